@@ -0,0 +1,91 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "AtomicCounterBuffer.h"
+#include "Capabilities.h"
+#include "ReadbackQueue.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Util/Macros.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace Rendering {
+
+AtomicCounterBuffer::AtomicCounterBuffer(uint32_t _numCounters) :
+		numCounters(std::max(_numCounters, 1u)), buffer(), lastValues(numCounters, 0), pendingReads(0) {
+	buffer.uploadData(BufferObject::TARGET_ATOMIC_COUNTER_BUFFER, lastValues, BufferObject::USAGE_DYNAMIC_COPY);
+}
+
+AtomicCounterBuffer::~AtomicCounterBuffer() = default;
+
+void AtomicCounterBuffer::bind(uint32_t binding) const {
+	buffer.bind(BufferObject::TARGET_ATOMIC_COUNTER_BUFFER, binding);
+}
+
+void AtomicCounterBuffer::unbind(uint32_t binding) const {
+	buffer.unbind(BufferObject::TARGET_ATOMIC_COUNTER_BUFFER, binding);
+}
+
+//! (internal)
+void AtomicCounterBuffer::updateBarrier() const {
+#if defined(LIB_GL) && defined(GL_ARB_shader_image_load_store)
+	if(Capabilities::get().imageLoadStore)
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+#endif
+}
+
+void AtomicCounterBuffer::reset(uint32_t value) {
+	updateBarrier();
+#if defined(LIB_GL) && defined(GL_ARB_clear_buffer_object)
+	if(Capabilities::get().clearBufferObject) {
+		buffer.clear(BufferObject::TARGET_ATOMIC_COUNTER_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, reinterpret_cast<const uint8_t *>(&value));
+		return;
+	}
+#endif
+	const std::vector<uint32_t> values(numCounters, value);
+	buffer.uploadSubData(BufferObject::TARGET_ATOMIC_COUNTER_BUFFER, values);
+}
+
+void AtomicCounterBuffer::setCounter(uint32_t index, uint32_t value) {
+	if(index >= numCounters)
+		throw std::out_of_range("AtomicCounterBuffer::setCounter: Invalid counter index.");
+	updateBarrier();
+	buffer.uploadSubData(BufferObject::TARGET_ATOMIC_COUNTER_BUFFER, reinterpret_cast<const uint8_t *>(&value), sizeof(uint32_t), index * sizeof(uint32_t));
+}
+
+void AtomicCounterBuffer::read(ReadbackQueue & queue, callback_t callback) {
+	if(!ReadbackQueue::isSupported()) {
+		lastValues = readNow();
+		if(callback)
+			callback(lastValues.data(), numCounters);
+		return;
+	}
+	updateBarrier();
+	++pendingReads;
+	// the reference keeps the counters alive until the request has finished
+	Util::Reference<AtomicCounterBuffer> self(this);
+	queue.readBuffer(buffer, 0, numCounters * sizeof(uint32_t), [self, callback](const uint8_t * data, size_t numBytes) {
+		AtomicCounterBuffer & counters = *self.get();
+		--counters.pendingReads;
+		std::memcpy(counters.lastValues.data(), data, std::min(numBytes, counters.lastValues.size() * sizeof(uint32_t)));
+		if(callback)
+			callback(counters.lastValues.data(), counters.numCounters);
+	});
+}
+
+std::vector<uint32_t> AtomicCounterBuffer::readNow() {
+	updateBarrier();
+	return buffer.downloadData<uint32_t>(BufferObject::TARGET_ATOMIC_COUNTER_BUFFER, numCounters);
+}
+
+}
@@ -0,0 +1,88 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_ATOMICCOUNTERBUFFER_H_
+#define RENDERING_ATOMICCOUNTERBUFFER_H_
+
+#include "BufferObject.h"
+#include <Util/ReferenceCounter.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Rendering {
+class ReadbackQueue;
+
+/**
+ * A set of atomic counters (atomic_uint) stored in a buffer object bound to GL_ATOMIC_COUNTER_BUFFER.
+ *
+ * In contrast to RenderingContext::setAtomicCounterTextureBuffer(), the counters need no buffer texture:
+ * reset() clears the buffer on the GPU and read() copies the values through a ReadbackQueue, so the values of a
+ * frame are available a frame or two later without stalling the pipeline.
+ *
+ * \code
+ *	Util::Reference<AtomicCounterBuffer> counters = new AtomicCounterBuffer(1);
+ *	// per frame
+ *	counters->reset();
+ *	counters->bind(0);	// layout(binding = 0, offset = 0) uniform atomic_uint visibleCount;
+ *	context.dispatchCompute(...);
+ *	counters->unbind(0);
+ *	counters->read(readbackQueue);
+ *	...
+ *	const uint32_t visible = counters->getLastValues()[0]; // from an earlier frame
+ * \endcode
+ *
+ * @note Requires GL_ARB_shader_atomic_counters.
+ */
+class AtomicCounterBuffer : public Util::ReferenceCounter<AtomicCounterBuffer> {
+	public:
+		typedef std::function<void (const uint32_t * values, uint32_t numCounters)> callback_t;
+
+		explicit AtomicCounterBuffer(uint32_t numCounters);
+		~AtomicCounterBuffer();
+
+		uint32_t getNumCounters() const						{	return numCounters;	}
+		BufferObject & getBuffer()							{	return buffer;	}
+
+		//! Bind the buffer to the atomic counter binding point @p binding.
+		void bind(uint32_t binding) const;
+		void unbind(uint32_t binding) const;
+
+		//! Set all counters to @p value, using glClearBufferData if available.
+		void reset(uint32_t value = 0);
+		//! Set a single counter to @p value.
+		void setCounter(uint32_t index, uint32_t value);
+
+		/*! Issue reading back the counters through the given queue. When the data has arrived (see ReadbackQueue::process()),
+			the values are stored (see getLastValues()) and passed to the optional callback.
+			If the queue is not supported, the values are read synchronously. */
+		void read(ReadbackQueue & queue, callback_t callback = callback_t());
+
+		//! Read the counters immediately (stalls the pipeline).
+		std::vector<uint32_t> readNow();
+
+		//! The values of the last finished read request (zeros if no request has finished yet).
+		const std::vector<uint32_t> & getLastValues() const	{	return lastValues;	}
+		//! Number of issued read requests that have not finished yet.
+		uint32_t getPendingReads() const					{	return pendingReads;	}
+
+	private:
+		const uint32_t numCounters;
+		BufferObject buffer;
+		std::vector<uint32_t> lastValues;
+		uint32_t pendingReads;
+
+		//! (internal) Make previous atomic counter writes visible to buffer copies and clears.
+		void updateBarrier() const;
+};
+
+}
+
+#endif /* RENDERING_ATOMICCOUNTERBUFFER_H_ */
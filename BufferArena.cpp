@@ -0,0 +1,217 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "BufferArena.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Util/Macros.h>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace Rendering {
+
+//! (internal) Round @p value up to the next multiple of @p alignment.
+static size_t alignOffset(size_t value, size_t alignment) {
+	return ((value + alignment - 1) / alignment) * alignment;
+}
+
+static const size_t NO_RANGE = static_cast<size_t>(-1);
+
+BufferArena::BufferArena(size_t initialCapacity, uint32_t _usageHint) :
+		ReferenceCounter_t(), bufferObject(), usageHint(_usageHint), capacity(initialCapacity), usedBytes(0),
+		allocationCount(0), growCount(0) {
+	if(initialCapacity == 0)
+		throw std::invalid_argument("BufferArena: The capacity must not be zero.");
+}
+
+BufferArena::~BufferArena() = default;
+
+//! (internal)
+void BufferArena::init() {
+	if(bufferObject.isValid())
+		return;
+	bufferObject.allocateData<uint8_t>(BufferObject::TARGET_COPY_WRITE_BUFFER, capacity, usageHint);
+	GET_GL_ERROR();
+	addFreeRange(0, capacity);
+}
+
+//! (internal)
+void BufferArena::grow(size_t numBytes) {
+	const size_t newCapacity = std::max(capacity * 2, capacity + numBytes);
+	BufferObject newBuffer;
+	newBuffer.allocateData<uint8_t>(BufferObject::TARGET_COPY_WRITE_BUFFER, newCapacity, usageHint);
+	if(usedBytes > 0)
+		newBuffer.copy(bufferObject, 0, 0, static_cast<uint32_t>(capacity));
+	bufferObject.swap(newBuffer);
+	GET_GL_ERROR();
+	addFreeRange(capacity, newCapacity - capacity);
+	capacity = newCapacity;
+	++growCount;
+}
+
+//! (internal)
+size_t BufferArena::findFreeRange(size_t numBytes, size_t alignment, size_t limit) const {
+	for(auto it = freeRangesBySize.lower_bound(numBytes); it != freeRangesBySize.end(); ++it) {
+		const size_t rangeOffset = it->second;
+		if(rangeOffset >= limit)
+			continue;
+		const size_t offset = alignOffset(rangeOffset, alignment);
+		if(offset + numBytes <= rangeOffset + it->first && offset + numBytes <= limit)
+			return rangeOffset;
+	}
+	return NO_RANGE;
+}
+
+//! (internal)
+void BufferArena::removeFreeRange(std::map<size_t, size_t>::iterator it) {
+	const auto sizeRange = freeRangesBySize.equal_range(it->second);
+	for(auto sizeIt = sizeRange.first; sizeIt != sizeRange.second; ++sizeIt) {
+		if(sizeIt->second == it->first) {
+			freeRangesBySize.erase(sizeIt);
+			break;
+		}
+	}
+	freeRangesByOffset.erase(it);
+}
+
+//! (internal)
+void BufferArena::takeFromFreeRange(size_t rangeOffset, size_t offset, size_t numBytes) {
+	const auto it = freeRangesByOffset.find(rangeOffset);
+	const size_t rangeEnd = rangeOffset + it->second;
+	removeFreeRange(it);
+	if(offset > rangeOffset)
+		addFreeRange(rangeOffset, offset - rangeOffset);
+	if(offset + numBytes < rangeEnd)
+		addFreeRange(offset + numBytes, rangeEnd - offset - numBytes);
+}
+
+//! (internal)
+void BufferArena::addFreeRange(size_t offset, size_t numBytes) {
+	// merge with the following range
+	auto next = freeRangesByOffset.lower_bound(offset);
+	if(next != freeRangesByOffset.end() && next->first == offset + numBytes) {
+		numBytes += next->second;
+		removeFreeRange(next);
+	}
+	// merge with the preceding range
+	next = freeRangesByOffset.lower_bound(offset);
+	if(next != freeRangesByOffset.begin()) {
+		auto prev = std::prev(next);
+		if(prev->first + prev->second == offset) {
+			offset = prev->first;
+			numBytes += prev->second;
+			removeFreeRange(prev);
+		}
+	}
+	freeRangesByOffset.emplace(offset, numBytes);
+	freeRangesBySize.emplace(numBytes, offset);
+}
+
+BufferArena::handle_t BufferArena::allocate(size_t numBytes, size_t alignment) {
+	if(numBytes == 0)
+		return INVALID_HANDLE;
+	alignment = std::max<size_t>(1, alignment);
+	init();
+	size_t rangeOffset = findFreeRange(numBytes, alignment, NO_RANGE);
+	if(rangeOffset == NO_RANGE) {
+		grow(numBytes + alignment);
+		rangeOffset = findFreeRange(numBytes, alignment, NO_RANGE);
+	}
+	const size_t offset = alignOffset(rangeOffset, alignment);
+	takeFromFreeRange(rangeOffset, offset, numBytes);
+
+	handle_t handle;
+	if(unusedHandles.empty()) {
+		allocations.push_back(Allocation());
+		handle = static_cast<handle_t>(allocations.size());
+	} else {
+		handle = unusedHandles.back();
+		unusedHandles.pop_back();
+	}
+	Allocation & allocation = allocations[handle - 1];
+	allocation.offset = offset;
+	allocation.size = numBytes;
+	allocation.alignment = alignment;
+	allocation.used = true;
+	allocationsByOffset.emplace(offset, handle);
+	usedBytes += numBytes;
+	++allocationCount;
+	return handle;
+}
+
+BufferArena::handle_t BufferArena::upload(const uint8_t * data, size_t numBytes, size_t alignment) {
+	const handle_t handle = allocate(numBytes, alignment);
+	if(handle != INVALID_HANDLE)
+		update(handle, data, numBytes);
+	return handle;
+}
+
+void BufferArena::update(handle_t handle, const uint8_t * data, size_t numBytes, size_t offsetInAllocation) {
+	if(!isValid(handle))
+		throw std::invalid_argument("BufferArena::update: Invalid handle.");
+	const Allocation & allocation = allocations[handle - 1];
+	if(offsetInAllocation + numBytes > allocation.size)
+		throw std::out_of_range("BufferArena::update: The range exceeds the allocation.");
+	bufferObject.uploadSubData(BufferObject::TARGET_COPY_WRITE_BUFFER, data, numBytes, allocation.offset + offsetInAllocation);
+	GET_GL_ERROR();
+}
+
+std::vector<uint8_t> BufferArena::download(handle_t handle) const {
+	if(!isValid(handle))
+		return std::vector<uint8_t>();
+	const Allocation & allocation = allocations[handle - 1];
+	return bufferObject.downloadData<uint8_t>(BufferObject::TARGET_COPY_READ_BUFFER, allocation.size, allocation.offset);
+}
+
+void BufferArena::release(handle_t handle) {
+	if(!isValid(handle)) {
+		WARN("BufferArena::release: Invalid handle.");
+		return;
+	}
+	Allocation & allocation = allocations[handle - 1];
+	allocation.used = false;
+	allocationsByOffset.erase(allocation.offset);
+	addFreeRange(allocation.offset, allocation.size);
+	usedBytes -= allocation.size;
+	--allocationCount;
+	unusedHandles.push_back(handle);
+}
+
+size_t BufferArena::compact(size_t maxBytes) {
+	size_t movedBytes = 0;
+	// Move the last allocations to the front; the ranges never overlap, so the data can be copied inside the buffer.
+	auto it = allocationsByOffset.end();
+	while(movedBytes < maxBytes && it != allocationsByOffset.begin()) {
+		--it;
+		const handle_t handle = it->second;
+		Allocation & allocation = allocations[handle - 1];
+		const size_t rangeOffset = findFreeRange(allocation.size, allocation.alignment, allocation.offset);
+		if(rangeOffset == NO_RANGE)
+			continue;
+		const size_t newOffset = alignOffset(rangeOffset, allocation.alignment);
+		takeFromFreeRange(rangeOffset, newOffset, allocation.size);
+		bufferObject.copy(bufferObject, static_cast<uint32_t>(allocation.offset), static_cast<uint32_t>(newOffset), static_cast<uint32_t>(allocation.size));
+		addFreeRange(allocation.offset, allocation.size);
+
+		it = allocationsByOffset.erase(it);
+		allocationsByOffset.emplace(newOffset, handle);
+		allocation.offset = newOffset;
+		movedBytes += allocation.size;
+	}
+	return movedBytes;
+}
+
+float BufferArena::getFragmentation() const {
+	const size_t freeBytes = getFreeBytes();
+	return freeBytes == 0 ? 0.0f : 1.0f - static_cast<float>(getLargestFreeRange()) / static_cast<float>(freeBytes);
+}
+
+}
@@ -0,0 +1,174 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_BUFFERARENA_H_
+#define RENDERING_BUFFERARENA_H_
+
+#include "BufferObject.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace Rendering {
+
+/**
+ * Sub-allocator for ranges of a single large buffer object.
+ *
+ * Many small meshes that each own a buffer object cause a considerable driver overhead. A BufferArena stores
+ * the data of many meshes in one buffer object instead. Free ranges are managed in a free list (sorted by offset
+ * and by size) and are merged with their neighbours when an allocation is released; an allocation request is
+ * served by the smallest free range that fits (best fit). If no free range is large enough, the buffer grows
+ * (the old content is copied on the GPU).
+ *
+ * Allocations are identified by handles; their offsets may change when the arena is compacted, so the offset
+ * has to be queried whenever the data is used.
+ *
+ * @note All functions that modify the buffer object require an active rendering context.
+ * @see BufferArenaAllocation
+ */
+class BufferArena : public Util::ReferenceCounter<BufferArena> {
+	public:
+		typedef uint32_t handle_t;
+		static const handle_t INVALID_HANDLE = 0;
+
+		/*! The storage of @p initialCapacity bytes is created when the first allocation is requested.
+			@throw std::invalid_argument if @p initialCapacity is zero.	*/
+		explicit BufferArena(size_t initialCapacity, uint32_t usageHint = BufferObject::USAGE_STATIC_DRAW);
+		~BufferArena();
+
+		/*! Reserve @p numBytes. The offset of the allocation is a multiple of @p alignment (which does not have to
+			be a power of two; e.g. the vertex size allows to address the vertices by a base vertex).
+			\return The handle of the allocation or INVALID_HANDLE if @p numBytes is zero.	*/
+		handle_t allocate(size_t numBytes, size_t alignment = 16);
+		//! Allocate a range and copy the given data into it.
+		handle_t upload(const uint8_t * data, size_t numBytes, size_t alignment = 16);
+		/*! Overwrite (a part of) the data of an allocation.
+			@throw std::out_of_range if the range exceeds the allocation.	*/
+		void update(handle_t handle, const uint8_t * data, size_t numBytes, size_t offsetInAllocation = 0);
+		//! Read back the data of an allocation.
+		std::vector<uint8_t> download(handle_t handle) const;
+		//! Release the allocation. Its range can be reused immediately.
+		void release(handle_t handle);
+
+		bool isValid(handle_t handle) const {
+			return handle != INVALID_HANDLE && handle <= allocations.size() && allocations[handle - 1].used;
+		}
+		//! Current offset of the allocation in bytes (changes when the arena is compacted).
+		size_t getOffset(handle_t handle) const			{	return allocations.at(handle - 1).offset;	}
+		size_t getSize(handle_t handle) const			{	return allocations.at(handle - 1).size;	}
+
+		/*! Move allocations from the end of the buffer into free ranges in front of them until at least
+			@p maxBytes have been moved or no allocation can be moved any more. The data is copied on the GPU
+			(BufferObject::copy), so this can be called once per frame with a small limit to defragment the
+			arena in the background.
+			\return The number of moved bytes.	*/
+		size_t compact(size_t maxBytes = static_cast<size_t>(-1));
+
+		BufferObject & getBufferObject()				{	return bufferObject;	}
+		const BufferObject & getBufferObject() const	{	return bufferObject;	}
+
+		//!	@name Statistics
+		//	@{
+		size_t getCapacity() const						{	return capacity;	}
+		size_t getUsedBytes() const						{	return usedBytes;	}
+		size_t getFreeBytes() const						{	return capacity - usedBytes;	}
+		uint32_t getAllocationCount() const				{	return allocationCount;	}
+		uint32_t getFreeRangeCount() const				{	return static_cast<uint32_t>(freeRangesByOffset.size());	}
+		size_t getLargestFreeRange() const				{	return freeRangesBySize.empty() ? 0 : freeRangesBySize.rbegin()->first;	}
+		/*! Measure for the fragmentation of the free memory: 0 if the free memory is one contiguous range,
+			approaching 1 if it is split into many small ranges.	*/
+		float getFragmentation() const;
+		//! Number of times the buffer had to grow.
+		uint32_t getGrowCount() const					{	return growCount;	}
+		//	@}
+
+	private:
+		struct Allocation {
+			size_t offset;
+			size_t size;
+			size_t alignment;
+			bool used;
+		};
+
+		BufferObject bufferObject;
+		const uint32_t usageHint;
+		size_t capacity;
+		size_t usedBytes;
+		uint32_t allocationCount;
+		uint32_t growCount;
+		std::vector<Allocation> allocations; //!< indexed by handle - 1
+		std::vector<handle_t> unusedHandles;
+		std::map<size_t, size_t> freeRangesByOffset; //!< offset -> size
+		std::multimap<size_t, size_t> freeRangesBySize; //!< size -> offset
+		std::map<size_t, handle_t> allocationsByOffset;
+
+		//! (internal) Create the storage if necessary.
+		void init();
+		//! (internal) Enlarge the buffer so that at least @p numBytes more bytes are available at its end.
+		void grow(size_t numBytes);
+		//! (internal) Return the offset of a free range that can hold the allocation and lies before @p limit (or -1).
+		size_t findFreeRange(size_t numBytes, size_t alignment, size_t limit) const;
+		//! (internal) Remove the given part from the free range starting at @p rangeOffset.
+		void takeFromFreeRange(size_t rangeOffset, size_t offset, size_t numBytes);
+		//! (internal) Add a free range and merge it with its neighbours.
+		void addFreeRange(size_t offset, size_t numBytes);
+		void removeFreeRange(std::map<size_t, size_t>::iterator it);
+};
+
+/**
+ * Owning reference to an allocation of a BufferArena: the allocation is released when this object is destroyed.
+ * Objects can be moved, but not copied.
+ */
+class BufferArenaAllocation {
+	public:
+		BufferArenaAllocation() : arena(), handle(BufferArena::INVALID_HANDLE) {}
+		BufferArenaAllocation(BufferArena * _arena, BufferArena::handle_t _handle) : arena(_arena), handle(_handle) {}
+		BufferArenaAllocation(BufferArenaAllocation && other) : arena(other.arena), handle(other.handle) {
+			other.arena = nullptr;
+			other.handle = BufferArena::INVALID_HANDLE;
+		}
+		BufferArenaAllocation(const BufferArenaAllocation &) = delete;
+		~BufferArenaAllocation()						{	release();	}
+
+		BufferArenaAllocation & operator=(BufferArenaAllocation && other) {
+			swap(other);
+			return *this;
+		}
+		BufferArenaAllocation & operator=(const BufferArenaAllocation &) = delete;
+
+		void swap(BufferArenaAllocation & other) {
+			std::swap(arena, other.arena);
+			std::swap(handle, other.handle);
+		}
+		void release() {
+			if(isValid())
+				arena->release(handle);
+			arena = nullptr;
+			handle = BufferArena::INVALID_HANDLE;
+		}
+
+		bool isValid() const							{	return arena.isNotNull() && arena->isValid(handle);	}
+		BufferArena * getArena() const					{	return arena.get();	}
+		BufferArena::handle_t getHandle() const			{	return handle;	}
+		size_t getOffset() const						{	return arena->getOffset(handle);	}
+		size_t getSize() const							{	return arena->getSize(handle);	}
+
+	private:
+		Util::Reference<BufferArena> arena;
+		BufferArena::handle_t handle;
+};
+
+}
+
+#endif /* RENDERING_BUFFERARENA_H_ */
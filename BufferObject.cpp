@@ -9,7 +9,9 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "BufferObject.h"
+#include "RenderingContext/RenderingContext.h"
 #include "GLHeader.h"
+#include "GLTrace.h"
 #include "Helper.h"
 #include <cstddef>
 #include <cstdint>
@@ -43,12 +45,14 @@ const uint32_t BufferObject::USAGE_DYNAMIC_DRAW = GL_DYNAMIC_DRAW;
 const uint32_t BufferObject::USAGE_DYNAMIC_READ = GL_DYNAMIC_READ;
 const uint32_t BufferObject::USAGE_DYNAMIC_COPY = GL_DYNAMIC_COPY;
 
-BufferObject::BufferObject() : bufferId(0) {
+BufferObject::BufferObject() : bufferId(0), memoryCategory(MemoryRegistry::OTHER_BUFFER), accountedSize(0) {
 }
 
-BufferObject::BufferObject(BufferObject && other) : bufferId(other.bufferId) {
+BufferObject::BufferObject(BufferObject && other) :
+		bufferId(other.bufferId), memoryCategory(other.memoryCategory), accountedSize(other.accountedSize) {
 	// Make sure the other buffer object does not free the handle.
 	other.bufferId = 0;
+	other.accountedSize = 0;
 }
 
 BufferObject::~BufferObject() {
@@ -62,58 +66,162 @@ BufferObject & BufferObject::operator=(BufferObject && other) {
 	}
 	// Make sure the other buffer object frees the handle.
 	std::swap(other.bufferId, bufferId);
+	swapAccountedSize(other);
 	return *this;
 }
 
 void BufferObject::swap(BufferObject & other){
 	std::swap(other.bufferId,bufferId);
+	swapAccountedSize(other);
+}
+
+//! (internal)
+void BufferObject::swapAccountedSize(BufferObject & other) {
+	if(memoryCategory != other.memoryCategory && accountedSize != other.accountedSize) {
+		MemoryRegistry::add(memoryCategory, static_cast<int64_t>(other.accountedSize) - static_cast<int64_t>(accountedSize));
+		MemoryRegistry::add(other.memoryCategory, static_cast<int64_t>(accountedSize) - static_cast<int64_t>(other.accountedSize));
+	}
+	std::swap(other.accountedSize, accountedSize);
+}
+
+void BufferObject::setMemoryCategory(MemoryRegistry::category_t category) {
+	MemoryRegistry::move(memoryCategory, category, accountedSize);
+	memoryCategory = category;
+}
+
+void BufferObject::_setStorageSize(size_t numBytes) {
+	MemoryRegistry::add(memoryCategory, static_cast<int64_t>(numBytes) - static_cast<int64_t>(accountedSize));
+	accountedSize = numBytes;
 }
 
 void BufferObject::prepare() {
 	if(bufferId == 0) {
+#if defined(LIB_GL) && defined(GL_ARB_direct_state_access)
+		// A name created by glGenBuffers does not refer to a buffer object until it is bound for the first time.
+		if(isDirectStateAccessSupported())
+			glCreateBuffers(1, &bufferId);
+		else
+#endif
 		glGenBuffers(1, &bufferId);
+		++RenderingContext::_getFrameCounters().buffersCreated;
+		RENDERING_GL_TRACE(CREATE_BUFFER, {bufferId});
 	}
 }
 
 void BufferObject::destroy() {
 	if(bufferId != 0) {
 		glDeleteBuffers(1, &bufferId);
+		RENDERING_GL_TRACE(DELETE_BUFFER, {bufferId});
 		bufferId = 0;
+		_setStorageSize(0);
 	}
 }
 
 void BufferObject::bind(uint32_t bufferTarget) const {
 	glBindBuffer(bufferTarget, bufferId);
+	RENDERING_GL_TRACE(BIND_BUFFER, {bufferTarget, bufferId});
 }
 
 void BufferObject::bind(uint32_t bufferTarget, uint32_t location) const {
 #if defined(LIB_GL)
 	glBindBufferBase(bufferTarget, location, bufferId);
+	RENDERING_GL_TRACE(BIND_BUFFER_BASE, {bufferTarget, location, bufferId});
 #endif
 }
 
 void BufferObject::unbind(uint32_t bufferTarget) const {
 	glBindBuffer(bufferTarget, 0);
+	RENDERING_GL_TRACE(BIND_BUFFER, {bufferTarget, 0u});
 }
 
 void BufferObject::unbind(uint32_t bufferTarget, uint32_t location) const {
 #if defined(LIB_GL)
 	glBindBufferBase(bufferTarget, location, 0);
+	RENDERING_GL_TRACE(BIND_BUFFER_BASE, {bufferTarget, location, 0u});
+#endif
+}
+
+//! (static)
+void BufferObject::bindBuffers(uint32_t bufferTarget, uint32_t firstLocation, const std::vector<const BufferObject *> & buffers) {
+#if defined(LIB_GL)
+	if(buffers.empty())
+		return;
+#if defined(GL_ARB_multi_bind)
+	static const bool multiBind = isExtensionSupported("GL_ARB_multi_bind");
+	if(multiBind) {
+		std::vector<GLuint> ids;
+		ids.reserve(buffers.size());
+		for(const auto & buffer : buffers)
+			ids.push_back(buffer == nullptr ? 0 : buffer->getGLId());
+		glBindBuffersBase(bufferTarget, firstLocation, static_cast<GLsizei>(ids.size()), ids.data());
+		if(GLTrace::isRecording()) {
+			for(const auto & id : ids)
+				GLTrace::record(GLTrace::BIND_BUFFER_BASE, {bufferTarget, firstLocation++, id});
+		}
+		return;
+	}
+#endif
+	for(const auto & buffer : buffers) {
+		glBindBufferBase(bufferTarget, firstLocation, buffer == nullptr ? 0 : buffer->getGLId());
+		RENDERING_GL_TRACE(BIND_BUFFER_BASE, {bufferTarget, firstLocation, buffer == nullptr ? 0u : buffer->getGLId()});
+		++firstLocation;
+	}
+#endif
+}
+
+//! (static)
+void BufferObject::unbindBuffers(uint32_t bufferTarget, uint32_t firstLocation, uint32_t count) {
+#if defined(LIB_GL)
+#if defined(GL_ARB_multi_bind)
+	static const bool multiBind = isExtensionSupported("GL_ARB_multi_bind");
+	if(multiBind) {
+		glBindBuffersBase(bufferTarget, firstLocation, static_cast<GLsizei>(count), nullptr);
+		if(GLTrace::isRecording()) {
+			for(uint32_t i = 0; i < count; ++i)
+				GLTrace::record(GLTrace::BIND_BUFFER_BASE, {bufferTarget, firstLocation + i, 0u});
+		}
+		return;
+	}
+#endif
+	for(uint32_t i = 0; i < count; ++i) {
+		glBindBufferBase(bufferTarget, firstLocation + i, 0);
+		RENDERING_GL_TRACE(BIND_BUFFER_BASE, {bufferTarget, firstLocation + i, 0u});
+	}
 #endif
 }
 
 void BufferObject::uploadData(uint32_t bufferTarget, const uint8_t* data, size_t numBytes, uint32_t usageHint) {
 	prepare();
-	bind(bufferTarget);
-	glBufferData(bufferTarget, static_cast<GLsizeiptr>(numBytes), data, usageHint);
-	unbind(bufferTarget);
+#if defined(LIB_GL) && defined(GL_ARB_direct_state_access)
+	if(isDirectStateAccessSupported()) {
+		glNamedBufferData(bufferId, static_cast<GLsizeiptr>(numBytes), data, usageHint);
+	} else
+#endif
+	{
+		bind(bufferTarget);
+		glBufferData(bufferTarget, static_cast<GLsizeiptr>(numBytes), data, usageHint);
+		unbind(bufferTarget);
+	}
+	RENDERING_GL_TRACE(BUFFER_DATA, {bufferId, static_cast<uint32_t>(numBytes), usageHint}, data, numBytes);
+	_setStorageSize(numBytes);
+	if(data != nullptr)
+		RenderingContext::_getFrameCounters().bufferBytesUploaded += numBytes;
 }
 
 void BufferObject::uploadSubData(uint32_t bufferTarget, const uint8_t* data, size_t numBytes, size_t offset) {
 	prepare();
-	bind(bufferTarget);
-	glBufferSubData(bufferTarget, offset, static_cast<GLsizeiptr>(numBytes), data);
-	unbind(bufferTarget);
+#if defined(LIB_GL) && defined(GL_ARB_direct_state_access)
+	if(isDirectStateAccessSupported()) {
+		glNamedBufferSubData(bufferId, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(numBytes), data);
+	} else
+#endif
+	{
+		bind(bufferTarget);
+		glBufferSubData(bufferTarget, offset, static_cast<GLsizeiptr>(numBytes), data);
+		unbind(bufferTarget);
+	}
+	RENDERING_GL_TRACE(BUFFER_SUB_DATA, {bufferId, static_cast<uint32_t>(offset), static_cast<uint32_t>(numBytes)}, data, numBytes);
+	RenderingContext::_getFrameCounters().bufferBytesUploaded += numBytes;
 }
 
 template<typename T>
@@ -137,6 +245,13 @@ std::vector<T> BufferObject::downloadData(uint32_t bufferTarget, std::size_t num
 	if(bufferId == 0) {
 		return std::vector<T>();
 	}
+#if defined(GL_ARB_direct_state_access)
+	if(isDirectStateAccessSupported()) {
+		std::vector<T> result(numberOfElements);
+		glGetNamedBufferSubData(bufferId, static_cast<GLintptr>(offset * sizeof(T)), static_cast<GLsizeiptr>(numberOfElements * sizeof(T)), result.data());
+		return result;
+	}
+#endif
 	bind(bufferTarget);
 	const T * bufferData = reinterpret_cast<const T *>(glMapBuffer(bufferTarget, GL_READ_ONLY));
 	const std::vector<T> result(bufferData + offset, bufferData + offset + numberOfElements);
@@ -153,10 +268,15 @@ std::vector<T> BufferObject::downloadData(uint32_t /*bufferTarget*/, std::size_t
 
 void BufferObject::clear(uint32_t bufferTarget, uint32_t internalFormat, uint32_t format, uint32_t type, const uint8_t* data) {
 #if defined(GL_ARB_clear_buffer_object)
+#if defined(GL_ARB_direct_state_access)
+	if(isDirectStateAccessSupported()) {
+		glClearNamedBufferData(bufferId, internalFormat, format, type, data);
+		return;
+	}
+#endif
 	bind(bufferTarget);
 	glClearBufferData(bufferTarget, internalFormat, format, type, data);
 	unbind(bufferTarget);
-	//glClearNamedBufferDataEXT(bufferId, internalFormat, format, type, data);
 #else
 	WARN("BufferObject::clear not supported!");
 #endif
@@ -171,6 +291,14 @@ void BufferObject::clear(uint32_t internalFormat, uint32_t format, uint32_t type
 }
 
 void BufferObject::copy(const BufferObject& source, uint32_t sourceOffset, uint32_t targetOffset, uint32_t size) {
+	RENDERING_GL_TRACE(COPY_BUFFER_SUB_DATA, {source.getGLId(), bufferId, sourceOffset, targetOffset, size});
+#if defined(LIB_GL) && defined(GL_ARB_direct_state_access)
+	if(isDirectStateAccessSupported()) {
+		glCopyNamedBufferSubData(source.getGLId(), bufferId, sourceOffset, targetOffset, size);
+		GET_GL_ERROR();
+		return;
+	}
+#endif
 	source.bind(TARGET_COPY_READ_BUFFER);
 	bind(TARGET_COPY_WRITE_BUFFER);
 	glCopyBufferSubData(TARGET_COPY_READ_BUFFER, TARGET_COPY_WRITE_BUFFER, sourceOffset, targetOffset, size);
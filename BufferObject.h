@@ -12,6 +12,7 @@
 #ifndef RENDERING_BUFFEROBJECT_H
 #define RENDERING_BUFFEROBJECT_H
 
+#include "MemoryRegistry.h"
 #include <cstddef>
 #include <cstdint>
 #include <vector>
@@ -55,6 +56,13 @@ class BufferObject {
 	private:
 		//! OpenGL handle for this buffer object.
 		uint32_t bufferId;
+		//! Category in the MemoryRegistry.
+		MemoryRegistry::category_t memoryCategory;
+		//! Size of the storage accounted in the MemoryRegistry.
+		size_t accountedSize;
+
+		//! (internal) Exchange the accounted sizes of this and the other buffer object, whose handles have been swapped.
+		void swapAccountedSize(BufferObject & other);
 
 	public:
 		//! Create an invalid buffer object for the given target.
@@ -92,6 +100,12 @@ class BufferObject {
 		void unbind(uint32_t bufferTarget) const;
 		void unbind(uint32_t bufferTarget, uint32_t location) const;
 
+		/*! (static) Bind the given buffers to the consecutive binding points of an indexed target (e.g.
+			TARGET_SHADER_STORAGE_BUFFER), starting with @p firstLocation. A nullptr removes the binding.
+			If GL_ARB_multi_bind is supported, all buffers are bound by a single call.	*/
+		static void bindBuffers(uint32_t bufferTarget, uint32_t firstLocation, const std::vector<const BufferObject *> & buffers);
+		//! (static) Remove the bindings of @p count consecutive binding points of an indexed target.
+		static void unbindBuffers(uint32_t bufferTarget, uint32_t firstLocation, uint32_t count);
 		/**
 		 * @brief Allocate buffer data
 		 * 
@@ -139,6 +153,16 @@ class BufferObject {
 			return bufferId != 0;
 		}
 		uint32_t getGLId()const{	return bufferId;	}
+
+		/*! Category of the buffer in the MemoryRegistry (default: OTHER_BUFFER).
+			Changing the category moves the size of an allocated storage to the new category.	*/
+		void setMemoryCategory(MemoryRegistry::category_t category);
+		MemoryRegistry::category_t getMemoryCategory()const	{	return memoryCategory;	}
+		//! Size of the storage in bytes (0 if no storage has been allocated).
+		size_t getSize()const								{	return accountedSize;	}
+		/*! (internal) Set the size of a storage that has not been allocated by uploadData() (e.g. by glBufferStorage);
+			updates the MemoryRegistry. */
+		void _setStorageSize(size_t numBytes);
 		
 		void clear(uint32_t bufferTarget, uint32_t internalFormat, uint32_t format, uint32_t type, const uint8_t* data=nullptr);
 		void clear(uint32_t internalFormat, uint32_t format, uint32_t type, const uint8_t* data=nullptr);
@@ -0,0 +1,133 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "Capabilities.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace Rendering {
+
+//! Value-initialized: all fields are zero until _init() has been called.
+static thread_local Capabilities capabilities = Capabilities();
+
+//! (static)
+const Capabilities & Capabilities::get() {
+	if(!capabilities.initialized)
+		_init();
+	return capabilities;
+}
+
+#ifdef LIB_GL
+//! (internal)
+static uint32_t getInteger(GLenum name) {
+	GLint value = 0;
+	glGetIntegerv(name, &value);
+	return value > 0 ? static_cast<uint32_t>(value) : 0;
+}
+#endif
+
+//! (static)
+void Capabilities::_init() {
+	Capabilities caps = Capabilities();
+#ifdef LIB_GL
+	{ // versions
+		const char * versionString = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+		int major = 0;
+		int minor = 0;
+		if(versionString != nullptr)
+			std::sscanf(versionString, "%d.%d", &major, &minor);
+		caps.glMajorVersion = static_cast<uint32_t>(std::max(major, 0));
+		caps.glMinorVersion = static_cast<uint32_t>(std::max(minor, 0));
+
+		const char * glslString = reinterpret_cast<const char *>(glGetString(GL_SHADING_LANGUAGE_VERSION));
+		int glslMajor = 0;
+		int glslMinor = 0;
+		if(glslString != nullptr)
+			std::sscanf(glslString, "%d.%d", &glslMajor, &glslMinor);
+		caps.glslVersion = static_cast<uint32_t>(std::max(glslMajor * 100 + glslMinor, 0));
+		caps.compatibilityProfile = isExtensionSupported("GL_ARB_compatibility");
+	}
+
+	const uint32_t version = caps.glMajorVersion * 10 + caps.glMinorVersion;
+	const auto supports = [version](uint32_t coreVersion, const char * extension) {
+		return (coreVersion != 0 && version >= coreVersion) || isExtensionSupported(extension);
+	};
+	caps.directStateAccess = supports(45, "GL_ARB_direct_state_access");
+	caps.bindlessTexture = supports(0, "GL_ARB_bindless_texture");
+	caps.multiBind = supports(44, "GL_ARB_multi_bind");
+	caps.bufferStorage = supports(44, "GL_ARB_buffer_storage");
+	caps.clearBufferObject = supports(43, "GL_ARB_clear_buffer_object");
+	caps.computeShader = supports(43, "GL_ARB_compute_shader");
+	caps.shaderStorageBuffer = supports(43, "GL_ARB_shader_storage_buffer_object");
+	caps.multiDrawIndirect = supports(43, "GL_ARB_multi_draw_indirect");
+	caps.imageLoadStore = supports(42, "GL_ARB_shader_image_load_store");
+	caps.atomicCounters = supports(42, "GL_ARB_shader_atomic_counters");
+	caps.textureStorage = supports(42, "GL_ARB_texture_storage");
+	caps.shaderSubroutine = supports(40, "GL_ARB_shader_subroutine");
+	caps.uniformBufferObject = supports(31, "GL_ARB_uniform_buffer_object");
+	caps.sync = supports(32, "GL_ARB_sync");
+	caps.timerQuery = supports(33, "GL_ARB_timer_query");
+	caps.conditionalRender = supports(30, "GL_NV_conditional_render");
+	caps.conditionalRenderInverted = supports(45, "GL_ARB_conditional_render_inverted");
+	caps.transformFeedback = supports(0, "GL_EXT_transform_feedback");
+	caps.programBinary = supports(41, "GL_ARB_get_program_binary");
+	caps.parallelShaderCompile = supports(0, "GL_KHR_parallel_shader_compile");
+	caps.debugOutput = supports(43, "GL_KHR_debug");
+	caps.textureFilterAnisotropic = supports(46, "GL_EXT_texture_filter_anisotropic");
+
+	caps.maxTextureUnits = getInteger(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS);
+	caps.maxTextureSize = getInteger(GL_MAX_TEXTURE_SIZE);
+	caps.max3DTextureSize = getInteger(GL_MAX_3D_TEXTURE_SIZE);
+	caps.maxArrayTextureLayers = getInteger(GL_MAX_ARRAY_TEXTURE_LAYERS);
+	caps.maxVertexAttribs = getInteger(GL_MAX_VERTEX_ATTRIBS);
+	caps.maxColorAttachments = getInteger(GL_MAX_COLOR_ATTACHMENTS);
+	caps.maxDrawBuffers = getInteger(GL_MAX_DRAW_BUFFERS);
+	caps.maxSamples = getInteger(GL_MAX_SAMPLES);
+#if defined(GL_ARB_uniform_buffer_object)
+	if(caps.uniformBufferObject) {
+		caps.maxUniformBlockSize = getInteger(GL_MAX_UNIFORM_BLOCK_SIZE);
+		caps.maxUniformBufferBindings = getInteger(GL_MAX_UNIFORM_BUFFER_BINDINGS);
+		caps.uniformBufferOffsetAlignment = getInteger(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT);
+	}
+#endif
+#if defined(GL_ARB_shader_storage_buffer_object)
+	if(caps.shaderStorageBuffer) {
+		caps.maxShaderStorageBlockSize = getInteger(GL_MAX_SHADER_STORAGE_BLOCK_SIZE);
+		caps.maxShaderStorageBufferBindings = getInteger(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS);
+		caps.shaderStorageBufferOffsetAlignment = getInteger(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT);
+	}
+#endif
+#if defined(GL_ARB_shader_image_load_store)
+	if(caps.imageLoadStore)
+		caps.maxImageUnits = getInteger(GL_MAX_IMAGE_UNITS);
+#endif
+#if defined(GL_ARB_shader_atomic_counters)
+	if(caps.atomicCounters) {
+		caps.maxAtomicCounterBufferBindings = getInteger(GL_MAX_ATOMIC_COUNTER_BUFFER_BINDINGS);
+		caps.maxAtomicCounterBufferSize = getInteger(GL_MAX_ATOMIC_COUNTER_BUFFER_SIZE);
+	}
+#endif
+#if defined(GL_ARB_compute_shader)
+	if(caps.computeShader)
+		caps.maxComputeWorkGroupInvocations = getInteger(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS);
+#endif
+#if defined(GL_EXT_texture_filter_anisotropic)
+	if(caps.textureFilterAnisotropic)
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &caps.maxAnisotropy);
+#endif
+	GET_GL_ERROR();
+#endif /* LIB_GL */
+	caps.initialized = true;
+	capabilities = caps;
+}
+
+}
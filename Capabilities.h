@@ -0,0 +1,100 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_CAPABILITIES_H_
+#define RENDERING_CAPABILITIES_H_
+
+#include <cstdint>
+
+namespace Rendering {
+
+/**
+ * Versions, extensions and limits of the GL context, resolved once by RenderingContext::initGLState().
+ *
+ * The values are stored per thread, as every thread uses its own GL context. Code choosing between several
+ * implementations (e.g. direct state access or bind-to-edit) reads the plain fields instead of querying
+ * the extension strings:
+ * \code
+ *	if(Capabilities::get().directStateAccess)
+ *		...
+ * \endcode
+ * If get() is called before initGLState() on a thread, the capabilities of the current context are resolved then.
+ */
+struct Capabilities {
+	//! @name Versions
+	//	@{
+	uint32_t glMajorVersion;
+	uint32_t glMinorVersion;
+	uint32_t glslVersion;		//!< e.g. 450 for GLSL 4.50
+	bool compatibilityProfile;
+	//	@}
+
+	//! @name Extensions (or the core version including them)
+	//	@{
+	bool directStateAccess;		//!< GL 4.5 or GL_ARB_direct_state_access
+	bool bindlessTexture;		//!< GL_ARB_bindless_texture
+	bool multiBind;				//!< GL 4.4 or GL_ARB_multi_bind
+	bool bufferStorage;			//!< GL 4.4 or GL_ARB_buffer_storage
+	bool clearBufferObject;		//!< GL 4.3 or GL_ARB_clear_buffer_object
+	bool computeShader;			//!< GL 4.3 or GL_ARB_compute_shader
+	bool shaderStorageBuffer;	//!< GL 4.3 or GL_ARB_shader_storage_buffer_object
+	bool multiDrawIndirect;		//!< GL 4.3 or GL_ARB_multi_draw_indirect
+	bool imageLoadStore;		//!< GL 4.2 or GL_ARB_shader_image_load_store
+	bool atomicCounters;		//!< GL 4.2 or GL_ARB_shader_atomic_counters
+	bool textureStorage;		//!< GL 4.2 or GL_ARB_texture_storage
+	bool shaderSubroutine;		//!< GL 4.0 or GL_ARB_shader_subroutine
+	bool uniformBufferObject;	//!< GL 3.1 or GL_ARB_uniform_buffer_object
+	bool sync;					//!< GL 3.2 or GL_ARB_sync
+	bool timerQuery;			//!< GL 3.3 or GL_ARB_timer_query
+	bool conditionalRender;		//!< GL 3.0 or GL_NV_conditional_render
+	bool conditionalRenderInverted;	//!< GL 4.5 or GL_ARB_conditional_render_inverted
+	bool transformFeedback;		//!< GL_EXT_transform_feedback
+	bool programBinary;			//!< GL 4.1 or GL_ARB_get_program_binary
+	bool parallelShaderCompile;	//!< GL_KHR_parallel_shader_compile
+	bool debugOutput;			//!< GL 4.3 or GL_KHR_debug
+	bool textureFilterAnisotropic;	//!< GL_EXT_texture_filter_anisotropic
+	//	@}
+
+	//! @name Limits (0 if the feature is not supported)
+	//	@{
+	uint32_t maxTextureUnits;			//!< GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS
+	uint32_t maxTextureSize;
+	uint32_t max3DTextureSize;
+	uint32_t maxArrayTextureLayers;
+	uint32_t maxVertexAttribs;
+	uint32_t maxColorAttachments;
+	uint32_t maxDrawBuffers;
+	uint32_t maxSamples;
+	uint32_t maxUniformBlockSize;
+	uint32_t maxUniformBufferBindings;
+	uint32_t uniformBufferOffsetAlignment;
+	uint32_t maxShaderStorageBlockSize;
+	uint32_t maxShaderStorageBufferBindings;
+	uint32_t shaderStorageBufferOffsetAlignment;
+	uint32_t maxImageUnits;
+	uint32_t maxAtomicCounterBufferBindings;
+	uint32_t maxAtomicCounterBufferSize;
+	uint32_t maxComputeWorkGroupInvocations;
+	float maxAnisotropy;
+	//	@}
+
+	bool initialized;
+
+	//! (static) The capabilities of the GL context of the calling thread.
+	static const Capabilities & get();
+
+	/*! (static, internal) Resolve the capabilities of the GL context that is current on the calling thread.
+		Called by RenderingContext::initGLState(). */
+	static void _init();
+};
+
+}
+
+#endif /* RENDERING_CAPABILITIES_H_ */
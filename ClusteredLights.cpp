@@ -0,0 +1,250 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ClusteredLights.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Shader/Shader.h"
+#include "Shader/ShaderObjectInfo.h"
+#include "Shader/Uniform.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Vec2.h>
+#include <Geometry/Vec4.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace Rendering {
+
+static const char * const assignmentProgram =
+R"***(#version 430
+layout(local_size_x = 64) in;
+
+struct ClusteredLight {
+	vec4 positionRadius;	// world position, radius
+	vec4 color;
+};
+layout(std430, binding = 4) readonly buffer ClusteredLights { ClusteredLight lights[]; };
+layout(std430, binding = 5) writeonly buffer ClusterLightCounts { uint clusterLightCounts[]; };
+layout(std430, binding = 6) writeonly buffer ClusterLightIndices { uint clusterLightIndices[]; };
+
+uniform mat4 worldToCamera;
+uniform mat4 clippingToCamera;
+uniform ivec3 gridSize;
+uniform vec2 zRange; // distances of the near and the far plane
+uniform int lightCount;
+uniform int maxLightsPerCluster;
+
+vec3 unproject(vec2 ndc, float ndcZ) {
+	const vec4 p = clippingToCamera * vec4(ndc, ndcZ, 1.0);
+	return p.xyz / p.w;
+}
+
+// point on the line through the given normalized device coordinates with the given distance to the camera plane
+vec3 pointAtDepth(vec2 ndc, float depth) {
+	const vec3 n = unproject(ndc, -1.0);
+	const vec3 f = unproject(ndc, 1.0);
+	return mix(n, f, (-depth - n.z) / (f.z - n.z));
+}
+
+void main() {
+	const uint cluster = gl_GlobalInvocationID.x;
+	if(cluster >= uint(gridSize.x * gridSize.y * gridSize.z))
+		return;
+	const uint x = cluster % uint(gridSize.x);
+	const uint y = (cluster / uint(gridSize.x)) % uint(gridSize.y);
+	const uint z = cluster / uint(gridSize.x * gridSize.y);
+
+	const vec2 ndcMin = vec2(x, y) / vec2(gridSize.xy) * 2.0 - 1.0;
+	const vec2 ndcMax = vec2(x + 1u, y + 1u) / vec2(gridSize.xy) * 2.0 - 1.0;
+	const float depthNear = zRange.x * pow(zRange.y / zRange.x, float(z) / float(gridSize.z));
+	const float depthFar = zRange.x * pow(zRange.y / zRange.x, float(z + 1u) / float(gridSize.z));
+
+	vec3 boxMin = vec3(1.0e30);
+	vec3 boxMax = vec3(-1.0e30);
+	for(int corner = 0; corner < 4; ++corner) {
+		const vec2 ndc = vec2((corner & 1) == 0 ? ndcMin.x : ndcMax.x, (corner & 2) == 0 ? ndcMin.y : ndcMax.y);
+		const vec3 a = pointAtDepth(ndc, depthNear);
+		const vec3 b = pointAtDepth(ndc, depthFar);
+		boxMin = min(boxMin, min(a, b));
+		boxMax = max(boxMax, max(a, b));
+	}
+
+	const uint offset = cluster * uint(maxLightsPerCluster);
+	uint count = 0u;
+	for(int i = 0; i < lightCount && count < uint(maxLightsPerCluster); ++i) {
+		const vec4 positionRadius = lights[i].positionRadius;
+		const vec3 center = (worldToCamera * vec4(positionRadius.xyz, 1.0)).xyz;
+		const vec3 d = center - clamp(center, boxMin, boxMax);
+		if(dot(d, d) <= positionRadius.w * positionRadius.w) {
+			clusterLightIndices[offset + count] = uint(i);
+			++count;
+		}
+	}
+	clusterLightCounts[cluster] = count;
+}
+)***";
+
+static const char * const shaderInterface =
+R"***(
+struct ClusteredLight {
+	vec4 positionRadius;	// world position, radius
+	vec4 color;
+};
+layout(std430, binding = 4) readonly buffer ClusteredLights { ClusteredLight sg_clusteredLights[]; };
+layout(std430, binding = 5) readonly buffer ClusterLightCounts { uint sg_clusterLightCounts[]; };
+layout(std430, binding = 6) readonly buffer ClusterLightIndices { uint sg_clusterLightIndices[]; };
+
+uniform ivec3 sg_clusterGridSize;
+uniform vec2 sg_clusterZRange;
+uniform int sg_clusterMaxLights;
+uniform int sg_viewport[4];
+
+// cameraZ is the z coordinate of the fragment in camera space (negative in front of the camera)
+uint sg_getCluster(vec2 fragCoord, float cameraZ) {
+	const vec2 p = (fragCoord - vec2(sg_viewport[0], sg_viewport[1])) / vec2(sg_viewport[2], sg_viewport[3]);
+	const ivec2 xy = clamp(ivec2(p * vec2(sg_clusterGridSize.xy)), ivec2(0), sg_clusterGridSize.xy - 1);
+	const float slice = log(-cameraZ / sg_clusterZRange.x) / log(sg_clusterZRange.y / sg_clusterZRange.x);
+	const int z = clamp(int(slice * float(sg_clusterGridSize.z)), 0, sg_clusterGridSize.z - 1);
+	return uint(xy.x + sg_clusterGridSize.x * (xy.y + sg_clusterGridSize.y * z));
+}
+uint sg_getClusterLightCount(uint cluster) {
+	return sg_clusterLightCounts[cluster];
+}
+ClusteredLight sg_getClusterLight(uint cluster, uint i) {
+	return sg_clusteredLights[sg_clusterLightIndices[cluster * uint(sg_clusterMaxLights) + i]];
+}
+)***";
+
+static const Uniform::UniformName UNIFORM_SG_CLUSTER_GRID_SIZE("sg_clusterGridSize");
+static const Uniform::UniformName UNIFORM_SG_CLUSTER_Z_RANGE("sg_clusterZRange");
+static const Uniform::UniformName UNIFORM_SG_CLUSTER_MAX_LIGHTS("sg_clusterMaxLights");
+
+//! (static)
+bool ClusteredLights::isSupported() {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	static const bool support = isExtensionSupported("GL_ARB_compute_shader") &&
+								isExtensionSupported("GL_ARB_shader_storage_buffer_object");
+	return support;
+#else
+	return false;
+#endif
+}
+
+//! (static)
+const char * ClusteredLights::getShaderInterface() {
+	return shaderInterface;
+}
+
+ClusteredLights::ClusteredLights(uint32_t _gridX, uint32_t _gridY, uint32_t _gridZ, uint32_t _maxLightsPerCluster) :
+		ReferenceCounter_t(), gridX(_gridX), gridY(_gridY), gridZ(_gridZ), maxLightsPerCluster(_maxLightsPerCluster),
+		lightsChanged(true), zNear(0.1f), zFar(1000.0f) {
+	if(gridX == 0 || gridY == 0 || gridZ == 0 || maxLightsPerCluster == 0)
+		throw std::invalid_argument("ClusteredLights: Invalid grid size.");
+}
+
+ClusteredLights::~ClusteredLights() = default;
+
+uint32_t ClusteredLights::addLight(const Geometry::Vec3 & position, float radius, const Util::Color4f & color) {
+	lightData.resize(lightData.size() + 8);
+	const uint32_t index = getLightCount() - 1;
+	setLight(index, position, radius, color);
+	return index;
+}
+
+void ClusteredLights::setLight(uint32_t index, const Geometry::Vec3 & position, float radius, const Util::Color4f & color) {
+	if(index >= getLightCount())
+		throw std::out_of_range("ClusteredLights::setLight: Invalid index.");
+	float * light = lightData.data() + index * 8;
+	light[0] = position.getX();
+	light[1] = position.getY();
+	light[2] = position.getZ();
+	light[3] = radius;
+	light[4] = color.getR();
+	light[5] = color.getG();
+	light[6] = color.getB();
+	light[7] = color.getA();
+	lightsChanged = true;
+}
+
+void ClusteredLights::clear() {
+	lightData.clear();
+	lightsChanged = true;
+}
+
+void ClusteredLights::update(RenderingContext & context) {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	if(!isSupported()) {
+		WARN("ClusteredLights::update: Compute shaders are not supported.");
+		return;
+	}
+	if(assignmentShader.isNull()) {
+		assignmentShader = Shader::createShader(Shader::USE_UNIFORMS);
+		assignmentShader->attachShaderObject(ShaderObjectInfo::createCompute(assignmentProgram));
+	}
+	if(lightsChanged) {
+		if(lightData.empty()) // keep a valid buffer for binding
+			lightBuffer.allocateData<float>(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 8, BufferObject::USAGE_DYNAMIC_DRAW);
+		else
+			lightBuffer.uploadData(BufferObject::TARGET_SHADER_STORAGE_BUFFER, lightData, BufferObject::USAGE_DYNAMIC_DRAW);
+		lightsChanged = false;
+	}
+	if(!countBuffer.isValid()) {
+		countBuffer.allocateData<uint32_t>(BufferObject::TARGET_SHADER_STORAGE_BUFFER, getClusterCount(), BufferObject::USAGE_DYNAMIC_COPY);
+		indexBuffer.allocateData<uint32_t>(BufferObject::TARGET_SHADER_STORAGE_BUFFER,
+											static_cast<std::size_t>(getClusterCount()) * maxLightsPerCluster, BufferObject::USAGE_DYNAMIC_COPY);
+	}
+
+	// distances of the near and the far plane
+	const Geometry::Matrix4x4 clippingToCamera = context.getMatrix_cameraToClipping().inverse();
+	const Geometry::Vec4 nearPoint = clippingToCamera * Geometry::Vec4(0.0f, 0.0f, -1.0f, 1.0f);
+	const Geometry::Vec4 farPoint = clippingToCamera * Geometry::Vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	zNear = std::max(-nearPoint.getZ() / nearPoint.getW(), 1.0e-4f);
+	zFar = std::max(-farPoint.getZ() / farPoint.getW(), zNear * 1.001f);
+
+	context.pushAndSetShader(assignmentShader.get());
+	assignmentShader->setUniform(context, Uniform("worldToCamera", context.getMatrix_worldToCamera()));
+	assignmentShader->setUniform(context, Uniform("clippingToCamera", clippingToCamera));
+	assignmentShader->setUniform(context, Uniform("gridSize", Geometry::Vec3i(gridX, gridY, gridZ)));
+	assignmentShader->setUniform(context, Uniform("zRange", Geometry::Vec2(zNear, zFar)));
+	assignmentShader->setUniform(context, Uniform("lightCount", static_cast<int32_t>(getLightCount())));
+	assignmentShader->setUniform(context, Uniform("maxLightsPerCluster", static_cast<int32_t>(maxLightsPerCluster)));
+	BufferObject::bindBuffers(BufferObject::TARGET_SHADER_STORAGE_BUFFER, LIGHTS_BINDING, {&lightBuffer, &countBuffer, &indexBuffer});
+
+	context.dispatchCompute((getClusterCount() + 63) / 64);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	BufferObject::unbindBuffers(BufferObject::TARGET_SHADER_STORAGE_BUFFER, LIGHTS_BINDING, 3);
+	context.popShader();
+	GET_GL_ERROR();
+#else
+	WARN("ClusteredLights::update: Compute shaders are not supported.");
+#endif
+}
+
+void ClusteredLights::bind(RenderingContext & context) {
+	if(!countBuffer.isValid()) {
+		WARN("ClusteredLights::bind: update() has not been called.");
+		return;
+	}
+	context.setGlobalUniform(Uniform(UNIFORM_SG_CLUSTER_GRID_SIZE, Geometry::Vec3i(gridX, gridY, gridZ)));
+	context.setGlobalUniform(Uniform(UNIFORM_SG_CLUSTER_Z_RANGE, Geometry::Vec2(zNear, zFar)));
+	context.setGlobalUniform(Uniform(UNIFORM_SG_CLUSTER_MAX_LIGHTS, static_cast<int32_t>(maxLightsPerCluster)));
+	BufferObject::bindBuffers(BufferObject::TARGET_SHADER_STORAGE_BUFFER, LIGHTS_BINDING, {&lightBuffer, &countBuffer, &indexBuffer});
+}
+
+void ClusteredLights::unbind(RenderingContext & /*context*/) {
+	if(!countBuffer.isValid())
+		return;
+	BufferObject::unbindBuffers(BufferObject::TARGET_SHADER_STORAGE_BUFFER, LIGHTS_BINDING, 3);
+}
+
+}
@@ -0,0 +1,98 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_CLUSTEREDLIGHTS_H_
+#define RENDERING_CLUSTEREDLIGHTS_H_
+
+#include "BufferObject.h"
+#include <Geometry/Vec3.h>
+#include <Util/Graphics/Color.h>
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+class RenderingContext;
+class Shader;
+
+/**
+ * Clustered forward shading for a large number of point lights, which are not limited by the light slots of
+ * RenderingContext::enableLight().
+ *
+ * The lights are stored in a shader storage buffer (std430 array of { vec4 positionRadius; vec4 color; }, the position
+ * in world coordinates). The view frustum is divided into gridX x gridY x gridZ clusters: the x and y axes are divided
+ * uniformly in screen space, the z axis exponentially between the near and the far plane. update() dispatches a compute
+ * shader that determines, for each cluster, the (up to maxLightsPerCluster) lights whose spheres intersect the cluster.
+ *
+ * bind() binds the lights to LIGHTS_BINDING, the number of lights per cluster to COUNTS_BINDING and the light indices
+ * to INDICES_BINDING, and sets the global uniforms declared by getShaderInterface(). A fragment shader includes the
+ * interface and iterates over the lights of its cluster:
+ * \code
+ * const uint cluster = sg_getCluster(gl_FragCoord.xy, positionInCamera.z);
+ * for(uint i = 0; i < sg_getClusterLightCount(cluster); ++i) {
+ *     const ClusteredLight light = sg_getClusterLight(cluster, i);
+ *     vec3 toLight = (sg_matrix_worldToCamera * vec4(light.positionRadius.xyz, 1.0)).xyz - positionInCamera.xyz;
+ *     ...
+ * }
+ * \endcode
+ *
+ * @note Requires OpenGL 4.3 (compute shaders and shader storage buffers).
+ */
+class ClusteredLights : public Util::ReferenceCounter<ClusteredLights> {
+	public:
+		static const uint32_t LIGHTS_BINDING = 4;
+		static const uint32_t COUNTS_BINDING = 5;
+		static const uint32_t INDICES_BINDING = 6;
+
+		static bool isSupported();
+
+		//! GLSL declarations (buffers, uniforms and access functions) to be included into a shader using the lights.
+		static const char * getShaderInterface();
+
+		/*! Create an empty light set.
+			@throw std::invalid_argument if a grid dimension or @p maxLightsPerCluster is zero. */
+		explicit ClusteredLights(uint32_t gridX = 16, uint32_t gridY = 9, uint32_t gridZ = 24, uint32_t maxLightsPerCluster = 128);
+		~ClusteredLights();
+
+		// lights
+		//! Add a point light and return its index.
+		uint32_t addLight(const Geometry::Vec3 & position, float radius, const Util::Color4f & color);
+		//! @throw std::out_of_range if @p index is invalid.
+		void setLight(uint32_t index, const Geometry::Vec3 & position, float radius, const Util::Color4f & color);
+		void clear();
+		uint32_t getLightCount() const						{	return static_cast<uint32_t>(lightData.size() / 8);	}
+
+		uint32_t getClusterCount() const					{	return gridX * gridY * gridZ;	}
+		uint32_t getMaxLightsPerCluster() const				{	return maxLightsPerCluster;	}
+
+		/*! Assign the lights to the clusters of the current camera and projection matrices.
+			Has to be called whenever the camera, the projection or the lights changed. */
+		void update(RenderingContext & context);
+
+		//! Bind the buffers and set the global uniforms for rendering with the lights assigned by the last update().
+		void bind(RenderingContext & context);
+		void unbind(RenderingContext & context);
+
+	private:
+		const uint32_t gridX, gridY, gridZ;
+		const uint32_t maxLightsPerCluster;
+		std::vector<float> lightData; // positionRadius, color
+		bool lightsChanged;
+		float zNear, zFar;
+		BufferObject lightBuffer;
+		BufferObject countBuffer;
+		BufferObject indexBuffer;
+		Util::Reference<Shader> assignmentShader;
+};
+
+}
+
+#endif /* RENDERING_CLUSTEREDLIGHTS_H_ */
@@ -0,0 +1,209 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ComputePass.h"
+#include "BufferObject.h"
+#include "Capabilities.h"
+#include "RenderingContext/RenderingContext.h"
+#include "RenderingContext/RenderingParameters.h"
+#include "Shader/Shader.h"
+#include "Texture/Texture.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Util/Macros.h>
+
+namespace Rendering {
+
+bool ComputePass::isSupported() {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	const Capabilities & capabilities = Capabilities::get();
+	return capabilities.computeShader && capabilities.shaderStorageBuffer;
+#else
+	return false;
+#endif
+}
+
+ComputePass::ComputePass(Shader * _shader) : shader(_shader), finalBarrierBits(0) {
+}
+
+ComputePass::~ComputePass() = default;
+
+std::array<uint32_t, 3> ComputePass::getWorkGroupSize() {
+	if(shader.isNull() || (shader->getStatus() != Shader::LINKED && !shader->init()))
+		return {{0, 0, 0}};
+	return shader->getReflection().workGroupSize;
+}
+
+const void * ComputePass::Binding::getResource() const {
+	return type == STORAGE_BUFFER ? static_cast<const void *>(buffer) : static_cast<const void *>(texture.get());
+}
+
+uint32_t ComputePass::Binding::getBarrierBit() const {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	switch(type) {
+		case STORAGE_BUFFER:
+			return GL_SHADER_STORAGE_BARRIER_BIT;
+		case IMAGE:
+			return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+		case TEXTURE:
+		default:
+			return GL_TEXTURE_FETCH_BARRIER_BIT;
+	}
+#else
+	return 0;
+#endif
+}
+
+void ComputePass::bindStorageBuffer(uint32_t binding, BufferObject * buffer, access_t access) {
+	Binding b;
+	b.type = STORAGE_BUFFER;
+	b.access = access;
+	b.location = binding;
+	b.level = 0;
+	b.buffer = buffer;
+	bindings.emplace_back(std::move(b));
+}
+
+void ComputePass::bindImage(uint8_t unit, Texture * texture, access_t access, uint32_t level) {
+	Binding b;
+	b.type = IMAGE;
+	b.access = access;
+	b.location = unit;
+	b.level = level;
+	b.buffer = nullptr;
+	b.texture = texture;
+	bindings.emplace_back(std::move(b));
+}
+
+void ComputePass::bindTexture(uint8_t unit, Texture * texture) {
+	Binding b;
+	b.type = TEXTURE;
+	b.access = READ;
+	b.location = unit;
+	b.level = 0;
+	b.buffer = nullptr;
+	b.texture = texture;
+	bindings.emplace_back(std::move(b));
+}
+
+void ComputePass::clearBindings() {
+	bindings.clear();
+}
+
+uint32_t ComputePass::execute(RenderingContext & context, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ) {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	if(!isSupported()) {
+		WARN("ComputePass::execute: Compute shaders are not supported.");
+		return 0;
+	}
+	uint32_t issuedBits = 0;
+	for(ComputePass * pass = this; pass != nullptr; pass = pass->getNext())
+		issuedBits |= pass->dispatch(context, pendingWrites, sizeX, sizeY, sizeZ);
+
+	uint32_t finalBits = 0;
+	for(const auto & write : pendingWrites)
+		finalBits |= finalBarrierBits & ~write.issuedBits;
+	if(finalBits != 0) {
+		glMemoryBarrier(finalBits);
+		for(auto & write : pendingWrites)
+			write.issuedBits |= finalBits;
+		issuedBits |= finalBits;
+	}
+	GET_GL_ERROR();
+	return issuedBits;
+#else
+	static_cast<void>(context);
+	static_cast<void>(sizeX);
+	static_cast<void>(sizeY);
+	static_cast<void>(sizeZ);
+	WARN("ComputePass::execute: Compute shaders are not supported.");
+	return 0;
+#endif
+}
+
+//! (internal)
+uint32_t ComputePass::dispatch(RenderingContext & context, std::vector<PendingWrite> & writes, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ) {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	const auto groupSize = getWorkGroupSize();
+	if(groupSize[0] == 0) {
+		WARN("ComputePass::execute: The shader is no valid compute shader.");
+		return 0;
+	}
+
+	// only make the writes visible that are accessed by this pass
+	uint32_t requiredBits = 0;
+	for(const auto & binding : bindings) {
+		const uint32_t bit = binding.getBarrierBit();
+		for(const auto & write : writes) {
+			if(write.resource == binding.getResource() && (write.issuedBits & bit) == 0)
+				requiredBits |= bit;
+		}
+	}
+	if(requiredBits != 0) {
+		glMemoryBarrier(requiredBits);
+		for(auto & write : writes)
+			write.issuedBits |= requiredBits;
+	}
+
+	context.pushAndSetShader(shader.get());
+	for(const auto & binding : bindings) {
+		if(binding.type == STORAGE_BUFFER) {
+			binding.buffer->bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, binding.location);
+		} else if(binding.type == IMAGE) {
+			ImageBindParameters image(binding.texture.get());
+			image.setLevel(binding.level);
+			image.setReadOperations((binding.access & READ) != 0);
+			image.setWriteOperations((binding.access & WRITE) != 0);
+			context.pushAndSetBoundImage(static_cast<uint8_t>(binding.location), image);
+		} else {
+			context.pushAndSetTexture(static_cast<uint8_t>(binding.location), binding.texture.get());
+		}
+	}
+
+	context.dispatchCompute((sizeX + groupSize[0] - 1) / groupSize[0],
+							(sizeY + groupSize[1] - 1) / groupSize[1],
+							(sizeZ + groupSize[2] - 1) / groupSize[2]);
+
+	for(auto it = bindings.rbegin(); it != bindings.rend(); ++it) {
+		if(it->type == STORAGE_BUFFER)
+			it->buffer->unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, it->location);
+		else if(it->type == IMAGE)
+			context.popBoundImage(static_cast<uint8_t>(it->location));
+		else
+			context.popTexture(static_cast<uint8_t>(it->location));
+	}
+	context.popShader();
+
+	// remember the written resources
+	for(const auto & binding : bindings) {
+		if((binding.access & WRITE) == 0)
+			continue;
+		bool found = false;
+		for(auto & write : writes) {
+			if(write.resource == binding.getResource()) {
+				write.issuedBits = 0;
+				found = true;
+			}
+		}
+		if(!found)
+			writes.push_back({binding.getResource(), 0});
+	}
+	return requiredBits;
+#else
+	static_cast<void>(context);
+	static_cast<void>(writes);
+	static_cast<void>(sizeX);
+	static_cast<void>(sizeY);
+	static_cast<void>(sizeZ);
+	return 0;
+#endif
+}
+
+}
@@ -0,0 +1,127 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_COMPUTEPASS_H_
+#define RENDERING_COMPUTEPASS_H_
+
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+class BufferObject;
+class RenderingContext;
+class Shader;
+class Texture;
+
+/**
+ * A compute shader dispatch together with the resources it accesses.
+ *
+ * The pass declares its shader storage buffers, images and sampled textures. execute() binds them, computes the
+ * number of work groups from the problem size and the work group size of the shader (see
+ * ShaderReflection::workGroupSize) and unbinds them afterwards. Passes can be chained with setNext(); executing
+ * the first pass executes the whole chain.
+ *
+ * Instead of a conservative glMemoryBarrier(GL_ALL_BARRIER_BITS) after every dispatch, the chain remembers which
+ * resources have been written. Before a pass accesses such a resource, a barrier with only the bit matching the
+ * declared access (storage buffer, image or texture fetch) is issued. Accesses of the written resources after
+ * the chain (e.g. indirect draws or buffer readbacks) are declared with setFinalBarrierBits().
+ *
+ * \code
+ *	Util::Reference<ComputePass> blur = new ComputePass(blurShader);
+ *	blur->bindTexture(0, source);
+ *	blur->bindImage(0, target, ComputePass::WRITE);
+ *	blur->setFinalBarrierBits(GL_TEXTURE_FETCH_BARRIER_BIT);
+ *	blur->execute(context, width, height);
+ * \endcode
+ *
+ * \note The declared buffers are not reference counted and must outlive the pass.
+ * \note Requires OpenGL 4.3 (compute shaders and shader storage buffers).
+ */
+class ComputePass : public Util::ReferenceCounter<ComputePass> {
+	public:
+		enum access_t : uint8_t {
+			READ = 1 << 0,
+			WRITE = 1 << 1,
+			READ_WRITE = READ | WRITE
+		};
+
+		static bool isSupported();
+
+		explicit ComputePass(Shader * shader);
+		~ComputePass();
+
+		Shader * getShader() const						{	return shader.get();	}
+
+		/*! Local size of the shader's work groups (taken from the reflection of the linked shader).
+			Returns (0,0,0) if the shader can not be linked or is no compute shader. */
+		std::array<uint32_t, 3> getWorkGroupSize();
+
+		//! Bind the buffer to the shader storage binding point @p binding during the pass.
+		void bindStorageBuffer(uint32_t binding, BufferObject * buffer, access_t access);
+		//! Bind the given level of the texture to the image unit @p unit during the pass.
+		void bindImage(uint8_t unit, Texture * texture, access_t access, uint32_t level = 0);
+		//! Bind the texture to the texture unit @p unit for sampling during the pass.
+		void bindTexture(uint8_t unit, Texture * texture);
+		//! Remove all declared resources.
+		void clearBindings();
+
+		//! Execute @p next after this pass (and its successors). nullptr ends the chain.
+		void setNext(ComputePass * next)				{	nextPass = next;	}
+		ComputePass * getNext() const					{	return nextPass.get();	}
+
+		/*! Barrier bits issued after the last pass of the chain if any declared resource has been written
+			(e.g. GL_COMMAND_BARRIER_BIT for written indirect draw commands). The bits of the first pass are used. */
+		void setFinalBarrierBits(uint32_t bits)			{	finalBarrierBits = bits;	}
+		uint32_t getFinalBarrierBits() const			{	return finalBarrierBits;	}
+
+		/*! Execute the pass and its successors for a problem of the given size (in invocations).
+			The number of work groups of each dimension is ceil(size / work group size) of the respective pass.
+			\note The chain must not contain cycles.
+			\return the barrier bits that have been issued. */
+		uint32_t execute(RenderingContext & context, uint32_t sizeX, uint32_t sizeY = 1, uint32_t sizeZ = 1);
+
+	private:
+		enum binding_t : uint8_t {
+			STORAGE_BUFFER,
+			IMAGE,
+			TEXTURE
+		};
+		struct Binding {
+			binding_t type;
+			access_t access;
+			uint32_t location; //!< binding point or unit
+			uint32_t level;
+			BufferObject * buffer;
+			Util::Reference<Texture> texture;
+			const void * getResource() const;
+			//! The barrier bit that makes previous incoherent writes visible to this kind of access.
+			uint32_t getBarrierBit() const;
+		};
+		//! A resource that has been written by a pass and the barrier bits that have been issued since then.
+		struct PendingWrite {
+			const void * resource;
+			uint32_t issuedBits;
+		};
+
+		Util::Reference<Shader> shader;
+		std::vector<Binding> bindings;
+		Util::Reference<ComputePass> nextPass;
+		uint32_t finalBarrierBits;
+		std::vector<PendingWrite> pendingWrites; //!< state of the chain starting with this pass
+
+		uint32_t dispatch(RenderingContext & context, std::vector<PendingWrite> & writes, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ);
+};
+
+}
+
+#endif /* RENDERING_COMPUTEPASS_H_ */
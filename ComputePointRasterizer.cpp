@@ -0,0 +1,302 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ComputePointRasterizer.h"
+#include "Draw.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include "Mesh/Mesh.h"
+#include "Mesh/MeshVertexData.h"
+#include "Mesh/VertexAttributeIds.h"
+#include "Mesh/VertexDescription.h"
+#include "Shader/Shader.h"
+#include "Shader/ShaderObjectInfo.h"
+#include "Shader/Uniform.h"
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Rect.h>
+#include <Geometry/Vec4.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+
+namespace Rendering {
+
+/* The frame buffer contains two 32-bit values per pixel. With 64-bit atomics, they form one value (depth in the
+	high, color in the low bits); otherwise, the depths of all pixels are followed by the colors.
+	The depth is stored as bits of a float in [0, 1], which compare like unsigned integers.	*/
+static const char * const rasterizeProgram =
+R"***(
+layout(local_size_x = 128) in;
+layout(std430, binding = 0) readonly buffer Vertices { uint vertexData[]; };
+#ifdef USE_INT64
+layout(std430, binding = 1) buffer Frame { uint64_t frame[]; };
+#else
+layout(std430, binding = 1) buffer Frame { uint frame[]; };
+uniform int colorPass;
+#endif
+uniform mat4 modelToClipping;
+uniform int viewportWidth;
+uniform int viewportHeight;
+uniform int firstVertex;
+uniform int vertexCount;
+uniform int vertexStride;	// in 32-bit words
+uniform int positionOffset;
+uniform int colorOffset;
+uniform int colorFormat;	// 0: default color, 1: RGBA8, 2: RGB float, 3: RGBA float
+uniform vec4 defaultColor;
+
+uint readColor(const uint base) {
+	if(colorFormat == 1)
+		return vertexData[base + uint(colorOffset)];
+	vec4 color = defaultColor;
+	if(colorFormat >= 2) {
+		color.r = uintBitsToFloat(vertexData[base + uint(colorOffset)]);
+		color.g = uintBitsToFloat(vertexData[base + uint(colorOffset) + 1u]);
+		color.b = uintBitsToFloat(vertexData[base + uint(colorOffset) + 2u]);
+		color.a = colorFormat == 3 ? uintBitsToFloat(vertexData[base + uint(colorOffset) + 3u]) : 1.0;
+	}
+	return packUnorm4x8(color);
+}
+
+void main() {
+	const uint i = gl_GlobalInvocationID.x;
+	if(i >= uint(vertexCount))
+		return;
+	const uint base = (uint(firstVertex) + i) * uint(vertexStride);
+	const uint p = base + uint(positionOffset);
+	const vec3 pos = vec3(uintBitsToFloat(vertexData[p]), uintBitsToFloat(vertexData[p + 1u]), uintBitsToFloat(vertexData[p + 2u]));
+	const vec4 clipPos = modelToClipping * vec4(pos, 1.0);
+	if(clipPos.w <= 0.0)
+		return;
+	const vec3 ndc = clipPos.xyz / clipPos.w;
+	if(any(lessThan(ndc, vec3(-1.0))) || any(greaterThanEqual(ndc, vec3(1.0))))
+		return;
+	const ivec2 pixel = ivec2((ndc.xy * 0.5 + 0.5) * vec2(viewportWidth, viewportHeight));
+	const uint index = uint(pixel.y * viewportWidth + pixel.x);
+	const uint depth = floatBitsToUint(ndc.z * 0.5 + 0.5);
+#ifdef USE_INT64
+	atomicMin(frame[index], (uint64_t(depth) << 32) | uint64_t(readColor(base)));
+#else
+	if(colorPass == 0)
+		atomicMin(frame[index], depth);
+	else if(frame[index] == depth)
+		frame[uint(viewportWidth * viewportHeight) + index] = readColor(base);
+#endif
+}
+)***";
+
+static const char * const resolveVertexProgram =
+R"***(#version 430
+in vec3 sg_Position;
+void main() {
+	gl_Position = vec4(sg_Position.xy, 0.0, 1.0);
+}
+)***";
+
+static const char * const resolveFragmentProgram =
+R"***(
+layout(std430, binding = 1) readonly buffer Frame { uint frame[]; };
+uniform int viewportX;
+uniform int viewportY;
+uniform int viewportWidth;
+uniform int viewportHeight;
+out vec4 fragColor;
+
+void main() {
+	const ivec2 pixel = ivec2(gl_FragCoord.xy) - ivec2(viewportX, viewportY);
+	const uint index = uint(pixel.y * viewportWidth + pixel.x);
+#ifdef USE_INT64
+	const uint depth = frame[2u * index + 1u];
+	const uint color = frame[2u * index];
+#else
+	const uint depth = frame[index];
+	const uint color = frame[uint(viewportWidth * viewportHeight) + index];
+#endif
+	if(depth == 0xffffffffu)
+		discard;
+	fragColor = unpackUnorm4x8(color);
+	gl_FragDepth = uintBitsToFloat(depth);
+}
+)***";
+
+//! (static)
+bool ComputePointRasterizer::isSupported() {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	static const bool support = isExtensionSupported("GL_ARB_compute_shader") &&
+								isExtensionSupported("GL_ARB_shader_storage_buffer_object");
+	return support;
+#else
+	return false;
+#endif
+}
+
+//! (static)
+bool ComputePointRasterizer::isInt64Supported() {
+#if defined(LIB_GL)
+	static const bool support = isSupported() && isExtensionSupported("GL_ARB_gpu_shader_int64") &&
+								isExtensionSupported("GL_NV_shader_atomic_int64");
+	return support;
+#else
+	return false;
+#endif
+}
+
+ComputePointRasterizer::ComputePointRasterizer() :
+		ReferenceCounter_t(), width(0), height(0), originX(0), originY(0), active(false), rasterizedPoints(0),
+		defaultColor(1.0f, 1.0f, 1.0f, 1.0f) {
+}
+
+ComputePointRasterizer::~ComputePointRasterizer() = default;
+
+//! (internal)
+void ComputePointRasterizer::initShaders() {
+	if(rasterizeShader.isNotNull())
+		return;
+	const std::string header = isInt64Supported() ?
+			"#version 430\n#extension GL_ARB_gpu_shader_int64 : require\n#extension GL_NV_shader_atomic_int64 : require\n#define USE_INT64\n" :
+			"#version 430\n";
+	rasterizeShader = Shader::createShader(Shader::USE_UNIFORMS);
+	rasterizeShader->attachShaderObject(ShaderObjectInfo::createCompute(header + rasterizeProgram));
+	resolveShader = Shader::createShader(Shader::USE_UNIFORMS);
+	resolveShader->attachShaderObject(ShaderObjectInfo::createVertex(resolveVertexProgram));
+	resolveShader->attachShaderObject(ShaderObjectInfo::createFragment(std::string(isInt64Supported() ? "#version 430\n#define USE_INT64\n" : "#version 430\n") + resolveFragmentProgram));
+}
+
+void ComputePointRasterizer::begin(RenderingContext & context) {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	if(!isSupported()) {
+		WARN("ComputePointRasterizer::begin: Compute shaders are not supported.");
+		return;
+	}
+	initShaders();
+	const Geometry::Rect_i & viewport = context.getViewport();
+	const uint32_t newWidth = static_cast<uint32_t>(std::max(viewport.getWidth(), 1));
+	const uint32_t newHeight = static_cast<uint32_t>(std::max(viewport.getHeight(), 1));
+	if(!frameBuffer.isValid() || newWidth != width || newHeight != height) {
+		width = newWidth;
+		height = newHeight;
+		frameBuffer.allocateData<uint32_t>(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 2 * static_cast<size_t>(width) * height, BufferObject::USAGE_DYNAMIC_COPY);
+	}
+	originX = viewport.getX();
+	originY = viewport.getY();
+	static const uint32_t clearValue = 0xffffffff;
+	frameBuffer.clear(BufferObject::TARGET_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, reinterpret_cast<const uint8_t *>(&clearValue));
+	active = true;
+	rasterizedPoints = 0;
+	GET_GL_ERROR();
+#else
+	WARN("ComputePointRasterizer::begin: Compute shaders are not supported.");
+#endif
+}
+
+//! (static)
+bool ComputePointRasterizer::canRasterize(Mesh * mesh) {
+	if(mesh == nullptr || mesh->isView() || mesh->getDrawMode() != Mesh::DRAW_POINTS || mesh->isUsingIndexData())
+		return false;
+	const VertexDescription & vd = mesh->getVertexDescription();
+	const VertexAttribute & position = vd.getAttribute(VertexAttributeIds::POSITION);
+	return (vd.getVertexSize() % 4) == 0 && !position.empty() && position.getDataType() == GL_FLOAT &&
+			position.getNumValues() >= 3 && (position.getOffset() % 4) == 0;
+}
+
+bool ComputePointRasterizer::rasterize(RenderingContext & context, Mesh * mesh, uint32_t firstElement, uint32_t elementCount) {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	if(!canRasterize(mesh) || !isSupported())
+		return false;
+	MeshVertexData & vertexData = mesh->_getVertexData();
+	if(!vertexData.isUploaded())
+		vertexData.upload();
+	const BufferObject * vertexBuffer = vertexData._getBufferObject();
+	if(vertexBuffer == nullptr) // e.g. stored in a streaming buffer or an arena
+		return false;
+	if(!active)
+		begin(context);
+	if(elementCount == 0 || firstElement >= vertexData.getVertexCount())
+		return true;
+	elementCount = std::min(elementCount, vertexData.getVertexCount() - firstElement);
+
+	const VertexDescription & vd = vertexData.getVertexDescription();
+	const VertexAttribute & color = vd.getAttribute(VertexAttributeIds::COLOR);
+	int32_t colorFormat = 0;
+	if(!color.empty() && (color.getOffset() % 4) == 0) {
+		if(color.getDataType() == GL_UNSIGNED_BYTE && color.getNumValues() == 4 && color.getNormalize())
+			colorFormat = 1;
+		else if(color.getDataType() == GL_FLOAT && color.getNumValues() >= 3)
+			colorFormat = color.getNumValues() == 3 ? 2 : 3;
+	}
+
+	context.pushAndSetShader(rasterizeShader.get());
+	Shader * shader = rasterizeShader.get();
+	shader->setUniform(context, Uniform("modelToClipping", context.getMatrix_cameraToClipping() * context.getMatrix_modelToCamera()));
+	shader->setUniform(context, Uniform("viewportWidth", static_cast<int32_t>(width)));
+	shader->setUniform(context, Uniform("viewportHeight", static_cast<int32_t>(height)));
+	shader->setUniform(context, Uniform("firstVertex", static_cast<int32_t>(firstElement)));
+	shader->setUniform(context, Uniform("vertexCount", static_cast<int32_t>(elementCount)));
+	shader->setUniform(context, Uniform("vertexStride", static_cast<int32_t>(vd.getVertexSize() / 4)));
+	shader->setUniform(context, Uniform("positionOffset", static_cast<int32_t>(vd.getAttribute(VertexAttributeIds::POSITION).getOffset() / 4)));
+	shader->setUniform(context, Uniform("colorOffset", static_cast<int32_t>(color.getOffset() / 4)));
+	shader->setUniform(context, Uniform("colorFormat", colorFormat));
+	shader->setUniform(context, Uniform("defaultColor", defaultColor));
+	vertexBuffer->bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 0);
+	frameBuffer.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 1);
+	const uint32_t numGroups = (elementCount + 127) / 128;
+	if(isInt64Supported()) {
+		context.dispatchCompute(numGroups);
+	} else {
+		shader->setUniform(context, Uniform("colorPass", 0));
+		context.dispatchCompute(numGroups);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		shader->setUniform(context, Uniform("colorPass", 1));
+		context.dispatchCompute(numGroups);
+	}
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	frameBuffer.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 1);
+	vertexBuffer->unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 0);
+	context.popShader();
+	rasterizedPoints += elementCount;
+	GET_GL_ERROR();
+	return true;
+#else
+	return false;
+#endif
+}
+
+void ComputePointRasterizer::resolve(RenderingContext & context) {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	if(!active)
+		return;
+	active = false;
+	context.pushAndSetShader(resolveShader.get());
+	resolveShader->setUniform(context, Uniform("viewportX", originX));
+	resolveShader->setUniform(context, Uniform("viewportY", originY));
+	resolveShader->setUniform(context, Uniform("viewportWidth", static_cast<int32_t>(width)));
+	resolveShader->setUniform(context, Uniform("viewportHeight", static_cast<int32_t>(height)));
+	frameBuffer.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 1);
+	drawFullScreenRect(context);
+	frameBuffer.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 1);
+	context.popShader();
+	GET_GL_ERROR();
+#endif
+}
+
+RenderingContext::DisplayMeshFn ComputePointRasterizer::createDisplayMeshFn(RenderingContext::DisplayMeshFn fallback) {
+	if(!fallback) {
+		using namespace std::placeholders;
+		fallback = std::bind(&Mesh::_display, _2, _1, _3, _4);
+	}
+	Util::Reference<ComputePointRasterizer> rasterizer(this);
+	return [rasterizer, fallback](RenderingContext & context, Mesh * mesh, uint32_t firstElement, uint32_t elementCount) {
+		if(!rasterizer->rasterize(context, mesh, firstElement, elementCount))
+			fallback(context, mesh, firstElement, elementCount);
+	};
+}
+
+}
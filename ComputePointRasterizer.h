@@ -0,0 +1,100 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_COMPUTEPOINTRASTERIZER_H_
+#define RENDERING_COMPUTEPOINTRASTERIZER_H_
+
+#include "BufferObject.h"
+#include "RenderingContext/RenderingContext.h"
+#include <Util/Graphics/Color.h>
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstdint>
+
+namespace Rendering {
+class Mesh;
+class Shader;
+
+/**
+ * Rasterization of dense point clouds with compute shaders instead of drawing GL_POINTS
+ * (following Schütz et al., "Rendering Point Clouds with Compute Shaders and Vertex Order Optimization", 2021).
+ *
+ * Every point is projected by a compute shader thread, which writes its depth and color packed into one
+ * 64-bit value with atomicMin into a buffer with one value per pixel of the viewport, so the closest point
+ * of every pixel remains. resolve() draws the buffer into the current FBO, writing the colors and depths
+ * of the covered pixels (using the current depth test and blending state).
+ * If 64-bit atomics are not supported (GL_NV_shader_atomic_int64), every mesh is rasterized in two passes:
+ * the first one determines the depth with 32-bit atomics, the second one writes the colors of the points
+ * with that depth.
+ * \code
+ * rasterizer->begin(renderingContext);
+ * renderingContext.setDisplayMeshFn(rasterizer->createDisplayMeshFn());
+ * // ... display the scene; point meshes are rasterized, other meshes are drawn as usual
+ * renderingContext.resetDisplayMeshFn();
+ * rasterizer->resolve(renderingContext);
+ * \endcode
+ * @note Every point covers a single pixel; the point size and the active shader are ignored.
+ * @note The points have to be stored in a VBO of their own with three float coordinates. Colors are used
+ *   if the mesh has a color attribute of type RGBA8 or RGB(A) float.
+ * @note Requires OpenGL 4.3 (compute shaders and shader storage buffers).
+ */
+class ComputePointRasterizer : public Util::ReferenceCounter<ComputePointRasterizer> {
+	public:
+		static bool isSupported();
+		//! (static) @c true iff 64-bit atomic operations are supported and a single pass per mesh suffices.
+		static bool isInt64Supported();
+
+		ComputePointRasterizer();
+		~ComputePointRasterizer();
+
+		//! Color of points of meshes without color attribute (default: white).
+		void setDefaultColor(const Util::Color4f & color)	{	defaultColor = color;	}
+		const Util::Color4f & getDefaultColor() const		{	return defaultColor;	}
+
+		//! Clear the buffer; it is resized to the current viewport if necessary.
+		void begin(RenderingContext & context);
+
+		//! @c true iff the points of the mesh can be rasterized (see the notes above).
+		static bool canRasterize(Mesh * mesh);
+
+		/*! Rasterize the vertices [firstElement, firstElement + elementCount) of the point mesh using the current
+			modelview and projection matrices. Calls begin() if it has not been called since the last resolve().
+			@return @c false if the mesh cannot be rasterized (see canRasterize()).	*/
+		bool rasterize(RenderingContext & context, Mesh * mesh, uint32_t firstElement, uint32_t elementCount);
+
+		//! Draw the rasterized points into the current FBO.
+		void resolve(RenderingContext & context);
+
+		/*! Return a function for RenderingContext::setDisplayMeshFn that rasterizes point meshes that can be
+			rasterized and passes all other meshes to @p fallback (Mesh::_display if empty).
+			\note The function holds a reference to the rasterizer.	*/
+		RenderingContext::DisplayMeshFn createDisplayMeshFn(RenderingContext::DisplayMeshFn fallback = RenderingContext::DisplayMeshFn());
+
+		//! Number of points rasterized since the last call of begin().
+		uint64_t getRasterizedPoints() const				{	return rasterizedPoints;	}
+
+	private:
+		BufferObject frameBuffer;
+		uint32_t width;
+		uint32_t height;
+		int32_t originX;
+		int32_t originY;
+		bool active;
+		uint64_t rasterizedPoints;
+		Util::Color4f defaultColor;
+		Util::Reference<Shader> rasterizeShader;
+		Util::Reference<Shader> resolveShader;
+
+		void initShaders();
+};
+
+}
+
+#endif /* RENDERING_COMPUTEPOINTRASTERIZER_H_ */
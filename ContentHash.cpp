@@ -0,0 +1,103 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ContentHash.h"
+#include <cstring>
+
+namespace Rendering {
+
+static const uint64_t PRIME1 = 11400714785074694791ULL;
+static const uint64_t PRIME2 = 14029467366897019727ULL;
+static const uint64_t PRIME3 = 1609587929392839161ULL;
+static const uint64_t PRIME4 = 9650029242287828579ULL;
+static const uint64_t PRIME5 = 2870177450012600261ULL;
+
+static inline uint64_t rotateLeft(uint64_t value, int bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+//! (internal) Unaligned load of a 64 bit word.
+static inline uint64_t read64(const uint8_t * cursor) {
+	uint64_t value;
+	std::memcpy(&value, cursor, sizeof(value));
+	return value;
+}
+
+static inline uint32_t read32(const uint8_t * cursor) {
+	uint32_t value;
+	std::memcpy(&value, cursor, sizeof(value));
+	return value;
+}
+
+static inline uint64_t mixRound(uint64_t accumulator, uint64_t input) {
+	accumulator += input * PRIME2;
+	accumulator = rotateLeft(accumulator, 31);
+	return accumulator * PRIME1;
+}
+
+static inline uint64_t mergeRound(uint64_t hash, uint64_t accumulator) {
+	hash ^= mixRound(0, accumulator);
+	return hash * PRIME1 + PRIME4;
+}
+
+uint64_t calcContentHash(const uint8_t * data, std::size_t numBytes, uint64_t seed) {
+	const uint8_t * cursor = data;
+	const uint8_t * const end = data + numBytes;
+	uint64_t hash;
+
+	if(numBytes >= 32) {
+		// four independent lanes; the compiler can interleave (and vectorize) them
+		uint64_t v1 = seed + PRIME1 + PRIME2;
+		uint64_t v2 = seed + PRIME2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - PRIME1;
+		const uint8_t * const limit = end - 32;
+		do {
+			v1 = mixRound(v1, read64(cursor));
+			v2 = mixRound(v2, read64(cursor + 8));
+			v3 = mixRound(v3, read64(cursor + 16));
+			v4 = mixRound(v4, read64(cursor + 24));
+			cursor += 32;
+		} while(cursor <= limit);
+
+		hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+		hash = mergeRound(hash, v1);
+		hash = mergeRound(hash, v2);
+		hash = mergeRound(hash, v3);
+		hash = mergeRound(hash, v4);
+	} else {
+		hash = seed + PRIME5;
+	}
+	hash += static_cast<uint64_t>(numBytes);
+
+	for(; cursor + 8 <= end; cursor += 8) {
+		hash ^= mixRound(0, read64(cursor));
+		hash = rotateLeft(hash, 27) * PRIME1 + PRIME4;
+	}
+	if(cursor + 4 <= end) {
+		hash ^= static_cast<uint64_t>(read32(cursor)) * PRIME1;
+		hash = rotateLeft(hash, 23) * PRIME2 + PRIME3;
+		cursor += 4;
+	}
+	for(; cursor < end; ++cursor) {
+		hash ^= static_cast<uint64_t>(*cursor) * PRIME5;
+		hash = rotateLeft(hash, 11) * PRIME1;
+	}
+
+	// avalanche
+	hash ^= hash >> 33;
+	hash *= PRIME2;
+	hash ^= hash >> 29;
+	hash *= PRIME3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+}
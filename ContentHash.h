@@ -0,0 +1,35 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_CONTENTHASH_H_
+#define RENDERING_CONTENTHASH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Rendering {
+
+/**
+ * Calculate a 64 bit hash of the given bytes (xxHash64 algorithm).
+ * The hash is meant for detecting identical data (e.g. duplicate meshes or textures). Large buffers are processed
+ * in four independent lanes of 64 bit words, so the calculation is limited by the memory bandwidth rather than by
+ * the dependency chain of a byte-wise hash.
+ *
+ * @param data Bytes to hash (may be @c nullptr if @p numBytes is zero)
+ * @param numBytes Number of bytes
+ * @param seed Initial value; passing the hash of other data combines the hashes of several buffers.
+ * @return Hash value
+ * @note Equal hashes do not guarantee equal data; compare the data if a collision is not acceptable.
+ */
+uint64_t calcContentHash(const uint8_t * data, std::size_t numBytes, uint64_t seed = 0);
+
+}
+
+#endif /* RENDERING_CONTENTHASH_H_ */
@@ -0,0 +1,164 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "DepthPicker.h"
+#include "FBO.h"
+#include "GLHeader.h"
+#include "ReadbackQueue.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Texture/PixelFormatGL.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace Rendering {
+
+DepthPicker::DepthPicker() : ReferenceCounter_t(), tileSize(32), frameNumber(0), submittedReads(0), idFBO(), idColorBufferId(0),
+		newRequests(), batches(), lastResolved(), queue(new ReadbackQueue) {
+}
+
+DepthPicker::~DepthPicker() = default;
+
+void DepthPicker::setIdBuffer(FBO * fbo, uint32_t colorBufferId) {
+	idFBO = fbo;
+	idColorBufferId = colorBufferId;
+}
+
+bool DepthPicker::request(int32_t x, int32_t y, callback_t callback) {
+	if(x < 0 || y < 0)
+		return false;
+	newRequests.emplace_back(x, y, std::move(callback));
+	return true;
+}
+
+uint32_t DepthPicker::getPendingCount() const {
+	uint32_t count = 0;
+	for(const auto & batch : batches) {
+		for(const auto & tile : batch->tiles)
+			count += static_cast<uint32_t>(tile.requests.size());
+	}
+	return count;
+}
+
+//! (internal, static)
+DepthPicker::Sample DepthPicker::getSample(const Batch & batch, const Tile & tile, int32_t x, int32_t y) {
+	Sample sample;
+	sample.x = x;
+	sample.y = y;
+	sample.frame = batch.frame;
+	const size_t index = static_cast<size_t>(y - tile.rect.getY()) * tile.rect.getWidth() + (x - tile.rect.getX());
+	sample.depth = tile.depths[index];
+	if(!tile.ids.empty())
+		sample.id = tile.ids[index];
+	return sample;
+}
+
+//! (internal)
+void DepthPicker::resolveFinishedBatches() {
+	const uint64_t finishedReads = submittedReads - queue->getPendingCount();
+	while(!batches.empty() && batches.front()->lastRead <= finishedReads) {
+		std::unique_ptr<Batch> batch(std::move(batches.front()));
+		batches.pop_front();
+		for(auto & tile : batch->tiles) {
+			for(auto & request : tile.requests) {
+				if(request.callback)
+					request.callback(getSample(*batch, tile, request.x, request.y));
+			}
+			tile.requests.clear();
+		}
+		lastResolved = std::move(batch);
+	}
+}
+
+void DepthPicker::update(RenderingContext & context) {
+	queue->process();
+	resolveFinishedBatches();
+	++frameNumber;
+	if(newRequests.empty())
+		return;
+
+	// group the requests by tiles
+	const int32_t size = static_cast<int32_t>(tileSize);
+	std::stable_sort(newRequests.begin(), newRequests.end(), [size](const Request & a, const Request & b) {
+		return a.y / size != b.y / size ? a.y / size < b.y / size : a.x / size < b.x / size;
+	});
+	std::unique_ptr<Batch> batch(new Batch);
+	batch->frame = frameNumber;
+	for(auto begin = newRequests.begin(); begin != newRequests.end();) {
+		auto end = begin;
+		int32_t minX = begin->x, maxX = begin->x, minY = begin->y, maxY = begin->y;
+		for(; end != newRequests.end() && end->x / size == begin->x / size && end->y / size == begin->y / size; ++end) {
+			minX = std::min(minX, end->x);
+			maxX = std::max(maxX, end->x);
+			minY = std::min(minY, end->y);
+			maxY = std::max(maxY, end->y);
+		}
+		Tile tile;
+		tile.rect = Geometry::Rect_i(minX, minY, maxX - minX + 1, maxY - minY + 1);
+		tile.requests.assign(std::make_move_iterator(begin), std::make_move_iterator(end));
+		batch->tiles.emplace_back(std::move(tile));
+		begin = end;
+	}
+	newRequests.clear();
+
+	PixelFormatGL depthFormat;
+	depthFormat.glLocalDataFormat = GL_DEPTH_COMPONENT;
+	depthFormat.glLocalDataType = GL_FLOAT;
+	depthFormat.glInternalFormat = GL_DEPTH_COMPONENT;
+	PixelFormatGL idFormat;
+#ifdef LIB_GL
+	idFormat.glLocalDataFormat = GL_RED_INTEGER;
+	idFormat.glLocalDataType = GL_UNSIGNED_INT;
+	idFormat.glInternalFormat = GL_R32UI;
+#endif
+	Batch * batchPtr = batch.get();
+	for(size_t t = 0; t < batch->tiles.size(); ++t) {
+		Tile & tile = batch->tiles[t];
+		const size_t numPixels = static_cast<size_t>(tile.rect.getWidth()) * tile.rect.getHeight();
+		tile.depths.assign(numPixels, 1.0f); // the values stay at the far plane if the read fails
+		queue->readPixels(context, tile.rect, depthFormat, [batchPtr, t](const uint8_t * data, size_t numBytes) {
+			std::vector<float> & depths = batchPtr->tiles[t].depths;
+			std::memcpy(depths.data(), data, std::min(numBytes, depths.size() * sizeof(float)));
+		});
+		++submittedReads;
+		if(idFBO.isNotNull()) {
+			tile.ids.assign(numPixels, 0);
+			queue->readFramebuffer(context, idFBO.get(), idColorBufferId, tile.rect, idFormat, [batchPtr, t](const uint8_t * data, size_t numBytes) {
+				std::vector<uint32_t> & ids = batchPtr->tiles[t].ids;
+				std::memcpy(ids.data(), data, std::min(numBytes, ids.size() * sizeof(uint32_t)));
+			});
+			++submittedReads;
+		}
+	}
+	batch->lastRead = submittedReads;
+	batches.emplace_back(std::move(batch));
+	// without asynchronous readback, the data is already available
+	resolveFinishedBatches();
+}
+
+void DepthPicker::finish() {
+	queue->finish();
+	resolveFinishedBatches();
+}
+
+bool DepthPicker::getLastSample(int32_t x, int32_t y, Sample & sample) const {
+	if(!lastResolved)
+		return false;
+	for(const auto & tile : lastResolved->tiles) {
+		const Geometry::Rect_i & rect = tile.rect;
+		if(x >= rect.getX() && y >= rect.getY() && x < rect.getX() + rect.getWidth() && y < rect.getY() + rect.getHeight()) {
+			sample = getSample(*lastResolved, tile, x, y);
+			return true;
+		}
+	}
+	return false;
+}
+
+}
@@ -0,0 +1,126 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_DEPTHPICKER_H_
+#define RENDERING_DEPTHPICKER_H_
+
+#include <Geometry/Rect.h>
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Rendering {
+class FBO;
+class ReadbackQueue;
+class RenderingContext;
+
+/**
+ * Batched, asynchronous replacement for Helper::readDepthValue().
+ *
+ * Requests for single pixels are collected during a frame. update() groups them into screen tiles and reads the
+ * bounding rectangle of the requests of each tile with one readPixels into a pack buffer of a ReadbackQueue, so the
+ * CPU does not wait for the GPU. When the data has arrived (usually one or two frames later), the callbacks of the
+ * requests are called from within update().
+ * Optionally, the value of an integer id buffer (a single channel unsigned integer color attachment) is read as well.
+ *
+ * For immediate queries (e.g. snapping while the mouse moves), getLastSample() returns the value of any pixel
+ * inside of the tiles of the most recently resolved frame.
+ * \code
+ *	picker.request(mouseX, mouseY, [](const DepthPicker::Sample & s) { ... });
+ *	...
+ *	renderScene();
+ *	picker.update(renderingContext); // depth buffer of the current read framebuffer
+ * \endcode
+ */
+class DepthPicker : public Util::ReferenceCounter<DepthPicker> {
+	public:
+		struct Sample {
+			int32_t x;
+			int32_t y;
+			float depth;		//!< window space depth in [0, 1]
+			uint32_t id;		//!< value of the id buffer (0 without an id buffer)
+			uint32_t frame;		//!< number of the update() call that read the value
+			Sample() : x(0), y(0), depth(1.0f), id(0), frame(0) {}
+		};
+		typedef std::function<void (const Sample &)> callback_t;
+
+		DepthPicker();
+		~DepthPicker();
+
+		//! Edge length in pixels of the tiles whose requests are read together (default: 32).
+		void setTileSize(uint32_t size)						{	tileSize = size > 0 ? size : 1;	}
+		uint32_t getTileSize() const						{	return tileSize;	}
+
+		//! Read the ids from the color attachment @p colorBufferId of @p fbo as well; @c nullptr disables reading ids.
+		void setIdBuffer(FBO * fbo, uint32_t colorBufferId);
+
+		/*! Request the values of the pixel (@p x, @p y) (window coordinates, origin bottom left). They are read by the
+			next call of update(). @p callback may be empty if only getLastSample() is used.
+			@return false if the coordinates are negative. */
+		bool request(int32_t x, int32_t y, callback_t callback = callback_t());
+		//! Number of requests that will be read by the next update().
+		uint32_t getRequestCount() const					{	return static_cast<uint32_t>(newRequests.size());	}
+		//! Number of requests that have been read, but whose data has not arrived yet.
+		uint32_t getPendingCount() const;
+
+		/*! Call once per frame after rendering: deliver the data that has arrived and read the
+			requested pixels from the depth buffer of the current read framebuffer. Does not block. */
+		void update(RenderingContext & context);
+		//! Wait for all pending reads and deliver their data.
+		void finish();
+
+		/*! Immediate mode: get the values of a pixel from the most recently resolved frame.
+			@return false if the pixel was not inside of a tile read in that frame. */
+		bool getLastSample(int32_t x, int32_t y, Sample & sample) const;
+
+	private:
+		struct Request {
+			int32_t x;
+			int32_t y;
+			callback_t callback;
+			Request(int32_t _x, int32_t _y, callback_t && _callback) : x(_x), y(_y), callback(std::move(_callback)) {}
+		};
+		struct Tile {
+			Geometry::Rect_i rect;
+			std::vector<float> depths;
+			std::vector<uint32_t> ids;
+			std::vector<Request> requests;
+		};
+		struct Batch {
+			uint32_t frame;
+			//! The batch is finished when this many reads have been submitted to the queue and finished.
+			uint64_t lastRead;
+			std::vector<Tile> tiles;
+		};
+
+		uint32_t tileSize;
+		uint32_t frameNumber;
+		uint64_t submittedReads;
+		Util::Reference<FBO> idFBO;
+		uint32_t idColorBufferId;
+		std::vector<Request> newRequests;
+		std::deque<std::unique_ptr<Batch>> batches;
+		//! Tiles of the most recently resolved frame.
+		std::unique_ptr<Batch> lastResolved;
+		//! Declared last, so that it is destroyed (with its pending callbacks) before the batches.
+		Util::Reference<ReadbackQueue> queue;
+
+		//! (internal) Call the callbacks of the finished batches.
+		void resolveFinishedBatches();
+		static Sample getSample(const Batch & batch, const Tile & tile, int32_t x, int32_t y);
+};
+
+}
+
+#endif /* RENDERING_DEPTHPICKER_H_ */
@@ -10,6 +10,7 @@
 */
 #include "Draw.h"
 #include "BufferObject.h"
+#include "InstanceBuffer.h"
 #include "Mesh/Mesh.h"
 #include "Mesh/MeshDataStrategy.h"
 #include "Mesh/VertexAttribute.h"
@@ -23,6 +24,7 @@
 #include "GLHeader.h"
 #include "Helper.h"
 #include "RenderingContext/RenderingContext.h"
+#include "RenderingContext/RenderingParameters.h"
 #include <Geometry/Box.h>
 #include <Geometry/Definitions.h>
 #include <Geometry/Matrix4x4.h>
@@ -34,18 +36,155 @@
 #include <Util/Graphics/Color.h>
 #include <Util/References.h>
 #include <Util/Macros.h>
+#include <algorithm>
 #include <cstddef>
 #include <list>
 #include <cstdint>
+#include <vector>
 
 namespace Rendering {
 
+// -------------------------------------------------------------------------
+// Transient batch used by the immediate-mode helpers
+
+namespace {
+
+//! (internal) Vertices of the primitives collected between beginDrawBatch() and endDrawBatch().
+struct DrawBatch {
+	bool active;
+	Mesh::draw_mode_t drawMode;
+	//! Interleaved camera space positions (3 floats) and colors (4 floats).
+	std::vector<float> vertices;
+	Geometry::Matrix4x4 cameraToClipping;
+	Util::Reference<Mesh> lineMesh;
+	Util::Reference<Mesh> triangleMesh;
+
+	DrawBatch() : active(false), drawMode(Mesh::DRAW_TRIANGLES) {
+	}
+};
+
+const uint32_t BATCH_FLOATS_PER_VERTEX = 7;
+
+//! The batch of the calling thread (i.e. of the rendering context used by the thread).
+DrawBatch & getDrawBatch() {
+	static thread_local DrawBatch batch;
+	return batch;
+}
+
+Mesh * createBatchMesh(Mesh::draw_mode_t drawMode) {
+	VertexDescription vertexDescription;
+	vertexDescription.appendPosition3D();
+	vertexDescription.appendColorRGBAFloat();
+	Mesh * mesh = new Mesh(vertexDescription, 0, 0);
+	mesh->setDrawMode(drawMode);
+	mesh->setUseIndexData(false);
+	mesh->setDataStrategy(SimpleMeshDataStrategy::getDynamicVertexStrategy());
+	return mesh;
+}
+
+void flushBatch(RenderingContext & rc, DrawBatch & batch) {
+	const uint32_t vertexCount = static_cast<uint32_t>(batch.vertices.size() / BATCH_FLOATS_PER_VERTEX);
+	if(vertexCount == 0)
+		return;
+	Util::Reference<Mesh> & mesh = (batch.drawMode == Mesh::DRAW_LINES) ? batch.lineMesh : batch.triangleMesh;
+	if(mesh.isNull())
+		mesh = createBatchMesh(batch.drawMode);
+
+	// The mesh only grows, so that the VBO is re-allocated rarely.
+	MeshVertexData & vd = mesh->openVertexData();
+	if(vd.getVertexCount() < vertexCount) {
+		uint32_t capacity = std::max(vd.getVertexCount(), static_cast<uint32_t>(256));
+		while(capacity < vertexCount)
+			capacity *= 2;
+		vd.allocate(capacity, vd.getVertexDescription());
+	}
+	std::copy(batch.vertices.begin(), batch.vertices.end(), reinterpret_cast<float *>(vd.data()));
+	vd.markAsChanged();
+
+	rc.pushAndSetMatrix_cameraToClipping(batch.cameraToClipping);
+	rc.pushAndSetMatrix_modelToCamera(Geometry::Matrix4x4());
+	rc.pushAndSetLighting(LightingParameters(false));
+	rc.displayMesh(mesh.get(), 0, vertexCount);
+	rc.popLighting();
+	rc.popMatrix_modelToCamera();
+	rc.popMatrix_cameraToClipping();
+	batch.vertices.clear();
+}
+
+/*! (internal) If batching is active, prepare the batch for primitives of the given mode and return it.
+	Otherwise, return @c nullptr and the primitive has to be drawn immediately. */
+DrawBatch * prepareBatch(RenderingContext & rc, Mesh::draw_mode_t drawMode) {
+	DrawBatch & batch = getDrawBatch();
+	if(!batch.active)
+		return nullptr;
+	if(!batch.vertices.empty() && (batch.drawMode != drawMode || batch.cameraToClipping != rc.getMatrix_cameraToClipping()))
+		flushBatch(rc, batch);
+	if(batch.vertices.empty()) {
+		batch.drawMode = drawMode;
+		batch.cameraToClipping = rc.getMatrix_cameraToClipping();
+	}
+	return &batch;
+}
+
+Util::Color4f getBatchColor(RenderingContext & rc) {
+	return rc.isMaterialEnabled() ? rc.getMaterial().getDiffuse() : Util::Color4f(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+void appendBatchVertex(DrawBatch & batch, const Geometry::Vec3 & cameraPos, const Util::Color4f & color) {
+	batch.vertices.push_back(cameraPos.getX());
+	batch.vertices.push_back(cameraPos.getY());
+	batch.vertices.push_back(cameraPos.getZ());
+	batch.vertices.push_back(color.r());
+	batch.vertices.push_back(color.g());
+	batch.vertices.push_back(color.b());
+	batch.vertices.push_back(color.a());
+}
+
+//! (internal) Append a closed line loop given in model space.
+void appendBatchLineLoop(RenderingContext & rc, DrawBatch & batch, const std::vector<Geometry::Vec3> & points, const Util::Color4f & color) {
+	const Geometry::Matrix4x4 & modelToCamera = rc.getMatrix_modelToCamera();
+	const Geometry::Vec3 first = modelToCamera.transformPosition(points.front());
+	Geometry::Vec3 previous = first;
+	for(size_t i = 1; i < points.size(); ++i) {
+		const Geometry::Vec3 current = modelToCamera.transformPosition(points[i]);
+		appendBatchVertex(batch, previous, color);
+		appendBatchVertex(batch, current, color);
+		previous = current;
+	}
+	appendBatchVertex(batch, previous, color);
+	appendBatchVertex(batch, first, color);
+}
+
+}
+
+void beginDrawBatch(RenderingContext & rc) {
+	DrawBatch & batch = getDrawBatch();
+	flushBatch(rc, batch);
+	batch.active = true;
+}
+
+void flushDrawBatch(RenderingContext & rc) {
+	flushBatch(rc, getDrawBatch());
+}
+
+void endDrawBatch(RenderingContext & rc) {
+	DrawBatch & batch = getDrawBatch();
+	flushBatch(rc, batch);
+	batch.active = false;
+}
+
+bool isDrawBatchActive() {
+	return getDrawBatch().active;
+}
+
+
 void drawFullScreenRect(RenderingContext & rc){
 	GET_GL_ERROR();
 
 	static Geometry::Matrix4x4f projectionMatrix(Geometry::Matrix4x4f::orthographicProjection(-1, 1, -1, 1, -1, 1));
 	static Geometry::Matrix4x4f modelViewMatrix;
-	static Util::Reference<Mesh> mesh;
+	static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
 	if(mesh.isNull()) {
 		VertexDescription vertexDescription;
 		vertexDescription.appendPosition3D();
@@ -99,7 +238,8 @@ void drawAbsWireframeBox(RenderingContext & rc, const Geometry::Box & box, const
 }
 
 void drawBox(RenderingContext & rc, const Geometry::Box & box) {
-	static Util::Reference<Mesh> mesh;
+	static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
 	if (mesh.isNull()) {
 		VertexDescription vertexDescription;
 		vertexDescription.appendPosition3D();
@@ -171,7 +311,19 @@ void drawBox(RenderingContext & rc, const Geometry::Box & box, const Util::Color
 }
 
 void drawWireframeBox(RenderingContext & rc, const Geometry::Box & box) {
-	static Util::Reference<Mesh> mesh;
+	if(DrawBatch * batch = prepareBatch(rc, Mesh::DRAW_LINES)) {
+		static const uint8_t edges[24] = {0, 1, 1, 3, 3, 2, 2, 0, 4, 5, 5, 7, 7, 6, 6, 4, 0, 4, 1, 5, 2, 6, 3, 7};
+		const Geometry::Matrix4x4 & modelToCamera = rc.getMatrix_modelToCamera();
+		const Util::Color4f color = getBatchColor(rc);
+		Geometry::Vec3 corners[8];
+		for (uint_fast8_t c = 0; c < 8; ++c)
+			corners[c] = modelToCamera.transformPosition(box.getCorner(static_cast<Geometry::corner_t> (c)));
+		for(const auto & corner : edges)
+			appendBatchVertex(*batch, corners[corner], color);
+		return;
+	}
+	static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
 	if (mesh.isNull()) {
 		VertexDescription vertexDescription;
 		vertexDescription.appendPosition3D();
@@ -242,13 +394,28 @@ void drawWireframeBox(RenderingContext & rc, const Geometry::Box & box, const Ut
 
 void drawQuad(RenderingContext & rc, const Geometry::Vec3 & lowerLeft, const Geometry::Vec3 & lowerRight, const Geometry::Vec3 & upperRight,
 				const Geometry::Vec3 & upperLeft) {
-	static Util::Reference<Mesh> mesh;
+	if(DrawBatch * batch = prepareBatch(rc, Mesh::DRAW_TRIANGLES)) {
+		const Geometry::Matrix4x4 & modelToCamera = rc.getMatrix_modelToCamera();
+		const Util::Color4f color = getBatchColor(rc);
+		const Geometry::Vec3 a = modelToCamera.transformPosition(lowerLeft);
+		const Geometry::Vec3 c = modelToCamera.transformPosition(upperRight);
+		appendBatchVertex(*batch, a, color);
+		appendBatchVertex(*batch, modelToCamera.transformPosition(lowerRight), color);
+		appendBatchVertex(*batch, c, color);
+		appendBatchVertex(*batch, a, color);
+		appendBatchVertex(*batch, c, color);
+		appendBatchVertex(*batch, modelToCamera.transformPosition(upperLeft), color);
+		return;
+	}
+	static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
 	if (mesh.isNull()) {
 		VertexDescription vertexDescription;
 		vertexDescription.appendPosition3D();
 		vertexDescription.appendNormalFloat();
 		vertexDescription.appendTexCoord();
 		mesh = new Mesh(vertexDescription, 4, 6);
+		mesh->setDataStrategy(SimpleMeshDataStrategy::getDynamicVertexStrategy());
 
 		MeshIndexData & id = mesh->openIndexData();
 		uint32_t * indices = id.data();
@@ -318,7 +485,18 @@ void drawQuad(RenderingContext & rc, const Geometry::Vec3f & lowerLeft, const Ge
 }
 
 void drawWireframeRect(RenderingContext & rc, const Geometry::Rect & rect) {
-	static Util::Reference<Mesh> mesh;
+	if(DrawBatch * batch = prepareBatch(rc, Mesh::DRAW_LINES)) {
+		const std::vector<Geometry::Vec3> points = {
+			Geometry::Vec3(rect.getMinX(), rect.getMinY(), 0.0f),
+			Geometry::Vec3(rect.getMaxX(), rect.getMinY(), 0.0f),
+			Geometry::Vec3(rect.getMaxX(), rect.getMaxY(), 0.0f),
+			Geometry::Vec3(rect.getMinX(), rect.getMaxY(), 0.0f)
+		};
+		appendBatchLineLoop(rc, *batch, points, getBatchColor(rc));
+		return;
+	}
+	static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
 	if (mesh.isNull()) {
 		VertexDescription vertexDescription;
 		vertexDescription.appendPosition2D();
@@ -364,7 +542,13 @@ void drawWireframeRect(RenderingContext & rc, const Geometry::Rect & rect, const
 }
 
 void drawRect(RenderingContext & rc, const Geometry::Rect & rect) {
-	static Util::Reference<Mesh> mesh;
+	if(prepareBatch(rc, Mesh::DRAW_TRIANGLES) != nullptr) {
+		drawQuad(rc, Geometry::Vec3(rect.getMinX(), rect.getMinY(), 0.0f), Geometry::Vec3(rect.getMaxX(), rect.getMinY(), 0.0f),
+				 Geometry::Vec3(rect.getMaxX(), rect.getMaxY(), 0.0f), Geometry::Vec3(rect.getMinX(), rect.getMaxY(), 0.0f));
+		return;
+	}
+	static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
 	if (mesh.isNull()) {
 		VertexDescription vertexDescription;
 		vertexDescription.appendPosition2D();
@@ -412,11 +596,22 @@ void drawRect(RenderingContext & rc, const Geometry::Rect & rect, const Util::Co
 }
 
 void drawWireframeCircle(RenderingContext & rc, const Geometry::Vec2f & center, float radius) {
-	static Util::Reference<Mesh> mesh;
+	static const uint32_t segments = 32;
+	if(DrawBatch * batch = prepareBatch(rc, Mesh::DRAW_LINES)) {
+		std::vector<Geometry::Vec3> points;
+		points.reserve(segments);
+		for(uint32_t s=0; s<segments; ++s) {
+			const float a = s * Geometry::Convert::degToRad(360.0f) / segments;
+			points.emplace_back(center.getX() + radius * std::sin(a), center.getY() + radius * std::cos(a), 0.0f);
+		}
+		appendBatchLineLoop(rc, *batch, points, getBatchColor(rc));
+		return;
+	}
+	static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
 	if (mesh.isNull()) {
 		VertexDescription vertexDescription;
 		vertexDescription.appendPosition2D();
-		uint32_t segments = 32;
 		mesh = new Mesh(vertexDescription, segments, segments);
 		mesh->setDrawMode(Mesh::DRAW_LINE_LOOP);
 
@@ -452,11 +647,21 @@ void drawWireframeCircle(RenderingContext & rc, const Geometry::Vec2f & center,
 }
 
 void drawTriangle(RenderingContext & rc, const Geometry::Vec3f & vertexA, const Geometry::Vec3f & vertexB, const Geometry::Vec3f & vertexC) {
-	static Util::Reference<Mesh> mesh;
+	if(DrawBatch * batch = prepareBatch(rc, Mesh::DRAW_TRIANGLES)) {
+		const Geometry::Matrix4x4 & modelToCamera = rc.getMatrix_modelToCamera();
+		const Util::Color4f color = getBatchColor(rc);
+		appendBatchVertex(*batch, modelToCamera.transformPosition(vertexA), color);
+		appendBatchVertex(*batch, modelToCamera.transformPosition(vertexB), color);
+		appendBatchVertex(*batch, modelToCamera.transformPosition(vertexC), color);
+		return;
+	}
+	static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
 	if (mesh.isNull()) {
 		VertexDescription vertexDescription;
 		vertexDescription.appendPosition3D();
 		mesh = new Mesh(vertexDescription, 3, 3);
+		mesh->setDataStrategy(SimpleMeshDataStrategy::getDynamicVertexStrategy());
 
 		MeshIndexData & id = mesh->openIndexData();
 		uint32_t * indices = id.data();
@@ -488,7 +693,15 @@ void drawTriangle(RenderingContext & rc, const Geometry::Vec3f & vertexA, const
 }
 
 void drawVector(RenderingContext & rc, const Geometry::Vec3 & from, const Geometry::Vec3 & to) {
-	static Util::Reference<Mesh> mesh;
+	if(DrawBatch * batch = prepareBatch(rc, Mesh::DRAW_LINES)) {
+		const Geometry::Matrix4x4 & modelToCamera = rc.getMatrix_modelToCamera();
+		const Util::Color4f color = getBatchColor(rc);
+		appendBatchVertex(*batch, modelToCamera.transformPosition(from), color);
+		appendBatchVertex(*batch, modelToCamera.transformPosition(to), color);
+		return;
+	}
+	static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
 	if (mesh.isNull()) {
 		VertexDescription vertexDescription;
 		vertexDescription.appendPosition3D();
@@ -518,7 +731,14 @@ void drawVector(RenderingContext & rc, const Geometry::Vec3 & from, const Geomet
 	rc.displayMesh(mesh.get());
 }
 void drawVector(RenderingContext & rc, const Geometry::Vec3 & from, const Geometry::Vec3 & to, const Util::Color4f & color1, const Util::Color4f & color2) {
-	static Util::Reference<Mesh> mesh;
+	if(DrawBatch * batch = prepareBatch(rc, Mesh::DRAW_LINES)) {
+		const Geometry::Matrix4x4 & modelToCamera = rc.getMatrix_modelToCamera();
+		appendBatchVertex(*batch, modelToCamera.transformPosition(from), color1);
+		appendBatchVertex(*batch, modelToCamera.transformPosition(to), color2);
+		return;
+	}
+	static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
 	if (mesh.isNull()) {
 		VertexDescription vertexDescription;
 		vertexDescription.appendPosition3D();
@@ -637,28 +857,28 @@ void drawInstances(RenderingContext & rc, Mesh* m, uint32_t firstElement, uint32
 		rc.applyChanges();
 
 		MeshVertexData & vd=m->_getVertexData();		
-		if(!vd.isUploaded())
+		if(!vd.isUploaded() && !vd.isInArena())
 			vd.upload();			
 			
-		vd.bind(rc, vd.isUploaded());			
+		vd.bind(rc, vd.isUploaded(), false); // the instance attributes are not part of the mesh's vertex array objects
 		
 		if(m->isUsingIndexData()) {			
 			MeshIndexData & id=m->_getIndexData();								
-			if(!id.isUploaded())
+			if(!id.isUploaded() && !id.isInArena())
 				id.upload();	
 							
-			BufferObject indexBuffer;
-			id._swapBufferObject(indexBuffer);
-			indexBuffer.bind(GL_ELEMENT_ARRAY_BUFFER);
+			const std::size_t indexOffset = id._bindBuffer();
 			
 			glDrawElementsInstanced(m->getGLDrawMode(), elementCount > 0 ? std::min(elementCount,id.getIndexCount()) : id.getIndexCount(), 
-					GL_UNSIGNED_INT, reinterpret_cast<void*>(sizeof(GLuint)*firstElement), instanceCount);
+					id.getUploadedIndexType(), reinterpret_cast<void*>(indexOffset + static_cast<std::size_t>(id.getUploadedIndexSize())*firstElement), instanceCount);
 					
-			indexBuffer.unbind(GL_ELEMENT_ARRAY_BUFFER);
-			id._swapBufferObject(indexBuffer);
+			id._unbindBuffer();
 		} else {
 			glDrawArraysInstanced(m->getGLDrawMode(), firstElement, elementCount, instanceCount);
 		}
+		RenderingContext::FrameCounters & counters = RenderingContext::_getFrameCounters();
+		++counters.drawCalls;
+		counters.primitives += static_cast<uint64_t>(m->getPrimitiveCount(elementCount)) * instanceCount;
 		
 		vd.unbind(rc, vd.isUploaded());
 #else
@@ -666,4 +886,48 @@ void drawInstances(RenderingContext & rc, Mesh* m, uint32_t firstElement, uint32
 #endif
 }
 
+
+void drawInstances(RenderingContext & rc, Mesh* m, InstanceBuffer & instances, uint32_t firstElement, uint32_t elementCount, uint32_t instanceCount) {
+	if(m->empty())
+		return;
+	if(instanceCount == 0 || instanceCount > instances.getInstanceCount())
+		instanceCount = instances.getInstanceCount();
+	if(instanceCount == 0)
+		return;
+
+#if defined(LIB_GL) && defined(GL_VERSION_3_3)
+	rc.applyChanges();
+	instances.upload();
+
+	MeshVertexData & vd = m->_getVertexData();
+	if(!vd.isUploaded() && !vd.isInArena())
+		vd.upload();
+	vd.bind(rc, vd.isUploaded(), true, &instances);
+
+	if(m->isUsingIndexData()) {
+		MeshIndexData & id = m->_getIndexData();
+		if(!id.isUploaded() && !id.isInArena())
+			id.upload();
+		if(elementCount == 0 || firstElement + elementCount > id.getIndexCount())
+			elementCount = firstElement < id.getIndexCount() ? id.getIndexCount() - firstElement : 0;
+
+		const std::size_t indexOffset = id._bindBuffer();
+		glDrawElementsInstanced(m->getGLDrawMode(), elementCount, id.getUploadedIndexType(), reinterpret_cast<void*>(indexOffset + static_cast<std::size_t>(id.getUploadedIndexSize())*firstElement), instanceCount);
+		id._unbindBuffer();
+	} else {
+		if(elementCount == 0 || firstElement + elementCount > vd.getVertexCount())
+			elementCount = firstElement < vd.getVertexCount() ? vd.getVertexCount() - firstElement : 0;
+		glDrawArraysInstanced(m->getGLDrawMode(), firstElement, elementCount, instanceCount);
+	}
+	GET_GL_ERROR();
+	RenderingContext::FrameCounters & counters = RenderingContext::_getFrameCounters();
+	++counters.drawCalls;
+	counters.primitives += static_cast<uint64_t>(m->getPrimitiveCount(elementCount)) * instanceCount;
+
+	vd.unbind(rc, vd.isUploaded(), &instances);
+#else
+	WARN("Instancing is not supported.");
+#endif
+}
+
 }
@@ -37,6 +37,7 @@ namespace Rendering {
 class RenderingContext;
 class Mesh;
 class BufferObject;
+class InstanceBuffer;
 }
 namespace Util {
 class Color4f;
@@ -101,6 +102,25 @@ void drawVector(RenderingContext & rc, const Geometry::Vec3f & from, const Geome
 void drawVector(RenderingContext & rc, const Geometry::Vec3f & from, const Geometry::Vec3f & to, const Util::Color4f & color);
 void drawVector(RenderingContext & rc, const Geometry::Vec3f & from, const Geometry::Vec3f & to, const Util::Color4f & color1, const Util::Color4f & color2);
 
+/**
+ * Start collecting primitives. Primitives collected before are drawn.
+ * Between beginDrawBatch() and endDrawBatch(), drawQuad(), drawRect(), drawTriangle(), drawVector(), drawWireframeBox(),
+ * drawWireframeRect() and drawWireframeCircle() do not draw immediately. Their vertices are transformed into camera space
+ * and appended to a transient vertex array. Consecutive primitives of the same kind (lines or triangles) that use the
+ * same projection matrix are drawn with a single draw call.
+ * The color of a batched primitive is the diffuse color of the active material (white, if no material is active) or the
+ * colors given to drawVector(). The vertex buffers of the batch use SimpleMeshDataStrategy::getDynamicVertexStrategy()
+ * and thereby the streaming buffer, if one is set.
+ * @note Except for the matrices and the material, the rendering state must not be changed while batching: the primitives
+ * are drawn with the state that is active when the batch is flushed. Lighting is disabled for batched primitives.
+ */
+void beginDrawBatch(RenderingContext & rc);
+//! Draw the collected primitives. Batching stays active.
+void flushDrawBatch(RenderingContext & rc);
+//! Draw the collected primitives and stop batching.
+void endDrawBatch(RenderingContext & rc);
+bool isDrawBatchActive();
+
 /**
  * Set the projection and modelview matrices to enable drawing in screen space.
  * 
@@ -116,6 +136,14 @@ void enableInstanceBuffer(RenderingContext & rc, BufferObject & instanceBuffer,
 void disableInstanceBuffer(RenderingContext & rc, BufferObject & instanceBuffer, int32_t location, uint32_t elements);
 void drawInstances(RenderingContext & rc, Mesh* m, uint32_t firstElement, uint32_t elementCount, uint32_t instanceCount);
 
+/**
+ * Draw @p instanceCount instances (all instances if 0) of the given mesh using the per-instance attributes of @p instances.
+ * Changed instance data is uploaded before drawing. The combination of the mesh's vertex buffer and the instance buffer is
+ * cached in the mesh's vertex array objects.
+ * @see InstanceBuffer
+ */
+void drawInstances(RenderingContext & rc, Mesh* m, InstanceBuffer & instances, uint32_t firstElement = 0, uint32_t elementCount = 0, uint32_t instanceCount = 0);
+
 }
 
 #endif /* DRAW_H_ */
@@ -0,0 +1,45 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "DrawCommandList.h"
+#include "Mesh/Mesh.h"
+
+namespace Rendering {
+
+void DrawCommandList::clear() {
+	commands.clear();
+	uniforms.clear();
+	pendingUniformsBegin = 0;
+}
+
+void DrawCommandList::draw(stateHandle_t stateBlock, Mesh * mesh, const Geometry::Matrix4x4 & modelToWorld, Shader * shader) {
+	if(mesh == nullptr)
+		return;
+	drawRange(stateBlock, mesh, modelToWorld, 0, mesh->isUsingIndexData() ? mesh->getIndexCount() : mesh->getVertexCount(), shader);
+}
+
+void DrawCommandList::drawRange(stateHandle_t stateBlock, Mesh * mesh, const Geometry::Matrix4x4 & modelToWorld,
+								uint32_t firstElement, uint32_t elementCount, Shader * shader) {
+	if(mesh == nullptr)
+		return;
+	Command command;
+	command.mesh = mesh;
+	command.shader = shader;
+	command.stateBlock = stateBlock;
+	command.firstElement = firstElement;
+	command.elementCount = elementCount;
+	command.modelToWorld = modelToWorld;
+	command.firstUniform = pendingUniformsBegin;
+	command.numUniforms = static_cast<uint32_t>(uniforms.size()) - pendingUniformsBegin;
+	commands.push_back(command);
+	pendingUniformsBegin = static_cast<uint32_t>(uniforms.size());
+}
+
+}
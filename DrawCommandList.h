@@ -0,0 +1,84 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_DRAWCOMMANDLIST_H_
+#define RENDERING_DRAWCOMMANDLIST_H_
+
+#include "Shader/Uniform.h"
+#include <Geometry/Matrix4x4.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+class Mesh;
+class Shader;
+
+/**
+ * List of draw commands that can be recorded without a rendering context, e.g. by one worker thread per scene
+ * partition. A command refers to a state block (a snapshot of the rendering state taken on the GL thread with
+ * RenderingContext::createStateBlock()), a mesh, an optional shader, the model's world matrix and uniforms.
+ * The lists are merged, sorted and executed on the GL thread by RenderingContext::submitCommandLists().
+ * \code
+ *	// GL thread, before the traversal
+ *	const auto opaque = context.createStateBlock();
+ *	// each worker thread (one list per thread)
+ *	lists[i].clear();
+ *	lists[i].addUniform(Uniform(colorName, color));	// applied with the next draw
+ *	lists[i].draw(opaque, mesh, worldMatrix);
+ *	// GL thread
+ *	context.submitCommandLists({&lists[0], &lists[1]});
+ * \endcode
+ * \note Recording does not touch the reference counters of meshes and shaders; they have to be kept alive until
+ *	the lists are submitted. Uniform names should be created beforehand (not by the workers).
+ * \note Uniforms are not reset between commands; a command should set all per draw uniforms it depends on.
+ */
+class DrawCommandList {
+	public:
+		typedef uint32_t stateHandle_t;
+
+		struct Command {
+			Mesh * mesh;
+			Shader * shader;				//!< nullptr: the shader of the state block
+			stateHandle_t stateBlock;
+			uint32_t firstElement;
+			uint32_t elementCount;
+			Geometry::Matrix4x4 modelToWorld;
+			uint32_t firstUniform;			//!< range in getUniforms()
+			uint32_t numUniforms;
+		};
+
+		DrawCommandList() : commands(), uniforms(), pendingUniformsBegin(0) {}
+
+		void clear();
+		void reserve(size_t numCommands)						{	commands.reserve(numCommands);	}
+		bool empty() const										{	return commands.empty();	}
+		size_t size() const										{	return commands.size();	}
+
+		//! The uniform is set with the next draw command.
+		void addUniform(const Uniform & uniform)				{	uniforms.push_back(uniform);	}
+		//! Draw the whole mesh.
+		void draw(stateHandle_t stateBlock, Mesh * mesh, const Geometry::Matrix4x4 & modelToWorld, Shader * shader = nullptr);
+		//! Draw @p elementCount indices (or vertices) beginning with @p firstElement.
+		void drawRange(stateHandle_t stateBlock, Mesh * mesh, const Geometry::Matrix4x4 & modelToWorld,
+						uint32_t firstElement, uint32_t elementCount, Shader * shader = nullptr);
+
+		const std::vector<Command> & getCommands() const		{	return commands;	}
+		const std::vector<Uniform> & getUniforms() const		{	return uniforms;	}
+
+	private:
+		std::vector<Command> commands;
+		std::vector<Uniform> uniforms;
+		uint32_t pendingUniformsBegin;	//!< uniforms from this index on belong to the next command
+};
+
+}
+
+#endif /* RENDERING_DRAWCOMMANDLIST_H_ */
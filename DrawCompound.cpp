@@ -31,7 +31,8 @@
 namespace Rendering {
 
 void drawCamera(RenderingContext & rc, const Util::Color4f & color) {
-	static Util::Reference<Mesh> mesh;
+	static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
 	if (mesh.isNull()) {
 		VertexDescription vd;
 		vd.appendPosition3D();
@@ -112,11 +113,16 @@ void drawCamera(RenderingContext & rc, const Util::Color4f & color) {
 }
 
 void drawCoordSys(RenderingContext & rc, float scale) {
-	static Util::Reference<Mesh> arrow;
-	static Util::Reference<Mesh> sphere;
-	static Util::Reference<Mesh> charX;
-	static Util::Reference<Mesh> charY;
-	static Util::Reference<Mesh> charZ;
+	static const uint32_t arrowSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & arrow = rc._getHelperMesh(arrowSlot);
+	static const uint32_t sphereSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & sphere = rc._getHelperMesh(sphereSlot);
+	static const uint32_t charXSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & charX = rc._getHelperMesh(charXSlot);
+	static const uint32_t charYSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & charY = rc._getHelperMesh(charYSlot);
+	static const uint32_t charZSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & charZ = rc._getHelperMesh(charZSlot);
 	const float radius = 0.025f;
 	
 	if (arrow.isNull()) {
@@ -274,7 +280,8 @@ void drawCoordSys(RenderingContext & rc, float scale) {
 }
 
 void drawFrustum(RenderingContext & rc, const Geometry::Frustum & frustum, const Util::Color4f & color, float lineWidth) {
-	static Util::Reference<Mesh> mesh;
+	static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
 	if (mesh.isNull()) {
 		VertexDescription vertexDescription;
 		vertexDescription.appendPosition3D();
@@ -323,7 +330,8 @@ void drawFrustum(RenderingContext & rc, const Geometry::Frustum & frustum, const
 }
 
 void drawGrid(RenderingContext & rc, float scale) {
-	static Util::Reference<Mesh> mesh;
+	static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+	Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
 	if (mesh.isNull()) {
 		VertexDescription vertexDescription;
 		vertexDescription.appendPosition3D();
@@ -0,0 +1,132 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "DynamicResolution.h"
+#include "FBO.h"
+#include "RenderTargetPool.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Texture/Texture.h"
+#include <Geometry/Rect.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <cmath>
+
+namespace Rendering {
+
+//! Queries that are not yet available; if there are more, no new query is started until one is resolved.
+static const size_t MAX_PENDING_QUERIES = 4;
+//! Weight of a new measurement in the exponential moving average.
+static const double FILTER_WEIGHT = 0.2;
+//! The render size is only changed if the desired scale deviates by more than this.
+static const float SCALE_THRESHOLD = 0.02f;
+//! Limits of the per measurement scale change; decreasing is faster than increasing to avoid missed frames.
+static const float MAX_SCALE_DECREASE = 0.9f;
+static const float MAX_SCALE_INCREASE = 1.03f;
+
+//! (internal) Scaled size rounded to a multiple of 8 pixels (for a better reuse of the pooled textures).
+static uint32_t getScaledSize(uint32_t size, float scale) {
+	const uint32_t scaled = (static_cast<uint32_t>(std::round(size * scale)) + 7) & ~7u;
+	return std::max(1u, std::min(size, scaled));
+}
+
+DynamicResolution::DynamicResolution(RenderTargetPool * _pool, double _targetFrameTime, float _minScale, float _maxScale) :
+		ReferenceCounter_t(), pool(_pool), targetFrameTime(_targetFrameTime), minScale(0.0f), maxScale(1.0f),
+		enabled(true), inFrame(false), scale(1.0f), desiredScale(1.0f), filteredTime(-1.0),
+		renderWidth(0), renderHeight(0), outputWidth(0), outputHeight(0), fbo(nullptr), queryActive(false) {
+	setScaleRange(_minScale, _maxScale);
+	scale = desiredScale = maxScale;
+}
+
+DynamicResolution::~DynamicResolution() = default;
+
+void DynamicResolution::setScaleRange(float _minScale, float _maxScale) {
+	maxScale = std::max(0.01f, std::min(_maxScale, 1.0f));
+	minScale = std::max(0.01f, std::min(_minScale, maxScale));
+	desiredScale = std::max(minScale, std::min(desiredScale, maxScale));
+}
+
+Texture * DynamicResolution::getColorTexture() const {
+	return colorTexture.get();
+}
+
+Texture * DynamicResolution::getDepthTexture() const {
+	return depthTexture.get();
+}
+
+void DynamicResolution::addMeasurement(double ms) {
+	if(ms <= 0.0)
+		return;
+	filteredTime = filteredTime < 0.0 ? ms : filteredTime * (1.0 - FILTER_WEIGHT) + ms * FILTER_WEIGHT;
+	// the GPU time is assumed to be proportional to the number of pixels, i.e. the square of the scale
+	const float factor = static_cast<float>(std::sqrt(targetFrameTime / filteredTime));
+	desiredScale *= std::max(MAX_SCALE_DECREASE, std::min(factor, MAX_SCALE_INCREASE));
+	desiredScale = std::max(minScale, std::min(desiredScale, maxScale));
+}
+
+//! (internal) Feed the available results into the controller without waiting for the others.
+void DynamicResolution::collectQueries() {
+	while(!pendingQueries.empty() && pendingQueries.front().isResultAvailable()) {
+		addMeasurement(static_cast<double>(pendingQueries.front().getResult64()) / 1000000.0);
+		pendingQueries.pop_front();
+	}
+}
+
+void DynamicResolution::beginFrame(RenderingContext & context, uint32_t _outputWidth, uint32_t _outputHeight) {
+	if(inFrame) {
+		WARN("DynamicResolution::beginFrame: endFrame has not been called.");
+		endFrame(context);
+	}
+	collectQueries();
+	if(!enabled) {
+		scale = maxScale;
+	} else if(std::abs(desiredScale - scale) > SCALE_THRESHOLD || desiredScale == minScale || desiredScale == maxScale) {
+		scale = desiredScale;
+	}
+	outputWidth = std::max(1u, _outputWidth);
+	outputHeight = std::max(1u, _outputHeight);
+	renderWidth = getScaledSize(outputWidth, scale);
+	renderHeight = getScaledSize(outputHeight, scale);
+
+	// release the textures of the last frame first, so that the pool can hand them out again
+	colorTexture = nullptr;
+	depthTexture = nullptr;
+	colorTexture = pool->acquireColorTexture(renderWidth, renderHeight, true);
+	depthTexture = pool->acquireDepthTexture(renderWidth, renderHeight);
+	fbo = pool->getFramebuffer(context, {colorTexture.get()}, depthTexture.get());
+	if(fbo == nullptr) {
+		WARN("DynamicResolution::beginFrame: the render target is not complete.");
+		return;
+	}
+	inFrame = true;
+	context.pushAndSetFBO(fbo);
+	context.pushAndSetViewport(Geometry::Rect_i(0, 0, static_cast<int>(renderWidth), static_cast<int>(renderHeight)));
+
+	queryActive = enabled && pendingQueries.size() < MAX_PENDING_QUERIES;
+	if(queryActive) {
+		pendingQueries.emplace_back(StatisticsQuery::createTimeElapsedQuery());
+		pendingQueries.back().begin();
+	}
+}
+
+void DynamicResolution::endFrame(RenderingContext & context) {
+	if(!inFrame)
+		return;
+	inFrame = false;
+	if(queryActive) {
+		pendingQueries.back().end();
+		queryActive = false;
+	}
+	context.popViewport();
+	context.popFBO();
+	fbo->blitToScreen(context, Geometry::Rect_i(0, 0, static_cast<int>(renderWidth), static_cast<int>(renderHeight)),
+					  Geometry::Rect_i(0, 0, static_cast<int>(outputWidth), static_cast<int>(outputHeight)), renderWidth != outputWidth || renderHeight != outputHeight);
+}
+
+}
@@ -0,0 +1,101 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_DYNAMICRESOLUTION_H_
+#define RENDERING_DYNAMICRESOLUTION_H_
+
+#include "StatisticsQuery.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <deque>
+
+namespace Rendering {
+class FBO;
+class RenderingContext;
+class RenderTargetPool;
+class Texture;
+
+/**
+ * Adaptive render resolution: the scene is rendered into a pooled render target whose size is a fraction (the
+ * scale) of the output size and is upscaled to the screen afterwards. The GPU time of each frame is measured with
+ * a time elapsed query (read back without stalling some frames later); the scale is adjusted to reach the
+ * target frame time within [minScale, maxScale].
+ * To improve the reuse of the pooled textures and to avoid oscillation, the render size is rounded to multiples of
+ * 8 pixels and only changed if the scale deviates by more than a small threshold.
+ * \code
+ *	Util::Reference<DynamicResolution> dynRes = new DynamicResolution(pool.get(), 16.0);
+ *	// each frame:
+ *	dynRes->beginFrame(context, windowWidth, windowHeight);	// binds the scaled render target and viewport
+ *	// render the scene...
+ *	dynRes->endFrame(context);								// upscale to the screen
+ *	pool->endFrame();
+ * \endcode
+ * \note The time elapsed query must not overlap with other GL_TIME_ELAPSED queries.
+ */
+class DynamicResolution : public Util::ReferenceCounter<DynamicResolution> {
+	public:
+		/*! @param pool Provides the render targets.
+			@param targetFrameTime GPU time per frame in milliseconds.	*/
+		DynamicResolution(RenderTargetPool * pool, double targetFrameTime = 16.0, float minScale = 0.5f, float maxScale = 1.0f);
+		~DynamicResolution();
+
+		void setTargetFrameTime(double ms)				{	targetFrameTime = ms;	}
+		double getTargetFrameTime() const				{	return targetFrameTime;	}
+		void setScaleRange(float minScale, float maxScale);
+		float getMinScale() const						{	return minScale;	}
+		float getMaxScale() const						{	return maxScale;	}
+		//! Disabled: the scene is rendered with the maximal scale and no time is measured.
+		void setEnabled(bool b)							{	enabled = b;	}
+		bool isEnabled() const							{	return enabled;	}
+
+		/*! Choose the render size for this frame, start the GPU timer and bind the render target and its viewport.
+			@param outputWidth, outputHeight Size of the screen area the result is upscaled to.	*/
+		void beginFrame(RenderingContext & context, uint32_t outputWidth, uint32_t outputHeight);
+		//! Stop the GPU timer, restore framebuffer and viewport and upscale the color buffer to the screen.
+		void endFrame(RenderingContext & context);
+
+		//! Current scale of the render size in relation to the output size.
+		float getScale() const							{	return scale;	}
+		uint32_t getRenderWidth() const					{	return renderWidth;	}
+		uint32_t getRenderHeight() const				{	return renderHeight;	}
+		//! Smoothed GPU frame time in milliseconds; negative if no measurement is available yet.
+		double getGpuFrameTime() const					{	return filteredTime;	}
+		Texture * getColorTexture() const;
+		Texture * getDepthTexture() const;
+		FBO * getFBO() const							{	return fbo;	}
+
+		/*! Feed a GPU frame time in milliseconds into the controller, e.g. from a FrameProfiler.
+			\note Called internally for every resolved time elapsed query.	*/
+		void addMeasurement(double ms);
+
+	private:
+		Util::Reference<RenderTargetPool> pool;
+		double targetFrameTime;
+		float minScale, maxScale;
+		bool enabled;
+		bool inFrame;
+		float scale;			//!< scale of the current render size
+		float desiredScale;		//!< scale requested by the controller
+		double filteredTime;
+		uint32_t renderWidth, renderHeight;
+		uint32_t outputWidth, outputHeight;
+		Util::Reference<Texture> colorTexture;
+		Util::Reference<Texture> depthTexture;
+		FBO * fbo;
+		std::deque<StatisticsQuery> pendingQueries;
+		bool queryActive;
+
+		void collectQueries();
+};
+
+}
+
+#endif /* RENDERING_DYNAMICRESOLUTION_H_ */
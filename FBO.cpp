@@ -14,6 +14,7 @@
 #include "Texture/Texture.h"
 #include "GLHeader.h"
 #include "Helper.h"
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 
@@ -29,6 +30,49 @@ void FBO::_disable(){
 
 }
 
+#if defined(LIB_GL)
+//! (internal) A name created by glGenFramebuffers can not be used with the Direct State Access functions before it is bound once.
+static void createFramebuffer(GLuint & glId) {
+#if defined(GL_ARB_direct_state_access)
+	if(isDirectStateAccessSupported()) {
+		glCreateFramebuffers(1, &glId);
+		return;
+	}
+#endif
+	glGenFramebuffers(1, &glId);
+}
+
+//! (internal) Attach the texture without binding the FBO.
+static void attachTextureDSA(GLuint fboId, GLenum attachmentPoint, Texture * texture, GLuint textureId, uint32_t level, int32_t layer) {
+#if defined(GL_ARB_direct_state_access)
+	switch( texture->getTextureType() ){
+		case TextureType::TEXTURE_1D:
+		case TextureType::TEXTURE_2D:
+		case TextureType::TEXTURE_2D_MULTISAMPLE:
+			glNamedFramebufferTexture(fboId, attachmentPoint, textureId, level);
+			break;
+		case TextureType::TEXTURE_CUBE_MAP:
+			// the faces of a cube map are its layers
+			glNamedFramebufferTextureLayer(fboId, attachmentPoint, textureId, level, std::max(0,layer));
+			break;
+		case TextureType::TEXTURE_1D_ARRAY:
+		case TextureType::TEXTURE_2D_ARRAY:
+		case TextureType::TEXTURE_3D:
+		case TextureType::TEXTURE_CUBE_MAP_ARRAY:
+			if(layer >= 0)
+				glNamedFramebufferTextureLayer(fboId, attachmentPoint, textureId, level, layer);
+			else
+				glNamedFramebufferTexture(fboId, attachmentPoint, textureId, level);
+			break;
+		case TextureType::TEXTURE_BUFFER:
+			throw std::logic_error("FBO::attachTexture: TextureBuffers are no valid targets.");
+		default:
+			throw std::logic_error("FBO::attachTexture: ???");
+	}
+#endif
+}
+#endif
+
 FBO::FBO() : glId(0){
 	//ctor
 }
@@ -48,7 +92,7 @@ FBO::~FBO(){
 void FBO::_enable(){
 	if(glId==0){
 #if defined(LIB_GL)
-		glGenFramebuffers(1, &glId);
+		createFramebuffer(glId);
 #elif defined(LIB_GLESv2)
 		glGenFramebuffers(1, &glId);
 #endif
@@ -61,6 +105,31 @@ void FBO::_enable(){
 }
 
 void FBO::attachTexture(RenderingContext & context,GLenum attachmentPoint,Texture * texture,uint32_t level,int32_t layer){
+	if(texture)
+		texture->_setMemoryCategory(MemoryRegistry::RENDER_TARGET);
+#if defined(LIB_GL)
+	if(isDirectStateAccessSupported()) {
+		if(glId==0)
+			createFramebuffer(glId);
+		GLuint textureId = 0;
+		if( texture ){
+			textureId = texture->getGLId();
+			if(textureId==0){
+				texture->_uploadGLTexture(context);
+				textureId = texture->getGLId();
+			}
+			if(layer+1 > texture->getNumLayers())
+				throw std::invalid_argument("FBO::attachTexture: invalid texture layer.");
+			attachTextureDSA(glId, attachmentPoint, texture, textureId, level, layer);
+		}else{
+#if defined(GL_ARB_direct_state_access)
+			glNamedFramebufferTexture(glId, attachmentPoint, 0, 0);
+#endif
+		}
+		GET_GL_ERROR();
+		return;
+	}
+#endif
 	context.pushAndSetFBO(this);
 	if( texture ){
 		GLuint textureId = texture->getGLId();
@@ -248,7 +317,7 @@ void FBO::setDrawBuffers(RenderingContext & context, uint32_t number) {
 #endif /* LIB_GL */
 }
 
-void FBO::blitToScreen(RenderingContext & context, const Geometry::Rect_i& srcRect, const Geometry::Rect_i& tgtRect) {
+void FBO::blitToScreen(RenderingContext & context, const Geometry::Rect_i& srcRect, const Geometry::Rect_i& tgtRect, bool linearFilter) {
 #ifdef LIB_GL
 	context.pushFBO();
 	context.applyChanges();
@@ -257,10 +326,139 @@ void FBO::blitToScreen(RenderingContext & context, const Geometry::Rect_i& srcRe
 	glDrawBuffer(GL_BACK);
 	glBlitFramebuffer(	srcRect.getX(), srcRect.getY(), srcRect.getWidth(), srcRect.getHeight(), 
 											tgtRect.getX(), tgtRect.getY(), tgtRect.getWidth(), tgtRect.getHeight(), 
-											GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+											linearFilter ? GL_COLOR_BUFFER_BIT : (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT),
+											linearFilter ? GL_LINEAR : GL_NEAREST);
 	GET_GL_ERROR();
 	context.popFBO();
+#else
+	(void)linearFilter;
 #endif /* LIB_GL */
 }
 
+void FBO::resolveToScreen(RenderingContext & context, const Geometry::Rect_i& srcRect, const Geometry::Rect_i& tgtRect, bool invalidateAfterwards) {
+#ifdef LIB_GL
+	context.pushFBO();
+	context.applyChanges();
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, glId);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glDrawBuffer(GL_BACK);
+	glBlitFramebuffer(	srcRect.getMinX(), srcRect.getMinY(), srcRect.getMaxX(), srcRect.getMaxY(),
+						tgtRect.getMinX(), tgtRect.getMinY(), tgtRect.getMaxX(), tgtRect.getMaxY(),
+						GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	GET_GL_ERROR();
+	context.popFBO();
+	if(invalidateAfterwards)
+		invalidate(context, {GL_COLOR_ATTACHMENT0, GL_DEPTH_ATTACHMENT, GL_STENCIL_ATTACHMENT});
+#endif /* LIB_GL */
+}
+
+//! (static)
+bool FBO::isInvalidationSupported() {
+#if defined(LIB_GL) && defined(GL_ARB_invalidate_subdata)
+	static const bool support = isExtensionSupported("GL_ARB_invalidate_subdata");
+	return support;
+#elif defined(LIB_GLESv2) && defined(GL_EXT_discard_framebuffer)
+	static const bool support = isExtensionSupported("GL_EXT_discard_framebuffer");
+	return support;
+#else
+	return false;
+#endif
+}
+
+void FBO::invalidate(RenderingContext & context, const std::vector<uint32_t> & attachmentPoints) {
+	if(attachmentPoints.empty() || glId == 0 || !isInvalidationSupported())
+		return;
+	const std::vector<GLenum> attachments(attachmentPoints.begin(), attachmentPoints.end());
+#if defined(LIB_GL) && defined(GL_ARB_invalidate_subdata)
+#if defined(GL_ARB_direct_state_access)
+	if(isDirectStateAccessSupported()) {
+		glInvalidateNamedFramebufferData(glId, static_cast<GLsizei>(attachments.size()), attachments.data());
+		GET_GL_ERROR();
+		return;
+	}
+#endif
+	context.pushAndSetFBO(this);
+	context.applyChanges();
+	glInvalidateFramebuffer(GL_FRAMEBUFFER, static_cast<GLsizei>(attachments.size()), attachments.data());
+	context.popFBO();
+	GET_GL_ERROR();
+#elif defined(LIB_GLESv2) && defined(GL_EXT_discard_framebuffer)
+	context.pushAndSetFBO(this);
+	context.applyChanges();
+	glDiscardFramebufferEXT(GL_FRAMEBUFFER, static_cast<GLsizei>(attachments.size()), attachments.data());
+	context.popFBO();
+	GET_GL_ERROR();
+#else
+	(void)context;
+#endif
+}
+
+bool FBO::isMultiviewSupported() {
+#if defined(LIB_GL) && defined(GL_OVR_multiview)
+	static const bool support = isExtensionSupported("GL_OVR_multiview");
+	return support;
+#else
+	return false;
+#endif
+}
+
+void FBO::attachMultiviewTexture(RenderingContext & context, uint32_t attachmentPoint, Texture * texture, uint32_t level, uint32_t baseView, uint32_t numViews) {
+	if(!isMultiviewSupported())
+		throw std::logic_error("FBO::attachMultiviewTexture: GL_OVR_multiview is not supported.");
+	if(texture == nullptr || texture->getTextureType() != TextureType::TEXTURE_2D_ARRAY)
+		throw std::invalid_argument("FBO::attachMultiviewTexture: a TEXTURE_2D_ARRAY is required.");
+	if(numViews == 0 || baseView + numViews > texture->getNumLayers())
+		throw std::invalid_argument("FBO::attachMultiviewTexture: invalid view range.");
+	texture->_setMemoryCategory(MemoryRegistry::RENDER_TARGET);
+#if defined(LIB_GL) && defined(GL_OVR_multiview)
+	if(texture->getGLId() == 0)
+		texture->_uploadGLTexture(context);
+	context.pushAndSetFBO(this);
+	glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, attachmentPoint, texture->getGLId(), static_cast<GLint>(level),
+									 static_cast<GLint>(baseView), static_cast<GLsizei>(numViews));
+	context.popFBO();
+	GET_GL_ERROR();
+#else
+	(void)context;
+	(void)attachmentPoint;
+	(void)level;
+#endif
+}
+
+//! (internal) Add or remove the attachment point from the set.
+static void setMember(std::vector<uint32_t> & attachments, uint32_t attachmentPoint, bool member) {
+	const auto it = std::find(attachments.begin(), attachments.end(), attachmentPoint);
+	if(member && it == attachments.end())
+		attachments.push_back(attachmentPoint);
+	else if(!member && it != attachments.end())
+		attachments.erase(it);
+}
+
+void FBO::setLoadContents(uint32_t attachmentPoint, bool load) {
+	setMember(noLoadAttachments, attachmentPoint, !load);
+}
+
+void FBO::setStoreContents(uint32_t attachmentPoint, bool store) {
+	setMember(noStoreAttachments, attachmentPoint, !store);
+}
+
+bool FBO::getLoadContents(uint32_t attachmentPoint) const {
+	return std::find(noLoadAttachments.begin(), noLoadAttachments.end(), attachmentPoint) == noLoadAttachments.end();
+}
+
+bool FBO::getStoreContents(uint32_t attachmentPoint) const {
+	return std::find(noStoreAttachments.begin(), noStoreAttachments.end(), attachmentPoint) == noStoreAttachments.end();
+}
+
+void FBO::beginPass(RenderingContext & context) {
+	context.pushAndSetFBO(this);
+	invalidate(context, noLoadAttachments);
+}
+
+void FBO::endPass(RenderingContext & context) {
+	invalidate(context, noStoreAttachments);
+	context.popFBO();
+}
+
 }
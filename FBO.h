@@ -15,6 +15,7 @@
 #include <Geometry/Rect.h>
 #include <Util/ReferenceCounter.h>
 #include <cstdint>
+#include <vector>
 
 namespace Rendering {
 
@@ -81,6 +82,15 @@ class FBO : public Util::ReferenceCounter<FBO> {
 		void attachDepthTexture(RenderingContext & context, Texture * t, uint32_t level=0, int32_t layer=-1);
 		void detachDepthTexture(RenderingContext & context);
 
+		//! Is GL_OVR_multiview available?
+		static bool isMultiviewSupported();
+		/*! Attach @p numViews consecutive layers of a TEXTURE_2D_ARRAY for multiview rendering (GL_OVR_multiview):
+			each draw call is broadcast to all views and the vertex shader can select per view data by gl_ViewID_OVR
+			(see RenderingContext::setMultiviewMatrices()).
+			@throw std::logic_error if multiview is not supported.
+			@throw std::invalid_argument if the texture is no array texture or has not enough layers.	*/
+		void attachMultiviewTexture(RenderingContext & context, uint32_t attachmentPoint, Texture * t, uint32_t level = 0, uint32_t baseView = 0, uint32_t numViews = 2);
+
 		/**
 		 * Activate the given number of draw buffers.
 		 *
@@ -91,10 +101,40 @@ class FBO : public Util::ReferenceCounter<FBO> {
 		 */
 		void setDrawBuffers(RenderingContext & context, uint32_t number);
 
-		//! copy a block of pixels from this framebuffer to the screen
-		void blitToScreen(RenderingContext & context, const Geometry::Rect_i& srcRect, const Geometry::Rect_i& tgtRect);
+		/*! copy a block of pixels from this framebuffer to the screen
+			If @p linearFilter is set (e.g. for upscaling), only the color buffer is copied.	*/
+		void blitToScreen(RenderingContext & context, const Geometry::Rect_i& srcRect, const Geometry::Rect_i& tgtRect, bool linearFilter = false);
+
+		/*! Resolve the (multisample) color buffer 0 into the screen. Afterwards, the color and depth contents of
+			this framebuffer are invalidated if @p invalidateAfterwards is set.
+			\note The source and target rectangles must have the same size if the framebuffer is multisampled.	*/
+		void resolveToScreen(RenderingContext & context, const Geometry::Rect_i& srcRect, const Geometry::Rect_i& tgtRect, bool invalidateAfterwards = true);
+
+	/*!	@name Invalidation
+		Invalidated attachments have undefined contents; the implementation does not need to load them into (or store
+		them from) its tile memory, which saves bandwidth e.g. for transient depth and multisample attachments.
+		Without GL_ARB_invalidate_subdata (or GL_EXT_discard_framebuffer), invalidation does nothing.	*/
+	// @{
+		static bool isInvalidationSupported();
+		//! Invalidate the contents of the given attachment points (e.g. GL_DEPTH_ATTACHMENT, GL_COLOR_ATTACHMENT0).
+		void invalidate(RenderingContext & context, const std::vector<uint32_t> & attachmentPoints);
+
+		/*! Per-pass hints: for attachments whose contents are not loaded, beginPass() invalidates the attachment
+			(e.g. when it is cleared or completely overwritten anyway); for attachments whose contents are not stored,
+			endPass() invalidates them (e.g. a depth buffer that is only needed during the pass).	*/
+		void setLoadContents(uint32_t attachmentPoint, bool load);
+		void setStoreContents(uint32_t attachmentPoint, bool store);
+		bool getLoadContents(uint32_t attachmentPoint) const;
+		bool getStoreContents(uint32_t attachmentPoint) const;
+		//! Activate the framebuffer (pushAndSetFBO) and invalidate the attachments that are not loaded.
+		void beginPass(RenderingContext & context);
+		//! Invalidate the attachments that are not stored and restore the previous framebuffer (popFBO).
+		void endPass(RenderingContext & context);
+	// @}
 	private:
 		uint32_t glId;
+		std::vector<uint32_t> noLoadAttachments;
+		std::vector<uint32_t> noStoreAttachments;
 };
 
 }
@@ -0,0 +1,201 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "FrameProfiler.h"
+#include "QueryPool.h"
+#include "RenderingContext/RenderingContext.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Util/Macros.h>
+
+namespace Rendering {
+
+#if defined(LIB_GL) && defined(GL_KHR_debug)
+static bool isDebugGroupSupported() {
+	static const bool support = isExtensionSupported("GL_KHR_debug");
+	return support;
+}
+#endif
+
+FrameProfiler::FrameProfiler(uint32_t _maxScopesPerFrame, uint32_t _historySize) :
+		ReferenceCounter_t(), enabled(true), inFrame(false), maxScopesPerFrame(_maxScopesPerFrame), historySize(_historySize),
+		frameNumber(0), queryPool(QueryPool::createTimestampPool(2 * _maxScopesPerFrame + 2, 4)),
+		startTime(std::chrono::steady_clock::now()), frameStartTime(startTime) {
+}
+
+FrameProfiler::~FrameProfiler() = default;
+
+//! (internal)
+double FrameProfiler::getMilliseconds(std::chrono::steady_clock::time_point from) const {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+}
+
+//! (internal)
+uint32_t FrameProfiler::recordTimestamp() {
+	return queryPool.isNotNull() ? queryPool->counter() : INVALID_INDEX;
+}
+
+void FrameProfiler::beginFrame() {
+	if(!enabled)
+		return;
+	if(inFrame)
+		endFrame();
+	inFrame = true;
+	current = PendingFrame();
+	current.frame.frameNumber = frameNumber;
+	current.frame.begin = getMilliseconds(startTime);
+	current.frame.cpuDuration = 0.0;
+	current.frame.gpuDuration = -1.0;
+	frameStartTime = std::chrono::steady_clock::now();
+	current.poolFrame = queryPool.isNotNull() ? queryPool->getFrameNumber() : 0;
+	current.frameBeginQuery = recordTimestamp();
+	current.frameEndQuery = INVALID_INDEX;
+	scopeStack.clear();
+}
+
+void FrameProfiler::pushScope(const std::string & name) {
+	if(!inFrame)
+		return;
+	Scope scope;
+	scope.name = name;
+	scope.parent = scopeStack.empty() ? INVALID_INDEX : scopeStack.back();
+	scope.depth = static_cast<uint32_t>(scopeStack.size());
+	scope.cpuBegin = scope.cpuEnd = getMilliseconds(frameStartTime);
+	scope.gpuBegin = scope.gpuEnd = -1.0;
+
+	PendingScope queries;
+	// the pool has room for two timestamps per scope plus the frame's begin and end
+	queries.beginQuery = current.queries.size() < maxScopesPerFrame ? recordTimestamp() : INVALID_INDEX;
+	queries.endQuery = INVALID_INDEX;
+
+	scopeStack.push_back(static_cast<uint32_t>(current.frame.scopes.size()));
+	current.frame.scopes.emplace_back(std::move(scope));
+	current.queries.push_back(queries);
+#if defined(LIB_GL) && defined(GL_KHR_debug)
+	if(isDebugGroupSupported())
+		glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name.c_str());
+#endif
+}
+
+void FrameProfiler::popScope() {
+	if(!inFrame || scopeStack.empty())
+		return;
+	const uint32_t index = scopeStack.back();
+	scopeStack.pop_back();
+	current.frame.scopes[index].cpuEnd = getMilliseconds(frameStartTime);
+	if(current.queries[index].beginQuery != INVALID_INDEX)
+		current.queries[index].endQuery = recordTimestamp();
+#if defined(LIB_GL) && defined(GL_KHR_debug)
+	if(isDebugGroupSupported())
+		glPopDebugGroup();
+#endif
+}
+
+void FrameProfiler::endFrame() {
+	if(!inFrame)
+		return;
+	if(!scopeStack.empty()) {
+		WARN("FrameProfiler::endFrame: Unclosed scopes.");
+		while(!scopeStack.empty())
+			popScope();
+	}
+	current.frameEndQuery = recordTimestamp();
+	current.frame.cpuDuration = getMilliseconds(frameStartTime);
+	if(queryPool.isNotNull())
+		queryPool->nextFrame();
+	++frameNumber;
+	inFrame = false;
+	pending.emplace_back(std::move(current));
+	resolve();
+}
+
+//! (internal)
+void FrameProfiler::resolve() {
+	while(!pending.empty()) {
+		PendingFrame & p = pending.front();
+		if(queryPool.isNotNull()) {
+			if(queryPool->getResults(p.poolFrame, queryResults)) {
+				const auto toMilliseconds = [&](uint32_t query) {
+					return query < queryResults.size() && p.frameBeginQuery < queryResults.size() ?
+							static_cast<double>(queryResults[query] - queryResults[p.frameBeginQuery]) * 1.0e-6 : -1.0;
+				};
+				for(size_t i = 0; i < p.queries.size(); ++i) {
+					if(p.queries[i].endQuery == INVALID_INDEX)
+						continue;
+					p.frame.scopes[i].gpuBegin = toMilliseconds(p.queries[i].beginQuery);
+					p.frame.scopes[i].gpuEnd = toMilliseconds(p.queries[i].endQuery);
+				}
+				p.frame.gpuDuration = toMilliseconds(p.frameEndQuery);
+			} else if(queryPool->getFrameNumber() - p.poolFrame < queryPool->getNumFrames()) {
+				break; // not finished yet; later frames are not finished either
+			} // else: the results have been overwritten -> CPU times only
+		}
+		addToHistory(std::move(p.frame));
+		pending.pop_front();
+	}
+}
+
+//! (internal)
+void FrameProfiler::addToHistory(Frame && frame) {
+	history.emplace_back(std::move(frame));
+	while(history.size() > historySize)
+		history.pop_front();
+}
+
+//! (internal)
+static std::string escapeJSON(const std::string & s) {
+	std::string result;
+	for(const char c : s) {
+		if(c == '"' || c == '\\') {
+			result += '\\';
+			result += c;
+		} else if(static_cast<unsigned char>(c) >= 0x20) {
+			result += c;
+		}
+	}
+	return result;
+}
+
+void FrameProfiler::writeChromeTrace(std::ostream & output) const {
+	output << "{\"traceEvents\":[";
+	bool first = true;
+	const auto writeEvent = [&](const std::string & name, const char * category, uint32_t thread, double beginMs, double durationMs) {
+		output << (first ? "\n" : ",\n") << "{\"name\":\"" << escapeJSON(name) << "\",\"cat\":\"" << category
+				<< "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread
+				<< ",\"ts\":" << static_cast<int64_t>(beginMs * 1000.0) << ",\"dur\":" << static_cast<int64_t>(durationMs * 1000.0) << "}";
+		first = false;
+	};
+	for(const auto & frame : history) {
+		const std::string frameName = "Frame " + std::to_string(frame.frameNumber);
+		writeEvent(frameName, "cpu", 0, frame.begin, frame.cpuDuration);
+		if(frame.gpuDuration >= 0.0)
+			writeEvent(frameName, "gpu", 1, frame.begin, frame.gpuDuration);
+		for(const auto & scope : frame.scopes) {
+			writeEvent(scope.name, "cpu", 0, frame.begin + scope.cpuBegin, scope.getCpuDuration());
+			if(scope.hasGpuTime())
+				writeEvent(scope.name, "gpu", 1, frame.begin + scope.gpuBegin, scope.getGpuDuration());
+		}
+	}
+	output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+// ------------------------------------------------------------------------------------------
+
+ProfileScope::ProfileScope(RenderingContext & context, const std::string & name) : profiler(context.getFrameProfiler()) {
+	if(profiler != nullptr)
+		profiler->pushScope(name);
+}
+
+ProfileScope::~ProfileScope() {
+	if(profiler != nullptr)
+		profiler->popScope();
+}
+
+}
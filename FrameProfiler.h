@@ -0,0 +1,141 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_FRAMEPROFILER_H_
+#define RENDERING_FRAMEPROFILER_H_
+
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Rendering {
+class QueryPool;
+class RenderingContext;
+
+/**
+ * Hierarchical CPU and GPU profiler for frames.
+ *
+ * A frame is enclosed in beginFrame()/endFrame(); inside, named scopes are pushed and popped (usually with the
+ * ProfileScope helper). For every scope, the CPU time is measured directly and the GPU time with timestamp
+ * queries (@see QueryPool); the scope is also pushed as debug group (GL_KHR_debug) for external GPU debuggers.
+ * The GPU results are resolved without stalling in one of the following endFrame() calls; only then the frame
+ * is added to the history.
+ * \code
+ *	Util::Reference<FrameProfiler> profiler = new FrameProfiler;
+ *	renderingContext.setFrameProfiler(profiler.get());
+ *	// each frame:
+ *	profiler->beginFrame();
+ *	{
+ *		ProfileScope scope(renderingContext, "shadows");
+ *		// ...
+ *	}
+ *	profiler->endFrame();
+ *	const FrameProfiler::Frame * frame = profiler->getLatestFrame();
+ * \endcode
+ */
+class FrameProfiler : public Util::ReferenceCounter<FrameProfiler> {
+	public:
+		static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+		struct Scope {
+			std::string name;
+			uint32_t parent;		//!< index of the parent scope in Frame::scopes or INVALID_INDEX
+			uint32_t depth;
+			double cpuBegin, cpuEnd;	//!< in milliseconds relative to the beginning of the frame
+			double gpuBegin, gpuEnd;	//!< in milliseconds relative to the frame's first GPU timestamp; negative if unavailable
+
+			double getCpuDuration() const	{	return cpuEnd - cpuBegin;	}
+			double getGpuDuration() const	{	return hasGpuTime() ? gpuEnd - gpuBegin : 0.0;	}
+			bool hasGpuTime() const			{	return gpuBegin >= 0.0 && gpuEnd >= 0.0;	}
+		};
+		struct Frame {
+			uint32_t frameNumber;
+			double begin;			//!< in milliseconds relative to the creation of the profiler
+			double cpuDuration;		//!< time between beginFrame() and endFrame()
+			double gpuDuration;		//!< time between the first and the last timestamp of the frame; negative if unavailable
+			std::vector<Scope> scopes;	//!< in depth-first order; a parent is stored before its children
+		};
+
+		/*! @param maxScopesPerFrame Further scopes of a frame are measured on the CPU only.
+			@param historySize Number of resolved frames that are kept.	*/
+		explicit FrameProfiler(uint32_t maxScopesPerFrame = 256, uint32_t historySize = 120);
+		~FrameProfiler();
+
+		void setEnabled(bool b)						{	enabled = b;	}
+		bool isEnabled() const						{	return enabled;	}
+
+		void beginFrame();
+		//! Finish the current frame and resolve the GPU times of earlier frames that are available.
+		void endFrame();
+
+		void pushScope(const std::string & name);
+		void popScope();
+
+		//! Resolved frames; oldest first.
+		const std::deque<Frame> & getFrames() const	{	return history;	}
+		//! The most recent resolved frame or nullptr.
+		const Frame * getLatestFrame() const		{	return history.empty() ? nullptr : &history.back();	}
+		void clearHistory()							{	history.clear();	}
+
+		/*! Write the resolved frames in the Chrome trace event format (chrome://tracing, Perfetto).
+			CPU scopes are written to thread 0, GPU scopes to thread 1.	*/
+		void writeChromeTrace(std::ostream & output) const;
+
+	private:
+		struct PendingScope {
+			uint32_t beginQuery, endQuery;	//!< indices in the query pool's frame
+		};
+		struct PendingFrame {
+			Frame frame;
+			std::vector<PendingScope> queries;
+			uint32_t poolFrame;				//!< frame number in the query pool
+			uint32_t frameBeginQuery, frameEndQuery;
+		};
+
+		bool enabled;
+		bool inFrame;
+		const uint32_t maxScopesPerFrame;
+		const size_t historySize;
+		uint32_t frameNumber;
+		Util::Reference<QueryPool> queryPool;
+		std::chrono::steady_clock::time_point startTime;
+		std::chrono::steady_clock::time_point frameStartTime;
+		PendingFrame current;
+		std::vector<uint32_t> scopeStack;
+		std::deque<PendingFrame> pending;
+		std::deque<Frame> history;
+		std::vector<uint64_t> queryResults;
+
+		double getMilliseconds(std::chrono::steady_clock::time_point from) const;
+		uint32_t recordTimestamp();
+		void resolve();
+		void addToHistory(Frame && frame);
+};
+
+/*! RAII helper: pushes a scope on the profiler of the given rendering context (if there is one) and pops it on
+	destruction. @see RenderingContext::setFrameProfiler	*/
+class ProfileScope {
+	public:
+		ProfileScope(RenderingContext & context, const std::string & name);
+		~ProfileScope();
+		ProfileScope(const ProfileScope &) = delete;
+		ProfileScope & operator=(const ProfileScope &) = delete;
+	private:
+		FrameProfiler * profiler;
+};
+
+}
+
+#endif /* RENDERING_FRAMEPROFILER_H_ */
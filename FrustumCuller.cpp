@@ -0,0 +1,359 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "FrustumCuller.h"
+#include "RenderingContext/RenderingContext.h"
+#include "TaskScheduler.h"
+#include <Geometry/Box.h>
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Sphere.h>
+#include <Geometry/Vec3.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define RENDERING_CULLING_SSE2
+	#include <emmintrin.h>
+	#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+		#define RENDERING_CULLING_AVX
+		#include <immintrin.h>
+	#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define RENDERING_CULLING_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace Rendering {
+
+//! Number of objects tested by one task of cull().
+static const uint32_t CULLING_CHUNK_SIZE = 16384;
+
+namespace {
+struct BoundsView {
+	const float * centerX;
+	const float * centerY;
+	const float * centerZ;
+	const float * extentX;
+	const float * extentY;
+	const float * extentZ;
+	const float * radii;
+};
+//! Test the objects [begin, end) and write the indices of the visible ones to @p out; returns their number.
+typedef uint32_t (*cullKernel_t)(const BoundsView & bounds, const float * planes, uint32_t begin, uint32_t end, uint32_t * out);
+}
+
+// ---------------------------------------------------------------------
+// scalar (also used for the remaining objects of the SIMD kernels)
+
+static inline bool isInsideScalar(const BoundsView & b, const float * planes, uint32_t i) {
+	for(uint_fast8_t p = 0; p < 6; ++p) {
+		const float * plane = planes + 4 * p;
+		const float distance = plane[0] * b.centerX[i] + plane[1] * b.centerY[i] + plane[2] * b.centerZ[i] + plane[3]
+				+ std::abs(plane[0]) * b.extentX[i] + std::abs(plane[1]) * b.extentY[i] + std::abs(plane[2]) * b.extentZ[i] + b.radii[i];
+		if(distance < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+static uint32_t cullScalar(const BoundsView & bounds, const float * planes, uint32_t begin, uint32_t end, uint32_t * out) {
+	uint32_t count = 0;
+	for(uint32_t i = begin; i < end; ++i) {
+		out[count] = i;
+		count += isInsideScalar(bounds, planes, i) ? 1 : 0;
+	}
+	return count;
+}
+
+// ---------------------------------------------------------------------
+// SSE2: four objects per iteration
+
+#if defined(RENDERING_CULLING_SSE2)
+static uint32_t cullSSE2(const BoundsView & b, const float * planes, uint32_t begin, uint32_t end, uint32_t * out) {
+	__m128 n[6][3], absN[6][3], d[6];
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	for(uint_fast8_t p = 0; p < 6; ++p) {
+		for(uint_fast8_t j = 0; j < 3; ++j) {
+			n[p][j] = _mm_set1_ps(planes[4 * p + j]);
+			absN[p][j] = _mm_andnot_ps(signMask, n[p][j]);
+		}
+		d[p] = _mm_set1_ps(planes[4 * p + 3]);
+	}
+	const __m128 zero = _mm_setzero_ps();
+	uint32_t count = 0;
+	uint32_t i = begin;
+	for(; i + 4 <= end; i += 4) {
+		const __m128 cx = _mm_loadu_ps(b.centerX + i), cy = _mm_loadu_ps(b.centerY + i), cz = _mm_loadu_ps(b.centerZ + i);
+		const __m128 ex = _mm_loadu_ps(b.extentX + i), ey = _mm_loadu_ps(b.extentY + i), ez = _mm_loadu_ps(b.extentZ + i);
+		const __m128 r = _mm_loadu_ps(b.radii + i);
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+		for(uint_fast8_t p = 0; p < 6; ++p) {
+			__m128 distance = _mm_add_ps(_mm_mul_ps(n[p][0], cx), _mm_mul_ps(n[p][1], cy));
+			distance = _mm_add_ps(distance, _mm_add_ps(_mm_mul_ps(n[p][2], cz), d[p]));
+			distance = _mm_add_ps(distance, _mm_add_ps(_mm_mul_ps(absN[p][0], ex), _mm_mul_ps(absN[p][1], ey)));
+			distance = _mm_add_ps(distance, _mm_add_ps(_mm_mul_ps(absN[p][2], ez), r));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+		}
+		const int mask = _mm_movemask_ps(inside);
+		for(uint_fast8_t k = 0; k < 4; ++k) {
+			out[count] = i + k;
+			count += (mask >> k) & 1;
+		}
+	}
+	return count + cullScalar(b, planes, i, end, out + count);
+}
+#endif
+
+// ---------------------------------------------------------------------
+// AVX: eight objects per iteration (compiled for AVX, only called if the CPU supports it)
+
+#if defined(RENDERING_CULLING_AVX)
+__attribute__((target("avx")))
+static uint32_t cullAVX(const BoundsView & b, const float * planes, uint32_t begin, uint32_t end, uint32_t * out) {
+	__m256 n[6][3], absN[6][3], d[6];
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	for(uint_fast8_t p = 0; p < 6; ++p) {
+		for(uint_fast8_t j = 0; j < 3; ++j) {
+			n[p][j] = _mm256_set1_ps(planes[4 * p + j]);
+			absN[p][j] = _mm256_andnot_ps(signMask, n[p][j]);
+		}
+		d[p] = _mm256_set1_ps(planes[4 * p + 3]);
+	}
+	const __m256 zero = _mm256_setzero_ps();
+	uint32_t count = 0;
+	uint32_t i = begin;
+	for(; i + 8 <= end; i += 8) {
+		const __m256 cx = _mm256_loadu_ps(b.centerX + i), cy = _mm256_loadu_ps(b.centerY + i), cz = _mm256_loadu_ps(b.centerZ + i);
+		const __m256 ex = _mm256_loadu_ps(b.extentX + i), ey = _mm256_loadu_ps(b.extentY + i), ez = _mm256_loadu_ps(b.extentZ + i);
+		const __m256 r = _mm256_loadu_ps(b.radii + i);
+		__m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+		for(uint_fast8_t p = 0; p < 6; ++p) {
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(n[p][0], cx), _mm256_mul_ps(n[p][1], cy));
+			distance = _mm256_add_ps(distance, _mm256_add_ps(_mm256_mul_ps(n[p][2], cz), d[p]));
+			distance = _mm256_add_ps(distance, _mm256_add_ps(_mm256_mul_ps(absN[p][0], ex), _mm256_mul_ps(absN[p][1], ey)));
+			distance = _mm256_add_ps(distance, _mm256_add_ps(_mm256_mul_ps(absN[p][2], ez), r));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+		}
+		const int mask = _mm256_movemask_ps(inside);
+		for(uint_fast8_t k = 0; k < 8; ++k) {
+			out[count] = i + k;
+			count += (mask >> k) & 1;
+		}
+	}
+	return count + cullScalar(b, planes, i, end, out + count);
+}
+#endif
+
+// ---------------------------------------------------------------------
+// NEON: four objects per iteration
+
+#if defined(RENDERING_CULLING_NEON)
+static uint32_t cullNEON(const BoundsView & b, const float * planes, uint32_t begin, uint32_t end, uint32_t * out) {
+	float32x4_t n[6][3], absN[6][3], d[6];
+	for(uint_fast8_t p = 0; p < 6; ++p) {
+		for(uint_fast8_t j = 0; j < 3; ++j) {
+			n[p][j] = vdupq_n_f32(planes[4 * p + j]);
+			absN[p][j] = vabsq_f32(n[p][j]);
+		}
+		d[p] = vdupq_n_f32(planes[4 * p + 3]);
+	}
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	uint32_t count = 0;
+	uint32_t i = begin;
+	for(; i + 4 <= end; i += 4) {
+		const float32x4_t cx = vld1q_f32(b.centerX + i), cy = vld1q_f32(b.centerY + i), cz = vld1q_f32(b.centerZ + i);
+		const float32x4_t ex = vld1q_f32(b.extentX + i), ey = vld1q_f32(b.extentY + i), ez = vld1q_f32(b.extentZ + i);
+		const float32x4_t r = vld1q_f32(b.radii + i);
+		uint32x4_t inside = vdupq_n_u32(0xffffffffu);
+		for(uint_fast8_t p = 0; p < 6; ++p) {
+			float32x4_t distance = vmlaq_f32(vmlaq_f32(vmlaq_f32(d[p], n[p][0], cx), n[p][1], cy), n[p][2], cz);
+			distance = vmlaq_f32(vmlaq_f32(vmlaq_f32(vaddq_f32(distance, r), absN[p][0], ex), absN[p][1], ey), absN[p][2], ez);
+			inside = vandq_u32(inside, vcgeq_f32(distance, zero));
+		}
+		uint32_t lanes[4];
+		vst1q_u32(lanes, inside);
+		for(uint_fast8_t k = 0; k < 4; ++k) {
+			out[count] = i + k;
+			count += lanes[k] & 1;
+		}
+	}
+	return count + cullScalar(b, planes, i, end, out + count);
+}
+#endif
+
+// ---------------------------------------------------------------------
+
+namespace {
+struct Kernel {
+	cullKernel_t cull;
+	const char * name;
+};
+}
+
+static Kernel selectKernel() {
+#if defined(RENDERING_CULLING_AVX)
+	if(__builtin_cpu_supports("avx"))
+		return Kernel{cullAVX, "AVX"};
+#endif
+#if defined(RENDERING_CULLING_SSE2)
+	return Kernel{cullSSE2, "SSE2"};
+#elif defined(RENDERING_CULLING_NEON)
+	return Kernel{cullNEON, "NEON"};
+#else
+	return Kernel{cullScalar, "scalar"};
+#endif
+}
+
+static const Kernel & getKernel() {
+	static const Kernel kernel = selectKernel();
+	return kernel;
+}
+
+//! (static)
+const char * FrustumCuller::getImplementationName() {
+	return getKernel().name;
+}
+
+FrustumCuller::FrustumCuller() {
+	// without a frustum, everything is visible
+	for(uint_fast8_t p = 0; p < 6; ++p) {
+		planes[4 * p] = planes[4 * p + 1] = planes[4 * p + 2] = 0.0f;
+		planes[4 * p + 3] = 1.0f;
+	}
+}
+
+void FrustumCuller::setFrustum(const Geometry::Matrix4x4 & worldToClipping) {
+	// Gribb/Hartmann: the planes are sums and differences of the last row and the other rows of the matrix
+	for(uint_fast8_t p = 0; p < 6; ++p) {
+		const uint_fast8_t row = p / 2;
+		const float sign = (p % 2 == 0) ? 1.0f : -1.0f;
+		float * plane = planes.data() + 4 * p;
+		for(uint_fast8_t column = 0; column < 4; ++column)
+			plane[column] = worldToClipping.at(3, column) + sign * worldToClipping.at(row, column);
+		const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		if(length > 0.0f) {
+			for(uint_fast8_t j = 0; j < 4; ++j)
+				plane[j] /= length;
+		}
+	}
+}
+
+void FrustumCuller::setFrustum(const RenderingContext & context) {
+	setFrustum(context.getMatrix_cameraToClipping() * context.getMatrix_worldToCamera());
+}
+
+//! (internal)
+void FrustumCuller::storeBox(uint32_t index, const Geometry::Box & box, const Geometry::Matrix4x4 & modelToWorld) {
+	const Geometry::Vec3 center = box.getCenter();
+	const float halfExtent[3] = {0.5f * box.getExtentX(), 0.5f * box.getExtentY(), 0.5f * box.getExtentZ()};
+	float worldCenter[3];
+	float worldExtent[3];
+	for(uint_fast8_t row = 0; row < 3; ++row) {
+		worldCenter[row] = modelToWorld.at(row, 3);
+		worldExtent[row] = 0.0f;
+		for(uint_fast8_t column = 0; column < 3; ++column) {
+			const float m = modelToWorld.at(row, column);
+			worldCenter[row] += m * center[column];
+			worldExtent[row] += std::abs(m) * halfExtent[column];
+		}
+	}
+	centerX[index] = worldCenter[0];
+	centerY[index] = worldCenter[1];
+	centerZ[index] = worldCenter[2];
+	extentX[index] = worldExtent[0];
+	extentY[index] = worldExtent[1];
+	extentZ[index] = worldExtent[2];
+	radii[index] = 0.0f;
+}
+
+uint32_t FrustumCuller::addBox(const Geometry::Box & box, const Geometry::Matrix4x4 & modelToWorld) {
+	const uint32_t index = size();
+	for(auto array : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radii})
+		array->push_back(0.0f);
+	storeBox(index, box, modelToWorld);
+	return index;
+}
+
+uint32_t FrustumCuller::addSphere(const Geometry::Sphere_f & sphere) {
+	const uint32_t index = size();
+	for(auto array : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radii})
+		array->push_back(0.0f);
+	setSphere(index, sphere);
+	return index;
+}
+
+void FrustumCuller::setBox(uint32_t index, const Geometry::Box & box, const Geometry::Matrix4x4 & modelToWorld) {
+	if(index >= size())
+		throw std::out_of_range("FrustumCuller::setBox: Invalid index.");
+	storeBox(index, box, modelToWorld);
+}
+
+void FrustumCuller::setSphere(uint32_t index, const Geometry::Sphere_f & sphere) {
+	if(index >= size())
+		throw std::out_of_range("FrustumCuller::setSphere: Invalid index.");
+	const Geometry::Vec3 & center = sphere.getCenter();
+	centerX[index] = center.x();
+	centerY[index] = center.y();
+	centerZ[index] = center.z();
+	extentX[index] = extentY[index] = extentZ[index] = 0.0f;
+	radii[index] = sphere.getRadius();
+}
+
+void FrustumCuller::setBoxes(uint32_t first, uint32_t count, const Geometry::Box * boxes, const Geometry::Matrix4x4 * modelToWorld) {
+	if(static_cast<uint64_t>(first) + count > size())
+		throw std::out_of_range("FrustumCuller::setBoxes: Invalid range.");
+	TaskScheduler::get().parallelFor(count, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t i = begin; i < end; ++i)
+			storeBox(first + i, boxes[i], modelToWorld[i]);
+	}, CULLING_CHUNK_SIZE, "FrustumCuller::setBoxes");
+}
+
+void FrustumCuller::reserve(uint32_t count) {
+	for(auto array : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radii})
+		array->reserve(count);
+}
+
+void FrustumCuller::clear() {
+	for(auto array : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radii})
+		array->clear();
+}
+
+uint32_t FrustumCuller::cull(std::vector<uint32_t> & visibleIndices) const {
+	const uint32_t count = size();
+	const BoundsView bounds{centerX.data(), centerY.data(), centerZ.data(), extentX.data(), extentY.data(), extentZ.data(), radii.data()};
+	const cullKernel_t kernel = getKernel().cull;
+	visibleIndices.resize(count);
+	TaskScheduler & scheduler = TaskScheduler::get();
+	const uint32_t numChunks = (count + CULLING_CHUNK_SIZE - 1) / CULLING_CHUNK_SIZE;
+	uint32_t visibleCount = 0;
+	if(numChunks <= 1 || scheduler.getNumWorkers() == 0) {
+		visibleCount = kernel(bounds, planes.data(), 0, count, visibleIndices.data());
+	} else {
+		// every chunk writes to its own range of the result, which is compacted afterwards
+		std::vector<uint32_t> chunkCounts(numChunks);
+		scheduler.parallelFor(numChunks, [&](uint32_t beginChunk, uint32_t endChunk) {
+			for(uint32_t chunk = beginChunk; chunk < endChunk; ++chunk) {
+				const uint32_t begin = chunk * CULLING_CHUNK_SIZE;
+				const uint32_t end = std::min(count, begin + CULLING_CHUNK_SIZE);
+				chunkCounts[chunk] = kernel(bounds, planes.data(), begin, end, visibleIndices.data() + begin);
+			}
+		}, 1, "FrustumCuller::cull");
+		for(uint32_t chunk = 0; chunk < numChunks; ++chunk) {
+			const auto chunkBegin = visibleIndices.begin() + chunk * CULLING_CHUNK_SIZE;
+			std::copy(chunkBegin, chunkBegin + chunkCounts[chunk], visibleIndices.begin() + visibleCount);
+			visibleCount += chunkCounts[chunk];
+		}
+	}
+	visibleIndices.resize(visibleCount);
+	return visibleCount;
+}
+
+}
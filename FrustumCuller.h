@@ -0,0 +1,89 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_FRUSTUMCULLER_H_
+#define RENDERING_FRUSTUMCULLER_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Geometry {
+template<typename _T> class _Matrix4x4;
+typedef _Matrix4x4<float> Matrix4x4;
+template<typename value_t> class _Box;
+typedef _Box<float> Box;
+template<typename T> class _Sphere;
+typedef _Sphere<float> Sphere_f;
+}
+namespace Rendering {
+class RenderingContext;
+
+/**
+ * Batch view frustum culling of many objects.
+ *
+ * The bounding volumes are stored as structure of arrays in world space: a box is transformed by its model matrix
+ * into the enclosing axis-aligned box when it is set, a sphere is stored with its radius. cull() tests all objects
+ * against the six planes of the frustum, eight (AVX) or four (SSE2, NEON) at a time, and writes the indices of the
+ * potentially visible objects into a compact, ascending list. Large sets are split over the TaskScheduler.
+ * The test is conservative: objects intersecting a plane's corner region may be reported as visible.
+ * \code
+ *	FrustumCuller culler;
+ *	for(...)
+ *		drawIndices.push_back(culler.addBox(mesh->getBoundingBox(), modelMatrix)); // == batch.addMesh(mesh, modelMatrix)
+ *	...
+ *	culler.setFrustum(renderingContext);
+ *	culler.cull(visible);
+ *	batch.draw(renderingContext, visible);
+ * \endcode
+ */
+class FrustumCuller {
+	public:
+		FrustumCuller();
+
+		//! Use the frustum of the given world to clipping matrix.
+		void setFrustum(const Geometry::Matrix4x4 & worldToClipping);
+		//! Use the frustum of the current camera (getMatrix_cameraToClipping() * getMatrix_worldToCamera()).
+		void setFrustum(const RenderingContext & context);
+
+		//! Add the box (in model coordinates) of an object with the given model to world matrix and return its index.
+		uint32_t addBox(const Geometry::Box & box, const Geometry::Matrix4x4 & modelToWorld);
+		//! Add a sphere given in world coordinates and return its index.
+		uint32_t addSphere(const Geometry::Sphere_f & sphere);
+		void setBox(uint32_t index, const Geometry::Box & box, const Geometry::Matrix4x4 & modelToWorld);
+		void setSphere(uint32_t index, const Geometry::Sphere_f & sphere);
+		//! Set the boxes of the objects [first, first + count) (e.g. after the objects moved). Done in parallel.
+		void setBoxes(uint32_t first, uint32_t count, const Geometry::Box * boxes, const Geometry::Matrix4x4 * modelToWorld);
+
+		uint32_t size() const								{	return static_cast<uint32_t>(centerX.size());	}
+		bool empty() const									{	return centerX.empty();	}
+		void reserve(uint32_t count);
+		void clear();
+
+		/*! Replace the contents of @p visibleIndices by the ascending indices of the objects intersecting the frustum.
+			@return the number of visible objects */
+		uint32_t cull(std::vector<uint32_t> & visibleIndices) const;
+
+		//! Name of the selected implementation ("AVX", "SSE2", "NEON" or "scalar").
+		static const char * getImplementationName();
+
+	private:
+		//! Normalized planes (nx, ny, nz, d) with the inside in the positive half-space: left, right, bottom, top, near, far.
+		std::array<float, 24> planes;
+		std::vector<float> centerX, centerY, centerZ;
+		std::vector<float> extentX, extentY, extentZ; //!< half extents of the boxes (0 for spheres)
+		std::vector<float> radii; //!< radii of the spheres (0 for boxes)
+
+		void storeBox(uint32_t index, const Geometry::Box & box, const Geometry::Matrix4x4 & modelToWorld);
+};
+
+}
+
+#endif /* RENDERING_FRUSTUMCULLER_H_ */
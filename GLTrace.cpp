@@ -0,0 +1,521 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "GLTrace.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Util/Macros.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Rendering {
+namespace GLTrace {
+
+static const char traceMagic[4] = {'R', 'G', 'L', 'T'};
+static const uint32_t traceVersion = 1;
+
+std::atomic<bool> _recording(false);
+
+//! (internal)
+struct Recorder {
+	std::mutex mutex;
+	std::unique_ptr<std::ofstream> output;
+	uint64_t numCommands;
+	Recorder() : numCommands(0) {}
+};
+
+//! (internal)
+static Recorder & getRecorder() {
+	static Recorder recorder;
+	return recorder;
+}
+
+bool startRecording(const std::string & filename) {
+	stopRecording();
+	Recorder & recorder = getRecorder();
+	std::lock_guard<std::mutex> lock(recorder.mutex);
+	std::unique_ptr<std::ofstream> output(new std::ofstream(filename, std::ios::binary | std::ios::trunc));
+	if(!output->good()) {
+		WARN("GLTrace::startRecording: Cannot open file \"" + filename + "\".");
+		return false;
+	}
+	output->write(traceMagic, sizeof(traceMagic));
+	output->write(reinterpret_cast<const char *>(&traceVersion), sizeof(traceVersion));
+	recorder.output = std::move(output);
+	recorder.numCommands = 0;
+	_recording = true;
+	return true;
+}
+
+void stopRecording() {
+	Recorder & recorder = getRecorder();
+	std::lock_guard<std::mutex> lock(recorder.mutex);
+	_recording = false;
+	if(recorder.output) {
+		recorder.output->close();
+		recorder.output.reset();
+	}
+}
+
+uint64_t getNumRecordedCommands() {
+	Recorder & recorder = getRecorder();
+	std::lock_guard<std::mutex> lock(recorder.mutex);
+	return recorder.numCommands;
+}
+
+//! (internal)
+static void writeCommand(opcode_t opcode, const uint32_t * args, std::size_t numArgs, const void * data, std::size_t numBytes) {
+	Recorder & recorder = getRecorder();
+	std::lock_guard<std::mutex> lock(recorder.mutex);
+	if(!recorder.output)
+		return;
+	if(data == nullptr)
+		numBytes = 0;
+	const uint16_t header[2] = {static_cast<uint16_t>(opcode), static_cast<uint16_t>(numArgs)};
+	const uint32_t dataSize = static_cast<uint32_t>(numBytes);
+	std::ostream & out = *recorder.output;
+	out.write(reinterpret_cast<const char *>(header), sizeof(header));
+	out.write(reinterpret_cast<const char *>(&dataSize), sizeof(dataSize));
+	out.write(reinterpret_cast<const char *>(args), static_cast<std::streamsize>(numArgs * sizeof(uint32_t)));
+	if(numBytes > 0)
+		out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(numBytes));
+	++recorder.numCommands;
+}
+
+void record(opcode_t opcode, std::initializer_list<uint32_t> args, const void * data, std::size_t numBytes) {
+	if(isRecording())
+		writeCommand(opcode, args.begin(), args.size(), data, numBytes);
+}
+
+void record(opcode_t opcode, const std::vector<uint32_t> & args, const void * data, std::size_t numBytes) {
+	if(isRecording())
+		writeCommand(opcode, args.data(), args.size(), data, numBytes);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+#ifdef LIB_GL
+//! (internal) Minimal number of arguments of every opcode.
+static const std::array<uint16_t, NUM_OPCODES> numRequiredArgs = {{
+	0,	// FRAME_END
+	1,	// ENABLE
+	1,	// DISABLE
+	4,	// BLEND_FUNC_SEPARATE
+	4,	// BLEND_COLOR
+	2,	// BLEND_EQUATION_SEPARATE
+	4,	// COLOR_MASK
+	1,	// CULL_FACE
+	1,	// DEPTH_MASK
+	1,	// DEPTH_FUNC
+	1,	// LINE_WIDTH
+	3,	// STENCIL_FUNC
+	3,	// STENCIL_OP
+	2,	// ALPHA_FUNC
+	2,	// POLYGON_MODE
+	2,	// POLYGON_OFFSET
+	1,	// ACTIVE_TEXTURE
+	2,	// BIND_TEXTURE
+	1,	// BIND_TEXTURES
+	2,	// TEX_BUFFER
+	1,	// CREATE_BUFFER
+	1,	// DELETE_BUFFER
+	2,	// BIND_BUFFER
+	3,	// BIND_BUFFER_BASE
+	3,	// BUFFER_DATA
+	3,	// BUFFER_SUB_DATA
+	5,	// COPY_BUFFER_SUB_DATA
+	7,	// CREATE_TEXTURE
+	1,	// DELETE_TEXTURE
+	9,	// TEX_IMAGE
+	2,	// GENERATE_MIPMAP
+	1,	// BIND_VERTEX_DATA
+	0,	// UNBIND_VERTEX_DATA
+	3,	// DRAW_ARRAYS
+	6,	// DRAW_ELEMENTS
+}};
+
+static float toFloat(uint32_t value) {
+	float result;
+	std::memcpy(&result, &value, sizeof(result));
+	return result;
+}
+
+//! (internal) The GL objects created during a replay; the recorded names are mapped to them.
+struct ReplayState {
+	std::unordered_map<uint32_t, GLuint> buffers;
+	std::unordered_map<uint32_t, std::pair<GLuint, GLenum>> textures; // recorded name -> (name, target)
+	std::unordered_set<GLuint> enabledAttributes;
+	GLuint vertexArray;
+	GLuint scratchVertexBuffer;
+	GLuint scratchIndexBuffer;
+	GLenum activeTexture;
+	GLenum setupUnit;	//! texture unit used for creating and uploading textures
+
+	ReplayState() : vertexArray(0), scratchVertexBuffer(0), scratchIndexBuffer(0), activeTexture(GL_TEXTURE0), setupUnit(GL_TEXTURE0) {
+		GLint maxUnits = 0;
+		glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxUnits);
+		setupUnit = GL_TEXTURE0 + static_cast<GLenum>(std::max(maxUnits - 1, 0));
+		glGenVertexArrays(1, &vertexArray);
+		glBindVertexArray(vertexArray);
+		glGenBuffers(1, &scratchVertexBuffer);
+		glGenBuffers(1, &scratchIndexBuffer);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	}
+	~ReplayState() {
+		reset();
+		glDeleteBuffers(1, &scratchVertexBuffer);
+		glDeleteBuffers(1, &scratchIndexBuffer);
+		glBindVertexArray(0);
+		glDeleteVertexArrays(1, &vertexArray);
+	}
+	void reset() {
+		for(const auto & attribLocation : enabledAttributes)
+			glDisableVertexAttribArray(attribLocation);
+		enabledAttributes.clear();
+		for(const auto & entry : buffers)
+			glDeleteBuffers(1, &entry.second);
+		buffers.clear();
+		for(const auto & entry : textures)
+			glDeleteTextures(1, &entry.second.first);
+		textures.clear();
+		glActiveTexture(GL_TEXTURE0);
+		activeTexture = GL_TEXTURE0;
+	}
+	GLuint getBuffer(uint32_t recordedName) {
+		if(recordedName == 0)
+			return 0;
+		auto & buffer = buffers[recordedName];
+		if(buffer == 0)
+			glGenBuffers(1, &buffer);
+		return buffer;
+	}
+	GLuint getTexture(uint32_t recordedName) const {
+		const auto it = textures.find(recordedName);
+		return it == textures.end() ? 0 : it->second.first;
+	}
+	//! Bind the texture on the setup unit; returns its target (0 if unknown).
+	GLenum bindForSetup(uint32_t recordedName) {
+		const auto it = textures.find(recordedName);
+		if(it == textures.end())
+			return 0;
+		glActiveTexture(setupUnit);
+		glBindTexture(it->second.second, it->second.first);
+		return it->second.second;
+	}
+	void endSetup(GLenum target) {
+		glBindTexture(target, 0);
+		glActiveTexture(activeTexture);
+	}
+};
+
+//! (internal)
+static void execute(ReplayState & state, opcode_t opcode, const std::vector<uint32_t> & a, const std::vector<uint8_t> & data, ReplayResult & result) {
+	const void * dataPtr = data.empty() ? nullptr : data.data();
+	switch(opcode) {
+		case ENABLE:
+			glEnable(a[0]);
+			break;
+		case DISABLE:
+			glDisable(a[0]);
+			break;
+		case BLEND_FUNC_SEPARATE:
+			glBlendFuncSeparate(a[0], a[1], a[2], a[3]);
+			break;
+		case BLEND_COLOR:
+			glBlendColor(toFloat(a[0]), toFloat(a[1]), toFloat(a[2]), toFloat(a[3]));
+			break;
+		case BLEND_EQUATION_SEPARATE:
+			glBlendEquationSeparate(a[0], a[1]);
+			break;
+		case COLOR_MASK:
+			glColorMask(a[0], a[1], a[2], a[3]);
+			break;
+		case CULL_FACE:
+			glCullFace(a[0]);
+			break;
+		case DEPTH_MASK:
+			glDepthMask(a[0]);
+			break;
+		case DEPTH_FUNC:
+			glDepthFunc(a[0]);
+			break;
+		case LINE_WIDTH:
+			glLineWidth(toFloat(a[0]));
+			break;
+		case STENCIL_FUNC:
+			glStencilFunc(a[0], static_cast<GLint>(a[1]), a[2]);
+			break;
+		case STENCIL_OP:
+			glStencilOp(a[0], a[1], a[2]);
+			break;
+		case ALPHA_FUNC:
+			glAlphaFunc(a[0], toFloat(a[1]));
+			break;
+		case POLYGON_MODE:
+			glPolygonMode(a[0], a[1]);
+			break;
+		case POLYGON_OFFSET:
+			glPolygonOffset(toFloat(a[0]), toFloat(a[1]));
+			break;
+		case ACTIVE_TEXTURE:
+			state.activeTexture = a[0];
+			glActiveTexture(a[0]);
+			break;
+		case BIND_TEXTURE:
+			glBindTexture(a[0], state.getTexture(a[1]));
+			break;
+		case BIND_TEXTURES: {
+			std::vector<GLuint> ids;
+			for(std::size_t i = 1; i < a.size(); ++i)
+				ids.push_back(state.getTexture(a[i]));
+#if defined(GL_ARB_multi_bind)
+			glBindTextures(a[0], static_cast<GLsizei>(ids.size()), ids.data());
+#else
+			WARN("GLTrace::replay: glBindTextures is not supported.");
+#endif
+			break;
+		}
+		case TEX_BUFFER:
+			glTexBuffer(GL_TEXTURE_BUFFER, a[0], state.getBuffer(a[1]));
+			break;
+		case CREATE_BUFFER:
+			state.getBuffer(a[0]);
+			break;
+		case DELETE_BUFFER: {
+			const auto it = state.buffers.find(a[0]);
+			if(it != state.buffers.end()) {
+				glDeleteBuffers(1, &it->second);
+				state.buffers.erase(it);
+			}
+			break;
+		}
+		case BIND_BUFFER:
+			glBindBuffer(a[0], state.getBuffer(a[1]));
+			break;
+		case BIND_BUFFER_BASE:
+			glBindBufferBase(a[0], a[1], state.getBuffer(a[2]));
+			break;
+		case BUFFER_DATA:
+			glBindBuffer(GL_COPY_WRITE_BUFFER, state.getBuffer(a[0]));
+			glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(a[1]), data.size() >= a[1] ? dataPtr : nullptr, a[2]);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			result.numBytesUploaded += data.size();
+			break;
+		case BUFFER_SUB_DATA:
+			if(data.size() < a[2])
+				break;
+			glBindBuffer(GL_COPY_WRITE_BUFFER, state.getBuffer(a[0]));
+			glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(a[1]), static_cast<GLsizeiptr>(a[2]), dataPtr);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			result.numBytesUploaded += data.size();
+			break;
+		case COPY_BUFFER_SUB_DATA:
+			glBindBuffer(GL_COPY_READ_BUFFER, state.getBuffer(a[0]));
+			glBindBuffer(GL_COPY_WRITE_BUFFER, state.getBuffer(a[1]));
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(a[2]), static_cast<GLintptr>(a[3]), static_cast<GLsizeiptr>(a[4]));
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			break;
+		case CREATE_TEXTURE: {
+			auto & texture = state.textures[a[0]];
+			if(texture.first != 0)
+				glDeleteTextures(1, &texture.first);
+			glGenTextures(1, &texture.first);
+			texture.second = a[1];
+			const GLenum target = state.bindForSetup(a[0]);
+			if(target != GL_TEXTURE_BUFFER && target != GL_TEXTURE_2D_MULTISAMPLE) {
+				glTexParameteri(target, GL_TEXTURE_WRAP_S, static_cast<GLint>(a[2]));
+				glTexParameteri(target, GL_TEXTURE_WRAP_T, static_cast<GLint>(a[3]));
+				glTexParameteri(target, GL_TEXTURE_WRAP_R, static_cast<GLint>(a[4]));
+				glTexParameteri(target, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(a[5]));
+				glTexParameteri(target, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(a[6]));
+			}
+			state.endSetup(target);
+			break;
+		}
+		case DELETE_TEXTURE: {
+			const auto it = state.textures.find(a[0]);
+			if(it != state.textures.end()) {
+				glDeleteTextures(1, &it->second.first);
+				state.textures.erase(it);
+			}
+			break;
+		}
+		case TEX_IMAGE: {
+			const GLenum target = state.bindForSetup(a[0]);
+			if(target == 0)
+				break;
+			const GLenum imageTarget = a[1];
+			const GLint level = static_cast<GLint>(a[2]);
+			const GLint internalFormat = static_cast<GLint>(a[3]);
+			const GLsizei width = static_cast<GLsizei>(a[4]);
+			const GLsizei height = static_cast<GLsizei>(a[5]);
+			const GLsizei depth = static_cast<GLsizei>(a[6]);
+			if(imageTarget == GL_TEXTURE_1D) {
+				glTexImage1D(imageTarget, level, internalFormat, width, 0, a[7], a[8], dataPtr);
+			} else if(imageTarget == GL_TEXTURE_3D || imageTarget == GL_TEXTURE_2D_ARRAY || imageTarget == GL_TEXTURE_CUBE_MAP_ARRAY) {
+				glTexImage3D(imageTarget, level, internalFormat, width, height, depth, 0, a[7], a[8], dataPtr);
+			} else if(imageTarget == GL_TEXTURE_2D_MULTISAMPLE) {
+				glTexImage2DMultisample(imageTarget, static_cast<GLsizei>(a[7]), static_cast<GLenum>(internalFormat), width, height, GL_FALSE);
+			} else {
+				glTexImage2D(imageTarget, level, internalFormat, width, height, 0, a[7], a[8], dataPtr);
+			}
+			state.endSetup(target);
+			result.numBytesUploaded += data.size();
+			break;
+		}
+		case GENERATE_MIPMAP: {
+			const GLenum target = state.bindForSetup(a[0]);
+			if(target == 0)
+				break;
+			glGenerateMipmap(target);
+			state.endSetup(target);
+			break;
+		}
+		case BIND_VERTEX_DATA: {
+			GLuint buffer = state.getBuffer(a[0]);
+			if(buffer == 0 && !data.empty()) { // client side vertex data
+				buffer = state.scratchVertexBuffer;
+				glBindBuffer(GL_ARRAY_BUFFER, buffer);
+				glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size()), dataPtr, GL_STREAM_DRAW);
+				result.numBytesUploaded += data.size();
+			} else {
+				glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			}
+			if(buffer == 0)
+				break;
+			for(std::size_t i = 1; i + 7 <= a.size(); i += 7) {
+				const GLuint location = a[i];
+				const uint8_t * offset = nullptr;
+				if(a[i + 4] != 0) {
+					glVertexAttribIPointer(location, static_cast<GLint>(a[i + 1]), a[i + 2], static_cast<GLsizei>(a[i + 5]), offset + a[i + 6]);
+				} else {
+					glVertexAttribPointer(location, static_cast<GLint>(a[i + 1]), a[i + 2], a[i + 3] != 0 ? GL_TRUE : GL_FALSE,
+										  static_cast<GLsizei>(a[i + 5]), offset + a[i + 6]);
+				}
+				glEnableVertexAttribArray(location);
+				state.enabledAttributes.insert(location);
+			}
+			break;
+		}
+		case UNBIND_VERTEX_DATA:
+			for(const auto & location : state.enabledAttributes)
+				glDisableVertexAttribArray(location);
+			state.enabledAttributes.clear();
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			break;
+		case DRAW_ARRAYS:
+			glDrawArrays(a[0], static_cast<GLint>(a[1]), static_cast<GLsizei>(a[2]));
+			break;
+		case DRAW_ELEMENTS: {
+			GLuint buffer = state.getBuffer(a[3]);
+			if(buffer == 0) { // client side indices
+				if(data.empty())
+					break;
+				buffer = state.scratchIndexBuffer;
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+				glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size()), dataPtr, GL_STREAM_DRAW);
+				result.numBytesUploaded += data.size();
+			} else {
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+			}
+			const uint8_t * offset = nullptr;
+			const GLint baseVertex = static_cast<GLint>(a[5]);
+			if(baseVertex != 0) {
+				glDrawElementsBaseVertex(a[0], static_cast<GLsizei>(a[1]), a[2], offset + a[4], baseVertex);
+			} else {
+				glDrawElements(a[0], static_cast<GLsizei>(a[1]), a[2], offset + a[4]);
+			}
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+			break;
+		}
+		default:
+			break;
+	}
+}
+#endif /* LIB_GL */
+
+ReplayResult replay(const std::string & filename, uint32_t repetitions) {
+	std::ifstream input(filename, std::ios::binary);
+	if(!input.good())
+		throw std::runtime_error("GLTrace::replay: Cannot open file \"" + filename + "\".");
+	char magic[4];
+	uint32_t version = 0;
+	input.read(magic, sizeof(magic));
+	input.read(reinterpret_cast<char *>(&version), sizeof(version));
+	if(!input.good() || std::memcmp(magic, traceMagic, sizeof(magic)) != 0)
+		throw std::runtime_error("GLTrace::replay: \"" + filename + "\" is no GL trace.");
+	if(version != traceVersion)
+		throw std::runtime_error("GLTrace::replay: Unsupported trace version " + std::to_string(version) + ".");
+	const std::streampos firstCommand = input.tellg();
+
+	ReplayResult result;
+#ifdef LIB_GL
+	typedef std::chrono::steady_clock clock_t;
+	ReplayState state;
+	std::vector<uint32_t> args;
+	std::vector<uint8_t> data;
+	const auto replayStart = clock_t::now();
+	for(uint32_t repetition = 0; repetition < repetitions; ++repetition) {
+		input.clear();
+		input.seekg(firstCommand);
+		auto frameStart = clock_t::now();
+		bool commandsInFrame = false;
+		while(true) {
+			uint16_t header[2];
+			uint32_t dataSize;
+			input.read(reinterpret_cast<char *>(header), sizeof(header));
+			if(input.eof())
+				break;
+			input.read(reinterpret_cast<char *>(&dataSize), sizeof(dataSize));
+			args.resize(header[1]);
+			data.resize(dataSize);
+			input.read(reinterpret_cast<char *>(args.data()), static_cast<std::streamsize>(args.size() * sizeof(uint32_t)));
+			input.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+			if(!input.good())
+				throw std::runtime_error("GLTrace::replay: Truncated trace \"" + filename + "\".");
+			const auto opcode = static_cast<opcode_t>(header[0]);
+			if(opcode >= NUM_OPCODES || args.size() < numRequiredArgs[opcode])
+				throw std::runtime_error("GLTrace::replay: Invalid command in trace \"" + filename + "\".");
+			++result.numCommands;
+			if(opcode == FRAME_END) {
+				glFinish();
+				const auto now = clock_t::now();
+				result.frameTimes.push_back(std::chrono::duration<double, std::milli>(now - frameStart).count());
+				frameStart = now;
+				commandsInFrame = false;
+			} else {
+				execute(state, opcode, args, data, result);
+				commandsInFrame = true;
+			}
+		}
+		if(commandsInFrame) {
+			glFinish();
+			result.frameTimes.push_back(std::chrono::duration<double, std::milli>(clock_t::now() - frameStart).count());
+		}
+		state.reset();
+	}
+	result.totalTime = std::chrono::duration<double, std::milli>(clock_t::now() - replayStart).count();
+	GET_GL_ERROR();
+#else
+	WARN("GLTrace::replay: Not supported.");
+#endif /* LIB_GL */
+	return result;
+}
+
+}
+}
@@ -0,0 +1,132 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_GLTRACE_H_
+#define RENDERING_GLTRACE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace Rendering {
+
+/**
+ * Capture and replay of the OpenGL commands issued by the library, e.g. for performance regression tests.
+ *
+ * While recording, the state changes of StatusHandler_glCore, the buffer and texture commands of BufferObject and
+ * Texture, and the vertex bindings and draw calls of MeshVertexData and MeshIndexData are written into a compact binary
+ * trace, together with the uploaded data. RenderingContext::endFrame() marks the end of a frame.
+ * A trace is replayed (e.g. by the RenderingTraceReplay tool in a HeadlessContext) with replay(), which measures
+ * the time of every frame.
+ * \code
+ *	GLTrace::startRecording("scene.gltrace");
+ *	// render some frames...
+ *	GLTrace::stopRecording();
+ * \endcode
+ * \note Shader programs and uniforms are not recorded; the trace is replayed without a shader program. The replay
+ *	therefore measures the cost of the state changes, uploads and draw calls, not the cost of shading.
+ * \note Recording has to be switched on explicitly; otherwise the overhead of every traced command is a single flag test.
+ *
+ * Trace format: The header "RGLT" followed by the format version (uint32). Every command consists of its opcode (uint16),
+ * the number of arguments (uint16), the size of its data (uint32), the arguments (uint32 each; floats are stored
+ * bitwise) and the data.
+ */
+namespace GLTrace {
+
+enum opcode_t : uint16_t {
+	FRAME_END = 0,				//!< ()
+	ENABLE,						//!< (cap)
+	DISABLE,					//!< (cap)
+	BLEND_FUNC_SEPARATE,		//!< (srcRGB, dstRGB, srcAlpha, dstAlpha)
+	BLEND_COLOR,				//!< (r, g, b, a)
+	BLEND_EQUATION_SEPARATE,	//!< (modeRGB, modeAlpha)
+	COLOR_MASK,					//!< (r, g, b, a)
+	CULL_FACE,					//!< (mode)
+	DEPTH_MASK,					//!< (flag)
+	DEPTH_FUNC,					//!< (func)
+	LINE_WIDTH,					//!< (width)
+	STENCIL_FUNC,				//!< (func, ref, mask)
+	STENCIL_OP,					//!< (sfail, dpfail, dppass)
+	ALPHA_FUNC,					//!< (func, ref)
+	POLYGON_MODE,				//!< (face, mode)
+	POLYGON_OFFSET,				//!< (factor, units)
+	ACTIVE_TEXTURE,				//!< (unit)
+	BIND_TEXTURE,				//!< (target, texture)
+	BIND_TEXTURES,				//!< (first, textures...)
+	TEX_BUFFER,					//!< (internalFormat, buffer)
+	CREATE_BUFFER,				//!< (buffer)
+	DELETE_BUFFER,				//!< (buffer)
+	BIND_BUFFER,				//!< (target, buffer)
+	BIND_BUFFER_BASE,			//!< (target, index, buffer)
+	BUFFER_DATA,				//!< (buffer, size, usage) + data
+	BUFFER_SUB_DATA,			//!< (buffer, offset, size) + data
+	COPY_BUFFER_SUB_DATA,		//!< (source, target, sourceOffset, targetOffset, size)
+	CREATE_TEXTURE,				//!< (texture, target, wrapS, wrapT, wrapR, magFilter, minFilter)
+	DELETE_TEXTURE,				//!< (texture)
+	TEX_IMAGE,					//!< (texture, target, level, internalFormat, width, height, depth, format, type) + data
+	GENERATE_MIPMAP,			//!< (texture, target)
+	BIND_VERTEX_DATA,			//!< (buffer, (location, size, type, normalized, integer, stride, offset)...) + client data
+	UNBIND_VERTEX_DATA,			//!< ()
+	DRAW_ARRAYS,				//!< (mode, first, count)
+	DRAW_ELEMENTS,				//!< (mode, count, type, buffer, offset, baseVertex) + client indices
+	NUM_OPCODES
+};
+
+//! (internal)
+extern std::atomic<bool> _recording;
+
+//! Is a trace being recorded? Check this before assembling the arguments of a command.
+inline bool isRecording()						{	return _recording.load(std::memory_order_relaxed);	}
+
+/*! Start recording into the given file; a running recording is stopped.
+	@return false, if the file could not be opened.	*/
+bool startRecording(const std::string & filename);
+void stopRecording();
+
+//! Number of commands recorded since startRecording().
+uint64_t getNumRecordedCommands();
+
+//! Add a command to the trace (thread safe). Does nothing if no trace is being recorded.
+void record(opcode_t opcode, std::initializer_list<uint32_t> args, const void * data = nullptr, std::size_t numBytes = 0);
+void record(opcode_t opcode, const std::vector<uint32_t> & args, const void * data = nullptr, std::size_t numBytes = 0);
+
+//! Record a command if a trace is being recorded; the arguments are only evaluated in that case.
+#define RENDERING_GL_TRACE(opcode, ...) \
+	do { if(Rendering::GLTrace::isRecording()) Rendering::GLTrace::record(Rendering::GLTrace::opcode, __VA_ARGS__); } while(false)
+
+//! Bitwise conversion of a float argument.
+inline uint32_t arg(float value) {
+	uint32_t result;
+	std::memcpy(&result, &value, sizeof(result));
+	return result;
+}
+
+struct ReplayResult {
+	uint64_t numCommands;
+	uint64_t numBytesUploaded;
+	std::vector<double> frameTimes;		//!< Duration of every frame in milliseconds (including glFinish)
+	double totalTime;					//!< Milliseconds
+	ReplayResult() : numCommands(0), numBytesUploaded(0), totalTime(0.0) {}
+};
+
+/*! Replay a recorded trace in the current GL context. The GL objects of the trace are created on demand and deleted
+	afterwards. Commands recorded after the last frame end are counted as an additional frame.
+	@param repetitions The trace is replayed that often; the frame times of all repetitions are returned.
+	@throw std::runtime_error if the file cannot be read or is no valid trace.	*/
+ReplayResult replay(const std::string & filename, uint32_t repetitions = 1);
+
+}
+}
+
+#endif /* RENDERING_GLTRACE_H_ */
@@ -0,0 +1,207 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "HeadlessContext.h"
+#include "FBO.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Texture/Texture.h"
+#include "Texture/TextureUtils.h"
+#include <Geometry/Rect.h>
+#include <Util/Macros.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef RENDERING_HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace Rendering {
+
+//! (static)
+bool HeadlessContext::isSupported() {
+#ifdef RENDERING_HAVE_EGL
+	return true;
+#else
+	return false;
+#endif
+}
+
+#ifdef RENDERING_HAVE_EGL
+//! (internal) The display of the first GPU device; the default display if devices cannot be enumerated.
+static EGLDisplay getHeadlessDisplay() {
+#if defined(EGL_EXT_platform_device)
+	const auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+	const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	if(queryDevices != nullptr && getPlatformDisplay != nullptr) {
+		EGLDeviceEXT devices[16];
+		EGLint numDevices = 0;
+		if(queryDevices(16, devices, &numDevices) == EGL_TRUE) {
+			for(EGLint i = 0; i < numDevices; ++i) {
+				const EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr);
+				if(display != EGL_NO_DISPLAY)
+					return display;
+			}
+		}
+	}
+#endif
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+//! (internal)
+static bool hasEGLExtension(EGLDisplay display, const std::string & name) {
+	const char * extensions = eglQueryString(display, EGL_EXTENSIONS);
+	return extensions != nullptr && (std::string(" ") + extensions + " ").find(" " + name + " ") != std::string::npos;
+}
+#endif
+
+HeadlessContext::HeadlessContext(uint32_t _width, uint32_t _height, bool compatibilityProfile) :
+		width(_width), height(_height), display(nullptr), surface(nullptr), context(nullptr) {
+#ifdef RENDERING_HAVE_EGL
+	EGLDisplay eglDisplay = getHeadlessDisplay();
+	EGLint major = 0, minor = 0;
+	if(eglDisplay == EGL_NO_DISPLAY || eglInitialize(eglDisplay, &major, &minor) != EGL_TRUE)
+		throw std::runtime_error("HeadlessContext: EGL could not be initialized.");
+	display = eglDisplay;
+
+#if defined(LIB_GLESv2)
+	const EGLint renderableType = EGL_OPENGL_ES2_BIT;
+	eglBindAPI(EGL_OPENGL_ES_API);
+#else
+	const EGLint renderableType = EGL_OPENGL_BIT;
+	eglBindAPI(EGL_OPENGL_API);
+#endif
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24, EGL_STENCIL_SIZE, 8,
+		EGL_RENDERABLE_TYPE, renderableType,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	if(eglChooseConfig(eglDisplay, configAttributes, &config, 1, &numConfigs) != EGL_TRUE || numConfigs == 0) {
+		eglTerminate(eglDisplay);
+		throw std::runtime_error("HeadlessContext: No suitable EGL configuration.");
+	}
+
+	const EGLint pbufferAttributes[] = {
+		EGL_WIDTH, static_cast<EGLint>(width),
+		EGL_HEIGHT, static_cast<EGLint>(height),
+		EGL_NONE
+	};
+	EGLSurface eglSurface = eglCreatePbufferSurface(eglDisplay, config, pbufferAttributes);
+	if(eglSurface == EGL_NO_SURFACE && !hasEGLExtension(eglDisplay, "EGL_KHR_surfaceless_context")) {
+		eglTerminate(eglDisplay);
+		throw std::runtime_error("HeadlessContext: Neither a pbuffer nor a surfaceless context is available.");
+	}
+	surface = eglSurface == EGL_NO_SURFACE ? nullptr : eglSurface;
+
+	std::vector<EGLint> contextAttributes;
+#if defined(LIB_GLESv2)
+	contextAttributes.insert(contextAttributes.end(), {EGL_CONTEXT_CLIENT_VERSION, 2});
+#elif defined(EGL_KHR_create_context)
+	if(!compatibilityProfile) {
+		contextAttributes.insert(contextAttributes.end(), {
+			EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+			EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR
+		});
+	}
+#endif
+	(void)compatibilityProfile;
+	contextAttributes.push_back(EGL_NONE);
+	EGLContext eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes.data());
+	if(eglContext == EGL_NO_CONTEXT) {
+		if(surface != nullptr)
+			eglDestroySurface(eglDisplay, eglSurface);
+		eglTerminate(eglDisplay);
+		throw std::runtime_error("HeadlessContext: The EGL context could not be created.");
+	}
+	context = eglContext;
+
+	if(!makeCurrent()) {
+		eglDestroyContext(eglDisplay, eglContext);
+		if(surface != nullptr)
+			eglDestroySurface(eglDisplay, eglSurface);
+		eglTerminate(eglDisplay);
+		throw std::runtime_error("HeadlessContext: The EGL context could not be made current.");
+	}
+	RenderingContext::initGLState();
+#else
+	(void)compatibilityProfile;
+	throw std::runtime_error("HeadlessContext: The library has been built without EGL support.");
+#endif
+}
+
+HeadlessContext::~HeadlessContext() {
+	// the GL objects have to be released while the context is current
+	makeCurrent();
+	fbo = nullptr;
+	colorTexture = nullptr;
+	depthTexture = nullptr;
+#ifdef RENDERING_HAVE_EGL
+	EGLDisplay eglDisplay = reinterpret_cast<EGLDisplay>(display);
+	eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(eglDisplay, reinterpret_cast<EGLContext>(context));
+	if(surface != nullptr)
+		eglDestroySurface(eglDisplay, reinterpret_cast<EGLSurface>(surface));
+	eglTerminate(eglDisplay);
+#endif
+}
+
+bool HeadlessContext::makeCurrent() {
+#ifdef RENDERING_HAVE_EGL
+	EGLSurface eglSurface = surface != nullptr ? reinterpret_cast<EGLSurface>(surface) : EGL_NO_SURFACE;
+	return eglMakeCurrent(reinterpret_cast<EGLDisplay>(display), eglSurface, eglSurface, reinterpret_cast<EGLContext>(context)) == EGL_TRUE;
+#else
+	return false;
+#endif
+}
+
+void HeadlessContext::release() {
+#ifdef RENDERING_HAVE_EGL
+	eglMakeCurrent(reinterpret_cast<EGLDisplay>(display), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+#endif
+}
+
+void HeadlessContext::bindFramebuffer(RenderingContext & renderingContext) {
+	if(fbo.isNull()) {
+		colorTexture = TextureUtils::createStdTexture(width, height, true);
+		depthTexture = TextureUtils::createDepthTexture(width, height);
+		fbo = new FBO;
+		fbo->attachColorTexture(renderingContext, colorTexture.get());
+		fbo->attachDepthTexture(renderingContext, depthTexture.get());
+		if(!fbo->isComplete(renderingContext))
+			WARN(std::string("HeadlessContext: ") + fbo->getStatusMessage(renderingContext));
+	}
+	renderingContext.pushAndSetFBO(fbo.get());
+	renderingContext.pushAndSetViewport(Geometry::Rect_i(0, 0, static_cast<int>(width), static_cast<int>(height)));
+}
+
+void HeadlessContext::unbindFramebuffer(RenderingContext & renderingContext) {
+	renderingContext.popViewport();
+	renderingContext.popFBO();
+}
+
+FBO * HeadlessContext::getFBO() const {
+	return fbo.get();
+}
+
+Texture * HeadlessContext::getColorTexture() const {
+	return colorTexture.get();
+}
+
+Texture * HeadlessContext::getDepthTexture() const {
+	return depthTexture.get();
+}
+
+}
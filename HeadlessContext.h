@@ -0,0 +1,86 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_HEADLESSCONTEXT_H_
+#define RENDERING_HEADLESSCONTEXT_H_
+
+#include <Util/References.h>
+#include <cstdint>
+
+namespace Rendering {
+class FBO;
+class RenderingContext;
+class Texture;
+
+/**
+ * GL context without a window system (e.g. for batch rendering, thumbnails, benchmarks and tests on GPU servers).
+ *
+ * The context is created with EGL: on a GPU device (EGL_EXT_platform_device) if available, otherwise on the
+ * default display. It renders into a pbuffer of the given size (or without surface, if EGL_KHR_surfaceless_context
+ * is available and no pbuffer can be created). After the context has been made current, RenderingContext::initGLState()
+ * is called. For rendering that does not depend on the pbuffer, bindFramebuffer() provides an offscreen default
+ * framebuffer backed by an FBO.
+ * \code
+ *	HeadlessContext headless(1024, 768);
+ *	RenderingContext context;
+ *	headless.bindFramebuffer(context);
+ *	// render...
+ *	Util::Reference<Util::Bitmap> image = TextureUtils::createBitmapFromTexture(context, *headless.getColorTexture());
+ *	headless.unbindFramebuffer(context);
+ * \endcode
+ * \note Requires a build with RENDERING_HEADLESS_EGL; with GLEW, GLEW has to be built with EGL support.
+ */
+class HeadlessContext {
+	public:
+		//! Was the library built with EGL support?
+		static bool isSupported();
+
+		/*! Create the context and make it current.
+			@param compatibilityProfile If false, an OpenGL 3.3 core profile context is requested.
+			@throw std::runtime_error if the context cannot be created.	*/
+		HeadlessContext(uint32_t width, uint32_t height, bool compatibilityProfile = true);
+		~HeadlessContext();
+
+		HeadlessContext(const HeadlessContext &) = delete;
+		HeadlessContext & operator=(const HeadlessContext &) = delete;
+
+		//! Make the context current on the calling thread.
+		bool makeCurrent();
+		//! Release the context from the calling thread.
+		void release();
+
+		uint32_t getWidth() const						{	return width;	}
+		uint32_t getHeight() const						{	return height;	}
+		//! @c false if the context has no pbuffer (surfaceless); rendering then requires a framebuffer object.
+		bool hasSurface() const							{	return surface != nullptr;	}
+
+		/*! Activate the offscreen framebuffer (RGBA8 color and depth textures of the context's size, created on first
+			use) and set the viewport to its size.	*/
+		void bindFramebuffer(RenderingContext & context);
+		//! Restore the framebuffer and viewport active before bindFramebuffer().
+		void unbindFramebuffer(RenderingContext & context);
+		FBO * getFBO() const;
+		Texture * getColorTexture() const;
+		Texture * getDepthTexture() const;
+
+	private:
+		uint32_t width;
+		uint32_t height;
+		void * display;
+		void * surface;
+		void * context;
+		Util::Reference<FBO> fbo;
+		Util::Reference<Texture> colorTexture;
+		Util::Reference<Texture> depthTexture;
+};
+
+}
+
+#endif /* RENDERING_HEADLESSCONTEXT_H_ */
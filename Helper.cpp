@@ -9,9 +9,18 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "Helper.h"
+#include "Capabilities.h"
 #include "GLHeader.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <chrono>
 #include <iostream>
 #include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
 #if defined(ANDROID)
 #include <android/log.h>
 #endif /* defined(ANDROID) */
@@ -19,13 +28,114 @@
 namespace Rendering {
 
 static bool GLErrorChecking = false;
+static std::atomic<uint32_t> sampledCallInterval(0); //! 0: every call is checked and errors are printed
+static std::atomic<uint32_t> sampledFrameInterval(1);
+static std::atomic<uint64_t> sampledFrameCounter(0);
+static std::atomic<bool> frameIsChecked(true);
 
 void enableGLErrorChecking() {
+	sampledCallInterval = 0;
+	frameIsChecked = true;
 	GLErrorChecking = true;
 }
 
 void disableGLErrorChecking() {
 	GLErrorChecking = false;
+	sampledCallInterval = 0;
+}
+
+void enableSampledGLErrorChecking(uint32_t callInterval, uint32_t frameInterval) {
+	sampledCallInterval = std::max(1u, callInterval);
+	sampledFrameInterval = std::max(1u, frameInterval);
+	sampledFrameCounter = 0;
+	frameIsChecked = true;
+	GLErrorChecking = true;
+}
+
+void _beginGLErrorCheckingFrame() {
+	if(sampledCallInterval.load(std::memory_order_relaxed) == 0)
+		return;
+	frameIsChecked.store(sampledFrameCounter++ % sampledFrameInterval.load(std::memory_order_relaxed) == 0, std::memory_order_relaxed);
+}
+
+//! (internal) Aggregated errors (accessed by the render threads and the asynchronous debug output).
+struct GLErrorStatistics {
+	std::mutex mutex;
+	std::map<std::tuple<const char *, int, uint32_t>, GLErrorRecord> records;
+	double reportInterval;
+	std::chrono::steady_clock::time_point lastReport;
+	GLErrorStatistics() : reportInterval(0.0), lastReport(std::chrono::steady_clock::now()) {}
+};
+
+static GLErrorStatistics & getGLErrorStatisticsData() {
+	static GLErrorStatistics statistics;
+	return statistics;
+}
+
+static void countGLError(const char * file, int line, uint32_t error, const char * message) {
+	GLErrorStatistics & statistics = getGLErrorStatisticsData();
+	std::lock_guard<std::mutex> lock(statistics.mutex);
+	GLErrorRecord & record = statistics.records[std::make_tuple(file, line, error)];
+	if(record.count == 0) {
+		record.file = file;
+		record.line = line;
+		record.error = error;
+		if(message != nullptr)
+			record.message = message;
+	}
+	++record.count;
+}
+
+static std::vector<GLErrorRecord> collectGLErrors(GLErrorStatistics & statistics) {
+	std::vector<GLErrorRecord> result;
+	result.reserve(statistics.records.size());
+	for(const auto & entry : statistics.records)
+		result.push_back(entry.second);
+	std::stable_sort(result.begin(), result.end(), [](const GLErrorRecord & a, const GLErrorRecord & b) { return a.count > b.count; });
+	return result;
+}
+
+static void outputGLErrors(std::ostream & output, const std::vector<GLErrorRecord> & records);
+
+//! Print and reset the aggregated errors if the report interval has elapsed.
+static void reportGLErrorsPeriodically() {
+	GLErrorStatistics & statistics = getGLErrorStatisticsData();
+	std::vector<GLErrorRecord> records;
+	{
+		std::lock_guard<std::mutex> lock(statistics.mutex);
+		if(statistics.reportInterval <= 0.0 || statistics.records.empty())
+			return;
+		const auto now = std::chrono::steady_clock::now();
+		if(std::chrono::duration<double>(now - statistics.lastReport).count() < statistics.reportInterval)
+			return;
+		statistics.lastReport = now;
+		records = collectGLErrors(statistics);
+		statistics.records.clear();
+	}
+	outputGLErrors(std::cerr, records);
+}
+
+std::vector<GLErrorRecord> getGLErrorStatistics() {
+	GLErrorStatistics & statistics = getGLErrorStatisticsData();
+	std::lock_guard<std::mutex> lock(statistics.mutex);
+	return collectGLErrors(statistics);
+}
+
+void resetGLErrorStatistics() {
+	GLErrorStatistics & statistics = getGLErrorStatisticsData();
+	std::lock_guard<std::mutex> lock(statistics.mutex);
+	statistics.records.clear();
+}
+
+void setGLErrorReportInterval(double seconds) {
+	GLErrorStatistics & statistics = getGLErrorStatisticsData();
+	std::lock_guard<std::mutex> lock(statistics.mutex);
+	statistics.reportInterval = seconds;
+	statistics.lastReport = std::chrono::steady_clock::now();
+}
+
+void outputGLErrorStatistics(std::ostream & output) {
+	outputGLErrors(output, getGLErrorStatistics());
 }
 
 static const char * getGLErrorString(GLenum errorFlag) {
@@ -55,13 +165,41 @@ static const char * getGLErrorString(GLenum errorFlag) {
 	}
 }
 
+static void outputGLErrors(std::ostream & output, const std::vector<GLErrorRecord> & records) {
+	for(const auto & record : records) {
+		if(record.message.empty()) {
+			output << "GL ERROR (0x" << std::hex << record.error << "):" << getGLErrorString(record.error)
+					<< " at " << record.file << ":" << std::dec << record.line << " (" << record.count << "x)\n";
+		} else {
+			output << "GL DEBUG type=0x" << std::hex << record.error << std::dec << " id=" << record.line
+					<< " (" << record.count << "x) message=" << record.message << '\n';
+		}
+	}
+	output.flush();
+}
+
 void checkGLError(const char * file, int line) {
 	if(!GLErrorChecking) {
 		return;
 	}
+	const uint32_t callInterval = sampledCallInterval.load(std::memory_order_relaxed);
+	if(callInterval != 0) {
+		static thread_local uint32_t callCounter = 0;
+		if(!frameIsChecked.load(std::memory_order_relaxed) || ++callCounter % callInterval != 0)
+			return;
+		bool errorFound = false;
+		for(GLenum errorFlag = glGetError(); errorFlag != GL_NO_ERROR; errorFlag = glGetError()) {
+			countGLError(file, line, errorFlag, nullptr);
+			errorFound = true;
+		}
+		if(errorFound)
+			reportGLErrorsPeriodically();
+		return;
+	}
 	// Call glGetError() in a loop, because there might be multiple recorded errors.
 	GLenum errorFlag = glGetError();
 	while (errorFlag != GL_NO_ERROR) {
+		countGLError(file, line, errorFlag, nullptr);
 #if defined(ANDROID)
 		__android_log_print(ANDROID_LOG_WARN, "RenderingMobile", "GL ERROR (%i):%s at %s:%i", errorFlag, getGLErrorString(errorFlag), file, line);
 #else
@@ -142,6 +280,12 @@ void outputGLInformation(std::ostream & output) {
 	output << "OpenGL renderer: " << glGetString(GL_RENDERER) << '\n';
 	output << "OpenGL version: " << glGetString(GL_VERSION) << '\n';
 	output << "OpenGL shading language version: " << glGetString(GL_SHADING_LANGUAGE_VERSION) << '\n';
+	const GPUMemoryInfo memory = queryGPUMemoryInfo();
+	if(memory.isValid()) {
+		if(memory.dedicatedMemory != 0)
+			output << "Dedicated video memory: " << (memory.dedicatedMemory >> 20) << " MiB\n";
+		output << "Available video memory: " << (memory.availableMemory >> 20) << " MiB\n";
+	}
 }
 
 const char * getGraphicsLanguageVersion() {
@@ -160,6 +304,104 @@ bool isExtensionSupported(const char * extension) {
 #endif
 }
 
+bool isDirectStateAccessSupported() {
+#if defined(LIB_GL) && defined(GL_ARB_direct_state_access)
+	return Capabilities::get().directStateAccess;
+#else
+	return false;
+#endif
+}
+
+#ifndef GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX
+#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX 0x9047
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#define GL_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX 0x904B
+#endif
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+GPUMemoryInfo queryGPUMemoryInfo() {
+	GPUMemoryInfo info;
+#if defined(LIB_GL)
+	static const bool nvxSupport = isExtensionSupported("GL_NVX_gpu_memory_info");
+	static const bool atiSupport = isExtensionSupported("GL_ATI_meminfo");
+	if(nvxSupport) { // values in KiB
+		GLint dedicated = 0, available = 0, evicted = 0;
+		glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &dedicated);
+		glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+		glGetIntegerv(GL_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX, &evicted);
+		info.dedicatedMemory = static_cast<uint64_t>(std::max(dedicated, 0)) * 1024;
+		info.availableMemory = static_cast<uint64_t>(std::max(available, 0)) * 1024;
+		info.evictedMemory = static_cast<uint64_t>(std::max(evicted, 0)) * 1024;
+	} else if(atiSupport) { // total free, largest free block, total auxiliary free, largest auxiliary free block in KiB
+		GLint values[4] = {0, 0, 0, 0};
+		glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, values);
+		info.availableMemory = static_cast<uint64_t>(std::max(values[0], 0)) * 1024;
+	}
+#endif
+	return info;
+}
+
+//! (internal)
+struct GPUMemoryPressureListener {
+	uint32_t id;
+	uint64_t threshold;
+	std::function<void(const GPUMemoryInfo &)> callback;
+	bool triggered;	//!< the available memory is below the threshold; reset when it has risen by 10%
+};
+
+//! (internal)
+struct GPUMemoryPressureListeners {
+	std::mutex mutex;
+	std::vector<std::shared_ptr<GPUMemoryPressureListener>> listeners;
+	uint32_t nextId;
+	GPUMemoryPressureListeners() : nextId(1) {}
+};
+
+static GPUMemoryPressureListeners & getGPUMemoryPressureListeners() {
+	static GPUMemoryPressureListeners listeners;
+	return listeners;
+}
+
+uint32_t addGPUMemoryPressureListener(uint64_t thresholdInBytes, std::function<void(const GPUMemoryInfo &)> listener) {
+	auto & data = getGPUMemoryPressureListeners();
+	std::lock_guard<std::mutex> lock(data.mutex);
+	std::shared_ptr<GPUMemoryPressureListener> entry(new GPUMemoryPressureListener{data.nextId++, thresholdInBytes, std::move(listener), false});
+	data.listeners.push_back(entry);
+	return entry->id;
+}
+
+void removeGPUMemoryPressureListener(uint32_t id) {
+	auto & data = getGPUMemoryPressureListeners();
+	std::lock_guard<std::mutex> lock(data.mutex);
+	data.listeners.erase(std::remove_if(data.listeners.begin(), data.listeners.end(),
+			[id](const std::shared_ptr<GPUMemoryPressureListener> & entry) { return entry->id == id; }), data.listeners.end());
+}
+
+GPUMemoryInfo checkGPUMemoryPressure() {
+	const GPUMemoryInfo info = queryGPUMemoryInfo();
+	if(!info.isValid())
+		return info;
+	std::vector<std::shared_ptr<GPUMemoryPressureListener>> notified;
+	{
+		auto & data = getGPUMemoryPressureListeners();
+		std::lock_guard<std::mutex> lock(data.mutex);
+		for(const auto & entry : data.listeners) {
+			if(!entry->triggered && info.availableMemory < entry->threshold) {
+				entry->triggered = true;
+				notified.push_back(entry);
+			} else if(entry->triggered && info.availableMemory > entry->threshold + entry->threshold / 10) {
+				entry->triggered = false;
+			}
+		}
+	}
+	// the listeners are called without holding the lock; they may add or remove listeners
+	for(const auto & entry : notified)
+		entry->callback(info);
+	return info;
+}
+
 float readDepthValue(int32_t x, int32_t y) {
 	GLfloat z;
 	glReadPixels(x, y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &z);
@@ -182,6 +424,8 @@ static void debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity
 	debugCallback(source,type,id,severity,length,message,static_cast<const void*>(userParam));
 }
 
+static std::atomic<bool> aggregateDebugOutput(false);
+
 static void debugCallback(GLenum source,
 						  GLenum type,
 						  GLuint id,
@@ -189,6 +433,11 @@ static void debugCallback(GLenum source,
 						  GLsizei /*length*/,
 						  const char * message,
                           const void * /*userParam*/) {
+	if(aggregateDebugOutput.load(std::memory_order_relaxed)) {
+		countGLError("GL debug output", static_cast<int>(id), type, message);
+		reportGLErrorsPeriodically();
+		return;
+	}
 	std::cerr << "GL DEBUG source=";
 	switch(source) {
 		case GL_DEBUG_SOURCE_API_ARB:
@@ -250,17 +499,22 @@ static void debugCallback(GLenum source,
 }
 #endif
 
-void enableDebugOutput() {
+void enableDebugOutput(bool aggregate) {
 #if defined(LIB_GLEW) && defined(LIB_GL) && defined(GL_ARB_debug_output)
 	if(!glewIsSupported("GL_ARB_debug_output")) {
 		std::cerr << "GL_ARB_debug_output is not supported" << std::endl;
 		return;
 	}
+	aggregateDebugOutput = aggregate;
 	glDebugMessageControlARB(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
 	glDebugMessageCallbackARB(&debugCallback, nullptr);
-	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+	if(aggregate)
+		glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+	else
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
 	glDebugMessageInsertARB(GL_DEBUG_SOURCE_THIRD_PARTY_ARB, GL_DEBUG_TYPE_OTHER_ARB, 1, GL_DEBUG_SEVERITY_LOW_ARB, -1, "Rendering: Debugging enabled");
 #else
+	static_cast<void>(aggregate);
 	std::cerr << "GL_ARB_debug_output is not supported" << std::endl;
 #endif
 }
@@ -12,14 +12,49 @@
 #define RENDERING_HELPER_H
 
 #include <cstdint>
+#include <functional>
 #include <iosfwd>
+#include <string>
+#include <vector>
 
 namespace Rendering {
 
+//! Check for GL errors at every GET_GL_ERROR() and print them immediately.
 void enableGLErrorChecking();
 void disableGLErrorChecking();
 void checkGLError(const char * file, int line);
 
+/**
+ * Enable low-overhead GL error checking: only every @p callInterval-th GET_GL_ERROR() call of every
+ * @p frameInterval-th frame (see RenderingContext::beginFrame()) queries glGetError(). The errors are not printed,
+ * but counted per call site; they are printed periodically (see setGLErrorReportInterval()) or can be queried with
+ * getGLErrorStatistics().
+ * \note An error is attributed to the call site of the check that detected it; the actual source may be any GL call
+ *	since the previous performed check. Lowering the intervals narrows the range.
+ */
+void enableSampledGLErrorChecking(uint32_t callInterval, uint32_t frameInterval = 1);
+
+//! Aggregated GL errors of a call site (or of a debug output message, see enableDebugOutput()).
+struct GLErrorRecord {
+	const char * file;		//!< "GL debug output" for debug messages
+	int line;				//!< The message id for debug messages
+	uint32_t error;			//!< The GL error flag or the debug message type
+	uint64_t count;
+	std::string message;	//!< The first debug message; empty for errors
+};
+
+//! Errors counted since the last reset, sorted by count (highest first).
+std::vector<GLErrorRecord> getGLErrorStatistics();
+void resetGLErrorStatistics();
+void outputGLErrorStatistics(std::ostream & output);
+
+/*! Print (to std::cerr) and reset the aggregated errors at most every @p seconds, if new errors occurred.
+	The report is triggered by a performed check or a debug message. 0 (default) disables the periodic report. */
+void setGLErrorReportInterval(double seconds);
+
+//! (internal) Called by RenderingContext::beginFrame() to select the frames checked by the sampled error checking.
+void _beginGLErrorCheckingFrame();
+
 /**
  * Return a human-readable description for the given OpenGL type.
  *
@@ -70,9 +105,61 @@ const char * getShadingLanguageVersion();
  */
 bool isExtensionSupported(const char * extension);
 
+/**
+ * Check whether objects can be modified without binding them.
+ * Buffer objects, textures and FBOs use the Direct State Access functions
+ * (e.g. @c glNamedBufferSubData) instead of bind-to-edit if this returns @c true.
+ *
+ * @return @c true if OpenGL 4.5 or @c GL_ARB_direct_state_access is supported, @c false otherwise.
+ * @see OpenGL extension @c GL_ARB_direct_state_access
+ */
+bool isDirectStateAccessSupported();
+
+//! Graphics memory of the device of the current context in bytes; 0 if unknown.
+struct GPUMemoryInfo {
+	uint64_t dedicatedMemory;	//!< Total dedicated video memory (only reported by @c GL_NVX_gpu_memory_info)
+	uint64_t availableMemory;	//!< Currently available video memory
+	uint64_t evictedMemory;		//!< Memory evicted by the driver since the start of the process (only @c GL_NVX_gpu_memory_info)
+	GPUMemoryInfo() : dedicatedMemory(0), availableMemory(0), evictedMemory(0) {}
+	bool isValid() const	{	return availableMemory != 0;	}
+};
+
+/**
+ * Query the graphics memory of the current device.
+ * For @c GL_ATI_meminfo, the free memory of the texture pool is reported as available memory.
+ *
+ * @return An invalid info if neither extension is supported.
+ * @see OpenGL extensions @c GL_NVX_gpu_memory_info and @c GL_ATI_meminfo
+ */
+GPUMemoryInfo queryGPUMemoryInfo();
+
+/**
+ * Register a listener that is called by checkGPUMemoryPressure() when the available graphics memory drops below
+ * the given threshold. It is called again only after the available memory has risen above the threshold by 10%.
+ * A listener typically lowers the budget of a TextureResidencyManager or a BudgetedMeshDataStrategy:
+ * \code
+ *	addGPUMemoryPressureListener(256 * 1024 * 1024, [&](const GPUMemoryInfo & info) {
+ *		residencyManager.setBudget(residencyManager.getUsedMemory() / 2);
+ *	});
+ * \endcode
+ *
+ * @return Id of the listener for removeGPUMemoryPressureListener()
+ */
+uint32_t addGPUMemoryPressureListener(uint64_t thresholdInBytes, std::function<void(const GPUMemoryInfo &)> listener);
+void removeGPUMemoryPressureListener(uint32_t id);
+
+/**
+ * Query the graphics memory and notify the pressure listeners whose threshold has been crossed.
+ * Has to be called regularly (e.g. once per frame or second) by a thread with a current context.
+ *
+ * @return The queried memory information
+ */
+GPUMemoryInfo checkGPUMemoryPressure();
+
 /**
  * Read a single value from the depth buffer.
  * 
+ * @note Stalls until the GPU has finished rendering; use a DepthPicker for repeated requests.
  * @see @c glReadPixels
  */
 float readDepthValue(int32_t x, int32_t y);
@@ -80,9 +167,11 @@ float readDepthValue(int32_t x, int32_t y);
 /**
  * Enable debug output that can be used to find errors or performance problems.
  * 
+ * @param aggregate If true, the messages are reported asynchronously and counted like the sampled GL errors
+ *	(see getGLErrorStatistics()) instead of being printed; this avoids the synchronization of the synchronous mode.
  * @see OpenGL extension @c GL_ARB_debug_output
  */
-void enableDebugOutput();
+void enableDebugOutput(bool aggregate = false);
 
 /**
  * Disable the debug output again.
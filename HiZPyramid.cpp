@@ -0,0 +1,271 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "HiZPyramid.h"
+#include "RenderingContext/RenderingContext.h"
+#include "RenderingContext/RenderingParameters.h"
+#include "Shader/Shader.h"
+#include "Shader/ShaderObjectInfo.h"
+#include "Shader/Uniform.h"
+#include "Texture/Texture.h"
+#include "Texture/TextureUtils.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Geometry/Box.h>
+#include <Geometry/Matrix4x4.h>
+#include <Util/Macros.h>
+#include <Util/TypeConstant.h>
+#include <algorithm>
+
+namespace Rendering {
+
+static const char * const copyProgram =
+R"***(#version 430
+layout(local_size_x = 8, local_size_y = 8) in;
+uniform sampler2D depthTexture;
+layout(r32f, binding = 0) uniform writeonly image2D dst;
+
+void main() {
+	const ivec2 pos = ivec2(gl_GlobalInvocationID.xy);
+	if(any(greaterThanEqual(pos, imageSize(dst))))
+		return;
+	imageStore(dst, pos, vec4(texelFetch(depthTexture, pos, 0).r));
+}
+)***";
+
+static const char * const reduceProgram =
+R"***(#version 430
+layout(local_size_x = 8, local_size_y = 8) in;
+layout(r32f, binding = 0) uniform readonly image2D src;
+layout(r32f, binding = 1) uniform writeonly image2D dst;
+
+void main() {
+	const ivec2 pos = ivec2(gl_GlobalInvocationID.xy);
+	const ivec2 dstSize = imageSize(dst);
+	if(any(greaterThanEqual(pos, dstSize)))
+		return;
+	const ivec2 srcSize = imageSize(src);
+	const ivec2 first = 2 * pos;
+	// the last texel of a level with odd size also covers the remaining texel of the source level
+	ivec2 last = first + ivec2(1);
+	if(pos.x == dstSize.x - 1) last.x = srcSize.x - 1;
+	if(pos.y == dstSize.y - 1) last.y = srcSize.y - 1;
+	last = min(last, srcSize - ivec2(1));
+	float depth = 0.0;
+	for(int y = first.y; y <= last.y; ++y) {
+		for(int x = first.x; x <= last.x; ++x)
+			depth = max(depth, imageLoad(src, ivec2(x, y)).r);
+	}
+	imageStore(dst, pos, vec4(depth));
+}
+)***";
+
+static const char * const testProgram =
+R"***(#version 430
+layout(local_size_x = 64) in;
+struct Box {
+	vec4 minCorner;
+	vec4 maxCorner;
+};
+layout(std430, binding = 0) readonly buffer Boxes { Box boxes[]; };
+layout(std430, binding = 1) writeonly buffer Results { uint visible[]; };
+uniform sampler2D pyramid;
+uniform mat4 modelToClipping;
+uniform int boxCount;
+uniform int numLevels;
+
+void main() {
+	const uint i = gl_GlobalInvocationID.x;
+	if(i >= uint(boxCount))
+		return;
+	const vec3 minCorner = boxes[i].minCorner.xyz;
+	const vec3 maxCorner = boxes[i].maxCorner.xyz;
+	vec3 ndcMin = vec3(1.0);
+	vec3 ndcMax = vec3(-1.0);
+	for(int c = 0; c < 8; ++c) {
+		const vec3 corner = vec3((c & 1) != 0 ? maxCorner.x : minCorner.x, (c & 2) != 0 ? maxCorner.y : minCorner.y, (c & 4) != 0 ? maxCorner.z : minCorner.z);
+		const vec4 clipPos = modelToClipping * vec4(corner, 1.0);
+		if(clipPos.w <= 0.0) {
+			// intersects the plane of the camera
+			visible[i] = 1u;
+			return;
+		}
+		const vec3 ndc = clipPos.xyz / clipPos.w;
+		ndcMin = min(ndcMin, ndc);
+		ndcMax = max(ndcMax, ndc);
+	}
+	if(any(greaterThan(ndcMin, vec3(1.0))) || any(lessThan(ndcMax, vec3(-1.0)))) {
+		visible[i] = 0u;
+		return;
+	}
+	const vec2 size0 = vec2(textureSize(pyramid, 0));
+	const vec2 uvMin = clamp(ndcMin.xy * 0.5 + 0.5, vec2(0.0), vec2(1.0));
+	const vec2 uvMax = clamp(ndcMax.xy * 0.5 + 0.5, vec2(0.0), vec2(1.0));
+	const vec2 extent = (uvMax - uvMin) * size0;
+	const int level = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), 0, numLevels - 1);
+	const ivec2 levelSize = textureSize(pyramid, level);
+	const ivec2 texelMin = clamp(ivec2(uvMin * vec2(levelSize)), ivec2(0), levelSize - ivec2(1));
+	const ivec2 texelMax = clamp(ivec2(uvMax * vec2(levelSize)), ivec2(0), levelSize - ivec2(1));
+	float farDepth = 0.0;
+	for(int y = texelMin.y; y <= texelMax.y; ++y) {
+		for(int x = texelMin.x; x <= texelMax.x; ++x)
+			farDepth = max(farDepth, texelFetch(pyramid, ivec2(x, y), level).r);
+	}
+	visible[i] = (ndcMin.z * 0.5 + 0.5 <= farDepth) ? 1u : 0u;
+}
+)***";
+
+//! (static)
+bool HiZPyramid::isSupported() {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_image_load_store) && defined(GL_ARB_shader_storage_buffer_object)
+	static const bool support = isExtensionSupported("GL_ARB_compute_shader") &&
+								isExtensionSupported("GL_ARB_shader_image_load_store") &&
+								isExtensionSupported("GL_ARB_shader_storage_buffer_object");
+	return support;
+#else
+	return false;
+#endif
+}
+
+HiZPyramid::HiZPyramid() : ReferenceCounter_t(), numLevels(0), pendingResults(0) {
+}
+
+HiZPyramid::~HiZPyramid() = default;
+
+Texture * HiZPyramid::getTexture() const {
+	return pyramid.get();
+}
+
+//! (internal)
+void HiZPyramid::initShaders() {
+	if(copyShader.isNotNull())
+		return;
+	copyShader = Shader::createShader(Shader::USE_UNIFORMS);
+	copyShader->attachShaderObject(ShaderObjectInfo::createCompute(copyProgram));
+	reduceShader = Shader::createShader(Shader::USE_UNIFORMS);
+	reduceShader->attachShaderObject(ShaderObjectInfo::createCompute(reduceProgram));
+	testShader = Shader::createShader(Shader::USE_UNIFORMS);
+	testShader->attachShaderObject(ShaderObjectInfo::createCompute(testProgram));
+}
+
+void HiZPyramid::update(RenderingContext & context, Texture * depthTexture) {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_image_load_store) && defined(GL_ARB_shader_storage_buffer_object)
+	if(!isSupported()) {
+		WARN("HiZPyramid::update: Compute shaders are not supported.");
+		return;
+	}
+	if(depthTexture == nullptr)
+		return;
+	initShaders();
+	const uint32_t width = depthTexture->getWidth();
+	const uint32_t height = depthTexture->getHeight();
+	if(pyramid.isNull() || pyramid->getWidth() != width || pyramid->getHeight() != height) {
+		pyramid = TextureUtils::createDataTexture(TextureType::TEXTURE_2D, width, height, 1, Util::TypeConstant::FLOAT, 1);
+		pyramid->createMipmaps(context);
+		numLevels = 1;
+		for(uint32_t size = std::max(width, height); size > 1; size /= 2)
+			++numLevels;
+		// sample the levels with texelFetch
+		context.pushAndSetTexture(0, nullptr);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, pyramid->getGLId());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(numLevels - 1));
+		glBindTexture(GL_TEXTURE_2D, 0);
+		context.popTexture(0);
+		GET_GL_ERROR();
+	}
+
+	// level 0: copy of the depth texture
+	{
+		ImageBindParameters target(pyramid.get());
+		target.setLevel(0);
+		target.setReadOperations(false);
+		context.pushAndSetShader(copyShader.get());
+		context.pushAndSetTexture(0, depthTexture);
+		context.pushAndSetBoundImage(0, target);
+		copyShader->setUniform(context, Uniform("depthTexture", 0));
+		context.dispatchCompute((width + 7) / 8, (height + 7) / 8);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		context.popBoundImage(0);
+		context.popTexture(0);
+		context.popShader();
+	}
+	// reduction
+	context.pushAndSetShader(reduceShader.get());
+	uint32_t levelWidth = width;
+	uint32_t levelHeight = height;
+	for(uint32_t level = 1; level < numLevels; ++level) {
+		levelWidth = std::max(1u, levelWidth / 2);
+		levelHeight = std::max(1u, levelHeight / 2);
+		ImageBindParameters source(pyramid.get());
+		source.setLevel(level - 1);
+		source.setWriteOperations(false);
+		ImageBindParameters target(pyramid.get());
+		target.setLevel(level);
+		target.setReadOperations(false);
+		context.pushAndSetBoundImage(0, source);
+		context.pushAndSetBoundImage(1, target);
+		context.dispatchCompute((levelWidth + 7) / 8, (levelHeight + 7) / 8);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		context.popBoundImage(1);
+		context.popBoundImage(0);
+	}
+	context.popShader();
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	GET_GL_ERROR();
+#else
+	WARN("HiZPyramid::update: Compute shaders are not supported.");
+#endif
+}
+
+void HiZPyramid::testBoxes(RenderingContext & context, const std::vector<Geometry::Box> & boxes) {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_image_load_store) && defined(GL_ARB_shader_storage_buffer_object)
+	if(pyramid.isNull() || boxes.empty())
+		return;
+	std::vector<float> boxData;
+	boxData.reserve(boxes.size() * 8);
+	for(const auto & box : boxes) {
+		boxData.insert(boxData.end(), {box.getMinX(), box.getMinY(), box.getMinZ(), 0.0f,
+									   box.getMaxX(), box.getMaxY(), box.getMaxZ(), 0.0f});
+	}
+	boxBuffer.uploadData(BufferObject::TARGET_SHADER_STORAGE_BUFFER, boxData, BufferObject::USAGE_STREAM_DRAW);
+	resultBuffer.allocateData<uint32_t>(BufferObject::TARGET_SHADER_STORAGE_BUFFER, boxes.size(), BufferObject::USAGE_STREAM_READ);
+	pendingResults = static_cast<uint32_t>(boxes.size());
+
+	context.pushAndSetShader(testShader.get());
+	context.pushAndSetTexture(0, pyramid.get());
+	testShader->setUniform(context, Uniform("pyramid", 0));
+	testShader->setUniform(context, Uniform("modelToClipping", context.getMatrix_cameraToClipping() * context.getMatrix_modelToCamera()));
+	testShader->setUniform(context, Uniform("boxCount", static_cast<int32_t>(boxes.size())));
+	testShader->setUniform(context, Uniform("numLevels", static_cast<int32_t>(numLevels)));
+	boxBuffer.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 0);
+	resultBuffer.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 1);
+	context.dispatchCompute((pendingResults + 63) / 64);
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	resultBuffer.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 1);
+	boxBuffer.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 0);
+	context.popTexture(0);
+	context.popShader();
+	GET_GL_ERROR();
+#else
+	WARN("HiZPyramid::testBoxes: Compute shaders are not supported.");
+#endif
+}
+
+bool HiZPyramid::fetchResults(std::vector<uint32_t> & visibility) {
+	if(pendingResults == 0)
+		return false;
+	visibility = resultBuffer.downloadData<uint32_t>(BufferObject::TARGET_SHADER_STORAGE_BUFFER, pendingResults);
+	pendingResults = 0;
+	return true;
+}
+
+}
@@ -0,0 +1,77 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_HIZPYRAMID_H_
+#define RENDERING_HIZPYRAMID_H_
+
+#include "BufferObject.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <vector>
+
+namespace Geometry {
+template<typename value_t> class _Box;
+typedef _Box<float> Box;
+}
+namespace Rendering {
+class RenderingContext;
+class Shader;
+class Texture;
+
+/**
+ * Hierarchical depth buffer (Hi-Z) for occlusion culling on the GPU without occlusion queries.
+ *
+ * update() copies a depth texture into level 0 of a single channel float texture and builds the
+ * mipmap chain with compute shaders, where each texel contains the farthest depth of the texels it covers.
+ * testBoxes() tests bounding boxes against the pyramid in a compute shader; the results are written into
+ * a buffer and can be fetched with fetchResults() in a later frame, so the CPU does not wait for the
+ * GPU. As this lags one frame behind, the boxes are commonly the nodes that were rendered (or tested) in the previous frame.
+ *
+ * @note Requires OpenGL 4.3 (compute shaders, image load/store and shader storage buffers).
+ */
+class HiZPyramid : public Util::ReferenceCounter<HiZPyramid> {
+	public:
+		static bool isSupported();
+
+		HiZPyramid();
+		~HiZPyramid();
+
+		/*! Build the pyramid from the given depth texture (e.g. the depth attachment of the last frame).
+			The pyramid is recreated if the size of the depth texture changed. */
+		void update(RenderingContext & context, Texture * depthTexture);
+
+		Texture * getTexture() const;
+		uint32_t getNumLevels() const									{	return numLevels;	}
+
+		/*! Test the boxes (in the coordinate system of the current modelview matrix) against the pyramid
+			using the current projection matrix. */
+		void testBoxes(RenderingContext & context, const std::vector<Geometry::Box> & boxes);
+
+		/*! Download the results of the last call of testBoxes(): one value per box, 0 for occluded boxes.
+			@return @c false if there are no results. */
+		bool fetchResults(std::vector<uint32_t> & visibility);
+
+	private:
+		Util::Reference<Texture> pyramid;
+		uint32_t numLevels;
+		Util::Reference<Shader> copyShader;
+		Util::Reference<Shader> reduceShader;
+		Util::Reference<Shader> testShader;
+		BufferObject boxBuffer;
+		BufferObject resultBuffer;
+		uint32_t pendingResults;
+
+		void initShaders();
+};
+
+}
+
+#endif /* RENDERING_HIZPYRAMID_H_ */
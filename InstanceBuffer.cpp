@@ -0,0 +1,139 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "InstanceBuffer.h"
+#include "StreamingBuffer.h"
+#include "Mesh/VertexAttribute.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Shader/Shader.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Util/Macros.h>
+#include <algorithm>
+#include <atomic>
+
+namespace Rendering {
+
+//! (internal) Return a new, globally unique layout key (0 is reserved for "no instance buffer").
+static uint32_t createLayoutKey() {
+	static std::atomic<uint32_t> counter(0);
+	return ++counter;
+}
+
+InstanceBuffer::InstanceBuffer(const VertexDescription & _description, uint32_t _instanceCount) :
+		ReferenceCounter_t(), description(_description), instanceCount(0), binaryData(), bufferObject(), bufferSize(0),
+		changedBegin(0), changedEnd(0), divisor(1), layoutKey(createLayoutKey()), streamingBuffer(), enabledLocations() {
+	allocate(_instanceCount);
+}
+
+InstanceBuffer::~InstanceBuffer() = default;
+
+void InstanceBuffer::allocate(uint32_t newInstanceCount) {
+	binaryData.resize(static_cast<size_t>(newInstanceCount) * description.getVertexSize());
+	instanceCount = newInstanceCount;
+	markAsChanged();
+}
+
+void InstanceBuffer::markAsChanged(uint32_t first, uint32_t count) {
+	const uint32_t end = std::min(instanceCount, first + count);
+	if(first >= end)
+		return;
+	if(hasChanged()) {
+		changedBegin = std::min(changedBegin, first);
+		changedEnd = std::max(changedEnd, end);
+	} else {
+		changedBegin = first;
+		changedEnd = end;
+	}
+}
+
+void InstanceBuffer::setStreamingBuffer(StreamingBuffer * buffer) {
+	streamingBuffer = buffer;
+}
+
+void InstanceBuffer::upload() {
+	if(binaryData.empty() || (!hasChanged() && bufferObject.isValid()))
+		return;
+	if(!bufferObject.isValid() || bufferSize != binaryData.size()) {
+		if(!bufferObject.isValid())
+			layoutKey = createLayoutKey();
+		bufferObject.uploadData(BufferObject::TARGET_ARRAY_BUFFER, binaryData.data(), binaryData.size(), BufferObject::USAGE_DYNAMIC_DRAW);
+		bufferSize = binaryData.size();
+	} else {
+		const size_t stride = description.getVertexSize();
+		const size_t offset = changedBegin * stride;
+		const size_t numBytes = (changedEnd - changedBegin) * stride;
+		StreamingBuffer::Range range;
+		if(streamingBuffer.isNotNull())
+			range = streamingBuffer->upload(binaryData.data() + offset, numBytes);
+		if(range.isValid()) {
+			bufferObject.copy(streamingBuffer->getBufferObject(), static_cast<uint32_t>(range.offset),
+								static_cast<uint32_t>(offset), static_cast<uint32_t>(numBytes));
+			RenderingContext::_getFrameCounters().bufferBytesUploaded += numBytes;
+		} else {
+			bufferObject.uploadSubData(BufferObject::TARGET_ARRAY_BUFFER, binaryData.data() + offset, numBytes, offset);
+		}
+	}
+	changedBegin = changedEnd = 0;
+}
+
+void InstanceBuffer::_enableAttributes(Shader & shader, bool recordLocations) {
+#if defined(LIB_GL) && defined(GL_VERSION_3_3)
+	bufferObject.bind(GL_ARRAY_BUFFER);
+	const GLsizei stride = description.getVertexSize();
+	for(const auto & attr : description.getAttributes()) {
+		if(attr.empty())
+			continue;
+		const GLint location = shader.getVertexAttributeLocation(attr.getNameId());
+		if(location == -1)
+			continue;
+		// Matrices occupy one location per column.
+		uint_fast8_t columns = 1;
+		uint_fast8_t rows = attr.getNumValues();
+		if(rows == 16 || rows == 9) {
+			columns = rows == 16 ? 4 : 3;
+			rows = columns;
+		} else if(rows > 4) {
+			WARN("InstanceBuffer: Unsupported number of values for attribute '" + attr.getName() + "'.");
+			continue;
+		}
+		const size_t columnSize = rows * attr.getDataSize() / attr.getNumValues();
+		for(uint_fast8_t c = 0; c < columns; ++c) {
+			const GLuint attribLocation = static_cast<GLuint>(location + c);
+			const uint8_t * offset = nullptr;
+			offset += attr.getOffset() + c * columnSize;
+			if(attr.getConvertToFloat()) {
+				glVertexAttribPointer(attribLocation, rows, attr.getDataType(), attr.getNormalize() ? GL_TRUE : GL_FALSE, stride, offset);
+			} else {
+				glVertexAttribIPointer(attribLocation, rows, attr.getDataType(), stride, offset);
+			}
+			glEnableVertexAttribArray(attribLocation);
+			glVertexAttribDivisor(attribLocation, divisor);
+			if(recordLocations)
+				enabledLocations.push_back(attribLocation);
+		}
+	}
+	GET_GL_ERROR();
+#else
+	WARN("Instancing is not supported.");
+#endif
+}
+
+void InstanceBuffer::_disableAttributes() {
+#if defined(LIB_GL) && defined(GL_VERSION_3_3)
+	for(const auto & location : enabledLocations) {
+		glDisableVertexAttribArray(location);
+		glVertexAttribDivisor(location, 0);
+	}
+#endif
+	enabledLocations.clear();
+}
+
+}
@@ -0,0 +1,112 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_INSTANCEBUFFER_H_
+#define RENDERING_INSTANCEBUFFER_H_
+
+#include "BufferObject.h"
+#include "Mesh/VertexDescription.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+class Shader;
+class StreamingBuffer;
+
+/**
+ * Per-instance attribute stream for instanced rendering (see drawInstances(RenderingContext&, Mesh*, InstanceBuffer&, uint32_t, uint32_t, uint32_t)).
+ *
+ * The layout of one instance is given by a VertexDescription. Each attribute is bound to the vertex attribute of the
+ * active shader with the same name and advances once per @a divisor instances. Attributes with 9 or 16 float values are
+ * bound as mat3 or mat4 (consecutive locations, one per column).
+ * \code
+ * VertexDescription desc;
+ * desc.appendFloatAttribute(Util::StringIdentifier("sg_InstanceMatrix"), 16);
+ * desc.appendColorRGBAByte();
+ * Util::Reference<InstanceBuffer> instances = new InstanceBuffer(desc, 100000);
+ * // ... fill instances->data()
+ * instances->markAsChanged();
+ * \endcode
+ *
+ * The data is kept in local memory. upload() (called automatically when drawing) re-allocates the buffer object
+ * if the number of instances has changed; otherwise, only the changed range (see markAsChanged(uint32_t,uint32_t))
+ * is transferred. If a streaming buffer is set, the range is written into the streaming buffer and copied on the GPU,
+ * so that the driver does not have to synchronize with draw calls still using the buffer object.
+ */
+class InstanceBuffer : public Util::ReferenceCounter<InstanceBuffer> {
+	public:
+		explicit InstanceBuffer(const VertexDescription & description, uint32_t instanceCount = 0);
+		~InstanceBuffer();
+
+		const VertexDescription & getVertexDescription() const	{	return description;	}
+		uint32_t getInstanceCount() const						{	return instanceCount;	}
+		size_t dataSize() const									{	return binaryData.size();	}
+
+		/*! Change the number of instances. The data of existing instances is preserved.
+			\note The buffer object is re-allocated with the next upload(). */
+		void allocate(uint32_t newInstanceCount);
+
+		uint8_t * data()										{	return binaryData.data();	}
+		const uint8_t * data() const							{	return binaryData.data();	}
+		uint8_t * operator[](uint32_t index)					{	return binaryData.data() + index * description.getVertexSize();	}
+		const uint8_t * operator[](uint32_t index) const		{	return binaryData.data() + index * description.getVertexSize();	}
+
+		//! Mark all instances as changed.
+		void markAsChanged()									{	markAsChanged(0, instanceCount);	}
+		//! Mark @p count instances beginning with @p first as changed. Ranges are merged.
+		void markAsChanged(uint32_t first, uint32_t count);
+		bool hasChanged() const									{	return changedEnd > changedBegin;	}
+
+		//! Number of instances to advance an attribute by (default: 1).
+		void setDivisor(uint32_t value)							{	divisor = value;	}
+		uint32_t getDivisor() const								{	return divisor;	}
+
+		/*! Use the given streaming buffer for partial updates (@c nullptr disables it).
+			\note The application has to call StreamingBuffer::nextFrame() once per frame. */
+		void setStreamingBuffer(StreamingBuffer * buffer);
+
+		/*! Transfer the changed data into the buffer object.
+			\note Has to be called from within the gl-thread. */
+		void upload();
+
+		BufferObject & getBufferObject()						{	return bufferObject;	}
+		const BufferObject & getBufferObject() const			{	return bufferObject;	}
+
+		/*! (internal) Number that changes whenever the buffer object is re-created; unique among all instance buffers.
+			Used as part of the vertex array object key (see VertexArrayObjectCache). */
+		uint32_t _getLayoutKey() const							{	return layoutKey;	}
+
+		/*! (internal) Set up the instance attributes for the given shader (including the divisor).
+			@param recordLocations if true, the locations are remembered for _disableAttributes();
+				the attributes of a vertex array object are not disabled explicitly.	*/
+		void _enableAttributes(Shader & shader, bool recordLocations);
+		//! (internal) Disable the attributes enabled by the last call to _enableAttributes() and reset their divisors.
+		void _disableAttributes();
+
+	private:
+		VertexDescription description;
+		uint32_t instanceCount;
+		std::vector<uint8_t> binaryData;
+		BufferObject bufferObject;
+		size_t bufferSize; //!< size of the buffer object's storage
+		uint32_t changedBegin;
+		uint32_t changedEnd;
+		uint32_t divisor;
+		uint32_t layoutKey;
+		Util::Reference<StreamingBuffer> streamingBuffer;
+		std::vector<uint32_t> enabledLocations;
+};
+
+}
+
+#endif /* RENDERING_INSTANCEBUFFER_H_ */
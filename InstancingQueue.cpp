@@ -0,0 +1,110 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "InstancingQueue.h"
+#include "Draw.h"
+#include "InstanceBuffer.h"
+#include "Mesh/Mesh.h"
+#include "MeshUtils/MeshRegistry.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Shader/Shader.h"
+
+namespace Rendering {
+
+const Util::StringIdentifier InstancingQueue::INSTANCE_MATRIX_ATTRIBUTE("sg_InstanceMatrix");
+
+InstancingQueue::InstancingQueue(MeshUtils::MeshRegistry * _registry, uint32_t _minInstanceCount) :
+		ReferenceCounter_t(), registry(_registry), minInstanceCount(_minInstanceCount),
+		instancedDrawCount(0), instanceCount(0), singleDrawCount(0) {
+	instanceDescription.appendFloatAttribute(INSTANCE_MATRIX_ATTRIBUTE, 16);
+}
+
+InstancingQueue::~InstancingQueue() = default;
+
+void InstancingQueue::add(Mesh * mesh, const Geometry::Matrix4x4 & modelMatrix) {
+	if(mesh == nullptr || mesh->empty())
+		return;
+	Mesh * unique = mesh;
+	if(registry.isNotNull()) {
+		// the content hash of a mesh is only calculated when the mesh is added for the first time
+		auto it = uniqueMeshes.find(mesh);
+		if(it == uniqueMeshes.end()) {
+			UniqueMesh entry;
+			entry.mesh = mesh;
+			entry.unique = registry->getUniqueMesh(mesh);
+			it = uniqueMeshes.emplace(mesh, entry).first;
+		}
+		it->second.used = true;
+		unique = it->second.unique;
+	}
+	Group & group = groups[unique];
+	if(group.mesh.isNull())
+		group.mesh = unique;
+	group.matrices.push_back(modelMatrix);
+}
+
+void InstancingQueue::draw(RenderingContext & context, Shader * instancingShader) {
+	instancedDrawCount = instanceCount = singleDrawCount = 0;
+	for(auto & entry : groups) {
+		Group & group = entry.second;
+		const uint32_t count = static_cast<uint32_t>(group.matrices.size());
+		if(count == 0)
+			continue;
+		if(instancingShader != nullptr && count >= minInstanceCount) {
+			if(group.instances.isNull())
+				group.instances = new InstanceBuffer(instanceDescription, count);
+			else if(group.instances->getInstanceCount() != count)
+				group.instances->allocate(count);
+			float * values = reinterpret_cast<float *>(group.instances->data());
+			for(const auto & matrix : group.matrices) {
+				// column-major
+				for(uint_fast8_t column = 0; column < 4; ++column) {
+					for(uint_fast8_t row = 0; row < 4; ++row)
+						*values++ = matrix.at(row, column);
+				}
+			}
+			group.instances->markAsChanged();
+			context.pushAndSetShader(instancingShader);
+			drawInstances(context, group.mesh.get(), *group.instances.get());
+			context.popShader();
+			++instancedDrawCount;
+			instanceCount += count;
+		} else {
+			for(const auto & matrix : group.matrices) {
+				context.pushMatrix_modelToCamera();
+				context.multMatrix_modelToCamera(matrix);
+				context.displayMesh(group.mesh.get());
+				context.popMatrix_modelToCamera();
+			}
+			singleDrawCount += count;
+		}
+	}
+}
+
+void InstancingQueue::clear() {
+	for(auto it = groups.begin(); it != groups.end();) {
+		if(it->second.matrices.empty()) { // not used since the last call
+			it = groups.erase(it);
+		} else {
+			it->second.matrices.clear();
+			++it;
+		}
+	}
+	for(auto it = uniqueMeshes.begin(); it != uniqueMeshes.end();) {
+		if(!it->second.used) {
+			it = uniqueMeshes.erase(it);
+		} else {
+			it->second.used = false;
+			++it;
+		}
+	}
+}
+
+}
@@ -0,0 +1,99 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_INSTANCINGQUEUE_H_
+#define RENDERING_INSTANCINGQUEUE_H_
+
+#include "Mesh/VertexDescription.h"
+#include <Geometry/Matrix4x4.h>
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <Util/StringIdentifier.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Rendering {
+class InstanceBuffer;
+class Mesh;
+class RenderingContext;
+class Shader;
+namespace MeshUtils {
+class MeshRegistry;
+}
+
+/**
+ * Queue of mesh draws that turns repeated meshes into instanced draw calls.
+ * The meshes added during a frame are grouped by identity; if a MeshUtils::MeshRegistry is given, meshes with
+ * identical content are grouped as well (e.g. the same bolt imported thousands of times). Groups with at least
+ * @a minInstanceCount draws are drawn with a single call of drawInstances() using the given instancing shader;
+ * the model matrices are passed as the per-instance mat4 attribute @a INSTANCE_MATRIX_ATTRIBUTE. Smaller groups are
+ * drawn one by one with the active shader.
+ * \code
+ * in mat4 sg_InstanceMatrix;
+ * ...
+ * gl_Position = sg_matrix_cameraToClipping * sg_matrix_modelToCamera * sg_InstanceMatrix * vec4(sg_Position, 1.0);
+ * \endcode
+ * The model matrices are relative to the model-to-camera matrix that is active when draw() is called.
+ * The instance buffers of the groups are kept between frames.
+ */
+class InstancingQueue : public Util::ReferenceCounter<InstancingQueue> {
+	public:
+		//! Name of the per-instance model matrix attribute ("sg_InstanceMatrix").
+		static const Util::StringIdentifier INSTANCE_MATRIX_ATTRIBUTE;
+
+		explicit InstancingQueue(MeshUtils::MeshRegistry * registry = nullptr, uint32_t minInstanceCount = 4);
+		~InstancingQueue();
+
+		void add(Mesh * mesh, const Geometry::Matrix4x4 & modelMatrix);
+
+		/*! Draw all queued meshes. @p instancingShader is used for the instanced groups; if it is @c nullptr,
+			all meshes are drawn one by one. The queue is not cleared.	*/
+		void draw(RenderingContext & context, Shader * instancingShader);
+
+		/*! Remove the queued draws (e.g. at the beginning of a frame). The instance buffers of the groups that have
+			been used since the last call are kept.	*/
+		void clear();
+
+		void setMinInstanceCount(uint32_t count)		{	minInstanceCount = count;	}
+		uint32_t getMinInstanceCount()const				{	return minInstanceCount;	}
+
+		//! Number of instanced draw calls issued by the last draw().
+		uint32_t getInstancedDrawCount()const			{	return instancedDrawCount;	}
+		//! Number of meshes drawn by the instanced draw calls of the last draw().
+		uint32_t getInstanceCount()const				{	return instanceCount;	}
+		//! Number of meshes drawn one by one by the last draw().
+		uint32_t getSingleDrawCount()const				{	return singleDrawCount;	}
+
+	private:
+		struct Group {
+			Util::Reference<Mesh> mesh;
+			std::vector<Geometry::Matrix4x4> matrices;
+			Util::Reference<InstanceBuffer> instances;
+		};
+		std::unordered_map<Mesh *, Group> groups;
+		struct UniqueMesh {
+			Util::Reference<Mesh> mesh;	//!< keeps the address from being reused while the entry exists
+			Mesh * unique;
+			bool used;
+		};
+		//! Unique meshes of the meshes added since the second last call of clear() (only used with a registry)
+		std::unordered_map<Mesh *, UniqueMesh> uniqueMeshes;
+		Util::Reference<MeshUtils::MeshRegistry> registry;
+		VertexDescription instanceDescription;
+		uint32_t minInstanceCount;
+		uint32_t instancedDrawCount;
+		uint32_t instanceCount;
+		uint32_t singleDrawCount;
+};
+
+}
+
+#endif /* RENDERING_INSTANCINGQUEUE_H_ */
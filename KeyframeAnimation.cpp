@@ -0,0 +1,185 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "KeyframeAnimation.h"
+#include "Draw.h"
+#include "InstanceBuffer.h"
+#include "Mesh/Mesh.h"
+#include "Mesh/MeshIndexData.h"
+#include "Mesh/MeshVertexData.h"
+#include "Mesh/VertexAttributeAccessors.h"
+#include "Mesh/VertexAttributeIds.h"
+#include "Mesh/VertexDescription.h"
+#include "RenderingContext/RenderingContext.h"
+#include "RenderingContext/RenderingParameters.h"
+#include "Serialization/StreamerMD2.h"
+#include "Shader/Uniform.h"
+#include "Texture/Texture.h"
+#include "Texture/TextureUtils.h"
+#include <Geometry/Box.h>
+#include <Geometry/Vec3.h>
+#include <Util/GenericAttribute.h>
+#include <Util/TypeConstant.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace Rendering {
+
+static const Util::StringIdentifier INSTANCE_POSE_ATTRIBUTE("sg_InstanceKeyframePose");
+
+KeyframeAnimation::KeyframeAnimation(const std::vector<MeshVertexData> & frames, const MeshIndexData & indexData) :
+		ReferenceCounter_t(), mesh(), frameTexture(), frameCount(static_cast<uint32_t>(frames.size())), vertexCount(0),
+		animations(), activeTextureUnit(0) {
+	if(frames.empty())
+		throw std::invalid_argument("KeyframeAnimation: No frames given.");
+	const VertexDescription & description = frames.front().getVertexDescription();
+	vertexCount = frames.front().getVertexCount();
+	if(!description.hasAttribute(VertexAttributeIds::POSITION) || vertexCount == 0)
+		throw std::invalid_argument("KeyframeAnimation: The frames contain no positions.");
+	const bool hasNormals = description.hasAttribute(VertexAttributeIds::NORMAL);
+
+	// Two texels per vertex and frame: position and normal.
+	frameTexture = TextureUtils::createDataTexture(TextureType::TEXTURE_BUFFER, 2 * vertexCount * frameCount, 1, 1, Util::TypeConstant::FLOAT, 4);
+	frameTexture->allocateLocalData();
+	float * texels = reinterpret_cast<float *>(frameTexture->getLocalData());
+	Geometry::Box bounds = frames.front().getBoundingBox();
+	for(const auto & frame : frames) {
+		if(frame.getVertexCount() != vertexCount || !(frame.getVertexDescription() == description))
+			throw std::invalid_argument("KeyframeAnimation: The frames do not match.");
+		bounds.include(frame.getBoundingBox());
+		MeshVertexData & vData = const_cast<MeshVertexData &>(frame);
+		Util::Reference<PositionAttributeAccessor> positions = PositionAttributeAccessor::create(vData, VertexAttributeIds::POSITION);
+		Util::Reference<NormalAttributeAccessor> normals;
+		if(hasNormals)
+			normals = NormalAttributeAccessor::create(vData, VertexAttributeIds::NORMAL);
+		for(uint32_t v = 0; v < vertexCount; ++v) {
+			const Geometry::Vec3 p = positions->getPosition(v);
+			*texels++ = p.getX();
+			*texels++ = p.getY();
+			*texels++ = p.getZ();
+			*texels++ = 1.0f;
+			const Geometry::Vec3 n = hasNormals ? normals->getNormal(v) : Geometry::Vec3(0.0f, 0.0f, 1.0f);
+			*texels++ = n.getX();
+			*texels++ = n.getY();
+			*texels++ = n.getZ();
+			*texels++ = 0.0f;
+		}
+	}
+	frameTexture->dataChanged();
+
+	MeshIndexData iData(indexData);
+	MeshVertexData vData(frames.front());
+	// The mesh is drawn with the animated positions; culling has to consider all frames.
+	vData._setBoundingBox(bounds);
+	mesh = new Mesh(std::move(iData), std::move(vData));
+}
+
+KeyframeAnimation::~KeyframeAnimation() = default;
+
+//! (static)
+KeyframeAnimation * KeyframeAnimation::createFromMD2Description(const Util::GenericAttributeMap & description) {
+	auto frames = dynamic_cast<StreamerMD2::framesDataWrapper *>(description.getValue(StreamerMD2::DESCRIPTION_KEYFRAMES_DATA));
+	auto indexData = dynamic_cast<StreamerMD2::indexDataWrapper *>(description.getValue(StreamerMD2::DESCRIPTION_MESH_INDEX_DATA));
+	if(frames == nullptr || indexData == nullptr || frames->ref().empty())
+		return nullptr;
+	auto animation = new KeyframeAnimation(frames->ref(), indexData->ref());
+	auto animationData = dynamic_cast<StreamerMD2::animationDataWrapper *>(description.getValue(StreamerMD2::DESCRIPTION_ANIMATIONS));
+	if(animationData != nullptr)
+		animation->setAnimations(animationData->ref());
+	return animation;
+}
+
+//! (static)
+const std::string & KeyframeAnimation::getShaderCode() {
+	static const std::string code =
+		"uniform samplerBuffer sg_keyframes;\n"
+		"uniform int sg_keyframeVertexCount;\n"
+		"#ifdef SG_KEYFRAME_INSTANCED\n"
+		"in vec3 sg_InstanceKeyframePose;\n"
+		"#else\n"
+		"uniform vec3 sg_keyframePose;\n"
+		"#endif\n"
+		"void sg_getKeyframeVertex(out vec3 position, out vec3 normal) {\n"
+		"#ifdef SG_KEYFRAME_INSTANCED\n"
+		"	vec3 pose = sg_InstanceKeyframePose;\n"
+		"#else\n"
+		"	vec3 pose = sg_keyframePose;\n"
+		"#endif\n"
+		"	int a = (int(pose.x) * sg_keyframeVertexCount + gl_VertexID) * 2;\n"
+		"	int b = (int(pose.y) * sg_keyframeVertexCount + gl_VertexID) * 2;\n"
+		"	position = mix(texelFetch(sg_keyframes, a).xyz, texelFetch(sg_keyframes, b).xyz, pose.z);\n"
+		"	normal = normalize(mix(texelFetch(sg_keyframes, a + 1).xyz, texelFetch(sg_keyframes, b + 1).xyz, pose.z));\n"
+		"}\n";
+	return code;
+}
+
+Mesh * KeyframeAnimation::getMesh() const {
+	return mesh.get();
+}
+
+Texture * KeyframeAnimation::getFrameTexture() const {
+	return frameTexture.get();
+}
+
+KeyframeAnimation::Pose KeyframeAnimation::getPose(const std::string & animationName, float time, bool loop) const {
+	const auto it = animations.find(animationName);
+	if(it == animations.end() || it->second.size() < 3)
+		return Pose();
+	const uint32_t first = static_cast<uint32_t>(std::max(0, it->second[0]));
+	const uint32_t last = std::min(static_cast<uint32_t>(std::max(it->second[0], it->second[1])), frameCount - 1);
+	const uint32_t length = last - first + 1;
+	const float frame = std::max(0.0f, time) * static_cast<float>(it->second[2]);
+	const uint32_t step = static_cast<uint32_t>(frame);
+	const float blend = frame - std::floor(frame);
+	if(!loop && step + 1 >= length)
+		return Pose(last, last, 0.0f);
+	return Pose(first + step % length, first + (step + 1) % length, blend);
+}
+
+void KeyframeAnimation::bindTexture(RenderingContext & context, uint8_t textureUnit) {
+	activeTextureUnit = textureUnit;
+	context.pushAndSetTexture(textureUnit, frameTexture.get(), TexUnitUsageParameter::GENERAL_PURPOSE);
+	context.setGlobalUniform(Uniform("sg_keyframes", static_cast<int32_t>(textureUnit)));
+	context.setGlobalUniform(Uniform("sg_keyframeVertexCount", static_cast<int32_t>(vertexCount)));
+}
+
+void KeyframeAnimation::enable(RenderingContext & context, const Pose & pose, uint8_t textureUnit) {
+	bindTexture(context, textureUnit);
+	context.setGlobalUniform(Uniform("sg_keyframePose", Geometry::Vec3(static_cast<float>(pose.frameA), static_cast<float>(pose.frameB), pose.blend)));
+}
+
+void KeyframeAnimation::disable(RenderingContext & context) {
+	context.popTexture(activeTextureUnit);
+}
+
+//! (static)
+InstanceBuffer * KeyframeAnimation::createPoseBuffer(uint32_t instanceCount) {
+	VertexDescription description;
+	description.appendFloatAttribute(INSTANCE_POSE_ATTRIBUTE, 3);
+	return new InstanceBuffer(description, instanceCount);
+}
+
+//! (static)
+void KeyframeAnimation::setInstancePose(InstanceBuffer & poses, uint32_t instance, const Pose & pose) {
+	float * values = reinterpret_cast<float *>(poses[instance]);
+	values[0] = static_cast<float>(pose.frameA);
+	values[1] = static_cast<float>(pose.frameB);
+	values[2] = pose.blend;
+	poses.markAsChanged(instance, 1);
+}
+
+void KeyframeAnimation::drawInstances(RenderingContext & context, InstanceBuffer & poses, uint32_t instanceCount, uint8_t textureUnit) {
+	bindTexture(context, textureUnit);
+	Rendering::drawInstances(context, mesh.get(), poses, 0, 0, instanceCount);
+	disable(context);
+}
+
+}
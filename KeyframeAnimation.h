@@ -0,0 +1,118 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_KEYFRAMEANIMATION_H_
+#define RENDERING_KEYFRAMEANIMATION_H_
+
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Util {
+class GenericAttributeMap;
+}
+namespace Rendering {
+class InstanceBuffer;
+class Mesh;
+class MeshIndexData;
+class MeshVertexData;
+class RenderingContext;
+class Texture;
+class VertexDescription;
+
+/**
+ * Keyframe (morph target) animation that is interpolated in the vertex shader.
+ *
+ * The positions and normals of all keyframes are packed into one RGBA32F buffer texture (two texels per vertex
+ * and frame). The mesh returned by getMesh() contains the remaining attributes (e.g. texture coordinates) and the
+ * first frame. A vertex shader obtains the animated vertex with the function declared by getShaderCode():
+ * \code
+ * // vertex shader
+ * #version 140
+ * // ... getShaderCode() ...
+ * void main() {
+ *	vec3 position, normal;
+ *	sg_getKeyframeVertex(position, normal);
+ *	// ...
+ * }
+ * \endcode
+ * The frames and the blend factor are set as global uniforms by enable(). For drawInstances(), each instance
+ * uses the pose stored in an InstanceBuffer (see createPoseBuffer()); the shader then has to define
+ * @c SG_KEYFRAME_INSTANCED before the code.
+ *
+ * @note Requires OpenGL 3.1 (buffer textures and gl_VertexID).
+ */
+class KeyframeAnimation : public Util::ReferenceCounter<KeyframeAnimation> {
+	public:
+		//! Frames and blend factor: the vertex is mix(frameA, frameB, blend).
+		struct Pose {
+			uint32_t frameA;
+			uint32_t frameB;
+			float blend;
+			Pose() : frameA(0), frameB(0), blend(0.0f) {}
+			Pose(uint32_t a, uint32_t b, float _blend) : frameA(a), frameB(b), blend(_blend) {}
+		};
+		//! Animation name -> [first frame, last frame, frames per second] (as stored by StreamerMD2)
+		typedef std::map<std::string, std::vector<int>> animations_t;
+
+		/*! Create the animation from the given keyframes and index data. All frames need the same vertex description
+			(containing at least a position) and the same number of vertices.
+			@throw std::invalid_argument if there are no frames or the frames do not match.	*/
+		KeyframeAnimation(const std::vector<MeshVertexData> & frames, const MeshIndexData & indexData);
+		~KeyframeAnimation();
+
+		/*! Create the animation from a description created by StreamerMD2::loadGeneric() (keyframes, index data and animations).
+			Returns @c nullptr if the description does not contain keyframes.	*/
+		static KeyframeAnimation * createFromMD2Description(const Util::GenericAttributeMap & description);
+
+		//! GLSL code declaring the uniforms and the function @c sg_getKeyframeVertex(out vec3 position, out vec3 normal).
+		static const std::string & getShaderCode();
+
+		uint32_t getFrameCount() const						{	return frameCount;	}
+		uint32_t getVertexCount() const						{	return vertexCount;	}
+		Mesh * getMesh() const;
+		Texture * getFrameTexture() const;
+
+		const animations_t & getAnimations() const			{	return animations;	}
+		void setAnimations(const animations_t & _animations)	{	animations = _animations;	}
+
+		/*! Pose of the given animation at @p time (in seconds). If @p loop is false, the last frame is held.
+			An unknown animation results in the first frame. */
+		Pose getPose(const std::string & animationName, float time, bool loop = true) const;
+
+		/*! Bind the frame texture to @p textureUnit and set the uniforms for the given pose.
+			Call disable() after the mesh has been drawn. */
+		void enable(RenderingContext & context, const Pose & pose, uint8_t textureUnit = 7);
+		void disable(RenderingContext & context);
+
+		//! Create an instance buffer storing one pose per instance (attribute @c sg_InstanceKeyframePose).
+		static InstanceBuffer * createPoseBuffer(uint32_t instanceCount);
+		static void setInstancePose(InstanceBuffer & poses, uint32_t instance, const Pose & pose);
+
+		//! Draw the mesh for each instance in @p poses with the instance's pose (all instances if @p instanceCount is 0).
+		void drawInstances(RenderingContext & context, InstanceBuffer & poses, uint32_t instanceCount = 0, uint8_t textureUnit = 7);
+
+	private:
+		Util::Reference<Mesh> mesh;
+		Util::Reference<Texture> frameTexture;
+		uint32_t frameCount;
+		uint32_t vertexCount;
+		animations_t animations;
+		uint8_t activeTextureUnit;
+
+		void bindTexture(RenderingContext & context, uint8_t textureUnit);
+};
+
+}
+
+#endif /* RENDERING_KEYFRAMEANIMATION_H_ */
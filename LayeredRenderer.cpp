@@ -0,0 +1,180 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "LayeredRenderer.h"
+#include "Draw.h"
+#include "Mesh/Mesh.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Shader/Uniform.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Vec3.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace Rendering {
+
+static const char * const shaderInterfaceVertexLayer =
+R"***(
+#extension GL_ARB_shader_viewport_layer_array : require
+layout(std140, binding = 2) uniform sg_LayerMatrices { mat4 sg_layerMatrices[32]; };
+uniform int sg_layerCount;
+
+//! Select the layer of the current instance and transform the world position into its clipping space.
+vec4 sg_layeredPosition(in vec4 worldPosition) {
+	const int layer = gl_InstanceID % sg_layerCount;
+	gl_Layer = layer;
+	return sg_layerMatrices[layer] * worldPosition;
+}
+)***";
+
+static const char * const shaderInterfaceGeometry =
+R"***(
+layout(std140, binding = 2) uniform sg_LayerMatrices { mat4 sg_layerMatrices[32]; };
+uniform int sg_layerCount;
+)***";
+
+static const char * const geometryShader =
+R"***(#version 430
+layout(triangles, invocations = 32) in;
+layout(triangle_strip, max_vertices = 3) out;
+layout(std140, binding = 2) uniform sg_LayerMatrices { mat4 sg_layerMatrices[32]; };
+uniform int sg_layerCount;
+
+void main() {
+	if(gl_InvocationID >= sg_layerCount)
+		return;
+	for(int i = 0; i < 3; ++i) {
+		gl_Layer = gl_InvocationID;
+		gl_Position = sg_layerMatrices[gl_InvocationID] * gl_in[i].gl_Position;
+		EmitVertex();
+	}
+	EndPrimitive();
+}
+)***";
+
+static const Uniform::UniformName UNIFORM_SG_LAYER_COUNT("sg_layerCount");
+
+//! (static)
+bool LayeredRenderer::isSupported(method_t method) {
+#if defined(LIB_GL) && defined(GL_ARB_uniform_buffer_object)
+	static const bool uboSupport = isExtensionSupported("GL_ARB_uniform_buffer_object");
+	if(!uboSupport)
+		return false;
+	if(method == VERTEX_SHADER_LAYER) {
+		static const bool support = isExtensionSupported("GL_ARB_shader_viewport_layer_array");
+		return support;
+	}
+	static const bool support = isExtensionSupported("GL_ARB_gpu_shader5"); // geometry shader invocations
+	return support;
+#else
+	return false;
+#endif
+}
+
+//! (static)
+LayeredRenderer::method_t LayeredRenderer::getPreferredMethod() {
+	return isSupported(VERTEX_SHADER_LAYER) ? VERTEX_SHADER_LAYER : GEOMETRY_SHADER_INSTANCING;
+}
+
+//! (static)
+const char * LayeredRenderer::getShaderInterface(method_t method) {
+	return method == VERTEX_SHADER_LAYER ? shaderInterfaceVertexLayer : shaderInterfaceGeometry;
+}
+
+//! (static)
+const char * LayeredRenderer::getGeometryShaderSource() {
+	return geometryShader;
+}
+
+//! (static)
+std::vector<Geometry::Matrix4x4> LayeredRenderer::createCubeMapMatrices(const Geometry::Vec3 & center, float zNear, float zFar) {
+	// viewing direction and up vector of the faces as defined by OpenGL
+	static const float faces[6][6] = {
+		{ 1.0f,  0.0f,  0.0f,	0.0f, -1.0f,  0.0f},
+		{-1.0f,  0.0f,  0.0f,	0.0f, -1.0f,  0.0f},
+		{ 0.0f,  1.0f,  0.0f,	0.0f,  0.0f,  1.0f},
+		{ 0.0f, -1.0f,  0.0f,	0.0f,  0.0f, -1.0f},
+		{ 0.0f,  0.0f,  1.0f,	0.0f, -1.0f,  0.0f},
+		{ 0.0f,  0.0f, -1.0f,	0.0f, -1.0f,  0.0f}
+	};
+	const Geometry::Matrix4x4 projection = Geometry::Matrix4x4::perspectiveProjection(-zNear, zNear, -zNear, zNear, zNear, zFar);
+	std::vector<Geometry::Matrix4x4> matrices;
+	for(const auto & face : faces) {
+		const Geometry::Vec3 dir(face[0], face[1], face[2]);
+		const Geometry::Vec3 up(face[3], face[4], face[5]);
+		const Geometry::Vec3 side = dir.cross(up);
+		const float view[16] = {	side.getX(), side.getY(), side.getZ(), -side.dot(center),
+									up.getX(), up.getY(), up.getZ(), -up.dot(center),
+									-dir.getX(), -dir.getY(), -dir.getZ(), dir.dot(center),
+									0.0f, 0.0f, 0.0f, 1.0f	};
+		matrices.push_back(projection * Geometry::Matrix4x4(view));
+	}
+	return matrices;
+}
+
+LayeredRenderer::LayeredRenderer(method_t _method) : ReferenceCounter_t(), method(_method), matricesChanged(true) {
+}
+
+LayeredRenderer::~LayeredRenderer() = default;
+
+void LayeredRenderer::setLayerMatrices(const std::vector<Geometry::Matrix4x4> & worldToClipping) {
+	if(worldToClipping.size() > MAX_LAYERS)
+		throw std::invalid_argument("LayeredRenderer::setLayerMatrices: Too many layers.");
+	matrixData.resize(worldToClipping.size() * 16);
+	for(size_t i = 0; i < worldToClipping.size(); ++i) {
+		const Geometry::Matrix4x4 transposed = worldToClipping[i].getTransposed();
+		std::copy(transposed.getData(), transposed.getData() + 16, matrixData.begin() + static_cast<std::ptrdiff_t>(i) * 16);
+	}
+	matricesChanged = true;
+}
+
+void LayeredRenderer::bind(RenderingContext & context) {
+#if defined(LIB_GL) && defined(GL_ARB_uniform_buffer_object)
+	if(!isSupported(method)) {
+		WARN("LayeredRenderer::bind: Layered rendering is not supported.");
+		return;
+	}
+	if(matricesChanged || !matrixBuffer.isValid()) {
+		std::vector<float> data(matrixData);
+		data.resize(MAX_LAYERS * 16, 0.0f); // the block always has MAX_LAYERS matrices
+		matrixBuffer.uploadData(BufferObject::TARGET_UNIFORM_BUFFER, data, BufferObject::USAGE_DYNAMIC_DRAW);
+		matricesChanged = false;
+	}
+	matrixBuffer.bind(BufferObject::TARGET_UNIFORM_BUFFER, MATRICES_BINDING);
+	context.setGlobalUniform(Uniform(UNIFORM_SG_LAYER_COUNT, static_cast<int32_t>(std::max(1u, getLayerCount()))));
+	GET_GL_ERROR();
+#else
+	WARN("LayeredRenderer::bind: Layered rendering is not supported.");
+#endif
+}
+
+void LayeredRenderer::unbind(RenderingContext & /*context*/) {
+	if(!matrixBuffer.isValid())
+		return;
+	matrixBuffer.unbind(BufferObject::TARGET_UNIFORM_BUFFER, MATRICES_BINDING);
+}
+
+void LayeredRenderer::display(RenderingContext & context, Mesh * mesh) {
+	if(mesh == nullptr || getLayerCount() == 0)
+		return;
+	bind(context);
+	if(method == VERTEX_SHADER_LAYER) {
+		const uint32_t count = mesh->isUsingIndexData() ? mesh->getIndexCount() : mesh->getVertexCount();
+		drawInstances(context, mesh, 0, count, getLayerCount());
+	} else {
+		context.displayMesh(mesh);
+	}
+	unbind(context);
+}
+
+}
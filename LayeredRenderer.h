@@ -0,0 +1,108 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_LAYEREDRENDERER_H_
+#define RENDERING_LAYEREDRENDERER_H_
+
+#include "BufferObject.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <vector>
+
+namespace Geometry {
+template<typename _T> class _Matrix4x4;
+typedef _Matrix4x4<float> Matrix4x4;
+template<typename _T> class _Vec3;
+typedef _Vec3<float> Vec3;
+}
+
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+
+/**
+ * Single-pass rendering into several layers of a layered framebuffer attachment (e.g. the six faces of a cube map
+ * or the cascades of a shadow map array attached with layer -1, see FBO::attachTexture()). Each mesh is submitted
+ * once; the primitives are broadcast to the layers by the GPU, each transformed by its own world-to-clipping matrix.
+ * The matrices are stored in a uniform buffer bound to MATRICES_BINDING.
+ *
+ * Two methods are available:
+ * - VERTEX_SHADER_LAYER: the mesh is drawn with one instance per layer, and the vertex shader writes gl_Layer
+ *   (GL_ARB_shader_viewport_layer_array). The shader includes getShaderInterface():
+ * \code
+ * // vertex shader
+ * #version 430
+ * // ... getShaderInterface(VERTEX_SHADER_LAYER) ...
+ * void main() {
+ *	vec4 worldPosition = sg_matrix_cameraToWorld * sg_matrix_modelToCamera * vec4(sg_Position, 1.0);
+ *	gl_Position = sg_layeredPosition(worldPosition); // sets gl_Layer
+ * }
+ * \endcode
+ * - GEOMETRY_SHADER_INSTANCING: the vertex shader writes the world position into gl_Position and the geometry shader
+ *   of getGeometryShaderSource() emits each triangle once per layer using geometry shader invocations.
+ * \code
+ * LayeredRenderer layered(LayeredRenderer::getPreferredMethod());
+ * layered.setLayerMatrices(LayeredRenderer::createCubeMapMatrices(lightPosition, 0.1f, 100.0f));
+ * context.pushAndSetFBO(cubeShadowFBO);
+ * layered.display(context, mesh);	// instead of six passes
+ * context.popFBO();
+ * \endcode
+ * @note At most MAX_LAYERS layers are supported.
+ */
+class LayeredRenderer : public Util::ReferenceCounter<LayeredRenderer> {
+	public:
+		static const uint32_t MATRICES_BINDING = 2;
+		static const uint32_t MAX_LAYERS = 32;
+
+		enum method_t {
+			VERTEX_SHADER_LAYER,
+			GEOMETRY_SHADER_INSTANCING
+		};
+
+		static bool isSupported(method_t method);
+		//! VERTEX_SHADER_LAYER if supported, otherwise GEOMETRY_SHADER_INSTANCING.
+		static method_t getPreferredMethod();
+
+		//! GLSL declarations (uniform block and the function sg_layeredPosition() for VERTEX_SHADER_LAYER).
+		static const char * getShaderInterface(method_t method);
+		/*! Complete geometry shader for GEOMETRY_SHADER_INSTANCING that broadcasts triangles whose world positions
+			are stored in gl_Position. Other outputs of the vertex shader are not passed through.	*/
+		static const char * getGeometryShaderSource();
+
+		/*! (static) The world-to-clipping matrices for the six faces of a cube map at @p center (in the order of the
+			cube map layers: +x, -x, +y, -y, +z, -z).	*/
+		static std::vector<Geometry::Matrix4x4> createCubeMapMatrices(const Geometry::Vec3 & center, float zNear, float zFar);
+
+		explicit LayeredRenderer(method_t method = VERTEX_SHADER_LAYER);
+		~LayeredRenderer();
+
+		method_t getMethod() const							{	return method;	}
+		uint32_t getLayerCount() const						{	return static_cast<uint32_t>(matrixData.size() / 16);	}
+		//! @throw std::invalid_argument if more than MAX_LAYERS matrices are given.
+		void setLayerMatrices(const std::vector<Geometry::Matrix4x4> & worldToClipping);
+
+		//! Upload the changed matrices, bind them and set the layer count uniform.
+		void bind(RenderingContext & context);
+		void unbind(RenderingContext & context);
+
+		//! Draw the mesh into all layers (bind(), one instanced draw or one draw, unbind()).
+		void display(RenderingContext & context, Mesh * mesh);
+
+	private:
+		const method_t method;
+		std::vector<float> matrixData; // column-major, as expected by std140
+		bool matricesChanged;
+		BufferObject matrixBuffer;
+};
+
+}
+
+#endif /* RENDERING_LAYEREDRENDERER_H_ */
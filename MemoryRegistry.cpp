@@ -0,0 +1,172 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MemoryRegistry.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace Rendering {
+
+namespace {
+
+struct Counter {
+	std::atomic<uint64_t> usage;
+	std::atomic<uint64_t> highWaterMark;
+};
+
+Counter counters[MemoryRegistry::NUM_CATEGORIES];
+Counter total;
+
+void addToCounter(Counter & counter, int64_t delta) {
+	if(delta < 0) {
+		counter.usage -= static_cast<uint64_t>(-delta);
+		return;
+	}
+	const uint64_t newUsage = (counter.usage += static_cast<uint64_t>(delta));
+	uint64_t mark = counter.highWaterMark.load();
+	while(mark < newUsage && !counter.highWaterMark.compare_exchange_weak(mark, newUsage)) {
+	}
+}
+
+struct StrategyUsage {
+	uint64_t usage;
+	uint64_t highWaterMark;
+};
+
+std::mutex strategyMutex;
+std::unordered_map<const MeshDataStrategy *, StrategyUsage> strategyUsages;
+
+}
+
+//! (static)
+const char * MemoryRegistry::getCategoryName(category_t category) {
+	switch(category) {
+		case VERTEX_BUFFER:		return "vertex buffer";
+		case INDEX_BUFFER:		return "index buffer";
+		case TEXTURE:			return "texture";
+		case RENDER_TARGET:		return "render target";
+		case STREAMING_BUFFER:	return "streaming buffer";
+		case OTHER_BUFFER:		return "other buffer";
+		default:				return "unknown";
+	}
+}
+
+//! (static)
+void MemoryRegistry::add(category_t category, int64_t deltaBytes) {
+	if(deltaBytes == 0 || category >= NUM_CATEGORIES)
+		return;
+	addToCounter(counters[category], deltaBytes);
+	addToCounter(total, deltaBytes);
+}
+
+//! (static)
+void MemoryRegistry::move(category_t from, category_t to, uint64_t bytes) {
+	if(from == to || bytes == 0 || from >= NUM_CATEGORIES || to >= NUM_CATEGORIES)
+		return;
+	addToCounter(counters[from], -static_cast<int64_t>(bytes));
+	addToCounter(counters[to], static_cast<int64_t>(bytes));
+}
+
+//! (static)
+uint64_t MemoryRegistry::getUsage(category_t category) {
+	return category < NUM_CATEGORIES ? counters[category].usage.load() : 0;
+}
+
+//! (static)
+uint64_t MemoryRegistry::getHighWaterMark(category_t category) {
+	return category < NUM_CATEGORIES ? counters[category].highWaterMark.load() : 0;
+}
+
+//! (static)
+uint64_t MemoryRegistry::getTotalUsage() {
+	return total.usage.load();
+}
+
+//! (static)
+uint64_t MemoryRegistry::getTotalHighWaterMark() {
+	return total.highWaterMark.load();
+}
+
+//! (static)
+MemoryRegistry::Snapshot MemoryRegistry::getSnapshot() {
+	Snapshot snapshot;
+	for(uint_fast8_t i = 0; i < NUM_CATEGORIES; ++i) {
+		snapshot.usage[i] = counters[i].usage.load();
+		snapshot.highWaterMarks[i] = counters[i].highWaterMark.load();
+	}
+	snapshot.totalUsage = total.usage.load();
+	snapshot.totalHighWaterMark = total.highWaterMark.load();
+	return snapshot;
+}
+
+//! (static)
+void MemoryRegistry::resetHighWaterMarks() {
+	for(auto & counter : counters)
+		counter.highWaterMark = counter.usage.load();
+	total.highWaterMark = total.usage.load();
+	std::lock_guard<std::mutex> lock(strategyMutex);
+	for(auto & entry : strategyUsages)
+		entry.second.highWaterMark = entry.second.usage;
+}
+
+//! (static)
+void MemoryRegistry::addStrategyUsage(const MeshDataStrategy * strategy, int64_t deltaBytes) {
+	if(deltaBytes == 0)
+		return;
+	std::lock_guard<std::mutex> lock(strategyMutex);
+	StrategyUsage & entry = strategyUsages[strategy];
+	if(deltaBytes < 0) {
+		entry.usage -= std::min(entry.usage, static_cast<uint64_t>(-deltaBytes));
+	} else {
+		entry.usage += static_cast<uint64_t>(deltaBytes);
+		entry.highWaterMark = std::max(entry.highWaterMark, entry.usage);
+	}
+}
+
+void MemoryRegistry::StrategyAccount::update(const MeshDataStrategy * newStrategy, uint64_t newBytes) {
+	if(newStrategy == strategy && newBytes == bytes)
+		return;
+	if(strategy != nullptr && bytes > 0)
+		addStrategyUsage(strategy, -static_cast<int64_t>(bytes));
+	strategy = newStrategy;
+	bytes = newStrategy == nullptr ? 0 : newBytes;
+	if(bytes > 0)
+		addStrategyUsage(strategy, static_cast<int64_t>(bytes));
+}
+
+//! (static)
+uint64_t MemoryRegistry::getStrategyUsage(const MeshDataStrategy * strategy) {
+	std::lock_guard<std::mutex> lock(strategyMutex);
+	const auto it = strategyUsages.find(strategy);
+	return it == strategyUsages.end() ? 0 : it->second.usage;
+}
+
+//! (static)
+uint64_t MemoryRegistry::getStrategyHighWaterMark(const MeshDataStrategy * strategy) {
+	std::lock_guard<std::mutex> lock(strategyMutex);
+	const auto it = strategyUsages.find(strategy);
+	return it == strategyUsages.end() ? 0 : it->second.highWaterMark;
+}
+
+//! (static)
+std::vector<std::pair<const MeshDataStrategy *, uint64_t>> MemoryRegistry::getStrategyUsages() {
+	std::lock_guard<std::mutex> lock(strategyMutex);
+	std::vector<std::pair<const MeshDataStrategy *, uint64_t>> result;
+	result.reserve(strategyUsages.size());
+	for(const auto & entry : strategyUsages) {
+		if(entry.second.usage > 0)
+			result.emplace_back(entry.first, entry.second.usage);
+	}
+	return result;
+}
+
+}
@@ -0,0 +1,112 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MEMORYREGISTRY_H_
+#define RENDERING_MEMORYREGISTRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Rendering {
+class MeshDataStrategy;
+
+/**
+ * Global accounting of the graphics memory allocated by the library.
+ *
+ * The totals are updated whenever a BufferObject allocates or releases its storage and whenever a Texture
+ * allocates or releases its gl texture. Every buffer object and texture belongs to one category: buffers of
+ * MeshVertexData are counted as VERTEX_BUFFER, buffers of MeshIndexData as INDEX_BUFFER, the persistently
+ * mapped buffers of StreamingBuffer as STREAMING_BUFFER and textures that have been attached to an FBO as
+ * RENDER_TARGET. In addition, the graphics memory of the meshes is summed up per MeshDataStrategy
+ * (updated when a mesh is displayed, when its buffers are evicted by a BudgetedMeshDataStrategy and when it is deleted).
+ *
+ * For every category, the high-water mark (the maximum since the last resetHighWaterMarks()) is recorded.
+ * Taking a snapshot and resetting the high-water marks once per frame yields the peaks of every frame:
+ * \code
+ * const MemoryRegistry::Snapshot snapshot = MemoryRegistry::getSnapshot();
+ * MemoryRegistry::resetHighWaterMarks();
+ * \endcode
+ * @note All functions are thread safe. The totals are estimates based on the requested sizes; drivers may
+ *   allocate more memory (e.g. for alignment or mipmaps of textures allocated by glTexImage).
+ * @note Meshes sharing a buffer (see Mesh::clone()) are counted once per category, but for each mesh in the
+ *   totals per data strategy.
+ */
+class MemoryRegistry {
+	public:
+		enum category_t : uint8_t {
+			VERTEX_BUFFER,
+			INDEX_BUFFER,
+			TEXTURE,
+			RENDER_TARGET,
+			STREAMING_BUFFER,
+			OTHER_BUFFER,
+			NUM_CATEGORIES
+		};
+
+		struct Snapshot {
+			uint64_t usage[NUM_CATEGORIES];
+			uint64_t highWaterMarks[NUM_CATEGORIES];
+			uint64_t totalUsage;
+			uint64_t totalHighWaterMark;
+		};
+
+		//! (static) Name of the category (e.g. "vertex buffer").
+		static const char * getCategoryName(category_t category);
+
+		//! (static) Change the usage of the given category by @p deltaBytes.
+		static void add(category_t category, int64_t deltaBytes);
+		//! (static) Move @p bytes from one category to another.
+		static void move(category_t from, category_t to, uint64_t bytes);
+
+		static uint64_t getUsage(category_t category);
+		static uint64_t getHighWaterMark(category_t category);
+		//! (static) Sum of all categories.
+		static uint64_t getTotalUsage();
+		static uint64_t getTotalHighWaterMark();
+		static Snapshot getSnapshot();
+
+		//! (static) Set the high-water marks to the current usage.
+		static void resetHighWaterMarks();
+
+		//! @name Usage per MeshDataStrategy
+		//	@{
+		//! (static, internal) Change the graphics memory accounted for the meshes using @p strategy.
+		static void addStrategyUsage(const MeshDataStrategy * strategy, int64_t deltaBytes);
+		static uint64_t getStrategyUsage(const MeshDataStrategy * strategy);
+		static uint64_t getStrategyHighWaterMark(const MeshDataStrategy * strategy);
+		//! (static) All strategies with accounted memory and their current usage.
+		static std::vector<std::pair<const MeshDataStrategy *, uint64_t>> getStrategyUsages();
+
+		/*! (internal) The memory an object (e.g. a Mesh) has accounted for a data strategy.
+			The accounted memory is released on destruction; a copy starts with nothing accounted. */
+		class StrategyAccount {
+				const MeshDataStrategy * strategy;
+				uint64_t bytes;
+			public:
+				StrategyAccount() : strategy(nullptr), bytes(0) {}
+				StrategyAccount(const StrategyAccount &) : strategy(nullptr), bytes(0) {}
+				StrategyAccount & operator=(const StrategyAccount &) = delete;
+				~StrategyAccount()	{	update(nullptr, 0);	}
+
+				//! Account @p newBytes for @p newStrategy instead of the previously accounted memory.
+				void update(const MeshDataStrategy * newStrategy, uint64_t newBytes);
+				uint64_t getBytes()const	{	return bytes;	}
+		};
+		//	@}
+
+	private:
+		MemoryRegistry() = delete;
+};
+
+}
+
+#endif /* RENDERING_MEMORYREGISTRY_H_ */
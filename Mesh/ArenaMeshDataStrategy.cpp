@@ -0,0 +1,58 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ArenaMeshDataStrategy.h"
+#include "Mesh.h"
+#include "MeshIndexData.h"
+#include "MeshVertexData.h"
+#include "../BufferArena.h"
+#include "../MemoryRegistry.h"
+
+namespace Rendering {
+
+//! (ctor)
+ArenaMeshDataStrategy::ArenaMeshDataStrategy(size_t vertexCapacity, size_t indexCapacity, bool preserveLocalData) :
+		SimpleMeshDataStrategy(USE_VBOS | (preserveLocalData ? PRESERVE_LOCAL_DATA : 0)),
+		vertexArena(new BufferArena(vertexCapacity)), indexArena(new BufferArena(indexCapacity)) {
+	vertexArena->getBufferObject().setMemoryCategory(MemoryRegistry::VERTEX_BUFFER);
+	indexArena->getBufferObject().setMemoryCategory(MemoryRegistry::INDEX_BUFFER);
+}
+
+//! (dtor)
+ArenaMeshDataStrategy::~ArenaMeshDataStrategy() = default;
+
+size_t ArenaMeshDataStrategy::compact(size_t maxBytes) {
+	return vertexArena->compact(maxBytes) + indexArena->compact(maxBytes);
+}
+
+//! ---|> MeshDataStrategy
+void ArenaMeshDataStrategy::prepare(Mesh * m) {
+	MeshIndexData & id = m->_getIndexData();
+	if( id.empty() && (id.isUploaded() || id.isInArena()) ){ // data has been removed
+		id.removeGlBuffer();
+	} else if( !id.empty() && id.hasLocalData() && (id.hasChanged() || !id.isInArena()) ){ // data has changed or is new
+		if(!id.upload(*indexArena))
+			id.upload();
+	}
+	if(!getFlag(PRESERVE_LOCAL_DATA) && (id.isUploaded() || id.isInArena()) && id.hasLocalData())
+		id.releaseLocalData();
+
+	MeshVertexData & vd = m->_getVertexData();
+	if( vd.empty() && (vd.isUploaded() || vd.isStreamed() || vd.isInArena()) ){ // data has been removed
+		vd.removeGlBuffer();
+	} else if( !vd.empty() && vd.hasLocalData() && (vd.hasChanged() || !vd.isInArena()) ){ // data has changed or is new
+		if(!vd.upload(*vertexArena))
+			vd.upload();
+	}
+	if(!getFlag(PRESERVE_LOCAL_DATA) && (vd.isUploaded() || vd.isInArena()) && vd.hasLocalData())
+		vd.releaseLocalData();
+}
+
+}
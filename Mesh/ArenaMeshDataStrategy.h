@@ -0,0 +1,50 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_ARENAMESHDATASTRATEGY_H_
+#define RENDERING_ARENAMESHDATASTRATEGY_H_
+
+#include "MeshDataStrategy.h"
+#include <Util/References.h>
+#include <cstddef>
+
+namespace Rendering {
+
+class BufferArena;
+
+/*!	ArenaMeshDataStrategy ---|> SimpleMeshDataStrategy ---|> MeshDataStrategy
+	Stores the vertex and index data of all meshes using this strategy in two shared BufferArenas
+	instead of creating two buffer objects per mesh. This reduces the number of buffer objects (and the
+	driver overhead) for scenes with many small meshes considerably.
+	A local copy of the data is released after uploading unless @a preserveLocalData is set.
+	\note Call compact() regularly (e.g. once per frame with a small limit) to reduce the fragmentation of the arenas. */
+class ArenaMeshDataStrategy : public SimpleMeshDataStrategy {
+	public:
+		/*! @param vertexCapacity Initial size in bytes of the vertex arena
+			@param indexCapacity Initial size in bytes of the index arena	*/
+		ArenaMeshDataStrategy(size_t vertexCapacity, size_t indexCapacity, bool preserveLocalData = false);
+		virtual ~ArenaMeshDataStrategy();
+
+		BufferArena & getVertexArena()					{	return *vertexArena;	}
+		BufferArena & getIndexArena()					{	return *indexArena;	}
+
+		//! Move up to @p maxBytes of data in each arena to reduce the fragmentation. Returns the number of moved bytes.
+		size_t compact(size_t maxBytes);
+
+		void prepare(Mesh * m) override;
+
+	private:
+		Util::Reference<BufferArena> vertexArena;
+		Util::Reference<BufferArena> indexArena;
+};
+
+}
+
+#endif /* RENDERING_ARENAMESHDATASTRATEGY_H_ */
@@ -0,0 +1,149 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "BudgetedMeshDataStrategy.h"
+#include "Mesh.h"
+#include "MeshIndexData.h"
+#include "MeshVertexData.h"
+#include "../Serialization/MeshSwapFile.h"
+#include <iterator>
+
+namespace Rendering {
+
+//! (ctor)
+BudgetedMeshDataStrategy::BudgetedMeshDataStrategy(size_t budgetInBytes) :
+		SimpleMeshDataStrategy(USE_VBOS | PRESERVE_LOCAL_DATA), budget(budgetInBytes), usedMemory(0) {
+}
+
+//! (dtor)
+BudgetedMeshDataStrategy::~BudgetedMeshDataStrategy() {
+	lru.clear();
+	entries.clear();
+}
+
+void BudgetedMeshDataStrategy::setSwapFile(Serialization::MeshSwapFile * file) {
+	swapFile = file;
+}
+
+//! (internal) Page in the data of a mesh that has neither local data nor buffer objects.
+static bool pageIn(Mesh * mesh, bool uploadDirectly) {
+	const MeshVertexData & vd = mesh->_getVertexData();
+	const MeshIndexData & id = mesh->_getIndexData();
+	const bool vertexDataMissing = !vd.empty() && !vd.hasLocalData() && !vd.isUploaded();
+	const bool indexDataMissing = !id.empty() && !id.hasLocalData() && !id.isUploaded();
+	if(!vertexDataMissing && !indexDataMissing)
+		return false;
+	// the file of the record is used, so a mesh can still be paged in after the swap file of the strategy has been changed
+	Serialization::MeshSwapFile * file = Serialization::MeshSwapFile::getSwapFile(mesh);
+	return file != nullptr && file->pageIn(mesh, uploadDirectly);
+}
+
+void BudgetedMeshDataStrategy::setBudget(size_t budgetInBytes) {
+	budget = budgetInBytes;
+	enforceBudget(nullptr);
+}
+
+void BudgetedMeshDataStrategy::releaseUnusedMeshes() {
+	for(auto it = lru.begin(); it != lru.end();) {
+		auto current = it++;
+		if(current->mesh->countReferences() == 1)
+			evict(current);
+	}
+}
+
+void BudgetedMeshDataStrategy::evictAll() {
+	while(!lru.empty())
+		evict(std::prev(lru.end()));
+}
+
+//! (internal)
+void BudgetedMeshDataStrategy::evict(lru_t::iterator it) {
+	Mesh * mesh = it->mesh.get();
+	MeshVertexData & vd = mesh->_getVertexData();
+	MeshIndexData & id = mesh->_getIndexData();
+	if(swapFile.isNotNull() && swapFile->pageOut(mesh)) {
+		// the data is stored in the swap file -> neither the buffers nor the local data are needed
+		vd.removeGlBuffer();
+		vd.releaseLocalData();
+		id.removeGlBuffer();
+		id.releaseLocalData();
+	} else {
+		// Only remove the buffers if the data can be uploaded again.
+		if(vd.isUploaded() && (vd.hasLocalData() || vd.download()))
+			vd.removeGlBuffer();
+		if(id.isUploaded() && (id.hasLocalData() || id.download()))
+			id.removeGlBuffer();
+	}
+	mesh->_updateMemoryAccounting();
+
+	++statistics.evictions;
+	statistics.evictedBytes += it->size;
+	usedMemory -= it->size;
+	entries.erase(mesh);
+	lru.erase(it);
+}
+
+//! (internal)
+void BudgetedMeshDataStrategy::enforceBudget(const Mesh * keep) {
+	while(usedMemory > budget && !lru.empty()) {
+		auto victim = std::prev(lru.end());
+		if(victim->mesh.get() == keep) {
+			if(victim == lru.begin())
+				break;
+			--victim;
+		}
+		evict(victim);
+	}
+}
+
+//! ---|> MeshDataStrategy
+void BudgetedMeshDataStrategy::assureLocalVertexData(Mesh * m) {
+	if(pageIn(m, false))
+		++statistics.pageIns;
+	SimpleMeshDataStrategy::assureLocalVertexData(m);
+}
+
+//! ---|> MeshDataStrategy
+void BudgetedMeshDataStrategy::assureLocalIndexData(Mesh * m) {
+	if(pageIn(m, false))
+		++statistics.pageIns;
+	SimpleMeshDataStrategy::assureLocalIndexData(m);
+}
+
+//! ---|> MeshDataStrategy
+void BudgetedMeshDataStrategy::prepare(Mesh * m) {
+	const bool wasUploaded = m->_getVertexData().isUploaded();
+	if(pageIn(m, true))
+		++statistics.pageIns;
+	SimpleMeshDataStrategy::prepare(m);
+	const size_t size = m->getGraphicsMemoryUsage();
+
+	auto it = entries.find(m);
+	if(it != entries.end()) {
+		// move to the front and update the size (the data may have changed)
+		lru.splice(lru.begin(), lru, it->second);
+		usedMemory = usedMemory - it->second->size + size;
+		it->second->size = size;
+	} else if(size > 0) {
+		lru.push_front({m, size});
+		entries.emplace(m, lru.begin());
+		usedMemory += size;
+	}
+	if(size > 0) {
+		if(wasUploaded)
+			++statistics.hits;
+		else
+			++statistics.misses;
+	}
+	if(usedMemory > budget)
+		enforceBudget(m);
+}
+
+}
@@ -0,0 +1,96 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_BUDGETEDMESHDATASTRATEGY_H_
+#define RENDERING_BUDGETEDMESHDATASTRATEGY_H_
+
+#include "MeshDataStrategy.h"
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+namespace Rendering {
+namespace Serialization {
+class MeshSwapFile;
+}
+
+/*!	BudgetedMeshDataStrategy ---|> SimpleMeshDataStrategy ---|> MeshDataStrategy
+	Keeps the graphics memory used by the buffer objects of all meshes using this strategy below a budget.
+	If the budget is exceeded, the buffer objects of the least recently displayed meshes are removed; they
+	are uploaded again when the mesh is displayed the next time. For this, a local copy of the data is preserved.
+
+	\note The strategy holds a reference to every mesh with uploaded data. Meshes that are only referenced by
+		the strategy are released by releaseUnusedMeshes() and when they are evicted.
+	If a swap file is set (see setSwapFile()), the data of evicted meshes is paged out into the file and the local copy is released
+	as well; the data is paged in again when the mesh is displayed (uploaded directly from the mapped file) or opened.
+	The main memory is then only used by the data of the meshes within the budget.
+
+	\note A mesh that is larger than the whole budget is still uploaded when it is displayed. */
+class BudgetedMeshDataStrategy : public SimpleMeshDataStrategy {
+	public:
+		struct Statistics {
+			uint64_t hits;			//!< Displayed meshes whose data was already uploaded.
+			uint64_t misses;		//!< Displayed meshes whose data had to be uploaded.
+			uint64_t evictions;		//!< Meshes whose buffer objects were removed to meet the budget.
+			uint64_t evictedBytes;
+			uint64_t pageIns;		//!< Meshes whose data was read from the swap file.
+			Statistics() : hits(0), misses(0), evictions(0), evictedBytes(0), pageIns(0) {}
+		};
+
+		explicit BudgetedMeshDataStrategy(size_t budgetInBytes);
+		virtual ~BudgetedMeshDataStrategy();
+
+		size_t getBudget() const						{	return budget;	}
+		//! Set the budget; if the used memory exceeds the new budget, buffer objects are evicted immediately.
+		void setBudget(size_t budgetInBytes);
+		//! Graphics memory currently used by the meshes of this strategy.
+		size_t getUsedMemory() const					{	return usedMemory;	}
+		uint32_t getNumResidentMeshes() const			{	return static_cast<uint32_t>(entries.size());	}
+
+		const Statistics & getStatistics() const		{	return statistics;	}
+		void resetStatistics()							{	statistics = Statistics();	}
+
+		//! Remove the buffer objects of meshes that are no longer referenced outside of this strategy and release them.
+		void releaseUnusedMeshes();
+		//! Remove the buffer objects of all meshes.
+		void evictAll();
+
+		/*! Page the data of evicted meshes out into the given file (@c nullptr disables swapping).
+			Meshes that have already been paged out are still paged in from their file. */
+		void setSwapFile(Serialization::MeshSwapFile * file);
+		Serialization::MeshSwapFile * getSwapFile() const	{	return swapFile.get();	}
+
+		void assureLocalVertexData(Mesh * m) override;
+		void assureLocalIndexData(Mesh * m) override;
+		void prepare(Mesh * m) override;
+
+	private:
+		struct Entry {
+			Util::Reference<Mesh> mesh;
+			size_t size;
+		};
+		typedef std::list<Entry> lru_t;
+
+		size_t budget;
+		size_t usedMemory;
+		lru_t lru; //!< front = most recently displayed
+		std::unordered_map<Mesh *, lru_t::iterator> entries;
+		Statistics statistics;
+		Util::Reference<Serialization::MeshSwapFile> swapFile;
+
+		void evict(lru_t::iterator it);
+		void enforceBudget(const Mesh * keep);
+};
+
+}
+
+#endif /* RENDERING_BUDGETEDMESHDATASTRATEGY_H_ */
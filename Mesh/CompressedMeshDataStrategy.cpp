@@ -0,0 +1,358 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "CompressedMeshDataStrategy.h"
+#include "Mesh.h"
+#include "MeshIndexData.h"
+#include "MeshVertexData.h"
+#include "VertexDescription.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+namespace Rendering {
+namespace {
+
+//! (internal) Compressed copies of the vertex and index data of a mesh; the parts are shared by copies of the mesh.
+class CompressedLocalData : public MeshDerivedData {
+	public:
+		std::shared_ptr<const std::vector<uint8_t>> vertices;
+		uint64_t vertexRevision;
+		size_t vertexBytes;
+		std::shared_ptr<const std::vector<uint8_t>> indices;
+		uint64_t indexRevision;
+		uint32_t indexCount;
+
+		CompressedLocalData() : MeshDerivedData(), vertices(), vertexRevision(0), vertexBytes(0), indices(), indexRevision(0), indexCount(0) {}
+
+		bool isVertexDataValid(const MeshVertexData & vd) const {
+			return vertices && vertexRevision == vd.getRevision()
+					&& vertexBytes == static_cast<size_t>(vd.getVertexCount()) * vd.getVertexDescription().getVertexSize();
+		}
+		bool isIndexDataValid(const MeshIndexData & id) const {
+			return indices && indexRevision == id.getRevision() && indexCount == id.getIndexCount();
+		}
+};
+
+CompressedLocalData * getCompressedLocalData(Mesh * mesh) {
+	return mesh == nullptr ? nullptr : dynamic_cast<CompressedLocalData *>(mesh->_getCompressedLocalData());
+}
+
+//! (internal) Append @p value with seven bits per byte; the highest bit marks that more bytes follow.
+void writeVarInt(std::vector<uint8_t> & out, uint64_t value) {
+	while(value >= 0x80) {
+		out.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+bool readVarInt(const uint8_t * & cursor, const uint8_t * end, uint64_t & value) {
+	value = 0;
+	for(uint_fast8_t shift = 0; shift < 64 && cursor != end; shift += 7) {
+		const uint8_t byte = *cursor++;
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+}
+
+//! (static)
+CompressedMeshDataStrategy * CompressedMeshDataStrategy::getStaticDrawStrategy() {
+	static CompressedMeshDataStrategy strategy(USE_VBOS, 16);
+	return &strategy;
+}
+
+//! (ctor)
+CompressedMeshDataStrategy::CompressedMeshDataStrategy(uint8_t _flags, uint32_t _cacheSize) :
+		SimpleMeshDataStrategy(_flags | USE_VBOS | PRESERVE_LOCAL_DATA), cacheSize(std::max(_cacheSize, 1u)) {
+}
+
+//! (dtor)
+CompressedMeshDataStrategy::~CompressedMeshDataStrategy() {
+	cache.clear();
+}
+
+void CompressedMeshDataStrategy::setCacheSize(uint32_t newSize) {
+	std::lock_guard<std::mutex> lock(mutex);
+	// the most recently opened mesh always stays decompressed
+	cacheSize = std::max(newSize, 1u);
+	shrinkCache(cacheSize);
+}
+
+void CompressedMeshDataStrategy::clearCache() {
+	std::lock_guard<std::mutex> lock(mutex);
+	shrinkCache(0);
+}
+
+CompressedMeshDataStrategy::Statistics CompressedMeshDataStrategy::getStatistics() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+void CompressedMeshDataStrategy::resetStatistics() {
+	std::lock_guard<std::mutex> lock(mutex);
+	statistics = Statistics();
+}
+
+//! (static)
+size_t CompressedMeshDataStrategy::getCompressedSize(Mesh * m) {
+	const CompressedLocalData * data = getCompressedLocalData(m);
+	if(data == nullptr)
+		return 0;
+	return (data->vertices ? data->vertices->size() : 0) + (data->indices ? data->indices->size() : 0);
+}
+
+//! (internal) Move the mesh to the front of the cache. The caller has to hold the lock.
+void CompressedMeshDataStrategy::touch(Mesh * m) {
+	auto it = std::find_if(cache.begin(), cache.end(), [m](const Util::Reference<Mesh> & entry) { return entry.get() == m; });
+	if(it != cache.end())
+		cache.splice(cache.begin(), cache, it);
+	else
+		cache.emplace_front(m);
+	shrinkCache(cacheSize);
+}
+
+//! (internal) Release the local data of the least recently opened meshes. The caller has to hold the lock.
+void CompressedMeshDataStrategy::shrinkCache(size_t maxSize) {
+	while(cache.size() > maxSize) {
+		Mesh * mesh = cache.back().get();
+		// changed data is released after it has been uploaded and compressed (see prepare())
+		const CompressedLocalData * data = getCompressedLocalData(mesh);
+		MeshVertexData & vd = mesh->_getVertexData();
+		if(data != nullptr && data->isVertexDataValid(vd) && vd.isUploaded() && !vd.hasChanged())
+			vd.releaseLocalData();
+		MeshIndexData & id = mesh->_getIndexData();
+		if(data != nullptr && data->isIndexDataValid(id) && id.isUploaded() && !id.hasChanged())
+			id.releaseLocalData();
+		++statistics.cacheEvictions;
+		cache.pop_back();
+	}
+}
+
+//! ---|> MeshDataStrategy
+void CompressedMeshDataStrategy::assureLocalVertexData(Mesh * m) {
+	MeshVertexData & vd = m->_getVertexData();
+	const CompressedLocalData * data = getCompressedLocalData(m);
+	if(!vd.hasLocalData() && data != nullptr && data->isVertexDataValid(vd)) {
+		std::vector<uint8_t> vertices;
+		if(decompressVertices(*data->vertices, vd.getVertexDescription().getVertexSize(), data->vertexBytes, vertices)) {
+			vd._restoreLocalData(std::move(vertices));
+			std::lock_guard<std::mutex> lock(mutex);
+			++statistics.decompressions;
+		}
+	}
+	SimpleMeshDataStrategy::assureLocalVertexData(m);
+	if(vd.hasLocalData() && vd.isUploaded()) {
+		std::lock_guard<std::mutex> lock(mutex);
+		touch(m);
+	}
+}
+
+//! ---|> MeshDataStrategy
+void CompressedMeshDataStrategy::assureLocalIndexData(Mesh * m) {
+	MeshIndexData & id = m->_getIndexData();
+	const CompressedLocalData * data = getCompressedLocalData(m);
+	if(!id.hasLocalData() && data != nullptr && data->isIndexDataValid(id)) {
+		std::vector<uint32_t> indices;
+		if(decompressIndices(*data->indices, data->indexCount, indices)) {
+			id._restoreLocalData(std::move(indices));
+			std::lock_guard<std::mutex> lock(mutex);
+			++statistics.decompressions;
+		}
+	}
+	SimpleMeshDataStrategy::assureLocalIndexData(m);
+	if(id.hasLocalData() && id.isUploaded()) {
+		std::lock_guard<std::mutex> lock(mutex);
+		touch(m);
+	}
+}
+
+//! ---|> MeshDataStrategy
+void CompressedMeshDataStrategy::prepare(Mesh * m) {
+	SimpleMeshDataStrategy::prepare(m);
+	if(!m->isView())
+		updateCompressedData(m);
+}
+
+//! (internal)
+void CompressedMeshDataStrategy::updateCompressedData(Mesh * m) {
+	MeshVertexData & vd = m->_getVertexData();
+	MeshIndexData & id = m->_getIndexData();
+	const CompressedLocalData * oldData = getCompressedLocalData(m);
+	const bool vertexDataValid = oldData != nullptr && oldData->isVertexDataValid(vd);
+	const bool indexDataValid = oldData != nullptr && oldData->isIndexDataValid(id);
+	const bool compressVertexData = !vertexDataValid && vd.isUploaded() && vd.hasLocalData() && !vd.hasChanged();
+	const bool compressIndexData = !indexDataValid && id.isUploaded() && id.hasLocalData() && !id.hasChanged();
+	if(compressVertexData || compressIndexData) {
+		// the parts may be shared by copies of the mesh, so a new object is created
+		Util::Reference<CompressedLocalData> newData = new CompressedLocalData;
+		if(vertexDataValid) {
+			newData->vertices = oldData->vertices;
+			newData->vertexRevision = oldData->vertexRevision;
+			newData->vertexBytes = oldData->vertexBytes;
+		}
+		if(indexDataValid) {
+			newData->indices = oldData->indices;
+			newData->indexRevision = oldData->indexRevision;
+			newData->indexCount = oldData->indexCount;
+		}
+		uint64_t uncompressedBytes = 0;
+		uint64_t compressedBytes = 0;
+		uint32_t compressions = 0;
+		if(compressVertexData) {
+			newData->vertices = std::make_shared<const std::vector<uint8_t>>(compressVertices(vd.data(), vd.dataSize(), vd.getVertexDescription().getVertexSize()));
+			newData->vertexRevision = vd.getRevision();
+			newData->vertexBytes = vd.dataSize();
+			uncompressedBytes += vd.dataSize();
+			compressedBytes += newData->vertices->size();
+			++compressions;
+		}
+		if(compressIndexData) {
+			newData->indices = std::make_shared<const std::vector<uint8_t>>(compressIndices(id.data(), id.getIndexCount()));
+			newData->indexRevision = id.getRevision();
+			newData->indexCount = id.getIndexCount();
+			uncompressedBytes += id.dataSize();
+			compressedBytes += newData->indices->size();
+			++compressions;
+		}
+		m->_setCompressedLocalData(newData.get());
+
+		std::lock_guard<std::mutex> lock(mutex);
+		statistics.compressions += compressions;
+		statistics.uncompressedBytes += uncompressedBytes;
+		statistics.compressedBytes += compressedBytes;
+	}
+
+	// release the local data unless the mesh has been opened recently
+	const CompressedLocalData * data = getCompressedLocalData(m);
+	if(data == nullptr || (!vd.hasLocalData() && !id.hasLocalData()))
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(std::any_of(cache.begin(), cache.end(), [m](const Util::Reference<Mesh> & entry) { return entry.get() == m; }))
+			return;
+	}
+	if(vd.hasLocalData() && data->isVertexDataValid(vd) && vd.isUploaded() && !vd.hasChanged()) {
+		if(getFlag(DEBUG_OUTPUT))	std::cout << " ~vLD";
+		vd.releaseLocalData();
+	}
+	if(id.hasLocalData() && data->isIndexDataValid(id) && id.isUploaded() && !id.hasChanged()) {
+		if(getFlag(DEBUG_OUTPUT))	std::cout << " ~idxLD";
+		id.releaseLocalData();
+	}
+}
+
+//! (static)
+std::vector<uint8_t> CompressedMeshDataStrategy::compressVertices(const uint8_t * data, size_t numBytes, size_t vertexSize) {
+	if(vertexSize == 0 || numBytes % vertexSize != 0)
+		throw std::invalid_argument("compressVertices: The data size has to be a multiple of the vertex size.");
+	const size_t count = numBytes / vertexSize;
+	std::vector<uint8_t> result;
+	result.reserve(numBytes / 4);
+	uint64_t zeros = 0;
+	// byte planes: the k-th byte of all vertices, stored as difference to the previous vertex
+	for(size_t k = 0; k < vertexSize; ++k) {
+		uint8_t previous = 0;
+		for(size_t i = 0; i < count; ++i) {
+			const uint8_t value = data[i * vertexSize + k];
+			const uint8_t delta = static_cast<uint8_t>(value - previous);
+			previous = value;
+			if(delta == 0) {
+				++zeros;
+				continue;
+			}
+			if(zeros > 0) {
+				result.push_back(0);
+				writeVarInt(result, zeros);
+				zeros = 0;
+			}
+			result.push_back(delta);
+		}
+	}
+	if(zeros > 0) {
+		result.push_back(0);
+		writeVarInt(result, zeros);
+	}
+	result.shrink_to_fit();
+	return result;
+}
+
+//! (static)
+bool CompressedMeshDataStrategy::decompressVertices(const std::vector<uint8_t> & compressed, size_t vertexSize, size_t numBytes, std::vector<uint8_t> & result) {
+	if(vertexSize == 0 || numBytes % vertexSize != 0)
+		return false;
+	const size_t count = numBytes / vertexSize;
+	result.resize(numBytes);
+	const uint8_t * cursor = compressed.data();
+	const uint8_t * const end = cursor + compressed.size();
+	uint64_t zeros = 0;
+	for(size_t k = 0; k < vertexSize; ++k) {
+		uint8_t value = 0;
+		for(size_t i = 0; i < count; ++i) {
+			if(zeros > 0) {
+				--zeros;
+			} else {
+				if(cursor == end)
+					return false;
+				const uint8_t delta = *cursor++;
+				if(delta == 0) {
+					if(!readVarInt(cursor, end, zeros) || zeros == 0)
+						return false;
+					--zeros;
+				}
+				value = static_cast<uint8_t>(value + delta);
+			}
+			result[i * vertexSize + k] = value;
+		}
+	}
+	return cursor == end && zeros == 0;
+}
+
+//! (static)
+std::vector<uint8_t> CompressedMeshDataStrategy::compressIndices(const uint32_t * indices, uint32_t count) {
+	std::vector<uint8_t> result;
+	result.reserve(count * 2);
+	int64_t previous = 0;
+	for(uint32_t i = 0; i < count; ++i) {
+		const int64_t delta = static_cast<int64_t>(indices[i]) - previous;
+		previous = indices[i];
+		// zigzag encoding: small negative differences become small numbers as well
+		writeVarInt(result, delta < 0 ? (static_cast<uint64_t>(-delta) << 1) - 1 : static_cast<uint64_t>(delta) << 1);
+	}
+	result.shrink_to_fit();
+	return result;
+}
+
+//! (static)
+bool CompressedMeshDataStrategy::decompressIndices(const std::vector<uint8_t> & compressed, uint32_t count, std::vector<uint32_t> & result) {
+	result.resize(count);
+	const uint8_t * cursor = compressed.data();
+	const uint8_t * const end = cursor + compressed.size();
+	int64_t previous = 0;
+	for(uint32_t i = 0; i < count; ++i) {
+		uint64_t value;
+		if(!readVarInt(cursor, end, value) || value > (static_cast<uint64_t>(std::numeric_limits<uint32_t>::max()) << 1))
+			return false;
+		const int64_t delta = (value & 1) != 0 ? -static_cast<int64_t>((value + 1) >> 1) : static_cast<int64_t>(value >> 1);
+		previous += delta;
+		if(previous < 0 || previous > static_cast<int64_t>(std::numeric_limits<uint32_t>::max()))
+			return false;
+		result[i] = static_cast<uint32_t>(previous);
+	}
+	return cursor == end;
+}
+
+}
@@ -0,0 +1,106 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_COMPRESSEDMESHDATASTRATEGY_H_
+#define RENDERING_COMPRESSEDMESHDATASTRATEGY_H_
+
+#include "MeshDataStrategy.h"
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <vector>
+
+namespace Rendering {
+
+/*!	CompressedMeshDataStrategy ---|> SimpleMeshDataStrategy ---|> MeshDataStrategy
+	Like the preserve-local-data strategies, the data of a mesh stays accessible in main memory after it has been uploaded,
+	e.g. for picking on the CPU. But instead of the plain data, only a compressed copy is kept: after the upload, the
+	vertices and indices are compressed and the local data is released. openVertexData() and openIndexData() decompress
+	the copy again (without a download from graphics memory).
+
+	The decompressed data of the most recently opened meshes is kept in a small cache, so repeated accesses to the same
+	meshes do not decompress them again. If more meshes are opened, the local data of the least recently opened one is
+	released (it remains available in compressed form).
+
+	The vertices are compressed by storing the differences between the bytes of consecutive vertices (byte planes)
+	with runs of zeros replaced by their length, the indices by storing the differences of consecutive indices with a
+	variable number of bytes. This works best for quantized or smoothly varying vertex data and for vertex cache optimized indices.
+
+	\note The compressed copies are stored in the meshes (see Mesh::_getCompressedLocalData()) and are updated
+		when the data changes.
+	\note The local data of a mesh may be released as soon as other meshes of this strategy are opened; pointers to it
+		must not be stored. */
+class CompressedMeshDataStrategy : public SimpleMeshDataStrategy {
+	public:
+		struct Statistics {
+			uint64_t compressions;		//!< Number of compressed vertex or index data.
+			uint64_t decompressions;	//!< Number of decompressed vertex or index data.
+			uint64_t uncompressedBytes;	//!< Size of the compressed data before the compression.
+			uint64_t compressedBytes;	//!< Size of the compressed data after the compression.
+			uint64_t cacheEvictions;	//!< Meshes whose local data was released to keep the cache size.
+			Statistics() : compressions(0), decompressions(0), uncompressedBytes(0), compressedBytes(0), cacheEvictions(0) {}
+		};
+
+		/*!	Return an instance creating static VBOs that caches the decompressed data of up to 16 meshes. */
+		static CompressedMeshDataStrategy * getStaticDrawStrategy();
+
+		/*! @p flags: see SimpleMeshDataStrategy (USE_VBOS and PRESERVE_LOCAL_DATA are always set).
+			@p cacheSize Maximum number of meshes whose data is kept decompressed after it has been opened. */
+		CompressedMeshDataStrategy(uint8_t flags, uint32_t cacheSize);
+		virtual ~CompressedMeshDataStrategy();
+
+		uint32_t getCacheSize() const				{	return cacheSize;	}
+		//! Set the size of the cache; the local data of meshes exceeding the new size is released.
+		void setCacheSize(uint32_t newSize);
+		//! Release the local data of all meshes in the cache.
+		void clearCache();
+
+		Statistics getStatistics() const;
+		void resetStatistics();
+
+		/*! (static) Return the size in bytes of the mesh's compressed data (vertices and indices)
+			or 0 if the mesh has no compressed copy. */
+		static size_t getCompressedSize(Mesh * m);
+
+		//! ---|> SimpleMeshDataStrategy
+		void assureLocalVertexData(Mesh * m) override;
+		//! ---|> SimpleMeshDataStrategy
+		void assureLocalIndexData(Mesh * m) override;
+		//! ---|> SimpleMeshDataStrategy
+		void prepare(Mesh * m) override;
+
+		/*! (static) Compress interleaved vertices with the given vertex size in bytes.
+			\note Exposed for tests and tools; the format is not meant to be stored. */
+		static std::vector<uint8_t> compressVertices(const uint8_t * data, size_t numBytes, size_t vertexSize);
+		/*! (static) Decompress vertices compressed by compressVertices().
+			@return @c false if the compressed data is invalid or does not match @p numBytes. */
+		static bool decompressVertices(const std::vector<uint8_t> & compressed, size_t vertexSize, size_t numBytes, std::vector<uint8_t> & result);
+		//! (static) Compress indices.
+		static std::vector<uint8_t> compressIndices(const uint32_t * indices, uint32_t count);
+		//! (static) Decompress indices compressed by compressIndices().
+		static bool decompressIndices(const std::vector<uint8_t> & compressed, uint32_t count, std::vector<uint32_t> & result);
+
+	private:
+		uint32_t cacheSize;
+		std::list<Util::Reference<Mesh>> cache; //!< front = most recently opened
+		Statistics statistics;
+		mutable std::mutex mutex;
+
+		void touch(Mesh * m);
+		void shrinkCache(size_t maxSize);
+		//! (internal) Update the compressed copy if the data has changed and release the local data if possible.
+		void updateCompressedData(Mesh * m);
+};
+
+}
+
+#endif /* RENDERING_COMPRESSEDMESHDATASTRATEGY_H_ */
@@ -0,0 +1,60 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_COPYONWRITEARRAY_H_
+#define RENDERING_COPYONWRITEARRAY_H_
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Rendering {
+
+/*! Array whose values are shared between copies until one of the copies is changed (copy-on-write).
+	Copying the array only copies a reference. Reading never copies the values; edit() returns values that
+	are exclusively owned by this array and copies them first if they are shared with another array.
+	\note A pointer obtained via edit() must not be used for writing after the array has been copied again.	*/
+template<typename value_t>
+class CopyOnWriteArray {
+	public:
+		typedef std::vector<value_t> array_t;
+
+		const value_t * data()const							{	return values ? values->data() : nullptr;	}
+		std::size_t size()const								{	return values ? values->size() : 0;	}
+		bool empty()const									{	return size() == 0;	}
+		const value_t * begin()const						{	return data();	}
+		const value_t * end()const							{	return data() + size();	}
+		const value_t & operator[](std::size_t index)const	{	return (*values)[index];	}
+
+		//! @c true iff the values are shared with another array.
+		bool isShared()const								{	return values && values.use_count() > 1;	}
+
+		//! Write access to the values; shared values are copied first.
+		array_t & edit() {
+			if(!values)
+				values = std::make_shared<array_t>();
+			else if(values.use_count() > 1)
+				values = std::make_shared<array_t>(*values);
+			return *values;
+		}
+		//! Replace the values without copying the old ones.
+		void assign(array_t && newValues)					{	values = std::make_shared<array_t>(std::move(newValues));	}
+		//! Release the reference to the values.
+		void clear()										{	values.reset();	}
+		void swap(CopyOnWriteArray & other)					{	values.swap(other.values);	}
+
+	private:
+		std::shared_ptr<array_t> values;
+};
+
+}
+
+#endif /* RENDERING_COPYONWRITEARRAY_H_ */
@@ -0,0 +1,91 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_DIRTYRANGESET_H_
+#define RENDERING_DIRTYRANGESET_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+
+/*! Small set of disjoint, sorted intervals [begin, end) of changed elements (e.g. vertices or indices).
+	Overlapping and adjacent intervals are merged. If more than @a maxRanges intervals would be stored,
+	the two intervals with the smallest gap between them are merged, so the number of partial uploads
+	stays bounded (at the cost of uploading some unchanged elements).	*/
+class DirtyRangeSet {
+	public:
+		struct Range {
+			uint32_t begin;
+			uint32_t end;
+			uint32_t size() const	{	return end - begin;	}
+		};
+
+		explicit DirtyRangeSet(std::size_t _maxRanges = 16) : maxRanges(std::max<std::size_t>(1, _maxRanges)) {}
+
+		void add(uint32_t begin, uint32_t count) {
+			if(count == 0)
+				return;
+			Range range{begin, begin + count};
+			// fast path: appending behind the last interval (e.g. when marking consecutive elements)
+			if(ranges.empty() || ranges.back().end < range.begin) {
+				ranges.push_back(range);
+			} else {
+				// first interval that ends at or after the new one begins
+				auto first = std::lower_bound(ranges.begin(), ranges.end(), range.begin,
+												[](const Range & r, uint32_t value) {	return r.end < value;	});
+				auto last = first;
+				while(last != ranges.end() && last->begin <= range.end) {
+					range.begin = std::min(range.begin, last->begin);
+					range.end = std::max(range.end, last->end);
+					++last;
+				}
+				if(first == last) {
+					ranges.insert(first, range);
+				} else {
+					*first = range;
+					ranges.erase(first + 1, last);
+				}
+			}
+			if(ranges.size() > maxRanges)
+				mergeClosest();
+		}
+
+		void clear()										{	ranges.clear();	}
+		bool empty() const									{	return ranges.empty();	}
+		const std::vector<Range> & getRanges() const		{	return ranges;	}
+		//! Number of elements covered by all intervals.
+		uint32_t getElementCount() const {
+			uint32_t count = 0;
+			for(const auto & range : ranges)
+				count += range.size();
+			return count;
+		}
+
+	private:
+		std::vector<Range> ranges;
+		std::size_t maxRanges;
+
+		void mergeClosest() {
+			std::size_t best = 0;
+			for(std::size_t i = 1; i + 1 < ranges.size(); ++i) {
+				if(ranges[i + 1].begin - ranges[i].end < ranges[best + 1].begin - ranges[best].end)
+					best = i;
+			}
+			ranges[best].end = ranges[best + 1].end;
+			ranges.erase(ranges.begin() + static_cast<std::ptrdiff_t>(best) + 1);
+		}
+};
+
+}
+
+#endif /* RENDERING_DIRTYRANGESET_H_ */
@@ -0,0 +1,95 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "LODMeshDataStrategy.h"
+#include "Mesh.h"
+#include "../RenderingContext/RenderingContext.h"
+#include <Geometry/Box.h>
+#include <Geometry/Definitions.h>
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Vec3.h>
+#include <Geometry/Vec4.h>
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+namespace Rendering {
+
+namespace {
+//! Keeps a strategy created by LODMeshDataStrategy::createForMesh() alive as long as the mesh.
+class OwnedLODStrategy : public MeshDerivedData {
+	public:
+		explicit OwnedLODStrategy(LODMeshDataStrategy * _strategy) : MeshDerivedData(), strategy(_strategy) {}
+		virtual ~OwnedLODStrategy() {}
+		std::unique_ptr<LODMeshDataStrategy> strategy;
+};
+}
+
+//! (ctor)
+LODMeshDataStrategy::LODMeshDataStrategy(std::vector<Level> _levels) :
+		SimpleMeshDataStrategy(USE_VBOS | PRESERVE_LOCAL_DATA), levels(std::move(_levels)), lodBias(1.0f), lastLevel(0) {
+}
+
+//! (dtor)
+LODMeshDataStrategy::~LODMeshDataStrategy() = default;
+
+//! (static)
+LODMeshDataStrategy * LODMeshDataStrategy::createForMesh(Mesh * mesh, std::vector<Level> levels) {
+	Util::Reference<OwnedLODStrategy> data = new OwnedLODStrategy(new LODMeshDataStrategy(std::move(levels)));
+	mesh->_setLODData(data.get());
+	mesh->setDataStrategy(data->strategy.get());
+	return data->strategy.get();
+}
+
+//! (static)
+float LODMeshDataStrategy::getProjectedSize(const RenderingContext & context, const Geometry::Box & box) {
+	const Geometry::Matrix4x4 modelToClipping = context.getMatrix_cameraToClipping() * context.getMatrix_modelToCamera();
+	float minX = std::numeric_limits<float>::max();
+	float minY = std::numeric_limits<float>::max();
+	float maxX = std::numeric_limits<float>::lowest();
+	float maxY = std::numeric_limits<float>::lowest();
+	for(uint_fast8_t c = 0; c < 8; ++c) {
+		const Geometry::Vec4 clipPos = modelToClipping * Geometry::Vec4(box.getCorner(static_cast<Geometry::corner_t>(c)), 1.0f);
+		if(clipPos[3] <= std::numeric_limits<float>::epsilon())
+			return std::numeric_limits<float>::max();
+		const float x = clipPos[0] / clipPos[3];
+		const float y = clipPos[1] / clipPos[3];
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+	}
+	// normalized device coordinates span [-1, 1]
+	return 0.5f * std::max(maxX - minX, maxY - minY);
+}
+
+uint32_t LODMeshDataStrategy::selectLevel(const RenderingContext & context, Mesh * m) const {
+	if(levels.size() < 2)
+		return 0;
+	const float size = getProjectedSize(context, m->getBoundingBox()) * lodBias;
+	for(uint32_t i = 0; i < levels.size(); ++i) {
+		if(size >= levels[i].minScreenSize)
+			return i;
+	}
+	return static_cast<uint32_t>(levels.size() - 1);
+}
+
+//! ---|> MeshDataStrategy
+void LODMeshDataStrategy::displayMesh(RenderingContext & context, Mesh * m,uint32_t startIndex,uint32_t indexCount){
+	if(levels.empty() || startIndex != 0 || indexCount != m->getIndexCount()) {
+		SimpleMeshDataStrategy::displayMesh(context, m, startIndex, indexCount);
+		return;
+	}
+	lastLevel = selectLevel(context, m);
+	const Level & level = levels[lastLevel];
+	SimpleMeshDataStrategy::displayMesh(context, m, level.firstElement, level.elementCount);
+}
+
+}
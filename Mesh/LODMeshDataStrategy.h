@@ -0,0 +1,77 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_LODMESHDATASTRATEGY_H_
+#define RENDERING_LODMESHDATASTRATEGY_H_
+
+#include "MeshDataStrategy.h"
+#include <cstdint>
+#include <vector>
+
+namespace Geometry {
+template<typename value_t> class _Box;
+typedef _Box<float> Box;
+}
+namespace Rendering {
+
+/*!	LODMeshDataStrategy ---|> SimpleMeshDataStrategy ---|> MeshDataStrategy
+	Strategy for a mesh whose index data contains several levels of detail as consecutive index ranges
+	(see MeshUtils::MeshLODChain). When the whole mesh is displayed, only the level matching the
+	projected size of the mesh's bounding box is drawn. Requests for other ranges are passed through.
+
+	\note Unlike the other strategies, an instance belongs to exactly one mesh. */
+class LODMeshDataStrategy : public SimpleMeshDataStrategy {
+	public:
+		struct Level {
+			uint32_t firstElement;
+			uint32_t elementCount;
+			/*! The level is used if the projected size of the bounding box is at least this value.
+				The size is measured as fraction of the viewport (1.0 means the size of the viewport). */
+			float minScreenSize;
+			Level(uint32_t first, uint32_t count, float minSize) : firstElement(first), elementCount(count), minScreenSize(minSize) {}
+		};
+
+		//! @p levels have to be sorted from the finest to the coarsest level (decreasing minScreenSize).
+		explicit LODMeshDataStrategy(std::vector<Level> levels);
+		virtual ~LODMeshDataStrategy();
+
+		/*! (static) Create a strategy with the given levels and set it as strategy of @p mesh.
+			The strategy is owned by the mesh (see Mesh::_getLODData()) and deleted together with it.
+			Used for meshes whose levels are restored from a file (see StreamerMMF).
+			\note A clone of the mesh shares the strategy.	*/
+		static LODMeshDataStrategy * createForMesh(Mesh * mesh, std::vector<Level> levels);
+
+		const std::vector<Level> & getLevels() const	{	return levels;	}
+
+		//! The projected size is multiplied by the bias before the level is selected; values > 1 prefer finer levels.
+		void setLODBias(float bias)						{	lodBias = bias;	}
+		float getLODBias() const						{	return lodBias;	}
+
+		//! Index of the level that was drawn by the last call to displayMesh().
+		uint32_t getLastLevel() const					{	return lastLevel;	}
+
+		uint32_t selectLevel(const RenderingContext & context, Mesh * m) const;
+
+		/*! (static) Return the size of the box projected with the current modelview and projection matrices
+			as fraction of the viewport (the larger one of width and height).
+			If the box intersects the plane of the camera, a huge value is returned. */
+		static float getProjectedSize(const RenderingContext & context, const Geometry::Box & box);
+
+		void displayMesh(RenderingContext & context, Mesh * m,uint32_t startIndex,uint32_t indexCount) override;
+
+	private:
+		std::vector<Level> levels;
+		float lodBias;
+		uint32_t lastLevel;
+};
+
+}
+
+#endif /* RENDERING_LODMESHDATASTRATEGY_H_ */
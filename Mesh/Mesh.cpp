@@ -10,13 +10,20 @@
 */
 #include "Mesh.h"
 #include "MeshDataStrategy.h"
+#include "VertexAttributeAccessors.h"
+#include "VertexAttributeIds.h"
 #include "VertexDescription.h"
 #include "../RenderingContext/RenderingContext.h"
+#include "../ContentHash.h"
+#include "../Shader/Shader.h"
 #include "../GLHeader.h"
 #include <Util/IO/FileName.h>
 #include <Util/ReferenceCounter.h>
+#include <Geometry/Box.h>
 #include <algorithm>
+#include <stdexcept>
 #include <utility>
+#include <vector>
 
 namespace Rendering {
 
@@ -25,20 +32,65 @@ static_assert(GL_TRIANGLES<256 && GL_LINES<256 && GL_POINTS<256 && GL_LINE_STRIP
 			"Constants for Mesh's triangleMode are expected to fit into a single byte; This should be true on all platforms."); 
 
 Mesh::Mesh() :
-		ReferenceCounter_t(), fileName(), dataStrategy(MeshDataStrategy::getDefaultStrategy()),drawMode(DRAW_TRIANGLES), useIndexData(true) {
+		ReferenceCounter_t(), fileName(), viewSource(), viewFirstElement(0), viewElementCount(0), viewBaseVertex(0), dataStrategy(MeshDataStrategy::getDefaultStrategy()),
+		dataHash(0), dataHashVertexRevision(0), dataHashIndexRevision(0), dataHashValid(false),drawMode(DRAW_TRIANGLES), useIndexData(true) {
 }
 
 Mesh::Mesh(MeshIndexData meshIndexData, MeshVertexData meshVertexData) :
 		ReferenceCounter_t(), indexData(std::move(meshIndexData)), fileName(), vertexData(std::move(meshVertexData)), 
-		dataStrategy(MeshDataStrategy::getDefaultStrategy()), drawMode(DRAW_TRIANGLES), useIndexData(true) {
+		viewSource(), viewFirstElement(0), viewElementCount(0), viewBaseVertex(0), dataStrategy(MeshDataStrategy::getDefaultStrategy()),
+		dataHash(0), dataHashVertexRevision(0), dataHashIndexRevision(0), dataHashValid(false), drawMode(DRAW_TRIANGLES), useIndexData(true) {
 }
 
 Mesh::Mesh(const VertexDescription & desc, uint32_t vertexCount, uint32_t indexCount) :
-		ReferenceCounter_t(), fileName(), dataStrategy(MeshDataStrategy::getDefaultStrategy()), drawMode(DRAW_TRIANGLES), useIndexData(true) {
+		ReferenceCounter_t(), fileName(), viewSource(), viewFirstElement(0), viewElementCount(0), viewBaseVertex(0), dataStrategy(MeshDataStrategy::getDefaultStrategy()),
+		dataHash(0), dataHashVertexRevision(0), dataHashIndexRevision(0), dataHashValid(false), drawMode(DRAW_TRIANGLES), useIndexData(true) {
 	indexData.allocate(indexCount);
 	vertexData.allocate(vertexCount, desc);
 }
 
+//! (static)
+Mesh * Mesh::createView(Mesh * source, uint32_t firstElement, uint32_t elementCount, int32_t baseVertex) {
+	if(source->isView()) { // reference the actual data
+		if(firstElement + elementCount > source->viewElementCount)
+			throw std::out_of_range("Mesh::createView: Invalid element range.");
+		return createView(source->viewSource.get(), source->viewFirstElement + firstElement, elementCount, source->viewBaseVertex + baseVertex);
+	}
+	const bool indexed = source->isUsingIndexData();
+	if(firstElement + elementCount > (indexed ? source->getIndexCount() : source->getVertexCount()))
+		throw std::out_of_range("Mesh::createView: Invalid element range.");
+
+	Mesh * view = new Mesh;
+	view->viewSource = source;
+	view->viewFirstElement = firstElement;
+	view->viewElementCount = elementCount;
+	view->viewBaseVertex = indexed ? baseVertex : 0;
+	view->drawMode = source->drawMode;
+	view->useIndexData = indexed;
+	view->fileName = source->fileName;
+
+	// bounding box of the referenced vertices
+	Geometry::Box bounds;
+	bounds.invalidate();
+	MeshVertexData & vd = source->openVertexData();
+	if(elementCount > 0 && vd.hasLocalData() && vd.getVertexDescription().hasAttribute(VertexAttributeIds::POSITION)) {
+		Util::Reference<PositionAttributeAccessor> positions = PositionAttributeAccessor::create(vd);
+		if(indexed) {
+			const MeshIndexData & id = source->openIndexData();
+			for(uint32_t i = firstElement; i < firstElement + elementCount; ++i) {
+				const int64_t index = static_cast<int64_t>(id[i]) + view->viewBaseVertex;
+				if(index >= 0 && index < vd.getVertexCount())
+					bounds.include(positions->getPosition(static_cast<uint32_t>(index)));
+			}
+		} else {
+			for(uint32_t i = firstElement; i < firstElement + elementCount; ++i)
+				bounds.include(positions->getPosition(i));
+		}
+	}
+	view->vertexData._setBoundingBox(bounds);
+	return view;
+}
+
 Mesh * Mesh::clone()const{
 	return new Mesh(*this);
 }
@@ -51,7 +103,73 @@ void Mesh::swap(Mesh & m){
 	swap(dataStrategy, m.dataStrategy);
 	swap(fileName, m.fileName);
 	swap(drawMode, m.drawMode);
+	swap(viewSource, m.viewSource);
+	swap(viewFirstElement, m.viewFirstElement);
+	swap(viewElementCount, m.viewElementCount);
+	swap(viewBaseVertex, m.viewBaseVertex);
 	swap(useIndexData, m.useIndexData);
+	swap(spatialIndex, m.spatialIndex);
+	swap(positionStream, m.positionStream);
+	swap(meshletCache, m.meshletCache);
+	swap(lodData, m.lodData);
+	swap(connectivity, m.connectivity);
+	swap(transformFeedback, m.transformFeedback);
+	swap(compressedLocalData, m.compressedLocalData);
+	swap(swapRecord, m.swapRecord);
+	swap(dataHash, m.dataHash);
+	swap(dataHashVertexRevision, m.dataHashVertexRevision);
+	swap(dataHashIndexRevision, m.dataHashIndexRevision);
+	swap(dataHashValid, m.dataHashValid);
+	_updateMemoryAccounting();
+	m._updateMemoryAccounting();
+}
+
+//! (internal)
+void Mesh::_updateMemoryAccounting() {
+	memoryAccount.update(dataStrategy, isView() ? 0 : getGraphicsMemoryUsage());
+}
+
+uint64_t Mesh::getContentHash() {
+	uint64_t hash;
+	if(isView()) {
+		const uint32_t range[3] = {viewFirstElement, viewElementCount, static_cast<uint32_t>(viewBaseVertex)};
+		hash = calcContentHash(reinterpret_cast<const uint8_t *>(range), sizeof(range), viewSource->getContentHash());
+	} else {
+		hash = _getDataHash();
+	}
+	const uint8_t mode[2] = {static_cast<uint8_t>(drawMode), static_cast<uint8_t>(useIndexData ? 1 : 0)};
+	return calcContentHash(mode, sizeof(mode), hash);
+}
+
+uint64_t Mesh::_getDataHash() {
+	if(!dataHashValid || dataHashVertexRevision != vertexData.getRevision() || dataHashIndexRevision != indexData.getRevision()) {
+		// const references: reading must not copy data shared with clones
+		const MeshVertexData & vd = openVertexData();
+		const MeshIndexData & id = openIndexData();
+		std::vector<uint32_t> description;
+		description.push_back(vd.getLayout());
+		for(const auto & attr : vd.getVertexDescription().getAttributes()) {
+			description.push_back(attr.getNameId().getValue());
+			description.push_back(attr.getNumValues());
+			description.push_back(attr.getDataType());
+			description.push_back(attr.getOffset());
+			description.push_back((attr.getNormalize() ? 1 : 0) | (attr.getConvertToFloat() ? 2 : 0));
+		}
+		dataHash = calcContentHash(reinterpret_cast<const uint8_t *>(description.data()), description.size() * sizeof(uint32_t));
+		dataHash = calcContentHash(vd.data(), vd.dataSize(), dataHash);
+		dataHash = calcContentHash(reinterpret_cast<const uint8_t *>(id.data()), id.dataSize(), dataHash);
+		dataHashVertexRevision = vd.getRevision();
+		dataHashIndexRevision = id.getRevision();
+		dataHashValid = true;
+	}
+	return dataHash;
+}
+
+void Mesh::_setDataHash(uint64_t hash) {
+	dataHash = hash;
+	dataHashVertexRevision = vertexData.getRevision();
+	dataHashIndexRevision = indexData.getRevision();
+	dataHashValid = true;
 }
 
 size_t Mesh::getMainMemoryUsage() const {
@@ -59,19 +177,59 @@ size_t Mesh::getMainMemoryUsage() const {
 }
 
 size_t Mesh::getGraphicsMemoryUsage() const {
-	return 	(indexData.isUploaded() ? indexData.getIndexCount() * sizeof(uint32_t) : 0)
-			+ (vertexData.isUploaded() ? vertexData.getVertexCount() * vertexData.getVertexDescription().getVertexSize() : 0);
+	return 	indexData.getUploadedDataSize()
+			+ (vertexData.isUploaded() || vertexData.isInArena() ? vertexData.getVertexCount() * vertexData.getVertexDescription().getVertexSize() : 0);
+}
+
+size_t Mesh::getSharedMainMemoryUsage() const {
+	return indexData.getSharedDataSize() + vertexData.getSharedDataSize();
+}
+
+size_t Mesh::getSharedGraphicsMemoryUsage() const {
+	return indexData.getSharedBufferSize() + vertexData.getSharedBufferSize();
 }
 
 void Mesh::_display(RenderingContext & context,uint32_t firstElement,uint32_t elementCount) {
 	context.applyChanges();
-	dataStrategy->prepare(this);
-	dataStrategy->displayMesh(context, this,firstElement,elementCount);
+	if(context.isActiveShaderPending()) {
+		++RenderingContext::_getFrameCounters().pendingShaderDraws;
+		Shader * fallback = context.getPendingShaderFallback();
+		if(fallback != nullptr && fallback->getStatus() != Shader::PENDING) {
+			context.pushAndSetShader(fallback);
+			_display(context, firstElement, elementCount);
+			context.popShader();
+		}
+		return;
+	}
+	if(isView()) {
+		if(firstElement >= viewElementCount)
+			return;
+		elementCount = std::min(elementCount, viewElementCount - firstElement);
+		if(viewBaseVertex == 0) { // the source draws the range (and counts the draw call)
+			viewSource->_display(context, viewFirstElement + firstElement, elementCount);
+			return;
+		}
+		// the display function of the data strategy does not support a base vertex
+		Mesh & source = *viewSource.get();
+		source.dataStrategy->prepare(&source);
+		MeshVertexData & vd = source.vertexData;
+		MeshIndexData & id = source.indexData;
+		vd.bind(context, vd.isUploaded());
+		id.drawElements(id.isUploaded(), getGLDrawMode(), viewFirstElement + firstElement, elementCount, viewBaseVertex);
+		vd.unbind(context, vd.isUploaded());
+	} else {
+		dataStrategy->prepare(this);
+		dataStrategy->displayMesh(context, this,firstElement,elementCount);
+		_updateMemoryAccounting();
+	}
+	RenderingContext::FrameCounters & counters = RenderingContext::_getFrameCounters();
+	++counters.drawCalls;
+	counters.primitives += getPrimitiveCount(elementCount);
 }
 
 uint32_t Mesh::getPrimitiveCount(uint32_t numElements) const {
 	if(numElements == 0) {
-		numElements = (useIndexData ? indexData.getIndexCount() : getVertexCount());
+		numElements = (useIndexData ? getIndexCount() : getVertexCount());
 	}
 	switch(drawMode) {
 		case DRAW_LINE_STRIP:
@@ -100,6 +258,7 @@ MeshVertexData & Mesh::openVertexData(){
 
 void Mesh::setDataStrategy(MeshDataStrategy * newStrategy) {
 	dataStrategy = newStrategy;
+	_updateMemoryAccounting();
 }
 
 uint32_t Mesh::getGLDrawMode() const {
@@ -13,7 +13,9 @@
 
 #include "MeshIndexData.h"
 #include "MeshVertexData.h"
+#include "../MemoryRegistry.h"
 #include <Util/ReferenceCounter.h>
+#include <Util/References.h>
 #include <Util/TypeNameMacro.h>
 #include <Util/IO/FileName.h>
 #include <cstddef>
@@ -30,6 +32,14 @@ class MeshDataStrategy;
 class VertexDescription;
 class RenderingContext;
 
+/*! Base class for data derived from a mesh's vertices and indices (e.g. MeshUtils::MeshBVH) that can be cached by the mesh.
+	The derived data itself is responsible for detecting whether it is outdated (e.g. using MeshVertexData::getRevision()). */
+class MeshDerivedData : public Util::ReferenceCounter<MeshDerivedData> {
+	public:
+		MeshDerivedData() : ReferenceCounter_t() {}
+		virtual ~MeshDerivedData() {}
+};
+
 /**
  * Class for polygonal meshes.
  * A mesh consisting of four components:
@@ -72,6 +82,10 @@ class Mesh : public Util::ReferenceCounter<Mesh> {
 		Mesh(const Mesh &) = default;
 		Mesh(Mesh &&) = default;
 
+		/*! Create a copy of this mesh. The copy shares the local vertex and index data with this mesh until the data
+			of one of the meshes is accessed for writing (e.g. via openVertexData().data()); GPU buffers holding unchanged
+			data are shared until new data is uploaded (copy-on-write).
+			@see getSharedMainMemoryUsage(), getSharedGraphicsMemoryUsage()	*/
 		Mesh* clone()const;
 
 		void swap(Mesh & m);
@@ -92,8 +106,20 @@ class Mesh : public Util::ReferenceCounter<Mesh> {
 		 */
 		size_t getGraphicsMemoryUsage() const;
 
+		/*! Return the part of getMainMemoryUsage() that is shared with copies of this mesh (see clone()).
+			@return Amount of memory in bytes	*/
+		size_t getSharedMainMemoryUsage() const;
+
+		/*! Return the part of getGraphicsMemoryUsage() that is shared with copies of this mesh (see clone()).
+			@return Amount of memory in bytes	*/
+		size_t getSharedGraphicsMemoryUsage() const;
+
 		/*! Returns true if no data is set. */
-		bool empty()const										{	return useIndexData ? (vertexData.empty() || indexData.empty()) : vertexData.empty();	}
+		bool empty()const {
+			if(isView())
+				return viewElementCount == 0;
+			return useIndexData ? (vertexData.empty() || indexData.empty()) : vertexData.empty();
+		}
 
 		/*! Display the mesh as VBO or VertexArray (determined by current data strategy).
 			- If the mesh uses indices (isUsingIndexData()==true), @p firstElement and @p elementCount are the first 
@@ -137,7 +163,7 @@ class Mesh : public Util::ReferenceCounter<Mesh> {
 		MeshIndexData & openIndexData();
 
 		uint32_t getIndexCount() const {
-			return useIndexData ? indexData.getIndexCount() : 0;
+			return useIndexData ? (isView() ? viewElementCount : indexData.getIndexCount()) : 0;
 		}
 
 		//! If useIndexData is false, the mesh's indexData
@@ -170,14 +196,45 @@ class Mesh : public Util::ReferenceCounter<Mesh> {
 			vertex data, this data can be accessed via MeshVertexData.data()	*/
 		MeshVertexData & openVertexData();
 
-		uint32_t getVertexCount()const   						{   return vertexData.getVertexCount(); }
-		const VertexDescription & getVertexDescription()const	{   return vertexData.getVertexDescription();	}
+		uint32_t getVertexCount()const {
+			if(isView())
+				return useIndexData ? viewSource->getVertexCount() : viewElementCount;
+			return vertexData.getVertexCount();
+		}
+		const VertexDescription & getVertexDescription()const	{   return isView() ? viewSource->getVertexDescription() : vertexData.getVertexDescription();	}
 		const Geometry::Box & getBoundingBox()const          	{   return vertexData.getBoundingBox();	}
 
 	private:
 		MeshVertexData vertexData;
 	// @}
 
+	/*!	@name View */
+	// @{
+	public:
+		/*! Create a mesh that displays only the elements [@p firstElement, @p firstElement + @p elementCount) of @p source
+			(indices if the source uses index data, vertices otherwise) without copying any vertex or index data,
+			neither in main nor in graphics memory. @p baseVertex is added to the indices when drawing (e.g. for parts
+			whose indices start at zero); it is ignored if the source does not use index data.
+			The view has its own bounding box that encloses the referenced vertices only (so the view can be culled
+			separately); calculating it requires the local data of the source, which is assured via openVertexData().
+			\note The view does not own any data: openVertexData() and openIndexData() of the view return empty data.
+				The source's data is displayed with the source's data strategy.
+			@throw std::out_of_range if the range exceeds the elements of @p source.	*/
+		static Mesh * createView(Mesh * source, uint32_t firstElement, uint32_t elementCount, int32_t baseVertex = 0);
+
+		bool isView()const										{	return viewSource.isNotNull();	}
+		//! The mesh whose data is displayed by this view (@c nullptr if this mesh is no view).
+		Mesh * getViewSource()const								{	return viewSource.get();	}
+		uint32_t getViewFirstElement()const						{	return viewFirstElement;	}
+		int32_t getViewBaseVertex()const						{	return viewBaseVertex;	}
+
+	private:
+		Util::Reference<Mesh> viewSource;
+		uint32_t viewFirstElement;
+		uint32_t viewElementCount;
+		int32_t viewBaseVertex;
+	// @}
+
 	/*!	@name DataStrategy */
 	// @{
 	public:
@@ -189,8 +246,79 @@ class Mesh : public Util::ReferenceCounter<Mesh> {
 		//! Set a new data strategy.
 		void setDataStrategy(MeshDataStrategy * newStrategy);
 
+		/*! (internal) Account the mesh's current graphics memory for its data strategy in the MemoryRegistry.
+			Called when the mesh is displayed and when the data strategy changes; a strategy that releases
+			the buffers of a mesh outside of the display call has to call it, too. */
+		void _updateMemoryAccounting();
+
 	private:
 		MeshDataStrategy * dataStrategy;
+		MemoryRegistry::StrategyAccount memoryAccount;
+	// @}
+
+	/*!	@name Cached derived data */
+	// @{
+	public:
+		/*! (internal) Spatial index (e.g. a MeshUtils::MeshBVH) cached by the mesh. Use MeshUtils::MeshBVH::get() to access it.
+			\note A copy of the mesh shares the cached data. */
+		MeshDerivedData * _getSpatialIndex() const				{	return spatialIndex.get();	}
+		void _setSpatialIndex(MeshDerivedData * data)			{	spatialIndex = data;	}
+
+		//! (internal) Position-only vertex stream used by the PositionStreamMeshDataStrategy.
+		MeshDerivedData * _getPositionStream() const			{	return positionStream.get();	}
+		void _setPositionStream(MeshDerivedData * data)			{	positionStream = data;	}
+
+		//! (internal) Meshlets cached by the mesh. Use MeshUtils::getMeshlets() to access them.
+		MeshDerivedData * _getMeshletCache() const				{	return meshletCache.get();	}
+		void _setMeshletCache(MeshDerivedData * data)			{	meshletCache = data;	}
+
+		//! (internal) Data that owns a level of detail strategy created for the mesh (see LODMeshDataStrategy::createForMesh()).
+		MeshDerivedData * _getLODData() const					{	return lodData.get();	}
+		void _setLODData(MeshDerivedData * data)				{	lodData = data;	}
+
+		//! (internal) Corner connectivity shared by the MeshUtils::ConnectivityAccessors created for the mesh.
+		MeshDerivedData * _getConnectivity() const				{	return connectivity.get();	}
+		void _setConnectivity(MeshDerivedData * data)			{	connectivity = data;	}
+
+		//! (internal) Transform feedback object capturing the vertices (see TransformFeedbackMeshDataStrategy).
+		MeshDerivedData * _getTransformFeedback() const			{	return transformFeedback.get();	}
+		void _setTransformFeedback(MeshDerivedData * data)		{	transformFeedback = data;	}
+
+		//! (internal) Compressed copy of the local data kept by the CompressedMeshDataStrategy.
+		MeshDerivedData * _getCompressedLocalData() const		{	return compressedLocalData.get();	}
+		void _setCompressedLocalData(MeshDerivedData * data)	{	compressedLocalData = data;	}
+
+		//! (internal) Location of the mesh's data inside a Serialization::MeshSwapFile.
+		MeshDerivedData * _getSwapRecord() const				{	return swapRecord.get();	}
+		void _setSwapRecord(MeshDerivedData * data)				{	swapRecord = data;	}
+
+		/*! Return a 64 bit hash of the mesh's content: the vertex description and layout, the vertices, the indices,
+			the draw mode and whether index data is used (for a view: the source's hash and the view's range).
+			The hash of the data is cached and only recalculated if the vertex or index data has been changed
+			(see MeshVertexData::getRevision()). Calculating it requires the local data (see openVertexData()).
+			\note Meshes with equal content have equal hashes; use MeshUtils::compareMeshes() to rule out collisions.	*/
+		uint64_t getContentHash();
+
+		/*! (internal) Return the cached hash of the vertex and index data that getContentHash() is based on.
+			It is calculated if it is outdated. Must not be called for a view. */
+		uint64_t _getDataHash();
+		/*! (internal) Set the hash of the current vertex and index data without calculating it
+			(e.g. if it has been stored in a file together with the data, see StreamerMMF). */
+		void _setDataHash(uint64_t hash);
+
+	private:
+		Util::Reference<MeshDerivedData> spatialIndex;
+		Util::Reference<MeshDerivedData> positionStream;
+		Util::Reference<MeshDerivedData> meshletCache;
+		Util::Reference<MeshDerivedData> lodData;
+		Util::Reference<MeshDerivedData> connectivity;
+		Util::Reference<MeshDerivedData> transformFeedback;
+		Util::Reference<MeshDerivedData> compressedLocalData;
+		Util::Reference<MeshDerivedData> swapRecord;
+		uint64_t dataHash;
+		uint64_t dataHashVertexRevision;
+		uint64_t dataHashIndexRevision;
+		bool dataHashValid;
 	// @}
 
 
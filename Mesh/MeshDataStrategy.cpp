@@ -14,20 +14,25 @@
 #include "MeshVertexData.h"
 #include "../GLHeader.h"
 #include "../RenderingContext/RenderingContext.h"
+#include "../StreamingBuffer.h"
 #include <Util/Macros.h>
 #include <iostream>
 
 namespace Rendering {
 
 //! (static)
-MeshDataStrategy * MeshDataStrategy::defaultStrategy = nullptr;
+std::atomic<MeshDataStrategy *> MeshDataStrategy::defaultStrategy(nullptr);
 
 //! (static)
 MeshDataStrategy * MeshDataStrategy::getDefaultStrategy(){
-	if(defaultStrategy == nullptr) {
-		defaultStrategy = SimpleMeshDataStrategy::getStaticDrawReleaseLocalStrategy();
+	MeshDataStrategy * strategy = defaultStrategy.load();
+	if(strategy == nullptr) {
+		MeshDataStrategy * initial = SimpleMeshDataStrategy::getStaticDrawReleaseLocalStrategy();
+		// keep a default that has been set concurrently
+		defaultStrategy.compare_exchange_strong(strategy, initial);
+		strategy = defaultStrategy.load();
 	}
-	return defaultStrategy;
+	return strategy;
 }
 
 //! (static)
@@ -84,6 +89,19 @@ SimpleMeshDataStrategy * SimpleMeshDataStrategy::getPureLocalStrategy(){
 	return RenderingContext::getCompabilityMode() ? &strategy : getDynamicVertexStrategy();
 }
 
+//! (internal)
+static StreamingBuffer * streamingBuffer = nullptr;
+
+//! (static)
+void SimpleMeshDataStrategy::setStreamingBuffer(StreamingBuffer * buffer){
+	streamingBuffer = buffer;
+}
+
+//! (static)
+StreamingBuffer * SimpleMeshDataStrategy::getStreamingBuffer(){
+	return streamingBuffer;
+}
+
 // ----
 
 /*! (ctor)	*/
@@ -134,10 +152,18 @@ void SimpleMeshDataStrategy::prepare(Mesh * m){
 	}
 
 	MeshVertexData & vd=m->_getVertexData();
-	if( vd.empty() && vd.isUploaded() ){ // "old" VBO present, although data has been removed
+	if( vd.empty() && (vd.isUploaded() || vd.isStreamed()) ){ // "old" VBO present, although data has been removed
 		if(getFlag(DEBUG_OUTPUT))	std::cout << " ~vBO";
 		vd.removeGlBuffer();
-	} else if( !vd.empty() && (vd.hasChanged() || !vd.isUploaded()) ){ // data has changed or is new
+	} else if( getFlag(DYNAMIC_VERTICES) && streamingBuffer != nullptr && !vd.empty() && vd.hasLocalData() &&
+				(vd.hasChanged() || (!vd.isStreamed() && !vd.isUploaded())) ){ // stream the data; fall back to a VBO if there is no space left
+		if( vd.upload(*streamingBuffer) ){
+			if(getFlag(DEBUG_OUTPUT))	std::cout << " +sBO";
+		} else {
+			if(getFlag(DEBUG_OUTPUT))	std::cout << " +vBO";
+			vd.upload(GL_DYNAMIC_DRAW);
+		}
+	} else if( !vd.empty() && (vd.hasChanged() || (!vd.isUploaded() && !vd.isStreamed())) ){ // data has changed or is new
 		if(getFlag(DEBUG_OUTPUT))	std::cout << " +vBO";
 		vd.upload( getFlag(DYNAMIC_VERTICES) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW );
 	}
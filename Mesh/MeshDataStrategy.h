@@ -11,12 +11,14 @@
 #ifndef MESHDATASTRATEGY_H
 #define MESHDATASTRATEGY_H
 
+#include <atomic>
 #include <cstdint>
 
 namespace Rendering{
 
 class Mesh;
 class RenderingContext;
+class StreamingBuffer;
 
 /*! Determines the strategy how the index and vertex data of a mesh is
 	handled (uploaded, downloaded, deletet, ...).
@@ -28,9 +30,10 @@ class RenderingContext;
 	\note If an implementation does make use of gl-calls, be carefull if the
 		mesh is accesed from a non-gl-thread. */
 class MeshDataStrategy {
-		static MeshDataStrategy * defaultStrategy;
+		static std::atomic<MeshDataStrategy *> defaultStrategy;
 	public:
-		/*! Returns an instance of the default strategy as singleton. */
+		/*! Returns an instance of the default strategy as singleton.
+			\note The default strategy is shared by all rendering contexts; it can be queried and set from any thread. */
 		static MeshDataStrategy * getDefaultStrategy();
 		static void setDefaultStrategy(MeshDataStrategy * newDefault);
 
@@ -76,7 +79,7 @@ class SimpleMeshDataStrategy : public MeshDataStrategy {
 
 		/*!	Return an instance of the SimpleMeshDataStrategy:
 			Create a VBO (with static usage) when first	displayed and release the local memory.
-			\note Each action results in an output message. */
+			\note Each action results in an output message. For the GPU cost of the meshes, see ProfilingMeshDataStrategy. */
 		static SimpleMeshDataStrategy * getDebugStrategy();
 
 		/*!	Return an instance of the SimpleMeshDataStrategy:
@@ -84,13 +87,21 @@ class SimpleMeshDataStrategy : public MeshDataStrategy {
 		static SimpleMeshDataStrategy * getStaticDrawPreserveLocalStrategy();
 
 		/*!	Return an instance of the SimpleMeshDataStrategy:
-			Create a VBO (with dynamic usage) when first displayed and to preserve a copy in local memory. */
+			Create a VBO (with dynamic usage) when first displayed and to preserve a copy in local memory.
+			If a streaming buffer is set (see setStreamingBuffer()), changed vertex data is written into the
+			streaming buffer instead of re-allocating the VBO. */
 		static SimpleMeshDataStrategy * getDynamicVertexStrategy();
 
 		/*!	Return an instance of the SimpleMeshDataStrategy:
 			Use VertexArrays and render from local memory. */
 		static SimpleMeshDataStrategy * getPureLocalStrategy();
 
+		/*!	Set the streaming buffer used for dynamic vertex data (@c nullptr disables streaming).
+			\note The application has to call StreamingBuffer::nextFrame() once per frame.
+			\note The buffer has to be valid as long as meshes are drawn from it. */
+		static void setStreamingBuffer(StreamingBuffer * buffer);
+		static StreamingBuffer * getStreamingBuffer();
+
 		// --------------------
 
 		static const uint8_t USE_VBOS = 1<<0;
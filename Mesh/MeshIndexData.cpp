@@ -10,9 +10,13 @@
 */
 #include "MeshIndexData.h"
 #include "../GLHeader.h"
+#include "../GLTrace.h"
 #include "../Helper.h"
+#include "../MemoryRegistry.h"
 #include <Util/Macros.h>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <limits>
 #include <stdexcept>
 #include <utility>
@@ -22,27 +26,83 @@ namespace Rendering {
 /*! (ctor)  */
 MeshIndexData::MeshIndexData() :
 			indexCount(0), minIndex(0), maxIndex(0),
-			bufferObject(), dataChanged(false) {
+			bufferObject(), arenaAllocation(), dataChanged(false), changedRanges(), uploadedIndexSize(4), revision(0) {
 }
 
 /*! (ctor)  */
 MeshIndexData::MeshIndexData(const MeshIndexData & other) :
 			indexCount(other.getIndexCount()), 
 			minIndex(other.getMinIndex()), maxIndex(other.getMaxIndex()),
-			bufferObject(), dataChanged(true) {
+			bufferObject(), arenaAllocation(), dataChanged(true), changedRanges(), uploadedIndexSize(4), revision(other.revision) {
+	if(other.isUploaded() && !other.hasChanged()) {
+		bufferObject = other.bufferObject;
+		uploadedIndexSize = other.uploadedIndexSize;
+		dataChanged = false;
+	}
 	if(other.hasLocalData()) {
 		indexArray = other.indexArray;
-	} else if(other.isUploaded()) {
-		other.downloadTo(indexArray);
+	} else if(isUploaded()) {
+		// the data is downloaded from the shared buffer when it is needed
+	} else if(other.isUploaded() || other.isInArena()) {
+		std::vector<uint32_t> downloadedData;
+		other.downloadTo(downloadedData);
+		indexArray.assign(std::move(downloadedData));
 	} else {
 		WARN("Cannot access index data."); // should not happen
 	}
 }
 
+static uint8_t minimumUploadedIndexSize = 2;
+
+//! (static)
+void MeshIndexData::setMinimumUploadedIndexSize(uint8_t size) {
+	if(size != 1 && size != 2 && size != 4)
+		throw std::invalid_argument("MeshIndexData::setMinimumUploadedIndexSize: Invalid index size.");
+	minimumUploadedIndexSize = size;
+}
+
+//! (static)
+uint8_t MeshIndexData::getMinimumUploadedIndexSize() {
+	return minimumUploadedIndexSize;
+}
+
+uint32_t MeshIndexData::getUploadedIndexType() const {
+	switch(uploadedIndexSize) {
+		case 1:
+			return GL_UNSIGNED_BYTE;
+		case 2:
+			return GL_UNSIGNED_SHORT;
+		default:
+			return GL_UNSIGNED_INT;
+	}
+}
+
+//! (static, internal)
+uint64_t MeshIndexData::createRevision() {
+	static std::atomic<uint64_t> lastRevision(0);
+	return ++lastRevision;
+}
+
 //!(internal)
 void MeshIndexData::releaseLocalData(){
 	indexArray.clear();
-	indexArray.shrink_to_fit();
+}
+
+//!(internal)
+BufferObject & MeshIndexData::getWritableBufferObject(){
+	if(bufferObject.isNull() || isBufferObjectShared()) {
+		bufferObject = new CountedBufferObject;
+		bufferObject->get().setMemoryCategory(MemoryRegistry::INDEX_BUFFER);
+	}
+	return bufferObject->get();
+}
+
+void MeshIndexData::_swapBufferObject(BufferObject & other){
+	if(bufferObject.isNull()) {
+		bufferObject = new CountedBufferObject;
+		bufferObject->get().setMemoryCategory(MemoryRegistry::INDEX_BUFFER);
+	}
+	bufferObject->get().swap(other);
 }
 
 void MeshIndexData::swap(MeshIndexData & other){
@@ -54,14 +114,19 @@ void MeshIndexData::swap(MeshIndexData & other){
 	swap(minIndex, other.minIndex);
 	swap(maxIndex, other.maxIndex);
 	swap(bufferObject, other.bufferObject);
+	arenaAllocation.swap(other.arenaAllocation);
 	swap(dataChanged, other.dataChanged);
+	swap(changedRanges, other.changedRanges);
+	swap(uploadedIndexSize, other.uploadedIndexSize);
+	swap(revision, other.revision);
 	swap(indexArray, other.indexArray);
 }
 
 void MeshIndexData::allocate(uint32_t count) {
 	indexCount = count;
-	indexArray.resize(indexCount, std::numeric_limits<uint32_t>::max());
-	indexArray.shrink_to_fit();
+	std::vector<uint32_t> & indices = indexArray.edit();
+	indices.resize(indexCount, std::numeric_limits<uint32_t>::max());
+	indices.shrink_to_fit();
 	markAsChanged();
 }
 
@@ -76,21 +141,101 @@ void MeshIndexData::updateIndexRange() {
 	}
 }
 
+void MeshIndexData::markAsChanged(uint32_t firstIndex, uint32_t count) {
+	if(firstIndex + count > indexCount)
+		throw std::out_of_range("MeshIndexData::markAsChanged: Invalid index range.");
+	if(!dataChanged) {
+		dataChanged = true;
+		changedRanges.clear();
+		changedRanges.add(firstIndex, count);
+	} else if(!changedRanges.empty()) { // otherwise, all indices are marked as changed already
+		changedRanges.add(firstIndex, count);
+	}
+	revision = createRevision();
+}
+
+//!	(internal)
+bool MeshIndexData::uploadChangedRanges(){
+	if(!dataChanged || changedRanges.empty() || indexArray.empty() || isBufferObjectShared())
+		return false;
+	uint32_t maxValue = 0;
+	for(const auto & range : changedRanges.getRanges())
+		maxValue = std::max(maxValue, *std::max_element(indexArray.begin() + range.begin, indexArray.begin() + range.end));
+	if(getCompactedIndexSize(maxValue) > uploadedIndexSize)
+		return false;
+
+	std::vector<uint8_t> compacted;
+	for(const auto & range : changedRanges.getRanges()) {
+		const std::size_t offset = static_cast<std::size_t>(range.begin) * uploadedIndexSize;
+		compacted.resize(static_cast<std::size_t>(range.size()) * uploadedIndexSize);
+		for(uint32_t i = 0; i < range.size(); ++i) {
+			const uint32_t value = indexArray[range.begin + i];
+			if(uploadedIndexSize == 1) {
+				compacted[i] = static_cast<uint8_t>(value);
+			} else if(uploadedIndexSize == 2) {
+				const uint16_t shortValue = static_cast<uint16_t>(value);
+				std::memcpy(compacted.data() + i * sizeof(uint16_t), &shortValue, sizeof(uint16_t));
+			} else {
+				std::memcpy(compacted.data() + i * sizeof(uint32_t), &value, sizeof(uint32_t));
+			}
+		}
+		if(isInArena())
+			arenaAllocation.getArena()->update(arenaAllocation.getHandle(), compacted.data(), compacted.size(), offset);
+		else
+			bufferObject->get().uploadSubData(GL_ELEMENT_ARRAY_BUFFER, compacted.data(), compacted.size(), offset);
+	}
+	GET_GL_ERROR()
+	changedRanges.clear();
+	return true;
+}
+
 bool MeshIndexData::upload() {
 	return upload(GL_STATIC_DRAW);
 }
 
 //!	(internal)
 bool MeshIndexData::upload(uint32_t usageHint){
-	if( isUploaded() )
+	if( isUploaded() && !indexArray.empty() && uploadChangedRanges() ) {
+		dataChanged = false;
+		return true;
+	}
+	changedRanges.clear();
+	if( isUploaded() || isInArena() )
 		removeGlBuffer();
 
 	if(indexCount == 0 || indexArray.empty() )
 		return false;
 
 	try {
-		bufferObject.uploadData(GL_ELEMENT_ARRAY_BUFFER, indexArray, usageHint);
-		GET_GL_ERROR()
+		uploadCompacted(indexCount, indexArray.data(), *std::max_element(indexArray.begin(), indexArray.end()), usageHint);
+	}
+	catch (...) {
+		WARN("VBO: upload failed");
+		removeGlBuffer();
+		return false;
+	}
+	dataChanged = false;
+	return true;
+}
+
+//!	(internal)
+bool MeshIndexData::_uploadExternal(uint32_t count, const uint32_t * indices, uint32_t usageHint){
+	if( isUploaded() || isInArena() )
+		removeGlBuffer();
+	releaseLocalData();
+	indexCount = count;
+	revision = createRevision();
+	if(count == 0) {
+		minIndex = 1;
+		maxIndex = 0;
+		return false;
+	}
+	auto minMaxPair = std::minmax_element(indices, indices + count);
+	minIndex = *minMaxPair.first;
+	maxIndex = *minMaxPair.second;
+
+	try {
+		uploadCompacted(count, indices, maxIndex, usageHint);
 	}
 	catch (...) {
 		WARN("VBO: upload failed");
@@ -101,11 +246,91 @@ bool MeshIndexData::upload(uint32_t usageHint){
 	return true;
 }
 
+//!	(internal)
+bool MeshIndexData::upload(BufferArena & arena){
+	if(indexCount == 0 || indexArray.empty() )
+		return false;
+	if( isInArena() && arenaAllocation.getArena() == &arena && uploadChangedRanges() ) {
+		dataChanged = false;
+		return true;
+	}
+	changedRanges.clear();
+	removeGlBuffer();
+
+	const uint8_t indexSize = getCompactedIndexSize(*std::max_element(indexArray.begin(), indexArray.end()));
+	try {
+		BufferArena::handle_t handle;
+		if(indexSize == 1) {
+			const std::vector<uint8_t> compacted(indexArray.begin(), indexArray.end());
+			handle = arena.upload(compacted.data(), compacted.size(), indexSize);
+		} else if(indexSize == 2) {
+			const std::vector<uint16_t> compacted(indexArray.begin(), indexArray.end());
+			handle = arena.upload(reinterpret_cast<const uint8_t *>(compacted.data()), compacted.size() * sizeof(uint16_t), indexSize);
+		} else {
+			handle = arena.upload(reinterpret_cast<const uint8_t *>(indexArray.data()), dataSize(), indexSize);
+		}
+		arenaAllocation = BufferArenaAllocation(&arena, handle);
+		uploadedIndexSize = indexSize;
+		GET_GL_ERROR()
+	}
+	catch (...) {
+		WARN("VBO: upload into arena failed");
+		removeGlBuffer();
+		return false;
+	}
+	dataChanged = false;
+	return true;
+}
+
+//!	(internal)
+std::size_t MeshIndexData::_bindBuffer()const{
+	if(isInArena()) {
+		arenaAllocation.getArena()->getBufferObject().bind(GL_ELEMENT_ARRAY_BUFFER);
+		return arenaAllocation.getOffset();
+	}
+	bufferObject->get().bind(GL_ELEMENT_ARRAY_BUFFER);
+	return 0;
+}
+
+//!	(internal)
+void MeshIndexData::_unbindBuffer()const{
+	if(isInArena())
+		arenaAllocation.getArena()->getBufferObject().unbind(GL_ELEMENT_ARRAY_BUFFER);
+	else
+		bufferObject->get().unbind(GL_ELEMENT_ARRAY_BUFFER);
+}
+
+//!	(static, internal)
+uint8_t MeshIndexData::getCompactedIndexSize(uint32_t maxValue) {
+	if(maxValue <= std::numeric_limits<uint8_t>::max() && minimumUploadedIndexSize <= 1)
+		return 1;
+	else if(maxValue <= std::numeric_limits<uint16_t>::max() && minimumUploadedIndexSize <= 2)
+		return 2;
+	return 4;
+}
+
+//!	(internal)
+void MeshIndexData::uploadCompacted(uint32_t count, const uint32_t * indices, uint32_t maxValue, uint32_t usageHint) {
+	uploadedIndexSize = getCompactedIndexSize(maxValue);
+	if(uploadedIndexSize == 1) {
+		const std::vector<uint8_t> compacted(indices, indices + count);
+		getWritableBufferObject().uploadData(GL_ELEMENT_ARRAY_BUFFER, compacted, usageHint);
+	} else if(uploadedIndexSize == 2) {
+		const std::vector<uint16_t> compacted(indices, indices + count);
+		getWritableBufferObject().uploadData(GL_ELEMENT_ARRAY_BUFFER, compacted, usageHint);
+	} else {
+		getWritableBufferObject().uploadData(GL_ELEMENT_ARRAY_BUFFER, reinterpret_cast<const uint8_t *>(indices), count * sizeof(uint32_t), usageHint);
+	}
+	GET_GL_ERROR()
+}
+
 //!	(internal)
 bool MeshIndexData::download(){
-	if(!isUploaded() || indexCount==0)
+	if((!isUploaded() && !isInArena()) || indexCount==0)
 		return false;
-	downloadTo(indexArray);
+	std::vector<uint32_t> downloadedData;
+	downloadTo(downloadedData);
+	indexArray.assign(std::move(downloadedData));
 	dataChanged = false;
 	return true;
 }
@@ -113,7 +338,36 @@ bool MeshIndexData::download(){
 //!	(internal)
 #ifdef LIB_GL
 void MeshIndexData::downloadTo(std::vector<uint32_t> & destination) const {
-	destination = bufferObject.downloadData<uint32_t>(GL_ELEMENT_ARRAY_BUFFER, getIndexCount());
+	if(isInArena()) {
+		const std::vector<uint8_t> bytes = arenaAllocation.getArena()->download(arenaAllocation.getHandle());
+		destination.resize(getIndexCount());
+		for(uint32_t i = 0; i < getIndexCount(); ++i) {
+			if(uploadedIndexSize == 1) {
+				destination[i] = bytes[i];
+			} else if(uploadedIndexSize == 2) {
+				uint16_t value;
+				std::memcpy(&value, bytes.data() + i * sizeof(uint16_t), sizeof(uint16_t));
+				destination[i] = value;
+			} else {
+				std::memcpy(&destination[i], bytes.data() + i * sizeof(uint32_t), sizeof(uint32_t));
+			}
+		}
+		return;
+	}
+	switch(uploadedIndexSize) {
+		case 1: {
+			const auto compacted = bufferObject->get().downloadData<uint8_t>(GL_ELEMENT_ARRAY_BUFFER, getIndexCount());
+			destination.assign(compacted.begin(), compacted.end());
+			break;
+		}
+		case 2: {
+			const auto compacted = bufferObject->get().downloadData<uint16_t>(GL_ELEMENT_ARRAY_BUFFER, getIndexCount());
+			destination.assign(compacted.begin(), compacted.end());
+			break;
+		}
+		default:
+			destination = bufferObject->get().downloadData<uint32_t>(GL_ELEMENT_ARRAY_BUFFER, getIndexCount());
+	}
 }
 #else
 void MeshIndexData::downloadTo(std::vector<uint32_t> & /*destination*/) const {
@@ -123,29 +377,72 @@ void MeshIndexData::downloadTo(std::vector<uint32_t> & /*destination*/) const {
 
 //!	(internal)
 void MeshIndexData::removeGlBuffer(){
-	bufferObject.destroy();
+	bufferObject = nullptr; // a buffer shared with copies is kept alive by them
+	arenaAllocation.release();
 }
 
+#ifdef LIB_GL
+//! (internal) glDrawRangeElements with an optional base vertex.
+static void drawRangeElements(uint32_t drawMode, uint32_t minIndex, uint32_t maxIndex, uint32_t count, uint32_t type, const void * indices, int32_t baseVertex) {
+#if defined(GL_ARB_draw_elements_base_vertex)
+	if(baseVertex != 0) {
+		glDrawRangeElementsBaseVertex(drawMode, minIndex, maxIndex, count, type, const_cast<void *>(indices), baseVertex);
+		return;
+	}
+#else
+	if(baseVertex != 0)
+		WARN("MeshIndexData::drawElements: A base vertex is not supported.");
+#endif
+	glDrawRangeElements(drawMode, minIndex, maxIndex, count, type, indices);
+}
+#endif
+
 /*! (internal) */
-void MeshIndexData::drawElements(bool useVBO,uint32_t drawMode,uint32_t startIndex,uint32_t numberOfIndices){
+void MeshIndexData::drawElements(bool useVBO,uint32_t drawMode,uint32_t startIndex,uint32_t numberOfIndices,int32_t baseVertex){
 	if(startIndex+numberOfIndices>getIndexCount())
 		throw std::out_of_range("MeshIndexData::drawElements: Accessing invalid index.");
-	
+
+	if(GLTrace::isRecording()) {
+		if(useVBO && isUploaded()) {
+			GLTrace::record(GLTrace::DRAW_ELEMENTS, {drawMode, numberOfIndices, getUploadedIndexType(), bufferObject->get().getGLId(),
+					static_cast<uint32_t>(uploadedIndexSize) * startIndex, static_cast<uint32_t>(baseVertex)});
+		} else if(isInArena()) {
+			GLTrace::record(GLTrace::DRAW_ELEMENTS, {drawMode, numberOfIndices, getUploadedIndexType(), arenaAllocation.getArena()->getBufferObject().getGLId(),
+					static_cast<uint32_t>(arenaAllocation.getOffset() + static_cast<std::size_t>(uploadedIndexSize)*startIndex), static_cast<uint32_t>(baseVertex)});
+		} else if(hasLocalData()) {
+			GLTrace::record(GLTrace::DRAW_ELEMENTS, {drawMode, numberOfIndices, static_cast<uint32_t>(GL_UNSIGNED_INT), 0u, 0u, static_cast<uint32_t>(baseVertex)},
+					indexArray.data() + startIndex, numberOfIndices * sizeof(uint32_t));
+		}
+	}
 #ifdef LIB_GL
 	if(useVBO && isUploaded()) { // VBO
-		bufferObject.bind(GL_ELEMENT_ARRAY_BUFFER);
-		glDrawRangeElements(drawMode, getMinIndex(), getMaxIndex(), numberOfIndices, GL_UNSIGNED_INT, reinterpret_cast<void*>(sizeof(GLuint)*startIndex));
-		bufferObject.unbind(GL_ELEMENT_ARRAY_BUFFER);
+		bufferObject->get().bind(GL_ELEMENT_ARRAY_BUFFER);
+		drawRangeElements(drawMode, getMinIndex(), getMaxIndex(), numberOfIndices, getUploadedIndexType(), reinterpret_cast<void*>(static_cast<std::size_t>(uploadedIndexSize)*startIndex), baseVertex);
+		bufferObject->get().unbind(GL_ELEMENT_ARRAY_BUFFER);
+	} else if(isInArena()) { // range of an arena
+		const BufferObject & arenaBuffer = arenaAllocation.getArena()->getBufferObject();
+		arenaBuffer.bind(GL_ELEMENT_ARRAY_BUFFER);
+		drawRangeElements(drawMode, getMinIndex(), getMaxIndex(), numberOfIndices, getUploadedIndexType(),
+							reinterpret_cast<void*>(arenaAllocation.getOffset() + static_cast<std::size_t>(uploadedIndexSize)*startIndex), baseVertex);
+		arenaBuffer.unbind(GL_ELEMENT_ARRAY_BUFFER);
 	} else if(hasLocalData()) { // VertexArray
-		glDrawRangeElements(drawMode, getMinIndex(), getMaxIndex(), numberOfIndices, GL_UNSIGNED_INT, reinterpret_cast<void*>(data()+startIndex));
+		drawRangeElements(drawMode, getMinIndex(), getMaxIndex(), numberOfIndices, GL_UNSIGNED_INT, indexArray.data()+startIndex, baseVertex);
 	}
 #else
+	if(baseVertex != 0)
+		WARN("MeshIndexData::drawElements: A base vertex is not supported.");
 	if (useVBO && isUploaded()) { // VBO
-		bufferObject.bind(GL_ELEMENT_ARRAY_BUFFER);
-		glDrawElements(drawMode, numberOfIndices, GL_UNSIGNED_INT, reinterpret_cast<void*>(sizeof(GLuint)*startIndex));
-		bufferObject.unbind(GL_ELEMENT_ARRAY_BUFFER);
+		bufferObject->get().bind(GL_ELEMENT_ARRAY_BUFFER);
+		glDrawElements(drawMode, numberOfIndices, getUploadedIndexType(), reinterpret_cast<void*>(static_cast<std::size_t>(uploadedIndexSize)*startIndex));
+		bufferObject->get().unbind(GL_ELEMENT_ARRAY_BUFFER);
+	} else if (isInArena()) { // range of an arena
+		const BufferObject & arenaBuffer = arenaAllocation.getArena()->getBufferObject();
+		arenaBuffer.bind(GL_ELEMENT_ARRAY_BUFFER);
+		glDrawElements(drawMode, numberOfIndices, getUploadedIndexType(),
+						reinterpret_cast<void*>(arenaAllocation.getOffset() + static_cast<std::size_t>(uploadedIndexSize)*startIndex));
+		arenaBuffer.unbind(GL_ELEMENT_ARRAY_BUFFER);
 	} else if (hasLocalData()) { // VertexArray
-		glDrawElements(drawMode, numberOfIndices, GL_UNSIGNED_INT, reinterpret_cast<void*>(data()+startIndex));
+		glDrawElements(drawMode, numberOfIndices, GL_UNSIGNED_INT, indexArray.data()+startIndex);
 	}
 #endif
 }
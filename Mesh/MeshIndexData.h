@@ -11,7 +11,11 @@
 #ifndef RENDERING_MESHINDEXDATA_H
 #define RENDERING_MESHINDEXDATA_H
 
+#include "../BufferArena.h"
 #include "../BufferObject.h"
+#include "CopyOnWriteArray.h"
+#include "DirtyRangeSet.h"
+#include <Util/References.h>
 #include <cstddef>
 #include <cstdint>
 #include <vector>
@@ -19,11 +23,14 @@
 namespace Rendering {
 
 /*! IndexData-Class .
-	Part of the Mesh implementation containing all index specific data of a mesh. */
+	Part of the Mesh implementation containing all index specific data of a mesh.
+	Copies share the local data and, if the data is unchanged, the index buffer until one of them is changed
+	(copy-on-write).	*/
 class MeshIndexData {
 	public:
 		MeshIndexData();
-		//! Copy all data from @p other
+		/*! Copy all data from @p other. The local data is shared with @p other until one of them is changed.
+			If the index buffer of @p other is up to date, it is shared as well.	*/
 		MeshIndexData(const MeshIndexData & other);
 		MeshIndexData(MeshIndexData &&) = default;
 
@@ -40,14 +47,28 @@ class MeshIndexData {
 		void allocate(uint32_t count);
 		void releaseLocalData();
 		const uint32_t * data() const						{	return indexArray.data();	}
-		uint32_t * data() 									{	return indexArray.data();	}
+		//! \note Creates an own copy of the local data if it is shared with a copy of this object.
+		uint32_t * data() 									{	return indexArray.edit().data();	}
 		std::size_t dataSize() const						{	return indexArray.size() * sizeof(uint32_t);	}
-		void markAsChanged()								{  	dataChanged=true;	}
+		//! Size in bytes of the local data shared with copies of this object (0 if the data is not shared).
+		std::size_t getSharedDataSize()const				{	return indexArray.isShared() ? dataSize() : 0;	}
+		//! Size in bytes of the index buffer shared with copies of this object (0 if the buffer is not shared).
+		std::size_t getSharedBufferSize()const				{	return isBufferObjectShared() ? getUploadedDataSize() : 0;	}
+		void markAsChanged()								{  	dataChanged=true;	changedRanges.clear();	revision=createRevision();	}
+		/*! Mark only the indices [@p firstIndex, @p firstIndex + @p count) as changed. If the data is uploaded
+			again, only the changed ranges are transferred into the existing buffer (unless a larger index type is required).
+			@throw std::out_of_range if the range exceeds the index count.	*/
+		void markAsChanged(uint32_t firstIndex, uint32_t count);
+		//! Changed index ranges; empty if all indices have changed (or nothing has changed, see hasChanged()).
+		const DirtyRangeSet & getChangedRanges()const		{	return changedRanges;	}
 		bool hasChanged()const								{  	return dataChanged;	}
+		/*! Revision of the data: a number that changes (to a value unique among all MeshIndexData objects) whenever
+			the data is allocated or marked as changed. */
+		uint64_t getRevision()const							{	return revision;	}
 		bool hasLocalData()const							{  	return !indexArray.empty();	}
 
 		const uint32_t & operator[](uint32_t index) const	{	return indexArray[index]; }
-		uint32_t & operator[](uint32_t index) 				{	return indexArray[index]; }
+		uint32_t & operator[](uint32_t index) 				{	return indexArray.edit()[index]; }
 
 		// index range
 		inline uint32_t getMinIndex() const 				{   return minIndex;    }
@@ -57,34 +78,92 @@ class MeshIndexData {
 		void updateIndexRange();
 
 		// vbo
-		inline bool isUploaded()const						{   return bufferObject.isValid();    }
+		inline bool isUploaded()const						{   return bufferObject.isNotNull() && bufferObject->get().isValid();    }
+
+		/*! Size in bytes (1, 2 or 4) of a single index inside the uploaded buffer.
+			The local data always uses 32 bit indices; when uploading, the smallest index type that can hold all
+			indices (but not smaller than getMinimumUploadedIndexSize()) is chosen.	*/
+		uint8_t getUploadedIndexSize()const					{	return uploadedIndexSize;	}
+		//! OpenGL data type (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT) of the uploaded indices.
+		uint32_t getUploadedIndexType()const;
+		//! Size in bytes of the uploaded buffer (0 if not uploaded).
+		std::size_t getUploadedDataSize()const				{	return isUploaded() || isInArena() ? static_cast<std::size_t>(indexCount) * uploadedIndexSize : 0;	}
+
+		/*! (static) Set the smallest index size (1, 2 or 4 bytes) used for uploaded buffers. The default is 2, as
+			8 bit indices are emulated in software by several drivers. 4 disables the compaction.	*/
+		static void setMinimumUploadedIndexSize(uint8_t size);
+		static uint8_t getMinimumUploadedIndexSize();
 
 		//! Call @a upload() with default usage hint.
 		bool upload();
 		/*! (internal) Create or update a VBO if hasChanged is set to true.
 			hasChanged is set to false.	*/
 		bool upload(uint32_t usageHint);
+		/*! (internal) Create a VBO directly from external memory (e.g. a memory-mapped file) without creating
+			a local copy. Existing local data is released and the index range is calculated from @p indices.	*/
+		bool _uploadExternal(uint32_t count, const uint32_t * indices, uint32_t usageHint);
+		/*! (internal) Copy the (compacted) local data into a range of the given arena instead of creating a VBO of its
+			own (an existing VBO is removed).
+			\note The indices are not offset by MeshVertexData::getArenaBaseVertex(); drawElements() draws them
+				relative to the vertex data bound before.	*/
+		bool upload(BufferArena & arena);
+		//! @c true iff the data is stored in a BufferArena.
+		bool isInArena()const								{	return arenaAllocation.isValid();	}
+		const BufferArenaAllocation & _getArenaAllocation()const	{	return arenaAllocation;	}
+		//! (internal) The buffer containing the uploaded indices, or @c nullptr if they have not been uploaded into a buffer of its own.
+		const BufferObject * _getBufferObject()const		{	return isUploaded() ? &bufferObject->get() : nullptr;	}
+		/*! (internal) Bind the buffer holding the uploaded indices (own VBO or arena) to GL_ELEMENT_ARRAY_BUFFER.
+			\return The byte offset of the first index inside the buffer.	*/
+		std::size_t _bindBuffer()const;
+		void _unbindBuffer()const;
 		/*! (internal) */
 		bool download();
 		void downloadTo(std::vector<uint32_t> & destination) const;
+		/*! (internal) Restore the released local copy of the uploaded data (e.g. from a compressed copy).
+			@p data has to be equal to the uploaded data; neither the data is marked as changed nor the revision is changed. */
+		void _restoreLocalData(std::vector<uint32_t> && data)	{	indexArray.assign(std::move(data));	}
 		/*! (internal) */
 		void removeGlBuffer();
 		/*! (internal) Draw the vertices referenced by the indices using the VBO or a VertexArray.
+			@p baseVertex is added to each index (requires GL_ARB_draw_elements_base_vertex).
 			Used by MeshDataStrategy::doDisplay(..) */
-		void drawElements(bool useVBO,uint32_t drawMode,uint32_t startIndex,uint32_t numberOfIndices);
+		void drawElements(bool useVBO,uint32_t drawMode,uint32_t startIndex,uint32_t numberOfIndices,int32_t baseVertex = 0);
 
 		/*! Swap the internal BufferObject.
 			\note The local data is not changed!
 			\note the size of the new buffer must be equal to that of the old one.
+			\note The indices inside the buffer have the type getUploadedIndexType().
+			\note The buffer may be shared with copies of this object (see getSharedBufferSize()).
 			\note Use only if you know what you are doing!	*/
-		void _swapBufferObject(BufferObject & other)	{	bufferObject.swap(other);	}
+		void _swapBufferObject(BufferObject & other);
 	private:
 		uint32_t indexCount;
-		std::vector<uint32_t> indexArray;
+		CopyOnWriteArray<uint32_t> indexArray;
 		uint32_t minIndex;
 		uint32_t maxIndex;
-		BufferObject bufferObject;
+		Util::Reference<CountedBufferObject> bufferObject;
+		BufferArenaAllocation arenaAllocation;
 		bool dataChanged;
+		//! If dataChanged is set and this is not empty, only the indices in these ranges have been changed.
+		DirtyRangeSet changedRanges;
+		uint8_t uploadedIndexSize;
+		uint64_t revision;
+
+		/*! (internal) Upload only the changed ranges into the existing VBO (or arena range).
+			Returns false if the whole data has to be uploaded.	*/
+		bool uploadChangedRanges();
+		/*! (internal) The buffer object to upload data into. If the buffer object is shared with a copy (or there is
+			none), a new one is created.	*/
+		BufferObject & getWritableBufferObject();
+		//! (internal) @c true iff the index buffer is shared with a copy.
+		bool isBufferObjectShared()const					{	return bufferObject.isNotNull() && bufferObject->countReferences() > 1;	}
+		//! (internal) Smallest allowed index size (1, 2 or 4 bytes) that can hold @p maxValue.
+		static uint8_t getCompactedIndexSize(uint32_t maxValue);
+		//! (internal) Upload @p count indices with values up to @p maxValue in the smallest allowed index type.
+		void uploadCompacted(uint32_t count, const uint32_t * indices, uint32_t maxValue, uint32_t usageHint);
+
+		//! (internal) Return a new, globally unique revision number.
+		static uint64_t createRevision();
 };
 }
 
@@ -12,19 +12,37 @@
 #include "VertexAttributeIds.h"
 #include "VertexDescription.h"
 #include "VertexAttributeAccessors.h"
+#include "TypedAttributeView.h"
+#include "../InstanceBuffer.h"
+#include "../MemoryRegistry.h"
 #include "../Shader/Shader.h"
 #include "../RenderingContext/RenderingContext.h"
 #include "../GLHeader.h"
+#include "../GLTrace.h"
 #include "../Helper.h"
+#include "../TaskScheduler.h"
 #include <Util/Macros.h>
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <set>
+#include <stdexcept>
 #include <vector>
 #include <utility>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define RENDERING_BOUNDS_SSE2
+	#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define RENDERING_BOUNDS_NEON
+	#include <arm_neon.h>
+#endif
+
 namespace Rendering{
 
 
@@ -36,31 +54,73 @@ void MeshVertexData::setVertexDescription(const VertexDescription & vd){
 	static std::set<VertexDescription> descriptionCollections;
 	std::pair<std::set<VertexDescription>::iterator,bool> result = descriptionCollections.insert(vd);
 	vertexDescription = &*(result.first);
+	vaoCache.clear();
 }
 
 // ---------------------------
 
 //! (ctor)
 MeshVertexData::MeshVertexData() :
-	binaryData(), vertexDescription(nullptr), vertexCount(0), bufferObject(), bb(), dataChanged(false) {
+	binaryData(), vertexDescription(nullptr), vertexCount(0), bufferObject(), vaoCache(), vaoBound(false),
+	streamingBuffer(), streamingRange(), arenaAllocation(), bb(), boundingBoxVertexCount(0), boundingBoxState(BOUNDING_BOX_VALID), dataChanged(false), changedRanges(), revision(0), layout(INTERLEAVED) {
 	setVertexDescription(VertexDescription());
 }
 
 //! (ctor)
 MeshVertexData::MeshVertexData(const MeshVertexData & other) :
-	binaryData(), vertexDescription(other.vertexDescription), vertexCount(other.getVertexCount()), bufferObject(), bb(other.getBoundingBox()), dataChanged(true) {
+	binaryData(), vertexDescription(other.vertexDescription), vertexCount(other.getVertexCount()), bufferObject(), vaoCache(), vaoBound(false),
+	streamingBuffer(), streamingRange(), arenaAllocation(), bb(other.getBoundingBox()),
+	boundingBoxVertexCount(other.boundingBoxVertexCount), boundingBoxState(other.boundingBoxState), dataChanged(true), changedRanges(), revision(other.revision), layout(other.layout) {
+	if(other.isUploaded() && !other.hasChanged()) {
+		bufferObject = other.bufferObject;
+		dataChanged = false;
+	}
 	if(other.hasLocalData()) {
 		binaryData = other.binaryData;
-	} else if(other.isUploaded()) {
-		other.downloadTo(binaryData);
+	} else if(isUploaded()) {
+		// the data is downloaded from the shared buffer when it is needed
+	} else if(other.isUploaded() || other.isInArena()) {
+		std::vector<uint8_t> downloadedData;
+		other.downloadTo(downloadedData);
+		binaryData.assign(std::move(downloadedData));
 	} else {
 		WARN("Cannot access vertex data."); // should not happen
 	}
 }
 
+//! (static, internal)
+uint64_t MeshVertexData::createRevision() {
+	static std::atomic<uint64_t> lastRevision(0);
+	return ++lastRevision;
+}
+
 void MeshVertexData::releaseLocalData(){
-	binaryData.resize(0);
-	binaryData.shrink_to_fit();
+	// the box can not be calculated without the local data
+	refreshBoundingBox();
+	binaryData.clear();
+}
+
+size_t MeshVertexData::getSharedBufferSize()const{
+	return isBufferObjectShared() && isUploaded() ? static_cast<size_t>(getVertexDescription().getVertexSize()) * vertexCount : 0;
+}
+
+//! (internal)
+BufferObject & MeshVertexData::getWritableBufferObject(){
+	if(bufferObject.isNull() || isBufferObjectShared()) {
+		bufferObject = new CountedBufferObject;
+		bufferObject->get().setMemoryCategory(MemoryRegistry::VERTEX_BUFFER);
+		vaoCache.clear();
+	}
+	return bufferObject->get();
+}
+
+void MeshVertexData::_swapBufferObject(BufferObject & other){
+	if(bufferObject.isNull()) {
+		bufferObject = new CountedBufferObject;
+		bufferObject->get().setMemoryCategory(MemoryRegistry::VERTEX_BUFFER);
+	}
+	bufferObject->get().swap(other);
+	vaoCache.clear();
 }
 
 void MeshVertexData::swap(MeshVertexData & other){
@@ -71,16 +131,62 @@ void MeshVertexData::swap(MeshVertexData & other){
 	swap(vertexDescription, other.vertexDescription);
 	swap(vertexCount, other.vertexCount);
 	swap(bufferObject, other.bufferObject);
+	vaoCache.swap(other.vaoCache);
+	swap(streamingBuffer, other.streamingBuffer);
+	swap(streamingRange, other.streamingRange);
+	arenaAllocation.swap(other.arenaAllocation);
 	swap(bb, other.bb);
+	swap(boundingBoxVertexCount, other.boundingBoxVertexCount);
+	swap(boundingBoxState, other.boundingBoxState);
 	swap(dataChanged, other.dataChanged);
+	swap(changedRanges, other.changedRanges);
+	swap(revision, other.revision);
+	swap(layout, other.layout);
 	swap(binaryData, other.binaryData);
 }
 
+void MeshVertexData::setLayout(layout_t newLayout) {
+	if(newLayout == layout)
+		return;
+	if(!hasLocalData() && isUploaded())
+		download();
+	if(hasLocalData()) {
+		const std::size_t vertexSize = getVertexDescription().getVertexSize();
+		std::vector<uint8_t> newData(binaryData.size());
+		for(const auto & attr : getVertexDescription().getAttributes()) {
+			if(attr.empty())
+				continue;
+			const std::size_t interleavedOffset = attr.getOffset();
+			const std::size_t separateOffset = static_cast<std::size_t>(attr.getOffset()) * vertexCount;
+			const bool toSeparate = newLayout == SEPARATE;
+			const uint8_t * source = binaryData.data() + (toSeparate ? interleavedOffset : separateOffset);
+			uint8_t * target = newData.data() + (toSeparate ? separateOffset : interleavedOffset);
+			const std::size_t sourceStride = toSeparate ? vertexSize : attr.getDataSize();
+			const std::size_t targetStride = toSeparate ? attr.getDataSize() : vertexSize;
+			for(uint32_t i = 0; i < vertexCount; ++i, source += sourceStride, target += targetStride)
+				std::memcpy(target, source, attr.getDataSize());
+		}
+		binaryData.assign(std::move(newData));
+	}
+	layout = newLayout;
+	vaoCache.clear();
+	markAsChanged();
+}
+
+std::size_t MeshVertexData::getAttributeOffset(const VertexAttribute & attr) const {
+	return layout == INTERLEAVED ? attr.getOffset() : static_cast<std::size_t>(attr.getOffset()) * vertexCount;
+}
+
+std::size_t MeshVertexData::getAttributeStride(const VertexAttribute & attr) const {
+	return layout == INTERLEAVED ? getVertexDescription().getVertexSize() : attr.getDataSize();
+}
+
 void MeshVertexData::allocate(uint32_t count, const VertexDescription & vd){
 	setVertexDescription(vd);
 	vertexCount = count;
-	binaryData.resize(vd.getVertexSize() * count);
-	binaryData.shrink_to_fit();
+	std::vector<uint8_t> & values = binaryData.edit();
+	values.resize(vd.getVertexSize() * count);
+	values.shrink_to_fit();
 	markAsChanged();
 }
 
@@ -90,47 +196,238 @@ const uint8_t * MeshVertexData::operator[](uint32_t index) const {
 }
 
 uint8_t * MeshVertexData::operator[](uint32_t index) {
-	return binaryData.data() + index * vertexDescription->getVertexSize();
+	return binaryData.edit().data() + index * vertexDescription->getVertexSize();
 }
 
-void MeshVertexData::updateBoundingBox() {
-	if (vertexCount == 0) {
-		bb = Geometry::Box();
+//! Vertices whose positions are processed by one task when calculating the bounding box.
+static const uint32_t BOUNDS_CHUNK_SIZE = 65536;
+
+/*! (internal) Update @p min and @p max by @p count float triples with the given stride (the data may be unaligned).
+	All but the last triple are loaded as four floats; the stride is at least twelve bytes, so this stays inside of the data. */
+static void accumulateBounds3f(const uint8_t * data, std::size_t stride, uint32_t count, float min[3], float max[3]) {
+	if(count == 0)
 		return;
+#if defined(RENDERING_BOUNDS_SSE2)
+	__m128 min0 = _mm_setr_ps(min[0], min[1], min[2], 0.0f), max0 = _mm_setr_ps(max[0], max[1], max[2], 0.0f);
+	__m128 min1 = min0, max1 = max0;
+	uint32_t i = 0;
+	for(; i + 2 < count; i += 2, data += 2 * stride) {
+		const __m128 a = _mm_loadu_ps(reinterpret_cast<const float *>(data));
+		const __m128 b = _mm_loadu_ps(reinterpret_cast<const float *>(data + stride));
+		min0 = _mm_min_ps(min0, a);
+		max0 = _mm_max_ps(max0, a);
+		min1 = _mm_min_ps(min1, b);
+		max1 = _mm_max_ps(max1, b);
 	}
-	const VertexDescription & vd=getVertexDescription();	
-	auto acc = FloatAttributeAccessor::create(*this, VertexAttributeIds::POSITION);
-	
-	const VertexAttribute & attr = vd.getAttribute(VertexAttributeIds::POSITION);
-	const uint8_t vertexNum = attr.getNumValues();
-	if (vertexNum < 1) {
-		WARN(std::string("Vertex component count is zero."));
+	for(; i < count; ++i, data += stride) {
+		float v[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+		std::memcpy(v, data, 3 * sizeof(float));
+		const __m128 a = _mm_loadu_ps(v);
+		min0 = _mm_min_ps(min0, a);
+		max0 = _mm_max_ps(max0, a);
+	}
+	float resultMin[4], resultMax[4];
+	_mm_storeu_ps(resultMin, _mm_min_ps(min0, min1));
+	_mm_storeu_ps(resultMax, _mm_max_ps(max0, max1));
+	std::copy(resultMin, resultMin + 3, min);
+	std::copy(resultMax, resultMax + 3, max);
+#elif defined(RENDERING_BOUNDS_NEON)
+	const float initialMin[4] = {min[0], min[1], min[2], 0.0f};
+	const float initialMax[4] = {max[0], max[1], max[2], 0.0f};
+	float32x4_t vMin = vld1q_f32(initialMin), vMax = vld1q_f32(initialMax);
+	for(uint32_t i = 0; i + 1 < count; ++i, data += stride) {
+		const float32x4_t a = vld1q_f32(reinterpret_cast<const float *>(data));
+		vMin = vminq_f32(vMin, a);
+		vMax = vmaxq_f32(vMax, a);
+	}
+	float v[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+	std::memcpy(v, data, 3 * sizeof(float));
+	vMin = vminq_f32(vMin, vld1q_f32(v));
+	vMax = vmaxq_f32(vMax, vld1q_f32(v));
+	float resultMin[4], resultMax[4];
+	vst1q_f32(resultMin, vMin);
+	vst1q_f32(resultMax, vMax);
+	std::copy(resultMin, resultMin + 3, min);
+	std::copy(resultMax, resultMax + 3, max);
+#else
+	for(uint32_t i = 0; i < count; ++i, data += stride) {
+		float p[3];
+		std::memcpy(p, data, sizeof(p));
+		for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+			min[dim] = std::min(min[dim], p[dim]);
+			max[dim] = std::max(max[dim], p[dim]);
+		}
+	}
+#endif
+}
+
+//! (internal) accumulateBounds3f() split into chunks processed by the TaskScheduler.
+static void accumulateBounds3fParallel(const uint8_t * data, std::size_t stride, uint32_t count, float min[3], float max[3]) {
+	TaskScheduler & scheduler = TaskScheduler::get();
+	const uint32_t numChunks = (count + BOUNDS_CHUNK_SIZE - 1) / BOUNDS_CHUNK_SIZE;
+	if(numChunks < 2 || scheduler.getNumWorkers() == 0) {
+		accumulateBounds3f(data, stride, count, min, max);
 		return;
 	}
-	
-	// The following implementation calculates minima and maxima for the coordinates.
-	// This is faster than calling Geometry::Box::include for each vertex.
-	std::vector<float> min(vertexNum, std::numeric_limits<float>::max());
-	std::vector<float> max(vertexNum, std::numeric_limits<float>::lowest());
-	for (uint_fast32_t i = 0; i < vertexCount; ++i) {
-		auto p = acc->getValues(i);
-		for (uint_fast8_t dim = 0; dim < vertexNum; ++dim) {
-			if (p[dim] < min[dim]) {
-				min[dim] = p[dim];
-			}
-			if (p[dim] > max[dim]) {
-				max[dim] = p[dim];
+	std::vector<std::array<float, 6>> chunkBounds(numChunks);
+	scheduler.parallelFor(numChunks, [&](uint32_t beginChunk, uint32_t endChunk) {
+		for(uint32_t chunk = beginChunk; chunk < endChunk; ++chunk) {
+			std::array<float, 6> & bounds = chunkBounds[chunk];
+			std::copy(min, min + 3, bounds.begin());
+			std::copy(max, max + 3, bounds.begin() + 3);
+			const uint32_t begin = chunk * BOUNDS_CHUNK_SIZE;
+			accumulateBounds3f(data + begin * stride, stride, std::min(BOUNDS_CHUNK_SIZE, count - begin), bounds.data(), bounds.data() + 3);
+		}
+	}, 1, "MeshVertexData::updateBoundingBox");
+	for(const auto & bounds : chunkBounds) {
+		for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+			min[dim] = std::min(min[dim], bounds[dim]);
+			max[dim] = std::max(max[dim], bounds[dim + 3]);
+		}
+	}
+}
+
+//! (internal) Update @p min and @p max by the first @p numValues values of type @p value_t of @p count vertices.
+template<typename value_t>
+static void accumulateBounds(const uint8_t * data, std::size_t stride, uint32_t count, uint8_t numValues, float min[3], float max[3]) {
+	for(uint32_t i = 0; i < count; ++i, data += stride) {
+		value_t p[3];
+		std::memcpy(p, data, numValues * sizeof(value_t));
+		for(uint_fast8_t dim = 0; dim < numValues; ++dim) {
+			const float value = AttributeValueTraits<value_t>::toFloat(p[dim]);
+			min[dim] = std::min(min[dim], value);
+			max[dim] = std::max(max[dim], value);
+		}
+	}
+}
+
+//! (internal)
+bool MeshVertexData::calculatePositionBounds(uint32_t begin, uint32_t end, float min[3], float max[3], uint8_t & numValues)const {
+	const VertexAttribute & attr = getVertexDescription().getAttribute(VertexAttributeIds::POSITION);
+	numValues = std::min<uint8_t>(attr.getNumValues(), 3);
+	if(attr.empty() || numValues == 0 || !hasLocalData())
+		return false;
+	std::fill(min, min + 3, std::numeric_limits<float>::max());
+	std::fill(max, max + 3, std::numeric_limits<float>::lowest());
+	const std::size_t stride = getAttributeStride(attr);
+	const uint8_t * first = data() + getAttributeOffset(attr) + begin * stride;
+	const uint32_t count = end - begin;
+	switch(attr.getDataType()) {
+		case GL_FLOAT:
+			if(numValues == 3 && stride >= 3 * sizeof(float))
+				accumulateBounds3fParallel(first, stride, count, min, max);
+			else
+				accumulateBounds<float>(first, stride, count, numValues, min, max);
+			return true;
+		case GL_UNSIGNED_BYTE:		accumulateBounds<uint8_t>(first, stride, count, numValues, min, max);	return true;
+		case GL_BYTE:				accumulateBounds<int8_t>(first, stride, count, numValues, min, max);	return true;
+		case GL_UNSIGNED_SHORT:		accumulateBounds<uint16_t>(first, stride, count, numValues, min, max);	return true;
+		case GL_SHORT:				accumulateBounds<int16_t>(first, stride, count, numValues, min, max);	return true;
+		case GL_UNSIGNED_INT:		accumulateBounds<uint32_t>(first, stride, count, numValues, min, max);	return true;
+		case GL_INT:				accumulateBounds<int32_t>(first, stride, count, numValues, min, max);	return true;
+		case GL_HALF_FLOAT:
+			for(uint32_t i = 0; i < count; ++i, first += stride) {
+				uint16_t p[3];
+				std::memcpy(p, first, numValues * sizeof(uint16_t));
+				for(uint_fast8_t dim = 0; dim < numValues; ++dim) {
+					const float value = Geometry::Convert::halfToFloat(p[dim]);
+					min[dim] = std::min(min[dim], value);
+					max[dim] = std::max(max[dim], value);
+				}
 			}
+			return true;
+		default:
+			return false;
+	}
+}
+
+//! (internal)
+void MeshVertexData::refreshBoundingBox()const {
+	if(boundingBoxState == BOUNDING_BOX_VALID)
+		return;
+	if(vertexCount == 0) {
+		bb = Geometry::Box();
+	} else if(!hasLocalData()) {
+		return; // keep the old box until the data is available again
+	} else {
+		// only the new vertices have to be included if the box is extended
+		const bool extend = boundingBoxState == BOUNDING_BOX_GROWN && boundingBoxVertexCount > 0 && boundingBoxVertexCount <= vertexCount;
+		const uint32_t begin = extend ? boundingBoxVertexCount : 0;
+		float min[3], max[3];
+		uint8_t numValues = 0;
+		if(begin < vertexCount && calculatePositionBounds(begin, vertexCount, min, max, numValues)) {
+			for(uint_fast8_t dim = numValues; dim < 3; ++dim)
+				min[dim] = max[dim] = 0.0f;
+			const Geometry::Box box(min[0], max[0], min[1], max[1], min[2], max[2]);
+			if(extend)
+				bb.include(box);
+			else
+				bb = box;
 		}
 	}
+	boundingBoxVertexCount = vertexCount;
+	boundingBoxState = BOUNDING_BOX_VALID;
+}
+
+void MeshVertexData::updateBoundingBox() {
+	const VertexAttribute & attr = getVertexDescription().getAttribute(VertexAttributeIds::POSITION);
+	if(vertexCount > 0 && attr.getNumValues() < 1) {
+		WARN(std::string("Vertex component count is zero."));
+		return;
+	}
+	boundingBoxState = BOUNDING_BOX_INVALID;
+	refreshBoundingBox();
+}
 
-	if (vertexNum == 1) {
-		bb = Geometry::Box(min[0], max[0], 0.0f, 0.0f, 0.0f, 0.0f);
-	} else if (vertexNum == 2) {
-		bb = Geometry::Box(min[0], max[0], min[1], max[1], 0.0f, 0.0f);
+void MeshVertexData::invalidateBoundingBox(uint32_t firstVertex, uint32_t count) {
+	if(count == 0)
+		return;
+	if(boundingBoxState != BOUNDING_BOX_INVALID && firstVertex >= boundingBoxVertexCount)
+		boundingBoxState = BOUNDING_BOX_GROWN;
+	else
+		boundingBoxState = BOUNDING_BOX_INVALID;
+}
+
+void MeshVertexData::markAsChanged(uint32_t firstVertex, uint32_t count) {
+	if(firstVertex + count > vertexCount)
+		throw std::out_of_range("MeshVertexData::markAsChanged: Invalid vertex range.");
+	if(!dataChanged) {
+		dataChanged = true;
+		changedRanges.clear();
+		changedRanges.add(firstVertex, count);
+	} else if(!changedRanges.empty()) { // otherwise, all vertices are marked as changed already
+		changedRanges.add(firstVertex, count);
+	}
+	revision = createRevision();
+}
+
+//! (internal)
+bool MeshVertexData::uploadChangedRanges() {
+	if(!dataChanged || changedRanges.empty() || binaryData.empty() || isBufferObjectShared())
+		return false;
+	std::vector<std::pair<std::size_t, std::size_t>> spans; // (offset, size) in bytes
+	if(layout == INTERLEAVED) {
+		const std::size_t vertexSize = getVertexDescription().getVertexSize();
+		for(const auto & range : changedRanges.getRanges())
+			spans.emplace_back(range.begin * vertexSize, range.size() * vertexSize);
 	} else {
-		bb = Geometry::Box(min[0], max[0], min[1], max[1], min[2], max[2]);
+		for(const auto & attr : getVertexDescription().getAttributes()) {
+			if(attr.empty())
+				continue;
+			const std::size_t stride = getAttributeStride(attr);
+			for(const auto & range : changedRanges.getRanges())
+				spans.emplace_back(getAttributeOffset(attr) + range.begin * stride, range.size() * stride);
+		}
 	}
+	for(const auto & span : spans) {
+		if(isInArena())
+			arenaAllocation.getArena()->update(arenaAllocation.getHandle(), binaryData.data() + span.first, span.second, span.first);
+		else
+			bufferObject->get().uploadSubData(GL_ARRAY_BUFFER, binaryData.data() + span.first, span.second, span.first);
+	}
+	GET_GL_ERROR()
+	changedRanges.clear();
+	return true;
 }
 
 bool MeshVertexData::upload() {
@@ -140,12 +437,104 @@ bool MeshVertexData::upload() {
 bool MeshVertexData::upload(uint32_t usageHint){
 	if(vertexCount == 0 || binaryData.empty() )
 		return false;
-		
-	if( isUploaded() )
+
+	if( isUploaded() && uploadChangedRanges() ) {
+		dataChanged = false;
+		return true;
+	}
+	changedRanges.clear();
+	if( isUploaded() || streamingBuffer.isNotNull() || isInArena() )
+		removeGlBuffer();
+
+	try {
+		getWritableBufferObject().uploadData(GL_ARRAY_BUFFER, binaryData.data(), binaryData.size(), usageHint);
+		GET_GL_ERROR()
+	}
+	catch (...) {
+		WARN("VBO: upload failed");
 		removeGlBuffer();
+		return false;
+	}
+	dataChanged = false;
+	return true;
+}
+
+bool MeshVertexData::upload(StreamingBuffer & buffer){
+	if(vertexCount == 0 || binaryData.empty() )
+		return false;
+
+	const StreamingBuffer::Range range = buffer.upload(binaryData.data(), binaryData.size());
+	if(!range.isValid())
+		return false;
+	if( isUploaded() || isInArena() )
+		removeGlBuffer();
+	streamingBuffer = &buffer;
+	streamingRange = range;
+	dataChanged = false;
+	return true;
+}
+
+bool MeshVertexData::upload(BufferArena & arena){
+	if(vertexCount == 0 || binaryData.empty() )
+		return false;
+
+	try {
+		if( isInArena() && arenaAllocation.getArena() == &arena && arenaAllocation.getSize() == binaryData.size() ) {
+			if(!uploadChangedRanges())
+				arena.update(arenaAllocation.getHandle(), binaryData.data(), binaryData.size());
+		} else {
+			removeGlBuffer();
+			const BufferArena::handle_t handle = arena.upload(binaryData.data(), binaryData.size(), getVertexDescription().getVertexSize());
+			arenaAllocation = BufferArenaAllocation(&arena, handle);
+		}
+		GET_GL_ERROR()
+	}
+	catch (...) {
+		WARN("VBO: upload into arena failed");
+		removeGlBuffer();
+		return false;
+	}
+	dataChanged = false;
+	return true;
+}
+
+uint32_t MeshVertexData::getArenaBaseVertex()const{
+	if(!isInArena() || getVertexDescription().getVertexSize() == 0)
+		return 0;
+	return static_cast<uint32_t>(arenaAllocation.getOffset() / getVertexDescription().getVertexSize());
+}
+
+bool MeshVertexData::_uploadExternal(uint32_t count, const VertexDescription & vd, const uint8_t * vertices, uint32_t usageHint,
+									 const Geometry::Box * boundingBox){
+	removeGlBuffer();
+	binaryData.clear(); // the old data does not match the new description
+	setVertexDescription(vd);
+	vertexCount = count;
+	layout = INTERLEAVED;
+	revision = createRevision();
+	const size_t numBytes = vd.getVertexSize() * count;
+
+	const VertexAttribute & posAttr = vd.getAttribute(VertexAttributeIds::POSITION);
+	if(count == 0 || posAttr.empty()) {
+		_setBoundingBox(Geometry::Box());
+	} else if(boundingBox != nullptr) {
+		_setBoundingBox(*boundingBox);
+	} else if(posAttr.getDataType() == GL_FLOAT && posAttr.getNumValues() >= 3) {
+		float min[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+		float max[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+		accumulateBounds3fParallel(vertices + posAttr.getOffset(), vd.getVertexSize(), count, min, max);
+		_setBoundingBox(Geometry::Box(min[0], max[0], min[1], max[1], min[2], max[2]));
+	} else {
+		// other position formats are handled by the accessors; this requires a temporary copy.
+		binaryData.assign(std::vector<uint8_t>(vertices, vertices + numBytes));
+		updateBoundingBox();
+		releaseLocalData();
+	}
+	if(count == 0)
+		return false;
 
 	try {
-		bufferObject.uploadData(GL_ARRAY_BUFFER, binaryData, usageHint);
+		getWritableBufferObject().uploadData(GL_ARRAY_BUFFER, vertices, numBytes, usageHint);
 		GET_GL_ERROR()
 	}
 	catch (...) {
@@ -158,17 +547,23 @@ bool MeshVertexData::upload(uint32_t usageHint){
 }
 
 bool MeshVertexData::download(){
-	if(!isUploaded() || vertexCount==0)
+	if((!isUploaded() && !isInArena()) || vertexCount==0)
 		return false;
-	downloadTo(binaryData);
+	std::vector<uint8_t> downloadedData;
+	downloadTo(downloadedData);
+	binaryData.assign(std::move(downloadedData));
 	dataChanged = false;
 	return true;
 }
 
 #ifdef LIB_GL
 void MeshVertexData::downloadTo(std::vector<uint8_t> & destination) const {
+	if(isInArena()) {
+		destination = arenaAllocation.getArena()->download(arenaAllocation.getHandle());
+		return;
+	}
 	const std::size_t numBytes = getVertexDescription().getVertexSize() * getVertexCount();
-	destination = bufferObject.downloadData<uint8_t>(GL_ARRAY_BUFFER, numBytes);
+	destination = bufferObject->get().downloadData<uint8_t>(GL_ARRAY_BUFFER, numBytes);
 }
 #else
 void MeshVertexData::downloadTo(std::vector<uint8_t> & /*destination*/) const {
@@ -176,22 +571,122 @@ void MeshVertexData::downloadTo(std::vector<uint8_t> & /*destination*/) const {
 }
 #endif
 
+void MeshVertexData::_markAsChangedOnGPU() {
+	releaseLocalData();
+	dataChanged = false;
+	changedRanges.clear();
+	revision = createRevision();
+}
+
 void MeshVertexData::removeGlBuffer(){
-	bufferObject.destroy();
+	vaoCache.clear();
+	bufferObject = nullptr; // a buffer shared with copies is kept alive by them
+	streamingBuffer = nullptr;
+	streamingRange = StreamingBuffer::Range();
+	arenaAllocation.release();
 }
 
-void MeshVertexData::bind(RenderingContext & context, bool useVBO) {
+/*! (internal) Record the attribute bindings of the vertex data. Without a shader, only the position is bound (to location 0).
+	@param baseOffset Offset of the vertex data inside the buffer.
+	@param clientData Vertex data in main memory, if no buffer is used.	*/
+static void traceBindVertexData(const MeshVertexData & vData, Shader * shader, uint32_t bufferId, std::size_t baseOffset, const uint8_t * clientData) {
+	std::vector<uint32_t> args(1, bufferId);
+	for(const auto & attr : vData.getVertexDescription().getAttributes()) {
+		if(attr.empty())
+			continue;
+		GLint location = -1;
+		if(shader != nullptr && !shader->usesClassicOpenGL())
+			location = shader->getVertexAttributeLocation(attr.getNameId());
+		else if(attr.getNameId() == VertexAttributeIds::POSITION)
+			location = 0;
+		if(location == -1)
+			continue;
+		args.insert(args.end(), {static_cast<uint32_t>(location), attr.getNumValues(), attr.getDataType(), attr.getNormalize() ? 1u : 0u,
+				attr.getConvertToFloat() ? 0u : 1u, static_cast<uint32_t>(vData.getAttributeStride(attr)),
+				static_cast<uint32_t>(baseOffset + vData.getAttributeOffset(attr))});
+	}
+	GLTrace::record(GLTrace::BIND_VERTEX_DATA, args, clientData, clientData != nullptr ? vData.dataSize() : 0);
+}
+
+//! (internal)
+bool MeshVertexData::bindVertexArrayObject(RenderingContext & context, InstanceBuffer * instances) {
+#ifdef LIB_GL
+	Shader * shader = context.getActiveShader();
+	if(shader == nullptr || shader->getStatus() != Shader::LINKED || shader->usesClassicOpenGL() || !shader->usesSGUniforms()
+			|| !VertexArrayObjectCache::isSupported())
+		return false;
+
+	const uint32_t layoutId = shader->getVertexAttributeLayoutId();
+	const uint32_t bufferId = bufferObject->get().getGLId();
+	const uint32_t instanceKey = instances != nullptr ? instances->_getLayoutKey() : 0;
+	GLuint vao = vaoCache.get(layoutId, bufferId, instanceKey);
+	if(vao != 0) {
+		glBindVertexArray(vao);
+		return true;
+	}
+
+	vao = vaoCache.create(layoutId, bufferId, instanceKey);
+	if(vao == 0)
+		return false;
+	glBindVertexArray(vao);
+	bufferObject->get().bind(GL_ARRAY_BUFFER);
+	// The attribute state is recorded in the vertex array object. RenderingContext::enableVertexAttribArray is not
+	// used here, as its bindings would be disabled again (inside the vertex array object) by unbind().
+	const VertexDescription & vd = getVertexDescription();
+	for(const auto & attr : vd.getAttributes()) {
+		if(attr.empty())
+			continue;
+		const GLint location = shader->getVertexAttributeLocation(attr.getNameId());
+		if(location == -1)
+			continue;
+		const GLuint attribLocation = static_cast<GLuint>(location);
+		const uint8_t * offset = nullptr;
+		if( attr.getConvertToFloat() ){
+			glVertexAttribPointer(attribLocation, attr.getNumValues(), attr.getDataType(), attr.getNormalize() ? GL_TRUE : GL_FALSE, getAttributeStride(attr), offset + getAttributeOffset(attr));
+		} else {
+			glVertexAttribIPointer(attribLocation, attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), offset + getAttributeOffset(attr));
+		}
+		glEnableVertexAttribArray(attribLocation);
+	}
+	if(instances != nullptr)
+		instances->_enableAttributes(*shader, false);
+	bufferObject->get().unbind(GL_ARRAY_BUFFER);
+	GET_GL_ERROR();
+	return true;
+#else
+	return false;
+#endif /* LIB_GL */
+}
+
+void MeshVertexData::bind(RenderingContext & context, bool useVBO, bool useVAO, InstanceBuffer * instances) {
+	if(useVAO && useVBO && isUploaded() && bindVertexArrayObject(context, instances)) {
+		vaoBound = true;
+		if(GLTrace::isRecording())
+			traceBindVertexData(*this, context.getActiveShader(), bufferObject->get().getGLId(), 0, nullptr);
+		return;
+	}
+	vaoBound = false;
 	const VertexDescription & vd = getVertexDescription();
 
 	const uint8_t * vertexPosition = nullptr;
+	const BufferObject * vertexBuffer = nullptr;
 	if (useVBO && isUploaded()) { // use VBO
-		bufferObject.bind(GL_ARRAY_BUFFER);
+		vertexBuffer = &bufferObject->get();
+		vertexBuffer->bind(GL_ARRAY_BUFFER);
+	} else if (isInArena()) { // use the range of the arena
+		vertexBuffer = &arenaAllocation.getArena()->getBufferObject();
+		vertexBuffer->bind(GL_ARRAY_BUFFER);
+		vertexPosition = reinterpret_cast<const uint8_t *>(arenaAllocation.getOffset());
+	} else if (isStreamed()) { // use the region of the streaming buffer
+		vertexBuffer = &streamingBuffer->getBufferObject();
+		vertexBuffer->bind(GL_ARRAY_BUFFER);
+		vertexPosition = reinterpret_cast<const uint8_t *>(streamingRange.offset);
 	} else { // use Vertex array
-		vertexPosition = data();
+		vertexPosition = binaryData.data();
 	}
 
 	Shader * shader = context.getActiveShader();
-	const GLsizei vSize=vd.getVertexSize();
+	// enableVertexAttribArray adds the attribute's interleaved offset; the base pointer is adjusted accordingly for separate streams.
 #ifdef LIB_GL
 	if (RenderingContext::getCompabilityMode() && (shader == nullptr || shader->usesClassicOpenGL())) {
 
@@ -202,39 +697,39 @@ void MeshVertexData::bind(RenderingContext & context, bool useVBO) {
 
 			if(nameId==VertexAttributeIds::POSITION) {
 				context.enableClientState(GL_VERTEX_ARRAY);
-				glVertexPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glVertexPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::NORMAL) {
 				context.enableClientState(GL_NORMAL_ARRAY);
-				glNormalPointer(attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glNormalPointer(attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::COLOR) {
 				context.enableClientState(GL_COLOR_ARRAY);
-				glColorPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glColorPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD0) {
 				context.enableTextureClientState(GL_TEXTURE0);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD1) {
 				context.enableTextureClientState(GL_TEXTURE1);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD2) {
 				context.enableTextureClientState(GL_TEXTURE2);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD3) {
 				context.enableTextureClientState(GL_TEXTURE3);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD4) {
 				context.enableTextureClientState(GL_TEXTURE4);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD5) {
 				context.enableTextureClientState(GL_TEXTURE5);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD6) {
 				context.enableTextureClientState(GL_TEXTURE6);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD7) {
 				context.enableTextureClientState(GL_TEXTURE7);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(shader != nullptr) { // ????????does this work?????
-				context.enableVertexAttribArray(attr, vertexPosition, vSize);
+				context.enableVertexAttribArray(attr, vertexPosition + getAttributeOffset(attr) - attr.getOffset(), getAttributeStride(attr));
 			}
 		}
 	}else if( shader != nullptr && context.useAMDAttrBugWorkaround() ){
@@ -243,7 +738,7 @@ void MeshVertexData::bind(RenderingContext & context, bool useVBO) {
 				continue;
 			if(attr.getNameId()==VertexAttributeIds::POSITION) {
 				context.enableClientState(GL_VERTEX_ARRAY);
-				glVertexPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glVertexPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 				break;
 			}
 		}
@@ -252,10 +747,18 @@ void MeshVertexData::bind(RenderingContext & context, bool useVBO) {
 	if (shader != nullptr && shader->usesSGUniforms()) {
 		for(const auto & attr : vd.getAttributes()) {
 			if(!attr.empty()) {
-				context.enableVertexAttribArray(attr, vertexPosition, vSize);
+				context.enableVertexAttribArray(attr, vertexPosition + getAttributeOffset(attr) - attr.getOffset(), getAttributeStride(attr));
 			}
 		}
 	}
+	if(instances != nullptr && shader != nullptr)
+		instances->_enableAttributes(*shader, true);
+	if(GLTrace::isRecording()) {
+		if(vertexBuffer != nullptr)
+			traceBindVertexData(*this, shader, vertexBuffer->getGLId(), reinterpret_cast<std::size_t>(vertexPosition), nullptr);
+		else
+			traceBindVertexData(*this, shader, 0, 0, vertexPosition);
+	}
 }
 
 /*! (internal) */
@@ -265,12 +768,25 @@ void MeshVertexData::drawArray(RenderingContext & context,bool useVBO,uint32_t d
 	
 	bind(context,useVBO);
 	glDrawArrays(drawMode, startIndex, numberOfElements);
+	RENDERING_GL_TRACE(DRAW_ARRAYS, {drawMode, startIndex, numberOfElements});
 	unbind(context,useVBO);
 }
 
-void MeshVertexData::unbind(RenderingContext & context, bool useVBO) {
+void MeshVertexData::unbind(RenderingContext & context, bool useVBO, InstanceBuffer * instances) {
+	RENDERING_GL_TRACE(UNBIND_VERTEX_DATA, {});
+	if(vaoBound) {
+		RenderingContext::_bindDefaultVertexArrayObject();
+		vaoBound = false;
+		return;
+	}
+	if(instances != nullptr)
+		instances->_disableAttributes();
 	if (useVBO && isUploaded()) { // unbind vertex VBO
-		bufferObject.unbind(GL_ARRAY_BUFFER);
+		bufferObject->get().unbind(GL_ARRAY_BUFFER);
+	} else if (isInArena()) {
+		arenaAllocation.getArena()->getBufferObject().unbind(GL_ARRAY_BUFFER);
+	} else if (isStreamed()) {
+		streamingBuffer->getBufferObject().unbind(GL_ARRAY_BUFFER);
 	}
 	context.disableAllClientStates();
 	context.disableAllTextureClientStates();
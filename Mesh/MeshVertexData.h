@@ -11,15 +11,23 @@
 #ifndef MeshVertexData_H
 #define MeshVertexData_H
 
+#include "../BufferArena.h"
 #include "../BufferObject.h"
+#include "../StreamingBuffer.h"
+#include "CopyOnWriteArray.h"
+#include "DirtyRangeSet.h"
+#include "VertexArrayObjectCache.h"
 #include <Geometry/Box.h>
+#include <Util/References.h>
 #include <cstddef>
 #include <cstdint>
 #include <vector>
 
 namespace Rendering {
 
+class InstanceBuffer;
 class RenderingContext;
+class VertexAttribute;
 class VertexDescription;
 
 /*! VertexData-Class.
@@ -28,26 +36,82 @@ class VertexDescription;
 	- The local storage for the vertex data (If the data is uploaded to
 		the graphics card, the local copy may be freed.)
 	- The vertex buffer id, if the data has been uploaded to graphics memory.
-	- A bounding box enclosing all vertices.	*/
+	- A bounding box enclosing all vertices.
+	The data is either stored interleaved (all attributes of a vertex are stored together) or as separate
+	streams (all values of one attribute are stored together, the streams are stored in the order of the
+	attributes). The layout is the same in the local copy and in the vertex buffer. The attribute accessors
+	and views work with both layouts; code accessing the raw data has to use getAttributeOffset() and
+	getAttributeStride(), or requires the interleaved layout.
+	Copies share the local data and, if the data is unchanged, the vertex buffer until one of them is changed
+	(copy-on-write): the non-const accessors of the data and uploading new data create an own copy.	*/
 class MeshVertexData {
-		std::vector<uint8_t> binaryData;
+	public:
+		enum layout_t : uint8_t {
+			INTERLEAVED,	//!< all attributes of a vertex are stored together (default)
+			SEPARATE		//!< each attribute is stored in its own contiguous stream
+		};
+	private:
+		CopyOnWriteArray<uint8_t> binaryData;
 		const VertexDescription * vertexDescription;
 		uint32_t vertexCount;
-		BufferObject bufferObject;
+		Util::Reference<CountedBufferObject> bufferObject;
+		VertexArrayObjectCache vaoCache;
+		bool vaoBound;
+		Util::Reference<StreamingBuffer> streamingBuffer;
+		StreamingBuffer::Range streamingRange;
+		BufferArenaAllocation arenaAllocation;
 
-		Geometry::Box bb;
+		enum boundingBoxState_t : uint8_t {
+			BOUNDING_BOX_VALID,
+			BOUNDING_BOX_GROWN,		//!< the vertices starting at boundingBoxVertexCount have to be included
+			BOUNDING_BOX_INVALID
+		};
+		mutable Geometry::Box bb;
+		//! Number of vertices the bounding box has been calculated for.
+		mutable uint32_t boundingBoxVertexCount;
+		mutable boundingBoxState_t boundingBoxState;
 		bool dataChanged;
+		//! If dataChanged is set and this is not empty, only the vertices in these ranges have been changed.
+		DirtyRangeSet changedRanges;
+		uint64_t revision;
+		layout_t layout;
+
+		//! (internal) Return a new, globally unique revision number.
+		static uint64_t createRevision();
+
+		/*! (internal) Bind a cached vertex array object for the active shader (create it if necessary).
+			If @p instances is given, its attributes are part of the vertex array object.
+			Returns false if no vertex array object can be used.	*/
+		bool bindVertexArrayObject(RenderingContext & context, InstanceBuffer * instances);
 
 		/*! (internal) To save memory, the vertexDescription is stored in a static set
 			so that each MeshVertexData-Object having the same vertex description references the same
-			VertexDescription object. */
+			VertexDescription object.
+			\note Invalidates the cached vertex array objects. */
 		void setVertexDescription(const VertexDescription & vd);
+
+		/*! (internal) Upload only the changed ranges into the existing VBO (or arena range).
+			Returns false if the whole data has to be uploaded.	*/
+		bool uploadChangedRanges();
+
+		/*! (internal) The buffer object to upload data into. If the buffer object is shared with a copy (or there is
+			none), a new one is created.	*/
+		BufferObject & getWritableBufferObject();
+		//! (internal) @c true iff the vertex buffer is shared with a copy.
+		bool isBufferObjectShared()const					{	return bufferObject.isNotNull() && bufferObject->countReferences() > 1;	}
+
+		/*! (internal) Calculate the minima and maxima of the positions of the vertices [@p begin, @p end) from
+			the local data. Returns false if there is no position attribute of a supported type.	*/
+		bool calculatePositionBounds(uint32_t begin, uint32_t end, float min[3], float max[3], uint8_t & numValues)const;
+		//! (internal) Recalculate an invalid or grown bounding box (if the local data is available).
+		void refreshBoundingBox()const;
 	public:
 
 		// main
 		MeshVertexData();
-		/*! Copy all data from @p other.
-			\note If the other data is only available in the graphics card memory, this may
+		/*! Copy all data from @p other. The local data is shared with @p other until one of them is changed.
+			If the vertex buffer of @p other is up to date, it is shared as well; the copy then has nothing to upload.
+			\note If the other data is only available in the graphics card memory and has changed, this may
 				only be called from within the gl-thread.	*/
 		MeshVertexData(const MeshVertexData & other);
 		MeshVertexData(MeshVertexData &&) = default;
@@ -62,50 +126,127 @@ class MeshVertexData {
 		bool empty()const										{	return vertexCount==0;	}
 		void swap(MeshVertexData & other);
 
+		// layout
+		layout_t getLayout()const								{	return layout;	}
+		/*! Reorder the data into the given layout. The vertex data is downloaded first if there is no local copy.
+			Storing the attributes as separate streams makes passes over single attributes (e.g. the bounding box
+			calculation or transformations) more cache-friendly and allows to fetch just the positions when drawing.
+			\note Sets dataChanged. */
+		void setLayout(layout_t newLayout);
+		//! Byte offset of the attribute's value of the first vertex in the data.
+		std::size_t getAttributeOffset(const VertexAttribute & attr)const;
+		//! Distance in bytes between the attribute's values of two consecutive vertices.
+		std::size_t getAttributeStride(const VertexAttribute & attr)const;
+
 		// data
 		/*! Set the local vertex data. The old data is freed.
 			\note Sets dataChanged. */
 		void allocate(uint32_t count, const VertexDescription & vd);
 		void releaseLocalData();
-		void markAsChanged()								{  	dataChanged=true;	}
+		void markAsChanged()								{  	dataChanged=true;	changedRanges.clear();	revision=createRevision();	}
+		/*! Mark only the vertices [@p firstVertex, @p firstVertex + @p count) as changed. If the data is uploaded
+			again, only the changed ranges are transferred into the existing buffer.
+			@throw std::out_of_range if the range exceeds the vertex count.	*/
+		void markAsChanged(uint32_t firstVertex, uint32_t count);
+		//! Changed vertex ranges; empty if all vertices have changed (or nothing has changed, see hasChanged()).
+		const DirtyRangeSet & getChangedRanges()const		{	return changedRanges;	}
 		bool hasChanged()const								{  	return dataChanged;	}
+		/*! Revision of the data: a number that changes (to a value unique among all MeshVertexData objects) whenever
+			the data is allocated or marked as changed. Can be used to detect outdated data derived from the vertices. */
+		uint64_t getRevision()const							{	return revision;	}
 		bool hasLocalData()const							{  	return !binaryData.empty();	}
 		const uint8_t * data()const							{	return binaryData.data();	}
-		uint8_t * data()									{	return binaryData.data();	}
+		//! \note Creates an own copy of the local data if it is shared with a copy of this object.
+		uint8_t * data()									{	return binaryData.edit().data();	}
 		size_t dataSize()const								{	return binaryData.size();	}
+		//! Size in bytes of the local data shared with copies of this object (0 if the data is not shared).
+		size_t getSharedDataSize()const						{	return binaryData.isShared() ? binaryData.size() : 0;	}
+		//! Size in bytes of the vertex buffer shared with copies of this object (0 if the buffer is not shared).
+		size_t getSharedBufferSize()const;
+		//! \note Only meaningful for the interleaved layout.
 		const uint8_t * operator[](uint32_t index) const;
 		uint8_t * operator[](uint32_t index);
 
 		// bounding box
+		/*! Calculate the bounding box of all vertices now. Float positions are processed by a vectorized kernel,
+			large meshes in parallel by the TaskScheduler. */
 		void updateBoundingBox();
-		const Geometry::Box & getBoundingBox() const		{	return bb;	}
+		/*! Mark the bounding box as outdated; it is recalculated by the next call of getBoundingBox()
+			(or before the local data is released). Use this instead of updateBoundingBox() if the data may
+			be changed several times before the box is needed. */
+		void invalidateBoundingBox()						{	boundingBoxState = BOUNDING_BOX_INVALID;	}
+		/*! Mark the positions of the vertices [@p firstVertex, @p firstVertex + @p count) as changed. If the range
+			only contains new vertices (behind the vertices the box has been calculated for), the box is
+			later extended by these vertices instead of being recalculated completely. */
+		void invalidateBoundingBox(uint32_t firstVertex, uint32_t count);
+		/*! 
+ote If the bounding box has been invalidated, it is recalculated first. As the other const accessors,
+			this must not be called concurrently with modifications of the data. */
+		const Geometry::Box & getBoundingBox() const		{	if(boundingBoxState != BOUNDING_BOX_VALID) refreshBoundingBox();	return bb;	}
 		/**
 		 * Set a new bounding box.
 		 *
 		 * @note This function should not be used normally. It is needed in special situations when there is no vertex data but the bounding box is known.
 		 * @param box New bounding box.
 		 */
-		void _setBoundingBox(const Geometry::Box & box)		{ bb = box; }
+		void _setBoundingBox(const Geometry::Box & box)		{ bb = box; boundingBoxVertexCount = vertexCount; boundingBoxState = BOUNDING_BOX_VALID; }
 
 
 		// vbo
-		inline bool isUploaded()const						{   return bufferObject.isValid();    }
+		inline bool isUploaded()const						{   return bufferObject.isNotNull() && bufferObject->get().isValid();    }
+		//! (internal) The VBO containing the data, or @c nullptr if the data has not been uploaded into a VBO of its own.
+		const BufferObject * _getBufferObject()const		{	return isUploaded() ? &bufferObject->get() : nullptr;	}
 
-		/*! (internal) */
-		void bind(RenderingContext & context, bool useVBO);
-		/*! (internal) */
-		void unbind(RenderingContext & context, bool useVBO);
+		/*! (internal) If the data is stored in a VBO and a shader without classic OpenGL is active,
+			a cached vertex array object is bound; otherwise, all attributes are set up individually.
+			If @p instances is given, its per-instance attributes are set up as well (and are part of the vertex array object).
+			\note Set @p useVAO to false if additional attributes (e.g. instance data) have been set up before. */
+		void bind(RenderingContext & context, bool useVBO, bool useVAO = true, InstanceBuffer * instances = nullptr);
+		/*! (internal) @p instances has to be the same as for bind(). */
+		void unbind(RenderingContext & context, bool useVBO, InstanceBuffer * instances = nullptr);
 
 		//! Call @a upload() with default usage hint.
 		bool upload();
 		/*! (internal) Create or update a VBO if hasChanged is set to true.
 			hasChanged is set to false.	*/
 		bool upload(uint32_t usageHint);
+		/*! (internal) Copy the local data into the current frame's region of the given streaming buffer
+			instead of creating a VBO (an existing VBO is removed). The data remains usable for drawing as long as
+			the region is not reused (see StreamingBuffer).
+			\note The local data is required for copying and should be preserved.
+			\return false if the streaming buffer has not enough space left.	*/
+		bool upload(StreamingBuffer & buffer);
+		/*! (internal) Create a VBO directly from external memory (e.g. a memory-mapped file) without creating
+			a local copy. Existing local data is released and the bounding box is calculated from @p vertices,
+			unless a precomputed @p boundingBox is given.
+			\note @p vertices must contain @p count interleaved vertices of the given description.	*/
+		bool _uploadExternal(uint32_t count, const VertexDescription & vd, const uint8_t * vertices, uint32_t usageHint,
+							 const Geometry::Box * boundingBox = nullptr);
+		//! @c true iff the data has been uploaded to a streaming buffer and is still valid there.
+		bool isStreamed()const								{	return streamingBuffer.isNotNull() && streamingBuffer->isRangeValid(streamingRange);	}
+		/*! (internal) Copy the local data into a range of the given arena instead of creating a VBO of its own
+			(an existing VBO is removed). If the data is already stored in the arena and its size has not changed,
+			the range is overwritten. The offset of the range is a multiple of the vertex size (see getArenaBaseVertex()).	*/
+		bool upload(BufferArena & arena);
+		//! @c true iff the data is stored in a BufferArena.
+		bool isInArena()const								{	return arenaAllocation.isValid();	}
+		const BufferArenaAllocation & _getArenaAllocation()const	{	return arenaAllocation;	}
+		/*! Index of the first vertex inside the buffer of the arena (0 if the data is not stored in an arena).
+			Meshes in the same arena that share a vertex description can be drawn from one vertex array by adding
+			this value as base vertex to their indices.	*/
+		uint32_t getArenaBaseVertex()const;
 		/*! (internal) */
 		bool download();
 		void downloadTo(std::vector<uint8_t> & destination)const;
+		/*! (internal) Restore the released local copy of the uploaded data (e.g. from a compressed copy).
+			@p data has to be equal to the uploaded data; neither the data is marked as changed nor the revision is changed. */
+		void _restoreLocalData(std::vector<uint8_t> && data)	{	binaryData.assign(std::move(data));	}
 		/*! (internal) */
 		void removeGlBuffer();
+		/*! (internal) The data inside the vertex buffer has been changed directly on the GPU (e.g. by a compute shader).
+			The outdated local copy is released (it is downloaded again when needed) and a new revision is created.
+			\note The bounding box is not updated.	*/
+		void _markAsChangedOnGPU();
 		
 		/*! (internal) Draw the vertices using the VBO or a VertexArray.
 			Used by MeshDataStrategy::doDisplay(..) if the mesh does not use indices. */
@@ -114,8 +255,9 @@ class MeshVertexData {
 		/*! Swap the internal BufferObject. 
 			\note The local data is not changed!
 			\note the size of the new buffer must be equal to that of the old one.
+			\note The buffer may be shared with copies of this object (see getSharedBufferSize()).
 			\note Use only if you know what you are doing!	*/		
-		void _swapBufferObject(BufferObject & other)	{	bufferObject.swap(other);	}
+		void _swapBufferObject(BufferObject & other);
 };
 
 
@@ -0,0 +1,190 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "PositionStreamMeshDataStrategy.h"
+#include "Mesh.h"
+#include "MeshIndexData.h"
+#include "MeshVertexData.h"
+#include "VertexAttributeIds.h"
+#include "VertexDescription.h"
+#include "../BufferObject.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+#include "../RenderingContext/RenderingContext.h"
+#include "../Shader/Shader.h"
+#include <Util/Macros.h>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace Rendering {
+
+namespace {
+//! (internal) Position-only vertex (and optionally index) buffer of a mesh.
+class PositionStream : public MeshDerivedData {
+	public:
+		BufferObject vertexBuffer;
+		BufferObject indexBuffer;		//!< remapped indices (only if the positions have been deduplicated)
+		VertexDescription description;	//!< contains only the position attribute
+		uint32_t vertexCount;
+		uint64_t vertexRevision;
+		uint64_t indexRevision;
+
+		PositionStream() : MeshDerivedData(), vertexCount(0), vertexRevision(0), indexRevision(0) {}
+		virtual ~PositionStream() {}
+
+		bool isDeduplicated() const		{	return indexBuffer.isValid();	}
+};
+
+//! (internal) Return the mesh's position stream if it matches the mesh's current data.
+PositionStream * getValidPositionStream(Mesh * m) {
+	auto stream = dynamic_cast<PositionStream *>(m->_getPositionStream());
+	if(stream == nullptr || !stream->vertexBuffer.isValid() || stream->vertexRevision != m->_getVertexData().getRevision())
+		return nullptr;
+	if(stream->isDeduplicated() && (!m->isUsingIndexData() || stream->indexRevision != m->_getIndexData().getRevision()))
+		return nullptr;
+	return stream;
+}
+}
+
+//! (static)
+PositionStreamMeshDataStrategy * PositionStreamMeshDataStrategy::getStaticDrawStrategy(){
+	static PositionStreamMeshDataStrategy strategy(USE_VBOS, true);
+	return &strategy;
+}
+
+//! (ctor)
+PositionStreamMeshDataStrategy::PositionStreamMeshDataStrategy(uint8_t _flags, bool _deduplicate) :
+		SimpleMeshDataStrategy(_flags | USE_VBOS), deduplicate(_deduplicate) {
+}
+
+//! (dtor)
+PositionStreamMeshDataStrategy::~PositionStreamMeshDataStrategy() = default;
+
+//! (static)
+bool PositionStreamMeshDataStrategy::hasPositionStream(Mesh * m) {
+	return getValidPositionStream(m) != nullptr;
+}
+
+//! (internal)
+void PositionStreamMeshDataStrategy::updatePositionStream(Mesh * m) {
+	MeshVertexData & vd = m->_getVertexData();
+	MeshIndexData & id = m->_getIndexData();
+	const bool useIndices = deduplicate && m->isUsingIndexData() && !id.empty();
+	auto stream = dynamic_cast<PositionStream *>(m->_getPositionStream());
+	if(stream != nullptr && stream->vertexBuffer.isValid() && stream->vertexRevision == vd.getRevision()
+			&& stream->isDeduplicated() == useIndices && (!useIndices || stream->indexRevision == id.getRevision()))
+		return;
+
+	const VertexAttribute & posAttr = vd.getVertexDescription().getAttribute(VertexAttributeIds::POSITION);
+	if(vd.empty() || posAttr.empty()) {
+		m->_setPositionStream(nullptr);
+		return;
+	}
+	assureLocalVertexData(m);
+	if(useIndices)
+		assureLocalIndexData(m);
+	if(!vd.hasLocalData() || (useIndices && !id.hasLocalData()))
+		return;
+
+	// gather the positions
+	const uint32_t vertexCount = vd.getVertexCount();
+	const std::size_t posSize = posAttr.getDataSize();
+	std::vector<uint8_t> positions(vertexCount * posSize);
+	{
+		const uint8_t * source = vd.data() + vd.getAttributeOffset(posAttr);
+		const std::size_t stride = vd.getAttributeStride(posAttr);
+		for(uint32_t i = 0; i < vertexCount; ++i, source += stride)
+			std::memcpy(positions.data() + i * posSize, source, posSize);
+	}
+
+	Util::Reference<PositionStream> newStream = new PositionStream;
+	newStream->description.appendAttribute(posAttr.getNameId(), posAttr.getNumValues(), posAttr.getDataType(), posAttr.getNormalize(), posAttr.getConvertToFloat());
+	newStream->vertexRevision = vd.getRevision();
+	newStream->vertexCount = vertexCount;
+
+	if(useIndices) {
+		// merge vertices with bitwise equal positions: sort the vertices by their positions and assign new indices
+		const uint8_t * p = positions.data();
+		std::vector<uint32_t> order(vertexCount);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [p, posSize](uint32_t a, uint32_t b) {
+			const int cmp = std::memcmp(p + a * posSize, p + b * posSize, posSize);
+			return cmp < 0 || (cmp == 0 && a < b);
+		});
+		std::vector<uint32_t> remap(vertexCount);
+		std::vector<uint8_t> uniquePositions;
+		uniquePositions.reserve(positions.size());
+		uint32_t uniqueCount = 0;
+		for(uint32_t i = 0; i < vertexCount; ++i) {
+			const uint32_t v = order[i];
+			if(i == 0 || std::memcmp(p + v * posSize, p + order[i - 1] * posSize, posSize) != 0) {
+				uniquePositions.insert(uniquePositions.end(), p + v * posSize, p + (v + 1) * posSize);
+				++uniqueCount;
+			}
+			remap[v] = uniqueCount - 1;
+		}
+		std::vector<uint32_t> indices(id.data(), id.data() + id.getIndexCount());
+		for(auto & index : indices)
+			index = index < vertexCount ? remap[index] : 0;
+		positions.swap(uniquePositions);
+		newStream->vertexCount = uniqueCount;
+		newStream->indexRevision = id.getRevision();
+		newStream->indexBuffer.uploadData(GL_ELEMENT_ARRAY_BUFFER, indices, GL_STATIC_DRAW);
+	}
+	newStream->vertexBuffer.uploadData(GL_ARRAY_BUFFER, positions, GL_STATIC_DRAW);
+	GET_GL_ERROR();
+	m->_setPositionStream(newStream.get());
+}
+
+//! ---|> SimpleMeshDataStrategy
+void PositionStreamMeshDataStrategy::prepare(Mesh * m){
+	// the position stream is built first, as the local data may be released afterwards
+	updatePositionStream(m);
+	SimpleMeshDataStrategy::prepare(m);
+}
+
+//! ---|> SimpleMeshDataStrategy
+void PositionStreamMeshDataStrategy::displayMesh(RenderingContext & context, Mesh * m, uint32_t startIndex, uint32_t indexCount){
+	if(m->empty())
+		return;
+	Shader * shader = context.getActiveShader();
+	PositionStream * stream = context.isPositionOnlyPass() && shader != nullptr ? getValidPositionStream(m) : nullptr;
+	if(stream == nullptr || shader->getActiveVertexAttributes().size() != 1
+			|| shader->getActiveVertexAttributes().front() != VertexAttributeIds::POSITION) {
+		MeshDataStrategy::doDisplayMesh(context, m, startIndex, indexCount);
+		return;
+	}
+
+	const VertexDescription & desc = stream->description;
+	stream->vertexBuffer.bind(GL_ARRAY_BUFFER);
+	context.enableVertexAttribArray(desc.getAttribute(VertexAttributeIds::POSITION), nullptr, static_cast<int32_t>(desc.getVertexSize()));
+	if(m->isUsingIndexData()) {
+		MeshIndexData & id = m->_getIndexData();
+		if(stream->isDeduplicated()) {
+			if(startIndex + indexCount > id.getIndexCount())
+				throw std::out_of_range("PositionStreamMeshDataStrategy::displayMesh: Accessing invalid index.");
+			stream->indexBuffer.bind(GL_ELEMENT_ARRAY_BUFFER);
+			glDrawElements(m->getGLDrawMode(), indexCount, GL_UNSIGNED_INT, reinterpret_cast<void*>(sizeof(GLuint) * startIndex));
+			stream->indexBuffer.unbind(GL_ELEMENT_ARRAY_BUFFER);
+		} else {
+			id.drawElements(id.isUploaded(), m->getGLDrawMode(), startIndex, indexCount);
+		}
+	} else {
+		glDrawArrays(m->getGLDrawMode(), startIndex, indexCount);
+	}
+	stream->vertexBuffer.unbind(GL_ARRAY_BUFFER);
+	context.disableAllVertexAttribArrays();
+	GET_GL_ERROR();
+}
+
+}
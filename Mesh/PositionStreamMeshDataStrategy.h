@@ -0,0 +1,61 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_POSITIONSTREAMMESHDATASTRATEGY_H_
+#define RENDERING_POSITIONSTREAMMESHDATASTRATEGY_H_
+
+#include "MeshDataStrategy.h"
+#include <cstdint>
+
+namespace Rendering {
+
+/*!	PositionStreamMeshDataStrategy ---|> SimpleMeshDataStrategy ---|> MeshDataStrategy
+	Strategy that maintains a secondary, position-only vertex buffer for each mesh in addition to the regular buffers.
+	If the RenderingContext is in position-only pass mode (see RenderingContext::setPositionOnlyPass()) and the active
+	shader uses sg_Position as its only vertex attribute, the mesh is drawn from that buffer. Depth-only passes
+	(shadow maps, depth prepasses) then fetch only the positions instead of complete interleaved vertices.
+
+	If deduplication is enabled, vertices of indexed meshes having the same position (e.g. differing only by their
+	normals or texture coordinates) are merged in the position-only buffer and a remapped index buffer is created.
+
+	The position-only buffers are stored in the mesh (see Mesh::_getPositionStream()) and are updated when the vertex
+	or index data changes.
+	\note Like the other strategies, an instance should be created only once and be shared by the meshes.
+	\note The additional buffers cost graphics memory: 12 bytes per (unique) vertex for float positions
+		(plus 4 bytes per index if the buffer is deduplicated).	*/
+class PositionStreamMeshDataStrategy : public SimpleMeshDataStrategy {
+	public:
+		/*!	Return an instance creating static VBOs (releasing the local data) with deduplicated position buffers. */
+		static PositionStreamMeshDataStrategy * getStaticDrawStrategy();
+
+		//! @p flags: see SimpleMeshDataStrategy (USE_VBOS is always set).
+		PositionStreamMeshDataStrategy(uint8_t flags, bool deduplicate);
+		virtual ~PositionStreamMeshDataStrategy();
+
+		bool isDeduplicating() const		{	return deduplicate;	}
+
+		/*! (static) Return @c true iff the mesh has a position-only buffer matching its current data.
+			\note The buffer is created or updated by prepare(). */
+		static bool hasPositionStream(Mesh * m);
+
+		//! ---|> SimpleMeshDataStrategy
+		void prepare(Mesh * m) override;
+		//! ---|> SimpleMeshDataStrategy
+		void displayMesh(RenderingContext & context, Mesh * m, uint32_t startIndex, uint32_t indexCount) override;
+
+	private:
+		const bool deduplicate;
+
+		void updatePositionStream(Mesh * m);
+};
+
+}
+
+#endif /* RENDERING_POSITIONSTREAMMESHDATASTRATEGY_H_ */
@@ -0,0 +1,170 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ProfilingMeshDataStrategy.h"
+#include "Mesh.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+#include "../QueryPool.h"
+#include "../RenderingContext/RenderingContext.h"
+#include <Util/Macros.h>
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+namespace Rendering {
+
+//! Number of frames whose query results are kept by the pools.
+static const uint32_t PROFILING_POOL_FRAMES = 4;
+
+ProfilingMeshDataStrategy::ProfilingMeshDataStrategy(uint8_t _flags, uint32_t _maxDrawsPerFrame, uint32_t _windowSize) :
+		SimpleMeshDataStrategy(_flags), maxDrawsPerFrame(std::max(1u, _maxDrawsPerFrame)), windowSize(std::max(1u, _windowSize)), windowFrames(0) {
+}
+
+ProfilingMeshDataStrategy::~ProfilingMeshDataStrategy() = default;
+
+//! (internal)
+uint32_t ProfilingMeshDataStrategy::getMeshIndex(Mesh * m) {
+	std::string name = m->getFileName().toString();
+	if(name.empty()) {
+		char buffer[32];
+		std::snprintf(buffer, sizeof(buffer), "(Mesh %p)", static_cast<void *>(m));
+		name = buffer;
+	}
+	const auto it = meshIndices.find(name);
+	if(it != meshIndices.end())
+		return it->second;
+	const uint32_t index = static_cast<uint32_t>(meshCosts.size());
+	meshIndices.emplace(name, index);
+	meshCosts.emplace_back(std::move(name));
+	return index;
+}
+
+//! ---|> SimpleMeshDataStrategy
+void ProfilingMeshDataStrategy::displayMesh(RenderingContext & context, Mesh * m, uint32_t startIndex, uint32_t indexCount) {
+	const uint32_t meshIndex = getMeshIndex(m);
+	MeshCost & cost = meshCosts[meshIndex];
+	++cost.drawCalls;
+	cost.vertices += indexCount;
+
+#if defined(LIB_GL)
+	if(timestampPool.isNull()) { // the pools require a GL context
+		timestampPool = QueryPool::createTimestampPool(2 * maxDrawsPerFrame, PROFILING_POOL_FRAMES);
+#if defined(GL_ARB_pipeline_statistics_query)
+		const uint32_t primitivesQuery = isExtensionSupported("GL_ARB_pipeline_statistics_query") ? GL_PRIMITIVES_SUBMITTED_ARB : GL_PRIMITIVES_GENERATED;
+#else
+		const uint32_t primitivesQuery = GL_PRIMITIVES_GENERATED;
+#endif
+		primitivesPool = new QueryPool(primitivesQuery, maxDrawsPerFrame, PROFILING_POOL_FRAMES);
+	}
+	if(timestampPool->getNumIssued() + 2 <= timestampPool->getCapacity() && primitivesPool->getNumIssued() < primitivesPool->getCapacity()) {
+		context.applyChanges(); // do not measure the state changes
+		TimedDraw draw;
+		draw.meshIndex = meshIndex;
+		draw.timestampIndex = timestampPool->counter();
+		draw.primitivesIndex = primitivesPool->begin();
+		SimpleMeshDataStrategy::displayMesh(context, m, startIndex, indexCount);
+		primitivesPool->end();
+		timestampPool->counter();
+		currentDraws.push_back(draw);
+		return;
+	}
+#endif
+	SimpleMeshDataStrategy::displayMesh(context, m, startIndex, indexCount);
+}
+
+void ProfilingMeshDataStrategy::nextFrame() {
+	if(timestampPool.isNotNull()) {
+		PendingFrame frame;
+		frame.frameNumber = timestampPool->getFrameNumber();
+		frame.draws.swap(currentDraws);
+		pendingFrames.emplace_back(std::move(frame));
+		timestampPool->nextFrame();
+		primitivesPool->nextFrame();
+
+		// collect the finished frames (in order)
+		while(!pendingFrames.empty()) {
+			const PendingFrame & pending = pendingFrames.front();
+			if(pending.frameNumber + timestampPool->getNumFrames() <= timestampPool->getFrameNumber()) {
+				WARN("ProfilingMeshDataStrategy: Query results have been dropped.");
+			} else if(timestampPool->getResults(pending.frameNumber, timestamps) && primitivesPool->getResults(pending.frameNumber, primitiveCounts)) {
+				for(const auto & draw : pending.draws) {
+					if(draw.timestampIndex + 1 >= timestamps.size() || draw.primitivesIndex >= primitiveCounts.size())
+						continue;
+					MeshCost & cost = meshCosts[draw.meshIndex];
+					const uint64_t begin = timestamps[draw.timestampIndex];
+					const uint64_t end = timestamps[draw.timestampIndex + 1];
+					cost.gpuTime += end > begin ? end - begin : 0;
+					cost.primitives += primitiveCounts[draw.primitivesIndex];
+					++cost.timedDrawCalls;
+				}
+			} else {
+				break;
+			}
+			pendingFrames.pop_front();
+		}
+	}
+	if(++windowFrames >= windowSize)
+		finishWindow();
+}
+
+//! (internal)
+void ProfilingMeshDataStrategy::finishWindow() {
+	lastWindow.clear();
+	for(auto & cost : meshCosts) {
+		if(cost.drawCalls > 0)
+			lastWindow.push_back(cost);
+		// the entries stay, as pending draws refer to them
+		cost = MeshCost(std::move(cost.name));
+	}
+	std::sort(lastWindow.begin(), lastWindow.end(), [](const MeshCost & a, const MeshCost & b) {
+		return a.gpuTime > b.gpuTime;
+	});
+	windowFrames = 0;
+}
+
+std::vector<ProfilingMeshDataStrategy::MeshCost> ProfilingMeshDataStrategy::getMostExpensiveMeshes(uint32_t count) const {
+	std::vector<MeshCost> result;
+	if(!lastWindow.empty()) {
+		result.assign(lastWindow.begin(), lastWindow.begin() + std::min<size_t>(count, lastWindow.size()));
+		return result;
+	}
+	for(const auto & cost : meshCosts) {
+		if(cost.drawCalls > 0)
+			result.push_back(cost);
+	}
+	const size_t n = std::min<size_t>(count, result.size());
+	std::partial_sort(result.begin(), result.begin() + n, result.end(), [](const MeshCost & a, const MeshCost & b) {
+		return a.gpuTime > b.gpuTime;
+	});
+	result.resize(n);
+	return result;
+}
+
+std::string ProfilingMeshDataStrategy::getReport(uint32_t count) const {
+	std::ostringstream s;
+	s << "GPU time [ms]\tdraws\tvertices\tprimitives\tmesh\n";
+	for(const auto & cost : getMostExpensiveMeshes(count)) {
+		s << (cost.gpuTime * 1.0e-6) << '\t' << cost.drawCalls << '\t' << cost.vertices << '\t' << cost.primitives << '\t' << cost.name;
+		if(cost.timedDrawCalls < cost.drawCalls)
+			s << " (" << cost.timedDrawCalls << " timed)";
+		s << '\n';
+	}
+	return s.str();
+}
+
+void ProfilingMeshDataStrategy::reset() {
+	for(auto & cost : meshCosts)
+		cost = MeshCost(std::move(cost.name));
+	lastWindow.clear();
+	windowFrames = 0;
+}
+
+}
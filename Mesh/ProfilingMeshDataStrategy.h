@@ -0,0 +1,112 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_PROFILINGMESHDATASTRATEGY_H_
+#define RENDERING_PROFILINGMESHDATASTRATEGY_H_
+
+#include "MeshDataStrategy.h"
+#include <Util/References.h>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Rendering {
+class QueryPool;
+
+/*!	ProfilingMeshDataStrategy ---|> SimpleMeshDataStrategy ---|> MeshDataStrategy
+	Strategy measuring the GPU cost of every mesh it displays. Each draw call is enclosed by two timestamp queries
+	and a primitives submitted query (GL_PRIMITIVES_GENERATED if GL_ARB_pipeline_statistics_query is not supported)
+	taken from QueryPools, so no query result is ever waited for.
+	The results are collected by nextFrame(), which has to be called once per frame, and are accumulated per mesh
+	(identified by Mesh::getFileName(); meshes without a file name by their address) over a window of frames.
+	After each window, the most expensive meshes can be queried or printed:
+	\code
+	ProfilingMeshDataStrategy profiler(SimpleMeshDataStrategy::USE_VBOS);
+	scene->setDataStrategy(&profiler); // or MeshDataStrategy::setDefaultStrategy(&profiler)
+	// each frame:
+	renderScene();
+	profiler.nextFrame();
+	...
+	std::cout << profiler.getReport(20);
+	\endcode
+	\note Only to be used from the GL thread. Timing every draw call has an overhead on its own and
+		serializes the GPU work a little; the values are meant for comparing meshes, not as absolute costs.	*/
+class ProfilingMeshDataStrategy : public SimpleMeshDataStrategy {
+	public:
+		struct MeshCost {
+			std::string name;
+			uint64_t gpuTime;		//!< nanoseconds
+			uint64_t primitives;
+			uint64_t vertices;		//!< submitted vertices (or indices)
+			uint32_t drawCalls;
+			uint32_t timedDrawCalls; //!< draw calls whose queries have been resolved
+			MeshCost() : gpuTime(0), primitives(0), vertices(0), drawCalls(0), timedDrawCalls(0) {}
+			explicit MeshCost(std::string _name) : name(std::move(_name)), gpuTime(0), primitives(0), vertices(0), drawCalls(0), timedDrawCalls(0) {}
+		};
+
+		/*! @p flags: see SimpleMeshDataStrategy.
+			@param maxDrawsPerFrame number of draw calls per frame that can be timed (further draws are only counted)
+			@param windowSize number of frames over which the costs are accumulated */
+		ProfilingMeshDataStrategy(uint8_t flags, uint32_t maxDrawsPerFrame = 4096, uint32_t windowSize = 60);
+		virtual ~ProfilingMeshDataStrategy();
+
+		//! ---|> SimpleMeshDataStrategy
+		void displayMesh(RenderingContext & context, Mesh * m, uint32_t startIndex, uint32_t indexCount) override;
+
+		//! Finish the current frame and collect the available query results.
+		void nextFrame();
+
+		void setWindowSize(uint32_t frames)						{	windowSize = frames > 0 ? frames : 1;	}
+		uint32_t getWindowSize() const							{	return windowSize;	}
+
+		/*! The @p count meshes with the largest GPU time of the last complete window (sorted by decreasing time).
+			Before the first window is complete, the values accumulated so far are used. */
+		std::vector<MeshCost> getMostExpensiveMeshes(uint32_t count) const;
+		//! Table of getMostExpensiveMeshes(@p count), one line per mesh.
+		std::string getReport(uint32_t count) const;
+
+		//! Forget all accumulated values.
+		void reset();
+
+	private:
+		struct TimedDraw {
+			uint32_t meshIndex;
+			uint32_t timestampIndex;	//!< index of the first of the two timestamps
+			uint32_t primitivesIndex;
+		};
+		struct PendingFrame {
+			uint32_t frameNumber;
+			std::vector<TimedDraw> draws;
+		};
+
+		const uint32_t maxDrawsPerFrame;
+		uint32_t windowSize;
+		uint32_t windowFrames;
+		Util::Reference<QueryPool> timestampPool;
+		Util::Reference<QueryPool> primitivesPool;
+		std::vector<TimedDraw> currentDraws;
+		std::deque<PendingFrame> pendingFrames;
+		//! Accumulated values of the current window; the indices are referenced by pending draws.
+		std::vector<MeshCost> meshCosts;
+		std::unordered_map<std::string, uint32_t> meshIndices;
+		//! Meshes of the last complete window having been drawn, sorted by decreasing GPU time.
+		std::vector<MeshCost> lastWindow;
+		std::vector<uint64_t> timestamps;
+		std::vector<uint64_t> primitiveCounts;
+
+		uint32_t getMeshIndex(Mesh * m);
+		void finishWindow();
+};
+
+}
+
+#endif /* RENDERING_PROFILINGMESHDATASTRATEGY_H_ */
@@ -0,0 +1,186 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "TransformFeedbackMeshDataStrategy.h"
+#include "MeshIndexData.h"
+#include "MeshVertexData.h"
+#include "VertexDescription.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+#include "../RenderingContext/RenderingContext.h"
+#include <Util/Macros.h>
+
+namespace Rendering {
+
+namespace {
+//! (internal) Transform feedback object of a mesh and the revision of the vertex data written by the last capture.
+class FeedbackCapture : public MeshDerivedData {
+	public:
+		uint32_t feedbackId;
+		uint64_t vertexRevision;
+		bool captured;
+		bool active;
+
+		FeedbackCapture() : MeshDerivedData(), feedbackId(0), vertexRevision(0), captured(false), active(false) {
+#if defined(LIB_GL) && defined(GL_ARB_transform_feedback2)
+			glGenTransformFeedbacks(1, &feedbackId);
+#endif
+		}
+		virtual ~FeedbackCapture() {
+#if defined(LIB_GL) && defined(GL_ARB_transform_feedback2)
+			if(feedbackId != 0)
+				glDeleteTransformFeedbacks(1, &feedbackId);
+#endif
+		}
+};
+
+FeedbackCapture * getCapture(Mesh * mesh) {
+	return mesh == nullptr ? nullptr : dynamic_cast<FeedbackCapture *>(mesh->_getTransformFeedback());
+}
+
+//! The vertices are drawn from the capture if the vertex data has not been changed since.
+bool isCaptureValid(Mesh * mesh, const FeedbackCapture * capture) {
+	const MeshVertexData & vd = mesh->_getVertexData();
+	return capture != nullptr && capture->captured && vd.isUploaded() && vd.getRevision() == capture->vertexRevision;
+}
+}
+
+//! (static)
+bool TransformFeedbackMeshDataStrategy::isSupported() {
+#if defined(LIB_GL) && defined(GL_ARB_transform_feedback2)
+	static const bool support = isExtensionSupported("GL_ARB_transform_feedback2");
+	return support;
+#else
+	return false;
+#endif
+}
+
+//! (static)
+TransformFeedbackMeshDataStrategy * TransformFeedbackMeshDataStrategy::getInstance() {
+	static TransformFeedbackMeshDataStrategy strategy;
+	return &strategy;
+}
+
+//! (static)
+Mesh * TransformFeedbackMeshDataStrategy::createMesh(const VertexDescription & vd, uint32_t capacity, Mesh::draw_mode_t drawMode) {
+	auto mesh = new Mesh;
+	mesh->setDrawMode(drawMode);
+	mesh->setUseIndexData(false);
+	mesh->setDataStrategy(getInstance());
+	MeshVertexData & vertices = mesh->openVertexData();
+	vertices.allocate(capacity, vd);
+	vertices.upload(GL_DYNAMIC_COPY);
+	vertices.releaseLocalData();
+	if(isSupported())
+		mesh->_setTransformFeedback(new FeedbackCapture);
+	return mesh;
+}
+
+//! (static)
+bool TransformFeedbackMeshDataStrategy::beginCapture(RenderingContext & context, Mesh * mesh) {
+#if defined(LIB_GL) && defined(GL_ARB_transform_feedback2)
+	FeedbackCapture * capture = getCapture(mesh);
+	if(capture == nullptr || capture->active)
+		return false;
+	MeshVertexData & vd = mesh->_getVertexData();
+	if(vd.hasLocalData() && (vd.hasChanged() || !vd.isUploaded())) // e.g. initial particles written by the application
+		vd.upload(GL_DYNAMIC_COPY);
+	const BufferObject * buffer = vd._getBufferObject();
+	if(buffer == nullptr)
+		return false;
+	GLenum primitiveMode;
+	switch(mesh->getDrawMode()) {
+		case Mesh::DRAW_POINTS:
+			primitiveMode = GL_POINTS;
+			break;
+		case Mesh::DRAW_TRIANGLES:
+			primitiveMode = GL_TRIANGLES;
+			break;
+		default:
+			primitiveMode = GL_LINES;
+			break;
+	}
+	context.applyChanges();
+	glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, capture->feedbackId);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffer->getGLId());
+	glBeginTransformFeedback(primitiveMode);
+	capture->active = true;
+	GET_GL_ERROR();
+	return true;
+#else
+	return false;
+#endif
+}
+
+//! (static)
+void TransformFeedbackMeshDataStrategy::endCapture(RenderingContext & /*context*/, Mesh * mesh) {
+#if defined(LIB_GL) && defined(GL_ARB_transform_feedback2)
+	FeedbackCapture * capture = getCapture(mesh);
+	if(capture == nullptr || !capture->active)
+		return;
+	glEndTransformFeedback();
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+	GET_GL_ERROR();
+	capture->active = false;
+	MeshVertexData & vd = mesh->_getVertexData();
+	vd._markAsChangedOnGPU();
+	capture->vertexRevision = vd.getRevision();
+	capture->captured = true;
+#endif
+}
+
+//! (static)
+bool TransformFeedbackMeshDataStrategy::hasCapturedVertices(Mesh * mesh) {
+	return isCaptureValid(mesh, getCapture(mesh));
+}
+
+//! ---|> MeshDataStrategy
+void TransformFeedbackMeshDataStrategy::assureLocalVertexData(Mesh * m) {
+	MeshVertexData & vd = m->_getVertexData();
+	if(!vd.hasLocalData() && vd.isUploaded())
+		vd.download(); // keeps the revision; the mesh is still drawn from the capture
+}
+
+//! ---|> MeshDataStrategy
+void TransformFeedbackMeshDataStrategy::assureLocalIndexData(Mesh * m) {
+	MeshIndexData & id = m->_getIndexData();
+	if(!id.hasLocalData() && id.isUploaded())
+		id.download();
+}
+
+//! ---|> MeshDataStrategy
+void TransformFeedbackMeshDataStrategy::prepare(Mesh * m) {
+	MeshVertexData & vd = m->_getVertexData();
+	if(!vd.empty() && vd.hasLocalData() && (vd.hasChanged() || !vd.isUploaded()))
+		vd.upload(GL_DYNAMIC_COPY);
+	MeshIndexData & id = m->_getIndexData();
+	if(m->isUsingIndexData() && !id.empty() && id.hasLocalData() && (id.hasChanged() || !id.isUploaded()))
+		id.upload();
+}
+
+//! ---|> MeshDataStrategy
+void TransformFeedbackMeshDataStrategy::displayMesh(RenderingContext & context, Mesh * m, uint32_t firstElement, uint32_t elementCount) {
+	FeedbackCapture * capture = getCapture(m);
+	if(m->isUsingIndexData() || !isCaptureValid(m, capture) || capture->active) {
+		if(!m->empty())
+			MeshDataStrategy::doDisplayMesh(context, m, firstElement, elementCount);
+		return;
+	}
+#if defined(LIB_GL) && defined(GL_ARB_transform_feedback2)
+	MeshVertexData & vd = m->_getVertexData();
+	vd.bind(context, true);
+	glDrawTransformFeedback(m->getGLDrawMode(), capture->feedbackId);
+	vd.unbind(context, true);
+	GET_GL_ERROR();
+#endif
+}
+
+}
@@ -0,0 +1,78 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_TRANSFORMFEEDBACKMESHDATASTRATEGY_H_
+#define RENDERING_TRANSFORMFEEDBACKMESHDATASTRATEGY_H_
+
+#include "MeshDataStrategy.h"
+#include "Mesh.h"
+#include <cstdint>
+
+namespace Rendering {
+class VertexDescription;
+
+/*!	TransformFeedbackMeshDataStrategy ---|> MeshDataStrategy
+	Strategy for meshes whose vertices are written by transform feedback (e.g. by GPU particle systems or
+	tessellation passes) and are drawn without ever reading the number of captured vertices back to the CPU.
+
+	createMesh() creates a mesh with a vertex buffer for a maximum number of vertices and a transform feedback
+	object. Between beginCapture() and endCapture(), the vertices emitted by the active shader are written into the
+	mesh's buffer; the shader's feedback varyings (see Shader::setInterleavedFeedbackVaryings()) have to match the
+	mesh's vertex description. Displaying the mesh afterwards draws the captured vertices with glDrawTransformFeedback.
+	\code
+	Util::Reference<Mesh> particles = TransformFeedbackMeshDataStrategy::createMesh(vd, maxParticles, Mesh::DRAW_POINTS);
+	// each frame
+	context.pushAndSetShader(simulationShader);
+	TransformFeedbackMeshDataStrategy::beginCapture(context, particles.get());
+	context.displayMesh(emitterMesh);
+	TransformFeedbackMeshDataStrategy::endCapture(context, particles.get());
+	context.popShader();
+	context.displayMesh(particles.get()); // draws the captured particles
+	\endcode
+	\note The requested element range is ignored when drawing captured vertices; all of them are drawn.
+	\note The local data is outdated after a capture and is released; it is downloaded from the buffer (the whole
+		capacity) if it is accessed. If the local data is changed, it is uploaded and drawn as usual until the next capture.
+	\note Requires OpenGL 4.0 or GL_ARB_transform_feedback2.	*/
+class TransformFeedbackMeshDataStrategy : public MeshDataStrategy {
+	public:
+		static bool isSupported();
+
+		//! Return the instance shared by all transform feedback meshes.
+		static TransformFeedbackMeshDataStrategy * getInstance();
+
+		/*! Create a mesh (without indices) using this strategy with a vertex buffer for up to @p capacity vertices.
+			\note Has to be called from within the gl-thread; the buffer is created immediately.	*/
+		static Mesh * createMesh(const VertexDescription & vd, uint32_t capacity, Mesh::draw_mode_t drawMode = Mesh::DRAW_POINTS);
+
+		/*! Start capturing the vertices emitted by the following draw calls into the mesh's vertex buffer.
+			The primitive type is derived from the mesh's draw mode (points, lines or triangles).
+			@return @c false if the mesh has not been created by createMesh() or transform feedback is not supported.	*/
+		static bool beginCapture(RenderingContext & context, Mesh * mesh);
+		static void endCapture(RenderingContext & context, Mesh * mesh);
+
+		//! @c true iff the mesh is drawn from its last capture.
+		static bool hasCapturedVertices(Mesh * mesh);
+
+		TransformFeedbackMeshDataStrategy() : MeshDataStrategy() {}
+		virtual ~TransformFeedbackMeshDataStrategy() {}
+
+		//! ---|> MeshDataStrategy
+		void assureLocalVertexData(Mesh * m) override;
+		//! ---|> MeshDataStrategy
+		void assureLocalIndexData(Mesh * m) override;
+		//! ---|> MeshDataStrategy
+		void prepare(Mesh * m) override;
+		//! ---|> MeshDataStrategy
+		void displayMesh(RenderingContext & context, Mesh * m, uint32_t firstElement, uint32_t elementCount) override;
+};
+
+}
+
+#endif /* RENDERING_TRANSFORMFEEDBACKMESHDATASTRATEGY_H_ */
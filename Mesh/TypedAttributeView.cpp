@@ -0,0 +1,30 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "TypedAttributeView.h"
+#include "../GLHeader.h"
+#include <stdexcept>
+#include <string>
+
+namespace Rendering {
+
+uint32_t AttributeValueTraits<float>::getDataType()		{	return GL_FLOAT;	}
+uint32_t AttributeValueTraits<int8_t>::getDataType()	{	return GL_BYTE;	}
+uint32_t AttributeValueTraits<uint8_t>::getDataType()	{	return GL_UNSIGNED_BYTE;	}
+uint32_t AttributeValueTraits<int16_t>::getDataType()	{	return GL_SHORT;	}
+uint32_t AttributeValueTraits<uint16_t>::getDataType()	{	return GL_UNSIGNED_SHORT;	}
+uint32_t AttributeValueTraits<int32_t>::getDataType()	{	return GL_INT;	}
+uint32_t AttributeValueTraits<uint32_t>::getDataType()	{	return GL_UNSIGNED_INT;	}
+
+void throwIncompatibleAttributeView(Util::StringIdentifier name) {
+	throw std::invalid_argument("TypedAttributeView: missing or incompatible attribute '" + name.toString() + '\'');
+}
+
+}
@@ -0,0 +1,193 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESH_TYPEDATTRIBUTEVIEW_H_
+#define RENDERING_MESH_TYPEDATTRIBUTEVIEW_H_
+
+#include "VertexAttribute.h"
+#include "MeshVertexData.h"
+#include "VertexDescription.h"
+
+#include <Geometry/Convert.h>
+#include <Util/StringIdentifier.h>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace Rendering {
+
+/*! Compile-time information about a value type that can be stored in a vertex attribute.
+	toFloat()/fromFloat() use the same conversions as the FloatAttributeAccessors
+	(normalized for bytes, unchanged for all other types). */
+template<typename value_t> struct AttributeValueTraits;
+
+#define RENDERING_ATTRIBUTE_VALUE_TRAITS(_type, _toFloat, _fromFloat) \
+	template<> struct AttributeValueTraits<_type> { \
+		static uint32_t getDataType(); \
+		static float toFloat(_type v)		{	return _toFloat;	} \
+		static _type fromFloat(float f)		{	return _fromFloat;	} \
+	};
+RENDERING_ATTRIBUTE_VALUE_TRAITS(float, v, f)
+RENDERING_ATTRIBUTE_VALUE_TRAITS(int8_t, Geometry::Convert::fromSignedTo<float>(v), Geometry::Convert::toSigned<int8_t>(f))
+RENDERING_ATTRIBUTE_VALUE_TRAITS(uint8_t, Geometry::Convert::fromUnsignedTo<float>(v), Geometry::Convert::toUnsigned<uint8_t>(f))
+RENDERING_ATTRIBUTE_VALUE_TRAITS(int16_t, static_cast<float>(v), static_cast<int16_t>(f))
+RENDERING_ATTRIBUTE_VALUE_TRAITS(uint16_t, static_cast<float>(v), static_cast<uint16_t>(f))
+RENDERING_ATTRIBUTE_VALUE_TRAITS(int32_t, static_cast<float>(v), static_cast<int32_t>(f))
+RENDERING_ATTRIBUTE_VALUE_TRAITS(uint32_t, static_cast<float>(v), static_cast<uint32_t>(f))
+#undef RENDERING_ATTRIBUTE_VALUE_TRAITS
+
+/*! Random access iterator over the values of one attribute of consecutive vertices.
+	Dereferencing yields a pointer to the first value of the attribute of the current vertex. */
+template<typename value_t>
+class StridedAttributeIterator {
+		uint8_t * ptr;
+		std::ptrdiff_t stride;
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef value_t * value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef value_t ** pointer;
+		typedef value_t * reference;
+
+		StridedAttributeIterator() : ptr(nullptr), stride(0) {}
+		StridedAttributeIterator(uint8_t * _ptr, std::ptrdiff_t _stride) : ptr(_ptr), stride(_stride) {}
+
+		value_t * operator*()const							{	return reinterpret_cast<value_t*>(ptr);	}
+		value_t * operator[](difference_type n)const		{	return reinterpret_cast<value_t*>(ptr + n * stride);	}
+
+		StridedAttributeIterator & operator++()				{	ptr += stride;	return *this;	}
+		StridedAttributeIterator operator++(int)			{	StridedAttributeIterator tmp(*this);	ptr += stride;	return tmp;	}
+		StridedAttributeIterator & operator--()				{	ptr -= stride;	return *this;	}
+		StridedAttributeIterator operator--(int)			{	StridedAttributeIterator tmp(*this);	ptr -= stride;	return tmp;	}
+		StridedAttributeIterator & operator+=(difference_type n)	{	ptr += n * stride;	return *this;	}
+		StridedAttributeIterator & operator-=(difference_type n)	{	ptr -= n * stride;	return *this;	}
+		StridedAttributeIterator operator+(difference_type n)const	{	return StridedAttributeIterator(ptr + n * stride, stride);	}
+		StridedAttributeIterator operator-(difference_type n)const	{	return StridedAttributeIterator(ptr - n * stride, stride);	}
+		difference_type operator-(const StridedAttributeIterator & other)const	{	return (ptr - other.ptr) / stride;	}
+
+		bool operator==(const StridedAttributeIterator & other)const	{	return ptr == other.ptr;	}
+		bool operator!=(const StridedAttributeIterator & other)const	{	return ptr != other.ptr;	}
+		bool operator<(const StridedAttributeIterator & other)const		{	return ptr < other.ptr;	}
+		bool operator>(const StridedAttributeIterator & other)const		{	return ptr > other.ptr;	}
+		bool operator<=(const StridedAttributeIterator & other)const	{	return ptr <= other.ptr;	}
+		bool operator>=(const StridedAttributeIterator & other)const	{	return ptr >= other.ptr;	}
+};
+
+/*! Non-virtual view onto a vertex attribute with a data type and a number of values known at compile time.
+	In contrast to the VertexAttributeAccessors, no type dispatch and no range checks are done per access,
+	so loops over a view can be inlined and vectorized by the compiler.
+	Usually, a view is created once per attribute by dispatchAttributeView().
+	\note Like a VertexAttributeAccessor, a view only stays valid as long as the referenced MeshVertexData is not altered externally!
+	\note The view may be used for attributes having more than @p numValues values; the additional values are ignored. */
+template<typename value_t, uint8_t numValues>
+class TypedAttributeView {
+		uint8_t * dataPtr;
+		std::size_t stride;
+		uint32_t count;
+	public:
+		typedef value_t value_type;
+		typedef StridedAttributeIterator<value_t> iterator;
+		static const uint8_t NUM_VALUES = numValues;
+
+		//! Returns true iff a view of this type can be used for the given attribute.
+		static bool isCompatible(const VertexAttribute & attr) {
+			return !attr.empty() && attr.getDataType() == AttributeValueTraits<value_t>::getDataType() && attr.getNumValues() >= numValues;
+		}
+
+		/*! (static factory)
+			Create a view for the given MeshVertexData's attribute having the given name.
+			If the attribute does not exist or is not compatible, an std::invalid_argument exception is thrown. */
+		static TypedAttributeView create(MeshVertexData & vData, Util::StringIdentifier name);
+
+		//! (ctor) The attribute has to be compatible (this is not checked).
+		TypedAttributeView(MeshVertexData & vData, const VertexAttribute & attr) :
+				dataPtr(vData.data() + vData.getAttributeOffset(attr)), stride(vData.getAttributeStride(attr)), count(vData.getVertexCount()) {}
+
+		uint32_t size()const								{	return count;	}
+		std::size_t getStride()const						{	return stride;	}
+
+		value_t * operator[](uint32_t index)const			{	return reinterpret_cast<value_t*>(dataPtr + index * stride);	}
+		value_t get(uint32_t index, uint8_t component)const	{	return (*this)[index][component];	}
+		void set(uint32_t index, uint8_t component, value_t value)const	{	(*this)[index][component] = value;	}
+
+		float getFloat(uint32_t index, uint8_t component)const	{	return AttributeValueTraits<value_t>::toFloat(get(index, component));	}
+		void setFloat(uint32_t index, uint8_t component, float value)const	{	set(index, component, AttributeValueTraits<value_t>::fromFloat(value));	}
+
+		iterator begin()const								{	return iterator(dataPtr, static_cast<std::ptrdiff_t>(stride));	}
+		iterator end()const									{	return begin() + count;	}
+};
+
+//! (internal) Throws an std::invalid_argument exception for an incompatible attribute.
+void throwIncompatibleAttributeView(Util::StringIdentifier name);
+
+template<typename value_t, uint8_t numValues>
+TypedAttributeView<value_t, numValues> TypedAttributeView<value_t, numValues>::create(MeshVertexData & vData, Util::StringIdentifier name) {
+	const VertexAttribute & attr = vData.getVertexDescription().getAttribute(name);
+	if(!isCompatible(attr))
+		throwIncompatibleAttributeView(name);
+	return TypedAttributeView(vData, attr);
+}
+
+//! (internal)
+template<typename value_t, typename Function>
+bool _dispatchAttributeView(MeshVertexData & vData, const VertexAttribute & attr, Function & fun) {
+	switch(attr.getNumValues()) {
+		case 1:		fun(TypedAttributeView<value_t, 1>(vData, attr));	return true;
+		case 2:		fun(TypedAttributeView<value_t, 2>(vData, attr));	return true;
+		case 3:		fun(TypedAttributeView<value_t, 3>(vData, attr));	return true;
+		default:	fun(TypedAttributeView<value_t, 4>(vData, attr));	return true;
+	}
+}
+
+/*! Call @p fun once with the TypedAttributeView matching the data type and the number of values of the given attribute.
+	As C++11 has no generic lambdas, @p fun has to be a function object with a templated call operator:
+	\code
+		struct MinFinder {
+			float min = std::numeric_limits<float>::max();
+			template<class View> void operator()(const View & view) {
+				for(auto it = view.begin(); it != view.end(); ++it)
+					min = std::min(min, AttributeValueTraits<typename View::value_type>::toFloat((*it)[0]));
+			}
+		} finder;
+		dispatchAttributeView(vData, VertexAttributeIds::POSITION, finder);
+	\endcode
+	Attributes with more than four values are passed as four-value views.
+	@return false iff the attribute does not exist or has a data type without AttributeValueTraits (e.g. GL_HALF_FLOAT);
+		@p fun is not called in this case. */
+template<typename Function>
+bool dispatchAttributeView(MeshVertexData & vData, const VertexAttribute & attr, Function & fun) {
+	if(attr.empty())
+		return false;
+	const uint32_t type = attr.getDataType();
+	if(type == AttributeValueTraits<float>::getDataType())
+		return _dispatchAttributeView<float>(vData, attr, fun);
+	else if(type == AttributeValueTraits<uint8_t>::getDataType())
+		return _dispatchAttributeView<uint8_t>(vData, attr, fun);
+	else if(type == AttributeValueTraits<int8_t>::getDataType())
+		return _dispatchAttributeView<int8_t>(vData, attr, fun);
+	else if(type == AttributeValueTraits<uint16_t>::getDataType())
+		return _dispatchAttributeView<uint16_t>(vData, attr, fun);
+	else if(type == AttributeValueTraits<int16_t>::getDataType())
+		return _dispatchAttributeView<int16_t>(vData, attr, fun);
+	else if(type == AttributeValueTraits<uint32_t>::getDataType())
+		return _dispatchAttributeView<uint32_t>(vData, attr, fun);
+	else if(type == AttributeValueTraits<int32_t>::getDataType())
+		return _dispatchAttributeView<int32_t>(vData, attr, fun);
+	return false;
+}
+
+template<typename Function>
+bool dispatchAttributeView(MeshVertexData & vData, Util::StringIdentifier name, Function & fun) {
+	return dispatchAttributeView(vData, vData.getVertexDescription().getAttribute(name), fun);
+}
+
+}
+
+#endif /* RENDERING_MESH_TYPEDATTRIBUTEVIEW_H_ */
@@ -0,0 +1,92 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "VertexArrayObjectCache.h"
+#include "../RenderingContext/RenderingContext.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+#include <algorithm>
+#include <utility>
+
+namespace Rendering {
+
+//! (static)
+bool VertexArrayObjectCache::isSupported() {
+#if defined(LIB_GL)
+	static const bool support = isExtensionSupported("GL_VERSION_3_0") || isExtensionSupported("GL_ARB_vertex_array_object");
+	return support && !RenderingContext::getCompabilityMode();
+#else
+	return false;
+#endif
+}
+
+VertexArrayObjectCache::VertexArrayObjectCache(VertexArrayObjectCache && other) : entries(), bufferId(0) {
+	swap(other);
+}
+
+VertexArrayObjectCache::~VertexArrayObjectCache() {
+	clear();
+}
+
+VertexArrayObjectCache & VertexArrayObjectCache::operator=(VertexArrayObjectCache && other) {
+	clear();
+	swap(other);
+	return *this;
+}
+
+void VertexArrayObjectCache::swap(VertexArrayObjectCache & other) {
+	using std::swap;
+	swap(entries, other.entries);
+	swap(bufferId, other.bufferId);
+}
+
+uint32_t VertexArrayObjectCache::get(uint32_t layoutId, uint32_t _bufferId, uint32_t instanceKey) {
+	if(_bufferId != bufferId) {
+		clear();
+		return 0;
+	}
+	for(const auto & entry : entries) {
+		if(entry.layoutId == layoutId && entry.instanceKey == instanceKey)
+			return entry.vao;
+	}
+	return 0;
+}
+
+uint32_t VertexArrayObjectCache::create(uint32_t layoutId, uint32_t _bufferId, uint32_t instanceKey) {
+#if defined(LIB_GL)
+	if(_bufferId != bufferId) {
+		clear();
+		bufferId = _bufferId;
+	}
+	if(entries.size() >= MAX_ENTRIES) {
+		glDeleteVertexArrays(1, &entries.front().vao);
+		entries.erase(entries.begin());
+	}
+	GLuint vao = 0;
+	glGenVertexArrays(1, &vao);
+	GET_GL_ERROR();
+	if(vao != 0)
+		entries.push_back({layoutId, instanceKey, vao});
+	return vao;
+#else
+	return 0;
+#endif
+}
+
+void VertexArrayObjectCache::clear() {
+#if defined(LIB_GL)
+	for(const auto & entry : entries)
+		glDeleteVertexArrays(1, &entry.vao);
+#endif
+	entries.clear();
+	bufferId = 0;
+}
+
+}
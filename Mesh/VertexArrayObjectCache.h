@@ -0,0 +1,69 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_VERTEXARRAYOBJECTCACHE_H_
+#define RENDERING_VERTEXARRAYOBJECTCACHE_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+
+/*! (internal) Small cache of vertex array objects used by a MeshVertexData.
+	A vertex array object stores the complete attribute setup of one vertex buffer for the attribute
+	locations of one shader. Each entry is therefore keyed by the shader's vertex attribute layout id
+	(@see Shader::getVertexAttributeLayoutId()) and is only valid for the vertex buffer it was created for.
+	If the vertex array object also contains the attributes of an InstanceBuffer, the buffer's layout key
+	(@see InstanceBuffer::_getLayoutKey()) is part of the key as well.
+	\note The vertex description is not part of the key: the owning MeshVertexData clears the cache when
+		its description or its buffer changes.
+	\note All methods (including the destructor) have to be called from within the gl-thread.	*/
+class VertexArrayObjectCache {
+		struct Entry {
+			uint32_t layoutId;
+			uint32_t instanceKey;
+			uint32_t vao;
+		};
+		std::vector<Entry> entries;
+		uint32_t bufferId; //!< gl id of the vertex buffer all entries were created for
+
+	public:
+		static const uint32_t MAX_ENTRIES = 8;
+
+		//! Returns true iff vertex array objects are available and not disabled by the compatibility mode.
+		static bool isSupported();
+
+		VertexArrayObjectCache() : entries(), bufferId(0) {}
+		VertexArrayObjectCache(VertexArrayObjectCache && other);
+		VertexArrayObjectCache(const VertexArrayObjectCache &) = delete;
+		~VertexArrayObjectCache();
+
+		VertexArrayObjectCache & operator=(VertexArrayObjectCache && other);
+		VertexArrayObjectCache & operator=(const VertexArrayObjectCache &) = delete;
+
+		void swap(VertexArrayObjectCache & other);
+
+		/*! Return the vertex array object for the given layout and buffer, or 0 if it does not exist.
+			\note If the buffer differs from the one the cache was created for, all entries are removed. */
+		uint32_t get(uint32_t layoutId, uint32_t bufferId, uint32_t instanceKey = 0);
+
+		/*! Create a new (empty) vertex array object for the given layout and buffer and return it.
+			If the cache is full, the oldest entry is removed.	*/
+		uint32_t create(uint32_t layoutId, uint32_t bufferId, uint32_t instanceKey = 0);
+
+		//! Delete all vertex array objects.
+		void clear();
+		bool empty() const								{	return entries.empty();	}
+		uint32_t size() const							{	return static_cast<uint32_t>(entries.size());	}
+};
+
+}
+
+#endif /* RENDERING_VERTEXARRAYOBJECTCACHE_H_ */
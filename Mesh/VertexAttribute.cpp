@@ -17,6 +17,15 @@
 
 namespace Rendering {
 
+//! (internal) Size in bytes of @p numValues values of the given type. Packed types store all values in one 32 bit word.
+static uint16_t getAttributeDataSize(uint32_t dataType, uint8_t numValues) {
+#if defined(GL_INT_2_10_10_10_REV) && defined(GL_UNSIGNED_INT_2_10_10_10_REV)
+	if(dataType == GL_INT_2_10_10_10_REV || dataType == GL_UNSIGNED_INT_2_10_10_10_REV)
+		return numValues == 0 ? 0 : 4;
+#endif
+	return getGLTypeSize(dataType) * numValues;
+}
+
 VertexAttribute::VertexAttribute() :
 		offset(0),dataSize(0),
 		numValues(0), dataType(GL_FLOAT), nameId(0), normalize(false), convertToFloat(true){
@@ -24,7 +33,7 @@ VertexAttribute::VertexAttribute() :
 
 //! (ctor)
 VertexAttribute::VertexAttribute(uint8_t _numValues, uint32_t _dataType, Util::StringIdentifier _nameId, bool _normalize, bool _convertToFloat /*= true*/) :
-		offset(0), dataSize(getGLTypeSize(_dataType) * _numValues),
+		offset(0), dataSize(getAttributeDataSize(_dataType, _numValues)),
 		numValues(_numValues), dataType(_dataType), nameId(std::move(_nameId)), name(), normalize(_normalize), convertToFloat(_convertToFloat) {
 	if((dataSize % 4) != 0) {
 		WARN("VertexAttribute is not 4-byte aligned.");
@@ -46,7 +55,7 @@ VertexAttribute::VertexAttribute(uint8_t _numValues, uint32_t _dataType, Util::S
 
 //! (ctor)
 VertexAttribute::VertexAttribute(uint16_t _offset,uint8_t _numValues, uint32_t _dataType, Util::StringIdentifier _nameId,std::string _name, bool _normalize, bool _convertToFloat /*= true*/) :
-		offset(_offset),dataSize(getGLTypeSize(_dataType)*_numValues),
+		offset(_offset),dataSize(getAttributeDataSize(_dataType, _numValues)),
 		numValues(_numValues), dataType(_dataType), nameId(std::move(_nameId)),name(std::move(_name)), normalize(_normalize), convertToFloat(_convertToFloat){
 	if((dataSize % 4) != 0) {
 		WARN("VertexAttribute is not 4-byte aligned.");
@@ -12,6 +12,9 @@
 #include "VertexAttributeAccessors.h"
 #include "../GLHeader.h"
 #include <Geometry/Convert.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <sstream>
 #include <exception>
 
@@ -40,6 +43,30 @@ void VertexAttributeAccessor::assertNumValues(uint32_t index, uint32_t count) co
 static const std::string noAttrErrorMsg("No attribute named '");
 static const std::string unimplementedFormatMsg("Attribute format not implemented for attribute '");
 
+//! (helper) Pack up to four values into a signed, normalized 2_10_10_10 value (x in the lowest bits). Missing values are 0.
+static uint32_t packSigned2_10_10_10(const float * values, uint32_t count) {
+	static const float maxValues[4] = {511.0f, 511.0f, 511.0f, 1.0f};
+	static const uint32_t masks[4] = {0x3ff, 0x3ff, 0x3ff, 0x3};
+	uint32_t packed = 0;
+	for(uint32_t i = 0; i < std::min(count, 4u); ++i) {
+		const int32_t v = static_cast<int32_t>(std::round(std::min(1.0f, std::max(-1.0f, values[i])) * maxValues[i]));
+		packed |= (static_cast<uint32_t>(v) & masks[i]) << (10 * i);
+	}
+	return packed;
+}
+
+//! (helper) Unpack the four values of a signed, normalized 2_10_10_10 value.
+static void unpackSigned2_10_10_10(uint32_t packed, float * values) {
+	const int32_t x = static_cast<int32_t>(packed << 22) >> 22;
+	const int32_t y = static_cast<int32_t>(packed << 12) >> 22;
+	const int32_t z = static_cast<int32_t>(packed << 2) >> 22;
+	const int32_t w = static_cast<int32_t>(packed) >> 30;
+	values[0] = std::max(x / 511.0f, -1.0f);
+	values[1] = std::max(y / 511.0f, -1.0f);
+	values[2] = std::max(z / 511.0f, -1.0f);
+	values[3] = std::max(static_cast<float>(w), -1.0f);
+}
+
 //! (helper)
 static const VertexAttribute & assertAttribute(MeshVertexData & _vData, const Util::StringIdentifier name) {
 	const VertexAttribute & attr = _vData.getVertexDescription().getAttribute(name);
@@ -153,6 +180,36 @@ class ColorAttributeAccessor4ub : public ColorAttributeAccessor {
 		}
 };
 
+/*! ColorAttributeAccessor4HF ---|> ColorAttributeAccessor	*/
+class ColorAttributeAccessor4HF : public ColorAttributeAccessor {
+	public:
+		ColorAttributeAccessor4HF(MeshVertexData & _vData, const VertexAttribute & _attribute) :
+			ColorAttributeAccessor(_vData, _attribute) {}
+		virtual ~ColorAttributeAccessor4HF() {}
+
+		//! ---|> ColorAttributeAccessor
+		Util::Color4f getColor4f(uint32_t index)const override {
+			assertRange(index);
+			const uint16_t * v = _ptr<const uint16_t>(index);
+			return Util::Color4f(Geometry::Convert::halfToFloat(v[0]), Geometry::Convert::halfToFloat(v[1]),
+								 Geometry::Convert::halfToFloat(v[2]), Geometry::Convert::halfToFloat(v[3]));
+		}
+		//! ---|> ColorAttributeAccessor
+		Util::Color4ub getColor4ub(uint32_t index)const override {
+			return Util::Color4ub(getColor4f(index));
+		}
+		//! ---|> ColorAttributeAccessor
+		void setColor(uint32_t index, const Util::Color4f & c) override {
+			assertRange(index);
+			uint16_t * v = _ptr<uint16_t>(index);
+			v[0] = Geometry::Convert::floatToHalf(c.getR()) , v[1] = Geometry::Convert::floatToHalf(c.getG());
+			v[2] = Geometry::Convert::floatToHalf(c.getB()) , v[3] = Geometry::Convert::floatToHalf(c.getA());
+		}
+		//! ---|> ColorAttributeAccessor
+		void setColor(uint32_t index, const Util::Color4ub & cub) override {
+			setColor(index, Util::Color4f(cub));
+		}
+};
 
 //! (static) Factory
 Util::Reference<ColorAttributeAccessor> ColorAttributeAccessor::create(MeshVertexData & _vData, Util::StringIdentifier name) {
@@ -163,6 +220,8 @@ Util::Reference<ColorAttributeAccessor> ColorAttributeAccessor::create(MeshVerte
 		return new ColorAttributeAccessor3f(_vData, attr);
 	} else if(attr.getNumValues() >= 4 && attr.getDataType() == GL_UNSIGNED_BYTE) {
 		return new ColorAttributeAccessor4ub(_vData, attr);
+	} else if(attr.getNumValues() >= 4 && attr.getDataType() == GL_HALF_FLOAT) {
+		return new ColorAttributeAccessor4HF(_vData, attr);
 	} else {
 		throw std::invalid_argument(unimplementedFormatMsg + name.toString() + '\'');
 	}
@@ -220,6 +279,100 @@ class NormalAttributeAccessor3f : public NormalAttributeAccessor {
 		}
 };
 
+/*! NormalAttributeAccessorHF ---|> NormalAttributeAccessor */
+class NormalAttributeAccessorHF : public NormalAttributeAccessor {
+	public:
+		NormalAttributeAccessorHF(MeshVertexData & _vData, const VertexAttribute & _attribute) :
+			NormalAttributeAccessor(_vData, _attribute) {}
+		virtual ~NormalAttributeAccessorHF() {}
+
+		//! ---|> NormalAttributeAccessor
+		Geometry::Vec3 getNormal(uint32_t index)const override {
+			assertRange(index);
+			const uint16_t * v = _ptr<const uint16_t>(index);
+			return Geometry::Vec3(Geometry::Convert::halfToFloat(v[0]),
+								  Geometry::Convert::halfToFloat(v[1]),
+								  Geometry::Convert::halfToFloat(v[2]));
+		}
+
+		//! ---|> NormalAttributeAccessor
+		void setNormal(uint32_t index, const Geometry::Vec3 & n) override {
+			assertRange(index);
+			uint16_t * v = _ptr<uint16_t>(index);
+			v[0] = Geometry::Convert::floatToHalf(n.x());
+			v[1] = Geometry::Convert::floatToHalf(n.y());
+			v[2] = Geometry::Convert::floatToHalf(n.z());
+			if(getAttribute().getNumValues() >= 4)
+				v[3] = 0;
+		}
+};
+
+/*! NormalAttributeAccessorPacked ---|> NormalAttributeAccessor
+	Normal stored as signed, normalized 2_10_10_10 value. */
+class NormalAttributeAccessorPacked : public NormalAttributeAccessor {
+	public:
+		NormalAttributeAccessorPacked(MeshVertexData & _vData, const VertexAttribute & _attribute) :
+			NormalAttributeAccessor(_vData, _attribute) {}
+		virtual ~NormalAttributeAccessorPacked() {}
+
+		//! ---|> NormalAttributeAccessor
+		Geometry::Vec3 getNormal(uint32_t index)const override {
+			assertRange(index);
+			uint32_t packed;
+			std::memcpy(&packed, _ptr<const uint8_t>(index), sizeof(packed));
+			float v[4];
+			unpackSigned2_10_10_10(packed, v);
+			return Geometry::Vec3(v[0], v[1], v[2]);
+		}
+
+		//! ---|> NormalAttributeAccessor
+		void setNormal(uint32_t index, const Geometry::Vec3 & n) override {
+			assertRange(index);
+			const float v[3] = {n.x(), n.y(), n.z()};
+			const uint32_t packed = packSigned2_10_10_10(v, 3);
+			std::memcpy(_ptr<uint8_t>(index), &packed, sizeof(packed));
+		}
+};
+
+/*! NormalAttributeAccessorOctahedral ---|> NormalAttributeAccessor
+	Normal stored octahedron-encoded as two signed, normalized short values.
+	@see VertexDescription::appendNormalOctahedral() */
+class NormalAttributeAccessorOctahedral : public NormalAttributeAccessor {
+	public:
+		NormalAttributeAccessorOctahedral(MeshVertexData & _vData, const VertexAttribute & _attribute) :
+			NormalAttributeAccessor(_vData, _attribute) {}
+		virtual ~NormalAttributeAccessorOctahedral() {}
+
+		//! ---|> NormalAttributeAccessor
+		Geometry::Vec3 getNormal(uint32_t index)const override {
+			assertRange(index);
+			const int16_t * v = _ptr<const int16_t>(index);
+			const float x = std::max(v[0] / 32767.0f, -1.0f);
+			const float y = std::max(v[1] / 32767.0f, -1.0f);
+			const float z = 1.0f - std::abs(x) - std::abs(y);
+			const float t = std::max(-z, 0.0f);
+			Geometry::Vec3 n(x >= 0.0f ? x - t : x + t, y >= 0.0f ? y - t : y + t, z);
+			const float length = n.length();
+			return length > 0.0f ? n / length : n;
+		}
+
+		//! ---|> NormalAttributeAccessor
+		void setNormal(uint32_t index, const Geometry::Vec3 & n) override {
+			assertRange(index);
+			const float sum = std::abs(n.x()) + std::abs(n.y()) + std::abs(n.z());
+			float x = sum > 0.0f ? n.x() / sum : 0.0f;
+			float y = sum > 0.0f ? n.y() / sum : 0.0f;
+			if(n.z() < 0.0f) {
+				const float ox = x;
+				x = (1.0f - std::abs(y)) * (ox >= 0.0f ? 1.0f : -1.0f);
+				y = (1.0f - std::abs(ox)) * (y >= 0.0f ? 1.0f : -1.0f);
+			}
+			int16_t * v = _ptr<int16_t>(index);
+			v[0] = static_cast<int16_t>(std::round(std::min(1.0f, std::max(-1.0f, x)) * 32767.0f));
+			v[1] = static_cast<int16_t>(std::round(std::min(1.0f, std::max(-1.0f, y)) * 32767.0f));
+		}
+};
+
 //! (static)
 Util::Reference<NormalAttributeAccessor> NormalAttributeAccessor::create(MeshVertexData & _vData, Util::StringIdentifier name) {
 	const VertexAttribute & attr = assertAttribute(_vData, name);
@@ -227,6 +380,14 @@ Util::Reference<NormalAttributeAccessor> NormalAttributeAccessor::create(MeshVer
 		return new NormalAttributeAccessor3f(_vData, attr);
 	} else if(attr.getNumValues() >= 4 && attr.getDataType() == GL_BYTE) {
 		return new NormalAttributeAccessor4b(_vData, attr);
+	} else if(attr.getNumValues() >= 3 && attr.getDataType() == GL_HALF_FLOAT) {
+		return new NormalAttributeAccessorHF(_vData, attr);
+#ifdef GL_INT_2_10_10_10_REV
+	} else if(attr.getNumValues() == 4 && attr.getDataType() == GL_INT_2_10_10_10_REV) {
+		return new NormalAttributeAccessorPacked(_vData, attr);
+#endif /* GL_INT_2_10_10_10_REV */
+	} else if(attr.getNumValues() == 2 && attr.getDataType() == GL_SHORT) {
+		return new NormalAttributeAccessorOctahedral(_vData, attr);
 	} else {
 		throw std::invalid_argument(unimplementedFormatMsg + name.toString() + '\'');
 	}
@@ -300,11 +461,35 @@ Util::Reference<PositionAttributeAccessor> PositionAttributeAccessor::create(Mes
 // ---------------------------------
 // TexCoord
 
+/*! TexCoordAttributeAccessorHF ---|> TexCoordAttributeAccessor */
+class TexCoordAttributeAccessorHF : public TexCoordAttributeAccessor {
+	public:
+		TexCoordAttributeAccessorHF(MeshVertexData & _vData, const VertexAttribute & _attribute) :
+			TexCoordAttributeAccessor(_vData, _attribute) {}
+		virtual ~TexCoordAttributeAccessorHF() {}
+
+		//! ---|> TexCoordAttributeAccessor
+		const Geometry::Vec2 getCoordinate(uint32_t index) const override {
+			assertRange(index);
+			const uint16_t * v = _ptr<const uint16_t>(index);
+			return Geometry::Vec2(Geometry::Convert::halfToFloat(v[0]), Geometry::Convert::halfToFloat(v[1]));
+		}
+
+		//! ---|> TexCoordAttributeAccessor
+		void setCoordinate(uint32_t index, const Geometry::Vec2 & p) override {
+			assertRange(index);
+			uint16_t * v = _ptr<uint16_t>(index);
+			v[0] = Geometry::Convert::floatToHalf(p.x()) , v[1] = Geometry::Convert::floatToHalf(p.y());
+		}
+};
+
 //! (static)
 Util::Reference<TexCoordAttributeAccessor> TexCoordAttributeAccessor::create(MeshVertexData & _vData, Util::StringIdentifier name) {
 	const VertexAttribute & attr = assertAttribute(_vData, name);
 	if(attr.getNumValues() == 2 && attr.getDataType() == GL_FLOAT) {
 		return new TexCoordAttributeAccessor(_vData, attr);
+	} else if(attr.getNumValues() == 2 && attr.getDataType() == GL_HALF_FLOAT) {
+		return new TexCoordAttributeAccessorHF(_vData, attr);
 	} else {
 		throw std::invalid_argument(unimplementedFormatMsg + name.toString() + '\'');
 	}
@@ -430,12 +615,53 @@ class FloatAttributeAccessorHF : public FloatAttributeAccessor {
 		void setValues(uint32_t index, const float* values, uint32_t count) override {
 			assertRange(index);
 			count = std::min<uint32_t>(count, getAttribute().getNumValues());
-			uint8_t * v = _ptr<uint8_t>(index);
+			uint16_t * v = _ptr<uint16_t>(index);
 			for(uint32_t i=0; i<count; ++i)
 				v[i] = Geometry::Convert::floatToHalf(values[i]);
 		}
 };
 
+/*! FloatAttributeAccessorPacked ---|> FloatAttributeAccessor
+	Four values stored as signed, normalized 2_10_10_10 value. */
+class FloatAttributeAccessorPacked : public FloatAttributeAccessor {
+	public:
+		FloatAttributeAccessorPacked(MeshVertexData & _vData, const VertexAttribute & _attribute) :
+			FloatAttributeAccessor(_vData, _attribute) {}
+		virtual ~FloatAttributeAccessorPacked() {}
+
+		//! ---|> FloatAttributeAccessor
+		float getValue(uint32_t index) const override {
+			return getValues(index)[0];
+		}
+
+		//! ---|> FloatAttributeAccessor
+		void setValue(uint32_t index, float value) override {
+			setValues(index, &value, 1);
+		}
+
+		//! ---|> FloatAttributeAccessor
+		const std::vector<float> getValues(uint32_t index) const override {
+			assertRange(index);
+			uint32_t packed;
+			std::memcpy(&packed, _ptr<const uint8_t>(index), sizeof(packed));
+			std::vector<float> out(4);
+			unpackSigned2_10_10_10(packed, out.data());
+			return out;
+		}
+
+		//! ---|> FloatAttributeAccessor
+		void setValues(uint32_t index, const float* values, uint32_t count) override {
+			assertRange(index);
+			uint32_t packed;
+			std::memcpy(&packed, _ptr<const uint8_t>(index), sizeof(packed));
+			float v[4];
+			unpackSigned2_10_10_10(packed, v);
+			std::copy(values, values + std::min(count, 4u), v);
+			packed = packSigned2_10_10_10(v, 4);
+			std::memcpy(_ptr<uint8_t>(index), &packed, sizeof(packed));
+		}
+};
+
 /*! FloatAttributeAccessorf ---|> FloatAttributeAccessor */
 class FloatAttributeAccessorf : public FloatAttributeAccessor {
 	public:
@@ -484,6 +710,10 @@ Util::Reference<FloatAttributeAccessor> FloatAttributeAccessor::create(MeshVerte
 		return new FloatAttributeAccessorub(_vData, attr);
 	} else if(attr.getDataType() == GL_HALF_FLOAT) {
 		return new FloatAttributeAccessorHF(_vData, attr);
+#ifdef GL_INT_2_10_10_10_REV
+	} else if(attr.getNumValues() == 4 && attr.getDataType() == GL_INT_2_10_10_10_REV) {
+		return new FloatAttributeAccessorPacked(_vData, attr);
+#endif /* GL_INT_2_10_10_10_REV */
 	} else {
 		throw std::invalid_argument(unimplementedFormatMsg + name.toString() + '\'');
 	}
@@ -36,8 +36,8 @@ class VertexAttributeAccessor : public Util::ReferenceCounter<VertexAttributeAcc
 
 		VertexAttributeAccessor(MeshVertexData & _vData,VertexAttribute _attribute) :
 				ReferenceCounter_t(),vData(_vData),attribute(std::move(_attribute)),
-				vertexSize(_vData.getVertexDescription().getVertexSize()),
-				dataPtr( vData.data() + attribute.getOffset() ) {}
+				vertexSize(_vData.getAttributeStride(attribute)),
+				dataPtr( vData.data() + _vData.getAttributeOffset(attribute) ) {}
 
 		void assertRange(uint32_t index)const			{	if(index>=vData.getVertexCount()) throwRangeError(index); }
 		void assertNumValues(uint32_t index, uint32_t count) const;
@@ -139,13 +139,13 @@ class TexCoordAttributeAccessor : public VertexAttributeAccessor{
 
 		virtual ~TexCoordAttributeAccessor(){}
 
-		const Geometry::Vec2 getCoordinate(uint32_t index)const	{
+		virtual const Geometry::Vec2 getCoordinate(uint32_t index)const	{
 			assertRange(index);
 			const float * v=_ptr<const float>(index);
 			return Geometry::Vec2(v[0],v[1]);
 		}
 
-		void setCoordinate(uint32_t index,const Geometry::Vec2 & p){
+		virtual void setCoordinate(uint32_t index,const Geometry::Vec2 & p){
 			assertRange(index);
 			float * v=_ptr<float>(index);
 			v[0] = p.x() , v[1] = p.y();
@@ -26,6 +26,8 @@ const Util::StringIdentifier 	VertexAttributeIds::TEXCOORD4("sg_TexCoord4");
 const Util::StringIdentifier 	VertexAttributeIds::TEXCOORD5("sg_TexCoord5");
 const Util::StringIdentifier 	VertexAttributeIds::TEXCOORD6("sg_TexCoord6");
 const Util::StringIdentifier 	VertexAttributeIds::TEXCOORD7("sg_TexCoord7");
+const Util::StringIdentifier 	VertexAttributeIds::JOINTS("sg_Joints");
+const Util::StringIdentifier 	VertexAttributeIds::WEIGHTS("sg_Weights");
 
 //! (static)
 Util::StringIdentifier VertexAttributeIds::getTextureCoordinateIdentifier(uint_fast8_t textureUnit) {
@@ -30,6 +30,10 @@ extern const Util::StringIdentifier 	TEXCOORD4;
 extern const Util::StringIdentifier 	TEXCOORD5;
 extern const Util::StringIdentifier 	TEXCOORD6;
 extern const Util::StringIdentifier 	TEXCOORD7;
+//! Indices of up to four joints influencing a skinned vertex. \see SkinningPalette
+extern const Util::StringIdentifier 	JOINTS;
+//! Weights of the joints given by JOINTS.
+extern const Util::StringIdentifier 	WEIGHTS;
 
 //! Helper function to access the texture coordinate identifiers TEXCOORD0 to TEXCOORD7 by a variable.
 extern Util::StringIdentifier getTextureCoordinateIdentifier(uint_fast8_t textureUnit);
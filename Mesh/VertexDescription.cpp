@@ -28,7 +28,11 @@ const VertexAttribute & VertexDescription::appendAttribute(const Util::StringIde
 	return attributes.back();
 }
 const VertexAttribute & VertexDescription::appendAttribute(const Util::StringIdentifier & nameId, uint8_t numValues, uint32_t glType) {
-	return appendAttribute(nameId,numValues,glType,glType==GL_BYTE || glType==GL_UNSIGNED_BYTE);
+	bool normalize = glType==GL_BYTE || glType==GL_UNSIGNED_BYTE;
+#if defined(GL_INT_2_10_10_10_REV) && defined(GL_UNSIGNED_INT_2_10_10_10_REV)
+	normalize = normalize || glType==GL_INT_2_10_10_10_REV || glType==GL_UNSIGNED_INT_2_10_10_10_REV;
+#endif
+	return appendAttribute(nameId,numValues,glType,normalize);
 }
 
 const VertexAttribute & VertexDescription::appendAttribute(const std::string & name, uint8_t numValues, uint32_t type, bool normalize, bool convertToFloat/*=true*/) {
@@ -137,10 +141,34 @@ const VertexAttribute & VertexDescription::appendColorRGBAFloat() {
 	return appendAttribute(VertexAttributeIds::COLOR, 4, GL_FLOAT, false);
 }
 
+const VertexAttribute & VertexDescription::appendJointIndices() {
+	return appendAttribute(VertexAttributeIds::JOINTS, 4, GL_UNSIGNED_BYTE, false, false);
+}
+
+const VertexAttribute & VertexDescription::appendJointWeights() {
+	return appendAttribute(VertexAttributeIds::WEIGHTS, 4, GL_FLOAT, false);
+}
+
 const VertexAttribute & VertexDescription::appendNormalByte() {
 	return appendAttribute(VertexAttributeIds::NORMAL, 4, GL_BYTE, true);
 }
 
+const VertexAttribute & VertexDescription::appendNormalPacked() {
+#ifdef GL_INT_2_10_10_10_REV
+	return appendAttribute(VertexAttributeIds::NORMAL, 4, GL_INT_2_10_10_10_REV, true);
+#else
+	return appendNormalByte();
+#endif /* GL_INT_2_10_10_10_REV */
+}
+
+const VertexAttribute & VertexDescription::appendNormalHalf() {
+	return appendAttribute(VertexAttributeIds::NORMAL, 4, GL_HALF_FLOAT, false);
+}
+
+const VertexAttribute & VertexDescription::appendNormalOctahedral() {
+	return appendAttribute(VertexAttributeIds::NORMAL, 2, GL_SHORT, true);
+}
+
 const VertexAttribute & VertexDescription::appendNormalFloat() {
 	return appendAttribute(VertexAttributeIds::NORMAL, 3, GL_FLOAT, false);
 }
@@ -165,5 +193,9 @@ const VertexAttribute & VertexDescription::appendTexCoord(uint_fast8_t textureUn
 	return appendAttribute(VertexAttributeIds::getTextureCoordinateIdentifier(textureUnit), 2, GL_FLOAT, false);
 }
 
+const VertexAttribute & VertexDescription::appendTexCoordHalf(uint_fast8_t textureUnit /*= 0*/) {
+	return appendAttribute(VertexAttributeIds::getTextureCoordinateIdentifier(textureUnit), 2, GL_HALF_FLOAT, false);
+}
+
 
 }
@@ -60,9 +60,33 @@ class VertexDescription {
 		//! Add a three-dimensional normal attribute. It is stored as four byte values.
 		const VertexAttribute & appendNormalByte();
 
+		/*! Add a three-dimensional normal attribute. It is stored as one signed, normalized 2_10_10_10 value (four bytes).
+			\note Requires OpenGL 3.3 or GL_ARB_vertex_type_2_10_10_10_rev. Without support for the type, four byte values are used. */
+		const VertexAttribute & appendNormalPacked();
+
+		//! Add a three-dimensional normal attribute. It is stored as four half float values.
+		const VertexAttribute & appendNormalHalf();
+
+		/*! Add a three-dimensional normal attribute. It is stored octahedron-encoded as two signed, normalized short values.
+			\note The shader has to decode the normal, e.g.:
+			\code
+			vec3 n = vec3(sg_Normal.xy, 1.0 - abs(sg_Normal.x) - abs(sg_Normal.y));
+			float t = max(-n.z, 0.0);
+			n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+			n = normalize(n);
+			\endcode */
+		const VertexAttribute & appendNormalOctahedral();
+
 		//! Add a three-dimensional normal attribute. It is stored as three float values.
 		const VertexAttribute & appendNormalFloat();
 
+		/*! Add the joint indices of a skinned vertex. They are stored as four unsigned byte values, which are
+			passed to the shader as integers (uvec4). Unused joints should have a weight of zero.	*/
+		const VertexAttribute & appendJointIndices();
+
+		//! Add the joint weights of a skinned vertex. They are stored as four float values.
+		const VertexAttribute & appendJointWeights();
+
 		//! Add a two-dimensional position attribute. It is stored as two float values.
 		const VertexAttribute & appendPosition2D();
 
@@ -78,6 +102,9 @@ class VertexDescription {
 		//! Add a texture coordinate attribute. It is stored as two float values.
 		const VertexAttribute & appendTexCoord(uint_fast8_t textureUnit = 0);
 
+		//! Add a texture coordinate attribute. It is stored as two half float values.
+		const VertexAttribute & appendTexCoordHalf(uint_fast8_t textureUnit = 0);
+
 		/*! Get a reference to the attribute with the corresponding name.
 			\return Always returns an attribute.
 					If the attribute is not present in the vertex description, it is empty.
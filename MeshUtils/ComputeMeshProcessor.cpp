@@ -0,0 +1,321 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ComputeMeshProcessor.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexDescription.h"
+#include "../RenderingContext/RenderingContext.h"
+#include "../Shader/Shader.h"
+#include "../Shader/ShaderObjectInfo.h"
+#include "../Shader/Uniform.h"
+#include <Geometry/Box.h>
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Vec3.h>
+#include <Util/Macros.h>
+#include <string>
+
+namespace Rendering {
+namespace MeshUtils {
+
+/* The vertex buffer is accessed as array of 32-bit words; all offsets and strides are given in words.
+	vertexFormat: 0: no normals, 1: three float normals, 2: four normalized byte normals.	*/
+static const char * const commonProgram =
+R"***(#version 430
+layout(local_size_x = 128) in;
+uniform int positionOffset;
+uniform int positionStride;
+uniform int normalOffset;
+uniform int normalStride;
+uniform int normalFormat;
+)***";
+
+static const char * const transformProgram =
+R"***(
+layout(std430, binding = 0) buffer Vertices { uint vertexData[]; };
+uniform mat4 transformation;
+uniform int vertexCount;
+
+void main() {
+	const uint i = gl_GlobalInvocationID.x;
+	if(i >= uint(vertexCount))
+		return;
+	const uint p = uint(positionOffset) + i * uint(positionStride);
+	vec4 pos = transformation * vec4(uintBitsToFloat(vertexData[p]), uintBitsToFloat(vertexData[p + 1u]), uintBitsToFloat(vertexData[p + 2u]), 1.0);
+	pos.xyz /= pos.w;
+	vertexData[p] = floatBitsToUint(pos.x);
+	vertexData[p + 1u] = floatBitsToUint(pos.y);
+	vertexData[p + 2u] = floatBitsToUint(pos.z);
+
+	const uint n = uint(normalOffset) + i * uint(normalStride);
+	if(normalFormat == 1) {
+		const vec3 normal = mat3(transformation) * vec3(uintBitsToFloat(vertexData[n]), uintBitsToFloat(vertexData[n + 1u]), uintBitsToFloat(vertexData[n + 2u]));
+		vertexData[n] = floatBitsToUint(normal.x);
+		vertexData[n + 1u] = floatBitsToUint(normal.y);
+		vertexData[n + 2u] = floatBitsToUint(normal.z);
+	} else if(normalFormat == 2) {
+		vec4 normal = unpackSnorm4x8(vertexData[n]);
+		normal.xyz = mat3(transformation) * normal.xyz;
+		vertexData[n] = packSnorm4x8(normal);
+	}
+}
+)***";
+
+// The normalized face normals are summed up per vertex as fixed point values with atomicAdd.
+static const char * const faceNormalProgram =
+R"***(
+layout(std430, binding = 0) readonly buffer Vertices { uint vertexData[]; };
+layout(std430, binding = 1) readonly buffer Indices { uint indexData[]; };
+layout(std430, binding = 2) buffer NormalSums { int normalSums[]; };
+uniform int triangleCount;
+uniform int indexSize;	// in bytes
+
+const float FIXED_POINT_SCALE = 65536.0;
+
+uint readIndex(const uint i) {
+	if(indexSize == 4)
+		return indexData[i];
+	else if(indexSize == 2)
+		return (indexData[i >> 1u] >> ((i & 1u) * 16u)) & 0xffffu;
+	return (indexData[i >> 2u] >> ((i & 3u) * 8u)) & 0xffu;
+}
+
+vec3 readPosition(const uint v) {
+	const uint p = uint(positionOffset) + v * uint(positionStride);
+	return vec3(uintBitsToFloat(vertexData[p]), uintBitsToFloat(vertexData[p + 1u]), uintBitsToFloat(vertexData[p + 2u]));
+}
+
+void main() {
+	const uint t = gl_GlobalInvocationID.x;
+	if(t >= uint(triangleCount))
+		return;
+	const uint ia = readIndex(t * 3u);
+	const uint ib = readIndex(t * 3u + 1u);
+	const uint ic = readIndex(t * 3u + 2u);
+	const vec3 a = readPosition(ia);
+	const vec3 b = readPosition(ib);
+	const vec3 c = readPosition(ic);
+	vec3 n = cross(c - b, a - b);
+	const float len = length(n);
+	if(len > 0.0)
+		n /= len;
+	const ivec3 fixedNormal = ivec3(round(n * FIXED_POINT_SCALE));
+	const uint v[3] = uint[3](ia, ib, ic);
+	for(int k = 0; k < 3; ++k) {
+		atomicAdd(normalSums[v[k] * 3u], fixedNormal.x);
+		atomicAdd(normalSums[v[k] * 3u + 1u], fixedNormal.y);
+		atomicAdd(normalSums[v[k] * 3u + 2u], fixedNormal.z);
+	}
+}
+)***";
+
+static const char * const vertexNormalProgram =
+R"***(
+layout(std430, binding = 0) buffer Vertices { uint vertexData[]; };
+layout(std430, binding = 2) readonly buffer NormalSums { int normalSums[]; };
+uniform int vertexCount;
+
+void main() {
+	const uint i = gl_GlobalInvocationID.x;
+	if(i >= uint(vertexCount))
+		return;
+	vec3 normal = vec3(normalSums[i * 3u], normalSums[i * 3u + 1u], normalSums[i * 3u + 2u]);
+	const float len = length(normal);
+	if(len > 0.0)
+		normal /= len;
+	const uint n = uint(normalOffset) + i * uint(normalStride);
+	if(normalFormat == 1) {
+		vertexData[n] = floatBitsToUint(normal.x);
+		vertexData[n + 1u] = floatBitsToUint(normal.y);
+		vertexData[n + 2u] = floatBitsToUint(normal.z);
+	} else {
+		vertexData[n] = packSnorm4x8(vec4(normal, unpackSnorm4x8(vertexData[n]).w));
+	}
+}
+)***";
+
+//! (static)
+bool ComputeMeshProcessor::isSupported() {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	static const bool support = isExtensionSupported("GL_ARB_compute_shader") &&
+								isExtensionSupported("GL_ARB_shader_storage_buffer_object");
+	return support;
+#else
+	return false;
+#endif
+}
+
+ComputeMeshProcessor::ComputeMeshProcessor() : ReferenceCounter_t(), normalSumsCapacity(0) {
+}
+
+ComputeMeshProcessor::~ComputeMeshProcessor() = default;
+
+//! (internal)
+void ComputeMeshProcessor::initShaders() {
+	if(transformShader.isNotNull())
+		return;
+	transformShader = Shader::createShader(Shader::USE_UNIFORMS);
+	transformShader->attachShaderObject(ShaderObjectInfo::createCompute(std::string(commonProgram) + transformProgram));
+	faceNormalShader = Shader::createShader(Shader::USE_UNIFORMS);
+	faceNormalShader->attachShaderObject(ShaderObjectInfo::createCompute(std::string(commonProgram) + faceNormalProgram));
+	vertexNormalShader = Shader::createShader(Shader::USE_UNIFORMS);
+	vertexNormalShader->attachShaderObject(ShaderObjectInfo::createCompute(std::string(commonProgram) + vertexNormalProgram));
+}
+
+//! (internal) 0: no normals, 1: float normals, 2: byte normals, -1: unsupported normals
+static int32_t getNormalFormat(const VertexAttribute & normal) {
+	if(normal.empty())
+		return 0;
+	if(normal.getDataType() == GL_FLOAT && normal.getNumValues() >= 3)
+		return 1;
+	if(normal.getDataType() == GL_BYTE && normal.getNumValues() == 4)
+		return 2;
+	return -1;
+}
+
+//! (static)
+bool ComputeMeshProcessor::canProcess(Mesh * mesh) {
+	if(mesh == nullptr || mesh->isView())
+		return false;
+	const MeshVertexData & vData = mesh->_getVertexData();
+	const VertexDescription & vd = vData.getVertexDescription();
+	const VertexAttribute & position = vd.getAttribute(VertexAttributeIds::POSITION);
+	const VertexAttribute & normal = vd.getAttribute(VertexAttributeIds::NORMAL);
+	if(vData.empty() || position.empty() || position.getDataType() != GL_FLOAT || position.getNumValues() < 3 || getNormalFormat(normal) < 0)
+		return false;
+	for(const VertexAttribute * attr : {&position, &normal}) {
+		if(!attr->empty() && ((vData.getAttributeOffset(*attr) % 4) != 0 || (vData.getAttributeStride(*attr) % 4) != 0))
+			return false;
+	}
+	return true;
+}
+
+//! (internal)
+bool ComputeMeshProcessor::prepareVertexData(Mesh * mesh) {
+	if(!isSupported() || !canProcess(mesh))
+		return false;
+	MeshVertexData & vData = mesh->_getVertexData();
+	if(vData.hasLocalData() && (vData.hasChanged() || !vData.isUploaded()))
+		vData.upload();
+	// the buffer has to be owned exclusively; the vertices of copies must not change
+	return vData._getBufferObject() != nullptr && vData.getSharedBufferSize() == 0 && !vData.hasChanged();
+}
+
+//! (internal) Set the attribute location uniforms shared by all programs.
+static void setAttributeUniforms(RenderingContext & context, Shader * shader, const MeshVertexData & vData) {
+	const VertexDescription & vd = vData.getVertexDescription();
+	const VertexAttribute & position = vd.getAttribute(VertexAttributeIds::POSITION);
+	const VertexAttribute & normal = vd.getAttribute(VertexAttributeIds::NORMAL);
+	shader->setUniform(context, Uniform("positionOffset", static_cast<int32_t>(vData.getAttributeOffset(position) / 4)));
+	shader->setUniform(context, Uniform("positionStride", static_cast<int32_t>(vData.getAttributeStride(position) / 4)));
+	shader->setUniform(context, Uniform("normalOffset", normal.empty() ? 0 : static_cast<int32_t>(vData.getAttributeOffset(normal) / 4)));
+	shader->setUniform(context, Uniform("normalStride", normal.empty() ? 0 : static_cast<int32_t>(vData.getAttributeStride(normal) / 4)));
+	shader->setUniform(context, Uniform("normalFormat", getNormalFormat(normal)));
+}
+
+bool ComputeMeshProcessor::transform(RenderingContext & context, Mesh * mesh, const Geometry::Matrix4x4 & transMat) {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	if(!prepareVertexData(mesh))
+		return false;
+	initShaders();
+	MeshVertexData & vData = mesh->_getVertexData();
+	const uint32_t vertexCount = vData.getVertexCount();
+
+	context.pushAndSetShader(transformShader.get());
+	Shader * shader = transformShader.get();
+	setAttributeUniforms(context, shader, vData);
+	shader->setUniform(context, Uniform("transformation", transMat));
+	shader->setUniform(context, Uniform("vertexCount", static_cast<int32_t>(vertexCount)));
+	const BufferObject * vertexBuffer = vData._getBufferObject();
+	vertexBuffer->bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 0);
+	context.dispatchCompute((vertexCount + 127) / 128);
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+	vertexBuffer->unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 0);
+	context.popShader();
+	GET_GL_ERROR();
+
+	// the transformed corners of the old box enclose the transformed vertices
+	const Geometry::Box oldBox = vData.getBoundingBox();
+	Geometry::Box box;
+	box.invalidate();
+	for(uint_fast8_t corner = 0; corner < 8; ++corner) {
+		const Geometry::Vec3 p((corner & 1) != 0 ? oldBox.getMaxX() : oldBox.getMinX(),
+							   (corner & 2) != 0 ? oldBox.getMaxY() : oldBox.getMinY(),
+							   (corner & 4) != 0 ? oldBox.getMaxZ() : oldBox.getMinZ());
+		box.include(transMat.transformPosition(p));
+	}
+	vData._markAsChangedOnGPU();
+	vData._setBoundingBox(box);
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool ComputeMeshProcessor::calculateNormals(RenderingContext & context, Mesh * mesh) {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	if(mesh == nullptr || mesh->getDrawMode() != Mesh::DRAW_TRIANGLES || !mesh->isUsingIndexData() ||
+			!mesh->getVertexDescription().hasAttribute(VertexAttributeIds::NORMAL) || !prepareVertexData(mesh))
+		return false;
+	MeshIndexData & iData = mesh->_getIndexData();
+	if(iData.hasLocalData() && (iData.hasChanged() || !iData.isUploaded()))
+		iData.upload();
+	const BufferObject * indexBuffer = iData._getBufferObject();
+	if(indexBuffer == nullptr || iData.hasChanged())
+		return false;
+	initShaders();
+	MeshVertexData & vData = mesh->_getVertexData();
+	const uint32_t vertexCount = vData.getVertexCount();
+	const uint32_t triangleCount = iData.getIndexCount() / 3;
+
+	if(normalSumsCapacity < vertexCount) {
+		normalSumsCapacity = vertexCount;
+		normalSums.allocateData<int32_t>(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 3 * static_cast<size_t>(vertexCount), BufferObject::USAGE_DYNAMIC_COPY);
+	}
+	normalSums.clear(BufferObject::TARGET_SHADER_STORAGE_BUFFER, GL_R32I, GL_RED_INTEGER, GL_INT);
+
+	const BufferObject * vertexBuffer = vData._getBufferObject();
+	vertexBuffer->bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 0);
+	indexBuffer->bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 1);
+	normalSums.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 2);
+
+	context.pushAndSetShader(faceNormalShader.get());
+	setAttributeUniforms(context, faceNormalShader.get(), vData);
+	faceNormalShader->setUniform(context, Uniform("triangleCount", static_cast<int32_t>(triangleCount)));
+	faceNormalShader->setUniform(context, Uniform("indexSize", static_cast<int32_t>(iData.getUploadedIndexSize())));
+	context.dispatchCompute((triangleCount + 127) / 128);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	context.popShader();
+
+	context.pushAndSetShader(vertexNormalShader.get());
+	setAttributeUniforms(context, vertexNormalShader.get(), vData);
+	vertexNormalShader->setUniform(context, Uniform("vertexCount", static_cast<int32_t>(vertexCount)));
+	context.dispatchCompute((vertexCount + 127) / 128);
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+	context.popShader();
+
+	normalSums.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 2);
+	indexBuffer->unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 1);
+	vertexBuffer->unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 0);
+	GET_GL_ERROR();
+
+	vData._markAsChangedOnGPU();
+	return true;
+#else
+	return false;
+#endif
+}
+
+}
+}
@@ -0,0 +1,79 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_COMPUTEMESHPROCESSOR_H_
+#define RENDERING_MESHUTILS_COMPUTEMESHPROCESSOR_H_
+
+#include "../BufferObject.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+
+namespace Geometry {
+template<typename _T> class _Matrix4x4;
+typedef _Matrix4x4<float> Matrix4x4;
+}
+
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+class Shader;
+namespace MeshUtils {
+
+/**
+ * Compute shader versions of MeshUtils::transform(...) and MeshUtils::calculateNormals(...) for meshes whose
+ * vertex data is stored in graphics memory. The vertex buffer is modified directly, so neither a download nor
+ * an upload is necessary; the local copy of the vertex data is released afterwards as it is outdated
+ * (it is downloaded again if it is accessed).
+ * \code
+ * if(!processor->transform(renderingContext, mesh, matrix))
+ *     MeshUtils::transform(mesh->openVertexData(), matrix); // fallback
+ * \endcode
+ * @note The positions have to be stored as three floats; normals as three floats or as four normalized bytes.
+ *   The vertex buffer must not be shared with copies of the mesh (see MeshVertexData::getSharedBufferSize()),
+ *   and must not be stored in a streaming buffer or an arena.
+ * @note Requires OpenGL 4.3 (compute shaders and shader storage buffers).
+ */
+class ComputeMeshProcessor : public Util::ReferenceCounter<ComputeMeshProcessor> {
+	public:
+		static bool isSupported();
+
+		ComputeMeshProcessor();
+		~ComputeMeshProcessor();
+
+		//! @c true iff the vertex data of the mesh can be processed (see the notes above); the data may still have to be uploaded.
+		static bool canProcess(Mesh * mesh);
+
+		/*! Transform the positions and normals of the mesh by the given matrix (like MeshUtils::transform(...)).
+			The bounding box is transformed as well (which may enlarge it).
+			@return @c false if the mesh cannot be processed; it is not changed in this case.	*/
+		bool transform(RenderingContext & context, Mesh * mesh, const Geometry::Matrix4x4 & transMat);
+
+		/*! Recalculate the normals of a triangle mesh with indices (like MeshUtils::calculateNormals(...)).
+			The mesh must already have a normal attribute.
+			@return @c false if the mesh cannot be processed; it is not changed in this case.	*/
+		bool calculateNormals(RenderingContext & context, Mesh * mesh);
+
+	private:
+		Util::Reference<Shader> transformShader;
+		Util::Reference<Shader> faceNormalShader;
+		Util::Reference<Shader> vertexNormalShader;
+		//! Fixed point sums of the face normals (three values per vertex)
+		BufferObject normalSums;
+		uint32_t normalSumsCapacity;
+
+		void initShaders();
+		//! (internal) Upload the vertex data if necessary; returns false if it cannot be processed.
+		bool prepareVertexData(Mesh * mesh);
+};
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_COMPUTEMESHPROCESSOR_H_ */
@@ -14,14 +14,16 @@
 #include "../Mesh/MeshVertexData.h"
 #include "../Mesh/VertexAttributeAccessors.h"
 #include "../Mesh/VertexAttributeIds.h"
+#include "internal/ParallelFor.h"
 
 #include <Util/StringUtils.h>
 
 #include <Geometry/Vec3.h>
 #include <Geometry/Triangle.h>
 
+#include <algorithm>
+#include <atomic>
 #include <limits>
-#include <set>
 
 #define INVALID std::numeric_limits<uint32_t>::max()
 
@@ -36,8 +38,8 @@ void ConnectivityAccessor::assertCornerRange(uint32_t cIndex) const {
 }
 
 void ConnectivityAccessor::assertVertexRange(uint32_t vIndex) const {
-	if(vIndex >= vertexCorners.size())
-		throw std::invalid_argument("Trying to access vertex " + Util::StringUtils::toString(vIndex) + " of overall " + Util::StringUtils::toString(vertexCorners.size()) + " vertices.");
+	if(vIndex >= vertexCount)
+		throw std::invalid_argument("Trying to access vertex " + Util::StringUtils::toString(vIndex) + " of overall " + Util::StringUtils::toString(vertexCount) + " vertices.");
 }
 
 void ConnectivityAccessor::assertTriangleRange(uint32_t tIndex) const {
@@ -45,32 +47,89 @@ void ConnectivityAccessor::assertTriangleRange(uint32_t tIndex) const {
 		throw std::invalid_argument("Trying to access triangle " + Util::StringUtils::toString(tIndex) + " of overall " + Util::StringUtils::toString(indices.getIndexCount()/3) + " triangles.");
 }
 
+namespace {
+//! Corner connectivity of a mesh's indices cached by the mesh (see Mesh::_getConnectivity()).
+class MeshConnectivity : public MeshDerivedData {
+	public:
+		std::vector<uint32_t> vertexCornerOffsets;
+		std::vector<uint32_t> vertexCornerList;
+		std::vector<uint32_t> nextVertexCorners;
+		uint64_t indexRevision;
+		uint32_t vertexCount;
+
+		MeshConnectivity(const MeshIndexData & indices, uint32_t vertexCount);
+		bool isValidFor(const Mesh * mesh) const {
+			return indexRevision == mesh->_getIndexData().getRevision() && vertexCount == mesh->getVertexCount();
+		}
+};
+
+/*! Counting sort of the corners by their vertex: the corners are counted and scattered in parallel using atomic
+	counters; sorting the (short) corner list of every vertex afterwards makes the result independent of the
+	scheduling of the threads. */
+MeshConnectivity::MeshConnectivity(const MeshIndexData & indices, uint32_t _vertexCount) :
+		MeshDerivedData(), indexRevision(indices.getRevision()), vertexCount(_vertexCount) {
+	const uint32_t numCorners = indices.getIndexCount();
+	std::unique_ptr<std::atomic<uint32_t>[]> counters(new std::atomic<uint32_t>[vertexCount]);
+	parallelFor(vertexCount, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t v = begin; v < end; ++v)
+			counters[v].store(0, std::memory_order_relaxed);
+	});
+	std::atomic<bool> invalidIndex(false);
+	parallelFor(numCorners, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t c = begin; c < end; ++c) {
+			const uint32_t v = indices[c];
+			if(v < vertexCount)
+				counters[v].fetch_add(1, std::memory_order_relaxed);
+			else
+				invalidIndex.store(true, std::memory_order_relaxed);
+		}
+	});
+	if(invalidIndex)
+		throw std::invalid_argument("ConnectivityAccessor: The mesh contains an index that exceeds the vertex count.");
+
+	vertexCornerOffsets.resize(vertexCount + 1);
+	vertexCornerOffsets[0] = 0;
+	for(uint32_t v = 0; v < vertexCount; ++v) {
+		vertexCornerOffsets[v + 1] = vertexCornerOffsets[v] + counters[v].load(std::memory_order_relaxed);
+		counters[v].store(vertexCornerOffsets[v], std::memory_order_relaxed);
+	}
+
+	vertexCornerList.resize(numCorners);
+	parallelFor(numCorners, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t c = begin; c < end; ++c)
+			vertexCornerList[counters[indices[c]].fetch_add(1, std::memory_order_relaxed)] = c;
+	});
+
+	nextVertexCorners.resize(numCorners);
+	parallelFor(vertexCount, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t v = begin; v < end; ++v) {
+			const auto first = vertexCornerList.begin() + vertexCornerOffsets[v];
+			const auto last = vertexCornerList.begin() + vertexCornerOffsets[v + 1];
+			std::sort(first, last);
+			for(auto it = first; it != last; ++it)
+				nextVertexCorners[*it] = (it + 1 == last) ? *first : *(it + 1);
+		}
+	}, 4096);
+}
+}
+
 ConnectivityAccessor::ConnectivityAccessor(Mesh* mesh) : indices(mesh->openIndexData()),
 		posAcc(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION)),
 		triAcc(TriangleAccessor::create(mesh)), meshDataHolder(new LocalMeshDataHolder(mesh)) {
-	vertexCorners.resize(mesh->getVertexCount(), INVALID);
-	triangleNextCorners.resize(indices.getIndexCount(), INVALID);
-
-
-	// TODO: do this lazy, on demand, and only partially.
-	for(uint32_t i=0; i<indices.getIndexCount(); ++i) {
-		uint32_t c = vertexCorners[indices[i]];
-		if(c == INVALID) {
-			vertexCorners[indices[i]] = i;
-			triangleNextCorners[i] = i;
-		} else {
-			uint32_t j = c;
-			uint32_t nvc = triangleNextCorners[j];
-			while(nvc != INVALID && nvc != c) {
-				j = nvc;
-				nvc = triangleNextCorners[j];
-			}
-			triangleNextCorners[j] = i;
-			triangleNextCorners[i] = c;
-		}
+	Util::Reference<MeshConnectivity> data = dynamic_cast<MeshConnectivity *>(mesh->_getConnectivity());
+	if(data.isNull() || !data->isValidFor(mesh)) {
+		data = new MeshConnectivity(indices, mesh->getVertexCount());
+		mesh->_setConnectivity(data.get());
 	}
+	connectivity = data.get();
+	vertexCount = data->vertexCount;
+	vertexCornerOffsets = data->vertexCornerOffsets.data();
+	vertexCornerList = data->vertexCornerList.data();
+	nextVertexCorners = data->nextVertexCorners.data();
 }
 
+ConnectivityAccessor::~ConnectivityAccessor() = default;
+
 //! (static)
 Util::Reference<ConnectivityAccessor> ConnectivityAccessor::create(Mesh* mesh) {
 	if(mesh->isUsingIndexData() && mesh->getDrawMode() == Mesh::DRAW_TRIANGLES) {
@@ -91,17 +150,17 @@ TriangleAccessor::TriangleIndices_t ConnectivityAccessor::getTriangle(uint32_t t
 }
 
 uint32_t ConnectivityAccessor::getCorner(uint32_t vIndex, uint32_t tIndex) const {
-	assertVertexRange(vIndex);
 	assertTriangleRange(tIndex);
-	uint32_t c = vertexCorners[vIndex];
-	while(c != INVALID && c/3 != tIndex)
-		c = triangleNextCorners[c];
-	return c;
+	for(const auto c : getVertexCorners(vIndex)) {
+		if(c/3 == tIndex)
+			return c;
+	}
+	return INVALID;
 }
 
 uint32_t ConnectivityAccessor::getVertexCorner(uint32_t vIndex) const {
-	assertVertexRange(vIndex);
-	return vertexCorners[vIndex];
+	const CornerRange corners = getVertexCorners(vIndex);
+	return corners.empty() ? INVALID : *corners.begin();
 }
 
 uint32_t ConnectivityAccessor::getTriangleCorner(uint32_t tIndex) const {
@@ -121,81 +180,49 @@ uint32_t ConnectivityAccessor::getCornerTriangle(uint32_t cIndex) const {
 
 uint32_t ConnectivityAccessor::getNextVertexCorner(uint32_t cIndex) const {
 	assertCornerRange(cIndex);
-	return triangleNextCorners[cIndex];
+	return nextVertexCorners[cIndex];
 }
 
 uint32_t ConnectivityAccessor::getNextTriangleCorner(uint32_t cIndex) const {
 	assertCornerRange(cIndex);
-	uint32_t tIndex = (cIndex/3);
-	return tIndex*3+((cIndex+1)%3);
+	return nextTriangleCorner(cIndex);
 }
 
 std::vector<uint32_t> ConnectivityAccessor::getVertexAdjacentTriangles(uint32_t vIndex) const {
 	std::vector<uint32_t> out;
-	uint32_t c = getVertexCorner(vIndex);
-	out.push_back(getCornerTriangle(c));
-	uint32_t nc = getNextVertexCorner(c);
-	while(nc != c && nc != INVALID) {
-		out.push_back(getCornerTriangle(nc));
-		nc = getNextVertexCorner(nc);
-	}
+	out.reserve(getVertexCorners(vIndex).size());
+	forEachVertexAdjacentTriangle(vIndex, [&out](uint32_t t) { out.push_back(t); });
 	return out;
 }
 
 std::vector<uint32_t> ConnectivityAccessor::getVertexAdjacentVertices(uint32_t vIndex) const {
-	std::set<uint32_t> out;
-	uint32_t c = getVertexCorner(vIndex);
-	out.insert(getCornerVertex(getNextTriangleCorner(c)));
-	out.insert(getCornerVertex(getNextTriangleCorner(getNextTriangleCorner(c))));
-	uint32_t nc = getNextVertexCorner(c);
-	while(nc != c && nc != INVALID) {
-		out.insert(getCornerVertex(getNextTriangleCorner(nc)));
-		out.insert(getCornerVertex(getNextTriangleCorner(getNextTriangleCorner(nc))));
-		nc = getNextVertexCorner(nc);
-	}
-	return std::vector<uint32_t>(out.begin(), out.end());
+	std::vector<uint32_t> out;
+	forEachVertexAdjacentVertex(vIndex, [&out](uint32_t v) { out.push_back(v); });
+	std::sort(out.begin(), out.end());
+	return out;
 }
 
 std::vector<uint32_t> ConnectivityAccessor::getAdjacentTriangles(uint32_t tIndex) const {
-	auto triangle = getTriangle(tIndex);
 	std::vector<uint32_t> out;
-	auto e1 = std::make_pair(std::get<0>(triangle), std::get<1>(triangle)); // edge a-b
-	auto e2 = std::make_pair(std::get<1>(triangle), std::get<2>(triangle)); // edge b-c
-	auto e3 = std::make_pair(std::get<2>(triangle), std::get<0>(triangle)); // edge c-a
-	for(auto e : {e1,e2,e3}) {
-		for(auto t : getVertexAdjacentTriangles(e.first)) {
-			uint32_t c = getTriangleCorner(t);
-			while(getCornerVertex(c) != e.first)
-				c = getNextTriangleCorner(c);
-			uint32_t pc = getNextTriangleCorner(getNextTriangleCorner(c)); // previous corner = 2 * next corner
-			if(e.second == getCornerVertex(pc))
-				out.push_back(t);
-		}
-	}
+	forEachAdjacentTriangle(tIndex, [&out](uint32_t t) { out.push_back(t); });
 	return out;
 }
 
 bool ConnectivityAccessor::isBorderEdge(uint32_t vIndex1, uint32_t vIndex2) const {
-	// find an edge with vertex1 and vertex2
-	uint32_t c = getVertexCorner(vIndex1);
-	uint32_t ntc = getNextTriangleCorner(c);
-	uint32_t nvc = getNextVertexCorner(c);
-	while(getCornerVertex(ntc) != vIndex2 && nvc != c) {
-		ntc = getNextTriangleCorner(nvc);
-		nvc = getNextVertexCorner(nvc);
-	}
-	if(getCornerVertex(ntc) != vIndex2 )
+	assertVertexRange(vIndex2);
+	const CornerRange corners = getVertexCorners(vIndex1);
+	// find an edge from vertex1 to vertex2
+	bool isEdge = false;
+	for(const auto c : corners)
+		isEdge = isEdge || indices[nextTriangleCorner(c)] == vIndex2;
+	if(!isEdge)
 		return false; // not an edge
-
-	ntc = getNextTriangleCorner(getNextTriangleCorner(c));
-	nvc = getNextVertexCorner(c);
-	while(nvc != c) {
-		if(getCornerVertex(ntc) == vIndex2)
-			return false; // opposing edge found
-		ntc = getNextTriangleCorner(getNextTriangleCorner(nvc));
-		nvc = getNextVertexCorner(nvc);
+	// find the opposing edge from vertex2 to vertex1
+	for(const auto c : corners) {
+		if(indices[previousTriangleCorner(c)] == vIndex2)
+			return false;
 	}
-	return getCornerVertex(ntc) != vIndex2;
+	return true;
 }
 
 bool ConnectivityAccessor::isBorderTriangle(uint32_t tIndex) const {
@@ -12,6 +12,7 @@
 
 #include "LocalMeshDataHolder.h"
 #include "TriangleAccessor.h"
+#include "../Mesh/MeshIndexData.h"
 
 #include <Util/References.h>
 #include <Util/ReferenceCounter.h>
@@ -29,8 +30,8 @@ typedef Triangle<Vec3> Triangle3;
 
 namespace Rendering {
 class Mesh;
+class MeshDerivedData;
 class MeshVertexData;
-class MeshIndexData;
 class PositionAttributeAccessor;
 namespace MeshUtils {
 
@@ -59,15 +60,43 @@ namespace MeshUtils {
  * c1 - corner of t0 and next triangle corner of c0 (see getNextTriangleCorner)
  * c2 - corner of v1 and next vertex corner of c0 (see getNextVertexCorner)
  * @endverbatim
+ *
+ * The corners of every vertex are stored in a compressed sparse row layout that is built in parallel by a
+ * counting sort over the indices. The connectivity is cached by the mesh and shared by all accessors created
+ * for it until its index data changes (see MeshIndexData::getRevision()), so consecutive operations on the
+ * same mesh build it only once. The adjacency can be iterated without allocations:
+ * \code
+ * acc->forEachAdjacentTriangle(t, [&](uint32_t neighbor) { ... });
+ * for(uint32_t corner : acc->getVertexCorners(v)) { ... }
+ * \endcode
  */
 class ConnectivityAccessor : public Util::ReferenceCounter<ConnectivityAccessor> {
+public:
+	//! Range of corner indices (see getVertexCorners()).
+	struct CornerRange {
+		const uint32_t * first;
+		const uint32_t * last;
+		const uint32_t * begin() const		{	return first;	}
+		const uint32_t * end() const		{	return last;	}
+		uint32_t size() const				{	return static_cast<uint32_t>(last - first);	}
+		bool empty() const					{	return first == last;	}
+	};
 private:
-	MeshIndexData& indices;
+	const MeshIndexData& indices;
 	Util::Reference<PositionAttributeAccessor> posAcc;
 	Util::Reference<TriangleAccessor> triAcc;
 	std::unique_ptr<LocalMeshDataHolder> meshDataHolder;
-	std::vector<uint32_t> vertexCorners;
-	std::vector<uint32_t> triangleNextCorners;
+	//! Shared connectivity data cached by the mesh; the pointers below point into it.
+	Util::Reference<MeshDerivedData> connectivity;
+	uint32_t vertexCount;
+	//! The corners of vertex v are vertexCornerList[vertexCornerOffsets[v]] ... vertexCornerList[vertexCornerOffsets[v+1]-1] (ascending).
+	const uint32_t * vertexCornerOffsets;
+	const uint32_t * vertexCornerList;
+	//! The next corner of the same vertex for every corner (the corners of a vertex form a cycle).
+	const uint32_t * nextVertexCorners;
+
+	static uint32_t previousTriangleCorner(uint32_t cIndex)	{	return cIndex - cIndex%3 + (cIndex+2)%3;	}
+	static uint32_t nextTriangleCorner(uint32_t cIndex)		{	return cIndex - cIndex%3 + (cIndex+1)%3;	}
 protected:
 	void assertCornerRange(uint32_t cIndex) const;
 	void assertVertexRange(uint32_t vIndex) const;
@@ -79,7 +108,7 @@ public:
 		If no Accessor can be created, an std::invalid_argument exception is thrown. */
 	static Util::Reference<ConnectivityAccessor> create(Mesh* mesh);
 
-	virtual ~ConnectivityAccessor() {}
+	virtual ~ConnectivityAccessor();
 
 	/**
 	 * Return the coordinates of a vertex.
@@ -145,6 +174,63 @@ public:
 	 */
 	uint32_t getNextTriangleCorner(uint32_t cIndex) const;
 
+	/**
+	 * Return the corners incident to a vertex in ascending order (without allocating memory).
+	 * @param vIndex the vertex index
+	 * @return range of corner indices; empty if the vertex is not referenced by any triangle
+	 */
+	CornerRange getVertexCorners(uint32_t vIndex) const {
+		assertVertexRange(vIndex);
+		return {vertexCornerList + vertexCornerOffsets[vIndex], vertexCornerList + vertexCornerOffsets[vIndex + 1]};
+	}
+
+	/**
+	 * Call @p fun(tIndex) for every triangle that is adjacent to a vertex (once per corner of the vertex).
+	 * Allocation-free variant of getVertexAdjacentTriangles().
+	 */
+	template<typename Function>
+	void forEachVertexAdjacentTriangle(uint32_t vIndex, Function fun) const {
+		for(const auto c : getVertexCorners(vIndex))
+			fun(c/3);
+	}
+
+	/**
+	 * Call @p fun(vIndex) once for every vertex that is adjacent to a vertex (in unspecified order).
+	 * Allocation-free variant of getVertexAdjacentVertices().
+	 */
+	template<typename Function>
+	void forEachVertexAdjacentVertex(uint32_t vIndex, Function fun) const {
+		const CornerRange corners = getVertexCorners(vIndex);
+		for(const uint32_t * it = corners.begin(); it != corners.end(); ++it) {
+			const uint32_t candidates[2] = {indices[nextTriangleCorner(*it)], indices[previousTriangleCorner(*it)]};
+			for(uint_fast8_t k = 0; k < 2; ++k) {
+				const uint32_t v = candidates[k];
+				bool visited = k == 1 && candidates[0] == v;
+				for(const uint32_t * prev = corners.begin(); prev != it && !visited; ++prev)
+					visited = indices[nextTriangleCorner(*prev)] == v || indices[previousTriangleCorner(*prev)] == v;
+				if(!visited)
+					fun(v);
+			}
+		}
+	}
+
+	/**
+	 * Call @p fun(tIndex) for every triangle that shares an edge with a triangle (in opposite direction).
+	 * Allocation-free variant of getAdjacentTriangles().
+	 */
+	template<typename Function>
+	void forEachAdjacentTriangle(uint32_t tIndex, Function fun) const {
+		assertTriangleRange(tIndex);
+		for(uint32_t k = 0; k < 3; ++k) {
+			const uint32_t from = indices[tIndex*3 + k];
+			const uint32_t to = indices[tIndex*3 + (k+1)%3];
+			for(const auto c : getVertexCorners(from)) {
+				if(indices[previousTriangleCorner(c)] == to)
+					fun(c/3);
+			}
+		}
+	}
+
 	/**
 	 * Return the triangles that are adjacent to a vertex.
 	 * @param vIndex the vertex index
@@ -9,13 +9,19 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "MarchingCubesMeshBuilder.h"
-#include "MeshBuilder.h"
+#include "internal/ParallelFor.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
 #include "../Mesh/VertexDescription.h"
+#include "../Texture/BrickedVolume.h"
 #include <Geometry/Vec4.h>
 #include <Util/Graphics/Color.h>
 #include <Util/Graphics/PixelAccessor.h>
 #include <Util/Macros.h>
+#include <algorithm>
 #include <cmath>
+#include <iostream>
 #include <vector>
 
 namespace Rendering {
@@ -343,131 +349,272 @@ static Geometry::Vec4 interpolateVertices(float isolevel, const Geometry::Vec4 &
 //	std::vector<float> occlusion;
 //};
 //	
-//! (static)
-Mesh * MarchingCubesMeshBuilder::createMesh(DataSet & data) {
+static const uint32_t INVALID_VERTEX = 0xffffffff;
+//! Edge length of the cubic bricks used to skip empty regions (in cubes).
+static const uint32_t BRICK_SIZE = 8;
 
-	if(data.density.size() < data.resolutionX * data.resolutionY * data.resolutionZ )
-		INVALID_ARGUMENT_EXCEPTION("createMesh: Given data has invalid size.");
+/*! Offset of the start point and direction (0=x, 1=y, 2=z) of each of the twelve cube edges.
+	The edges are numbered as in edgeTable and triTable, the start point is always the corner with the smaller coordinate. */
+static const uint8_t edgeInfo[12][4] = {
+	{0, 0, 0, 0}, {1, 0, 0, 2}, {0, 0, 1, 0}, {0, 0, 0, 2},
+	{0, 1, 0, 0}, {1, 1, 0, 2}, {0, 1, 1, 0}, {0, 1, 0, 2},
+	{0, 0, 0, 1}, {1, 0, 0, 1}, {1, 0, 1, 1}, {0, 0, 1, 1}
+};
+
+namespace {
+//! Vertices and triangles created for a range of cube layers by a single thread.
+struct SlabOutput {
+	std::vector<float> vertices; //! x, y, z, occlusion for each vertex.
+	std::vector<uint32_t> indices; //! Slab local indices.
+	/*! Vertex indices of the x and y edges in the first and the last point plane of the slab.
+		These vertices are shared with the neighbouring slabs. */
+	std::vector<uint32_t> bottomEdges;
+	std::vector<uint32_t> topEdges;
+};
 
-//	if(data.occlusion.empty())
-//		data.occlusion = data.density;
+//! Minimal and maximal density inside of each brick.
+struct BrickGrid {
+	uint32_t numX, numY, numZ;
+	std::vector<uint8_t> active; //! 1 iff the brick may contain a part of the surface.
 
-	VertexDescription vertexDescription;
-	vertexDescription.appendPosition3D();
-//	vertexDescription.appendNormalFloat();
-	vertexDescription.appendColorRGBAFloat();
-//	vertexDescription.appendTexCoord();
-	MeshBuilder mb(vertexDescription);
+	bool isActive(uint32_t cx, uint32_t cy, uint32_t cz) const {
+		return active[((cz / BRICK_SIZE) * numY + cy / BRICK_SIZE) * numX + cx / BRICK_SIZE] != 0;
+	}
+};
+}
+
+/*! (internal) Mark the bricks that may be intersected by the surface. Cube coordinates are relative to the range minimum.
+	A cube contains a part of the surface iff at least one of its corners is above and one is not above the isolevel. */
+static BrickGrid createBrickGrid(const MarchingCubesMeshBuilder::DataSet & data, uint32_t cubesX, uint32_t cubesY, uint32_t cubesZ) {
+	BrickGrid bricks;
+	bricks.numX = (cubesX + BRICK_SIZE - 1) / BRICK_SIZE;
+	bricks.numY = (cubesY + BRICK_SIZE - 1) / BRICK_SIZE;
+	bricks.numZ = (cubesZ + BRICK_SIZE - 1) / BRICK_SIZE;
+	bricks.active.resize(bricks.numX * bricks.numY * bricks.numZ);
+	const float isolevel = data.isolevel;
+	const BrickedVolume * volume = data.bricks;
+	if(volume != nullptr && (!volume->hasBrickRanges() || volume->getSizeX() != data.resolutionX ||
+			volume->getSizeY() != data.resolutionY || volume->getSizeZ() != data.resolutionZ))
+		volume = nullptr;
+	parallelFor(bricks.numZ, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t bz = begin; bz < end; ++bz) {
+			for(uint32_t by = 0; by < bricks.numY; ++by) {
+				for(uint32_t bx = 0; bx < bricks.numX; ++bx) {
+					// a brick of n cubes covers n+1 points in each direction
+					const uint32_t x0 = data.rangeMinX + bx * BRICK_SIZE, x1 = std::min(x0 + BRICK_SIZE, data.rangeMinX + cubesX);
+					const uint32_t y0 = data.rangeMinY + by * BRICK_SIZE, y1 = std::min(y0 + BRICK_SIZE, data.rangeMinY + cubesY);
+					const uint32_t z0 = data.rangeMinZ + bz * BRICK_SIZE, z1 = std::min(z0 + BRICK_SIZE, data.rangeMinZ + cubesZ);
+					if(volume != nullptr) {
+						// point p lies in the volume brick min(p / stride, numBricks - 1)
+						const uint32_t stride = volume->getBrickSize() - 1;
+						float minValue = isolevel, maxValue = isolevel;
+						bool first = true;
+						for(uint32_t vz = std::min(z0 / stride, volume->getNumBricksZ() - 1); vz <= std::min(z1 / stride, volume->getNumBricksZ() - 1); ++vz) {
+							for(uint32_t vy = std::min(y0 / stride, volume->getNumBricksY() - 1); vy <= std::min(y1 / stride, volume->getNumBricksY() - 1); ++vy) {
+								for(uint32_t vx = std::min(x0 / stride, volume->getNumBricksX() - 1); vx <= std::min(x1 / stride, volume->getNumBricksX() - 1); ++vx) {
+									const auto & range = volume->getBrickRanges()[volume->getBrickIndex(vx, vy, vz)];
+									minValue = first ? range.minValue : std::min(minValue, range.minValue);
+									maxValue = first ? range.maxValue : std::max(maxValue, range.maxValue);
+									first = false;
+								}
+							}
+						}
+						bricks.active[(bz * bricks.numY + by) * bricks.numX + bx] = (maxValue > isolevel && minValue <= isolevel) ? 1 : 0;
+						continue;
+					}
+					bool above = false;
+					bool notAbove = false;
+					for(uint32_t z = z0; z <= z1 && !(above && notAbove); ++z) {
+						for(uint32_t y = y0; y <= y1; ++y) {
+							const float * ptr = data.density.data() + z * data.layerXYSize + y * data.resolutionX;
+							for(uint32_t x = x0; x <= x1; ++x) {
+								if(ptr[x] > isolevel)
+									above = true;
+								else
+									notAbove = true;
+							}
+						}
+					}
+					bricks.active[(bz * bricks.numY + by) * bricks.numX + bx] = (above && notAbove) ? 1 : 0;
+				}
+			}
+		}
+	}, 1);
+	return bricks;
+}
 
+/*! (internal) Polygonise the cube layers [zBegin, zEnd).
+	Each vertex is created once per slab: the vertex indices of the edges of the current cube layer are cached in two
+	planes of x/y edges (bottom and top of the layer) and one plane of z edges. */
+static void polygoniseSlab(const MarchingCubesMeshBuilder::DataSet & data, const BrickGrid & bricks,
+						uint32_t zBegin, uint32_t zEnd, SlabOutput & out) {
 	const float isolevel = data.isolevel;
-//	const uint32_t layerXYSize = data.layerXYSize;
-//	const uint8_t * ptr=data.data();
-//	const float uScale = 1.0f / sizeX;
-//	const float vScale = 1.0f / sizeY;
+	const uint32_t resX = data.resolutionX;
+	const uint32_t layerSize = data.layerXYSize;
+	const float * density = data.density.data();
+	const float * occlusion = data.occlusion.data();
 
-	Geometry::Vec4 vertexList[12];
+	std::vector<uint32_t> planeEdges[2] = {
+		std::vector<uint32_t>(2 * layerSize, INVALID_VERTEX),
+		std::vector<uint32_t>(2 * layerSize, INVALID_VERTEX)
+	};
+	std::vector<uint32_t> zEdges(layerSize, INVALID_VERTEX);
 
-	for(uint32_t z = data.rangeMinZ; z < data.rangeMaxZ - 1; ++z) {
+	for(uint32_t z = zBegin; z < zEnd; ++z) {
+		if(z != zBegin) {
+			std::swap(planeEdges[0], planeEdges[1]);
+			std::fill(planeEdges[1].begin(), planeEdges[1].end(), INVALID_VERTEX);
+			std::fill(zEdges.begin(), zEdges.end(), INVALID_VERTEX);
+		}
 		for(uint32_t y = data.rangeMinY; y < data.rangeMaxY - 1; ++y) {
 			for(uint32_t x = data.rangeMinX; x < data.rangeMaxX - 1; ++x) {
-				const float * ptr = data.density.data() + z * data.layerXYSize + y * data.resolutionX + x;
-
-				const float density_xyz = *ptr ;
-				const float density_Xyz = *(ptr + 1) ;
-				const float density_XyZ = *(ptr + 1 + data.layerXYSize) ;
-				const float density_xyZ = *(ptr + data.layerXYSize) ;
-				const float density_xYz = *(ptr + data.resolutionX) ;
-				const float density_XYz = *(ptr + data.resolutionX + 1) ;
-				const float density_XYZ = *(ptr + data.resolutionX + 1 + data.layerXYSize) ;
-				const float density_xYZ = *(ptr + data.resolutionX + data.layerXYSize) ;
+				if(!bricks.isActive(x - data.rangeMinX, y - data.rangeMinY, z - data.rangeMinZ)) {
+					x = std::min(data.rangeMaxX - 1, data.rangeMinX + ((x - data.rangeMinX) / BRICK_SIZE + 1) * BRICK_SIZE) - 1;
+					continue;
+				}
+				const float * ptr = density + z * layerSize + y * resX + x;
 
 				uint8_t cubeindex = 0;
-				if( density_xyz > isolevel)				cubeindex |= 1;
-				if( density_Xyz > isolevel)				cubeindex |= 2;
-				if( density_XyZ > isolevel)				cubeindex |= 4;
-				if( density_xyZ > isolevel)				cubeindex |= 8;
-				if( density_xYz > isolevel)				cubeindex |= 16;
-				if( density_XYz > isolevel)				cubeindex |= 32;
-				if( density_XYZ > isolevel)				cubeindex |= 64;
-				if( density_xYZ > isolevel)				cubeindex |= 128;
+				if( *ptr > isolevel)									cubeindex |= 1;
+				if( *(ptr + 1) > isolevel)								cubeindex |= 2;
+				if( *(ptr + 1 + layerSize) > isolevel)					cubeindex |= 4;
+				if( *(ptr + layerSize) > isolevel)						cubeindex |= 8;
+				if( *(ptr + resX) > isolevel)							cubeindex |= 16;
+				if( *(ptr + resX + 1) > isolevel)						cubeindex |= 32;
+				if( *(ptr + resX + 1 + layerSize) > isolevel)			cubeindex |= 64;
+				if( *(ptr + resX + layerSize) > isolevel)				cubeindex |= 128;
 
 				/* Cube is entirely in/out of the surface */
 				if(edgeTable[cubeindex] == 0)
 					continue;
 
-
-				// get occlusion values
-				const float * oPtr = data.occlusion.data() + z * data.layerXYSize + y * data.resolutionX + x;
-				const float o_xyz = *oPtr ;
-				const float o_Xyz = *(oPtr + 1) ;
-				const float o_XyZ = *(oPtr + 1 + data.layerXYSize) ;
-				const float o_xyZ = *(oPtr + data.layerXYSize) ;
-				const float o_xYz = *(oPtr + data.resolutionX) ;
-				const float o_XYz = *(oPtr + data.resolutionX + 1) ;
-				const float o_XYZ = *(oPtr + data.resolutionX + 1 + data.layerXYSize) ;
-				const float o_xYZ = *(oPtr + data.resolutionX + data.layerXYSize) ;
-
-				/* Find the vertices where the surface intersects the cube */
-				if(edgeTable[cubeindex] & 1)
-					vertexList[0] = interpolateVertices(isolevel,
-								Geometry::Vec4(x, y, z, o_xyz),			Geometry::Vec4(x+1, y, z, o_Xyz),		density_xyz, density_Xyz);
-				if(edgeTable[cubeindex] & 2)
-					vertexList[1] = interpolateVertices(isolevel,
-								Geometry::Vec4(x+1, y, z, o_Xyz),		Geometry::Vec4(x+1, y, z+1, o_XyZ),		density_Xyz, density_XyZ);
-				if(edgeTable[cubeindex] & 4)
-					vertexList[2] = interpolateVertices(isolevel,
-								Geometry::Vec4(x+1, y, z+1, o_XyZ),		Geometry::Vec4(x, y, z+1, o_xyZ),		density_XyZ, density_xyZ);
-				if(edgeTable[cubeindex] & 8)
-					vertexList[3] = interpolateVertices(isolevel,
-								Geometry::Vec4(x, y, z+1, o_xyZ),		Geometry::Vec4(x, y, z, o_xyz),			density_xyZ, density_xyz);
-				if(edgeTable[cubeindex] & 16)
-					vertexList[4] = interpolateVertices(isolevel,
-								Geometry::Vec4(x, y+1 , z, o_xYz),		Geometry::Vec4(x+1 , y+1 , z, o_XYz),	density_xYz, density_XYz);
-				if(edgeTable[cubeindex] & 32)
-					vertexList[5] = interpolateVertices(isolevel,
-								Geometry::Vec4(x+1 , y+1 , z, o_XYz),	Geometry::Vec4(x+1 , y+1 , z+1, o_XYZ),	density_XYz, density_XYZ);
-				if(edgeTable[cubeindex] & 64)
-					vertexList[6] = interpolateVertices(isolevel,
-								Geometry::Vec4(x+1 , y+1 , z+1, o_XYZ),	Geometry::Vec4(x, y+1 , z+1, o_xYZ),	density_XYZ, density_xYZ);
-				if(edgeTable[cubeindex] & 128)
-					vertexList[7] = interpolateVertices(isolevel,
-								Geometry::Vec4(x, y+1 , z+1, o_xYZ),	Geometry::Vec4(x, y+1 , z, o_xYz),		density_xYZ, density_xYz);
-				if(edgeTable[cubeindex] & 256)
-					vertexList[8] = interpolateVertices(isolevel,
-								Geometry::Vec4(x, y, z, o_xyz),			Geometry::Vec4(x, y+1 , z, o_xYz),		density_xyz, density_xYz);
-				if(edgeTable[cubeindex] & 512)
-					vertexList[9] = interpolateVertices(isolevel,
-								Geometry::Vec4(x+1, y, z, o_Xyz),		Geometry::Vec4(x+1 , y+1 , z, o_XYz),	density_Xyz, density_XYz);
-				if(edgeTable[cubeindex] & 1024)
-					vertexList[10] = interpolateVertices(isolevel,
-								Geometry::Vec4(x+1, y, z+1, o_XyZ),		Geometry::Vec4(x+1 , y+1 , z+1, o_XYZ),	density_XyZ, density_XYZ);
-				if(edgeTable[cubeindex] & 2048)
-					vertexList[11] = interpolateVertices(isolevel,
-								Geometry::Vec4(x, y, z+1, o_xyZ),		Geometry::Vec4(x, y+1 , z+1, o_xYZ),	density_xyZ, density_xYZ);
+				uint32_t vertexList[12];
+				for(uint_fast8_t e = 0; e < 12; ++e) {
+					if((edgeTable[cubeindex] & (1 << e)) == 0)
+						continue;
+					const uint32_t px = x + edgeInfo[e][0];
+					const uint32_t py = y + edgeInfo[e][1];
+					const uint8_t dz = edgeInfo[e][2];
+					const uint8_t axis = edgeInfo[e][3];
+					const uint32_t cell = py * resX + px;
+					uint32_t & cached = (axis == 2) ? zEdges[cell] : planeEdges[dz][2 * cell + axis];
+					if(cached == INVALID_VERTEX) {
+						const uint32_t pz = z + dz;
+						const uint32_t index1 = pz * layerSize + cell;
+						const uint32_t index2 = index1 + (axis == 0 ? 1 : (axis == 1 ? resX : layerSize));
+						const Geometry::Vec4 v = interpolateVertices(isolevel,
+								Geometry::Vec4(px, py, pz, occlusion[index1]),
+								Geometry::Vec4(px + (axis == 0 ? 1 : 0), py + (axis == 1 ? 1 : 0), pz + (axis == 2 ? 1 : 0), occlusion[index2]),
+								density[index1], density[index2]);
+						cached = static_cast<uint32_t>(out.vertices.size() / 4);
+						out.vertices.insert(out.vertices.end(), {v.x(), v.y(), v.z(), v.w()});
+					}
+					vertexList[e] = cached;
+				}
 
 				for (uint8_t i = 0; triTable[cubeindex][i] != -1; i += 3) {
+					for(int8_t j = 2; j >= 0; --j)
+						out.indices.push_back(vertexList[triTable[cubeindex][i+j]]);
+				}
+			}
+		}
+		if(z == zBegin)
+			out.bottomEdges = planeEdges[0];
+	}
+	out.topEdges.swap(planeEdges[1]);
+}
+
+//! (static)
+Mesh * MarchingCubesMeshBuilder::createMesh(DataSet & data) {
 
-//					mb.texCoord0(Geometry::Vec2( x*uScale,y*vScale) );
+	if(data.density.size() < data.resolutionX * data.resolutionY * data.resolutionZ )
+		INVALID_ARGUMENT_EXCEPTION("createMesh: Given data has invalid size.");
+	if(data.occlusion.size() < data.density.size())
+		INVALID_ARGUMENT_EXCEPTION("createMesh: Given occlusion data has invalid size.");
+	if(data.rangeMaxX > data.resolutionX || data.rangeMaxY > data.resolutionY || data.rangeMaxZ > data.resolutionZ)
+		INVALID_ARGUMENT_EXCEPTION("createMesh: Given range exceeds the data's resolution.");
 
-					for(int8_t j = 2; j >= 0; --j) {
-						const Geometry::Vec4 & v = vertexList[triTable[cubeindex][i+j]];
-						mb.color(Util::Color4f(v.w(),v.w(),v.w(),1.0));
+	if(data.rangeMaxX < data.rangeMinX + 2 || data.rangeMaxY < data.rangeMinY + 2 || data.rangeMaxZ < data.rangeMinZ + 2) {
+		std::cerr << "Empty Mesh..? (MarchingCubesMeshBuilder::createMesh)\n";
+		return nullptr;
+	}
+	const uint32_t cubesX = data.rangeMaxX - data.rangeMinX - 1;
+	const uint32_t cubesY = data.rangeMaxY - data.rangeMinY - 1;
+	const uint32_t cubesZ = data.rangeMaxZ - data.rangeMinZ - 1;
 
-						mb.position( v.xyz() );
-						mb.addIndex(mb.addVertex());
+	const BrickGrid bricks = createBrickGrid(data, cubesX, cubesY, cubesZ);
 
-					}
+	// Split the cube layers into slabs that are processed concurrently.
+	static const uint32_t minCubesPerSlab = 64 * 64 * 64;
+	const uint32_t numThreads = TaskScheduler::get().getConcurrency();
+	const uint32_t numSlabs = std::max(1u, std::min(std::min(numThreads, cubesZ),
+										static_cast<uint32_t>(static_cast<uint64_t>(cubesX) * cubesY * cubesZ / minCubesPerSlab)));
+	const uint32_t slabSize = (cubesZ + numSlabs - 1) / numSlabs;
+	std::vector<SlabOutput> slabs(numSlabs);
+	parallelFor(numSlabs, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t s = begin; s < end; ++s) {
+			const uint32_t zBegin = data.rangeMinZ + std::min(cubesZ, s * slabSize);
+			const uint32_t zEnd = data.rangeMinZ + std::min(cubesZ, (s + 1) * slabSize);
+			if(zBegin < zEnd)
+				polygoniseSlab(data, bricks, zBegin, zEnd, slabs[s]);
+		}
+	}, 1);
 
-				}
-//					mb.texCoord0(Geometry::Vec2( x*uScale,y*vScale) );
-//					mb.position(Geometry::Vec3(static_cast<float>(x),static_cast<float>(y),static_cast<float>(z)));
-//					mb.addIndex(mb.addVertex());
-//				}
+	// Join the slabs: vertices on the first point plane of a slab already exist in the previous slab.
+	std::vector<std::vector<uint32_t>> localToGlobal(numSlabs);
+	std::vector<uint32_t> indexOffsets(numSlabs + 1, 0);
+	uint32_t vertexCount = 0;
+	for(uint32_t s = 0; s < numSlabs; ++s) {
+		const SlabOutput & slab = slabs[s];
+		std::vector<uint32_t> & mapping = localToGlobal[s];
+		mapping.assign(slab.vertices.size() / 4, INVALID_VERTEX);
+		if(s > 0 && !slab.bottomEdges.empty() && !slabs[s - 1].topEdges.empty()) {
+			const std::vector<uint32_t> & previousTop = slabs[s - 1].topEdges;
+			for(size_t e = 0; e < slab.bottomEdges.size(); ++e) {
+				if(slab.bottomEdges[e] != INVALID_VERTEX && previousTop[e] != INVALID_VERTEX)
+					mapping[slab.bottomEdges[e]] = localToGlobal[s - 1][previousTop[e]];
 			}
 		}
+		for(auto & index : mapping) {
+			if(index == INVALID_VERTEX)
+				index = vertexCount++;
+		}
+		indexOffsets[s + 1] = indexOffsets[s] + static_cast<uint32_t>(slab.indices.size());
+	}
+	const uint32_t indexCount = indexOffsets[numSlabs];
+	if(indexCount == 0) {
+		std::cerr << "Empty Mesh..? (MarchingCubesMeshBuilder::createMesh)\n";
+		return nullptr;
 	}
-	return mb.buildMesh();
 
+	VertexDescription vertexDescription;
+	const uint16_t posOffset = vertexDescription.appendPosition3D().getOffset();
+	const uint16_t colorOffset = vertexDescription.appendColorRGBAFloat().getOffset();
+	auto mesh = new Mesh(vertexDescription, vertexCount, indexCount);
+	MeshVertexData & vertexData = mesh->openVertexData();
+	MeshIndexData & indexData = mesh->openIndexData();
+	parallelFor(numSlabs, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t s = begin; s < end; ++s) {
+			const SlabOutput & slab = slabs[s];
+			const std::vector<uint32_t> & mapping = localToGlobal[s];
+			for(size_t i = 0; i < mapping.size(); ++i) {
+				const float * v = slab.vertices.data() + 4 * i;
+				float * position = reinterpret_cast<float *>(vertexData[mapping[i]] + posOffset);
+				float * color = reinterpret_cast<float *>(vertexData[mapping[i]] + colorOffset);
+				position[0] = v[0];
+				position[1] = v[1];
+				position[2] = v[2];
+				color[0] = color[1] = color[2] = v[3];
+				color[3] = 1.0f;
+			}
+			uint32_t * indices = indexData.data() + indexOffsets[s];
+			for(const auto & index : slab.indices)
+				*(indices++) = mapping[index];
+		}
+	}, 1);
+	vertexData.updateBoundingBox();
+	indexData.updateIndexRange();
+	return mesh;
 }
 
 
@@ -477,21 +624,23 @@ Mesh * MarchingCubesMeshBuilder::createMeshFromTiledImage(const Util::PixelAcces
 	
 	DataSet data(sizeX,sizeY,sizeZ);
 	
-	float * ptr = data.density.data();
-	float * oPtr = data.occlusion.data();
-	for(uint32_t z = 0; z < sizeZ; ++z) {
-		const uint32_t xOffset = (z % numHorizontalTiles) * sizeX;
-		const uint32_t yOffset = static_cast<uint32_t>(z / numHorizontalTiles) * sizeY;
-		for(uint32_t y = 0; y < sizeY; ++y) {
-			for(uint32_t x = 0; x < sizeX; ++x) {
-				Util::Color4f c = accessor.readColor4f(xOffset + x, yOffset + y);
-				*ptr = c.getR();
-				*oPtr = c.getG();
-				++ptr;
-				++oPtr;
+	parallelFor(sizeZ, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t z = begin; z < end; ++z) {
+			float * ptr = data.density.data() + z * data.layerXYSize;
+			float * oPtr = data.occlusion.data() + z * data.layerXYSize;
+			const uint32_t xOffset = (z % numHorizontalTiles) * sizeX;
+			const uint32_t yOffset = static_cast<uint32_t>(z / numHorizontalTiles) * sizeY;
+			for(uint32_t y = 0; y < sizeY; ++y) {
+				for(uint32_t x = 0; x < sizeX; ++x) {
+					Util::Color4f c = accessor.readColor4f(xOffset + x, yOffset + y);
+					*ptr = c.getR();
+					*oPtr = c.getG();
+					++ptr;
+					++oPtr;
+				}
 			}
 		}
-	}
+	}, 8);
 	return createMesh(data);
 }
 
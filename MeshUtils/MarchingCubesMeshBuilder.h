@@ -18,6 +18,7 @@ namespace Util {
 class PixelAccessor;
 }
 namespace Rendering {
+class BrickedVolume;
 class Mesh;
 namespace MeshUtils {
 
@@ -38,16 +39,23 @@ struct DataSet{
 	uint32_t rangeMinX,rangeMaxX,rangeMinY,rangeMaxY,rangeMinZ,rangeMaxZ;
 	std::vector<float> density; //! resolutionX*resolutionY*resolutionZ many values.
 	std::vector<float> occlusion;
+	/*! (optional) Bricked representation of the same density values. If its sizes match and its brick ranges are
+		known, they are used to skip empty regions instead of scanning the density values. */
+	const BrickedVolume * bricks;
 	
 	DataSet(const uint32_t rX,const uint32_t rY,const uint32_t rZ) : 
 		resolutionX(rX),resolutionY(rY),resolutionZ(rZ),layerXYSize(rX*rY),
 		isolevel(0.5),
 		rangeMinX(0),rangeMaxX(rX),rangeMinY(0),rangeMaxY(rY),rangeMinZ(0),rangeMaxZ(rZ),
-		density(rX*rY*rZ),occlusion(rX*rY*rZ)
+		density(rX*rY*rZ),occlusion(rX*rY*rZ),bricks(nullptr)
 		{}
 	
 };
 	
+/*! Create an indexed mesh of the isosurface of the given data set inside of its range.
+	Vertices on cube edges are shared by the adjacent triangles. The data set is processed in slabs of z-layers in parallel,
+	bricks of cubes that do not contain the isolevel are skipped.
+	@return the new mesh or nullptr if the surface is empty. */
 Mesh * createMesh(DataSet & data);
 Mesh * createMeshFromTiledImage(const Util::PixelAccessor & accessor, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ);
 }
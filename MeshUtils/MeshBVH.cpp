@@ -0,0 +1,415 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MeshBVH.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeAccessors.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "TriangleAccessor.h"
+#include <Geometry/Line.h>
+#include <Geometry/LineTriangleIntersection.h>
+#include <Geometry/Plane.h>
+#include <Geometry/Triangle.h>
+#include <Geometry/Vec3.h>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace Rendering {
+namespace MeshUtils {
+
+//! (internal) Triangle data used while building the hierarchy.
+struct MeshBVH::BuildTriangle {
+	float min[3];
+	float max[3];
+	float centroid[3];
+	uint32_t id;
+};
+
+namespace {
+//! (internal) Axis-aligned box used while building the hierarchy.
+struct Bounds {
+	float min[3];
+	float max[3];
+	Bounds() {
+		std::fill(min, min + 3, std::numeric_limits<float>::max());
+		std::fill(max, max + 3, std::numeric_limits<float>::lowest());
+	}
+	void include(const float * bMin, const float * bMax) {
+		for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+			min[dim] = std::min(min[dim], bMin[dim]);
+			max[dim] = std::max(max[dim], bMax[dim]);
+		}
+	}
+	float getHalfSurfaceArea() const {
+		if(min[0] > max[0])
+			return 0.0f;
+		const float dx = max[0] - min[0];
+		const float dy = max[1] - min[1];
+		const float dz = max[2] - min[2];
+		return dx * dy + dy * dz + dz * dx;
+	}
+};
+}
+
+static const uint32_t NUM_BINS = 16;
+
+//! (ctor)
+MeshBVH::MeshBVH() : MeshDerivedData(), vertexRevision(0), indexRevision(0) {
+}
+
+//! (dtor)
+MeshBVH::~MeshBVH() = default;
+
+//! (static)
+MeshBVH * MeshBVH::get(Mesh * mesh) {
+	MeshBVH * bvh = getIfValid(mesh);
+	if(bvh == nullptr && mesh->getDrawMode() == Mesh::DRAW_TRIANGLES) {
+		Util::Reference<MeshBVH> newBVH = create(mesh);
+		mesh->_setSpatialIndex(newBVH.get());
+		bvh = newBVH.get();
+	}
+	return bvh;
+}
+
+//! (static)
+MeshBVH * MeshBVH::getIfValid(const Mesh * mesh) {
+	MeshBVH * bvh = dynamic_cast<MeshBVH *>(mesh->_getSpatialIndex());
+	return (bvh != nullptr && bvh->isValidFor(mesh)) ? bvh : nullptr;
+}
+
+//! (static)
+Util::Reference<MeshBVH> MeshBVH::create(Mesh * mesh, uint32_t maxLeafSize) {
+	Util::Reference<MeshBVH> bvh = new MeshBVH;
+	MeshVertexData & vertexData = mesh->openVertexData();
+	const MeshIndexData & indexData = mesh->openIndexData();
+	bvh->vertexRevision = vertexData.getRevision();
+	bvh->indexRevision = indexData.getRevision();
+	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES)
+		return bvh;
+
+	const uint32_t numTriangles = mesh->getIndexCount() / 3;
+	if(numTriangles == 0)
+		return bvh;
+	auto triAcc = TriangleAccessor::create(mesh);
+	std::vector<BuildTriangle> buildTriangles(numTriangles);
+	std::vector<float> meshPositions(static_cast<std::size_t>(numTriangles) * 9);
+	TriangleAccessor::TriangleBlock block;
+	for(uint32_t first = 0; first < numTriangles; first += block.count) {
+		triAcc->getTriangles(first, block);
+		for(uint32_t i = 0; i < block.count; ++i) {
+			const uint32_t t = first + i;
+			BuildTriangle & triangle = buildTriangles[t];
+			triangle.id = t;
+			const float p[3][3] = {	{block.x[0][i], block.y[0][i], block.z[0][i]},
+									{block.x[1][i], block.y[1][i], block.z[1][i]},
+									{block.x[2][i], block.y[2][i], block.z[2][i]}	};
+			std::copy(&p[0][0], &p[0][0] + 9, meshPositions.begin() + t * 9);
+			for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+				triangle.min[dim] = std::min({p[0][dim], p[1][dim], p[2][dim]});
+				triangle.max[dim] = std::max({p[0][dim], p[1][dim], p[2][dim]});
+				triangle.centroid[dim] = (triangle.min[dim] + triangle.max[dim]) * 0.5f;
+			}
+		}
+	}
+
+	bvh->nodes.reserve(2 * numTriangles / std::max(1u, maxLeafSize) + 1);
+	bvh->build(buildTriangles, 0, numTriangles, std::max(1u, maxLeafSize));
+	bvh->nodes.shrink_to_fit();
+
+	bvh->triangleIds.resize(numTriangles);
+	bvh->positions.resize(meshPositions.size());
+	for(uint32_t i = 0; i < numTriangles; ++i) {
+		const uint32_t id = buildTriangles[i].id;
+		bvh->triangleIds[i] = id;
+		std::copy(meshPositions.begin() + id * 9, meshPositions.begin() + id * 9 + 9, bvh->positions.begin() + i * 9);
+	}
+	return bvh;
+}
+
+//! (internal) Build the subtree for the triangles [begin, end) and return the index of its root node.
+uint32_t MeshBVH::build(std::vector<BuildTriangle> & buildTriangles, uint32_t begin, uint32_t end, uint32_t maxLeafSize) {
+	const uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+	nodes.emplace_back();
+
+	Bounds bounds, centroidBounds;
+	for(uint32_t i = begin; i < end; ++i) {
+		bounds.include(buildTriangles[i].min, buildTriangles[i].max);
+		centroidBounds.include(buildTriangles[i].centroid, buildTriangles[i].centroid);
+	}
+	{
+		Node & node = nodes[nodeIndex];
+		std::copy(bounds.min, bounds.min + 3, node.min);
+		std::copy(bounds.max, bounds.max + 3, node.max);
+	}
+
+	const uint32_t count = end - begin;
+	uint32_t bestAxis = 0;
+	uint32_t bestSplit = 0;
+	float bestCost = std::numeric_limits<float>::max();
+	if(count > maxLeafSize) {
+		// binned surface area heuristic
+		for(uint32_t axis = 0; axis < 3; ++axis) {
+			const float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+			if(extent <= 0.0f)
+				continue;
+			const float scale = NUM_BINS / extent;
+			std::array<Bounds, NUM_BINS> binBounds;
+			std::array<uint32_t, NUM_BINS> binCounts;
+			binCounts.fill(0);
+			for(uint32_t i = begin; i < end; ++i) {
+				const uint32_t bin = std::min(NUM_BINS - 1, static_cast<uint32_t>((buildTriangles[i].centroid[axis] - centroidBounds.min[axis]) * scale));
+				++binCounts[bin];
+				binBounds[bin].include(buildTriangles[i].min, buildTriangles[i].max);
+			}
+			// sweep from the right to get the cost of all right sides
+			std::array<float, NUM_BINS> rightCosts;
+			Bounds right;
+			uint32_t rightCount = 0;
+			for(uint32_t bin = NUM_BINS - 1; bin > 0; --bin) {
+				right.include(binBounds[bin].min, binBounds[bin].max);
+				rightCount += binCounts[bin];
+				rightCosts[bin] = right.getHalfSurfaceArea() * rightCount;
+			}
+			Bounds left;
+			uint32_t leftCount = 0;
+			for(uint32_t bin = 0; bin < NUM_BINS - 1; ++bin) {
+				left.include(binBounds[bin].min, binBounds[bin].max);
+				leftCount += binCounts[bin];
+				if(leftCount == 0 || leftCount == count)
+					continue;
+				const float cost = left.getHalfSurfaceArea() * leftCount + rightCosts[bin + 1];
+				if(cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = bin + 1;
+				}
+			}
+		}
+	}
+
+	uint32_t middle = begin;
+	if(bestSplit > 0 && bestCost < bounds.getHalfSurfaceArea() * count) {
+		const float scale = NUM_BINS / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+		const float minCentroid = centroidBounds.min[bestAxis];
+		middle = static_cast<uint32_t>(std::partition(buildTriangles.begin() + begin, buildTriangles.begin() + end,
+			[=](const BuildTriangle & triangle) {
+				return std::min(NUM_BINS - 1, static_cast<uint32_t>((triangle.centroid[bestAxis] - minCentroid) * scale)) < bestSplit;
+			}) - buildTriangles.begin());
+	} else if(count > maxLeafSize && (count > 4 * maxLeafSize || bestSplit == 0)) {
+		// no useful split was found (e.g. all centroids are equal), but the leaf would be too large -> split in the middle
+		middle = begin + count / 2;
+	}
+
+	if(middle == begin || middle == end) {
+		nodes[nodeIndex].secondChildOrFirstTriangle = begin;
+		nodes[nodeIndex].triangleCount = count;
+	} else {
+		build(buildTriangles, begin, middle, maxLeafSize);
+		const uint32_t secondChild = build(buildTriangles, middle, end, maxLeafSize);
+		nodes[nodeIndex].secondChildOrFirstTriangle = secondChild;
+		nodes[nodeIndex].triangleCount = 0;
+	}
+	return nodeIndex;
+}
+
+//! (static)
+MeshBVH * MeshBVH::createFromData(Mesh * mesh, std::vector<Node> nodes, std::vector<uint32_t> triangleIds, std::vector<float> positions) {
+	const std::size_t numTriangles = triangleIds.size();
+	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES || numTriangles != mesh->getIndexCount() / 3 || positions.size() != numTriangles * 9)
+		throw std::invalid_argument("MeshBVH::createFromData: Data does not match the mesh.");
+	if(numTriangles > 0 && nodes.empty())
+		throw std::invalid_argument("MeshBVH::createFromData: Missing nodes.");
+	for(std::size_t i = 0; i < nodes.size(); ++i) {
+		const Node & node = nodes[i];
+		const bool valid = node.isLeaf() ?
+				static_cast<std::size_t>(node.secondChildOrFirstTriangle) + node.triangleCount <= numTriangles :
+				(i + 1 < nodes.size() && node.secondChildOrFirstTriangle > i + 1 && node.secondChildOrFirstTriangle < nodes.size());
+		if(!valid)
+			throw std::invalid_argument("MeshBVH::createFromData: Invalid node.");
+	}
+	for(const auto & triangle : triangleIds) {
+		if(triangle >= numTriangles)
+			throw std::invalid_argument("MeshBVH::createFromData: Invalid triangle index.");
+	}
+	Util::Reference<MeshBVH> bvh = new MeshBVH;
+	bvh->nodes = std::move(nodes);
+	bvh->triangleIds = std::move(triangleIds);
+	bvh->positions = std::move(positions);
+	bvh->vertexRevision = mesh->_getVertexData().getRevision();
+	bvh->indexRevision = mesh->_getIndexData().getRevision();
+	mesh->_setSpatialIndex(bvh.get());
+	return bvh.get();
+}
+
+bool MeshBVH::isValidFor(const Mesh * mesh) const {
+	return vertexRevision == mesh->_getVertexData().getRevision() && indexRevision == mesh->_getIndexData().getRevision();
+}
+
+std::size_t MeshBVH::getMemoryUsage() const {
+	return sizeof(MeshBVH) + nodes.capacity() * sizeof(Node) + triangleIds.capacity() * sizeof(uint32_t) + positions.capacity() * sizeof(float);
+}
+
+//! (internal) Returns the entry distance of the ray into the box, or a negative value if the box is missed within [0, maxDistance].
+static inline float intersectBox(const MeshBVH::Node & node, const float * origin, const float * invDir, float maxDistance) {
+	float tMin = 0.0f;
+	float tMax = maxDistance;
+	for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+		float t0 = (node.min[dim] - origin[dim]) * invDir[dim];
+		float t1 = (node.max[dim] - origin[dim]) * invDir[dim];
+		if(t0 > t1)
+			std::swap(t0, t1);
+		tMin = std::max(tMin, t0);
+		tMax = std::min(tMax, t1);
+		if(tMin > tMax) // also handles NaN from 0 * inf, as comparisons with NaN are false
+			return -1.0f;
+	}
+	return tMin;
+}
+
+int32_t MeshBVH::getFirstIntersectingTriangle(const Geometry::Ray3 & ray, float * distance) const {
+	if(nodes.empty())
+		return -1;
+	const Geometry::Vec3 & rayOrigin = ray.getOrigin();
+	const Geometry::Vec3 & rayDir = ray.getDirection();
+	const float origin[3] = {rayOrigin.x(), rayOrigin.y(), rayOrigin.z()};
+	const float invDir[3] = {1.0f / rayDir.x(), 1.0f / rayDir.y(), 1.0f / rayDir.z()};
+
+	int32_t closest = -1;
+	float closestDist = std::numeric_limits<float>::infinity();
+	float tLine, uTri, vTri;
+
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+	while(!stack.empty()) {
+		const Node & node = nodes[stack.back()];
+		stack.pop_back();
+		if(intersectBox(node, origin, invDir, closestDist) < 0.0f)
+			continue;
+		if(node.isLeaf()) {
+			for(uint32_t i = node.secondChildOrFirstTriangle; i < node.secondChildOrFirstTriangle + node.triangleCount; ++i) {
+				const float * p = &positions[i * 9];
+				const Geometry::Triangle<Geometry::Vec3> triangle(Geometry::Vec3(p), Geometry::Vec3(p + 3), Geometry::Vec3(p + 6));
+				if(Geometry::Intersection::getLineTriangleIntersection(ray, triangle, tLine, uTri, vTri) && tLine >= 0) {
+					const int32_t id = static_cast<int32_t>(triangleIds[i]);
+					if(tLine < closestDist || (tLine == closestDist && id < closest)) {
+						closestDist = tLine;
+						closest = id;
+					}
+				}
+			}
+		} else {
+			// visit the nearer child first
+			const uint32_t first = static_cast<uint32_t>(&node - nodes.data()) + 1;
+			const uint32_t second = node.secondChildOrFirstTriangle;
+			const float tFirst = intersectBox(nodes[first], origin, invDir, closestDist);
+			const float tSecond = intersectBox(nodes[second], origin, invDir, closestDist);
+			if(tFirst >= 0.0f && tSecond >= 0.0f) {
+				stack.push_back(tFirst <= tSecond ? second : first);
+				stack.push_back(tFirst <= tSecond ? first : second);
+			} else if(tFirst >= 0.0f) {
+				stack.push_back(first);
+			} else if(tSecond >= 0.0f) {
+				stack.push_back(second);
+			}
+		}
+	}
+	if(distance != nullptr && closest >= 0)
+		*distance = closestDist;
+	return closest;
+}
+
+//! (internal) @p nodeTest returns -1 (no triangle of the subtree is collected), 1 (all are collected) or 0 (test the triangles).
+template<typename NodeTest, typename TriangleTest>
+void MeshBVH::collectTriangles(const NodeTest & nodeTest, const TriangleTest & triangleTest, std::vector<uint32_t> & triangles) const {
+	if(nodes.empty())
+		return;
+	const std::size_t firstResult = triangles.size();
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+	while(!stack.empty()) {
+		const uint32_t nodeIndex = stack.back();
+		stack.pop_back();
+		const Node & node = nodes[nodeIndex];
+		const int result = nodeTest(node);
+		if(result < 0)
+			continue;
+		if(!node.isLeaf() && result == 0) {
+			stack.push_back(node.secondChildOrFirstTriangle);
+			stack.push_back(nodeIndex + 1);
+			continue;
+		}
+		if(result > 0) {
+			// the triangles of a subtree are stored consecutively: find its range by descending to the first and the last leaf.
+			uint32_t firstLeaf = nodeIndex;
+			while(!nodes[firstLeaf].isLeaf())
+				++firstLeaf;
+			uint32_t lastLeaf = nodeIndex;
+			while(!nodes[lastLeaf].isLeaf())
+				lastLeaf = nodes[lastLeaf].secondChildOrFirstTriangle;
+			triangles.insert(triangles.end(), triangleIds.begin() + nodes[firstLeaf].secondChildOrFirstTriangle,
+				triangleIds.begin() + nodes[lastLeaf].secondChildOrFirstTriangle + nodes[lastLeaf].triangleCount);
+		} else {
+			for(uint32_t i = node.secondChildOrFirstTriangle; i < node.secondChildOrFirstTriangle + node.triangleCount; ++i) {
+				if(triangleTest(&positions[i * 9]))
+					triangles.push_back(triangleIds[i]);
+			}
+		}
+	}
+	std::sort(triangles.begin() + firstResult, triangles.end());
+}
+
+//! (internal) Minimum and maximum of plane.planeTest() over the node's box.
+static inline void getPlaneTestRange(const Geometry::Plane & plane, const MeshBVH::Node & node, float & minTest, float & maxTest) {
+	const Geometry::Vec3 & normal = plane.getNormal();
+	Geometry::Vec3 nearCorner, farCorner;
+	for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+		const bool positive = normal[dim] >= 0.0f;
+		nearCorner[dim] = positive ? node.min[dim] : node.max[dim];
+		farCorner[dim] = positive ? node.max[dim] : node.min[dim];
+	}
+	minTest = plane.planeTest(nearCorner);
+	maxTest = plane.planeTest(farCorner);
+}
+
+void MeshBVH::collectTrianglesInFrontOfPlane(const Geometry::Plane & plane, std::vector<uint32_t> & triangles) const {
+	collectTriangles(
+		[&plane](const Node & node) -> int {
+			float minTest, maxTest;
+			getPlaneTestRange(plane, node, minTest, maxTest);
+			return maxTest < 0.0f ? -1 : (minTest >= 0.0f ? 1 : 0);
+		},
+		[&plane](const float * p) {
+			return plane.planeTest(Geometry::Vec3(p)) >= 0.0f && plane.planeTest(Geometry::Vec3(p + 3)) >= 0.0f && plane.planeTest(Geometry::Vec3(p + 6)) >= 0.0f;
+		}, triangles);
+}
+
+void MeshBVH::collectTrianglesCrossingPlane(const Geometry::Plane & plane, float tolerance, std::vector<uint32_t> & triangles) const {
+	collectTriangles(
+		[&plane, tolerance](const Node & node) -> int {
+			float minTest, maxTest;
+			getPlaneTestRange(plane, node, minTest, maxTest);
+			return (minTest >= -tolerance || maxTest <= tolerance) ? -1 : 0;
+		},
+		[&plane, tolerance](const float * p) {
+			const float pa = plane.planeTest(Geometry::Vec3(p));
+			const float pb = plane.planeTest(Geometry::Vec3(p + 3));
+			const float pc = plane.planeTest(Geometry::Vec3(p + 6));
+			return !(pa >= -tolerance && pb >= -tolerance && pc >= -tolerance) && !(pa <= tolerance && pb <= tolerance && pc <= tolerance);
+		}, triangles);
+}
+
+}
+}
@@ -0,0 +1,125 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_MESHBVH_H_
+#define RENDERING_MESHUTILS_MESHBVH_H_
+
+#include "../Mesh/Mesh.h"
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Geometry {
+template<typename _T> class _Plane;
+typedef _Plane<float> Plane;
+template<typename _T> class _Vec3;
+typedef _Vec3<float> Vec3;
+template<typename _T> class _Ray;
+typedef _Ray<Vec3> Ray3;
+}
+
+namespace Rendering {
+namespace MeshUtils {
+
+/**
+ * Bounding volume hierarchy over the triangles of a triangle mesh.
+ * The hierarchy is built top-down using the surface area heuristic (binned) and stored as a flat
+ * array of nodes in depth-first order. The triangle positions are copied in leaf order, so queries
+ * do not access the mesh.
+ *
+ * A BVH is cached by the mesh it was built for (see get()) and automatically rebuilt when the mesh's
+ * vertex or index data has been marked as changed (see MeshVertexData::getRevision()).
+ *
+ * \code
+ * MeshUtils::MeshBVH * bvh = MeshUtils::MeshBVH::get(mesh);
+ * const int32_t triangle = bvh->getFirstIntersectingTriangle(ray);
+ * \endcode
+ */
+class MeshBVH : public MeshDerivedData {
+	public:
+		//! Node of the hierarchy; the first child of an inner node always directly follows its parent.
+		struct Node {
+			float min[3];
+			//! Inner node: index of the second child; leaf: index of the first triangle (in leaf order).
+			uint32_t secondChildOrFirstTriangle;
+			float max[3];
+			//! Number of triangles; 0 for inner nodes.
+			uint32_t triangleCount;
+
+			bool isLeaf()const	{	return triangleCount > 0;	}
+		};
+
+		/*! (static) Return the BVH cached by @p mesh. If there is none, or if it is outdated, a new one is built and cached.
+			Returns nullptr if the mesh is no triangle mesh. */
+		static MeshBVH * get(Mesh * mesh);
+
+		/*! (static) Return the BVH cached by @p mesh if it exists and is up to date; nothing is built.
+			Used by operations that only profit from a BVH if it is already available. */
+		static MeshBVH * getIfValid(const Mesh * mesh);
+
+		/*! (static) Build a new BVH for the given triangle mesh (which is not cached).
+			@param maxLeafSize Maximum number of triangles in a leaf. */
+		static Util::Reference<MeshBVH> create(Mesh * mesh, uint32_t maxLeafSize = 4);
+
+		/*! (static) Create a BVH from previously stored data (see getNodes(), getTriangleIds() and getTrianglePositions())
+			for the current data of @p mesh and cache it there. Nothing is calculated except for a consistency check.
+			@throw std::invalid_argument if the data is inconsistent or does not match the mesh's triangle count. */
+		static MeshBVH * createFromData(Mesh * mesh, std::vector<Node> nodes, std::vector<uint32_t> triangleIds, std::vector<float> positions);
+
+		virtual ~MeshBVH();
+
+		//! Returns true iff the BVH was built for the current data of @p mesh.
+		bool isValidFor(const Mesh * mesh) const;
+
+		/*! Return the index of the closest triangle hit by the ray (with a non-negative ray parameter), or -1.
+			If several triangles are hit at the same distance, the one with the lowest index is returned.
+			@param distance If not null, the ray parameter of the hit is stored there. */
+		int32_t getFirstIntersectingTriangle(const Geometry::Ray3 & ray, float * distance = nullptr) const;
+
+		/*! Collect the indices of all triangles whose vertices all lie in front of or on the plane (planeTest >= 0).
+			The indices are appended to @p triangles in ascending order. */
+		void collectTrianglesInFrontOfPlane(const Geometry::Plane & plane, std::vector<uint32_t> & triangles) const;
+
+		/*! Collect the indices of all triangles having a vertex farther than @p tolerance behind and a vertex
+			farther than @p tolerance in front of the plane. The indices are appended to @p triangles in ascending order. */
+		void collectTrianglesCrossingPlane(const Geometry::Plane & plane, float tolerance, std::vector<uint32_t> & triangles) const;
+
+		uint32_t getTriangleCount() const					{	return static_cast<uint32_t>(triangleIds.size());	}
+		const std::vector<Node> & getNodes() const			{	return nodes;	}
+		//! Mesh triangle index of every triangle in leaf order.
+		const std::vector<uint32_t> & getTriangleIds() const	{	return triangleIds;	}
+		//! Positions (nine floats) of every triangle in leaf order.
+		const std::vector<float> & getTrianglePositions() const	{	return positions;	}
+		//! Amount of main memory used by the BVH in bytes.
+		std::size_t getMemoryUsage() const;
+
+	private:
+		MeshBVH();
+
+		struct BuildTriangle;
+		uint32_t build(std::vector<BuildTriangle> & buildTriangles, uint32_t begin, uint32_t end, uint32_t maxLeafSize);
+
+		template<typename NodeTest, typename TriangleTest>
+		void collectTriangles(const NodeTest & nodeTest, const TriangleTest & triangleTest, std::vector<uint32_t> & triangles) const;
+
+		std::vector<Node> nodes;
+		//! Mesh triangle index of every triangle in leaf order.
+		std::vector<uint32_t> triangleIds;
+		//! Positions of the three vertices (nine floats) of every triangle in leaf order.
+		std::vector<float> positions;
+		uint64_t vertexRevision;
+		uint64_t indexRevision;
+};
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_MESHBVH_H_ */
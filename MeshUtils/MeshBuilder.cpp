@@ -14,6 +14,7 @@
 #include "MeshUtils.h"
 #include "../Mesh/VertexAccessor.h"
 #include "../Mesh/Mesh.h"
+#include "../GLHeader.h"
 
 #include <Geometry/Matrix4x4.h>
 
@@ -24,7 +25,9 @@
 #include <Util/Graphics/Bitmap.h>
 #include <Util/Graphics/PixelAccessor.h>
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <map>
 
 namespace Rendering {
@@ -178,6 +181,7 @@ MeshBuilder::MeshBuilder() {
 	currentVertex.allocate(1, description);
 	acc = new VertexAccessor(currentVertex);
 	acc->setColor(0, Util::Color4f{1,1,1,1}); // Default color WHITE
+	resolveAttributeSlots();
 }
 
 MeshBuilder::MeshBuilder(VertexDescription _description) : description(std::move(_description)) {
@@ -186,6 +190,40 @@ MeshBuilder::MeshBuilder(VertexDescription _description) : description(std::move
 	currentVertex.allocate(1, description);
 	acc = new VertexAccessor(currentVertex);
 	acc->setColor(0, Util::Color4f{1,1,1,1}); // Default color WHITE
+	resolveAttributeSlots();
+}
+
+void MeshBuilder::resolveAttributeSlots() {
+	auto resolve = [this](const Util::StringIdentifier & name, uint8_t numValues) {
+		AttributeSlot slot;
+		const VertexAttribute & attr = description.getAttribute(name);
+		if(!attr.empty() && attr.getDataType() == GL_FLOAT && attr.getNumValues() == numValues) {
+			slot.offset = attr.getOffset();
+			slot.numValues = numValues;
+		}
+		return slot;
+	};
+	positionSlot = resolve(VertexAttributeIds::POSITION, 3);
+	normalSlot = resolve(VertexAttributeIds::NORMAL, 3);
+	colorSlot = resolve(VertexAttributeIds::COLOR, 4);
+	texCoordSlot = resolve(VertexAttributeIds::TEXCOORD0, 2);
+}
+
+void MeshBuilder::ensureVertexCapacity(uint32_t count) {
+	if(count > vData.getVertexCount())
+		vData.allocate(std::max(count, vData.getVertexCount() * 2), description);
+}
+
+void MeshBuilder::ensureIndexCapacity(uint32_t count) {
+	if(count > iData.getIndexCount())
+		iData.allocate(std::max(count, iData.getIndexCount() * 2));
+}
+
+void MeshBuilder::reserve(uint32_t numVertices, uint32_t numIndices) {
+	if(vSize + numVertices > vData.getVertexCount())
+		vData.allocate(vSize + numVertices, description);
+	if(iSize + numIndices > iData.getIndexCount())
+		iData.allocate(iSize + numIndices);
 }
 
 MeshBuilder::~MeshBuilder() = default;
@@ -200,7 +238,15 @@ void MeshBuilder::position(const Geometry::Vec2 & v, const Util::StringIdentifie
 }
 
 void MeshBuilder::position(const Geometry::Vec3f & v, const Util::StringIdentifier& attr) {
-	acc->setPosition(0, transMat ? transMat->transformPosition(v) : v, attr);
+	const Geometry::Vec3f p = transMat ? transMat->transformPosition(v) : v;
+	if(positionSlot.isValid() && attr == VertexAttributeIds::POSITION) {
+		float * target = reinterpret_cast<float *>(currentVertex.data() + positionSlot.offset);
+		target[0] = p.getX();
+		target[1] = p.getY();
+		target[2] = p.getZ();
+	} else {
+		acc->setPosition(0, p, attr);
+	}
 }
 
 void MeshBuilder::position(const Geometry::Vec4 & v, const Util::StringIdentifier& attr) {
@@ -208,14 +254,26 @@ void MeshBuilder::position(const Geometry::Vec4 & v, const Util::StringIdentifie
 }
 
 void MeshBuilder::normal(const Geometry::Vec3f & n, const Util::StringIdentifier& attr) {
-	acc->setNormal(0, transMat ? ((*transMat)*Geometry::Vec4(n,0.0)).xyz() : n, attr);
+	const Geometry::Vec3f t = transMat ? ((*transMat)*Geometry::Vec4(n,0.0)).xyz() : n;
+	if(normalSlot.isValid() && attr == VertexAttributeIds::NORMAL) {
+		float * target = reinterpret_cast<float *>(currentVertex.data() + normalSlot.offset);
+		target[0] = t.getX();
+		target[1] = t.getY();
+		target[2] = t.getZ();
+	} else {
+		acc->setNormal(0, t, attr);
+	}
 }
 void MeshBuilder::normal(const Geometry::Vec3b & n, const Util::StringIdentifier& attr) {
 	normal( Geometry::Vec3f(n) );
 }
 
 void MeshBuilder::color(const Util::Color4f & c, const Util::StringIdentifier& attr) {
-	acc->setColor(0, c, attr);
+	if(colorSlot.isValid() && attr == VertexAttributeIds::COLOR) {
+		std::memcpy(currentVertex.data() + colorSlot.offset, c.data(), 4 * sizeof(float));
+	} else {
+		acc->setColor(0, c, attr);
+	}
 }
 
 void MeshBuilder::color(const Util::Color4ub & c, const Util::StringIdentifier& attr) {
@@ -223,7 +281,13 @@ void MeshBuilder::color(const Util::Color4ub & c, const Util::StringIdentifier&
 }
 
 void MeshBuilder::texCoord0(const Geometry::Vec2 & uv, const Util::StringIdentifier& attr) {
-	acc->setTexCoord(0, uv, attr);
+	if(texCoordSlot.isValid() && attr == VertexAttributeIds::TEXCOORD0) {
+		float * target = reinterpret_cast<float *>(currentVertex.data() + texCoordSlot.offset);
+		target[0] = uv.getX();
+		target[1] = uv.getY();
+	} else {
+		acc->setTexCoord(0, uv, attr);
+	}
 }
 
 void MeshBuilder::values(const std::vector<float> & v, const Util::StringIdentifier& attr) {
@@ -254,19 +318,77 @@ uint32_t MeshBuilder::addVertex(const Geometry::Vec3& pos, const Geometry::Vec3&
 }
 
 uint32_t MeshBuilder::addVertex() {
-	if(vSize >= vData.getVertexCount())
-		vData.allocate(vData.getVertexCount()*2, description);
-		
+	ensureVertexCapacity(vSize + 1);
 	std::copy(currentVertex.data(), currentVertex.data() + description.getVertexSize(), vData.data() + vSize * description.getVertexSize());
 	return vSize++;
 }
 
+uint32_t MeshBuilder::addVertices(uint32_t count, const float * positions, const float * normals, const float * colors, const float * texCoords) {
+	const uint32_t first = vSize;
+	if(count == 0)
+		return first;
+	ensureVertexCapacity(vSize + count);
+	const size_t stride = description.getVertexSize();
+	uint8_t * target = vData.data() + first * stride;
+	for(uint32_t i = 0; i < count; ++i)
+		std::copy(currentVertex.data(), currentVertex.data() + stride, target + i * stride);
+
+	// Attributes that are not stored as floats are written using an accessor.
+	std::unique_ptr<VertexAccessor> fallback;
+	auto writeAttribute = [&](const float * values, const AttributeSlot & slot, uint8_t numValues, const Util::StringIdentifier & name, bool isPosition, bool isNormal) {
+		if(values == nullptr)
+			return;
+		for(uint32_t i = 0; i < count; ++i) {
+			const float * value = values + i * numValues;
+			Geometry::Vec3f v;
+			if((isPosition || isNormal) && transMat) {
+				v = isPosition ? transMat->transformPosition(Geometry::Vec3f(value)) : transMat->transformDirection(Geometry::Vec3f(value));
+				value = v.getVec();
+			}
+			if(slot.isValid()) {
+				std::memcpy(target + i * stride + slot.offset, value, numValues * sizeof(float));
+			} else if(description.hasAttribute(name)) {
+				if(!fallback)
+					fallback.reset(new VertexAccessor(vData));
+				fallback->setFloats(first + i, value, numValues, name);
+			}
+		}
+	};
+	writeAttribute(positions, positionSlot, 3, VertexAttributeIds::POSITION, true, false);
+	writeAttribute(normals, normalSlot, 3, VertexAttributeIds::NORMAL, false, true);
+	writeAttribute(colors, colorSlot, 4, VertexAttributeIds::COLOR, false, false);
+	writeAttribute(texCoords, texCoordSlot, 2, VertexAttributeIds::TEXCOORD0, false, false);
+
+	vSize += count;
+	return first;
+}
+
+uint32_t MeshBuilder::addRawVertices(const uint8_t * vertices, uint32_t count) {
+	const uint32_t first = vSize;
+	ensureVertexCapacity(vSize + count);
+	const size_t stride = description.getVertexSize();
+	std::copy(vertices, vertices + count * stride, vData.data() + first * stride);
+	vSize += count;
+	return first;
+}
+
 void MeshBuilder::addIndex(uint32_t idx) {
-	if(iSize >= iData.getIndexCount())
-		iData.allocate(iData.getIndexCount()*2);
+	ensureIndexCapacity(iSize + 1);
 	iData[iSize++] = idx;
 }
 
+void MeshBuilder::addIndices(const uint32_t * indices, uint32_t count, uint32_t baseVertex) {
+	ensureIndexCapacity(iSize + count);
+	uint32_t * target = iData.data() + iSize;
+	if(baseVertex == 0) {
+		std::copy(indices, indices + count, target);
+	} else {
+		for(uint32_t i = 0; i < count; ++i)
+			target[i] = indices[i] + baseVertex;
+	}
+	iSize += count;
+}
+
 Mesh* MeshBuilder::buildMesh() {
 	if(isEmpty()) {
 		std::cerr << "Empty Mesh..? (MeshBuilder::buildMesh)\n";
@@ -276,15 +398,25 @@ Mesh* MeshBuilder::buildMesh() {
 	vData.allocate(vSize, description);
 	vData.updateBoundingBox();
   
-  if(iSize > 0) {
-  	iData.allocate(iSize);
-  	iData.updateIndexRange();
-  }
+	const bool useIndexData = iSize > 0;
+	if(useIndexData) {
+		iData.allocate(iSize);
+		iData.updateIndexRange();
+	} else {
+		iData = MeshIndexData();
+	}
 
-	auto m = new Mesh(iData, vData);
-	if(iSize == 0)
+	auto m = new Mesh(std::move(iData), std::move(vData));
+	if(!useIndexData)
 		m->setUseIndexData(false);
 
+	// The buffers now belong to the mesh; start over with empty ones.
+	vData = MeshVertexData();
+	vData.allocate(1, description);
+	iData = MeshIndexData();
+	iData.allocate(1);
+	vSize = 0;
+	iSize = 0;
 	return m;
 }
 
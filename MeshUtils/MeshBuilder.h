@@ -99,9 +99,15 @@ public:
 	/*!	true if no no vertices were added so far.	*/
 	bool isEmpty() const { return vSize == 0; }
 
-	//!	Build a new mesh using the internal vertex and index buffer.
+	/*!	Build a new mesh using the internal vertex and index buffer.
+		The buffers are moved into the mesh; afterwards, the builder is empty (the current vertex data and
+		the transformation are kept). */
 	Mesh * buildMesh();
 
+	/*! Make sure that at least @p numVertices further vertices and @p numIndices further indices can be added
+		without re-allocating the internal buffers. */
+	void reserve(uint32_t numVertices, uint32_t numIndices);
+
 	/*! Sets the current vertex data for the following vertices (like a state in OpenGL). 
 		If a tranformation is set, the position and normal are transformed accordingly before being set. */
 	void position(const Geometry::Vec2 & v, const Util::StringIdentifier& attr=VertexAttributeIds::POSITION);
@@ -126,9 +132,23 @@ public:
 						float r, float g, float b, float a,
 						float u, float v) __attribute__((deprecated));
 
+	/*! Add @p count vertices at once. The arrays are tightly packed (three floats per position and normal, four
+		floats per color, two floats per texture coordinate); for an array that is @c nullptr, the current value
+		(set by position(...), normal(...) etc.) is used. The transformation is applied to positions and normals.
+		The index of the first new vertex is returned. */
+	uint32_t addVertices(uint32_t count, const float * positions, const float * normals = nullptr,
+						const float * colors = nullptr, const float * texCoords = nullptr);
+
+	/*! Add @p count vertices stored in the builder's vertex description. The data is copied as is (no transformation).
+		The index of the first new vertex is returned. */
+	uint32_t addRawVertices(const uint8_t * vertices, uint32_t count);
+
 	/*!	Add a index to the interal buffer	*/
 	void addIndex(uint32_t idx);
 
+	//! Add @p count indices at once; @p baseVertex is added to each index.
+	void addIndices(const uint32_t * indices, uint32_t count, uint32_t baseVertex = 0);
+
 	/*!	Adds a quad to the internal buffer, clockwise.	*/
 	void addQuad(uint32_t idx0, uint32_t idx1, uint32_t idx2, uint32_t idx3);
 
@@ -152,6 +172,23 @@ public:
 	void transform(const Geometry::Matrix4x4 & m);
 	
 private:
+	/*! (internal) Location of a standard float attribute in the vertex description, resolved once per builder,
+		so that the per-vertex calls do not have to look up the attribute by name. */
+	struct AttributeSlot {
+		int32_t offset = -1; //!< -1 if the attribute is missing or not stored as float
+		uint8_t numValues = 0;
+		bool isValid() const { return offset >= 0; }
+	};
+	AttributeSlot positionSlot;
+	AttributeSlot normalSlot;
+	AttributeSlot colorSlot;
+	AttributeSlot texCoordSlot;
+
+	void resolveAttributeSlots();
+	//! (internal) Grow the vertex buffer (at least doubling its size) to hold @p count vertices.
+	void ensureVertexCapacity(uint32_t count);
+	void ensureIndexCapacity(uint32_t count);
+
 	VertexDescription description;
 	uint32_t vSize=0;
 	uint32_t iSize=0;
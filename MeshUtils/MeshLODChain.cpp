@@ -0,0 +1,141 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MeshLODChain.h"
+#include "../Mesh/LODMeshDataStrategy.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexDescription.h"
+#include <Util/Macros.h>
+#include <algorithm>
+
+namespace Rendering {
+namespace MeshUtils {
+
+//! (static)
+MeshLODChain * MeshLODChain::create(Mesh * mesh,
+									float fullDetailScreenSize,
+									const std::vector<LevelDescription> & levelDescriptions,
+									const Simplification::weights_t & weights,
+									uint32_t numThreads,
+									simplifier_t simplifier) {
+	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES || !mesh->isUsingIndexData()) {
+		WARN("MeshLODChain: Only indexed triangle meshes are supported.");
+		return nullptr;
+	}
+	const uint32_t numTriangles = mesh->getPrimitiveCount();
+
+	// build the levels
+	std::vector<Mesh *> levelMeshes;
+	std::vector<Util::Reference<Mesh>> simplifiedMeshes; // owns the levels except for the original mesh
+	std::vector<float> minScreenSizes;
+	levelMeshes.push_back(mesh);
+	minScreenSizes.push_back(fullDetailScreenSize);
+	for(const auto & description : levelDescriptions) {
+		Mesh * previous = levelMeshes.back();
+		const uint32_t target = std::max(1u, static_cast<uint32_t>(description.triangleRatio * numTriangles));
+		if(target >= previous->getPrimitiveCount())
+			continue;
+		Mesh * simplified;
+		if(simplifier == VERTEX_CLUSTERING) {
+			// clustering the original mesh does not accumulate the errors of the previous levels
+			simplified = Simplification::simplifyMeshByClusteringToTriangleCount(mesh, target);
+		} else {
+			simplified = Simplification::simplifyMeshParallel(previous, target, 0.0f, true, -1.0f, weights, numThreads);
+		}
+		if(simplified == nullptr || simplified == previous || simplified == mesh)
+			break;
+		if(simplified->getPrimitiveCount() == 0 || simplified->getPrimitiveCount() >= previous->getPrimitiveCount()) {
+			Util::Reference<Mesh> discard(simplified);
+			break;
+		}
+		simplifiedMeshes.emplace_back(simplified);
+		levelMeshes.push_back(simplified);
+		minScreenSizes.push_back(description.minScreenSize);
+	}
+	// the coarsest level is used for all smaller sizes
+	minScreenSizes.back() = 0.0f;
+
+	// concatenate the levels
+	const VertexDescription & vd = mesh->getVertexDescription();
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	for(Mesh * levelMesh : levelMeshes) {
+		vertexCount += levelMesh->getVertexCount();
+		indexCount += levelMesh->getIndexCount();
+	}
+	MeshVertexData vertexData;
+	vertexData.allocate(vertexCount, vd);
+	MeshIndexData indexData;
+	indexData.allocate(indexCount);
+	std::vector<LODMeshDataStrategy::Level> levels;
+	uint8_t * vertexPointer = vertexData.data();
+	uint32_t * indexPointer = indexData.data();
+	uint32_t vertexOffset = 0;
+	uint32_t indexOffset = 0;
+	for(size_t i = 0; i < levelMeshes.size(); ++i) {
+		Mesh * levelMesh = levelMeshes[i];
+		const MeshVertexData & levelVertices = levelMesh->openVertexData();
+		vertexPointer = std::copy(levelVertices.data(), levelVertices.data() + levelVertices.dataSize(), vertexPointer);
+		const MeshIndexData & levelIndices = levelMesh->openIndexData();
+		for(uint32_t j = 0; j < levelIndices.getIndexCount(); ++j)
+			*indexPointer++ = levelIndices[j] + vertexOffset;
+		levels.emplace_back(indexOffset, levelIndices.getIndexCount(), minScreenSizes[i]);
+		vertexOffset += levelMesh->getVertexCount();
+		indexOffset += levelIndices.getIndexCount();
+	}
+	levelMeshes.clear();
+	simplifiedMeshes.clear();
+	vertexData.updateBoundingBox();
+	indexData.updateIndexRange();
+
+	Util::Reference<Mesh> chainMesh = new Mesh(std::move(indexData), std::move(vertexData));
+	std::unique_ptr<LODMeshDataStrategy> strategy(new LODMeshDataStrategy(std::move(levels)));
+	chainMesh->setDataStrategy(strategy.get());
+	return new MeshLODChain(chainMesh, std::move(strategy));
+}
+
+//! (static)
+MeshLODChain * MeshLODChain::create(Mesh * mesh, uint32_t numLevels, const Simplification::weights_t & weights, uint32_t numThreads,
+									simplifier_t simplifier) {
+	std::vector<LevelDescription> descriptions;
+	float ratio = 1.0f;
+	float screenSize = 0.5f;
+	for(uint32_t i = 1; i < numLevels; ++i) {
+		ratio *= 0.5f;
+		descriptions.emplace_back(ratio, screenSize * 0.5f);
+		screenSize *= 0.5f;
+	}
+	return create(mesh, 0.5f, descriptions, weights, numThreads, simplifier);
+}
+
+//! (ctor)
+MeshLODChain::MeshLODChain(Util::Reference<Mesh> _mesh, std::unique_ptr<LODMeshDataStrategy> _strategy) :
+		ReferenceCounter_t(), mesh(std::move(_mesh)), strategy(std::move(_strategy)) {
+}
+
+//! (dtor)
+MeshLODChain::~MeshLODChain() {
+	// The mesh may outlive the chain; it must not keep a pointer to the strategy.
+	if(mesh->getDataStrategy() == strategy.get())
+		mesh->setDataStrategy(MeshDataStrategy::getDefaultStrategy());
+}
+
+uint32_t MeshLODChain::getNumLevels() const {
+	return static_cast<uint32_t>(strategy->getLevels().size());
+}
+
+uint32_t MeshLODChain::getTriangleCount(uint32_t level) const {
+	return strategy->getLevels().at(level).elementCount / 3;
+}
+
+}
+}
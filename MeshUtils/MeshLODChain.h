@@ -0,0 +1,85 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_MESHLODCHAIN_H_
+#define RENDERING_MESHUTILS_MESHLODCHAIN_H_
+
+#include "Simplification.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Rendering {
+class LODMeshDataStrategy;
+class Mesh;
+namespace MeshUtils {
+
+/**
+ * Levels of detail of a mesh stored in a single mesh: the vertices of all levels share one vertex buffer
+ * and every level is a consecutive range of the index data (finest level first).
+ * The mesh uses a LODMeshDataStrategy that selects the level by the projected size of the bounding box,
+ * so it can be displayed like any other mesh.
+ */
+class MeshLODChain : public Util::ReferenceCounter<MeshLODChain> {
+	public:
+		struct LevelDescription {
+			//! Number of triangles relative to the original mesh (e.g. 0.5 for half of the triangles).
+			float triangleRatio;
+			//! Minimum projected size (fraction of the viewport) for which the level is used.
+			float minScreenSize;
+			LevelDescription(float ratio, float minSize) : triangleRatio(ratio), minScreenSize(minSize) {}
+		};
+
+		enum simplifier_t {
+			//! High quality: Simplification::simplifyMeshParallel applied to the previous level.
+			QUADRIC_ERROR,
+			//! Fast, low quality: Simplification::simplifyMeshByClusteringToTriangleCount applied to the original mesh.
+			VERTEX_CLUSTERING
+		};
+
+		/**
+		 * Create a chain from the given triangle mesh. The original mesh is the first level and is used if its projected
+		 * size is at least @p fullDetailScreenSize. Each further level is created by the given @p simplifier.
+		 * Descriptions have to be sorted by decreasing triangle ratio.
+		 * @param weights attribute weights (only used by QUADRIC_ERROR)
+		 * @return chain, or @c nullptr if @p mesh is no indexed triangle mesh
+		 */
+		static MeshLODChain * create(Mesh * mesh,
+									 float fullDetailScreenSize,
+									 const std::vector<LevelDescription> & levels,
+									 const Simplification::weights_t & weights,
+									 uint32_t numThreads = 0,
+									 simplifier_t simplifier = QUADRIC_ERROR);
+
+		//! Create a chain with @p numLevels levels, halving the triangle count and the screen size from level to level.
+		static MeshLODChain * create(Mesh * mesh, uint32_t numLevels, const Simplification::weights_t & weights, uint32_t numThreads = 0,
+									 simplifier_t simplifier = QUADRIC_ERROR);
+
+		~MeshLODChain();
+
+		//! Mesh containing all levels.
+		Mesh * getMesh() const								{	return mesh.get();	}
+		LODMeshDataStrategy * getStrategy() const			{	return strategy.get();	}
+		uint32_t getNumLevels() const;
+		uint32_t getTriangleCount(uint32_t level) const;
+
+	private:
+		MeshLODChain(Util::Reference<Mesh> mesh, std::unique_ptr<LODMeshDataStrategy> strategy);
+
+		Util::Reference<Mesh> mesh;
+		std::unique_ptr<LODMeshDataStrategy> strategy;
+};
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_MESHLODCHAIN_H_ */
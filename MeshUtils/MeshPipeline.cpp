@@ -0,0 +1,185 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MeshPipeline.h"
+#include "LocalMeshDataHolder.h"
+#include "MeshUtils.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexDescription.h"
+#include <Util/Timer.h>
+#include <algorithm>
+#include <utility>
+
+namespace Rendering {
+namespace MeshUtils {
+
+//! (internal) Remove unused vertices; the vertex data is only rebuilt if there are unused vertices.
+static void eliminateUnusedVerticesInPlace(Mesh * mesh) {
+	const MeshIndexData & indices = mesh->openIndexData();
+	std::vector<bool> used(mesh->getVertexCount(), false);
+	uint32_t usedCount = 0;
+	for(uint32_t i = 0; i < indices.getIndexCount(); ++i) {
+		if(!used[indices[i]]) {
+			used[indices[i]] = true;
+			++usedCount;
+		}
+	}
+	if(usedCount == mesh->getVertexCount())
+		return;
+	Util::Reference<Mesh> result = MeshUtils::eliminateUnusedVertices(mesh);
+	mesh->openVertexData().swap(result->openVertexData());
+	mesh->openIndexData().swap(result->openIndexData());
+}
+
+MeshPipeline & MeshPipeline::eliminateDuplicateVertices() {
+	stages.emplace_back(DUPLICATE_VERTICES, "eliminateDuplicateVertices", [](Mesh * mesh) {
+		MeshUtils::eliminateDuplicateVertices(mesh);
+	});
+	return *this;
+}
+
+MeshPipeline & MeshPipeline::addTriangleFilter(const std::string & name, const std::vector<TrianglePredicate> & predicates) {
+	stages.emplace_back(TRIANGLE_FILTER, name, [predicates](Mesh * mesh) {
+		MeshUtils::filterTriangles(mesh, predicates, false);
+	});
+	stages.back().predicates = predicates;
+	return *this;
+}
+
+MeshPipeline & MeshPipeline::eliminateZeroAreaTriangles() {
+	return addTriangleFilter("eliminateZeroAreaTriangles", {MeshUtils::createZeroAreaPredicate()});
+}
+
+MeshPipeline & MeshPipeline::eliminateLongTriangles(float ratio) {
+	return addTriangleFilter("eliminateLongTriangles", {MeshUtils::createLongTrianglePredicate(ratio)});
+}
+
+MeshPipeline & MeshPipeline::eliminateTrianglesBehindPlane(const Geometry::Plane & plane) {
+	return addTriangleFilter("eliminateTrianglesBehindPlane", {MeshUtils::createPlanePredicate(plane)});
+}
+
+MeshPipeline & MeshPipeline::filterTriangles(const std::vector<TrianglePredicate> & predicates) {
+	return addTriangleFilter("filterTriangles", predicates);
+}
+
+MeshPipeline & MeshPipeline::eliminateUnusedVertices() {
+	stages.emplace_back(UNUSED_VERTICES, "eliminateUnusedVertices", &eliminateUnusedVerticesInPlace);
+	return *this;
+}
+
+MeshPipeline & MeshPipeline::calculateNormals() {
+	return addStage("calculateNormals", [](Mesh * mesh) {
+		MeshUtils::calculateNormals(mesh);
+	});
+}
+
+MeshPipeline & MeshPipeline::optimizeIndices(uint_fast8_t cacheSize) {
+	return addStage("optimizeIndices", [cacheSize](Mesh * mesh) {
+		MeshUtils::optimizeIndices(mesh, cacheSize);
+	});
+}
+
+MeshPipeline & MeshPipeline::shrinkMesh(bool shrinkPosition, bool shrinkTexCoords, bool packNormals) {
+	return addStage("shrinkMesh", [shrinkPosition, shrinkTexCoords, packNormals](Mesh * mesh) {
+		MeshUtils::shrinkMesh(mesh, shrinkPosition, shrinkTexCoords, packNormals);
+	});
+}
+
+MeshPipeline & MeshPipeline::addStage(const std::string & name, const stage_function_t & function) {
+	stages.emplace_back(CUSTOM, name, function);
+	return *this;
+}
+
+std::vector<MeshPipeline::Stage> MeshPipeline::getFusedStages() const {
+	std::vector<Stage> fused(stages);
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(size_t i = 0; i + 1 < fused.size(); ++i) {
+			if(fused[i].type == DUPLICATE_VERTICES && fused[i + 1].type == TRIANGLE_FILTER) {
+				std::swap(fused[i], fused[i + 1]);
+				changed = true;
+			} else if(fused[i].type == TRIANGLE_FILTER && fused[i + 1].type == TRIANGLE_FILTER) {
+				Stage & stage = fused[i];
+				const Stage & next = fused[i + 1];
+				stage.name += " + " + next.name;
+				stage.predicates.insert(stage.predicates.end(), next.predicates.begin(), next.predicates.end());
+				stage.removeUnusedVertices = stage.removeUnusedVertices || next.removeUnusedVertices;
+				fused.erase(fused.begin() + i + 1);
+				changed = true;
+			} else if(fused[i].type == TRIANGLE_FILTER && fused[i + 1].type == UNUSED_VERTICES) {
+				fused[i].name += " + " + fused[i + 1].name;
+				fused[i].removeUnusedVertices = true;
+				fused.erase(fused.begin() + i + 1);
+				changed = true;
+			} else if(fused[i].type == DUPLICATE_VERTICES && fused[i + 1].type == UNUSED_VERTICES) {
+				fused.erase(fused.begin() + i + 1);
+				changed = true;
+			} else if(fused[i].type == fused[i + 1].type && fused[i].type != CUSTOM) {
+				fused.erase(fused.begin() + i + 1); // the built-in stages are idempotent
+				changed = true;
+			}
+		}
+	}
+	// the filter stages apply the combined predicates in a single pass
+	for(auto & stage : fused) {
+		if(stage.type == TRIANGLE_FILTER) {
+			const std::vector<TrianglePredicate> predicates(stage.predicates);
+			const bool removeUnusedVertices = stage.removeUnusedVertices;
+			stage.function = [predicates, removeUnusedVertices](Mesh * mesh) {
+				MeshUtils::filterTriangles(mesh, predicates, removeUnusedVertices);
+			};
+		}
+	}
+	return fused;
+}
+
+MeshPipeline::Report MeshPipeline::run(Mesh * mesh) const {
+	Report report;
+	report.milliseconds = 0.0;
+	report.estimatedPeakMemory = 0;
+
+	LocalMeshDataHolder holder(mesh);
+	for(const auto & stage : getFusedStages()) {
+		StageReport stageReport;
+		stageReport.name = stage.name;
+		stageReport.memoryBefore = mesh->getMainMemoryUsage();
+		const MeshVertexData & vertexData = mesh->_getVertexData();
+		const MeshIndexData & indexData = mesh->_getIndexData();
+		const uint8_t * oldVertices = vertexData.data();
+		const uint32_t * oldIndices = indexData.data();
+		const std::size_t oldVertexBytes = vertexData.dataSize();
+		const std::size_t oldIndexBytes = indexData.dataSize();
+
+		Util::Timer timer;
+		timer.reset();
+		stage.function(mesh);
+		timer.stop();
+
+		stageReport.milliseconds = timer.getMilliseconds();
+		stageReport.memoryAfter = mesh->getMainMemoryUsage();
+		stageReport.estimatedPeakMemory = std::max(stageReport.memoryBefore, stageReport.memoryAfter);
+		if(mesh->_getVertexData().data() != oldVertices)
+			stageReport.estimatedPeakMemory = std::max(stageReport.estimatedPeakMemory, stageReport.memoryAfter + oldVertexBytes);
+		if(mesh->_getIndexData().data() != oldIndices)
+			stageReport.estimatedPeakMemory = std::max(stageReport.estimatedPeakMemory, stageReport.memoryAfter + oldIndexBytes);
+
+		report.milliseconds += stageReport.milliseconds;
+		report.estimatedPeakMemory = std::max(report.estimatedPeakMemory, stageReport.estimatedPeakMemory);
+		report.stages.push_back(std::move(stageReport));
+	}
+	return report;
+}
+
+}
+}
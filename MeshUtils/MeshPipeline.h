@@ -0,0 +1,109 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_MESHPIPELINE_H_
+#define RENDERING_MESHUTILS_MESHPIPELINE_H_
+
+#include "MeshUtils.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Rendering {
+class Mesh;
+namespace MeshUtils {
+
+/**
+ * Chain of mesh processing operations that are applied in place to a single mesh.
+ * In contrast to calling the corresponding MeshUtils functions one after another, no stage
+ * creates a new Mesh, the mesh's data is held in local memory (see LocalMeshDataHolder) while
+ * the pipeline runs, and adjacent stages are fused where possible:
+ * - eliminateDuplicateVertices() followed by a triangle filter (e.g. eliminateZeroAreaTriangles()) is executed in the
+ *   opposite order (the result is the same), so that the duplicate elimination directly drops the vertices of removed triangles.
+ * - eliminateUnusedVertices() directly after eliminateDuplicateVertices() is skipped (the duplicate elimination
+ *   already removes unused vertices); otherwise, the vertex data is only rebuilt if there are unused vertices.
+ * - Adjacent triangle filters (eliminateZeroAreaTriangles(), eliminateLongTriangles(), eliminateTrianglesBehindPlane(),
+ *   filterTriangles()) and a directly following eliminateUnusedVertices() are executed as a single
+ *   MeshUtils::filterTriangles() pass, which compacts the indices and vertices only once.
+ *
+ * \code
+ * MeshUtils::MeshPipeline pipeline;
+ * pipeline.eliminateDuplicateVertices().eliminateZeroAreaTriangles().eliminateUnusedVertices()
+ *         .calculateNormals().optimizeIndices().shrinkMesh();
+ * const MeshUtils::MeshPipeline::Report report = pipeline.run(mesh);
+ * \endcode
+ */
+class MeshPipeline {
+	public:
+		typedef std::function<void (Mesh *)> stage_function_t;
+
+		struct StageReport {
+			std::string name;
+			double milliseconds;
+			//! Main memory used by the mesh before and after the stage (see Mesh::getMainMemoryUsage()).
+			std::size_t memoryBefore;
+			std::size_t memoryAfter;
+			/*! Estimated peak main memory of the mesh data while the stage ran: if the stage has replaced the
+				vertex or index data, the old and the new data existed at the same time. */
+			std::size_t estimatedPeakMemory;
+		};
+		struct Report {
+			std::vector<StageReport> stages;
+			double milliseconds;
+			std::size_t estimatedPeakMemory;
+		};
+
+		MeshPipeline & eliminateDuplicateVertices();
+		MeshPipeline & eliminateZeroAreaTriangles();
+		MeshPipeline & eliminateLongTriangles(float ratio);
+		MeshPipeline & eliminateTrianglesBehindPlane(const Geometry::Plane & plane);
+		//! Remove the triangles rejected by any of the predicates (see MeshUtils::filterTriangles()); keeps unused vertices.
+		MeshPipeline & filterTriangles(const std::vector<TrianglePredicate> & predicates);
+		MeshPipeline & eliminateUnusedVertices();
+		MeshPipeline & calculateNormals();
+		MeshPipeline & optimizeIndices(uint_fast8_t cacheSize = 24);
+		MeshPipeline & shrinkMesh(bool shrinkPosition = false, bool shrinkTexCoords = false, bool packNormals = false);
+		//! Add a custom stage that modifies the given mesh in place.
+		MeshPipeline & addStage(const std::string & name, const stage_function_t & function);
+
+		//! Remove all stages.
+		void clear()											{	stages.clear();	}
+		size_t getStageCount() const							{	return stages.size();	}
+
+		//! Apply all stages to @p mesh and return the timing and memory report.
+		Report run(Mesh * mesh) const;
+
+	private:
+		enum stage_type_t {
+			DUPLICATE_VERTICES, TRIANGLE_FILTER, UNUSED_VERTICES, CUSTOM
+		};
+		struct Stage {
+			stage_type_t type;
+			std::string name;
+			stage_function_t function;
+			std::vector<TrianglePredicate> predicates; //!< TRIANGLE_FILTER only
+			bool removeUnusedVertices; //!< TRIANGLE_FILTER only
+			Stage(stage_type_t _type, std::string _name, stage_function_t _function) :
+				type(_type), name(std::move(_name)), function(std::move(_function)), removeUnusedVertices(false) {}
+		};
+		MeshPipeline & addTriangleFilter(const std::string & name, const std::vector<TrianglePredicate> & predicates);
+		std::vector<Stage> stages;
+
+		//! (internal) Return the stages after fusing adjacent stages.
+		std::vector<Stage> getFusedStages() const;
+};
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_MESHPIPELINE_H_ */
@@ -0,0 +1,65 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MeshRegistry.h"
+#include "MeshUtils.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+
+namespace Rendering {
+namespace MeshUtils {
+
+Mesh * MeshRegistry::getUniqueMesh(Mesh * mesh) {
+	if(mesh == nullptr || mesh->isView())
+		return mesh;
+	const uint64_t hash = mesh->getContentHash();
+	const auto range = meshes.equal_range(hash);
+	for(auto it = range.first; it != range.second; ++it) {
+		Mesh * candidate = it->second.get();
+		if(candidate == mesh)
+			return mesh;
+		if(compareMeshes(candidate, mesh)) {
+			++duplicateCount;
+			return candidate;
+		}
+	}
+	meshes.emplace(hash, mesh);
+	return mesh;
+}
+
+Mesh * MeshRegistry::shareData(Mesh * mesh) {
+	Mesh * unique = getUniqueMesh(mesh);
+	if(unique == mesh)
+		return unique;
+	MeshVertexData vertexData(unique->_getVertexData());
+	MeshIndexData indexData(unique->_getIndexData());
+	mesh->_getVertexData().swap(vertexData);
+	mesh->_getIndexData().swap(indexData);
+	return unique;
+}
+
+bool MeshRegistry::remove(Mesh * mesh) {
+	for(auto it = meshes.begin(); it != meshes.end(); ++it) {
+		if(it->second.get() == mesh) {
+			meshes.erase(it);
+			return true;
+		}
+	}
+	return false;
+}
+
+void MeshRegistry::clear() {
+	meshes.clear();
+	duplicateCount = 0;
+}
+
+}
+}
@@ -0,0 +1,68 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_MESHREGISTRY_H_
+#define RENDERING_MESHUTILS_MESHREGISTRY_H_
+
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace Rendering {
+class Mesh;
+namespace MeshUtils {
+
+/**
+ * Registry of unique meshes for detecting duplicates (e.g. the same part imported many times).
+ * Meshes are identified by Mesh::getContentHash(); meshes with equal hashes are compared with compareMeshes(),
+ * so hash collisions never merge different meshes.
+ * \code
+ * Util::Reference<MeshUtils::MeshRegistry> registry = new MeshUtils::MeshRegistry;
+ * for(auto & part : importedParts)
+ *     part.mesh = registry->getUniqueMesh(part.mesh.get()); // identical parts reference the same mesh
+ * \endcode
+ * The registry holds a reference to each unique mesh.
+ * @note Views (see Mesh::createView()) are not registered.
+ */
+class MeshRegistry : public Util::ReferenceCounter<MeshRegistry> {
+	public:
+		MeshRegistry() : ReferenceCounter_t(), duplicateCount(0) {}
+
+		/*! Return the registered mesh with the same content as @p mesh.
+			If there is none, @p mesh is registered and returned.
+			\note The hash of a registered mesh is not updated if the mesh is changed afterwards; changed meshes
+				have to be removed before and registered again.	*/
+		Mesh * getUniqueMesh(Mesh * mesh);
+
+		/*! Let @p mesh share the vertex and index data of the registered mesh with the same content (like a clone,
+			see Mesh::clone()), so the data is stored only once in main memory and, if the unique mesh has been
+			uploaded, in graphics memory. Other properties of @p mesh (e.g. the file name and the data strategy) are kept.
+			@return The unique mesh	*/
+		Mesh * shareData(Mesh * mesh);
+
+		//! Remove the given mesh from the registry; returns @c false if it is not registered.
+		bool remove(Mesh * mesh);
+		void clear();
+
+		std::size_t getUniqueMeshCount()const				{	return meshes.size();	}
+		//! Number of calls of getUniqueMesh() and shareData() that found a duplicate.
+		std::size_t getDuplicateCount()const				{	return duplicateCount;	}
+
+	private:
+		std::unordered_multimap<uint64_t, Util::Reference<Mesh>> meshes;
+		std::size_t duplicateCount;
+};
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_MESHREGISTRY_H_ */
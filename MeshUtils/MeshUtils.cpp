@@ -17,7 +17,12 @@
 #include "../Helper.h"
 #include "../Texture/Texture.h"
 #include "../Texture/TextureUtils.h"
+#include "MeshBVH.h"
 #include "TriangleAccessor.h"
+#include "VertexConversionPlan.h"
+#include "internal/ParallelFor.h"
+#include "internal/ScratchArena.h"
+#include "internal/TransformKernels.h"
 #include <Geometry/BoundingSphere.h>
 #include <Geometry/Box.h>
 #include <Geometry/Matrix4x4.h>
@@ -29,7 +34,6 @@
 #include <Geometry/Plane.h>
 #include <Geometry/Line.h>
 #include <Geometry/LineTriangleIntersection.h>
-#include <Geometry/PointOctree.h>
 #include <Geometry/Point.h>
 #include <Geometry/Interpolation.h>
 #include <Util/Graphics/Color.h>
@@ -38,7 +42,9 @@
 #include <Util/Macros.h>
 #include <Util/Utils.h>
 #include <Util/Numeric.h>
+#include <Util/Timer.h>
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstring> /* for memcmp */
 #include <map>
@@ -59,7 +65,6 @@ namespace MeshUtils {
 
 /**
  * Class which stores raw vertex data. Used in
- * @a eliminateDuplicateVertices().
  * @a splitLargeTriangles().
  *
  * @author Benjamin Eikel
@@ -126,6 +131,9 @@ public:
 	 */
 	static RawVertex interpolate(const RawVertex & rwa, const RawVertex & rwb, float a, const uint32_t & newIndex, const VertexDescription & vd);
 
+	//! Write the interpolated vertex to @p target (getSize() bytes) instead of allocating it.
+	static void interpolate(const RawVertex & rwa, const RawVertex & rwb, float a, uint8_t * target, const VertexDescription & vd);
+
 	static RawVertex move(const RawVertex & rw, const Geometry::Vec3 & dir, const uint32_t & newIndex, const VertexDescription & vd);
 
 private:
@@ -287,7 +295,11 @@ void interpolateValue(uint8_t* data, const RawVertex & rwa, const RawVertex & rw
 RawVertex RawVertex::interpolate(const RawVertex & rwa, const RawVertex & rwb, float a, const uint32_t & newIndex, const VertexDescription & vd) {
 	FAIL_IF(rwa.getSize()!=rwb.getSize());
 	auto data = new uint8_t[rwa.getSize()];
-	RawVertex ret(newIndex, data, rwa.getSize());
+	interpolate(rwa, rwb, a, data, vd);
+	return RawVertex(newIndex, data, rwa.getSize());
+}
+
+void RawVertex::interpolate(const RawVertex & rwa, const RawVertex & rwb, float a, uint8_t * data, const VertexDescription & vd) {
 	float a_inv = 1.0f - a;
 	for(const auto & attr : vd.getAttributes()) {
 		if (attr.empty())
@@ -326,7 +338,6 @@ RawVertex RawVertex::interpolate(const RawVertex & rwa, const RawVertex & rwb, f
 			}
 		}
 	}
-	return ret;
 }
 
 // -----------------------------------------------------------------------------
@@ -400,10 +411,10 @@ uint32_t calculateHash( Mesh * mesh ){
 	if(mesh==nullptr)
 		return 0;
 
-	MeshIndexData & iData = mesh->openIndexData();
+	const MeshIndexData & iData = mesh->openIndexData();
 	uint32_t h = Util::calcHash( reinterpret_cast<const uint8_t*>(iData.data()),iData.dataSize() );
 
-	MeshVertexData & vData = mesh->openVertexData();
+	const MeshVertexData & vData = mesh->openVertexData();
 	h ^= Util::calcHash( vData.data(),vData.dataSize() );
 
 	h ^= calculateHash( vData.getVertexDescription() );
@@ -439,12 +450,14 @@ bool compareMeshes( Mesh * mesh1,Mesh * mesh2 ){
 
 	// indices
 	const MeshIndexData & iData1 = mesh1->openIndexData();
-	if(!std::equal(iData1.data(),iData1.data()+iData1.getIndexCount(),mesh2->openIndexData().data()) )
+	const MeshIndexData & iData2 = mesh2->openIndexData();
+	if(!std::equal(iData1.data(),iData1.data()+iData1.getIndexCount(),iData2.data()) )
 		return false;
 
 	// vertices
 	const MeshVertexData & vData1 = mesh1->openVertexData();
-	if(!std::equal(vData1.data(),vData1.data()+vData1.dataSize(),mesh2->openVertexData().data()) )
+	const MeshVertexData & vData2 = mesh2->openVertexData();
+	if(!std::equal(vData1.data(),vData1.data()+vData1.dataSize(),vData2.data()) )
 		return false;
 
 	return true;
@@ -567,7 +580,7 @@ void splitLargeTriangles(Mesh * m, float maxSideLength) {
 	for (size_t i = 0; i < vertexArray.size(); i++) {
 		std::copy(vertexArray.at(i).getData(), vertexArray.at(i).getData() + vertexSize, vertices[i]);
 	}
-	vertices.updateBoundingBox();
+	vertices.invalidateBoundingBox();
 
 	// cleanup
 	for (auto & rawVertex : vertexArray) {
@@ -578,7 +591,7 @@ void splitLargeTriangles(Mesh * m, float maxSideLength) {
 // -----------------------------------------------------------------------------
 
 //! (static)
-void shrinkMesh(Mesh * m, bool shrinkPosition) {
+void shrinkMesh(Mesh * m, bool shrinkPosition, bool shrinkTexCoords, bool packNormals) {
 	// prepare vertex description
 	const VertexDescription & vdOld = m->getVertexDescription();
 	VertexDescription vdNew;
@@ -586,10 +599,18 @@ void shrinkMesh(Mesh * m, bool shrinkPosition) {
 	bool convertNormals = false;
 	bool convertColors = false;
 	bool convertPosition = false;
+	bool convertTexCoords = false;
 	for(const auto & attr : vdOld.getAttributes()) {
+		bool isTexCoord = false;
+		for(uint_fast8_t unit = 0; unit < 8 && !isTexCoord; ++unit)
+			isTexCoord = attr.getNameId() == VertexAttributeIds::getTextureCoordinateIdentifier(unit);
+
 		// can shrink normals?
 		if (attr.getNameId() == VertexAttributeIds::NORMAL && attr.getDataType() == GL_FLOAT && attr.getNumValues() >= 3) {
-			vdNew.appendNormalByte();
+			if(packNormals)
+				vdNew.appendNormalPacked();
+			else
+				vdNew.appendNormalByte();
 			convertNormals = true;
 		} // can shrink colors?
 		else if (attr.getNameId() == VertexAttributeIds::COLOR && attr.getDataType() == GL_FLOAT && attr.getNumValues() >= 3) {
@@ -599,15 +620,19 @@ void shrinkMesh(Mesh * m, bool shrinkPosition) {
 		else if (shrinkPosition && attr.getNameId() == VertexAttributeIds::POSITION && attr.getDataType() == GL_FLOAT && attr.getNumValues() >= 3) {
 			vdNew.appendPosition4DHalf();
 			convertPosition = true;
+		} // can shrink texture coordinates?
+		else if (shrinkTexCoords && isTexCoord && attr.getDataType() == GL_FLOAT && attr.getNumValues() == 2) {
+			vdNew.appendAttribute(attr.getNameId(), 2, GL_HALF_FLOAT, false);
+			convertTexCoords = true;
 		} else { // just copy
 			vdNew.appendAttribute(attr.getNameId(), attr.getNumValues(), attr.getDataType(), attr.getNormalize());
 		}
 	}
 
-	if (!convertColors && !convertNormals && !convertPosition)
+	if (!convertColors && !convertNormals && !convertPosition && !convertTexCoords)
 		return;
 
-	// convert vertices
+	// convert vertices; normals, positions and texture coordinates are converted by the conversion plan
 	MeshVertexData & oldVertices = m->openVertexData();
 	std::unique_ptr<MeshVertexData> newVertices(convertVertices(oldVertices, vdNew));
 
@@ -617,23 +642,11 @@ void shrinkMesh(Mesh * m, bool shrinkPosition) {
 		for(uint32_t i=0;source->checkRange(i);++i)
 			target->setColor(i,source->getColor4ub(i));
 	}
-	if (convertNormals) {
-		Util::Reference<NormalAttributeAccessor> source(NormalAttributeAccessor::create(oldVertices,VertexAttributeIds::NORMAL));
-		Util::Reference<NormalAttributeAccessor> target(NormalAttributeAccessor::create(*newVertices.get(),VertexAttributeIds::NORMAL));
-		for(uint32_t i=0;source->checkRange(i);++i)
-			target->setNormal(i,source->getNormal(i));
-	}
-	if (convertPosition) {
-		Util::Reference<PositionAttributeAccessor> source(PositionAttributeAccessor::create(oldVertices,VertexAttributeIds::POSITION));
-		Util::Reference<PositionAttributeAccessor> target(PositionAttributeAccessor::create(*newVertices.get(),VertexAttributeIds::POSITION));
-		for(uint32_t i=0;source->checkRange(i);++i)
-			target->setPosition(i,source->getPosition(i));
-	}
 	// set new vertices
 	oldVertices.swap(*newVertices.get());
 
 	oldVertices.markAsChanged();
-	oldVertices.updateBoundingBox();
+	oldVertices.invalidateBoundingBox();
 }
 
 // -----------------------------------------------------------------------------
@@ -650,7 +663,7 @@ static void transformVertexData(MeshVertexData & vData, const Matrix4x4f & trans
 //! (static)
 void transform(MeshVertexData & vData, const Matrix4x4f & transMat) {
 	transformVertexData(vData, transMat, 0, vData.getVertexCount());
-	vData.updateBoundingBox();
+	vData.invalidateBoundingBox();
 }
 
 // -----------------------------------------------------------------------------
@@ -659,10 +672,21 @@ void transform(MeshVertexData & vData, const Matrix4x4f & transMat) {
 void transformCoordinates(MeshVertexData & vData, Util::StringIdentifier attrName, const Geometry::Matrix4x4 & transMat, uint32_t begin,
 		uint32_t numVerts) {
 
-	Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vData,attrName));
-	const uint32_t end = begin+numVerts;
-	for(uint32_t i=begin;i<end;++i)
-		positionAccessor->setPosition(i,transMat.transformPosition(positionAccessor->getPosition(i)));
+	const VertexAttribute & attr = vData.getVertexDescription().getAttribute(attrName);
+	const bool isAffine = transMat.at(3, 0) == 0.0f && transMat.at(3, 1) == 0.0f && transMat.at(3, 2) == 0.0f && transMat.at(3, 3) == 1.0f;
+	if(isAffine && attr.getDataType() == GL_FLOAT && attr.getNumValues() >= 3 && begin + numVerts <= vData.getVertexCount()) {
+		// fast path: transform the float triples directly with the batch kernel
+		const float m[12] = {	transMat.at(0, 0), transMat.at(0, 1), transMat.at(0, 2), transMat.at(0, 3),
+								transMat.at(1, 0), transMat.at(1, 1), transMat.at(1, 2), transMat.at(1, 3),
+								transMat.at(2, 0), transMat.at(2, 1), transMat.at(2, 2), transMat.at(2, 3)};
+		const std::size_t stride = vData.getAttributeStride(attr);
+		TransformKernels::transformPositions3f(vData.data() + vData.getAttributeOffset(attr) + begin * stride, stride, numVerts, m);
+	} else {
+		Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vData,attrName));
+		const uint32_t end = begin+numVerts;
+		for(uint32_t i=begin;i<end;++i)
+			positionAccessor->setPosition(i,transMat.transformPosition(positionAccessor->getPosition(i)));
+	}
 	vData.markAsChanged();
 }
 
@@ -672,22 +696,27 @@ void transformCoordinates(MeshVertexData & vData, Util::StringIdentifier attrNam
 void transformNormals(MeshVertexData & vData, Util::StringIdentifier attrName, const Geometry::Matrix4x4 & transMat, uint32_t begin,
 		uint32_t numVerts) {
 
-	Util::Reference<NormalAttributeAccessor> normalAccessor(NormalAttributeAccessor::create(vData,attrName));
-	const uint32_t end = begin+numVerts;
-	for(uint32_t i=begin;i<end;++i)
-		normalAccessor->setNormal(i, (transMat * Geometry::Vec4(normalAccessor->getNormal(i),0)).xyz());
-	vData.markAsChanged();
-}
-
-// -----------------------------------------------------------------------------
-
-inline bool canConvert(const VertexAttribute& oldAttr, const VertexAttribute& newAttr) {
-	if(oldAttr.getDataType() == GL_FLOAT) {
-		return newAttr.getDataType() == GL_BYTE || newAttr.getDataType() == GL_UNSIGNED_BYTE; // float to byte
-	} else if(newAttr.getDataType() == GL_FLOAT) {
-		return oldAttr.getDataType() == GL_BYTE || oldAttr.getDataType() == GL_UNSIGNED_BYTE; // byte to float
+	const VertexAttribute & attr = vData.getVertexDescription().getAttribute(attrName);
+	const bool isFloat3 = attr.getDataType() == GL_FLOAT && attr.getNumValues() >= 3;
+	const bool isByte4 = attr.getDataType() == GL_BYTE && attr.getNumValues() >= 4;
+	if((isFloat3 || isByte4) && begin + numVerts <= vData.getVertexCount()) {
+		// fast path: transform the values directly with the batch kernel
+		const float m[9] = {	transMat.at(0, 0), transMat.at(0, 1), transMat.at(0, 2),
+								transMat.at(1, 0), transMat.at(1, 1), transMat.at(1, 2),
+								transMat.at(2, 0), transMat.at(2, 1), transMat.at(2, 2)};
+		const std::size_t stride = vData.getAttributeStride(attr);
+		uint8_t * first = vData.data() + vData.getAttributeOffset(attr) + begin * stride;
+		if(isFloat3)
+			TransformKernels::transformDirections3f(first, stride, numVerts, m);
+		else
+			TransformKernels::transformDirections4b(first, stride, numVerts, m);
+	} else {
+		Util::Reference<NormalAttributeAccessor> normalAccessor(NormalAttributeAccessor::create(vData,attrName));
+		const uint32_t end = begin+numVerts;
+		for(uint32_t i=begin;i<end;++i)
+			normalAccessor->setNormal(i, (transMat * Geometry::Vec4(normalAccessor->getNormal(i),0)).xyz());
 	}
-	return false;
+	vData.markAsChanged();
 }
 
 // -----------------------------------------------------------------------------
@@ -699,40 +728,7 @@ MeshVertexData * convertVertices(const MeshVertexData & oldVertices, const Verte
 	if (oldVertexDescription == newVertexDescription)
 		return new MeshVertexData(oldVertices);
 
-	const uint32_t numVertices = oldVertices.getVertexCount();
-	auto newVertices = new MeshVertexData;
-	newVertices->allocate(numVertices, newVertexDescription);
-
-	// Initialize the data with zero.
-	std::fill_n(newVertices->data(), newVertices->dataSize(), 0);
-
-	const std::size_t oldVertexSize = oldVertexDescription.getVertexSize();
-	const std::size_t newVertexSize = newVertexDescription.getVertexSize();
-	for(const auto & oldAttr : oldVertexDescription.getAttributes()) {
-		const VertexAttribute & newAttr = newVertexDescription.getAttribute(oldAttr.getNameId());
-
-		if (oldAttr.empty() || newAttr.empty()) {
-			continue;
-		}
-		if(oldAttr.getDataType() == newAttr.getDataType()) {					
-			uint32_t dataSize = std::min(oldAttr.getDataSize(), newAttr.getDataSize());
-			const uint8_t * source = oldVertices.data() + oldAttr.getOffset();
-			uint8_t * target = newVertices->data() + newAttr.getOffset();
-			for (uint32_t i = 0; i < numVertices; ++i) {
-				std::copy(source, source + dataSize, target);
-				source += oldVertexSize;
-				target += newVertexSize;
-			}			
-		} else if( canConvert(oldAttr, newAttr) ) {
-			auto oldAcc = FloatAttributeAccessor::create(const_cast<MeshVertexData&>(oldVertices), newAttr.getNameId());
-			auto newAcc = FloatAttributeAccessor::create(*newVertices, newAttr.getNameId());
-			for (uint32_t i = 0; i < numVertices; ++i) {
-				newAcc->setValues(i, oldAcc->getValues(i));
-			}
-		}
-	}
-	newVertices->updateBoundingBox();
-	return newVertices;
+	return VertexConversionPlan::get(oldVertexDescription, newVertexDescription)->apply(oldVertices);
 }
 
 // -----------------------------------------------------------------------------
@@ -772,6 +768,24 @@ void removeColorData(Mesh * m) {
 
 // -----------------------------------------------------------------------------
 
+/*! (internal) Build the list of adjacent triangles for every vertex (compressed sparse row layout):
+	The triangles of vertex v are triangles[offsets[v]] ... triangles[offsets[v+1]-1], sorted by their index.
+	Accumulating per-triangle values in this order gives the same (deterministic) result as a serial scatter-add over all triangles. */
+static void buildVertexTriangleLists(const MeshIndexData & indices, uint32_t numTriangles, uint32_t vertexCount,
+		std::vector<uint32_t> & offsets, std::vector<uint32_t> & triangles) {
+	offsets.assign(vertexCount + 1, 0);
+	for(uint32_t i = 0; i < numTriangles * 3; ++i)
+		++offsets[indices[i] + 1];
+	for(uint32_t v = 0; v < vertexCount; ++v)
+		offsets[v + 1] += offsets[v];
+	triangles.resize(offsets[vertexCount]);
+	std::vector<uint32_t> insertPos(offsets.begin(), offsets.end() - 1);
+	for(uint32_t t = 0; t < numTriangles; ++t) {
+		for(uint32_t k = 0; k < 3; ++k)
+			triangles[insertPos[indices[t * 3 + k]]++] = t;
+	}
+}
+
 //! (static)
 void calculateNormals(Mesh * m) {
 	MeshVertexData & vData = m->openVertexData();
@@ -785,35 +799,42 @@ void calculateNormals(Mesh * m) {
 	}
 
 	const uint32_t vertexCount = vData.getVertexCount();
-
-	std::vector<Geometry::Vec3> normals(vertexCount);
-
-	// accumulate normals
 	const MeshIndexData & indices = m->openIndexData();
-	const uint32_t indexCount = m->getIndexCount();
+	const uint32_t numTriangles = m->getIndexCount() / 3;
+
+	// calculate face normals
+	std::vector<Geometry::Vec3> faceNormals(numTriangles);
 	Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vData,VertexAttributeIds::POSITION));
-	for (uint32_t i = 0; i < indexCount-2; i += 3) {
-		// n = cb x ab
-		const Geometry::Vec3 a( positionAccessor->getPosition(indices[i + 0]) );
-		const Geometry::Vec3 b( positionAccessor->getPosition(indices[i + 1]) );
-		const Geometry::Vec3 c( positionAccessor->getPosition(indices[i + 2]) );
-
-		Geometry::Vec3 n( (c-b).cross(a-b) );
-		const float length = n.length();
-		if(length>0)
-			n.normalize();
-		normals[indices[i+0]] += n;
-		normals[indices[i+1]] += n;
-		normals[indices[i+2]] += n;
-	}
-
-	// set normals
+	const PositionAttributeAccessor * positions = positionAccessor.get();
+	parallelFor(numTriangles, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t t = begin; t < end; ++t) {
+			// n = cb x ab
+			const Geometry::Vec3 a( positions->getPosition(indices[t * 3 + 0]) );
+			const Geometry::Vec3 b( positions->getPosition(indices[t * 3 + 1]) );
+			const Geometry::Vec3 c( positions->getPosition(indices[t * 3 + 2]) );
+
+			Geometry::Vec3 n( (c-b).cross(a-b) );
+			const float length = n.length();
+			if(length>0)
+				n.normalize();
+			faceNormals[t] = n;
+		}
+	});
+
+	// accumulate and set normals
+	std::vector<uint32_t> offsets, vertexTriangles;
+	buildVertexTriangleLists(indices, numTriangles, vertexCount, offsets, vertexTriangles);
 	Util::Reference<NormalAttributeAccessor> normalAccessor(NormalAttributeAccessor::create(vData,VertexAttributeIds::NORMAL));
-	for(uint32_t i=0;i<vertexCount;++i){
-		const Geometry::Vec3 n = normals[i];
-		const float length = n.length();
-		normalAccessor->setNormal(i, length>0 ? n/length : n);
-	}
+	NormalAttributeAccessor * normals = normalAccessor.get();
+	parallelFor(vertexCount, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t i = begin; i < end; ++i) {
+			Geometry::Vec3 n;
+			for(uint32_t k = offsets[i]; k < offsets[i + 1]; ++k)
+				n += faceNormals[vertexTriangles[k]];
+			const float length = n.length();
+			normals->setNormal(i, length>0 ? n/length : n);
+		}
+	});
 	vData.markAsChanged();
 }
 
@@ -841,13 +862,24 @@ Mesh * combineMeshes(const std::deque<Mesh *> & meshArray, const std::deque<Geom
 
 	const VertexDescription & vd = firstMesh->getVertexDescription();
 
-	std::deque<Mesh *> meshArray2; //< collect meshes which have the same vertexDescription
-	std::deque<Geometry::Matrix4x4> transformations2; //< collect meshes which have the same vertexDescription
+	//! A source mesh with the same vertexDescription and the slots of its data in the combined mesh
+	struct Part {
+		const MeshVertexData * vertices;
+		const uint32_t * indexData;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t vertexOffset;
+		uint32_t indexOffset;
+		const Geometry::Matrix4x4 * transformation;
+	};
+	std::vector<Part> parts;
+	parts.reserve(meshArray.size());
 
-	//count vertices and indices, check if Meshes exist and have the same vertexDescription
+	// first pass: check if Meshes exist and have the same vertexDescription, make their data local and count vertices and indices
 	uint32_t indexCount = 0;
 	uint32_t vertexCount = 0;
 	{
+		const Geometry::Matrix4x4 noTrans;
 		auto tIt = transformations.begin();
 		for (auto it = meshArray.begin(); it != meshArray.end(); ++it, (tIt != transformations.end() ? ++tIt : tIt)) {
 			if (!(*it)) {
@@ -859,11 +891,19 @@ Mesh * combineMeshes(const std::deque<Mesh *> & meshArray, const std::deque<Geom
 				std::cout << (*it)->getVertexDescription().toString() << ":" << vd.toString() << "\n";
 				continue;
 			}
-			meshArray2.push_back(*it);
-			if (tIt != transformations.end())
-				transformations2.push_back(*tIt);
-			indexCount += (*it)->getIndexCount();
-			vertexCount += (*it)->getVertexCount();
+			const MeshIndexData & currentIndices = (*it)->openIndexData();
+			const MeshVertexData & currentVertices = (*it)->openVertexData();
+			Part part;
+			part.vertices = &currentVertices;
+			part.indexData = currentIndices.data();
+			part.vertexCount = currentVertices.getVertexCount();
+			part.indexCount = currentIndices.getIndexCount();
+			part.vertexOffset = vertexCount;
+			part.indexOffset = indexCount;
+			part.transformation = (tIt != transformations.end() && (*tIt) != noTrans) ? &(*tIt) : nullptr;
+			parts.push_back(part);
+			indexCount += part.indexCount;
+			vertexCount += part.vertexCount;
 		}
 	}
 	// create mesh
@@ -873,31 +913,70 @@ Mesh * combineMeshes(const std::deque<Mesh *> & meshArray, const std::deque<Geom
 	MeshIndexData & indices = mesh->openIndexData();
 	indices.allocate(indexCount);
 
-	// copy data
-
-	uint32_t indexPointer = 0;
-	uint32_t vertexPointer = 0;
+	// the batch kernels can transform the parts in parallel, all other formats are transformed afterwards
+	const VertexAttribute & posAttr = vd.getAttribute(VertexAttributeIds::POSITION);
+	const VertexAttribute & normalAttr = vd.getAttribute(VertexAttributeIds::NORMAL);
+	const bool floatNormals = !normalAttr.empty() && normalAttr.getDataType() == GL_FLOAT && normalAttr.getNumValues() >= 3;
+	const bool byteNormals = !normalAttr.empty() && normalAttr.getDataType() == GL_BYTE && normalAttr.getNumValues() >= 4;
+	const bool kernelFormat = posAttr.getDataType() == GL_FLOAT && posAttr.getNumValues() >= 3 && (normalAttr.empty() || floatNormals || byteNormals);
+	const std::size_t vertexSize = vd.getVertexSize();
+	uint8_t * const targetVertices = vertices.data();
+	uint32_t * const targetIndices = indices.data();
+	std::vector<uint8_t> transformLater(parts.size(), 0);
+
+	// second pass: copy, rebase and transform every part into its slot
+	parallelFor(static_cast<uint32_t>(parts.size()), [&](uint32_t begin, uint32_t end) {
+		for(uint32_t p = begin; p < end; ++p) {
+			const Part & part = parts[p];
+			// add modified indices
+			const uint32_t * source = part.indexData;
+			uint32_t * target = targetIndices + part.indexOffset;
+			const uint32_t offset = part.vertexOffset;
+			for(uint32_t j = 0; j < part.indexCount; ++j)
+				target[j] = source[j] + offset;
+
+			// add vertices (the combined mesh is interleaved)
+			uint8_t * partVertices = targetVertices + part.vertexOffset * vertexSize;
+			const uint8_t * sourceVertices = part.vertices->data();
+			if(part.vertices->getLayout() == MeshVertexData::INTERLEAVED) {
+				std::copy(sourceVertices, sourceVertices + part.vertexCount * vertexSize, partVertices);
+			} else {
+				for(const auto & attr : vd.getAttributes()) {
+					if(attr.empty())
+						continue;
+					const uint8_t * attrSource = sourceVertices + part.vertices->getAttributeOffset(attr);
+					uint8_t * attrTarget = partVertices + attr.getOffset();
+					for(uint32_t i = 0; i < part.vertexCount; ++i, attrSource += attr.getDataSize(), attrTarget += vertexSize)
+						std::memcpy(attrTarget, attrSource, attr.getDataSize());
+				}
+			}
 
-	Geometry::Matrix4x4 noTrans;
-	auto tIt2 = transformations2.cbegin();
-	for (auto it = meshArray2.cbegin(); it != meshArray2.cend(); ++it, (tIt2 != transformations2.cend() ? ++tIt2 : tIt2)) {
-		Mesh * currentMesh = *it;
-		// add modified indices
-		MeshIndexData & currentIndices = currentMesh->openIndexData();
-		for (uint32_t j = 0; j < currentIndices.getIndexCount(); ++j)
-			indices[indexPointer + j] = currentIndices[j] + vertexPointer;
-		indexPointer += currentIndices.getIndexCount();
-
-		// add vertices
-		MeshVertexData & currentVertices = currentMesh->openVertexData();
-		std::copy(currentVertices.data(), currentVertices.data() + currentVertices.dataSize(), vertices[vertexPointer]);
-
-		if (tIt2 != transformations2.cend() && (*tIt2) != noTrans) {
-			transformVertexData(vertices, (*tIt2), vertexPointer, currentVertices.getVertexCount());
+			if(part.transformation == nullptr)
+				continue;
+			const Geometry::Matrix4x4 & transMat = *part.transformation;
+			const bool isAffine = transMat.at(3, 0) == 0.0f && transMat.at(3, 1) == 0.0f && transMat.at(3, 2) == 0.0f && transMat.at(3, 3) == 1.0f;
+			if(!kernelFormat || !isAffine) {
+				transformLater[p] = 1;
+				continue;
+			}
+			const float m[12] = {	transMat.at(0, 0), transMat.at(0, 1), transMat.at(0, 2), transMat.at(0, 3),
+									transMat.at(1, 0), transMat.at(1, 1), transMat.at(1, 2), transMat.at(1, 3),
+									transMat.at(2, 0), transMat.at(2, 1), transMat.at(2, 2), transMat.at(2, 3)};
+			TransformKernels::transformPositions3f(partVertices + posAttr.getOffset(), vertexSize, part.vertexCount, m);
+			if(floatNormals || byteNormals) {
+				const float n[9] = {	m[0], m[1], m[2], m[4], m[5], m[6], m[8], m[9], m[10]	};
+				if(floatNormals)
+					TransformKernels::transformDirections3f(partVertices + normalAttr.getOffset(), vertexSize, part.vertexCount, n);
+				else
+					TransformKernels::transformDirections4b(partVertices + normalAttr.getOffset(), vertexSize, part.vertexCount, n);
+			}
 		}
-		vertexPointer += currentVertices.getVertexCount();
+	}, 16);
+	for(uint32_t p = 0; p < parts.size(); ++p) {
+		if(transformLater[p] != 0)
+			transformVertexData(vertices, *parts[p].transformation, parts[p].vertexOffset, parts[p].vertexCount);
 	}
-	vertices.updateBoundingBox();
+	vertices.invalidateBoundingBox();
 	indices.updateIndexRange();
 
 	return mesh;
@@ -972,68 +1051,147 @@ MeshVertexData * extractVertexData(Mesh * mesh, uint32_t begin, uint32_t length)
 
 // -----------------------------------------------------------------------------
 
-//! (static)
-void eliminateDuplicateVertices(Mesh * mesh) {
-	const VertexDescription & desc = mesh->getVertexDescription();
-	const uint32_t indexCount = mesh->getIndexCount();
-
-	// Set of vertices used to create unique vertices.
-	std::set<RawVertex> rawVertices;
-	// Mapping from old index to new index.
-	std::map<uint32_t, uint32_t> indexReplace;
-
-	// Simply go over the indices and add one vertex after another.
-	{
-		const MeshVertexData & vertices = mesh->openVertexData();
-		const MeshIndexData & indices = mesh->openIndexData();
-		const std::size_t vertexSize = desc.getVertexSize();
-
-		for (uint32_t counter = 0; counter < indexCount; ++counter) {
-			const uint32_t index = indices[counter];
-			const uint8_t * vertex = vertices[index];
-			RawVertex raw(index, vertex, vertexSize);
-			auto it = rawVertices.insert(raw).first;
-			indexReplace.insert(std::make_pair(index, it->getIndex()));
+//! (internal) Return the vertices referenced by the given indices in the order of their first reference.
+static std::vector<uint32_t> collectReferencedVertices(const MeshIndexData & indices, uint32_t vertexCount) {
+	std::vector<bool> referenced(vertexCount, false);
+	std::vector<uint32_t> vertices;
+	for(uint32_t i = 0; i < indices.getIndexCount(); ++i) {
+		const uint32_t index = indices[i];
+		if(!referenced[index]) {
+			referenced[index] = true;
+			vertices.push_back(index);
 		}
 	}
+	return vertices;
+}
 
-	// Mapping from new index to vertex position.
-	std::map<uint32_t, uint32_t> indexPosition;
+/*! (internal) Replace the mesh's data: the new vertex i is a copy of the old vertex <tt>uniqueVertices[i]</tt>,
+	and every index v is replaced by <tt>newIndices[v]</tt>. */
+static void replaceByMergedVertices(Mesh * mesh, const std::vector<uint32_t> & uniqueVertices, const std::vector<uint32_t> & newIndices) {
+	const VertexDescription & desc = mesh->getVertexDescription();
+	const uint32_t indexCount = mesh->getIndexCount();
+	const std::size_t vertexSize = desc.getVertexSize();
 
-	// Create the new mesh and add the rawVertices.
 	Util::Reference<Mesh> result = new Mesh;
 	result->setDataStrategy(mesh->getDataStrategy());
+	result->setFileName(mesh->getFileName());
+	result->setUseIndexData(mesh->isUsingIndexData());
+	result->setDrawMode(mesh->getDrawMode());
 
+	const MeshVertexData & oldVertices = mesh->openVertexData();
 	MeshVertexData & vertices = result->openVertexData();
-	vertices.allocate(rawVertices.size(), desc);
+	vertices.allocate(uniqueVertices.size(), desc);
+	uint8_t * data = vertices.data();
+	for(const auto & index : uniqueVertices) {
+		std::copy(oldVertices[index], oldVertices[index] + vertexSize, data);
+		data += vertexSize;
+	}
 
+	const MeshIndexData & oldIndices = mesh->openIndexData();
 	MeshIndexData & indices = result->openIndexData();
 	indices.allocate(indexCount);
+	for(uint32_t i = 0; i < indexCount; ++i)
+		indices[i] = newIndices[oldIndices[i]];
 
-	{
-		uint8_t * data = vertices.data();
-		uint32_t vertexPos = 0;
-		for(const auto & vertex : rawVertices) {
-			std::copy(vertex.getData(), vertex.getData() + vertex.getSize(), data);
-			data += vertex.getSize();
-			indexPosition.insert(std::make_pair(vertex.getIndex(), vertexPos));
-			++vertexPos;
-		}
-		// Translate the indices.
-		const uint32_t * srcIndex = mesh->openIndexData().data();
-		uint32_t * dstIndex = indices.data();
-		for (uint32_t counter = 0; counter < indexCount; ++counter) {
-			const uint32_t newIndex = indexReplace.find(*srcIndex)->second;
-			*dstIndex = indexPosition.find(newIndex)->second;
-			++srcIndex;
-			++dstIndex;
+	vertices.invalidateBoundingBox();
+	indices.updateIndexRange();
+
+	mesh->swap(*result.get());
+}
+
+/*! (internal) Finish a vertex merge: @p representatives[i] is the position (in @p vertexOrder) of the vertex that vertexOrder[i] is merged into.
+	The representative always has to come first (representatives[i] <= i).
+	@return number of merged vertices. */
+static uint32_t applyVertexMerge(Mesh * mesh, const std::vector<uint32_t> & vertexOrder, const uint32_t * representatives) {
+	const uint32_t oldCount = mesh->getVertexCount();
+	std::vector<uint32_t> newIndices(oldCount, 0);
+	std::vector<uint32_t> uniqueVertices;
+	for(uint32_t i = 0; i < vertexOrder.size(); ++i) {
+		if(representatives[i] == i) {
+			newIndices[vertexOrder[i]] = uniqueVertices.size();
+			uniqueVertices.push_back(vertexOrder[i]);
+		} else {
+			newIndices[vertexOrder[i]] = newIndices[vertexOrder[representatives[i]]];
 		}
 	}
+	replaceByMergedVertices(mesh, uniqueVertices, newIndices);
+	return oldCount - mesh->getVertexCount();
+}
 
-	vertices.updateBoundingBox();
-	indices.updateIndexRange();
+//! (internal) Size of a hash table for the given number of entries (a power of two).
+static uint32_t getHashTableSize(uint32_t numEntries) {
+	uint32_t size = 1;
+	while(size < numEntries && size < (1u << 31))
+		size <<= 1;
+	return size;
+}
 
-	mesh->swap(*result.get());
+//! (internal) FNV-1a hash of a vertex' bytes.
+static uint64_t hashVertexBytes(const uint8_t * data, std::size_t size) {
+	uint64_t hash = 14695981039346656037ull;
+	for(std::size_t i = 0; i < size; ++i) {
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+//! (static)
+void eliminateDuplicateVertices(Mesh * mesh, VertexMergeStatistics * statistics) {
+	Util::Timer timer;
+	timer.reset();
+	const ScratchScope scratch;
+
+	const MeshVertexData & vertices = mesh->openVertexData();
+	const std::size_t vertexSize = mesh->getVertexDescription().getVertexSize();
+	const std::vector<uint32_t> vertexOrder = collectReferencedVertices(mesh->openIndexData(), vertices.getVertexCount());
+	const uint32_t count = vertexOrder.size();
+
+	// hash the vertices' bytes
+	const uint32_t numBuckets = getHashTableSize(count);
+	ScratchVector<uint32_t> buckets(count);
+	parallelFor(count, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t i = begin; i < end; ++i)
+			buckets[i] = static_cast<uint32_t>(hashVertexBytes(vertices[vertexOrder[i]], vertexSize)) & (numBuckets - 1);
+	});
+
+	// sort the vertices into their buckets (stable, so every bucket is ordered by first reference)
+	ScratchVector<uint32_t> bucketOffsets(numBuckets + 1, 0);
+	for(const auto & bucket : buckets)
+		++bucketOffsets[bucket + 1];
+	for(uint32_t b = 0; b < numBuckets; ++b)
+		bucketOffsets[b + 1] += bucketOffsets[b];
+	ScratchVector<uint32_t> bucketEntries(count);
+	{
+		ScratchVector<uint32_t> insertPos(bucketOffsets.begin(), bucketOffsets.end() - 1);
+		for(uint32_t i = 0; i < count; ++i)
+			bucketEntries[insertPos[buckets[i]]++] = i;
+	}
+
+	// equal vertices are always in the same bucket -> the buckets can be processed independently
+	ScratchVector<uint32_t> representatives(count);
+	parallelFor(numBuckets, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t b = begin; b < end; ++b) {
+			for(uint32_t e = bucketOffsets[b]; e < bucketOffsets[b + 1]; ++e) {
+				const uint32_t i = bucketEntries[e];
+				representatives[i] = i;
+				for(uint32_t other = bucketOffsets[b]; other < e; ++other) {
+					const uint32_t j = bucketEntries[other];
+					if(representatives[j] == j && std::memcmp(vertices[vertexOrder[i]], vertices[vertexOrder[j]], vertexSize) == 0) {
+						representatives[i] = j;
+						break;
+					}
+				}
+			}
+		}
+	});
+
+	const uint32_t merged = applyVertexMerge(mesh, vertexOrder, representatives.data());
+	timer.stop();
+	if(statistics != nullptr) {
+		statistics->mergedVertices = merged;
+		statistics->milliseconds = timer.getMilliseconds();
+	}
 }
 
 // -----------------------------------------------------------------------------
@@ -1082,7 +1240,7 @@ Mesh * eliminateUnusedVertices(Mesh * mesh) {
 	for(const auto & oldIndex : usedOldVertices) {
 		std::copy(oldVertexData[oldIndex], oldVertexData[oldIndex] + vSize, newVertexData[i++]);
 	}
-	newVertexData.updateBoundingBox();
+	newVertexData.invalidateBoundingBox();
 
 	return newMesh;
 }
@@ -1091,112 +1249,163 @@ Mesh * eliminateUnusedVertices(Mesh * mesh) {
 
 //! (static)
 Mesh * eliminateLongTriangles(Mesh * mesh, float ratio) {
-	const MeshIndexData & originalIndices = mesh->openIndexData();
-	const MeshVertexData & vertexData = mesh->openVertexData();
-	std::deque<uint32_t> newIndices;
-	const uint32_t indexCount = mesh->getIndexCount();
+	Mesh * newMesh = mesh->clone();
+	filterTriangles(newMesh, {createLongTrianglePredicate(ratio)}, true);
+	return newMesh;
+}
 
-	for (uint32_t counter = 0; counter < indexCount; counter += 3) {
-		Geometry::Vec3 p1(reinterpret_cast<const float*> (vertexData[originalIndices[counter]]));
-		Geometry::Vec3 p2(reinterpret_cast<const float*> (vertexData[originalIndices[counter + 1]]));
-		Geometry::Vec3 p3(reinterpret_cast<const float*> (vertexData[originalIndices[counter + 2]]));
+// -----------------------------------------------------------------------------
 
-		float a2 = (p1 - p2).lengthSquared();
-		float b2 = (p2 - p3).lengthSquared();
-		float c2 = (p1 - p3).lengthSquared();
+Mesh * eliminateTrianglesBehindPlane(Mesh * mesh, const Geometry::Plane & plane) {
+	// use the mesh's BVH if it has already been built
+	const MeshBVH * bvh = MeshBVH::getIfValid(mesh);
+	if(bvh != nullptr) {
+		const MeshIndexData & originalIndices = mesh->openIndexData();
+		const MeshVertexData & vertexData = mesh->openVertexData();
+		std::vector<uint32_t> triangles;
+		bvh->collectTrianglesInFrontOfPlane(plane, triangles);
+		MeshIndexData newIndexData;
+		newIndexData.allocate(triangles.size() * 3);
+		for(uint32_t i = 0; i < triangles.size(); ++i) {
+			for(uint32_t corner = 0; corner < 3; ++corner)
+				newIndexData[i * 3 + corner] = originalIndices[triangles[i] * 3 + corner];
+		}
+		newIndexData.updateIndexRange();
+		return new Mesh(newIndexData, vertexData);
+	}
+	Mesh * newMesh = mesh->clone();
+	filterTriangles(newMesh, {createPlanePredicate(plane)}, false);
+	return newMesh;
+}
 
-		if (a2 == 0.0f || b2 == 0.0f || c2 == 0.0f)
-			continue;
+// -----------------------------------------------------------------------------
+
+Mesh * eliminateZeroAreaTriangles(Mesh * mesh) {
+	Mesh * newMesh = mesh->clone();
+	filterTriangles(newMesh, {createZeroAreaPredicate()}, false);
+	return newMesh;
+}
+
+// -----------------------------------------------------------------------------
 
-		float f = sqrtf(2.0f * (a2 * b2 + b2 * c2 + c2 * a2) - (a2 * a2 + b2 * b2 + c2 * c2));
+TrianglePredicate createLongTrianglePredicate(float ratio) {
+	return [ratio](const Geometry::Vec3 & p1, const Geometry::Vec3 & p2, const Geometry::Vec3 & p3) {
+		const float a2 = (p1 - p2).lengthSquared();
+		const float b2 = (p2 - p3).lengthSquared();
+		const float c2 = (p1 - p3).lengthSquared();
+		if(a2 == 0.0f || b2 == 0.0f || c2 == 0.0f)
+			return false;
 
-		float max = sqrtf(a2 > b2 ? (a2 > c2 ? a2 : c2) : (b2 > c2 ? b2 : c2));
+		const float f = sqrtf(2.0f * (a2 * b2 + b2 * c2 + c2 * a2) - (a2 * a2 + b2 * b2 + c2 * c2));
+		const float max = sqrtf(a2 > b2 ? (a2 > c2 ? a2 : c2) : (b2 > c2 ? b2 : c2));
 		// maximum height of the triangle
-		float h_max = f / (2.0f * max);
+		const float h_max = f / (2.0f * max);
+		return max <= ratio * h_max;
+	};
+}
 
-		if (max > ratio * h_max)
-			continue;
-		newIndices.push_back(originalIndices[counter]);
-		newIndices.push_back(originalIndices[counter + 1]);
-		newIndices.push_back(originalIndices[counter + 2]);
-	}
-	MeshIndexData newIndexData;
-	newIndexData.allocate(newIndices.size());
-	std::copy(newIndices.begin(), newIndices.end(), newIndexData.data());
-	Util::Reference<Mesh> newMesh = new Mesh(newIndexData, vertexData);
-	return eliminateUnusedVertices(newMesh.get());
+TrianglePredicate createPlanePredicate(const Geometry::Plane & plane) {
+	return [plane](const Geometry::Vec3 & a, const Geometry::Vec3 & b, const Geometry::Vec3 & c) {
+		return plane.planeTest(a) >= 0.0f && plane.planeTest(b) >= 0.0f && plane.planeTest(c) >= 0.0f;
+	};
 }
 
-// -----------------------------------------------------------------------------
+TrianglePredicate createZeroAreaPredicate() {
+	return [](const Geometry::Vec3 & a, const Geometry::Vec3 & b, const Geometry::Vec3 & c) {
+		return !Geometry::Triangle<Geometry::Vec3f>(a, b, c).isDegenerate();
+	};
+}
 
-Mesh * eliminateTrianglesBehindPlane(Mesh * mesh, const Geometry::Plane & plane) {
-	const MeshIndexData & originalIndices = mesh->openIndexData();
-	const MeshVertexData & vertexData = mesh->openVertexData();
-	std::deque<uint32_t> newIndices;
-	const uint32_t indexCount = mesh->getIndexCount();
+/*! (internal) Remove the vertices that are not referenced by the mesh's indices. The remaining vertices are
+	moved to the front of the vertex data, so the data is not copied if no vertex is removed.	*/
+static void compactUsedVertices(Mesh * mesh) {
+	static const uint32_t UNUSED = 0xffffffff;
+	const uint32_t vertexCount = mesh->getVertexCount();
+	const MeshIndexData & constIndices = mesh->openIndexData();
+	const uint32_t indexCount = constIndices.getIndexCount();
+	std::vector<uint32_t> newIndices(vertexCount, UNUSED);
+	for(uint32_t i = 0; i < indexCount; ++i)
+		newIndices[constIndices[i]] = 0;
+	uint32_t usedCount = 0;
+	for(auto & newIndex : newIndices) {
+		if(newIndex != UNUSED)
+			newIndex = usedCount++;
+	}
+	if(usedCount == vertexCount)
+		return;
 
-	for (uint_fast32_t counter = 0; counter < indexCount; counter += 3) {
-		const uint32_t & indexA = originalIndices[counter];
-		const uint32_t & indexB = originalIndices[counter + 1];
-		const uint32_t & indexC = originalIndices[counter + 2];
-		{
-			const Geometry::Vec3 vertex(reinterpret_cast<const float *> (vertexData[indexA]));
-			if (plane.planeTest(vertex) < 0.0f) {
-				continue;
-			}
-		}
-		{
-			const Geometry::Vec3 vertex(reinterpret_cast<const float *> (vertexData[indexB]));
-			if (plane.planeTest(vertex) < 0.0f) {
-				continue;
-			}
-		}
-		{
-			const Geometry::Vec3 vertex(reinterpret_cast<const float *> (vertexData[indexC]));
-			if (plane.planeTest(vertex) < 0.0f) {
-				continue;
-			}
-		}
-		newIndices.push_back(indexA);
-		newIndices.push_back(indexB);
-		newIndices.push_back(indexC);
+	MeshVertexData & vertexData = mesh->openVertexData();
+	const VertexDescription description(vertexData.getVertexDescription());
+	const std::size_t vertexSize = description.getVertexSize();
+	uint8_t * data = vertexData.data();
+	for(uint32_t v = 0; v < vertexCount; ++v) {
+		if(newIndices[v] != UNUSED && newIndices[v] != v)
+			std::memcpy(data + newIndices[v] * vertexSize, data + v * vertexSize, vertexSize);
 	}
-	MeshIndexData newIndexData;
-	newIndexData.allocate(newIndices.size());
-	std::copy(newIndices.begin(), newIndices.end(), newIndexData.data());
-	newIndexData.updateIndexRange();
-	return new Mesh(newIndexData, vertexData);
-}
+	vertexData.allocate(usedCount, description);
+	vertexData.invalidateBoundingBox();
 
-// -----------------------------------------------------------------------------
+	MeshIndexData & indices = mesh->openIndexData();
+	uint32_t * indexArray = indices.data();
+	parallelFor(indexCount, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t i = begin; i < end; ++i)
+			indexArray[i] = newIndices[indexArray[i]];
+	});
+	indices.updateIndexRange();
+	indices.markAsChanged();
+}
 
-Mesh * eliminateZeroAreaTriangles(Mesh * mesh) {
-	const MeshIndexData & originalIndices = mesh->openIndexData();
-	const MeshVertexData & vertexData = mesh->openVertexData();
-	const uint32_t indexCount = mesh->getIndexCount();
-	std::vector<uint32_t> newIndices;
-	newIndices.reserve(indexCount);
+uint32_t filterTriangles(Mesh * mesh, const std::vector<TrianglePredicate> & predicates, bool removeUnusedVertices) {
+	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES || !mesh->isUsingIndexData()) {
+		WARN("filterTriangles: The mesh does not consist of indexed triangles.");
+		return 0;
+	}
+	MeshVertexData & vertexData = mesh->openVertexData();
+	const MeshIndexData & constIndices = mesh->openIndexData();
+	const uint32_t triangleCount = constIndices.getIndexCount() / 3;
+	if(triangleCount == 0 || !vertexData.getVertexDescription().hasAttribute(VertexAttributeIds::POSITION))
+		return 0;
 
-	for (uint_fast32_t counter = 0; counter < indexCount; counter += 3) {
-		const uint32_t & indexA = originalIndices[counter];
-		const uint32_t & indexB = originalIndices[counter + 1];
-		const uint32_t & indexC = originalIndices[counter + 2];
-		const Geometry::Triangle<Geometry::Vec3f> triangle(
-						Geometry::Vec3f(reinterpret_cast<const float *>(vertexData[indexA])),
-						Geometry::Vec3f(reinterpret_cast<const float *>(vertexData[indexB])),
-						Geometry::Vec3f(reinterpret_cast<const float *>(vertexData[indexC])));
-
-		if (!triangle.isDegenerate()) {
-			newIndices.push_back(indexA);
-			newIndices.push_back(indexB);
-			newIndices.push_back(indexC);
+	// evaluate all predicates in one pass
+	Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION));
+	const PositionAttributeAccessor * positions = positionAccessor.get();
+	std::vector<uint8_t> keep(triangleCount);
+	parallelFor(triangleCount, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t t = begin; t < end; ++t) {
+			const Geometry::Vec3 a(positions->getPosition(constIndices[t * 3 + 0]));
+			const Geometry::Vec3 b(positions->getPosition(constIndices[t * 3 + 1]));
+			const Geometry::Vec3 c(positions->getPosition(constIndices[t * 3 + 2]));
+			bool kept = true;
+			for(const auto & predicate : predicates) {
+				if(!predicate(a, b, c)) {
+					kept = false;
+					break;
+				}
+			}
+			keep[t] = kept ? 1 : 0;
+		}
+	});
+
+	// compact the indices in place
+	uint32_t keptCount = 0;
+	for(const auto & k : keep)
+		keptCount += k;
+	if(keptCount < triangleCount) {
+		MeshIndexData & indices = mesh->openIndexData();
+		uint32_t * indexArray = indices.data();
+		for(uint32_t t = 0, target = 0; t < triangleCount; ++t) {
+			if(keep[t]) {
+				if(target != t * 3)
+					std::copy(indexArray + t * 3, indexArray + t * 3 + 3, indexArray + target);
+				target += 3;
+			}
 		}
+		indices.allocate(keptCount * 3);
+		indices.updateIndexRange();
 	}
-	MeshIndexData newIndexData;
-	newIndexData.allocate(newIndices.size());
-	std::copy(newIndices.begin(), newIndices.end(), newIndexData.data());
-	newIndexData.updateIndexRange();
-	return new Mesh(newIndexData, vertexData);
+	if(removeUnusedVertices)
+		compactUsedVertices(mesh);
+	return triangleCount - keptCount;
 }
 
 // -----------------------------------------------------------------------------
@@ -1291,7 +1500,7 @@ Mesh * removeSkinsWithHoleCovering(Mesh * mesh, float maxNormalZ, float covering
 	newIndexData.allocate(newIndices.size());
 	std::copy(newIndices.begin(), newIndices.end(), newIndexData.data());
 	newIndexData.updateIndexRange();
-	newVertexData.updateBoundingBox();
+	newVertexData.invalidateBoundingBox();
 	return new Mesh(newIndexData, newVertexData);
 }
 
@@ -1303,7 +1512,7 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 		 * Consider all 1-ring candidates and select the best for fanning.
 		 *
 		 * @param stop Flag which tells if the algorithm has ended.
-		 * @param nextCand Passed from caller.
+		 * @param nextCand Passed from caller (sorted, without duplicates).
 		 * @param stamp Passed from caller.
 		 * @param cacheSize Passed from caller.
 		 * @param cacheTimes Passed from caller.
@@ -1313,8 +1522,8 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 		 * @param cursor Passed from caller.
 		 * @return Number of next vertex.
 		 */
-		static uint32_t getNextVertex(bool & stop, const std::set<uint32_t> & nextCand, const uint32_t stamp, const uint8_t cacheSize,
-				const uint32_t * cacheTimes, const uint_fast16_t * liveTriangles, std::stack<uint32_t> & deadEndStack, const uint32_t numVertices,
+		static uint32_t getNextVertex(bool & stop, const ScratchVector<uint32_t> & nextCand, const uint32_t stamp, const uint8_t cacheSize,
+				const uint32_t * cacheTimes, const uint_fast16_t * liveTriangles, ScratchVector<uint32_t> & deadEndStack, const uint32_t numVertices,
 				uint32_t & cursor) {
 			// Best candidate and priority.
 			bool found = false;
@@ -1356,12 +1565,12 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 		 * @param cursor Passed from caller.
 		 * @return Number of non-local vertex.
 		 */
-		static uint32_t skipDeadEnd(bool & stop, const uint_fast16_t * liveTriangles, std::stack<uint32_t> & deadEndStack,
+		static uint32_t skipDeadEnd(bool & stop, const uint_fast16_t * liveTriangles, ScratchVector<uint32_t> & deadEndStack,
 				const uint32_t numVertices, uint32_t & cursor) {
 			while (!deadEndStack.empty()) {
 				// Next in dead-end stack.
-				uint32_t d = deadEndStack.top();
-				deadEndStack.pop();
+				uint32_t d = deadEndStack.back();
+				deadEndStack.pop_back();
 				// Check for live triangles.
 				if (liveTriangles[d] > 0) {
 					return d;
@@ -1389,46 +1598,51 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 	uint32_t numIndices = mesh->getIndexCount();
 	uint32_t numTriangles = numIndices / 3;
 	MeshIndexData & indices = mesh->openIndexData();
+	const ScratchScope scratch;
+	ScratchArena & arena = scratch.getArena();
 
 	// Build vertex-triangle adjacency.
 	// First pass: Count occurrences.
-	auto occurrences = new uint_fast16_t[numVertices];
+	auto occurrences = arena.allocateArray<uint_fast16_t>(numVertices);
 	std::fill_n(occurrences, numVertices, 0);
 	for (uint32_t i = 0; i < numIndices; ++i) {
 		++occurrences[indices[i]];
 	}
 	// Second pass: Create the offset map.
-	auto offsetMap = new uint32_t[numVertices];
+	auto offsetMap = arena.allocateArray<uint32_t>(numVertices);
 	uint32_t sum = 0;
 	for (uint32_t v = 0; v < numVertices; ++v) {
 		offsetMap[v] = sum;
 		sum += occurrences[v];
 	}
 	// Third pass: Construct triangle lists.
-	auto triangleLists = new uint32_t[sum]; // A
-	auto tmpOffsetMap = new uint32_t[numVertices];
-	std::copy(offsetMap, offsetMap + numVertices, tmpOffsetMap);
-	for (uint32_t i = 0; i < numIndices; ++i) {
-		uint32_t vertex = indices[i];
-		uint32_t offset = tmpOffsetMap[vertex];
-		triangleLists[offset] = i / 3;
-		++tmpOffsetMap[vertex];
+	auto triangleLists = arena.allocateArray<uint32_t>(sum); // A
+	{
+		const ScratchScope tmpScratch;
+		auto tmpOffsetMap = arena.allocateArray<uint32_t>(numVertices);
+		std::copy(offsetMap, offsetMap + numVertices, tmpOffsetMap);
+		for (uint32_t i = 0; i < numIndices; ++i) {
+			uint32_t vertex = indices[i];
+			uint32_t offset = tmpOffsetMap[vertex];
+			triangleLists[offset] = i / 3;
+			++tmpOffsetMap[vertex];
+		}
 	}
-	delete[] tmpOffsetMap;
 
 	// Create per-vertex live triangle count.
-	auto liveTriangles = new uint_fast16_t[numVertices]; // L
+	auto liveTriangles = arena.allocateArray<uint_fast16_t>(numVertices); // L
 	std::copy(occurrences, occurrences + numVertices, liveTriangles);
 	// Create per-vertex caching time stamps.
-	auto cacheTimes = new uint32_t[numVertices]; // C
+	auto cacheTimes = arena.allocateArray<uint32_t>(numVertices); // C
 	std::fill_n(cacheTimes, numVertices, 0);
-	// Create dead-end vertex stack.
-	std::stack<uint32_t> deadEndStack; // D
 	// Create per-triangles emitted flags.
-	auto emitted = new bool[numTriangles]; // E
-	for (uint32_t t = 0; t < numTriangles; ++t) {
-		emitted[t] = false;
-	}
+	auto emitted = arena.allocateArray<bool>(numTriangles); // E
+	std::fill_n(emitted, numTriangles, false);
+	// Create dead-end vertex stack; every emitted index is pushed once.
+	ScratchVector<uint32_t> deadEndStack; // D
+	deadEndStack.reserve(numIndices);
+	// 1-ring of next candidates; the vector is reused by all iterations.
+	ScratchVector<uint32_t> nextCand; // N
 	// Create output buffer.
 	MeshIndexData newIndices;
 	newIndices.allocate(numIndices);
@@ -1442,8 +1656,7 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 
 	bool stop = false;
 	while (!stop) {
-		// 1-ring of next candidates.
-		std::set<uint32_t> nextCand; // N
+		nextCand.clear();
 		uint_fast16_t numNeighbors = occurrences[fanVertex];
 		for (uint_fast16_t i = 0; i < numNeighbors; ++i) {
 			uint32_t t = triangleLists[offsetMap[fanVertex] + i];
@@ -1456,9 +1669,9 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 				*output = v;
 				++output;
 				// Add to dead-end stack.
-				deadEndStack.push(v);
+				deadEndStack.push_back(v);
 				// Register as candidate.
-				nextCand.insert(v);
+				nextCand.push_back(v);
 				// Decrease live triangle count.
 				--liveTriangles[v];
 				// If not in cache
@@ -1473,17 +1686,12 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 			emitted[t] = true;
 
 		}
+		// Visit the candidates in ascending order (ties keep the smallest vertex).
+		std::sort(nextCand.begin(), nextCand.end());
+		nextCand.erase(std::unique(nextCand.begin(), nextCand.end()), nextCand.end());
 		fanVertex = Inner::getNextVertex(stop, nextCand, stamp, _cacheSize, cacheTimes, liveTriangles, deadEndStack, numVertices, cursor);
 	}
 
-	// Clean up.
-	delete[] occurrences;
-	delete[] offsetMap;
-	delete[] triangleLists;
-	delete[] liveTriangles;
-	delete[] cacheTimes;
-	delete[] emitted;
-
 	newIndices.markAsChanged();
 	newIndices.updateIndexRange();
 
@@ -1613,77 +1821,76 @@ void calculateTangentVectors(Mesh * mesh, const Util::StringIdentifier uvName, c
 	const VertexAttribute & uvAttr = vDesc.getAttribute(uvName);
 	const VertexAttribute & tanAttr = vDesc.getAttribute(tangentVecName);
 
-	std::vector<Vec3> tan1(vertices.getVertexCount());
-	std::vector<Vec3> tan2(vertices.getVertexCount());
-
-	for (uint32_t i = 0; i < indices.getIndexCount(); i += 3) {
-		const uint32_t index1 = indices[i];
-		const uint32_t index2 = indices[i + 1];
-		const uint32_t index3 = indices[i + 2];
-
-		const Vec3 pos1(reinterpret_cast<float*> (vertices[index1] + posAttr.getOffset()));
-		const Vec3 pos2(reinterpret_cast<float*> (vertices[index2] + posAttr.getOffset()));
-		const Vec3 pos3(reinterpret_cast<float*> (vertices[index3] + posAttr.getOffset()));
-
-		const Vec2 uv1(reinterpret_cast<float*> (vertices[index1] + uvAttr.getOffset()));
-		const Vec2 uv2(reinterpret_cast<float*> (vertices[index2] + uvAttr.getOffset()));
-		const Vec2 uv3(reinterpret_cast<float*> (vertices[index3] + uvAttr.getOffset()));
-
-		const float x1 = pos2.x() - pos1.x();
-		const float x2 = pos3.x() - pos1.x();
-		const float y1 = pos2.y() - pos1.y();
-		const float y2 = pos3.y() - pos1.y();
-		const float z1 = pos2.z() - pos1.z();
-		const float z2 = pos3.z() - pos1.z();
-
-		const float s1 = uv2.x() - uv1.x();
-		const float s2 = uv3.x() - uv1.x();
-		const float t1 = uv2.y() - uv1.y();
-		const float t2 = uv3.y() - uv1.y();
-
-		const float r = 1.0f / (s1 * t2 - s2 * t1);
-		const Vec3 sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
-		const Vec3 tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
-
-		tan1[index1] += sdir;
-		tan1[index2] += sdir;
-		tan1[index3] += sdir;
-
-		tan2[index1] += tdir;
-		tan2[index2] += tdir;
-		tan2[index3] += tdir;
-	}
+	const uint32_t vertexCount = vertices.getVertexCount();
+	const uint32_t numTriangles = indices.getIndexCount() / 3;
+
+	// per-triangle tangent (sdir) and bitangent (tdir) directions
+	std::vector<Vec3> triangleSDirs(numTriangles);
+	std::vector<Vec3> triangleTDirs(numTriangles);
+	parallelFor(numTriangles, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t t = begin; t < end; ++t) {
+			const uint32_t index1 = indices[t * 3];
+			const uint32_t index2 = indices[t * 3 + 1];
+			const uint32_t index3 = indices[t * 3 + 2];
+
+			const Vec3 pos1(reinterpret_cast<const float*> (vertices[index1] + posAttr.getOffset()));
+			const Vec3 pos2(reinterpret_cast<const float*> (vertices[index2] + posAttr.getOffset()));
+			const Vec3 pos3(reinterpret_cast<const float*> (vertices[index3] + posAttr.getOffset()));
+
+			const Vec2 uv1(reinterpret_cast<const float*> (vertices[index1] + uvAttr.getOffset()));
+			const Vec2 uv2(reinterpret_cast<const float*> (vertices[index2] + uvAttr.getOffset()));
+			const Vec2 uv3(reinterpret_cast<const float*> (vertices[index3] + uvAttr.getOffset()));
+
+			const float x1 = pos2.x() - pos1.x();
+			const float x2 = pos3.x() - pos1.x();
+			const float y1 = pos2.y() - pos1.y();
+			const float y2 = pos3.y() - pos1.y();
+			const float z1 = pos2.z() - pos1.z();
+			const float z2 = pos3.z() - pos1.z();
+
+			const float s1 = uv2.x() - uv1.x();
+			const float s2 = uv3.x() - uv1.x();
+			const float t1 = uv2.y() - uv1.y();
+			const float t2 = uv3.y() - uv1.y();
+
+			const float r = 1.0f / (s1 * t2 - s2 * t1);
+			triangleSDirs[t] = Vec3((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
+			triangleTDirs[t] = Vec3((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
+		}
+	});
 
 	// -----------------------------------------------------------------------------
 
-	if (normalAttr.getDataType() == GL_FLOAT) {
-		for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-			const Vec3 normal(reinterpret_cast<float*> (vertices[i] + normalAttr.getOffset()));
-			const Vec3 & t = tan1[i];
-			const Vec3 tan((t - normal * normal.dot(t)).getNormalized() * 127); // Gram-Schmidt orthogonalize
+	std::vector<uint32_t> offsets, vertexTriangles;
+	buildVertexTriangleLists(indices, numTriangles, vertexCount, offsets, vertexTriangles);
+	const bool floatNormals = normalAttr.getDataType() == GL_FLOAT;
+	if (!floatNormals && normalAttr.getDataType() != GL_BYTE)
+		return;
 
-			int8_t * const tPtr = reinterpret_cast<int8_t*> (vertices[i] + tanAttr.getOffset());
-			int8_t handedness = (normal.cross(t).dot(tan2[i]) < 0.0f) ? -1 : 1; // Calculate handedness
-			tPtr[0] = handedness * static_cast<int8_t> (tan.x());
-			tPtr[1] = handedness * static_cast<int8_t> (tan.y());
-			tPtr[2] = handedness * static_cast<int8_t> (tan.z());
-			tPtr[3] = handedness;
-		}
-	} else if (normalAttr.getDataType() == GL_BYTE) {
-		for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-			const int8_t * nPtr = reinterpret_cast<const int8_t*> (vertices[i] + normalAttr.getOffset());
-			const Vec3 normal((Vec3(nPtr[0], nPtr[1], nPtr[2])).normalize());
-			const Vec3 & t = tan1[i];
+	parallelFor(vertexCount, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i) {
+			Vec3 t, t2;
+			for(uint32_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+				t += triangleSDirs[vertexTriangles[k]];
+				t2 += triangleTDirs[vertexTriangles[k]];
+			}
+			Vec3 normal;
+			if (floatNormals) {
+				normal = Vec3(reinterpret_cast<const float*> (vertices[i] + normalAttr.getOffset()));
+			} else {
+				const int8_t * nPtr = reinterpret_cast<const int8_t*> (vertices[i] + normalAttr.getOffset());
+				normal = Vec3(nPtr[0], nPtr[1], nPtr[2]).normalize();
+			}
 			const Vec3 tan((t - normal * normal.dot(t)).getNormalized() * 127); // Gram-Schmidt orthogonalize
 
 			int8_t * const tPtr = reinterpret_cast<int8_t*> (vertices[i] + tanAttr.getOffset());
-			int8_t handedness = (normal.cross(t).dot(tan2[i]) < 0.0f) ? -1 : 1; // Calculate handedness
+			int8_t handedness = (normal.cross(t).dot(t2) < 0.0f) ? -1 : 1; // Calculate handedness
 			tPtr[0] = handedness * static_cast<int8_t> (tan.x());
 			tPtr[1] = handedness * static_cast<int8_t> (tan.y());
 			tPtr[2] = handedness * static_cast<int8_t> (tan.z());
 			tPtr[3] = handedness;
 		}
-	}
+	});
 }
 
 // -----------------------------------------------------------------------------
@@ -1694,124 +1901,162 @@ inline bool isZero(float f, float tolerance=std::numeric_limits<float>::epsilon(
 
 // -----------------------------------------------------------------------------
 
+//! (internal) Returns true iff RawVertex::interpolate() supports all attributes of the vertex description.
+static bool isInterpolatable(const VertexDescription & vd) {
+	for(const auto & attr : vd.getAttributes()) {
+		switch(attr.empty() ? GL_FLOAT : attr.getDataType()) {
+			case GL_FLOAT:
+			case GL_UNSIGNED_BYTE:
+			case GL_BYTE:
+			case GL_UNSIGNED_SHORT:
+			case GL_SHORT:
+			case GL_UNSIGNED_INT:
+			case GL_INT:
+#ifdef LIB_GL
+			case GL_DOUBLE:
+#endif /* LIB_GL */
+			case GL_BOOL:
+				break;
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+/*! (internal) How a triangle is treated by cutMesh(); the corners are rotated by @p rotation first
+	(corner a is the corner on the plane (SPLIT_ON_VERTEX) or the single corner on its side (SPLIT_EDGES)). */
+struct CutClassification {
+	enum type_t : uint8_t {
+		KEEP,				//!< one triangle, no new vertex
+		SPLIT_ON_VERTEX,	//!< two triangles, one new vertex on the edge bc
+		SPLIT_EDGES			//!< three triangles, two new vertices on the edges ab and ac
+	};
+	type_t type;
+	uint8_t rotation;
+	float blend[2];
+
+	uint32_t getNumNewVertices() const			{	return type == KEEP ? 0 : (type == SPLIT_ON_VERTEX ? 1 : 2);	}
+	uint32_t getNumNewTriangles() const			{	return getNumNewVertices();	}
+};
+
 //!	(static)
-void cutMesh(Mesh* m, const Geometry::Plane& plane, const std::set<uint32_t> tIndices, float tolerance) {
+void cutMesh(Mesh* m, const Geometry::Plane& plane, const TriangleSelection & tIndices, float tolerance) {
 	const VertexDescription & vd = m->getVertexDescription();
 	const VertexAttribute & posAttr = vd.getAttribute(VertexAttributeIds::POSITION);
-	if (posAttr.getDataType() != GL_FLOAT || m->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+	if (posAttr.getDataType() != GL_FLOAT || m->getDrawMode() != Mesh::DRAW_TRIANGLES || !isInterpolatable(vd)) {
 		WARN("cutMesh: Unsupported vertex format.");
 		return;
 	}
 
-	std::deque<SplitTriangle> triangles;
-	std::deque<SplitTriangle> trianglesOut;
-	std::deque<SplitTriangle> trianglesNew;
-	std::vector<RawVertex> vertexArray;
-
 	MeshVertexData & vertices = m->openVertexData();
 	MeshIndexData & indices = m->openIndexData();
-
-	// extract triangles
-	size_t vertexSize = vd.getVertexSize();
-	for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-		auto tmpData = new uint8_t[vertexSize];
-		std::copy(vertices[i], vertices[i] + vertexSize, tmpData);
-		vertexArray.emplace_back(i, tmpData, vertexSize);
-	}
-	uint32_t * iData = indices.data();
-	for (unsigned i = 0; i < indices.getIndexCount(); i += 3)
-		triangles.push_back(SplitTriangle(vertexArray.at(iData[i + 0]), vertexArray.at(iData[i + 1]), vertexArray.at(iData[i + 2])));
-
-	// split triangles intersecting plane
-	uint32_t tIndex = 0;
-	while(!triangles.empty()) {
-		auto t = triangles.front();
-		triangles.pop_front();
-		RawVertex a = t.getRawVertex(0);
-		RawVertex b = t.getRawVertex(1);
-		RawVertex c = t.getRawVertex(2);
-
-		const Geometry::Vec3 va(reinterpret_cast<const float *> (a.getData() + posAttr.getOffset()));
-		const Geometry::Vec3 vb(reinterpret_cast<const float *> (b.getData() + posAttr.getOffset()));
-		const Geometry::Vec3 vc(reinterpret_cast<const float *> (c.getData() + posAttr.getOffset()));
-
-		float pa = plane.planeTest(va);
-		float pb = plane.planeTest(vb);
-		float pc = plane.planeTest(vc);
-
-		if( (pa>=-tolerance && pb>=-tolerance && pc>=-tolerance) || (pa<=tolerance && pb<=tolerance && pc<=tolerance) || (!tIndices.empty() && tIndices.count(tIndex)==0)) {
-			// triangle is completely above/below plane -> keep
-			trianglesOut.push_back(t);
-		} else if (isZero(pa, tolerance) || isZero(pb, tolerance) || isZero(pc, tolerance)){
-			// one point lies on the plane -> split into two triangles
-
-			// reorder vertices s.t. vertex a lies on the plane
-			if(isZero(pb, tolerance)) {
-				std::swap(a, b); std::swap(b, c);
-				std::swap(pa, pb); std::swap(pb, pc);
-			} else if(isZero(pc, tolerance)) {
-				std::swap(a, c); std::swap(b, c);
-				std::swap(pa, pc); std::swap(pb, pc);
-			}
-
-			float blend = std::abs(pb)/(std::abs(pb) + std::abs(pc));
-			RawVertex d = RawVertex::interpolate(b, c, blend, vertexArray.size(), vd);
-			vertexArray.push_back(d);
-			trianglesOut.push_back(SplitTriangle(a, b, d));
-			trianglesNew.push_back(SplitTriangle(a, d, c));
-		} else {
-			// only one point is above/below plane -> split into three triangles
-
-			// reorder vertices s.t. vertex a is the single point above/below the plane
-			if( (pb>=0 && pa<=0 && pc<=0) || (pb<=0 && pa>=0 && pc>=0) ) { // b above/below plane
-				std::swap(a, b); std::swap(b, c);
-				std::swap(pa, pb); std::swap(pb, pc);
-			} else if((pc>=0 && pa<=0 && pb<=0) || (pc<=0 && pa>=0 && pb>=0)) { // c above/below plane
-				std::swap(a, c); std::swap(b, c);
-				std::swap(pa, pc); std::swap(pb, pc);
+	const uint32_t vertexCount = vertices.getVertexCount();
+	const uint32_t numTriangles = indices.getIndexCount() / 3;
+	const size_t vertexSize = vd.getVertexSize();
+	const std::vector<uint32_t> oldIndices(indices.data(), indices.data() + numTriangles * 3);
+	const uint8_t * const oldVertexData = static_cast<const MeshVertexData &>(vertices).data();
+
+	// if the mesh's BVH has already been built, use it to select the triangles crossing the plane
+	std::vector<uint8_t> crossingTriangles;
+	if(const MeshBVH * bvh = MeshBVH::getIfValid(m)) {
+		std::vector<uint32_t> crossing;
+		bvh->collectTrianglesCrossingPlane(plane, tolerance, crossing);
+		crossingTriangles.resize(numTriangles, 0);
+		for(const auto & t : crossing)
+			crossingTriangles[t] = 1;
+	}
+
+	// classify the triangles against the plane
+	std::vector<CutClassification> classes(numTriangles);
+	parallelFor(numTriangles, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t t = begin; t < end; ++t) {
+			CutClassification & cls = classes[t];
+			cls.type = CutClassification::KEEP;
+			cls.rotation = 0;
+			if(!crossingTriangles.empty() && crossingTriangles[t] == 0)
+				continue;
+			float p[3];
+			for(uint_fast8_t k = 0; k < 3; ++k)
+				p[k] = plane.planeTest(Geometry::Vec3(reinterpret_cast<const float *>(oldVertexData + oldIndices[t * 3 + k] * vertexSize + posAttr.getOffset())));
+			const float pa = p[0], pb = p[1], pc = p[2];
+			if( (pa>=-tolerance && pb>=-tolerance && pc>=-tolerance) || (pa<=tolerance && pb<=tolerance && pc<=tolerance) || (!tIndices.empty() && !tIndices.contains(t))) {
+				// triangle is completely above/below plane -> keep
+			} else if (isZero(pa, tolerance) || isZero(pb, tolerance) || isZero(pc, tolerance)) {
+				// one point lies on the plane -> split into two triangles (rotate s.t. vertex a lies on the plane)
+				cls.type = CutClassification::SPLIT_ON_VERTEX;
+				cls.rotation = isZero(pb, tolerance) ? 1 : (isZero(pc, tolerance) ? 2 : 0);
+				const float rb = p[(cls.rotation + 1) % 3], rc = p[(cls.rotation + 2) % 3];
+				cls.blend[0] = std::abs(rb)/(std::abs(rb) + std::abs(rc));
+			} else {
+				// only one point is above/below plane -> split into three triangles (rotate s.t. vertex a is the single point)
+				cls.type = CutClassification::SPLIT_EDGES;
+				if( (pb>=0 && pa<=0 && pc<=0) || (pb<=0 && pa>=0 && pc>=0) ) // b above/below plane
+					cls.rotation = 1;
+				else if((pc>=0 && pa<=0 && pb<=0) || (pc<=0 && pa>=0 && pb>=0)) // c above/below plane
+					cls.rotation = 2;
+				const float ra = p[cls.rotation], rb = p[(cls.rotation + 1) % 3], rc = p[(cls.rotation + 2) % 3];
+				cls.blend[0] = std::abs(ra)/(std::abs(ra) + std::abs(rb));
+				cls.blend[1] = std::abs(ra)/(std::abs(ra) + std::abs(rc));
 			}
-
-			float blend_ab = std::abs(pa)/(std::abs(pa) + std::abs(pb));
-			float blend_ac = std::abs(pa)/(std::abs(pa) + std::abs(pc));
-			RawVertex d_ab = RawVertex::interpolate(a, b, blend_ab, vertexArray.size(), vd);
-			vertexArray.push_back(d_ab);
-			RawVertex d_ac = RawVertex::interpolate(a, c, blend_ac, vertexArray.size(), vd);
-			vertexArray.push_back(d_ac);
-
-			trianglesOut.push_back(SplitTriangle(a, d_ab, d_ac));
-			trianglesNew.push_back(SplitTriangle(d_ab, b, c));
-			trianglesNew.push_back(SplitTriangle(d_ab, c, d_ac));
 		}
-		++tIndex;
-	}
-	for(auto t : trianglesNew)
-		trianglesOut.push_back(t);
-	trianglesNew.clear();
+	});
+
+	// offsets of the new vertices and the additional triangles (appended after the first triangle of every input triangle)
+	std::vector<uint32_t> newVertexOffsets(numTriangles + 1, 0);
+	for(uint32_t t = 0; t < numTriangles; ++t)
+		newVertexOffsets[t + 1] = newVertexOffsets[t] + classes[t].getNumNewVertices();
+	const uint32_t numNewVertices = newVertexOffsets[numTriangles];
+	if(numNewVertices == 0)
+		return;
 
 	// reassemble mesh
-	// - indices
-	uint32_t iCount = trianglesOut.size() * 3;
-	indices.allocate(iCount);
-	for (uint32_t i = 0; i < iCount; i += 3) {
-		SplitTriangle t = trianglesOut.front();
-		trianglesOut.pop_front();
-		indices[i + 0] = t.a.getIndex();
-		indices[i + 1] = t.b.getIndex();
-		indices[i + 2] = t.c.getIndex();
-	}
+	MeshVertexData newVertices;
+	newVertices.allocate(vertexCount + numNewVertices, vd);
+	uint8_t * const newVertexData = newVertices.data();
+	std::copy(oldVertexData, oldVertexData + static_cast<size_t>(vertexCount) * vertexSize, newVertexData);
+	indices.allocate((numTriangles + numNewVertices) * 3); // every new vertex adds one triangle
+	uint32_t * const newIndices = indices.data();
+	parallelFor(numTriangles, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t t = begin; t < end; ++t) {
+			const CutClassification & cls = classes[t];
+			const uint32_t * tri = oldIndices.data() + t * 3;
+			uint32_t * out = newIndices + t * 3;
+			uint32_t * outNew = newIndices + (numTriangles + newVertexOffsets[t]) * 3;
+			if(cls.type == CutClassification::KEEP) {
+				std::copy(tri, tri + 3, out);
+				continue;
+			}
+			const uint32_t ia = tri[cls.rotation], ib = tri[(cls.rotation + 1) % 3], ic = tri[(cls.rotation + 2) % 3];
+			const RawVertex a(ia, oldVertexData + ia * vertexSize, vertexSize);
+			const RawVertex b(ib, oldVertexData + ib * vertexSize, vertexSize);
+			const RawVertex c(ic, oldVertexData + ic * vertexSize, vertexSize);
+			const uint32_t d0 = vertexCount + newVertexOffsets[t];
+			uint8_t * const target0 = newVertexData + static_cast<size_t>(d0) * vertexSize;
+			if(cls.type == CutClassification::SPLIT_ON_VERTEX) {
+				std::copy(b.getData(), b.getData() + vertexSize, target0);
+				RawVertex::interpolate(b, c, cls.blend[0], target0, vd);
+				const uint32_t first[3] = {ia, ib, d0};
+				const uint32_t second[3] = {ia, d0, ic};
+				std::copy(first, first + 3, out);
+				std::copy(second, second + 3, outNew);
+			} else {
+				const uint32_t d1 = d0 + 1;
+				uint8_t * const target1 = target0 + vertexSize;
+				std::copy(a.getData(), a.getData() + vertexSize, target0);
+				RawVertex::interpolate(a, b, cls.blend[0], target0, vd);
+				std::copy(a.getData(), a.getData() + vertexSize, target1);
+				RawVertex::interpolate(a, c, cls.blend[1], target1, vd);
+				const uint32_t first[3] = {ia, d0, d1};
+				const uint32_t second[6] = {d0, ib, ic, d0, ic, d1};
+				std::copy(first, first + 3, out);
+				std::copy(second, second + 6, outNew);
+			}
+		}
+	});
 	indices.updateIndexRange();
-
-	// - vertices
-	vertices.allocate(vertexArray.size(), vd);
-	for (size_t i = 0; i < vertexArray.size(); i++) {
-		std::copy(vertexArray.at(i).getData(), vertexArray.at(i).getData() + vertexSize, vertices[i]);
-	}
-	vertices.updateBoundingBox();
-
-	// cleanup
-	for (auto & rawVertex : vertexArray) {
-		delete[] rawVertex.getData();
-	}
+	vertices.swap(newVertices);
+	vertices.invalidateBoundingBox();
 }
 
 // -----------------------------------------------------------------------------
@@ -1821,23 +2066,15 @@ void cutMesh(Mesh* m, const Geometry::Plane& plane, const std::set<uint32_t> tIn
 #define ADJ_CA 4
 
 inline
-uint8_t getAdjacence(const SplitTriangle& t1, const SplitTriangle& t2, const VertexAttribute & posAttr) {
+uint8_t getAdjacence(const Geometry::Vec3 * t1, const Geometry::Vec3 * t2) {
 	const static float EPS = std::numeric_limits<float>::epsilon()*10;
-	const Geometry::Vec3 va1(reinterpret_cast<const float *> (t1.a.getData() + posAttr.getOffset()));
-	const Geometry::Vec3 vb1(reinterpret_cast<const float *> (t1.b.getData() + posAttr.getOffset()));
-	const Geometry::Vec3 vc1(reinterpret_cast<const float *> (t1.c.getData() + posAttr.getOffset()));
-	const Geometry::Vec3 va2(reinterpret_cast<const float *> (t2.a.getData() + posAttr.getOffset()));
-	const Geometry::Vec3 vb2(reinterpret_cast<const float *> (t2.b.getData() + posAttr.getOffset()));
-	const Geometry::Vec3 vc2(reinterpret_cast<const float *> (t2.c.getData() + posAttr.getOffset()));
+	const Geometry::Vec3 & va1 = t1[0], & vb1 = t1[1], & vc1 = t1[2];
+	const Geometry::Vec3 & va2 = t2[0], & vb2 = t2[1], & vc2 = t2[2];
 
 	bool eq_a = va1.equals(va2, EPS) || va1.equals(vb2, EPS) || va1.equals(vc2, EPS);
 	bool eq_b = vb1.equals(va2, EPS) || vb1.equals(vb2, EPS) || vb1.equals(vc2, EPS);
 	bool eq_c = vc1.equals(va2, EPS) || vc1.equals(vb2, EPS) || vc1.equals(vc2, EPS);
 
-	//std::cout << eq_a << "; " << eq_b << "; " << eq_c << std::endl;
-	//std::cout << va1 << "; " << vb1 << "; " << vc1 << std::endl;
-	//std::cout << va2 << "; " << vb2 << "; " << vc2 << std::endl;
-
 	if(eq_a && eq_b)
 		return ADJ_AB;
 	if(eq_b && eq_c)
@@ -1850,7 +2087,7 @@ uint8_t getAdjacence(const SplitTriangle& t1, const SplitTriangle& t2, const Ver
 // -----------------------------------------------------------------------------
 
 //!	(static)
-void extrudeTriangles(Mesh* m, const Geometry::Vec3& dir, const std::set<uint32_t> tIndices) {
+void extrudeTriangles(Mesh* m, const Geometry::Vec3& dir, const TriangleSelection & tIndices) {
 	const VertexDescription & vd = m->getVertexDescription();
 	const VertexAttribute & posAttr = vd.getAttribute(VertexAttributeIds::POSITION);
 	if (posAttr.getDataType() != GL_FLOAT || m->getDrawMode() != Mesh::DRAW_TRIANGLES) {
@@ -1858,100 +2095,135 @@ void extrudeTriangles(Mesh* m, const Geometry::Vec3& dir, const std::set<uint32_
 		return;
 	}
 
-	std::vector<SplitTriangle> triangles;
-	std::vector<RawVertex> vertexArray;
-
 	MeshVertexData & vertices = m->openVertexData();
 	MeshIndexData & indices = m->openIndexData();
+	const uint32_t vertexCount = vertices.getVertexCount();
+	const uint32_t numTriangles = indices.getIndexCount() / 3;
+	const size_t vertexSize = vd.getVertexSize();
+	const std::vector<uint32_t> oldIndices(indices.data(), indices.data() + numTriangles * 3);
+	const uint8_t * const oldVertexData = static_cast<const MeshVertexData &>(vertices).data();
+
+	std::vector<uint32_t> selected;
+	selected.reserve(tIndices.count());
+	tIndices.forEach([&](uint32_t t) {
+		if(t < numTriangles)
+			selected.push_back(t);
+	});
+	const uint32_t numSelected = static_cast<uint32_t>(selected.size());
+	if(numSelected == 0)
+		return;
 
-	// extract triangles
-	size_t vertexSize = vd.getVertexSize();
-	for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-		auto tmpData = new uint8_t[vertexSize];
-		std::copy(vertices[i], vertices[i] + vertexSize, tmpData);
-		vertexArray.emplace_back(i, tmpData, vertexSize);
-	}
-	uint32_t * iData = indices.data();
-	for (unsigned i = 0; i < indices.getIndexCount(); i += 3)
-		triangles.push_back(SplitTriangle(vertexArray.at(iData[i + 0]), vertexArray.at(iData[i + 1]), vertexArray.at(iData[i + 2])));
-
-
-	// find adjacent triangles
-	std::unordered_map<uint32_t, uint8_t> adjacencies;
-	for(auto ti : tIndices) {
-		if(ti >= triangles.size())
-			continue;
-		adjacencies[ti] = 0;
-		for(auto tj : tIndices) {
-			if(tj >= triangles.size() || ti == tj)
-				continue;
-			uint8_t adj = getAdjacence(triangles[ti], triangles[tj], posAttr);
-			adjacencies[ti] |= adj;
-			//std::cout << ti << "-" << tj << " ab " << ((adj&ADJ_AB)>0) << " bc " << ((adj&ADJ_BC)>0) << " ca " << ((adj&ADJ_CA)>0) << std::endl;
-		}
-	}
-
-	// extrude triangles
-	for(auto ti : tIndices) {
-		if(ti >= triangles.size())
-			continue;
-		RawVertex a = triangles[ti].a;
-		RawVertex b = triangles[ti].b;
-		RawVertex c = triangles[ti].c;
-
-		RawVertex an = RawVertex::move(a, dir, vertexArray.size(), vd);
-		vertexArray.push_back(an);
-		RawVertex bn = RawVertex::move(b, dir, vertexArray.size(), vd);
-		vertexArray.push_back(bn);
-		RawVertex cn = RawVertex::move(c, dir, vertexArray.size(), vd);
-		vertexArray.push_back(cn);
-		triangles[ti].a = an;
-		triangles[ti].b = bn;
-		triangles[ti].c = cn;
-
-		// add new triangles
-		uint8_t adj = adjacencies[ti];
-
-		if( (adj & ADJ_CA) == 0) {
-			triangles.push_back(SplitTriangle(a, an, cn));
-			triangles.push_back(SplitTriangle(a, cn, c));
+	std::vector<Geometry::Vec3> positions(static_cast<size_t>(numSelected) * 3);
+	parallelFor(numSelected, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t i = begin; i < end; ++i) {
+			for(uint_fast8_t k = 0; k < 3; ++k)
+				positions[i * 3 + k] = Geometry::Vec3(reinterpret_cast<const float *>(oldVertexData + oldIndices[selected[i] * 3 + k] * vertexSize + posAttr.getOffset()));
 		}
+	});
 
-		if( (adj & ADJ_AB) == 0) {
-			triangles.push_back(SplitTriangle(b, bn, an));
-			triangles.push_back(SplitTriangle(b, an, a));
+	// find adjacent triangles: only selected triangles having a vertex in a neighboring grid cell are compared
+	const double cellSize = std::numeric_limits<float>::epsilon() * 20.0; // larger than the tolerance of getAdjacence()
+	auto getCell = [cellSize](const Geometry::Vec3 & p, uint_fast8_t dim) {
+		return static_cast<int64_t>(std::floor(std::min(std::max(p[dim] / cellSize, -1.0e18), 1.0e18)));
+	};
+	auto hashCell = [](int64_t x, int64_t y, int64_t z) {
+		return static_cast<uint64_t>(x) * 73856093ull ^ static_cast<uint64_t>(y) * 19349663ull ^ static_cast<uint64_t>(z) * 83492791ull;
+	};
+	std::vector<std::pair<uint64_t, uint32_t>> cellEntries(static_cast<size_t>(numSelected) * 3); // (cell hash, selected triangle)
+	parallelFor(numSelected * 3, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t i = begin; i < end; ++i) {
+			const Geometry::Vec3 & p = positions[i];
+			cellEntries[i] = std::make_pair(hashCell(getCell(p, 0), getCell(p, 1), getCell(p, 2)), i / 3);
 		}
-
-		if( (adj & ADJ_BC) == 0) {
-			triangles.push_back(SplitTriangle(c, cn, bn));
-			triangles.push_back(SplitTriangle(c, bn, b));
+	});
+	std::sort(cellEntries.begin(), cellEntries.end());
+
+	std::vector<uint8_t> adjacencies(numSelected, 0);
+	parallelFor(numSelected, [&](uint32_t begin, uint32_t end) {
+		std::vector<uint32_t> candidates;
+		for(uint32_t i = begin; i < end; ++i) {
+			candidates.clear();
+			for(uint_fast8_t k = 0; k < 3; ++k) {
+				const Geometry::Vec3 & p = positions[i * 3 + k];
+				const int64_t cx = getCell(p, 0), cy = getCell(p, 1), cz = getCell(p, 2);
+				for(int64_t x = cx - 1; x <= cx + 1; ++x) {
+					for(int64_t y = cy - 1; y <= cy + 1; ++y) {
+						for(int64_t z = cz - 1; z <= cz + 1; ++z) {
+							auto range = std::equal_range(cellEntries.begin(), cellEntries.end(), std::make_pair(hashCell(x, y, z), 0u),
+									[](const std::pair<uint64_t, uint32_t> & e1, const std::pair<uint64_t, uint32_t> & e2) { return e1.first < e2.first; });
+							for(auto it = range.first; it != range.second; ++it) {
+								if(it->second != i)
+									candidates.push_back(it->second);
+							}
+						}
+					}
+				}
+			}
+			std::sort(candidates.begin(), candidates.end());
+			candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+			for(const auto j : candidates)
+				adjacencies[i] |= getAdjacence(positions.data() + i * 3, positions.data() + j * 3);
 		}
-	}
-
-	// reassemble mesh
-	// - indices
-	{
-		indices.allocate(triangles.size() * 3);
-		uint32_t i=0;
-		for (auto t : triangles) {
-			indices[i++] = t.a.getIndex();
-			indices[i++] = t.b.getIndex();
-			indices[i++] = t.c.getIndex();
+	}, 1024);
+
+	// offsets of the side triangles of every selected triangle (two per edge without selected neighbor)
+	std::vector<uint32_t> sideOffsets(numSelected + 1, 0);
+	for(uint32_t i = 0; i < numSelected; ++i) {
+		const uint8_t adj = adjacencies[i];
+		sideOffsets[i + 1] = sideOffsets[i] + 2 * (((adj & ADJ_CA) == 0) + ((adj & ADJ_AB) == 0) + ((adj & ADJ_BC) == 0));
+	}
+
+	// extrude triangles: the moved vertices of the i-th selected triangle are vertexCount + 3*i ... +2
+	MeshVertexData newVertices;
+	newVertices.allocate(vertexCount + numSelected * 3, vd);
+	uint8_t * const newVertexData = newVertices.data();
+	std::copy(oldVertexData, oldVertexData + static_cast<size_t>(vertexCount) * vertexSize, newVertexData);
+	indices.allocate((numTriangles + sideOffsets[numSelected]) * 3);
+	uint32_t * const newIndices = indices.data();
+	std::copy(oldIndices.begin(), oldIndices.end(), newIndices);
+	parallelFor(numSelected, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t i = begin; i < end; ++i) {
+			const uint32_t ti = selected[i];
+			const uint32_t a = oldIndices[ti * 3], b = oldIndices[ti * 3 + 1], c = oldIndices[ti * 3 + 2];
+			const uint32_t an = vertexCount + i * 3, bn = an + 1, cn = an + 2;
+			const uint32_t source[3] = {a, b, c};
+			for(uint_fast8_t k = 0; k < 3; ++k) {
+				uint8_t * target = newVertexData + static_cast<size_t>(an + k) * vertexSize;
+				std::copy(oldVertexData + source[k] * vertexSize, oldVertexData + (source[k] + 1) * vertexSize, target);
+				float * posData = reinterpret_cast<float *>(target + posAttr.getOffset());
+				posData[0] += dir.x();
+				posData[1] += dir.y();
+				posData[2] += dir.z();
+			}
+			newIndices[ti * 3] = an;
+			newIndices[ti * 3 + 1] = bn;
+			newIndices[ti * 3 + 2] = cn;
+
+			// add new triangles
+			const uint8_t adj = adjacencies[i];
+			uint32_t * out = newIndices + (numTriangles + sideOffsets[i]) * 3;
+			auto addTriangle = [&out](uint32_t v0, uint32_t v1, uint32_t v2) {
+				*out++ = v0;
+				*out++ = v1;
+				*out++ = v2;
+			};
+			if( (adj & ADJ_CA) == 0) {
+				addTriangle(a, an, cn);
+				addTriangle(a, cn, c);
+			}
+			if( (adj & ADJ_AB) == 0) {
+				addTriangle(b, bn, an);
+				addTriangle(b, an, a);
+			}
+			if( (adj & ADJ_BC) == 0) {
+				addTriangle(c, cn, bn);
+				addTriangle(c, bn, b);
+			}
 		}
-		indices.updateIndexRange();
-	}
-
-	// - vertices
-	vertices.allocate(vertexArray.size(), vd);
-	for (size_t i = 0; i < vertexArray.size(); i++) {
-		std::copy(vertexArray.at(i).getData(), vertexArray.at(i).getData() + vertexSize, vertices[i]);
-	}
-	vertices.updateBoundingBox();
-
-	// cleanup
-	for (auto & rawVertex : vertexArray) {
-		delete[] rawVertex.getData();
-	}
+	});
+	indices.updateIndexRange();
+	vertices.swap(newVertices);
+	vertices.invalidateBoundingBox();
 }
 
 //!	(static)
@@ -1960,244 +2232,322 @@ int32_t getFirstTriangleIntersectingRay(Mesh* m, const Geometry::Ray3& ray) {
 		WARN("getFirstTriangleIntersectingRay: Unsupported vertex format.");
 		return -1;
 	}
-	auto posAcc = PositionAttributeAccessor::create(m->openVertexData(), VertexAttributeIds::POSITION);
-	MeshIndexData & indices = m->openIndexData();
-
-	float tLine, uTri, vTri;
-	int32_t closest = -1;
-	float closestDist = std::numeric_limits<float>::infinity();
-	for(uint32_t i=0; i<indices.getIndexCount(); i+=3) {
-		Geometry::Triangle<Geometry::Vec3> triangle(
-			posAcc->getPosition(indices[i+0]),
-			posAcc->getPosition(indices[i+1]),
-			posAcc->getPosition(indices[i+2]));
-		// TODO: check triangle normal
-		if(Geometry::Intersection::getLineTriangleIntersection(ray, triangle, tLine, uTri, vTri)) {
-			if(tLine >= 0 && tLine < closestDist) {
-				closestDist = tLine;
-				closest = i/3;
-			}
-		}
-	}
-
-	return closest;
+	// TODO: check triangle normal
+	return MeshBVH::get(m)->getFirstIntersectingTriangle(ray);
 }
 
 // -----------------------------------------------------------------------------
 
 
 //! (static)
-uint32_t mergeCloseVertices(Mesh * mesh, float tolerance) {
-	const VertexDescription & desc = mesh->getVertexDescription();
-	const uint32_t indexCount = mesh->getIndexCount();
+uint32_t mergeCloseVertices(Mesh * mesh, float tolerance, VertexMergeStatistics * statistics) {
+	Util::Timer timer;
+	timer.reset();
 
-	auto posAcc = PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION);
-
-	auto comp = [&posAcc, &tolerance](const RawVertex& lhs, const RawVertex& rhs) -> bool {
-		auto v1 = posAcc->getPosition(lhs.getIndex());
-		auto v2 = posAcc->getPosition(rhs.getIndex());
-		if(std::abs(v1.x()-v2.x()) > tolerance)
-			return v1.x() < v2.x();
-		if(std::abs(v1.y()-v2.y()) > tolerance)
-			return v1.y() < v2.y();
-		if(std::abs(v1.z()-v2.z()) > tolerance)
-			return v1.z() < v2.z();
-		return false;
+	MeshVertexData & vertexData = mesh->openVertexData();
+	auto posAcc = PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION);
+	const PositionAttributeAccessor * positionAccessor = posAcc.get();
+	const std::vector<uint32_t> vertexOrder = collectReferencedVertices(mesh->openIndexData(), vertexData.getVertexCount());
+	const uint32_t count = vertexOrder.size();
+
+	// The cells have to be at least as large as the tolerance, so that all close vertices are found in the neighboring cells.
+	// Cells much smaller than the mesh are not useful and could overflow the cell coordinates.
+	const Geometry::Box & bb = vertexData.getBoundingBox();
+	const float cellSize = std::max(std::max(tolerance, bb.getExtentMax() * 1.0e-6f), std::numeric_limits<float>::min());
+	const Geometry::Vec3 origin = bb.getMin();
+
+	typedef std::array<int32_t, 3> cell_t;
+	std::vector<Geometry::Vec3> positions(count);
+	std::vector<cell_t> cells(count);
+	parallelFor(count, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t i = begin; i < end; ++i) {
+			positions[i] = positionAccessor->getPosition(vertexOrder[i]);
+			for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+				const float c = std::floor((positions[i][dim] - origin[dim]) / cellSize);
+				cells[i][dim] = static_cast<int32_t>(std::min(std::max(c, -1.0e9f), 1.0e9f));
+			}
+		}
+	});
+
+	// spatial hash grid: chains of representatives per bucket
+	static const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+	const uint32_t numBuckets = getHashTableSize(count);
+	const auto getBucket = [numBuckets](int32_t x, int32_t y, int32_t z) -> uint32_t {
+		const uint32_t hash = static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(y) * 19349663u ^ static_cast<uint32_t>(z) * 83492791u;
+		return hash & (numBuckets - 1);
 	};
+	std::vector<uint32_t> bucketHeads(numBuckets, NONE);
+	std::vector<uint32_t> nextInBucket(count, NONE);
+	std::vector<uint32_t> representatives(count);
+
+	for(uint32_t i = 0; i < count; ++i) {
+		const Geometry::Vec3 & p = positions[i];
+		const cell_t & cell = cells[i];
+		uint32_t representative = NONE;
+		for(int32_t dx = -1; dx <= 1; ++dx) {
+			for(int32_t dy = -1; dy <= 1; ++dy) {
+				for(int32_t dz = -1; dz <= 1; ++dz) {
+					for(uint32_t j = bucketHeads[getBucket(cell[0] + dx, cell[1] + dy, cell[2] + dz)]; j != NONE; j = nextInBucket[j]) {
+						if(j < representative && std::abs(p.x() - positions[j].x()) <= tolerance
+								&& std::abs(p.y() - positions[j].y()) <= tolerance
+								&& std::abs(p.z() - positions[j].z()) <= tolerance) {
+							representative = j; // prefer the first referenced vertex
+						}
+					}
+				}
+			}
+		}
+		if(representative == NONE) {
+			representatives[i] = i;
+			const uint32_t bucket = getBucket(cell[0], cell[1], cell[2]);
+			nextInBucket[i] = bucketHeads[bucket];
+			bucketHeads[bucket] = i;
+		} else {
+			representatives[i] = representative;
+		}
+	}
 
-	uint32_t oldCount = mesh->getVertexCount();
+	const uint32_t merged = applyVertexMerge(mesh, vertexOrder, representatives.data());
+	timer.stop();
+	if(statistics != nullptr) {
+		statistics->mergedVertices = merged;
+		statistics->milliseconds = timer.getMilliseconds();
+	}
+	return merged;
+}
 
-	// Set of vertices used to create unique vertices.
-	std::set<RawVertex, decltype(comp)> rawVertices(comp);
-	// Mapping from old index to new index.
-	std::map<uint32_t, uint32_t> indexReplace;
+// -----------------------------------------------------------------------------
 
-	// Simply go over the indices and add one vertex after another.
-	{
-		const MeshVertexData & vertices = mesh->openVertexData();
-		const MeshIndexData & indices = mesh->openIndexData();
-		const std::size_t vertexSize = desc.getVertexSize();
-
-		for (uint32_t counter = 0; counter < indexCount; ++counter) {
-			const uint32_t index = indices[counter];
-			const uint8_t * vertex = vertices[index];
-			RawVertex raw(index, vertex, vertexSize);
-			auto it = rawVertices.insert(raw);
-			indexReplace.insert(std::make_pair(index, it.first->getIndex()));
+//! (internal) Disjoint-set forest with union by size and path halving.
+class UnionFind {
+	ScratchVector<uint32_t> parent;
+	ScratchVector<uint32_t> size;
+public:
+	explicit UnionFind(uint32_t count) : parent(count), size(count, 1) {
+		for(uint32_t i = 0; i < count; ++i)
+			parent[i] = i;
+	}
+	uint32_t find(uint32_t x) {
+		while(parent[x] != x) {
+			parent[x] = parent[parent[x]];
+			x = parent[x];
 		}
+		return x;
+	}
+	void unite(uint32_t a, uint32_t b) {
+		a = find(a);
+		b = find(b);
+		if(a == b)
+			return;
+		if(size[a] < size[b])
+			std::swap(a, b);
+		parent[b] = a;
+		size[a] += size[b];
 	}
+};
 
-	// Mapping from new index to vertex position.
-	std::map<uint32_t, uint32_t> indexPosition;
-
-	// Create the new mesh and add the rawVertices.
-	Util::Reference<Mesh> result = new Mesh;
-	result->setDataStrategy(mesh->getDataStrategy());
-	result->setFileName(mesh->getFileName());
-	result->setUseIndexData(mesh->isUsingIndexData());
-	result->setDrawMode(mesh->getDrawMode());
-
-	MeshVertexData & vertices = result->openVertexData();
-	vertices.allocate(rawVertices.size(), desc);
+//! (internal) Hash for integer cell coordinates of a spatial hash grid.
+struct GridCellHash {
+	size_t operator()(const std::array<int64_t, 3> & cell) const {
+		return static_cast<size_t>(cell[0] * 73856093ll ^ cell[1] * 19349663ll ^ cell[2] * 83492791ll);
+	}
+};
 
-	MeshIndexData & indices = result->openIndexData();
-	indices.allocate(indexCount);
+/*! (internal) Unite all (referenced) vertices whose positions are not farther apart than @p distance.
+	A spatial hash grid with a cell size of distance/sqrt(3) is used: the vertices of one cell are always close,
+	and close vertices are at most two cells apart. */
+static void uniteCloseVertices(const Geometry::Vec3 * positions, const std::vector<uint32_t> & vertices,
+		const Geometry::Box & bb, float distance, UnionFind & sets) {
+	typedef std::array<int64_t, 3> cell_t;
+	const uint32_t count = vertices.size();
+	if(!(distance > 0.0f)) {
+		// only vertices at exactly the same position are close
+		std::unordered_map<cell_t, uint32_t, GridCellHash> vertexAtPosition;
+		vertexAtPosition.reserve(count);
+		for(const auto & v : vertices) {
+			cell_t key;
+			for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+				const float value = positions[v][dim] + 0.0f; // -0 -> 0
+				uint32_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				key[dim] = bits;
+			}
+			auto it = vertexAtPosition.insert(std::make_pair(key, v)).first;
+			sets.unite(it->second, v);
+		}
+		return;
+	}
 
-	{
-		uint8_t * data = vertices.data();
-		uint32_t vertexPos = 0;
-		for(const auto & vertex : rawVertices) {
-			std::copy(vertex.getData(), vertex.getData() + vertex.getSize(), data);
-			data += vertex.getSize();
-			indexPosition.insert(std::make_pair(vertex.getIndex(), vertexPos));
-			++vertexPos;
+	const float cellSize = distance / std::sqrt(3.0f);
+	const Geometry::Vec3 origin = bb.getMin();
+	ScratchVector<cell_t> vertexCells(count);
+	parallelFor(count, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t i = begin; i < end; ++i) {
+			for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+				const double c = std::floor((static_cast<double>(positions[vertices[i]][dim]) - origin[dim]) / cellSize);
+				vertexCells[i][dim] = static_cast<int64_t>(std::min(std::max(c, -4.0e18), 4.0e18));
+			}
 		}
-		// Translate the indices.
-		const uint32_t * srcIndex = mesh->openIndexData().data();
-		uint32_t * dstIndex = indices.data();
-		for (uint32_t counter = 0; counter < indexCount; ++counter) {
-			const uint32_t newIndex = indexReplace.find(*srcIndex)->second;
-			*dstIndex = indexPosition.find(newIndex)->second;
-			++srcIndex;
-			++dstIndex;
+	});
+
+	// sort the vertices into their cells (compressed sparse row layout)
+	std::unordered_map<cell_t, uint32_t, GridCellHash> cellIndices;
+	cellIndices.reserve(count);
+	ScratchVector<uint32_t> cellOfVertex(count);
+	ScratchVector<cell_t> cells;
+	for(uint32_t i = 0; i < count; ++i) {
+		auto it = cellIndices.insert(std::make_pair(vertexCells[i], static_cast<uint32_t>(cells.size()))).first;
+		if(it->second == cells.size())
+			cells.push_back(vertexCells[i]);
+		cellOfVertex[i] = it->second;
+	}
+	ScratchVector<uint32_t> cellOffsets(cells.size() + 1, 0);
+	for(const auto & c : cellOfVertex)
+		++cellOffsets[c + 1];
+	for(uint32_t c = 0; c < cells.size(); ++c)
+		cellOffsets[c + 1] += cellOffsets[c];
+	ScratchVector<uint32_t> cellVertices(count);
+	{
+		ScratchVector<uint32_t> insertPos(cellOffsets.begin(), cellOffsets.end() - 1);
+		for(uint32_t i = 0; i < count; ++i)
+			cellVertices[insertPos[cellOfVertex[i]]++] = vertices[i];
+	}
+
+	const float distanceSquared = distance * distance;
+	for(uint32_t c = 0; c < cells.size(); ++c) {
+		const uint32_t first = cellVertices[cellOffsets[c]];
+		for(uint32_t k = cellOffsets[c] + 1; k < cellOffsets[c + 1]; ++k)
+			sets.unite(first, cellVertices[k]);
+
+		for(int64_t dx = -2; dx <= 2; ++dx) {
+			for(int64_t dy = -2; dy <= 2; ++dy) {
+				for(int64_t dz = -2; dz <= 2; ++dz) {
+					const cell_t neighbor = {{cells[c][0] + dx, cells[c][1] + dy, cells[c][2] + dz}};
+					if(!(cells[c] < neighbor)) // handle every pair of cells only once
+						continue;
+					const auto it = cellIndices.find(neighbor);
+					if(it == cellIndices.end())
+						continue;
+					const uint32_t n = it->second;
+					if(sets.find(first) == sets.find(cellVertices[cellOffsets[n]]))
+						continue;
+					bool connected = false;
+					for(uint32_t k = cellOffsets[c]; k < cellOffsets[c + 1] && !connected; ++k) {
+						for(uint32_t l = cellOffsets[n]; l < cellOffsets[n + 1]; ++l) {
+							if((positions[cellVertices[k]] - positions[cellVertices[l]]).lengthSquared() <= distanceSquared) {
+								sets.unite(first, cellVertices[l]);
+								connected = true;
+								break;
+							}
+						}
+					}
+				}
+			}
 		}
 	}
-
-	vertices.updateBoundingBox();
-	indices.updateIndexRange();
-
-	mesh->swap(*result.get());
-
-	return oldCount-mesh->getVertexCount();
 }
 
-// -----------------------------------------------------------------------------
-
 std::deque<Mesh*> splitIntoConnectedComponents(Mesh* mesh, float relDistance/*=0.001*/) {
 	std::deque<Mesh*> result;
-	auto bb = mesh->getBoundingBox();
-	float distance =bb.getDiameter() * relDistance;
+	const Geometry::Box bb = mesh->getBoundingBox();
+	const float distance = bb.getDiameter() * relDistance;
 	
 	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
 		WARN("Mesh is not a triangle mesh.");
 		return result;
 	}
-	
-	struct ConnectedComponent;
-	struct Triangle {
-		uint32_t idx;
-		ConnectedComponent* component;
-		Triangle(uint32_t i) : idx(i), component(nullptr) {}
-	};	
-	struct ConnectedComponent {
-		std::vector<Triangle*> triangles;
-		void join(ConnectedComponent* other) {
-			if(other != this) {
-				if(other->triangles.size() < triangles.size()) {
-					for(auto& t : other->triangles) 
-						t->component = this;
-					triangles.reserve(triangles.size() + other->triangles.size());
-					triangles.insert(triangles.end(), other->triangles.begin(), other->triangles.end());
-					other->triangles.clear();
-				} else {
-					for(auto& t : triangles) 
-						t->component = other;
-					other->triangles.reserve(triangles.size() + other->triangles.size());
-					other->triangles.insert(other->triangles.end(), triangles.begin(), triangles.end());
-					triangles.clear();
-				}
-			}
-		}
-		void add(Triangle* t) {
-			t->component = this;
-			triangles.emplace_back(t);
-		}
-	};
-	struct OctreeEntry : public Geometry::Point<Geometry::Vec3f> {
-		Triangle* triangle;
-		OctreeEntry(const Geometry::Vec3 & p, Triangle* tri) : Geometry::Point<Geometry::Vec3f>(p), triangle(tri) {}
-	};
-	
-	Geometry::PointOctree<OctreeEntry> octree(bb,distance,100);
-	Geometry::Sphere_f searchSphere({0,0,0}, distance);
-	std::vector<std::unique_ptr<ConnectedComponent>> components;
-	std::vector<std::unique_ptr<Triangle>> triangles;
-	triangles.reserve(mesh->getPrimitiveCount());
-	
-	auto triAcc = TriangleAccessor::create(mesh);
-	std::cout << "Identifying connected components " << 0 << "%        ";
-	for(uint32_t i=0; i<mesh->getPrimitiveCount(); ++i) {
-		auto triangle = new Triangle(i);
-		triangles.emplace_back(triangle);
-		auto tri = triAcc->getTriangle(i);
-		for(const auto& pos : {tri.getVertexA(), tri.getVertexB(), tri.getVertexC()}) {
-			searchSphere.setCenter(pos);
-			std::deque<OctreeEntry> points;
-			octree.collectPointsWithinSphere(searchSphere, points);
-			for(auto& point : points) {
-				auto otherTriangle = point.triangle;
-				if(!triangle->component)
-					otherTriangle->component->add(triangle);
-				else
-					otherTriangle->component->join(triangle->component);
-			}
-		}
-		if(!triangle->component) {
-			auto cc = new ConnectedComponent;
-			cc->add(triangle);
-			components.emplace_back(cc);
-		}		
-		for(const auto& pos : {tri.getVertexA(), tri.getVertexB(), tri.getVertexC()}) {
-			octree.insert({pos, triangle});
-		}
-		if(i%1000==0) {
-			std::cout << "\rIdentifying connected components " << (static_cast<float>(i*100)/static_cast<float>(mesh->getPrimitiveCount())) << "%        ";
-		}
+
+	MeshVertexData & vertexData = mesh->openVertexData();
+	const MeshIndexData & indices = mesh->openIndexData();
+	const uint32_t vertexCount = vertexData.getVertexCount();
+	const uint32_t numTriangles = mesh->getIndexCount() / 3;
+	const std::vector<uint32_t> vertices = collectReferencedVertices(indices, vertexCount);
+	const ScratchScope scratch;
+
+	// vertices of a triangle and close vertices are connected
+	UnionFind sets(vertexCount);
+	for(uint32_t t = 0; t < numTriangles; ++t) {
+		sets.unite(indices[t * 3], indices[t * 3 + 1]);
+		sets.unite(indices[t * 3], indices[t * 3 + 2]);
 	}
-	std::cout << "\rIdentifying connected components 100%        " << std::endl;
-	
-	uint32_t cmpCount=0;
-	for(const auto& cc : components) {
-		if(cc->triangles.size() > 0) {
-			++cmpCount;
+	{
+		auto posAcc = PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION);
+		const PositionAttributeAccessor * positionAccessor = posAcc.get();
+		ScratchVector<Geometry::Vec3> positions(vertexCount);
+		parallelFor(vertices.size(), [&](uint32_t begin, uint32_t end) {
+			for(uint32_t i = begin; i < end; ++i)
+				positions[vertices[i]] = positionAccessor->getPosition(vertices[i]);
+		});
+		uniteCloseVertices(positions.data(), vertices, bb, distance, sets);
+	}
+
+	// number the components in the order of their first triangle and count their triangles and vertices
+	static const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+	ScratchVector<uint32_t> componentOfRoot(vertexCount, NONE);
+	ScratchVector<uint32_t> triangleComponents(numTriangles);
+	ScratchVector<uint32_t> triangleCounts;
+	for(uint32_t t = 0; t < numTriangles; ++t) {
+		uint32_t & component = componentOfRoot[sets.find(indices[t * 3])];
+		if(component == NONE) {
+			component = triangleCounts.size();
+			triangleCounts.push_back(0);
 		}
-	}
-	
-	std::cout << "Identifyied " << cmpCount << " components" << std::endl;
-	std::cout << "Creating meshes 0%        ";
-	uint32_t j=0;
-	
-	MeshIndexData tmpIndexData;
-	tmpIndexData.allocate(1);
-	MeshVertexData vertexData(mesh->openVertexData());
-	Mesh tmpMesh(tmpIndexData, vertexData);
-	tmpMesh.setDataStrategy(mesh->getDataStrategy());
-	tmpMesh.setDrawMode(mesh->getDrawMode());
-	tmpMesh.setUseIndexData(true);
-	
-	for(const auto& cc : components) {
-		if(cc->triangles.size() > 0) {
-			MeshIndexData indexData;
-			indexData.allocate(cc->triangles.size()*3);
-			uint32_t i=0;
-			for(auto t : cc->triangles) {
-				auto triIdx = triAcc->getIndices(t->idx);
-				indexData[i++] = std::get<0>(triIdx);
-				indexData[i++] = std::get<1>(triIdx);
-				indexData[i++] = std::get<2>(triIdx);
+		triangleComponents[t] = component;
+		++triangleCounts[component];
+	}
+	const uint32_t numComponents = triangleCounts.size();
+	ScratchVector<uint32_t> vertexCounts(numComponents, 0);
+	for(const auto & v : vertices)
+		++vertexCounts[componentOfRoot[sets.find(v)]];
+
+	// create the component meshes with their final size and fill them in one pass;
+	// the vertices are stored in the order of their first use (like eliminateUnusedVertices() does)
+	const VertexDescription & desc = vertexData.getVertexDescription();
+	const std::size_t vertexSize = desc.getVertexSize();
+	ScratchVector<Mesh *> components(numComponents);
+	for(uint32_t c = 0; c < numComponents; ++c)
+		components[c] = new Mesh(desc, vertexCounts[c], triangleCounts[c] * 3);
+	ScratchVector<uint32_t> usedVertices(numComponents, 0);
+	ScratchVector<uint32_t> usedIndices(numComponents, 0);
+	ScratchVector<uint32_t> newVertexIndices(vertexCount, NONE);
+	for(uint32_t t = 0; t < numTriangles; ++t) {
+		const uint32_t c = triangleComponents[t];
+		MeshIndexData & newIndices = components[c]->_getIndexData();
+		for(uint32_t corner = 0; corner < 3; ++corner) {
+			const uint32_t oldIndex = indices[t * 3 + corner];
+			if(newVertexIndices[oldIndex] == NONE) {
+				newVertexIndices[oldIndex] = usedVertices[c]++;
+				std::copy(vertexData[oldIndex], vertexData[oldIndex] + vertexSize, components[c]->_getVertexData()[newVertexIndices[oldIndex]]);
 			}
-			tmpMesh.openIndexData().swap(indexData);
-			result.push_back(eliminateUnusedVertices(&tmpMesh));
-			std::cout << "\rCreating meshes " << (static_cast<float>(++j*100)/static_cast<float>(cmpCount)) << "%        ";
+			newIndices[usedIndices[c]++] = newVertexIndices[oldIndex];
 		}
 	}
-	std::cout << "\rCreating meshes 100%        " << std::endl; 
-	
+	for(auto component : components) {
+		component->_getVertexData().invalidateBoundingBox();
+		component->_getIndexData().updateIndexRange();
+		result.push_back(component);
+	}
 	return result;
 }
 
 // -----------------------------------------------------------------------------
 
+//! (static, internal) Mark the runs of vertices with a set flag as changed, so only they are uploaded again.
+static void markChangedVertices(MeshVertexData & vData, const std::vector<uint8_t> & changed) {
+	const uint32_t count = static_cast<uint32_t>(changed.size());
+	for(uint32_t i = 0; i < count; ++i) {
+		if(changed[i] == 0)
+			continue;
+		const uint32_t first = i;
+		while(i < count && changed[i] != 0)
+			++i;
+		vData.markAsChanged(first, i - first);
+	}
+}
+
+//! Number of vertices processed together by the deformers; the per-vertex values are computed in small arrays.
+static const uint32_t DEFORMER_BLOCK_SIZE = 64;
+
 void applyDisplacementMap(Mesh* mesh, Util::PixelAccessor* displaceAcc, float scale, bool clampToEdge) {
 	if(!mesh || !displaceAcc) {
 		return;
@@ -2210,19 +2560,46 @@ void applyDisplacementMap(Mesh* mesh, Util::PixelAccessor* displaceAcc, float sc
 	const uint32_t width = displaceAcc->getWidth();
 	const uint32_t height = displaceAcc->getHeight();
 	auto& vData = mesh->openVertexData();
-	auto pAcc(PositionAttributeAccessor::create(vData, VertexAttributeIds::POSITION));
-	auto tcAcc(TexCoordAttributeAccessor::create(vData, VertexAttributeIds::TEXCOORD0));
-	auto nAcc(NormalAttributeAccessor::create(vData, VertexAttributeIds::NORMAL));
-	for(uint32_t i=0; i<mesh->getVertexCount(); ++i) {
-		auto pos = pAcc->getPosition(i);
-		auto tc = tcAcc->getCoordinate(i);
-		auto n = nAcc->getNormal(i);
-		uint32_t px = clampToEdge ? std::max(0, std::min<int32_t>(width-1, tc.x()*width)) : ((tc.x() - std::floor(tc.x())) * width);
-		uint32_t py = clampToEdge ? std::max(0, std::min<int32_t>(height-1, tc.y()*height)) : ((tc.y() - std::floor(tc.y())) * height);
-		auto value = displaceAcc->readSingleValueFloat(px, py) * scale;
-		pAcc->setPosition(i, pos + n * value);
-	}
-	vData.markAsChanged();
+	// the accessors only reference the (now unshared) data, so they can be used by several threads for different vertices
+	Util::Reference<PositionAttributeAccessor> pAcc(PositionAttributeAccessor::create(vData, VertexAttributeIds::POSITION));
+	Util::Reference<TexCoordAttributeAccessor> tcAcc(TexCoordAttributeAccessor::create(vData, VertexAttributeIds::TEXCOORD0));
+	Util::Reference<NormalAttributeAccessor> nAcc(NormalAttributeAccessor::create(vData, VertexAttributeIds::NORMAL));
+	const uint32_t vertexCount = vData.getVertexCount();
+	std::vector<uint8_t> changed(vertexCount, 0);
+	parallelFor(vertexCount, [&](uint32_t begin, uint32_t end) {
+		float u[DEFORMER_BLOCK_SIZE], v[DEFORMER_BLOCK_SIZE];
+		uint32_t px[DEFORMER_BLOCK_SIZE], py[DEFORMER_BLOCK_SIZE];
+		for(uint32_t first = begin; first < end; first += DEFORMER_BLOCK_SIZE) {
+			const uint32_t count = std::min(DEFORMER_BLOCK_SIZE, end - first);
+			for(uint32_t j = 0; j < count; ++j) {
+				const auto tc = tcAcc->getCoordinate(first + j);
+				u[j] = tc.x();
+				v[j] = tc.y();
+			}
+			// pixel coordinates of the whole block
+			if(clampToEdge) {
+				for(uint32_t j = 0; j < count; ++j) {
+					px[j] = static_cast<uint32_t>(std::max(0, std::min<int32_t>(width-1, u[j]*width)));
+					py[j] = static_cast<uint32_t>(std::max(0, std::min<int32_t>(height-1, v[j]*height)));
+				}
+			} else {
+				for(uint32_t j = 0; j < count; ++j) {
+					px[j] = static_cast<uint32_t>((u[j] - std::floor(u[j])) * width);
+					py[j] = static_cast<uint32_t>((v[j] - std::floor(v[j])) * height);
+				}
+			}
+			for(uint32_t j = 0; j < count; ++j) {
+				const float value = displaceAcc->readSingleValueFloat(px[j], py[j]) * scale;
+				if(value == 0)
+					continue;
+				const uint32_t i = first + j;
+				pAcc->setPosition(i, pAcc->getPosition(i) + nAcc->getNormal(i) * value);
+				changed[i] = 1;
+			}
+		}
+	});
+	// only the displaced vertices are uploaded again (e.g. when a brush region is applied)
+	markChangedVertices(vData, changed);
 }
 
 // -----------------------------------------------------------------------------
@@ -2237,20 +2614,46 @@ void applyNoise(Mesh* mesh, float noiseScale, const Geometry::Matrix4x4& transfo
 		return;
 	}
 	
-	Util::NoiseGenerator gen(seed);
+	const Util::NoiseGenerator gen(seed);
 	
 	auto& vData = mesh->openVertexData();
-	auto pAcc(PositionAttributeAccessor::create(vData, VertexAttributeIds::POSITION));
-	auto nAcc(NormalAttributeAccessor::create(vData, VertexAttributeIds::NORMAL));
-	for(uint32_t i=0; i<mesh->getVertexCount(); ++i) {
-		auto pos = pAcc->getPosition(i);
-		auto tPos = transform.transformPosition(pos);
-		auto n = nAcc->getNormal(i);
-		auto value = gen.get(tPos.x(), tPos.y(), tPos.z()) * noiseScale;
-		pAcc->setPosition(i, pos + n * value);
-	}
+	Util::Reference<PositionAttributeAccessor> pAcc(PositionAttributeAccessor::create(vData, VertexAttributeIds::POSITION));
+	Util::Reference<NormalAttributeAccessor> nAcc(NormalAttributeAccessor::create(vData, VertexAttributeIds::NORMAL));
+	const bool isAffine = transform.at(3, 0) == 0.0f && transform.at(3, 1) == 0.0f && transform.at(3, 2) == 0.0f && transform.at(3, 3) == 1.0f;
+	const float m[12] = {	transform.at(0, 0), transform.at(0, 1), transform.at(0, 2), transform.at(0, 3),
+							transform.at(1, 0), transform.at(1, 1), transform.at(1, 2), transform.at(1, 3),
+							transform.at(2, 0), transform.at(2, 1), transform.at(2, 2), transform.at(2, 3)};
+	parallelFor(vData.getVertexCount(), [&](uint32_t begin, uint32_t end) {
+		float tPos[DEFORMER_BLOCK_SIZE][3];
+		float value[DEFORMER_BLOCK_SIZE];
+		for(uint32_t first = begin; first < end; first += DEFORMER_BLOCK_SIZE) {
+			const uint32_t count = std::min(DEFORMER_BLOCK_SIZE, end - first);
+			for(uint32_t j = 0; j < count; ++j) {
+				const auto pos = pAcc->getPosition(first + j);
+				if(isAffine) {
+					tPos[j][0] = pos.x();
+					tPos[j][1] = pos.y();
+					tPos[j][2] = pos.z();
+				} else {
+					const auto t = transform.transformPosition(pos);
+					tPos[j][0] = t.x();
+					tPos[j][1] = t.y();
+					tPos[j][2] = t.z();
+				}
+			}
+			// transform the whole block with the batch kernel
+			if(isAffine)
+				TransformKernels::transformPositions3f(reinterpret_cast<uint8_t*>(tPos), sizeof(tPos[0]), count, m);
+			for(uint32_t j = 0; j < count; ++j)
+				value[j] = gen.get(tPos[j][0], tPos[j][1], tPos[j][2]) * noiseScale;
+			for(uint32_t j = 0; j < count; ++j) {
+				const uint32_t i = first + j;
+				pAcc->setPosition(i, pAcc->getPosition(i) + nAcc->getNormal(i) * value[j]);
+			}
+		}
+	});
 	vData.markAsChanged();
-	vData.updateBoundingBox();
+	vData.invalidateBoundingBox();
 }
 
 // -----------------------------------------------------------------------------
@@ -2259,18 +2662,40 @@ void flattenMesh(Mesh* mesh, const Geometry::Vec3& pos, float radius, float fall
 	using namespace Geometry;
 	if(!mesh) return;
 	auto& vData = mesh->openVertexData();
-	auto pAcc(PositionAttributeAccessor::create(vData, VertexAttributeIds::POSITION));
-	for(uint32_t i=0; i<mesh->getVertexCount(); ++i) {
-		auto p = pAcc->getPosition(i);
-		float d = pos.distance(p);
-		if(d <= radius) {
-			p.y(pos.y());
-		} else if(d < radius+falloff) {
-			float b = (d-radius)/falloff;
-			p.y(Interpolation::cubicBezier(pos.y(),pos.y(),p.y(), p.y(), b));
+	Util::Reference<PositionAttributeAccessor> pAcc(PositionAttributeAccessor::create(vData, VertexAttributeIds::POSITION));
+	const uint32_t vertexCount = vData.getVertexCount();
+	std::vector<uint8_t> changed(vertexCount, 0);
+	parallelFor(vertexCount, [&](uint32_t begin, uint32_t end) {
+		float x[DEFORMER_BLOCK_SIZE], y[DEFORMER_BLOCK_SIZE], z[DEFORMER_BLOCK_SIZE], d[DEFORMER_BLOCK_SIZE];
+		for(uint32_t first = begin; first < end; first += DEFORMER_BLOCK_SIZE) {
+			const uint32_t count = std::min(DEFORMER_BLOCK_SIZE, end - first);
+			for(uint32_t j = 0; j < count; ++j) {
+				const auto p = pAcc->getPosition(first + j);
+				x[j] = p.x();
+				y[j] = p.y();
+				z[j] = p.z();
+			}
+			// distances of the whole block
+			for(uint32_t j = 0; j < count; ++j) {
+				const float dx = x[j] - pos.x(), dy = y[j] - pos.y(), dz = z[j] - pos.z();
+				d[j] = std::sqrt(dx * dx + dy * dy + dz * dz);
+			}
+			for(uint32_t j = 0; j < count; ++j) {
+				if(d[j] <= radius) {
+					y[j] = pos.y();
+				} else if(d[j] < radius+falloff) {
+					const float b = (d[j]-radius)/falloff;
+					y[j] = Interpolation::cubicBezier(pos.y(),pos.y(),y[j], y[j], b);
+				} else {
+					continue;
+				}
+				const uint32_t i = first + j;
+				pAcc->setPosition(i, Vec3(x[j], y[j], z[j]));
+				changed[i] = 1;
+			}
 		}
-		pAcc->setPosition(i, p);
-	}
+	});
+	markChangedVertices(vData, changed);
 }
 
 // -----------------------------------------------------------------------------
@@ -2279,8 +2704,20 @@ float computeSurfaceArea(Mesh* mesh) {
 	if(!mesh || mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) return 0;
 	auto tAcc = TriangleAccessor::create(mesh);
 	float area = 0;
-	for(uint32_t i=0; i<mesh->getPrimitiveCount(); ++i) 
-		area += tAcc->getTriangle(i).calcArea();
+	TriangleAccessor::TriangleBlock block;
+	float blockArea[TriangleAccessor::TriangleBlock::SIZE];
+	for(uint32_t first = 0; first < tAcc->getTriangleCount(); first += block.count) {
+		tAcc->getTriangles(first, block);
+		// |(b-a) x (c-a)| / 2
+		for(uint32_t i = 0; i < block.count; ++i) {
+			const float ux = block.x[1][i] - block.x[0][i], uy = block.y[1][i] - block.y[0][i], uz = block.z[1][i] - block.z[0][i];
+			const float vx = block.x[2][i] - block.x[0][i], vy = block.y[2][i] - block.y[0][i], vz = block.z[2][i] - block.z[0][i];
+			const float cx = uy * vz - uz * vy, cy = uz * vx - ux * vz, cz = ux * vy - uy * vx;
+			blockArea[i] = 0.5f * std::sqrt(cx * cx + cy * cy + cz * cz);
+		}
+		for(uint32_t i = 0; i < block.count; ++i)
+			area += blockArea[i];
+	}
 	return area;
 }
 
@@ -2330,7 +2767,8 @@ void copyVertices(Rendering::Mesh* source, Rendering::Mesh* target, uint32_t sou
 	uint32_t tgtStart = targetOffset*vd.getVertexSize();
 	uint32_t srcEnd = (sourceOffset + count)*vd.getVertexSize();
 		
-	if(srcVertices.isUploaded() && tgtVertices.isUploaded()) {
+	// a target buffer shared with a copy of the target mesh must not be written
+	if(srcVertices.isUploaded() && tgtVertices.isUploaded() && tgtVertices.getSharedBufferSize() == 0) {
 		BufferObject srcBO;
 		BufferObject tgtBO;
 		srcVertices._swapBufferObject(srcBO);
@@ -2339,14 +2777,16 @@ void copyVertices(Rendering::Mesh* source, Rendering::Mesh* target, uint32_t sou
 		srcVertices._swapBufferObject(srcBO);
 		tgtVertices._swapBufferObject(tgtBO);
 		tgtVertices.releaseLocalData();
-	} else if(srcVertices.hasLocalData() && !tgtVertices.hasLocalData()) {
-		tgtVertices.download();
-	} else if(!srcVertices.hasLocalData() && tgtVertices.hasLocalData()) {
-		srcVertices.download();
+	} else {
+		if(!srcVertices.hasLocalData())
+			srcVertices.download();
+		if(!tgtVertices.hasLocalData())
+			tgtVertices.download();
 	}
 	
 	if(srcVertices.hasLocalData() && tgtVertices.hasLocalData()) {
-		std::copy(srcVertices.data() + srcStart, srcVertices.data() + srcEnd, tgtVertices.data() + tgtStart);
+		const uint8_t * srcData = static_cast<const MeshVertexData &>(srcVertices).data(); // keeps shared source data shared
+		std::copy(srcData + srcStart, srcData + srcEnd, tgtVertices.data() + tgtStart);
 		tgtVertices.markAsChanged();
 	}
 	
@@ -11,10 +11,12 @@
 #ifndef MESHUTILS_H
 #define MESHUTILS_H
 
+#include "TriangleSelection.h"
 #include <Geometry/Matrix4x4.h>
 
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <utility>
 #include <vector>
 #include <set>
@@ -101,6 +103,7 @@ void calculateTextureCoordinates_projection( Mesh * mesh, Util::StringIdentifier
  * Combine several meshes into a single mesh.
  *
  * @note All meshes must have the same VertexDescription.
+ * @note The combined mesh is allocated once; the source meshes are then copied (and transformed) in parallel.
  * @author Claudius Jaehn
  * @author Stefan Arens
  * @author Paul Justus
@@ -143,17 +146,26 @@ const VertexDescription & newVertexDescription);
 void copyVertexAttribute(Mesh * mesh, Util::StringIdentifier from, Util::StringIdentifier to);
 
 
+//! Result of eliminateDuplicateVertices() and mergeCloseVertices().
+struct VertexMergeStatistics {
+	uint32_t mergedVertices = 0;
+	double milliseconds = 0.0;
+};
+
 /**
  * Remove vertices which are equal to each other from the mesh and
  * store them only once. The indices to the vertices are adjusted.
- * This function has runtime O(n * log(n)) where n is the
+ * The vertices are compared byte-wise using a hash table whose buckets are
+ * processed in parallel; the expected runtime is O(n) where n is the
  * number of vertices in @a mesh.
+ * Unreferenced vertices are removed; the remaining vertices are stored in the order of their first reference.
  *
  * @param mesh Mesh to do the elimination on.
+ * @param statistics If not null, the number of merged vertices and the time spent are stored there.
  *
  * @author Benjamin Eikel
  */
-void eliminateDuplicateVertices(Mesh * mesh);
+void eliminateDuplicateVertices(Mesh * mesh, VertexMergeStatistics * statistics = nullptr);
 
 /**
  * Clone the given mesh but remove all vertices which are
@@ -164,7 +176,7 @@ Mesh * eliminateUnusedVertices(Mesh * mesh);
 /**
  * Deletes long triangles (whose ratio between the longest side and
  * the corresponding height is > ratio).
- * \note Calls eliminateUnusedVertices to remove unused vertices.
+ * \note Removes the unused vertices (see filterTriangles()).
  */
 Mesh * eliminateLongTriangles(Mesh * mesh, float ratio);
 
@@ -174,6 +186,7 @@ Mesh * eliminateLongTriangles(Mesh * mesh, float ratio);
  * @param mesh Source mesh. The mesh is not changed.
  * @param plane Plane that is used for cutting off vertices.
  * @return New mesh
+ * @note If the mesh's MeshBVH has already been built, it is used to select the triangles.
  */
 Mesh * eliminateTrianglesBehindPlane(Mesh * mesh, const Geometry::Plane & plane);
 
@@ -185,6 +198,34 @@ Mesh * eliminateTrianglesBehindPlane(Mesh * mesh, const Geometry::Plane & plane)
  */
 Mesh * eliminateZeroAreaTriangles(Mesh * m);
 
+//! Returns false if the triangle with the given corner positions should be removed by filterTriangles().
+typedef std::function<bool (const Geometry::Vec3 &, const Geometry::Vec3 &, const Geometry::Vec3 &)> TrianglePredicate;
+
+//! Keeps the triangles kept by eliminateLongTriangles().
+TrianglePredicate createLongTrianglePredicate(float ratio);
+//! Keeps the triangles whose vertices all lie on or in front of the given plane (see eliminateTrianglesBehindPlane()).
+TrianglePredicate createPlanePredicate(const Geometry::Plane & plane);
+//! Keeps the triangles that are not degenerate (see eliminateZeroAreaTriangles()).
+TrianglePredicate createZeroAreaPredicate();
+
+/**
+ * Remove all triangles of the mesh for which at least one of the given predicates returns false.
+ * In contrast to calling several eliminate...() functions one after another, the predicates are evaluated
+ * in a single parallel pass over the triangles, and the index data (and optionally the vertex data) is
+ * compacted only once, in place: no new Mesh is created.
+ * \code
+ * MeshUtils::filterTriangles(scan, {	MeshUtils::createZeroAreaPredicate(),
+ *									MeshUtils::createLongTrianglePredicate(10.0f),
+ *									MeshUtils::createPlanePredicate(groundPlane) });
+ * \endcode
+ *
+ * @param mesh Indexed triangle mesh that is changed in place.
+ * @param removeUnusedVertices If true, the vertices that are no longer referenced are removed; the remaining
+ *			vertices keep their relative order.
+ * @return The number of removed triangles.
+ */
+uint32_t filterTriangles(Mesh * mesh, const std::vector<TrianglePredicate> & predicates, bool removeUnusedVertices = true);
+
 /**
  *Estimate the max. side length of the polygon in the mesh m
 */
@@ -203,6 +244,7 @@ float getLongestSideLength(Mesh * m);
  * @param cacheSize Post-transform vertex cache size to optimize
  * for. This parameter is called @c k in the article.
  * @see http://doi.acm.org/10.1145/1276377.1276489
+ * @see VertexCacheOptimization for Forsyth's algorithm, overdraw and vertex fetch optimization
  * @author Benjamin Eikel
  */
 void optimizeIndices(Mesh * mesh, const uint_fast8_t cacheSize =	24);
@@ -268,14 +310,18 @@ void setMaterial(Mesh * mesh, const Util::Color4f & ambient, const Util::Color4f
 
 
 /**
- * converts normals from 3 * GL_FLOAT to 4 * GL_BYTE if present
+ * converts normals from 3 * GL_FLOAT to 4 * GL_BYTE (or one packed GL_INT_2_10_10_10_REV value) if present
  * converts colors from (3 or 4) * GL_FLOAT to 4 * GL_UNSIGNED_BYTE if present
  * optionally converts position from (3 or 4) * GL_FLOAT to 4 * GL_HALF_FLOAT
+ * optionally converts texture coordinates from 2 * GL_FLOAT to 2 * GL_HALF_FLOAT
+ * With all options, a vertex with position, normal and texture coordinate needs 16 bytes instead of 32.
  * @param m the mesh to be shrinked
- * @param
+ * @param shrinkPosition store positions as half floats
+ * @param shrinkTexCoords store texture coordinates as half floats
+ * @param packNormals store normals as signed, normalized 2_10_10_10 value (requires OpenGL 3.3)
  * @author Ralf Petring
  */
-void shrinkMesh(Mesh * m, bool shrinkPosition=false);
+void shrinkMesh(Mesh * m, bool shrinkPosition=false, bool shrinkTexCoords=false, bool packNormals=false);
 
 
 /**
@@ -304,24 +350,26 @@ VertexDescription uniteVertexDescriptions(const std::deque<VertexDescription> &
  *
  * @param m the mesh to be cut
  * @param plane the cutting plane
- * @param tIndices list of triangle indices to cut. If empty, the whole mesh is cut.
+ * @param tIndices triangles to cut (a std::set or std::vector of indices is converted implicitly). If empty, the whole mesh is cut.
  * @param tolerance if a vertex lies on the plane with the given tolerance, no new vertex is created
+ * @note If the mesh's MeshBVH has already been built, it is used to select the triangles crossing the plane.
  * @author Sascha Brandt
  */
-void cutMesh(Mesh* m, const Geometry::Plane& plane, const std::set<uint32_t> tIndices={}, float tolerance=std::numeric_limits<float>::epsilon());
+void cutMesh(Mesh* m, const Geometry::Plane& plane, const TriangleSelection & tIndices=TriangleSelection(), float tolerance=std::numeric_limits<float>::epsilon());
 
 /**
  * Extrudes the specified triangles of the given mesh.
  *
  * @param m the mesh
  * @param dir extrusion direction
- * @param tIndices set of triangle indices to extrude
+ * @param tIndices triangles to extrude (a std::set or std::vector of indices is converted implicitly)
  * @author Sascha Brandt
  */
-void extrudeTriangles(Mesh* m, const Geometry::Vec3& dir, const std::set<uint32_t> tIndices);
+void extrudeTriangles(Mesh* m, const Geometry::Vec3& dir, const TriangleSelection & tIndices);
 
 /**
- * Slow method for finding the first triangle in a mesh that intersects the given ray.
+ * Find the first triangle in a mesh that intersects the given ray.
+ * The mesh's MeshBVH is used (and built on the first call or after the mesh has changed).
  * @param m the mesh
  * @param ray the ray
  * @return -1 if no intersecting triangle was found, the triangle index otherwise.
@@ -332,17 +380,24 @@ int32_t getFirstTriangleIntersectingRay(Mesh* m, const Geometry::Ray3& ray);
 /**
  * Remove vertices which are close to each other from the mesh and
  * store them only once. The indices to the vertices are adjusted.
- * This function has runtime O(n * log(n)) where n is the
- * number of vertices in @a mesh.
+ * Two vertices are close if their positions differ by at most @a tolerance in every coordinate;
+ * a vertex is merged into the first referenced close vertex which was not merged itself.
+ * The close vertices are found using a spatial hash grid with a cell size of (at least) @a tolerance;
+ * the expected runtime is O(n) where n is the number of vertices in @a mesh.
+ * Unreferenced vertices are removed; the remaining vertices are stored in the order of their first reference.
  *
  * @param mesh Mesh to do the elimination on.
+ * @param statistics If not null, the number of merged vertices and the time spent are stored there.
  * @return number of merged vertices
  * @author Sascha Brandt
  */
-uint32_t mergeCloseVertices(Mesh * mesh, float tolerance=std::numeric_limits<float>::epsilon());
+uint32_t mergeCloseVertices(Mesh * mesh, float tolerance=std::numeric_limits<float>::epsilon(), VertexMergeStatistics * statistics = nullptr);
 
 /**
  * Splits a mesh into its connected components.
+ * Triangles sharing a vertex, or having vertices closer than the given distance, belong to the same component.
+ * The components are determined with a union-find structure and a spatial hash grid (expected runtime linear in the mesh size).
+ * They are returned in the order of their first triangle; each new mesh stores its vertices in the order of their first use.
  *
  * @param mesh Mesh to split into connected components
  * @param relDistance relative distance (w.r.t. mesh's bounding box) between vertices that are considered as connected.
@@ -358,6 +413,7 @@ std::deque<Mesh*> splitIntoConnectedComponents(Mesh* mesh, float relDistance=0.0
  * @param displaceAcc pixel accessor of the displacement map
  * @param scale scale factor multiplied with the value of the texture
  * @param clampToEdge clamp to texture borders (true) or wrap around (false)
+ * @note The vertices are processed in parallel; only the displaced vertices are marked as changed.
  * @author Sascha Brandt
  */
 void applyDisplacementMap(Mesh* mesh, Util::PixelAccessor* displaceAcc, float scale=1.0, bool clampToEdge=false);
@@ -370,6 +426,7 @@ void applyDisplacementMap(Mesh* mesh, Util::PixelAccessor* displaceAcc, float sc
  * @param seed The seed for the noise generator
  * @param noiseScale scale factor multiplied with the noise value
  * @param transform transformation matrix applied on each position
+ * @note The vertices are processed in parallel.
  * @author Sascha Brandt
  */
 void applyNoise(Mesh* mesh, float noiseScale=1.0, const Geometry::Matrix4x4& transform={}, uint32_t seed=0);
@@ -381,6 +438,7 @@ void applyNoise(Mesh* mesh, float noiseScale=1.0, const Geometry::Matrix4x4& tra
  * @param pos the 3d position
  * @param radius radius around the 3d position to flatten vertices
  * @param falloff blend falloff for vertices beyond the radius
+ * @note The vertices are processed in parallel; only the moved vertices are marked as changed.
  * @author Sascha Brandt
  */
 void flattenMesh(Mesh* mesh, const Geometry::Vec3& pos, float radius, float falloff);
@@ -0,0 +1,202 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "Meshlets.h"
+#include "ConnectivityAccessor.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include <Geometry/Vec3.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+
+namespace Rendering {
+namespace MeshUtils {
+
+std::vector<uint32_t> MeshletData::createIndices() const {
+	std::vector<uint32_t> indices;
+	indices.reserve(triangles.size());
+	for(const auto & meshlet : meshlets) {
+		const uint8_t * local = triangles.data() + meshlet.triangleOffset * 3;
+		for(uint32_t i = 0; i < meshlet.triangleCount * 3; ++i)
+			indices.push_back(vertices[meshlet.vertexOffset + local[i]]);
+	}
+	return indices;
+}
+
+//! (internal) Calculate the bounding sphere and the normal cone of the last meshlet.
+static void calculateBounds(const ConnectivityAccessor & acc, MeshletData & data) {
+	Meshlet & meshlet = data.meshlets.back();
+	const uint32_t * vertices = data.vertices.data() + meshlet.vertexOffset;
+	Geometry::Vec3 minPos = acc.getVertex(vertices[0]);
+	Geometry::Vec3 maxPos = minPos;
+	for(uint32_t i = 1; i < meshlet.vertexCount; ++i) {
+		const Geometry::Vec3 pos = acc.getVertex(vertices[i]);
+		for(uint_fast8_t axis = 0; axis < 3; ++axis) {
+			minPos[axis] = std::min(minPos[axis], pos[axis]);
+			maxPos[axis] = std::max(maxPos[axis], pos[axis]);
+		}
+	}
+	const Geometry::Vec3 center = (minPos + maxPos) * 0.5f;
+	float radius = 0.0f;
+	for(uint32_t i = 0; i < meshlet.vertexCount; ++i)
+		radius = std::max(radius, center.distance(acc.getVertex(vertices[i])));
+
+	std::vector<Geometry::Vec3> normals;
+	normals.reserve(meshlet.triangleCount);
+	Geometry::Vec3 axis;
+	const uint8_t * local = data.triangles.data() + meshlet.triangleOffset * 3;
+	for(uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+		const Geometry::Vec3 a = acc.getVertex(vertices[local[t * 3 + 0]]);
+		const Geometry::Vec3 b = acc.getVertex(vertices[local[t * 3 + 1]]);
+		const Geometry::Vec3 c = acc.getVertex(vertices[local[t * 3 + 2]]);
+		const Geometry::Vec3 normal = (b - a).cross(c - a);
+		const float length = normal.length();
+		if(length > std::numeric_limits<float>::epsilon()) {
+			normals.push_back(normal / length);
+			axis += normals.back();
+		}
+	}
+	float cutoff = 2.0f;
+	const float axisLength = axis.length();
+	if(axisLength > std::numeric_limits<float>::epsilon()) {
+		axis /= axisLength;
+		float minDot = 1.0f;
+		for(const auto & normal : normals)
+			minDot = std::min(minDot, normal.dot(axis));
+		// the test is only conservative if all normals lie within 90 degrees of the axis
+		if(minDot > 0.0f)
+			cutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+	for(uint_fast8_t i = 0; i < 3; ++i) {
+		meshlet.center[i] = center[i];
+		meshlet.coneAxis[i] = axis[i];
+	}
+	meshlet.radius = radius;
+	meshlet.coneCutoff = cutoff;
+}
+
+MeshletData buildMeshlets(Mesh * mesh, uint32_t maxVertices, uint32_t maxTriangles) {
+	if(mesh == nullptr || mesh->getDrawMode() != Mesh::DRAW_TRIANGLES || !mesh->isUsingIndexData())
+		throw std::invalid_argument("buildMeshlets: Mesh is no indexed triangle mesh.");
+	maxVertices = std::min(256u, std::max(3u, maxVertices));
+	maxTriangles = std::min(512u, std::max(1u, maxTriangles));
+	Util::Reference<ConnectivityAccessor> acc = ConnectivityAccessor::create(mesh);
+
+	static const uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+	const uint32_t numTriangles = mesh->getPrimitiveCount();
+	std::vector<bool> assigned(numTriangles, false);
+	std::vector<uint32_t> localIndex(mesh->getVertexCount(), INVALID);
+	std::deque<uint32_t> frontier;
+
+	MeshletData data;
+	uint32_t numAssigned = 0;
+	uint32_t seedCursor = 0;
+	while(numAssigned < numTriangles) {
+		Meshlet meshlet;
+		meshlet.vertexOffset = static_cast<uint32_t>(data.vertices.size());
+		meshlet.vertexCount = 0;
+		meshlet.triangleOffset = static_cast<uint32_t>(data.triangles.size() / 3);
+		meshlet.triangleCount = 0;
+
+		while(assigned[seedCursor])
+			++seedCursor;
+		frontier.clear();
+		frontier.push_back(seedCursor);
+		while(!frontier.empty() && meshlet.triangleCount < maxTriangles) {
+			const uint32_t t = frontier.front();
+			frontier.pop_front();
+			if(assigned[t])
+				continue;
+			const auto triangle = acc->getTriangle(t);
+			const uint32_t corners[3] = {std::get<0>(triangle), std::get<1>(triangle), std::get<2>(triangle)};
+			uint32_t newVertices = 0;
+			for(const auto v : corners) {
+				if(localIndex[v] == INVALID)
+					++newVertices;
+			}
+			// a triangle with the same vertex twice would be counted twice, which is only conservative
+			if(meshlet.vertexCount + newVertices > maxVertices)
+				continue;
+			for(const auto v : corners) {
+				if(localIndex[v] == INVALID) {
+					localIndex[v] = meshlet.vertexCount++;
+					data.vertices.push_back(v);
+				}
+				data.triangles.push_back(static_cast<uint8_t>(localIndex[v]));
+			}
+			++meshlet.triangleCount;
+			assigned[t] = true;
+			++numAssigned;
+			acc->forEachAdjacentTriangle(t, [&](uint32_t neighbor) {
+				if(!assigned[neighbor])
+					frontier.push_back(neighbor);
+			});
+		}
+		for(uint32_t i = 0; i < meshlet.vertexCount; ++i)
+			localIndex[data.vertices[meshlet.vertexOffset + i]] = INVALID;
+		data.meshlets.push_back(meshlet);
+		calculateBounds(*acc.get(), data);
+	}
+	return data;
+}
+
+
+namespace {
+//! Meshlets cached by a mesh together with the parameters and the data revisions they were built for.
+class MeshletCache : public MeshDerivedData {
+	public:
+		MeshletCache(MeshletData _data, uint32_t _maxVertices, uint32_t _maxTriangles, const Mesh * mesh) :
+				MeshDerivedData(), data(std::move(_data)), maxVertices(_maxVertices), maxTriangles(_maxTriangles),
+				vertexRevision(mesh->_getVertexData().getRevision()), indexRevision(mesh->_getIndexData().getRevision()) {}
+		virtual ~MeshletCache() {}
+
+		bool isValidFor(const Mesh * mesh) const {
+			return vertexRevision == mesh->_getVertexData().getRevision() && indexRevision == mesh->_getIndexData().getRevision();
+		}
+		MeshletData data;
+		uint32_t maxVertices;
+		uint32_t maxTriangles;
+		uint64_t vertexRevision;
+		uint64_t indexRevision;
+};
+}
+
+const MeshletData & getMeshlets(Mesh * mesh, uint32_t maxVertices, uint32_t maxTriangles) {
+	auto cache = dynamic_cast<MeshletCache *>(mesh->_getMeshletCache());
+	maxVertices = std::min(256u, std::max(3u, maxVertices));
+	maxTriangles = std::min(512u, std::max(1u, maxTriangles));
+	if(cache == nullptr || !cache->isValidFor(mesh) || cache->maxVertices != maxVertices || cache->maxTriangles != maxTriangles) {
+		cache = new MeshletCache(buildMeshlets(mesh, maxVertices, maxTriangles), maxVertices, maxTriangles, mesh);
+		mesh->_setMeshletCache(cache);
+	}
+	return cache->data;
+}
+
+const MeshletData * getCachedMeshlets(const Mesh * mesh, uint32_t * maxVertices, uint32_t * maxTriangles) {
+	auto cache = dynamic_cast<const MeshletCache *>(mesh->_getMeshletCache());
+	if(cache == nullptr || !cache->isValidFor(mesh))
+		return nullptr;
+	if(maxVertices != nullptr)
+		*maxVertices = cache->maxVertices;
+	if(maxTriangles != nullptr)
+		*maxTriangles = cache->maxTriangles;
+	return &cache->data;
+}
+
+void setCachedMeshlets(Mesh * mesh, MeshletData data, uint32_t maxVertices, uint32_t maxTriangles) {
+	mesh->_setMeshletCache(new MeshletCache(std::move(data), maxVertices, maxTriangles, mesh));
+}
+}
+}
@@ -0,0 +1,79 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_MESHLETS_H_
+#define RENDERING_MESHUTILS_MESHLETS_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+class Mesh;
+namespace MeshUtils {
+
+/**
+ * A small cluster of connected triangles with its bounding sphere and normal cone.
+ * The layout matches the std430 layout of a struct of two uvec4 and two vec4.
+ */
+struct Meshlet {
+	uint32_t vertexOffset;		//!< first entry in MeshletData::vertices
+	uint32_t vertexCount;
+	uint32_t triangleOffset;	//!< first triangle in MeshletData::triangles (3 entries per triangle)
+	uint32_t triangleCount;
+	float center[3];
+	float radius;
+	/*! Average normal of the triangles. The cluster faces away from a viewer at position p if
+		dot(center - p, coneAxis) >= coneCutoff * length(center - p) + radius.
+		A cutoff greater than one disables the test (the normals do not lie in a common half space). */
+	float coneAxis[3];
+	float coneCutoff;
+};
+
+struct MeshletData {
+	std::vector<Meshlet> meshlets;
+	//! Indices of the mesh's vertices used by the meshlets
+	std::vector<uint32_t> vertices;
+	//! Meshlet-local vertex indices (relative to the meshlet's vertexOffset)
+	std::vector<uint8_t> triangles;
+
+	//! Return the triangles of all meshlets (in meshlet order) as indices of the mesh's vertices.
+	std::vector<uint32_t> createIndices() const;
+};
+
+/**
+ * Split a triangle mesh into meshlets with at most @p maxVertices vertices and @p maxTriangles triangles.
+ * The meshlets are grown from a seed triangle over the edge adjacency of a ConnectivityAccessor.
+ * @note @p maxVertices is clamped to [3, 256], @p maxTriangles to [1, 512].
+ * @throw std::invalid_argument if the mesh is no indexed triangle mesh with positions.
+ */
+MeshletData buildMeshlets(Mesh * mesh, uint32_t maxVertices = 64, uint32_t maxTriangles = 124);
+
+/**
+ * Return the meshlets cached by @p mesh. If there are none, if they are outdated (see MeshVertexData::getRevision()),
+ * or if they were built with other limits, new meshlets are built with buildMeshlets() and cached.
+ */
+const MeshletData & getMeshlets(Mesh * mesh, uint32_t maxVertices = 64, uint32_t maxTriangles = 124);
+
+/**
+ * Return the meshlets cached by @p mesh if they are up to date, or nullptr; nothing is built.
+ * The limits the meshlets were built with are stored in @p maxVertices and @p maxTriangles (if not null).
+ */
+const MeshletData * getCachedMeshlets(const Mesh * mesh, uint32_t * maxVertices = nullptr, uint32_t * maxTriangles = nullptr);
+
+/**
+ * Cache previously built (e.g. stored) meshlets for the current data of @p mesh.
+ * @note The data is not checked against the mesh.
+ */
+void setCachedMeshlets(Mesh * mesh, MeshletData data, uint32_t maxVertices, uint32_t maxTriangles);
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_MESHLETS_H_ */
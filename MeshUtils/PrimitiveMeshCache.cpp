@@ -0,0 +1,114 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "PrimitiveMeshCache.h"
+#include "PrimitiveShapes.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+
+#include <Geometry/Box.h>
+#include <Geometry/Sphere.h>
+#include <Geometry/Vec3.h>
+
+namespace Rendering {
+namespace MeshUtils {
+
+//! (internal)
+Util::Reference<Mesh> PrimitiveMeshCache::get(shape_t shape, std::vector<double> && parameters, const VertexDescription& vd, const std::function<Mesh*()>& create) {
+	key_t key(shape, std::move(parameters), vd);
+	const auto it = meshes.find(key);
+	if(it != meshes.end()) {
+		++hitCount;
+		return it->second;
+	}
+	Util::Reference<Mesh> mesh(create());
+	if(mesh.isNotNull()) // invalid parameters are not cached
+		meshes.emplace(std::move(key), mesh);
+	return mesh;
+}
+
+Util::Reference<Mesh> PrimitiveMeshCache::getBox(const VertexDescription& vd, const Geometry::Box& box) {
+	const auto & min = box.getMin();
+	const auto & max = box.getMax();
+	return get(BOX, {min.x(), min.y(), min.z(), max.x(), max.y(), max.z()}, vd,
+				[&]() {	return createBox(vd, box);	});
+}
+
+Util::Reference<Mesh> PrimitiveMeshCache::getDome(const VertexDescription& vd, double radius, int horiRes, int vertRes, double halfSphereFraction, double imagePercentage) {
+	return get(DOME, {radius, static_cast<double>(horiRes), static_cast<double>(vertRes), halfSphereFraction, imagePercentage}, vd,
+				[&]() {	return createDome(vd, radius, horiRes, vertRes, halfSphereFraction, imagePercentage);	});
+}
+
+Util::Reference<Mesh> PrimitiveMeshCache::getSphere(const VertexDescription& vd, const Geometry::Sphere_f& sphere, uint32_t inclinationSegments, uint32_t azimuthSegments) {
+	const auto & center = sphere.getCenter();
+	return get(SPHERE, {center.x(), center.y(), center.z(), sphere.getRadius(), static_cast<double>(inclinationSegments), static_cast<double>(azimuthSegments)}, vd,
+				[&]() {	return createSphere(vd, sphere, inclinationSegments, azimuthSegments);	});
+}
+
+Util::Reference<Mesh> PrimitiveMeshCache::getDiscSector(const VertexDescription& vd, float radius, uint8_t numSegments, float angle) {
+	return get(DISC_SECTOR, {radius, static_cast<double>(numSegments), angle}, vd,
+				[&]() {	return createDiscSector(vd, radius, numSegments, angle);	});
+}
+
+Util::Reference<Mesh> PrimitiveMeshCache::getRingSector(const VertexDescription& vd, float innerRadius, float outerRadius, uint8_t numSegments, float angle) {
+	return get(RING_SECTOR, {innerRadius, outerRadius, static_cast<double>(numSegments), angle}, vd,
+				[&]() {	return createRingSector(vd, innerRadius, outerRadius, numSegments, angle);	});
+}
+
+Util::Reference<Mesh> PrimitiveMeshCache::getCone(const VertexDescription& vd, float radius, float height, uint8_t numSegments) {
+	return get(CONE, {radius, height, static_cast<double>(numSegments)}, vd,
+				[&]() {	return createCone(vd, radius, height, numSegments);	});
+}
+
+Util::Reference<Mesh> PrimitiveMeshCache::getConicalFrustum(const VertexDescription& vd, float radiusBottom, float radiusTop, float height, uint8_t numSegments) {
+	return get(CONICAL_FRUSTUM, {radiusBottom, radiusTop, height, static_cast<double>(numSegments)}, vd,
+				[&]() {	return createConicalFrustum(vd, radiusBottom, radiusTop, height, numSegments);	});
+}
+
+Util::Reference<Mesh> PrimitiveMeshCache::getArrow(const VertexDescription& vd, float radius, float length) {
+	return get(ARROW, {radius, length}, vd,
+				[&]() {	return createArrow(vd, radius, length);	});
+}
+
+Util::Reference<Mesh> PrimitiveMeshCache::getRectangle(const VertexDescription& vd, const Geometry::Rect_f& rect) {
+	return get(RECTANGLE, {rect.getX(), rect.getY(), rect.getWidth(), rect.getHeight()}, vd,
+				[&]() {	return createRectangle(vd, rect);	});
+}
+
+Util::Reference<Mesh> PrimitiveMeshCache::getGrid(const VertexDescription& vd, float width, float height, uint32_t rows, uint32_t columns) {
+	return get(GRID, {width, height, static_cast<double>(rows), static_cast<double>(columns)}, vd,
+				[&]() {	return createGrid(vd, width, height, rows, columns);	});
+}
+
+Util::Reference<Mesh> PrimitiveMeshCache::getHexGrid(const VertexDescription& vd, float width, float height, uint32_t rows, uint32_t columns) {
+	return get(HEX_GRID, {width, height, static_cast<double>(rows), static_cast<double>(columns)}, vd,
+				[&]() {	return createHexGrid(vd, width, height, rows, columns);	});
+}
+
+Util::Reference<Mesh> PrimitiveMeshCache::getTorus(const VertexDescription& vd, float innerRadius, float outerRadius, uint32_t majorSegments, uint32_t minorSegments) {
+	return get(TORUS, {innerRadius, outerRadius, static_cast<double>(majorSegments), static_cast<double>(minorSegments)}, vd,
+				[&]() {	return createTorus(vd, innerRadius, outerRadius, majorSegments, minorSegments);	});
+}
+
+void PrimitiveMeshCache::upload() {
+	for(auto & entry : meshes) {
+		Mesh * mesh = entry.second.get();
+		MeshVertexData & vd = mesh->_getVertexData();
+		if(!vd.empty() && vd.hasLocalData() && (vd.hasChanged() || !vd.isUploaded()))
+			vd.upload();
+		MeshIndexData & id = mesh->_getIndexData();
+		if(mesh->isUsingIndexData() && !id.empty() && id.hasLocalData() && (id.hasChanged() || !id.isUploaded()))
+			id.upload();
+	}
+}
+
+}
+}
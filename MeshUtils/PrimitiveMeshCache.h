@@ -0,0 +1,101 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_PRIMITIVEMESHCACHE_H_
+#define RENDERING_MESHUTILS_PRIMITIVEMESHCACHE_H_
+
+#include "../Mesh/VertexDescription.h"
+#include <Geometry/Rect.h>
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace Geometry {
+template<typename value_t> class _Box;
+typedef _Box<float> Box;
+template<typename T_> class _Sphere;
+typedef _Sphere<float> Sphere_f;
+}
+
+namespace Rendering {
+class Mesh;
+namespace MeshUtils {
+
+/**
+ * Cache of the meshes created by the functions in PrimitiveShapes.h, keyed by the shape, its parameters and
+ * the VertexDescription. Requesting the same primitive twice returns the same mesh, so its data is created and
+ * uploaded only once (e.g. for gizmos and markers that are drawn every frame).
+ * \code
+ * Util::Reference<MeshUtils::PrimitiveMeshCache> primitives = new MeshUtils::PrimitiveMeshCache;
+ * Util::Reference<Mesh> arrow = primitives->getArrow(vd, 0.05f, 1.0f); // created once
+ * \endcode
+ * The cache holds a reference to each mesh.
+ * @note The meshes are shared; they must not be changed by the caller (clone them instead, see Mesh::clone()).
+ */
+class PrimitiveMeshCache : public Util::ReferenceCounter<PrimitiveMeshCache> {
+	public:
+		PrimitiveMeshCache() : ReferenceCounter_t(), hitCount(0) {}
+
+		//! \see createBox(...)
+		Util::Reference<Mesh> getBox(const VertexDescription& vd, const Geometry::Box& box);
+		//! \see createDome(...)
+		Util::Reference<Mesh> getDome(const VertexDescription& vd, double radius = 100.0, int horiRes = 40, int vertRes = 40, double halfSphereFraction = 1.0, double imagePercentage = 1.0);
+		//! \see createSphere(...)
+		Util::Reference<Mesh> getSphere(const VertexDescription& vd, const Geometry::Sphere_f& sphere, uint32_t inclinationSegments, uint32_t azimuthSegments);
+		//! \see createDiscSector(...)
+		Util::Reference<Mesh> getDiscSector(const VertexDescription& vd, float radius, uint8_t numSegments, float angle = 360.0f);
+		//! \see createRingSector(...)
+		Util::Reference<Mesh> getRingSector(const VertexDescription& vd, float innerRadius, float outerRadius, uint8_t numSegments, float angle = 360.0f);
+		//! \see createCone(...)
+		Util::Reference<Mesh> getCone(const VertexDescription& vd, float radius, float height, uint8_t numSegments);
+		//! \see createConicalFrustum(...)
+		Util::Reference<Mesh> getConicalFrustum(const VertexDescription& vd, float radiusBottom, float radiusTop, float height, uint8_t numSegments);
+		//! \see createArrow(...)
+		Util::Reference<Mesh> getArrow(const VertexDescription& vd, float radius, float length);
+		//! \see createRectangle(...)
+		Util::Reference<Mesh> getRectangle(const VertexDescription& vd, const Geometry::Rect_f& rect);
+		//! \see createGrid(...)
+		Util::Reference<Mesh> getGrid(const VertexDescription& vd, float width, float height, uint32_t rows, uint32_t columns);
+		//! \see createHexGrid(...)
+		Util::Reference<Mesh> getHexGrid(const VertexDescription& vd, float width, float height, uint32_t rows, uint32_t columns);
+		//! \see createTorus(...)
+		Util::Reference<Mesh> getTorus(const VertexDescription& vd, float innerRadius, float outerRadius, uint32_t majorSegments, uint32_t minorSegments);
+
+		/*! Pre-warming: upload the data of all cached meshes that has not been uploaded yet, so drawing them for the
+			first time does not cause buffer uploads.
+			\note Has to be called from within the gl-thread.	*/
+		void upload();
+
+		void clear()										{	meshes.clear();	}
+		std::size_t getMeshCount()const					{	return meshes.size();	}
+		//! Number of requests that returned a cached mesh.
+		std::size_t getHitCount()const						{	return hitCount;	}
+
+	private:
+		enum shape_t : uint8_t {
+			BOX, DOME, SPHERE, DISC_SECTOR, RING_SECTOR, CONE, CONICAL_FRUSTUM, ARROW, RECTANGLE, GRID, HEX_GRID, TORUS
+		};
+		typedef std::tuple<shape_t, std::vector<double>, VertexDescription> key_t;
+		std::map<key_t, Util::Reference<Mesh>> meshes;
+		std::size_t hitCount;
+
+		//! (internal) Return the cached mesh for the given key; if there is none, it is created by @p create.
+		Util::Reference<Mesh> get(shape_t shape, std::vector<double> && parameters, const VertexDescription& vd, const std::function<Mesh*()>& create);
+};
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_PRIMITIVEMESHCACHE_H_ */
@@ -13,7 +13,13 @@
 
 #include "MeshBuilder.h"
 #include "MeshUtils.h"
+#include "internal/ParallelFor.h"
 #include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeAccessors.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexDescription.h"
 
 #include <Geometry/Box.h>
 #include <Geometry/BoxHelper.h>
@@ -27,8 +33,13 @@
 #include <Util/Graphics/PixelAccessor.h>
 #include <Util/Graphics/Bitmap.h>
 
+#include <algorithm>
 #include <cmath>
 #include <map>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #ifndef M_PI
 #define M_PI		3.14159265358979323846
@@ -46,6 +57,7 @@ using namespace Geometry;
 // ---------------------------------------------------------
   
 void addBox(MeshBuilder& mb, const Box& box) {
+	mb.reserve(24, 36);
 	uint32_t nextIndex = mb.getNextIndex();
 	for (uint_fast8_t s = 0; s < 6; ++s) {
 		const side_t side = static_cast<side_t>(s);
@@ -126,6 +138,7 @@ void addSphere(MeshBuilder& mb, const Sphere_f & sphere, uint32_t inclinationSeg
 	const double TWO_PI = 2.0 * M_PI;
 	const double inclinationIncrement = M_PI / static_cast<double>(inclinationSegments);
 	const double azimuthIncrement = TWO_PI / static_cast<double>(azimuthSegments);
+	mb.reserve((inclinationSegments + 1) * (azimuthSegments + 1), 6 * (inclinationSegments - 1) * azimuthSegments);
 
 	// Multiple "North Poles"
 	mb.position(sphere.getCenter() + Vec3f(0.0f, sphere.getRadius(), 0.0f));
@@ -390,6 +403,7 @@ void addGrid(MeshBuilder& mb, float width, float height, uint32_t rows, uint32_t
 	const float xScale=width / columns;
 	const float yScale=height / rows;
   uint32_t idx = mb.getNextIndex();
+  mb.reserve((rows + 1) * (columns + 1), 6 * rows * columns);
   mb.normal(Vec3(0,1,0));
 
 	for(uint32_t y=0; y<=rows; ++y) {
@@ -410,10 +424,101 @@ void addGrid(MeshBuilder& mb, float width, float height, uint32_t rows, uint32_t
 	}
 }
 
+enum shared_grid_shape_t : uint8_t {
+	SHARED_GRID, SHARED_HEX_GRID
+};
+typedef std::tuple<shared_grid_shape_t, uint32_t, uint32_t> shared_grid_key_t;
+static std::mutex sharedGridMutex;
+static std::map<shared_grid_key_t, MeshIndexData> sharedGridIndexData;
+
+//! (internal) Return a copy of the cached indices of the given grid; they are created on the first request.
+static MeshIndexData getSharedIndexData(shared_grid_shape_t shape, uint32_t rows, uint32_t columns) {
+	std::lock_guard<std::mutex> lock(sharedGridMutex);
+	const shared_grid_key_t key(shape, rows, columns);
+	auto it = sharedGridIndexData.find(key);
+	if(it == sharedGridIndexData.end()) {
+		// the indices do not depend on the size or the vertex description of the grid
+		VertexDescription vd;
+		vd.appendPosition3D();
+		MeshBuilder mb(vd);
+		if(shape == SHARED_GRID)
+			addGrid(mb, 1.0f, 1.0f, rows, columns);
+		else
+			addHexGrid(mb, 1.0f, 1.0f, rows, columns);
+		Util::Reference<Mesh> mesh = mb.buildMesh();
+		if(mesh.isNull())
+			return MeshIndexData();
+		it = sharedGridIndexData.emplace(key, mesh->openIndexData()).first;
+	}
+	return MeshIndexData(it->second);
+}
+
+MeshIndexData getSharedGridIndexData(uint32_t rows, uint32_t columns) {
+	return getSharedIndexData(SHARED_GRID, rows, columns);
+}
+
+MeshIndexData getSharedHexGridIndexData(uint32_t rows, uint32_t columns) {
+	return getSharedIndexData(SHARED_HEX_GRID, rows, columns);
+}
+
+void uploadSharedGridIndexData() {
+	std::lock_guard<std::mutex> lock(sharedGridMutex);
+	for(auto & entry : sharedGridIndexData) {
+		MeshIndexData & indices = entry.second;
+		if(!indices.empty() && indices.hasLocalData() && (indices.hasChanged() || !indices.isUploaded()))
+			indices.upload();
+	}
+}
+
+void clearSharedGridIndexData() {
+	std::lock_guard<std::mutex> lock(sharedGridMutex);
+	sharedGridIndexData.clear();
+}
+
 Mesh* createGrid(const VertexDescription& vd, float width, float height, uint32_t rows, uint32_t columns) {
   MeshBuilder mb(vd);
   addGrid(mb, width, height, rows, columns);
-  return mb.buildMesh();
+  Mesh * mesh = mb.buildMesh();
+  if(mesh != nullptr) {
+    // reference the cached topology instead of an own copy of equal indices
+    MeshIndexData indices(getSharedGridIndexData(rows, columns));
+    mesh->_getIndexData().swap(indices);
+  }
+  return mesh;
+}
+
+std::vector<Util::Reference<Mesh>> createGridPatches(const VertexDescription& vd, float width, float height, uint32_t rows, uint32_t columns,
+													uint32_t patchCountX, uint32_t patchCountZ) {
+	std::vector<Util::Reference<Mesh>> patches;
+	Util::Reference<Mesh> grid = createGrid(vd, width, height, rows, columns);
+	if(grid.isNull() || patchCountX == 0 || patchCountZ == 0)
+		return patches;
+
+	const MeshVertexData & gridVertices = grid->openVertexData();
+	const uint32_t vertexCount = gridVertices.getVertexCount();
+	const uint32_t patchCount = patchCountX * patchCountZ;
+	const std::size_t patchSize = gridVertices.dataSize();
+	MeshVertexData vertices;
+	vertices.allocate(vertexCount * patchCount, gridVertices.getVertexDescription());
+	uint8_t * data = vertices.data();
+	Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vertices, VertexAttributeIds::POSITION));
+	PositionAttributeAccessor * positions = positionAccessor.get();
+	parallelFor(patchCount, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t patch = begin; patch < end; ++patch) {
+			std::copy(gridVertices.data(), gridVertices.data() + patchSize, data + patch * patchSize);
+			const Vec3 offset(static_cast<float>(patch % patchCountX) * width, 0.0f, static_cast<float>(patch / patchCountX) * height);
+			for(uint32_t v = patch * vertexCount; v < (patch + 1) * vertexCount; ++v)
+				positions->setPosition(v, positions->getPosition(v) + offset);
+		}
+	});
+	vertices.invalidateBoundingBox();
+
+	const uint32_t indexCount = grid->getIndexCount();
+	Util::Reference<Mesh> source = new Mesh(MeshIndexData(grid->_getIndexData()), std::move(vertices));
+	patches.reserve(patchCount);
+	for(uint32_t patch = 0; patch < patchCount; ++patch)
+		patches.emplace_back(Mesh::createView(source.get(), 0, indexCount, static_cast<int32_t>(patch * vertexCount)));
+	return patches;
 }
 
 // ---------------------------------------------------------
@@ -463,12 +568,102 @@ void addHexGrid(MeshBuilder& mb, float width, float height, uint32_t rows, uint3
 Mesh* createHexGrid(const VertexDescription& vd, float width, float height, uint32_t rows, uint32_t columns) {
   MeshBuilder mb(vd);
   addHexGrid(mb, width, height, rows, columns);
-  return mb.buildMesh();
+  Mesh * mesh = mb.buildMesh();
+  if(mesh != nullptr) {
+    MeshIndexData indices(getSharedHexGridIndexData(rows, columns));
+    mesh->_getIndexData().swap(indices);
+  }
+  return mesh;
 }
 
 // ---------------------------------------------------------
 
-void addVoxelMesh(MeshBuilder& mb, const Util::PixelAccessor& colorAcc, uint32_t depth) {
+//! (internal) A merged face of the greedy voxel mesher: a rectangle of equally colored voxel faces.
+struct VoxelQuad {
+	uint32_t origin[3];
+	uint32_t size[3];
+	uint8_t face; //!< 2*axis + (1 for the positive direction)
+	Util::Color4f color;
+};
+
+/*! (internal) Merge the visible faces of one slice of the voxel grid in direction @p face into rectangles.
+	The visible faces of the slice are collected in a 2d mask, which is then covered greedily with
+	rectangles of equal color (first extending along the first, then along the second slice axis).	*/
+static void meshVoxelSlice(const Util::PixelAccessor& colorAcc, const Vec3i& res, uint8_t face, uint32_t slice, std::vector<VoxelQuad>& quads) {
+	const uint32_t d = face / 2;
+	const uint32_t u = (d + 1) % 3;
+	const uint32_t v = (d + 2) % 3;
+	const bool positive = (face & 1) != 0;
+	const uint32_t resU = res[u];
+	const uint32_t resV = res[v];
+	const auto read = [&](const uint32_t c[3]) {
+		return colorAcc.readColor4f(c[0], c[1] + c[2]*res.y());
+	};
+	const auto sameColor = [](const Util::Color4f& a, const Util::Color4f& b) {
+		return a.getR() == b.getR() && a.getG() == b.getG() && a.getB() == b.getB() && a.getA() == b.getA();
+	};
+
+	std::vector<Util::Color4f> colors(resU * resV);
+	std::vector<uint8_t> visible(resU * resV, 0);
+	uint32_t c[3];
+	c[d] = slice;
+	for(uint32_t j=0; j<resV; ++j) {
+		for(uint32_t i=0; i<resU; ++i) {
+			c[u] = i;
+			c[v] = j;
+			const auto color = read(c);
+			if(color.a() <= 0)
+				continue;
+			const bool atBorder = positive ? slice == static_cast<uint32_t>(res[d])-1 : slice == 0;
+			if(!atBorder) {
+				uint32_t n[3] = {c[0], c[1], c[2]};
+				n[d] = positive ? slice+1 : slice-1;
+				if(!(read(n).a() < 0.1))
+					continue;
+			}
+			colors[i + j*resU] = color;
+			visible[i + j*resU] = 1;
+		}
+	}
+
+	for(uint32_t j=0; j<resV; ++j) {
+		for(uint32_t i=0; i<resU; ) {
+			const uint32_t first = i + j*resU;
+			if(visible[first] == 0) {
+				++i;
+				continue;
+			}
+			const auto& color = colors[first];
+			uint32_t w = 1;
+			while(i+w < resU && visible[first+w] != 0 && sameColor(colors[first+w], color))
+				++w;
+			uint32_t h = 1;
+			for(; j+h < resV; ++h) {
+				const uint32_t row = first + h*resU;
+				uint32_t k = 0;
+				while(k < w && visible[row+k] != 0 && sameColor(colors[row+k], color))
+					++k;
+				if(k < w)
+					break;
+			}
+			VoxelQuad quad;
+			quad.origin[d] = slice;
+			quad.origin[u] = i;
+			quad.origin[v] = j;
+			quad.size[d] = 1;
+			quad.size[u] = w;
+			quad.size[v] = h;
+			quad.face = face;
+			quad.color = color;
+			quads.push_back(quad);
+			for(uint32_t y=0; y<h; ++y)
+				std::fill(visible.begin() + first + y*resU, visible.begin() + first + y*resU + w, 0);
+			i += w;
+		}
+	}
+}
+
+void addVoxelMesh(MeshBuilder& mb, const Util::PixelAccessor& colorAcc, uint32_t depth, bool greedy) {
 	//Util::Reference<Util::PixelAccessor> colorAcc = Util::PixelAccessor::create(std::move(voxelBitmap));
 	if( colorAcc.getPixelFormat().getNumComponents() < 4 ){
 		WARN("createVoxelMesh: unsupported color texture format. Requires 4 components.");
@@ -480,6 +675,51 @@ void addVoxelMesh(MeshBuilder& mb, const Util::PixelAccessor& colorAcc, uint32_t
 	}
 	
 	Vec3i res(colorAcc.getWidth(), colorAcc.getHeight()/depth, depth);
+
+	if(greedy) {
+		// corner offsets of the faces (bit i of the mask: corner i lies on the far side of the quad along that axis); as below
+		static const uint8_t faceMods[6][3] = {
+			{0, 4|8, 2|4}, {1|2|4|8, 2|4, 4|8},
+			{2|4, 0, 4|8}, {4|8, 1|2|4|8, 2|4},
+			{4|8, 2|4, 0}, {2|4, 4|8, 1|2|4|8}
+		};
+		// one job per face direction and slice; the slices are independent
+		std::vector<std::pair<uint8_t, uint32_t>> jobs;
+		for(uint8_t face=0; face<6; ++face) {
+			for(uint32_t slice=0; slice<static_cast<uint32_t>(res[face/2]); ++slice)
+				jobs.emplace_back(face, slice);
+		}
+		std::vector<std::vector<VoxelQuad>> sliceQuads(jobs.size());
+		parallelFor(static_cast<uint32_t>(jobs.size()), [&](uint32_t begin, uint32_t end) {
+			for(uint32_t job=begin; job<end; ++job)
+				meshVoxelSlice(colorAcc, res, jobs[job].first, jobs[job].second, sliceQuads[job]);
+		}, 1);
+		std::size_t numQuads = 0;
+		for(const auto& quads : sliceQuads)
+			numQuads += quads.size();
+		mb.reserve(4*numQuads, 6*numQuads);
+		for(auto& quads : sliceQuads) {
+			for(const auto& quad : quads) {
+				const uint8_t* mods = faceMods[quad.face];
+				Vec3 normal(0,0,0);
+				normal[quad.face/2] = (quad.face & 1) != 0 ? 1.0f : -1.0f;
+				mb.color(quad.color);
+				mb.normal(normal);
+				const uint32_t idx = mb.getNextIndex();
+				for(uint8_t corner=0; corner<4; ++corner) {
+					Vec3 pos;
+					for(uint8_t axis=0; axis<3; ++axis)
+						pos[axis] = static_cast<float>(quad.origin[axis] + ((mods[axis] & (1<<corner)) != 0 ? quad.size[axis] : 0));
+					mb.position(pos);
+					mb.addVertex();
+				}
+				mb.addQuad(idx,idx+1,idx+2,idx+3);
+			}
+			// free the slices' quads early
+			std::vector<VoxelQuad>().swap(quads);
+		}
+		return;
+	}
 	
 	const auto createQuad = [&](uint32_t x, uint32_t y, uint32_t z, uint8_t xMod, uint8_t yMod, uint8_t zMod, const Vec3& normal){
     uint32_t idx = mb.getNextIndex();
@@ -516,9 +756,9 @@ void addVoxelMesh(MeshBuilder& mb, const Util::PixelAccessor& colorAcc, uint32_t
   }
 }
 
-Mesh* createVoxelMesh(const VertexDescription& vd, const Util::PixelAccessor& colorAcc, uint32_t depth) {
+Mesh* createVoxelMesh(const VertexDescription& vd, const Util::PixelAccessor& colorAcc, uint32_t depth, bool greedy) {
   MeshBuilder mb(vd);
-  addVoxelMesh(mb, colorAcc, depth);
+  addVoxelMesh(mb, colorAcc, depth, greedy);
   return mb.buildMesh();
 }
 
@@ -535,6 +775,7 @@ void addTorus(MeshBuilder& mb, float innerRadius, float outerRadius, uint32_t ma
 	}
 	float minorRadius = (outerRadius - innerRadius) * 0.5;
 	float majorRadius = innerRadius + minorRadius;
+	mb.reserve(majorSegments * minorSegments, 6 * majorSegments * minorSegments);
 	for(uint32_t major=0; major<majorSegments; ++major) {
 		float u = major * 2.0 * M_PI / majorSegments;
 		Vec3 center(std::cos(u) * majorRadius, 0, std::sin(u) * majorRadius);
@@ -17,6 +17,7 @@
 #include <Util/References.h>
 
 #include <cstdint>
+#include <vector>
 
 namespace Geometry {
 template<typename value_t> class _Box;
@@ -44,6 +45,7 @@ class PixelAccessor;
 
 namespace Rendering {
 class Mesh;
+class MeshIndexData;
 class VertexDescription;
 namespace MeshUtils {
 class MeshBuilder;
@@ -204,6 +206,7 @@ inline void addRectangle(MeshBuilder& mb, float width, float height) {
 
 /**
  * Creates a rectangular grid in the x-z-plane.
+ * The index data is shared with all grids of the same resolution (see getSharedGridIndexData()).
  *
  * @param vd Vertex description specifying the vertex information to generate
  * @param width The width of the grid 
@@ -218,6 +221,7 @@ void addGrid(MeshBuilder& mb, float width, float height, uint32_t rows, uint32_t
 
 /**
  * Creates a hexagonal grid in the x-z-plane.
+ * The index data is shared with all hexagonal grids of the same resolution (see getSharedHexGridIndexData()).
  *
  * @param vd Vertex description specifying the vertex information to generate
  * @param width The width of the grid 
@@ -230,6 +234,32 @@ Mesh* createHexGrid(const VertexDescription& vd, float width, float height, uint
 //! Adds a hexagonal grid to the given meshBuilder. \see createHexGrid(...)
 void addHexGrid(MeshBuilder& mb, float width, float height, uint32_t rows, uint32_t columns);
 
+/*! Return a copy of the index data of a grid with the given numbers of rows and columns (as created by createGrid())
+	from a process-wide cache. The copy shares the local indices with the cache (copy-on-write, see MeshIndexData);
+	if the cached data has been uploaded (see uploadSharedGridIndexData()), the index buffer is shared as well.	*/
+MeshIndexData getSharedGridIndexData(uint32_t rows, uint32_t columns);
+//! Like getSharedGridIndexData(), for the hexagonal grids created by createHexGrid().
+MeshIndexData getSharedHexGridIndexData(uint32_t rows, uint32_t columns);
+/*! Upload the cached grid indices that have not been uploaded yet. Afterwards, all grids created with the same shape
+	and resolution use a single index buffer.
+	\note Has to be called from within the gl-thread.	*/
+void uploadSharedGridIndexData();
+/*! Remove the cached grid indices; meshes using them keep their copies.
+	\note If the cached data has been uploaded, call this within the gl-thread before the context is destroyed.	*/
+void clearSharedGridIndexData();
+
+/**
+ * Creates @p patchCountX x @p patchCountZ adjacent grids (see createGrid()) as views (see Mesh::createView()) of a
+ * single mesh: the patch (x, z) is translated by (x * width, 0, z * height). The vertices of all patches are stored
+ * one after another, while the indices of a single grid are stored only once and are offset by a base vertex per
+ * patch. Therefore, all patches are drawn from one vertex buffer and one index buffer, and every patch can be culled
+ * separately.
+ *
+ * @return The patches ordered by rows (the patch (x, z) at z * patchCountX + x); the shared mesh is their view source.
+ */
+std::vector<Util::Reference<Mesh>> createGridPatches(const VertexDescription& vd, float width, float height, uint32_t rows, uint32_t columns,
+													uint32_t patchCountX, uint32_t patchCountZ);
+
 /**
  * Creates a mesh from a voxel bitmap as exported from a 3D Texture.
  * The bitmap should have a height of depth*heiht, i.e., each depth layer is stored from top to bottom in the vertical direction of the bitmap.
@@ -241,11 +271,13 @@ void addHexGrid(MeshBuilder& mb, float width, float height, uint32_t rows, uint3
  * @param vd Vertex description specifying the vertex information to generate
  * @param colorAcc the bitmap that defines the voxel grid. Every pixel with non-zero alpha value defines a voxel.
  * @param the depth of the voxel grid. The height of the bitmap should be divisible by this value
+ * @param greedy merge adjacent visible faces of equal color lying in the same plane into larger quads.
+ *        The slices of the grid are processed in parallel; the surface is the same, but usually consists of far fewer triangles.
  */
-Mesh* createVoxelMesh(const VertexDescription& vd, const Util::PixelAccessor& colorAcc, uint32_t depth);
+Mesh* createVoxelMesh(const VertexDescription& vd, const Util::PixelAccessor& colorAcc, uint32_t depth, bool greedy=false);
 
-//! Adds a voxel mesh to the given meshBuilder. \see createHexGrid(...)
-void addVoxelMesh(MeshBuilder& mb, const Util::PixelAccessor& colorAcc, uint32_t depth);
+//! Adds a voxel mesh to the given meshBuilder. \see createVoxelMesh(...)
+void addVoxelMesh(MeshBuilder& mb, const Util::PixelAccessor& colorAcc, uint32_t depth, bool greedy=false);
 
  /**
  * Creates a torus mesh.
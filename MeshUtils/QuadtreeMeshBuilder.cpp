@@ -10,14 +10,16 @@
 */
 #include "QuadtreeMeshBuilder.h"
 #include "MeshBuilder.h"
+#include "internal/ParallelFor.h"
 
 #include <Geometry/Vec2.h>
 #include <Geometry/Vec3.h>
 
 #include <Util/Graphics/PixelAccessor.h>
 
+#include <algorithm>
+#include <deque>
 #include <limits>
-#include <map>
 
 #ifndef NDEBUG
 #define NDEBUG
@@ -29,6 +31,125 @@ namespace MeshUtils {
 using namespace Util;
 using namespace std;
 
+class QuadtreeMeshBuilder::QuadTree::NodePool {
+	private:
+		//! A deque allocates its elements in blocks and never moves them.
+		std::deque<QuadTree> nodes;
+	public:
+		QuadTree * create(QuadTree * parent, uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+			nodes.emplace_back(parent, x, y, width, height);
+			return &nodes.back();
+		}
+};
+
+/*! Level 0 contains the values of all pixels, each texel of the next level contains the minimum and maximum of
+	(up to) four texels of the previous level. */
+class QuadtreeMeshBuilder::MinMaxPyramid {
+	private:
+		struct Level {
+			uint32_t width;
+			uint32_t height;
+			std::vector<float> minValues;
+			std::vector<float> maxValues; //! Empty for level 0 (minimum and maximum are the same).
+		};
+		const uint8_t numChannels;
+		std::vector<Level> levels;
+
+	public:
+		/*! (ctor)
+			@param values numChannels values for each pixel, row by row */
+		MinMaxPyramid(uint32_t width, uint32_t height, uint8_t _numChannels, std::vector<float> values) :
+				numChannels(_numChannels) {
+			levels.emplace_back();
+			levels.back().width = width;
+			levels.back().height = height;
+			levels.back().minValues = std::move(values);
+			while(levels.back().width > 1 || levels.back().height > 1) {
+				const Level & source = levels.back();
+				Level level;
+				level.width = (source.width + 1) / 2;
+				level.height = (source.height + 1) / 2;
+				level.minValues.resize(level.width * level.height * numChannels);
+				level.maxValues.resize(level.width * level.height * numChannels);
+				const std::vector<float> & sourceMax = source.maxValues.empty() ? source.minValues : source.maxValues;
+				for(uint32_t y = 0; y < level.height; ++y) {
+					for(uint32_t x = 0; x < level.width; ++x) {
+						const uint32_t target = (y * level.width + x) * numChannels;
+						for(uint_fast8_t c = 0; c < numChannels; ++c) {
+							level.minValues[target + c] = std::numeric_limits<float>::max();
+							level.maxValues[target + c] = std::numeric_limits<float>::lowest();
+						}
+						for(uint32_t sy = 2 * y; sy < std::min(2 * y + 2, source.height); ++sy) {
+							for(uint32_t sx = 2 * x; sx < std::min(2 * x + 2, source.width); ++sx) {
+								const uint32_t sourceIndex = (sy * source.width + sx) * numChannels;
+								for(uint_fast8_t c = 0; c < numChannels; ++c) {
+									level.minValues[target + c] = std::min(level.minValues[target + c], source.minValues[sourceIndex + c]);
+									level.maxValues[target + c] = std::max(level.maxValues[target + c], sourceMax[sourceIndex + c]);
+								}
+							}
+						}
+					}
+				}
+				levels.push_back(std::move(level));
+			}
+		}
+
+		float getValue(uint32_t x, uint32_t y, uint8_t channel) const {
+			return levels.front().minValues[(y * levels.front().width + x) * numChannels + channel];
+		}
+
+		//! Minimum and maximum of the whole image.
+		void getRange(float * minValues, float * maxValues) const {
+			const Level & top = levels.back();
+			for(uint_fast8_t c = 0; c < numChannels; ++c) {
+				minValues[c] = top.minValues[c];
+				maxValues[c] = (top.maxValues.empty() ? top.minValues : top.maxValues)[c];
+			}
+		}
+
+		/*! Conservative bounds of the values inside of the region [xMin, xMax) x [yMin, yMax):
+			The result contains the region's minimum and maximum, but may include values of pixels close to the region. */
+		void getRange(uint32_t xMin, uint32_t yMin, uint32_t xMax, uint32_t yMax, float * minValues, float * maxValues) const {
+			for(uint_fast8_t c = 0; c < numChannels; ++c) {
+				minValues[c] = std::numeric_limits<float>::max();
+				maxValues[c] = std::numeric_limits<float>::lowest();
+			}
+			if(xMin >= xMax || yMin >= yMax)
+				return;
+			// use the level whose texels are not larger than the region, so that only a few texels have to be visited
+			const uint32_t regionSize = std::min(xMax - xMin, yMax - yMin);
+			size_t levelIndex = 0;
+			while(levelIndex + 1 < levels.size() && (2u << levelIndex) <= regionSize)
+				++levelIndex;
+			const Level & level = levels[levelIndex];
+			const std::vector<float> & levelMax = level.maxValues.empty() ? level.minValues : level.maxValues;
+			for(uint32_t y = yMin >> levelIndex; y <= ((yMax - 1) >> levelIndex); ++y) {
+				for(uint32_t x = xMin >> levelIndex; x <= ((xMax - 1) >> levelIndex); ++x) {
+					const uint32_t index = (y * level.width + x) * numChannels;
+					for(uint_fast8_t c = 0; c < numChannels; ++c) {
+						minValues[c] = std::min(minValues[c], level.minValues[index + c]);
+						maxValues[c] = std::max(maxValues[c], levelMax[index + c]);
+					}
+				}
+			}
+		}
+};
+
+//! (internal) Read the values of all pixels in parallel; @p read(x, y, values) stores the values of one pixel.
+template<typename ReadFunction>
+static std::vector<float> readPixels(const Util::PixelAccessor & accessor, uint8_t numChannels, const ReadFunction & read) {
+	const uint32_t width = accessor.getWidth();
+	const uint32_t height = accessor.getHeight();
+	std::vector<float> values(width * height * numChannels);
+	parallelFor(height, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t y = begin; y < end; ++y) {
+			for(uint32_t x = 0; x < width; ++x)
+				read(x, y, values.data() + (y * width + x) * numChannels);
+		}
+	}, 64);
+	return values;
+}
+
 QuadtreeMeshBuilder::QuadTree::QuadTree(uint16_t _x, uint16_t _y, uint16_t _width, uint16_t _height) :
 	children(),
 	neighbors(),
@@ -36,8 +157,15 @@ QuadtreeMeshBuilder::QuadTree::QuadTree(uint16_t _x, uint16_t _y, uint16_t _widt
 	x(_x),
 	y(_y),
 	width(_width),
-	height(_height) {
-
+	height(_height),
+	pool(nullptr),
+	ownedPool(new NodePool) {
+
+	pool = ownedPool.get();
+	children.NW = nullptr;
+	children.NE = nullptr;
+	children.SW = nullptr;
+	children.SE = nullptr;
 	neighbors.WEST = nullptr;
 	neighbors.NORTH = nullptr;
 	neighbors.EAST = nullptr;
@@ -51,8 +179,14 @@ QuadtreeMeshBuilder::QuadTree::QuadTree(QuadtreeMeshBuilder::QuadTree* _parent,
 	x(_x),
 	y(_y),
 	width(_width),
-	height(_height) {
-
+	height(_height),
+	pool(_parent->pool),
+	ownedPool() {
+
+	children.NW = nullptr;
+	children.NE = nullptr;
+	children.SW = nullptr;
+	children.SE = nullptr;
 	neighbors.WEST = nullptr;
 	neighbors.NORTH = nullptr;
 	neighbors.EAST = nullptr;
@@ -75,15 +209,15 @@ bool QuadtreeMeshBuilder::QuadTree::split() {
 	const uint16_t height1 = height - height / 2u;
 
 	// create (maximum) four children (sometimes a quad-tree node can only contain the children NW and NE, or NW and SW)
-	children.NW.reset(new QuadTree(this, x, y, width1, height1));
+	children.NW = pool->create(this, x, y, width1, height1);
 	if (width > 1) {
-		children.NE.reset(new QuadTree(this, x+width1, y, width-width1, height1));
+		children.NE = pool->create(this, x+width1, y, width-width1, height1);
 	}
 	if (height > 1) {
-		children.SW.reset(new QuadTree(this, x, y+height1, width1, height-height1));
+		children.SW = pool->create(this, x, y+height1, width1, height-height1);
 	}
 	if (width > 1 && height > 1) {
-		children.SE.reset(new QuadTree(this, x+width1, y+height1, width-width1, height-height1));
+		children.SE = pool->create(this, x+width1, y+height1, width-width1, height-height1);
 	}
 
 	// rearrange the neighbors and do balancing where necessary
@@ -98,10 +232,10 @@ void QuadtreeMeshBuilder::QuadTree::arrangeNeighbors() {
 	QuadTree * east = neighbors.EAST;
 	QuadTree * south = neighbors.SOUTH;
 
-	QuadTree * nw = children.NW.get();
-	QuadTree * ne = children.NE.get();
-	QuadTree * sw = children.SW.get();
-	QuadTree * se = children.SE.get();
+	QuadTree * nw = children.NW;
+	QuadTree * ne = children.NE;
+	QuadTree * sw = children.SW;
+	QuadTree * se = children.SE;
 
 
 	// west side
@@ -109,14 +243,14 @@ void QuadtreeMeshBuilder::QuadTree::arrangeNeighbors() {
 		if (west->isLeaf()) {
 			west->split();
 		}
-		QuadTree * neighbor = (parent != nullptr && parent->children.NW.get() == this) ? west->children.NE.get() : west->children.SE.get();
+		QuadTree * neighbor = (parent != nullptr && parent->children.NW == this) ? west->children.NE : west->children.SE;
 		nw->neighbors.WEST = neighbor;
 		if (sw != nullptr)
 			sw->neighbors.WEST = neighbor;
 	} else if (west && !west->isLeaf()) {
-		makeHorizontalNeighbors(west->children.NE.get(), nw);
+		makeHorizontalNeighbors(west->children.NE, nw);
 		if (sw != nullptr) {
-			makeHorizontalNeighbors(west->children.SE.get(), sw);
+			makeHorizontalNeighbors(west->children.SE, sw);
 		}
 	} else {
 		nw->neighbors.WEST = west;
@@ -130,14 +264,14 @@ void QuadtreeMeshBuilder::QuadTree::arrangeNeighbors() {
 		if (north->isLeaf()) {
 			north->split();
 		}
-		QuadTree * neighbor = (parent != nullptr && parent->children.NW.get() == this) ? north->children.SW.get() : north->children.SE.get();
+		QuadTree * neighbor = (parent != nullptr && parent->children.NW == this) ? north->children.SW : north->children.SE;
 		nw->neighbors.NORTH = neighbor;
 		if (ne != nullptr)
 			ne->neighbors.NORTH = neighbor;
 	} else if (north && !north->isLeaf()) {
-		makeVerticalNeighbors(north->children.SW.get(), nw);
+		makeVerticalNeighbors(north->children.SW, nw);
 		if (ne != nullptr) {
-			makeVerticalNeighbors(north->children.SE.get(), ne);
+			makeVerticalNeighbors(north->children.SE, ne);
 		}
 	} else {
 		nw->neighbors.NORTH = north;
@@ -151,7 +285,7 @@ void QuadtreeMeshBuilder::QuadTree::arrangeNeighbors() {
 		if (east->isLeaf()) {
 			east->split();
 		}
-		QuadTree * neighbor = (parent != nullptr && parent->children.NE.get() == this) ? east->children.NW.get() : east->children.SW.get();
+		QuadTree * neighbor = (parent != nullptr && parent->children.NE == this) ? east->children.NW : east->children.SW;
 		if (ne == nullptr) {
 			nw->neighbors.EAST = neighbor;
 			sw->neighbors.EAST = neighbor;
@@ -163,12 +297,12 @@ void QuadtreeMeshBuilder::QuadTree::arrangeNeighbors() {
 		}
 	} else if (east && !east->isLeaf()) {
 		if (ne == nullptr) {
-			makeHorizontalNeighbors(nw, east->children.NW.get());
-			makeHorizontalNeighbors(sw, east->children.SW.get());
+			makeHorizontalNeighbors(nw, east->children.NW);
+			makeHorizontalNeighbors(sw, east->children.SW);
 		} else {
-			makeHorizontalNeighbors(ne, east->children.NW.get());
+			makeHorizontalNeighbors(ne, east->children.NW);
 			if (se != nullptr) {
-				makeHorizontalNeighbors(se, east->children.SW.get());
+				makeHorizontalNeighbors(se, east->children.SW);
 			}
 		}
 	} else {
@@ -188,7 +322,7 @@ void QuadtreeMeshBuilder::QuadTree::arrangeNeighbors() {
 		if (south->isLeaf()) {
 			south->split();
 		}
-		QuadTree * neighbor = (parent != nullptr && parent->children.SE.get() == this) ? south->children.NE.get() : south->children.NW.get();
+		QuadTree * neighbor = (parent != nullptr && parent->children.SE == this) ? south->children.NE : south->children.NW;
 		if (sw == nullptr) {
 			nw->neighbors.SOUTH = neighbor;
 			ne->neighbors.SOUTH = neighbor;
@@ -199,12 +333,12 @@ void QuadtreeMeshBuilder::QuadTree::arrangeNeighbors() {
 		}
 	} else if (south && !south->isLeaf()) {
 		if (sw == nullptr) {
-			makeVerticalNeighbors(nw, south->children.NW.get());
-			makeVerticalNeighbors(ne, south->children.NE.get());
+			makeVerticalNeighbors(nw, south->children.NW);
+			makeVerticalNeighbors(ne, south->children.NE);
 		} else {
-			makeVerticalNeighbors(sw, south->children.NW.get());
+			makeVerticalNeighbors(sw, south->children.NW);
 			if (se != nullptr) {
-				makeVerticalNeighbors(se, south->children.NE.get());
+				makeVerticalNeighbors(se, south->children.NE);
 			}
 		}
 	} else {
@@ -234,7 +368,7 @@ void QuadtreeMeshBuilder::QuadTree::arrangeNeighbors() {
 	}
 }
 
-void QuadtreeMeshBuilder::QuadTree::collectLeaves(deque<QuadTree *> & leaves) {
+void QuadtreeMeshBuilder::QuadTree::collectLeaves(std::vector<QuadTree *> & leaves) {
 	if (isLeaf()) {
 		leaves.push_back(this);
 	} else {
@@ -311,19 +445,12 @@ QuadtreeMeshBuilder::DepthSplitFunction::DepthSplitFunction(Util::Reference<Util
 	if(depth.isNull()) {
 		throw std::invalid_argument("No access to depth values.");
 	}
-	const uint16_t texWidth = depth->getWidth();
-	const uint16_t texHeight = depth->getHeight();
-	for (uint_fast16_t x = 0; x < texWidth; ++x) {
-		for (uint_fast16_t y = 0; y < texHeight; ++y) {
-			const float current = depth->readSingleValueFloat(x, y);
-			if (current < minDepth) {
-				minDepth = current;
-			}
-			if (current > maxDepth) {
-				maxDepth = current;
-			}
-		}
-	}
+	const Util::PixelAccessor & accessor = *depth.get();
+	pyramid = std::make_shared<MinMaxPyramid>(depth->getWidth(), depth->getHeight(), 1,
+			readPixels(accessor, 1, [&accessor](uint32_t x, uint32_t y, float * values) {
+				values[0] = accessor.readSingleValueFloat(x, y);
+			}));
+	pyramid->getRange(&minDepth, &maxDepth);
 }
 
 bool QuadtreeMeshBuilder::DepthSplitFunction::operator()(QuadtreeMeshBuilder::QuadTree * node) {
@@ -333,13 +460,19 @@ bool QuadtreeMeshBuilder::DepthSplitFunction::operator()(QuadtreeMeshBuilder::Qu
 	const uint16_t yMax = node->getHeight() + yMin;
 
 	const float minDisruption = disruptionFactor * (maxDepth - minDepth);
+	// No difference between two depth values can be larger than the range of the node's depth values.
+	float regionMin, regionMax;
+	pyramid->getRange(xMin, yMin, xMax, yMax, &regionMin, &regionMax);
+	if (regionMax - regionMin <= minDisruption) {
+		return false;
+	}
 	// If there is a continuous change of depth values, then do not split.
 	// If there is a large disruption of depth values, then split.
 	for (uint_fast16_t y = yMin; y < yMax; ++y) {
 		float rowDeltaMax = 0.0f;
 		for (uint_fast16_t x = xMin + 1u; x < xMax; ++x) {
-			const float current = depth->readSingleValueFloat(x, y);
-			const float before = depth->readSingleValueFloat(x - 1, y);
+			const float current = pyramid->getValue(x, y, 0);
+			const float before = pyramid->getValue(x - 1, y, 0);
 			const float delta = std::abs(before - current);
 			if (delta > rowDeltaMax) {
 				rowDeltaMax = delta;
@@ -353,8 +486,8 @@ bool QuadtreeMeshBuilder::DepthSplitFunction::operator()(QuadtreeMeshBuilder::Qu
 	for (uint_fast16_t x = xMin; x < xMax; ++x) {
 		float columnDeltaMax = 0.0f;
 		for (uint_fast16_t y = yMin + 1u; y < yMax; ++y) {
-			const float current = depth->readSingleValueFloat(x, y);
-			const float before = depth->readSingleValueFloat(x, y - 1);
+			const float current = pyramid->getValue(x, y, 0);
+			const float before = pyramid->getValue(x, y - 1, 0);
 			const float delta = std::abs(before - current);
 			if (delta > columnDeltaMax) {
 				columnDeltaMax = delta;
@@ -374,6 +507,15 @@ QuadtreeMeshBuilder::ColorSplitFunction::ColorSplitFunction(Util::Reference<Util
 	if(color.isNull()) {
 		throw std::invalid_argument("No access to color values.");
 	}
+	const Util::PixelAccessor & accessor = *color.get();
+	pyramid = std::make_shared<MinMaxPyramid>(color->getWidth(), color->getHeight(), 4,
+			readPixels(accessor, 4, [&accessor](uint32_t x, uint32_t y, float * values) {
+				const Util::Color4ub c = accessor.readColor4ub(x, y);
+				values[0] = c.getR();
+				values[1] = c.getG();
+				values[2] = c.getB();
+				values[3] = c.getA();
+			}));
 }
 
 bool QuadtreeMeshBuilder::ColorSplitFunction::operator()(QuadtreeMeshBuilder::QuadTree * node) {
@@ -383,6 +525,12 @@ bool QuadtreeMeshBuilder::ColorSplitFunction::operator()(QuadtreeMeshBuilder::Qu
 	const uint16_t yMax = node->getHeight() + yMin;
 
 	const uint16_t minDisruption = 255;
+	// The difference of two colors can not be larger than the sum of the channel ranges of the node.
+	float regionMin[4], regionMax[4];
+	pyramid->getRange(xMin, yMin, xMax, yMax, regionMin, regionMax);
+	if ((regionMax[0] - regionMin[0]) + (regionMax[1] - regionMin[1]) + (regionMax[2] - regionMin[2]) + (regionMax[3] - regionMin[3]) <= minDisruption) {
+		return false;
+	}
 	// If there is a continuous change of color values, then do not split.
 	// If there is a large disruption of color values, then split.
 	for (uint_fast16_t y = yMin; y < yMax; ++y) {
@@ -427,6 +575,11 @@ QuadtreeMeshBuilder::StencilSplitFunction::StencilSplitFunction(Util::Reference<
 	if(stencil.isNull()) {
 		throw std::invalid_argument("No access to stencil values.");
 	}
+	const Util::PixelAccessor & accessor = *stencil.get();
+	pyramid = std::make_shared<MinMaxPyramid>(stencil->getWidth(), stencil->getHeight(), 1,
+			readPixels(accessor, 1, [&accessor](uint32_t x, uint32_t y, float * values) {
+				values[0] = accessor.readSingleValueByte(x, y);
+			}));
 }
 
 bool QuadtreeMeshBuilder::StencilSplitFunction::operator()(QuadtreeMeshBuilder::QuadTree * node) {
@@ -435,11 +588,17 @@ bool QuadtreeMeshBuilder::StencilSplitFunction::operator()(QuadtreeMeshBuilder::
 	const uint16_t xMax = node->getWidth() + xMin;
 	const uint16_t yMax = node->getHeight() + yMin;
 
+	// If all stencil values of the node are the same, then do not split.
+	float regionMin, regionMax;
+	pyramid->getRange(xMin, yMin, xMax, yMax, &regionMin, &regionMax);
+	if (regionMin == regionMax) {
+		return false;
+	}
 	// If there is a disruption of stencil values, then split.
 	for (uint_fast16_t y = yMin; y < yMax; ++y) {
 		for (uint_fast16_t x = xMin + 1u; x < xMax; ++x) {
-			const uint8_t current = stencil->readSingleValueByte(x, y);
-			const uint8_t before = stencil->readSingleValueByte(x - 1, y);
+			const float current = pyramid->getValue(x, y, 0);
+			const float before = pyramid->getValue(x - 1, y, 0);
 			if (current != before) {
 				return true;
 			}
@@ -447,8 +606,8 @@ bool QuadtreeMeshBuilder::StencilSplitFunction::operator()(QuadtreeMeshBuilder::
 	}
 	for (uint_fast16_t x = xMin; x < xMax; ++x) {
 		for (uint_fast16_t y = yMin + 1u; y < yMax; ++y) {
-			const uint8_t current = stencil->readSingleValueByte(x, y);
-			const uint8_t before = stencil->readSingleValueByte(x, y - 1);
+			const float current = pyramid->getValue(x, y, 0);
+			const float before = pyramid->getValue(x, y - 1, 0);
 			if (current != before) {
 				return true;
 			}
@@ -525,7 +684,9 @@ Mesh * QuadtreeMeshBuilder::createMesh(const VertexDescription& vd,
 	const uint16_t height = static_cast<uint16_t>(depthReader->getHeight()) - 1;
 
 	// 1: create queue used to build up a quad-tree (it usually contains the leaves, but could also contain some inner nodes)
-	deque<QuadTree*> quadtrees;
+	vector<QuadTree*> quadtrees;
+	vector<QuadTree*> nextQuadtrees;
+	vector<uint8_t> splitRequired;
 
 	// 2: create the root quad-tree and add it to the queue
 	QuadTree root(0, 0, width, height);
@@ -533,20 +694,33 @@ Mesh * QuadtreeMeshBuilder::createMesh(const VertexDescription& vd,
 
 	// 3: as long as there are further leaf-nodes
 	while (!quadtrees.empty()) {
-		QuadTree* quadtree = quadtrees.front();
-		quadtrees.pop_front();
-
-		if (!quadtree->isLeaf()) { // node has been already split during balancing
-			quadtree->collectLeaves(quadtrees);
-			continue;
-		}
+		// evaluate the split function for all leaves of the queue in parallel; the result only depends on the node's area
+		splitRequired.assign(quadtrees.size(), 0);
+		parallelFor(static_cast<uint32_t>(quadtrees.size()), [&](uint32_t begin, uint32_t end) {
+			for(uint32_t i = begin; i < end; ++i) {
+				if (quadtrees[i]->isLeaf() && function(quadtrees[i])) {
+					splitRequired[i] = 1;
+				}
+			}
+		}, 64);
+
+		// split the nodes in queue order (splitting may split neighbors for balancing)
+		nextQuadtrees.clear();
+		for(size_t i = 0; i < quadtrees.size(); ++i) {
+			QuadTree* quadtree = quadtrees[i];
+			if (!quadtree->isLeaf()) { // node has been already split during balancing
+				quadtree->collectLeaves(nextQuadtrees);
+				continue;
+			}
 
-		// split the quadtree if necessary
-		if (function(quadtree)) {
-			if (quadtree->split()) {
-				quadtree->collectLeaves(quadtrees);
+			// split the quadtree if necessary
+			if (splitRequired[i] != 0) {
+				if (quadtree->split()) {
+					quadtree->collectLeaves(nextQuadtrees);
+				}
 			}
 		}
+		quadtrees.swap(nextQuadtrees);
 	}
 
 
@@ -560,25 +734,25 @@ Mesh * QuadtreeMeshBuilder::createMesh(const VertexDescription& vd,
 	const float vScale = 1.0f / static_cast<float>(height);
 
 	// 5-A: collect the quadtree-leaves
-	deque<QuadTree*> leaves;
+	vector<QuadTree*> leaves;
 	root.collectLeaves(leaves);
 
 #ifndef NDEBUG
 	createDebugOutput(leaves, depthReader.get(), colorReader.get());
 #endif
 
-	// 5-B: as long as there are leaves
-	map<vertex_t, uint32_t> indexMap; // index map containing indices to already created vertices
+	// 5-B: for all leaves
+	// index grid containing indices to already created vertices (vertex coordinates are in [0, width] x [0, height])
+	static const uint32_t UNKNOWN_INDEX = INVALID_INDEX - 1;
+	const uint32_t gridWidth = static_cast<uint32_t>(width) + 1;
+	vector<uint32_t> indexGrid(gridWidth * (static_cast<uint32_t>(height) + 1), UNKNOWN_INDEX);
 	vector<uint32_t> indices;
 	vector<vertex_t> vertices;
 	indices.reserve(8);
 	vertices.reserve(8);
 
 
-	while (!leaves.empty()) {
-		QuadTree * quadtree = leaves.front();
-		leaves.pop_front();
-
+	for(QuadTree * quadtree : leaves) {
 		indices.clear();
 		vertices.clear();
 
@@ -589,12 +763,12 @@ Mesh * QuadtreeMeshBuilder::createMesh(const VertexDescription& vd,
 		for(const auto & vertex : vertices) {
 			const uint16_t x = vertex.first;
 			const uint16_t y = vertex.second;
-			auto lb = indexMap.lower_bound(vertex);
-			if(lb != indexMap.end() && !(indexMap.key_comp()(vertex, lb->first))) {
-				indices.push_back(lb->second); // try to get an index of the specified vertex
+			uint32_t & knownIndex = indexGrid[y * gridWidth + x];
+			if(knownIndex != UNKNOWN_INDEX) {
+				indices.push_back(knownIndex); // try to get an index of the specified vertex
 			} else if(stencilReader.isNotNull() && stencilReader->readSingleValueByte(x, y) == 0) {
 				// Generate a dummy vertex only, because the pixel belongs to the background
-				indexMap.insert(lb, std::make_pair(vertex, INVALID_INDEX));
+				knownIndex = INVALID_INDEX;
 				indices.push_back(INVALID_INDEX);
 			} else {
 				// create new position
@@ -615,7 +789,7 @@ Mesh * QuadtreeMeshBuilder::createMesh(const VertexDescription& vd,
 				builder.texCoord0(Geometry::Vec2(x * uScale, y * vScale));
 
 				const uint32_t index = builder.addVertex();
-				indexMap.insert(lb, std::make_pair(vertex, index)); // insert into the indexMap
+				knownIndex = index; // insert into the index grid
 				indices.push_back(index);
 			}
 		}
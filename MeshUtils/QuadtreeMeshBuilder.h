@@ -34,18 +34,24 @@ namespace MeshUtils {
  *
  */
 class QuadtreeMeshBuilder {
+private:
+	//! (internal) Minimum and maximum values of an image, stored in a mip-map like pyramid.
+	class MinMaxPyramid;
 public:
 	typedef std::pair<uint16_t, uint16_t> vertex_t;
 
 	/** quad tree used to subdivide the texture into areas */
 	class QuadTree {
 	private:
-		/** array containing the pointers to the four children. */
+		//! (internal) Storage of all nodes of a tree; nodes are allocated in blocks and released together with the root.
+		class NodePool;
+
+		/** array containing the pointers to the four children (owned by the pool). */
 		struct {
-			std::unique_ptr<QuadTree> NW;
-			std::unique_ptr<QuadTree> NE;
-			std::unique_ptr<QuadTree> SW;
-			std::unique_ptr<QuadTree> SE;
+			QuadTree * NW;
+			QuadTree * NE;
+			QuadTree * SW;
+			QuadTree * SE;
 		} children;
 
 		/** array containing the pointers to the neighbors */
@@ -71,6 +77,11 @@ public:
 		/** the height of the texture area */
 		uint16_t height;
 
+		/** pool of the tree the node belongs to */
+		NodePool * pool;
+
+		/** pool owned by the root node */
+		std::unique_ptr<NodePool> ownedPool;
 
 	private:
 		QuadTree(const QuadTree &) = delete;
@@ -105,10 +116,10 @@ public:
 		const QuadTree * getEastNeighbor() const	{	return neighbors.EAST;	}
 		const QuadTree * getSouthNeighbor() const	{	return neighbors.SOUTH;	}
 
-		const QuadTree * getNorthWestChild() const	{	return children.NW.get();		}
-		const QuadTree * getNorthEastChild() const	{	return children.NE.get();		}
-		const QuadTree * getSouthWestChild() const	{	return children.SW.get();		}
-		const QuadTree * getSouthEastChild() const	{	return children.SE.get();		}
+		const QuadTree * getNorthWestChild() const	{	return children.NW;		}
+		const QuadTree * getNorthEastChild() const	{	return children.NE;		}
+		const QuadTree * getSouthWestChild() const	{	return children.SW;		}
+		const QuadTree * getSouthEastChild() const	{	return children.SE;		}
 
 		/**
 		 * simply tries to split the current node into four smaller nodes
@@ -118,9 +129,9 @@ public:
 
 		/**
 		 * collects all leaf-nodes from current node's subtree
-		 * @param leaves : list to that all leaves will be collected
+		 * @param leaves : list to that all leaves will be appended
 		 */
-		void collectLeaves(std::deque<QuadTree *> & leaves);
+		void collectLeaves(std::vector<QuadTree *> & leaves);
 		uint8_t collectVertices(std::vector<vertex_t> & vertices) const;
 
 	private:
@@ -155,7 +166,7 @@ public:
 		public:
 			/**
 			 * Default constructor.
-			 * The minimum and maximum depth values are initialized here.
+			 * The depth values are read once and the minimum and maximum depth values are initialized here.
 			 *
 			 * @param depthAccessor Access to the depth values
 			 * @param depthDisruption This factor is multiplied with the depth range.
@@ -175,6 +186,8 @@ public:
 		private:
 			//! Access to the depth values.
 			Util::Reference<Util::PixelAccessor> depth;
+			//! Depth values with their minimum and maximum over image regions.
+			std::shared_ptr<const MinMaxPyramid> pyramid;
 			//! Minimum depth of the whole texture.
 			float minDepth;
 			//! Maximum depth of the whole texture.
@@ -203,6 +216,8 @@ public:
 		private:
 			//! Access to the color values.
 			Util::Reference<Util::PixelAccessor> color;
+			//! Minimum and maximum of the color channels over image regions.
+			std::shared_ptr<const MinMaxPyramid> pyramid;
 	};
 
 	//! Split function that only uses the stencil values.
@@ -225,6 +240,8 @@ public:
 		private:
 			//! Access to the stencil values.
 			Util::Reference<Util::PixelAccessor> stencil;
+			//! Minimum and maximum stencil values over image regions.
+			std::shared_ptr<const MinMaxPyramid> pyramid;
 	};
 
 	//! Split function that uses multiple other split functions
@@ -268,7 +285,8 @@ public:
 	 * @param normalTexture (optional) containing normal-vectors
 	 * @param stencilTexture (optional) Stencil values.
 	 * If the stencil value of a pixel is zero, no vertices will be generated for that pixel.
-	 * @param function split function determines whether a quad-tree node requires a split
+	 * @param function split function determines whether a quad-tree node requires a split.
+	 * The nodes of one level of the tree are tested in parallel, so the function has to be thread-safe.
 	 * @return created mesh
 	 */
 	static Mesh * createMesh(const VertexDescription & vd,
@@ -283,7 +301,7 @@ private:
 	~QuadtreeMeshBuilder() {}
 
 #ifndef NDEBUG
-	static void createDebugOutput(const std::deque<QuadtreeMeshBuilder::QuadTree *> & leaves, Util::PixelAccessor * depth, Util::PixelAccessor * color);
+	static void createDebugOutput(const std::vector<QuadtreeMeshBuilder::QuadTree *> & leaves, Util::PixelAccessor * depth, Util::PixelAccessor * color);
 #endif
 };
 
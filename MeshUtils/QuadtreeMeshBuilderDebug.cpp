@@ -49,7 +49,7 @@ static void drawLine(Util::PixelAccessor * pixelAccessor, const Util::Color4ub &
 	}
 }
 
-void QuadtreeMeshBuilder::createDebugOutput(const std::deque<QuadtreeMeshBuilder::QuadTree *> & leaves, Util::PixelAccessor * sourceDepth, Util::PixelAccessor * sourceColor) {
+void QuadtreeMeshBuilder::createDebugOutput(const std::vector<QuadtreeMeshBuilder::QuadTree *> & leaves, Util::PixelAccessor * sourceDepth, Util::PixelAccessor * sourceColor) {
 	const uint32_t bitmapWidth = static_cast<uint32_t> (sourceDepth->getWidth());
 	const uint32_t bitmapHeight = static_cast<uint32_t> (sourceDepth->getHeight());
 	Util::Reference<Util::Bitmap> depthDebugBitmap = new Util::Bitmap(bitmapWidth, bitmapHeight, Util::PixelFormat::MONO_FLOAT);
@@ -13,6 +13,8 @@
 #include "../Mesh/Mesh.h"
 #include "../Mesh/VertexAttributeAccessors.h"
 #include "../Mesh/VertexAttributeIds.h"
+#include "../TaskScheduler.h"
+#include "internal/ScratchArena.h"
 #include <Geometry/Point.h>
 #include <Geometry/PointOctree.h>
 #include <Geometry/Sphere.h>
@@ -20,14 +22,15 @@
 #include <Util/Macros.h>
 #include <Util/Numeric.h>
 #include <Util/ProgressIndicator.h>
-#include <Util/UpdatableHeap.h>
 #include <Util/Utils.h>
 #include <Util/References.h>
 #include <Util/Timer.h>
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <deque>
 #include <set>
+#include <memory>
 #include <stdexcept>
 #include <unordered_set>
 #include <utility>
@@ -37,10 +40,14 @@ namespace Rendering {
 namespace MeshUtils {
 namespace Simplification {
 
+//! Maximum number of data entries of a vertex: VERTEX (3), NORMAL (3), COLOR (4), TEX0 (2)
+static const std::size_t MAX_DATA_ENTRIES = 12;
+typedef std::array<float, MAX_DATA_ENTRIES> dataArray_t;
+
 struct heapData{
 	unsigned int vertex1;
 	unsigned int vertex2;
-	std::vector<float> optPos;
+	dataArray_t optPos;
 
 	heapData() :
 		vertex1(std::numeric_limits<unsigned int>::max()), vertex2(std::numeric_limits<unsigned int>::max()), optPos() {
@@ -50,9 +57,121 @@ struct heapData{
 	}
 };
 
-typedef Util::UpdatableHeap<float, heapData>::UpdatableHeapElement heapElement;
-typedef std::set<heapElement*>::iterator heapElementSetIterator;
-typedef std::set<unsigned int>::iterator uIntSetIterator;
+/**
+ * Binary min-heap of vertex pairs.
+ * All pairs are stored in one array and are referenced by their index, which stays valid until the pair is erased.
+ * The slots of erased pairs are reused, so no memory is allocated per pair.
+ */
+class EdgeHeap {
+	private:
+		struct Entry {
+			float cost;
+			uint32_t heapPos;
+			heapData data;
+		};
+		std::vector<Entry> entries;
+		std::vector<uint32_t> heap;
+		std::vector<uint32_t> freeEntries;
+
+		bool less(std::size_t a, std::size_t b) const {
+			return entries[heap[a]].cost < entries[heap[b]].cost;
+		}
+		void swapPositions(std::size_t a, std::size_t b) {
+			std::swap(heap[a], heap[b]);
+			entries[heap[a]].heapPos = static_cast<uint32_t>(a);
+			entries[heap[b]].heapPos = static_cast<uint32_t>(b);
+		}
+		void siftUp(std::size_t pos) {
+			while(pos > 0) {
+				const std::size_t parent = (pos - 1) / 2;
+				if(!less(pos, parent)) {
+					break;
+				}
+				swapPositions(pos, parent);
+				pos = parent;
+			}
+		}
+		void siftDown(std::size_t pos) {
+			const std::size_t count = heap.size();
+			while(true) {
+				const std::size_t left = 2 * pos + 1;
+				if(left >= count) {
+					break;
+				}
+				std::size_t smallest = left;
+				if(left + 1 < count && less(left + 1, left)) {
+					smallest = left + 1;
+				}
+				if(!less(smallest, pos)) {
+					break;
+				}
+				swapPositions(pos, smallest);
+				pos = smallest;
+			}
+		}
+	public:
+		void reserve(std::size_t count) {
+			entries.reserve(count);
+			heap.reserve(count);
+		}
+		std::size_t size() const {
+			return heap.size();
+		}
+		//! Return the pair with the lowest cost.
+		uint32_t top() const {
+			return heap.front();
+		}
+		float getCost(uint32_t id) const {
+			return entries[id].cost;
+		}
+		heapData & getData(uint32_t id) {
+			return entries[id].data;
+		}
+		/**
+		 * Insert a new pair.
+		 * @note References returned by getData() are invalidated.
+		 */
+		uint32_t insert(float cost, const heapData & data) {
+			uint32_t id;
+			if(freeEntries.empty()) {
+				id = static_cast<uint32_t>(entries.size());
+				entries.emplace_back();
+			} else {
+				id = freeEntries.back();
+				freeEntries.pop_back();
+			}
+			Entry & entry = entries[id];
+			entry.cost = cost;
+			entry.data = data;
+			entry.heapPos = static_cast<uint32_t>(heap.size());
+			heap.push_back(id);
+			siftUp(entry.heapPos);
+			return id;
+		}
+		void update(uint32_t id, float cost) {
+			const float oldCost = entries[id].cost;
+			entries[id].cost = cost;
+			if(cost < oldCost) {
+				siftUp(entries[id].heapPos);
+			} else {
+				siftDown(entries[id].heapPos);
+			}
+		}
+		void erase(uint32_t id) {
+			const std::size_t pos = entries[id].heapPos;
+			const std::size_t last = heap.size() - 1;
+			if(pos != last) {
+				swapPositions(pos, last);
+				heap.pop_back();
+				siftDown(pos);
+				siftUp(pos);
+			} else {
+				heap.pop_back();
+			}
+			freeEntries.push_back(id);
+		}
+};
+
 const float DONT_MERGE_COST = std::numeric_limits<float>::max();
 
 struct VertexPoint : public Geometry::Point<Geometry::Vec3f> {
@@ -219,7 +338,7 @@ struct Quadric {
 struct vertex_t {
 	Quadric<float> q;
 	std::vector<float> data; // vertex data: VERTEX, NORMAL, COLOR, TEX0
-	std::set<heapElement*> inHeap;
+	std::set<uint32_t> inHeap;
 	std::deque<uint32_t> inIndex;
 	std::set<unsigned int> neighbors;
 
@@ -248,12 +367,13 @@ inline static void make_unique(ContainerType & container) {
  * Normalize a vector
  * 
  * @param normalVector Vector as array
+ * @param size Number of components
  * @return @c true if successful, @c false if the length is zero
  */
-static bool normalize(std::vector<float> & normalVector) {
+static bool normalize(float * normalVector, std::size_t size) {
 	float length = 0;
-	for(const auto & n : normalVector) {
-		length += n * n;
+	for(std::size_t i = 0; i < size; ++i) {
+		length += normalVector[i] * normalVector[i];
 	}
 	length = std::sqrt(length);
 
@@ -262,8 +382,8 @@ static bool normalize(std::vector<float> & normalVector) {
 	}
 
 	length = 1 / length;
-	for(auto & n : normalVector) {
-		n *= length;
+	for(std::size_t i = 0; i < size; ++i) {
+		normalVector[i] *= length;
 	}
 	return true;
 }
@@ -294,26 +414,25 @@ static Geometry::Vec3f calcNormal(const float * vertexA, const float * vertexB,
  */
 static void getQuadric(const std::vector<float> & p, const std::vector<float> & q, const std::vector<float> & r, Quadric<float> & quadric){
 	const size_t size = quadric.A.getSize();
+	const ScratchScope scratch;
 
 	// e1 = (q - p) / ||q - p||
-	std::vector<float> e1;
-	e1.reserve(size);
+	float * e1 = scratch.getArena().allocateArray<float>(size);
 	for(uint_fast8_t i=0; i<size; ++i){
-		e1.push_back(q[i] - p[i]);
+		e1[i] = q[i] - p[i];
 	}
-	normalize(e1);
+	normalize(e1, size);
 
 	// e2 = (r - p - (e1 * (r - p)) e1) / ||...||
-	std::vector<float> e2;
-	e2.reserve(size);
+	float * e2 = scratch.getArena().allocateArray<float>(size);
 	float r_p_e1 = 0.0f;
 	for(uint_fast8_t i=0; i<size; ++i){
 		r_p_e1 += (r[i] - p[i]) * e1[i];
 	}
 	for(uint_fast8_t i=0; i<size; ++i){
-		e2.push_back(r[i] - p[i] - r_p_e1 * e1[i]);
+		e2[i] = r[i] - p[i] - r_p_e1 * e1[i];
 	}
-	normalize(e2);
+	normalize(e2, size);
 
 	float p_e1 = 0.0f;
 	float p_e2 = 0.0f;
@@ -345,7 +464,7 @@ static void getQuadric(const std::vector<float> & p, const std::vector<float> &
  * @return pointer to allocated array
  */
 static std::size_t initVertexArray(Mesh * mesh, 
-								   Util::ProgressIndicator & progress, 
+								   Util::ProgressIndicator * progress, 
 								   const weights_t & weights,
 								   std::vector<vertex_t> & vertices, 
 								   Geometry::PointOctree<VertexPoint> * vOctree) {
@@ -424,7 +543,9 @@ static std::size_t initVertexArray(Mesh * mesh,
 
 		vertices.emplace_back(std::move(vertex));
 
-		progress.increment();
+		if(progress != nullptr) {
+			progress->increment();
+		}
 	}
 
 	// initialize quadrics q
@@ -450,7 +571,9 @@ static std::size_t initVertexArray(Mesh * mesh,
 		vertices[indexA].q += tmpQ;
 		vertices[indexB].q += tmpQ;
 		vertices[indexC].q += tmpQ;
-		progress.increment();
+		if(progress != nullptr) {
+			progress->increment();
+		}
 	}
 
 	for(auto & vertex : vertices) {
@@ -473,35 +596,29 @@ static std::size_t initVertexArray(Mesh * mesh,
 static void getNeighboursOfVertex(Mesh * mesh, const vertex_t & v, Geometry::PointOctree<VertexPoint> * vOctree, float threshold, std::set<unsigned int> & n, std::set<std::pair<unsigned int, unsigned int> > & singleNeighbors){
 	const MeshIndexData & iData = mesh->openIndexData();
 	const uint32_t * indices = iData.data();
-	std::vector<bool> multiNeighbors(iData.getMaxIndex(), false);
+	const ScratchScope scratch;
+	// sorted list of the corners of all faces of v; a vertex occurring more than once is a multiple neighbor of v
+	ScratchVector<unsigned int> corners;
+	corners.reserve(v.inIndex.size() * 3);
 	for(auto & elem : v.inIndex){
-		if(!n.insert(indices[elem+0]).second){
-			// has been inserted before => is a multiple neighbor of v
-			multiNeighbors[indices[elem+0]] = true;
-		}
-		if(!n.insert(indices[elem+1]).second){
-			// has been inserted before => is a multiple neighbor of v
-			multiNeighbors[indices[elem+1]] = true;
-		}
-		if(!n.insert(indices[elem + 2]).second){
-			// has been inserted before => is a multiple neighbor of v
-			multiNeighbors[indices[elem+2]] = true;
+		for(uint_fast8_t k = 0; k < 3; ++k){
+			corners.push_back(indices[elem + k]);
+			n.insert(indices[elem + k]);
 		}
 	}
+	std::sort(corners.begin(), corners.end());
+	auto isMultiNeighbor = [&corners](unsigned int index) {
+		const auto range = std::equal_range(corners.begin(), corners.end(), index);
+		return std::distance(range.first, range.second) > 1;
+	};
 
 	// build single neighbor set
 	for(auto & elem : v.inIndex){
-		if(!multiNeighbors[indices[elem+0]]){
-			// iData[*it+0] is not a multiple neighbor => add to singleNeighbors
-			singleNeighbors.insert(std::make_pair(indices[elem+0], elem));
-		}
-		if(!multiNeighbors[indices[elem+1]]){
-			// iData[*it+1] is not a multiple neighbor => add to singleNeighbors
-			singleNeighbors.insert(std::make_pair(indices[elem+1], elem));
-		}
-		if(!multiNeighbors[indices[elem+2]]){
-			// iData[*it+2] is not a multiple neighbor => add to singleNeighbors
-			singleNeighbors.insert(std::make_pair(indices[elem+2], elem));
+		for(uint_fast8_t k = 0; k < 3; ++k){
+			if(!isMultiNeighbor(indices[elem + k])){
+				// is not a multiple neighbor => add to singleNeighbors
+				singleNeighbors.insert(std::make_pair(indices[elem + k], elem));
+			}
 		}
 	}
 
@@ -520,13 +637,14 @@ static void getNeighboursOfVertex(Mesh * mesh, const vertex_t & v, Geometry::Poi
  * only compares v1, v2 and (v1+v2)/2 as new positions...
  * @return cost
  */
-static float getOptimalPosition(const vertex_t & vertexA, const vertex_t & vertexB, std::vector<float> & optPos, std::size_t dataSize, bool useOptPos){
+static float getOptimalPosition(const vertex_t & vertexA, const vertex_t & vertexB, dataArray_t & optPos, std::size_t dataSize, bool useOptPos){
 	bool optPosSuccess=false;
 	float cost = 0;
 	if(useOptPos){
 		// allocate and initiate matrix for inversion
+		const ScratchScope scratch;
 		const auto rowSize = 2 * dataSize;
-		auto mInvert = new float[dataSize * rowSize];
+		auto mInvert = scratch.getArena().allocateArray<float>(dataSize * rowSize);
 		for (std::size_t row = 0; row < dataSize; ++row) {
 			for (std::size_t col = 0; col < dataSize; ++col) {
 				const auto rowOffset = row * rowSize;
@@ -543,7 +661,6 @@ static float getOptimalPosition(const vertex_t & vertexA, const vertex_t & verte
 			// matrix inversion successful
 			// calculate & store optimal position
 			// Optimal position vBar = - A^-1 b
-			optPos.resize(dataSize);
 			for (uint_fast8_t row = 0; row < dataSize; ++row) {
 				const uint_fast8_t rowOffset = row * rowSize + dataSize;
 
@@ -564,9 +681,6 @@ static float getOptimalPosition(const vertex_t & vertexA, const vertex_t & verte
 				cost -= sum * (vertexA.q.b[col] + vertexB.q.b[col]);
 			}
 		}
-
-		// free matrix memory
-		delete[] mInvert;
 	}
 	if(!optPosSuccess){
 		// matrix is not invertible => get best position of v1, v2 and (v1+v2)/2
@@ -584,52 +698,53 @@ static float getOptimalPosition(const vertex_t & vertexA, const vertex_t & verte
 		// use minimum of v1 and v2 as optimal position
 		if(costV1<costV2 && costV1<costV1V2div2){
 			cost = costV1;
-			optPos = vertexA.data;
+			std::copy(vertexA.data.begin(), vertexA.data.end(), optPos.begin());
 		}else if(costV2<costV1 && costV2<costV1V2div2){
 			cost = costV2;
-			optPos = vertexB.data;
+			std::copy(vertexB.data.begin(), vertexB.data.end(), optPos.begin());
 		} else{
 			cost = costV1V2div2;
-			optPos = sumData;
+			std::copy(sumData.begin(), sumData.end(), optPos.begin());
 		}
 	}
 	return cost;
 }
 
-Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold, bool useOptimalPositioning, float maxAngle, const weights_t & weights) {
-	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
-		WARN("Mesh simplification can only be done with triangle meshes.");
-		return mesh;
-	}
-	if(mesh->getPrimitiveCount() <= newNumberOfTriangles) {
-		WARN("Mesh already has less or equal as many triangles as requested.");
-		return mesh;
-	}
-	Util::info<<"\nSimplifying mesh from "<<mesh->getPrimitiveCount()<<" to "<<newNumberOfTriangles<<" triangles; threshold: "<<threshold<<"; optPos: "<<useOptimalPositioning<<"\n";
-	Util::info<<"Weights are: vertex="<<weights[0]<<" normal="<<weights[1]<<" color="<<weights[2]<<" tex0="<<weights[3]<<" boundary="<<weights[4]<<"\n";
-	Util::ProgressIndicator progress("Simplify progress",(mesh->getPrimitiveCount()-newNumberOfTriangles)+mesh->getPrimitiveCount()+3*mesh->getVertexCount(), 2);
-	Util::Timer timer;
-	timer.reset();
-
+/**
+ * Simplify the given triangle mesh and store the result in @p vertexData and @p indexData.
+ * The vertex data still contains the removed vertices; they are not referenced by the index data anymore.
+ * Pairs containing a vertex marked in @p lockedVertices are never contracted (if the vector is not empty).
+ * The function does not use any global state, so it may be called concurrently for different meshes.
+ * @return @c false if the mesh could not be simplified.
+ */
+static bool simplifyData(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold, bool useOptimalPositioning, float maxAngle, const weights_t & weights,
+						 const std::vector<bool> & lockedVertices,
+						 Util::ProgressIndicator * progress,
+						 MeshVertexData & vertexData,
+						 MeshIndexData & indexData,
+						 int & flipcount) {
+	auto isLocked = [&lockedVertices](unsigned int v) {
+		return !lockedVertices.empty() && lockedVertices[v];
+	};
 	// initialize vertex array
 	const Geometry::Box & meshBB = mesh->getBoundingBox();
 	const float octreeBoxMax = std::max(std::max(meshBB.getMaxX(), meshBB.getMaxY()), meshBB.getMaxZ()) * weights[VERTEX_OFFSET];
 	const float octreeBoxMin = std::min(std::min(meshBB.getMinX(), meshBB.getMinY()), meshBB.getMinZ()) * weights[VERTEX_OFFSET];
 	const Geometry::Box octreeBox(octreeBoxMin, octreeBoxMax, octreeBoxMin, octreeBoxMax, octreeBoxMin, octreeBoxMax);
 	threshold *= weights[VERTEX_OFFSET];
-	Geometry::PointOctree<VertexPoint> * vertexOctree = nullptr;
+	std::unique_ptr<Geometry::PointOctree<VertexPoint>> vertexOctree;
 	if(threshold > 0.0f) {
-		vertexOctree = new Geometry::PointOctree<VertexPoint>(octreeBox, threshold, 100);
+		vertexOctree.reset(new Geometry::PointOctree<VertexPoint>(octreeBox, threshold, 100));
 	}
 	std::vector<vertex_t> vertices;
-	const auto numDataEntries = initVertexArray(mesh, progress, weights, vertices, vertexOctree);
+	const auto numDataEntries = initVertexArray(mesh, progress, weights, vertices, vertexOctree.get());
 	if(numDataEntries == 0) {
 		WARN("Vertex data does not contain readable information, or weights prevent the data usage.");
-		return mesh;
+		return false;
 	}
 
 	// build heap
-	Util::UpdatableHeap<float, heapData> heap;
+	EdgeHeap heap;
 
 	const uint32_t vertexCount = mesh->getVertexCount();
 	MeshIndexData iData = mesh->openIndexData();
@@ -642,7 +757,7 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 		std::vector<float> v3(numDataEntries, 0.0f);
 		for(unsigned int i=0; i<vertexCount; ++i){
 			std::set<std::pair<unsigned int, unsigned int> > singleNeighbors;
-			getNeighboursOfVertex(mesh, vertices[i], vertexOctree, threshold, vertices[i].neighbors, singleNeighbors);
+			getNeighboursOfVertex(mesh, vertices[i], vertexOctree.get(), threshold, vertices[i].neighbors, singleNeighbors);
 
 			if(weights[BOUNDARY_OFFSET] && weights[VERTEX_OFFSET]){
 				// make sure to add a boundary plan to only once to both vertices i and *singleNeighborIterator.first by checking first<i
@@ -674,7 +789,9 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 					vertices[singleNeighborIterator->first].q += tmpQ;
 				}
 			}
-			progress.increment();
+			if(progress != nullptr) {
+				progress->increment();
+			}
 			// singleNeighbors is destroyed here
 		}
 	}
@@ -682,19 +799,27 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 	// build heap
 	for(unsigned int i=0; i<vertexCount; ++i){
 		// add unique neighbors to heap (by adding only pairs of (i,j) where i<j)
+		// locked vertices never become part of a pair; as pairs are only redirected to the remaining vertex during the merges, this holds until the end
+		if(isLocked(i)) {
+			continue;
+		}
 		for(auto it=vertices[i].neighbors.upper_bound(i); it!=vertices[i].neighbors.end(); ++it){
+			if(isLocked(*it)) {
+				continue;
+			}
 			heapData hd(i, *it);
 			float cost = getOptimalPosition(vertices[i], vertices[*it], hd.optPos, numDataEntries, useOptimalPositioning);
-			heapElement *h = heap.insert(cost, hd);
+			const uint32_t h = heap.insert(cost, hd);
 			vertices[i].inHeap.insert(h);
 			vertices[*it].inHeap.insert(h);
 		}
-		progress.increment();
+		if(progress != nullptr) {
+			progress->increment();
+		}
 	}
 
 
 	// merge vertices
-	int flipcount = 0;
 	std::unordered_set<unsigned int> indexTrash;
 	std::vector<unsigned int> vertexTrash;
 	// rough estimate of the number of vertices that will be removed
@@ -702,10 +827,12 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 	unsigned int newTriangleCount = mesh->getPrimitiveCount();
 
 	{
-		while(newTriangleCount>newNumberOfTriangles && heap.size()!=0 && heap.top()->getCost()!=DONT_MERGE_COST /*&& iteration<threshold*/){
-			heapElement *heapHead = heap.top();
-			heapData &topData = heapHead->data;
-			std::set<heapElement*> heapTrash;
+		while(newTriangleCount>newNumberOfTriangles && heap.size()!=0 && heap.getCost(heap.top())!=DONT_MERGE_COST /*&& iteration<threshold*/){
+			const uint32_t heapHead = heap.top();
+			heapData &topData = heap.getData(heapHead);
+			// the set's nodes are released in bulk at the end of the iteration
+			const ScratchScope iterationScratch;
+			std::set<uint32_t, std::less<uint32_t>, ScratchAllocator<uint32_t>> heapTrash;
 
 			if(maxAngle != -1) {
 				// check if some normal flips
@@ -808,7 +935,7 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 			vertexTrash.push_back(topData.vertex2);
 
 			// update data of vertex1 to data of merged vertex
-			vertices[topData.vertex1].data = topData.optPos;
+			vertices[topData.vertex1].data.assign(topData.optPos.begin(), topData.optPos.begin() + numDataEntries);
 
 			// update indexData of vertex2 to vertex1 and inIndex of vertex1
 			for(const auto & triIndex : vertices[topData.vertex2].inIndex) {
@@ -828,7 +955,9 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 						}
 
 						--newTriangleCount;
-						progress.increment();
+						if(progress != nullptr) {
+							progress->increment();
+						}
 					}
 				} else {
 					// only vertex2 is used in this triangle => update vertex2 to vertex1
@@ -851,25 +980,26 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 
 			// update heap by replacing vertex2 by vertex1
 			for(auto & elem : vertices[topData.vertex2].inHeap) {
+				heapData & elemData = heap.getData(elem);
 				// update heapHead->vertex2 in heapElement to heapHead->vertex1 and make sure that heapElements are unique
-				if(elem->data.vertex1==topData.vertex2) {
+				if(elemData.vertex1==topData.vertex2) {
 					// update vertex1 of heapElement
-					if(vertices[topData.vertex1].neighbors.insert(elem->data.vertex2).second) {
+					if(vertices[topData.vertex1].neighbors.insert(elemData.vertex2).second) {
 						// new neighbor has been added => update heap normally
-						vertices[elem->data.vertex2].neighbors.insert(topData.vertex1);
+						vertices[elemData.vertex2].neighbors.insert(topData.vertex1);
 						vertices[topData.vertex1].inHeap.insert(elem);
-						elem->data.vertex1 = topData.vertex1;
+						elemData.vertex1 = topData.vertex1;
 					} else {
 						// neighbors already existed => delete this heapElement so preserve uniqueness
 						heapTrash.insert(elem);
 					}
 				}else{
 					// update vertex2 of heapElement
-					if(vertices[topData.vertex1].neighbors.insert(elem->data.vertex1).second) {
+					if(vertices[topData.vertex1].neighbors.insert(elemData.vertex1).second) {
 						// new neighbor has been added => update heap normally
-						vertices[elem->data.vertex1].neighbors.insert(topData.vertex1);
+						vertices[elemData.vertex1].neighbors.insert(topData.vertex1);
 						vertices[topData.vertex1].inHeap.insert(elem);
-						elem->data.vertex2 = topData.vertex1;
+						elemData.vertex2 = topData.vertex1;
 					} else {
 						// neighbors already existed => delete this heapElement so preserve uniqueness
 						heapTrash.insert(elem);
@@ -884,26 +1014,28 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 			for(auto & elem : vertices[topData.vertex1].inHeap) {
 				// only update heapElement if it will not be deleted
 				if(heapTrash.count(elem) == 0) {
-					float cost = getOptimalPosition(vertices[elem->data.vertex1], vertices[elem->data.vertex2], elem->data.optPos, numDataEntries, useOptimalPositioning);
+					heapData & elemData = heap.getData(elem);
+					float cost = getOptimalPosition(vertices[elemData.vertex1], vertices[elemData.vertex2], elemData.optPos, numDataEntries, useOptimalPositioning);
 					heap.update(elem, cost);
 				}
 			}
 
 			// delete heapElements in heapTrash (this is including heapHead)
 			for(auto & elem : heapTrash) {
-				vertices[elem->data.vertex1].inHeap.erase(elem);
-				vertices[elem->data.vertex2].inHeap.erase(elem);
+				const heapData & elemData = heap.getData(elem);
+				vertices[elemData.vertex1].inHeap.erase(elem);
+				vertices[elemData.vertex2].inHeap.erase(elem);
 				heap.erase(elem);
 			}
 		}
 	}
 
-	if(heap.size()!=0 && heap.top()->getCost()==DONT_MERGE_COST){
+	if(heap.size()!=0 && heap.getCost(heap.top())==DONT_MERGE_COST){
 		WARN("Could not merge any more due to constraints.");
 	}
 
 	// write vertex data
-	MeshVertexData vertexData = mesh->openVertexData();
+	vertexData = MeshVertexData(mesh->openVertexData());
 	{
 		// there should be no duplicates, but the function sorts the array
 		// sorted array is needed for binary_search below
@@ -982,7 +1114,6 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 	}
 
 	// copy indices to newMesh deleting/skipping indexTrash
-	MeshIndexData indexData;
 	{
 		uint32_t newIndexCount = mesh->getIndexCount() - indexTrash.size() * 3;
 		indexData.allocate(newIndexCount);
@@ -997,6 +1128,30 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 			}
 		}
 	}
+	return true;
+}
+
+Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold, bool useOptimalPositioning, float maxAngle, const weights_t & weights) {
+	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+		WARN("Mesh simplification can only be done with triangle meshes.");
+		return mesh;
+	}
+	if(mesh->getPrimitiveCount() <= newNumberOfTriangles) {
+		WARN("Mesh already has less or equal as many triangles as requested.");
+		return mesh;
+	}
+	Util::info<<"\nSimplifying mesh from "<<mesh->getPrimitiveCount()<<" to "<<newNumberOfTriangles<<" triangles; threshold: "<<threshold<<"; optPos: "<<useOptimalPositioning<<"\n";
+	Util::info<<"Weights are: vertex="<<weights[0]<<" normal="<<weights[1]<<" color="<<weights[2]<<" tex0="<<weights[3]<<" boundary="<<weights[4]<<"\n";
+	Util::ProgressIndicator progress("Simplify progress",(mesh->getPrimitiveCount()-newNumberOfTriangles)+mesh->getPrimitiveCount()+3*mesh->getVertexCount(), 2);
+	Util::Timer timer;
+	timer.reset();
+
+	MeshVertexData vertexData;
+	MeshIndexData indexData;
+	int flipcount = 0;
+	if(!simplifyData(mesh, newNumberOfTriangles, threshold, useOptimalPositioning, maxAngle, weights, std::vector<bool>(), &progress, vertexData, indexData, flipcount)) {
+		return mesh;
+	}
 
 	Util::Reference<Mesh> newMesh = new Mesh(std::move(indexData), std::move(vertexData));
 
@@ -1011,6 +1166,198 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 	return returnMesh;
 }
 
+Mesh * simplifyMeshParallel(Mesh * mesh,
+							uint32_t numberOfTriangles,
+							float threshold,
+							bool useOptimalPositioning,
+							float maxAngle,
+							const weights_t & weights,
+							uint32_t numThreads) {
+	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+		WARN("Mesh simplification can only be done with triangle meshes.");
+		return mesh;
+	}
+	if(mesh->getPrimitiveCount() <= numberOfTriangles) {
+		WARN("Mesh already has less or equal as many triangles as requested.");
+		return mesh;
+	}
+	if(numThreads == 0) {
+		numThreads = TaskScheduler::get().getConcurrency();
+	}
+	// the number of partitions is the next power of two of the number of threads
+	uint32_t depth = 0;
+	while((1u << depth) < numThreads) {
+		++depth;
+	}
+	const uint32_t numPartitions = 1u << depth;
+	const uint32_t numTriangles = mesh->getPrimitiveCount();
+	static const uint32_t MIN_PARTITION_SIZE = 1024;
+	if(numPartitions < 2 || numTriangles < numPartitions * MIN_PARTITION_SIZE) {
+		return simplifyMesh(mesh, numberOfTriangles, threshold, useOptimalPositioning, maxAngle, weights);
+	}
+
+	const MeshVertexData & vData = mesh->openVertexData();
+	const MeshIndexData & iData = mesh->openIndexData();
+	const uint32_t vertexCount = vData.getVertexCount();
+	const std::size_t vertexSize = vData.getVertexDescription().getVertexSize();
+
+	// partition the triangles by recursively splitting their centroids at the median of the longest axis
+	std::vector<Geometry::Vec3f> centroids;
+	centroids.reserve(numTriangles);
+	{
+		Util::Reference<PositionAttributeAccessor> positionAccessor;
+		try {
+			positionAccessor = PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION);
+		} catch(...) {
+			return simplifyMesh(mesh, numberOfTriangles, threshold, useOptimalPositioning, maxAngle, weights);
+		}
+		for(uint32_t t = 0; t < numTriangles; ++t) {
+			centroids.push_back((positionAccessor->getPosition(iData[3 * t + 0])
+									+ positionAccessor->getPosition(iData[3 * t + 1])
+									+ positionAccessor->getPosition(iData[3 * t + 2])) / 3.0f);
+		}
+	}
+	std::vector<uint32_t> triangleOrder(numTriangles);
+	for(uint32_t t = 0; t < numTriangles; ++t) {
+		triangleOrder[t] = t;
+	}
+	std::vector<std::pair<uint32_t, uint32_t>> ranges(1, std::make_pair(0u, numTriangles));
+	for(uint32_t level = 0; level < depth; ++level) {
+		std::vector<std::pair<uint32_t, uint32_t>> subRanges;
+		for(const auto & range : ranges) {
+			Geometry::Vec3f minCorner = centroids[triangleOrder[range.first]];
+			Geometry::Vec3f maxCorner = minCorner;
+			for(uint32_t i = range.first; i < range.second; ++i) {
+				const auto & centroid = centroids[triangleOrder[i]];
+				for(uint_fast8_t axis = 0; axis < 3; ++axis) {
+					minCorner[axis] = std::min(minCorner[axis], centroid[axis]);
+					maxCorner[axis] = std::max(maxCorner[axis], centroid[axis]);
+				}
+			}
+			const auto extent = maxCorner - minCorner;
+			const uint_fast8_t axis = (extent.getX() >= extent.getY() && extent.getX() >= extent.getZ()) ? 0 : (extent.getY() >= extent.getZ() ? 1 : 2);
+			const uint32_t middle = range.first + (range.second - range.first) / 2;
+			std::nth_element(triangleOrder.begin() + range.first, triangleOrder.begin() + middle, triangleOrder.begin() + range.second,
+							 [&centroids, axis](uint32_t a, uint32_t b) {
+								return centroids[a][axis] < centroids[b][axis];
+							 });
+			subRanges.emplace_back(range.first, middle);
+			subRanges.emplace_back(middle, range.second);
+		}
+		ranges.swap(subRanges);
+	}
+	centroids.clear();
+
+	// vertices used by more than one partition are locked during the parallel phase
+	const uint32_t INVALID_PARTITION = std::numeric_limits<uint32_t>::max();
+	std::vector<uint32_t> vertexPartition(vertexCount, INVALID_PARTITION);
+	std::vector<bool> boundaryVertices(vertexCount, false);
+	for(uint32_t p = 0; p < numPartitions; ++p) {
+		for(uint32_t i = ranges[p].first; i < ranges[p].second; ++i) {
+			for(uint_fast8_t k = 0; k < 3; ++k) {
+				const uint32_t v = iData[3 * triangleOrder[i] + k];
+				if(vertexPartition[v] == INVALID_PARTITION) {
+					vertexPartition[v] = p;
+				} else if(vertexPartition[v] != p) {
+					boundaryVertices[v] = true;
+				}
+			}
+		}
+	}
+
+	struct Partition {
+		//! Global indices of the partition's vertices (sorted)
+		std::vector<uint32_t> vertices;
+		MeshVertexData vertexData;
+		MeshIndexData indexData;
+	};
+	std::vector<Partition> partitions(numPartitions);
+	std::atomic<uint32_t> nextPartition(0);
+	auto simplifyPartitions = [&]() {
+		for(uint32_t p = nextPartition++; p < numPartitions; p = nextPartition++) {
+			Partition & partition = partitions[p];
+			const uint32_t partitionTriangles = ranges[p].second - ranges[p].first;
+			for(uint32_t i = ranges[p].first; i < ranges[p].second; ++i) {
+				for(uint_fast8_t k = 0; k < 3; ++k) {
+					partition.vertices.push_back(iData[3 * triangleOrder[i] + k]);
+				}
+			}
+			make_unique(partition.vertices);
+			const uint32_t partitionVertices = static_cast<uint32_t>(partition.vertices.size());
+
+			MeshVertexData subVertexData;
+			subVertexData.allocate(partitionVertices, vData.getVertexDescription());
+			std::vector<bool> lockedVertices(partitionVertices);
+			for(uint32_t v = 0; v < partitionVertices; ++v) {
+				std::copy(vData[partition.vertices[v]], vData[partition.vertices[v]] + vertexSize, subVertexData[v]);
+				lockedVertices[v] = boundaryVertices[partition.vertices[v]];
+			}
+			subVertexData.updateBoundingBox();
+			MeshIndexData subIndexData;
+			subIndexData.allocate(3 * partitionTriangles);
+			uint32_t * subIndices = subIndexData.data();
+			for(uint32_t i = ranges[p].first; i < ranges[p].second; ++i) {
+				for(uint_fast8_t k = 0; k < 3; ++k) {
+					const auto it = std::lower_bound(partition.vertices.begin(), partition.vertices.end(), iData[3 * triangleOrder[i] + k]);
+					*subIndices++ = static_cast<uint32_t>(std::distance(partition.vertices.begin(), it));
+				}
+			}
+			subIndexData.updateIndexRange();
+			Util::Reference<Mesh> subMesh = new Mesh(std::move(subIndexData), std::move(subVertexData));
+
+			const uint32_t target = static_cast<uint32_t>(static_cast<uint64_t>(partitionTriangles) * numberOfTriangles / numTriangles);
+			int flipcount = 0;
+			if(!simplifyData(subMesh.get(), target, threshold, useOptimalPositioning, maxAngle, weights, lockedVertices, nullptr,
+							 partition.vertexData, partition.indexData, flipcount)) {
+				partition.vertexData = MeshVertexData(subMesh->openVertexData());
+				partition.indexData = MeshIndexData(subMesh->openIndexData());
+			}
+		}
+	};
+	TaskScheduler & scheduler = TaskScheduler::get();
+	TaskScheduler::TaskGroup group;
+	for(uint32_t t = 1; t < numThreads; ++t) {
+		scheduler.run(group, simplifyPartitions, "MeshUtils::simplifyMesh");
+	}
+	simplifyPartitions();
+	scheduler.wait(group);
+
+	// stitch the partitions: locked vertices are unchanged and therefore identical in all partitions
+	MeshVertexData mergedVertexData(vData);
+	uint32_t mergedIndexCount = 0;
+	for(const auto & partition : partitions) {
+		mergedIndexCount += partition.indexData.getIndexCount();
+	}
+	MeshIndexData mergedIndexData;
+	mergedIndexData.allocate(mergedIndexCount);
+	uint32_t * mergedIndices = mergedIndexData.data();
+	for(const auto & partition : partitions) {
+		for(uint32_t v = 0; v < partition.vertices.size(); ++v) {
+			if(!boundaryVertices[partition.vertices[v]]) {
+				std::copy(partition.vertexData[v], partition.vertexData[v] + vertexSize, mergedVertexData[partition.vertices[v]]);
+			}
+		}
+		for(uint32_t i = 0; i < partition.indexData.getIndexCount(); ++i) {
+			*mergedIndices++ = partition.vertices[partition.indexData[i]];
+		}
+	}
+	mergedVertexData.markAsChanged();
+	mergedVertexData.updateBoundingBox();
+	mergedIndexData.updateIndexRange();
+	Util::Reference<Mesh> mergedMesh = new Mesh(std::move(mergedIndexData), std::move(mergedVertexData));
+	Util::Reference<Mesh> compactMesh = MeshUtils::eliminateUnusedVertices(mergedMesh.get());
+	mergedMesh = nullptr;
+
+	// final serial pass over the whole mesh, which also simplifies the seams between the partitions
+	if(compactMesh->getPrimitiveCount() > numberOfTriangles) {
+		Mesh * result = simplifyMesh(compactMesh.get(), numberOfTriangles, threshold, useOptimalPositioning, maxAngle, weights);
+		if(result != compactMesh.get()) {
+			return result;
+		}
+	}
+	return compactMesh.detachAndDecrease();
+}
+
 }
 }
 }
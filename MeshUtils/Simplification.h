@@ -48,6 +48,51 @@ Mesh * simplifyMesh(Mesh * mesh,
 					float maxAngle, 
 					const weights_t & weights);
 
+/**
+ * Multithreaded variant of simplifyMesh().
+ * The triangles are partitioned spatially into (at least) @p numThreads parts, which are simplified concurrently.
+ * Vertices shared by several partitions are locked during this phase. Afterwards, a serial pass over the
+ * stitched mesh simplifies the seams and reduces the mesh to the requested number of triangles.
+ * Small meshes are simplified by simplifyMesh() directly.
+ *
+ * @param numThreads number of threads to use; @c 0 uses the number of hardware threads
+ * @see simplifyMesh for a description of the other parameters
+ */
+Mesh * simplifyMeshParallel(Mesh * mesh,
+							uint32_t numberOfTriangles,
+							float threshold,
+							bool useOptimalPositioning,
+							float maxAngle,
+							const weights_t & weights,
+							uint32_t numThreads = 0);
+
+/**
+ * Fast, low quality simplification by vertex clustering.
+ * The vertices are sorted into a uniform grid of cubic cells; all vertices of a cell are merged into one vertex
+ * positioned at the minimum of the summed quadrics of the cell's triangles (or at the mean position, if that
+ * minimum is not well defined or lies outside of the cell). The other attributes are taken from the vertex closest to
+ * that position. Triangles collapsing to a line or a point are removed. The running time is linear in the size of the
+ * mesh and the work is distributed over the TaskScheduler.
+ * The mesh has to be an indexed triangle mesh. This method will return a new mesh and leave the original unchanged.
+ *
+ * @param mesh Mesh to be simplified
+ * @param gridResolution number of cells along the longest side of the mesh's bounding box
+ * @return new simplified mesh, null if simplification failed
+ */
+Mesh * simplifyMeshByClustering(Mesh * mesh, uint32_t gridResolution);
+
+/**
+ * Variant of simplifyMeshByClustering() choosing the cell size so that no vertex moves farther than @p maxError.
+ */
+Mesh * simplifyMeshByClusteringError(Mesh * mesh, float maxError);
+
+/**
+ * Variant of simplifyMeshByClustering() searching a grid resolution resulting in at most (and close to)
+ * @p numberOfTriangles triangles. The mesh is clustered up to six times.
+ * If the mesh already has less triangles, it is returned unchanged.
+ */
+Mesh * simplifyMeshByClusteringToTriangleCount(Mesh * mesh, uint32_t numberOfTriangles);
+
 }
 }
 }
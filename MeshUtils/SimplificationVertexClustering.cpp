@@ -0,0 +1,365 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2013 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "Simplification.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeAccessors.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexDescription.h"
+#include "../TaskScheduler.h"
+#include "internal/ParallelFor.h"
+#include <Geometry/Box.h>
+#include <Geometry/Vec3.h>
+#include <Util/Macros.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace Rendering {
+namespace MeshUtils {
+namespace Simplification {
+namespace {
+
+static const uint64_t EMPTY_CELL = std::numeric_limits<uint64_t>::max();
+static const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+//! Upper bound for the memory of the per-thread accumulation buffers.
+static const size_t MAX_ACCUMULATION_MEMORY = 64 * 1024 * 1024;
+
+//! Accumulated plane quadric (upper triangle of the symmetric 4x4 matrix) and vertex positions of a cluster.
+struct ClusterData {
+	// a², ab, ac, ad, b², bc, bd, c², cd, d²
+	std::array<double, 10> q;
+	std::array<double, 3> positionSum;
+	uint32_t vertexCount;
+	ClusterData() : q(), positionSum(), vertexCount(0) {}
+	void add(const ClusterData & other) {
+		for(uint_fast8_t i = 0; i < 10; ++i)
+			q[i] += other.q[i];
+		for(uint_fast8_t i = 0; i < 3; ++i)
+			positionSum[i] += other.positionSum[i];
+		vertexCount += other.vertexCount;
+	}
+};
+
+uint64_t hashCell(uint64_t key) {
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdull;
+	key ^= key >> 33;
+	return key;
+}
+
+/*! Minimize the quadric inside of the cell [cellMin, cellMin + cellSize]. If the system is ill-conditioned or its solution is outside
+	of the cell (e.g. for flat or sharp clusters), the mean of the cluster's vertices is used. */
+Geometry::Vec3 getRepresentative(const ClusterData & data, const Geometry::Vec3 & cellMin, float cellSize) {
+	const std::array<double, 10> & q = data.q;
+	const double a00 = q[0], a01 = q[1], a02 = q[2], a11 = q[4], a12 = q[5], a22 = q[7];
+	const double b0 = -q[3], b1 = -q[6], b2 = -q[8];
+	const double c00 = a11 * a22 - a12 * a12;
+	const double c01 = a02 * a12 - a01 * a22;
+	const double c02 = a01 * a12 - a02 * a11;
+	const double det = a00 * c00 + a01 * c01 + a02 * c02;
+	const double trace = a00 + a11 + a22;
+	if(trace > 0.0 && std::abs(det) > 1.0e-6 * trace * trace * trace) {
+		const double c11 = a00 * a22 - a02 * a02;
+		const double c12 = a01 * a02 - a00 * a12;
+		const double c22 = a00 * a11 - a01 * a01;
+		const Geometry::Vec3 x(static_cast<float>((c00 * b0 + c01 * b1 + c02 * b2) / det),
+							   static_cast<float>((c01 * b0 + c11 * b1 + c12 * b2) / det),
+							   static_cast<float>((c02 * b0 + c12 * b1 + c22 * b2) / det));
+		bool inside = true;
+		for(uint_fast8_t dim = 0; dim < 3; ++dim)
+			inside = inside && x[dim] >= cellMin[dim] && x[dim] <= cellMin[dim] + cellSize;
+		if(inside)
+			return x;
+	}
+	const double scale = data.vertexCount > 0 ? 1.0 / data.vertexCount : 0.0;
+	return Geometry::Vec3(static_cast<float>(data.positionSum[0] * scale), static_cast<float>(data.positionSum[1] * scale),
+						  static_cast<float>(data.positionSum[2] * scale));
+}
+
+//! Cluster the vertices of @p mesh in a grid of cubic cells with edge length @p cellSize.
+Mesh * clusterVertices(Mesh * mesh, float cellSize) {
+	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES || !mesh->isUsingIndexData()) {
+		WARN("Vertex clustering can only be done with indexed triangle meshes.");
+		return nullptr;
+	}
+	if(!(cellSize > 0.0f)) {
+		WARN("Vertex clustering requires a positive cell size.");
+		return nullptr;
+	}
+	MeshVertexData & vertexData = mesh->openVertexData();
+	const MeshIndexData & indexData = mesh->openIndexData();
+	const uint32_t vertexCount = vertexData.getVertexCount();
+	const uint32_t numTriangles = indexData.getIndexCount() / 3;
+	const uint32_t * const indices = indexData.data();
+	const Geometry::Box bb = vertexData.getBoundingBox();
+	const Geometry::Vec3 origin = bb.getMin();
+	// at most 2^21 cells per axis, so the cell coordinates fit into a 64 bit key
+	std::array<uint64_t, 3> cellCounts;
+	for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+		const float extent = bb.getMax()[dim] - bb.getMin()[dim];
+		cellCounts[dim] = static_cast<uint64_t>(std::min(std::max(std::ceil(extent / cellSize), 1.0f), 2097152.0f));
+	}
+
+	// cell of every vertex
+	Util::Reference<PositionAttributeAccessor> positionAccessor = PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION);
+	const PositionAttributeAccessor * positions = positionAccessor.get();
+	std::vector<Geometry::Vec3> vertexPositions(vertexCount);
+	std::vector<uint64_t> cellKeys(vertexCount);
+	parallelFor(vertexCount, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t i = begin; i < end; ++i) {
+			const Geometry::Vec3 p = positions->getPosition(i);
+			vertexPositions[i] = p;
+			uint64_t key = 0;
+			for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+				const float c = std::floor((p[dim] - origin[dim]) / cellSize);
+				const uint64_t cell = c > 0.0f ? std::min(static_cast<uint64_t>(c), cellCounts[dim] - 1) : 0; // also clamps NaN
+				key = (key << 21) | cell;
+			}
+			cellKeys[i] = key;
+		}
+	});
+
+	// number the occupied cells using a lock-free hash table (linear probing)
+	uint32_t tableSize = 1;
+	while(tableSize < 2 * static_cast<uint64_t>(vertexCount) && tableSize < (1u << 31))
+		tableSize <<= 1;
+	const uint32_t tableMask = tableSize - 1;
+	std::unique_ptr<std::atomic<uint64_t>[]> table(new std::atomic<uint64_t>[tableSize]);
+	parallelFor(tableSize, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t s = begin; s < end; ++s)
+			table[s].store(EMPTY_CELL, std::memory_order_relaxed);
+	});
+	std::vector<uint32_t> vertexClusters(vertexCount);
+	parallelFor(vertexCount, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t i = begin; i < end; ++i) {
+			const uint64_t key = cellKeys[i];
+			for(uint32_t slot = static_cast<uint32_t>(hashCell(key)) & tableMask;; slot = (slot + 1) & tableMask) {
+				uint64_t expected = EMPTY_CELL;
+				if(table[slot].compare_exchange_strong(expected, key, std::memory_order_relaxed) || expected == key) {
+					vertexClusters[i] = slot;
+					break;
+				}
+			}
+		}
+	});
+	std::vector<uint32_t> clusterOfSlot(tableSize, NONE);
+	std::vector<uint64_t> clusterKeys;
+	for(uint32_t s = 0; s < tableSize; ++s) {
+		const uint64_t key = table[s].load(std::memory_order_relaxed);
+		if(key != EMPTY_CELL) {
+			clusterOfSlot[s] = static_cast<uint32_t>(clusterKeys.size());
+			clusterKeys.push_back(key);
+		}
+	}
+	table.reset();
+	const uint32_t numClusters = static_cast<uint32_t>(clusterKeys.size());
+	parallelFor(vertexCount, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t i = begin; i < end; ++i)
+			vertexClusters[i] = clusterOfSlot[vertexClusters[i]];
+	});
+	clusterOfSlot = std::vector<uint32_t>();
+
+	/* accumulate the area weighted plane quadrics of the triangles and the vertex positions of the clusters;
+		every part of the vertices and triangles writes into buffers of its own, which are summed up afterwards */
+	const uint32_t numParts = static_cast<uint32_t>(std::max<size_t>(1, std::min<size_t>(std::min<size_t>(TaskScheduler::get().getConcurrency(), numTriangles / 4096 + 1),
+			MAX_ACCUMULATION_MEMORY / (static_cast<size_t>(numClusters) * sizeof(ClusterData) + 1))));
+	std::vector<std::vector<ClusterData>> partData(numParts);
+	parallelFor(numParts, [&](uint32_t beginPart, uint32_t endPart) {
+		for(uint32_t part = beginPart; part < endPart; ++part) {
+			std::vector<ClusterData> & data = partData[part];
+			data.resize(numClusters);
+			const uint32_t firstVertex = static_cast<uint32_t>(static_cast<uint64_t>(vertexCount) * part / numParts);
+			const uint32_t endVertex = static_cast<uint32_t>(static_cast<uint64_t>(vertexCount) * (part + 1) / numParts);
+			for(uint32_t i = firstVertex; i < endVertex; ++i) {
+				ClusterData & cluster = data[vertexClusters[i]];
+				for(uint_fast8_t dim = 0; dim < 3; ++dim)
+					cluster.positionSum[dim] += vertexPositions[i][dim];
+				++cluster.vertexCount;
+			}
+			const uint32_t firstTriangle = static_cast<uint32_t>(static_cast<uint64_t>(numTriangles) * part / numParts);
+			const uint32_t endTriangle = static_cast<uint32_t>(static_cast<uint64_t>(numTriangles) * (part + 1) / numParts);
+			for(uint32_t t = firstTriangle; t < endTriangle; ++t) {
+				const uint32_t a = indices[3 * t], b = indices[3 * t + 1], c = indices[3 * t + 2];
+				const Geometry::Vec3 & pA = vertexPositions[a];
+				const Geometry::Vec3 normal = (vertexPositions[b] - pA).cross(vertexPositions[c] - pA);
+				const float doubleArea = normal.length();
+				if(!(doubleArea > 0.0f))
+					continue;
+				const double nx = normal.x() / doubleArea, ny = normal.y() / doubleArea, nz = normal.z() / doubleArea;
+				const double d = -(nx * pA.x() + ny * pA.y() + nz * pA.z());
+				const double w = 0.5 * doubleArea;
+				const std::array<double, 10> planeQuadric = {{w * nx * nx, w * nx * ny, w * nx * nz, w * nx * d, w * ny * ny,
+															  w * ny * nz, w * ny * d, w * nz * nz, w * nz * d, w * d * d}};
+				const uint32_t clusters[3] = {vertexClusters[a], vertexClusters[b], vertexClusters[c]};
+				for(uint_fast8_t corner = 0; corner < 3; ++corner) {
+					if((corner > 0 && clusters[corner] == clusters[0]) || (corner > 1 && clusters[corner] == clusters[1]))
+						continue;
+					std::array<double, 10> & q = data[clusters[corner]].q;
+					for(uint_fast8_t i = 0; i < 10; ++i)
+						q[i] += planeQuadric[i];
+				}
+			}
+		}
+	}, 1);
+
+	// representative positions
+	std::vector<ClusterData> & clusterData = partData[0];
+	std::vector<Geometry::Vec3> representatives(numClusters);
+	parallelFor(numClusters, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t c = begin; c < end; ++c) {
+			for(uint32_t part = 1; part < numParts; ++part)
+				clusterData[c].add(partData[part][c]);
+			const uint64_t key = clusterKeys[c];
+			const Geometry::Vec3 cellMin(origin.x() + static_cast<float>((key >> 42) & 0x1fffff) * cellSize,
+										 origin.y() + static_cast<float>((key >> 21) & 0x1fffff) * cellSize,
+										 origin.z() + static_cast<float>(key & 0x1fffff) * cellSize);
+			representatives[c] = getRepresentative(clusterData[c], cellMin, cellSize);
+		}
+	}, 4096);
+	partData.clear();
+
+	// the attributes of a cluster are taken from its vertex closest to the representative position
+	std::unique_ptr<std::atomic<uint64_t>[]> closestVertices(new std::atomic<uint64_t>[numClusters]);
+	for(uint32_t c = 0; c < numClusters; ++c)
+		closestVertices[c].store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+	parallelFor(vertexCount, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t i = begin; i < end; ++i) {
+			const uint32_t c = vertexClusters[i];
+			// non-negative floats keep their order when compared as integers
+			const float distance = (vertexPositions[i] - representatives[c]).lengthSquared();
+			uint32_t distanceBits;
+			std::memcpy(&distanceBits, &distance, sizeof(distanceBits));
+			const uint64_t candidate = (static_cast<uint64_t>(distanceBits) << 32) | i;
+			uint64_t current = closestVertices[c].load(std::memory_order_relaxed);
+			while(candidate < current && !closestVertices[c].compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {
+			}
+		}
+	});
+
+	// keep the triangles whose corners are in three different clusters
+	std::vector<uint32_t> keptTriangles(numParts + 1, 0);
+	std::vector<uint32_t> clusterIndices(3 * static_cast<size_t>(numTriangles));
+	parallelFor(numParts, [&](uint32_t beginPart, uint32_t endPart) {
+		for(uint32_t part = beginPart; part < endPart; ++part) {
+			const uint32_t firstTriangle = static_cast<uint32_t>(static_cast<uint64_t>(numTriangles) * part / numParts);
+			const uint32_t endTriangle = static_cast<uint32_t>(static_cast<uint64_t>(numTriangles) * (part + 1) / numParts);
+			uint32_t * out = clusterIndices.data() + 3 * static_cast<size_t>(firstTriangle);
+			for(uint32_t t = firstTriangle; t < endTriangle; ++t) {
+				const uint32_t a = vertexClusters[indices[3 * t]], b = vertexClusters[indices[3 * t + 1]], c = vertexClusters[indices[3 * t + 2]];
+				if(a == b || b == c || a == c)
+					continue;
+				*out++ = a;
+				*out++ = b;
+				*out++ = c;
+			}
+			keptTriangles[part + 1] = static_cast<uint32_t>((out - clusterIndices.data()) / 3) - firstTriangle;
+		}
+	}, 1);
+	for(uint32_t part = 0; part < numParts; ++part)
+		keptTriangles[part + 1] += keptTriangles[part];
+	const uint32_t newTriangleCount = keptTriangles[numParts];
+
+	// number the referenced clusters (in the order of their first use)
+	std::vector<uint32_t> newVertexIndices(numClusters, NONE);
+	std::vector<uint32_t> usedClusters;
+	for(uint32_t part = 0; part < numParts; ++part) {
+		const size_t first = 3 * (static_cast<uint64_t>(numTriangles) * part / numParts);
+		const size_t count = 3 * static_cast<size_t>(keptTriangles[part + 1] - keptTriangles[part]);
+		for(size_t i = first; i < first + count; ++i) {
+			uint32_t & newIndex = newVertexIndices[clusterIndices[i]];
+			if(newIndex == NONE) {
+				newIndex = static_cast<uint32_t>(usedClusters.size());
+				usedClusters.push_back(clusterIndices[i]);
+			}
+		}
+	}
+
+	const VertexDescription & desc = vertexData.getVertexDescription();
+	const size_t vertexSize = desc.getVertexSize();
+	const uint32_t newVertexCount = static_cast<uint32_t>(usedClusters.size());
+	auto result = new Mesh(desc, newVertexCount, 3 * newTriangleCount);
+	MeshVertexData & newVertexData = result->_getVertexData();
+	Util::Reference<PositionAttributeAccessor> newPositions = PositionAttributeAccessor::create(newVertexData, VertexAttributeIds::POSITION);
+	parallelFor(newVertexCount, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t v = begin; v < end; ++v) {
+			const uint32_t c = usedClusters[v];
+			const uint32_t source = static_cast<uint32_t>(closestVertices[c].load(std::memory_order_relaxed) & 0xffffffffu);
+			std::copy(vertexData[source], vertexData[source] + vertexSize, newVertexData[v]);
+			newPositions->setPosition(v, representatives[c]);
+		}
+	});
+	MeshIndexData & newIndexData = result->_getIndexData();
+	uint32_t * const newIndices = newIndexData.data();
+	parallelFor(numParts, [&](uint32_t beginPart, uint32_t endPart) {
+		for(uint32_t part = beginPart; part < endPart; ++part) {
+			const uint32_t * in = clusterIndices.data() + 3 * (static_cast<uint64_t>(numTriangles) * part / numParts);
+			for(size_t i = 3 * static_cast<size_t>(keptTriangles[part]); i < 3 * static_cast<size_t>(keptTriangles[part + 1]); ++i)
+				newIndices[i] = newVertexIndices[*in++];
+		}
+	}, 1);
+	newVertexData.updateBoundingBox();
+	newIndexData.updateIndexRange();
+	return result;
+}
+
+}
+
+Mesh * simplifyMeshByClustering(Mesh * mesh, uint32_t gridResolution) {
+	const Geometry::Box & bb = mesh->getBoundingBox();
+	const float extent = bb.getExtentMax();
+	if(gridResolution == 0 || !(extent > 0.0f)) {
+		WARN("Vertex clustering requires a grid resolution > 0 and a mesh with an extent.");
+		return nullptr;
+	}
+	return clusterVertices(mesh, extent / gridResolution);
+}
+
+Mesh * simplifyMeshByClusteringError(Mesh * mesh, float maxError) {
+	// a vertex stays inside of its cell, so it moves by at most the diagonal of the cell
+	return clusterVertices(mesh, maxError / std::sqrt(3.0f));
+}
+
+Mesh * simplifyMeshByClusteringToTriangleCount(Mesh * mesh, uint32_t numberOfTriangles) {
+	if(mesh->getPrimitiveCount() <= numberOfTriangles) {
+		WARN("Mesh already has less or equal as many triangles as requested.");
+		return mesh;
+	}
+	// the number of triangles of a clustered surface grows with the square of the grid resolution
+	float resolution = std::max(2.0f, std::sqrt(static_cast<float>(numberOfTriangles) / 2.0f));
+	Util::Reference<Mesh> best;
+	Util::Reference<Mesh> smallest;
+	for(uint_fast8_t iteration = 0; iteration < 6; ++iteration) {
+		Util::Reference<Mesh> result = simplifyMeshByClustering(mesh, static_cast<uint32_t>(std::max(1.0f, resolution)));
+		if(result.isNull())
+			return nullptr;
+		const uint32_t count = result->getPrimitiveCount();
+		if(smallest.isNull() || count < smallest->getPrimitiveCount())
+			smallest = result;
+		if(count <= numberOfTriangles && (best.isNull() || count > best->getPrimitiveCount()))
+			best = result;
+		if(count == 0 || (count <= numberOfTriangles && count >= numberOfTriangles * 0.8f) || resolution <= 1.0f)
+			break;
+		resolution *= std::sqrt(static_cast<float>(numberOfTriangles) / count) * (count > numberOfTriangles ? 0.95f : 1.0f);
+	}
+	return best.isNotNull() ? best.detachAndDecrease() : smallest.detachAndDecrease();
+}
+
+}
+}
+}
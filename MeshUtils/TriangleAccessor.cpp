@@ -12,6 +12,7 @@
 #include "../Mesh/Mesh.h"
 #include "../Mesh/MeshIndexData.h"
 #include "../Mesh/MeshVertexData.h"
+#include "../Mesh/TypedAttributeView.h"
 #include "../Mesh/VertexAttributeAccessors.h"
 #include "../Mesh/VertexAttributeIds.h"
 
@@ -20,6 +21,8 @@
 #include <Geometry/Vec3.h>
 #include <Geometry/Triangle.h>
 
+#include <algorithm>
+
 namespace Rendering {
 namespace MeshUtils {
 
@@ -27,7 +30,13 @@ static const std::string unimplementedFormatMsg("Mesh is not a valid triangle me
 
 TriangleAccessor::TriangleAccessor(Mesh* mesh) : indices(mesh->openIndexData()),
 		posAcc(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION)),
-		meshDataHolder(new LocalMeshDataHolder(mesh)) {
+		meshDataHolder(new LocalMeshDataHolder(mesh)), floatPositions(nullptr), positionStride(0) {
+	MeshVertexData & vertices = mesh->openVertexData();
+	const VertexAttribute & attr = vertices.getVertexDescription().getAttribute(VertexAttributeIds::POSITION);
+	if(TypedAttributeView<float, 3>::isCompatible(attr)) {
+		floatPositions = vertices.data() + vertices.getAttributeOffset(attr);
+		positionStride = vertices.getAttributeStride(attr);
+	}
 }
 
 
@@ -65,6 +74,39 @@ TriangleAccessor::TriangleIndices_t TriangleAccessor::getIndices(uint32_t index)
 	return std::make_tuple(indices[index*3+0],indices[index*3+1],indices[index*3+2]);
 }
 
+uint32_t TriangleAccessor::getTriangleCount() const {
+	return indices.getIndexCount() / 3;
+}
+
+uint32_t TriangleAccessor::getTriangles(uint32_t first, TriangleBlock & block) const {
+	const uint32_t triangleCount = getTriangleCount();
+	if(first > triangleCount)
+		assertRange(first);
+	block.first = first;
+	block.count = std::min(TriangleBlock::SIZE, triangleCount - first);
+	const uint32_t * blockIndices = static_cast<const MeshIndexData &>(indices).data() + first * 3;
+	if(floatPositions != nullptr) {
+		for(uint32_t i = 0; i < block.count; ++i) {
+			for(uint_fast8_t c = 0; c < 3; ++c) {
+				const float * p = reinterpret_cast<const float *>(floatPositions + blockIndices[i * 3 + c] * positionStride);
+				block.x[c][i] = p[0];
+				block.y[c][i] = p[1];
+				block.z[c][i] = p[2];
+			}
+		}
+	} else {
+		for(uint32_t i = 0; i < block.count; ++i) {
+			for(uint_fast8_t c = 0; c < 3; ++c) {
+				const Geometry::Vec3 p = posAcc->getPosition(blockIndices[i * 3 + c]);
+				block.x[c][i] = p.x();
+				block.y[c][i] = p.y();
+				block.z[c][i] = p.z();
+			}
+		}
+	}
+	return block.count;
+}
+
 
 
 } /* namespace MeshUtils */
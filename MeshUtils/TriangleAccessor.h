@@ -15,6 +15,8 @@
 #include <Util/References.h>
 #include <Util/ReferenceCounter.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <tuple>
 #include <memory>
 
@@ -37,6 +39,9 @@ private:
 	MeshIndexData& indices;
 	Util::Reference<PositionAttributeAccessor> posAcc;
 	std::unique_ptr<LocalMeshDataHolder> meshDataHolder;
+	//! Positions stored as (at least) three floats are read directly by getTriangles(); nullptr otherwise.
+	const uint8_t * floatPositions;
+	std::size_t positionStride;
 protected:
 	TriangleAccessor(Mesh* mesh);
 
@@ -44,6 +49,17 @@ protected:
 public:
 	typedef std::tuple<uint32_t,uint32_t,uint32_t> TriangleIndices_t;
 
+	/*! Vertex positions of up to SIZE consecutive triangles in structure-of-arrays layout: the position of the
+		corner c (0..2) of the triangle first+i is (x[c][i], y[c][i], z[c][i]). */
+	struct TriangleBlock {
+		static const uint32_t SIZE = 64;
+		uint32_t first;
+		uint32_t count;
+		alignas(16) float x[3][SIZE];
+		alignas(16) float y[3][SIZE];
+		alignas(16) float z[3][SIZE];
+	};
+
 	/*! (static factory)
 		Create a TriangleAccessor for the given Mesh.
 		If no Accessor can be created, an std::invalid_argument exception is thrown. */
@@ -55,6 +71,21 @@ public:
 	void setTriangle(uint32_t index, const Geometry::Triangle3 triangle);
 
 	TriangleIndices_t getIndices(uint32_t index) const;
+
+	//! Return the number of triangles.
+	uint32_t getTriangleCount() const;
+
+	/*! Decode the triangles [first, first + min(TriangleBlock::SIZE, getTriangleCount() - first)) into @p block.
+		Float positions are read without a virtual call per corner, so kernels over the block can be vectorized:
+		\code
+		TriangleAccessor::TriangleBlock block;
+		for(uint32_t first = 0; first < acc->getTriangleCount(); first += block.count) {
+			acc->getTriangles(first, block);
+			for(uint32_t i = 0; i < block.count; ++i) { ... block.x[0][i] ... }
+		}
+		\endcode
+		@return the number of decoded triangles (block.count) */
+	uint32_t getTriangles(uint32_t first, TriangleBlock & block) const;
 };
 
 } /* namespace MeshUtils */
@@ -0,0 +1,112 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_TRIANGLESELECTION_H_
+#define RENDERING_MESHUTILS_TRIANGLESELECTION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <set>
+#include <vector>
+
+namespace Rendering {
+namespace MeshUtils {
+
+/**
+ * Set of triangle indices stored as a dynamic bitset (one bit per triangle up to the largest selected index).
+ * Used by the selection-based MeshUtils functions (e.g. cutMesh(), extrudeTriangles()). Testing an index is a
+ * single bit lookup and iterating yields the indices in ascending order. For compatibility, a selection can be
+ * constructed implicitly from a std::set or a (not necessarily sorted) std::vector of indices.
+ */
+class TriangleSelection {
+		std::vector<uint64_t> words;
+		uint32_t numSelected;
+	public:
+		TriangleSelection() : numSelected(0) {}
+		TriangleSelection(const std::set<uint32_t> & indices) : numSelected(0) {
+			if(!indices.empty())
+				words.resize(*indices.rbegin() / 64 + 1, 0);
+			for(const auto index : indices)
+				add(index);
+		}
+		TriangleSelection(const std::vector<uint32_t> & indices) : numSelected(0) {
+			for(const auto index : indices)
+				add(index);
+		}
+		TriangleSelection(std::initializer_list<uint32_t> indices) : numSelected(0) {
+			for(const auto index : indices)
+				add(index);
+		}
+
+		//! Select the triangles [first, first + count).
+		static TriangleSelection range(uint32_t first, uint32_t count) {
+			TriangleSelection selection;
+			for(uint32_t t = first; t < first + count; ++t)
+				selection.add(t);
+			return selection;
+		}
+
+		void add(uint32_t index) {
+			if(index / 64 >= words.size())
+				words.resize(index / 64 + 1, 0);
+			uint64_t & word = words[index / 64];
+			const uint64_t bit = uint64_t(1) << (index % 64);
+			if((word & bit) == 0) {
+				word |= bit;
+				++numSelected;
+			}
+		}
+		void remove(uint32_t index) {
+			if(contains(index)) {
+				words[index / 64] &= ~(uint64_t(1) << (index % 64));
+				--numSelected;
+			}
+		}
+		bool contains(uint32_t index) const {
+			return index / 64 < words.size() && (words[index / 64] & (uint64_t(1) << (index % 64))) != 0;
+		}
+		void clear() {
+			words.clear();
+			numSelected = 0;
+		}
+
+		bool empty() const					{	return numSelected == 0;	}
+		//! Number of selected triangles.
+		uint32_t count() const				{	return numSelected;	}
+		//! Memory used by the bitset in bytes.
+		std::size_t getMemoryUsage() const	{	return words.capacity() * sizeof(uint64_t);	}
+
+		//! Call @p fun(index) for every selected index in ascending order.
+		template<typename Function>
+		void forEach(Function fun) const {
+			for(std::size_t w = 0; w < words.size(); ++w) {
+				for(uint64_t word = words[w]; word != 0; word &= word - 1) { // clear the lowest set bit
+					uint32_t bit = 0;
+					while((word & (uint64_t(1) << bit)) == 0)
+						++bit;
+					fun(static_cast<uint32_t>(w * 64 + bit));
+				}
+			}
+		}
+
+		//! Return the selected indices in ascending order.
+		std::vector<uint32_t> toVector() const {
+			std::vector<uint32_t> indices;
+			indices.reserve(numSelected);
+			forEach([&indices](uint32_t index) { indices.push_back(index); });
+			return indices;
+		}
+};
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_TRIANGLESELECTION_H_ */
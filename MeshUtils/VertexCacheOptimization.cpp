@@ -0,0 +1,332 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "VertexCacheOptimization.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeAccessors.h"
+#include "../Mesh/VertexDescription.h"
+#include <Geometry/Vec3.h>
+#include <Util/Macros.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace Rendering {
+namespace MeshUtils {
+namespace VertexCacheOptimization {
+
+static const uint32_t MAX_CACHE_SIZE = 64;
+static const uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+
+static bool checkMesh(Mesh * mesh) {
+	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES || !mesh->isUsingIndexData()) {
+		WARN("This function only works with meshes with a triangle list.");
+		return false;
+	}
+	return true;
+}
+
+//! Triangles adjacent to each vertex (compressed row storage).
+struct VertexTriangles {
+	std::vector<uint32_t> offsets; // size numVertices + 1
+	std::vector<uint32_t> triangles;
+
+	VertexTriangles(const uint32_t * indices, uint32_t numIndices, uint32_t numVertices) : offsets(numVertices + 1, 0), triangles(numIndices) {
+		for(uint32_t i = 0; i < numIndices; ++i)
+			++offsets[indices[i] + 1];
+		for(uint32_t v = 0; v < numVertices; ++v)
+			offsets[v + 1] += offsets[v];
+		std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+		for(uint32_t i = 0; i < numIndices; ++i)
+			triangles[cursor[indices[i]]++] = i / 3;
+	}
+	uint32_t count(uint32_t v) const	{	return offsets[v + 1] - offsets[v];	}
+};
+
+// ---------------------------------------------------------------------
+
+CacheStatistics analyzeVertexCache(Mesh * mesh, uint32_t cacheSize) {
+	CacheStatistics result;
+	if(!checkMesh(mesh))
+		return result;
+	MeshIndexData & id = mesh->openIndexData();
+	const uint32_t numVertices = mesh->getVertexCount();
+	const uint32_t numIndices = id.getIndexCount() - id.getIndexCount() % 3;
+	if(numIndices == 0 || numVertices == 0 || cacheSize == 0)
+		return result;
+
+	// FIFO: a vertex is cached if it has been inserted during the last cacheSize misses.
+	std::vector<uint32_t> insertionTime(numVertices, INVALID);
+	std::vector<bool> referenced(numVertices, false);
+	uint32_t misses = 0;
+	uint32_t numReferenced = 0;
+	for(uint32_t i = 0; i < numIndices; ++i) {
+		const uint32_t v = id[i];
+		if(v >= numVertices)
+			continue;
+		if(!referenced[v]) {
+			referenced[v] = true;
+			++numReferenced;
+		}
+		if(insertionTime[v] == INVALID || misses - insertionTime[v] >= cacheSize) {
+			insertionTime[v] = misses;
+			++misses;
+		}
+	}
+	result.acmr = static_cast<float>(misses) / static_cast<float>(numIndices / 3);
+	result.atvr = numReferenced == 0 ? 0.0f : static_cast<float>(misses) / static_cast<float>(numReferenced);
+	return result;
+}
+
+// ---------------------------------------------------------------------
+
+//! Vertex score of Forsyth's algorithm.
+static float getVertexScore(int32_t cachePosition, uint32_t cacheSize, uint32_t numLiveTriangles) {
+	if(numLiveTriangles == 0)
+		return -1.0f;
+	float score = 0.0f;
+	if(cachePosition >= 0) {
+		if(cachePosition < 3) { // the vertices of the last triangle
+			score = 0.75f;
+		} else {
+			const float scaler = 1.0f / static_cast<float>(cacheSize - 3);
+			score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scaler, 1.5f);
+		}
+	}
+	// bonus for vertices with few remaining triangles
+	return score + 2.0f / std::sqrt(static_cast<float>(numLiveTriangles));
+}
+
+void optimizeVertexCache(Mesh * mesh, uint32_t cacheSize) {
+	if(!checkMesh(mesh))
+		return;
+	cacheSize = std::min(MAX_CACHE_SIZE, std::max(4u, cacheSize));
+	MeshIndexData & id = mesh->openIndexData();
+	const uint32_t numVertices = mesh->getVertexCount();
+	const uint32_t numTriangles = id.getIndexCount() / 3;
+	if(numTriangles == 0)
+		return;
+	const uint32_t * indices = id.data();
+	for(uint32_t i = 0; i < numTriangles * 3; ++i) {
+		if(indices[i] >= numVertices) {
+			WARN("optimizeVertexCache: Invalid index.");
+			return;
+		}
+	}
+
+	VertexTriangles adjacency(indices, numTriangles * 3, numVertices);
+	std::vector<uint32_t> numLive(numVertices);
+	for(uint32_t v = 0; v < numVertices; ++v)
+		numLive[v] = adjacency.count(v);
+	std::vector<int32_t> cachePosition(numVertices, -1);
+	std::vector<float> vertexScore(numVertices);
+	for(uint32_t v = 0; v < numVertices; ++v)
+		vertexScore[v] = getVertexScore(-1, cacheSize, numLive[v]);
+	std::vector<float> triangleScore(numTriangles);
+	std::vector<bool> emitted(numTriangles, false);
+	uint32_t bestTriangle = INVALID;
+	float bestScore = -1.0f;
+	for(uint32_t t = 0; t < numTriangles; ++t) {
+		triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+		if(triangleScore[t] > bestScore) {
+			bestScore = triangleScore[t];
+			bestTriangle = t;
+		}
+	}
+
+	std::vector<uint32_t> output;
+	output.reserve(numTriangles * 3);
+	std::vector<uint32_t> cache, newCache;
+	cache.reserve(cacheSize + 3);
+	newCache.reserve(cacheSize + 3);
+	uint32_t scanCursor = 0;
+
+	for(uint32_t numEmitted = 0; numEmitted < numTriangles; ++numEmitted) {
+		if(bestTriangle == INVALID) { // no candidate in the cache: continue with the next triangle in input order
+			while(emitted[scanCursor])
+				++scanCursor;
+			bestTriangle = scanCursor;
+		}
+		const uint32_t t = bestTriangle;
+		emitted[t] = true;
+		newCache.clear();
+		for(uint_fast8_t k = 0; k < 3; ++k) {
+			const uint32_t v = indices[t * 3 + k];
+			output.push_back(v);
+			newCache.push_back(v);
+			// remove the triangle from the live triangles of the vertex
+			uint32_t * begin = &adjacency.triangles[adjacency.offsets[v]];
+			uint32_t * end = begin + numLive[v];
+			uint32_t * pos = std::find(begin, end, t);
+			std::swap(*pos, *(end - 1));
+			--numLive[v];
+		}
+		for(const auto v : cache) {
+			if(v != newCache[0] && v != newCache[1] && v != newCache[2])
+				newCache.push_back(v);
+		}
+		// update the scores of all vertices that were or are in the cache
+		bestTriangle = INVALID;
+		bestScore = -1.0f;
+		for(uint32_t i = 0; i < newCache.size(); ++i) {
+			const uint32_t v = newCache[i];
+			cachePosition[v] = i < cacheSize ? static_cast<int32_t>(i) : -1;
+			const float newScore = getVertexScore(cachePosition[v], cacheSize, numLive[v]);
+			const float diff = newScore - vertexScore[v];
+			vertexScore[v] = newScore;
+			const uint32_t * adjacent = &adjacency.triangles[adjacency.offsets[v]];
+			for(uint32_t j = 0; j < numLive[v]; ++j) {
+				const uint32_t adjacentTriangle = adjacent[j];
+				triangleScore[adjacentTriangle] += diff;
+				if(i < cacheSize && triangleScore[adjacentTriangle] > bestScore) {
+					bestScore = triangleScore[adjacentTriangle];
+					bestTriangle = adjacentTriangle;
+				}
+			}
+		}
+		if(newCache.size() > cacheSize)
+			newCache.resize(cacheSize);
+		cache.swap(newCache);
+	}
+	std::copy(output.begin(), output.end(), id.data());
+	id.markAsChanged();
+}
+
+// ---------------------------------------------------------------------
+
+void optimizeOverdraw(Mesh * mesh, uint32_t cacheSize, uint32_t minClusterSize) {
+	if(!checkMesh(mesh) || cacheSize == 0)
+		return;
+	MeshIndexData & id = mesh->openIndexData();
+	MeshVertexData & vd = mesh->openVertexData();
+	const uint32_t numVertices = vd.getVertexCount();
+	const uint32_t numTriangles = id.getIndexCount() / 3;
+	if(numTriangles == 0 || !vd.getVertexDescription().hasAttribute(VertexAttributeIds::POSITION))
+		return;
+	const uint32_t * indices = id.data();
+
+	// split into clusters
+	std::vector<uint32_t> clusterStarts;
+	{
+		std::vector<uint32_t> insertionTime(numVertices, INVALID);
+		uint32_t misses = 0;
+		for(uint32_t t = 0; t < numTriangles; ++t) {
+			uint32_t triangleMisses = 0;
+			for(uint_fast8_t k = 0; k < 3; ++k) {
+				const uint32_t v = indices[t * 3 + k];
+				if(v >= numVertices) {
+					WARN("optimizeOverdraw: Invalid index.");
+					return;
+				}
+				if(insertionTime[v] == INVALID || misses - insertionTime[v] >= cacheSize) {
+					insertionTime[v] = misses++;
+					++triangleMisses;
+				}
+			}
+			if(t == 0 || (triangleMisses == 3 && t - clusterStarts.back() >= minClusterSize))
+				clusterStarts.push_back(t);
+		}
+	}
+	const uint32_t numClusters = static_cast<uint32_t>(clusterStarts.size());
+	if(numClusters < 2)
+		return;
+	clusterStarts.push_back(numTriangles);
+
+	// sort key: how much the cluster faces away from the mesh's center
+	auto posAcc = PositionAttributeAccessor::create(vd);
+	Geometry::Vec3 meshCenter;
+	for(uint32_t i = 0; i < numTriangles * 3; ++i)
+		meshCenter += posAcc->getPosition(indices[i]);
+	meshCenter /= static_cast<float>(numTriangles * 3);
+
+	std::vector<std::pair<float, uint32_t>> keys;
+	keys.reserve(numClusters);
+	for(uint32_t c = 0; c < numClusters; ++c) {
+		Geometry::Vec3 centroid;
+		Geometry::Vec3 normal; // area weighted
+		for(uint32_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+			const Geometry::Vec3 a = posAcc->getPosition(indices[t * 3]);
+			const Geometry::Vec3 b = posAcc->getPosition(indices[t * 3 + 1]);
+			const Geometry::Vec3 cPos = posAcc->getPosition(indices[t * 3 + 2]);
+			centroid += a + b + cPos;
+			normal += (b - a).cross(cPos - a);
+		}
+		centroid /= static_cast<float>((clusterStarts[c + 1] - clusterStarts[c]) * 3);
+		keys.emplace_back(-(centroid - meshCenter).dot(normal), c);
+	}
+	std::stable_sort(keys.begin(), keys.end());
+
+	std::vector<uint32_t> output;
+	output.reserve(numTriangles * 3);
+	for(const auto & key : keys)
+		output.insert(output.end(), indices + clusterStarts[key.second] * 3, indices + clusterStarts[key.second + 1] * 3);
+	std::copy(output.begin(), output.end(), id.data());
+	id.markAsChanged();
+}
+
+// ---------------------------------------------------------------------
+
+void optimizeVertexFetch(Mesh * mesh) {
+	if(!checkMesh(mesh))
+		return;
+	MeshIndexData & id = mesh->openIndexData();
+	MeshVertexData & vd = mesh->openVertexData();
+	const uint32_t numVertices = vd.getVertexCount();
+	const uint32_t numIndices = id.getIndexCount();
+	if(numVertices == 0 || numIndices == 0)
+		return;
+
+	std::vector<uint32_t> newIndex(numVertices, INVALID);
+	uint32_t next = 0;
+	for(uint32_t i = 0; i < numIndices; ++i) {
+		const uint32_t v = id[i];
+		if(v >= numVertices) {
+			WARN("optimizeVertexFetch: Invalid index.");
+			return;
+		}
+		if(newIndex[v] == INVALID)
+			newIndex[v] = next++;
+	}
+	for(auto & index : newIndex) {
+		if(index == INVALID)
+			index = next++;
+	}
+
+	const size_t vertexSize = vd.getVertexDescription().getVertexSize();
+	std::vector<uint8_t> oldData(vd.data(), vd.data() + vd.dataSize());
+	for(uint32_t v = 0; v < numVertices; ++v)
+		std::memcpy(vd.data() + newIndex[v] * vertexSize, oldData.data() + v * vertexSize, vertexSize);
+	for(uint32_t i = 0; i < numIndices; ++i)
+		id[i] = newIndex[id[i]];
+	vd.markAsChanged();
+	id.markAsChanged();
+	id.updateIndexRange();
+}
+
+// ---------------------------------------------------------------------
+
+OptimizationReport optimizeMesh(Mesh * mesh, uint32_t cacheSize) {
+	OptimizationReport report;
+	report.before = analyzeVertexCache(mesh, cacheSize);
+	optimizeVertexCache(mesh, cacheSize);
+	optimizeOverdraw(mesh, cacheSize);
+	optimizeVertexFetch(mesh);
+	report.after = analyzeVertexCache(mesh, cacheSize);
+	return report;
+}
+
+}
+}
+}
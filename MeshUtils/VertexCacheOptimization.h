@@ -0,0 +1,71 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_VERTEXCACHEOPTIMIZATION_H
+#define RENDERING_MESHUTILS_VERTEXCACHEOPTIMIZATION_H
+
+#include <cstdint>
+
+namespace Rendering {
+class Mesh;
+namespace MeshUtils {
+/**
+ * Reordering of triangles and vertices for a better utilization of the post-transform vertex cache,
+ * less overdraw and a more local vertex fetch. All functions run in linear time (except for sorting the
+ * clusters in optimizeOverdraw) and only work for meshes with a triangle list.
+ */
+namespace VertexCacheOptimization {
+
+//! Result of the simulation of a FIFO post-transform vertex cache.
+struct CacheStatistics {
+	//! Average cache miss ratio: transformed vertices per triangle (optimum: 0.5; worst case: 3).
+	float acmr;
+	//! Average transform to vertex ratio: transformed vertices per referenced vertex (optimum: 1).
+	float atvr;
+	CacheStatistics() : acmr(0.0f), atvr(0.0f) {}
+};
+
+//! Simulate a FIFO vertex cache with @p cacheSize entries for the indices of @p mesh.
+CacheStatistics analyzeVertexCache(Mesh * mesh, uint32_t cacheSize = 32);
+
+/**
+ * Reorder the triangles for a LRU cache of the given size using the algorithm of Tom Forsyth
+ * ("Linear-Speed Vertex Cache Optimisation", 2006). The cache size is limited to 64.
+ */
+void optimizeVertexCache(Mesh * mesh, uint32_t cacheSize = 32);
+
+/**
+ * Reorder clusters of triangles so that triangles facing outward are drawn first (following Sander et al.,
+ * "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007). A new cluster begins at each
+ * triangle whose vertices all miss the cache, which keeps the vertex cache efficiency mostly intact.
+ * Call it after optimizeVertexCache().
+ * @param minClusterSize Minimum number of triangles of a cluster.
+ */
+void optimizeOverdraw(Mesh * mesh, uint32_t cacheSize = 32, uint32_t minClusterSize = 64);
+
+/**
+ * Reorder the vertices in the order of their first use by the indices. Vertices that are not referenced
+ * are moved to the end. The vertex data has to be available locally (it is downloaded if necessary).
+ */
+void optimizeVertexFetch(Mesh * mesh);
+
+struct OptimizationReport {
+	CacheStatistics before;
+	CacheStatistics after;
+};
+
+//! Apply optimizeVertexCache, optimizeOverdraw and optimizeVertexFetch and report the cache statistics.
+OptimizationReport optimizeMesh(Mesh * mesh, uint32_t cacheSize = 32);
+
+}
+}
+}
+
+#endif // RENDERING_MESHUTILS_VERTEXCACHEOPTIMIZATION_H
@@ -0,0 +1,171 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "VertexConversionPlan.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttribute.h"
+#include "../GLHeader.h"
+#include "internal/ConversionKernels.h"
+#include "internal/ParallelFor.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <mutex>
+
+namespace Rendering {
+namespace MeshUtils {
+
+//! (internal) Number of vertices converted by all operations before continuing with the next vertices.
+static const uint32_t blockSize = 256;
+static const std::size_t maxCachedPlans = 16;
+
+//! (static)
+std::shared_ptr<const VertexConversionPlan> VertexConversionPlan::get(const VertexDescription & source, const VertexDescription & target) {
+	static std::mutex mutex;
+	static std::deque<std::shared_ptr<const VertexConversionPlan>> cache;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	for(auto it = cache.begin(); it != cache.end(); ++it) {
+		if((*it)->getSourceDescription() == source && (*it)->getTargetDescription() == target) {
+			auto plan = *it;
+			if(it != cache.begin()) {
+				cache.erase(it);
+				cache.push_front(plan);
+			}
+			return plan;
+		}
+	}
+	std::shared_ptr<const VertexConversionPlan> plan = std::make_shared<VertexConversionPlan>(source, target);
+	cache.push_front(plan);
+	if(cache.size() > maxCachedPlans)
+		cache.pop_back();
+	return plan;
+}
+
+//! (internal)
+static bool getOperationType(uint32_t sourceType, uint32_t targetType, VertexConversionPlan::operation_t & type) {
+	if(sourceType == targetType) {
+		type = VertexConversionPlan::COPY;
+	} else if(sourceType == GL_FLOAT) {
+		switch(targetType) {
+			case GL_BYTE:			type = VertexConversionPlan::FLOAT_TO_SNORM8;	break;
+			case GL_UNSIGNED_BYTE:	type = VertexConversionPlan::FLOAT_TO_UNORM8;	break;
+			case GL_HALF_FLOAT:		type = VertexConversionPlan::FLOAT_TO_HALF;		break;
+#ifdef GL_INT_2_10_10_10_REV
+			case GL_INT_2_10_10_10_REV:	type = VertexConversionPlan::FLOAT_TO_SIGNED_2_10_10_10;	break;
+#endif
+			default:
+				return false;
+		}
+	} else if(targetType == GL_FLOAT) {
+		switch(sourceType) {
+			case GL_BYTE:			type = VertexConversionPlan::SNORM8_TO_FLOAT;	break;
+			case GL_UNSIGNED_BYTE:	type = VertexConversionPlan::UNORM8_TO_FLOAT;	break;
+			case GL_HALF_FLOAT:		type = VertexConversionPlan::HALF_TO_FLOAT;		break;
+#ifdef GL_INT_2_10_10_10_REV
+			case GL_INT_2_10_10_10_REV:	type = VertexConversionPlan::SIGNED_2_10_10_10_TO_FLOAT;	break;
+#endif
+			default:
+				return false;
+		}
+	} else {
+		return false;
+	}
+	return true;
+}
+
+//! (static)
+bool VertexConversionPlan::canConvert(const VertexAttribute & source, const VertexAttribute & target) {
+	operation_t type;
+	return getOperationType(source.getDataType(), target.getDataType(), type);
+}
+
+VertexConversionPlan::VertexConversionPlan(const VertexDescription & source, const VertexDescription & target) :
+		sourceDescription(source), targetDescription(target) {
+	for(const auto & sourceAttr : sourceDescription.getAttributes()) {
+		const VertexAttribute & targetAttr = targetDescription.getAttribute(sourceAttr.getNameId());
+		if(sourceAttr.empty() || targetAttr.empty())
+			continue;
+		Operation op;
+		if(!getOperationType(sourceAttr.getDataType(), targetAttr.getDataType(), op.type))
+			continue;
+		op.sourceOffset = sourceAttr.getOffset();
+		op.targetOffset = targetAttr.getOffset();
+		if(op.type == COPY)
+			op.count = std::min(sourceAttr.getDataSize(), targetAttr.getDataSize());
+		else // the kernels convert at most four values per vertex
+			op.count = std::min<uint16_t>(4, std::min(sourceAttr.getNumValues(), targetAttr.getNumValues()));
+		operations.push_back(op);
+	}
+}
+
+void VertexConversionPlan::apply(const uint8_t * source, uint8_t * target, uint32_t count) const {
+	const std::size_t sourceStride = sourceDescription.getVertexSize();
+	const std::size_t targetStride = targetDescription.getVertexSize();
+	parallelFor(count, [&](uint32_t begin, uint32_t end) {
+		// Initialize the data with zero.
+		std::fill(target + begin * targetStride, target + end * targetStride, 0);
+		for(uint32_t blockBegin = begin; blockBegin < end; blockBegin += blockSize) {
+			const uint32_t blockCount = std::min(blockSize, end - blockBegin);
+			const uint8_t * blockSource = source + blockBegin * sourceStride;
+			uint8_t * blockTarget = target + blockBegin * targetStride;
+			for(const auto & op : operations) {
+				const uint8_t * s = blockSource + op.sourceOffset;
+				uint8_t * t = blockTarget + op.targetOffset;
+				switch(op.type) {
+					case COPY:
+						for(uint32_t i = 0; i < blockCount; ++i)
+							std::memcpy(t + i * targetStride, s + i * sourceStride, op.count);
+						break;
+					case FLOAT_TO_SNORM8:
+						ConversionKernels::floatToSnorm8(s, sourceStride, t, targetStride, blockCount, op.count);
+						break;
+					case FLOAT_TO_UNORM8:
+						ConversionKernels::floatToUnorm8(s, sourceStride, t, targetStride, blockCount, op.count);
+						break;
+					case FLOAT_TO_HALF:
+						ConversionKernels::floatToHalf(s, sourceStride, t, targetStride, blockCount, op.count);
+						break;
+					case SNORM8_TO_FLOAT:
+						ConversionKernels::snorm8ToFloat(s, sourceStride, t, targetStride, blockCount, op.count);
+						break;
+					case UNORM8_TO_FLOAT:
+						ConversionKernels::unorm8ToFloat(s, sourceStride, t, targetStride, blockCount, op.count);
+						break;
+					case HALF_TO_FLOAT:
+						ConversionKernels::halfToFloat(s, sourceStride, t, targetStride, blockCount, op.count);
+						break;
+					case FLOAT_TO_SIGNED_2_10_10_10:
+						ConversionKernels::floatToSigned2_10_10_10(s, sourceStride, t, targetStride, blockCount, op.count);
+						break;
+					case SIGNED_2_10_10_10_TO_FLOAT:
+						ConversionKernels::signed2_10_10_10ToFloat(s, sourceStride, t, targetStride, blockCount, op.count);
+						break;
+				}
+			}
+		}
+	}, 4 * blockSize);
+}
+
+MeshVertexData * VertexConversionPlan::apply(const MeshVertexData & vertices) const {
+	if(vertices.getLayout() != MeshVertexData::INTERLEAVED) {
+		MeshVertexData interleaved(vertices);
+		interleaved.setLayout(MeshVertexData::INTERLEAVED);
+		return apply(interleaved);
+	}
+	auto newVertices = new MeshVertexData;
+	newVertices->allocate(vertices.getVertexCount(), targetDescription);
+	apply(vertices.data(), newVertices->data(), vertices.getVertexCount());
+	newVertices->updateBoundingBox();
+	return newVertices;
+}
+
+}
+}
@@ -0,0 +1,90 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_VERTEXCONVERSIONPLAN_H_
+#define RENDERING_MESHUTILS_VERTEXCONVERSIONPLAN_H_
+
+#include "../Mesh/VertexDescription.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Rendering {
+class MeshVertexData;
+class VertexAttribute;
+namespace MeshUtils {
+
+/**
+ * Precompiled conversion of vertex data from one VertexDescription into another.
+ * The plan is created once per pair of descriptions and contains one operation per attribute
+ * present in both descriptions: a plain copy for attributes of equal type, or a batch conversion
+ * between GL_FLOAT and GL_BYTE (snorm8), GL_UNSIGNED_BYTE (unorm8), GL_HALF_FLOAT or GL_INT_2_10_10_10_REV.
+ * Values missing in the source are initialized with 0; attributes that cannot be converted are skipped.
+ * Applying a plan converts contiguous blocks of vertices in parallel.
+ *
+ * \code
+ * auto plan = MeshUtils::VertexConversionPlan::get(importedDescription, packedDescription);
+ * for(auto & vertices : importedVertexData)
+ *     packedVertexData.emplace_back(plan->apply(vertices));
+ * \endcode
+ */
+class VertexConversionPlan {
+	public:
+		enum operation_t : uint8_t {
+			COPY,
+			FLOAT_TO_SNORM8,
+			FLOAT_TO_UNORM8,
+			FLOAT_TO_HALF,
+			SNORM8_TO_FLOAT,
+			UNORM8_TO_FLOAT,
+			HALF_TO_FLOAT,
+			FLOAT_TO_SIGNED_2_10_10_10,
+			SIGNED_2_10_10_10_TO_FLOAT
+		};
+		struct Operation {
+			operation_t type;
+			uint16_t sourceOffset;
+			uint16_t targetOffset;
+			uint16_t count;		//!< number of bytes (COPY) or values
+		};
+
+		/*! (static) Return the plan for the given pair of descriptions.
+			The most recently used plans are cached, so repeated conversions between the same formats are not planned again.
+			\note Thread-safe. */
+		static std::shared_ptr<const VertexConversionPlan> get(const VertexDescription & source, const VertexDescription & target);
+
+		//! (static) Return @c true iff the values of @p source can be converted into the format of @p target.
+		static bool canConvert(const VertexAttribute & source, const VertexAttribute & target);
+
+		VertexConversionPlan(const VertexDescription & source, const VertexDescription & target);
+
+		const VertexDescription & getSourceDescription() const	{	return sourceDescription;	}
+		const VertexDescription & getTargetDescription() const	{	return targetDescription;	}
+		const std::vector<Operation> & getOperations() const	{	return operations;	}
+
+		/*! Convert @p count vertices from @p source (in the source format) into @p target (in the target format).
+			The target memory has to hold @p count vertices of the target description. */
+		void apply(const uint8_t * source, uint8_t * target, uint32_t count) const;
+
+		/*! Allocate new vertex data in the target format containing the converted vertices of @p vertices.
+			The bounding box of the result is updated. The result uses the interleaved layout.
+			\note @p vertices has to use the source description of the plan. */
+		MeshVertexData * apply(const MeshVertexData & vertices) const;
+
+	private:
+		VertexDescription sourceDescription;
+		VertexDescription targetDescription;
+		std::vector<Operation> operations;
+};
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_VERTEXCONVERSIONPLAN_H_ */
@@ -0,0 +1,315 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ConversionKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define RENDERING_CONVERSION_SSE2
+	#include <emmintrin.h>
+	#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+		#define RENDERING_CONVERSION_F16C
+		#include <immintrin.h>
+	#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define RENDERING_CONVERSION_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace Rendering {
+namespace MeshUtils {
+namespace ConversionKernels {
+
+// The values are accessed with memcpy, as the vertex data may not be aligned.
+
+uint16_t floatToHalf(float value) {
+	uint32_t f;
+	std::memcpy(&f, &value, sizeof(f));
+	const uint16_t sign = static_cast<uint16_t>((f >> 16) & 0x8000);
+	f &= 0x7fffffff;
+	if(f >= 0x47800000) // too large, infinity or NaN
+		return sign | (f > 0x7f800000 ? 0x7e00 : 0x7c00);
+	if(f < 0x38800000) { // subnormal half (or zero)
+		float a;
+		std::memcpy(&a, &f, sizeof(a));
+		return sign | static_cast<uint16_t>(std::nearbyint(a * 16777216.0f));
+	}
+	// Re-bias the exponent and round the mantissa to nearest even.
+	f += 0xc8000fff + ((f >> 13) & 1);
+	return sign | static_cast<uint16_t>(f >> 13);
+}
+
+float halfToFloat(uint16_t value) {
+	const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+	const uint32_t exponent = (value >> 10) & 0x1f;
+	const uint32_t mantissa = value & 0x3ff;
+	if(exponent == 0) {
+		const float f = static_cast<float>(mantissa) / 16777216.0f;
+		return sign != 0 ? -f : f;
+	}
+	const uint32_t bits = sign | (exponent == 31 ? (0x7f800000 | (mantissa << 13)) : (((exponent + 112) << 23) | (mantissa << 13)));
+	float f;
+	std::memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+// ---------------------------------------------------------------------
+// scalar
+
+#if !defined(RENDERING_CONVERSION_SSE2) && !defined(RENDERING_CONVERSION_NEON)
+static void floatToSnorm8Scalar(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		float v[4];
+		std::memcpy(v, source, numValues * sizeof(float));
+		for(uint32_t c = 0; c < numValues; ++c) {
+			const int8_t b = static_cast<int8_t>(std::min(1.0f, std::max(-1.0f, v[c])) * 127.0f);
+			std::memcpy(target + c, &b, 1);
+		}
+	}
+}
+
+static void floatToUnorm8Scalar(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		float v[4];
+		std::memcpy(v, source, numValues * sizeof(float));
+		for(uint32_t c = 0; c < numValues; ++c)
+			target[c] = static_cast<uint8_t>(std::min(1.0f, std::max(0.0f, v[c])) * 255.0f);
+	}
+}
+
+#endif
+
+static void floatToHalfScalar(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		float v[4];
+		uint16_t h[4];
+		std::memcpy(v, source, numValues * sizeof(float));
+		for(uint32_t c = 0; c < numValues; ++c)
+			h[c] = floatToHalf(v[c]);
+		std::memcpy(target, h, numValues * sizeof(uint16_t));
+	}
+}
+
+#if !defined(RENDERING_CONVERSION_SSE2)
+static void floatToSigned2_10_10_10Scalar(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	static const float maxValues[4] = {511.0f, 511.0f, 511.0f, 1.0f};
+	static const uint32_t masks[4] = {0x3ff, 0x3ff, 0x3ff, 0x3};
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		float v[4];
+		std::memcpy(v, source, numValues * sizeof(float));
+		uint32_t packed = 0;
+		for(uint32_t c = 0; c < numValues; ++c) {
+			const int32_t p = static_cast<int32_t>(std::round(std::min(1.0f, std::max(-1.0f, v[c])) * maxValues[c]));
+			packed |= (static_cast<uint32_t>(p) & masks[c]) << (10 * c);
+		}
+		std::memcpy(target, &packed, sizeof(packed));
+	}
+}
+
+#endif
+
+void signed2_10_10_10ToFloat(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		uint32_t packed;
+		std::memcpy(&packed, source, sizeof(packed));
+		const float v[4] = {
+			std::max((static_cast<int32_t>(packed << 22) >> 22) / 511.0f, -1.0f),
+			std::max((static_cast<int32_t>(packed << 12) >> 22) / 511.0f, -1.0f),
+			std::max((static_cast<int32_t>(packed << 2) >> 22) / 511.0f, -1.0f),
+			std::max(static_cast<float>(static_cast<int32_t>(packed) >> 30), -1.0f)
+		};
+		std::memcpy(target, v, numValues * sizeof(float));
+	}
+}
+
+void snorm8ToFloat(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		int8_t b[4];
+		float v[4];
+		std::memcpy(b, source, numValues);
+		for(uint32_t c = 0; c < numValues; ++c)
+			v[c] = std::max(static_cast<float>(b[c]) / 127.0f, -1.0f);
+		std::memcpy(target, v, numValues * sizeof(float));
+	}
+}
+
+void unorm8ToFloat(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		float v[4];
+		for(uint32_t c = 0; c < numValues; ++c)
+			v[c] = static_cast<float>(source[c]) / 255.0f;
+		std::memcpy(target, v, numValues * sizeof(float));
+	}
+}
+
+void halfToFloat(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		uint16_t h[4];
+		float v[4];
+		std::memcpy(h, source, numValues * sizeof(uint16_t));
+		for(uint32_t c = 0; c < numValues; ++c)
+			v[c] = halfToFloat(h[c]);
+		std::memcpy(target, v, numValues * sizeof(float));
+	}
+}
+
+// ---------------------------------------------------------------------
+// SSE2: one vertex (up to four values) per iteration
+
+#if defined(RENDERING_CONVERSION_SSE2)
+static inline __m128 loadValues(const uint8_t * ptr, uint32_t numValues) {
+	float v[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+	std::memcpy(v, ptr, numValues * sizeof(float));
+	return _mm_loadu_ps(v);
+}
+
+static void floatToSnorm8SSE(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	const __m128 minValue = _mm_set1_ps(-1.0f);
+	const __m128 maxValue = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(127.0f);
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		const __m128 v = _mm_mul_ps(_mm_min_ps(_mm_max_ps(loadValues(source, numValues), minValue), maxValue), scale);
+		const __m128i i32 = _mm_cvttps_epi32(v);
+		const __m128i i16 = _mm_packs_epi32(i32, i32);
+		const int32_t packed = _mm_cvtsi128_si32(_mm_packs_epi16(i16, i16));
+		std::memcpy(target, &packed, numValues);
+	}
+}
+
+static void floatToUnorm8SSE(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	const __m128 minValue = _mm_setzero_ps();
+	const __m128 maxValue = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(255.0f);
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		const __m128 v = _mm_mul_ps(_mm_min_ps(_mm_max_ps(loadValues(source, numValues), minValue), maxValue), scale);
+		const __m128i i32 = _mm_cvttps_epi32(v);
+		const __m128i i16 = _mm_packs_epi32(i32, i32);
+		const int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(i16, i16));
+		std::memcpy(target, &packed, numValues);
+	}
+}
+
+static void floatToSigned2_10_10_10SSE(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	const __m128 minValue = _mm_set1_ps(-1.0f);
+	const __m128 maxValue = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_setr_ps(511.0f, 511.0f, 511.0f, 1.0f);
+	const __m128i mask = _mm_setr_epi32(0x3ff, 0x3ff, 0x3ff, 0x3);
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		const __m128 v = _mm_mul_ps(_mm_min_ps(_mm_max_ps(loadValues(source, numValues), minValue), maxValue), scale);
+		int32_t c[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(c), _mm_and_si128(_mm_cvtps_epi32(v), mask));
+		const uint32_t packed = static_cast<uint32_t>(c[0]) | (static_cast<uint32_t>(c[1]) << 10) | (static_cast<uint32_t>(c[2]) << 20) | (static_cast<uint32_t>(c[3]) << 30);
+		std::memcpy(target, &packed, sizeof(packed));
+	}
+}
+#endif
+
+// ---------------------------------------------------------------------
+// F16C (compiled for F16C, only called if the CPU supports it)
+
+#if defined(RENDERING_CONVERSION_F16C)
+__attribute__((target("f16c")))
+static void floatToHalfF16C(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		const __m128i h = _mm_cvtps_ph(loadValues(source, numValues), _MM_FROUND_TO_NEAREST_INT);
+		uint16_t values[8];
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(values), h);
+		std::memcpy(target, values, numValues * sizeof(uint16_t));
+	}
+}
+#endif
+
+// ---------------------------------------------------------------------
+// NEON
+
+#if defined(RENDERING_CONVERSION_NEON)
+static inline float32x4_t loadValues(const uint8_t * ptr, uint32_t numValues) {
+	float v[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+	std::memcpy(v, ptr, numValues * sizeof(float));
+	return vld1q_f32(v);
+}
+
+static void floatToSnorm8NEON(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		const float32x4_t v = vmulq_n_f32(vminq_f32(vmaxq_f32(loadValues(source, numValues), vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f)), 127.0f);
+		const int16x4_t i16 = vmovn_s32(vcvtq_s32_f32(v));
+		int8_t packed[8];
+		vst1_s8(packed, vmovn_s16(vcombine_s16(i16, i16)));
+		std::memcpy(target, packed, numValues);
+	}
+}
+
+static void floatToUnorm8NEON(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	for(uint32_t i = 0; i < count; ++i, source += sourceStride, target += targetStride) {
+		const float32x4_t v = vmulq_n_f32(vminq_f32(vmaxq_f32(loadValues(source, numValues), vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f)), 255.0f);
+		const uint16x4_t u16 = vmovn_u32(vcvtq_u32_f32(v));
+		uint8_t packed[8];
+		vst1_u8(packed, vmovn_u16(vcombine_u16(u16, u16)));
+		std::memcpy(target, packed, numValues);
+	}
+}
+#endif
+
+// ---------------------------------------------------------------------
+// dispatch
+
+typedef void (*kernel_t)(const uint8_t *, std::size_t, uint8_t *, std::size_t, uint32_t, uint32_t);
+struct Kernels {
+	kernel_t toSnorm8;
+	kernel_t toUnorm8;
+	kernel_t toHalf;
+	kernel_t toSigned2_10_10_10;
+	const char * name;
+};
+
+static Kernels selectKernels() {
+#if defined(RENDERING_CONVERSION_F16C)
+	if(__builtin_cpu_supports("f16c"))
+		return Kernels{floatToSnorm8SSE, floatToUnorm8SSE, floatToHalfF16C, floatToSigned2_10_10_10SSE, "SSE2+F16C"};
+#endif
+#if defined(RENDERING_CONVERSION_SSE2)
+	return Kernels{floatToSnorm8SSE, floatToUnorm8SSE, floatToHalfScalar, floatToSigned2_10_10_10SSE, "SSE2"};
+#elif defined(RENDERING_CONVERSION_NEON)
+	return Kernels{floatToSnorm8NEON, floatToUnorm8NEON, floatToHalfScalar, floatToSigned2_10_10_10Scalar, "NEON"};
+#else
+	return Kernels{floatToSnorm8Scalar, floatToUnorm8Scalar, floatToHalfScalar, floatToSigned2_10_10_10Scalar, "scalar"};
+#endif
+}
+
+static const Kernels & getKernels() {
+	static const Kernels kernels = selectKernels();
+	return kernels;
+}
+
+void floatToSnorm8(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	getKernels().toSnorm8(source, sourceStride, target, targetStride, count, numValues);
+}
+
+void floatToUnorm8(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	getKernels().toUnorm8(source, sourceStride, target, targetStride, count, numValues);
+}
+
+void floatToHalf(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	getKernels().toHalf(source, sourceStride, target, targetStride, count, numValues);
+}
+
+void floatToSigned2_10_10_10(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues) {
+	getKernels().toSigned2_10_10_10(source, sourceStride, target, targetStride, count, numValues);
+}
+
+const char * getImplementationName() {
+	return getKernels().name;
+}
+
+}
+}
+}
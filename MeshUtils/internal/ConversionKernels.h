@@ -0,0 +1,50 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_CONVERSIONKERNELS_H_
+#define RENDERING_MESHUTILS_CONVERSIONKERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Rendering {
+namespace MeshUtils {
+/**
+ * (internal) Batch kernels converting interleaved vertex attributes between float and packed formats.
+ * Each kernel converts @p numValues (at most four) values of @p count vertices; source and target are given
+ * with their strides in bytes and are accessed unaligned.
+ * Floats are clamped to [-1,1] (snorm8) or [0,1] (unorm8) and truncated, like the vertex attribute accessors do;
+ * half floats are rounded to nearest even. Signed 2_10_10_10 values (x in the lowest bits) are clamped to [-1,1] and
+ * rounded; missing values are stored as 0.
+ * The packers use SSE2 (and F16C, if the CPU supports it) or NEON; all other kernels are scalar.
+ */
+namespace ConversionKernels {
+
+void floatToSnorm8(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues);
+void floatToUnorm8(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues);
+void floatToHalf(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues);
+void floatToSigned2_10_10_10(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues);
+void snorm8ToFloat(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues);
+void unorm8ToFloat(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues);
+void halfToFloat(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues);
+void signed2_10_10_10ToFloat(const uint8_t * source, std::size_t sourceStride, uint8_t * target, std::size_t targetStride, uint32_t count, uint32_t numValues);
+
+//! Scalar conversion of a single value (round to nearest even).
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+
+//! Name of the selected packer implementation ("SSE2+F16C", "SSE2", "NEON" or "scalar").
+const char * getImplementationName();
+
+}
+}
+}
+
+#endif /* RENDERING_MESHUTILS_CONVERSIONKERNELS_H_ */
@@ -0,0 +1,39 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_PARALLELFOR_H_
+#define RENDERING_MESHUTILS_PARALLELFOR_H_
+
+#include "../../TaskScheduler.h"
+#include <cstdint>
+#include <functional>
+
+namespace Rendering {
+namespace MeshUtils {
+
+/*! (internal) Split the range [0, count) into contiguous chunks and call @p fun(begin, end) for each chunk
+	using the library-wide TaskScheduler. If the range is smaller than @p minChunkSize, or the scheduler has no
+	worker threads, @p fun is called once on the calling thread.
+	\note @p fun must only write to data belonging to its own range. */
+template<typename Function>
+void parallelFor(uint32_t count, const Function & fun, uint32_t minChunkSize = 16384) {
+	TaskScheduler & scheduler = TaskScheduler::get();
+	if(scheduler.getNumWorkers() == 0 || count < 2 * minChunkSize) {
+		if(count > 0)
+			fun(0u, count);
+		return;
+	}
+	scheduler.parallelFor(count, std::function<void (uint32_t, uint32_t)>(std::cref(fun)), minChunkSize, "MeshUtils::parallelFor");
+}
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_PARALLELFOR_H_ */
@@ -0,0 +1,106 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ScratchArena.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace Rendering {
+namespace MeshUtils {
+
+//! Size of the first block of an arena.
+static const std::size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+//! An empty arena keeps at most this many bytes for the next calls.
+static const std::size_t MAX_RETAINED_SIZE = 64 * 1024 * 1024;
+
+ScratchArena & ScratchArena::get() {
+	static thread_local ScratchArena arena;
+	return arena;
+}
+
+ScratchArena::ScratchArena() : blocks(), currentBlock(0), currentOffset(0), peakBytes(0) {
+}
+
+void * ScratchArena::allocate(std::size_t numBytes, std::size_t alignment) {
+	if(alignment == 0 || (alignment & (alignment - 1)) != 0)
+		throw std::invalid_argument("ScratchArena: alignment has to be a power of two.");
+	numBytes = std::max<std::size_t>(numBytes, 1);
+	while(true) {
+		if(currentBlock < blocks.size()) {
+			Block & block = blocks[currentBlock];
+			const uintptr_t address = reinterpret_cast<uintptr_t>(block.data.get()) + currentOffset;
+			const std::size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+			if(currentOffset + padding + numBytes <= block.size) {
+				currentOffset += padding + numBytes;
+				peakBytes = std::max(peakBytes, getUsedBytes());
+				return block.data.get() + (currentOffset - numBytes);
+			}
+			// continue in the next retained block if it is large enough
+			if(currentBlock + 1 < blocks.size() && blocks[currentBlock + 1].size >= numBytes + alignment) {
+				++currentBlock;
+				currentOffset = 0;
+				continue;
+			}
+		}
+		// insert a new block behind the current one
+		const std::size_t lastSize = blocks.empty() ? INITIAL_BLOCK_SIZE / 2 : blocks[std::min(currentBlock, blocks.size() - 1)].size;
+		Block block;
+		block.size = std::max(2 * lastSize, numBytes + alignment);
+		block.data.reset(new uint8_t[block.size]);
+		const std::size_t position = blocks.empty() ? 0 : currentBlock + 1;
+		blocks.insert(blocks.begin() + position, std::move(block));
+		currentBlock = position;
+		currentOffset = 0;
+	}
+}
+
+void ScratchArena::deallocate(void * pointer, std::size_t numBytes) {
+	if(pointer == nullptr || currentBlock >= blocks.size())
+		return;
+	uint8_t * const begin = blocks[currentBlock].data.get();
+	numBytes = std::max<std::size_t>(numBytes, 1);
+	if(static_cast<uint8_t *>(pointer) + numBytes == begin + currentOffset)
+		currentOffset -= numBytes;
+}
+
+void ScratchArena::release(const Marker & marker) {
+	currentBlock = marker.block;
+	currentOffset = marker.offset;
+	if(currentBlock == 0 && currentOffset == 0)
+		releaseAll();
+}
+
+void ScratchArena::releaseAll() {
+	if(blocks.size() <= 1 && getCapacity() <= MAX_RETAINED_SIZE)
+		return;
+	const std::size_t capacity = getCapacity();
+	blocks.clear();
+	Block block;
+	block.size = capacity <= MAX_RETAINED_SIZE ? capacity : INITIAL_BLOCK_SIZE;
+	block.data.reset(new uint8_t[block.size]);
+	blocks.push_back(std::move(block));
+}
+
+std::size_t ScratchArena::getCapacity() const {
+	std::size_t capacity = 0;
+	for(const auto & block : blocks)
+		capacity += block.size;
+	return capacity;
+}
+
+std::size_t ScratchArena::getUsedBytes() const {
+	std::size_t used = currentOffset;
+	for(std::size_t b = 0; b < currentBlock && b < blocks.size(); ++b)
+		used += blocks[b].size;
+	return used;
+}
+
+}
+}
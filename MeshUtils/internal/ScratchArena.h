@@ -0,0 +1,148 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_SCRATCHARENA_H_
+#define RENDERING_MESHUTILS_SCRATCHARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Rendering {
+namespace MeshUtils {
+
+/**
+ * (internal) Monotonic per-thread memory for the temporary data of the mesh utilities.
+ * Allocating only moves an offset forward; the memory is given back in bulk by resetting the arena to a
+ * Marker (usually with a ScratchScope at the beginning of a function). The blocks are kept for the next call,
+ * so repeated calls do not touch the system allocator after the first one.
+ * \note An arena must only be used by its own thread. Other threads may of course read and write
+ *	the allocated memory (e.g. inside of parallelFor()) as long as the owning thread waits for them.
+ */
+class ScratchArena {
+	public:
+		//! Position inside the arena; everything allocated after it is released by release(marker).
+		struct Marker {
+			std::size_t block;
+			std::size_t offset;
+		};
+
+		//! The arena of the calling thread.
+		static ScratchArena & get();
+
+		ScratchArena();
+		ScratchArena(const ScratchArena &) = delete;
+		ScratchArena & operator=(const ScratchArena &) = delete;
+
+		//! Uninitialized memory of at least @p numBytes with the given alignment (a power of two).
+		void * allocate(std::size_t numBytes, std::size_t alignment = alignof(std::max_align_t));
+
+		/*! Give back the given memory. This is only possible for the most recent allocation;
+			all other memory stays reserved until the surrounding marker is released. */
+		void deallocate(void * pointer, std::size_t numBytes);
+
+		//! Uninitialized array of @p count elements. Only use this for trivial types.
+		template<typename T>
+		T * allocateArray(std::size_t count) {
+			return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+		}
+
+		Marker getMarker() const {
+			return {currentBlock, currentOffset};
+		}
+		/*! Release everything allocated after @p marker was taken.
+			Releasing the whole arena merges its blocks into one (up to a size limit), so the next call fits into a single block. */
+		void release(const Marker & marker);
+
+		//! Number of bytes reserved from the system.
+		std::size_t getCapacity() const;
+		//! Number of bytes currently in use (including the padding for alignment).
+		std::size_t getUsedBytes() const;
+		//! Highest value of getUsedBytes() since the arena has been created.
+		std::size_t getPeakBytes() const {
+			return peakBytes;
+		}
+
+	private:
+		struct Block {
+			std::unique_ptr<uint8_t[]> data;
+			std::size_t size;
+		};
+		std::vector<Block> blocks;
+		std::size_t currentBlock;
+		std::size_t currentOffset;
+		std::size_t peakBytes;
+
+		void releaseAll();
+};
+
+/**
+ * (internal) Releases everything allocated from the thread's ScratchArena during the lifetime of the scope.
+ * \note Scratch containers have to be declared after the scope, so they are destroyed before it.
+ */
+class ScratchScope {
+		ScratchArena & arena;
+		const ScratchArena::Marker marker;
+	public:
+		ScratchScope() : arena(ScratchArena::get()), marker(arena.getMarker()) {
+		}
+		~ScratchScope() {
+			arena.release(marker);
+		}
+		ScratchScope(const ScratchScope &) = delete;
+		ScratchScope & operator=(const ScratchScope &) = delete;
+
+		ScratchArena & getArena() const {
+			return arena;
+		}
+};
+
+/**
+ * (internal) Standard allocator taking its memory from the ScratchArena of the thread that created it.
+ * @code
+ * const ScratchScope scope;
+ * ScratchVector<uint32_t> offsets(count + 1, 0);
+ * @endcode
+ */
+template<typename T>
+struct ScratchAllocator {
+	typedef T value_type;
+
+	ScratchArena * arena;
+
+	ScratchAllocator() : arena(&ScratchArena::get()) {
+	}
+	template<typename U>
+	ScratchAllocator(const ScratchAllocator<U> & other) : arena(other.arena) {
+	}
+	T * allocate(std::size_t count) {
+		return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T)));
+	}
+	void deallocate(T * pointer, std::size_t count) {
+		arena->deallocate(pointer, count * sizeof(T));
+	}
+};
+template<typename T, typename U>
+bool operator==(const ScratchAllocator<T> & a, const ScratchAllocator<U> & b) {
+	return a.arena == b.arena;
+}
+template<typename T, typename U>
+bool operator!=(const ScratchAllocator<T> & a, const ScratchAllocator<U> & b) {
+	return a.arena != b.arena;
+}
+
+template<typename T>
+using ScratchVector = std::vector<T, ScratchAllocator<T>>;
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_SCRATCHARENA_H_ */
@@ -0,0 +1,227 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "TransformKernels.h"
+#include <Geometry/Convert.h>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define RENDERING_TRANSFORM_SSE2
+	#include <emmintrin.h>
+	#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+		#define RENDERING_TRANSFORM_AVX
+		#include <immintrin.h>
+	#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define RENDERING_TRANSFORM_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace Rendering {
+namespace MeshUtils {
+namespace TransformKernels {
+
+// The values are accessed with memcpy, as the vertex data may not be aligned for float.
+
+// ---------------------------------------------------------------------
+// scalar
+
+#if !defined(RENDERING_TRANSFORM_SSE2) && !defined(RENDERING_TRANSFORM_NEON)
+static void transformPositionsScalar(uint8_t * data, std::size_t stride, uint32_t count, const float * m) {
+	for(uint32_t i = 0; i < count; ++i, data += stride) {
+		float v[3];
+		std::memcpy(v, data, sizeof(v));
+		const float r[3] = {
+			m[0] * v[0] + m[1] * v[1] + m[2] * v[2] + m[3],
+			m[4] * v[0] + m[5] * v[1] + m[6] * v[2] + m[7],
+			m[8] * v[0] + m[9] * v[1] + m[10] * v[2] + m[11]
+		};
+		std::memcpy(data, r, sizeof(r));
+	}
+}
+
+static void transformDirectionsScalar(uint8_t * data, std::size_t stride, uint32_t count, const float * m) {
+	for(uint32_t i = 0; i < count; ++i, data += stride) {
+		float v[3];
+		std::memcpy(v, data, sizeof(v));
+		const float r[3] = {
+			m[0] * v[0] + m[1] * v[1] + m[2] * v[2],
+			m[3] * v[0] + m[4] * v[1] + m[5] * v[2],
+			m[6] * v[0] + m[7] * v[1] + m[8] * v[2]
+		};
+		std::memcpy(data, r, sizeof(r));
+	}
+}
+#endif
+
+// ---------------------------------------------------------------------
+// SSE2: one vertex per iteration, the matrix columns are kept in registers
+
+#if defined(RENDERING_TRANSFORM_SSE2)
+static inline __m128 loadVec3(const uint8_t * ptr) {
+	float v[4];
+	std::memcpy(v, ptr, 3 * sizeof(float));
+	v[3] = 0.0f;
+	return _mm_loadu_ps(v);
+}
+static inline void storeVec3(uint8_t * ptr, __m128 value) {
+	float v[4];
+	_mm_storeu_ps(v, value);
+	std::memcpy(ptr, v, 3 * sizeof(float));
+}
+
+static void transformSSE(uint8_t * data, std::size_t stride, uint32_t count, const float * m, std::size_t rowLength, bool translate) {
+	const __m128 col0 = _mm_setr_ps(m[0], m[rowLength], m[2 * rowLength], 0.0f);
+	const __m128 col1 = _mm_setr_ps(m[1], m[rowLength + 1], m[2 * rowLength + 1], 0.0f);
+	const __m128 col2 = _mm_setr_ps(m[2], m[rowLength + 2], m[2 * rowLength + 2], 0.0f);
+	const __m128 col3 = translate ? _mm_setr_ps(m[3], m[7], m[11], 0.0f) : _mm_setzero_ps();
+	for(uint32_t i = 0; i < count; ++i, data += stride) {
+		const __m128 v = loadVec3(data);
+		__m128 r = _mm_mul_ps(col0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+		r = _mm_add_ps(r, _mm_mul_ps(col1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+		r = _mm_add_ps(r, _mm_mul_ps(col2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+		storeVec3(data, _mm_add_ps(r, col3));
+	}
+}
+
+static void transformPositionsSSE(uint8_t * data, std::size_t stride, uint32_t count, const float * m) {
+	transformSSE(data, stride, count, m, 4, true);
+}
+static void transformDirectionsSSE(uint8_t * data, std::size_t stride, uint32_t count, const float * m) {
+	transformSSE(data, stride, count, m, 3, false);
+}
+#endif
+
+// ---------------------------------------------------------------------
+// AVX: two vertices per iteration (compiled for AVX, only called if the CPU supports it)
+
+#if defined(RENDERING_TRANSFORM_AVX)
+__attribute__((target("avx")))
+static void transformAVX(uint8_t * data, std::size_t stride, uint32_t count, const float * m, std::size_t rowLength, bool translate) {
+	const __m256 col0 = _mm256_setr_ps(m[0], m[rowLength], m[2 * rowLength], 0.0f, m[0], m[rowLength], m[2 * rowLength], 0.0f);
+	const __m256 col1 = _mm256_setr_ps(m[1], m[rowLength + 1], m[2 * rowLength + 1], 0.0f, m[1], m[rowLength + 1], m[2 * rowLength + 1], 0.0f);
+	const __m256 col2 = _mm256_setr_ps(m[2], m[rowLength + 2], m[2 * rowLength + 2], 0.0f, m[2], m[rowLength + 2], m[2 * rowLength + 2], 0.0f);
+	const __m256 col3 = translate ? _mm256_setr_ps(m[3], m[7], m[11], 0.0f, m[3], m[7], m[11], 0.0f) : _mm256_setzero_ps();
+	uint32_t i = 0;
+	for(; i + 1 < count; i += 2, data += 2 * stride) {
+		float v[8];
+		std::memcpy(v, data, 3 * sizeof(float));
+		std::memcpy(v + 4, data + stride, 3 * sizeof(float));
+		v[3] = v[7] = 0.0f;
+		const __m256 vertices = _mm256_loadu_ps(v);
+		__m256 r = _mm256_mul_ps(col0, _mm256_permute_ps(vertices, _MM_SHUFFLE(0, 0, 0, 0)));
+		r = _mm256_add_ps(r, _mm256_mul_ps(col1, _mm256_permute_ps(vertices, _MM_SHUFFLE(1, 1, 1, 1))));
+		r = _mm256_add_ps(r, _mm256_mul_ps(col2, _mm256_permute_ps(vertices, _MM_SHUFFLE(2, 2, 2, 2))));
+		_mm256_storeu_ps(v, _mm256_add_ps(r, col3));
+		std::memcpy(data, v, 3 * sizeof(float));
+		std::memcpy(data + stride, v + 4, 3 * sizeof(float));
+	}
+	if(i < count)
+		transformSSE(data, stride, 1, m, rowLength, translate);
+}
+
+static void transformPositionsAVX(uint8_t * data, std::size_t stride, uint32_t count, const float * m) {
+	transformAVX(data, stride, count, m, 4, true);
+}
+static void transformDirectionsAVX(uint8_t * data, std::size_t stride, uint32_t count, const float * m) {
+	transformAVX(data, stride, count, m, 3, false);
+}
+#endif
+
+// ---------------------------------------------------------------------
+// NEON
+
+#if defined(RENDERING_TRANSFORM_NEON)
+static void transformNEON(uint8_t * data, std::size_t stride, uint32_t count, const float * m, std::size_t rowLength, bool translate) {
+	const float c0[4] = {m[0], m[rowLength], m[2 * rowLength], 0.0f};
+	const float c1[4] = {m[1], m[rowLength + 1], m[2 * rowLength + 1], 0.0f};
+	const float c2[4] = {m[2], m[rowLength + 2], m[2 * rowLength + 2], 0.0f};
+	const float c3[4] = {translate ? m[3] : 0.0f, translate ? m[7] : 0.0f, translate ? m[11] : 0.0f, 0.0f};
+	const float32x4_t col0 = vld1q_f32(c0);
+	const float32x4_t col1 = vld1q_f32(c1);
+	const float32x4_t col2 = vld1q_f32(c2);
+	const float32x4_t col3 = vld1q_f32(c3);
+	for(uint32_t i = 0; i < count; ++i, data += stride) {
+		float v[4];
+		std::memcpy(v, data, 3 * sizeof(float));
+		float32x4_t r = vmlaq_n_f32(col3, col0, v[0]);
+		r = vmlaq_n_f32(r, col1, v[1]);
+		r = vmlaq_n_f32(r, col2, v[2]);
+		vst1q_f32(v, r);
+		std::memcpy(data, v, 3 * sizeof(float));
+	}
+}
+
+static void transformPositionsNEON(uint8_t * data, std::size_t stride, uint32_t count, const float * m) {
+	transformNEON(data, stride, count, m, 4, true);
+}
+static void transformDirectionsNEON(uint8_t * data, std::size_t stride, uint32_t count, const float * m) {
+	transformNEON(data, stride, count, m, 3, false);
+}
+#endif
+
+// ---------------------------------------------------------------------
+// dispatch
+
+typedef void (*kernel_t)(uint8_t *, std::size_t, uint32_t, const float *);
+struct Kernels {
+	kernel_t positions;
+	kernel_t directions;
+	const char * name;
+};
+
+static Kernels selectKernels() {
+#if defined(RENDERING_TRANSFORM_AVX)
+	if(__builtin_cpu_supports("avx"))
+		return Kernels{transformPositionsAVX, transformDirectionsAVX, "AVX"};
+#endif
+#if defined(RENDERING_TRANSFORM_SSE2)
+	return Kernels{transformPositionsSSE, transformDirectionsSSE, "SSE2"};
+#elif defined(RENDERING_TRANSFORM_NEON)
+	return Kernels{transformPositionsNEON, transformDirectionsNEON, "NEON"};
+#else
+	return Kernels{transformPositionsScalar, transformDirectionsScalar, "scalar"};
+#endif
+}
+
+static const Kernels & getKernels() {
+	static const Kernels kernels = selectKernels();
+	return kernels;
+}
+
+void transformPositions3f(uint8_t * data, std::size_t stride, uint32_t count, const float matrix[12]) {
+	getKernels().positions(data, stride, count, matrix);
+}
+
+void transformDirections3f(uint8_t * data, std::size_t stride, uint32_t count, const float matrix[9]) {
+	getKernels().directions(data, stride, count, matrix);
+}
+
+void transformDirections4b(uint8_t * data, std::size_t stride, uint32_t count, const float matrix[9]) {
+	const float * m = matrix;
+	for(uint32_t i = 0; i < count; ++i, data += stride) {
+		int8_t * v = reinterpret_cast<int8_t *>(data);
+		const float x = Geometry::Convert::fromSignedTo<float>(v[0]);
+		const float y = Geometry::Convert::fromSignedTo<float>(v[1]);
+		const float z = Geometry::Convert::fromSignedTo<float>(v[2]);
+		v[0] = Geometry::Convert::toSigned<int8_t>(m[0] * x + m[1] * y + m[2] * z);
+		v[1] = Geometry::Convert::toSigned<int8_t>(m[3] * x + m[4] * y + m[5] * z);
+		v[2] = Geometry::Convert::toSigned<int8_t>(m[6] * x + m[7] * y + m[8] * z);
+		v[3] = 0;
+	}
+}
+
+const char * getImplementationName() {
+	return getKernels().name;
+}
+
+}
+}
+}
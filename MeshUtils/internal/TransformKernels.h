@@ -0,0 +1,43 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_TRANSFORMKERNELS_H_
+#define RENDERING_MESHUTILS_TRANSFORMKERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Rendering {
+namespace MeshUtils {
+/**
+ * (internal) Batch kernels transforming interleaved vertex attributes in place.
+ * The implementation (AVX, SSE2, NEON or scalar) is chosen once at runtime depending on the CPU.
+ * The matrices are given row-major: 3x4 for positions (the last row of the 4x4 matrix has to be (0,0,0,1))
+ * and 3x3 for directions.
+ */
+namespace TransformKernels {
+
+//! Transform the first three float values of @p count vertices (with the given stride in bytes) as positions.
+void transformPositions3f(uint8_t * data, std::size_t stride, uint32_t count, const float matrix[12]);
+
+//! Transform the first three float values of @p count vertices as directions.
+void transformDirections3f(uint8_t * data, std::size_t stride, uint32_t count, const float matrix[9]);
+
+//! Transform normalized signed byte directions (four bytes, the last one is set to 0).
+void transformDirections4b(uint8_t * data, std::size_t stride, uint32_t count, const float matrix[9]);
+
+//! Name of the selected implementation ("AVX", "SSE2", "NEON" or "scalar").
+const char * getImplementationName();
+
+}
+}
+}
+
+#endif /* RENDERING_MESHUTILS_TRANSFORMKERNELS_H_ */
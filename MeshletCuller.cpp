@@ -0,0 +1,187 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MeshletCuller.h"
+#include "Mesh/Mesh.h"
+#include "Mesh/MeshVertexData.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Shader/Shader.h"
+#include "Shader/ShaderObjectInfo.h"
+#include "Shader/Uniform.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Vec3.h>
+#include <Geometry/Vec4.h>
+#include <Util/Macros.h>
+
+namespace Rendering {
+
+static const char * const cullingProgram =
+R"***(#version 430
+layout(local_size_x = 64) in;
+
+struct MeshletBounds {
+	vec4 sphere;	// center, radius
+	vec4 cone;		// axis, cutoff
+};
+struct DrawCommand {
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	uint baseVertex;
+	uint baseInstance;
+};
+layout(std430, binding = 0) readonly buffer Bounds { MeshletBounds bounds[]; };
+layout(std430, binding = 1) buffer Commands { DrawCommand commands[]; };
+
+uniform mat4 modelToClipping;
+uniform vec3 cameraPosition; // in model space
+uniform int meshletCount;
+uniform bool coneCulling;
+
+void main() {
+	const uint i = gl_GlobalInvocationID.x;
+	if(i >= uint(meshletCount))
+		return;
+	const vec4 sphere = bounds[i].sphere;
+	const mat4 m = transpose(modelToClipping);
+	const vec4 planes[6] = vec4[6](m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[3] + m[2], m[3] - m[2]);
+	bool visible = true;
+	for(int p = 0; p < 6; ++p) {
+		if(dot(planes[p].xyz, sphere.xyz) + planes[p].w < -sphere.w * length(planes[p].xyz))
+			visible = false;
+	}
+	if(visible && coneCulling) {
+		const vec4 cone = bounds[i].cone;
+		const vec3 toCenter = sphere.xyz - cameraPosition;
+		if(dot(toCenter, cone.xyz) >= cone.w * length(toCenter) + sphere.w)
+			visible = false;
+	}
+	commands[i].instanceCount = visible ? 1u : 0u;
+}
+)***";
+
+//! (static)
+bool MeshletCuller::isSupported() {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_multi_draw_indirect) && defined(GL_ARB_shader_storage_buffer_object)
+	static const bool support = isExtensionSupported("GL_ARB_compute_shader") &&
+								isExtensionSupported("GL_ARB_multi_draw_indirect") &&
+								isExtensionSupported("GL_ARB_shader_storage_buffer_object");
+	return support;
+#else
+	return false;
+#endif
+}
+
+MeshletCuller::MeshletCuller(Mesh * _mesh, uint32_t maxVertices, uint32_t maxTriangles) :
+		ReferenceCounter_t(), mesh(_mesh), meshletData(MeshUtils::getMeshlets(_mesh, maxVertices, maxTriangles)),
+		coneCulling(true), uploaded(false) {
+}
+
+MeshletCuller::~MeshletCuller() = default;
+
+//! (internal)
+void MeshletCuller::upload() {
+	if(uploaded)
+		return;
+	std::vector<float> bounds;
+	std::vector<uint32_t> commands;
+	bounds.reserve(meshletData.meshlets.size() * 8);
+	commands.reserve(meshletData.meshlets.size() * 5);
+	for(const auto & meshlet : meshletData.meshlets) {
+		bounds.insert(bounds.end(), meshlet.center, meshlet.center + 3);
+		bounds.push_back(meshlet.radius);
+		bounds.insert(bounds.end(), meshlet.coneAxis, meshlet.coneAxis + 3);
+		bounds.push_back(meshlet.coneCutoff);
+		commands.push_back(meshlet.triangleCount * 3);	// count
+		commands.push_back(1);							// instanceCount
+		commands.push_back(meshlet.triangleOffset * 3);	// firstIndex
+		commands.push_back(0);							// baseVertex
+		commands.push_back(0);							// baseInstance
+	}
+	boundsBuffer.uploadData(BufferObject::TARGET_SHADER_STORAGE_BUFFER, bounds, BufferObject::USAGE_STATIC_DRAW);
+	commandBuffer.uploadData(BufferObject::TARGET_DRAW_INDIRECT_BUFFER, commands, BufferObject::USAGE_DYNAMIC_COPY);
+	indexBuffer.uploadData(BufferObject::TARGET_ELEMENT_ARRAY_BUFFER, meshletData.createIndices(), BufferObject::USAGE_STATIC_DRAW);
+	uploaded = true;
+	GET_GL_ERROR();
+}
+
+void MeshletCuller::cull(RenderingContext & context) {
+	if(meshletData.meshlets.empty())
+		return;
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_multi_draw_indirect) && defined(GL_ARB_shader_storage_buffer_object)
+	if(!isSupported()) {
+		WARN("MeshletCuller::cull: GPU culling is not supported.");
+		return;
+	}
+	if(cullingShader.isNull()) {
+		cullingShader = Shader::createShader(Shader::USE_UNIFORMS);
+		cullingShader->attachShaderObject(ShaderObjectInfo::createCompute(cullingProgram));
+	}
+	upload();
+
+	const Geometry::Matrix4x4 & modelToCamera = context.getMatrix_modelToCamera();
+	const Geometry::Vec4 cameraPosition = modelToCamera.inverse() * Geometry::Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	context.pushAndSetShader(cullingShader.get());
+	cullingShader->setUniform(context, Uniform("modelToClipping", context.getMatrix_cameraToClipping() * modelToCamera));
+	cullingShader->setUniform(context, Uniform("cameraPosition", Geometry::Vec3(cameraPosition.xyz() / cameraPosition.getW())));
+	cullingShader->setUniform(context, Uniform("meshletCount", static_cast<int32_t>(getMeshletCount())));
+	cullingShader->setUniform(context, Uniform("coneCulling", coneCulling));
+	boundsBuffer.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, BOUNDS_BINDING);
+	commandBuffer.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, COMMAND_BINDING);
+
+	context.dispatchCompute((getMeshletCount() + 63) / 64);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+	commandBuffer.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, COMMAND_BINDING);
+	boundsBuffer.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, BOUNDS_BINDING);
+	context.popShader();
+	GET_GL_ERROR();
+#else
+	WARN("MeshletCuller::cull: GPU culling is not supported.");
+#endif
+}
+
+void MeshletCuller::draw(RenderingContext & context) {
+	if(meshletData.meshlets.empty())
+		return;
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_multi_draw_indirect) && defined(GL_ARB_shader_storage_buffer_object)
+	if(!isSupported()) {
+		WARN("MeshletCuller::draw: Multi draw indirect is not supported.");
+		return;
+	}
+	if(context.getActiveShader() == nullptr) {
+		WARN("MeshletCuller::draw: No active shader.");
+		return;
+	}
+	context.applyChanges();
+	upload();
+
+	MeshVertexData & vertexData = mesh->_getVertexData();
+	if(!vertexData.isUploaded())
+		vertexData.upload();
+	vertexData.bind(context, true, false);
+	indexBuffer.bind(BufferObject::TARGET_ELEMENT_ARRAY_BUFFER);
+	commandBuffer.bind(BufferObject::TARGET_DRAW_INDIRECT_BUFFER);
+
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(getMeshletCount()), 0);
+
+	commandBuffer.unbind(BufferObject::TARGET_DRAW_INDIRECT_BUFFER);
+	indexBuffer.unbind(BufferObject::TARGET_ELEMENT_ARRAY_BUFFER);
+	vertexData.unbind(context, true);
+	GET_GL_ERROR();
+#else
+	WARN("MeshletCuller::draw: Multi draw indirect is not supported.");
+#endif
+}
+
+}
@@ -0,0 +1,81 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHLETCULLER_H_
+#define RENDERING_MESHLETCULLER_H_
+
+#include "BufferObject.h"
+#include "MeshUtils/Meshlets.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+class Shader;
+
+/**
+ * GPU-driven culling of the meshlets of a mesh (see MeshUtils::buildMeshlets).
+ *
+ * The meshlet bounds are stored in a shader storage buffer (std430 array of { vec4 sphere; vec4 cone; })
+ * and every meshlet has one draw command (DrawElementsIndirectCommand) in a second buffer.
+ * cull() dispatches a compute shader that tests each meshlet against the view frustum and its normal cone and
+ * sets the instance count of the command to zero or one. draw() renders all commands with a single call of
+ * glMultiDrawElementsIndirect from the mesh's vertex buffer using the active shader, so the CPU never reads back
+ * the visibility.
+ *
+ * During cull(), the bounds are bound to shader storage binding point BOUNDS_BINDING and
+ * the commands to COMMAND_BINDING.
+ *
+ * @note Requires OpenGL 4.3 (compute shaders, multi draw indirect and shader storage buffers).
+ */
+class MeshletCuller : public Util::ReferenceCounter<MeshletCuller> {
+	public:
+		static const uint32_t BOUNDS_BINDING = 0;
+		static const uint32_t COMMAND_BINDING = 1;
+
+		static bool isSupported();
+
+		/*! Build the meshlets of the given triangle mesh, or use the ones cached by the mesh (see MeshUtils::getMeshlets()).
+			@throw std::invalid_argument if the mesh is no indexed triangle mesh with positions. */
+		explicit MeshletCuller(Mesh * mesh, uint32_t maxVertices = 64, uint32_t maxTriangles = 124);
+		~MeshletCuller();
+
+		Mesh * getMesh() const								{	return mesh.get();	}
+		const MeshUtils::MeshletData & getMeshletData() const	{	return meshletData;	}
+		uint32_t getMeshletCount() const					{	return static_cast<uint32_t>(meshletData.meshlets.size());	}
+
+		void setConeCullingEnabled(bool b)					{	coneCulling = b;	}
+		bool isConeCullingEnabled() const					{	return coneCulling;	}
+
+		//! Determine the visible meshlets for the current modelview and projection matrices.
+		void cull(RenderingContext & context);
+
+		//! Draw the meshlets that passed the last call of cull() (or all meshlets if cull() was never called).
+		void draw(RenderingContext & context);
+
+	private:
+		Util::Reference<Mesh> mesh;
+		MeshUtils::MeshletData meshletData;
+		bool coneCulling;
+		bool uploaded;
+		BufferObject boundsBuffer;
+		BufferObject commandBuffer;
+		BufferObject indexBuffer;
+		Util::Reference<Shader> cullingShader;
+
+		void upload();
+};
+
+}
+
+#endif /* RENDERING_MESHLETCULLER_H_ */
@@ -0,0 +1,210 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MultiDrawBatch.h"
+#include "Mesh/Mesh.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Shader/Shader.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Geometry/Matrix4x4.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace Rendering {
+
+const Util::StringIdentifier MultiDrawBatch::DRAW_ID_ATTRIBUTE("sg_DrawId");
+
+//! (static)
+bool MultiDrawBatch::isSupported() {
+#if defined(LIB_GL) && defined(GL_ARB_multi_draw_indirect) && defined(GL_ARB_shader_storage_buffer_object)
+	static const bool support = isExtensionSupported("GL_ARB_multi_draw_indirect") && isExtensionSupported("GL_ARB_shader_storage_buffer_object");
+	return support;
+#else
+	return false;
+#endif
+}
+
+//! (internal) Store the matrix column-major at the given position.
+static void storeMatrix(std::vector<float> & matrices, uint32_t drawIndex, const Geometry::Matrix4x4 & matrix) {
+	float * ptr = matrices.data() + drawIndex * 16;
+	for(uint_fast8_t i = 0; i < 4; ++i) {
+		for(uint_fast8_t j = 0; j < 4; ++j) {
+			*ptr++ = matrix.at(j, i);
+		}
+	}
+}
+
+MultiDrawBatch::MultiDrawBatch() : geometryChanged(false), matricesChanged(false), glDrawMode(GL_TRIANGLES), vertexCount(0) {
+}
+
+MultiDrawBatch::~MultiDrawBatch() = default;
+
+uint32_t MultiDrawBatch::addMesh(Mesh * mesh, const Geometry::Matrix4x4 & modelMatrix) {
+	if(mesh == nullptr || !mesh->isUsingIndexData())
+		throw std::invalid_argument("MultiDrawBatch::addMesh: Mesh without index data.");
+	if(empty()) {
+		vertexDescription = mesh->getVertexDescription();
+		glDrawMode = mesh->getGLDrawMode();
+	} else if(!(mesh->getVertexDescription() == vertexDescription) || mesh->getGLDrawMode() != glDrawMode) {
+		throw std::invalid_argument("MultiDrawBatch::addMesh: Vertex description or draw mode differs from the batch.");
+	}
+	const MeshVertexData & vd = mesh->openVertexData();
+	const MeshIndexData & id = mesh->openIndexData();
+
+	const uint32_t drawIndex = getDrawCount();
+	indirectCommands.push_back(id.getIndexCount());
+	indirectCommands.push_back(1);									// instanceCount
+	indirectCommands.push_back(static_cast<uint32_t>(indices.size()));	// firstIndex
+	indirectCommands.push_back(vertexCount);						// baseVertex
+	indirectCommands.push_back(drawIndex);							// baseInstance
+	drawIndices.push_back(drawIndex);
+
+	vertices.insert(vertices.end(), vd.data(), vd.data() + vd.dataSize());
+	indices.insert(indices.end(), id.data(), id.data() + id.getIndexCount());
+	vertexCount += vd.getVertexCount();
+
+	matrices.resize(matrices.size() + 16);
+	storeMatrix(matrices, drawIndex, modelMatrix);
+
+	geometryChanged = true;
+	matricesChanged = true;
+	return drawIndex;
+}
+
+void MultiDrawBatch::setModelMatrix(uint32_t drawIndex, const Geometry::Matrix4x4 & modelMatrix) {
+	if(drawIndex >= getDrawCount())
+		throw std::out_of_range("MultiDrawBatch::setModelMatrix: Invalid draw index.");
+	storeMatrix(matrices, drawIndex, modelMatrix);
+	matricesChanged = true;
+}
+
+void MultiDrawBatch::clear() {
+	vertices.clear();
+	indices.clear();
+	indirectCommands.clear();
+	drawIndices.clear();
+	matrices.clear();
+	vertexCount = 0;
+	vertexData = MeshVertexData();
+	indexBuffer.destroy();
+	indirectBuffer.destroy();
+	drawIdBuffer.destroy();
+	matrixBuffer.destroy();
+	visibleCommands.clear();
+	visibleIndirectBuffer.destroy();
+	geometryChanged = matricesChanged = false;
+}
+
+//! (internal)
+void MultiDrawBatch::upload() {
+	if(geometryChanged) {
+		vertexData.allocate(vertexCount, vertexDescription);
+		std::copy(vertices.begin(), vertices.end(), vertexData.data());
+		vertexData.upload(GL_STATIC_DRAW);
+		vertexData.releaseLocalData();
+		indexBuffer.uploadData(GL_ELEMENT_ARRAY_BUFFER, indices, GL_STATIC_DRAW);
+		indirectBuffer.uploadData(BufferObject::TARGET_DRAW_INDIRECT_BUFFER, indirectCommands, GL_STATIC_DRAW);
+		drawIdBuffer.uploadData(GL_ARRAY_BUFFER, drawIndices, GL_STATIC_DRAW);
+		geometryChanged = false;
+		// the buffer size changed
+		matrixBuffer.destroy();
+		matricesChanged = true;
+	}
+	if(matricesChanged) {
+		if(matrixBuffer.isValid()) {
+			matrixBuffer.uploadSubData(BufferObject::TARGET_SHADER_STORAGE_BUFFER, matrices);
+		} else {
+			matrixBuffer.uploadData(BufferObject::TARGET_SHADER_STORAGE_BUFFER, matrices, GL_DYNAMIC_DRAW);
+		}
+		matricesChanged = false;
+	}
+	GET_GL_ERROR();
+}
+
+void MultiDrawBatch::draw(RenderingContext & context, uint32_t matrixBinding) {
+	if(empty())
+		return;
+	drawCommands(context, indirectBuffer, getDrawCount(), getIndexCount(), matrixBinding);
+}
+
+void MultiDrawBatch::draw(RenderingContext & context, const std::vector<uint32_t> & visibleDrawIndices, uint32_t matrixBinding) {
+	if(visibleDrawIndices.empty())
+		return;
+	if(visibleDrawIndices.size() == drawIndices.size()) {
+		draw(context, matrixBinding);
+		return;
+	}
+	// the base instance keeps the draw index, so the draw id attribute and the matrices stay valid
+	visibleCommands.resize(visibleDrawIndices.size() * 5);
+	uint32_t * command = visibleCommands.data();
+	uint32_t visibleIndexCount = 0;
+	for(const uint32_t drawIndex : visibleDrawIndices) {
+		if(drawIndex >= getDrawCount())
+			throw std::out_of_range("MultiDrawBatch::draw: Invalid draw index.");
+		command = std::copy(indirectCommands.begin() + drawIndex * 5, indirectCommands.begin() + drawIndex * 5 + 5, command);
+		visibleIndexCount += indirectCommands[drawIndex * 5];
+	}
+	visibleIndirectBuffer.uploadData(BufferObject::TARGET_DRAW_INDIRECT_BUFFER, visibleCommands, GL_STREAM_DRAW);
+	drawCommands(context, visibleIndirectBuffer, static_cast<uint32_t>(visibleDrawIndices.size()), visibleIndexCount, matrixBinding);
+}
+
+//! (internal)
+void MultiDrawBatch::drawCommands(RenderingContext & context, BufferObject & commandBuffer, uint32_t commandCount, uint32_t commandIndexCount, uint32_t matrixBinding) {
+#if defined(LIB_GL) && defined(GL_ARB_multi_draw_indirect) && defined(GL_ARB_shader_storage_buffer_object)
+	if(!isSupported()) {
+		WARN("MultiDrawBatch::draw: Multi draw indirect is not supported.");
+		return;
+	}
+	Shader * shader = context.getActiveShader();
+	if(shader == nullptr) {
+		WARN("MultiDrawBatch::draw: No active shader.");
+		return;
+	}
+	context.applyChanges();
+	upload();
+
+	vertexData.bind(context, true, false);
+	const int32_t drawIdLocation = shader->getVertexAttributeLocation(DRAW_ID_ATTRIBUTE);
+	if(drawIdLocation != -1) {
+		const GLuint location = static_cast<GLuint>(drawIdLocation);
+		drawIdBuffer.bind(GL_ARRAY_BUFFER);
+		glVertexAttribIPointer(location, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+		glEnableVertexAttribArray(location);
+		glVertexAttribDivisor(location, 1);
+		drawIdBuffer.unbind(GL_ARRAY_BUFFER);
+	}
+	matrixBuffer.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, matrixBinding);
+	indexBuffer.bind(GL_ELEMENT_ARRAY_BUFFER);
+	commandBuffer.bind(BufferObject::TARGET_DRAW_INDIRECT_BUFFER);
+
+	glMultiDrawElementsIndirect(glDrawMode, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(commandCount), 0);
+	RenderingContext::FrameCounters & counters = RenderingContext::_getFrameCounters();
+	++counters.drawCalls;
+	if(glDrawMode == GL_TRIANGLES)
+		counters.primitives += commandIndexCount / 3;
+
+	commandBuffer.unbind(BufferObject::TARGET_DRAW_INDIRECT_BUFFER);
+	indexBuffer.unbind(GL_ELEMENT_ARRAY_BUFFER);
+	matrixBuffer.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, matrixBinding);
+	if(drawIdLocation != -1) {
+		const GLuint location = static_cast<GLuint>(drawIdLocation);
+		glVertexAttribDivisor(location, 0);
+		glDisableVertexAttribArray(location);
+	}
+	vertexData.unbind(context, true);
+	GET_GL_ERROR();
+#else
+	WARN("MultiDrawBatch::draw: Multi draw indirect is not supported.");
+#endif
+}
+
+}
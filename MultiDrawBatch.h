@@ -0,0 +1,109 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MULTIDRAWBATCH_H_
+#define RENDERING_MULTIDRAWBATCH_H_
+
+#include "BufferObject.h"
+#include "Mesh/MeshVertexData.h"
+#include "Mesh/VertexDescription.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/StringIdentifier.h>
+#include <cstdint>
+#include <vector>
+
+namespace Geometry {
+template<typename _T> class _Matrix4x4;
+typedef _Matrix4x4<float> Matrix4x4;
+}
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+
+/**
+ * Batch of static meshes with identical vertex descriptions and draw modes that are drawn
+ * with a single call of glMultiDrawElementsIndirect.
+ * 
+ * The vertices and indices of all meshes are copied into one shared vertex buffer and one shared index buffer.
+ * Each mesh becomes one indirect draw command. Its model matrix is stored in a shader storage buffer
+ * (std430 array of mat4, bound to the given binding point), and the index of the draw command is passed to
+ * the shader using the integer vertex attribute @a DRAW_ID_ATTRIBUTE (instanced by the draw command's base instance).
+ * 
+ * \code
+ * layout(std430, binding = 0) readonly buffer DrawMatrices { mat4 sg_drawMatrices[]; };
+ * in uint sg_DrawId;
+ * ...
+ * gl_Position = sg_matrix_modelToClipping * sg_drawMatrices[sg_DrawId] * vec4(sg_Position, 1.0);
+ * \endcode
+ * 
+ * @note Requires OpenGL 4.3 (multi draw indirect and shader storage buffers).
+ */
+class MultiDrawBatch : public Util::ReferenceCounter<MultiDrawBatch> {
+	public:
+		//! Name of the vertex attribute containing the draw index ("sg_DrawId").
+		static const Util::StringIdentifier DRAW_ID_ATTRIBUTE;
+
+		static bool isSupported();
+
+		MultiDrawBatch();
+		~MultiDrawBatch();
+
+		/*! Add the vertices and indices of the given mesh to the batch.
+			The first mesh determines the vertex description and draw mode of the batch.
+			@return The index of the new draw command, which can be used to update the model matrix.
+			@throw std::invalid_argument if the mesh does not use indices or does not match the batch.	*/
+		uint32_t addMesh(Mesh * mesh, const Geometry::Matrix4x4 & modelMatrix);
+
+		void setModelMatrix(uint32_t drawIndex, const Geometry::Matrix4x4 & modelMatrix);
+
+		uint32_t getDrawCount() const					{	return static_cast<uint32_t>(drawIndices.size());	}
+		uint32_t getVertexCount() const					{	return vertexCount;	}
+		uint32_t getIndexCount() const					{	return static_cast<uint32_t>(indices.size());	}
+		bool empty() const								{	return drawIndices.empty();	}
+
+		//! Remove all meshes and free the buffers.
+		void clear();
+
+		/*! Draw all meshes of the batch using the active shader. Changed data is uploaded automatically.
+			@param matrixBinding Binding point of the shader storage buffer containing the model matrices. */
+		void draw(RenderingContext & context, uint32_t matrixBinding = 0);
+
+		/*! Draw only the meshes with the given (ascending) draw indices, e.g. the result of FrustumCuller::cull().
+			The indirect commands of these meshes are copied into a separate buffer for every call. */
+		void draw(RenderingContext & context, const std::vector<uint32_t> & visibleDrawIndices, uint32_t matrixBinding = 0);
+
+	private:
+		bool geometryChanged;
+		bool matricesChanged;
+		uint32_t glDrawMode;
+		uint32_t vertexCount;
+		VertexDescription vertexDescription;
+
+		std::vector<uint8_t> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<uint32_t> indirectCommands; //!< count, instanceCount, firstIndex, baseVertex, baseInstance
+		std::vector<uint32_t> drawIndices;
+		std::vector<float> matrices; //!< column-major
+
+		MeshVertexData vertexData;
+		BufferObject indexBuffer;
+		BufferObject indirectBuffer;
+		BufferObject drawIdBuffer;
+		BufferObject matrixBuffer;
+		std::vector<uint32_t> visibleCommands;
+		BufferObject visibleIndirectBuffer;
+
+		void upload();
+		void drawCommands(RenderingContext & context, BufferObject & commandBuffer, uint32_t commandCount, uint32_t commandIndexCount, uint32_t matrixBinding);
+};
+
+}
+
+#endif /* RENDERING_MULTIDRAWBATCH_H_ */
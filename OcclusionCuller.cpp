@@ -0,0 +1,250 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "OcclusionCuller.h"
+#include "OcclusionQuery.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Draw.h"
+#include <Geometry/Box.h>
+#include <Geometry/Definitions.h>
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Vec3.h>
+#include <Geometry/Vec4.h>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace Rendering {
+
+//! (internal) State of the traversal of a single frame.
+struct OcclusionCuller::FrameData {
+	typedef std::pair<float, uint32_t> entry_t; // distance, node
+	RenderingContext & context;
+	Hierarchy & hierarchy;
+	Geometry::Matrix4x4 modelToClipping;
+	Geometry::Vec3 cameraPosition;
+	std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> traversalQueue;
+	std::deque<PendingQuery> queryQueue;
+	std::vector<uint32_t> invisibleQueue;
+	std::vector<uint32_t> visibleQueue;
+	std::vector<uint32_t> children;
+
+	FrameData(RenderingContext & _context, Hierarchy & _hierarchy) : context(_context), hierarchy(_hierarchy) {
+	}
+
+	enum class BoxTest { OUTSIDE, INTERSECTS_NEAR_PLANE, INSIDE };
+	//! Test the box against the view frustum.
+	BoxTest testBox(const Geometry::Box & box) const {
+		uint_fast8_t outside[6] = {0, 0, 0, 0, 0, 0};
+		bool behindCamera = false;
+		for(uint_fast8_t c = 0; c < 8; ++c) {
+			const Geometry::Vec4 p = modelToClipping * Geometry::Vec4(box.getCorner(static_cast<Geometry::corner_t>(c)), 1.0f);
+			const float w = p.getW();
+			if(p.getX() < -w) ++outside[0];
+			if(p.getX() > w) ++outside[1];
+			if(p.getY() < -w) ++outside[2];
+			if(p.getY() > w) ++outside[3];
+			if(p.getZ() < -w) ++outside[4];
+			if(p.getZ() > w) ++outside[5];
+			if(w <= 0.0f)
+				behindCamera = true;
+		}
+		for(const auto count : outside) {
+			if(count == 8)
+				return BoxTest::OUTSIDE;
+		}
+		return (behindCamera || outside[4] > 0) ? BoxTest::INTERSECTS_NEAR_PLANE : BoxTest::INSIDE;
+	}
+	void push(uint32_t node) {
+		traversalQueue.emplace(hierarchy.getBoundingBox(node).getDistanceSquared(cameraPosition), node);
+	}
+};
+
+OcclusionCuller::OcclusionCuller() :
+		batchSize(32), visibilityInterval(8), visiblePixelThreshold(0), waitForResults(false), frameNumber(1) {
+}
+
+OcclusionCuller::~OcclusionCuller() = default;
+
+void OcclusionCuller::reset() {
+	nodes.clear();
+	deferredQueries.clear();
+}
+
+//! (internal)
+OcclusionCuller::NodeState & OcclusionCuller::getState(uint32_t node) {
+	if(node >= nodes.size())
+		nodes.resize(node + 1);
+	return nodes[node];
+}
+
+//! (internal)
+std::unique_ptr<OcclusionQuery> OcclusionCuller::acquireQuery() {
+	if(freeQueries.empty())
+		return std::unique_ptr<OcclusionQuery>(new OcclusionQuery);
+	std::unique_ptr<OcclusionQuery> query(std::move(freeQueries.back()));
+	freeQueries.pop_back();
+	return query;
+}
+
+//! (internal) Mark the node and its ancestors as visible.
+void OcclusionCuller::pullUpVisibility(uint32_t node) {
+	while(node != NO_PARENT) {
+		NodeState & state = getState(node);
+		if(state.visible && state.lastVisited == frameNumber)
+			break;
+		state.visible = true;
+		node = state.parent;
+	}
+}
+
+//! (internal) Render a leaf or add the children of an inner node to the traversal queue.
+void OcclusionCuller::traverseNode(FrameData & frame, uint32_t node) {
+	if(frame.hierarchy.isLeaf(node)) {
+		frame.hierarchy.drawLeaf(frame.context, node);
+		++statistics.renderedLeaves;
+		return;
+	}
+	// the visibility of an inner node is determined by its children
+	getState(node).visible = false;
+	frame.children.clear();
+	frame.hierarchy.getChildren(node, frame.children);
+	for(const auto child : frame.children) {
+		getState(child).parent = node;
+		frame.push(child);
+	}
+}
+
+//! (internal) Issue the queries for all nodes in the queue.
+void OcclusionCuller::issueQueries(FrameData & frame, std::vector<uint32_t> & queue, bool wasVisible) {
+	if(queue.empty())
+		return;
+	OcclusionQuery::enableTestMode(frame.context);
+	for(const auto node : queue) {
+		PendingQuery pending;
+		pending.node = node;
+		pending.wasVisible = wasVisible;
+		pending.query = acquireQuery();
+		pending.query->begin();
+		drawFastAbsBox(frame.context, frame.hierarchy.getBoundingBox(node));
+		pending.query->end();
+		frame.queryQueue.emplace_back(std::move(pending));
+		++statistics.issuedQueries;
+	}
+	OcclusionQuery::disableTestMode(frame.context);
+	queue.clear();
+}
+
+//! (internal)
+void OcclusionCuller::handleResult(FrameData & frame, PendingQuery & pending, uint32_t result) {
+	freeQueries.emplace_back(std::move(pending.query));
+	NodeState & state = getState(pending.node);
+	if(result > visiblePixelThreshold) {
+		if(!pending.wasVisible)
+			traverseNode(frame, pending.node);
+		pullUpVisibility(pending.node);
+	} else {
+		state.visible = false;
+		++statistics.occludedNodes;
+	}
+}
+
+void OcclusionCuller::display(RenderingContext & context, Hierarchy & hierarchy, uint32_t root) {
+	++frameNumber;
+	statistics = Statistics();
+
+	// Evaluate the queries of the last frame that are available by now; the others are dropped.
+	while(!deferredQueries.empty()) {
+		PendingQuery & pending = deferredQueries.front();
+		if(pending.query->isResultAvailable() && pending.query->getResult() > visiblePixelThreshold) {
+			// treat the node as visible in the last frame
+			uint32_t node = pending.node;
+			while(node != NO_PARENT) {
+				NodeState & state = getState(node);
+				state.visible = true;
+				state.lastVisited = frameNumber - 1;
+				node = state.parent;
+			}
+		}
+		freeQueries.emplace_back(std::move(pending.query));
+		deferredQueries.pop_front();
+	}
+
+	FrameData frame(context, hierarchy);
+	const Geometry::Matrix4x4 & modelToCamera = context.getMatrix_modelToCamera();
+	frame.modelToClipping = context.getMatrix_cameraToClipping() * modelToCamera;
+	const Geometry::Vec4 camPos = modelToCamera.inverse() * Geometry::Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	frame.cameraPosition = camPos.xyz() / camPos.getW();
+
+	getState(root).parent = NO_PARENT;
+	frame.push(root);
+	while(true) {
+		// handle the available results
+		while(!frame.queryQueue.empty() && frame.queryQueue.front().query->isResultAvailable()) {
+			PendingQuery pending(std::move(frame.queryQueue.front()));
+			frame.queryQueue.pop_front();
+			handleResult(frame, pending, pending.query->getResult());
+		}
+		if(!frame.traversalQueue.empty()) {
+			const uint32_t node = frame.traversalQueue.top().second;
+			frame.traversalQueue.pop();
+			++statistics.traversedNodes;
+
+			NodeState & state = getState(node);
+			const bool wasVisible = state.visible && state.lastVisited == frameNumber - 1;
+			state.lastVisited = frameNumber;
+			const auto test = frame.testBox(hierarchy.getBoundingBox(node));
+			if(test == FrameData::BoxTest::OUTSIDE) {
+				state.visible = false;
+				continue;
+			}
+			if(test == FrameData::BoxTest::INTERSECTS_NEAR_PLANE) {
+				// the box cannot be queried reliably
+				traverseNode(frame, node);
+				if(hierarchy.isLeaf(node))
+					pullUpVisibility(node);
+				continue;
+			}
+			if(!wasVisible) {
+				frame.invisibleQueue.push_back(node);
+				if(frame.invisibleQueue.size() >= batchSize)
+					issueQueries(frame, frame.invisibleQueue, false);
+			} else {
+				if(hierarchy.isLeaf(node)) {
+					// spread the queries of visible leaves over the frames
+					if((frameNumber + node * 7919u) % visibilityInterval == 0)
+						frame.visibleQueue.push_back(node);
+					pullUpVisibility(node);
+				}
+				traverseNode(frame, node);
+			}
+			continue;
+		}
+		if(!frame.invisibleQueue.empty() || !frame.visibleQueue.empty()) {
+			issueQueries(frame, frame.invisibleQueue, false);
+			issueQueries(frame, frame.visibleQueue, true);
+			continue;
+		}
+		if(frame.queryQueue.empty())
+			break;
+		if(waitForResults) {
+			PendingQuery pending(std::move(frame.queryQueue.front()));
+			frame.queryQueue.pop_front();
+			handleResult(frame, pending, pending.query->getResult());
+			continue;
+		}
+		break;
+	}
+	statistics.deferredQueries = static_cast<uint32_t>(frame.queryQueue.size());
+	for(auto & pending : frame.queryQueue)
+		deferredQueries.emplace_back(std::move(pending));
+}
+
+}
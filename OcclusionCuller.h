@@ -0,0 +1,123 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_OCCLUSIONCULLER_H_
+#define RENDERING_OCCLUSIONCULLER_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace Geometry {
+template<typename value_t> class _Box;
+typedef _Box<float> Box;
+}
+namespace Rendering {
+class OcclusionQuery;
+class RenderingContext;
+
+/**
+ * Coherent hierarchical occlusion culling following CHC++ (Mattausch et al., "CHC++: Coherent Hierarchical
+ * Culling Revisited", 2008), built on OcclusionQuery, OcclusionQuery::enableTestMode() and drawFastAbsBox().
+ *
+ * The application provides its bounding volume hierarchy by implementing OcclusionCuller::Hierarchy.
+ * The hierarchy is traversed front to back. Nodes that were visible in the previous frame are rendered
+ * without waiting for a query; their visibility is only checked every few frames. Nodes that were invisible are
+ * collected and their bounding boxes are queried in batches. Query results are only fetched when they are available.
+ * Queries that are still pending when everything else is done are evaluated at the beginning of the next frame
+ * (unless setWaitForResults(true) is used), so a node that becomes visible may appear one frame late,
+ * but the CPU never waits for the GPU.
+ */
+class OcclusionCuller {
+	public:
+		//! Interface to the application's bounding volume hierarchy. Nodes are identified by (small) integers.
+		class Hierarchy {
+			public:
+				virtual ~Hierarchy() {}
+				//! Bounding box of the node in the coordinate system of the current modelview matrix.
+				virtual Geometry::Box getBoundingBox(uint32_t node) const = 0;
+				virtual bool isLeaf(uint32_t node) const = 0;
+				virtual void getChildren(uint32_t node, std::vector<uint32_t> & children) const = 0;
+				virtual void drawLeaf(RenderingContext & context, uint32_t node) = 0;
+		};
+
+		struct Statistics {
+			uint32_t traversedNodes;
+			uint32_t renderedLeaves;
+			uint32_t issuedQueries;
+			uint32_t occludedNodes;
+			uint32_t deferredQueries;	//!< Queries whose results were not available at the end of the frame.
+			Statistics() : traversedNodes(0), renderedLeaves(0), issuedQueries(0), occludedNodes(0), deferredQueries(0) {}
+		};
+
+		OcclusionCuller();
+		~OcclusionCuller();
+
+		//! Number of previously invisible nodes that are collected before their queries are issued (default: 32).
+		void setBatchSize(uint32_t size)					{	batchSize = size > 0 ? size : 1;	}
+		uint32_t getBatchSize() const						{	return batchSize;	}
+
+		//! Number of frames a visible leaf is assumed to stay visible before it is queried again (default: 8).
+		void setVisibilityInterval(uint32_t frames)			{	visibilityInterval = frames > 0 ? frames : 1;	}
+		uint32_t getVisibilityInterval() const				{	return visibilityInterval;	}
+
+		//! A node is visible if more samples than this threshold pass the depth test (default: 0).
+		void setVisiblePixelThreshold(uint32_t pixels)		{	visiblePixelThreshold = pixels;	}
+		uint32_t getVisiblePixelThreshold() const			{	return visiblePixelThreshold;	}
+
+		//! If @c true, the results of all queries are fetched in the same frame (which may stall).
+		void setWaitForResults(bool b)						{	waitForResults = b;	}
+		bool getWaitForResults() const						{	return waitForResults;	}
+
+		//! Render the visible leaves of the hierarchy starting at @p root.
+		void display(RenderingContext & context, Hierarchy & hierarchy, uint32_t root);
+
+		//! Forget all visibility information (e.g. after the hierarchy changed).
+		void reset();
+
+		const Statistics & getStatistics() const			{	return statistics;	}
+
+	private:
+		static const uint32_t NO_PARENT = 0xffffffff;
+		struct NodeState {
+			uint32_t lastVisited;
+			uint32_t parent;
+			bool visible;
+			NodeState() : lastVisited(0), parent(NO_PARENT), visible(false) {}
+		};
+		struct PendingQuery {
+			uint32_t node;
+			bool wasVisible;
+			std::unique_ptr<OcclusionQuery> query;
+		};
+		struct FrameData;
+
+		uint32_t batchSize;
+		uint32_t visibilityInterval;
+		uint32_t visiblePixelThreshold;
+		bool waitForResults;
+		uint32_t frameNumber;
+		std::vector<NodeState> nodes;
+		std::deque<PendingQuery> deferredQueries;
+		std::vector<std::unique_ptr<OcclusionQuery>> freeQueries;
+		Statistics statistics;
+
+		NodeState & getState(uint32_t node);
+		std::unique_ptr<OcclusionQuery> acquireQuery();
+		void pullUpVisibility(uint32_t node);
+		void traverseNode(FrameData & frame, uint32_t node);
+		void issueQueries(FrameData & frame, std::vector<uint32_t> & queue, bool wasVisible);
+		void handleResult(FrameData & frame, PendingQuery & pending, uint32_t result);
+};
+
+}
+
+#endif /* RENDERING_OCCLUSIONCULLER_H_ */
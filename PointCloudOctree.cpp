@@ -0,0 +1,564 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "PointCloudOctree.h"
+#include "Mesh/Mesh.h"
+#include "Mesh/LODMeshDataStrategy.h"
+#include "Mesh/MeshVertexData.h"
+#include "Mesh/VertexAttributeAccessors.h"
+#include "Mesh/VertexAttributeIds.h"
+#include "Mesh/VertexDescription.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Serialization/Serialization.h"
+#include "Serialization/StreamerMMF.h"
+#include "Serialization/StreamerXYZ.h"
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Rect.h>
+#include <Geometry/Vec3.h>
+#include <Geometry/Vec4.h>
+#include <Util/Graphics/Color.h>
+#include <Util/IO/FileName.h>
+#include <Util/IO/FileUtils.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <unordered_set>
+#include <utility>
+
+namespace Rendering {
+
+const char * const PointCloudOctree::indexFileName = "octree.pco";
+
+namespace {
+
+const uint32_t PCO_HEADER = 0x0d6f6370; // = "pco "
+const uint32_t PCO_VERSION = 0x01;
+
+//! Point as stored in the temporary files and the node meshes (position and RGBA color).
+struct Point {
+	float pos[3];
+	uint8_t color[4];
+};
+static_assert(sizeof(Point) == 16, "Point has to match the vertex description of the nodes.");
+
+const size_t pointsPerBlock = 65536;
+
+VertexDescription getPointDescription() {
+	VertexDescription vertexDesc;
+	vertexDesc.appendPosition3D();
+	vertexDesc.appendColorRGBAByte();
+	return vertexDesc;
+}
+
+std::string getTempPath(const std::string & directory, uint32_t node) {
+	return directory + '/' + std::to_string(node) + ".tmp";
+}
+
+//! Temporary file with the points of a node that has not been processed yet.
+class PointFile {
+	public:
+		PointFile(const std::string & _path) : path(_path), count(0) {}
+		~PointFile() {	flush();	}
+		bool open() {
+			output.open(path.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			return output.good();
+		}
+		bool add(const Point & point) {
+			buffer.push_back(point);
+			++count;
+			return buffer.size() < pointsPerBlock || flush();
+		}
+		bool flush() {
+			if(!buffer.empty() && output.is_open())
+				output.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(Point)));
+			buffer.clear();
+			return output.good();
+		}
+		bool close() {
+			const bool success = flush();
+			output.close();
+			return success && !output.fail();
+		}
+		uint64_t getCount() const	{	return count;	}
+	private:
+		const std::string path;
+		std::ofstream output;
+		std::vector<Point> buffer;
+		uint64_t count;
+};
+
+//! Read the points of a temporary file in blocks.
+template<typename callback_t>
+bool readPoints(const std::string & path, callback_t callback) {
+	std::ifstream input(path.c_str(), std::ios_base::in | std::ios_base::binary);
+	if(!input.good())
+		return false;
+	std::vector<Point> buffer(pointsPerBlock);
+	while(input.good()) {
+		input.read(reinterpret_cast<char *>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(Point)));
+		const size_t count = static_cast<size_t>(input.gcount()) / sizeof(Point);
+		for(size_t i = 0; i < count; ++i)
+			callback(buffer[i]);
+	}
+	return !input.bad();
+}
+
+bool writeNodeMesh(const std::string & path, const std::vector<Point> & points) {
+	Util::Reference<Mesh> mesh = new Mesh(getPointDescription(), static_cast<uint32_t>(points.size()), 0);
+	mesh->setDrawMode(Mesh::DRAW_POINTS);
+	mesh->setUseIndexData(false);
+	MeshVertexData & vd = mesh->openVertexData();
+	std::memcpy(vd.data(), points.data(), points.size() * sizeof(Point));
+	vd.markAsChanged();
+	vd.updateBoundingBox();
+
+	std::ofstream output(path.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	StreamerMMF streamer;
+	bool success = output.good() && streamer.saveMesh(mesh.get(), output);
+	output.close();
+	return success && !output.fail();
+}
+
+struct BuildNode {
+	float box[6];
+	uint32_t numPoints;
+	uint32_t children[8];
+	BuildNode() : numPoints(0) {
+		std::fill(std::begin(box), std::end(box), 0.0f);
+		std::fill(std::begin(children), std::end(children), 0);
+	}
+};
+
+class OctreeBuilder {
+	public:
+		OctreeBuilder(const std::string & _directory, const PointCloudOctree::BuildParameters & _parameters) :
+			directory(_directory), parameters(_parameters) {
+			parameters.maxPointsPerNode = std::max<uint32_t>(parameters.maxPointsPerNode, 1);
+			parameters.gridResolution = std::min<uint32_t>(std::max<uint32_t>(parameters.gridResolution, 1), 1024);
+		}
+
+		//! Process the node whose points are stored in its temporary file. The children are processed recursively.
+		bool processNode(uint32_t index, const Geometry::Vec3 & cellMin, float cellSize, uint32_t depth, uint64_t numPoints) {
+			const std::string tempPath = getTempPath(directory, index);
+			const bool isLeaf = numPoints <= parameters.maxPointsPerNode || depth >= parameters.maxDepth;
+			const uint32_t resolution = parameters.gridResolution;
+			const float toGrid = static_cast<float>(resolution) / cellSize;
+			const Geometry::Vec3 center = cellMin + Geometry::Vec3(cellSize, cellSize, cellSize) * 0.5f;
+
+			std::vector<Point> kept;
+			std::unordered_set<uint32_t> occupiedCells;
+			std::vector<std::unique_ptr<PointFile>> childFiles(8);
+			float box[6] = {	std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+								std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()	};
+			bool success = true;
+			success = readPoints(tempPath, [&](const Point & point) {
+				for(uint_fast8_t i = 0; i < 3; ++i) {
+					box[i] = std::min(box[i], point.pos[i]);
+					box[3 + i] = std::max(box[3 + i], point.pos[i]);
+				}
+				if(isLeaf) {
+					kept.push_back(point);
+					return;
+				}
+				if(kept.size() < parameters.maxPointsPerNode) {
+					uint32_t cell = 0;
+					for(int_fast8_t i = 2; i >= 0; --i) {
+						const float pos = (point.pos[i] - cellMin[i]) * toGrid;
+						const uint32_t c = pos <= 0.0f ? 0 : std::min(static_cast<uint32_t>(pos), resolution - 1);
+						cell = cell * resolution + c;
+					}
+					if(occupiedCells.insert(cell).second) {
+						kept.push_back(point);
+						return;
+					}
+				}
+				const uint32_t octant =	(point.pos[0] >= center.getX() ? 1 : 0) |
+										(point.pos[1] >= center.getY() ? 2 : 0) |
+										(point.pos[2] >= center.getZ() ? 4 : 0);
+				std::unique_ptr<PointFile> & childFile = childFiles[octant];
+				if(!childFile) {
+					childFile.reset(new PointFile(getTempPath(directory, static_cast<uint32_t>(nodes.size()) + octant)));
+					if(!childFile->open())
+						success = false;
+				}
+				if(!childFile->add(point))
+					success = false;
+			}) && success;
+			// The temporary files of the children are named after the first free indices; reserve them all.
+			const uint32_t firstChild = static_cast<uint32_t>(nodes.size());
+			if(!isLeaf)
+				nodes.resize(nodes.size() + 8);
+			for(auto & childFile : childFiles) {
+				if(childFile && !childFile->close())
+					success = false;
+			}
+			std::remove(tempPath.c_str());
+
+			BuildNode & node = nodes[index];
+			std::copy(std::begin(box), std::end(box), std::begin(node.box));
+			node.numPoints = static_cast<uint32_t>(kept.size());
+			success = success && writeNodeMesh(directory + '/' + std::to_string(index) + '.' + StreamerMMF::fileExtension, kept);
+			kept.clear();
+			kept.shrink_to_fit();
+			occupiedCells.clear();
+
+			const float childSize = cellSize * 0.5f;
+			for(uint32_t octant = 0; octant < 8 && !isLeaf; ++octant) {
+				if(!childFiles[octant])
+					continue;
+				const uint32_t childIndex = firstChild + octant;
+				const uint64_t childPoints = childFiles[octant]->getCount();
+				childFiles[octant].reset();
+				if(!success) {
+					std::remove(getTempPath(directory, childIndex).c_str());
+					continue;
+				}
+				nodes[index].children[octant] = childIndex;
+				const Geometry::Vec3 childMin(	cellMin.getX() + ((octant & 1) ? childSize : 0.0f),
+												cellMin.getY() + ((octant & 2) ? childSize : 0.0f),
+												cellMin.getZ() + ((octant & 4) ? childSize : 0.0f));
+				success = processNode(childIndex, childMin, childSize, depth + 1, childPoints) && success;
+			}
+			return success;
+		}
+
+		/*! Remove the unused indices (octants without points) and write the index file.
+			The order of the nodes is kept, so the new index of a node is not larger than its old one
+			and children are still stored after their parents.	*/
+		bool writeIndex(uint64_t totalPoints) {
+			std::vector<bool> used(nodes.size(), false);
+			used[0] = true;
+			for(const auto & node : nodes) {
+				for(const auto child : node.children) {
+					if(child != 0)
+						used[child] = true;
+				}
+			}
+			std::vector<uint32_t> newIndex(nodes.size(), 0);
+			std::vector<uint32_t> order;
+			for(uint32_t i = 0; i < nodes.size(); ++i) {
+				if(used[i]) {
+					newIndex[i] = static_cast<uint32_t>(order.size());
+					order.push_back(i);
+				}
+			}
+			bool success = true;
+			for(size_t i = 0; i < order.size(); ++i) { // rename the node files in increasing order
+				if(newIndex[order[i]] == order[i])
+					continue;
+				const std::string oldPath = directory + '/' + std::to_string(order[i]) + '.' + StreamerMMF::fileExtension;
+				const std::string newPath = directory + '/' + std::to_string(i) + '.' + StreamerMMF::fileExtension;
+				std::remove(newPath.c_str());
+				success = std::rename(oldPath.c_str(), newPath.c_str()) == 0 && success;
+			}
+
+			std::ofstream output((directory + '/' + PointCloudOctree::indexFileName).c_str(),
+									std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			auto writeValue = [&output](const void * value, size_t size) {
+				output.write(reinterpret_cast<const char *>(value), static_cast<std::streamsize>(size));
+			};
+			const uint32_t header[4] = {PCO_HEADER, PCO_VERSION, parameters.gridResolution, static_cast<uint32_t>(order.size())};
+			writeValue(header, sizeof(header));
+			writeValue(&totalPoints, sizeof(totalPoints));
+			for(const auto oldIndex : order) {
+				BuildNode node = nodes[oldIndex];
+				for(auto & child : node.children)
+					child = child == 0 ? 0 : newIndex[child];
+				writeValue(node.box, sizeof(node.box));
+				writeValue(&node.numPoints, sizeof(node.numPoints));
+				writeValue(node.children, sizeof(node.children));
+			}
+			output.close();
+			return success && !output.fail();
+		}
+
+		std::vector<BuildNode> nodes;
+
+	private:
+		const std::string directory;
+		PointCloudOctree::BuildParameters parameters;
+};
+
+//! Return true if the box is completely outside of one of the clipping planes.
+bool isOutsideFrustum(const Geometry::Matrix4x4 & modelToClipping, const Geometry::Box & box) {
+	uint32_t outside[6] = {0, 0, 0, 0, 0, 0};
+	for(uint_fast8_t c = 0; c < 8; ++c) {
+		const Geometry::Vec4 p = modelToClipping * Geometry::Vec4(box.getCorner(static_cast<Geometry::corner_t>(c)), 1.0f);
+		for(uint_fast8_t axis = 0; axis < 3; ++axis) {
+			if(p[axis] < -p[3])
+				++outside[2 * axis];
+			if(p[axis] > p[3])
+				++outside[2 * axis + 1];
+		}
+	}
+	return std::find(std::begin(outside), std::end(outside), 8) != std::end(outside);
+}
+
+}
+
+//! (static)
+bool PointCloudOctree::build(const PointSource_t & source, const std::string & directory, const BuildParameters & parameters) {
+	OctreeBuilder builder(directory, parameters);
+	builder.nodes.resize(1);
+
+	// Copy the points into the temporary file of the root and determine the bounding box.
+	float minPos[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+	float maxPos[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+	uint64_t numPoints = 0;
+	bool success;
+	{
+		PointFile rootFile(getTempPath(directory, 0));
+		success = rootFile.open();
+		if(success) {
+			source([&](Mesh * chunk) {
+				MeshVertexData & vd = chunk->openVertexData();
+				if(!vd.getVertexDescription().hasAttribute(VertexAttributeIds::POSITION)) {
+					WARN("PointCloudOctree: Chunk without positions.");
+					return false;
+				}
+				auto positions = PositionAttributeAccessor::create(vd);
+				Util::Reference<ColorAttributeAccessor> colors;
+				if(vd.getVertexDescription().hasAttribute(VertexAttributeIds::COLOR))
+					colors = ColorAttributeAccessor::create(vd);
+				for(uint32_t i = 0; i < vd.getVertexCount(); ++i) {
+					Point point;
+					const Geometry::Vec3 pos = positions->getPosition(i);
+					for(uint_fast8_t j = 0; j < 3; ++j) {
+						point.pos[j] = pos[j];
+						minPos[j] = std::min(minPos[j], point.pos[j]);
+						maxPos[j] = std::max(maxPos[j], point.pos[j]);
+					}
+					if(colors.isNotNull()) {
+						const Util::Color4ub color = colors->getColor4ub(i);
+						point.color[0] = color.getR();
+						point.color[1] = color.getG();
+						point.color[2] = color.getB();
+						point.color[3] = color.getA();
+					} else {
+						std::fill(std::begin(point.color), std::end(point.color), 255);
+					}
+					if(!rootFile.add(point)) {
+						success = false;
+						return false;
+					}
+				}
+				return true;
+			});
+			numPoints = rootFile.getCount();
+			success = rootFile.close() && success;
+		}
+	}
+	if(!success || numPoints == 0) {
+		WARN(numPoints == 0 ? "PointCloudOctree: No points." : "PointCloudOctree: Could not write to \"" + directory + "\".");
+		std::remove(getTempPath(directory, 0).c_str());
+		return false;
+	}
+
+	// the cells of the octree are cubes
+	const float cellSize = std::max(std::max(maxPos[0] - minPos[0], maxPos[1] - minPos[1]), std::max(maxPos[2] - minPos[2], std::numeric_limits<float>::min()));
+	success = builder.processNode(0, Geometry::Vec3(minPos[0], minPos[1], minPos[2]), cellSize * 1.0001f, 0, numPoints);
+	success = success && builder.writeIndex(numPoints);
+	if(!success)
+		WARN("PointCloudOctree: Could not write to \"" + directory + "\".");
+	return success;
+}
+
+//! (static)
+bool PointCloudOctree::build(const Util::FileName & input, const std::string & directory, const BuildParameters & parameters) {
+	if(input.getEnding() == StreamerXYZ::fileExtension) {
+		auto stream = Util::FileUtils::openForReading(input);
+		if(!stream || !stream->good()) {
+			WARN("PointCloudOctree: Could not open \"" + input.toString() + "\".");
+			return false;
+		}
+		return build([&stream](const ChunkCallback_t & callback) {
+			StreamerXYZ::loadPointChunks(*stream, 1000000, callback);
+		}, directory, parameters);
+	}
+	Util::Reference<Mesh> mesh = Serialization::loadMesh(input);
+	if(mesh.isNull())
+		return false;
+	return build([&mesh](const ChunkCallback_t & callback) {
+		callback(mesh.get());
+	}, directory, parameters);
+}
+
+//! (static)
+PointCloudOctree * PointCloudOctree::load(const std::string & directory, size_t graphicsMemoryBudget, uint32_t numLoaderThreads) {
+	const std::string indexPath = directory + '/' + indexFileName;
+	std::ifstream input(indexPath.c_str(), std::ios_base::in | std::ios_base::binary);
+	uint32_t header[4] = {0, 0, 0, 0};
+	uint64_t totalPoints = 0;
+	input.read(reinterpret_cast<char *>(header), sizeof(header));
+	input.read(reinterpret_cast<char *>(&totalPoints), sizeof(totalPoints));
+	if(!input.good() || header[0] != PCO_HEADER || header[1] != PCO_VERSION || header[3] == 0) {
+		WARN("PointCloudOctree: Invalid index file \"" + indexPath + "\".");
+		return nullptr;
+	}
+	std::unique_ptr<PointCloudOctree> octree(new PointCloudOctree(directory, graphicsMemoryBudget, numLoaderThreads));
+	octree->gridResolution = header[2];
+	octree->totalPoints = totalPoints;
+	octree->nodes.resize(header[3]);
+	for(uint32_t i = 0; i < header[3]; ++i) {
+		BuildNode data;
+		input.read(reinterpret_cast<char *>(data.box), sizeof(data.box));
+		input.read(reinterpret_cast<char *>(&data.numPoints), sizeof(data.numPoints));
+		input.read(reinterpret_cast<char *>(data.children), sizeof(data.children));
+		Node & node = octree->nodes[i];
+		node.box = Geometry::Box(Geometry::Vec3(data.box[0], data.box[1], data.box[2]), Geometry::Vec3(data.box[3], data.box[4], data.box[5]));
+		node.numPoints = data.numPoints;
+		for(uint_fast8_t c = 0; c < 8; ++c) {
+			// children are stored after their parents
+			if(data.children[c] != NO_CHILD && (data.children[c] <= i || data.children[c] >= header[3])) {
+				WARN("PointCloudOctree: Invalid index file \"" + indexPath + "\".");
+				return nullptr;
+			}
+			node.children[c] = data.children[c];
+		}
+	}
+	if(!input.good()) {
+		WARN("PointCloudOctree: Invalid index file \"" + indexPath + "\".");
+		return nullptr;
+	}
+	return octree.release();
+}
+
+//! (ctor)
+PointCloudOctree::PointCloudOctree(std::string _directory, size_t graphicsMemoryBudget, uint32_t numLoaderThreads) :
+		directory(std::move(_directory)), gridResolution(1), totalPoints(0),
+		strategy(graphicsMemoryBudget), loader(numLoaderThreads),
+		pointBudget(5000000), maxScreenSpaceError(2.0f), maxLoadedPoints(20000000), maxRequestsPerFrame(8),
+		uploadBudget(4 * 1024 * 1024), frameNumber(0) {
+}
+
+//! (dtor)
+PointCloudOctree::~PointCloudOctree() {
+	releaseAll();
+}
+
+std::string PointCloudOctree::getNodePath(uint32_t node) const {
+	return directory + '/' + std::to_string(node) + '.' + StreamerMMF::fileExtension;
+}
+
+//! (internal) Take the meshes of the finished requests.
+void PointCloudOctree::finishRequests() {
+	for(auto it = loadingNodes.begin(); it != loadingNodes.end();) {
+		Node & node = nodes[*it];
+		if(node.request.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			++it;
+			continue;
+		}
+		node.mesh = node.request.get();
+		node.request = Serialization::AsyncMeshLoader::future_t();
+		node.loading = false;
+		if(node.mesh.isNull()) {
+			node.failed = true;
+		} else {
+			loadedNodes.push_back(*it);
+			++statistics.loadedNodes;
+			statistics.loadedPoints += node.numPoints;
+		}
+		it = loadingNodes.erase(it);
+	}
+}
+
+//! (internal) Release the least recently displayed nodes until the loaded points fit into the limit.
+void PointCloudOctree::releaseNodes() {
+	if(statistics.loadedPoints <= maxLoadedPoints)
+		return;
+	std::sort(loadedNodes.begin(), loadedNodes.end(), [this](uint32_t a, uint32_t b) {
+		return nodes[a].lastDisplayed < nodes[b].lastDisplayed;
+	});
+	size_t numReleased = 0;
+	while(numReleased < loadedNodes.size() && statistics.loadedPoints > maxLoadedPoints) {
+		Node & node = nodes[loadedNodes[numReleased]];
+		if(node.lastDisplayed == frameNumber)
+			break;
+		node.mesh = nullptr;
+		statistics.loadedPoints -= node.numPoints;
+		--statistics.loadedNodes;
+		++statistics.releasedNodes;
+		++numReleased;
+	}
+	loadedNodes.erase(loadedNodes.begin(), loadedNodes.begin() + static_cast<std::ptrdiff_t>(numReleased));
+	// remove the buffers of the released meshes
+	strategy.releaseUnusedMeshes();
+}
+
+void PointCloudOctree::releaseAll() {
+	for(const auto index : loadedNodes)
+		nodes[index].mesh = nullptr;
+	loadedNodes.clear();
+	statistics.loadedNodes = 0;
+	statistics.loadedPoints = 0;
+	strategy.evictAll();
+}
+
+void PointCloudOctree::display(RenderingContext & context) {
+	++frameNumber;
+	statistics.displayedNodes = 0;
+	statistics.displayedPoints = 0;
+	statistics.culledNodes = 0;
+	statistics.requestedNodes = 0;
+	statistics.releasedNodes = 0;
+
+	loader.processUploads(context, uploadBudget);
+	finishRequests();
+
+	const Geometry::Matrix4x4 modelToClipping = context.getMatrix_cameraToClipping() * context.getMatrix_modelToCamera();
+	const Geometry::Rect_i & viewport = context.getViewport();
+	// projected size of a cell of the subsampling grid in pixels
+	const float gridCellToPixels = static_cast<float>(std::max(viewport.getWidth(), viewport.getHeight())) / static_cast<float>(gridResolution);
+
+	// nodes with the largest projected size first
+	typedef std::pair<float, uint32_t> entry_t;
+	std::priority_queue<entry_t> queue;
+	queue.emplace(LODMeshDataStrategy::getProjectedSize(context, nodes.front().box), 0);
+	while(!queue.empty()) {
+		const entry_t entry = queue.top();
+		queue.pop();
+		Node & node = nodes[entry.second];
+		if(isOutsideFrustum(modelToClipping, node.box)) {
+			++statistics.culledNodes;
+			continue;
+		}
+		if(statistics.displayedPoints + node.numPoints > pointBudget)
+			break;
+		if(node.mesh.isNull()) {
+			if(!node.loading && !node.failed && statistics.requestedNodes < maxRequestsPerFrame) {
+				node.request = loader.loadMesh(Util::FileName(getNodePath(entry.second)), &strategy);
+				node.loading = true;
+				loadingNodes.push_back(entry.second);
+				++statistics.requestedNodes;
+			}
+			// the children refine this node and are not displayed without it
+			continue;
+		}
+		context.displayMesh(node.mesh.get());
+		node.lastDisplayed = frameNumber;
+		++statistics.displayedNodes;
+		statistics.displayedPoints += node.numPoints;
+
+		if(entry.first * gridCellToPixels <= maxScreenSpaceError)
+			continue;
+		for(const auto child : node.children) {
+			if(child != NO_CHILD)
+				queue.emplace(LODMeshDataStrategy::getProjectedSize(context, nodes[child].box), child);
+		}
+	}
+	releaseNodes();
+}
+
+}
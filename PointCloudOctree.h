@@ -0,0 +1,175 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_POINTCLOUDOCTREE_H_
+#define RENDERING_POINTCLOUDOCTREE_H_
+
+#include "Serialization/AsyncMeshLoader.h"
+#include "Mesh/BudgetedMeshDataStrategy.h"
+#include <Geometry/Box.h>
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Util {
+class FileName;
+}
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+
+/**
+ * Out-of-core octree for point clouds that are too large to be kept in memory or to be drawn as a single mesh.
+ *
+ * build() distributes the points of a point source (e.g. StreamerXYZ::loadPointChunks()) into an octree
+ * stored in a directory: an index file (indexFileName) and one point mesh in the MMF format per node.
+ * Every node stores a spatially uniform subsample of the points in its cell (at most one point per cell of
+ * a grid with gridResolution^3 cells); the remaining points are passed to the children. A node is therefore
+ * displayed together with its ancestors (additive refinement). The points are streamed through temporary
+ * files, so only the points kept by a single node are held in memory while building.
+ *
+ * display() traverses the octree ordered by the projected size of the nodes. The nodes in the view frustum
+ * are refined while the projected point spacing is larger than the maximum screen-space error and the
+ * point budget is not exceeded. Missing nodes are requested from an AsyncMeshLoader; until they are uploaded,
+ * only their ancestors are displayed. The nodes are ordinary point meshes using a BudgetedMeshDataStrategy,
+ * which limits the graphics memory. If the number of loaded points exceeds the memory limit, the nodes that
+ * have not been displayed for the longest time are released.
+ * \code
+ * PointCloudOctree::build(Util::FileName("scan.xyz"), "scan_octree");
+ * std::unique_ptr<PointCloudOctree> octree(PointCloudOctree::load("scan_octree"));
+ * // per frame
+ * octree->display(renderingContext);
+ * \endcode
+ */
+class PointCloudOctree {
+	public:
+		struct BuildParameters {
+			uint32_t maxPointsPerNode;	//!< Nodes with more points are subdivided (default: 20000).
+			uint32_t gridResolution;	//!< Resolution of the subsampling grid of a node (default: 128).
+			uint32_t maxDepth;			//!< Nodes at this depth keep all of their points (default: 20).
+			BuildParameters() : maxPointsPerNode(20000), gridResolution(128), maxDepth(20) {}
+		};
+
+		struct Statistics {
+			uint32_t displayedNodes;
+			uint64_t displayedPoints;
+			uint32_t culledNodes;
+			uint32_t requestedNodes;	//!< Nodes requested from the loader during the last frame.
+			uint32_t loadedNodes;
+			uint64_t loadedPoints;
+			uint32_t releasedNodes;		//!< Nodes released during the last frame to meet the memory limit.
+			Statistics() : displayedNodes(0), displayedPoints(0), culledNodes(0), requestedNodes(0),
+				loadedNodes(0), loadedPoints(0), releasedNodes(0) {}
+		};
+
+		//! Called for every chunk of points; return false to stop reading.
+		typedef std::function<bool (Mesh * chunk)> ChunkCallback_t;
+		//! A point source passes all of its points as point meshes in one or several chunks to the callback.
+		typedef std::function<void (const ChunkCallback_t &)> PointSource_t;
+
+		static const char * const indexFileName;
+
+		/*! (static) Build an octree from the points of @p source in the existing directory @p directory.
+			The chunks have to contain positions; colors are used if present.
+			@return false if there were no points or the files could not be written.	*/
+		static bool build(const PointSource_t & source, const std::string & directory, const BuildParameters & parameters = BuildParameters());
+		/*! (static) Build an octree from the given point file. .xyz files are read in chunks; other files are loaded
+			with Serialization::loadMesh().	*/
+		static bool build(const Util::FileName & input, const std::string & directory, const BuildParameters & parameters = BuildParameters());
+
+		/*! (static) Open an octree created by build().
+			@param graphicsMemoryBudget Budget of the data strategy of the nodes (see BudgetedMeshDataStrategy).
+			@return The octree or @c nullptr if the index file could not be read.	*/
+		static PointCloudOctree * load(const std::string & directory, size_t graphicsMemoryBudget = 512 * 1024 * 1024, uint32_t numLoaderThreads = 2);
+
+		~PointCloudOctree();
+
+		PointCloudOctree(const PointCloudOctree &) = delete;
+		PointCloudOctree & operator=(const PointCloudOctree &) = delete;
+
+		//! Maximum number of points displayed per frame (default: 5000000).
+		void setPointBudget(uint64_t points)				{	pointBudget = points;	}
+		uint64_t getPointBudget() const						{	return pointBudget;	}
+
+		//! Nodes are refined while their projected point spacing is larger than this value in pixels (default: 2).
+		void setMaxScreenSpaceError(float pixels)			{	maxScreenSpaceError = pixels;	}
+		float getMaxScreenSpaceError() const				{	return maxScreenSpaceError;	}
+
+		//! Maximum number of points of the loaded nodes kept in main memory (default: 20000000).
+		void setMaxLoadedPoints(uint64_t points)			{	maxLoadedPoints = points;	}
+		uint64_t getMaxLoadedPoints() const					{	return maxLoadedPoints;	}
+
+		//! Maximum number of nodes requested from the loader per frame (default: 8).
+		void setMaxRequestsPerFrame(uint32_t requests)		{	maxRequestsPerFrame = requests;	}
+		uint32_t getMaxRequestsPerFrame() const				{	return maxRequestsPerFrame;	}
+
+		//! Bytes uploaded per frame (see AsyncMeshLoader::processUploads(); default: 4 MiB).
+		void setUploadBudget(size_t bytes)					{	uploadBudget = bytes;	}
+		size_t getUploadBudget() const						{	return uploadBudget;	}
+
+		/*! Upload finished nodes, display the octree with the current modelview and projection matrices and
+			request the missing nodes. Call once per frame on the GL thread.	*/
+		void display(RenderingContext & context);
+
+		//! Release all loaded nodes.
+		void releaseAll();
+
+		const Geometry::Box & getBoundingBox() const		{	return nodes.front().box;	}
+		uint32_t getNodeCount() const						{	return static_cast<uint32_t>(nodes.size());	}
+		uint64_t getPointCount() const						{	return totalPoints;	}
+		BudgetedMeshDataStrategy & getDataStrategy()		{	return strategy;	}
+		const Statistics & getStatistics() const			{	return statistics;	}
+
+	private:
+		static const uint32_t NO_CHILD = 0;
+		struct Node {
+			Geometry::Box box; //!< Bounding box of the points of the node and its descendants
+			uint32_t numPoints;
+			uint32_t children[8];
+			Util::Reference<Mesh> mesh;
+			Serialization::AsyncMeshLoader::future_t request;
+			bool loading;
+			bool failed;
+			uint32_t lastDisplayed;
+			Node() : numPoints(0), children(), loading(false), failed(false), lastDisplayed(0) {}
+		};
+
+		const std::string directory;
+		std::vector<Node> nodes;
+		uint32_t gridResolution;
+		uint64_t totalPoints;
+
+		BudgetedMeshDataStrategy strategy;
+		Serialization::AsyncMeshLoader loader;
+		std::vector<uint32_t> loadingNodes;
+		std::vector<uint32_t> loadedNodes;
+
+		uint64_t pointBudget;
+		float maxScreenSpaceError;
+		uint64_t maxLoadedPoints;
+		uint32_t maxRequestsPerFrame;
+		size_t uploadBudget;
+		uint32_t frameNumber;
+		Statistics statistics;
+
+		PointCloudOctree(std::string directory, size_t graphicsMemoryBudget, uint32_t numLoaderThreads);
+
+		std::string getNodePath(uint32_t node) const;
+		void finishRequests();
+		void releaseNodes();
+};
+
+}
+
+#endif /* RENDERING_POINTCLOUDOCTREE_H_ */
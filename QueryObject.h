@@ -58,6 +58,9 @@ class QueryObject {
 		void end() const;
 
 		bool isValid()const	{	return id!=0;	}
+
+		//! Returns the OpenGL query object identifier; e.g. for RenderingContext::beginConditionalRender().
+		uint32_t getGLId()const	{	return id;	}
 		
 		//! Returns the GL constant of the query's type. \note Don't rely on GL constants from outside of Rendering.
 		uint32_t _getQueryType()const	{	return queryType;	}
@@ -0,0 +1,230 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "QueryPool.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Util/Macros.h>
+#include <cstring>
+#include <stdexcept>
+
+namespace Rendering {
+
+#if defined(LIB_GL) && defined(GL_ARB_query_buffer_object) && defined(GL_ARB_sync)
+#define QUERY_BUFFER_AVAILABLE
+#endif
+
+//! (static)
+bool QueryPool::isQueryBufferSupported() {
+#ifdef QUERY_BUFFER_AVAILABLE
+	static const bool support = isExtensionSupported("GL_ARB_query_buffer_object");
+	return support;
+#else
+	return false;
+#endif
+}
+
+#if defined(LIB_GL)
+//! (static)
+QueryPool * QueryPool::createOcclusionPool(uint32_t capacity, uint32_t numFrames) {
+	return new QueryPool(GL_SAMPLES_PASSED, capacity, numFrames);
+}
+//! (static)
+QueryPool * QueryPool::createAnySamplesPassedPool(uint32_t capacity, uint32_t numFrames) {
+	return new QueryPool(GL_ANY_SAMPLES_PASSED, capacity, numFrames);
+}
+//! (static)
+QueryPool * QueryPool::createTimeElapsedPool(uint32_t capacity, uint32_t numFrames) {
+	return new QueryPool(GL_TIME_ELAPSED, capacity, numFrames);
+}
+//! (static)
+QueryPool * QueryPool::createTimestampPool(uint32_t capacity, uint32_t numFrames) {
+	return new QueryPool(GL_TIMESTAMP, capacity, numFrames);
+}
+#else
+QueryPool * QueryPool::createOcclusionPool(uint32_t, uint32_t)			{	return nullptr;	}
+QueryPool * QueryPool::createAnySamplesPassedPool(uint32_t, uint32_t)	{	return nullptr;	}
+QueryPool * QueryPool::createTimeElapsedPool(uint32_t, uint32_t)		{	return nullptr;	}
+QueryPool * QueryPool::createTimestampPool(uint32_t, uint32_t)			{	return nullptr;	}
+#endif
+
+QueryPool::QueryPool(uint32_t _queryType, uint32_t _capacity, uint32_t numFrames) :
+		ReferenceCounter_t(), queryType(_queryType), capacity(_capacity), frames(numFrames),
+		currentFrame(0), frameNumber(0), overflowCount(0), queryBuffer() {
+	if(capacity == 0 || numFrames == 0)
+		throw std::invalid_argument("QueryPool: Invalid size.");
+#if defined(LIB_GL)
+	// allocate all identifiers in one call
+	std::vector<uint32_t> ids(capacity * numFrames);
+	glGenQueries(static_cast<GLsizei>(ids.size()), ids.data());
+	for(uint32_t f = 0; f < numFrames; ++f)
+		frames[f].ids.assign(ids.begin() + f * capacity, ids.begin() + (f + 1) * capacity);
+	GET_GL_ERROR();
+#endif
+#ifdef QUERY_BUFFER_AVAILABLE
+	if(isQueryBufferSupported())
+		queryBuffer.allocateData<uint64_t>(GL_QUERY_BUFFER, capacity * numFrames, GL_DYNAMIC_READ);
+#endif
+}
+
+QueryPool::~QueryPool() {
+#if defined(LIB_GL)
+	for(auto & frame : frames) {
+		resetFrame(frame);
+		glDeleteQueries(static_cast<GLsizei>(frame.ids.size()), frame.ids.data());
+	}
+#endif
+}
+
+//! (internal)
+void QueryPool::resetFrame(Frame & frame) {
+#ifdef QUERY_BUFFER_AVAILABLE
+	if(frame.fence != nullptr)
+		glDeleteSync(reinterpret_cast<GLsync>(frame.fence));
+#endif
+	frame.fence = nullptr;
+	frame.numIssued = 0;
+	frame.finished = false;
+}
+
+uint32_t QueryPool::begin() {
+	Frame & frame = frames[currentFrame];
+	if(frame.numIssued >= capacity) {
+		++overflowCount;
+		return INVALID_INDEX;
+	}
+#if defined(LIB_GL)
+	glBeginQuery(static_cast<GLenum>(queryType), frame.ids[frame.numIssued]);
+#endif
+	return frame.numIssued++;
+}
+
+void QueryPool::end() {
+#if defined(LIB_GL)
+	glEndQuery(static_cast<GLenum>(queryType));
+#endif
+}
+
+uint32_t QueryPool::counter() {
+	Frame & frame = frames[currentFrame];
+	if(frame.numIssued >= capacity) {
+		++overflowCount;
+		return INVALID_INDEX;
+	}
+#if defined(LIB_GL)
+	glQueryCounter(frame.ids[frame.numIssued], GL_TIMESTAMP);
+#endif
+	return frame.numIssued++;
+}
+
+void QueryPool::nextFrame() {
+	Frame & frame = frames[currentFrame];
+	frame.frameNumber = frameNumber;
+	frame.finished = true;
+#ifdef QUERY_BUFFER_AVAILABLE
+	if(isQueryBufferSupported() && frame.numIssued > 0) {
+		// the GPU writes the results when they are available; the CPU does not wait
+		queryBuffer.bind(GL_QUERY_BUFFER);
+		const size_t frameOffset = currentFrame * capacity * sizeof(uint64_t);
+		for(uint32_t i = 0; i < frame.numIssued; ++i) {
+			glGetQueryObjectui64v(frame.ids[i], GL_QUERY_RESULT,
+								reinterpret_cast<GLuint64 *>(frameOffset + i * sizeof(uint64_t)));
+		}
+		queryBuffer.unbind(GL_QUERY_BUFFER);
+		frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		GET_GL_ERROR();
+	}
+#endif
+	++frameNumber;
+	currentFrame = (currentFrame + 1) % frames.size();
+	resetFrame(frames[currentFrame]);
+}
+
+//! (internal)
+QueryPool::Frame * QueryPool::findFrame(uint32_t number) {
+	for(auto & frame : frames) {
+		if(frame.finished && frame.frameNumber == number)
+			return &frame;
+	}
+	return nullptr;
+}
+
+bool QueryPool::getResults(uint32_t number, std::vector<uint64_t> & results) {
+	Frame * frame = findFrame(number);
+	if(frame == nullptr)
+		return false;
+	results.resize(frame->numIssued);
+	if(frame->numIssued == 0)
+		return true;
+#ifdef QUERY_BUFFER_AVAILABLE
+	if(frame->fence != nullptr) {
+		const GLenum result = glClientWaitSync(reinterpret_cast<GLsync>(frame->fence), 0, 0);
+		if(result == GL_TIMEOUT_EXPIRED)
+			return false;
+		const size_t frameIndex = static_cast<size_t>(frame - frames.data());
+		queryBuffer.bind(GL_QUERY_BUFFER);
+		const void * data = glMapBufferRange(GL_QUERY_BUFFER, static_cast<GLintptr>(frameIndex * capacity * sizeof(uint64_t)),
+											static_cast<GLsizeiptr>(frame->numIssued * sizeof(uint64_t)), GL_MAP_READ_BIT);
+		if(data != nullptr) {
+			std::memcpy(results.data(), data, frame->numIssued * sizeof(uint64_t));
+			glUnmapBuffer(GL_QUERY_BUFFER);
+		}
+		queryBuffer.unbind(GL_QUERY_BUFFER);
+		GET_GL_ERROR();
+		return data != nullptr;
+	}
+#endif
+#if defined(LIB_GL)
+	// without query buffer: check each query; the last one is usually finished last
+	for(uint32_t i = frame->numIssued; i > 0; --i) {
+		GLint available = 0;
+		glGetQueryObjectiv(frame->ids[i - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if(available != GL_TRUE)
+			return false;
+	}
+	for(uint32_t i = 0; i < frame->numIssued; ++i) {
+	#if defined(GL_ARB_timer_query)
+		GLuint64 value = 0;
+		glGetQueryObjectui64v(frame->ids[i], GL_QUERY_RESULT, &value);
+	#else
+		GLuint value = 0;
+		glGetQueryObjectuiv(frame->ids[i], GL_QUERY_RESULT, &value);
+	#endif
+		results[i] = value;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool QueryPool::beginConditionalRender(uint32_t index, uint32_t framesAgo, bool wait) const {
+#if defined(LIB_GL)
+	if(index == INVALID_INDEX || framesAgo >= frames.size())
+		return false;
+	const uint32_t frameIndex = static_cast<uint32_t>((currentFrame + frames.size() - framesAgo) % frames.size());
+	const Frame & frame = frames[frameIndex];
+	if(index >= frame.numIssued)
+		return false;
+	glBeginConditionalRender(frame.ids[index], wait ? GL_QUERY_WAIT : GL_QUERY_NO_WAIT);
+	return true;
+#else
+	return false;
+#endif
+}
+
+//! (static)
+void QueryPool::endConditionalRender() {
+#if defined(LIB_GL)
+	glEndConditionalRender();
+#endif
+}
+
+}
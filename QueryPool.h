@@ -0,0 +1,114 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_QUERYPOOL_H_
+#define RENDERING_QUERYPOOL_H_
+
+#include "BufferObject.h"
+#include <Util/ReferenceCounter.h>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+
+/**
+ * Pool of queries of one type that are reused frame by frame without waiting for their results.
+ *
+ * The query identifiers of @a numFrames frames are allocated once. In each frame, up to @a capacity queries are
+ * issued with begin()/end() (or counter() for timestamps); nextFrame() finishes the frame. The results of a frame
+ * can be fetched with getResults() as soon as the GPU has finished them; usually after one or two frames.
+ * If GL_ARB_query_buffer_object is supported, the GPU writes all results of a frame into a query buffer, which is
+ * read with a single map; otherwise the availability of each query is checked.
+ * Occlusion results can also be used directly by the GPU with beginConditionalRender().
+ * \code
+ *	Util::Reference<QueryPool> pool = QueryPool::createOcclusionPool(1024);
+ *	// each frame:
+ *	const uint32_t frame = pool->getFrameNumber();
+ *	for(...) {	const uint32_t index = pool->begin(); drawBoundingBox(...); pool->end(); }
+ *	pool->nextFrame();
+ *	std::vector<uint64_t> results;
+ *	if(pool->getResults(lastFetchedFrame + 1, results)) ...
+ * \endcode
+ */
+class QueryPool : public Util::ReferenceCounter<QueryPool> {
+	public:
+		static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+		static bool isQueryBufferSupported();
+
+		//! @see GL_SAMPLES_PASSED
+		static QueryPool * createOcclusionPool(uint32_t capacity, uint32_t numFrames = 3);
+		//! @see GL_ANY_SAMPLES_PASSED
+		static QueryPool * createAnySamplesPassedPool(uint32_t capacity, uint32_t numFrames = 3);
+		//! Results are in nanoseconds. @see GL_TIME_ELAPSED
+		static QueryPool * createTimeElapsedPool(uint32_t capacity, uint32_t numFrames = 3);
+		//! Use counter() instead of begin()/end(); results are in nanoseconds. @see GL_TIMESTAMP
+		static QueryPool * createTimestampPool(uint32_t capacity, uint32_t numFrames = 3);
+
+		/*! @param queryType GL constant of the query type (e.g. GL_SAMPLES_PASSED). \note Don't rely on GL constants from outside of Rendering.
+			@throw std::invalid_argument if @p capacity or @p numFrames is zero.	*/
+		QueryPool(uint32_t queryType, uint32_t capacity, uint32_t numFrames);
+		~QueryPool();
+
+		/*!	Start the next query of the current frame.
+			@return the query's index inside the frame or INVALID_INDEX if the capacity is exhausted (nothing is started). */
+		uint32_t begin();
+		//!	Stop the query started by the last successful call to begin().
+		void end();
+		//!	Record the GPU time into the next query of the current frame (timestamp pools). @return index or INVALID_INDEX
+		uint32_t counter();
+
+		/*! Finish the current frame: request the results (into the query buffer) and continue with the next frame.
+			The results of the frame numFrames ago are dropped if they have not been fetched. */
+		void nextFrame();
+
+		/*! Non-blocking: copy the results of the given (finished) frame into @p results (one value per issued query).
+			@return false if the results are not available yet or the frame is no longer (or not yet) stored. */
+		bool getResults(uint32_t frameNumber, std::vector<uint64_t> & results);
+
+		/*! Render the following commands only if the query @p index of the current frame (or @p framesAgo frames ago)
+			passed any samples. The GPU evaluates the result; with @p wait == false the rendering is done if the
+			result is not yet available.
+			@return false if there is no such query; endConditionalRender() must then not be called. */
+		bool beginConditionalRender(uint32_t index, uint32_t framesAgo = 0, bool wait = false) const;
+		static void endConditionalRender();
+
+		uint32_t getFrameNumber() const					{	return frameNumber;	}
+		uint32_t getCapacity() const					{	return capacity;	}
+		uint32_t getNumFrames() const					{	return static_cast<uint32_t>(frames.size());	}
+		//! Number of queries issued in the current frame.
+		uint32_t getNumIssued() const					{	return frames[currentFrame].numIssued;	}
+		//! Number of begin()/counter() calls that failed because the capacity was exhausted.
+		uint32_t getOverflowCount() const				{	return overflowCount;	}
+
+	private:
+		struct Frame {
+			std::vector<uint32_t> ids;
+			uint32_t numIssued;
+			uint32_t frameNumber;
+			void * fence; //!< GLsync; set when the results have been requested into the query buffer
+			bool finished; //!< nextFrame() has been called for this frame
+			Frame() : numIssued(0), frameNumber(0), fence(nullptr), finished(false) {}
+		};
+		const uint32_t queryType;
+		const uint32_t capacity;
+		std::vector<Frame> frames;
+		uint32_t currentFrame;
+		uint32_t frameNumber;
+		uint32_t overflowCount;
+		BufferObject queryBuffer; //!< 64 bit results; capacity values per frame
+
+		Frame * findFrame(uint32_t frameNumber);
+		void resetFrame(Frame & frame);
+};
+
+}
+
+#endif /* RENDERING_QUERYPOOL_H_ */
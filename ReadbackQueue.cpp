@@ -0,0 +1,234 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ReadbackQueue.h"
+#include "FBO.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Texture/Texture.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Util/Macros.h>
+#include <stdexcept>
+
+namespace Rendering {
+
+#if defined(LIB_GL) && defined(GL_ARB_pixel_buffer_object) && defined(GL_ARB_sync)
+#define READBACK_QUEUE_AVAILABLE
+#endif
+
+//! Maximum number of unused pack buffers that are kept for later requests.
+static const size_t MAX_FREE_BUFFERS = 8;
+
+//! (static)
+bool ReadbackQueue::isSupported() {
+#ifdef READBACK_QUEUE_AVAILABLE
+	static const bool support = isExtensionSupported("GL_ARB_pixel_buffer_object") && isExtensionSupported("GL_ARB_sync");
+	return support;
+#else
+	return false;
+#endif
+}
+
+ReadbackQueue::ReadbackQueue() : ReferenceCounter_t(), bufferMemory(0) {
+}
+
+ReadbackQueue::~ReadbackQueue() {
+#ifdef READBACK_QUEUE_AVAILABLE
+	for(auto & request : requests) {
+		if(request.fence != nullptr)
+			glDeleteSync(reinterpret_cast<GLsync>(request.fence));
+	}
+#endif
+}
+
+//! (internal)
+ReadbackQueue::PackBuffer ReadbackQueue::acquirePackBuffer(size_t numBytes) {
+	PackBuffer packBuffer;
+#ifdef READBACK_QUEUE_AVAILABLE
+	for(auto it = freeBuffers.begin(); it != freeBuffers.end(); ++it) {
+		if(it->capacity >= numBytes) {
+			packBuffer = std::move(*it);
+			freeBuffers.erase(it);
+			break;
+		}
+	}
+	if(packBuffer.capacity == 0) {
+		packBuffer.buffer.allocateData<uint8_t>(GL_PIXEL_PACK_BUFFER, numBytes, GL_STREAM_READ);
+		packBuffer.capacity = numBytes;
+		bufferMemory += numBytes;
+	}
+	packBuffer.buffer.bind(GL_PIXEL_PACK_BUFFER);
+#endif
+	return packBuffer;
+}
+
+//! (internal)
+void ReadbackQueue::submit(PackBuffer && packBuffer, size_t numBytes, callback_t && callback) {
+	Request request;
+	request.packBuffer = std::move(packBuffer);
+	request.numBytes = numBytes;
+	request.fence = nullptr;
+	request.callback = std::move(callback);
+#ifdef READBACK_QUEUE_AVAILABLE
+	request.packBuffer.buffer.unbind(GL_PIXEL_PACK_BUFFER);
+	if(isSupported())
+		request.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	GET_GL_ERROR();
+#endif
+	requests.emplace_back(std::move(request));
+	if(!isSupported()) // synchronous fallback
+		finish();
+}
+
+//! (internal)
+void ReadbackQueue::deliver(Request & request) {
+#ifdef READBACK_QUEUE_AVAILABLE
+	if(request.fence != nullptr) {
+		glDeleteSync(reinterpret_cast<GLsync>(request.fence));
+		request.fence = nullptr;
+	}
+	request.packBuffer.buffer.bind(GL_PIXEL_PACK_BUFFER);
+	const uint8_t * data = reinterpret_cast<const uint8_t *>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+																				static_cast<GLsizeiptr>(request.numBytes), GL_MAP_READ_BIT));
+	if(data != nullptr) {
+		if(request.callback)
+			request.callback(data, request.numBytes);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	} else {
+		WARN("ReadbackQueue: Mapping the pack buffer failed.");
+	}
+	request.packBuffer.buffer.unbind(GL_PIXEL_PACK_BUFFER);
+	GET_GL_ERROR();
+
+	if(freeBuffers.size() < MAX_FREE_BUFFERS) {
+		freeBuffers.emplace_back(std::move(request.packBuffer));
+	} else {
+		bufferMemory -= request.packBuffer.capacity;
+		request.packBuffer.buffer.destroy();
+	}
+#endif
+}
+
+void ReadbackQueue::readPixels(RenderingContext & context, const Geometry::Rect_i & rect, const PixelFormatGL & pixelFormat, callback_t callback) {
+#ifdef READBACK_QUEUE_AVAILABLE
+	Texture::Format format;
+	format.pixelFormat = pixelFormat;
+	const size_t numBytes = static_cast<size_t>(format.getPixelSize()) * rect.getWidth() * rect.getHeight();
+	if(numBytes == 0)
+		return;
+	context.applyChanges();
+	PackBuffer packBuffer = acquirePackBuffer(numBytes);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(rect.getX(), rect.getY(), rect.getWidth(), rect.getHeight(),
+				static_cast<GLenum>(pixelFormat.glLocalDataFormat), static_cast<GLenum>(pixelFormat.glLocalDataType), nullptr);
+	submit(std::move(packBuffer), numBytes, std::move(callback));
+#else
+	WARN("ReadbackQueue::readPixels: Not supported.");
+#endif
+}
+
+void ReadbackQueue::readFramebuffer(RenderingContext & context, FBO * fbo, uint32_t colorBufferId, const Geometry::Rect_i & rect,
+									const PixelFormatGL & pixelFormat, callback_t callback) {
+#ifdef READBACK_QUEUE_AVAILABLE
+	context.pushAndSetFBO(fbo);
+	context.applyChanges();
+	if(fbo != nullptr)
+		glReadBuffer(GL_COLOR_ATTACHMENT0 + colorBufferId);
+	readPixels(context, rect, pixelFormat, std::move(callback));
+	context.popFBO();
+#else
+	WARN("ReadbackQueue::readFramebuffer: Not supported.");
+#endif
+}
+
+void ReadbackQueue::readTexture(RenderingContext & context, Texture * texture, callback_t callback) {
+#ifdef READBACK_QUEUE_AVAILABLE
+	const TextureType type = texture->getTextureType();
+	if(type == TextureType::TEXTURE_BUFFER || type == TextureType::TEXTURE_2D_MULTISAMPLE)
+		throw std::invalid_argument("ReadbackQueue::readTexture: Unsupported texture type.");
+	const Texture::Format & format = texture->getFormat();
+	const size_t numBytes = format.getLevelDataSize(0);
+
+	context.pushAndSetTexture(0, texture); // uploads the texture if necessary
+
+	PackBuffer packBuffer = acquirePackBuffer(numBytes);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	const uint32_t numTargets = type == TextureType::TEXTURE_CUBE_MAP ? 6 : 1;
+	for(uint32_t face = 0; face < numTargets; ++face) {
+		const GLenum target = type == TextureType::TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : static_cast<GLenum>(format.glTextureType);
+		uint8_t * offset = reinterpret_cast<uint8_t *>(face * (numBytes / numTargets));
+		if(format.pixelFormat.compressed) {
+			glGetCompressedTexImage(target, 0, offset);
+		} else {
+			glGetTexImage(target, 0, static_cast<GLenum>(format.pixelFormat.glLocalDataFormat),
+						static_cast<GLenum>(format.pixelFormat.glLocalDataType), offset);
+		}
+	}
+	submit(std::move(packBuffer), numBytes, std::move(callback));
+
+	context.popTexture(0);
+#else
+	WARN("ReadbackQueue::readTexture: Not supported.");
+#endif
+}
+
+void ReadbackQueue::readBuffer(const BufferObject & buffer, size_t offset, size_t numBytes, callback_t callback) {
+#ifdef READBACK_QUEUE_AVAILABLE
+	if(numBytes == 0)
+		return;
+	PackBuffer packBuffer = acquirePackBuffer(numBytes);
+	buffer.bind(GL_COPY_READ_BUFFER);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_PIXEL_PACK_BUFFER, static_cast<GLintptr>(offset), 0, static_cast<GLsizeiptr>(numBytes));
+	buffer.unbind(GL_COPY_READ_BUFFER);
+	submit(std::move(packBuffer), numBytes, std::move(callback));
+#else
+	WARN("ReadbackQueue::readBuffer: Not supported.");
+#endif
+}
+
+uint32_t ReadbackQueue::process() {
+	uint32_t numFinished = 0;
+#ifdef READBACK_QUEUE_AVAILABLE
+	// requests finish in submission order
+	while(!requests.empty()) {
+		Request & request = requests.front();
+		if(request.fence != nullptr) {
+			const GLenum result = glClientWaitSync(reinterpret_cast<GLsync>(request.fence), 0, 0);
+			if(result == GL_TIMEOUT_EXPIRED)
+				break;
+			if(result == GL_WAIT_FAILED)
+				WARN("ReadbackQueue: Waiting for fence failed.");
+		}
+		Request finished(std::move(request));
+		requests.pop_front();
+		deliver(finished);
+		++numFinished;
+	}
+#endif
+	return numFinished;
+}
+
+void ReadbackQueue::finish() {
+#ifdef READBACK_QUEUE_AVAILABLE
+	while(!requests.empty()) {
+		Request finished(std::move(requests.front()));
+		requests.pop_front();
+		if(finished.fence != nullptr) {
+			GLenum result;
+			do {
+				result = glClientWaitSync(reinterpret_cast<GLsync>(finished.fence), GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+			} while(result == GL_TIMEOUT_EXPIRED);
+		}
+		deliver(finished);
+	}
+#endif
+}
+
+}
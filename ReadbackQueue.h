@@ -0,0 +1,102 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_READBACKQUEUE_H_
+#define RENDERING_READBACKQUEUE_H_
+
+#include "BufferObject.h"
+#include "Texture/PixelFormatGL.h"
+#include <Geometry/Rect.h>
+#include <Util/ReferenceCounter.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace Rendering {
+class FBO;
+class RenderingContext;
+class Texture;
+
+/**
+ * Queue for reading data back from the GPU without stalling the pipeline.
+ *
+ * Each request copies pixels of the current read framebuffer, an FBO attachment, a texture or a range of a buffer
+ * object into a pack buffer and inserts a fence. process() (called once per frame) checks the fences without waiting
+ * and passes the data of the finished requests to their callbacks, usually one or two frames later. The pack buffers
+ * are reused by later requests. If the results are needed immediately, finish() waits for all requests.
+ *
+ * @note The data pointer passed to a callback is only valid during the call.
+ * @note Requires GL_ARB_pixel_buffer_object and GL_ARB_sync. If they are not supported, the requests are
+ *	executed synchronously.
+ * @see PBO for the previous, format specific implementation.
+ */
+class ReadbackQueue : public Util::ReferenceCounter<ReadbackQueue> {
+	public:
+		typedef std::function<void (const uint8_t * data, size_t numBytes)> callback_t;
+
+		static bool isSupported();
+
+		ReadbackQueue();
+		~ReadbackQueue();
+
+		/*! Read a rectangle of the currently bound read framebuffer (the screen or the active FBO).
+			The rows are tightly packed (GL_PACK_ALIGNMENT 1). */
+		void readPixels(RenderingContext & context, const Geometry::Rect_i & rect, const PixelFormatGL & pixelFormat, callback_t callback);
+
+		//! Read a rectangle of the color attachment @p colorBufferId of the given @p fbo (nullptr: the screen).
+		void readFramebuffer(RenderingContext & context, FBO * fbo, uint32_t colorBufferId, const Geometry::Rect_i & rect,
+							const PixelFormatGL & pixelFormat, callback_t callback);
+
+		/*! Read level 0 of the given texture in the texture's local data format (layout as in Texture::getLocalData()).
+			@throw std::invalid_argument if the texture type is not supported (buffer and multisample textures). */
+		void readTexture(RenderingContext & context, Texture * texture, callback_t callback);
+
+		//! Read @p numBytes of the given buffer object starting at @p offset.
+		void readBuffer(const BufferObject & buffer, size_t offset, size_t numBytes, callback_t callback);
+
+		//! Pass the data of all finished requests to their callbacks; does not block. Returns the number of finished requests.
+		uint32_t process();
+
+		//! Wait for all pending requests and pass their data to the callbacks.
+		void finish();
+
+		uint32_t getPendingCount() const					{	return static_cast<uint32_t>(requests.size());	}
+		//! Number of bytes allocated for pack buffers (pending and unused).
+		size_t getBufferMemory() const						{	return bufferMemory;	}
+
+	private:
+		struct PackBuffer {
+			BufferObject buffer;
+			size_t capacity;
+			PackBuffer() : buffer(), capacity(0) {}
+		};
+		struct Request {
+			PackBuffer packBuffer;
+			size_t numBytes;
+			void * fence; //!< GLsync
+			callback_t callback;
+		};
+		std::deque<Request> requests;
+		std::vector<PackBuffer> freeBuffers;
+		size_t bufferMemory;
+
+		//! (internal) Take a pack buffer with at least @p numBytes capacity from the free list (or create one) and bind it to GL_PIXEL_PACK_BUFFER.
+		PackBuffer acquirePackBuffer(size_t numBytes);
+		//! (internal) Insert the fence for a request whose copy commands have been issued.
+		void submit(PackBuffer && packBuffer, size_t numBytes, callback_t && callback);
+		//! (internal) Map the data, call the callback and recycle the pack buffer.
+		void deliver(Request & request);
+};
+
+}
+
+#endif /* RENDERING_READBACKQUEUE_H_ */
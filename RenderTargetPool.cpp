@@ -0,0 +1,175 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "RenderTargetPool.h"
+#include "FBO.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Texture/TextureUtils.h"
+#include "GLHeader.h"
+#include <Util/Macros.h>
+
+namespace Rendering {
+
+RenderTargetPool::RenderTargetPool(uint32_t _maxIdleFrames) :
+	ReferenceCounter_t(), maxIdleFrames(_maxIdleFrames), frameNumber(0), transientDepth(true) {
+}
+
+RenderTargetPool::~RenderTargetPool() = default;
+
+Util::Reference<Texture> RenderTargetPool::acquireTexture(const Texture::Format & format) {
+	for(auto & entry : textures) {
+		if(entry.texture->getFormat() == format && !isInUse(entry)) {
+			entry.lastUsedFrame = frameNumber;
+			++statistics.textureHits;
+			return entry.texture;
+		}
+	}
+	TextureEntry entry;
+	entry.texture = new Texture(format);
+	entry.lastUsedFrame = frameNumber;
+	entry.numFramebuffers = 0;
+	textures.push_back(entry);
+	++statistics.textureMisses;
+	return entry.texture;
+}
+
+Util::Reference<Texture> RenderTargetPool::acquireColorTexture(uint32_t width, uint32_t height, bool alpha) {
+	return acquireTexture(TextureUtils::createStdTexture(width, height, alpha)->getFormat());
+}
+
+Util::Reference<Texture> RenderTargetPool::acquireDepthTexture(uint32_t width, uint32_t height) {
+	return acquireTexture(TextureUtils::createDepthTexture(width, height)->getFormat());
+}
+
+//! (internal)
+RenderTargetPool::TextureEntry * RenderTargetPool::findEntry(Texture * texture) {
+	for(auto & entry : textures) {
+		if(entry.texture.get() == texture)
+			return &entry;
+	}
+	return nullptr;
+}
+
+FBO * RenderTargetPool::getFramebuffer(RenderingContext & context, const std::vector<Texture *> & colorTextures, Texture * depthTexture) {
+	std::vector<Texture *> key(colorTextures);
+	key.push_back(depthTexture);
+
+	const auto it = framebuffers.find(key);
+	if(it != framebuffers.end()) {
+		it->second.lastUsedFrame = frameNumber;
+		for(const auto & texture : it->second.attachments) {
+			TextureEntry * textureEntry = findEntry(texture.get());
+			if(textureEntry)
+				textureEntry->lastUsedFrame = frameNumber;
+		}
+		++statistics.framebufferHits;
+		applyStoreHints(*it->second.fbo.get(), depthTexture);
+		return it->second.fbo.get();
+	}
+	++statistics.framebufferMisses;
+
+	Util::Reference<FBO> fbo = new FBO;
+	for(size_t i = 0; i < colorTextures.size(); ++i)
+		fbo->attachColorTexture(context, colorTextures[i], static_cast<uint32_t>(i));
+	if(depthTexture) {
+#if defined(LIB_GL)
+		if(depthTexture->getFormat().pixelFormat.glLocalDataFormat == GL_DEPTH_STENCIL_EXT)
+			fbo->attachDepthStencilTexture(context, depthTexture);
+		else
+#endif
+			fbo->attachDepthTexture(context, depthTexture);
+	}
+	if(colorTextures.size() > 1)
+		fbo->setDrawBuffers(context, static_cast<uint32_t>(colorTextures.size()));
+	if(!fbo->isComplete(context)) {
+		WARN(std::string("RenderTargetPool: ") + fbo->getStatusMessage(context));
+		return nullptr;
+	}
+
+	applyStoreHints(*fbo.get(), depthTexture);
+
+	FramebufferEntry & entry = framebuffers[key];
+	entry.fbo = fbo;
+	entry.lastUsedFrame = frameNumber;
+	for(const auto & texture : key) {
+		if(!texture)
+			continue;
+		entry.attachments.emplace_back(texture);
+		TextureEntry * textureEntry = findEntry(texture);
+		if(textureEntry)
+			++textureEntry->numFramebuffers;
+	}
+	return fbo.get();
+}
+
+//! (internal)
+void RenderTargetPool::applyStoreHints(FBO & fbo, Texture * depthTexture) const {
+	if(depthTexture) {
+		fbo.setStoreContents(GL_DEPTH_ATTACHMENT, !transientDepth);
+		fbo.setStoreContents(GL_STENCIL_ATTACHMENT, !transientDepth);
+	}
+}
+
+//! (internal)
+void RenderTargetPool::removeFramebuffer(framebufferMap_t::iterator it) {
+	for(const auto & texture : it->second.attachments) {
+		TextureEntry * textureEntry = findEntry(texture.get());
+		if(textureEntry)
+			--textureEntry->numFramebuffers;
+	}
+	framebuffers.erase(it);
+}
+
+void RenderTargetPool::endFrame() {
+	for(auto & entry : textures) { // textures still referenced from outside stay alive
+		if(isInUse(entry))
+			entry.lastUsedFrame = frameNumber;
+	}
+	++frameNumber;
+
+	for(auto it = framebuffers.begin(); it != framebuffers.end();) {
+		bool idle = frameNumber - it->second.lastUsedFrame > maxIdleFrames;
+		for(const auto & texture : it->second.attachments) {
+			const TextureEntry * textureEntry = findEntry(texture.get());
+			if(textureEntry && frameNumber - textureEntry->lastUsedFrame > maxIdleFrames)
+				idle = true;
+		}
+		if(idle)
+			removeFramebuffer(it++);
+		else
+			++it;
+	}
+	for(auto it = textures.begin(); it != textures.end();) {
+		if(!isInUse(*it) && frameNumber - it->lastUsedFrame > maxIdleFrames)
+			it = textures.erase(it);
+		else
+			++it;
+	}
+}
+
+void RenderTargetPool::clear() {
+	framebuffers.clear();
+	for(auto it = textures.begin(); it != textures.end();) {
+		it->numFramebuffers = 0;
+		if(isInUse(*it))
+			++it;
+		else
+			it = textures.erase(it);
+	}
+}
+
+size_t RenderTargetPool::getMemoryUsage() const {
+	size_t size = 0;
+	for(const auto & entry : textures)
+		size += entry.texture->getDataSize();
+	return size;
+}
+
+}
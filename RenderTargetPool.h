@@ -0,0 +1,120 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_RENDERTARGETPOOL_H_
+#define RENDERING_RENDERTARGETPOOL_H_
+
+#include "Texture/Texture.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace Rendering {
+class FBO;
+class RenderingContext;
+
+/*! Pool of transient render targets (e.g. for post-processing passes).
+	Textures are handed out by their Texture::Format. A texture is in use as long as it is referenced outside of the
+	pool; afterwards it can be handed out again (even within the same frame). Framebuffers are cached by their set
+	of attachments, so the repeated attaching and completeness checks are only done once per attachment set.
+	endFrame() should be called once per frame; textures and framebuffers that have not been used for
+	@a maxIdleFrames frames are released (e.g. the render targets of the old size after a window resize).
+	\code
+		Util::Reference<Texture> color = pool->acquireColorTexture(width, height, true);
+		Util::Reference<Texture> depth = pool->acquireDepthTexture(width, height);
+		FBO * fbo = pool->getFramebuffer(context, {color.get()}, depth.get());
+		context.pushAndSetFBO(fbo);
+		// ...
+		context.popFBO();
+		// at the end of the frame
+		pool->endFrame();
+	\endcode
+	If the depth is transient (see setTransientDepth()), the depth (and stencil) attachments of the framebuffers are
+	not stored at FBO::endPass(), so tile-based GPUs do not write them back to memory.
+	\note The framebuffer cache holds references to the attached textures. */
+class RenderTargetPool : public Util::ReferenceCounter<RenderTargetPool> {
+	public:
+		struct Statistics {
+			uint64_t textureHits;			//!< Requests served by a pooled texture.
+			uint64_t textureMisses;			//!< Requests that created a new texture.
+			uint64_t framebufferHits;
+			uint64_t framebufferMisses;
+			Statistics() : textureHits(0), textureMisses(0), framebufferHits(0), framebufferMisses(0) {}
+		};
+
+		explicit RenderTargetPool(uint32_t maxIdleFrames = 3);
+		~RenderTargetPool();
+
+		//! Returns an unused texture of the given format; a new texture is created if there is none.
+		Util::Reference<Texture> acquireTexture(const Texture::Format & format);
+		//! @see TextureUtils::createStdTexture
+		Util::Reference<Texture> acquireColorTexture(uint32_t width, uint32_t height, bool alpha);
+		//! @see TextureUtils::createDepthTexture
+		Util::Reference<Texture> acquireDepthTexture(uint32_t width, uint32_t height);
+
+		/*! Returns a framebuffer with the given color attachments (0...n-1) and depth (or depth stencil) attachment.
+			The draw buffers are set to the number of color textures.
+			@return nullptr if the framebuffer is not complete. */
+		FBO * getFramebuffer(RenderingContext & context, const std::vector<Texture *> & colorTextures, Texture * depthTexture = nullptr);
+
+		//! Advance the frame counter and release textures and framebuffers that have been idle for too long.
+		void endFrame();
+		//! Release all unused textures and all framebuffers.
+		void clear();
+
+		//! If enabled (default), the depth attachments are invalidated at FBO::endPass() (see FBO::setStoreContents()).
+		void setTransientDepth(bool enabled)			{	transientDepth = enabled;	}
+		bool isTransientDepth() const					{	return transientDepth;	}
+
+		uint32_t getMaxIdleFrames() const				{	return maxIdleFrames;	}
+		void setMaxIdleFrames(uint32_t frames)			{	maxIdleFrames = frames;	}
+		uint32_t getNumTextures() const					{	return static_cast<uint32_t>(textures.size());	}
+		uint32_t getNumFramebuffers() const				{	return static_cast<uint32_t>(framebuffers.size());	}
+		//! Size of the pooled textures' data in bytes.
+		size_t getMemoryUsage() const;
+
+		const Statistics & getStatistics() const		{	return statistics;	}
+		void resetStatistics()							{	statistics = Statistics();	}
+
+	private:
+		struct TextureEntry {
+			Util::Reference<Texture> texture;
+			uint32_t lastUsedFrame;
+			uint32_t numFramebuffers;	//!< references held by cached framebuffers
+		};
+		struct FramebufferEntry {
+			Util::Reference<FBO> fbo;
+			std::vector<Util::Reference<Texture>> attachments;
+			uint32_t lastUsedFrame;
+		};
+		//! key: the color textures followed by the depth texture (may be nullptr)
+		typedef std::map<std::vector<Texture *>, FramebufferEntry> framebufferMap_t;
+
+		uint32_t maxIdleFrames;
+		uint32_t frameNumber;
+		bool transientDepth;
+		std::vector<TextureEntry> textures;
+		framebufferMap_t framebuffers;
+		Statistics statistics;
+
+		bool isInUse(const TextureEntry & entry) const {
+			return entry.texture->countReferences() > 1 + static_cast<int>(entry.numFramebuffers);
+		}
+		TextureEntry * findEntry(Texture * texture);
+		void removeFramebuffer(framebufferMap_t::iterator it);
+		void applyStoreHints(FBO & fbo, Texture * depthTexture) const;
+};
+
+}
+
+#endif /* RENDERING_RENDERTARGETPOOL_H_ */
@@ -12,29 +12,43 @@
 #include "RenderingContext.h"
 
 #include "internal/CoreRenderingStatus.h"
+#include "internal/DrawCommandQueue.h"
 #include "internal/RenderingStatus.h"
+#include "internal/StateStack.h"
 #include "internal/StatusHandler_glCompatibility.h"
 #include "internal/StatusHandler_glCore.h"
 #include "internal/StatusHandler_sgUniforms.h"
 #include "RenderingParameters.h"
 #include "../BufferObject.h"
+#include "../Capabilities.h"
+#include "../DrawCommandList.h"
 #include "../Mesh/Mesh.h"
 #include "../Mesh/VertexAttribute.h"
+#include "../Shader/GlobalUniformBlock.h"
 #include "../Shader/Shader.h"
 #include "../Shader/UniformRegistry.h"
 #include "../Texture/Texture.h"
 #include "../FBO.h"
+#include "../FrameProfiler.h"
 #include "../GLHeader.h"
+#include "../GLTrace.h"
 #include "../Helper.h"
+#include "../QueryObject.h"
 #include <Geometry/Matrix4x4.h>
 #include <Geometry/Rect.h>
 #include <Util/Graphics/ColorLibrary.h>
 #include <Util/Graphics/Color.h>
 #include <Util/Macros.h>
 #include <Util/References.h>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <sstream>
 #include <stdexcept>
-#include <stack>
+#include <unordered_map>
+#include <vector>
 
 #ifdef WIN32
 #include <GL/wglew.h>
@@ -48,7 +62,7 @@ class RenderingContext::InternalData {
 		RenderingStatus targetRenderingStatus;
 		RenderingStatus openGLRenderingStatus;
 		RenderingStatus * activeRenderingStatus;
-		std::stack<RenderingStatus *> renderingDataStack;
+		StateStack<RenderingStatus *> renderingDataStack;
 
 		CoreRenderingStatus actualCoreRenderingStatus;
 		CoreRenderingStatus appliedCoreRenderingStatus;
@@ -60,55 +74,119 @@ class RenderingContext::InternalData {
 			return activeRenderingStatus;
 		}
 
-		std::stack<AlphaTestParameters> alphaTestParameterStack;
-		std::unordered_map<uint32_t,std::stack<Util::Reference<Texture>>> atomicCounterStacks; 
+		StateStack<AlphaTestParameters> alphaTestParameterStack;
+		std::vector<StateStack<Util::Reference<Texture>>> atomicCounterStacks;
 
-		std::stack<BlendingParameters> blendingParameterStack;
-		std::stack<ColorBufferParameters> colorBufferParameterStack;
-		std::stack<CullFaceParameters> cullFaceParameterStack;
-		std::stack<DepthBufferParameters> depthBufferParameterStack;
-		std::array<std::stack<ImageBindParameters>, MAX_BOUND_IMAGES> imageStacks; 
+		StateStack<BlendingParameters> blendingParameterStack;
+		StateStack<ColorBufferParameters> colorBufferParameterStack;
+		StateStack<CullFaceParameters> cullFaceParameterStack;
+		StateStack<DepthBufferParameters> depthBufferParameterStack;
+		std::array<StateStack<ImageBindParameters>, MAX_BOUND_IMAGES> imageStacks; 
 		std::array<ImageBindParameters, MAX_BOUND_IMAGES> boundImages;
-		std::stack<LightingParameters> lightingParameterStack;
-		std::stack<LineParameters> lineParameterStack;
-		std::stack<MaterialParameters> materialStack;
-		std::stack<PointParameters> pointParameterStack;
-		std::stack<PolygonModeParameters> polygonModeParameterStack;
-		std::stack<PolygonOffsetParameters> polygonOffsetParameterStack;
-		std::stack<ScissorParameters> scissorParametersStack;
+		StateStack<LightingParameters> lightingParameterStack;
+		StateStack<LineParameters> lineParameterStack;
+		StateStack<MaterialParameters> materialStack;
+		StateStack<PointParameters> pointParameterStack;
+		StateStack<PolygonModeParameters> polygonModeParameterStack;
+		StateStack<PolygonOffsetParameters> polygonOffsetParameterStack;
+		StateStack<ScissorParameters> scissorParametersStack;
 		ScissorParameters currentScissorParameters;
-		std::stack<StencilParameters> stencilParameterStack;
+		StateStack<StencilParameters> stencilParameterStack;
 		
-		std::array<std::stack<ClipPlaneParameters>, MAX_CLIP_PLANES> clipPlaneStacks;
+		std::array<StateStack<ClipPlaneParameters>, MAX_CLIP_PLANES> clipPlaneStacks;
 		std::array<ClipPlaneParameters, MAX_CLIP_PLANES> activeClipPlanes;
 				
-		std::stack<Util::Reference<FBO> > fboStack;
+		StateStack<Util::Reference<FBO> > fboStack;
 		Util::Reference<FBO> activeFBO;
 
 		UniformRegistry globalUniforms;
 
-		std::stack<Geometry::Matrix4x4> matrixStack;
-		std::stack<Geometry::Matrix4x4> projectionMatrixStack;
+		std::unique_ptr<GlobalUniformBlock> globalUniformBlock;
+		UniformRegistry globalUniformBlockValues; //!< values of the block members (never synchronized with the shaders)
+		RenderingStatus globalUniformBlockStatus; //!< camera matrices stored in the block
+		bool globalUniformBlockInitialized;
 
-		std::array<std::stack<std::pair<Util::Reference<Texture>, TexUnitUsageParameter>>, MAX_TEXTURES> textureStacks;
+		StateStack<Geometry::Matrix4x4> matrixStack;
+		StateStack<Geometry::Matrix4x4> projectionMatrixStack;
+
+		std::array<StateStack<std::pair<Util::Reference<Texture>, TexUnitUsageParameter>>, MAX_TEXTURES> textureStacks;
+		std::unordered_map<Texture *, Util::Reference<Texture>> residentTextures;
 
 		typedef std::pair<Util::Reference<CountedBufferObject>,uint32_t> feedbackBufferStatus_t; // buffer->mode
 
-		std::stack<feedbackBufferStatus_t> feedbackStack;
+		StateStack<feedbackBufferStatus_t> feedbackStack;
 		feedbackBufferStatus_t activeFeedbackStatus;
 
-		std::stack<uint32_t> activeClientStates;
-		std::stack<uint32_t> activeTextureClientStates;
-		std::stack<uint32_t> activeVertexAttributeBindings;
+		StateStack<uint32_t> activeClientStates;
+		StateStack<uint32_t> activeTextureClientStates;
+		StateStack<uint32_t> activeVertexAttributeBindings;
 		
 		Geometry::Rect_i currentViewport;
-		std::stack<Geometry::Rect_i> viewportStack;
+		StateStack<Geometry::Rect_i> viewportStack;
 
 		Geometry::Rect_i windowClientArea;
+
+		uint32_t skippedStateGroups;
+		bool positionOnlyPass;
+
+		DrawCommandQueue drawCommandQueue;
+		DisplayMeshFn displayMeshFnBeforeRecording;
+
+		//! State blocks referenced by DrawCommandLists
+		struct StateBlockSnapshot {
+			Util::Reference<Shader> shader;
+			CoreRenderingStatus coreStatus;
+			RenderingStatus renderingStatus;
+			bool blended;
+		};
+		std::vector<StateBlockSnapshot> stateBlocks;
+
+		//! (see _getHelperMesh) A deque, as references to the elements have to stay valid when it grows.
+		std::deque<Util::Reference<Mesh>> helperMeshes;
+
+		Util::Reference<FrameProfiler> frameProfiler;
+
+		//! fences of the frames in flight (oldest first) and their frame numbers
+		std::deque<std::pair<uint64_t, void *>> frameFences;
+		uint64_t frameNumber;
+		uint64_t completedFrameNumber;
+		uint32_t maxFramesInFlight;
+		bool inFrame;
+		double frameWaitTime;
+		bool conditionalRenderActive;
+		Util::Reference<Shader> pendingShaderFallback;
 		
+		//! Values saved by pushStateFrame()
+		struct StateFrame {
+			AlphaTestParameters alphaTest;
+			BlendingParameters blending;
+			ColorBufferParameters colorBuffer;
+			CullFaceParameters cullFace;
+			DepthBufferParameters depthBuffer;
+			LightingParameters lighting;
+			LineParameters line;
+			PointParameters point;
+			PolygonModeParameters polygonMode;
+			PolygonOffsetParameters polygonOffset;
+			ScissorParameters scissor;
+			StencilParameters stencil;
+			Geometry::Rect_i viewport;
+			Geometry::Matrix4x4 modelToCamera;
+			Geometry::Matrix4x4 cameraToClipping;
+		};
+		StateStack<StateFrame> stateFrameStack;
+
+		StateStack<Util::Reference<Texture>> & getAtomicCounterStack(uint32_t index) {
+			if(index >= atomicCounterStacks.size())
+				atomicCounterStacks.resize(index + 1);
+			return atomicCounterStacks[index];
+		}
+
 		InternalData() : targetRenderingStatus(), openGLRenderingStatus(), activeRenderingStatus(nullptr),
 			actualCoreRenderingStatus(), appliedCoreRenderingStatus(), globalUniforms(), textureStacks(),
-			currentViewport(0, 0, 0, 0) {
+			globalUniformBlockInitialized(false), currentViewport(0, 0, 0, 0), skippedStateGroups(0), positionOnlyPass(false),
+			frameFences(), frameNumber(0), completedFrameNumber(0), maxFramesInFlight(2), inFrame(false), frameWaitTime(0.0),
+			conditionalRenderActive(false) {
 		}
 };
 
@@ -133,9 +211,26 @@ RenderingContext::RenderingContext() :
 	setStencil(StencilParameters());
 }
 
-bool RenderingContext::compabilityMode = true;
+thread_local bool RenderingContext::compabilityMode = true;
 
-RenderingContext::~RenderingContext() = default;
+//! (static)
+uint32_t RenderingContext::_createHelperMeshSlot() {
+	static std::atomic<uint32_t> numSlots(0);
+	return numSlots++;
+}
+
+Util::Reference<Mesh> & RenderingContext::_getHelperMesh(uint32_t slot) {
+	if(slot >= internalData->helperMeshes.size())
+		internalData->helperMeshes.resize(slot + 1);
+	return internalData->helperMeshes[slot];
+}
+
+RenderingContext::~RenderingContext() {
+#if defined(LIB_GL) && defined(GL_ARB_sync)
+	for(const auto & fence : internalData->frameFences)
+		glDeleteSync(reinterpret_cast<GLsync>(fence.second));
+#endif
+}
 
 void RenderingContext::resetDisplayMeshFn() {
 	using namespace std::placeholders;
@@ -169,6 +264,16 @@ void RenderingContext::clearScreen(const Util::Color4f & color) {
 }
 
 
+//! Created by initGLState() for the GL context of the calling thread.
+static thread_local GLuint defaultVertexArrayObject = 0;
+
+//! (static)
+void RenderingContext::_bindDefaultVertexArrayObject() {
+#ifdef LIB_GL
+	glBindVertexArray(defaultVertexArrayObject);
+#endif /* LIB_GL */
+}
+
 //! (static)
 void RenderingContext::initGLState() {
 #ifdef LIB_GLEW
@@ -177,6 +282,7 @@ void RenderingContext::initGLState() {
 	if(GLEW_OK != err) {
 		WARN(std::string("GLEW Error: ") + reinterpret_cast<const char *>(glewGetErrorString(err)));
 	}
+	Capabilities::_init();
 
 #ifdef LIB_GL
 	glPixelStorei( GL_PACK_ALIGNMENT,1); // allow glReadPixel for all possible resolutions
@@ -210,10 +316,9 @@ void RenderingContext::initGLState() {
 		// Workaround: Create a single vertex array object here.
 		// For the core profile of OpenGL 3.2 or higher this is required,
 		// because glVertexAttribPointer generates an GL_INVALID_OPERATION without it.
-		// In the future, vertex array objects should be integrated into the rendering system.
-		GLuint vertexArrayObject;
-		glGenVertexArrays(1, &vertexArrayObject);
-		glBindVertexArray(vertexArrayObject);
+		// Meshes stored in VBOs use their own cached vertex array objects (@see VertexArrayObjectCache).
+		glGenVertexArrays(1, &defaultVertexArrayObject);
+		glBindVertexArray(defaultVertexArrayObject);
 	}
 
 	// Enable the possibility to write gl_PointSize from the vertex shader.
@@ -265,14 +370,39 @@ void RenderingContext::barrier(uint32_t flags) {
 
 void RenderingContext::applyChanges(bool forced) {
 	try {
-		StatusHandler_glCore::apply(internalData->appliedCoreRenderingStatus, internalData->actualCoreRenderingStatus, forced);
+		const uint32_t skipped = StatusHandler_glCore::apply(internalData->appliedCoreRenderingStatus, internalData->actualCoreRenderingStatus, forced);
+		internalData->skippedStateGroups += skipped;
+		_getFrameCounters().appliedStateGroups += CoreRenderingStatus::NUM_GROUPS - skipped;
+		internalData->actualCoreRenderingStatus.clearDirtyGroups();
+		if(internalData->globalUniformBlock)
+			updateGlobalUniformBlock(forced);
 		Shader * shader = internalData->getActiveRenderingStatus()->getShader();
-		if(shader) {
+		bool shaderPending = false;
+		if(shader && shader->getStatus() == Shader::PENDING) {
+			if(shader->isReady()) { // the shader has been set while it was compiling
+				shader->_enable();
+				++_getFrameCounters().shaderChanges;
+				if(!shader->getRenderingStatus()->isInitialized()) {
+					forced = true; // make sure that all uniforms are initially set
+					shader->getRenderingStatus()->markInitialized();
+				}
+			} else if(shader->getStatus() == Shader::PENDING) {
+				shaderPending = true; // the shader dependent state is applied when the shader is ready
+			} else {
+				WARN("RenderingContext::applyChanges: can't enable shader, using OpenGL instead");
+				internalData->setActiveRenderingStatus(&(internalData->openGLRenderingStatus));
+				glUseProgram(0);
+				shader = nullptr;
+			}
+		}
+		if(shader && !shaderPending) {
 			if(shader->usesClassicOpenGL())
 				StatusHandler_glCompatibility::apply(internalData->openGLRenderingStatus, internalData->targetRenderingStatus, forced);
 
+			const bool usesGlobalUniformBlock = internalData->globalUniformBlock &&
+					shader->_bindGlobalUniformBlock(internalData->globalUniformBlock->getBinding());
 			if(shader->usesSGUniforms()) {
-				StatusHandler_sgUniforms::apply(*shader->getRenderingStatus(), internalData->targetRenderingStatus, forced);
+				StatusHandler_sgUniforms::apply(*shader->getRenderingStatus(), internalData->targetRenderingStatus, forced, usesGlobalUniformBlock);
 				if(immediate && getActiveShader() == shader) {
 					shader->applyUniforms(false); // forced is false here, as this forced means to re-apply all uniforms
 				}
@@ -284,7 +414,7 @@ void RenderingContext::applyChanges(bool forced) {
 			// apply uniforms
 			shader->applyUniforms(forced);
 			GET_GL_ERROR();
-		} else if(compabilityMode) {
+		} else if(!shader && compabilityMode) {
 			StatusHandler_glCompatibility::apply(internalData->openGLRenderingStatus, internalData->targetRenderingStatus, forced);
 		}
 	} catch(const std::exception & e) {
@@ -293,45 +423,341 @@ void RenderingContext::applyChanges(bool forced) {
 	GET_GL_ERROR();
 }
 
+uint32_t RenderingContext::getSkippedStateGroupCount() const {
+	return internalData->skippedStateGroups;
+}
+
+void RenderingContext::resetSkippedStateGroupCount() {
+	internalData->skippedStateGroups = 0;
+}
+
+RenderingContext::FrameCounters & RenderingContext::_getFrameCounters() {
+	static FrameCounters counters;
+	return counters;
+}
+
+// Draw command recording ************************************************************************
+
+void RenderingContext::startDrawCommandRecording() {
+	if(isRecordingDrawCommands()) {
+		WARN("startDrawCommandRecording: Already recording.");
+		return;
+	}
+	internalData->displayMeshFnBeforeRecording = displayMeshFn;
+	internalData->drawCommandQueue.begin(internalData->globalUniforms);
+	displayMeshFn = [](RenderingContext & rc, Mesh * mesh, uint32_t firstElement, uint32_t elementCount) {
+		InternalData & data = *rc.internalData;
+		data.drawCommandQueue.record(mesh, firstElement, elementCount, rc.getActiveShader(),
+									data.actualCoreRenderingStatus, data.targetRenderingStatus, data.globalUniforms);
+	};
+}
+
+bool RenderingContext::isRecordingDrawCommands() const {
+	return internalData->drawCommandQueue.isRecording();
+}
+
+RenderingContext::DrawCommandStatistics RenderingContext::flushDrawCommands() {
+	DrawCommandStatistics statistics;
+	if(!isRecordingDrawCommands()) {
+		WARN("flushDrawCommands: Not recording.");
+		return statistics;
+	}
+	displayMeshFn = internalData->displayMeshFnBeforeRecording;
+	internalData->displayMeshFnBeforeRecording = DisplayMeshFn();
+
+	DrawCommandQueue::shaderUniforms_t finalShaderUniforms;
+	std::vector<Uniform> finalGlobalUniforms;
+	std::vector<DrawCommandQueue::Command> commands = internalData->drawCommandQueue.finish(internalData->globalUniforms,
+																		finalShaderUniforms, finalGlobalUniforms, statistics);
+	if(commands.empty())
+		return statistics;
+
+	// store the current state
+	const Util::Reference<Shader> activeShader = getActiveShader();
+	const CoreRenderingStatus coreStatus = internalData->actualCoreRenderingStatus;
+	const RenderingStatus renderingStatus = internalData->targetRenderingStatus;
+
+	for(const auto & command : commands) {
+		if(getActiveShader() != command.shader.get())
+			setShader(command.shader.get());
+		internalData->actualCoreRenderingStatus = command.coreStatus;
+		internalData->actualCoreRenderingStatus.markAllDirty();
+		internalData->targetRenderingStatus = command.renderingStatus;
+		for(const auto & uniform : command.globalUniforms)
+			internalData->globalUniforms.setUniform(uniform, false, false);
+		if(command.shader.isNotNull()) {
+			for(const auto & uniform : command.uniforms)
+				command.shader->setUniform(*this, uniform, false, false);
+		}
+		displayMeshFn(*this, command.mesh.get(), command.firstElement, command.elementCount);
+	}
+
+	// restore the state of the end of the recording
+	for(const auto & entry : finalShaderUniforms) {
+		for(const auto & uniform : entry.second)
+			entry.first->setUniform(*this, uniform, false, false);
+	}
+	for(const auto & uniform : finalGlobalUniforms)
+		internalData->globalUniforms.setUniform(uniform, false, false);
+	setShader(activeShader.get());
+	internalData->actualCoreRenderingStatus = coreStatus;
+	internalData->actualCoreRenderingStatus.markAllDirty();
+	internalData->targetRenderingStatus = renderingStatus;
+	if(immediate)
+		applyChanges();
+	return statistics;
+}
+
+uint32_t RenderingContext::createStateBlock() {
+	InternalData::StateBlockSnapshot snapshot;
+	snapshot.shader = getActiveShader();
+	snapshot.coreStatus = internalData->actualCoreRenderingStatus;
+	snapshot.renderingStatus = internalData->targetRenderingStatus;
+	snapshot.blended = snapshot.coreStatus.getBlendingParameters().isEnabled();
+	internalData->stateBlocks.emplace_back(std::move(snapshot));
+	return static_cast<uint32_t>(internalData->stateBlocks.size() - 1);
+}
+
+void RenderingContext::clearStateBlocks() {
+	internalData->stateBlocks.clear();
+}
+
+//! (internal) A command of a DrawCommandList during submission.
+struct SubmittedCommand {
+	const DrawCommandList::Command * command;
+	const DrawCommandList * list;
+	Shader * shader;
+	uint32_t order;		//!< position in the merged lists
+	bool blended;
+};
+
+//! (internal) Do the state blocks bind the same textures?
+static bool sameTextures(const CoreRenderingStatus & a, const CoreRenderingStatus & b) {
+	for(uint_fast8_t unit = 0; unit < MAX_TEXTURES; ++unit) {
+		if(a.getTexture(unit).get() != b.getTexture(unit).get())
+			return false;
+	}
+	return true;
+}
+
+//! (internal)
+template<typename getBlock_t>
+static void countStateChanges(const std::vector<SubmittedCommand> & commands, getBlock_t getBlock,
+							uint32_t & shaderChanges, uint32_t & textureChanges, uint32_t & meshChanges) {
+	shaderChanges = textureChanges = meshChanges = 0;
+	for(size_t i = 1; i < commands.size(); ++i) {
+		const auto & previous = commands[i - 1];
+		const auto & current = commands[i];
+		if(previous.shader != current.shader)
+			++shaderChanges;
+		if(previous.command->stateBlock != current.command->stateBlock &&
+				!sameTextures(getBlock(previous).coreStatus, getBlock(current).coreStatus))
+			++textureChanges;
+		if(previous.command->mesh != current.command->mesh)
+			++meshChanges;
+	}
+}
+
+RenderingContext::DrawCommandStatistics RenderingContext::submitCommandLists(const std::vector<const DrawCommandList *> & lists) {
+	DrawCommandStatistics statistics;
+	const auto & stateBlocks = internalData->stateBlocks;
+
+	std::vector<SubmittedCommand> commands;
+	size_t numCommands = 0;
+	for(const auto list : lists)
+		numCommands += list != nullptr ? list->size() : 0;
+	commands.reserve(numCommands);
+	for(const auto list : lists) {
+		if(list == nullptr)
+			continue;
+		for(const auto & command : list->getCommands()) {
+			if(command.stateBlock >= stateBlocks.size()) {
+				WARN("submitCommandLists: Invalid state block.");
+				continue;
+			}
+			const auto & block = stateBlocks[command.stateBlock];
+			SubmittedCommand entry;
+			entry.command = &command;
+			entry.list = list;
+			entry.shader = command.shader != nullptr ? command.shader : block.shader.get();
+			entry.order = static_cast<uint32_t>(commands.size());
+			entry.blended = block.blended;
+			commands.push_back(entry);
+		}
+	}
+	if(commands.empty())
+		return statistics;
+
+	const auto getBlock = [&stateBlocks](const SubmittedCommand & c) -> const InternalData::StateBlockSnapshot & {
+		return stateBlocks[c.command->stateBlock];
+	};
+	statistics.numCommands = static_cast<uint32_t>(commands.size());
+	countStateChanges(commands, getBlock, statistics.shaderChangesRecorded, statistics.textureChangesRecorded, statistics.meshChangesRecorded);
+	std::sort(commands.begin(), commands.end(), [](const SubmittedCommand & a, const SubmittedCommand & b) {
+		if(a.blended != b.blended)
+			return b.blended;
+		if(a.blended) // keep the order of transparent objects
+			return a.order < b.order;
+		if(a.shader != b.shader)
+			return a.shader < b.shader;
+		if(a.command->stateBlock != b.command->stateBlock)
+			return a.command->stateBlock < b.command->stateBlock;
+		if(a.command->mesh != b.command->mesh)
+			return a.command->mesh < b.command->mesh;
+		return a.order < b.order;
+	});
+	countStateChanges(commands, getBlock, statistics.shaderChangesSubmitted, statistics.textureChangesSubmitted, statistics.meshChangesSubmitted);
+
+	// store the current state
+	const Util::Reference<Shader> activeShader = getActiveShader();
+	const CoreRenderingStatus coreStatus = internalData->actualCoreRenderingStatus;
+	const RenderingStatus renderingStatus = internalData->targetRenderingStatus;
+
+	uint32_t currentBlock = 0xFFFFFFFF;
+	for(const auto & entry : commands) {
+		const DrawCommandList::Command & command = *entry.command;
+		if(getActiveShader() != entry.shader)
+			setShader(entry.shader);
+		const auto & block = stateBlocks[command.stateBlock];
+		if(command.stateBlock != currentBlock) {
+			currentBlock = command.stateBlock;
+			internalData->actualCoreRenderingStatus = block.coreStatus;
+			internalData->actualCoreRenderingStatus.markAllDirty();
+			internalData->targetRenderingStatus = block.renderingStatus;
+		}
+		internalData->targetRenderingStatus.setMatrix_modelToCamera(block.renderingStatus.getMatrix_worldToCamera() * command.modelToWorld);
+		if(entry.shader != nullptr) {
+			const auto & uniforms = entry.list->getUniforms();
+			for(uint32_t i = command.firstUniform; i < command.firstUniform + command.numUniforms; ++i)
+				entry.shader->setUniform(*this, uniforms[i], false, false);
+		}
+		displayMeshFn(*this, command.mesh, command.firstElement, command.elementCount);
+	}
+
+	setShader(activeShader.get());
+	internalData->actualCoreRenderingStatus = coreStatus;
+	internalData->actualCoreRenderingStatus.markAllDirty();
+	internalData->targetRenderingStatus = renderingStatus;
+	if(immediate)
+		applyChanges();
+	return statistics;
+}
+
+void RenderingContext::setFrameProfiler(FrameProfiler * profiler) {
+	internalData->frameProfiler = profiler;
+}
+
+FrameProfiler * RenderingContext::getFrameProfiler() const {
+	return internalData->frameProfiler.get();
+}
+
+// Frame pacing ******************************************************************************
+
+//! (internal) Remove the fences of the frames that have been completed; if @p wait is set, wait for the oldest one.
+static void updateFrameFences(std::deque<std::pair<uint64_t, void *>> & fences, uint64_t & completedFrameNumber, bool wait) {
+#if defined(LIB_GL) && defined(GL_ARB_sync)
+	while(!fences.empty()) {
+		GLsync fence = reinterpret_cast<GLsync>(fences.front().second);
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if(result == GL_TIMEOUT_EXPIRED && wait) {
+			do {
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+			} while(result == GL_TIMEOUT_EXPIRED);
+		}
+		if(result == GL_TIMEOUT_EXPIRED)
+			return;
+		if(result == GL_WAIT_FAILED)
+			WARN("RenderingContext: Waiting for frame fence failed.");
+		glDeleteSync(fence);
+		completedFrameNumber = fences.front().first;
+		fences.pop_front();
+		wait = false;
+	}
+#else
+	(void)wait;
+	if(!fences.empty()) {
+		completedFrameNumber = fences.back().first;
+		fences.clear();
+	}
+#endif
+}
+
+void RenderingContext::beginFrame() {
+	if(internalData->inFrame) {
+		WARN("RenderingContext::beginFrame: endFrame has not been called.");
+		endFrame();
+	}
+	const auto start = std::chrono::steady_clock::now();
+	updateFrameFences(internalData->frameFences, internalData->completedFrameNumber, false);
+	while(internalData->frameFences.size() >= internalData->maxFramesInFlight)
+		updateFrameFences(internalData->frameFences, internalData->completedFrameNumber, true);
+	internalData->frameWaitTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	++internalData->frameNumber;
+	internalData->inFrame = true;
+	_beginGLErrorCheckingFrame();
+}
+
+void RenderingContext::endFrame() {
+	if(!internalData->inFrame)
+		return;
+	internalData->inFrame = false;
+	RENDERING_GL_TRACE(FRAME_END, {});
+#if defined(LIB_GL) && defined(GL_ARB_sync)
+	internalData->frameFences.emplace_back(internalData->frameNumber, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	GET_GL_ERROR();
+#else
+	internalData->frameFences.emplace_back(internalData->frameNumber, nullptr);
+#endif
+}
+
+uint64_t RenderingContext::getFrameNumber() const {
+	return internalData->frameNumber;
+}
+
+uint32_t RenderingContext::getFrameIndex() const {
+	return static_cast<uint32_t>(internalData->frameNumber % internalData->maxFramesInFlight);
+}
+
+uint64_t RenderingContext::getCompletedFrameNumber() const {
+	return internalData->completedFrameNumber;
+}
+
+bool RenderingContext::isFrameCompleted(uint64_t number) {
+	if(number > internalData->completedFrameNumber)
+		updateFrameFences(internalData->frameFences, internalData->completedFrameNumber, false);
+	return number <= internalData->completedFrameNumber;
+}
+
+void RenderingContext::setMaxFramesInFlight(uint32_t frames) {
+	internalData->maxFramesInFlight = std::max(1u, std::min(frames, 8u));
+}
+
+uint32_t RenderingContext::getMaxFramesInFlight() const {
+	return internalData->maxFramesInFlight;
+}
+
+double RenderingContext::getFrameWaitTime() const {
+	return internalData->frameWaitTime;
+}
+
 // Atomic counters (extension ARB_shader_atomic_counters)  *****************************************************
 
 
 //! (static)
 bool RenderingContext::isAtomicCountersSupported(){
 #if defined(GL_ARB_shader_atomic_counters)
-	static const bool support = isExtensionSupported("GL_ARB_shader_atomic_counters");
-	return support;
+	return Capabilities::get().atomicCounters;
 #else
 	return false;
 #endif
 }
 //! (static)
 uint32_t RenderingContext::getMaxAtomicCounterBuffers(){
-	static const uint32_t value = [](){
-#if defined(GL_ARB_shader_atomic_counters)
-		if(isAtomicCountersSupported()){
-			GLint max;
-			glGetIntegerv(GL_MAX_ATOMIC_COUNTER_BUFFER_BINDINGS, &max); 
-			return static_cast<uint32_t>(max);
-		}
-#endif
-		return static_cast<uint32_t>(0);
-	}();
-	return value;
+	return Capabilities::get().maxAtomicCounterBufferBindings;
 }
 //! (static)
 uint32_t RenderingContext::getMaxAtomicCounterBufferSize(){
-	static const uint32_t value = [](){
-#if defined(GL_ARB_shader_atomic_counters)
-		if(isAtomicCountersSupported()){
-			GLint max;
-			glGetIntegerv(GL_MAX_ATOMIC_COUNTER_BUFFER_SIZE, &max); 
-			return static_cast<uint32_t>(max);
-		}
-#endif
-		return static_cast<uint32_t>(0);
-	}();
-	return value;
+	return Capabilities::get().maxAtomicCounterBufferSize;
 }
 
 static void assertCorrectAtomicBufferIndex(uint32_t index){
@@ -343,13 +769,13 @@ static void assertCorrectAtomicBufferIndex(uint32_t index){
 
 Texture* RenderingContext::getAtomicCounterTextureBuffer(uint32_t index)const{
 	assertCorrectAtomicBufferIndex(index);
-	auto& stack = internalData->atomicCounterStacks[index];
+	auto& stack = internalData->getAtomicCounterStack(index);
 	return stack.empty() ? nullptr : stack.top().get();
 }
 
 void RenderingContext::pushAtomicCounterTextureBuffer(uint32_t index){
 	assertCorrectAtomicBufferIndex(index);
-	auto& stack = internalData->atomicCounterStacks[index];
+	auto& stack = internalData->getAtomicCounterStack(index);
 	if(stack.empty()) stack.push(nullptr); // init stack
 	stack.push( getAtomicCounterTextureBuffer(index) );
 }
@@ -360,7 +786,7 @@ void RenderingContext::pushAndSetAtomicCounterTextureBuffer(uint32_t index, Text
 }
 void RenderingContext::popAtomicCounterTextureBuffer(uint32_t index){
 	assertCorrectAtomicBufferIndex(index);
-	auto& stack = internalData->atomicCounterStacks[index];
+	auto& stack = internalData->getAtomicCounterStack(index);
 	if(stack.size()<=1){
 		WARN("popAtomicCounterTexture: Empty stack");
 	}else{
@@ -406,7 +832,7 @@ void RenderingContext::setAtomicCounterTextureBuffer(uint32_t index, Texture * t
 	}
 #endif 
 
-	auto& stack = internalData->atomicCounterStacks[index];
+	auto& stack = internalData->getAtomicCounterStack(index);
 	if(stack.empty())
 		stack.push(texture);
 	else
@@ -525,6 +951,81 @@ void RenderingContext::clearColor(const Util::Color4f & clearValue) {
 	glClear(GL_COLOR_BUFFER_BIT);
 }
 
+// Conditional Render ***************************************************************************
+//! (static)
+bool RenderingContext::isConditionalRenderSupported() {
+	return Capabilities::get().conditionalRender;
+}
+
+void RenderingContext::beginConditionalRender(const QueryObject & query, conditionalRenderMode_t mode, bool inverted) {
+	if(internalData->conditionalRenderActive) {
+		WARN("beginConditionalRender: Conditional rendering is already active.");
+		return;
+	}
+	if(!isConditionalRenderSupported() || !query.isValid())
+		return;
+#if defined(LIB_GL)
+	const uint32_t queryType = query._getQueryType();
+	if(queryType != GL_SAMPLES_PASSED
+#if defined(GL_ARB_occlusion_query2)
+			&& queryType != GL_ANY_SAMPLES_PASSED
+#endif
+			) {
+		WARN("beginConditionalRender: The query is no occlusion query.");
+		return;
+	}
+	GLenum glMode = GL_QUERY_NO_WAIT;
+	if(inverted) {
+#if defined(GL_ARB_conditional_render_inverted)
+		if(!Capabilities::get().conditionalRenderInverted) {
+			WARN("beginConditionalRender: Inverted conditional rendering is not supported; rendering unconditionally.");
+			return;
+		}
+		switch(mode) {
+			case CONDITIONAL_RENDER_WAIT:				glMode = GL_QUERY_WAIT_INVERTED;			break;
+			case CONDITIONAL_RENDER_BY_REGION_WAIT:		glMode = GL_QUERY_BY_REGION_WAIT_INVERTED;		break;
+			case CONDITIONAL_RENDER_BY_REGION_NO_WAIT:	glMode = GL_QUERY_BY_REGION_NO_WAIT_INVERTED;	break;
+			case CONDITIONAL_RENDER_NO_WAIT:
+			default:									glMode = GL_QUERY_NO_WAIT_INVERTED;			break;
+		}
+#else
+		WARN("beginConditionalRender: Inverted conditional rendering is not supported; rendering unconditionally.");
+		return;
+#endif
+	} else {
+		switch(mode) {
+			case CONDITIONAL_RENDER_WAIT:				glMode = GL_QUERY_WAIT;				break;
+			case CONDITIONAL_RENDER_BY_REGION_WAIT:		glMode = GL_QUERY_BY_REGION_WAIT;		break;
+			case CONDITIONAL_RENDER_BY_REGION_NO_WAIT:	glMode = GL_QUERY_BY_REGION_NO_WAIT;	break;
+			case CONDITIONAL_RENDER_NO_WAIT:
+			default:									glMode = GL_QUERY_NO_WAIT;			break;
+		}
+	}
+	// pending state changes must not be skipped together with the conditional draw calls
+	applyChanges();
+	glBeginConditionalRender(query.getGLId(), glMode);
+	GET_GL_ERROR();
+	internalData->conditionalRenderActive = true;
+#else
+	(void)mode;
+	(void)inverted;
+#endif
+}
+
+void RenderingContext::endConditionalRender() {
+	if(!internalData->conditionalRenderActive)
+		return;
+#if defined(LIB_GL)
+	glEndConditionalRender();
+	GET_GL_ERROR();
+#endif
+	internalData->conditionalRenderActive = false;
+}
+
+bool RenderingContext::isConditionalRenderActive() const {
+	return internalData->conditionalRenderActive;
+}
+
 // Cull Face ************************************************************************************
 const CullFaceParameters & RenderingContext::getCullFaceParameters() const {
 	return internalData->actualCoreRenderingStatus.getCullFaceParameters();
@@ -590,6 +1091,14 @@ void RenderingContext::clearDepth(float clearValue) {
 	glClear(GL_DEPTH_BUFFER_BIT);
 }
 
+void RenderingContext::setPositionOnlyPass(bool enable) {
+	internalData->positionOnlyPass = enable;
+}
+
+bool RenderingContext::isPositionOnlyPass() const {
+	return internalData->positionOnlyPass;
+}
+
 // AlphaTest ************************************************************************************
 const AlphaTestParameters & RenderingContext::getAlphaTestParameters() const {
 	return internalData->actualCoreRenderingStatus.getAlphaTestParameters();
@@ -622,8 +1131,7 @@ void RenderingContext::setAlphaTest(const AlphaTestParameters & p) {
 //! (static)
 bool RenderingContext::isImageBindingSupported(){
 #if defined(GL_ARB_shader_image_load_store)
-	static const bool support = isExtensionSupported("GL_ARB_shader_image_load_store");
-	return support;
+	return Capabilities::get().imageLoadStore;
 #else
 	return false;
 #endif
@@ -966,19 +1474,83 @@ void RenderingContext::setFBO(FBO * fbo) {
 }
 
 // GLOBAL UNIFORMS ***************************************************************************
+static const Uniform::UniformName UNIFORM_SG_MATRIX_WORLD_TO_CAMERA("sg_matrix_worldToCamera");
+static const Uniform::UniformName UNIFORM_SG_MATRIX_CAMERA_TO_WORLD("sg_matrix_cameraToWorld");
+static const Uniform::UniformName UNIFORM_SG_MATRIX_CAMERA_TO_CLIPPING("sg_matrix_cameraToClipping");
+static const Uniform::UniformName UNIFORM_SG_MATRIX_CLIPPING_TO_CAMERA("sg_matrix_clippingToCamera");
+
 void RenderingContext::setGlobalUniform(const Uniform & u) {
-	internalData->globalUniforms.setUniform(u, false, false);
+	if(internalData->globalUniformBlock && internalData->globalUniformBlock->setUniform(u)) {
+		internalData->globalUniformBlockValues.setUniform(u, false, false);
+	} else {
+		internalData->globalUniforms.setUniform(u, false, false);
+	}
 	if(immediate)
 		applyChanges();	
 }
 const Uniform & RenderingContext::getGlobalUniform(const Util::StringIdentifier & uniformName) {
+	if(internalData->globalUniformBlock && internalData->globalUniformBlock->contains(uniformName))
+		return internalData->globalUniformBlockValues.getUniform(uniformName);
 	return internalData->globalUniforms.getUniform(uniformName);
 }
 
+void RenderingContext::enableGlobalUniformBlock(const std::vector<Uniform> & members, uint32_t binding) {
+	std::unique_ptr<GlobalUniformBlock> block(new GlobalUniformBlock(binding));
+	const RenderingStatus & target = internalData->targetRenderingStatus;
+	block->addMember(Uniform(UNIFORM_SG_MATRIX_WORLD_TO_CAMERA, target.getMatrix_worldToCamera()));
+	block->addMember(Uniform(UNIFORM_SG_MATRIX_CAMERA_TO_WORLD, target.getMatrix_cameraToWorld()));
+	block->addMember(Uniform(UNIFORM_SG_MATRIX_CAMERA_TO_CLIPPING, target.getMatrix_cameraToClipping()));
+	block->addMember(Uniform(UNIFORM_SG_MATRIX_CLIPPING_TO_CAMERA, target.getMatrix_cameraToClipping().inverse()));
+	internalData->globalUniformBlockValues.clear();
+	for(const auto & member : members) {
+		block->addMember(member);
+		internalData->globalUniformBlockValues.setUniform(member, false, false);
+	}
+	internalData->globalUniformBlock = std::move(block);
+	internalData->globalUniformBlockInitialized = false;
+	if(immediate)
+		applyChanges();
+}
+
+void RenderingContext::disableGlobalUniformBlock() {
+	internalData->globalUniformBlock.reset();
+	internalData->globalUniformBlockValues.clear();
+}
+
+const GlobalUniformBlock * RenderingContext::getGlobalUniformBlock() const {
+	return internalData->globalUniformBlock.get();
+}
+
+//! (internal) Write the changed camera matrices into the global uniform block and upload the changed data.
+void RenderingContext::updateGlobalUniformBlock(bool forced) {
+	GlobalUniformBlock & block = *internalData->globalUniformBlock;
+	RenderingStatus & blockStatus = internalData->globalUniformBlockStatus;
+	const RenderingStatus & target = internalData->targetRenderingStatus;
+	const bool initial = forced || !internalData->globalUniformBlockInitialized;
+	if(initial || blockStatus.matrixCameraToWorldChanged(target)) {
+		blockStatus.updateMatrix_cameraToWorld(target);
+		block.setUniform(Uniform(UNIFORM_SG_MATRIX_WORLD_TO_CAMERA, target.getMatrix_worldToCamera()));
+		block.setUniform(Uniform(UNIFORM_SG_MATRIX_CAMERA_TO_WORLD, target.getMatrix_cameraToWorld()));
+	}
+	if(initial || blockStatus.matrix_cameraToClipChanged(target)) {
+		blockStatus.updateMatrix_cameraToClipping(target);
+		block.setUniform(Uniform(UNIFORM_SG_MATRIX_CAMERA_TO_CLIPPING, target.getMatrix_cameraToClipping()));
+		block.setUniform(Uniform(UNIFORM_SG_MATRIX_CLIPPING_TO_CAMERA, target.getMatrix_cameraToClipping().inverse()));
+	}
+	block.upload();
+	if(initial)
+		block.bind();
+	internalData->globalUniformBlockInitialized = true;
+}
+
 // SHADER ************************************************************************************
 void RenderingContext::setShader(Shader * shader) {
 	if(shader) {
-		if(shader->_enable()) {
+		if(shader->getStatus() == Shader::PENDING && !shader->isReady()) {
+			// the program is bound by applyChanges() when it is ready
+			internalData->setActiveRenderingStatus(shader->getRenderingStatus());
+		} else if(shader->_enable()) {
+			++_getFrameCounters().shaderChanges;
 			internalData->setActiveRenderingStatus(shader->getRenderingStatus());
 			if (!internalData->getActiveRenderingStatus()->isInitialized()) { // this shader has not yet been initialized.
 				applyChanges(true); // make sure that all uniforms are initially set (e.g. even for disabled lights)
@@ -1033,6 +1605,19 @@ const Shader * RenderingContext::getActiveShader() const {
 	return internalData->getActiveRenderingStatus()->getShader();
 }
 
+void RenderingContext::setPendingShaderFallback(Shader * shader) {
+	internalData->pendingShaderFallback = shader;
+}
+
+Shader * RenderingContext::getPendingShaderFallback() const {
+	return internalData->pendingShaderFallback.get();
+}
+
+bool RenderingContext::isActiveShaderPending() const {
+	const Shader * shader = getActiveShader();
+	return shader != nullptr && shader->getStatus() == Shader::PENDING;
+}
+
 void RenderingContext::dispatchCompute(uint32_t numGroupsX, uint32_t numGroupsY, uint32_t numGroupsZ) {	
 	#if defined(LIB_GL) and defined(GL_ARB_compute_shader)
 		if(!getActiveShader()) {
@@ -1067,8 +1652,11 @@ void RenderingContext::loadUniformSubroutines(uint32_t shaderStage, const std::v
 			WARN("loadUniformSubroutines: There is no active shader.");
 		} else {
 			applyChanges();
-			glUniformSubroutinesuiv(shaderStage, indices.size(), static_cast<const GLuint*>(indices.data()));
-			GET_GL_ERROR();
+			// the shader re-loads its selection when it is bound, so unchanged indices need no upload
+			if(getActiveShader()->_selectSubroutines(shaderStage, indices)) {
+				glUniformSubroutinesuiv(shaderStage, indices.size(), static_cast<const GLuint*>(indices.data()));
+				GET_GL_ERROR();
+			}
 		}
 	#else
 		WARN("loadUniformSubroutines: Uniform subroutines are not supported.");
@@ -1080,9 +1668,10 @@ void RenderingContext::loadUniformSubroutines(uint32_t shaderStage, const std::v
 	if(!shader) {
 		WARN("loadUniformSubroutines: There is no active shader.");
 	} else {
-		std::vector<uint32_t> indices;
+		static std::vector<uint32_t> indices; // reused to avoid an allocation per call
+		indices.clear();
 		for(const auto& name : names)
-			indices.emplace_back(shader->getSubroutineIndex(shaderStage, name));
+			indices.emplace_back(static_cast<uint32_t>(shader->getSubroutineIndex(shaderStage, name)));
 		loadUniformSubroutines(shaderStage, indices);
 	}
 }
@@ -1148,13 +1737,40 @@ void RenderingContext::setTexture(uint8_t unit, Texture * texture, TexUnitUsageP
 		applyChanges();
 }
 
+uint64_t RenderingContext::makeTextureResident(Texture * texture) {
+	if(texture == nullptr || !Texture::isBindlessSupported())
+		return 0;
+	texture->_setBindlessResident(*this, true);
+	if(!texture->isBindlessResident())
+		return 0;
+	internalData->residentTextures[texture] = texture;
+	return texture->getBindlessHandle(*this);
+}
+
+void RenderingContext::makeTextureNonResident(Texture * texture) {
+	const auto it = internalData->residentTextures.find(texture);
+	if(it == internalData->residentTextures.end())
+		return;
+	texture->_setBindlessResident(*this, false);
+	internalData->residentTextures.erase(it);
+}
+
+void RenderingContext::makeAllTexturesNonResident() {
+	for(auto & entry : internalData->residentTextures)
+		entry.second->_setBindlessResident(*this, false);
+	internalData->residentTextures.clear();
+}
+
+uint32_t RenderingContext::getNumResidentTextures() const {
+	return static_cast<uint32_t>(internalData->residentTextures.size());
+}
+
 // TRANSFORM FEEDBACK ************************************************************************
 
 //! (static)
 bool RenderingContext::isTransformFeedbackSupported(){
 #if defined(GL_EXT_transform_feedback)
-	static const bool support = isExtensionSupported("GL_EXT_transform_feedback");
-	return support;
+	return Capabilities::get().transformFeedback;
 #else
 	return false;
 #endif
@@ -1273,6 +1889,65 @@ const Geometry::Matrix4x4 & RenderingContext::getMatrix_cameraToClipping() const
 	return internalData->targetRenderingStatus.getMatrix_cameraToClipping();
 }
 
+// MULTIVIEW ************************************************************************************
+
+//! (static)
+uint32_t RenderingContext::getMaxMultiviewCount() {
+#if defined(LIB_GL) && defined(GL_OVR_multiview)
+	if(FBO::isMultiviewSupported()) {
+		static const uint32_t maxViews = [](){
+			GLint value = 0;
+			glGetIntegerv(GL_MAX_VIEWS_OVR, &value);
+			return static_cast<uint32_t>(std::max(value, 0));
+		}();
+		return maxViews;
+	}
+#endif
+	return 0;
+}
+
+void RenderingContext::setMultiviewMatrices(const std::vector<Geometry::Matrix4x4> & worldToCamera, const std::vector<Geometry::Matrix4x4> & cameraToClipping) {
+	if(worldToCamera.size() != cameraToClipping.size() || worldToCamera.empty() || worldToCamera.size() > getMaxMultiviewCount())
+		throw std::invalid_argument("RenderingContext::setMultiviewMatrices: invalid number of views.");
+	std::vector<Geometry::Matrix4x4> matrices;
+	matrices.reserve(worldToCamera.size());
+	for(size_t i = 0; i < worldToCamera.size(); ++i)
+		matrices.emplace_back(cameraToClipping[i] * worldToCamera[i]);
+	internalData->targetRenderingStatus.setMultiviewMatrices(matrices);
+	if(immediate)
+		applyChanges();
+}
+
+void RenderingContext::disableMultiview() {
+	if(!internalData->targetRenderingStatus.isMultiviewEnabled())
+		return;
+	internalData->targetRenderingStatus.setMultiviewMatrices(std::vector<Geometry::Matrix4x4>());
+	if(immediate)
+		applyChanges();
+}
+
+bool RenderingContext::isMultiviewEnabled() const {
+	return internalData->targetRenderingStatus.isMultiviewEnabled();
+}
+
+const std::vector<Geometry::Matrix4x4> & RenderingContext::getMultiviewMatrices() const {
+	return internalData->targetRenderingStatus.getMultiviewMatrices();
+}
+
+//! (static)
+std::string RenderingContext::getMultiviewShaderInterface(uint32_t numViews) {
+	std::ostringstream s;
+	s << "#extension GL_OVR_multiview : require\n";
+	s << "layout(num_views = " << numViews << ") in;\n";
+	s << "uniform mat4 sg_multiview_worldToClipping[" << numViews << "];\n";
+	s << "uniform mat4 sg_multiview_modelToClipping[" << numViews << "];\n";
+	s << "uniform int sg_multiviewCount;\n";
+	s << "vec4 sg_multiviewPosition(in vec4 modelPos) {\n";
+	s << "\treturn sg_multiview_modelToClipping[gl_ViewID_OVR] * modelPos;\n";
+	s << "}\n";
+	return s.str();
+}
+
 // CAMERA MATRIX *****************************************************************************
 
 void RenderingContext::setMatrix_cameraToWorld(const Geometry::Matrix4x4 & matrix) {
@@ -1339,6 +2014,10 @@ const MaterialParameters & RenderingContext::getMaterial() const {
 	return internalData->targetRenderingStatus.getMaterialParameters();
 }
 
+bool RenderingContext::isMaterialEnabled() const {
+	return internalData->targetRenderingStatus.isMaterialEnabled();
+}
+
 void RenderingContext::popMaterial() {
 	if(internalData->materialStack.empty()) {
 		WARN("RenderingContext.popMaterial: stack empty, ignoring call");
@@ -1398,6 +2077,62 @@ void RenderingContext::popViewport() {
 void RenderingContext::pushViewport() {
 	internalData->viewportStack.emplace(internalData->currentViewport);
 }
+
+// STATE FRAME *******************************************************************************
+
+void RenderingContext::pushStateFrame() {
+	internalData->stateFrameStack.emplace();
+	InternalData::StateFrame & frame = internalData->stateFrameStack.top();
+	const CoreRenderingStatus & core = internalData->actualCoreRenderingStatus;
+	frame.alphaTest = core.getAlphaTestParameters();
+	frame.blending = core.getBlendingParameters();
+	frame.colorBuffer = core.getColorBufferParameters();
+	frame.cullFace = core.getCullFaceParameters();
+	frame.depthBuffer = core.getDepthBufferParameters();
+	frame.lighting = core.getLightingParameters();
+	frame.line = core.getLineParameters();
+	frame.point = internalData->targetRenderingStatus.getPointParameters();
+	frame.polygonMode = core.getPolygonModeParameters();
+	frame.polygonOffset = core.getPolygonOffsetParameters();
+	frame.scissor = getScissor();
+	frame.stencil = core.getStencilParameters();
+	frame.viewport = internalData->currentViewport;
+	frame.modelToCamera = internalData->targetRenderingStatus.getMatrix_modelToCamera();
+	frame.cameraToClipping = internalData->targetRenderingStatus.getMatrix_cameraToClipping();
+}
+
+void RenderingContext::popStateFrame() {
+	if(internalData->stateFrameStack.empty()) {
+		WARN("popStateFrame: Empty state frame stack");
+		return;
+	}
+	const InternalData::StateFrame & frame = internalData->stateFrameStack.top();
+
+	// restore all groups first and apply them with a single call
+	const bool wasImmediate = immediate;
+	immediate = false;
+	setAlphaTest(frame.alphaTest);
+	setBlending(frame.blending);
+	setColorBuffer(frame.colorBuffer);
+	setCullFace(frame.cullFace);
+	setDepthBuffer(frame.depthBuffer);
+	setLighting(frame.lighting);
+	setLine(frame.line);
+	setPointParameters(frame.point);
+	setPolygonMode(frame.polygonMode);
+	setPolygonOffset(frame.polygonOffset);
+	setScissor(frame.scissor);
+	setStencil(frame.stencil);
+	if(!(frame.viewport == internalData->currentViewport))
+		setViewport(frame.viewport);
+	setMatrix_modelToCamera(frame.modelToCamera);
+	setMatrix_cameraToClipping(frame.cameraToClipping);
+	immediate = wasImmediate;
+
+	internalData->stateFrameStack.pop();
+	if(immediate)
+		applyChanges();
+}
 void RenderingContext::setViewport(const Geometry::Rect_i & viewport) {
 	internalData->currentViewport = viewport;
 	glViewport(internalData->currentViewport.getX(), internalData->currentViewport.getY(), internalData->currentViewport.getWidth(), internalData->currentViewport.getHeight());
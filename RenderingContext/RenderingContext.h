@@ -13,8 +13,10 @@
 #define RENDERING_RENDERINCONTEXT_H_
 
 #include <Util/CountedObjectWrapper.h>
+#include <Util/References.h>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <functional>
 #include <vector>
 
@@ -37,6 +39,9 @@ class ColorBufferParameters;
 class CullFaceParameters;
 class DepthBufferParameters;
 class FBO;
+class DrawCommandList;
+class FrameProfiler;
+class GlobalUniformBlock;
 class ImageBindParameters;
 class LightParameters;
 class LightingParameters;
@@ -46,6 +51,7 @@ class Mesh;
 class PointParameters;
 class PolygonModeParameters;
 class PolygonOffsetParameters;
+class QueryObject;
 class ScissorParameters;
 class StencilParameters;
 class Shader;
@@ -67,7 +73,8 @@ private:
 	std::unique_ptr<InternalData> internalData;
 
 	bool immediate;
-	static bool compabilityMode;
+	//! Profile of the GL context that was current on this thread when initGLState() was called.
+	static thread_local bool compabilityMode;
 
 public:
 
@@ -89,11 +96,136 @@ public:
 	bool getImmediateMode() const {
 		return immediate;
 	}
+	//! \note Refers to the GL context of the calling thread (see initGLState()).
 	static bool getCompabilityMode() {
 		return compabilityMode;
 	}
 
+	/*! (internal) Helper meshes (e.g. of the Draw functions) are stored per rendering context, as vertex array
+		objects and (unshared) buffers cannot be used in other GL contexts.
+		A slot is allocated once per helper (thread-safe); the returned reference stays valid for the lifetime
+		of the context.
+		\code
+			static const uint32_t meshSlot = RenderingContext::_createHelperMeshSlot();
+			Util::Reference<Mesh> & mesh = rc._getHelperMesh(meshSlot);
+			if(mesh.isNull())
+				mesh = ...;
+		\endcode	*/
+	static uint32_t _createHelperMeshSlot();
+	Util::Reference<Mesh> & _getHelperMesh(uint32_t slot);
+
 	void applyChanges(bool forced = false);
+
+	/*! Number of core state groups (blending, depth buffer, textures, ...) that applyChanges() did not have to
+		compare, because they were not changed since the preceding call. Accumulates until reset. */
+	uint32_t getSkippedStateGroupCount() const;
+	void resetSkippedStateGroupCount();
+
+	/*! Cheap counters of the rendering work issued since the last call to resetFrameCounters().
+		\note The counters are shared by all contexts of the process, as buffer uploads and creations
+			are issued without a context. Call resetFrameCounters() at the beginning of each frame. */
+	struct FrameCounters {
+		uint32_t drawCalls;				//!< Meshes drawn (each instanced or multi draw counts once)
+		uint64_t primitives;			//!< Primitives submitted (see Mesh::getPrimitiveCount)
+		uint32_t appliedStateGroups;	//!< Core state groups compared and applied by applyChanges()
+		uint32_t shaderChanges;			//!< Programs made active
+		uint32_t textureBinds;			//!< Textures bound or unbound when applying the texture units
+		uint32_t uniformUploads;		//!< Uniform values transferred to a program
+		uint64_t bufferBytesUploaded;	//!< Bytes transferred by BufferObject::uploadData/uploadSubData
+		uint32_t buffersCreated;		//!< Buffer objects created
+		uint32_t texturesCreated;		//!< Texture objects created
+		uint32_t pendingShaderDraws;	//!< Meshes skipped or drawn with the fallback shader, because the active shader was not ready
+
+		FrameCounters() : drawCalls(0), primitives(0), appliedStateGroups(0), shaderChanges(0), textureBinds(0),
+				uniformUploads(0), bufferBytesUploaded(0), buffersCreated(0), texturesCreated(0), pendingShaderDraws(0) {
+		}
+	};
+	const FrameCounters & getFrameCounters() const	{	return _getFrameCounters();	}
+	void resetFrameCounters()						{	_getFrameCounters() = FrameCounters();	}
+
+	//! (internal, static) Counters incremented by the rendering classes.
+	static FrameCounters & _getFrameCounters();
+	//	@}
+
+	// -----------------------------------
+
+	/*!	@name Draw command recording
+		While recording, displayMesh(...) does not draw, but stores a draw command containing the mesh, the shader,
+		a snapshot of the shader independent and shader dependent state (including matrices, material, lights and
+		textures) and the uniforms changed since the recording started. On flushing, the commands are sorted by
+		shader, textures and mesh (commands with blending keep their order and are drawn last) and are submitted
+		using the DisplayMeshFn that was set before the recording started.
+		\note The FBO, viewport, scissor, clip planes and bound images are not part of the snapshot and must not be
+			changed while recording.	*/
+	//	@{
+	struct DrawCommandStatistics {
+		uint32_t numCommands;
+		uint32_t shaderChangesRecorded;		//!< Number of shader changes in the recorded order
+		uint32_t shaderChangesSubmitted;	//!< Number of shader changes in the submitted order
+		uint32_t textureChangesRecorded;
+		uint32_t textureChangesSubmitted;
+		uint32_t meshChangesRecorded;
+		uint32_t meshChangesSubmitted;
+
+		DrawCommandStatistics() : numCommands(0), shaderChangesRecorded(0), shaderChangesSubmitted(0),
+				textureChangesRecorded(0), textureChangesSubmitted(0), meshChangesRecorded(0), meshChangesSubmitted(0) {}
+		uint32_t getStateChangesRecorded() const	{	return shaderChangesRecorded + textureChangesRecorded + meshChangesRecorded;	}
+		uint32_t getStateChangesSubmitted() const	{	return shaderChangesSubmitted + textureChangesSubmitted + meshChangesSubmitted;	}
+	};
+
+	void startDrawCommandRecording();
+	bool isRecordingDrawCommands() const;
+
+	//! Stop the recording and submit all recorded draw commands.
+	DrawCommandStatistics flushDrawCommands();
+
+	/*! Store a snapshot of the current state (like a recorded draw command: the shader and the shader independent
+		and dependent state including camera, material, lights and textures) for use by DrawCommandLists.
+		The handle stays valid until clearStateBlocks() is called.	*/
+	uint32_t createStateBlock();
+	void clearStateBlocks();
+	/*! Merge and execute command lists recorded by other threads. The commands are sorted like recorded draw
+		commands (commands whose state block enables blending keep the order of the lists and are drawn last).
+		The modelToCamera matrix of a command is the state block's worldToCamera matrix multiplied by the
+		command's modelToWorld matrix. Afterwards, the previous state is restored.	*/
+	DrawCommandStatistics submitCommandLists(const std::vector<const DrawCommandList *> & lists);
+	//	@}
+
+	// -----------------------------------
+
+	/*!	@name Profiling
+		The frame profiler used by ProfileScope; nullptr disables the profiling scopes. */
+	//	@{
+	void setFrameProfiler(FrameProfiler * profiler);
+	FrameProfiler * getFrameProfiler() const;
+	//	@}
+
+	// -----------------------------------
+
+	/*!	@name Frame pacing
+		The common notion of the GPU frame boundary: endFrame() inserts a fence (GL_ARB_sync) after the frame's
+		commands; beginFrame() waits until at most getMaxFramesInFlight() - 1 earlier frames are still executed
+		on the GPU. Resources that are written by the CPU and read by the GPU (ring buffers, query pools, readbacks)
+		can use getFrameIndex() to select the part that is not used by a frame in flight.
+		The number of frames in flight is the latency-vs-throughput setting: 1 gives the lowest input latency
+		(the CPU waits for the previous frame to finish), 2 or 3 let CPU and GPU work in parallel.
+		\note Unlike finish(), waiting only blocks until an older frame has finished.	*/
+	//	@{
+	void beginFrame();
+	void endFrame();
+	//! Number of the current frame (incremented by beginFrame()).
+	uint64_t getFrameNumber() const;
+	//! The current frame number modulo the maximal number of frames in flight.
+	uint32_t getFrameIndex() const;
+	//! Number of the latest frame whose commands are known to be completed on the GPU (0 if there is none).
+	uint64_t getCompletedFrameNumber() const;
+	//! Check without waiting whether the commands of the given frame have been completed on the GPU.
+	bool isFrameCompleted(uint64_t frameNumber);
+	//! @p frames is clamped to [1, 8]; the default is 2.
+	void setMaxFramesInFlight(uint32_t frames);
+	uint32_t getMaxFramesInFlight() const;
+	//! CPU time in milliseconds the last beginFrame() waited for the GPU.
+	double getFrameWaitTime() const;
 	//	@}
 
 	// -----------------------------------
@@ -113,6 +245,11 @@ public:
 	*/
 	static bool useAMDAttrBugWorkaround();
 
+	/*! (internal) Bind the vertex array object created by initGLState() for the core profile.
+		Used to leave a cached vertex array object (@see VertexArrayObjectCache) so that
+		vertex attribute changes do not modify its state. */
+	static void _bindDefaultVertexArrayObject();
+
 	/**
 	 * Flush the GL commands buffer.
 	 * @see glFlush
@@ -133,6 +270,17 @@ public:
 	
 	// @}
 
+	//! @name State frames
+	//	@{
+	/*! Save the alphaTest, blending, colorBuffer, cullFace, depthBuffer, lighting, line, point, polygonMode,
+		polygonOffset, scissor and stencil parameters, the viewport and both matrices in one operation.
+		popStateFrame() restores all of them and applies the changes at once, which is cheaper than a sequence of
+		individual push and pop calls (e.g. for each node of a scene graph traversal).
+		\note The individual parameter stacks are not affected. */
+	void pushStateFrame();
+	void popStateFrame();
+	//	@}
+
 	// --------------------------------------------------------------------
 	// --------------------------------------------------------------------
 	// Parameters (sorted alphabetically)
@@ -148,7 +296,8 @@ public:
 	
 	// ------
 
-	//! @name Atomic counters (extension ARB_shader_atomic_counters)
+	/*! @name Atomic counters (extension ARB_shader_atomic_counters)
+		\note AtomicCounterBuffer provides counters without a buffer texture, including clearing and asynchronous readback. */
 	//	@{
 	static bool isAtomicCountersSupported();
 	static uint32_t getMaxAtomicCounterBuffers();
@@ -205,6 +354,36 @@ public:
 	// @}
 	// ------
 
+	//! @name Conditional Rendering
+	//	@{
+	enum conditionalRenderMode_t : uint8_t {
+		CONDITIONAL_RENDER_WAIT,				//!< wait for the result of the query
+		CONDITIONAL_RENDER_NO_WAIT,				//!< render if the result is not available yet
+		CONDITIONAL_RENDER_BY_REGION_WAIT,		//!< like CONDITIONAL_RENDER_WAIT, but the GPU may evaluate the result per screen region
+		CONDITIONAL_RENDER_BY_REGION_NO_WAIT	//!< like CONDITIONAL_RENDER_NO_WAIT, but the GPU may evaluate the result per screen region
+	};
+	static bool isConditionalRenderSupported();
+
+	/*! Let the GPU discard the following rendering commands if no samples passed the given occlusion query
+		(or, if @p inverted, if any samples passed). The result never reaches the CPU, so the query can be used
+		in the same frame it was issued, e.g. with a drawFastAbsBox() proxy:
+		\code
+		OcclusionQuery::enableTestMode(rc);
+		query.begin(); drawFastAbsBox(rc, box); query.end();
+		OcclusionQuery::disableTestMode(rc);
+		rc.beginConditionalRender(query);
+		rc.displayMesh(mesh);
+		rc.endConditionalRender();
+		\endcode
+		If conditional rendering (or the inverted mode) is not supported, the commands are always executed.
+		\note Conditional rendering can not be nested; the query must not be active. */
+	void beginConditionalRender(const QueryObject & query, conditionalRenderMode_t mode = CONDITIONAL_RENDER_NO_WAIT, bool inverted = false);
+	void endConditionalRender();
+	bool isConditionalRenderActive() const;
+	// @}
+
+	// ------
+
 	//! @name CullFace
 	//	@{
 	const CullFaceParameters & getCullFaceParameters() const;
@@ -233,6 +412,12 @@ public:
 	 * @see Parameter GL_DEPTH_BUFFER_BIT of glClear
 	 */
 	void clearDepth(float clearValue);
+
+	/*! Enable the position-only pass mode (e.g. while rendering shadow maps or a depth prepass).
+		In this mode, meshes using a PositionStreamMeshDataStrategy are drawn from their position-only vertex
+		buffers if the active shader uses no vertex attribute other than sg_Position. */
+	void setPositionOnlyPass(bool enable);
+	bool isPositionOnlyPass() const;
 	// @}
 
 	// ------
@@ -252,6 +437,22 @@ public:
 	//	@{
 	void setGlobalUniform(const Uniform & u);
 	const Uniform & getGlobalUniform(const Util::StringIdentifier & uniformName);
+
+	/*! Store the camera matrices (sg_matrix_worldToCamera, sg_matrix_cameraToWorld, sg_matrix_cameraToClipping,
+		sg_matrix_clippingToCamera) and the given global uniforms in a uniform buffer (std140) that is bound to
+		all shaders declaring the block (see GlobalUniformBlock::getDeclaration()). The values of @p members
+		are used as initial values.
+		Changes of these uniforms are written into the buffer once when the changes are applied,
+		instead of being transferred to each shader individually.
+		\note Shaders that do not declare the block do not receive the global uniforms that are members of the block.
+		\note Changes of block members are not recorded by startDrawCommandRecording().	*/
+	void enableGlobalUniformBlock(const std::vector<Uniform> & members, uint32_t binding = 0);
+	void disableGlobalUniformBlock();
+	//! Returns nullptr if the global uniform block is disabled.
+	const GlobalUniformBlock * getGlobalUniformBlock() const;
+private:
+	void updateGlobalUniformBlock(bool forced);
+public:
 	// @}
 
 	// ------
@@ -315,6 +516,8 @@ public:
 	//	@{
 	//! Return the active material.
 	const MaterialParameters & getMaterial() const;
+	//! Return true iff a material is active.
+	bool isMaterialEnabled() const;
 	//! Pop a material from the top of the stack and activate it. Deactivate material usage if stack is empty.
 	void popMaterial();
 	//! Push the given material onto the material stack.
@@ -362,6 +565,34 @@ public:
 	void popMatrix_cameraToClipping();										//! formerly known as popProjectionMatrix
 	void setMatrix_cameraToClipping(const Geometry::Matrix4x4 & matrix);	//! formerly known as setProjectionMatrix
 	// @}
+
+	// ------
+
+	/*! @name Multiview (stereo rendering)
+		With GL_OVR_multiview, a single draw call is broadcast to all views of a layered framebuffer attachment
+		(see FBO::attachMultiviewTexture()). While multiview is enabled, the sg-uniforms additionally contain
+		sg_multiview_worldToClipping[] (per view), sg_multiview_modelToClipping[] (per view, updated with the
+		modelToCamera matrix) and sg_multiviewCount; a vertex shader selects its matrix by gl_ViewID_OVR.
+		The regular camera matrices are still used for everything that is not view dependent (e.g. lighting).
+		\code
+			context.setMultiviewMatrices({leftWorldToCamera, rightWorldToCamera}, {leftProjection, rightProjection});
+			fbo->beginPass(context);
+			context.displayMesh(mesh);	// renders both eyes
+			fbo->endPass(context);
+			context.disableMultiview();
+		\endcode	*/
+	//	@{
+	/*! Enable multiview rendering with one view per matrix pair.
+		@throw std::invalid_argument if the numbers of matrices differ or are not in [1, getMaxMultiviewCount()]. */
+	void setMultiviewMatrices(const std::vector<Geometry::Matrix4x4> & worldToCamera, const std::vector<Geometry::Matrix4x4> & cameraToClipping);
+	void disableMultiview();
+	bool isMultiviewEnabled() const;
+	//! The worldToClipping matrix of each view; empty if multiview is disabled.
+	const std::vector<Geometry::Matrix4x4> & getMultiviewMatrices() const;
+	static uint32_t getMaxMultiviewCount();
+	//! GLSL declarations for a vertex shader: layout(num_views), the sg_multiview uniforms and sg_multiviewPosition(vec4 modelPos).
+	static std::string getMultiviewShaderInterface(uint32_t numViews = 2);
+	// @}
 	
 	// ------
 
@@ -415,6 +646,16 @@ public:
 	//! (internal) called by Shader::setUniform(...)
 	void _setUniformOnShader(Shader * shader, const Uniform & uniform, bool warnIfUnused, bool forced);
 
+	/*! A shader that is still compiling (see Shader::initAsync()) can be set like any other shader; it is bound
+		by applyChanges() as soon as it is ready. Until then, meshes are drawn using the fallback shader
+		or, if no fallback is set (default), they are skipped.
+		\note The fallback shader should be ready (i.e. not PENDING).	*/
+	void setPendingShaderFallback(Shader * shader);
+	Shader * getPendingShaderFallback() const;
+
+	//! Returns true if the active shader is still compiling. Call applyChanges() before to check if it has finished.
+	bool isActiveShaderPending() const;
+
 	// @}
 
 	// ------
@@ -464,6 +705,14 @@ public:
 	//! \note texture may be nullptr
 	void setTexture(uint8_t unit, Texture * texture); // default: usage = TexUnitUsageParameter::TEXTURE_MAPPING);
 	void setTexture(uint8_t unit, Texture * texture, TexUnitUsageParameter usage);
+
+	/*! Make the bindless handle of the texture resident and return it (0 if bindless textures are not supported).
+		The handle can be passed to shaders (e.g. using a BindlessTextureTable) without binding the texture to a unit.
+		The context keeps a reference to each resident texture until it is made non-resident.	*/
+	uint64_t makeTextureResident(Texture * texture);
+	void makeTextureNonResident(Texture * texture);
+	void makeAllTexturesNonResident();
+	uint32_t getNumResidentTextures() const;
 	// @}
 	
 	// ------
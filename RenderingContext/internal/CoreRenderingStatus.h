@@ -11,6 +11,7 @@
 #ifndef CORE_RENDERING_DATA_H_
 #define CORE_RENDERING_DATA_H_
 
+#include "StateBlockCache.h"
 #include "../RenderingParameters.h"
 #include "../../Texture/Texture.h"
 #include <Util/References.h>
@@ -22,22 +23,28 @@ namespace Rendering {
 class CoreRenderingStatus {
 	//!	@name Construction
 	//	@{
+	private:
+		/*! Check numbers are drawn from a counter shared by all instances, so that equal check numbers always refer
+			to equal values, even if a status is restored from a copy (e.g. by a recorded draw command). */
+		static uint32_t createCheckNumber() {
+			static uint32_t counter = 0;
+			return ++counter;
+		}
 	public:
 		CoreRenderingStatus() :
 			alphaTestParameters(),
-			blendingCheckNumber(0),
-			blendingParameters(),
-			colorBufferParameters(), 
-			cullFaceParameters(),
-			depthBufferParameters(),
+			blending(StateBlockCache<BlendingParameters>::getDefault()),
+			colorBuffer(StateBlockCache<ColorBufferParameters>::getDefault()),
+			cullFace(StateBlockCache<CullFaceParameters>::getDefault()),
+			depthBuffer(StateBlockCache<DepthBufferParameters>::getDefault()),
 			lightingParameters(),
 			lineParameters(),
 			polygonModeParameters(),
 			polygonOffsetParameters(),
-			stencilCheckNumber(),
-			stencilParameters(),
+			stencil(StateBlockCache<StencilParameters>::getDefault()),
 			texturesCheckNumber(),
-			boundTextures() {
+			boundTextures(),
+			dirtyGroups(ALL_GROUPS) {
 		}
 	//	@}
 
@@ -56,6 +63,7 @@ class CoreRenderingStatus {
 		}
 		void setAlphaTestParameters(const AlphaTestParameters & p){
 			alphaTestParameters=p;
+			markDirty(GROUP_ALPHA_TEST);
 		}
 
 	//	@}
@@ -65,28 +73,22 @@ class CoreRenderingStatus {
 	//!	@name Blending
 	//	@{
 	private:
-		uint32_t blendingCheckNumber;
-		BlendingParameters blendingParameters;
+		const StateBlock<BlendingParameters> * blending;
 
 	public:
 		bool blendingParametersChanged(const CoreRenderingStatus & actual) const {
-			return (blendingCheckNumber == actual.blendingCheckNumber) ? false :
-					(blendingParameters != actual.blendingParameters);
+			return blending != actual.blending;
 		}
 		const BlendingParameters & getBlendingParameters() const {
-			return blendingParameters;
+			return blending->parameters;
 		}
 		void setBlendingParameters(const BlendingParameters & p) {
-			blendingParameters = p;
-			++blendingCheckNumber;
-		}
-		void updateBlendingParameters(const BlendingParameters & p,uint32_t _checkNumber) {
-			blendingParameters = p;
-			blendingCheckNumber = _checkNumber;
+			if(!(blending->parameters == p))
+				blending = StateBlockCache<BlendingParameters>::intern(p);
+			markDirty(GROUP_BLENDING);
 		}
 		void updateBlendingParameters(const CoreRenderingStatus & other) {
-			blendingParameters = other.blendingParameters;
-			blendingCheckNumber = other.blendingCheckNumber;
+			blending = other.blending;
 		}
 
 	//	@}
@@ -96,16 +98,21 @@ class CoreRenderingStatus {
 	//!	@name ColorBuffer
 	//	@{
 	private:
-		ColorBufferParameters colorBufferParameters;
+		const StateBlock<ColorBufferParameters> * colorBuffer;
 	public:
 		bool colorBufferParametersChanged(const CoreRenderingStatus & actual) const {
-			return colorBufferParameters != actual.colorBufferParameters;
+			return colorBuffer != actual.colorBuffer;
 		}
 		const ColorBufferParameters & getColorBufferParameters() const {
-			return colorBufferParameters;
+			return colorBuffer->parameters;
 		}
 		void setColorBufferParameters(const ColorBufferParameters & p) {
-			colorBufferParameters = p;
+			if(!(colorBuffer->parameters == p))
+				colorBuffer = StateBlockCache<ColorBufferParameters>::intern(p);
+			markDirty(GROUP_COLOR_BUFFER);
+		}
+		void updateColorBufferParameters(const CoreRenderingStatus & other) {
+			colorBuffer = other.colorBuffer;
 		}
 	//	@}
 
@@ -114,16 +121,21 @@ class CoreRenderingStatus {
 	//!	@name CullFace
 	//	@{
 	private:
-		CullFaceParameters cullFaceParameters;
+		const StateBlock<CullFaceParameters> * cullFace;
 	public:
 		bool cullFaceParametersChanged(const CoreRenderingStatus & actual) const {
-			return cullFaceParameters!=actual.cullFaceParameters;
+			return cullFace != actual.cullFace;
 		}
 		const CullFaceParameters & getCullFaceParameters()const {
-			return cullFaceParameters;
+			return cullFace->parameters;
 		}
 		void setCullFaceParameters(const CullFaceParameters & p){
-			cullFaceParameters=p;
+			if(!(cullFace->parameters == p))
+				cullFace = StateBlockCache<CullFaceParameters>::intern(p);
+			markDirty(GROUP_CULL_FACE);
+		}
+		void updateCullFaceParameters(const CoreRenderingStatus & other) {
+			cullFace = other.cullFace;
 		}
 
 	//	@}
@@ -133,16 +145,21 @@ class CoreRenderingStatus {
 	//!	@name DepthBuffer
 	//	@{
 	private:
-		DepthBufferParameters depthBufferParameters;
+		const StateBlock<DepthBufferParameters> * depthBuffer;
 	public:
 		bool depthBufferParametersChanged(const CoreRenderingStatus & actual) const {
-			return depthBufferParameters != actual.depthBufferParameters;
+			return depthBuffer != actual.depthBuffer;
 		}
 		const DepthBufferParameters & getDepthBufferParameters() const {
-			return depthBufferParameters;
+			return depthBuffer->parameters;
 		}
 		void setDepthBufferParameters(const DepthBufferParameters & p) {
-			depthBufferParameters = p;
+			if(!(depthBuffer->parameters == p))
+				depthBuffer = StateBlockCache<DepthBufferParameters>::intern(p);
+			markDirty(GROUP_DEPTH_BUFFER);
+		}
+		void updateDepthBufferParameters(const CoreRenderingStatus & other) {
+			depthBuffer = other.depthBuffer;
 		}
 	//	@}
 
@@ -161,6 +178,7 @@ class CoreRenderingStatus {
 		}
 		void setLightingParameters(const LightingParameters & p) {
 			lightingParameters = p;
+			markDirty(GROUP_LIGHTING);
 		}
 	//	@}
 
@@ -179,6 +197,7 @@ class CoreRenderingStatus {
 		}
 		void setLineParameters(const LineParameters & p) {
 			lineParameters = p;
+			markDirty(GROUP_LINE);
 		}
 	//	@}
 
@@ -197,6 +216,7 @@ class CoreRenderingStatus {
 		}
 		void setPolygonModeParameters(const PolygonModeParameters & p){
 			polygonModeParameters=p;
+			markDirty(GROUP_POLYGON_MODE);
 		}
 
 	//	@}
@@ -216,6 +236,7 @@ class CoreRenderingStatus {
 		}
 		void setPolygonOffsetParameters(const PolygonOffsetParameters & p) {
 			polygonOffsetParameters = p;
+			markDirty(GROUP_POLYGON_OFFSET);
 		}
 	//	@}
 
@@ -224,27 +245,22 @@ class CoreRenderingStatus {
 	//!	@name Stencil
 	//	@{
 	private:
-		uint32_t stencilCheckNumber;
-		StencilParameters stencilParameters;
+		const StateBlock<StencilParameters> * stencil;
 
 	public:
 		bool stencilParametersChanged(const CoreRenderingStatus & actual) const {
-			return (stencilCheckNumber == actual.stencilCheckNumber) ? false : (stencilParameters != actual.stencilParameters);
+			return stencil != actual.stencil;
 		}
 		const StencilParameters & getStencilParameters() const {
-			return stencilParameters;
+			return stencil->parameters;
 		}
 		void setStencilParameters(const StencilParameters & p) {
-			stencilParameters = p;
-			++stencilCheckNumber;
-		}
-		void updateStencilParameters(const StencilParameters & p, uint32_t _checkNumber) {
-			stencilParameters = p;
-			stencilCheckNumber = _checkNumber;
+			if(!(stencil->parameters == p))
+				stencil = StateBlockCache<StencilParameters>::intern(p);
+			markDirty(GROUP_STENCIL);
 		}
 		void updateStencilParameters(const CoreRenderingStatus & other) {
-			stencilParameters = other.stencilParameters;
-			stencilCheckNumber = other.stencilCheckNumber;
+			stencil = other.stencil;
 		}
 	//	@}
 
@@ -256,8 +272,9 @@ class CoreRenderingStatus {
 
 	public:
 		void setTexture(uint8_t unit, Util::Reference<Texture> texture) {
-			++texturesCheckNumber;
+			texturesCheckNumber = createCheckNumber();
 			boundTextures.at(unit) = std::move(texture);
+			markDirty(GROUP_TEXTURES);
 		}
 		const Util::Reference<Texture> & getTexture(uint8_t unit) const {
 			return boundTextures.at(unit);
@@ -270,6 +287,52 @@ class CoreRenderingStatus {
 			texturesCheckNumber = actual.texturesCheckNumber;
 		}
 	//	@}
+
+	// ------
+
+	/*!	Key for sorting by the interned state blocks: commands with equal keys use the same depth buffer, cull face,
+		stencil and color buffer parameters. The ids are truncated to 16 bits, which only affects the sort quality.	*/
+	public:
+		uint64_t getStateBlockKey() const {
+			return	(static_cast<uint64_t>(depthBuffer->id & 0xffff) << 48) | (static_cast<uint64_t>(cullFace->id & 0xffff) << 32) |
+					(static_cast<uint64_t>(stencil->id & 0xffff) << 16) | static_cast<uint64_t>(colorBuffer->id & 0xffff);
+		}
+
+	// ------
+
+	/*!	@name Dirty groups
+		Each setter marks its parameter group as dirty. The status handler only compares and applies the groups that
+		have been marked since the last call to clearDirtyGroups(), so that a call to applyChanges() without any
+		intermediate state change is nearly free.	*/
+	//	@{
+	public:
+		enum group_t : uint32_t {
+			GROUP_ALPHA_TEST = 1 << 0,
+			GROUP_BLENDING = 1 << 1,
+			GROUP_COLOR_BUFFER = 1 << 2,
+			GROUP_CULL_FACE = 1 << 3,
+			GROUP_DEPTH_BUFFER = 1 << 4,
+			GROUP_LIGHTING = 1 << 5,
+			GROUP_LINE = 1 << 6,
+			GROUP_POLYGON_MODE = 1 << 7,
+			GROUP_POLYGON_OFFSET = 1 << 8,
+			GROUP_STENCIL = 1 << 9,
+			GROUP_TEXTURES = 1 << 10,
+			ALL_GROUPS = (1 << 11) - 1
+		};
+		static const uint8_t NUM_GROUPS = 11;
+
+	private:
+		uint32_t dirtyGroups;
+		void markDirty(group_t group)						{	dirtyGroups |= group;	}
+
+	public:
+		bool isDirty(group_t group) const					{	return (dirtyGroups & group) != 0;	}
+		bool hasDirtyGroups() const							{	return dirtyGroups != 0;	}
+		uint32_t getDirtyGroups() const						{	return dirtyGroups;	}
+		void clearDirtyGroups()								{	dirtyGroups = 0;	}
+		void markAllDirty()									{	dirtyGroups = ALL_GROUPS;	}
+	//	@}
 };
 
 }
@@ -0,0 +1,156 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2013 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2013 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2013 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "DrawCommandQueue.h"
+#include <Util/StringIdentifier.h>
+#include <algorithm>
+#include <unordered_set>
+
+namespace Rendering {
+
+//! (internal)
+static bool sameTextures(const DrawCommandQueue::Command & a, const DrawCommandQueue::Command & b) {
+	for(uint_fast8_t unit = 0; unit < MAX_TEXTURES; ++unit) {
+		if(a.coreStatus.getTexture(unit) != b.coreStatus.getTexture(unit))
+			return false;
+	}
+	return true;
+}
+
+//! (internal) Strict weak ordering by shader, textures, state blocks and mesh. Blending commands are placed behind all others.
+static bool submissionOrder(const DrawCommandQueue::Command & a, const DrawCommandQueue::Command & b) {
+	if(a.blended != b.blended)
+		return b.blended;
+	if(a.blended) // keep the order of transparent objects
+		return a.recordingIndex < b.recordingIndex;
+	if(a.shader != b.shader)
+		return a.shader.get() < b.shader.get();
+	for(uint_fast8_t unit = 0; unit < MAX_TEXTURES; ++unit) {
+		const Texture * ta = a.coreStatus.getTexture(unit).get();
+		const Texture * tb = b.coreStatus.getTexture(unit).get();
+		if(ta != tb)
+			return ta < tb;
+	}
+	if(a.stateBlockKey != b.stateBlockKey)
+		return a.stateBlockKey < b.stateBlockKey;
+	return a.mesh.get() < b.mesh.get();
+}
+
+//! (internal)
+static void countStateChanges(const std::vector<DrawCommandQueue::Command> & commands,
+							uint32_t & shaderChanges, uint32_t & textureChanges, uint32_t & meshChanges) {
+	shaderChanges = textureChanges = meshChanges = 0;
+	for(size_t i = 1; i < commands.size(); ++i) {
+		const auto & previous = commands[i - 1];
+		const auto & current = commands[i];
+		if(previous.shader != current.shader)
+			++shaderChanges;
+		if(!sameTextures(previous, current))
+			++textureChanges;
+		if(previous.mesh != current.mesh)
+			++meshChanges;
+	}
+}
+
+/*! (internal) Append the initial value of every uniform that is changed by any of the commands,
+	but not by the given one.	*/
+static void completeUniforms(std::vector<Uniform> & uniforms, const std::unordered_set<Util::StringIdentifier> & changedNames,
+							const std::vector<Uniform> & initialUniforms) {
+	if(uniforms.size() == changedNames.size())
+		return;
+	std::unordered_set<Util::StringIdentifier> present;
+	for(const auto & uniform : uniforms)
+		present.insert(uniform.getNameId());
+	for(const auto & uniform : initialUniforms) {
+		if(changedNames.count(uniform.getNameId()) > 0 && present.count(uniform.getNameId()) == 0)
+			uniforms.push_back(uniform);
+	}
+}
+
+void DrawCommandQueue::begin(const UniformRegistry & globalUniforms) {
+	commands.clear();
+	initialShaderUniforms.clear();
+	initialGlobalUniforms.clear();
+	globalUniforms.collectUniforms(initialGlobalUniforms);
+	stepOfRecordingStart = UniformRegistry::getCurrentGlobalStep();
+	recording = true;
+}
+
+void DrawCommandQueue::record(Mesh * mesh, uint32_t firstElement, uint32_t elementCount, Shader * shader,
+							const CoreRenderingStatus & coreStatus, const RenderingStatus & renderingStatus,
+							const UniformRegistry & globalUniforms) {
+	if(mesh == nullptr)
+		return;
+	commands.emplace_back();
+	Command & command = commands.back();
+	command.mesh = mesh;
+	command.firstElement = firstElement;
+	command.elementCount = elementCount;
+	command.shader = shader;
+	command.coreStatus = coreStatus;
+	command.renderingStatus = renderingStatus;
+	command.recordingIndex = static_cast<uint32_t>(commands.size() - 1);
+	command.stateBlockKey = coreStatus.getStateBlockKey();
+	command.blended = coreStatus.getBlendingParameters().isEnabled();
+	if(shader != nullptr) {
+		const UniformRegistry & shaderUniforms = *shader->_getUniformRegistry();
+		if(initialShaderUniforms.count(shader) == 0)
+			shaderUniforms.collectUniforms(initialShaderUniforms[shader]);
+		shaderUniforms.collectUniforms(command.uniforms, stepOfRecordingStart);
+	}
+	globalUniforms.collectUniforms(command.globalUniforms, stepOfRecordingStart);
+}
+
+std::vector<DrawCommandQueue::Command> DrawCommandQueue::finish(const UniformRegistry & globalUniforms,
+		shaderUniforms_t & finalShaderUniforms, std::vector<Uniform> & finalGlobalUniforms,
+		RenderingContext::DrawCommandStatistics & statistics) {
+	recording = false;
+	std::vector<Command> result;
+	result.swap(commands);
+
+	statistics = RenderingContext::DrawCommandStatistics();
+	statistics.numCommands = static_cast<uint32_t>(result.size());
+	countStateChanges(result, statistics.shaderChangesRecorded, statistics.textureChangesRecorded, statistics.meshChangesRecorded);
+
+	// complete the uniforms, so that the commands no longer depend on the recording order
+	std::unordered_map<Shader *, std::unordered_set<Util::StringIdentifier>> changedShaderUniforms;
+	std::unordered_set<Util::StringIdentifier> changedGlobalUniforms;
+	for(const auto & command : result) {
+		if(command.shader.isNotNull()) {
+			auto & names = changedShaderUniforms[command.shader.get()];
+			for(const auto & uniform : command.uniforms)
+				names.insert(uniform.getNameId());
+		}
+		for(const auto & uniform : command.globalUniforms)
+			changedGlobalUniforms.insert(uniform.getNameId());
+	}
+	for(auto & command : result) {
+		if(command.shader.isNotNull())
+			completeUniforms(command.uniforms, changedShaderUniforms[command.shader.get()], initialShaderUniforms[command.shader.get()]);
+		completeUniforms(command.globalUniforms, changedGlobalUniforms, initialGlobalUniforms);
+	}
+
+	// remember the values at the end of the recording
+	finalShaderUniforms.clear();
+	for(const auto & entry : initialShaderUniforms) {
+		finalShaderUniforms.emplace_back(entry.first, std::vector<Uniform>());
+		entry.first->_getUniformRegistry()->collectUniforms(finalShaderUniforms.back().second, stepOfRecordingStart);
+	}
+	finalGlobalUniforms.clear();
+	globalUniforms.collectUniforms(finalGlobalUniforms, stepOfRecordingStart);
+	initialShaderUniforms.clear();
+	initialGlobalUniforms.clear();
+
+	std::stable_sort(result.begin(), result.end(), submissionOrder);
+	countStateChanges(result, statistics.shaderChangesSubmitted, statistics.textureChangesSubmitted, statistics.meshChangesSubmitted);
+	return result;
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2013 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2013 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2013 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_DRAWCOMMANDQUEUE_H_
+#define RENDERING_DRAWCOMMANDQUEUE_H_
+
+#include "CoreRenderingStatus.h"
+#include "RenderingStatus.h"
+#include "../RenderingContext.h"
+#include "../../Mesh/Mesh.h"
+#include "../../Shader/Shader.h"
+#include "../../Shader/Uniform.h"
+#include "../../Shader/UniformRegistry.h"
+#include <Util/References.h>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Rendering {
+
+//! (internal) Used by the renderingContext to record draw commands and to submit them sorted by their state.
+class DrawCommandQueue {
+	public:
+		struct Command {
+			Util::Reference<Mesh> mesh;
+			uint32_t firstElement;
+			uint32_t elementCount;
+			Util::Reference<Shader> shader;
+			CoreRenderingStatus coreStatus;
+			RenderingStatus renderingStatus;
+			std::vector<Uniform> uniforms;			//!< uniforms of the shader that were changed while recording
+			std::vector<Uniform> globalUniforms;	//!< global uniforms that were changed while recording
+			uint32_t recordingIndex;
+			uint64_t stateBlockKey;					//!< CoreRenderingStatus::getStateBlockKey() of coreStatus
+			bool blended;							//!< blending is enabled in coreStatus
+		};
+
+		typedef std::vector<std::pair<Util::Reference<Shader>, std::vector<Uniform>>> shaderUniforms_t;
+
+	private:
+		std::vector<Command> commands;
+		bool recording;
+		UniformRegistry::step_t stepOfRecordingStart;
+
+		//! Uniform values before their first change while recording; used for commands recorded before that change.
+		std::vector<Uniform> initialGlobalUniforms;
+		std::unordered_map<Shader *, std::vector<Uniform>> initialShaderUniforms;
+
+	public:
+		DrawCommandQueue() : commands(), recording(false), stepOfRecordingStart(0) {}
+
+		bool isRecording() const						{	return recording;	}
+		uint32_t size() const							{	return static_cast<uint32_t>(commands.size());	}
+
+		void begin(const UniformRegistry & globalUniforms);
+
+		void record(Mesh * mesh, uint32_t firstElement, uint32_t elementCount, Shader * shader,
+					const CoreRenderingStatus & coreStatus, const RenderingStatus & renderingStatus,
+					const UniformRegistry & globalUniforms);
+
+		/*! Stop recording and return the commands in submission order.
+			Opaque commands are sorted by shader, textures, the remaining state blocks and mesh (the mesh owns the vertex buffer); commands with
+			enabled blending keep their recording order and are submitted afterwards.
+			The uniform lists of all commands are completed so that each command can be submitted independently.
+			@param finalShaderUniforms Receives the uniforms that have to be set after submission to restore the state
+				at the end of the recording.
+			@param finalGlobalUniforms See finalShaderUniforms.
+			@param statistics Receives the number of state changes	before and after sorting. */
+		std::vector<Command> finish(const UniformRegistry & globalUniforms, shaderUniforms_t & finalShaderUniforms,
+									std::vector<Uniform> & finalGlobalUniforms, RenderingContext::DrawCommandStatistics & statistics);
+};
+
+}
+
+#endif /* RENDERING_DRAWCOMMANDQUEUE_H_ */
@@ -18,6 +18,7 @@
 #include <bitset>
 #include <cassert>
 #include <deque>
+#include <utility>
 #include <vector>
 #include <cstdint>
 
@@ -30,6 +31,12 @@ class RenderingStatus {
 	//!	@name General
 	//	@{
 	private:
+		/*! Check numbers are drawn from a counter shared by all instances, so that equal check numbers always refer
+			to equal values, even if a status is restored from a copy (e.g. by a recorded draw command). */
+		static uint32_t createCheckNumber() {
+			static uint32_t counter = 0;
+			return ++counter;
+		}
 		Util::Reference<Shader> shader;
 		bool initialized;
 
@@ -51,8 +58,16 @@ class RenderingStatus {
 			pointParameters(),
 			matrix_cameraToClippingCheckNumber(0),
 			matrix_cameraToClipping(),
+			multiviewCheckNumber(0),
+			multiview_worldToClipping(),
 			textureUnitUsagesCheckNumber(0),
-			textureUnitParams(MAX_TEXTURES, std::make_pair(TexUnitUsageParameter::DISABLED,TextureType::TEXTURE_2D)) {
+			textureUnitParams(MAX_TEXTURES, std::make_pair(TexUnitUsageParameter::DISABLED,TextureType::TEXTURE_2D)),
+			modelToClippingSourceCheckNumbers(INVALID_CHECK_NUMBER, INVALID_CHECK_NUMBER),
+			matrix_modelToClipping(),
+			clippingToCameraSourceCheckNumber(INVALID_CHECK_NUMBER),
+			matrix_clippingToCamera(),
+			sgUniformUsage(0),
+			sgUniformUsageKnown(false) {
 		}
 		Shader * getShader() 						{	return shader.get();	}
 		bool isInitialized()const					{	return initialized;	}
@@ -77,7 +92,7 @@ class RenderingStatus {
 		void setMatrix_cameraToWorld(const Geometry::Matrix4x4f & eyeToWorld) {
 			matrix_cameraToWorld = eyeToWorld;
 			matrix_worldToCamera = eyeToWorld.inverse();
-			++checkNumber_matrixCameraWorld;
+			checkNumber_matrixCameraWorld = createCheckNumber();
 		}
 		void updateMatrix_cameraToWorld(const RenderingStatus & actual) {
 			matrix_cameraToWorld = actual.matrix_cameraToWorld;
@@ -129,7 +144,7 @@ class RenderingStatus {
 			while(lightsEnabled[pos]) {
 				++pos;
 			}
-			++lightsCheckNumber;
+			lightsCheckNumber = createCheckNumber();
 			lights[pos] = light;
 			lightsEnabled[pos] = true;
 			return pos;
@@ -137,7 +152,7 @@ class RenderingStatus {
 		//! Disable the light with the given number.
 		void disableLight(uint8_t lightNumber) {
 			assert(lightsEnabled[lightNumber]);
-			++lightsCheckNumber;
+			lightsCheckNumber = createCheckNumber();
 			lightsEnabled[lightNumber] = false;
 		}
 		//! Return @c true, if the light with the given light number is enabled.
@@ -185,7 +200,7 @@ class RenderingStatus {
 		void setMaterial(const MaterialParameters & mat) {
 			material = mat;
 			materialEnabled = true;
-			++materialCheckNumber;
+			materialCheckNumber = createCheckNumber();
 		}
 		void updateMaterial(const RenderingStatus & actual) {
 			materialEnabled=actual.materialEnabled;
@@ -194,7 +209,7 @@ class RenderingStatus {
 		}
 		void disableMaterial() {
 			materialEnabled = false;
-			++materialCheckNumber;
+			materialCheckNumber = createCheckNumber();
 		}
 	//	@}
 
@@ -210,7 +225,7 @@ class RenderingStatus {
 		const Geometry::Matrix4x4f & getMatrix_modelToCamera() const 				{	return matrix_modelToCamera;	}
 		void setMatrix_modelToCamera(const Geometry::Matrix4x4f & matrix) {
 			matrix_modelToCamera = matrix;
-			++matrix_modelToCameraCheckNumber;
+			matrix_modelToCameraCheckNumber = createCheckNumber();
 		}
 		bool matrix_modelToCameraChanged(const RenderingStatus & actual) const {
 			return (matrix_modelToCameraCheckNumber == actual.matrix_modelToCameraCheckNumber) ? false :
@@ -218,7 +233,7 @@ class RenderingStatus {
 		}
 		void multModelViewMatrix(const Geometry::Matrix4x4f & matrix) {
 			matrix_modelToCamera *= matrix;
-			++matrix_modelToCameraCheckNumber;
+			matrix_modelToCameraCheckNumber = createCheckNumber();
 		}
 		void updateModelViewMatrix(const RenderingStatus & actual) {
 			matrix_modelToCamera = actual.matrix_modelToCamera;
@@ -255,7 +270,7 @@ class RenderingStatus {
 	public:
 		void setMatrix_cameraToClipping(const Geometry::Matrix4x4f & matrix) {
 			matrix_cameraToClipping = matrix;
-			++matrix_cameraToClippingCheckNumber;
+			matrix_cameraToClippingCheckNumber = createCheckNumber();
 		}
 		const Geometry::Matrix4x4f & getMatrix_cameraToClipping() const 				{	return matrix_cameraToClipping;	}
 		void updateMatrix_cameraToClipping(const RenderingStatus & actual) {
@@ -270,6 +285,32 @@ class RenderingStatus {
 
 	// ------
 
+	/*!	@name Multiview
+		One worldToClipping matrix per view (e.g. per eye); empty if multiview rendering is disabled.	*/
+	//	@{
+	private:
+		uint32_t multiviewCheckNumber;
+		std::vector<Geometry::Matrix4x4f> multiview_worldToClipping;
+
+	public:
+		void setMultiviewMatrices(const std::vector<Geometry::Matrix4x4f> & matrices) {
+			multiview_worldToClipping = matrices;
+			multiviewCheckNumber = createCheckNumber();
+		}
+		const std::vector<Geometry::Matrix4x4f> & getMultiviewMatrices() const	{	return multiview_worldToClipping;	}
+		bool isMultiviewEnabled() const										{	return !multiview_worldToClipping.empty();	}
+		bool multiviewChanged(const RenderingStatus & actual) const {
+			return (multiviewCheckNumber == actual.multiviewCheckNumber) ? false :
+					multiview_worldToClipping != actual.multiview_worldToClipping;
+		}
+		void updateMultiview(const RenderingStatus & actual) {
+			multiview_worldToClipping = actual.multiview_worldToClipping;
+			multiviewCheckNumber = actual.multiviewCheckNumber;
+		}
+	//	@}
+
+	// ------
+
 	//!	@name Texture Units
 	//	@{
 	private:
@@ -278,7 +319,7 @@ class RenderingStatus {
 
 	public:
 		void setTextureUnitParams(uint8_t unit, TexUnitUsageParameter use, TextureType t ) {
-			++textureUnitUsagesCheckNumber;
+			textureUnitUsagesCheckNumber = createCheckNumber();
 			textureUnitParams.at(unit) = std::make_pair(use,t);
 		}
 		const std::pair<TexUnitUsageParameter,TextureType> & getTextureUnitParams(uint8_t unit) const {
@@ -292,7 +333,57 @@ class RenderingStatus {
 			textureUnitParams = actual.textureUnitParams;
 			textureUnitUsagesCheckNumber = actual.textureUnitUsagesCheckNumber;
 		}
+	//	@}
 
+	// ------
+
+	/*!	@name Derived matrices
+		The matrices are calculated on first access and cached until the check number of one of their source
+		matrices changes.	*/
+	//	@{
+	private:
+		static const uint32_t INVALID_CHECK_NUMBER = 0xffffffff;
+		mutable std::pair<uint32_t, uint32_t> modelToClippingSourceCheckNumbers; // cameraToClipping, modelToCamera
+		mutable Geometry::Matrix4x4f matrix_modelToClipping;
+		mutable uint32_t clippingToCameraSourceCheckNumber;
+		mutable Geometry::Matrix4x4f matrix_clippingToCamera;
+
+	public:
+		const Geometry::Matrix4x4f & getMatrix_modelToClipping() const {
+			const std::pair<uint32_t, uint32_t> sources(matrix_cameraToClippingCheckNumber, matrix_modelToCameraCheckNumber);
+			if(sources != modelToClippingSourceCheckNumbers) {
+				matrix_modelToClipping = matrix_cameraToClipping * matrix_modelToCamera;
+				modelToClippingSourceCheckNumbers = sources;
+			}
+			return matrix_modelToClipping;
+		}
+		const Geometry::Matrix4x4f & getMatrix_clippingToCamera() const {
+			if(clippingToCameraSourceCheckNumber != matrix_cameraToClippingCheckNumber) {
+				matrix_clippingToCamera = matrix_cameraToClipping.inverse();
+				clippingToCameraSourceCheckNumber = matrix_cameraToClippingCheckNumber;
+			}
+			return matrix_clippingToCamera;
+		}
+	//	@}
+
+	// ------
+
+	/*!	@name Uniform usage
+		Bit mask (defined by the StatusHandler_sgUniforms) of the groups of derived sg-uniforms used by the shader.
+		It is determined once the shader is linked; until then, all uniforms are considered as used.	*/
+	//	@{
+	private:
+		uint32_t sgUniformUsage;
+		bool sgUniformUsageKnown;
+
+	public:
+		bool isSGUniformUsageKnown() const			{	return sgUniformUsageKnown;	}
+		uint32_t getSGUniformUsage() const			{	return sgUniformUsage;	}
+		void setSGUniformUsage(uint32_t usage) {
+			sgUniformUsage = usage;
+			sgUniformUsageKnown = true;
+		}
+	//	@}
 };
 
 }
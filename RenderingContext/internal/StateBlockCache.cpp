@@ -0,0 +1,115 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2013 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2013 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2013 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "StateBlockCache.h"
+#include "../RenderingParameters.h"
+#include <Util/Graphics/Color.h>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Rendering {
+
+//! (internal)
+static inline void hashCombine(std::size_t & seed, std::size_t value) {
+	seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+//! (internal)
+static std::size_t hashParameters(const BlendingParameters & p) {
+	std::size_t seed = p.isEnabled() ? 1 : 0;
+	hashCombine(seed, static_cast<std::size_t>(p.getBlendFuncSrcRGB()));
+	hashCombine(seed, static_cast<std::size_t>(p.getBlendFuncDstRGB()));
+	hashCombine(seed, static_cast<std::size_t>(p.getBlendFuncSrcAlpha()));
+	hashCombine(seed, static_cast<std::size_t>(p.getBlendFuncDstAlpha()));
+	hashCombine(seed, static_cast<std::size_t>(p.getBlendEquationRGB()));
+	hashCombine(seed, static_cast<std::size_t>(p.getBlendEquationAlpha()));
+	const std::hash<float> floatHash;
+	hashCombine(seed, floatHash(p.getBlendColor().getR()));
+	hashCombine(seed, floatHash(p.getBlendColor().getG()));
+	hashCombine(seed, floatHash(p.getBlendColor().getB()));
+	hashCombine(seed, floatHash(p.getBlendColor().getA()));
+	return seed;
+}
+
+//! (internal)
+static std::size_t hashParameters(const ColorBufferParameters & p) {
+	return	(p.isRedWritingEnabled() ? 1 : 0) | (p.isGreenWritingEnabled() ? 2 : 0) |
+			(p.isBlueWritingEnabled() ? 4 : 0) | (p.isAlphaWritingEnabled() ? 8 : 0);
+}
+
+//! (internal)
+static std::size_t hashParameters(const CullFaceParameters & p) {
+	return (static_cast<std::size_t>(p.getMode()) << 1) | (p.isEnabled() ? 1 : 0);
+}
+
+//! (internal)
+static std::size_t hashParameters(const DepthBufferParameters & p) {
+	return	(static_cast<std::size_t>(p.getFunction()) << 2) | (p.isTestEnabled() ? 1 : 0) | (p.isWritingEnabled() ? 2 : 0);
+}
+
+//! (internal)
+static std::size_t hashParameters(const StencilParameters & p) {
+	std::size_t seed = p.isEnabled() ? 1 : 0;
+	hashCombine(seed, static_cast<std::size_t>(p.getFunction()));
+	hashCombine(seed, static_cast<std::size_t>(p.getReferenceValue()));
+	hashCombine(seed, static_cast<std::size_t>(p.getBitMask().to_ulong()));
+	hashCombine(seed, static_cast<std::size_t>(p.getFailAction()));
+	hashCombine(seed, static_cast<std::size_t>(p.getDepthTestFailAction()));
+	hashCombine(seed, static_cast<std::size_t>(p.getDepthTestPassAction()));
+	return seed;
+}
+
+//! (internal) The blocks of one parameter type, grouped by their hash value.
+template<typename params_t>
+struct StateBlockStorage {
+	std::unordered_map<std::size_t, std::vector<std::unique_ptr<StateBlock<params_t>>>> buckets;
+	uint32_t count = 0;
+
+	static StateBlockStorage & get() {
+		static StateBlockStorage storage;
+		return storage;
+	}
+};
+
+//! (static)
+template<typename params_t>
+const StateBlock<params_t> * StateBlockCache<params_t>::intern(const params_t & parameters) {
+	auto & storage = StateBlockStorage<params_t>::get();
+	auto & bucket = storage.buckets[hashParameters(parameters)];
+	for(const auto & block : bucket) {
+		if(block->parameters == parameters)
+			return block.get();
+	}
+	bucket.emplace_back(new StateBlock<params_t>(parameters, ++storage.count));
+	return bucket.back().get();
+}
+
+//! (static)
+template<typename params_t>
+const StateBlock<params_t> * StateBlockCache<params_t>::getDefault() {
+	static const StateBlock<params_t> * defaultBlock = intern(params_t());
+	return defaultBlock;
+}
+
+//! (static)
+template<typename params_t>
+std::size_t StateBlockCache<params_t>::size() {
+	return StateBlockStorage<params_t>::get().count;
+}
+
+template class StateBlockCache<BlendingParameters>;
+template class StateBlockCache<ColorBufferParameters>;
+template class StateBlockCache<CullFaceParameters>;
+template class StateBlockCache<DepthBufferParameters>;
+template class StateBlockCache<StencilParameters>;
+
+}
@@ -0,0 +1,49 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2013 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2013 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2013 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_STATEBLOCKCACHE_H_
+#define RENDERING_STATEBLOCKCACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Rendering {
+
+/*! (internal) Immutable, interned copy of a set of rendering parameters.
+	There is exactly one block for every distinct set of parameters, so that two blocks are equal if and only if they
+	are the same object. */
+template<typename params_t>
+struct StateBlock {
+	const params_t parameters;
+	const uint32_t id; //!< Unique among all blocks of the same type; starts with 1 and is used for sorting.
+
+	StateBlock(const params_t & p, uint32_t _id) : parameters(p), id(_id) {}
+};
+
+/*! (internal) Used by the CoreRenderingStatus to intern parameter sets.
+	The blocks are hashed by their values and are never released, as the number of distinct parameter sets used by an
+	application is small.
+	\note Not thread-safe; the cache is used only by the rendering thread.
+	\note Instantiated for BlendingParameters, ColorBufferParameters, CullFaceParameters, DepthBufferParameters and
+		StencilParameters. */
+template<typename params_t>
+class StateBlockCache {
+	public:
+		//! Return the block holding the given parameters; the block is created if necessary.
+		static const StateBlock<params_t> * intern(const params_t & parameters);
+		//! Return the block holding default-constructed parameters.
+		static const StateBlock<params_t> * getDefault();
+		//! Number of interned blocks.
+		static std::size_t size();
+};
+
+}
+
+#endif /* RENDERING_STATEBLOCKCACHE_H_ */
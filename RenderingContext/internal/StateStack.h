@@ -0,0 +1,49 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2013 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2013 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2013 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_STATESTACK_H_
+#define RENDERING_STATESTACK_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Rendering {
+
+/*! (internal) Stack used by the renderingContext to save and restore state groups.
+	In contrast to std::stack (which is based on a std::deque), the values are stored contiguously in a vector with
+	@p reservedCapacity pre-allocated entries. Popping never frees memory, so a balanced sequence of push and pop
+	operations only allocates if the stack grows beyond its largest size so far. */
+template<typename value_t, std::size_t reservedCapacity = 16>
+class StateStack {
+	private:
+		std::vector<value_t> values;
+	public:
+		StateStack() {
+			values.reserve(reservedCapacity);
+		}
+
+		bool empty() const					{	return values.empty();	}
+		std::size_t size() const			{	return values.size();	}
+		std::size_t capacity() const		{	return values.capacity();	}
+
+		value_t & top()						{	return values.back();	}
+		const value_t & top() const			{	return values.back();	}
+
+		void push(const value_t & value)	{	values.push_back(value);	}
+		void push(value_t && value)			{	values.push_back(std::move(value));	}
+		template<typename ... args_t>
+		void emplace(args_t && ... args)	{	values.emplace_back(std::forward<args_t>(args)...);	}
+		void pop()							{	values.pop_back();	}
+};
+
+}
+
+#endif /* RENDERING_STATESTACK_H_ */
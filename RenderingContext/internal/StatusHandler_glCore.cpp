@@ -13,8 +13,10 @@
 #include "../RenderingContext.h"
 #include "../../BufferObject.h"
 #include "../../GLHeader.h"
+#include "../../GLTrace.h"
 #include "../../Helper.h"
-
+#include <array>
+#include <bitset>
 #ifdef WIN32
 #include <GL/wglew.h>
 #endif
@@ -22,6 +24,47 @@
 namespace Rendering {
 namespace StatusHandler_glCore{
 
+#if defined(LIB_GL) && defined(GL_ARB_multi_bind)
+/*! (internal) Bind all changed texture units with a single call of glBindTextures.
+	The range between the first and the last changed unit is rebound; unchanged units in between get the same texture.	*/
+static void bindTexturesMulti(const CoreRenderingStatus & target, const CoreRenderingStatus & actual, bool forced) {
+	uint_fast8_t first = MAX_TEXTURES;
+	uint_fast8_t last = 0;
+	for(uint_fast8_t unit = 0; unit < MAX_TEXTURES; ++unit) {
+		if(forced || actual.getTexture(unit) != target.getTexture(unit)) {
+			if(first == MAX_TEXTURES)
+				first = unit;
+			last = unit;
+			++RenderingContext::_getFrameCounters().textureBinds;
+		}
+	}
+	if(first == MAX_TEXTURES)
+		return;
+
+	std::array<GLuint, MAX_TEXTURES> ids;
+	for(uint_fast8_t unit = first; unit <= last; ++unit) {
+		const auto & texture = actual.getTexture(unit);
+		ids[unit - first] = texture ? texture->_getGLIdForBinding() : 0; // 0 unbinds all targets of the unit
+	}
+	glBindTextures(static_cast<GLuint>(first), static_cast<GLsizei>(last - first + 1), ids.data());
+	if(GLTrace::isRecording()) {
+		std::vector<uint32_t> args(1, first);
+		args.insert(args.end(), ids.begin(), ids.begin() + (last - first + 1));
+		GLTrace::record(GLTrace::BIND_TEXTURES, args);
+	}
+
+	// buffer textures need their buffer to be attached
+	for(uint_fast8_t unit = first; unit <= last; ++unit) {
+		const auto & texture = actual.getTexture(unit);
+		if(texture && texture->getBufferObject() != nullptr && (forced || texture != target.getTexture(unit))) {
+			glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(unit));
+			RENDERING_GL_TRACE(ACTIVE_TEXTURE, {GL_TEXTURE0 + static_cast<GLenum>(unit)});
+			glTexBuffer(GL_TEXTURE_BUFFER, texture->getFormat().pixelFormat.glInternalFormat, texture->getBufferObject()->getGLId());
+			RENDERING_GL_TRACE(TEX_BUFFER, {texture->getFormat().pixelFormat.glInternalFormat, texture->getBufferObject()->getGLId()});
+		}
+	}
+}
+#endif
 static GLenum convertStencilAction(StencilParameters::action_t action) {
 	switch(action) {
 		case StencilParameters::KEEP:
@@ -46,16 +89,25 @@ static GLenum convertStencilAction(StencilParameters::action_t action) {
 	throw std::invalid_argument("Invalid StencilParameters::action_t enumerator");
 }
 
-void apply(CoreRenderingStatus & target, const CoreRenderingStatus & actual, bool forced) {
+uint8_t apply(CoreRenderingStatus & target, const CoreRenderingStatus & actual, bool forced) {
+	uint8_t skippedGroups = 0;
+	if(!forced) {
+		skippedGroups = CoreRenderingStatus::NUM_GROUPS - static_cast<uint8_t>(std::bitset<32>(actual.getDirtyGroups()).count());
+		if(!actual.hasDirtyGroups())
+			return skippedGroups;
+	}
+
 	// Blending
-	if(forced || target.blendingParametersChanged(actual)) {
+	if(forced || (actual.isDirty(CoreRenderingStatus::GROUP_BLENDING) && target.blendingParametersChanged(actual))) {
 		const BlendingParameters & targetParams = target.getBlendingParameters();
 		const BlendingParameters & actualParams = actual.getBlendingParameters();
 		if(forced || targetParams.isEnabled() != actualParams.isEnabled()) {
 			if(actualParams.isEnabled()) {
 				glEnable(GL_BLEND);
+				RENDERING_GL_TRACE(ENABLE, {GL_BLEND});
 			} else {
 				glDisable(GL_BLEND);
+				RENDERING_GL_TRACE(DISABLE, {GL_BLEND});
 			}
 		}
 		if(forced ||
@@ -67,100 +119,130 @@ void apply(CoreRenderingStatus & target, const CoreRenderingStatus & actual, boo
 								BlendingParameters::functionToGL(actualParams.getBlendFuncDstRGB()),
 								BlendingParameters::functionToGL(actualParams.getBlendFuncSrcAlpha()),
 								BlendingParameters::functionToGL(actualParams.getBlendFuncDstAlpha()));
+			RENDERING_GL_TRACE(BLEND_FUNC_SEPARATE, {BlendingParameters::functionToGL(actualParams.getBlendFuncSrcRGB()),
+												BlendingParameters::functionToGL(actualParams.getBlendFuncDstRGB()),
+												BlendingParameters::functionToGL(actualParams.getBlendFuncSrcAlpha()),
+												BlendingParameters::functionToGL(actualParams.getBlendFuncDstAlpha())});
 		}
 		if(forced || targetParams.getBlendColor() != actualParams.getBlendColor()) {
 			glBlendColor(actualParams.getBlendColor().getR(),
 						 actualParams.getBlendColor().getG(),
 						 actualParams.getBlendColor().getB(),
 						 actualParams.getBlendColor().getA());
+			RENDERING_GL_TRACE(BLEND_COLOR, {GLTrace::arg(actualParams.getBlendColor().getR()), GLTrace::arg(actualParams.getBlendColor().getG()),
+										GLTrace::arg(actualParams.getBlendColor().getB()), GLTrace::arg(actualParams.getBlendColor().getA())});
 		}
 		if(forced ||
 				targetParams.getBlendEquationRGB() != actualParams.getBlendEquationRGB() ||
 				targetParams.getBlendEquationAlpha() != actualParams.getBlendEquationAlpha()) {
 			glBlendEquationSeparate(BlendingParameters::equationToGL(actualParams.getBlendEquationRGB()),
 									BlendingParameters::equationToGL(actualParams.getBlendEquationAlpha()));
+			RENDERING_GL_TRACE(BLEND_EQUATION_SEPARATE, {BlendingParameters::equationToGL(actualParams.getBlendEquationRGB()),
+													BlendingParameters::equationToGL(actualParams.getBlendEquationAlpha())});
 		}
 		target.updateBlendingParameters(actual);
 	}
 
 	// ColorBuffer
-	if(forced || target.colorBufferParametersChanged(actual)) {
+	if(forced || (actual.isDirty(CoreRenderingStatus::GROUP_COLOR_BUFFER) && target.colorBufferParametersChanged(actual))) {
 		glColorMask(
 			actual.getColorBufferParameters().isRedWritingEnabled() ? GL_TRUE : GL_FALSE,
 			actual.getColorBufferParameters().isGreenWritingEnabled() ? GL_TRUE : GL_FALSE,
 			actual.getColorBufferParameters().isBlueWritingEnabled() ? GL_TRUE : GL_FALSE,
 			actual.getColorBufferParameters().isAlphaWritingEnabled() ? GL_TRUE : GL_FALSE
 		);
-		target.setColorBufferParameters(actual.getColorBufferParameters());
+		RENDERING_GL_TRACE(COLOR_MASK, {actual.getColorBufferParameters().isRedWritingEnabled() ? 1u : 0u,
+									actual.getColorBufferParameters().isGreenWritingEnabled() ? 1u : 0u,
+									actual.getColorBufferParameters().isBlueWritingEnabled() ? 1u : 0u,
+									actual.getColorBufferParameters().isAlphaWritingEnabled() ? 1u : 0u});
+		target.updateColorBufferParameters(actual);
 	}
 	GET_GL_ERROR();
 
 	// CullFace
-	if(forced || target.cullFaceParametersChanged(actual)) {
+	if(forced || (actual.isDirty(CoreRenderingStatus::GROUP_CULL_FACE) && target.cullFaceParametersChanged(actual))) {
 		if(actual.getCullFaceParameters().isEnabled()) {
 			glEnable(GL_CULL_FACE);
+			RENDERING_GL_TRACE(ENABLE, {GL_CULL_FACE});
 
 		} else {
 			glDisable(GL_CULL_FACE);
+			RENDERING_GL_TRACE(DISABLE, {GL_CULL_FACE});
 		}
 		switch(actual.getCullFaceParameters().getMode()) {
 			case CullFaceParameters::CULL_BACK:
 				glCullFace(GL_BACK);
+				RENDERING_GL_TRACE(CULL_FACE, {GL_BACK});
 				break;
 			case CullFaceParameters::CULL_FRONT:
 				glCullFace(GL_FRONT);
+				RENDERING_GL_TRACE(CULL_FACE, {GL_FRONT});
 				break;
 			case CullFaceParameters::CULL_FRONT_AND_BACK:
 				glCullFace(GL_FRONT_AND_BACK);
+				RENDERING_GL_TRACE(CULL_FACE, {GL_FRONT_AND_BACK});
 				break;
 			default:
 				throw std::invalid_argument("Invalid CullFaceParameters::cullFaceMode_t enumerator");
 		}
-		target.setCullFaceParameters(actual.getCullFaceParameters());
+		target.updateCullFaceParameters(actual);
 	}
 
 	// DepthBuffer
-	if(forced || target.depthBufferParametersChanged(actual)) {
+	if(forced || (actual.isDirty(CoreRenderingStatus::GROUP_DEPTH_BUFFER) && target.depthBufferParametersChanged(actual))) {
 		if(actual.getDepthBufferParameters().isTestEnabled()) {
 			glEnable(GL_DEPTH_TEST);
+			RENDERING_GL_TRACE(ENABLE, {GL_DEPTH_TEST});
 		} else {
 			glDisable(GL_DEPTH_TEST);
+			RENDERING_GL_TRACE(DISABLE, {GL_DEPTH_TEST});
 		}
 		if(actual.getDepthBufferParameters().isWritingEnabled()) {
 			glDepthMask(GL_TRUE);
+			RENDERING_GL_TRACE(DEPTH_MASK, {GL_TRUE});
 		} else {
 			glDepthMask(GL_FALSE);
+			RENDERING_GL_TRACE(DEPTH_MASK, {GL_FALSE});
 		}
 		glDepthFunc(Comparison::functionToGL(actual.getDepthBufferParameters().getFunction()));
-		target.setDepthBufferParameters(actual.getDepthBufferParameters());
+		RENDERING_GL_TRACE(DEPTH_FUNC, {Comparison::functionToGL(actual.getDepthBufferParameters().getFunction())});
+		target.updateDepthBufferParameters(actual);
 	}
 	GET_GL_ERROR();
 
 	// Line
-	if(forced || target.lineParametersChanged(actual)) {
+	if(forced || (actual.isDirty(CoreRenderingStatus::GROUP_LINE) && target.lineParametersChanged(actual))) {
 		auto width = actual.getLineParameters().getWidth();
 		glLineWidth(RenderingContext::getCompabilityMode() ? width : std::min(width, 1.0f));
+		RENDERING_GL_TRACE(LINE_WIDTH, {GLTrace::arg(RenderingContext::getCompabilityMode() ? width : std::min(width, 1.0f))});
 		target.setLineParameters(actual.getLineParameters());
 	}
 
 	// stencil
-	if (forced || target.stencilParametersChanged(actual)) {
+	if(forced || (actual.isDirty(CoreRenderingStatus::GROUP_STENCIL) && target.stencilParametersChanged(actual))) {
 		const StencilParameters & targetParams = target.getStencilParameters();
 		const StencilParameters & actualParams = actual.getStencilParameters();
 		if(forced || targetParams.isEnabled() != actualParams.isEnabled()) {
 			if(actualParams.isEnabled()) {
 				glEnable(GL_STENCIL_TEST);
+				RENDERING_GL_TRACE(ENABLE, {GL_STENCIL_TEST});
 			} else {
 				glDisable(GL_STENCIL_TEST);
+				RENDERING_GL_TRACE(DISABLE, {GL_STENCIL_TEST});
 			}
 		}
 		if(forced || targetParams.differentFunctionParameters(actualParams)) {
 			glStencilFunc(Comparison::functionToGL(actualParams.getFunction()), actualParams.getReferenceValue(), actualParams.getBitMask().to_ulong());
+			RENDERING_GL_TRACE(STENCIL_FUNC, {Comparison::functionToGL(actualParams.getFunction()), static_cast<uint32_t>(actualParams.getReferenceValue()),
+											static_cast<uint32_t>(actualParams.getBitMask().to_ulong())});
 		}
 		if(forced || targetParams.differentActionParameters(actualParams)) {
 			glStencilOp(convertStencilAction(actualParams.getFailAction()),
 						convertStencilAction(actualParams.getDepthTestFailAction()),
 						convertStencilAction(actualParams.getDepthTestPassAction()));
+			RENDERING_GL_TRACE(STENCIL_OP, {convertStencilAction(actualParams.getFailAction()),
+										convertStencilAction(actualParams.getDepthTestFailAction()),
+										convertStencilAction(actualParams.getDepthTestPassAction())});
 		}
 		target.updateStencilParameters(actual);
 	}
@@ -170,13 +252,16 @@ void apply(CoreRenderingStatus & target, const CoreRenderingStatus & actual, boo
 #ifdef LIB_GL
  	if(RenderingContext::getCompabilityMode()) {
 		// AlphaTest
-		if(forced || target.alphaTestParametersChanged(actual)) {
+		if(forced || (actual.isDirty(CoreRenderingStatus::GROUP_ALPHA_TEST) && target.alphaTestParametersChanged(actual))) {
 			if(actual.getAlphaTestParameters().isEnabled()) {
 				glDisable(GL_ALPHA_TEST);
+				RENDERING_GL_TRACE(DISABLE, {GL_ALPHA_TEST});
 			} else {
 				glEnable(GL_ALPHA_TEST);
+				RENDERING_GL_TRACE(ENABLE, {GL_ALPHA_TEST});
 			}
 			glAlphaFunc(Comparison::functionToGL(actual.getAlphaTestParameters().getMode()), actual.getAlphaTestParameters().getReferenceValue());
+			RENDERING_GL_TRACE(ALPHA_FUNC, {Comparison::functionToGL(actual.getAlphaTestParameters().getMode()), GLTrace::arg(actual.getAlphaTestParameters().getReferenceValue())});
 			target.setAlphaTestParameters(actual.getAlphaTestParameters());
 		}
 		GET_GL_ERROR();
@@ -184,13 +269,15 @@ void apply(CoreRenderingStatus & target, const CoreRenderingStatus & actual, boo
 #endif /* LIB_GL */
 
 	// Lighting
-	if(forced || target.lightingParametersChanged(actual)) {
+	if(forced || (actual.isDirty(CoreRenderingStatus::GROUP_LIGHTING) && target.lightingParametersChanged(actual))) {
 #ifdef LIB_GL
  		if(RenderingContext::getCompabilityMode()) {
 			if(actual.getLightingParameters().isEnabled()) {
 				glEnable(GL_LIGHTING);
+				RENDERING_GL_TRACE(ENABLE, {GL_LIGHTING});
 			} else {
 				glDisable(GL_LIGHTING);
+				RENDERING_GL_TRACE(DISABLE, {GL_LIGHTING});
 			}
  		}
 #endif /* LIB_GL */
@@ -200,27 +287,35 @@ void apply(CoreRenderingStatus & target, const CoreRenderingStatus & actual, boo
 
 #ifdef LIB_GL
 	// polygonMode
-	if(forced || target.polygonModeParametersChanged(actual) ) {
+	if(forced || (actual.isDirty(CoreRenderingStatus::GROUP_POLYGON_MODE) && target.polygonModeParametersChanged(actual))) {
 		glPolygonMode(GL_FRONT_AND_BACK, PolygonModeParameters::modeToGL(actual.getPolygonModeParameters().getMode()));
+		RENDERING_GL_TRACE(POLYGON_MODE, {GL_FRONT_AND_BACK, PolygonModeParameters::modeToGL(actual.getPolygonModeParameters().getMode())});
 		target.setPolygonModeParameters(actual.getPolygonModeParameters());
 	}
 	GET_GL_ERROR();
 #endif /* LIB_GL */
 
 	// PolygonOffset
-	if(forced || target.polygonOffsetParametersChanged(actual)) {
+	if(forced || (actual.isDirty(CoreRenderingStatus::GROUP_POLYGON_OFFSET) && target.polygonOffsetParametersChanged(actual))) {
 		if(actual.getPolygonOffsetParameters().isEnabled()) {
 			glEnable(GL_POLYGON_OFFSET_FILL);
+			RENDERING_GL_TRACE(ENABLE, {GL_POLYGON_OFFSET_FILL});
 #ifdef LIB_GL
 			glEnable(GL_POLYGON_OFFSET_LINE);
+			RENDERING_GL_TRACE(ENABLE, {GL_POLYGON_OFFSET_LINE});
 			glEnable(GL_POLYGON_OFFSET_POINT);
+			RENDERING_GL_TRACE(ENABLE, {GL_POLYGON_OFFSET_POINT});
 #endif /* LIB_GL */
 			glPolygonOffset(actual.getPolygonOffsetParameters().getFactor(), actual.getPolygonOffsetParameters().getUnits());
+			RENDERING_GL_TRACE(POLYGON_OFFSET, {GLTrace::arg(actual.getPolygonOffsetParameters().getFactor()), GLTrace::arg(actual.getPolygonOffsetParameters().getUnits())});
 		} else {
 			glDisable(GL_POLYGON_OFFSET_FILL);
+			RENDERING_GL_TRACE(DISABLE, {GL_POLYGON_OFFSET_FILL});
 #ifdef LIB_GL
 			glDisable(GL_POLYGON_OFFSET_LINE);
+			RENDERING_GL_TRACE(DISABLE, {GL_POLYGON_OFFSET_LINE});
 			glDisable(GL_POLYGON_OFFSET_POINT);
+			RENDERING_GL_TRACE(DISABLE, {GL_POLYGON_OFFSET_POINT});
 #endif /* LIB_GL */
 		}
 		target.setPolygonOffsetParameters(actual.getPolygonOffsetParameters());
@@ -228,29 +323,46 @@ void apply(CoreRenderingStatus & target, const CoreRenderingStatus & actual, boo
 	GET_GL_ERROR();
 
 	// Textures
-	if(forced || target.texturesChanged(actual)) {
+	if(forced || (actual.isDirty(CoreRenderingStatus::GROUP_TEXTURES) && target.texturesChanged(actual))) {
+#if defined(LIB_GL) && defined(GL_ARB_multi_bind)
+		static const bool multiBind = isExtensionSupported("GL_ARB_multi_bind");
+		if(multiBind) {
+			bindTexturesMulti(target, actual, forced);
+			target.updateTextures(actual);
+			GET_GL_ERROR();
+			return skippedGroups;
+		}
+#endif
 		for(uint_fast8_t unit = 0; unit < MAX_TEXTURES; ++unit) {
 			const auto & texture = actual.getTexture(unit);
 			const auto & oldTexture = target.getTexture(unit);
 			if(forced || texture != oldTexture) {
+				++RenderingContext::_getFrameCounters().textureBinds;
 				glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(unit));
+				RENDERING_GL_TRACE(ACTIVE_TEXTURE, {GL_TEXTURE0 + static_cast<GLenum>(unit)});
 				if( texture ) {
-					glBindTexture(texture->getGLTextureType(), texture->getGLId());
+					glBindTexture(texture->getGLTextureType(), texture->_getGLIdForBinding());
+					RENDERING_GL_TRACE(BIND_TEXTURE, {texture->getGLTextureType(), texture->_getGLIdForBinding()});
 #if defined(LIB_GL)
 					BufferObject* buffer = texture->getBufferObject();
-					if(buffer)
+					if(buffer) {
 						glTexBuffer( GL_TEXTURE_BUFFER, texture->getFormat().pixelFormat.glInternalFormat, buffer->getGLId() );
+						RENDERING_GL_TRACE(TEX_BUFFER, {texture->getFormat().pixelFormat.glInternalFormat, buffer->getGLId()});
+					}
 #endif
 				} else if( oldTexture ) {
 					glBindTexture(oldTexture->getGLTextureType(), 0);
+					RENDERING_GL_TRACE(BIND_TEXTURE, {oldTexture->getGLTextureType(), 0u});
 				} else {
 					glBindTexture(GL_TEXTURE_2D, 0);
+					RENDERING_GL_TRACE(BIND_TEXTURE, {GL_TEXTURE_2D, 0u});
 				}
 			}
 		}
 		target.updateTextures(actual);
 	}
 	GET_GL_ERROR();
+	return skippedGroups;
 }
 
 }
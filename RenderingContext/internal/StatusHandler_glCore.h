@@ -10,13 +10,17 @@
 */
 #ifndef RENDERING_STATHANDLER_GLCORE_H_
 #define RENDERING_STATHANDLER_GLCORE_H_
+#include <cstdint>
+
 namespace Rendering {
 
 class CoreRenderingStatus;
 
 namespace StatusHandler_glCore{
 
-void apply(CoreRenderingStatus & target, const CoreRenderingStatus & actual, bool forced);
+/*! Apply the parameter groups that are marked as dirty in @p actual and differ from @p target.
+	Returns the number of groups that were skipped because they were not marked as dirty. */
+uint8_t apply(CoreRenderingStatus & target, const CoreRenderingStatus & actual, bool forced);
 
 }
 }
@@ -16,7 +16,10 @@ class RenderingStatus;
 
 namespace StatusHandler_sgUniforms{
 
-void apply(RenderingStatus & target, const RenderingStatus & actual, bool forced);
+/*! Transfer the changed sg-uniforms to the target's shader.
+	If @p cameraMatricesInBlock is true, the camera matrices (sg_matrix_worldToCamera, sg_matrix_cameraToWorld,
+	sg_matrix_cameraToClipping and sg_matrix_clippingToCamera) are provided by the global uniform block and are skipped. */
+void apply(RenderingStatus & target, const RenderingStatus & actual, bool forced, bool cameraMatricesInBlock = false);
 
 }
 }
@@ -0,0 +1,173 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "AsyncMeshLoader.h"
+#include "Serialization.h"
+#include "../Mesh/MeshDataStrategy.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../UploadWorker.h"
+#include <Util/Macros.h>
+#include <algorithm>
+#include <exception>
+
+namespace Rendering {
+namespace Serialization {
+
+AsyncMeshLoader::AsyncMeshLoader(uint32_t numThreads) :
+		numParsing(0), terminate(false), uploadWorker(nullptr), numFinished(0), latencySum(0.0), latencyMax(0.0) {
+	for(uint32_t i = 0; i < std::max<uint32_t>(numThreads, 1); ++i)
+		workers.emplace_back(&AsyncMeshLoader::workerLoop, this);
+}
+
+AsyncMeshLoader::~AsyncMeshLoader() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		terminate = true;
+	}
+	workAvailable.notify_all();
+	for(auto & worker : workers)
+		worker.join();
+	for(auto & request : parseQueue)
+		request->promise.set_value(nullptr);
+	for(auto & request : uploadQueue)
+		request->promise.set_value(nullptr);
+}
+
+AsyncMeshLoader::future_t AsyncMeshLoader::loadMesh(const Util::FileName & url, MeshDataStrategy * strategy) {
+	std::unique_ptr<Request> request(new Request);
+	request->url = url;
+	request->strategy = strategy;
+	request->requestTime = clock_t::now();
+	future_t future = request->promise.get_future().share();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		parseQueue.emplace_back(std::move(request));
+	}
+	workAvailable.notify_one();
+	return future;
+}
+
+//! (internal)
+void AsyncMeshLoader::workerLoop() {
+	while(true) {
+		std::unique_ptr<Request> request;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			workAvailable.wait(lock, [this] { return terminate || !parseQueue.empty(); });
+			if(terminate)
+				return;
+			request = std::move(parseQueue.front());
+			parseQueue.pop_front();
+			++numParsing;
+		}
+		try {
+			request->mesh = Serialization::loadMesh(request->url);
+			if(request->mesh.isNotNull() && request->strategy != nullptr)
+				request->mesh->setDataStrategy(request->strategy);
+		} catch(const std::exception & e) {
+			WARN(std::string("AsyncMeshLoader: Loading failed: ") + e.what());
+			request->mesh = nullptr;
+		}
+		std::unique_lock<std::mutex> lock(mutex);
+		--numParsing;
+		if(uploadWorker != nullptr && request->mesh.isNotNull()) {
+			UploadWorker * worker = uploadWorker;
+			lock.unlock();
+			// the parsed mesh is only referenced by the request; it is released by the callback on the render thread
+			std::shared_ptr<Request> sharedRequest(std::move(request));
+			Mesh * mesh = sharedRequest->mesh.get();
+			worker->enqueue([mesh](RenderingContext &) {
+						MeshDataStrategy * strategy = mesh->getDataStrategy() != nullptr ? mesh->getDataStrategy() : MeshDataStrategy::getDefaultStrategy();
+						strategy->prepare(mesh);
+					},
+					[this, sharedRequest]() {
+						const double latency = std::chrono::duration<double>(clock_t::now() - sharedRequest->requestTime).count();
+						sharedRequest->promise.set_value(sharedRequest->mesh);
+						std::lock_guard<std::mutex> lock(mutex);
+						++numFinished;
+						latencySum += latency;
+						latencyMax = std::max(latencyMax, latency);
+					});
+		} else {
+			uploadQueue.emplace_back(std::move(request));
+		}
+	}
+}
+
+void AsyncMeshLoader::setUploadWorker(UploadWorker * worker) {
+	std::lock_guard<std::mutex> lock(mutex);
+	uploadWorker = worker;
+}
+
+uint32_t AsyncMeshLoader::processUploads(RenderingContext & /*context*/, size_t byteBudget) {
+	uint32_t numUploaded = 0;
+	size_t uploadedBytes = 0;
+	while(numUploaded == 0 || uploadedBytes < byteBudget) {
+		std::unique_ptr<Request> request;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if(uploadQueue.empty())
+				break;
+			request = std::move(uploadQueue.front());
+			uploadQueue.pop_front();
+		}
+		Mesh * mesh = request->mesh.get();
+		if(mesh != nullptr) {
+			uploadedBytes += mesh->_getVertexData().dataSize() + mesh->_getIndexData().dataSize();
+			MeshDataStrategy * strategy = mesh->getDataStrategy() != nullptr ? mesh->getDataStrategy() : MeshDataStrategy::getDefaultStrategy();
+			strategy->prepare(mesh);
+		}
+		const double latency = std::chrono::duration<double>(clock_t::now() - request->requestTime).count();
+		request->promise.set_value(request->mesh);
+		++numUploaded;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		++numFinished;
+		latencySum += latency;
+		latencyMax = std::max(latencyMax, latency);
+	}
+	return numUploaded;
+}
+
+uint32_t AsyncMeshLoader::getParseQueueDepth() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return static_cast<uint32_t>(parseQueue.size()) + numParsing;
+}
+
+uint32_t AsyncMeshLoader::getUploadQueueDepth() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return static_cast<uint32_t>(uploadQueue.size());
+}
+
+uint32_t AsyncMeshLoader::getNumFinished() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return numFinished;
+}
+
+double AsyncMeshLoader::getAverageLatency() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return numFinished == 0 ? 0.0 : latencySum / numFinished;
+}
+
+double AsyncMeshLoader::getMaxLatency() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return latencyMax;
+}
+
+void AsyncMeshLoader::resetStatistics() {
+	std::lock_guard<std::mutex> lock(mutex);
+	numFinished = 0;
+	latencySum = 0.0;
+	latencyMax = 0.0;
+}
+
+}
+}
@@ -0,0 +1,118 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_ASYNCMESHLOADER_H_
+#define RENDERING_ASYNCMESHLOADER_H_
+
+#include "../Mesh/Mesh.h"
+#include <Util/IO/FileName.h>
+#include <Util/References.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Rendering {
+class MeshDataStrategy;
+class RenderingContext;
+class UploadWorker;
+namespace Serialization {
+
+/**
+ * Loader that parses mesh files on a pool of worker threads.
+ *
+ * loadMesh() returns immediately with a future. A worker parses the file with Serialization::loadMesh;
+ * afterwards, the mesh waits in the upload queue until processUploads() is called on the GL thread,
+ * which prepares (uploads) the meshes using their data strategies within the given byte budget.
+ * The future becomes ready after the upload (with @c nullptr if the file could not be loaded).
+ *
+ * If an UploadWorker is set, the parsed meshes are passed to it instead and are uploaded in its shared context;
+ * the futures then become ready in UploadWorker::publish().
+ *
+ * @note The worker threads do not use OpenGL; all gl calls are done in processUploads() (or by the UploadWorker).
+ * @note The parallel parts of the streamers run on the shared TaskScheduler; a worker waiting for them executes
+ *	scheduler tasks in the meantime.
+ */
+class AsyncMeshLoader {
+	public:
+		typedef std::shared_future<Util::Reference<Mesh>> future_t;
+
+		//! Create the loader with @p numThreads worker threads (at least one).
+		explicit AsyncMeshLoader(uint32_t numThreads = 2);
+		//! Pending requests are discarded; their futures receive @c nullptr.
+		~AsyncMeshLoader();
+
+		AsyncMeshLoader(const AsyncMeshLoader &) = delete;
+		AsyncMeshLoader & operator=(const AsyncMeshLoader &) = delete;
+
+		/*! Request loading the given file. The type of the mesh is determined by the file extension.
+			If @p strategy is given, it is set as data strategy of the mesh before it is uploaded.
+			\note The strategy has to stay valid until the request is finished.	*/
+		future_t loadMesh(const Util::FileName & url, MeshDataStrategy * strategy = nullptr);
+
+		/*! Upload parsed meshes until @p byteBudget bytes of vertex and index data have been uploaded
+			(at least one mesh is uploaded per call). Call once per frame on the GL thread.
+			@return Number of uploaded meshes	*/
+		uint32_t processUploads(RenderingContext & context, size_t byteBudget = 4 * 1024 * 1024);
+
+		/*! Upload the meshes parsed afterwards with the given worker (nullptr: use processUploads()).
+			\note The loader must not be destroyed while the worker has unpublished meshes of it.	*/
+		void setUploadWorker(UploadWorker * worker);
+
+		//! @name Statistics
+		//	@{
+		//! Number of requests waiting for or being parsed by a worker.
+		uint32_t getParseQueueDepth() const;
+		//! Number of parsed meshes waiting for processUploads().
+		uint32_t getUploadQueueDepth() const;
+		//! Number of finished requests.
+		uint32_t getNumFinished() const;
+		//! Average and maximum latency (from the request to the finished upload) in seconds.
+		double getAverageLatency() const;
+		double getMaxLatency() const;
+		void resetStatistics();
+		//	@}
+
+	private:
+		typedef std::chrono::steady_clock clock_t;
+		struct Request {
+			Util::FileName url;
+			Util::Reference<Mesh> mesh;
+			MeshDataStrategy * strategy;
+			std::promise<Util::Reference<Mesh>> promise;
+			clock_t::time_point requestTime;
+		};
+
+		mutable std::mutex mutex;
+		std::condition_variable workAvailable;
+		std::deque<std::unique_ptr<Request>> parseQueue;
+		std::deque<std::unique_ptr<Request>> uploadQueue;
+		std::vector<std::thread> workers;
+		uint32_t numParsing;
+		bool terminate;
+		UploadWorker * uploadWorker;
+
+		uint32_t numFinished;
+		double latencySum;
+		double latencyMax;
+
+		void workerLoop();
+};
+
+}
+}
+
+#endif /* RENDERING_ASYNCMESHLOADER_H_ */
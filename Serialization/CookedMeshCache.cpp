@@ -0,0 +1,155 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "CookedMeshCache.h"
+#include "Serialization.h"
+#include "StreamerMMF.h"
+#include "TextureCache.h"
+#include "../ContentHash.h"
+#include "../Mesh/Mesh.h"
+#include "../MeshUtils/VertexCacheOptimization.h"
+#include <Util/IO/FileName.h>
+#include <Util/Macros.h>
+#include <Util/References.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace Rendering {
+namespace Serialization {
+
+static Util::Reference<CookedMeshCache> activeMeshCache;
+
+void setMeshCache(CookedMeshCache * cache) {
+	activeMeshCache = cache;
+}
+
+CookedMeshCache * getMeshCache() {
+	return activeMeshCache.get();
+}
+
+CookedMeshCache::CookedMeshCache(std::string _directory, uint32_t _importerVersion) :
+		ReferenceCounter_t(), directory(std::move(_directory)), importerVersion(_importerVersion), optimizeMeshes(true),
+		hitCount(0), missCount(0), writing(false), stopping(false) {
+}
+
+CookedMeshCache::~CookedMeshCache() {
+	waitForPendingWrites();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	queueCondition.notify_all();
+	if(writer.joinable())
+		writer.join();
+}
+
+std::string CookedMeshCache::getCookedPath(const std::string & sourcePath) const {
+	struct stat info;
+	if(stat(sourcePath.c_str(), &info) != 0)
+		return std::string();
+	std::ostringstream key;
+	key << TextureCache::getCanonicalPath(sourcePath) << '|' << static_cast<uint64_t>(info.st_size) << '|'
+		<< static_cast<int64_t>(info.st_mtime) << '|' << importerVersion << '|' << StreamerMMF::MMF_VERSION;
+	const std::string keyString = key.str();
+	const uint64_t hash = calcContentHash(reinterpret_cast<const uint8_t *>(keyString.data()), keyString.size());
+
+	static const char * const digits = "0123456789abcdef";
+	std::string name(16, '0');
+	for(int i = 0; i < 16; ++i)
+		name[15 - i] = digits[(hash >> (4 * i)) & 0x0f];
+	return directory + '/' + name + '.' + StreamerMMF::fileExtension;
+}
+
+Mesh * CookedMeshCache::loadMesh(const Util::FileName & url) {
+	if(url.getFSName() != "file")
+		return _loadMeshUncached(url);
+
+	const std::string cookedPath = getCookedPath(url.getPath());
+	if(!cookedPath.empty()) {
+		struct stat info;
+		if(stat(cookedPath.c_str(), &info) == 0) {
+			Util::Reference<Mesh> mesh = StreamerMMF::loadMeshMapped(cookedPath, false);
+			if(mesh.isNotNull() && !mesh->empty()) {
+				++hitCount;
+				mesh->setFileName(url);
+				return mesh.detachAndDecrease();
+			}
+			WARN("CookedMeshCache: Ignoring invalid cooked copy \"" + cookedPath + "\".");
+		}
+	}
+
+	Util::Reference<Mesh> mesh = _loadMeshUncached(url);
+	if(mesh.isNull())
+		return nullptr;
+	++missCount;
+	if(!cookedPath.empty() && !mesh->isView()) {
+		Job job;
+		job.mesh = mesh->clone(); // shares the data until one of the meshes is changed
+		job.path = cookedPath;
+		job.optimize = optimizeMeshes;
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(job);
+		if(!writer.joinable())
+			writer = std::thread(&CookedMeshCache::run, this);
+		queueCondition.notify_one();
+	}
+	return mesh.detachAndDecrease();
+}
+
+void CookedMeshCache::waitForPendingWrites() {
+	std::unique_lock<std::mutex> lock(mutex);
+	idleCondition.wait(lock, [this] { return queue.empty() && !writing; });
+}
+
+//! (internal)
+void CookedMeshCache::run() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true) {
+		queueCondition.wait(lock, [this] { return stopping || !queue.empty(); });
+		if(queue.empty())
+			return;
+		const Job job = queue.front();
+		queue.pop_front();
+		writing = true;
+		lock.unlock();
+		writeCookedCopy(job);
+		lock.lock();
+		writing = false;
+		idleCondition.notify_all();
+	}
+}
+
+//! (static, internal)
+void CookedMeshCache::writeCookedCopy(const Job & job) {
+	Util::Reference<Mesh> mesh = job.mesh; // the copy is only referenced by this thread
+	if(job.optimize && mesh->isUsingIndexData() && mesh->getDrawMode() == Mesh::DRAW_TRIANGLES)
+		MeshUtils::VertexCacheOptimization::optimizeMesh(mesh.get());
+
+	const std::string tempPath = job.path + ".tmp";
+	bool success;
+	{
+		std::ofstream output(tempPath.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		StreamerMMF streamer;
+		success = output.good() && streamer.saveMesh(mesh.get(), output);
+		output.close();
+		success = success && !output.fail();
+	}
+	std::remove(job.path.c_str()); // rename does not replace existing files on all platforms
+	if(!success || std::rename(tempPath.c_str(), job.path.c_str()) != 0) {
+		WARN("CookedMeshCache: Could not write \"" + job.path + "\".");
+		std::remove(tempPath.c_str());
+	}
+}
+
+}
+}
@@ -0,0 +1,108 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_COOKEDMESHCACHE_H_
+#define RENDERING_COOKEDMESHCACHE_H_
+
+#include <Util/ReferenceCounter.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Util {
+class FileName;
+}
+namespace Rendering {
+class Mesh;
+namespace Serialization {
+
+/**
+ * Cache directory containing cooked copies of loaded meshes in the MMF format (see StreamerMMF).
+ * A cooked copy is identified by the canonical path, the size and the modification time of the source file, the
+ * importer version given to the cache and the MMF version; a changed source file therefore simply misses the cache.
+ * - On a hit, the cooked copy is loaded by mapping it into memory (StreamerMMF::loadMeshMapped()), which is much
+ *   faster than parsing e.g. .obj, .ply or .xyz files.
+ * - On a miss, the source file is loaded as usual. A copy of the mesh (which shares the data, see Mesh::clone())
+ *   is written into the cache directory by a background thread, so loading is not delayed; if enabled, the triangles and vertices of the
+ *   copy are reordered with MeshUtils::VertexCacheOptimization::optimizeMesh() first.
+ *
+ * If set via setMeshCache(), Serialization::loadMesh(const Util::FileName &) uses the cache for local files.
+ * \code
+ * Util::Reference<Serialization::CookedMeshCache> cache = new Serialization::CookedMeshCache("cache/meshes");
+ * Serialization::setMeshCache(cache.get());
+ * \endcode
+ * @note The cache may be used from several threads (e.g. by an AsyncMeshLoader).
+ * @note Files are written to a temporary name and renamed afterwards, so an interrupted write never produces
+ *   a broken cooked copy.
+ */
+class CookedMeshCache : public Util::ReferenceCounter<CookedMeshCache> {
+	public:
+		/*! @param directory Existing directory for the cooked copies
+			@param importerVersion Increase it whenever the importers change, to invalidate the existing copies.	*/
+		explicit CookedMeshCache(std::string directory, uint32_t importerVersion = 1);
+		//! Waits for the pending writes.
+		~CookedMeshCache();
+
+		/*! Load the cooked copy of the given file, or load the file and cook it in the background.
+			Files that are not stored in the local file system are loaded without the cache.
+			@return The mesh (with the file name @p url), or @c nullptr if it could not be loaded.	*/
+		Mesh * loadMesh(const Util::FileName & url);
+
+		//! If enabled (default), the cooked copies are optimized for the vertex cache.
+		void setOptimizeMeshes(bool enabled)			{	optimizeMeshes = enabled;	}
+		bool isOptimizingMeshes()const					{	return optimizeMeshes;	}
+
+		//! Block until all cooked copies have been written.
+		void waitForPendingWrites();
+
+		//! Path of the cooked copy of the given local file (empty if the file does not exist).
+		std::string getCookedPath(const std::string & sourcePath)const;
+
+		uint32_t getHitCount()const						{	return hitCount;	}
+		uint32_t getMissCount()const					{	return missCount;	}
+
+	private:
+		struct Job {
+			Mesh * mesh; //!< copy of the loaded mesh; only referenced by the writer thread
+			std::string path;
+			bool optimize;
+		};
+		const std::string directory;
+		const uint32_t importerVersion;
+		bool optimizeMeshes;
+		std::atomic<uint32_t> hitCount;
+		std::atomic<uint32_t> missCount;
+
+		std::mutex mutex;
+		std::condition_variable queueCondition;
+		std::condition_variable idleCondition;
+		std::deque<Job> queue;
+		bool writing;
+		bool stopping;
+		std::thread writer;
+
+		//! (internal) Main function of the writer thread.
+		void run();
+		static void writeCookedCopy(const Job & job);
+};
+
+/*! Set the cache used by loadMesh(const Util::FileName &).
+	@c nullptr (the default) disables the cache.	*/
+void setMeshCache(CookedMeshCache * cache);
+CookedMeshCache * getMeshCache();
+
+}
+}
+
+#endif /* RENDERING_COOKEDMESHCACHE_H_ */
@@ -0,0 +1,156 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "EmbeddedDataChannel.h"
+#include "Serialization.h"
+#include "StreamerMMF.h"
+#include "../Mesh/Mesh.h"
+#include <Util/GenericAttribute.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace Rendering {
+namespace Serialization {
+
+typedef Util::WrapperAttribute<EmbeddedDataChannel &> ChannelAttribute_t;
+
+const Util::StringIdentifier EmbeddedDataChannel::CONTEXT_EMBEDDED_DATA("EmbeddedDataChannel");
+
+//! (ctor)
+EmbeddedDataChannel::EmbeddedDataChannel(std::ostream & _output) :
+		output(&_output), input(nullptr), startPosition(static_cast<int64_t>(_output.tellp())), renderingContext(nullptr), blockCount(0) {
+}
+
+//! (ctor)
+EmbeddedDataChannel::EmbeddedDataChannel(std::istream & _input) :
+		output(nullptr), input(&_input), startPosition(static_cast<int64_t>(_input.tellg())), renderingContext(nullptr), blockCount(0) {
+}
+
+void EmbeddedDataChannel::addToContext(Util::GenericAttributeMap & context) {
+	context.setValue(CONTEXT_EMBEDDED_DATA, new ChannelAttribute_t(*this));
+}
+
+//! (static)
+EmbeddedDataChannel * EmbeddedDataChannel::getFromContext(const Util::GenericAttributeMap * context) {
+	if(context == nullptr)
+		return nullptr;
+	auto attribute = dynamic_cast<ChannelAttribute_t *>(context->getValue(CONTEXT_EMBEDDED_DATA));
+	return attribute == nullptr ? nullptr : &attribute->get();
+}
+
+int64_t EmbeddedDataChannel::writeBlock(const std::string & extension, const std::function<bool (std::ostream &)> & writeData) {
+	if(output == nullptr) {
+		WARN("EmbeddedDataChannel: Channel is not opened for writing.");
+		return -1;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	output->seekp(0, std::ios_base::end);
+	const int64_t blockPosition = static_cast<int64_t>(output->tellp());
+	const uint32_t header[2] = {BLOCK_MAGIC, static_cast<uint32_t>(extension.size())};
+	uint64_t dataSize = 0;
+	output->write(reinterpret_cast<const char *>(header), sizeof(header));
+	output->write(extension.data(), extension.size());
+	const int64_t sizePosition = static_cast<int64_t>(output->tellp());
+	output->write(reinterpret_cast<const char *>(&dataSize), sizeof(dataSize)); // patched below
+	if(!writeData(*output) || !output->good()) {
+		WARN("EmbeddedDataChannel: Writing block failed.");
+		return -1;
+	}
+	const int64_t endPosition = static_cast<int64_t>(output->tellp());
+	dataSize = static_cast<uint64_t>(endPosition - sizePosition) - sizeof(dataSize);
+	output->seekp(sizePosition);
+	output->write(reinterpret_cast<const char *>(&dataSize), sizeof(dataSize));
+	output->seekp(endPosition);
+	if(!output->good()) {
+		WARN("EmbeddedDataChannel: Stream is not seekable.");
+		return -1;
+	}
+	++blockCount;
+	return blockPosition - startPosition;
+}
+
+int64_t EmbeddedDataChannel::writeBlock(const std::string & extension, const std::string & data) {
+	return writeBlock(extension, [&data](std::ostream & out) {
+		out.write(data.data(), data.size());
+		return true;
+	});
+}
+
+//! (internal)
+bool EmbeddedDataChannel::readBlockHeader(int64_t offset, std::string & extension, uint64_t & dataSize) {
+	if(input == nullptr || offset < 0) {
+		WARN("EmbeddedDataChannel: Channel is not opened for reading.");
+		return false;
+	}
+	input->clear();
+	input->seekg(startPosition + offset);
+	uint32_t header[2] = {0, 0};
+	input->read(reinterpret_cast<char *>(header), sizeof(header));
+	if(!input->good() || header[0] != BLOCK_MAGIC || header[1] > 256) {
+		WARN("EmbeddedDataChannel: Invalid block.");
+		return false;
+	}
+	extension.resize(header[1]);
+	input->read(&extension[0], header[1]);
+	input->read(reinterpret_cast<char *>(&dataSize), sizeof(dataSize));
+	if(!input->good()) {
+		WARN("EmbeddedDataChannel: Invalid block.");
+		return false;
+	}
+	return true;
+}
+
+bool EmbeddedDataChannel::readBlock(int64_t offset, std::string & extension, std::string & data) {
+	std::lock_guard<std::mutex> lock(mutex);
+	uint64_t dataSize = 0;
+	if(!readBlockHeader(offset, extension, dataSize))
+		return false;
+	// read in parts, so a corrupt size does not allocate more memory than the stream contains
+	static const uint64_t partSize = 1 << 24;
+	data.clear();
+	for(uint64_t remaining = dataSize; remaining > 0 && input->good(); ) {
+		const size_t size = static_cast<size_t>(std::min(remaining, partSize));
+		const size_t oldSize = data.size();
+		data.resize(oldSize + size);
+		input->read(&data[oldSize], size);
+		remaining -= size;
+	}
+	if(!input->good()) {
+		WARN("EmbeddedDataChannel: Block is truncated.");
+		return false;
+	}
+	++blockCount;
+	return true;
+}
+
+Mesh * EmbeddedDataChannel::loadMeshBlock(int64_t offset) {
+	std::string extension;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		uint64_t dataSize = 0;
+		if(!readBlockHeader(offset, extension, dataSize))
+			return nullptr;
+		if(extension == StreamerMMF::fileExtension) {
+			++blockCount;
+			StreamerMMF streamer;
+			return streamer.loadMesh(*input);
+		}
+	}
+	std::string data;
+	if(!readBlock(offset, extension, data))
+		return nullptr;
+	return loadMesh(extension, data);
+}
+
+}
+}
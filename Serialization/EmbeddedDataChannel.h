@@ -0,0 +1,102 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_EMBEDDEDDATACHANNEL_H_
+#define RENDERING_EMBEDDEDDATACHANNEL_H_
+
+#include <Util/StringIdentifier.h>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+
+namespace Util {
+class GenericAttributeMap;
+}
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+namespace Serialization {
+
+/**
+ * Side channel for the binary payloads of meshes and textures that are embedded into serialized generic attributes.
+ * If the context of Util::GenericAttributeSerialization contains a channel (see addToContext()), embedded meshes
+ * (and textures) are written as raw blocks into the channel's stream instead of being base64-encoded into the
+ * attribute string; the string only contains the offset of the block (e.g. "$[mmf_block]1024").
+ * When reading, a block is only read when the attribute referencing it is unserialized; meshes in the mmf format
+ * are loaded directly from the channel's stream.
+ *
+ * \code
+ * std::ofstream blocks("scene.bin", std::ios::binary);
+ * Serialization::EmbeddedDataChannel channel(blocks);
+ * Util::GenericAttributeMap context;
+ * channel.addToContext(context);
+ * const std::string text = Util::GenericAttributeSerialization::serialize(attribute, &context);
+ * \endcode
+ *
+ * Format (binary little endian; offsets are relative to the stream position when the channel was created):
+ * Block ::= uint32 magic (0x6b6c4245 "EBlk"), uint32 extensionLength, char extension[extensionLength],
+ *           uint64 dataSize, uint8 data[dataSize]
+ *
+ * \note The stream has to be seekable. The functions are thread-safe.
+ */
+class EmbeddedDataChannel {
+	public:
+		static const uint32_t BLOCK_MAGIC = 0x6b6c4245;
+		//! Key of the channel in the context of Util::GenericAttributeSerialization.
+		static const Util::StringIdentifier CONTEXT_EMBEDDED_DATA;
+
+		//! Create a channel for writing blocks.
+		explicit EmbeddedDataChannel(std::ostream & output);
+		//! Create a channel for reading blocks.
+		explicit EmbeddedDataChannel(std::istream & input);
+
+		//! Add a reference to the channel to the given serialization context.
+		void addToContext(Util::GenericAttributeMap & context);
+		//! (static) Return the channel of the given serialization context, or nullptr.
+		static EmbeddedDataChannel * getFromContext(const Util::GenericAttributeMap * context);
+
+		/*! Write a block whose data is produced by @p writeData directly into the channel's stream.
+			@return offset of the block, or -1 if writing failed. */
+		int64_t writeBlock(const std::string & extension, const std::function<bool (std::ostream &)> & writeData);
+		int64_t writeBlock(const std::string & extension, const std::string & data);
+
+		//! Read the block at the given offset. @return false if there is no valid block.
+		bool readBlock(int64_t offset, std::string & extension, std::string & data);
+
+		/*! Load the mesh stored in the block at the given offset (nullptr on failure).
+			Blocks in the mmf format are read directly from the stream. */
+		Mesh * loadMeshBlock(int64_t offset);
+
+		/*! Rendering context used to download textures that are embedded (see Serialization::saveTexture()).
+			Without a context, textures without a file name are not serialized. */
+		void setRenderingContext(RenderingContext * context)	{	renderingContext = context;	}
+		RenderingContext * getRenderingContext() const			{	return renderingContext;	}
+
+		//! Number of blocks written or read.
+		uint32_t getBlockCount() const							{	return blockCount;	}
+
+	private:
+		std::ostream * output;
+		std::istream * input;
+		int64_t startPosition;
+		RenderingContext * renderingContext;
+		uint32_t blockCount;
+		std::mutex mutex;
+
+		//! (internal) Seek to the block and read its header; the stream is positioned at the data afterwards.
+		bool readBlockHeader(int64_t offset, std::string & extension, uint64_t & dataSize);
+};
+
+}
+}
+
+#endif /* RENDERING_EMBEDDEDDATACHANNEL_H_ */
@@ -8,22 +8,49 @@
 */
 #include "GenericAttributeSerialization.h"
 #include "Serialization.h"
+#include "EmbeddedDataChannel.h"
 #include "../Mesh/Mesh.h"
+#include "../Texture/Texture.h"
 #include <Util/GenericAttribute.h>
 #include <Util/GenericAttributeSerialization.h>
 #include <Util/Encoding.h>
 #include <Util/IO/FileLocator.h>
+#include <cstdlib>
+#include <string>
 
 namespace Rendering {
 namespace Serialization {
 
 static const bool renderingAttrStreamerInitialized = initGenericAttributeSerialization();
+static const Util::StringIdentifier CONTEXT_FILE_LOCATOR("FileLocator");
+
+//! (internal) Locate a file using the FileLocator of the context, if there is one.
+static Util::FileName locateFile(const std::string & s, const Util::GenericAttributeMap * context) {
+	auto filename = Util::FileName(s);
+	if(context != nullptr && context->contains(CONTEXT_FILE_LOCATOR)) {
+		auto locator = context->getValue<Util::WrapperAttribute<Util::FileLocator&>>(CONTEXT_FILE_LOCATOR)->get();
+		filename = locator.locateFile(filename).second;
+	}
+	return filename;
+}
+
+//! (internal) Parse the block offset following @p prefix; returns -1 if @p s does not start with the prefix.
+static int64_t getBlockOffset(const std::string & s, const std::string & prefix) {
+	if(s.compare(0, prefix.length(), prefix) != 0)
+		return -1;
+	return static_cast<int64_t>(std::strtoll(s.c_str() + prefix.length(), nullptr, 10));
+}
 
 std::pair<std::string, std::string> serializeGAMesh(const std::pair<const Util::GenericAttribute *, const Util::GenericAttributeMap *> & attributeAndContext) {
 	auto meshAttribute = dynamic_cast<const MeshAttribute_t *>(attributeAndContext.first);
 	const auto & mesh = meshAttribute->get();
 	const auto & filename = mesh->getFileName();
 	if(filename.empty()) {
+		EmbeddedDataChannel * channel = EmbeddedDataChannel::getFromContext(attributeAndContext.second);
+		if(channel != nullptr) {
+			const int64_t offset = channel->writeBlock("mmf", [&mesh](std::ostream & out) {	return saveMesh(mesh, "mmf", out);	});
+			return std::make_pair(GATypeNameMesh, offset < 0 ? std::string("") : embeddedMeshBlockPrefix + std::to_string(offset));
+		}
 		std::ostringstream meshStream;
 		if(saveMesh(mesh, "mmf", meshStream)) {
 			const std::string streamString = meshStream.str();
@@ -37,25 +64,61 @@ std::pair<std::string, std::string> serializeGAMesh(const std::pair<const Util::
 }
 
 MeshAttribute_t * unserializeGAMesh(const std::pair<std::string, const Util::GenericAttributeMap *> & contentAndContext) {	
-	static const Util::StringIdentifier CONTEXT_FILE_LOCATOR("FileLocator");
 	const std::string & s = contentAndContext.first;
 	Mesh * mesh = nullptr;
-	if(s.compare(0, embeddedMeshPrefix.length(), embeddedMeshPrefix) == 0) {
+	const int64_t blockOffset = getBlockOffset(s, embeddedMeshBlockPrefix);
+	if(blockOffset >= 0) {
+		EmbeddedDataChannel * channel = EmbeddedDataChannel::getFromContext(contentAndContext.second);
+		if(channel == nullptr)
+			WARN("unserializeGAMesh: Embedded mesh block found, but the context contains no EmbeddedDataChannel.");
+		else
+			mesh = channel->loadMeshBlock(blockOffset);
+	} else if(s.compare(0, embeddedMeshPrefix.length(), embeddedMeshPrefix) == 0) {
 		const std::vector<uint8_t> meshData = Util::decodeBase64(s.substr(embeddedMeshPrefix.length()));
 		mesh = loadMesh("mmf", std::string(meshData.begin(), meshData.end()));
 	} else {
-		auto filename = Util::FileName(s);
-		if(contentAndContext.second->contains(CONTEXT_FILE_LOCATOR)) {
-			auto locator = contentAndContext.second->getValue<Util::WrapperAttribute<Util::FileLocator&>>(CONTEXT_FILE_LOCATOR)->get();
-			filename = locator.locateFile(filename).second;
-		} 
-		mesh = loadMesh(filename);
+		mesh = loadMesh(locateFile(s, contentAndContext.second));
 	}
 	return mesh == nullptr ? nullptr : new MeshAttribute_t(mesh);
 }
 
+std::pair<std::string, std::string> serializeGATexture(const std::pair<const Util::GenericAttribute *, const Util::GenericAttributeMap *> & attributeAndContext) {
+	auto textureAttribute = dynamic_cast<const TextureAttribute_t *>(attributeAndContext.first);
+	Texture * texture = textureAttribute->get();
+	const auto & filename = texture->getFileName();
+	if(!filename.empty())
+		return std::make_pair(GATypeNameTexture, filename.toString());
+	EmbeddedDataChannel * channel = EmbeddedDataChannel::getFromContext(attributeAndContext.second);
+	if(channel == nullptr || channel->getRenderingContext() == nullptr) {
+		WARN("serializeGATexture: Textures without file name can only be stored in an EmbeddedDataChannel with a rendering context.");
+		return std::make_pair(GATypeNameTexture, std::string(""));
+	}
+	RenderingContext & context = *channel->getRenderingContext();
+	const int64_t offset = channel->writeBlock("png", [&context, texture](std::ostream & out) {	return saveTexture(context, texture, "png", out);	});
+	return std::make_pair(GATypeNameTexture, offset < 0 ? std::string("") : embeddedTextureBlockPrefix + std::to_string(offset));
+}
+
+TextureAttribute_t * unserializeGATexture(const std::pair<std::string, const Util::GenericAttributeMap *> & contentAndContext) {
+	const std::string & s = contentAndContext.first;
+	Util::Reference<Texture> texture;
+	const int64_t blockOffset = getBlockOffset(s, embeddedTextureBlockPrefix);
+	if(blockOffset >= 0) {
+		EmbeddedDataChannel * channel = EmbeddedDataChannel::getFromContext(contentAndContext.second);
+		std::string extension;
+		std::string data;
+		if(channel == nullptr)
+			WARN("unserializeGATexture: Embedded texture block found, but the context contains no EmbeddedDataChannel.");
+		else if(channel->readBlock(blockOffset, extension, data))
+			texture = loadTexture(extension, data);
+	} else if(!s.empty()) {
+		texture = loadTexture(locateFile(s, contentAndContext.second));
+	}
+	return texture.isNull() ? nullptr : new TextureAttribute_t(texture.get());
+}
+
 bool initGenericAttributeSerialization() {
-	static bool serializerRegistered = Util::GenericAttributeSerialization::registerSerializer<MeshAttribute_t>(GATypeNameMesh, serializeGAMesh, unserializeGAMesh);
+	static bool serializerRegistered = Util::GenericAttributeSerialization::registerSerializer<MeshAttribute_t>(GATypeNameMesh, serializeGAMesh, unserializeGAMesh) &&
+			Util::GenericAttributeSerialization::registerSerializer<TextureAttribute_t>(GATypeNameTexture, serializeGATexture, unserializeGATexture);
 	return serializerRegistered;
 }
 
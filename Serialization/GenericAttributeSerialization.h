@@ -18,12 +18,16 @@ template<class ObjType> class ReferenceAttribute;
 }
 namespace Rendering {
 class Mesh;
+class Texture;
 namespace Serialization {
 
-/*! Adds a handler for Util::_CounterAttribute<Mesh> to Util::GenericAttributeSerialization.
+/*! Adds handlers for Util::ReferenceAttribute<Mesh> and Util::ReferenceAttribute<Texture> to Util::GenericAttributeSerialization.
 	Should be called at least once before a GenericAttribute is serialized which
-	may contain a Mesh.
-	\note Texture-Serialization may be added here when needed.
+	may contain a Mesh or a Texture.
+	Meshes and textures without a file name are embedded: if the context contains an EmbeddedDataChannel,
+	their data is written as a binary block into the channel and the string references the block.
+	Otherwise, meshes are embedded as base64-encoded string; textures are only embedded into a channel
+	(requires the channel's rendering context).
 	\note The return value is always true and can be used for static initialization.
 */
 bool initGenericAttributeSerialization();
@@ -31,11 +35,22 @@ bool initGenericAttributeSerialization();
 typedef Util::ReferenceAttribute<Mesh> MeshAttribute_t;
 const std::string GATypeNameMesh("Mesh");
 const std::string embeddedMeshPrefix("$[mmf_b64]");
+//! Prefix of a mesh stored in a block of an EmbeddedDataChannel; followed by the block's offset.
+const std::string embeddedMeshBlockPrefix("$[mmf_block]");
 std::pair<std::string, std::string> serializeGAMesh(const std::pair<const Util::GenericAttribute *,
 																	const Util::GenericAttributeMap *> & attributeAndContext);
 MeshAttribute_t * unserializeGAMesh(const std::pair<std::string,
 													const Util::GenericAttributeMap *> & contentAndContext);
 
+typedef Util::ReferenceAttribute<Texture> TextureAttribute_t;
+const std::string GATypeNameTexture("Texture");
+//! Prefix of a texture stored in a block of an EmbeddedDataChannel; followed by the block's offset.
+const std::string embeddedTextureBlockPrefix("$[texture_block]");
+std::pair<std::string, std::string> serializeGATexture(const std::pair<const Util::GenericAttribute *,
+																		const Util::GenericAttributeMap *> & attributeAndContext);
+TextureAttribute_t * unserializeGATexture(const std::pair<std::string,
+														  const Util::GenericAttributeMap *> & contentAndContext);
+
 }
 }
 
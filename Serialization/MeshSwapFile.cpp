@@ -0,0 +1,259 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MeshSwapFile.h"
+#include "StreamerMMF.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "internal/MappedFile.h"
+#include <Util/Macros.h>
+#include <Util/References.h>
+#include <cstdio>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+namespace Rendering {
+namespace Serialization {
+namespace {
+
+//! (internal) Alignment of the records inside the file; the MMF data blocks are aligned relative to the record.
+const size_t RECORD_ALIGNMENT = StreamerMMF::MMF_DATA_ALIGNMENT;
+
+//! (internal) Range of the swap file; given back when the last record using it is deleted.
+struct SwapRange {
+	Util::Reference<MeshSwapFile> file;
+	size_t offset;
+	size_t size;		//!< allocated bytes
+	size_t dataSize;	//!< bytes of the MMF data
+	SwapRange(MeshSwapFile * _file, size_t _offset, size_t _size, size_t _dataSize) :
+			file(_file), offset(_offset), size(_size), dataSize(_dataSize) {}
+	~SwapRange() {
+		file->_releaseRange(offset, size);
+	}
+};
+
+//! (internal) Location of the paged out data of a mesh and the revisions of the data.
+class SwapRecord : public MeshDerivedData {
+	public:
+		std::shared_ptr<SwapRange> range;
+		uint64_t vertexRevision;
+		uint64_t indexRevision;
+
+		SwapRecord(std::shared_ptr<SwapRange> _range, uint64_t _vertexRevision, uint64_t _indexRevision) :
+				MeshDerivedData(), range(std::move(_range)), vertexRevision(_vertexRevision), indexRevision(_indexRevision) {}
+};
+
+//! (internal) The record of the mesh if it matches the mesh's current data.
+SwapRecord * getValidRecord(Mesh * mesh) {
+	if(mesh == nullptr)
+		return nullptr;
+	SwapRecord * record = dynamic_cast<SwapRecord *>(mesh->_getSwapRecord());
+	if(record == nullptr || record->vertexRevision != mesh->_getVertexData().getRevision() || record->indexRevision != mesh->_getIndexData().getRevision())
+		return nullptr;
+	return record;
+}
+
+}
+
+//! (ctor)
+MeshSwapFile::MeshSwapFile(std::string _path) :
+		ReferenceCounter_t(), path(std::move(_path)), file(path.c_str(), std::ios_base::in | std::ios_base::out | std::ios_base::trunc | std::ios_base::binary),
+		fileSize(0), usedBytes(0), mappingOutdated(true) {
+	if(!file.good())
+		WARN("MeshSwapFile: Could not create file \"" + path + "\".");
+}
+
+//! (dtor)
+MeshSwapFile::~MeshSwapFile() {
+	mapping.reset();
+	file.close();
+	std::remove(path.c_str());
+}
+
+bool MeshSwapFile::isValid() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return file.is_open() && !file.fail();
+}
+
+size_t MeshSwapFile::getFileSize() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return fileSize;
+}
+
+size_t MeshSwapFile::getUsedBytes() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return usedBytes;
+}
+
+MeshSwapFile::Statistics MeshSwapFile::getStatistics() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+//! (static)
+MeshSwapFile * MeshSwapFile::getSwapFile(Mesh * mesh) {
+	const SwapRecord * record = getValidRecord(mesh);
+	return record == nullptr ? nullptr : record->range->file.get();
+}
+
+//! (internal) The caller has to hold the lock.
+size_t MeshSwapFile::allocateRange(size_t size) {
+	usedBytes += size;
+	for(auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+		if(it->second < size)
+			continue;
+		const size_t offset = it->first;
+		const size_t remaining = it->second - size;
+		freeRanges.erase(it);
+		if(remaining > 0)
+			freeRanges.emplace(offset + size, remaining);
+		return offset;
+	}
+	const size_t offset = fileSize;
+	fileSize += size;
+	return offset;
+}
+
+void MeshSwapFile::_releaseRange(size_t offset, size_t size) {
+	std::lock_guard<std::mutex> lock(mutex);
+	usedBytes -= size;
+	auto next = freeRanges.lower_bound(offset);
+	if(next != freeRanges.end() && offset + size == next->first) {
+		size += next->second;
+		next = freeRanges.erase(next);
+	}
+	if(next != freeRanges.begin()) {
+		auto previous = std::prev(next);
+		if(previous->first + previous->second == offset) {
+			offset = previous->first;
+			size += previous->second;
+			freeRanges.erase(previous);
+		}
+	}
+	if(offset + size == fileSize)
+		fileSize = offset; // the space is reused by the next record appended to the file
+	else
+		freeRanges.emplace(offset, size);
+}
+
+bool MeshSwapFile::pageOut(Mesh * mesh) {
+	if(mesh == nullptr || mesh->isView())
+		return false;
+	const SwapRecord * oldRecord = getValidRecord(mesh);
+	if(oldRecord != nullptr && oldRecord->range->file.get() == this)
+		return true;
+	if(mesh->_getVertexData().getLayout() != MeshVertexData::INTERLEAVED) {
+		WARN("MeshSwapFile::pageOut: Only meshes with interleaved vertices can be paged out.");
+		return false;
+	}
+
+	std::ostringstream output;
+	StreamerMMF streamer;
+	if(!streamer.saveMesh(mesh, output))
+		return false;
+	const std::string data = output.str();
+	const size_t size = (data.size() + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+
+	size_t offset;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(!file.is_open() || file.fail())
+			return false;
+		offset = allocateRange(size);
+		file.seekp(static_cast<std::streamoff>(offset));
+		file.write(data.data(), static_cast<std::streamsize>(data.size()));
+		if(data.size() < size) {
+			static const char padding[RECORD_ALIGNMENT] = {};
+			file.write(padding, static_cast<std::streamsize>(size - data.size()));
+		}
+		file.flush();
+		mappingOutdated = true;
+		if(file.fail()) {
+			WARN("MeshSwapFile::pageOut: Could not write to \"" + path + "\".");
+			file.clear();
+			usedBytes -= size;
+			freeRanges.emplace(offset, size);
+			return false;
+		}
+		++statistics.pageOuts;
+		statistics.bytesWritten += data.size();
+	}
+	// saving may have downloaded the data, but that does not change the revisions
+	std::shared_ptr<SwapRange> range = std::make_shared<SwapRange>(this, offset, size, data.size());
+	mesh->_setSwapRecord(new SwapRecord(std::move(range), mesh->_getVertexData().getRevision(), mesh->_getIndexData().getRevision()));
+	return true;
+}
+
+bool MeshSwapFile::pageIn(Mesh * mesh, bool uploadDirectly) {
+	SwapRecord * record = getValidRecord(mesh);
+	if(record == nullptr || record->range->file.get() != this)
+		return false;
+	const std::shared_ptr<SwapRange> range = record->range;
+	MeshVertexData & vd = mesh->_getVertexData();
+	MeshIndexData & id = mesh->_getIndexData();
+	// data that is still uploaded is kept; only its local copy is restored
+	uploadDirectly = uploadDirectly && !vd.isUploaded() && !id.isUploaded();
+
+	std::shared_ptr<MappedFile> currentMapping;
+	std::vector<uint8_t> buffer;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(MappedFile::isSupported() && (mappingOutdated || !mapping)) {
+			mapping = std::make_shared<MappedFile>(path, false);
+			mappingOutdated = false;
+		}
+		if(mapping && mapping->data != nullptr && range->offset + range->dataSize <= mapping->size) {
+			currentMapping = mapping;
+		} else { // read the record without a mapping
+			buffer.resize(range->dataSize);
+			file.seekg(static_cast<std::streamoff>(range->offset));
+			file.read(reinterpret_cast<char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+			if(file.fail()) {
+				file.clear();
+				WARN("MeshSwapFile::pageIn: Could not read from \"" + path + "\".");
+				return false;
+			}
+		}
+		++statistics.pageIns;
+		statistics.bytesRead += range->dataSize;
+	}
+	const uint8_t * data = currentMapping ? currentMapping->data + range->offset : buffer.data();
+	Util::Reference<Mesh> loaded = StreamerMMF::loadMeshFromMemory(data, range->dataSize, uploadDirectly);
+	if(loaded.isNull())
+		return false;
+	MeshVertexData & loadedVertices = loaded->_getVertexData();
+	MeshIndexData & loadedIndices = loaded->_getIndexData();
+	if(loadedVertices.getVertexCount() != vd.getVertexCount() || loadedIndices.getIndexCount() != id.getIndexCount()) {
+		WARN("MeshSwapFile::pageIn: The stored data does not match the mesh.");
+		return false;
+	}
+
+	if(vd.isUploaded()) {
+		if(!vd.hasLocalData())
+			vd._restoreLocalData(std::vector<uint8_t>(loadedVertices.data(), loadedVertices.data() + loadedVertices.dataSize()));
+	} else {
+		vd.swap(loadedVertices);
+	}
+	if(id.isUploaded()) {
+		if(!id.hasLocalData())
+			id._restoreLocalData(std::vector<uint32_t>(loadedIndices.data(), loadedIndices.data() + loadedIndices.getIndexCount()));
+	} else {
+		id.swap(loadedIndices);
+	}
+	// the replaced data has new revisions; the record is shared by copies of the mesh, so a new one is created
+	mesh->_setSwapRecord(new SwapRecord(range, vd.getRevision(), id.getRevision()));
+	mesh->_updateMemoryAccounting();
+	return true;
+}
+
+}
+}
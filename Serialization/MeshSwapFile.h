@@ -0,0 +1,100 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHSWAPFILE_H_
+#define RENDERING_MESHSWAPFILE_H_
+
+#include <Util/ReferenceCounter.h>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace Rendering {
+class MappedFile;
+class Mesh;
+namespace Serialization {
+
+/**
+ * Swap file into which the data of meshes can be paged out, so that neither a local copy nor a buffer object has to be kept.
+ * Every paged out mesh is stored as an MMF record (see StreamerMMF) at a 16 byte aligned offset of the file;
+ * the data is paged in again by mapping the file into memory (and uploading directly from the mapping, if requested).
+ * A mesh keeps its record (see Mesh::_getSwapRecord()) while its data is unchanged, so paging out the same data
+ * again does not write anything. The space of a record is reused when the data changes or the mesh is deleted.
+ *
+ * Used by the BudgetedMeshDataStrategy (see BudgetedMeshDataStrategy::setSwapFile()) for the meshes it evicts.
+ * \code
+ * Util::Reference<Serialization::MeshSwapFile> swapFile = new Serialization::MeshSwapFile("/tmp/meshes.swap");
+ * budgetedStrategy.setSwapFile(swapFile.get());
+ * \endcode
+ * @note The file is created (or truncated) by the constructor and deleted by the destructor.
+ * @note Only meshes with interleaved vertices can be paged out. The swap file may be used from several threads.
+ */
+class MeshSwapFile : public Util::ReferenceCounter<MeshSwapFile> {
+	public:
+		struct Statistics {
+			uint64_t pageOuts;		//!< Meshes written into the file.
+			uint64_t pageIns;		//!< Meshes read from the file.
+			uint64_t bytesWritten;
+			uint64_t bytesRead;
+			Statistics() : pageOuts(0), pageIns(0), bytesWritten(0), bytesRead(0) {}
+		};
+
+		explicit MeshSwapFile(std::string path);
+		~MeshSwapFile();
+
+		//! @c false if the file could not be created.
+		bool isValid() const;
+		const std::string & getPath() const				{	return path;	}
+
+		/*! Store the data of the mesh in the file, unless the file already contains the current data.
+			The local data and the buffer objects of the mesh are not changed; the caller may release them afterwards.
+			@return @c true iff the current data of the mesh is stored in the file. */
+		bool pageOut(Mesh * mesh);
+
+		/*! (static) Return the swap file containing the current data of the mesh, or @c nullptr. */
+		static MeshSwapFile * getSwapFile(Mesh * mesh);
+
+		/*! Restore the data of a mesh stored by pageOut(). If the mesh still has buffer objects, only the local data is restored.
+			Otherwise, the data of the mesh is replaced by the data from the file: with @p uploadDirectly, it is uploaded into new buffer
+			objects from the mapped file without creating a local copy (must be called from the gl-thread).
+			@return @c false if the file does not contain the current data of the mesh or the data could not be read. */
+		bool pageIn(Mesh * mesh, bool uploadDirectly);
+
+		//! Size of the file in bytes.
+		size_t getFileSize() const;
+		//! Bytes of the file used by records.
+		size_t getUsedBytes() const;
+		Statistics getStatistics() const;
+
+		//! (internal) Give a range of the file back; called when a record is deleted.
+		void _releaseRange(size_t offset, size_t size);
+
+	private:
+		const std::string path;
+		mutable std::mutex mutex;
+		std::fstream file;
+		size_t fileSize;
+		size_t usedBytes;
+		std::map<size_t, size_t> freeRanges; //!< offset -> size
+		std::shared_ptr<MappedFile> mapping; //!< shared with pageIn() calls reading from an outdated mapping
+		bool mappingOutdated;
+		Statistics statistics;
+
+		size_t allocateRange(size_t size);
+};
+
+}
+}
+
+#endif /* RENDERING_MESHSWAPFILE_H_ */
@@ -9,6 +9,10 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "Serialization.h"
+#include "CookedMeshCache.h"
+#include "StreamerDDS.h"
+#include "StreamerGLTF.h"
+#include "StreamerKTX.h"
 #include "StreamerMD2.h"
 #include "StreamerMMF.h"
 #include "StreamerMTL.h"
@@ -17,18 +21,24 @@
 #include "StreamerOBJ.h"
 #include "StreamerPKM.h"
 #include "StreamerPLY.h"
+#include "StreamerQMF.h"
 #include "StreamerXYZ.h"
+#include "TextureCache.h"
 #include "../Mesh/Mesh.h"
 #include "../Texture/Texture.h"
+#include "../Texture/TextureUploadQueue.h"
 #include "../Texture/TextureUtils.h"
+#include "../TaskScheduler.h"
 #include <Util/Graphics/Bitmap.h>
 #include <Util/IO/FileName.h>
 #include <Util/IO/FileUtils.h>
 #include <Util/Serialization/Serialization.h>
 #include <Util/GenericAttribute.h>
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <memory>
+#include <vector>
 
 namespace Rendering {
 namespace Serialization {
@@ -54,7 +64,13 @@ const Util::StringIdentifier DESCRIPTION_MATERIAL_SHININESS("shininess");
 static AbstractRenderingStreamer * createStreamer(const std::string & extension, uint8_t capability) {
 	std::string lowerExtension(extension);
 	std::transform(extension.begin(), extension.end(), lowerExtension.begin(), ::tolower);
-	if(StreamerMD2::queryCapabilities(lowerExtension) & capability) {
+	if(StreamerDDS::queryCapabilities(lowerExtension) & capability) {
+		return new StreamerDDS;
+	} else if(StreamerGLTF::queryCapabilities(lowerExtension) & capability) {
+		return new StreamerGLTF;
+	} else if(StreamerKTX::queryCapabilities(lowerExtension) & capability) {
+		return new StreamerKTX;
+	} else if(StreamerMD2::queryCapabilities(lowerExtension) & capability) {
 		return new StreamerMD2;
 	} else if(StreamerMMF::queryCapabilities(lowerExtension) & capability) {
 		return new StreamerMMF;
@@ -70,6 +86,8 @@ static AbstractRenderingStreamer * createStreamer(const std::string & extension,
 		return new StreamerPKM;
 	} else if(StreamerPLY::queryCapabilities(lowerExtension) & capability) {
 		return new StreamerPLY;
+	} else if(StreamerQMF::queryCapabilities(lowerExtension) & capability) {
+		return new StreamerQMF;
 	} else if(StreamerXYZ::queryCapabilities(lowerExtension) & capability) {
 		return new StreamerXYZ;
 	} else {
@@ -78,6 +96,13 @@ static AbstractRenderingStreamer * createStreamer(const std::string & extension,
 }
 
 Mesh * loadMesh(const Util::FileName & url) {
+	CookedMeshCache * cache = getMeshCache();
+	if(cache != nullptr)
+		return cache->loadMesh(url);
+	return _loadMeshUncached(url);
+}
+
+Mesh * _loadMeshUncached(const Util::FileName & url) {
 	std::unique_ptr<AbstractRenderingStreamer> loader(createStreamer(url.getEnding(), AbstractRenderingStreamer::CAP_LOAD_MESH));
 	if(loader.get() == nullptr) {
 		WARN("Unsupported file extension \"" + url.getEnding() + "\".");
@@ -137,6 +162,10 @@ bool saveMesh(Mesh * mesh, const std::string & extension, std::ostream & output)
 }
 
 Util::Reference<Texture> loadTexture(const Util::FileName & url, TextureType tType, uint32_t numLayers) {
+	TextureCache * cache = getTextureCache();
+	if(cache != nullptr)
+		return cache->get(url, tType, numLayers);
+
 	Util::Reference<Texture> texture;
 	
 	std::unique_ptr<AbstractRenderingStreamer> loader(createStreamer(url.getEnding(), AbstractRenderingStreamer::CAP_LOAD_TEXTURE));
@@ -149,7 +178,7 @@ Util::Reference<Texture> loadTexture(const Util::FileName & url, TextureType tTy
 	} else {	// Try Util::Serialization
 		Util::Reference<Util::Bitmap> bitmap = Util::Serialization::loadBitmap(url);
 		if(bitmap)
-			texture = TextureUtils::createTextureFromBitmap(*bitmap.get(), tType, numLayers);
+			texture = TextureUtils::createTextureFromBitmapInPlace(bitmap, tType, numLayers);
 	}
 	if( texture ) 
 		texture->setFileName(url);
@@ -166,12 +195,43 @@ Util::Reference<Texture> loadTexture(const std::string & extension, const std::s
 		// Try Util::Serialization.
 		Util::Reference<Util::Bitmap> bitmap = Util::Serialization::loadBitmap(extension, data);
 		if(bitmap) 
-			return TextureUtils::createTextureFromBitmap(*bitmap.get(), tType, numLayers);
+			return TextureUtils::createTextureFromBitmapInPlace(bitmap, tType, numLayers);
 		WARN("Unsupported file extension \"" + extension + "\".");
 		return nullptr;
 	}
 }
 
+std::vector<Util::Reference<Texture>> loadTextures(const std::vector<Util::FileName> & urls, TextureType tType, uint32_t numLayers, uint32_t numThreads) {
+	std::vector<Util::Reference<Texture>> textures(urls.size());
+	if(numThreads == 0)
+		numThreads = TaskScheduler::get().getConcurrency();
+	numThreads = static_cast<uint32_t>(std::min<std::size_t>(numThreads, urls.size()));
+
+	// The files are taken one by one, as their decoding times differ a lot.
+	std::atomic<std::size_t> nextIndex(0);
+	const auto worker = [&]() {
+		for(std::size_t i = nextIndex++; i < urls.size(); i = nextIndex++)
+			textures[i] = loadTexture(urls[i], tType, numLayers);
+	};
+	TaskScheduler & scheduler = TaskScheduler::get();
+	TaskScheduler::TaskGroup group;
+	for(uint32_t t = 1; t < numThreads; ++t)
+		scheduler.run(group, worker, "Serialization::loadTextures");
+	worker();
+	scheduler.wait(group);
+	return textures;
+}
+
+std::vector<Util::Reference<Texture>> loadTextures(RenderingContext & context, TextureUploadQueue & uploadQueue,
+		const std::vector<Util::FileName> & urls, TextureType tType, uint32_t numLayers, uint32_t numThreads) {
+	std::vector<Util::Reference<Texture>> textures = loadTextures(urls, tType, numLayers, numThreads);
+	for(const auto & texture : textures) {
+		if(texture.isNotNull())
+			uploadQueue.enqueue(context, texture.get());
+	}
+	return textures;
+}
+
 bool saveTexture(RenderingContext & context,Texture * texture, const Util::FileName & url) {
 	if(!texture){
 		WARN("Error saving texture: texture was null");
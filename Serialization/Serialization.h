@@ -16,6 +16,7 @@
 #include <Util/StringIdentifier.h>
 #include <iosfwd>
 #include <string>
+#include <vector>
 
 namespace Util {
 class FileName;
@@ -27,6 +28,7 @@ template<class ObjType> class ReferenceAttribute;
 namespace Rendering {
 class RenderingContext;
 class Texture;
+class TextureUploadQueue;
 
 /**
  * @brief %Serialization functions for objects (meshes, textures etc.)
@@ -65,9 +67,15 @@ extern const Util::StringIdentifier DESCRIPTION_MATERIAL_SHININESS;
  *
  * @param file Address to the file containing the mesh data
  * @return A single mesh
+ * @note If a CookedMeshCache has been set (see setMeshCache()), a cooked copy of the file is used if available.
  */
 Mesh * loadMesh(const Util::FileName & url);
 
+/**
+ * (internal) Load a single mesh from the given address without using the mesh cache (see setMeshCache()).
+ */
+Mesh * _loadMeshUncached(const Util::FileName & url);
+
 /**
  * Create a single mesh from the given data.
  * The type of the mesh has to be given as parameter.
@@ -105,6 +113,8 @@ bool saveMesh(Mesh * mesh, const std::string & extension, std::ostream & output)
  *
  * @param file Address to the file containing the texture data
  * @return A single texture
+ * @note If a TextureCache has been set (see setTextureCache()), the texture is taken from the cache
+ * and may be shared with other callers.
  */
 Util::Reference<Texture> loadTexture(const Util::FileName & url,  TextureType tType  = TextureType::TEXTURE_2D, uint32_t numLayers=1);
 
@@ -118,6 +128,26 @@ Util::Reference<Texture> loadTexture(const Util::FileName & url,  TextureType tT
  */
 Util::Reference<Texture> loadTexture(const std::string & extension, const std::string & data, TextureType tType  = TextureType::TEXTURE_2D, uint32_t numLayers=1);
 
+/**
+ * Load several textures in parallel: the files are read and decoded by @a numThreads worker threads
+ * (0: one per hardware thread) that call loadTexture(const Util::FileName &, TextureType, uint32_t).
+ * No OpenGL calls are made, so this may be called without a current rendering context.
+ *
+ * @param urls Addresses of the files containing the texture data
+ * @return The textures in the order of @a urls; an entry is @c nullptr if the file could not be loaded.
+ * @note The streamers and bitmap loaders are used concurrently and must not keep global state.
+ */
+std::vector<Util::Reference<Texture>> loadTextures(const std::vector<Util::FileName> & urls, TextureType tType = TextureType::TEXTURE_2D,
+		uint32_t numLayers = 1, uint32_t numThreads = 0);
+
+/**
+ * Like loadTextures(const std::vector<Util::FileName> &, TextureType, uint32_t, uint32_t), but the loaded textures are
+ * passed to the given upload queue (on the calling thread), so that their data is uploaded over the next frames.
+ * Textures that cannot be queued are uploaded as usual when they are bound.
+ */
+std::vector<Util::Reference<Texture>> loadTextures(RenderingContext & context, TextureUploadQueue & uploadQueue,
+		const std::vector<Util::FileName> & urls, TextureType tType = TextureType::TEXTURE_2D, uint32_t numLayers = 1, uint32_t numThreads = 0);
+
 /**
  * Write a single texture to the given address.
  * The type of the texture is determined by the file extension.
@@ -0,0 +1,167 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "StreamerDDS.h"
+#include "../Texture/Texture.h"
+#include "../Texture/TextureUtils.h"
+#include "../GLHeader.h"
+#include <Util/Macros.h>
+#include <algorithm>
+#include <cstdint>
+
+namespace Rendering {
+
+const char * const StreamerDDS::fileExtension = "dds";
+
+static const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+static const uint32_t DDPF_FOURCC = 0x4;
+static const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+static const uint32_t DDSCAPS2_VOLUME = 0x200000;
+static const uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+inline static uint32_t makeFourCC(const char code[5]) {
+	return static_cast<uint32_t>(code[0]) | (static_cast<uint32_t>(code[1]) << 8) | (static_cast<uint32_t>(code[2]) << 16) | (static_cast<uint32_t>(code[3]) << 24);
+}
+
+//! (internal) Returns the gl internal format of a (legacy) FourCC code or 0.
+static uint32_t fourCCToGLFormat(uint32_t fourCC) {
+#if defined(GL_EXT_texture_compression_s3tc)
+	if(fourCC == makeFourCC("DXT1"))
+		return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	if(fourCC == makeFourCC("DXT3"))
+		return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+	if(fourCC == makeFourCC("DXT5"))
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+#endif
+#if defined(GL_ARB_texture_compression_rgtc)
+	if(fourCC == makeFourCC("ATI1") || fourCC == makeFourCC("BC4U"))
+		return GL_COMPRESSED_RED_RGTC1;
+	if(fourCC == makeFourCC("BC4S"))
+		return GL_COMPRESSED_SIGNED_RED_RGTC1;
+	if(fourCC == makeFourCC("ATI2") || fourCC == makeFourCC("BC5U"))
+		return GL_COMPRESSED_RG_RGTC2;
+	if(fourCC == makeFourCC("BC5S"))
+		return GL_COMPRESSED_SIGNED_RG_RGTC2;
+#endif
+	return 0;
+}
+
+//! (internal) Returns the gl internal format of a block compressed DXGI_FORMAT or 0.
+static uint32_t dxgiFormatToGLFormat(uint32_t dxgiFormat) {
+	switch(dxgiFormat) {
+#if defined(GL_EXT_texture_compression_s3tc)
+		case 71:	return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;			// DXGI_FORMAT_BC1_UNORM
+		case 74:	return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;			// DXGI_FORMAT_BC2_UNORM
+		case 77:	return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;			// DXGI_FORMAT_BC3_UNORM
+#endif
+#if defined(GL_EXT_texture_sRGB)
+		case 72:	return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;		// DXGI_FORMAT_BC1_UNORM_SRGB
+		case 75:	return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;		// DXGI_FORMAT_BC2_UNORM_SRGB
+		case 78:	return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;		// DXGI_FORMAT_BC3_UNORM_SRGB
+#endif
+#if defined(GL_ARB_texture_compression_rgtc)
+		case 80:	return GL_COMPRESSED_RED_RGTC1;						// DXGI_FORMAT_BC4_UNORM
+		case 81:	return GL_COMPRESSED_SIGNED_RED_RGTC1;				// DXGI_FORMAT_BC4_SNORM
+		case 83:	return GL_COMPRESSED_RG_RGTC2;						// DXGI_FORMAT_BC5_UNORM
+		case 84:	return GL_COMPRESSED_SIGNED_RG_RGTC2;				// DXGI_FORMAT_BC5_SNORM
+#endif
+#if defined(GL_ARB_texture_compression_bptc)
+		case 95:	return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;		// DXGI_FORMAT_BC6H_UF16
+		case 96:	return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;			// DXGI_FORMAT_BC6H_SF16
+		case 98:	return GL_COMPRESSED_RGBA_BPTC_UNORM;				// DXGI_FORMAT_BC7_UNORM
+		case 99:	return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;			// DXGI_FORMAT_BC7_UNORM_SRGB
+#endif
+		default:
+			return 0;
+	}
+}
+
+Util::Reference<Texture> StreamerDDS::loadTexture(std::istream & input, TextureType type, uint32_t numLayers){
+	struct DDSHeader {
+		uint32_t size, flags, height, width, pitchOrLinearSize, depth, mipMapCount;
+		uint32_t reserved1[11];
+		uint32_t pfSize, pfFlags, pfFourCC, pfRGBBitCount, pfRBitMask, pfGBitMask, pfBBitMask, pfABitMask;
+		uint32_t caps, caps2, caps3, caps4, reserved2;
+	};
+	struct DDSHeaderDX10 {
+		uint32_t dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2;
+	};
+
+	char magic[4];
+	input.read(magic, 4);
+	DDSHeader header;
+	input.read(reinterpret_cast<char *>(&header), sizeof(DDSHeader));
+	if(!input.good() || !std::equal(magic, magic + 4, "DDS ") || header.size != sizeof(DDSHeader)) {
+		WARN("StreamerDDS: Invalid DDS header.");
+		return nullptr;
+	}
+	if((header.caps2 & DDSCAPS2_VOLUME) != 0) {
+		WARN("StreamerDDS: Volume textures are not supported.");
+		return nullptr;
+	}
+	if((header.pfFlags & DDPF_FOURCC) == 0) {
+		WARN("StreamerDDS: Only block compressed DDS files are supported.");
+		return nullptr;
+	}
+
+	uint32_t glInternalFormat = 0;
+	uint32_t arraySize = 1;
+	bool cubeMap = (header.caps2 & DDSCAPS2_CUBEMAP) != 0;
+	if(header.pfFourCC == makeFourCC("DX10")) {
+		DDSHeaderDX10 headerDX10;
+		input.read(reinterpret_cast<char *>(&headerDX10), sizeof(DDSHeaderDX10));
+		glInternalFormat = dxgiFormatToGLFormat(headerDX10.dxgiFormat);
+		arraySize = std::max(1u, headerDX10.arraySize);
+		cubeMap = (headerDX10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE) != 0;
+	} else {
+		glInternalFormat = fourCCToGLFormat(header.pfFourCC);
+	}
+	if(glInternalFormat == 0) {
+		WARN("StreamerDDS: Unsupported compressed format.");
+		return nullptr;
+	}
+
+	const uint32_t fileLayers = arraySize * (cubeMap ? 6 : 1);
+	const TextureType fileType = cubeMap ? (arraySize > 1 ? TextureType::TEXTURE_CUBE_MAP_ARRAY : TextureType::TEXTURE_CUBE_MAP) :
+											(arraySize > 1 ? TextureType::TEXTURE_2D_ARRAY : TextureType::TEXTURE_2D);
+	if((type != TextureType::TEXTURE_2D || numLayers != 1) && (type != fileType || numLayers != fileLayers)) {
+		WARN("StreamerDDS: The requested texture type does not match the file.");
+		return nullptr;
+	}
+	const uint32_t numLevels = (header.flags & DDSD_MIPMAPCOUNT) != 0 ? std::max(1u, header.mipMapCount) : 1;
+
+	Util::Reference<Texture> texture = TextureUtils::createCompressedTexture(fileType, header.width, header.height, fileLayers, glInternalFormat, numLevels);
+	if(!texture || !texture->getLocalData())
+		return nullptr;
+
+	// DDS stores all levels of a layer (face) consecutively; the texture's local data stores all layers of a level consecutively.
+	const Texture::Format & format = texture->getFormat();
+	for(uint32_t layer = 0; layer < fileLayers; ++layer) {
+		for(uint32_t level = 0; level < numLevels; ++level) {
+			const uint32_t layerSize = format.getLevelDataSize(level) / fileLayers;
+			input.read(reinterpret_cast<char *>(texture->getLocalData() + format.getLevelDataOffset(level) + layer * layerSize), layerSize);
+		}
+	}
+	if(!input.good()) {
+		WARN("StreamerDDS: Unexpected end of file.");
+		return nullptr;
+	}
+	return texture;
+}
+
+uint8_t StreamerDDS::queryCapabilities(const std::string & extension) {
+	if(extension == fileExtension) {
+		return CAP_LOAD_TEXTURE;
+	} else {
+		return 0;
+	}
+}
+
+}
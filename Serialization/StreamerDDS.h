@@ -0,0 +1,43 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_STREAMERDDS_H_
+#define RENDERING_STREAMERDDS_H_
+
+#include "AbstractRenderingStreamer.h"
+
+namespace Rendering {
+
+/**
+ * Loader for block compressed DirectDraw Surface files (DXT1/3/5, ATI1/2 and BC1-BC7 with DX10 header).
+ * All stored mipmap levels are loaded; array textures and cube maps (and cube map arrays) are supported.
+ * The texture type is defined by the file. If @a loadTexture is called with a type other than
+ * TEXTURE_2D with one layer, the file has to match that type.
+ *
+ * @note Uncompressed and volume DDS files are not supported.
+ * @see https://docs.microsoft.com/windows/win32/direct3ddds/dx-graphics-dds-pguide
+ */
+class StreamerDDS : public AbstractRenderingStreamer {
+	public:
+		StreamerDDS() :
+			AbstractRenderingStreamer() {
+		}
+		virtual ~StreamerDDS() {
+		}
+
+		Util::Reference<Texture> loadTexture(std::istream & input, TextureType, uint32_t numLayers) override;
+
+		static uint8_t queryCapabilities(const std::string & extension);
+		static const char * const fileExtension;
+};
+
+}
+
+#endif /* RENDERING_STREAMERDDS_H_ */
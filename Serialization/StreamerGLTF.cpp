@@ -0,0 +1,726 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "StreamerGLTF.h"
+#include "Serialization.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexDescription.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+#include "internal/MappedFile.h"
+#include "internal/TextParsing.h"
+#include <Geometry/Box.h>
+#include <Util/GenericAttribute.h>
+#include <Util/Macros.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Rendering {
+
+const char * const StreamerGLTF::fileExtension = "glb";
+const char * const StreamerGLTF::fileExtensionText = "gltf";
+
+namespace {
+static const uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+static const uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+static const uint32_t GLB_CHUNK_BIN = 0x004E4942; // "BIN\0"
+
+//! Value of a JSON document. Object members are stored in @a values with their names in @a keys.
+struct JSONValue {
+	enum type_t { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+	type_t type;
+	double number;
+	std::string string;
+	std::vector<std::string> keys;
+	std::vector<JSONValue> values;
+
+	JSONValue() : type(NUL), number(0.0) {}
+
+	const JSONValue * get(const std::string & key) const {
+		for(size_t i = 0; i < keys.size(); ++i) {
+			if(keys[i] == key)
+				return &values[i];
+		}
+		return nullptr;
+	}
+	const JSONValue * at(size_t index) const {
+		return (type == ARRAY && index < values.size()) ? &values[index] : nullptr;
+	}
+	double getNumber(const std::string & key, double defaultValue) const {
+		const JSONValue * value = get(key);
+		return (value != nullptr && value->type == NUMBER) ? value->number : defaultValue;
+	}
+	std::string getString(const std::string & key) const {
+		const JSONValue * value = get(key);
+		return (value != nullptr && value->type == STRING) ? value->string : std::string();
+	}
+	bool getBool(const std::string & key, bool defaultValue) const {
+		const JSONValue * value = get(key);
+		return (value != nullptr && value->type == BOOLEAN) ? value->number != 0.0 : defaultValue;
+	}
+};
+
+//! Recursive descent parser for the JSON part of a glTF file.
+class JSONParser {
+	public:
+		JSONParser(const char * begin, const char * _end) : cursor(begin), end(_end) {}
+
+		bool parse(JSONValue & value) {
+			if(!parseValue(value, 0))
+				return false;
+			skipWhitespace();
+			return cursor == end || *cursor == '\0'; // the json chunk of a glb file may be padded with spaces or zeros
+		}
+
+	private:
+		static const uint32_t MAX_DEPTH = 128;
+		const char * cursor;
+		const char * end;
+
+		void skipWhitespace() {
+			while(cursor != end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r'))
+				++cursor;
+		}
+		bool consume(const char * token) {
+			const size_t length = std::strlen(token);
+			if(static_cast<size_t>(end - cursor) < length || std::strncmp(cursor, token, length) != 0)
+				return false;
+			cursor += length;
+			return true;
+		}
+		bool parseValue(JSONValue & value, uint32_t depth) {
+			skipWhitespace();
+			if(cursor == end || depth > MAX_DEPTH)
+				return false;
+			switch(*cursor) {
+				case '{': {
+					value.type = JSONValue::OBJECT;
+					++cursor;
+					skipWhitespace();
+					if(cursor != end && *cursor == '}') {
+						++cursor;
+						return true;
+					}
+					while(true) {
+						std::string key;
+						skipWhitespace();
+						if(!parseString(key))
+							return false;
+						skipWhitespace();
+						if(cursor == end || *cursor != ':')
+							return false;
+						++cursor;
+						value.keys.push_back(std::move(key));
+						value.values.emplace_back();
+						if(!parseValue(value.values.back(), depth + 1))
+							return false;
+						skipWhitespace();
+						if(cursor != end && *cursor == ',') {
+							++cursor;
+						} else if(cursor != end && *cursor == '}') {
+							++cursor;
+							return true;
+						} else {
+							return false;
+						}
+					}
+				}
+				case '[': {
+					value.type = JSONValue::ARRAY;
+					++cursor;
+					skipWhitespace();
+					if(cursor != end && *cursor == ']') {
+						++cursor;
+						return true;
+					}
+					while(true) {
+						value.values.emplace_back();
+						if(!parseValue(value.values.back(), depth + 1))
+							return false;
+						skipWhitespace();
+						if(cursor != end && *cursor == ',') {
+							++cursor;
+						} else if(cursor != end && *cursor == ']') {
+							++cursor;
+							return true;
+						} else {
+							return false;
+						}
+					}
+				}
+				case '"':
+					value.type = JSONValue::STRING;
+					return parseString(value.string);
+				case 't':
+					value.type = JSONValue::BOOLEAN;
+					value.number = 1.0;
+					return consume("true");
+				case 'f':
+					value.type = JSONValue::BOOLEAN;
+					return consume("false");
+				case 'n':
+					return consume("null");
+				default:
+					value.type = JSONValue::NUMBER;
+					return parseNumber(value.number);
+			}
+		}
+		bool parseNumber(double & number) {
+			// integers (e.g. byte offsets) are parsed exactly; other numbers with TextParsing::parseFloat
+			const char * c = cursor;
+			if(c != end && *c == '-')
+				++c;
+			const char * digits = c;
+			uint64_t integer = 0;
+			for(; c != end && *c >= '0' && *c <= '9'; ++c)
+				integer = integer * 10 + static_cast<uint64_t>(*c - '0');
+			if(c == digits)
+				return false;
+			if(c == end || (*c != '.' && *c != 'e' && *c != 'E')) {
+				number = (*cursor == '-') ? -static_cast<double>(integer) : static_cast<double>(integer);
+				cursor = c;
+				return true;
+			}
+			number = TextParsing::parseFloat(cursor, end);
+			return true;
+		}
+		static void appendUTF8(std::string & s, uint32_t codePoint) {
+			if(codePoint < 0x80) {
+				s += static_cast<char>(codePoint);
+			} else if(codePoint < 0x800) {
+				s += static_cast<char>(0xC0 | (codePoint >> 6));
+				s += static_cast<char>(0x80 | (codePoint & 0x3F));
+			} else if(codePoint < 0x10000) {
+				s += static_cast<char>(0xE0 | (codePoint >> 12));
+				s += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				s += static_cast<char>(0x80 | (codePoint & 0x3F));
+			} else {
+				s += static_cast<char>(0xF0 | (codePoint >> 18));
+				s += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+				s += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				s += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+		}
+		bool parseHex4(uint32_t & value) {
+			if(end - cursor < 4)
+				return false;
+			value = 0;
+			for(int i = 0; i < 4; ++i, ++cursor) {
+				const char c = *cursor;
+				value <<= 4;
+				if(c >= '0' && c <= '9')
+					value |= static_cast<uint32_t>(c - '0');
+				else if(c >= 'a' && c <= 'f')
+					value |= static_cast<uint32_t>(c - 'a' + 10);
+				else if(c >= 'A' && c <= 'F')
+					value |= static_cast<uint32_t>(c - 'A' + 10);
+				else
+					return false;
+			}
+			return true;
+		}
+		bool parseString(std::string & s) {
+			if(cursor == end || *cursor != '"')
+				return false;
+			++cursor;
+			while(cursor != end && *cursor != '"') {
+				if(*cursor != '\\') {
+					s += *cursor++;
+					continue;
+				}
+				if(++cursor == end)
+					return false;
+				const char c = *cursor++;
+				switch(c) {
+					case 'b':	s += '\b';	break;
+					case 'f':	s += '\f';	break;
+					case 'n':	s += '\n';	break;
+					case 'r':	s += '\r';	break;
+					case 't':	s += '\t';	break;
+					case 'u': {
+						uint32_t codePoint;
+						if(!parseHex4(codePoint))
+							return false;
+						if(codePoint >= 0xD800 && codePoint < 0xDC00 && consume("\\u")) { // surrogate pair
+							uint32_t low;
+							if(!parseHex4(low) || low < 0xDC00 || low >= 0xE000)
+								return false;
+							codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+						}
+						appendUTF8(s, codePoint);
+						break;
+					}
+					default: // '"', '\\', '/'
+						s += c;
+						break;
+				}
+			}
+			if(cursor == end)
+				return false;
+			++cursor;
+			return true;
+		}
+};
+
+bool decodeBase64(const std::string & input, size_t begin, std::vector<uint8_t> & output) {
+	uint32_t buffer = 0;
+	int bits = 0;
+	for(size_t i = begin; i < input.size(); ++i) {
+		const char c = input[i];
+		uint32_t value;
+		if(c >= 'A' && c <= 'Z')
+			value = static_cast<uint32_t>(c - 'A');
+		else if(c >= 'a' && c <= 'z')
+			value = static_cast<uint32_t>(c - 'a' + 26);
+		else if(c >= '0' && c <= '9')
+			value = static_cast<uint32_t>(c - '0' + 52);
+		else if(c == '+')
+			value = 62;
+		else if(c == '/')
+			value = 63;
+		else if(c == '=')
+			break;
+		else
+			return false;
+		buffer = (buffer << 6) | value;
+		bits += 6;
+		if(bits >= 8) {
+			bits -= 8;
+			output.push_back(static_cast<uint8_t>(buffer >> bits));
+		}
+	}
+	return true;
+}
+
+struct BufferRange {
+	const uint8_t * data;
+	size_t size;
+	BufferRange() : data(nullptr), size(0) {}
+	BufferRange(const uint8_t * _data, size_t _size) : data(_data), size(_size) {}
+};
+
+//! Location of an accessor's elements in the (mapped) buffer data.
+struct AccessorData {
+	const uint8_t * data;	//!< first element
+	const uint8_t * bufferEnd;
+	int32_t bufferView;
+	uint32_t count;
+	uint32_t componentType;
+	uint32_t numComponents;
+	bool normalized;
+	size_t stride;
+	size_t elementSize;
+	const JSONValue * accessor;
+};
+
+bool getAccessor(const JSONValue & root, const std::vector<BufferRange> & buffers, double index, AccessorData & result) {
+	static const std::string warningPrefix("StreamerGLTF: ");
+	const JSONValue * accessors = root.get("accessors");
+	const JSONValue * accessor = accessors != nullptr ? accessors->at(static_cast<size_t>(index)) : nullptr;
+	if(accessor == nullptr || index < 0) {
+		WARN(warningPrefix + "Invalid accessor.");
+		return false;
+	}
+	if(accessor->get("sparse") != nullptr) {
+		WARN(warningPrefix + "Sparse accessors are not supported.");
+		return false;
+	}
+	const JSONValue * bufferViews = root.get("bufferViews");
+	const double viewIndex = accessor->getNumber("bufferView", -1);
+	const JSONValue * view = (bufferViews != nullptr && viewIndex >= 0) ? bufferViews->at(static_cast<size_t>(viewIndex)) : nullptr;
+	if(view == nullptr) {
+		WARN(warningPrefix + "Accessors without buffer view are not supported.");
+		return false;
+	}
+	const double bufferIndex = view->getNumber("buffer", -1);
+	if(bufferIndex < 0 || bufferIndex >= buffers.size() || buffers[static_cast<size_t>(bufferIndex)].data == nullptr) {
+		WARN(warningPrefix + "Missing buffer data.");
+		return false;
+	}
+	const BufferRange & buffer = buffers[static_cast<size_t>(bufferIndex)];
+
+	const std::string type = accessor->getString("type");
+	if(type == "SCALAR")
+		result.numComponents = 1;
+	else if(type == "VEC2")
+		result.numComponents = 2;
+	else if(type == "VEC3")
+		result.numComponents = 3;
+	else if(type == "VEC4")
+		result.numComponents = 4;
+	else {
+		WARN(warningPrefix + "Unsupported accessor type \"" + type + "\".");
+		return false;
+	}
+	result.componentType = static_cast<uint32_t>(accessor->getNumber("componentType", 0));
+	switch(result.componentType) { // the glTF constants are the OpenGL ones
+		case GL_BYTE:
+		case GL_UNSIGNED_BYTE:
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+		case GL_UNSIGNED_INT:
+		case GL_FLOAT:
+			break;
+		default:
+			WARN(warningPrefix + "Unsupported component type.");
+			return false;
+	}
+	result.count = static_cast<uint32_t>(accessor->getNumber("count", 0));
+	result.normalized = accessor->getBool("normalized", false);
+	result.elementSize = getGLTypeSize(result.componentType) * result.numComponents;
+	result.stride = static_cast<size_t>(view->getNumber("byteStride", 0));
+	if(result.stride == 0)
+		result.stride = result.elementSize;
+	result.bufferView = static_cast<int32_t>(viewIndex);
+	result.accessor = accessor;
+
+	const uint64_t viewOffset = static_cast<uint64_t>(view->getNumber("byteOffset", 0));
+	const uint64_t viewLength = static_cast<uint64_t>(view->getNumber("byteLength", 0));
+	const uint64_t offset = static_cast<uint64_t>(accessor->getNumber("byteOffset", 0));
+	const uint64_t requiredLength = result.count == 0 ? 0 : offset + result.stride * (result.count - 1) + result.elementSize;
+	if(viewOffset + viewLength > buffer.size || requiredLength > viewLength) {
+		WARN(warningPrefix + "Accessor exceeds its buffer.");
+		return false;
+	}
+	result.data = buffer.data + viewOffset + offset;
+	result.bufferEnd = buffer.data + buffer.size;
+	return true;
+}
+
+//! A vertex attribute of a primitive and the accessor containing its values.
+struct PrimitiveAttribute {
+	std::string name;
+	AccessorData data;
+	uint8_t numValues;		//!< number of components including the padding to four bytes
+	bool convertToFloat;
+};
+
+std::string getAttributeName(const std::string & semantic, bool & convertToFloat) {
+	convertToFloat = true;
+	if(semantic == "POSITION")
+		return VertexAttributeIds::POSITION.toString();
+	else if(semantic == "NORMAL")
+		return VertexAttributeIds::NORMAL.toString();
+	else if(semantic == "TANGENT")
+		return VertexAttributeIds::TANGENT.toString();
+	else if(semantic == "COLOR_0")
+		return VertexAttributeIds::COLOR.toString();
+	else if(semantic.compare(0, 9, "TEXCOORD_") == 0 && semantic.size() == 10 && semantic[9] >= '0' && semantic[9] <= '7')
+		return VertexAttributeIds::getTextureCoordinateIdentifier(static_cast<uint_fast8_t>(semantic[9] - '0')).toString();
+	convertToFloat = semantic.compare(0, 7, "JOINTS_") != 0;
+	return semantic;
+}
+
+Mesh * createMesh(const JSONValue & root, const JSONValue & primitive, const std::vector<BufferRange> & buffers, bool uploadDirectly) {
+	static const std::string warningPrefix("StreamerGLTF: ");
+	const uint32_t mode = static_cast<uint32_t>(primitive.getNumber("mode", 4));
+	if(mode != GL_POINTS && mode != GL_LINES && mode != GL_LINE_LOOP && mode != GL_LINE_STRIP && mode != GL_TRIANGLES) {
+		WARN(warningPrefix + "Unsupported primitive mode.");
+		return nullptr;
+	}
+	const JSONValue * attributeMap = primitive.get("attributes");
+	if(attributeMap == nullptr || attributeMap->type != JSONValue::OBJECT || attributeMap->values.empty()) {
+		WARN(warningPrefix + "Primitive without attributes.");
+		return nullptr;
+	}
+
+	std::vector<PrimitiveAttribute> attributes;
+	for(size_t i = 0; i < attributeMap->keys.size(); ++i) {
+		PrimitiveAttribute attr;
+		if(attributeMap->values[i].type != JSONValue::NUMBER || !getAccessor(root, buffers, attributeMap->values[i].number, attr.data))
+			return nullptr;
+		attr.name = getAttributeName(attributeMap->keys[i], attr.convertToFloat);
+		// vertex attribute elements are aligned to four bytes; the padding becomes additional components
+		const size_t componentSize = getGLTypeSize(attr.data.componentType);
+		attr.numValues = static_cast<uint8_t>(((attr.data.elementSize + 3) / 4 * 4) / componentSize);
+		if(!attributes.empty() && attr.data.count != attributes.front().data.count) {
+			WARN(warningPrefix + "Vertex attributes with differing counts.");
+			return nullptr;
+		}
+		attributes.push_back(std::move(attr));
+	}
+	// store the attributes in the order of their data, so interleaved data matches the vertex description
+	std::sort(attributes.begin(), attributes.end(), [](const PrimitiveAttribute & a, const PrimitiveAttribute & b) {
+		return a.data.data < b.data.data;
+	});
+
+	VertexDescription vd;
+	for(const auto & attr : attributes)
+		vd.appendAttribute(attr.name, attr.numValues, attr.data.componentType, attr.data.normalized, attr.convertToFloat);
+	const uint32_t vertexCount = attributes.front().data.count;
+
+	// bounding box from the accessor of float positions
+	Geometry::Box box;
+	bool hasBox = false;
+	for(const auto & attr : attributes) {
+		if(attr.name != VertexAttributeIds::POSITION.toString() || attr.data.componentType != GL_FLOAT || attr.data.numComponents != 3)
+			continue;
+		const JSONValue * min = attr.data.accessor->get("min");
+		const JSONValue * max = attr.data.accessor->get("max");
+		if(min != nullptr && max != nullptr && min->type == JSONValue::ARRAY && max->type == JSONValue::ARRAY &&
+				min->values.size() == 3 && max->values.size() == 3) {
+			box = Geometry::Box(min->values[0].number, max->values[0].number, min->values[1].number, max->values[1].number,
+								min->values[2].number, max->values[2].number);
+			hasBox = true;
+		}
+	}
+
+	Util::Reference<Mesh> mesh = new Mesh;
+	mesh->setGLDrawMode(mode);
+	MeshVertexData & vertices = mesh->_getVertexData();
+
+	// interleaved: all attributes of one buffer view at the offsets of the vertex description
+	const uint8_t * base = attributes.front().data.data;
+	bool interleaved = true;
+	for(size_t i = 0; i < attributes.size() && interleaved; ++i) {
+		const AccessorData & data = attributes[i].data;
+		interleaved = data.bufferView == attributes.front().data.bufferView && data.stride == vd.getVertexSize() &&
+				static_cast<size_t>(data.data - base) == vd.getAttributes()[i].getOffset() &&
+				static_cast<size_t>(data.bufferEnd - base) >= vd.getVertexSize() * vertexCount;
+	}
+	if(interleaved) {
+		if(!uploadDirectly || !vertices._uploadExternal(vertexCount, vd, base, GL_STATIC_DRAW, hasBox ? &box : nullptr)) {
+			vertices.allocate(vertexCount, vd);
+			std::copy(base, base + vertices.dataSize(), vertices.data());
+			if(hasBox)
+				vertices._setBoundingBox(box);
+			else
+				vertices.updateBoundingBox();
+		}
+	} else {
+		vertices.setLayout(MeshVertexData::SEPARATE);
+		vertices.allocate(vertexCount, vd);
+		uint8_t * target = vertices.data();
+		for(size_t i = 0; i < attributes.size(); ++i) {
+			const AccessorData & data = attributes[i].data;
+			const VertexAttribute & attr = vd.getAttributes()[i];
+			uint8_t * attrTarget = target + vertices.getAttributeOffset(attr);
+			if(data.stride == attr.getDataSize()) {
+				std::copy(data.data, data.data + static_cast<size_t>(attr.getDataSize()) * vertexCount, attrTarget);
+			} else {
+				const size_t copySize = std::min(data.stride, static_cast<size_t>(attr.getDataSize()));
+				for(uint32_t v = 0; v < vertexCount; ++v)
+					std::copy(data.data + data.stride * v, data.data + data.stride * v + copySize, attrTarget + attr.getDataSize() * v);
+			}
+		}
+		if(hasBox)
+			vertices._setBoundingBox(box);
+		else
+			vertices.updateBoundingBox();
+	}
+
+	// indices
+	const JSONValue * indicesIndex = primitive.get("indices");
+	if(indicesIndex == nullptr) {
+		mesh->setUseIndexData(false);
+		return mesh.detachAndDecrease();
+	}
+	AccessorData indexData;
+	if(indicesIndex->type != JSONValue::NUMBER || !getAccessor(root, buffers, indicesIndex->number, indexData) || indexData.numComponents != 1 ||
+			(indexData.componentType != GL_UNSIGNED_INT && indexData.componentType != GL_UNSIGNED_SHORT && indexData.componentType != GL_UNSIGNED_BYTE)) {
+		WARN(warningPrefix + "Invalid index accessor.");
+		return nullptr;
+	}
+	mesh->setUseIndexData(true);
+	MeshIndexData & indices = mesh->_getIndexData();
+	const bool packed32 = indexData.componentType == GL_UNSIGNED_INT && indexData.stride == sizeof(uint32_t) &&
+			reinterpret_cast<uintptr_t>(indexData.data) % alignof(uint32_t) == 0;
+	if(packed32 && uploadDirectly && indices._uploadExternal(indexData.count, reinterpret_cast<const uint32_t *>(indexData.data), GL_STATIC_DRAW))
+		return mesh.detachAndDecrease();
+	indices.allocate(indexData.count);
+	uint32_t * target = indices.data();
+	if(indexData.componentType == GL_UNSIGNED_INT && indexData.stride == sizeof(uint32_t)) {
+		std::memcpy(target, indexData.data, indexData.count * sizeof(uint32_t));
+	} else {
+		for(uint32_t i = 0; i < indexData.count; ++i) {
+			const uint8_t * element = indexData.data + indexData.stride * i;
+			if(indexData.componentType == GL_UNSIGNED_BYTE) {
+				target[i] = *element;
+			} else if(indexData.componentType == GL_UNSIGNED_SHORT) {
+				uint16_t value;
+				std::memcpy(&value, element, sizeof(value));
+				target[i] = value;
+			} else {
+				std::memcpy(target + i, element, sizeof(uint32_t));
+			}
+		}
+	}
+	indices.updateIndexRange();
+	return mesh.detachAndDecrease();
+}
+
+/*! Load the primitives of the meshes of a .glb or .gltf file.
+	@param maxPrimitives Maximum number of primitives to load. */
+std::vector<Util::Reference<Mesh>> loadPrimitives(const uint8_t * data, size_t size, bool uploadDirectly, size_t maxPrimitives) {
+	static const std::string warningPrefix("StreamerGLTF: ");
+	std::vector<Util::Reference<Mesh>> meshes;
+
+	const char * jsonBegin = reinterpret_cast<const char *>(data);
+	const char * jsonEnd = jsonBegin + size;
+	BufferRange binaryChunk;
+	uint32_t header[3];
+	if(size >= sizeof(header)) {
+		std::memcpy(header, data, sizeof(header));
+	}
+	if(size >= sizeof(header) && header[0] == GLB_MAGIC) {
+		if(header[1] != 2) {
+			WARN(warningPrefix + "Unsupported glb version.");
+			return meshes;
+		}
+		jsonBegin = jsonEnd = nullptr;
+		size_t offset = sizeof(header);
+		const size_t length = std::min<size_t>(size, header[2]);
+		while(length - offset >= 2 * sizeof(uint32_t)) {
+			uint32_t chunk[2]; // length, type
+			std::memcpy(chunk, data + offset, sizeof(chunk));
+			offset += sizeof(chunk);
+			if(chunk[0] > length - offset)
+				break;
+			if(chunk[1] == GLB_CHUNK_JSON && jsonBegin == nullptr) {
+				jsonBegin = reinterpret_cast<const char *>(data + offset);
+				jsonEnd = jsonBegin + chunk[0];
+			} else if(chunk[1] == GLB_CHUNK_BIN && binaryChunk.data == nullptr) {
+				binaryChunk = BufferRange(data + offset, chunk[0]);
+			}
+			offset += (chunk[0] + 3) / 4 * 4;
+			offset = std::min(offset, length);
+		}
+		if(jsonBegin == nullptr) {
+			WARN(warningPrefix + "Missing JSON chunk.");
+			return meshes;
+		}
+	}
+
+	JSONValue root;
+	if(!JSONParser(jsonBegin, jsonEnd).parse(root) || root.type != JSONValue::OBJECT) {
+		WARN(warningPrefix + "Invalid JSON data.");
+		return meshes;
+	}
+	if(const JSONValue * required = root.get("extensionsRequired")) {
+		for(const auto & extension : required->values) {
+			if(extension.string == "KHR_draco_mesh_compression" || extension.string == "EXT_meshopt_compression" ||
+					extension.string == "KHR_meshopt_compression") {
+				WARN(warningPrefix + "Unsupported extension \"" + extension.string + "\".");
+				return meshes;
+			}
+		}
+	}
+
+	// buffers: the binary chunk of a glb file or embedded data
+	std::vector<BufferRange> buffers;
+	std::vector<std::vector<uint8_t>> decodedBuffers;
+	if(const JSONValue * bufferList = root.get("buffers")) {
+		decodedBuffers.reserve(bufferList->values.size()); // the ranges point into the decoded data
+		for(size_t i = 0; i < bufferList->values.size(); ++i) {
+			const JSONValue & buffer = bufferList->values[i];
+			const std::string uri = buffer.getString("uri");
+			const size_t byteLength = static_cast<size_t>(buffer.getNumber("byteLength", 0));
+			if(uri.empty() && i == 0 && binaryChunk.data != nullptr) {
+				buffers.emplace_back(binaryChunk.data, std::min(byteLength, binaryChunk.size));
+			} else if(uri.compare(0, 5, "data:") == 0 && uri.find(";base64,") != std::string::npos) {
+				decodedBuffers.emplace_back();
+				if(!decodeBase64(uri, uri.find(";base64,") + 8, decodedBuffers.back()))
+					WARN(warningPrefix + "Invalid data URI.");
+				buffers.emplace_back(decodedBuffers.back().data(), std::min(byteLength, decodedBuffers.back().size()));
+			} else {
+				WARN(warningPrefix + "External buffers are not supported (\"" + uri + "\").");
+				buffers.emplace_back();
+			}
+		}
+	}
+
+	const JSONValue * meshList = root.get("meshes");
+	if(meshList == nullptr)
+		return meshes;
+	for(const auto & meshValue : meshList->values) {
+		const JSONValue * primitives = meshValue.get("primitives");
+		if(primitives == nullptr)
+			continue;
+		for(const auto & primitive : primitives->values) {
+			if(meshes.size() >= maxPrimitives)
+				return meshes;
+			Util::Reference<Mesh> mesh = createMesh(root, primitive, buffers, uploadDirectly);
+			if(mesh.isNotNull())
+				meshes.push_back(mesh);
+		}
+	}
+	return meshes;
+}
+
+std::vector<uint8_t> readStream(std::istream & input) {
+	std::vector<uint8_t> buffer;
+	static const size_t blockSize = 1024 * 1024;
+	size_t size = 0;
+	while(input.good()) {
+		buffer.resize(size + blockSize);
+		input.read(reinterpret_cast<char *>(buffer.data() + size), blockSize);
+		size += static_cast<size_t>(input.gcount());
+	}
+	buffer.resize(size);
+	return buffer;
+}
+}
+
+Util::GenericAttributeList * StreamerGLTF::loadGeneric(std::istream & input) {
+	const std::vector<uint8_t> data = readStream(input);
+	auto meshes = loadPrimitives(data.data(), data.size(), false, std::numeric_limits<size_t>::max());
+	if(meshes.empty())
+		return nullptr;
+	auto list = new Util::GenericAttributeList;
+	for(const auto & mesh : meshes)
+		list->push_back(Serialization::createMeshDescription(mesh.get()));
+	return list;
+}
+
+Mesh * StreamerGLTF::loadMesh(std::istream & input) {
+	const std::vector<uint8_t> data = readStream(input);
+	auto meshes = loadPrimitives(data.data(), data.size(), false, 1);
+	return meshes.empty() ? nullptr : meshes.front().detachAndDecrease();
+}
+
+//!	(static)
+Mesh * StreamerGLTF::loadMeshMapped(const std::string & localPath, bool uploadDirectly) {
+	if(!MappedFile::isSupported()) {
+		std::ifstream input(localPath.c_str(), std::ios_base::in | std::ios_base::binary);
+		if(!input.good()) {
+			WARN("StreamerGLTF::loadMeshMapped: Could not open file \"" + localPath + "\".");
+			return nullptr;
+		}
+		StreamerGLTF streamer;
+		return streamer.loadMesh(input);
+	}
+	MappedFile file(localPath);
+	if(file.data == nullptr) {
+		WARN("StreamerGLTF::loadMeshMapped: Could not map file \"" + localPath + "\".");
+		return nullptr;
+	}
+	auto meshes = loadPrimitives(file.data, file.size, uploadDirectly, 1);
+	return meshes.empty() ? nullptr : meshes.front().detachAndDecrease();
+}
+
+uint8_t StreamerGLTF::queryCapabilities(const std::string & extension) {
+	if(extension == fileExtension || extension == fileExtensionText) {
+		return CAP_LOAD_MESH | CAP_LOAD_GENERIC;
+	} else {
+		return 0;
+	}
+}
+
+}
@@ -0,0 +1,63 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_STREAMERGLTF_H_
+#define RENDERING_STREAMERGLTF_H_
+
+#include "AbstractRenderingStreamer.h"
+#include <cstdint>
+#include <string>
+
+namespace Rendering {
+
+/**
+ * Loader for glTF 2.0 files: binary .glb files and .gltf files whose buffers are embedded as data URIs.
+ * Every primitive of the file's meshes is loaded as a separate mesh; node transformations, materials and
+ * animations are ignored.
+ *
+ * The vertex attributes are not converted: each accessor becomes a vertex attribute of the same component type
+ * (including the quantized types allowed by KHR_mesh_quantization), so the data is copied as a whole.
+ * If all attributes are interleaved in one buffer view in a layout matching the VertexDescription, the vertices are
+ * copied (or uploaded) with a single call; attributes of separate buffer views are stored in the
+ * MeshVertexData::SEPARATE layout with one copy per attribute. The bounding box is taken from the accessor's
+ * min and max values for float positions. Indices of 8 or 16 bits are widened to 32 bits.
+ *
+ * Attribute names: POSITION, NORMAL, TANGENT, COLOR_0 and TEXCOORD_0 to TEXCOORD_7 are mapped to the corresponding
+ * VertexAttributeIds; other attributes keep their glTF name (JOINTS_n are integer attributes).
+ * \note Sparse accessors, external buffers and mesh compression extensions are not supported.
+ * \note Quantized files usually rely on the node transformation for dequantization, which has to be applied by the caller.
+ */
+class StreamerGLTF : public AbstractRenderingStreamer {
+	public:
+		StreamerGLTF() :
+			AbstractRenderingStreamer() {
+		}
+		virtual ~StreamerGLTF() {
+		}
+
+		//! Load all primitives as a list of mesh descriptions.
+		Util::GenericAttributeList * loadGeneric(std::istream & input) override;
+		//! Load the first primitive of the first mesh.
+		Mesh * loadMesh(std::istream & input) override;
+
+		/*! Load the first primitive from a local file by mapping it into memory instead of reading it through a stream.
+			If @p uploadDirectly is true, matching vertex and 32 bit index data is uploaded from the mapping into buffer
+			objects without creating local copies (must be called from the gl-thread).
+			\note If memory mapping is not supported, the file is loaded using loadMesh(std::istream&).	*/
+		static Mesh * loadMeshMapped(const std::string & localPath, bool uploadDirectly);
+
+		static uint8_t queryCapabilities(const std::string & extension);
+		static const char * const fileExtension;
+		static const char * const fileExtensionText;
+};
+
+}
+
+#endif /* RENDERING_STREAMERGLTF_H_ */
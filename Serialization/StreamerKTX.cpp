@@ -0,0 +1,237 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "StreamerKTX.h"
+#include "../Texture/Texture.h"
+#include "../Texture/TextureUtils.h"
+#include "../GLHeader.h"
+#include <Util/Macros.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+
+const char * const StreamerKTX::fileExtension = "ktx";
+const char * const StreamerKTX::fileExtension2 = "ktx2";
+
+static const uint8_t KTX1_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+inline static uint32_t swapBytes(uint32_t value) {
+	return (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+}
+
+//! (internal) Returns the gl internal format of a block compressed VkFormat or 0.
+static uint32_t vkFormatToGLFormat(uint32_t vkFormat) {
+	switch(vkFormat) {
+#if defined(GL_EXT_texture_compression_s3tc)
+		case 131:	return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;				// VK_FORMAT_BC1_RGB_UNORM_BLOCK
+		case 133:	return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;			// VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+		case 135:	return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;			// VK_FORMAT_BC2_UNORM_BLOCK
+		case 137:	return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;			// VK_FORMAT_BC3_UNORM_BLOCK
+#endif
+#if defined(GL_EXT_texture_sRGB)
+		case 132:	return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;			// VK_FORMAT_BC1_RGB_SRGB_BLOCK
+		case 134:	return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;		// VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+		case 136:	return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;		// VK_FORMAT_BC2_SRGB_BLOCK
+		case 138:	return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;		// VK_FORMAT_BC3_SRGB_BLOCK
+#endif
+#if defined(GL_ARB_texture_compression_rgtc)
+		case 139:	return GL_COMPRESSED_RED_RGTC1;						// VK_FORMAT_BC4_UNORM_BLOCK
+		case 140:	return GL_COMPRESSED_SIGNED_RED_RGTC1;				// VK_FORMAT_BC4_SNORM_BLOCK
+		case 141:	return GL_COMPRESSED_RG_RGTC2;						// VK_FORMAT_BC5_UNORM_BLOCK
+		case 142:	return GL_COMPRESSED_SIGNED_RG_RGTC2;				// VK_FORMAT_BC5_SNORM_BLOCK
+#endif
+#if defined(GL_ARB_texture_compression_bptc)
+		case 143:	return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;		// VK_FORMAT_BC6H_UFLOAT_BLOCK
+		case 144:	return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;			// VK_FORMAT_BC6H_SFLOAT_BLOCK
+		case 145:	return GL_COMPRESSED_RGBA_BPTC_UNORM;				// VK_FORMAT_BC7_UNORM_BLOCK
+		case 146:	return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;			// VK_FORMAT_BC7_SRGB_BLOCK
+#endif
+#if defined(GL_ARB_ES3_compatibility)
+		case 147:	return GL_COMPRESSED_RGB8_ETC2;						// VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+		case 148:	return GL_COMPRESSED_SRGB8_ETC2;					// VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK
+		case 149:	return GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;	// VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK
+		case 150:	return GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2;// VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK
+		case 151:	return GL_COMPRESSED_RGBA8_ETC2_EAC;				// VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK
+		case 152:	return GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;			// VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK
+		case 153:	return GL_COMPRESSED_R11_EAC;						// VK_FORMAT_EAC_R11_UNORM_BLOCK
+		case 154:	return GL_COMPRESSED_SIGNED_R11_EAC;				// VK_FORMAT_EAC_R11_SNORM_BLOCK
+		case 155:	return GL_COMPRESSED_RG11_EAC;						// VK_FORMAT_EAC_R11G11_UNORM_BLOCK
+		case 156:	return GL_COMPRESSED_SIGNED_RG11_EAC;				// VK_FORMAT_EAC_R11G11_SNORM_BLOCK
+#endif
+		default:
+			break;
+	}
+#if defined(GL_KHR_texture_compression_astc_ldr)
+	// VK_FORMAT_ASTC_4x4_UNORM_BLOCK ... VK_FORMAT_ASTC_12x12_SRGB_BLOCK alternate between linear and sRGB
+	if(vkFormat >= 157 && vkFormat <= 184) {
+		const uint32_t blockIndex = (vkFormat - 157) / 2;
+		return ((vkFormat - 157) % 2 == 0 ? GL_COMPRESSED_RGBA_ASTC_4x4_KHR : GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR) + blockIndex;
+	}
+#endif
+	return 0;
+}
+
+//! (internal) Determines the texture type of a file; returns false if the type is not supported or does not match the requested one.
+static bool getTextureType(uint32_t depth, uint32_t numArrayElements, uint32_t numFaces, TextureType requestedType, uint32_t requestedLayers,
+							TextureType & type, uint32_t & numLayers) {
+	if(depth > 1 || (numFaces != 1 && numFaces != 6)) {
+		WARN("StreamerKTX: Only 2d, array and cube map textures are supported.");
+		return false;
+	}
+	numLayers = std::max(1u, numArrayElements) * numFaces;
+	if(numFaces == 6)
+		type = numArrayElements > 0 ? TextureType::TEXTURE_CUBE_MAP_ARRAY : TextureType::TEXTURE_CUBE_MAP;
+	else
+		type = numArrayElements > 0 ? TextureType::TEXTURE_2D_ARRAY : TextureType::TEXTURE_2D;
+	if((requestedType != TextureType::TEXTURE_2D || requestedLayers != 1) && (requestedType != type || requestedLayers != numLayers)) {
+		WARN("StreamerKTX: The requested texture type does not match the file.");
+		return false;
+	}
+	return true;
+}
+
+//! (internal) KTX 1.1: each level is preceded by its size; cube map faces (of non-array textures) are stored separately.
+static Util::Reference<Texture> loadKTX1(std::istream & input, TextureType requestedType, uint32_t requestedLayers) {
+	struct KTX1Header {
+		uint32_t endianness, glType, glTypeSize, glFormat, glInternalFormat, glBaseInternalFormat;
+		uint32_t pixelWidth, pixelHeight, pixelDepth, numberOfArrayElements, numberOfFaces, numberOfMipmapLevels, bytesOfKeyValueData;
+	};
+	KTX1Header header;
+	input.read(reinterpret_cast<char *>(&header), sizeof(KTX1Header));
+	const bool swapped = header.endianness == 0x01020304;
+	if(swapped) {
+		uint32_t * values = reinterpret_cast<uint32_t *>(&header);
+		for(size_t i = 0; i < sizeof(KTX1Header) / sizeof(uint32_t); ++i)
+			values[i] = swapBytes(values[i]);
+	}
+	if(!input.good() || header.endianness != 0x04030201) {
+		WARN("StreamerKTX: Invalid KTX header.");
+		return nullptr;
+	}
+	if(header.glType != 0 || header.glFormat != 0) {
+		WARN("StreamerKTX: Only block compressed KTX files are supported.");
+		return nullptr;
+	}
+	TextureType type;
+	uint32_t numLayers;
+	if(!getTextureType(header.pixelDepth, header.numberOfArrayElements, header.numberOfFaces, requestedType, requestedLayers, type, numLayers))
+		return nullptr;
+	input.ignore(header.bytesOfKeyValueData);
+
+	const uint32_t numLevels = std::max(1u, header.numberOfMipmapLevels);
+	Util::Reference<Texture> texture = TextureUtils::createCompressedTexture(type, header.pixelWidth, header.pixelHeight, numLayers,
+																			header.glInternalFormat, numLevels);
+	if(!texture || !texture->getLocalData())
+		return nullptr;
+
+	const Texture::Format & format = texture->getFormat();
+	for(uint32_t level = 0; level < numLevels; ++level) {
+		uint32_t imageSize = 0;
+		input.read(reinterpret_cast<char *>(&imageSize), sizeof(uint32_t));
+		if(swapped)
+			imageSize = swapBytes(imageSize);
+		const uint32_t levelSize = format.getLevelDataSize(level);
+		if(imageSize != (type == TextureType::TEXTURE_CUBE_MAP ? levelSize / 6 : levelSize)) {
+			WARN("StreamerKTX: Invalid image size.");
+			return nullptr;
+		}
+		// block sizes are multiples of four bytes, so there is no cube or mip padding
+		input.read(reinterpret_cast<char *>(texture->getLocalData() + format.getLevelDataOffset(level)), levelSize);
+	}
+	if(!input.good()) {
+		WARN("StreamerKTX: Unexpected end of file.");
+		return nullptr;
+	}
+	return texture;
+}
+
+//! (internal) KTX 2.0: the levels are located by an index (the smallest level is usually stored first).
+static Util::Reference<Texture> loadKTX2(std::istream & input, std::streampos start, TextureType requestedType, uint32_t requestedLayers) {
+	struct KTX2Header {
+		uint32_t vkFormat, typeSize, pixelWidth, pixelHeight, pixelDepth, layerCount, faceCount, levelCount, supercompressionScheme;
+		uint32_t dfdByteOffset, dfdByteLength, kvdByteOffset, kvdByteLength;
+		uint64_t sgdByteOffset, sgdByteLength;
+	};
+	struct KTX2LevelIndex {
+		uint64_t byteOffset, byteLength, uncompressedByteLength;
+	};
+	KTX2Header header;
+	// read member-wise: the 64 bit members would be padded in the struct
+	input.read(reinterpret_cast<char *>(&header), 13 * sizeof(uint32_t));
+	input.read(reinterpret_cast<char *>(&header.sgdByteOffset), sizeof(uint64_t));
+	input.read(reinterpret_cast<char *>(&header.sgdByteLength), sizeof(uint64_t));
+	if(!input.good()) {
+		WARN("StreamerKTX: Invalid KTX2 header.");
+		return nullptr;
+	}
+	if(header.supercompressionScheme != 0) {
+		WARN("StreamerKTX: Supercompressed KTX2 files (BasisLZ, Zstandard, ZLIB) are not supported.");
+		return nullptr;
+	}
+	const uint32_t glInternalFormat = vkFormatToGLFormat(header.vkFormat);
+	if(glInternalFormat == 0) {
+		WARN("StreamerKTX: Unsupported vkFormat (only block compressed formats are supported).");
+		return nullptr;
+	}
+	TextureType type;
+	uint32_t numLayers;
+	if(!getTextureType(header.pixelDepth, header.layerCount, header.faceCount, requestedType, requestedLayers, type, numLayers))
+		return nullptr;
+
+	const uint32_t numLevels = std::max(1u, header.levelCount);
+	std::vector<KTX2LevelIndex> levelIndex(numLevels);
+	input.read(reinterpret_cast<char *>(levelIndex.data()), numLevels * sizeof(KTX2LevelIndex));
+
+	Util::Reference<Texture> texture = TextureUtils::createCompressedTexture(type, header.pixelWidth, header.pixelHeight, numLayers,
+																			glInternalFormat, numLevels);
+	if(!texture || !texture->getLocalData())
+		return nullptr;
+
+	const Texture::Format & format = texture->getFormat();
+	for(uint32_t level = 0; level < numLevels && input.good(); ++level) {
+		const uint32_t levelSize = format.getLevelDataSize(level);
+		if(levelIndex[level].byteLength != levelSize) {
+			WARN("StreamerKTX: Invalid level size.");
+			return nullptr;
+		}
+		input.seekg(start + static_cast<std::streamoff>(levelIndex[level].byteOffset));
+		input.read(reinterpret_cast<char *>(texture->getLocalData() + format.getLevelDataOffset(level)), levelSize);
+	}
+	if(!input.good()) {
+		WARN("StreamerKTX: Unexpected end of file.");
+		return nullptr;
+	}
+	return texture;
+}
+
+Util::Reference<Texture> StreamerKTX::loadTexture(std::istream & input, TextureType type, uint32_t numLayers){
+	const std::streampos start = input.tellg();
+	uint8_t identifier[12];
+	input.read(reinterpret_cast<char *>(identifier), 12);
+	if(input.good() && std::equal(identifier, identifier + 12, KTX1_IDENTIFIER))
+		return loadKTX1(input, type, numLayers);
+	if(input.good() && std::equal(identifier, identifier + 12, KTX2_IDENTIFIER))
+		return loadKTX2(input, start, type, numLayers);
+	WARN("StreamerKTX: Invalid KTX identifier.");
+	return nullptr;
+}
+
+uint8_t StreamerKTX::queryCapabilities(const std::string & extension) {
+	if(extension == fileExtension || extension == fileExtension2) {
+		return CAP_LOAD_TEXTURE;
+	} else {
+		return 0;
+	}
+}
+
+}
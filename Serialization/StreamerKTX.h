@@ -0,0 +1,45 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_STREAMERKTX_H_
+#define RENDERING_STREAMERKTX_H_
+
+#include "AbstractRenderingStreamer.h"
+
+namespace Rendering {
+
+/**
+ * Loader for block compressed Khronos textures (KTX 1.1 and KTX 2.0), e.g. BC1-BC7, ETC2/EAC and ASTC.
+ * All stored mipmap levels are loaded; array textures and cube maps (and cube map arrays) are supported.
+ * The texture type is defined by the file. If @a loadTexture is called with a type other than
+ * TEXTURE_2D with one layer, the file has to match that type.
+ *
+ * @note Supercompressed KTX 2.0 files (BasisLZ, Zstandard, ZLIB) and uncompressed or 3d textures are not supported.
+ * @see https://registry.khronos.org/KTX/specs/1.0/ktxspec_v1.html
+ * @see https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+ */
+class StreamerKTX : public AbstractRenderingStreamer {
+	public:
+		StreamerKTX() :
+			AbstractRenderingStreamer() {
+		}
+		virtual ~StreamerKTX() {
+		}
+
+		Util::Reference<Texture> loadTexture(std::istream & input, TextureType, uint32_t numLayers) override;
+
+		static uint8_t queryCapabilities(const std::string & extension);
+		static const char * const fileExtension;
+		static const char * const fileExtension2;	//!< KTX 2.0
+};
+
+}
+
+#endif /* RENDERING_STREAMERKTX_H_ */
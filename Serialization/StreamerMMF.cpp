@@ -10,11 +10,23 @@
 */
 #include "StreamerMMF.h"
 #include "Serialization.h"
+#include "../Mesh/LODMeshDataStrategy.h"
 #include "../Mesh/Mesh.h"
 #include "../Mesh/VertexAttributeIds.h"
 #include "../Mesh/VertexDescription.h"
+#include "../MeshUtils/MeshBVH.h"
+#include "../MeshUtils/Meshlets.h"
+#include "../GLHeader.h"
+#include "internal/MappedFile.h"
+#include <Geometry/Box.h>
 #include <Util/GenericAttribute.h>
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <vector>
 
 /// \todo Show compile error when using a machine without LITTLE-ENDIANness
@@ -24,26 +36,126 @@ namespace Rendering {
 
 const char * const StreamerMMF::fileExtension = "mmf";
 
+// the structures are stored as they are in the optional blocks
+static_assert(sizeof(MeshUtils::Meshlet) == 12 * sizeof(uint32_t), "MeshUtils::Meshlet has to be tightly packed.");
+static_assert(sizeof(MeshUtils::MeshBVH::Node) == 8 * sizeof(uint32_t), "MeshUtils::MeshBVH::Node has to be tightly packed.");
+
+namespace {
+//! Sequential access to the data of an optional block; every access checks the remaining size.
+class BlockData {
+	public:
+		explicit BlockData(const std::vector<uint8_t> & _data) : data(_data), pos(0) {}
+		template<typename T>
+		bool get(T & value) {
+			if(data.size() - pos < sizeof(T))
+				return false;
+			std::memcpy(&value, data.data() + pos, sizeof(T));
+			pos += sizeof(T);
+			return true;
+		}
+		template<typename T>
+		bool getArray(std::vector<T> & values, size_t count) {
+			if(count > (data.size() - pos) / sizeof(T))
+				return false;
+			values.resize(count);
+			if(count > 0)
+				std::memcpy(values.data(), data.data() + pos, count * sizeof(T));
+			pos += count * sizeof(T);
+			return true;
+		}
+	private:
+		const std::vector<uint8_t> & data;
+		size_t pos;
+};
+
+template<typename T>
+void writeValue(std::ostream & out, const T & value) {
+	out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+template<typename T>
+void writeArray(std::ostream & out, const std::vector<T> & values) {
+	out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+Geometry::Box toBox(const float * values) {
+	return Geometry::Box(values[0], values[3], values[1], values[4], values[2], values[5]);
+}
+}
+
 uint32_t StreamerMMF::Reader::read_uint32() {
-	uint32_t x;
-	in.read(reinterpret_cast<char *> (&x), 4);
+	uint32_t x = 0;
+	read(reinterpret_cast<uint8_t *> (&x), 4);
 	return x;
 }
 
 void StreamerMMF::Reader::read(uint8_t * data,size_t count) {
-	in.read(reinterpret_cast<char *> (data), count);
+	if(in != nullptr) {
+		in->read(reinterpret_cast<char *> (data), count);
+	} else if(static_cast<size_t>(end - cursor) >= count) {
+		std::memcpy(data, cursor, count);
+		cursor += count;
+	} else {
+		std::fill(data, data + count, 0);
+		cursor = end;
+		failed = true;
+	}
 }
 
 void StreamerMMF::Reader::skip(uint32_t size) {
-	in.seekg(std::ios_base::cur+size);
+	if(in != nullptr) {
+		in->seekg(size, std::ios_base::cur);
+	} else if(static_cast<size_t>(end - cursor) >= size) {
+		cursor += size;
+	} else {
+		cursor = end;
+		failed = true;
+	}
+}
+
+bool StreamerMMF::Reader::good() const {
+	return in != nullptr ? in->good() : !failed;
+}
+
+const uint8_t * StreamerMMF::Reader::directData(size_t count) {
+	if(in != nullptr || !uploadDirectly || static_cast<size_t>(end - cursor) < count)
+		return nullptr;
+	const uint8_t * data = cursor;
+	cursor += count;
+	return data;
 }
 
 //!	(static)
 Mesh * StreamerMMF::loadMesh(std::istream & input) {
-
-//	std::cout << "\nloadMMF...";
 	Reader reader(input);
+	return loadMesh(reader);
+}
 
+//!	(static)
+Mesh * StreamerMMF::loadMeshMapped(const std::string & localPath, bool uploadDirectly) {
+	if(!MappedFile::isSupported()) {
+		std::ifstream input(localPath.c_str(), std::ios_base::in | std::ios_base::binary);
+		if(!input.good()) {
+			WARN("StreamerMMF::loadMeshMapped: Could not open file \"" + localPath + "\".");
+			return nullptr;
+		}
+		return loadMesh(input);
+	}
+	MappedFile file(localPath);
+	if(file.data == nullptr) {
+		WARN("StreamerMMF::loadMeshMapped: Could not map file \"" + localPath + "\".");
+		return nullptr;
+	}
+	return loadMeshFromMemory(file.data, file.size, uploadDirectly);
+}
+
+//!	(static)
+Mesh * StreamerMMF::loadMeshFromMemory(const uint8_t * data, size_t size, bool uploadDirectly) {
+	Reader reader(data, size, uploadDirectly);
+	return loadMesh(reader);
+}
+
+//!	(internal,static)
+Mesh * StreamerMMF::loadMesh(Reader & reader) {
 	uint32_t format = reader.read_uint32();
 	if(format!=MMF_HEADER)    {
 		WARN(std::string("wrong mesh format: ") + Util::StringUtils::toString(format));
@@ -54,10 +166,11 @@ Mesh * StreamerMMF::loadMesh(std::istream & input) {
 		WARN(std::string("can't read mesh, version to high: ") + Util::StringUtils::toString(version));
 		return nullptr;
 	}
+	reader.version = version;
 
 	auto mesh = new Mesh;
 	uint32_t blockType = reader.read_uint32();
-	while(blockType != StreamerMMF::MMF_END && input.good()) {
+	while(blockType != StreamerMMF::MMF_END && reader.good()) {
 		// blocksize is discarded.
 		uint32_t blockSize = reader.read_uint32();
 		switch(blockType) {
@@ -67,6 +180,34 @@ Mesh * StreamerMMF::loadMesh(std::istream & input) {
 			case StreamerMMF::MMF_INDEX_DATA:
 				readIndexData(mesh, reader);
 				break;
+			case StreamerMMF::MMF_BOUNDING_BOX:
+				if(blockSize == sizeof(reader.boundingBox)) {
+					reader.read(reinterpret_cast<uint8_t *>(reader.boundingBox), sizeof(reader.boundingBox));
+					reader.hasBoundingBox = true;
+				} else {
+					reader.skip(blockSize);
+				}
+				break;
+			case StreamerMMF::MMF_CONTENT_HASH:
+				if(blockSize == sizeof(reader.contentHash)) {
+					reader.read(reinterpret_cast<uint8_t *>(&reader.contentHash), sizeof(reader.contentHash));
+					reader.hasContentHash = true;
+				} else {
+					reader.skip(blockSize);
+				}
+				break;
+			case StreamerMMF::MMF_LOD_LEVELS:
+				reader.lodBlock.resize(blockSize);
+				reader.read(reader.lodBlock.data(), blockSize);
+				break;
+			case StreamerMMF::MMF_MESHLETS:
+				reader.meshletBlock.resize(blockSize);
+				reader.read(reader.meshletBlock.data(), blockSize);
+				break;
+			case StreamerMMF::MMF_BVH:
+				reader.bvhBlock.resize(blockSize);
+				reader.read(reader.bvhBlock.data(), blockSize);
+				break;
 			default:
 				WARN("LoaderMMF::loadMesh: unknown data block found.");
 				std::cout << "blockSize:"<<blockSize<<" \n";
@@ -75,11 +216,89 @@ Mesh * StreamerMMF::loadMesh(std::istream & input) {
 		}
 		blockType = reader.read_uint32();
 	}
-
-//	std::cout << "done.\n";
+	if(reader.good())
+		applyOptionalData(mesh, reader);
 	return mesh;
 }
 
+//!	(internal,static)
+void StreamerMMF::applyOptionalData(Mesh * mesh, Reader & in) {
+	static const std::string warningPrefix("LoaderMMF::applyOptionalData: ");
+	if(in.hasBoundingBox) // the block may have been stored after the vertex block
+		mesh->_getVertexData()._setBoundingBox(toBox(in.boundingBox));
+
+	if(!in.lodBlock.empty()) {
+		BlockData block(in.lodBlock);
+		const uint64_t elementCount = mesh->isUsingIndexData() ? mesh->getIndexCount() : mesh->getVertexCount();
+		uint32_t levelCount = 0;
+		float bias = 1.0f;
+		bool valid = block.get(levelCount) && block.get(bias) && levelCount > 0;
+		std::vector<LODMeshDataStrategy::Level> levels;
+		for(uint32_t i = 0; valid && i < levelCount; ++i) {
+			uint32_t first = 0;
+			uint32_t count = 0;
+			float minSize = 0.0f;
+			valid = block.get(first) && block.get(count) && block.get(minSize) && static_cast<uint64_t>(first) + count <= elementCount;
+			if(valid)
+				levels.emplace_back(first, count, minSize);
+		}
+		if(valid)
+			LODMeshDataStrategy::createForMesh(mesh, std::move(levels))->setLODBias(bias);
+		else
+			WARN(warningPrefix + "Invalid level of detail block.");
+	}
+
+	if(!in.meshletBlock.empty()) {
+		BlockData block(in.meshletBlock);
+		uint32_t maxVertices = 0, maxTriangles = 0, meshletCount = 0, vertexCount = 0, triangleIndexCount = 0;
+		MeshUtils::MeshletData data;
+		bool valid = block.get(maxVertices) && block.get(maxTriangles) && block.get(meshletCount) && block.get(vertexCount) &&
+				block.get(triangleIndexCount) && block.getArray(data.meshlets, meshletCount) &&
+				block.getArray(data.vertices, vertexCount) && block.getArray(data.triangles, triangleIndexCount);
+		for(auto it = data.vertices.begin(); valid && it != data.vertices.end(); ++it)
+			valid = *it < mesh->getVertexCount();
+		for(auto it = data.meshlets.begin(); valid && it != data.meshlets.end(); ++it) {
+			const MeshUtils::Meshlet & meshlet = *it;
+			valid = static_cast<uint64_t>(meshlet.vertexOffset) + meshlet.vertexCount <= data.vertices.size() &&
+					(static_cast<uint64_t>(meshlet.triangleOffset) + meshlet.triangleCount) * 3 <= data.triangles.size();
+			for(uint32_t i = meshlet.triangleOffset * 3; valid && i < (meshlet.triangleOffset + meshlet.triangleCount) * 3; ++i)
+				valid = data.triangles[i] < meshlet.vertexCount;
+		}
+		if(valid)
+			MeshUtils::setCachedMeshlets(mesh, std::move(data), maxVertices, maxTriangles);
+		else
+			WARN(warningPrefix + "Invalid meshlet block.");
+	}
+
+	if(!in.bvhBlock.empty()) {
+		BlockData block(in.bvhBlock);
+		uint32_t nodeCount = 0, triangleCount = 0;
+		std::vector<MeshUtils::MeshBVH::Node> nodes;
+		std::vector<uint32_t> triangleIds;
+		std::vector<float> positions;
+		if(block.get(nodeCount) && block.get(triangleCount) && block.getArray(nodes, nodeCount) &&
+				block.getArray(triangleIds, triangleCount) && block.getArray(positions, static_cast<size_t>(triangleCount) * 9)) {
+			try {
+				MeshUtils::MeshBVH::createFromData(mesh, std::move(nodes), std::move(triangleIds), std::move(positions));
+			} catch(const std::invalid_argument & e) {
+				WARN(warningPrefix + e.what());
+			}
+		} else {
+			WARN(warningPrefix + "Invalid BVH block.");
+		}
+	}
+
+	// set last: the hash is only valid for the current data revisions
+	if(in.hasContentHash)
+		mesh->_setDataHash(in.contentHash);
+}
+
+//!	(internal,static)
+void StreamerMMF::readPadding(Reader & in) {
+	if(in.version >= 0x02)
+		in.skip(in.read_uint32());
+}
+
 //!	(internal,static)
 void StreamerMMF::readVertexData(Mesh * mesh, Reader & in) {
 	static const std::string warningPrefix("LoaderMMF::readVertexData: ");
@@ -91,6 +310,9 @@ void StreamerMMF::readVertexData(Mesh * mesh, Reader & in) {
 		uint32_t glType = in.read_uint32();
 		uint32_t extLength = in.read_uint32();
 		std::string name;
+		bool hasFormat = false;
+		bool normalize = false;
+		bool convertToFloat = true;
 
 		switch(attrId) {
 			case 0x00: {
@@ -133,7 +355,7 @@ void StreamerMMF::readVertexData(Mesh * mesh, Reader & in) {
 			uint32_t extBlockSize=in.read_uint32();
 			extLength-=8;
 
-			if(extLength>extBlockSize) {
+			if(extBlockSize>extLength) {
 				WARN(warningPrefix+"Error in vertex block");
 				FAIL();
 			}
@@ -145,6 +367,12 @@ void StreamerMMF::readVertexData(Mesh * mesh, Reader & in) {
 			if(extBlockType==MMF_VERTEX_ATTR_EXT_NAME) {
 				name.assign(data.begin(), data.end());
 				name=name.substr(0,name.find('\0')); // remove additional zeros
+			} else if(extBlockType==MMF_VERTEX_ATTR_EXT_FORMAT && extBlockSize>=sizeof(uint32_t)) {
+				uint32_t flags;
+				std::memcpy(&flags, data.data(), sizeof(flags));
+				normalize = (flags & MMF_FORMAT_NORMALIZE) != 0;
+				convertToFloat = (flags & MMF_FORMAT_INTEGER) == 0;
+				hasFormat = true;
 			} else {
 				WARN(warningPrefix+"Found unsupported ext data, skipping data.");
 			}
@@ -156,17 +384,30 @@ void StreamerMMF::readVertexData(Mesh * mesh, Reader & in) {
 		if(name.empty())
 			WARN(warningPrefix+"Found unnamed vertex attribute.");
 
-		vd.appendAttribute(name,numValues,glType);
+		if(hasFormat)
+			vd.appendAttribute(name,numValues,glType,normalize,convertToFloat);
+		else
+			vd.appendAttribute(name,numValues,glType);
 //        vd.setData(index, numValues, glType);
 
 	}
 	const uint32_t count = in.read_uint32();
+	readPadding(in);
+	const uint8_t * directData = in.directData(static_cast<size_t>(vd.getVertexSize()) * count);
+	if(directData != nullptr) {
+		const Geometry::Box box = toBox(in.boundingBox);
+		mesh->_getVertexData()._uploadExternal(count, vd, directData, GL_STATIC_DRAW, in.hasBoundingBox ? &box : nullptr);
+		return;
+	}
 	MeshVertexData & vertices = mesh->openVertexData();
 	vertices.allocate(count,vd);
 
 	in.read( vertices.data(), vertices.dataSize());
 
-	vertices.updateBoundingBox();
+	if(in.hasBoundingBox)
+		vertices._setBoundingBox(toBox(in.boundingBox));
+	else
+		vertices.updateBoundingBox();
 }
 
 //!	(internal,static)
@@ -174,6 +415,7 @@ void StreamerMMF::readIndexData(Mesh * mesh, Reader & in) {
 	const uint32_t count = in.read_uint32();
 	const uint32_t triangleMode = in.read_uint32();
 	mesh->setGLDrawMode(triangleMode);
+	readPadding(in);
 
 	// As the use of index data is not stored explicitly in a .mmf-file,
 	// if the mesh has no indices, it is assumed that it does not use them. 
@@ -181,6 +423,13 @@ void StreamerMMF::readIndexData(Mesh * mesh, Reader & in) {
 		mesh->setUseIndexData(false);
 	}else{
 		mesh->setUseIndexData(true);
+		const uint8_t * directData = in.directData(count * sizeof(uint32_t));
+		if(directData != nullptr && reinterpret_cast<uintptr_t>(directData) % alignof(uint32_t) == 0) {
+			mesh->_getIndexData()._uploadExternal(count, reinterpret_cast<const uint32_t *>(directData), GL_STATIC_DRAW);
+			return;
+		} else if(directData != nullptr) { // unaligned data (version 1 file)
+			in.cursor = directData;
+		}
 		MeshIndexData & indices=mesh->openIndexData();
 		indices.allocate(count);
 
@@ -208,9 +457,29 @@ bool StreamerMMF::saveMesh(Mesh * mesh, std::ostream & output) {
 	write(output, MMF_VERSION);
 
 	/// VertexData
-	MeshVertexData & vertices = mesh->openVertexData();
+	MeshVertexData * meshVertices = &mesh->openVertexData();
+	std::unique_ptr<MeshVertexData> interleavedVertices;
+	if(meshVertices->getLayout() != MeshVertexData::INTERLEAVED) { // the file format stores interleaved vertices
+		interleavedVertices.reset(new MeshVertexData(*meshVertices));
+		interleavedVertices->setLayout(MeshVertexData::INTERLEAVED);
+		meshVertices = interleavedVertices.get();
+	}
+	MeshVertexData & vertices = *meshVertices;
 	const VertexDescription & vd = vertices.getVertexDescription();
 
+	// the loaded mesh has the same data hash if the vertices are stored unchanged
+	const bool hashMatchesFile = !mesh->isView() && interleavedVertices == nullptr &&
+			std::none_of(vd.getAttributes().begin(), vd.getAttributes().end(), [](const VertexAttribute & attr) { return attr.empty(); });
+
+	/// BoundingBox (before the vertices, so it needs not be calculated while loading them)
+	size_t offset = 2 * sizeof(uint32_t); // header, version
+	if(vertices.getVertexCount() > 0 && !vd.getAttribute(VertexAttributeIds::POSITION).empty()) {
+		const Geometry::Box & box = vertices.getBoundingBox();
+		const float values[6] = {box.getMinX(), box.getMinY(), box.getMinZ(), box.getMaxX(), box.getMaxY(), box.getMaxZ()};
+		writeBlock(output, MMF_BOUNDING_BOX, std::string(reinterpret_cast<const char *>(values), sizeof(values)));
+		offset += 2 * sizeof(uint32_t) + sizeof(values);
+	}
+
 	// prepare header
 	std::ostringstream headerOut;
 	for(const auto & attr : vd.getAttributes()) {
@@ -231,37 +500,63 @@ bool StreamerMMF::saveMesh(Mesh * mesh, std::ostream & output) {
 		write(headerOut,attrId);				// attrId
 		write(headerOut,attr.getNumValues());	// numValues
 		write(headerOut,attr.getDataType());	// dataType
+
+		// the format is only stored if it differs from the default format derived from the data type
+		VertexDescription defaultDescription;
+		const VertexAttribute & defaultAttr = defaultDescription.appendAttribute(attr.getNameId(), attr.getNumValues(), attr.getDataType());
+		const bool writeFormat = defaultAttr.getNormalize() != attr.getNormalize() || !attr.getConvertToFloat();
+
+		std::string name;
+		uint32_t extLength = 0;
 		if(attrId==MMF_CUSTOM_ATTR_ID){
-			std::string name(attr.getName());
+			name = attr.getName();
 			while(name.length()%4!=0)// fill name up with \0 until 32bit alignment is reached
 				name+='\0';
-
-			write(headerOut,name.length()+8);	// extLength = String + 4 (extType) + 4 (stringLength)
+			extLength += name.length()+8;		// String + 4 (extType) + 4 (stringLength)
+		}
+		if(writeFormat)
+			extLength += 12;					// 4 (extType) + 4 (dataLength) + 4 (flags)
+		write(headerOut,extLength);				// extLength
+		if(attrId==MMF_CUSTOM_ATTR_ID){
 			write(headerOut,MMF_VERTEX_ATTR_EXT_NAME); // extType
 			write(headerOut,name.length());		// stringLength
 			headerOut.write(name.c_str(),name.length()); // String
-		}else{
-			write(headerOut,0); 				// extLength = 0
+		}
+		if(writeFormat){
+			write(headerOut,MMF_VERTEX_ATTR_EXT_FORMAT); // extType
+			write(headerOut,4);					// dataLength
+			write(headerOut,(attr.getNormalize() ? MMF_FORMAT_NORMALIZE : 0) | (attr.getConvertToFloat() ? 0 : MMF_FORMAT_INTEGER)); // flags
 		}
 	}
 	write(headerOut,MMF_END);
 	write(headerOut,vertices.getVertexCount());
 	const std::string & header=headerOut.str();
 
+	// the file offset is tracked to align the vertex and index data
+	offset += 2 * sizeof(uint32_t) + header.length() + sizeof(uint32_t); // blockType, dataSize, header, paddingLength
+	const uint32_t vertexPadding = getPaddingLength(offset);
+	offset += vertexPadding + vertices.dataSize();
+
 	// write data
 	write(output, MMF_VERTEX_DATA);
-	write(output,vertices.dataSize()+header.length()); // dataSize
+	write(output,vertices.dataSize()+header.length()+sizeof(uint32_t)+vertexPadding); // dataSize
 	output.write(header.c_str(),header.length());		// header
+	writePadding(output, vertexPadding);
 	output.write(reinterpret_cast<char *> (vertices.data()), vertices.dataSize()); // data
 
 	/// IndexData Header
 	MeshIndexData & indices = mesh->openIndexData();
+	offset += 5 * sizeof(uint32_t); // blockType, dataSize, indexCount, triangleMode, paddingLength
+	const uint32_t indexPadding = getPaddingLength(offset);
 	write(output, MMF_INDEX_DATA);
-	write(output, indices.dataSize()+sizeof(uint32_t)+sizeof(uint32_t)); // indexData length +indexCount +triangleMode
+	write(output, indices.dataSize()+3*sizeof(uint32_t)+indexPadding); // indexData length +indexCount +triangleMode +padding
 	write(output, indices.getIndexCount());
 	write(output, mesh->getGLDrawMode());
+	writePadding(output, indexPadding);
 	output.write(reinterpret_cast<char *> (indices.data()), indices.dataSize());
 
+	writeOptionalBlocks(mesh, output, hashMatchesFile);
+
 	/// final END
 	write(output, MMF_END);
 	return true;
@@ -269,11 +564,81 @@ bool StreamerMMF::saveMesh(Mesh * mesh, std::ostream & output) {
 
 
 
+//!	(internal,static)
+void StreamerMMF::writeOptionalBlocks(Mesh * mesh, std::ostream & out, bool hashMatchesFile) {
+	/// ContentHash
+	if(hashMatchesFile) {
+		const uint64_t hash = mesh->_getDataHash();
+		writeBlock(out, MMF_CONTENT_HASH, std::string(reinterpret_cast<const char *>(&hash), sizeof(hash)));
+	}
+
+	/// LOD levels
+	if(auto lodStrategy = dynamic_cast<LODMeshDataStrategy *>(mesh->getDataStrategy())) {
+		std::ostringstream data;
+		write(data, lodStrategy->getLevels().size());
+		writeValue(data, lodStrategy->getLODBias());
+		for(const auto & level : lodStrategy->getLevels()) {
+			write(data, level.firstElement);
+			write(data, level.elementCount);
+			writeValue(data, level.minScreenSize);
+		}
+		writeBlock(out, MMF_LOD_LEVELS, data.str());
+	}
+
+	/// Meshlets (only if they have been built already)
+	uint32_t maxVertices = 0;
+	uint32_t maxTriangles = 0;
+	if(const MeshUtils::MeshletData * meshlets = MeshUtils::getCachedMeshlets(mesh, &maxVertices, &maxTriangles)) {
+		std::ostringstream data;
+		write(data, maxVertices);
+		write(data, maxTriangles);
+		write(data, meshlets->meshlets.size());
+		write(data, meshlets->vertices.size());
+		write(data, meshlets->triangles.size());
+		writeArray(data, meshlets->meshlets);
+		writeArray(data, meshlets->vertices);
+		writeArray(data, meshlets->triangles);
+		static const char zeros[4] = {0};
+		data.write(zeros, (4 - meshlets->triangles.size() % 4) % 4);
+		writeBlock(out, MMF_MESHLETS, data.str());
+	}
+
+	/// BVH (only if it has been built already)
+	if(const MeshUtils::MeshBVH * bvh = MeshUtils::MeshBVH::getIfValid(mesh)) {
+		std::ostringstream data;
+		write(data, bvh->getNodes().size());
+		write(data, bvh->getTriangleIds().size());
+		writeArray(data, bvh->getNodes());
+		writeArray(data, bvh->getTriangleIds());
+		writeArray(data, bvh->getTrianglePositions());
+		writeBlock(out, MMF_BVH, data.str());
+	}
+}
+
+//!	(internal,static)
+void StreamerMMF::writeBlock(std::ostream & out, uint32_t blockType, const std::string & data) {
+	write(out, blockType);
+	write(out, data.size());
+	out.write(data.data(), data.size());
+}
+
 //!	(internal,static)
 void StreamerMMF::write(std::ostream & out, uint32_t x) {
 	out.write(reinterpret_cast<char *> (&x), 4);
 }
 
+//!	(internal,static)
+uint32_t StreamerMMF::getPaddingLength(size_t offset) {
+	return static_cast<uint32_t>((MMF_DATA_ALIGNMENT - offset % MMF_DATA_ALIGNMENT) % MMF_DATA_ALIGNMENT);
+}
+
+//!	(internal,static)
+void StreamerMMF::writePadding(std::ostream & out, uint32_t paddingLength) {
+	static const char zeros[MMF_DATA_ALIGNMENT] = {0};
+	write(out, paddingLength);
+	out.write(zeros, paddingLength);
+}
+
 uint8_t StreamerMMF::queryCapabilities(const std::string & extension) {
 	if(extension == fileExtension) {
 		return CAP_LOAD_MESH | CAP_LOAD_GENERIC | CAP_SAVE_MESH;
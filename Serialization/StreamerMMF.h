@@ -13,6 +13,7 @@
 
 #include "AbstractRenderingStreamer.h"
 #include <cstdint>
+#include <vector>
 
 namespace Rendering {
 
@@ -24,8 +25,8 @@ namespace Rendering {
 	Fileformat: binary little endian
 
 	MMF-File ::=    Header (char[4] "mmf"+chr(13) ),
-					uint32 version (currently 0x01),
-					DataBlock * (one VertexBlock and one IndexBlock),
+					uint32 version (currently 0x02),
+					DataBlock * (one VertexBlock, one IndexBlock and optional blocks with precomputed data),
 					EndMarker (uint32 0xFFFFFFFF)
 
 	DataBlock ::=   uint32 dataType,
@@ -36,11 +37,15 @@ namespace Rendering {
 
 	DataBlock ::=   IndexBlock
 
+	DataBlock ::=   BoundingBoxBlock | ContentHashBlock | LODBlock | MeshletBlock | BVHBlock
+					-- optional; readers skip unknown blocks, so adding these did not change the version.
+
 	VertexBlock ::= Vertex-dataType (uint32 0x00),
 					uint32 dataSize,
 					VertexAttributeDescription *,
 					EndMarker (uint32 0xFFFFFFFF),
 					uint32 vertexCount -- the number of vertices in the following datablock,
+					Padding (only version >= 0x02),
 					uint8* vertexData -- the vertex data
 
 	VertexAttributeDescription ::=
@@ -62,31 +67,86 @@ namespace Rendering {
 					uint8 data[dataLength]
 
 	VertexAttributeExtension ::=
-					VertexAttributeNameExtension
+					VertexAttributeNameExtension |
+					VertexAttributeFormatExtension
 
 	VertexAttributeNameExtension ::=
 					uint32 extension Type 0x03 ( MMF_VERTEX_ATTR_EXT_NAME )
 					uint32 length of name string including padding zeros
 					uint8* attrName (filled up with additional zeros until 32bit alignment is reached.
 
+	VertexAttributeFormatExtension ::= (only present if the format differs from the default for the type)
+					uint32 extension Type 0x04 ( MMF_VERTEX_ATTR_EXT_FORMAT )
+					uint32 dataLength (=4)
+					uint32 flags -- 0x01: normalize (MMF_FORMAT_NORMALIZE), 0x02: integer attribute, not converted to float (MMF_FORMAT_INTEGER)
+					Without this block, byte and packed 2_10_10_10 attributes are normalized and all attributes are converted to float.
+
 
 	IndexBlock ::=  Index-dataType (uint32 0x01),
 					uint32 dataSize,
 					uint32 indexCount -- the number of indices in the following datablock,
 					uint32 (=GLuint) indexMode -- the meaning of the indices (GL_TRIANGLES, GL_TRIANGLE_STRIP, ...),
+					Padding (only version >= 0x02),
 					uint8* indexData -- the index data
+
+	BoundingBoxBlock ::= (written before the VertexBlock, so the box needs not be calculated while reading the vertices)
+					BoundingBox-dataType (uint32 0x02),
+					uint32 dataSize (=24),
+					float minX, minY, minZ, maxX, maxY, maxZ
+
+	ContentHashBlock ::= (only written if the loaded mesh has the same hash, see Mesh::_getDataHash())
+					ContentHash-dataType (uint32 0x03),
+					uint32 dataSize (=8),
+					uint64 hash -- hash of the vertex and index data
+
+	LODBlock ::=    (the index ranges of a LODMeshDataStrategy, see MeshUtils::MeshLODChain)
+					LOD-dataType (uint32 0x04),
+					uint32 dataSize,
+					uint32 levelCount,
+					float lodBias,
+					( uint32 firstElement, uint32 elementCount, float minScreenSize ) [levelCount]
+
+	MeshletBlock ::= (see MeshUtils::getMeshlets)
+					Meshlet-dataType (uint32 0x05),
+					uint32 dataSize,
+					uint32 maxVertices, uint32 maxTriangles,
+					uint32 meshletCount, uint32 vertexCount, uint32 triangleIndexCount,
+					( uint32 vertexOffset, vertexCount, triangleOffset, triangleCount,
+					  float center[3], radius, coneAxis[3], coneCutoff ) [meshletCount],
+					uint32 vertices[vertexCount],
+					uint8 triangles[triangleIndexCount] (filled up with zeros until 32bit alignment is reached)
+
+	BVHBlock ::=    (see MeshUtils::MeshBVH)
+					BVH-dataType (uint32 0x06),
+					uint32 dataSize,
+					uint32 nodeCount, uint32 triangleCount,
+					( float min[3], uint32 secondChildOrFirstTriangle, float max[3], uint32 triangleCount ) [nodeCount],
+					uint32 triangleIds[triangleCount],
+					float positions[9 * triangleCount]
+
+	Padding ::=     uint32 paddingLength,
+					uint8 zeros[paddingLength] -- the following data starts at a file offset that is a multiple of 16 (MMF_DATA_ALIGNMENT)
 */
 class StreamerMMF : public AbstractRenderingStreamer {
 	public:
-		const static uint32_t MMF_VERSION = 0x01;
+		const static uint32_t MMF_VERSION = 0x02;
 		const static uint32_t MMF_HEADER = 0x0d666d6d; // = "mmf "
 
 		const static uint32_t MMF_VERTEX_DATA = 0x00;
 		const static uint32_t MMF_INDEX_DATA = 0x01;
+		const static uint32_t MMF_BOUNDING_BOX = 0x02;
+		const static uint32_t MMF_CONTENT_HASH = 0x03;
+		const static uint32_t MMF_LOD_LEVELS = 0x04;
+		const static uint32_t MMF_MESHLETS = 0x05;
+		const static uint32_t MMF_BVH = 0x06;
 		const static uint32_t MMF_END = 0xFFFFFFFF;
 
 		const static uint32_t MMF_CUSTOM_ATTR_ID = 0xFF;
 		const static uint32_t MMF_VERTEX_ATTR_EXT_NAME = 0x03;
+		const static uint32_t MMF_VERTEX_ATTR_EXT_FORMAT = 0x04;
+		const static uint32_t MMF_FORMAT_NORMALIZE = 0x01;
+		const static uint32_t MMF_FORMAT_INTEGER = 0x02;
+		const static uint32_t MMF_DATA_ALIGNMENT = 16;
 
 		StreamerMMF() :
 			AbstractRenderingStreamer() {
@@ -98,22 +158,65 @@ class StreamerMMF : public AbstractRenderingStreamer {
 		Mesh * loadMesh(std::istream & input) override;
 		bool saveMesh(Mesh * mesh, std::ostream & output) override;
 
+		/*! Load a mesh from a local file by mapping it into memory instead of reading it through a stream.
+			If @p uploadDirectly is true, the vertex and index data is uploaded from the mapping into buffer objects
+			without creating local copies (must be called from the gl-thread). Otherwise, the data is copied
+			into the mesh once.
+			\note If memory mapping is not supported, the file is loaded using loadMesh(std::istream&).	*/
+		static Mesh * loadMeshMapped(const std::string & localPath, bool uploadDirectly);
+
+		/*! Load a mesh from MMF data in memory (e.g. a mapped part of a larger file).
+			@p uploadDirectly: see loadMeshMapped(). */
+		static Mesh * loadMeshFromMemory(const uint8_t * data, size_t size, bool uploadDirectly);
+
 		static uint8_t queryCapabilities(const std::string & extension);
 		static const char * const fileExtension;
 
 	private:
+		/*! Reads either from a stream or from memory (e.g. a memory-mapped file).
+			The version of the file is stored when the header has been read, the data of the
+			optional blocks when the blocks have been read. */
 		struct Reader{
-			Reader(std::istream & _in) : in(_in){}
-			std::istream & in;
+			Reader(std::istream & _in) :
+				in(&_in), cursor(nullptr), end(nullptr), failed(false), version(0), uploadDirectly(false),
+				hasBoundingBox(false), hasContentHash(false), contentHash(0) {}
+			Reader(const uint8_t * data, size_t size, bool _uploadDirectly) :
+				in(nullptr), cursor(data), end(data + size), failed(false), version(0), uploadDirectly(_uploadDirectly),
+				hasBoundingBox(false), hasContentHash(false), contentHash(0) {}
+			std::istream * in;
+			const uint8_t * cursor;
+			const uint8_t * end;
+			bool failed;
+			uint32_t version;
+			bool uploadDirectly;
+
+			bool hasBoundingBox;
+			float boundingBox[6];
+			bool hasContentHash;
+			uint64_t contentHash;
+			//! Data of the blocks that can only be applied after the vertex and index data has been read.
+			std::vector<uint8_t> lodBlock, meshletBlock, bvhBlock;
+
 			uint32_t read_uint32();
 			void read(uint8_t * data,size_t count);
 			void skip(uint32_t size);
-
+			bool good() const;
+			/*! Return a pointer to the next @p count bytes and skip them, if the data is in memory
+				and @p uploadDirectly is set. Otherwise nullptr is returned and nothing is skipped. */
+			const uint8_t * directData(size_t count);
 		};
+		static Mesh * loadMesh(Reader & reader);
 		static void readVertexData(Mesh * mesh, Reader & in);
 		static void readIndexData(Mesh * mesh, Reader & in);
-
-
+		static void readPadding(Reader & in);
+		//! Restore the data of the optional blocks that has been stored by the reader.
+		static void applyOptionalData(Mesh * mesh, Reader & in);
+		static void writeOptionalBlocks(Mesh * mesh, std::ostream & out, bool hashMatchesFile);
+		static void writeBlock(std::ostream & out, uint32_t blockType, const std::string & data);
+
+		//! Number of padding bytes required at the given file offset.
+		static uint32_t getPaddingLength(size_t offset);
+		static void writePadding(std::ostream & out, uint32_t paddingLength);
 		static void write(std::ostream & out, uint32_t x);
 };
 
@@ -14,12 +14,24 @@
 #include "../Mesh/VertexAttributeIds.h"
 #include "../Mesh/VertexDescription.h"
 #include "../MeshUtils/MeshUtils.h"
+#include "../TaskScheduler.h"
 #include "../GLHeader.h"
+#include "internal/TextParsing.h"
 #include <Util/GenericAttribute.h>
-#include <Util/StringUtils.h>
+#include <Util/Macros.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
 #include <list>
-#include <map>
-#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 using namespace Util;
 
@@ -27,309 +39,353 @@ namespace Rendering {
 
 const char * const StreamerOBJ::fileExtension = "obj";
 
-struct Vertex {
+static uint32_t numParserThreads = 0;
 
-	Vertex() :
-		data(), index(0) {
-	}
-
-	Vertex(const Vertex & other) :
-		data(other.data), index(other.index) {
-	}
-
-	Vertex(float pos[3], float nor[3], float tex[2]) :
-		data(), index(0) {
-		size_t size = 3;
-		if (nor != nullptr) {
-			size += 3;
-		}
-		if (tex != nullptr) {
-			size += 2;
-		}
-		data.reserve(size);
-		data.push_back(pos[0]);
-		data.push_back(pos[1]);
-		data.push_back(pos[2]);
-		if (nor != nullptr) {
-			data.push_back(nor[0]);
-			data.push_back(nor[1]);
-			data.push_back(nor[2]);
-		}
-		if (tex != nullptr) {
-			// Texture offsets are ignored here.
-			data.push_back(tex[0]);
-			data.push_back(tex[1]);
-		}
-	}
-
-	Vertex & operator=(const Vertex & other) {
-		data = other.data;
-		index = other.index;
-		return *this;
-	}
-
-	bool operator<(const Vertex & other) const {
-		// Do not compare index here.
-		return data < other.data;
-	}
-
-	std::vector<float> data;
-	uint32_t index;
-};
-
-static void triangulate(std::list<uint32_t> & l) {
-	if (l.size() <= 3) {
-		if(l.size() < 3) {
-			WARN("cannot triangulate list with < 3 entries");
-			l.clear();
-		}
-		return;
-	}
-	// Copy list.
-	std::list<uint32_t> old(l);
-	l.clear();
-
-	uint32_t a, b, c;
-	a = old.front();
-	old.pop_front();
-	b = old.front();
-	old.pop_front();
-	c = old.front();
-	old.pop_front();
-	l.push_back(a);
-	l.push_back(b);
-	l.push_back(c);
-	while (!old.empty()) {
-		b = c;
-		c = old.front();
-		old.pop_front();
-		l.push_back(a);
-		l.push_back(b);
-		l.push_back(c);
-	}
+void StreamerOBJ::setNumThreads(uint32_t numThreads) {
+	numParserThreads = numThreads;
 }
 
-
-static Mesh * createMesh(VertexDescription * vertexDesc, const std::list<uint32_t> & faces, const std::set<Vertex> & vertexSet) {
-	Util::Reference<Mesh> mesh = new Mesh;
-
-
-	// Create index data.
-	std::size_t indexCount = faces.size();
-
-	MeshIndexData & indices = mesh->openIndexData();
-	indices.allocate(indexCount);
-	uint32_t * indexData = indices.data();
-
-
-	// Mapping is done because one face list may reference only a small subset of the vertices.
-	std::map<uint32_t, uint32_t> indexMap;
-
-	uint32_t newIndex = 0;
-	for(const auto & face : faces) {
-		auto find = indexMap.lower_bound(face);
-		if(find == indexMap.end() || indexMap.key_comp()(face, find->first)) {
-			find = indexMap.insert(find, std::make_pair(face, newIndex));
-			++newIndex;
-		}
-		*indexData = find->second;
-		++indexData;
-	}
-	indices.updateIndexRange();
-
-	// Create vertex data.
-	MeshVertexData & vertices = mesh->openVertexData();
-	vertices.allocate(indexMap.size(), *vertexDesc);
-
-	const uint16_t posOffset = vertexDesc->getAttribute(VertexAttributeIds::POSITION).getOffset();
-	const uint16_t texOffset = vertexDesc->getAttribute(VertexAttributeIds::TEXCOORD0).getOffset();
-	const uint16_t norOffset = vertexDesc->getAttribute(VertexAttributeIds::NORMAL).getOffset();
-
-	uint8_t * data = vertices.data();
-	for(const auto & vertex : vertexSet) {
-		auto find = indexMap.find(vertex.index);
-		if (find != indexMap.end()) {
-			// Copy position.
-			auto end = std::next(vertex.data.begin(), 3);
-			std::copy(vertex.data.begin(), end, reinterpret_cast<float *> (data + (find->second * vertexDesc->getVertexSize()) + posOffset));
-
-			const bool texAvail = vertex.data.size() == 5 || vertex.data.size() == 8;
-			const bool norAvail = vertex.data.size() == 6 || vertex.data.size() == 8;
-			if(norAvail) {
-				// Copy normal.
-				auto begin = end;
-				std::advance(end, 3);
-				std::copy(begin, end, reinterpret_cast<float *> (data + (find->second * vertexDesc->getVertexSize()) + norOffset));
-			}
-			if(texAvail) {
-				// Copy texture coordinate.
-				auto begin = end;
-				std::advance(end, 2);
-				std::copy(begin, end, reinterpret_cast<float *> (data + (find->second * vertexDesc->getVertexSize()) + texOffset));
-			}
-		}
-	}
-	vertices.updateBoundingBox();
-
-	MeshUtils::shrinkMesh(mesh.get());
-
-	if (mesh->getVertexCount() == 0 || mesh->getIndexCount() == 0) {
-		mesh = nullptr;
-	}
-
-	return mesh.detachAndDecrease();
+uint32_t StreamerOBJ::getNumThreads() {
+	if(numParserThreads != 0)
+		return numParserThreads;
+	return TaskScheduler::get().getConcurrency();
 }
 
-Util::GenericAttributeList * StreamerOBJ::loadGeneric(std::istream & input) {
-	auto descriptionList = new Util::GenericAttributeList;
-
-	std::set<Vertex> vertices;
+namespace {
+using namespace TextParsing;
 
+static const size_t MIN_CHUNK_SIZE = 4 * 1024 * 1024;
 
-	// Insert initial items, because first index for OBJ is 1.
-	std::vector<float> positions(3, 0.0f);
-	std::vector<float> normals(3, 0.0f);
-	std::vector<float> texcoords(2, 0.0f);
-
-	std::list<uint32_t> faces;
-
-	std::string currentMtl;
-	std::list<std::string> mtlFiles;
+//! Indices (1-based, 0 = not given) of position, texture coordinate and normal of a face vertex.
+struct FaceVertex {
+	std::array<int32_t, 3> index;
+	//! Bit i is set if index[i] is relative to the number of values defined in the chunk before the face.
+	uint8_t relative;
+};
 
-	VertexDescription * vertexDesc = nullptr;
+struct Command {
+	enum type_t { FACE, NEW_GROUP, USE_MATERIAL, MATERIAL_LIBRARY, UNKNOWN_KEYWORD };
+	type_t type;
+	uint32_t first; //!< FACE: first FaceVertex
+	uint32_t count; //!< FACE: number of vertices
+	std::string text;
+};
 
-	char chars[256];
+//! Result of tokenizing a line-aligned part of the file.
+struct Chunk {
+	std::vector<float> positions;
+	std::vector<float> texCoords;
+	std::vector<float> normals;
+	std::vector<FaceVertex> faceVertices;
+	std::vector<Command> commands;
+};
 
-	while (input.getline(chars, 256)) {
-		char * cursor = chars;
-		StringUtils::stepWhitespaces(&cursor);
-		if (*cursor == 'v') {
+void parseChunk(const char * cursor, const char * end, Chunk & chunk) {
+	while(cursor != end) {
+		skipBlanks(cursor, end);
+		if(cursor == end)
+			break;
+		if(*cursor == 'v') {
 			++cursor;
-			if (*cursor == ' ') {
-				++cursor;
-				float pos[3];
-				pos[0] = strtof(cursor, &cursor);
-				pos[1] = strtof(cursor, &cursor);
-				pos[2] = strtof(cursor, &cursor);
-				positions.insert(positions.end(), pos, pos + 3);
-			} else if (*cursor == 't') {
+			if(cursor != end && isBlank(*cursor)) {
+				for(uint_fast8_t i = 0; i < 3; ++i)
+					chunk.positions.push_back(parseFloat(cursor, end));
+			} else if(cursor != end && *cursor == 't') {
 				++cursor;
-				float texCoord[2];
-				texCoord[0] = strtof(cursor, &cursor);
-				texCoord[1] = strtof(cursor, &cursor);
-				texcoords.insert(texcoords.end(), texCoord, texCoord + 2);
-			} else if (*cursor == 'n') {
+				for(uint_fast8_t i = 0; i < 2; ++i)
+					chunk.texCoords.push_back(parseFloat(cursor, end));
+			} else if(cursor != end && *cursor == 'n') {
 				++cursor;
-				float normal[3];
-				normal[0] = strtof(cursor, &cursor);
-				normal[1] = strtof(cursor, &cursor);
-				normal[2] = strtof(cursor, &cursor);
-				normals.insert(normals.end(), normal, normal + 3);
+				for(uint_fast8_t i = 0; i < 3; ++i)
+					chunk.normals.push_back(parseFloat(cursor, end));
 			}
-		} else if (*cursor == 'f') {
+		} else if(*cursor == 'f') {
 			++cursor;
-			int32_t v = 0, vt = 0, vn = 0;
-			v = strtol(cursor, &cursor, 10);
-			std::list<uint32_t> vertexIndexList;
-			while (v != 0) {
-				if (*cursor == '/') {
+			const std::array<int32_t, 3> counts = {{	static_cast<int32_t>(chunk.positions.size() / 3),
+														static_cast<int32_t>(chunk.texCoords.size() / 2),
+														static_cast<int32_t>(chunk.normals.size() / 3)	}};
+			Command command;
+			command.type = Command::FACE;
+			command.first = static_cast<uint32_t>(chunk.faceVertices.size());
+			while(true) {
+				skipBlanks(cursor, end);
+				FaceVertex vertex;
+				vertex.index.fill(0);
+				vertex.relative = 0;
+				if(!parseInt(cursor, end, vertex.index[0]) || vertex.index[0] == 0)
+					break;
+				if(cursor != end && *cursor == '/') {
 					++cursor;
-					vt = strtol(cursor, &cursor, 10);
-					if (*cursor == '/') {
+					parseInt(cursor, end, vertex.index[1]);
+					if(cursor != end && *cursor == '/') {
 						++cursor;
-						vn = strtol(cursor, &cursor, 10);
+						parseInt(cursor, end, vertex.index[2]);
 					}
 				}
-				if (!vertexDesc) {
-					vertexDesc = new VertexDescription;
-					vertexDesc->appendAttribute(VertexAttributeIds::POSITION, 3, GL_FLOAT,false);
-					if (vt != 0) {
-						vertexDesc->appendAttribute(VertexAttributeIds::TEXCOORD0, 2, GL_FLOAT,false);
-					}
-					if (vn != 0) {
-						vertexDesc->appendAttribute(VertexAttributeIds::NORMAL, 3, GL_FLOAT,false);
+				for(uint_fast8_t i = 0; i < 3; ++i) {
+					if(vertex.index[i] < 0) {
+						vertex.index[i] += counts[i] + 1;
+						vertex.relative |= (1 << i);
 					}
 				}
+				chunk.faceVertices.push_back(vertex);
+			}
+			command.count = static_cast<uint32_t>(chunk.faceVertices.size()) - command.first;
+			chunk.commands.push_back(command);
+		} else if(*cursor == 'g' || *cursor == 's') {
+			chunk.commands.push_back({Command::NEW_GROUP, 0, 0, std::string()});
+		} else if(end - cursor >= 6 && std::equal(cursor, cursor + 6, "usemtl")) {
+			cursor += 6;
+			chunk.commands.push_back({Command::USE_MATERIAL, 0, 0, readRestOfLine(cursor, end)});
+		} else if(end - cursor >= 6 && std::equal(cursor, cursor + 6, "mtllib")) {
+			cursor += 6;
+			chunk.commands.push_back({Command::MATERIAL_LIBRARY, 0, 0, readRestOfLine(cursor, end)});
+		} else if(*cursor != '#' && *cursor != '\n' && *cursor != '\r' && *cursor != 'o') {
+			chunk.commands.push_back({Command::UNKNOWN_KEYWORD, 0, 0, std::string(1, *cursor)});
+		}
+		skipLine(cursor, end);
+	}
+}
 
-				float * tex = nullptr;
-				float * nor = nullptr;
-				if(v < 0)
-					v = positions.size()/3 + v;
-				if(vt < 0)
-					vt = texcoords.size()/2 + vt;
-				if(vn < 0)
-					vn = normals.size()/3 + vn;
-				
-				if (vt != 0) {
-					tex = &texcoords[2 * vt];
-				}
-				if (vn != 0) {
-					nor = &normals[3 * vn];
-				}
-				uint32_t index;
-				Vertex vertex(&positions[3 * v], nor, tex);
-				auto iter = vertices.lower_bound(vertex);
-				if (iter != vertices.end() && !(vertices.key_comp()(vertex, *iter))) {
-					index = iter->index;
-				} else {
-					vertex.index = vertices.size();
-					vertices.insert(iter, vertex);
-					index = vertex.index;
-				}
+struct FaceVertexHash {
+	size_t operator()(const std::array<uint32_t, 3> & key) const {
+		return (static_cast<size_t>(key[0]) * 73856093u) ^ (static_cast<size_t>(key[1]) * 19349663u) ^ (static_cast<size_t>(key[2]) * 83492791u);
+	}
+};
+
+//! Collects the faces of one mesh; each distinct (position, texture coordinate, normal) triple becomes one vertex.
+class MeshAssembler {
+	public:
+		MeshAssembler(const std::vector<float> & _positions, const std::vector<float> & _texCoords, const std::vector<float> & _normals) :
+			positions(_positions), texCoords(_texCoords), normals(_normals), hasTexCoords(false), hasNormals(false), outOfRange(false) {
+		}
 
-				vertexIndexList.push_back(index);
+		bool empty() const {
+			return vertexDescription.getVertexSize() == 0;
+		}
 
-				v = strtoul(cursor, &cursor, 10);
+		void addFace(const std::array<uint32_t, 3> * faceVertices, uint32_t count) {
+			if(count < 3) {
+				WARN("cannot triangulate list with < 3 entries");
+				return;
 			}
-			triangulate(vertexIndexList);
-			while (!vertexIndexList.empty()) {
-				// Append one triangle.
-				for (uint_fast8_t i = 0; i < 3; ++i) {
-					faces.push_back(vertexIndexList.front());
-					vertexIndexList.pop_front();
+			for(uint32_t i = 0; i < count; ++i) {
+				if(faceVertices[i][0] > positions.size() / 3 || faceVertices[i][1] > texCoords.size() / 2 || faceVertices[i][2] > normals.size() / 3) {
+					if(!outOfRange)
+						WARN("OBJ face references undefined vertex data; face skipped.");
+					outOfRange = true;
+					return;
 				}
 			}
-		} else if (StringUtils::beginsWith(cursor, "mtllib")) {
-			cursor += 6;
-			mtlFiles.push_back(StringUtils::trim(cursor));
-		} else if (*cursor == 'g' || *cursor == 's') {
-			if (!vertexDesc)
-				continue;
-
-			Mesh * mesh = createMesh(vertexDesc, faces, vertices);
-			vertexDesc = nullptr;
-			faces.clear();
-			if(mesh) {
-				Util::GenericAttributeMap * d = Serialization::createMeshDescription(mesh);
-				d->setString(Serialization::DESCRIPTION_MATERIAL_NAME, currentMtl);
-				descriptionList->push_back(d);
+			if(empty()) {
+				hasTexCoords = faceVertices[0][1] != 0;
+				hasNormals = faceVertices[0][2] != 0;
+				vertexDescription.appendAttribute(VertexAttributeIds::POSITION, 3, GL_FLOAT, false);
+				if(hasTexCoords)
+					vertexDescription.appendAttribute(VertexAttributeIds::TEXCOORD0, 2, GL_FLOAT, false);
+				if(hasNormals)
+					vertexDescription.appendAttribute(VertexAttributeIds::NORMAL, 3, GL_FLOAT, false);
 			}
-		} else if (StringUtils::beginsWith(cursor, "usemtl")) {
-
-			if (vertexDesc) {
-				Mesh * mesh = createMesh(vertexDesc, faces, vertices);
-				vertexDesc = nullptr;
-				faces.clear();
-				if(mesh) {
-					Util::GenericAttributeMap * d = Serialization::createMeshDescription(mesh);
-					d->setString(Serialization::DESCRIPTION_MATERIAL_NAME, currentMtl);
-					descriptionList->push_back(d);
-				}
+			// triangle fan
+			const uint32_t a = getVertex(faceVertices[0]);
+			uint32_t c = getVertex(faceVertices[1]);
+			for(uint32_t i = 2; i < count; ++i) {
+				const uint32_t b = c;
+				c = getVertex(faceVertices[i]);
+				indices.push_back(a);
+				indices.push_back(b);
+				indices.push_back(c);
 			}
-			cursor += 6;
-			currentMtl = StringUtils::trim(cursor);
-		} else if (*cursor != '#' && *cursor != '\0' && *cursor != '\n' && *cursor != '\r' && *cursor != 'o') {
-			WARN(std::string("Unknown OBJ keyword \"") + *cursor + "\".");
 		}
+
+		//! Create the mesh and reset the assembler. Returns nullptr if the mesh would be empty.
+		Mesh * createMesh() {
+			Util::Reference<Mesh> mesh = new Mesh;
+			if(!indices.empty()) {
+				MeshIndexData & indexData = mesh->openIndexData();
+				indexData.allocate(indices.size());
+				std::copy(indices.begin(), indices.end(), indexData.data());
+				indexData.updateIndexRange();
+
+				const uint32_t numFloats = vertexDescription.getVertexSize() / sizeof(float);
+				MeshVertexData & vertexData = mesh->openVertexData();
+				vertexData.allocate(vertexValues.size() / numFloats, vertexDescription);
+				std::copy(vertexValues.begin(), vertexValues.end(), reinterpret_cast<float *>(vertexData.data()));
+				vertexData.updateBoundingBox();
+
+				MeshUtils::shrinkMesh(mesh.get());
+			}
+			vertexDescription = VertexDescription();
+			vertexMap.clear();
+			vertexValues.clear();
+			indices.clear();
+			if(mesh->getVertexCount() == 0 || mesh->getIndexCount() == 0)
+				mesh = nullptr;
+			return mesh.detachAndDecrease();
+		}
+
+	private:
+		const std::vector<float> & positions;
+		const std::vector<float> & texCoords;
+		const std::vector<float> & normals;
+		VertexDescription vertexDescription;
+		bool hasTexCoords;
+		bool hasNormals;
+		bool outOfRange;
+		std::unordered_map<std::array<uint32_t, 3>, uint32_t, FaceVertexHash> vertexMap;
+		std::vector<float> vertexValues;
+		std::vector<uint32_t> indices;
+
+		uint32_t getVertex(const std::array<uint32_t, 3> & key) {
+			const uint32_t newIndex = static_cast<uint32_t>(vertexMap.size());
+			auto result = vertexMap.emplace(key, newIndex);
+			if(!result.second)
+				return result.first->second;
+
+			// The positions etc. are shifted by one, as the first index in an OBJ file is 1.
+			const float * pos = key[0] == 0 ? zeros : &positions[3 * (key[0] - 1)];
+			vertexValues.insert(vertexValues.end(), pos, pos + 3);
+			if(hasTexCoords) {
+				const float * tex = key[1] == 0 ? zeros : &texCoords[2 * (key[1] - 1)];
+				vertexValues.insert(vertexValues.end(), tex, tex + 2);
+			}
+			if(hasNormals) {
+				const float * nor = key[2] == 0 ? zeros : &normals[3 * (key[2] - 1)];
+				vertexValues.insert(vertexValues.end(), nor, nor + 3);
+			}
+			return newIndex;
+		}
+		static const float zeros[3];
+};
+const float MeshAssembler::zeros[3] = {0.0f, 0.0f, 0.0f};
+
+}
+
+Util::GenericAttributeList * StreamerOBJ::loadGeneric(std::istream & input) {
+	// read the whole file
+	std::vector<char> buffer;
+	{
+		static const size_t blockSize = 1024 * 1024;
+		size_t size = 0;
+		while(input.good()) {
+			buffer.resize(size + blockSize);
+			input.read(buffer.data() + size, blockSize);
+			size += static_cast<size_t>(input.gcount());
+		}
+		buffer.resize(size);
 	}
 
-	Mesh * mesh = createMesh(vertexDesc, faces, vertices);
-	faces.clear();
-	if(mesh) {
-		Util::GenericAttributeMap * d = Serialization::createMeshDescription(mesh);
-		d->setString(Serialization::DESCRIPTION_MATERIAL_NAME, currentMtl);
-		descriptionList->push_back(d);
+	// split into line-aligned chunks and tokenize them
+	const size_t numChunks = std::max<size_t>(1, std::min<size_t>(getNumThreads(), buffer.size() / MIN_CHUNK_SIZE));
+	std::vector<const char *> chunkBegins;
+	const char * const bufferEnd = buffer.data() + buffer.size();
+	chunkBegins.push_back(buffer.data());
+	for(size_t i = 1; i < numChunks; ++i) {
+		const char * split = std::max(chunkBegins.back(), buffer.data() + i * (buffer.size() / numChunks));
+		split = std::find(split, bufferEnd, '\n');
+		chunkBegins.push_back(split == bufferEnd ? bufferEnd : split + 1);
+	}
+	chunkBegins.push_back(bufferEnd);
+
+	std::vector<Chunk> chunks(numChunks);
+	if(numChunks == 1) {
+		parseChunk(chunkBegins[0], chunkBegins[1], chunks[0]);
+	} else {
+		TaskScheduler & scheduler = TaskScheduler::get();
+		TaskScheduler::TaskGroup group;
+		for(size_t i = 1; i < numChunks; ++i)
+			scheduler.run(group, std::bind(parseChunk, chunkBegins[i], chunkBegins[i + 1], std::ref(chunks[i])), "StreamerOBJ::parseChunk");
+		parseChunk(chunkBegins[0], chunkBegins[1], chunks[0]);
+		scheduler.wait(group);
+	}
+	std::vector<char>().swap(buffer);
+
+	// merge the vertex data
+	std::vector<float> positions;
+	std::vector<float> texCoords;
+	std::vector<float> normals;
+	if(numChunks == 1) {
+		positions.swap(chunks[0].positions);
+		texCoords.swap(chunks[0].texCoords);
+		normals.swap(chunks[0].normals);
+	} else {
+		size_t numPositions = 0, numTexCoords = 0, numNormals = 0;
+		for(const auto & chunk : chunks) {
+			numPositions += chunk.positions.size();
+			numTexCoords += chunk.texCoords.size();
+			numNormals += chunk.normals.size();
+		}
+		positions.reserve(numPositions);
+		texCoords.reserve(numTexCoords);
+		normals.reserve(numNormals);
+	}
+
+	auto descriptionList = new Util::GenericAttributeList;
+	std::list<std::string> mtlFiles;
+	std::string currentMtl;
+	MeshAssembler assembler(positions, texCoords, normals);
+	auto finishMesh = [&]() {
+		if(assembler.empty())
+			return;
+		Mesh * mesh = assembler.createMesh();
+		if(mesh) {
+			Util::GenericAttributeMap * d = Serialization::createMeshDescription(mesh);
+			d->setString(Serialization::DESCRIPTION_MATERIAL_NAME, currentMtl);
+			descriptionList->push_back(d);
+		}
+	};
+
+	// assemble the meshes in file order
+	std::vector<std::array<uint32_t, 3>> faceVertices;
+	for(auto & chunk : chunks) {
+		const std::array<uint32_t, 3> base = {{	static_cast<uint32_t>(positions.size() / 3),
+												static_cast<uint32_t>(texCoords.size() / 2),
+												static_cast<uint32_t>(normals.size() / 3)	}};
+		if(numChunks > 1) {
+			positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+			texCoords.insert(texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+			normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+		}
+		for(const auto & command : chunk.commands) {
+			switch(command.type) {
+				case Command::FACE: {
+					faceVertices.clear();
+					for(uint32_t i = command.first; i < command.first + command.count; ++i) {
+						const FaceVertex & vertex = chunk.faceVertices[i];
+						std::array<uint32_t, 3> key;
+						for(uint_fast8_t j = 0; j < 3; ++j) {
+							const int64_t index = static_cast<int64_t>(vertex.index[j]) + (((vertex.relative >> j) & 1) ? base[j] : 0);
+							// negative results are invalid; map them to a value that is always out of range
+							key[j] = index < 0 ? std::numeric_limits<uint32_t>::max() : static_cast<uint32_t>(index);
+						}
+						faceVertices.push_back(key);
+					}
+					assembler.addFace(faceVertices.data(), static_cast<uint32_t>(faceVertices.size()));
+					break;
+				}
+				case Command::NEW_GROUP:
+					finishMesh();
+					break;
+				case Command::USE_MATERIAL:
+					finishMesh();
+					currentMtl = command.text;
+					break;
+				case Command::MATERIAL_LIBRARY:
+					mtlFiles.push_back(command.text);
+					break;
+				case Command::UNKNOWN_KEYWORD:
+				default:
+					WARN(std::string("Unknown OBJ keyword \"") + command.text + "\".");
+					break;
+			}
+		}
+		// free memory early
+		std::vector<float>().swap(chunk.positions);
+		std::vector<float>().swap(chunk.texCoords);
+		std::vector<float>().swap(chunk.normals);
+		std::vector<FaceVertex>().swap(chunk.faceVertices);
 	}
+	finishMesh();
 
 	// Traverse list in reverse order to get right order again when using push_front below.
 	for(auto it = mtlFiles.rbegin(); it != mtlFiles.rend(); ++it) {
@@ -12,9 +12,16 @@
 #define RENDERING_STREAMEROBJ_H_
 
 #include "AbstractRenderingStreamer.h"
+#include <cstdint>
 
 namespace Rendering {
 
+/**
+ * Loader for Wavefront .obj files.
+ *
+ * The whole input is read into memory and split into line-aligned chunks that are tokenized in parallel
+ * (see setNumThreads()). Afterwards, the faces of all chunks are assembled into meshes in file order.
+ */
 class StreamerOBJ : public AbstractRenderingStreamer {
 	public:
 		StreamerOBJ() :
@@ -27,6 +34,11 @@ class StreamerOBJ : public AbstractRenderingStreamer {
 
 		static uint8_t queryCapabilities(const std::string & extension);
 		static const char * const fileExtension;
+
+		/*! Set the maximum number of threads used for parsing. A value of 0 uses the number of hardware threads;
+			1 disables parallel parsing. Files are only split into chunks of at least 4 MiB.	*/
+		static void setNumThreads(uint32_t numThreads);
+		static uint32_t getNumThreads();
 };
 }
 
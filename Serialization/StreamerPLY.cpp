@@ -15,11 +15,15 @@
 #include "../Mesh/VertexDescription.h"
 #include "../GLHeader.h"
 #include "../Helper.h"
+#include "../TaskScheduler.h"
 #include <Geometry/Convert.h>
 #include <Util/Graphics/Color.h>
 #include <Util/GenericAttribute.h>
 #include <Util/StringUtils.h>
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <sstream>
@@ -210,6 +214,38 @@ class PLY_Element {
 		const Property & getProperty(int16_t index) const {
 			return entries[index];
 		}
+
+		int16_t getNumProperties() const {
+			return static_cast<int16_t>(entries.size());
+		}
+
+		format_t getFormat() const {
+			return sourceFormat;
+		}
+
+		std::string getPropertyName(int16_t index) const {
+			for(const auto & entry : names) {
+				if(entry.second == index)
+					return entry.first;
+			}
+			return std::string();
+		}
+
+		/**
+		 * Calculate the byte offset of each property inside a binary row.
+		 * @return the size of a row, or 0 if the element contains lists (i.e. the rows have no fixed size).
+		 */
+		uint32_t getFixedRowLayout(std::vector<uint32_t> & offsets) const {
+			offsets.clear();
+			uint32_t rowSize = 0;
+			for(const auto & e : entries) {
+				if(e.isList())
+					return 0;
+				offsets.push_back(rowSize);
+				rowSize += getDataSize(e.dataType);
+			}
+			return rowSize;
+		}
 		/**
 		 * // dataSize <64 !!!!!!!
 		 */
@@ -378,6 +414,387 @@ class PLY_Element {
 
 //-------------------------------------------------------------------------------------------------
 
+static uint32_t numLoaderThreads = 0;
+
+void StreamerPLY::setNumThreads(uint32_t numThreads) {
+	numLoaderThreads = numThreads;
+}
+
+uint32_t StreamerPLY::getNumThreads() {
+	if(numLoaderThreads != 0)
+		return numLoaderThreads;
+	return TaskScheduler::get().getConcurrency();
+}
+
+//! Minimum number of vertices per thread.
+static const uint32_t MIN_VERTICES_PER_THREAD = 64 * 1024;
+
+//! Reverse the byte order of all @p size byte values starting at @p data with the given stride.
+static void swapBytes(uint8_t * data, size_t numValues, uint8_t size, size_t stride) {
+	for(size_t i = 0; i < numValues; ++i, data += stride)
+		std::reverse(data, data + size);
+}
+
+//! Reverse the byte order of @p numValues consecutive 32 bit values (written to be auto-vectorized).
+static void swapBytes32(uint8_t * data, size_t numValues) {
+	for(size_t i = 0; i < numValues; ++i) {
+		uint32_t v;
+		std::memcpy(&v, data + i * 4, 4);
+		v = ((v & 0x000000ffu) << 24) | ((v & 0x0000ff00u) << 8) | ((v & 0x00ff0000u) >> 8) | ((v & 0xff000000u) >> 24);
+		std::memcpy(data + i * 4, &v, 4);
+	}
+}
+
+/**
+ * If all properties of a binary vertex element form known attributes (x,y,z[,w] / nx,ny,nz[,nw] / red,green,blue[,alpha] /
+ * s,t[,u] or u,v) with a type that can be used directly, create the vertex description with the same memory layout.
+ * The rows can then be copied into the vertex data without conversion.
+ */
+static bool createMatchingVertexDescription(const PLY_Element & e, VertexDescription & vd) {
+	struct Group {
+		Util::StringIdentifier attrId;
+		const char * names[4];
+		uint8_t minCount;
+		bool used;
+	};
+	Group groups[] = {
+		{VertexAttributeIds::POSITION, {"x", "y", "z", "w"}, 3, false},
+		{VertexAttributeIds::NORMAL, {"nx", "ny", "nz", "nw"}, 3, false},
+		{VertexAttributeIds::COLOR, {"red", "green", "blue", "alpha"}, 3, false},
+		{VertexAttributeIds::TEXCOORD0, {"s", "t", "u", nullptr}, 2, false},
+		{VertexAttributeIds::TEXCOORD0, {"u", "v", nullptr, nullptr}, 2, false}
+	};
+	const int16_t numProperties = e.getNumProperties();
+	if(numProperties == 0)
+		return false;
+	for(int16_t i = 0; i < numProperties;) {
+		const std::string name = e.getPropertyName(i);
+		const uint8_t type = e.getProperty(i).dataType;
+		Group * group = nullptr;
+		for(auto & g : groups) {
+			if(!g.used && name == g.names[0])
+				group = &g;
+		}
+		if(group == nullptr || group->used)
+			return false;
+		uint8_t count = 1;
+		while(count < 4 && group->names[count] != nullptr && i + count < numProperties
+				&& e.getPropertyName(i + count) == group->names[count] && e.getProperty(i + count).dataType == type)
+			++count;
+		if(count < group->minCount)
+			return false;
+
+		if(group->attrId == VertexAttributeIds::NORMAL && type == PLY_Element::TYPE_CHAR) {
+			vd.appendAttribute(group->attrId, count, GL_BYTE, true);
+		} else if(group->attrId == VertexAttributeIds::COLOR && type == PLY_Element::TYPE_UCHAR) {
+			vd.appendAttribute(group->attrId, count, GL_UNSIGNED_BYTE, true);
+		} else if(type == PLY_Element::TYPE_FLOAT) {
+			vd.appendAttribute(group->attrId, count, GL_FLOAT, false);
+		} else {
+			return false;
+		}
+		for(auto & g : groups) { // s,t and u,v are alternatives
+			if(g.attrId == group->attrId)
+				g.used = true;
+		}
+		i += count;
+	}
+	return true;
+}
+
+//! Values of the current row parsed by PLY_Element::parseData.
+struct ParsedRowSource {
+	const PLY_Element & element;
+	explicit ParsedRowSource(const PLY_Element & _element) : element(_element) {}
+	uint8_t getType(int index) const {
+		return element.getProperty(index).dataType;
+	}
+	template<typename t> t get(int index) const {
+		return element.getProperty(index).getCurrentValue<t>();
+	}
+};
+
+//! Values of a binary row with a fixed layout; only the requested values are decoded.
+struct BinaryRowSource {
+	const PLY_Element & element;
+	const std::vector<uint32_t> & offsets;
+	const bool flipBytes;
+	const uint8_t * row;
+	BinaryRowSource(const PLY_Element & _element, const std::vector<uint32_t> & _offsets, bool _flipBytes) :
+		element(_element), offsets(_offsets), flipBytes(_flipBytes), row(nullptr) {}
+	uint8_t getType(int index) const {
+		return element.getProperty(index).dataType;
+	}
+	template<typename t> t get(int index) const {
+		const uint8_t type = getType(index);
+		const uint8_t * data = row + offsets[index];
+		const uint8_t size = PLY_Element::getDataSize(type);
+		switch(type) {
+			case PLY_Element::TYPE_FLOAT:	return static_cast<t>(element.getBinaryNumber<float>(data, size, flipBytes));
+			case PLY_Element::TYPE_DOUBLE:	return static_cast<t>(element.getBinaryNumber<double>(data, size, flipBytes));
+			case PLY_Element::TYPE_CHAR:	return static_cast<t>(element.getBinaryNumber<int8_t>(data, size, flipBytes));
+			case PLY_Element::TYPE_UCHAR:	return static_cast<t>(element.getBinaryNumber<uint8_t>(data, size, flipBytes));
+			case PLY_Element::TYPE_SHORT:	return static_cast<t>(element.getBinaryNumber<int16_t>(data, size, flipBytes));
+			case PLY_Element::TYPE_USHORT:	return static_cast<t>(element.getBinaryNumber<uint16_t>(data, size, flipBytes));
+			case PLY_Element::TYPE_INT:		return static_cast<t>(element.getBinaryNumber<int32_t>(data, size, flipBytes));
+			case PLY_Element::TYPE_UINT:	return static_cast<t>(element.getBinaryNumber<uint32_t>(data, size, flipBytes));
+			default:						return static_cast<t>(0);
+		}
+	}
+};
+
+/**
+ * Mapping of the properties of a vertex element to the attributes of the loaded vertex data.
+ * It is created once per header and applied to each row.
+ */
+struct VertexMapping {
+	int xIndex, yIndex, zIndex;
+	int nxIndex, nyIndex, nzIndex;
+	int sIndex, tIndex;
+	int redIndex, greenIndex, blueIndex, alphaIndex;
+	bool useVertexNormals, useTex0, useVertexColor;
+	int posOffset, normalsOffset, colorOffset, tex0Offset;
+	int vertexSize;
+
+	VertexMapping(const PLY_Element & e, VertexDescription & vFormat) {
+		const VertexAttribute & posAttr = vFormat.appendPosition3D();
+		posOffset = posAttr.getOffset();
+
+		xIndex=e.getPropertyIndex("x");
+		yIndex=e.getPropertyIndex("y");
+		zIndex=e.getPropertyIndex("z");
+
+		nxIndex=e.getPropertyIndex("nx");
+		nyIndex=e.getPropertyIndex("ny");
+		nzIndex=e.getPropertyIndex("nz");
+
+		useVertexNormals = useTex0 = useVertexColor = false;
+		normalsOffset = colorOffset = tex0Offset = 0;
+		if(nxIndex>=0&&nyIndex>=0&&nzIndex>=0) {
+			useVertexNormals=true;
+			normalsOffset = vFormat.appendNormalByte().getOffset();
+		}
+		sIndex=e.getPropertyIndex("s");
+		tIndex=e.getPropertyIndex("t");
+		if(sIndex>=0&&tIndex>=0) {
+			useTex0=true;
+			tex0Offset = vFormat.appendTexCoord().getOffset();
+		}
+		if(!useTex0) {
+			sIndex=e.getPropertyIndex("u");
+			tIndex=e.getPropertyIndex("v");
+			if(sIndex>=0&&tIndex>=0) {
+				useTex0=true;
+				tex0Offset = vFormat.appendTexCoord().getOffset();
+			}
+		}
+		redIndex=e.getPropertyIndex("red");
+		greenIndex=e.getPropertyIndex("green");
+		blueIndex=e.getPropertyIndex("blue");
+		alphaIndex=e.getPropertyIndex("alpha");
+		if(redIndex>=0&&greenIndex>=0&&blueIndex>=0) {
+			useVertexColor=true;
+			colorOffset = vFormat.appendColorRGBAByte().getOffset();
+		}
+		vertexSize=vFormat.getVertexSize();
+	}
+
+	template<typename Source>
+	void writeVertex(const Source & e, uint8_t * vCursor) const {
+		*((reinterpret_cast<float *>(vCursor+posOffset))+0)=e.template get<float>(xIndex);
+		*((reinterpret_cast<float *>(vCursor+posOffset))+1)=e.template get<float>(yIndex);
+		*((reinterpret_cast<float *>(vCursor+posOffset))+2)=e.template get<float>(zIndex);
+		if(useVertexNormals) {
+			GLbyte nx,ny,nz;
+			if(e.getType(nxIndex)==PLY_Element::TYPE_CHAR){
+				nx=e.template get<GLbyte>(nxIndex);
+				ny=e.template get<GLbyte>(nyIndex);
+				nz=e.template get<GLbyte>(nzIndex);
+			}else{
+				nx= Geometry::Convert::toSigned<int8_t>(e.template get<float>(nxIndex));
+				ny= Geometry::Convert::toSigned<int8_t>(e.template get<float>(nyIndex));
+				nz= Geometry::Convert::toSigned<int8_t>(e.template get<float>(nzIndex));
+			}
+			*((reinterpret_cast<GLbyte *>(vCursor+normalsOffset))+0)=nx;
+			*((reinterpret_cast<GLbyte *>(vCursor+normalsOffset))+1)=ny;
+			*((reinterpret_cast<GLbyte *>(vCursor+normalsOffset))+2)=nz;
+		}
+		if(useVertexColor) {
+			Util::Color4ub color;
+			if(e.getType(redIndex) == PLY_Element::TYPE_FLOAT) {
+				Util::Color4f floatColor;
+				floatColor.setR(e.template get<float>(redIndex));
+				floatColor.setG(e.template get<float>(greenIndex));
+				floatColor.setB(e.template get<float>(blueIndex));
+				if(alphaIndex > 0) {
+					floatColor.setA(e.template get<float>(alphaIndex));
+				} else {
+					floatColor.setA(1.0f);
+				}
+				color = Util::Color4ub(floatColor);
+			} else { // most likely = TYPE_UCHAR
+				color.setR(e.template get<GLubyte>(redIndex));
+				color.setG(e.template get<GLubyte>(greenIndex));
+				color.setB(e.template get<GLubyte>(blueIndex));
+				if(alphaIndex > 0) {
+					color.setA(e.template get<GLubyte>(alphaIndex));
+				} else {
+					color.setA(255);
+				}
+			}
+			*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 0) = color.getR();
+			*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 1) = color.getG();
+			*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 2) = color.getB();
+			*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 3) = color.getA();
+		}
+		if(useTex0){
+			*((reinterpret_cast<float *>(vCursor+tex0Offset))+0)=e.template get<float>(sIndex);
+			*((reinterpret_cast<float *>(vCursor+tex0Offset))+1)=e.template get<float>(tIndex);
+		}
+	}
+};
+
+//! Run @p fun(first, count) for @p numThreads consecutive ranges of @p numItems items using the TaskScheduler.
+template<typename Fun_t>
+static void parallelFor(uint32_t numItems, uint32_t numThreads, Fun_t fun) {
+	if(numThreads <= 1) {
+		fun(0, numItems);
+		return;
+	}
+	TaskScheduler & scheduler = TaskScheduler::get();
+	TaskScheduler::TaskGroup group;
+	const uint32_t itemsPerThread = (numItems + numThreads - 1) / numThreads;
+	for(uint32_t t = 1; t < numThreads; ++t) {
+		const uint32_t first = t * itemsPerThread;
+		if(first >= numItems)
+			break;
+		scheduler.run(group, std::bind(fun, first, std::min(itemsPerThread, numItems - first)), "StreamerPLY::parallelFor");
+	}
+	if(numItems > 0)
+		fun(0, std::min(itemsPerThread, numItems));
+	scheduler.wait(group);
+}
+
+/**
+ * Read the rows of a vertex element starting at @p cursor.
+ * @return false on a buffer overrun.
+ */
+static bool readVertexElement(const PLY_Element & e, const std::vector<char> & buffer, int & cursor, MeshVertexData & vertices) {
+	const uint32_t numVertices = e.count;
+	const uint32_t numThreads = std::min(StreamerPLY::getNumThreads(), std::max(1u, numVertices / MIN_VERTICES_PER_THREAD));
+	const uint8_t * const data = reinterpret_cast<const uint8_t *>(buffer.data());
+	const size_t available = buffer.size() - static_cast<size_t>(cursor);
+
+	if(e.getFormat() != PLY_Element::ASCII) {
+		std::vector<uint32_t> offsets;
+		const uint32_t rowSize = e.getFixedRowLayout(offsets);
+		if(rowSize > 0) {
+			if(static_cast<size_t>(rowSize) * numVertices > available) {
+				std::cerr <<"!!! Buffer overrun!";
+				return false;
+			}
+			const bool flipBytes = (e.getFormat() == PLY_Element::BINARY_BIG_ENDIAN);
+			const uint8_t * const rows = data + cursor;
+
+			VertexDescription matchingFormat;
+			if(createMatchingVertexDescription(e, matchingFormat) && matchingFormat.getVertexSize() == rowSize) {
+				// the rows already have the layout of the vertex data
+				vertices.allocate(numVertices, matchingFormat);
+				std::memcpy(vertices.data(), rows, vertices.dataSize());
+				if(flipBytes) {
+					bool allFourBytes = true;
+					for(int16_t i = 0; i < e.getNumProperties(); ++i)
+						allFourBytes = allFourBytes && PLY_Element::getDataSize(e.getProperty(i).dataType) == 4;
+					if(allFourBytes) {
+						swapBytes32(vertices.data(), vertices.dataSize() / 4);
+					} else {
+						for(int16_t i = 0; i < e.getNumProperties(); ++i) {
+							const uint8_t size = PLY_Element::getDataSize(e.getProperty(i).dataType);
+							if(size > 1)
+								swapBytes(vertices.data() + offsets[i], numVertices, size, rowSize);
+						}
+					}
+				}
+			} else {
+				VertexDescription vFormat;
+				const VertexMapping mapping(e, vFormat);
+				vertices.allocate(numVertices, vFormat);
+				uint8_t * const vData = vertices.data();
+				parallelFor(numVertices, numThreads, [&](uint32_t first, uint32_t count) {
+					BinaryRowSource source(e, offsets, flipBytes);
+					for(uint32_t j = first; j < first + count; ++j) {
+						source.row = rows + static_cast<size_t>(j) * rowSize;
+						mapping.writeVertex(source, vData + static_cast<size_t>(j) * mapping.vertexSize);
+					}
+				});
+			}
+			cursor += static_cast<int>(static_cast<size_t>(rowSize) * numVertices);
+			vertices.updateBoundingBox();
+			return true;
+		}
+	}
+
+	VertexDescription vFormat;
+	const VertexMapping mapping(e, vFormat);
+	vertices.allocate(numVertices, vFormat);
+	uint8_t * const vData = vertices.data();
+
+	// Rows with lists or ascii rows: The rows are parsed one by one. For ascii data, the start of every chunk of rows is
+	// determined by counting lines (assuming one row per line), so that the chunks can be parsed in parallel.
+	std::vector<int> chunkStarts(1, cursor);
+	uint32_t rowsPerChunk = numVertices;
+	if(e.getFormat() == PLY_Element::ASCII && numThreads > 1) {
+		rowsPerChunk = (numVertices + numThreads - 1) / numThreads;
+		const char * pos = buffer.data() + cursor;
+		const char * const end = buffer.data() + buffer.size();
+		for(uint32_t j = 1; j < numVertices && pos != end; ++j) {
+			pos = std::find(pos, end, '\n');
+			if(pos != end)
+				++pos;
+			if(j % rowsPerChunk == 0)
+				chunkStarts.push_back(static_cast<int>(pos - buffer.data()));
+		}
+	}
+	if(rowsPerChunk == 0 || chunkStarts.size() != (numVertices + rowsPerChunk - 1) / rowsPerChunk) { // too few lines
+		chunkStarts.resize(1);
+		rowsPerChunk = numVertices;
+	}
+	std::vector<int> chunkEnds(chunkStarts.size(), cursor);
+	std::vector<char> overrun(chunkStarts.size(), 0);
+	auto parseRows = [&](uint32_t chunk) {
+		PLY_Element rowParser(e); // parseData stores the values of the current row
+		int chunkCursor = chunkStarts[chunk];
+		const uint32_t first = chunk * rowsPerChunk;
+		const uint32_t last = std::min(numVertices, first + rowsPerChunk);
+		for(uint32_t j = first; j < last; ++j) {
+			chunkCursor += rowParser.parseData(data + chunkCursor);
+			if(chunkCursor > static_cast<int>(buffer.size())) {
+				overrun[chunk] = 1;
+				return;
+			}
+			mapping.writeVertex(ParsedRowSource(rowParser), vData + static_cast<size_t>(j) * mapping.vertexSize);
+		}
+		chunkEnds[chunk] = chunkCursor;
+	};
+	if(chunkStarts.size() == 1) {
+		parseRows(0);
+	} else {
+		TaskScheduler & scheduler = TaskScheduler::get();
+		TaskScheduler::TaskGroup group;
+		for(uint32_t chunk = 1; chunk < chunkStarts.size(); ++chunk)
+			scheduler.run(group, std::bind(parseRows, chunk), "StreamerPLY::parseRows");
+		parseRows(0);
+		scheduler.wait(group);
+	}
+	if(std::find(overrun.begin(), overrun.end(), 1) != overrun.end()) {
+		std::cerr <<"!!! Buffer overrun!";
+		return false;
+	}
+	cursor = chunkEnds.back();
+	vertices.updateBoundingBox();
+	return true;
+}
+
 Mesh * StreamerPLY::loadMesh(std::istream & input) {
 	int cursor=0;
 
@@ -453,131 +870,13 @@ Mesh * StreamerPLY::loadMesh(std::istream & input) {
 
 	auto mesh = new Mesh;
 
-	bool useVertexColor=false;
-	bool useVertexNormals=false;
-	bool useTex0=false;
-
 	for(auto & e : elements) {
 		
 		if(e.name=="vertex") {
-			uint32_t numVertices=e.count;
-
-			VertexDescription vFormat;
-			const VertexAttribute & posAttr = vFormat.appendPosition3D();
-
-			int xIndex=e.getPropertyIndex("x");
-			int yIndex=e.getPropertyIndex("y");
-			int zIndex=e.getPropertyIndex("z");
-
-			int nxIndex=e.getPropertyIndex("nx");
-			int nyIndex=e.getPropertyIndex("ny");
-			int nzIndex=e.getPropertyIndex("nz");
-
-			VertexAttribute normalAttr;
-			if(nxIndex>=0&&nyIndex>=0&&nzIndex>=0) {
-				useVertexNormals=true;
-				normalAttr = vFormat.appendNormalByte();
-			}
-			VertexAttribute tex0Attr;
-			int sIndex=e.getPropertyIndex("s");
-			int tIndex=e.getPropertyIndex("t");
-			if(sIndex>=0&&tIndex>=0) {
-				useTex0=true;
-				tex0Attr = vFormat.appendTexCoord();
-			}
-			if(!useTex0) {
-				sIndex=e.getPropertyIndex("u");
-				tIndex=e.getPropertyIndex("v");
-				if(sIndex>=0&&tIndex>=0) {
-					useTex0=true;
-					tex0Attr = vFormat.appendTexCoord();
-				}
-			}
-			VertexAttribute colorAttr;
-			int redIndex=e.getPropertyIndex("red");
-			int greenIndex=e.getPropertyIndex("green");
-			int blueIndex=e.getPropertyIndex("blue");
-			int alphaIndex=e.getPropertyIndex("alpha");
-//#ifdef PLY_LOADER_USE_VERTEX_NORMALS
-			if(redIndex>=0&&greenIndex>=0&&blueIndex>=0) {
-				useVertexColor=true;
-				colorAttr = vFormat.appendColorRGBAByte();
+			if(!readVertexElement(e, buffer, cursor, mesh->openVertexData())) {
+				delete mesh;
+				return nullptr;
 			}
-//#endif
-			int vertexSize=vFormat.getVertexSize();
-			const int posOffset=posAttr.getOffset();
-			const int normalsOffset=normalAttr.getOffset();
-			const int colorOffset=colorAttr.getOffset();
-			const int tex0Offset=tex0Attr.getOffset();
-			MeshVertexData & vertices=mesh->openVertexData();
-			vertices.allocate(numVertices,vFormat);
-
-			uint8_t * vCursor= vertices.data();
-			for(uint32_t j=0;j<numVertices;++j) {
-//				std::cout << "<"<<j;
-				int rowSize=e.parseData(reinterpret_cast<uint8_t *>(buffer.data() + cursor));
-				cursor+=rowSize;
-//
-				*((reinterpret_cast<float *>(vCursor+posOffset))+0)=e.getProperty(xIndex).getCurrentValue<float>();
-				*((reinterpret_cast<float *>(vCursor+posOffset))+1)=e.getProperty(yIndex).getCurrentValue<float>();
-				*((reinterpret_cast<float *>(vCursor+posOffset))+2)=e.getProperty(zIndex).getCurrentValue<float>();
-				if(useVertexNormals) {
-
-					GLbyte nx,ny,nz;
-					if(e.getProperty(nxIndex).dataType==PLY_Element::TYPE_CHAR){
-						nx=e.getProperty(nxIndex).getCurrentValue<GLbyte>();
-						ny=e.getProperty(nyIndex).getCurrentValue<GLbyte>();
-						nz=e.getProperty(nzIndex).getCurrentValue<GLbyte>();
-//                        normal=Geometry::Vec3(values[indices[nxIndex]],values[indices[nyIndex]],values[indices[nzIndex]]);
-					}else{
-						nx= Geometry::Convert::toSigned<int8_t>(e.getProperty(nxIndex).getCurrentValue<float>());
-						ny= Geometry::Convert::toSigned<int8_t>(e.getProperty(nyIndex).getCurrentValue<float>());
-						nz= Geometry::Convert::toSigned<int8_t>(e.getProperty(nzIndex).getCurrentValue<float>());
-					}
-					*((reinterpret_cast<GLbyte *>(vCursor+normalsOffset))+0)=nx;
-					*((reinterpret_cast<GLbyte *>(vCursor+normalsOffset))+1)=ny;
-					*((reinterpret_cast<GLbyte *>(vCursor+normalsOffset))+2)=nz;
-				}
-				if(useVertexColor) {
-					Util::Color4ub color;
-					if(e.getProperty(redIndex).dataType == PLY_Element::TYPE_FLOAT) {
-						Util::Color4f floatColor;
-						floatColor.setR(e.getProperty(redIndex).getCurrentValue<float>());
-						floatColor.setG(e.getProperty(greenIndex).getCurrentValue<float>());
-						floatColor.setB(e.getProperty(blueIndex).getCurrentValue<float>());
-						if(alphaIndex > 0) {
-							floatColor.setA(e.getProperty(alphaIndex).getCurrentValue<float>());
-						} else {
-							floatColor.setA(1.0f);
-						}
-						color = Util::Color4ub(floatColor);
-					} else { // most likely = TYPE_UCHAR
-						color.setR(e.getProperty(redIndex).getCurrentValue<GLubyte>());
-						color.setG(e.getProperty(greenIndex).getCurrentValue<GLubyte>());
-						color.setB(e.getProperty(blueIndex).getCurrentValue<GLubyte>());
-						if(alphaIndex > 0) {
-							color.setA(e.getProperty(alphaIndex).getCurrentValue<GLubyte>());
-						} else {
-							color.setA(255);
-						}
-					}
-					*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 0) = color.getR();
-					*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 1) = color.getG();
-					*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 2) = color.getB();
-					*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 3) = color.getA();
-				}
-				if(useTex0){
-					*((reinterpret_cast<float *>(vCursor+tex0Offset))+0)=e.getProperty(sIndex).getCurrentValue<float>();
-					*((reinterpret_cast<float *>(vCursor+tex0Offset))+1)=e.getProperty(tIndex).getCurrentValue<float>();
-				}
-				if(cursor > static_cast<int>(buffer.size())) {
-					std::cerr <<"!!! Buffer overrun!";
-					return nullptr;
-				}
-
-				vCursor+=vertexSize;
-			}
-			vertices.updateBoundingBox();
 		} else if(e.name=="face") {
 
 			// calculate number of indices
@@ -12,9 +12,17 @@
 #define RENDERING_STREAMERPLY_H_
 
 #include "AbstractRenderingStreamer.h"
+#include <cstdint>
 
 namespace Rendering {
 
+/**
+ * Loader and saver for .ply files.
+ *
+ * Binary vertex rows whose properties match a vertex description (e.g. files written by saveMesh) are copied
+ * into the vertex data as a whole; other vertex rows are converted on multiple threads (see setNumThreads()).
+ * Parallel ascii parsing assumes that each vertex is stored in a separate line.
+ */
 class StreamerPLY : public AbstractRenderingStreamer {
 	public:
 		StreamerPLY() :
@@ -29,6 +37,11 @@ class StreamerPLY : public AbstractRenderingStreamer {
 
 		static uint8_t queryCapabilities(const std::string & extension);
 		static const char * const fileExtension;
+
+		/*! Set the maximum number of threads used for reading vertex data. A value of 0 uses the number of
+			hardware threads; 1 disables parallel loading.	*/
+		static void setNumThreads(uint32_t numThreads);
+		static uint32_t getNumThreads();
 };
 
 }
@@ -0,0 +1,376 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "StreamerQMF.h"
+#include "Serialization.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/VertexAttributeAccessors.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexDescription.h"
+#include <Geometry/Box.h>
+#include <Geometry/Vec2.h>
+#include <Geometry/Vec3.h>
+#include <Util/GenericAttribute.h>
+#include <Util/Graphics/Color.h>
+#include <Util/Macros.h>
+#include <Util/StringUtils.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/// \todo Show compile error when using a machine without LITTLE-ENDIANness
+
+namespace Rendering {
+
+const char * const StreamerQMF::fileExtension = "qmf";
+
+template<typename T>
+static void write(std::ostream & out, const T & value) {
+	out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<typename T>
+static void writeArray(std::ostream & out, const std::vector<T> & values) {
+	out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+template<typename T>
+static T read(std::istream & in) {
+	T value = T();
+	in.read(reinterpret_cast<char *>(&value), sizeof(T));
+	return value;
+}
+
+template<typename T>
+static void readArray(std::istream & in, std::vector<T> & values, size_t count) {
+	values.resize(count);
+	in.read(reinterpret_cast<char *>(values.data()), count * sizeof(T));
+}
+
+static uint16_t quantize(float value, float min, float extent) {
+	if(extent <= 0.0f)
+		return 0;
+	const float normalized = std::min(1.0f, std::max(0.0f, (value - min) / extent));
+	return static_cast<uint16_t>(std::lround(normalized * 65535.0f));
+}
+
+static float dequantize(uint16_t value, float min, float extent) {
+	return min + extent * (static_cast<float>(value) / 65535.0f);
+}
+
+static float signNotZero(float v) {
+	return v < 0.0f ? -1.0f : 1.0f;
+}
+
+//! Octahedron encoding of a unit vector into two signed bytes.
+static void encodeNormal(const Geometry::Vec3 & n, int8_t * out) {
+	const float l1 = std::abs(n.getX()) + std::abs(n.getY()) + std::abs(n.getZ());
+	float x = 0.0f, y = 0.0f;
+	if(l1 > 0.0f) {
+		x = n.getX() / l1;
+		y = n.getY() / l1;
+		if(n.getZ() < 0.0f) {
+			const float ox = x;
+			x = (1.0f - std::abs(y)) * signNotZero(ox);
+			y = (1.0f - std::abs(ox)) * signNotZero(y);
+		}
+	}
+	out[0] = static_cast<int8_t>(std::lround(std::min(1.0f, std::max(-1.0f, x)) * 127.0f));
+	out[1] = static_cast<int8_t>(std::lround(std::min(1.0f, std::max(-1.0f, y)) * 127.0f));
+}
+
+static Geometry::Vec3 decodeNormal(const int8_t * in) {
+	float x = std::max(-1.0f, in[0] / 127.0f);
+	float y = std::max(-1.0f, in[1] / 127.0f);
+	const float z = 1.0f - std::abs(x) - std::abs(y);
+	if(z < 0.0f) {
+		const float ox = x;
+		x = (1.0f - std::abs(y)) * signNotZero(ox);
+		y = (1.0f - std::abs(ox)) * signNotZero(y);
+	}
+	Geometry::Vec3 n(x, y, z);
+	const float length = n.length();
+	return length > 0.0f ? n / length : Geometry::Vec3(0.0f, 0.0f, 1.0f);
+}
+
+static void encodeVarint(uint64_t value, std::vector<uint8_t> & out) {
+	while(value >= 0x80) {
+		out.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+//! @return false if the data ends within the number.
+static bool decodeVarint(const uint8_t *& cursor, const uint8_t * end, uint64_t & value) {
+	value = 0;
+	for(uint32_t shift = 0; cursor != end && shift < 64; shift += 7) {
+		const uint8_t byte = *cursor++;
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+//! (static)
+Mesh * StreamerQMF::loadMesh(std::istream & input) {
+	if(read<uint32_t>(input) != QMF_HEADER) {
+		WARN("StreamerQMF::loadMesh: Wrong mesh format.");
+		return nullptr;
+	}
+	const uint32_t version = read<uint32_t>(input);
+	if(version > QMF_VERSION) {
+		WARN(std::string("StreamerQMF::loadMesh: Can't read mesh, version to high: ") + Util::StringUtils::toString(version));
+		return nullptr;
+	}
+	const uint32_t vertexCount = read<uint32_t>(input);
+	const uint32_t indexCount = read<uint32_t>(input);
+	const uint32_t drawMode = read<uint32_t>(input);
+	const uint32_t flags = read<uint32_t>(input);
+	float boxMin[3], boxMax[3];
+	for(auto & v : boxMin)
+		v = read<float>(input);
+	for(auto & v : boxMax)
+		v = read<float>(input);
+	float texMin[2] = {0.0f, 0.0f}, texMax[2] = {0.0f, 0.0f};
+	if(flags & QMF_HAS_TEXCOORDS) {
+		for(auto & v : texMin)
+			v = read<float>(input);
+		for(auto & v : texMax)
+			v = read<float>(input);
+	}
+	if(!input.good()) {
+		WARN("StreamerQMF::loadMesh: Invalid header.");
+		return nullptr;
+	}
+
+	VertexDescription vd;
+	vd.appendPosition3D();
+	if(flags & QMF_HAS_NORMALS)
+		vd.appendNormalByte();
+	if(flags & QMF_HAS_COLORS)
+		vd.appendColorRGBAByte();
+	if(flags & QMF_HAS_TEXCOORDS)
+		vd.appendTexCoord();
+
+	Util::Reference<Mesh> mesh = new Mesh;
+	mesh->setGLDrawMode(drawMode);
+	MeshVertexData & vertices = mesh->openVertexData();
+	vertices.allocate(vertexCount, vd);
+
+	{	// positions
+		std::vector<uint16_t> data;
+		readArray(input, data, static_cast<size_t>(vertexCount) * 3);
+		auto acc = PositionAttributeAccessor::create(vertices);
+		const float extent[3] = {boxMax[0] - boxMin[0], boxMax[1] - boxMin[1], boxMax[2] - boxMin[2]};
+		for(uint32_t i = 0; i < vertexCount; ++i) {
+			const uint16_t * q = &data[i * 3];
+			acc->setPosition(i, Geometry::Vec3(	dequantize(q[0], boxMin[0], extent[0]),
+												dequantize(q[1], boxMin[1], extent[1]),
+												dequantize(q[2], boxMin[2], extent[2])));
+		}
+	}
+	if(flags & QMF_HAS_NORMALS) {
+		std::vector<int8_t> data;
+		readArray(input, data, static_cast<size_t>(vertexCount) * 2);
+		auto acc = NormalAttributeAccessor::create(vertices);
+		for(uint32_t i = 0; i < vertexCount; ++i)
+			acc->setNormal(i, decodeNormal(&data[i * 2]));
+	}
+	if(flags & QMF_HAS_COLORS) {
+		std::vector<uint8_t> data;
+		readArray(input, data, static_cast<size_t>(vertexCount) * 4);
+		auto acc = ColorAttributeAccessor::create(vertices);
+		for(uint32_t i = 0; i < vertexCount; ++i)
+			acc->setColor(i, Util::Color4ub(data[i * 4], data[i * 4 + 1], data[i * 4 + 2], data[i * 4 + 3]));
+	}
+	if(flags & QMF_HAS_TEXCOORDS) {
+		std::vector<uint16_t> data;
+		readArray(input, data, static_cast<size_t>(vertexCount) * 2);
+		auto acc = TexCoordAttributeAccessor::create(vertices);
+		const float extent[2] = {texMax[0] - texMin[0], texMax[1] - texMin[1]};
+		for(uint32_t i = 0; i < vertexCount; ++i) {
+			acc->setCoordinate(i, Geometry::Vec2(	dequantize(data[i * 2], texMin[0], extent[0]),
+													dequantize(data[i * 2 + 1], texMin[1], extent[1])));
+		}
+	}
+	vertices.updateBoundingBox();
+
+	const uint32_t indexDataSize = read<uint32_t>(input);
+	if(indexCount == 0) {
+		mesh->setUseIndexData(false);
+	} else {
+		mesh->setUseIndexData(true);
+		std::vector<uint8_t> data;
+		readArray(input, data, indexDataSize);
+		MeshIndexData & indices = mesh->openIndexData();
+		indices.allocate(indexCount);
+		const uint8_t * cursor = data.data();
+		const uint8_t * const end = data.data() + data.size();
+		int64_t previous = 0;
+		for(uint32_t i = 0; i < indexCount; ++i) {
+			uint64_t zigzag;
+			if(!decodeVarint(cursor, end, zigzag)) {
+				WARN("StreamerQMF::loadMesh: Index data is truncated.");
+				return nullptr;
+			}
+			const int64_t delta = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+			previous += delta;
+			indices[i] = static_cast<uint32_t>(previous);
+		}
+		indices.updateIndexRange();
+	}
+	if(input.fail()) {
+		WARN("StreamerQMF::loadMesh: Unexpected end of data.");
+		return nullptr;
+	}
+	return mesh.detachAndDecrease();
+}
+
+//! ---|> GenericLoader
+Util::GenericAttributeList * StreamerQMF::loadGeneric(std::istream & input) {
+	Mesh * m = loadMesh(input);
+	if(m == nullptr) {
+		return nullptr;
+	}
+	auto l = new Util::GenericAttributeList;
+	l->push_back(Serialization::createMeshDescription(m));
+	return l;
+}
+
+//! (static)
+bool StreamerQMF::saveMesh(Mesh * mesh, std::ostream & output) {
+	MeshVertexData & vertices = mesh->openVertexData();
+	const VertexDescription & vd = vertices.getVertexDescription();
+	const uint32_t vertexCount = vertices.getVertexCount();
+	if(!vd.hasAttribute(VertexAttributeIds::POSITION)) {
+		WARN("StreamerQMF::saveMesh: The mesh has no positions.");
+		return false;
+	}
+	uint32_t flags = 0;
+	for(const auto & attr : vd.getAttributes()) {
+		if(attr.empty())
+			continue;
+		if(attr.getNameId() == VertexAttributeIds::NORMAL) {
+			flags |= QMF_HAS_NORMALS;
+		} else if(attr.getNameId() == VertexAttributeIds::COLOR) {
+			flags |= QMF_HAS_COLORS;
+		} else if(attr.getNameId() == VertexAttributeIds::TEXCOORD0) {
+			flags |= QMF_HAS_TEXCOORDS;
+		} else if(attr.getNameId() != VertexAttributeIds::POSITION) {
+			WARN("StreamerQMF::saveMesh: Vertex attribute '" + attr.getName() + "' is not stored.");
+		}
+	}
+
+	const Geometry::Box & bb = vertices.getBoundingBox();
+	const float boxMin[3] = {bb.getMinX(), bb.getMinY(), bb.getMinZ()};
+	const float boxMax[3] = {bb.getMaxX(), bb.getMaxY(), bb.getMaxZ()};
+	float texMin[2] = {0.0f, 0.0f}, texMax[2] = {0.0f, 0.0f};
+	Util::Reference<TexCoordAttributeAccessor> texAcc;
+	if(flags & QMF_HAS_TEXCOORDS) {
+		texAcc = TexCoordAttributeAccessor::create(vertices);
+		for(uint32_t i = 0; i < vertexCount; ++i) {
+			const Geometry::Vec2 t = texAcc->getCoordinate(i);
+			texMin[0] = (i == 0) ? t.getX() : std::min(texMin[0], t.getX());
+			texMin[1] = (i == 0) ? t.getY() : std::min(texMin[1], t.getY());
+			texMax[0] = (i == 0) ? t.getX() : std::max(texMax[0], t.getX());
+			texMax[1] = (i == 0) ? t.getY() : std::max(texMax[1], t.getY());
+		}
+	}
+
+	/// Header
+	write(output, QMF_HEADER);
+	write(output, QMF_VERSION);
+	write(output, vertexCount);
+	write(output, mesh->isUsingIndexData() ? mesh->getIndexCount() : 0u);
+	write(output, mesh->getGLDrawMode());
+	write(output, flags);
+	for(const auto & v : boxMin)
+		write(output, v);
+	for(const auto & v : boxMax)
+		write(output, v);
+	if(flags & QMF_HAS_TEXCOORDS) {
+		for(const auto & v : texMin)
+			write(output, v);
+		for(const auto & v : texMax)
+			write(output, v);
+	}
+
+	/// VertexData
+	{
+		std::vector<uint16_t> data;
+		data.reserve(static_cast<size_t>(vertexCount) * 3);
+		auto acc = PositionAttributeAccessor::create(vertices);
+		for(uint32_t i = 0; i < vertexCount; ++i) {
+			const Geometry::Vec3 p = acc->getPosition(i);
+			const float values[3] = {p.getX(), p.getY(), p.getZ()};
+			for(uint_fast8_t dim = 0; dim < 3; ++dim)
+				data.push_back(quantize(values[dim], boxMin[dim], boxMax[dim] - boxMin[dim]));
+		}
+		writeArray(output, data);
+	}
+	if(flags & QMF_HAS_NORMALS) {
+		std::vector<int8_t> data(static_cast<size_t>(vertexCount) * 2);
+		auto acc = NormalAttributeAccessor::create(vertices);
+		for(uint32_t i = 0; i < vertexCount; ++i)
+			encodeNormal(acc->getNormal(i), &data[i * 2]);
+		writeArray(output, data);
+	}
+	if(flags & QMF_HAS_COLORS) {
+		std::vector<uint8_t> data;
+		data.reserve(static_cast<size_t>(vertexCount) * 4);
+		auto acc = ColorAttributeAccessor::create(vertices);
+		for(uint32_t i = 0; i < vertexCount; ++i) {
+			const Util::Color4ub c = acc->getColor4ub(i);
+			data.push_back(c.getR());
+			data.push_back(c.getG());
+			data.push_back(c.getB());
+			data.push_back(c.getA());
+		}
+		writeArray(output, data);
+	}
+	if(flags & QMF_HAS_TEXCOORDS) {
+		std::vector<uint16_t> data;
+		data.reserve(static_cast<size_t>(vertexCount) * 2);
+		for(uint32_t i = 0; i < vertexCount; ++i) {
+			const Geometry::Vec2 t = texAcc->getCoordinate(i);
+			data.push_back(quantize(t.getX(), texMin[0], texMax[0] - texMin[0]));
+			data.push_back(quantize(t.getY(), texMin[1], texMax[1] - texMin[1]));
+		}
+		writeArray(output, data);
+	}
+
+	/// IndexData
+	std::vector<uint8_t> indexData;
+	if(mesh->isUsingIndexData()) {
+		MeshIndexData & indices = mesh->openIndexData();
+		int64_t previous = 0;
+		for(uint32_t i = 0; i < indices.getIndexCount(); ++i) {
+			const int64_t delta = static_cast<int64_t>(indices[i]) - previous;
+			previous = indices[i];
+			encodeVarint((static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63), indexData);
+		}
+	}
+	write(output, static_cast<uint32_t>(indexData.size()));
+	writeArray(output, indexData);
+	return output.good();
+}
+
+uint8_t StreamerQMF::queryCapabilities(const std::string & extension) {
+	if(extension == fileExtension) {
+		return CAP_LOAD_MESH | CAP_LOAD_GENERIC | CAP_SAVE_MESH;
+	} else {
+		return 0;
+	}
+}
+
+}
@@ -0,0 +1,75 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_STREAMERQMF_H_
+#define RENDERING_STREAMERQMF_H_
+
+#include "AbstractRenderingStreamer.h"
+#include <cstdint>
+
+namespace Rendering {
+
+/**
+
+	.qmf (Quantized Mesh Format)
+	============================
+
+	Compact storage of meshes with positions, normals, colors and texture coordinates.
+	Other vertex attributes are not stored.
+
+	Fileformat: binary little endian
+
+	QMF-File ::=    Header (char[4] "qmf"+chr(13) ),
+					uint32 version (currently 0x01),
+					uint32 vertexCount,
+					uint32 indexCount (0 if the mesh does not use indices),
+					uint32 (=GLuint) drawMode (GL_TRIANGLES, GL_POINTS, ...),
+					uint32 flags -- 0x01: normals, 0x02: colors, 0x04: texture coordinates,
+					float boxMin[3], float boxMax[3] -- bounding box of the positions,
+					float texMin[2], float texMax[2] -- range of the texture coordinates (only if flag 0x04 is set),
+					uint16 positions[vertexCount][3] -- quantized relative to the bounding box,
+					int8 normals[vertexCount][2] -- octahedron encoded (only if flag 0x01 is set),
+					uint8 colors[vertexCount][4] -- RGBA (only if flag 0x02 is set),
+					uint16 texCoords[vertexCount][2] -- quantized relative to their range (only if flag 0x04 is set),
+					uint32 indexDataSize -- number of bytes of the following encoded indices,
+					Varint indices[indexCount] -- zigzag encoded differences to the previous index (the first one to 0)
+
+	Varint ::=      uint8* -- 7 bits per byte, least significant first; the highest bit is set if another byte follows.
+
+	When loading, normals are decoded into normalized GL_BYTE attributes and colors into normalized GL_UNSIGNED_BYTE
+	attributes. Positions and texture coordinates are decoded into floats, as the mesh cannot carry the dequantization
+	transformation.
+*/
+class StreamerQMF : public AbstractRenderingStreamer {
+	public:
+		const static uint32_t QMF_VERSION = 0x01;
+		const static uint32_t QMF_HEADER = 0x0d666d71; // = "qmf "
+
+		const static uint32_t QMF_HAS_NORMALS = 0x01;
+		const static uint32_t QMF_HAS_COLORS = 0x02;
+		const static uint32_t QMF_HAS_TEXCOORDS = 0x04;
+
+		StreamerQMF() :
+			AbstractRenderingStreamer() {
+		}
+		virtual ~StreamerQMF() {
+		}
+
+		Util::GenericAttributeList * loadGeneric(std::istream & input) override;
+		Mesh * loadMesh(std::istream & input) override;
+		bool saveMesh(Mesh * mesh, std::ostream & output) override;
+
+		static uint8_t queryCapabilities(const std::string & extension);
+		static const char * const fileExtension;
+};
+
+}
+
+#endif /* RENDERING_STREAMERQMF_H_ */
@@ -11,11 +11,15 @@
 #include "../Mesh/Mesh.h"
 #include "../Mesh/VertexDescription.h"
 #include "../MeshUtils/MeshBuilder.h"
+#include "internal/TextParsing.h"
 #include <Geometry/Vec3.h>
 #include <Geometry/PointOctree.h>
 #include <Util/GenericAttribute.h>
 #include <Util/IO/FileUtils.h>
 #include <Util/Macros.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <cstring>
 #include <istream>
 #include <random>
 #include <limits>
@@ -69,12 +73,106 @@ Mesh * StreamerXYZ::loadMesh(std::istream & input, std::size_t numPoints) {
 
 Util::GenericAttributeList * StreamerXYZ::loadGeneric(std::istream & input) {
 	auto list = new Util::GenericAttributeList;
+	loadPointChunks(input, 1000000, [list](Mesh * chunk) {
+		list->push_back(Serialization::createMeshDescription(chunk->clone()));
+		return true;
+	});
+	return list;
+}
+
+//! (static)
+uint64_t StreamerXYZ::loadPointChunks(std::istream & input, uint32_t pointsPerChunk, const ChunkCallback_t & callback, uint32_t stride) {
+	using namespace TextParsing;
+	if(pointsPerChunk == 0)
+		pointsPerChunk = 1;
+	if(stride == 0)
+		stride = 1;
+
+	VertexDescription vertexDesc;
+	vertexDesc.appendPosition3D();
+	vertexDesc.appendColorRGBAByte();
+	const size_t vertexSize = vertexDesc.getVertexSize();
+
+	Util::Reference<Mesh> chunk = new Mesh(vertexDesc, pointsPerChunk, 0);
+	chunk->setDrawMode(Mesh::DRAW_POINTS);
+	chunk->setUseIndexData(false);
+	uint32_t chunkSize = 0;
+	uint64_t numPointsPassed = 0;
+	uint64_t lineNumber = 0;
+
+	auto passChunk = [&]() -> bool {
+		if(chunkSize == 0)
+			return true;
+		if(chunkSize < pointsPerChunk) { // last chunk
+			Util::Reference<Mesh> lastChunk = new Mesh(vertexDesc, chunkSize, 0);
+			lastChunk->setDrawMode(Mesh::DRAW_POINTS);
+			lastChunk->setUseIndexData(false);
+			std::memcpy(lastChunk->openVertexData().data(), chunk->openVertexData().data(), chunkSize * vertexSize);
+			chunk = lastChunk;
+		}
+		MeshVertexData & vd = chunk->openVertexData();
+		vd.markAsChanged();
+		vd.updateBoundingBox();
+		numPointsPassed += chunkSize;
+		chunkSize = 0;
+		return callback(chunk.get());
+	};
+
+	// Parse all complete lines in [cursor, end); returns false if reading should stop.
+	auto parseLines = [&](const char * cursor, const char * end) -> bool {
+		while(cursor != end) {
+			skipBlanks(cursor, end);
+			if(isLineEnd(cursor, end) || *cursor == '#') {
+				skipLine(cursor, end);
+				continue;
+			}
+			if((lineNumber++ % stride) != 0) {
+				skipLine(cursor, end);
+				continue;
+			}
+			float pos[3];
+			for(uint_fast8_t i = 0; i < 3; ++i)
+				pos[i] = parseFloat(cursor, end);
+			uint8_t color[4] = {255, 255, 255, 255};
+			for(uint_fast8_t i = 0; i < 3; ++i) {
+				skipBlanks(cursor, end);
+				int32_t value;
+				if(!parseInt(cursor, end, value))
+					break;
+				color[i] = static_cast<uint8_t>(value);
+			}
+			skipLine(cursor, end);
+
+			uint8_t * vertex = chunk->openVertexData().data() + chunkSize * vertexSize;
+			std::memcpy(vertex, pos, sizeof(pos));
+			std::memcpy(vertex + sizeof(pos), color, sizeof(color));
+			if(++chunkSize == pointsPerChunk && !passChunk())
+				return false;
+		}
+		return true;
+	};
+
+	static const size_t blockSize = 4 * 1024 * 1024;
+	std::vector<char> buffer(blockSize);
+	size_t used = 0; // bytes of an incomplete line at the beginning of the buffer
 	while(input.good()) {
-		Mesh * mesh = loadMesh(input, 1000000);
-		Util::GenericAttributeMap * desc = Serialization::createMeshDescription(mesh);
-		list->push_back(desc);
+		if(used == buffer.size()) // very long line
+			buffer.resize(buffer.size() * 2);
+		input.read(buffer.data() + used, buffer.size() - used);
+		const size_t size = used + static_cast<size_t>(input.gcount());
+		const char * const begin = buffer.data();
+		const char * lineEnd = begin + size;
+		if(input.good()) { // keep the incomplete last line for the next block
+			while(lineEnd != begin && *(lineEnd - 1) != '\n')
+				--lineEnd;
+		}
+		if(!parseLines(begin, lineEnd))
+			return numPointsPassed;
+		used = static_cast<size_t>((begin + size) - lineEnd);
+		std::memmove(buffer.data(), lineEnd, used);
 	}
-	return list;
+	passChunk();
+	return numPointsPassed;
 }
 
 uint8_t StreamerXYZ::queryCapabilities(const std::string & extension) {
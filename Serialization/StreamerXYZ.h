@@ -10,6 +10,8 @@
 #define RENDERING_STREAMERXYZ_H_
 
 #include "AbstractRenderingStreamer.h"
+#include <cstdint>
+#include <functional>
 #include <vector>
 namespace Util{
 class FileName;
@@ -30,6 +32,18 @@ class StreamerXYZ : public AbstractRenderingStreamer {
 		}
 		Mesh * loadMesh(std::istream & input, std::size_t numPoints);
 		Util::GenericAttributeList * loadGeneric(std::istream & input) override;
+
+		//! Called for every chunk of points; return false to stop reading.
+		typedef std::function<bool (Mesh * chunk)> ChunkCallback_t;
+
+		/*! Read the points of @p input (lines "x y z [r g b]") in fixed-size chunks and pass each chunk
+			as point mesh to @p callback. Only a bounded amount of memory is used, independent of the size of the input.
+			@param pointsPerChunk Maximum number of points of a chunk.
+			@param stride Only every @p stride-th point is used (e.g. for previews); the other lines are skipped without parsing.
+			@return Number of points passed to the callback.
+			\note The same mesh is reused for the following chunks (except for the last one, which may be smaller).
+				Use Mesh::clone() if the data has to be kept.	*/
+		static uint64_t loadPointChunks(std::istream & input, uint32_t pointsPerChunk, const ChunkCallback_t & callback, uint32_t stride = 1);
 		
 		
 		/*! Distributes the points in the given xyz-input file into @p numberOfClusters many .xyz-files
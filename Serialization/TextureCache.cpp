@@ -0,0 +1,191 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "TextureCache.h"
+#include "Serialization.h"
+#include "../ContentHash.h"
+#include "../Texture/Texture.h"
+#include <Util/IO/FileName.h>
+#include <Util/IO/FileUtils.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+namespace Rendering {
+namespace Serialization {
+
+static Util::Reference<TextureCache> activeTextureCache;
+
+void setTextureCache(TextureCache * cache) {
+	activeTextureCache = cache;
+}
+
+TextureCache * getTextureCache() {
+	return activeTextureCache.get();
+}
+
+TextureCache::TextureCache() :
+		ReferenceCounter_t(), contentHashing(false), hitCount(0), missCount(0), savedMemory(0) {
+}
+
+TextureCache::~TextureCache() = default;
+
+//! (static)
+std::string TextureCache::getCanonicalPath(const std::string & path) {
+	std::string protocol;
+	std::string location = path;
+	const std::size_t protocolEnd = path.find("://");
+	if(protocolEnd != std::string::npos) {
+		protocol = path.substr(0, protocolEnd + 3);
+		location = path.substr(protocolEnd + 3);
+		if(protocol == "file://") // default protocol
+			protocol.clear();
+	}
+	std::replace(location.begin(), location.end(), '\\', '/');
+	const bool absolute = !location.empty() && location.front() == '/';
+
+	std::vector<std::string> segments;
+	std::size_t begin = 0;
+	while(begin <= location.size()) {
+		std::size_t end = location.find('/', begin);
+		if(end == std::string::npos)
+			end = location.size();
+		const std::string segment = location.substr(begin, end - begin);
+		if(segment.empty() || segment == ".") {
+			// skip
+		} else if(segment == ".." && !segments.empty() && segments.back() != "..") {
+			segments.pop_back();
+		} else if(segment != ".." || !absolute) {
+			segments.push_back(segment);
+		}
+		begin = end + 1;
+	}
+
+	std::string result = protocol;
+	if(absolute)
+		result += '/';
+	for(std::size_t i = 0; i < segments.size(); ++i) {
+		if(i > 0)
+			result += '/';
+		result += segments[i];
+	}
+	return result;
+}
+
+Util::Reference<Texture> TextureCache::get(const Util::FileName & url, TextureType tType, uint32_t numLayers) {
+	const std::string typeKey = '|' + std::to_string(static_cast<int>(tType)) + '|' + std::to_string(numLayers);
+	const std::string pathKey = getCanonicalPath(url.toString()) + typeKey;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		const auto pathIt = textureByPath.find(pathKey);
+		if(pathIt != textureByPath.end()) {
+			++hitCount;
+			savedMemory += pathIt->second.texture->getDataSize();
+			return pathIt->second.texture;
+		}
+	}
+
+	// The mutex is not held while the file is read and decoded, so that several threads can load textures in parallel.
+	// The file is always read completely, so that its contents can be hashed and parsed from memory.
+	const std::vector<uint8_t> bytes = Util::FileUtils::loadFile(url);
+	if(bytes.empty()) {
+		WARN("TextureCache: Error reading file. Path: " + url.toString());
+		return nullptr;
+	}
+	Entry entry;
+	entry.contentKey = 0;
+	if(contentHashing) {
+		const uint64_t typeHash = calcContentHash(reinterpret_cast<const uint8_t *>(typeKey.data()), typeKey.size());
+		entry.contentKey = std::max<uint64_t>(1, calcContentHash(bytes.data(), bytes.size(), typeHash));
+		std::lock_guard<std::mutex> lock(mutex);
+		const auto contentIt = textureByContent.find(entry.contentKey);
+		if(contentIt != textureByContent.end()) {
+			entry.texture = contentIt->second;
+			textureByPath.emplace(pathKey, entry);
+			++hitCount;
+			savedMemory += entry.texture->getDataSize();
+			return entry.texture;
+		}
+	}
+
+	Util::Reference<Texture> texture = loadTexture(url.getEnding(), std::string(bytes.begin(), bytes.end()), tType, numLayers);
+	if(texture.isNull())
+		return nullptr;
+	texture->setFileName(url);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	++missCount;
+	// Another thread may have loaded the same file in the meantime; its texture is kept.
+	const auto pathIt = textureByPath.find(pathKey);
+	if(pathIt != textureByPath.end())
+		return pathIt->second.texture;
+	if(entry.contentKey != 0) {
+		const auto contentIt = textureByContent.find(entry.contentKey);
+		if(contentIt != textureByContent.end()) {
+			entry.texture = contentIt->second;
+			textureByPath.emplace(pathKey, entry);
+			return entry.texture;
+		}
+	}
+	entry.texture = texture;
+	textureByPath.emplace(pathKey, entry);
+	if(entry.contentKey != 0)
+		textureByContent.emplace(entry.contentKey, entry.texture);
+	return entry.texture;
+}
+
+uint32_t TextureCache::releaseUnused() {
+	std::lock_guard<std::mutex> lock(mutex);
+	// number of references held by the cache per texture
+	std::unordered_map<Texture *, int> cacheReferences;
+	for(const auto & pathEntry : textureByPath)
+		++cacheReferences[pathEntry.second.texture.get()];
+	for(const auto & contentEntry : textureByContent)
+		++cacheReferences[contentEntry.second.get()];
+
+	std::unordered_set<Texture *> unused;
+	for(const auto & textureEntry : cacheReferences) {
+		if(textureEntry.first->countReferences() == textureEntry.second)
+			unused.insert(textureEntry.first);
+	}
+	for(auto it = textureByPath.begin(); it != textureByPath.end();) {
+		if(unused.count(it->second.texture.get()) > 0)
+			it = textureByPath.erase(it);
+		else
+			++it;
+	}
+	for(auto it = textureByContent.begin(); it != textureByContent.end();) {
+		if(unused.count(it->second.get()) > 0)
+			it = textureByContent.erase(it);
+		else
+			++it;
+	}
+	return static_cast<uint32_t>(unused.size());
+}
+
+void TextureCache::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	textureByPath.clear();
+	textureByContent.clear();
+}
+
+std::size_t TextureCache::getTextureCount()const {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<const Texture *> textures;
+	for(const auto & pathEntry : textureByPath)
+		textures.push_back(pathEntry.second.texture.get());
+	std::sort(textures.begin(), textures.end());
+	return static_cast<std::size_t>(std::unique(textures.begin(), textures.end()) - textures.begin());
+}
+
+}
+}
@@ -0,0 +1,101 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_TEXTURECACHE_H_
+#define RENDERING_TEXTURECACHE_H_
+
+#include "../Texture/TextureType.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Util {
+class FileName;
+}
+namespace Rendering {
+class Texture;
+namespace Serialization {
+
+/**
+ * Cache of loaded textures, so that materials referencing the same image file share one Texture.
+ * Textures are identified by the canonical path of the file (separators, "." and ".." segments are normalized)
+ * together with the texture type and the number of layers. If content hashing is enabled, the bytes of a file are
+ * hashed when it is loaded, so that byte-identical files with different paths share one texture as well.
+ *
+ * If set via setTextureCache(), Serialization::loadTexture(const Util::FileName &, TextureType, uint32_t) uses the cache.
+ * \code
+ * Util::Reference<Serialization::TextureCache> cache = new Serialization::TextureCache;
+ * cache->setContentHashing(true);
+ * Serialization::setTextureCache(cache.get());
+ * // ... import scenes
+ * cache->releaseUnused();
+ * \endcode
+ * @note The textures are shared: changing a texture obtained from the cache changes it for all users.
+ * @note The cache may be used from several threads.
+ */
+class TextureCache : public Util::ReferenceCounter<TextureCache> {
+	public:
+		TextureCache();
+		~TextureCache();
+
+		/*! Return the cached texture for the given file, or load it and add it to the cache.
+			@return The texture, or @c nullptr if the file could not be loaded (failures are not cached).	*/
+		Util::Reference<Texture> get(const Util::FileName & url, TextureType tType = TextureType::TEXTURE_2D, uint32_t numLayers = 1);
+
+		//! If enabled, files with different paths and identical contents share one texture (disabled by default).
+		void setContentHashing(bool enabled)			{	contentHashing = enabled;	}
+		bool isContentHashing()const					{	return contentHashing;	}
+
+		/*! Remove the textures that are referenced by the cache only.
+			@return The number of removed textures	*/
+		uint32_t releaseUnused();
+		void clear();
+
+		std::size_t getTextureCount()const;
+		//! Number of calls of get() that returned a cached texture.
+		uint32_t getHitCount()const						{	return hitCount;	}
+		//! Number of calls of get() that loaded a texture.
+		uint32_t getMissCount()const					{	return missCount;	}
+		/*! Amount of (graphics) memory in bytes that has not been allocated because a cached texture was handed out
+			instead of loading a new one (sum of the data sizes of all cache hits).	*/
+		std::size_t getSavedMemory()const				{	return savedMemory;	}
+
+		//! (static) Normalized form of the given path that is used as key.
+		static std::string getCanonicalPath(const std::string & path);
+
+	private:
+		struct Entry {
+			Util::Reference<Texture> texture;
+			uint64_t contentKey;	//!< key in textureByContent (0: none)
+		};
+		mutable std::mutex mutex;
+		//! path key -> texture
+		std::unordered_map<std::string, Entry> textureByPath;
+		//! content hash (combined with size, type and layers) -> texture
+		std::unordered_map<uint64_t, Util::Reference<Texture>> textureByContent;
+		bool contentHashing;
+		uint32_t hitCount;
+		uint32_t missCount;
+		std::size_t savedMemory;
+};
+
+/*! Set the cache used by loadTexture(const Util::FileName &, TextureType, uint32_t).
+	@c nullptr (the default) disables caching.	*/
+void setTextureCache(TextureCache * cache);
+TextureCache * getTextureCache();
+
+}
+}
+
+#endif /* RENDERING_TEXTURECACHE_H_ */
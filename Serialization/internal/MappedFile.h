@@ -0,0 +1,98 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MAPPEDFILE_H_
+#define RENDERING_MAPPEDFILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RENDERING_MAPPEDFILE_USE_MMAP
+#endif
+
+namespace Rendering {
+//! (internal) Read-only memory mapping of a whole file, used by the streamers that load mapped files.
+class MappedFile {
+	public:
+		//! @p sequential is a hint whether the file is read from front to back (or in random order, e.g. tiles of an image).
+		explicit MappedFile(const std::string & path, bool sequential = true) : data(nullptr), size(0) {
+#if defined(RENDERING_MAPPEDFILE_USE_MMAP)
+			const int fd = open(path.c_str(), O_RDONLY);
+			if(fd == -1)
+				return;
+			struct stat info;
+			if(fstat(fd, &info) == 0 && info.st_size > 0) {
+				void * mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				if(mapping != MAP_FAILED) {
+					data = static_cast<const uint8_t *>(mapping);
+					size = static_cast<size_t>(info.st_size);
+					madvise(mapping, size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+				}
+			}
+			close(fd); // the mapping stays valid
+#elif defined(_WIN32)
+			file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+			mappingHandle = nullptr;
+			if(file == INVALID_HANDLE_VALUE)
+				return;
+			LARGE_INTEGER fileSize;
+			if(GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+				mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if(mappingHandle != nullptr) {
+					data = static_cast<const uint8_t *>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+					if(data != nullptr)
+						size = static_cast<size_t>(fileSize.QuadPart);
+				}
+			}
+#endif
+		}
+		~MappedFile() {
+#if defined(RENDERING_MAPPEDFILE_USE_MMAP)
+			if(data != nullptr)
+				munmap(const_cast<uint8_t *>(data), size);
+#elif defined(_WIN32)
+			if(data != nullptr)
+				UnmapViewOfFile(data);
+			if(mappingHandle != nullptr)
+				CloseHandle(mappingHandle);
+			if(file != INVALID_HANDLE_VALUE)
+				CloseHandle(file);
+#endif
+		}
+		MappedFile(const MappedFile &) = delete;
+		MappedFile & operator=(const MappedFile &) = delete;
+
+		static bool isSupported() {
+#if defined(RENDERING_MAPPEDFILE_USE_MMAP) || defined(_WIN32)
+			return true;
+#else
+			return false;
+#endif
+		}
+		const uint8_t * data;
+		size_t size;
+	private:
+#if defined(_WIN32)
+		HANDLE file;
+		HANDLE mappingHandle;
+#endif
+};
+
+}
+
+#endif /* RENDERING_MAPPEDFILE_H_ */
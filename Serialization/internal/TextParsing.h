@@ -0,0 +1,136 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_TEXTPARSING_H_
+#define RENDERING_TEXTPARSING_H_
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+namespace Rendering {
+/*! (internal) Functions for parsing numbers from a text buffer, used by the streamers of text formats.
+	In contrast to strtof and stream extraction, the buffer does not need to be null-terminated and no locale is used. */
+namespace TextParsing {
+
+inline bool isBlank(char c) {
+	return c == ' ' || c == '\t';
+}
+
+inline bool isLineEnd(const char * cursor, const char * end) {
+	return cursor == end || *cursor == '\n' || *cursor == '\r';
+}
+
+inline void skipBlanks(const char *& cursor, const char * end) {
+	while(cursor != end && isBlank(*cursor))
+		++cursor;
+}
+
+inline void skipLine(const char *& cursor, const char * end) {
+	while(cursor != end && *cursor != '\n')
+		++cursor;
+	if(cursor != end)
+		++cursor;
+}
+
+//! Return the (trimmed) rest of the current line.
+inline std::string readRestOfLine(const char *& cursor, const char * end) {
+	skipBlanks(cursor, end);
+	const char * begin = cursor;
+	while(!isLineEnd(cursor, end))
+		++cursor;
+	const char * last = cursor;
+	while(last != begin && isBlank(*(last - 1)))
+		--last;
+	return std::string(begin, last);
+}
+
+/*! Parse a decimal integer. @p cursor is not moved if there is no number.
+	@return false if no digits were found. */
+inline bool parseInt(const char *& cursor, const char * end, int32_t & value) {
+	const char * c = cursor;
+	bool negative = false;
+	if(c != end && (*c == '-' || *c == '+')) {
+		negative = (*c == '-');
+		++c;
+	}
+	if(c == end || *c < '0' || *c > '9')
+		return false;
+	int64_t result = 0;
+	for(; c != end && *c >= '0' && *c <= '9'; ++c)
+		result = result * 10 + (*c - '0');
+	value = static_cast<int32_t>(negative ? -result : result);
+	cursor = c;
+	return true;
+}
+
+/*! Parse a floating point number ([+-]digits[.digits][(e|E)[+-]digits]).
+	Numbers that cannot be handled here (e.g. "nan", "inf") are passed to strtof. */
+inline float parseFloat(const char *& cursor, const char * end) {
+	static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+										1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+	skipBlanks(cursor, end);
+	const char * c = cursor;
+	bool negative = false;
+	if(c != end && (*c == '-' || *c == '+')) {
+		negative = (*c == '-');
+		++c;
+	}
+	uint64_t mantissa = 0;
+	int32_t exponent = 0;
+	uint32_t numDigits = 0;
+	for(; c != end && *c >= '0' && *c <= '9'; ++c, ++numDigits) {
+		if(mantissa < 1000000000000000000ull)
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*c - '0');
+		else
+			++exponent; // ignore digits beyond the precision
+	}
+	if(c != end && *c == '.') {
+		for(++c; c != end && *c >= '0' && *c <= '9'; ++c, ++numDigits) {
+			if(mantissa < 1000000000000000000ull) {
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*c - '0');
+				--exponent;
+			}
+		}
+	}
+	if(numDigits == 0) {
+		if(c != end && std::isalpha(static_cast<unsigned char>(*c))) { // "nan", "inf"
+			const std::string token(cursor, std::find_if(cursor, end, [](char x) { return isBlank(x) || x == '\n' || x == '\r'; }));
+			char * tokenEnd = nullptr;
+			const float value = std::strtof(token.c_str(), &tokenEnd);
+			cursor += tokenEnd - token.c_str();
+			return value;
+		}
+		return 0.0f;
+	}
+	if(c != end && (*c == 'e' || *c == 'E')) {
+		const char * expCursor = c + 1;
+		int32_t e;
+		if(parseInt(expCursor, end, e)) {
+			exponent += e;
+			c = expCursor;
+		}
+	}
+	cursor = c;
+	double value = static_cast<double>(mantissa);
+	if(exponent < 0)
+		value = (-exponent <= 22) ? value / powersOfTen[-exponent] : value * std::pow(10.0, exponent);
+	else if(exponent > 0)
+		value = (exponent <= 22) ? value * powersOfTen[exponent] : value * std::pow(10.0, exponent);
+	return static_cast<float>(negative ? -value : value);
+}
+
+}
+}
+
+#endif /* RENDERING_TEXTPARSING_H_ */
@@ -0,0 +1,168 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "GlobalUniformBlock.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+#include <Util/Macros.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace Rendering {
+
+const char * const GlobalUniformBlock::BLOCK_NAME = "sg_GlobalUniforms";
+
+//! (internal) Returns the number of components of one column (or vector) of the given type.
+static uint32_t getNumRows(Uniform::dataType_t type) {
+	switch(type) {
+		case Uniform::UNIFORM_BOOL:
+		case Uniform::UNIFORM_FLOAT:
+		case Uniform::UNIFORM_INT:
+			return 1;
+		case Uniform::UNIFORM_VEC2B:
+		case Uniform::UNIFORM_VEC2F:
+		case Uniform::UNIFORM_VEC2I:
+		case Uniform::UNIFORM_MATRIX_2X2F:
+			return 2;
+		case Uniform::UNIFORM_VEC3B:
+		case Uniform::UNIFORM_VEC3F:
+		case Uniform::UNIFORM_VEC3I:
+		case Uniform::UNIFORM_MATRIX_3X3F:
+			return 3;
+		default:
+			return 4;
+	}
+}
+
+//! (internal)
+static uint32_t getNumColumns(Uniform::dataType_t type) {
+	switch(type) {
+		case Uniform::UNIFORM_MATRIX_2X2F:
+			return 2;
+		case Uniform::UNIFORM_MATRIX_3X3F:
+			return 3;
+		case Uniform::UNIFORM_MATRIX_4X4F:
+			return 4;
+		default:
+			return 1;
+	}
+}
+
+//! (internal)
+static const char * getGLSLTypeName(Uniform::dataType_t type) {
+	static const char * const names[] = {
+		"bool", "bvec2", "bvec3", "bvec4",
+		"float", "vec2", "vec3", "vec4",
+		"int", "ivec2", "ivec3", "ivec4",
+		"mat2", "mat3", "mat4"
+	};
+	return names[type];
+}
+
+GlobalUniformBlock::GlobalUniformBlock(uint32_t _binding) :
+		binding(_binding), dirtyBegin(std::numeric_limits<size_t>::max()), dirtyEnd(0) {
+}
+
+void GlobalUniformBlock::addMember(const Uniform & prototype) {
+	if(prototype.isNull() || contains(prototype.getNameId()))
+		throw std::invalid_argument("GlobalUniformBlock::addMember: Invalid or duplicate member '" + prototype.getName() + "'.");
+	if(bufferObject.isValid())
+		throw std::invalid_argument("GlobalUniformBlock::addMember: The block is already in use.");
+
+	Member member;
+	member.name = prototype.getNameId();
+	member.type = prototype.getType();
+	member.numValues = std::max<size_t>(prototype.getNumValues(), 1);
+	member.columns = getNumColumns(member.type);
+	const uint32_t rows = getNumRows(member.type);
+	member.columnSize = rows * 4;
+
+	// std140: arrays and matrix columns are aligned like vec4; single scalars and vectors to their (rounded) size.
+	size_t alignment;
+	size_t size;
+	if(member.numValues > 1 || member.columns > 1) {
+		alignment = 16;
+		member.columnStride = 16;
+		member.valueStride = 16 * member.columns;
+		size = member.numValues * member.valueStride;
+	} else {
+		alignment = rows == 1 ? 4 : (rows == 2 ? 8 : 16);
+		member.columnStride = member.columnSize;
+		member.valueStride = member.columnSize;
+		size = member.columnSize;
+	}
+	member.offset = ((data.size() + alignment - 1) / alignment) * alignment;
+
+	memberIndices[member.name] = members.size();
+	members.push_back(member);
+	// the size of a uniform block is a multiple of vec4
+	data.resize(((member.offset + size + 15) / 16) * 16, 0);
+	setUniform(prototype);
+}
+
+bool GlobalUniformBlock::setUniform(const Uniform & uniform) {
+	const auto it = memberIndices.find(uniform.getNameId());
+	if(it == memberIndices.end())
+		return false;
+	const Member & member = members[it->second];
+	if(uniform.getType() != member.type || uniform.getNumValues() > member.numValues) {
+		WARN("GlobalUniformBlock: Type of uniform '" + uniform.getName() + "' does not match the block.");
+		return false;
+	}
+	const uint8_t * source = uniform.getData();
+	uint8_t * target = data.data() + member.offset;
+	for(size_t value = 0; value < uniform.getNumValues(); ++value) {
+		for(uint32_t column = 0; column < member.columns; ++column) {
+			std::memcpy(target + value * member.valueStride + column * member.columnStride, source, member.columnSize);
+			source += member.columnSize;
+		}
+	}
+	dirtyBegin = std::min(dirtyBegin, member.offset);
+	dirtyEnd = std::max(dirtyEnd, member.offset + uniform.getNumValues() * member.valueStride);
+	return true;
+}
+
+void GlobalUniformBlock::upload() {
+	if(data.empty())
+		return;
+	if(!bufferObject.isValid()) {
+		bufferObject.uploadData(BufferObject::TARGET_UNIFORM_BUFFER, data, BufferObject::USAGE_DYNAMIC_DRAW);
+		bind();
+	} else if(dirtyBegin < dirtyEnd) {
+		dirtyEnd = std::min(dirtyEnd, data.size());
+		bufferObject.uploadSubData(BufferObject::TARGET_UNIFORM_BUFFER, data.data() + dirtyBegin, dirtyEnd - dirtyBegin, dirtyBegin);
+	}
+	dirtyBegin = std::numeric_limits<size_t>::max();
+	dirtyEnd = 0;
+	GET_GL_ERROR();
+}
+
+void GlobalUniformBlock::bind() const {
+	if(bufferObject.isValid())
+		bufferObject.bind(BufferObject::TARGET_UNIFORM_BUFFER, binding);
+}
+
+std::string GlobalUniformBlock::getDeclaration() const {
+	std::ostringstream s;
+	s << "layout(std140) uniform " << BLOCK_NAME << " {\n";
+	for(const auto & member : members) {
+		s << "\t" << getGLSLTypeName(member.type) << " " << member.name.toString();
+		if(member.numValues > 1)
+			s << "[" << member.numValues << "]";
+		s << ";\n";
+	}
+	s << "};\n";
+	return s.str();
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_GLOBALUNIFORMBLOCK_H_
+#define RENDERING_GLOBALUNIFORMBLOCK_H_
+
+#include "Uniform.h"
+#include "../BufferObject.h"
+#include <Util/StringIdentifier.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Rendering {
+
+/*! Uniform buffer object shared by all shaders. The members are laid out according to the std140 rules in the
+	order of their declaration; the corresponding GLSL declaration can be obtained by getDeclaration().
+	Changed values are collected locally and written to the buffer with one call to upload().
+	\note Only uniforms of the default types (no structs) are supported; the member names must be valid GLSL identifiers.
+	\see RenderingContext::enableGlobalUniformBlock	*/
+class GlobalUniformBlock {
+	public:
+		//! Name of the uniform block in GLSL.
+		static const char * const BLOCK_NAME;
+
+		explicit GlobalUniformBlock(uint32_t binding);
+
+		/*! Append a member to the block. The type and the number of values are taken from @p prototype;
+			its data is used as initial value.
+			\throw std::invalid_argument if a member with the same name exists or the buffer has already been created.	*/
+		void addMember(const Uniform & prototype);
+
+		bool contains(const Util::StringIdentifier & name) const	{	return memberIndices.count(name) > 0;	}
+
+		/*! Store the value of a member of the block.
+			\return false if the uniform is no member of the block or its type does not match. */
+		bool setUniform(const Uniform & uniform);
+
+		//! Write all changed values into the buffer object (it is created if necessary).
+		void upload();
+
+		//! Bind the buffer object to the block's binding point.
+		void bind() const;
+
+		uint32_t getBinding() const						{	return binding;	}
+		//! Size of the block in bytes.
+		size_t getSize() const							{	return data.size();	}
+
+		//! GLSL source of the block declaration: <tt>layout(std140) uniform sg_GlobalUniforms { ... };</tt>
+		std::string getDeclaration() const;
+
+	private:
+		struct Member {
+			Util::StringIdentifier name;
+			Uniform::dataType_t type;
+			size_t numValues;
+			size_t offset;
+			uint32_t columns;		//!< number of columns of a matrix, 1 otherwise
+			uint32_t columnSize;	//!< bytes per column in the source data
+			uint32_t columnStride;	//!< bytes between two columns in the block
+			uint32_t valueStride;	//!< bytes between two array elements in the block
+		};
+		const uint32_t binding;
+		std::vector<Member> members;
+		std::unordered_map<Util::StringIdentifier, size_t> memberIndices;
+		std::vector<uint8_t> data;
+		size_t dirtyBegin;
+		size_t dirtyEnd;
+		BufferObject bufferObject;
+};
+
+}
+
+#endif /* RENDERING_GLOBALUNIFORMBLOCK_H_ */
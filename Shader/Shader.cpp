@@ -9,25 +9,54 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "Shader.h"
+#include "GlobalUniformBlock.h"
+#include "ShaderReflection.h"
 #include "Uniform.h"
 #include "UniformRegistry.h"
 #include "../RenderingContext/internal/RenderingStatus.h"
 #include "../RenderingContext/RenderingContext.h"
 #include "../GLHeader.h"
 #include "../Helper.h"
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Vec2.h>
+#include <Geometry/Vec3.h>
+#include <Geometry/Vec4.h>
+#include <Util/IO/FileName.h>
+#include <Util/IO/FileUtils.h>
 #include <Util/Macros.h>
 #include <Util/StringIdentifier.h>
 #include <Util/StringUtils.h>
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <iomanip>
+#include <sstream>
 #include <vector>
 
+#if defined(LIB_GL) && defined(GL_ARB_get_program_binary)
+#define PROGRAM_BINARY_AVAILABLE
+#endif
+
 using namespace std;
 namespace Rendering {
 
 // -----------------------------------------
 // static helper
 
+static const uint32_t PROGRAM_BINARY_MAGIC = 0x43425052; // "RPBC"
+
+static std::string & getProgramBinaryCacheDirectoryRef() {
+	static std::string directory;
+	return directory;
+}
+
+#if defined(PROGRAM_BINARY_AVAILABLE)
+static bool isProgramBinaryCacheEnabled() {
+	static const bool support = isExtensionSupported("GL_ARB_get_program_binary");
+	return support && !getProgramBinaryCacheDirectoryRef().empty();
+}
+#endif
+
 //! (static)
 void Shader::printProgramInfoLog(uint32_t obj) {
 	int infoLogLength = 0;
@@ -95,7 +124,8 @@ Shader * Shader::createShader(const std::string & vsa, const std::string & gsa,
 
 /*!	[ctor]	*/
 Shader::Shader(flag_t _usage) :
-		usageFlags(_usage), renderingData(), prog(0), status(UNKNOWN), uniforms(new UniformRegistry),glFeedbackVaryingType(0){
+		usageFlags(_usage), renderingData(), prog(0), status(UNKNOWN), programBinaryLoaded(false), uniforms(new UniformRegistry),
+		globalUniformBlockBinding(-2), vertexAttributeLayoutId(0), activeVertexAttributes(),glFeedbackVaryingType(0){
 }
 
 /*!	[dtor]	*/
@@ -106,19 +136,31 @@ Shader::~Shader() {
 bool Shader::init() {
 	while(status!=LINKED){
 		if(status == UNKNOWN){
-			status = compileProgram() ? COMPILED : INVALID;
+			status = (loadProgramBinary() || compileProgram()) ? COMPILED : INVALID;
 		}else if(status == COMPILED){
 			if( linkProgram() ){
 				status = LINKED;
-
 				// recreate renderingData
 				renderingData.reset(new RenderingStatus(this));
-
-				// make sure all set uniforms are re-applied.
-				uniforms->resetCounters();
-
-				// initialize uniforms with default
-				initUniformRegistry();
+				initLinkedProgram();
+			}else{
+				status = INVALID;
+			}
+		}else if(status == PENDING){
+			if( finishPendingProgram() ){
+				status = LINKED;
+				// renderingData has been created by initAsync() and may already be used by the RenderingContext.
+				// The uniforms that have been set in the meantime are kept.
+				std::vector<Uniform> presetUniforms;
+				uniforms->collectUniforms(presetUniforms);
+				// the initial uniform values are applied to the current program
+				GLint currentProgram = 0;
+				glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+				glUseProgram(prog);
+				initLinkedProgram();
+				glUseProgram(static_cast<GLuint>(currentProgram));
+				for(auto it = presetUniforms.rbegin(); it != presetUniforms.rend(); ++it)
+					uniforms->setUniform(*it, false, false);
 			}else{
 				status = INVALID;
 			}
@@ -130,6 +172,91 @@ bool Shader::init() {
 	return true;
 }
 
+//! (internal)
+void Shader::initLinkedProgram() {
+	// make sure all set uniforms are re-applied.
+	uniforms->resetCounters();
+
+	reflection.gather(prog, std::any_of(shaderObjects.begin(), shaderObjects.end(), [](const ShaderObjectInfo & obj) {
+		return obj.getType() == ShaderObjectInfo::SHADER_STAGE_COMPUTE;
+	}));
+	subroutineSelections.clear();
+
+	// invalidate vertex array objects created for the old program.
+	vertexAttributeLocations.clear();
+	activeVertexAttributes.clear();
+	for(const auto & attribute : reflection.attributes)
+		activeVertexAttributes.emplace_back(attribute.name);
+	updateVertexAttributeLayoutId();
+
+	// the uniform block bindings are part of the program
+	globalUniformBlockBinding = -2;
+
+	// initialize uniforms with default
+	initUniformRegistry();
+}
+
+bool Shader::initAsync() {
+	if(status != UNKNOWN)
+		return status != INVALID;
+	if(loadProgramBinary()) { // nothing to compile
+		status = COMPILED;
+		return init();
+	}
+#if defined(LIB_GL) && defined(GL_KHR_parallel_shader_compile)
+	static bool threadsInitialized = false;
+	if(!threadsInitialized) {
+		threadsInitialized = true;
+		if(isExtensionSupported("GL_KHR_parallel_shader_compile"))
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); // let the driver choose the number of threads
+	}
+#endif
+	prog = glCreateProgram();
+	for(const auto & shaderObject : shaderObjects) {
+		const GLuint handle = shaderObject.compileAsync();
+		glAttachShader(prog, handle);
+		pendingShaderHandles.push_back(handle);
+	}
+	startLinking();
+	GET_GL_ERROR();
+	renderingData.reset(new RenderingStatus(this));
+	status = PENDING;
+	return true;
+}
+
+bool Shader::isReady() {
+	if(status == PENDING) {
+#if defined(LIB_GL) && defined(GL_KHR_parallel_shader_compile)
+		static const bool support = isExtensionSupported("GL_KHR_parallel_shader_compile");
+		if(support) {
+			GLint completed = GL_FALSE;
+			glGetProgramiv(prog, GL_COMPLETION_STATUS_KHR, &completed);
+			if(completed == GL_FALSE)
+				return false;
+		}
+#endif
+		init();
+	}
+	return status == LINKED;
+}
+
+//! (internal)
+bool Shader::finishPendingProgram() {
+	bool compiled = true;
+	for(size_t i = 0; i < pendingShaderHandles.size(); ++i) {
+		if(!shaderObjects[i].checkCompileStatus(pendingShaderHandles[i]))
+			compiled = false;
+		glDeleteShader(pendingShaderHandles[i]);
+	}
+	pendingShaderHandles.clear();
+	if(!compiled) {
+		glDeleteProgram(prog);
+		prog = 0;
+		return false;
+	}
+	return checkLinkStatus();
+}
+
 /*!	(internal) */
 bool Shader::compileProgram() {
 	prog = glCreateProgram();
@@ -149,7 +276,16 @@ bool Shader::compileProgram() {
 
 //! (internal)
 bool Shader::linkProgram() {
-	
+	if(programBinaryLoaded) { // the program binary has already been linked
+		programBinaryLoaded = false;
+		return true;
+	}
+	startLinking();
+	return checkLinkStatus();
+}
+
+//! (internal)
+void Shader::startLinking() {
 	// apply feedback varyings
 	#if defined(GL_EXT_transform_feedback)
 	if(!feedbackVaryings.empty() && RenderingContext::requestTransformFeedbackSupport()){
@@ -163,10 +299,17 @@ bool Shader::linkProgram() {
 	}
 	#endif // GL_EXT_transform_feedback
 
+#if defined(PROGRAM_BINARY_AVAILABLE)
+	if(isProgramBinaryCacheEnabled())
+		glProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
 	
 	glLinkProgram(prog);
 	GET_GL_ERROR();
+}
 
+//! (internal)
+bool Shader::checkLinkStatus() {
 	GLint linkStatus;
 	glGetProgramiv(prog, GL_LINK_STATUS, &linkStatus);
 	if (linkStatus == GL_FALSE) {
@@ -178,7 +321,114 @@ bool Shader::linkProgram() {
 	}
 
 	GET_GL_ERROR();
+	storeProgramBinary();
+	return true;
+}
+
+// ------------------------------------------------------------------
+// Program binary cache
+
+//! (static)
+void Shader::setProgramBinaryCacheDirectory(const std::string & directory) {
+	getProgramBinaryCacheDirectoryRef() = directory;
+}
+
+//! (static)
+const std::string & Shader::getProgramBinaryCacheDirectory() {
+	return getProgramBinaryCacheDirectoryRef();
+}
+
+//! (internal) 64 bit FNV-1a hash of the program's description.
+std::string Shader::getProgramBinaryFileName() const {
+	std::ostringstream key;
+	for(const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+		const GLubyte * str = glGetString(name);
+		key << (str != nullptr ? reinterpret_cast<const char *>(str) : "") << '\n';
+	}
+	for(const auto & shaderObject : shaderObjects)
+		key << shaderObject.getType() << '\n' << shaderObject.getDefines() << '\n' << shaderObject.getCode() << '\n';
+	key << glFeedbackVaryingType << '\n';
+	for(const auto & varying : feedbackVaryings)
+		key << varying << '\n';
+
+	uint64_t hash = 14695981039346656037ull;
+	for(const char c : key.str()) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 1099511628211ull;
+	}
+	std::ostringstream fileName;
+	const std::string & directory = getProgramBinaryCacheDirectory();
+	fileName << directory;
+	if(directory.back() != '/')
+		fileName << '/';
+	fileName << std::hex << std::setw(16) << std::setfill('0') << hash << ".glprog";
+	return fileName.str();
+}
+
+//! (internal)
+bool Shader::loadProgramBinary() {
+#if defined(PROGRAM_BINARY_AVAILABLE)
+	if(!isProgramBinaryCacheEnabled())
+		return false;
+	const Util::FileName fileName(getProgramBinaryFileName());
+	if(!Util::FileUtils::isFile(fileName))
+		return false;
+	auto stream = Util::FileUtils::openForReading(fileName);
+	if(!stream)
+		return false;
+	uint32_t header[3] = {0, 0, 0}; // magic, binary format, binary size
+	stream->read(reinterpret_cast<char *>(header), sizeof(header));
+	if(!stream->good() || header[0] != PROGRAM_BINARY_MAGIC || header[2] == 0)
+		return false;
+	std::vector<char> binary(header[2]);
+	stream->read(binary.data(), static_cast<std::streamsize>(binary.size()));
+	if(!stream->good())
+		return false;
+
+	prog = glCreateProgram();
+	glProgramBinary(prog, static_cast<GLenum>(header[1]), binary.data(), static_cast<GLsizei>(binary.size()));
+	GLint linkStatus = GL_FALSE;
+	glGetProgramiv(prog, GL_LINK_STATUS, &linkStatus);
+	glGetError(); // an unsupported binary format is reported as GL error
+	if(linkStatus == GL_FALSE) { // the driver rejected the binary (e.g. after a driver update) -> compile from source
+		glDeleteProgram(prog);
+		prog = 0;
+		return false;
+	}
+	programBinaryLoaded = true;
 	return true;
+#else
+	return false;
+#endif
+}
+
+//! (internal)
+void Shader::storeProgramBinary() {
+#if defined(PROGRAM_BINARY_AVAILABLE)
+	if(!isProgramBinaryCacheEnabled())
+		return;
+	GLint binaryLength = 0;
+	glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if(binaryLength <= 0)
+		return;
+	std::vector<char> binary(static_cast<size_t>(binaryLength));
+	GLenum binaryFormat = 0;
+	GLsizei length = 0;
+	glGetProgramBinary(prog, binaryLength, &length, &binaryFormat, binary.data());
+	GET_GL_ERROR();
+	if(length <= 0)
+		return;
+
+	const Util::FileName fileName(getProgramBinaryFileName());
+	auto stream = Util::FileUtils::openForWriting(fileName);
+	if(!stream) {
+		WARN("Shader: Could not write program binary to " + fileName.toString());
+		return;
+	}
+	const uint32_t header[3] = {PROGRAM_BINARY_MAGIC, static_cast<uint32_t>(binaryFormat), static_cast<uint32_t>(length)};
+	stream->write(reinterpret_cast<const char *>(header), sizeof(header));
+	stream->write(binary.data(), length);
+#endif
 }
 
 void Shader::attachShaderObject(ShaderObjectInfo && obj) {
@@ -189,6 +439,10 @@ void Shader::attachShaderObject(ShaderObjectInfo && obj) {
 bool Shader::_enable() {
 	if( status==LINKED || init() ){
 		glUseProgram(prog);
+#if defined(LIB_GL) && defined(GL_ARB_shader_subroutine)
+		for(const auto & selection : subroutineSelections)
+			glUniformSubroutinesuiv(selection.first, static_cast<GLsizei>(selection.second.size()), selection.second.data());
+#endif
 		return true;
 	}
 	else
@@ -197,7 +451,7 @@ bool Shader::_enable() {
 
 bool Shader::enable(RenderingContext & rc){
 	rc.setShader(this);
-	return getStatus() == LINKED || init();
+	return getStatus() == LINKED || getStatus() == PENDING || init();
 }
 
 bool Shader::isActive(RenderingContext & rc){
@@ -212,23 +466,22 @@ void Shader::applyUniforms(bool forced){
 		return;
 
 	// apply the uniforms that have been changed since the last call (or all, if forced)
-	for(auto it=uniforms->orderedList.begin();
-			it!=uniforms->orderedList.end() && ( (*it)->stepOfLastSet > uniforms->stepOfLastApply || forced ); ++it ){
-		UniformRegistry::entry_t * entry(*it);
-
+	const GLuint program = getShaderProg();
+	UniformRegistry::forEachEntrySetAfter(*uniforms, uniforms->stepOfLastApply, forced, [program](UniformRegistry::entry_t & entry) {
 		// new uniform? --> query and store the location
-		if( entry->location==-1 ){
-			entry->location = glGetUniformLocation( getShaderProg(), entry->uniform.getName().c_str());
-			if(entry->location==-1){
-				entry->valid = false;
-				if(entry->warnIfUnused)
-					WARN(std::string("No uniform named: ") + entry->uniform.getName());
-				continue;
+		if( entry.location==-1 ){
+			entry.location = glGetUniformLocation( program, entry.uniform.getName().c_str());
+			if(entry.location==-1){
+				entry.valid = false;
+				if(entry.warnIfUnused)
+					WARN(std::string("No uniform named: ") + entry.uniform.getName());
+				return;
 			}
 		}
 		// set the data
-		applyUniform(entry->uniform,entry->location);
-	}
+		if(applyUniform(entry.uniform,entry.location))
+			++RenderingContext::_getFrameCounters().uniformUploads;
+	});
 	uniforms->stepOfLastApply = UniformRegistry::getNewGlobalStep();
 }
 
@@ -326,25 +579,15 @@ void Shader::getActiveUniforms(std::vector<Uniform> & activeUniforms){
 	if(getStatus()!=LINKED)
 		return;
 
-	GLint uniformCount = 0;
-	glGetProgramiv(prog,GL_ACTIVE_UNIFORMS,&uniformCount);
-	GLint bufSize=0;
-	glGetProgramiv(prog,GL_ACTIVE_UNIFORM_MAX_LENGTH,&bufSize);
-	auto nameBuffer=new char[bufSize];
-
-	activeUniforms.reserve(uniformCount);
-
-	for(GLint i=0;i<uniformCount;++i){
-		GLsizei nameLength=0;
-		GLint arraySize=0;
-		GLenum glType=0;
-		glGetActiveUniform(prog,i,bufSize,&nameLength,&arraySize,&glType,nameBuffer);
+	activeUniforms.reserve(activeUniforms.size() + reflection.uniforms.size());
 
-		std::string name(nameBuffer,nameLength);
-
-		// name is the name of an array (name[index]) -> strip the index
-		if(name.length()>0&&name.at(name.length()-1) == ']')
-			name=name.substr(0,name.rfind('['));
+	// names, types and locations are taken from the reflection data; only the values are queried.
+	for(const auto & info : reflection.uniforms){
+		if(info.blockIndex != -1) // members of uniform blocks have no location
+			continue;
+		const std::string & name = info.name;
+		const GLenum glType = info.glType;
+		const uint32_t arraySize = info.arraySize;
 
 		// determine data type
 		Uniform::dataType_t dataType;
@@ -469,13 +712,9 @@ void Shader::getActiveUniforms(std::vector<Uniform> & activeUniforms){
 		std::vector<uint8_t> data(valueSize * arraySize);
 		bool valid=true;
 		// fetch the values
-		for(int index=0;index<arraySize;++index){
-			// add '[index]' for index>0
-			const std::string name2(index==0? name : name+'['+Util::StringUtils::toString(index)+']');
-			// query location
-			const GLint location = glGetUniformLocation( getShaderProg(), name2.c_str() );
+		for(uint32_t index=0;index<arraySize;++index){
+			const GLint location = reflection.elementLocations[info.firstLocation + index];
 			if(location==-1){
-//				WARN(std::string("Uniform not found (should not be possible):")+name2);
 				valid=false;
 				break;
 			}
@@ -490,11 +729,13 @@ void Shader::getActiveUniforms(std::vector<Uniform> & activeUniforms){
 			activeUniforms.emplace_back(name, dataType, arraySize, data);
 		}
 	}
-
-	delete [] nameBuffer;
 }
 
 void Shader::setUniform(RenderingContext & rc,const Uniform & uniform, bool warnIfUnused, bool forced){
+	if(getStatus() == PENDING){ // applied when the program is ready
+		uniforms->setUniform(uniform, warnIfUnused, forced);
+		return;
+	}
 	if(!init()){
 		WARN("setUniform: Shader not ready.");
 		return;
@@ -502,6 +743,86 @@ void Shader::setUniform(RenderingContext & rc,const Uniform & uniform, bool warn
 	rc._setUniformOnShader(this,uniform,warnIfUnused,forced);
 }
 
+UniformHandle Shader::getUniformHandle(const Util::StringIdentifier name) {
+	UniformHandle handle;
+	if(getStatus() == PENDING || !init())
+		return handle;
+	const uint32_t slot = uniforms->findSlot(name);
+	if(slot == UniformRegistry::EMPTY_SLOT)
+		return handle;
+	UniformRegistry::entry_t & entry = uniforms->entries[slot];
+	if(!entry.valid)
+		return handle;
+	if(entry.location == -1) {
+		entry.location = glGetUniformLocation(getShaderProg(), entry.uniform.getName().c_str());
+		if(entry.location == -1)
+			return handle;
+	}
+	handle.slot = slot;
+	handle.location = entry.location;
+	handle.type = static_cast<uint8_t>(entry.uniform.getType());
+	return handle;
+}
+
+//! (internal)
+bool Shader::setUniformData(RenderingContext & rc, const UniformHandle & handle, uint8_t type, const void * data, size_t numBytes) {
+	if(!handle.isValid() || handle.type != type || handle.slot >= uniforms->entries.size()
+			|| uniforms->entries[handle.slot].uniform.getDataSize() != numBytes)
+		return false;
+	if(uniforms->setUniformData(handle.slot, data, numBytes, false) && rc.getImmediateMode() && rc.getActiveShader() == this)
+		applyUniforms(false);
+	return true;
+}
+
+bool Shader::setUniform(RenderingContext & rc, const UniformHandle & handle, float value) {
+	return setUniformData(rc, handle, Uniform::UNIFORM_FLOAT, &value, sizeof(value));
+}
+
+bool Shader::setUniform(RenderingContext & rc, const UniformHandle & handle, int32_t value) {
+	return setUniformData(rc, handle, Uniform::UNIFORM_INT, &value, sizeof(value));
+}
+
+bool Shader::setUniform(RenderingContext & rc, const UniformHandle & handle, const Geometry::Vec2 & value) {
+	return setUniformData(rc, handle, Uniform::UNIFORM_VEC2F, value.getVec(), 2 * sizeof(float));
+}
+
+bool Shader::setUniform(RenderingContext & rc, const UniformHandle & handle, const Geometry::Vec3 & value) {
+	return setUniformData(rc, handle, Uniform::UNIFORM_VEC3F, value.getVec(), 3 * sizeof(float));
+}
+
+bool Shader::setUniform(RenderingContext & rc, const UniformHandle & handle, const Geometry::Vec4 & value) {
+	return setUniformData(rc, handle, Uniform::UNIFORM_VEC4F, value.getVec(), 4 * sizeof(float));
+}
+
+bool Shader::setUniform(RenderingContext & rc, const UniformHandle & handle, const Geometry::Matrix4x4 & value) {
+	const Geometry::Matrix4x4 transposed = value.getTransposed();
+	return setUniformData(rc, handle, Uniform::UNIFORM_MATRIX_4X4F, transposed.getData(), 16 * sizeof(float));
+}
+
+// --------------------------------
+// global uniform block
+
+bool Shader::_bindGlobalUniformBlock(uint32_t binding){
+	if(globalUniformBlockBinding == static_cast<int32_t>(binding))
+		return true;
+	if(globalUniformBlockBinding == -1 || getStatus() != LINKED)
+		return false;
+#if defined(LIB_GL) && defined(GL_ARB_uniform_buffer_object)
+	const GLuint blockIndex = glGetUniformBlockIndex(prog, GlobalUniformBlock::BLOCK_NAME);
+	if(blockIndex == GL_INVALID_INDEX){
+		globalUniformBlockBinding = -1;
+		return false;
+	}
+	glUniformBlockBinding(prog, blockIndex, binding);
+	GET_GL_ERROR();
+	globalUniformBlockBinding = static_cast<int32_t>(binding);
+	return true;
+#else
+	globalUniformBlockBinding = -1;
+	return false;
+#endif
+}
+
 // --------------------------------
 // vertexAttributes
 
@@ -512,6 +833,14 @@ void Shader::defineVertexAttribute(const std::string & attrName, uint32_t index)
 	}
 
 	glBindAttribLocation(prog,index,attrName.c_str());
+	vertexAttributeLocations.clear();
+	updateVertexAttributeLayoutId();
+}
+
+//! (internal)
+void Shader::updateVertexAttributeLayoutId(){
+	static uint32_t layoutIdCounter = 0;
+	vertexAttributeLayoutId = ++layoutIdCounter;
 }
 
 int32_t Shader::getVertexAttributeLocation(Util::StringIdentifier attrName){
@@ -526,6 +855,12 @@ int32_t Shader::getVertexAttributeLocation(Util::StringIdentifier attrName){
 	}
 	return it->second;
 }
+
+const std::vector<Util::StringIdentifier> & Shader::getActiveVertexAttributes(){
+	if(getStatus() != LINKED)
+		init();
+	return activeVertexAttributes;
+}
 // ---------------------------------
 // feedback handler
 
@@ -553,11 +888,24 @@ void Shader::setSeparateFeedbackVaryings(const std::vector<std::string>& names){
 // Shader Subroutines
 
 int32_t Shader::getSubroutineIndex(uint32_t stage, const std::string & name) {
-	#if defined(LIB_GL) and defined(GL_ARB_shader_subroutine)
-	return glGetSubroutineIndex(getShaderProg(), stage, name.c_str());
-	#else
-	return -1;
-	#endif
+	if(getStatus() != LINKED && !init())
+		return -1;
+	return reflection.getSubroutineIndex(stage, name);
+}
+
+bool Shader::_selectSubroutines(uint32_t stage, const std::vector<uint32_t> & indices) {
+	if(indices.size() != reflection.getNumSubroutineUniformLocations(stage))
+		return true; // not cached; the upload reports the error
+	for(auto & selection : subroutineSelections) {
+		if(selection.first == stage) {
+			if(selection.second == indices)
+				return false;
+			selection.second = indices;
+			return true;
+		}
+	}
+	subroutineSelections.emplace_back(stage, indices);
+	return true;
 }
 
 
@@ -12,6 +12,7 @@
 #define SHADER_H
 
 #include "ShaderObjectInfo.h"
+#include "ShaderReflection.h"
 #include "../RenderingContext/RenderingContext.h"
 #include <Util/ReferenceCounter.h>
 #include <Util/StringIdentifier.h>
@@ -19,11 +20,19 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 // Forward declarations
 namespace Geometry {
+template<typename _T> class _Vec2;
+typedef _Vec2<float> Vec2;
+template<typename _T> class _Vec3;
+typedef _Vec3<float> Vec3;
+template<typename _T> class _Vec4;
+typedef _Vec4<float> Vec4;
 template<typename _T> class _Matrix4x4;
+typedef _Matrix4x4<float> Matrix4x4;
 typedef _Matrix4x4<float> Matrix4x4f;
 }
 namespace Util {
@@ -35,6 +44,21 @@ class Uniform;
 class UniformRegistry;
 class RenderingStatus;
 
+/*!	Precompiled reference to a uniform of one Shader (see Shader::getUniformHandle()).
+	Setting a value through a handle needs neither a name lookup nor an allocation. The handle stays valid for the
+	lifetime of the shader; it must not be used with another shader.	*/
+class UniformHandle {
+		static const uint32_t INVALID_SLOT = 0xffffffff;
+		uint32_t slot;
+		int32_t location;
+		uint8_t type;	//!< Uniform::dataType_t
+		friend class Shader;
+	public:
+		UniformHandle() : slot(INVALID_SLOT), location(-1), type(0) {}
+		bool isValid() const			{	return slot != INVALID_SLOT;	}
+		int32_t getLocation() const		{	return location;	}
+};
+
 /*!	Shader */
 class Shader : public Util::ReferenceCounter<Shader> {
 	/*! @name Main */
@@ -50,8 +74,8 @@ class Shader : public Util::ReferenceCounter<Shader> {
 		bool _enable();
 
 		/*! Sets the active shader at the renderingContext. If the shader
-			has not been linked, it is linked.
-			\return returns true if the status of the shader is LINKED	*/
+			has not been linked, it is linked (unless it is PENDING, see initAsync()).
+			\return returns true if the status of the shader is LINKED or PENDING	*/
 		bool enable(RenderingContext & rc);
 		bool isActive(RenderingContext & rc); // (???) !=enabled
 
@@ -90,7 +114,8 @@ class Shader : public Util::ReferenceCounter<Shader> {
 			UNKNOWN = 0,
 			COMPILED = 1,
 			LINKED = 2,
-			INVALID = 3
+			INVALID = 3,
+			PENDING = 4 //!< compiling and linking have been issued by initAsync(), but may not be finished
 		};
 		status_t getStatus()const				{	return status;	}
 		uint32_t getShaderProg()const			{	return prog;	}
@@ -98,9 +123,29 @@ class Shader : public Util::ReferenceCounter<Shader> {
 		//! Try to transfer the shader into LINKED-state. Returns true on success.
 		bool init();
 
+		/*! Issue compiling and linking of the program without waiting for the results; the status is set to PENDING.
+			The uniform and attribute locations are resolved when the linking has finished.
+			While the shader is pending, it can be set at the RenderingContext, whose handling of draws
+			can be configured with RenderingContext::setPendingShaderFallback().
+			Calling init() waits for the results.
+			\return false if the shader is INVALID.	*/
+		bool initAsync();
+
+		/*! If the shader is PENDING and the driver has finished compiling and linking it, the shader is transferred
+			into the LINKED (or INVALID) state. Returns true if the shader is LINKED.
+			\note The completion is queried using GL_KHR_parallel_shader_compile. If the extension is not supported,
+				the call waits for the results.	*/
+		bool isReady();
+
+		/*! Uniforms, uniform blocks, vertex attributes and subroutines of the linked program.
+			The tables are gathered once per linking; they are empty if the shader is not LINKED.	*/
+		const ShaderReflection & getReflection() const	{	return reflection;	}
+
 	private:
 		uint32_t prog;
 		status_t status;
+		std::vector<uint32_t> pendingShaderHandles; //!< shader objects of a PENDING program
+		ShaderReflection reflection;
 
 		/*! (internal) Compile all objects and create the shader program.
 			If everything works fine, status is set to COMPILED and true is returned.
@@ -111,6 +156,46 @@ class Shader : public Util::ReferenceCounter<Shader> {
 			If everything works fine, status is set to LINKED and true is returned.
 			Otherwise, status is set to INVALID and false is returned.	*/
 		bool linkProgram();
+
+		//! (internal) Apply the feedback varyings and issue linking the program.
+		void startLinking();
+
+		//! (internal) Check if the program was linked successfully. If not, the program is deleted and false is returned.
+		bool checkLinkStatus();
+
+		//! (internal) Check the results of a PENDING program.
+		bool finishPendingProgram();
+
+		//! (internal) Reset the program dependent data after the program has been linked.
+		void initLinkedProgram();
+	// @}
+
+	// ------------------------
+
+	/*! @name Program binary cache
+		If a cache directory is set, the binary of a linked program is stored there and loaded instead of
+		compiling the sources when the same program is initialized again. A program is identified by a hash
+		of its shader objects (type, defines and code), its feedback varyings and the driver's vendor,
+		renderer and version strings. If the driver rejects a cached binary, the program is compiled from
+		source and the cache entry is replaced.
+		\note Requires GL_ARB_get_program_binary; otherwise the cache is ignored. */
+	// @{
+	public:
+		//! (static) Set the directory used for the cached binaries. An empty string (default) disables the cache.
+		static void setProgramBinaryCacheDirectory(const std::string & directory);
+		static const std::string & getProgramBinaryCacheDirectory();
+
+	private:
+		bool programBinaryLoaded; //!< true if prog has been created from a cached binary and must not be linked again
+
+		std::string getProgramBinaryFileName() const;
+
+		/*! (internal) Try to create the program from the cache. If successful, prog is linked,
+			programBinaryLoaded is set and true is returned.	*/
+		bool loadProgramBinary();
+
+		//! (internal) Store the binary of the linked program in the cache.
+		void storeProgramBinary();
 	// @}
 
 	// ------------------------
@@ -166,6 +251,38 @@ class Shader : public Util::ReferenceCounter<Shader> {
 			\note The uniform is stored at the Shader's internal uniformRegistry.
 			\note The Shader needs not to be active.*/
 		void setUniform(RenderingContext & rc,const Uniform & uniform, bool warnIfUnused=true, bool forced=false);
+
+		/*! Resolve the uniform with the given name once, so that its value can be set without a name lookup.
+			\note The shader is linked, if necessary; a pending shader (see initAsync()) has to be finished first.
+			@return An invalid handle if the program does not use a uniform with the given name.	*/
+		UniformHandle getUniformHandle(const Util::StringIdentifier name);
+
+		/*! Set the value of a single (non-array) uniform through its handle. The value is stored in the
+			uniformRegistry like a Uniform set by name; it is applied immediately if the shader is active in an
+			immediate RenderingContext.
+			@return false if the handle is invalid or the type does not match the declared type of the uniform.	*/
+		bool setUniform(RenderingContext & rc, const UniformHandle & handle, float value);
+		bool setUniform(RenderingContext & rc, const UniformHandle & handle, int32_t value);
+		bool setUniform(RenderingContext & rc, const UniformHandle & handle, const Geometry::Vec2 & value);
+		bool setUniform(RenderingContext & rc, const UniformHandle & handle, const Geometry::Vec3 & value);
+		bool setUniform(RenderingContext & rc, const UniformHandle & handle, const Geometry::Vec4 & value);
+		//! \note As for Uniform, the matrix is transposed.
+		bool setUniform(RenderingContext & rc, const UniformHandle & handle, const Geometry::Matrix4x4 & value);
+
+	private:
+		bool setUniformData(RenderingContext & rc, const UniformHandle & handle, uint8_t type, const void * data, size_t numBytes);
+	// @}
+
+	// ------------------------
+
+	/*! @name Global uniform block */
+	// @{
+	private:
+		int32_t globalUniformBlockBinding; //!< -2: unknown, -1: the program does not declare the block
+	public:
+		/*! (internal) If the program declares the block GlobalUniformBlock::BLOCK_NAME, it is bound to
+			the given binding point and true is returned. Called by the RenderingContext.	*/
+		bool _bindGlobalUniformBlock(uint32_t binding);
 	// @}
 
 	// ------------------------
@@ -174,9 +291,21 @@ class Shader : public Util::ReferenceCounter<Shader> {
 	// @{
 	private:
 		std::unordered_map<Util::StringIdentifier, int32_t> vertexAttributeLocations;
+		uint32_t vertexAttributeLayoutId;
+		std::vector<Util::StringIdentifier> activeVertexAttributes;
+		void updateVertexAttributeLayoutId();
 	public:
 		void defineVertexAttribute(const std::string & attrName, uint32_t index);
 		int32_t getVertexAttributeLocation(Util::StringIdentifier attrName);
+
+		/*! Names of the vertex attributes used by the linked program.
+			Built-in attributes (e.g. gl_Vertex or gl_VertexID) are not included. The list is taken from the reflection data. */
+		const std::vector<Util::StringIdentifier> & getActiveVertexAttributes();
+
+		/*! Globally unique id of the current vertex attribute locations of this shader.
+			A new id is assigned whenever the program is linked or an attribute location is redefined;
+			it is used as key for cached vertex array objects.	*/
+		uint32_t getVertexAttributeLayoutId() const		{	return vertexAttributeLayoutId;	}
 	// @}
 
 
@@ -196,7 +325,16 @@ class Shader : public Util::ReferenceCounter<Shader> {
 	/*! @name Shader Subroutines */
 	// @{
 	public:
+		//! \return the index of the named subroutine of the given stage (taken from the reflection data) or -1.
 		int32_t getSubroutineIndex(uint32_t stage, const std::string & name);
+
+		/*! (internal) Called by the RenderingContext before the subroutine indices of a stage are loaded into the
+			active program. The selection is stored and re-loaded whenever the program is bound again (binding
+			a program resets its subroutine uniforms).
+			\return false if the indices equal the selection that is already loaded (no upload required). */
+		bool _selectSubroutines(uint32_t stage, const std::vector<uint32_t> & indices);
+	private:
+		std::vector<std::pair<uint32_t, std::vector<uint32_t>>> subroutineSelections; //!< (stage, indices)
 	// @}
 };
 }
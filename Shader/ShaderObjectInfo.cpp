@@ -48,26 +48,26 @@ static void printShaderInfoLog(uint32_t obj, const std::string & code, const Uti
 	GET_GL_ERROR();
 }
 
-uint32_t ShaderObjectInfo::compile() const {
-	GLuint handle = glCreateShader(getType());
+//! (internal) The shader's code with the stage define and the defines inserted.
+static std::string getPreparedCode(const ShaderObjectInfo & obj) {
 	// This postfix assures that the file not be empty even if everything is cut out due to an ifdef-commando.
 	// Files without content do not compile with AMD cards.
-	std::string strCode = getCode() + "\nvoid _();\n";
+	std::string strCode = obj.getCode() + "\nvoid _();\n";
 	std::string header;
 
 	// prepend a "#define SG_shaderType" or insert it after the initial "#version..." line.
-	if(getType() == GL_FRAGMENT_SHADER) {
+	if(obj.getType() == GL_FRAGMENT_SHADER) {
 		header = "#define SG_FRAGMENT_SHADER\n";
 #ifdef LIB_GL
-	} else if(getType() == GL_GEOMETRY_SHADER) {
+	} else if(obj.getType() == GL_GEOMETRY_SHADER) {
 		header = "#define SG_GEOMETRY_SHADER\n";
-	} else if(getType() == GL_COMPUTE_SHADER) {
+	} else if(obj.getType() == GL_COMPUTE_SHADER) {
 		header = "#define SG_COMPUTE_SHADER\n";
 #endif /* LIB_GL */
-	} else if(getType() == GL_VERTEX_SHADER) {
+	} else if(obj.getType() == GL_VERTEX_SHADER) {
 		header = "#define SG_VERTEX_SHADER\n";
 	}
-	header += defines;
+	header += obj.getDefines();
 	static const std::string versionPrefix = "#version";
 	if(strCode.compare(0, versionPrefix.length(), versionPrefix) == 0) {
 		header += "#line 2\n";
@@ -76,20 +76,37 @@ uint32_t ShaderObjectInfo::compile() const {
 		header += "#line 1\n";
 		strCode = header + strCode;
 	}
+	return strCode;
+}
 
+uint32_t ShaderObjectInfo::compile() const {
+	const GLuint handle = compileAsync();
+	if(!checkCompileStatus(handle)) {
+		GET_GL_ERROR();
+		glDeleteShader(handle);
+		return 0;
+	}
+	return handle;
+}
+
+uint32_t ShaderObjectInfo::compileAsync() const {
+	GLuint handle = glCreateShader(getType());
+	const std::string strCode = getPreparedCode(*this);
 	const char * str = strCode.c_str();
 	glShaderSource(handle, 1, &str, nullptr);
 	glCompileShader(handle);
 	GET_GL_ERROR();
+	return handle;
+}
+
+bool ShaderObjectInfo::checkCompileStatus(uint32_t handle) const {
 	GLint compileStatus;
 	glGetShaderiv(handle, GL_COMPILE_STATUS, &compileStatus);
 	if(compileStatus == GL_FALSE) {
-		printShaderInfoLog(handle, strCode, filename);
-		GET_GL_ERROR();
-		glDeleteShader(handle);
-		return 0;
+		printShaderInfoLog(handle, getPreparedCode(*this), filename);
+		return false;
 	}
-	return handle;
+	return true;
 }
 
 ShaderObjectInfo ShaderObjectInfo::createVertex(const std::string & code) {
@@ -54,6 +54,9 @@ class ShaderObjectInfo {
 		uint32_t getType() const {
 			return type;
 		}
+		const std::string & getDefines() const {
+			return defines;
+		}
 		ShaderObjectInfo& addDefine(const std::string& key, const std::string& value="") {
 			defines += "#define " + key + " " + value + "\n";
 			return *this;
@@ -67,6 +70,20 @@ class ShaderObjectInfo {
 		 */
 		uint32_t compile() const;
 
+		/**
+		 * Issue compiling the source without waiting for the result.
+		 * 
+		 * @return Handle of the GL shader
+		 * @see checkCompileStatus
+		 */
+		uint32_t compileAsync() const;
+
+		/**
+		 * Check if the given shader handle has been compiled successfully.
+		 * If not, the info log is printed.
+		 */
+		bool checkCompileStatus(uint32_t handle) const;
+
 		/**
 		 * Create a VertexShaderObject from the given code
 		 * 
@@ -0,0 +1,192 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ShaderReflection.h"
+#include "ShaderObjectInfo.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+#include <Util/StringUtils.h>
+#include <algorithm>
+
+namespace Rendering {
+
+void ShaderReflection::clear() {
+	uniforms.clear();
+	elementLocations.clear();
+	blocks.clear();
+	attributes.clear();
+	subroutines.clear();
+	stages.clear();
+	workGroupSize = {{0, 0, 0}};
+}
+
+//! (internal)
+static std::string getStrippedName(const std::vector<GLchar> & buffer, GLsizei length) {
+	std::string name(buffer.data(), static_cast<std::size_t>(length));
+	// name is the name of an array (name[index]) -> strip the index
+	if(!name.empty() && name.back() == ']')
+		name.erase(name.rfind('['));
+	return name;
+}
+
+void ShaderReflection::gather(uint32_t program, bool computeProgram) {
+	clear();
+	if(program == 0)
+		return;
+
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader)
+	if(computeProgram) {
+		GLint size[3] = {0, 0, 0};
+		glGetProgramiv(program, GL_COMPUTE_WORK_GROUP_SIZE, size);
+		workGroupSize = {{static_cast<uint32_t>(size[0]), static_cast<uint32_t>(size[1]), static_cast<uint32_t>(size[2])}};
+	}
+#else
+	static_cast<void>(computeProgram);
+#endif
+
+	{ // uniforms
+		GLint count = 0;
+		GLint maxLength = 0;
+		glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+		std::vector<GLchar> buffer(static_cast<std::size_t>(std::max(maxLength, 1)));
+		uniforms.reserve(static_cast<std::size_t>(count));
+		for(GLint i = 0; i < count; ++i) {
+			GLsizei length = 0;
+			GLint arraySize = 0;
+			GLenum glType = 0;
+			glGetActiveUniform(program, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()), &length, &arraySize, &glType, buffer.data());
+
+			UniformInfo info;
+			info.name = getStrippedName(buffer, length);
+			info.glType = glType;
+			info.arraySize = static_cast<uint32_t>(std::max(arraySize, 1));
+			info.blockIndex = -1;
+#if defined(LIB_GL) && defined(GL_ARB_uniform_buffer_object)
+			{
+				const GLuint uniformIndex = static_cast<GLuint>(i);
+				GLint blockIndex = -1;
+				glGetActiveUniformsiv(program, 1, &uniformIndex, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+				info.blockIndex = blockIndex;
+			}
+#endif
+			info.firstLocation = static_cast<uint32_t>(elementLocations.size());
+			if(info.blockIndex == -1) {
+				for(uint32_t index = 0; index < info.arraySize; ++index) {
+					// add '[index]' for index>0
+					const std::string elementName(index == 0 ? info.name : info.name + '[' + Util::StringUtils::toString(index) + ']');
+					elementLocations.push_back(glGetUniformLocation(program, elementName.c_str()));
+				}
+			}
+			uniforms.emplace_back(std::move(info));
+		}
+	}
+
+#if defined(LIB_GL) && defined(GL_ARB_uniform_buffer_object)
+	{ // uniform blocks
+		GLint count = 0;
+		GLint maxLength = 0;
+		glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+		glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+		std::vector<GLchar> buffer(static_cast<std::size_t>(std::max(maxLength, 1)));
+		blocks.reserve(static_cast<std::size_t>(count));
+		for(GLint i = 0; i < count; ++i) {
+			GLsizei length = 0;
+			glGetActiveUniformBlockName(program, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()), &length, buffer.data());
+			GLint dataSize = 0;
+			GLint numUniforms = 0;
+			glGetActiveUniformBlockiv(program, static_cast<GLuint>(i), GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+			glGetActiveUniformBlockiv(program, static_cast<GLuint>(i), GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &numUniforms);
+			BlockInfo info;
+			info.name.assign(buffer.data(), static_cast<std::size_t>(length));
+			info.index = static_cast<uint32_t>(i);
+			info.dataSize = static_cast<uint32_t>(dataSize);
+			info.numUniforms = static_cast<uint32_t>(numUniforms);
+			blocks.emplace_back(std::move(info));
+		}
+	}
+#endif
+
+	{ // vertex attributes
+		GLint count = 0;
+		GLint maxLength = 0;
+		glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+		glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+		std::vector<GLchar> buffer(static_cast<std::size_t>(std::max(maxLength, 1)));
+		for(GLint i = 0; i < count; ++i) {
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum glType = 0;
+			glGetActiveAttrib(program, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()), &length, &size, &glType, buffer.data());
+			const std::string name(buffer.data(), static_cast<std::size_t>(length));
+			if(name.compare(0, 3, "gl_") == 0)
+				continue;
+			AttributeInfo info;
+			info.name = Util::StringIdentifier(name);
+			info.glType = glType;
+			info.arraySize = static_cast<uint32_t>(std::max(size, 1));
+			info.location = glGetAttribLocation(program, name.c_str());
+			attributes.emplace_back(info);
+		}
+	}
+
+#if defined(LIB_GL) && defined(GL_ARB_shader_subroutine)
+	static const bool subroutinesSupported = isExtensionSupported("GL_ARB_shader_subroutine");
+	if(subroutinesSupported) {
+		static const bool computeSupported = isExtensionSupported("GL_ARB_compute_shader");
+		std::vector<uint32_t> stageList{	ShaderObjectInfo::SHADER_STAGE_VERTEX, ShaderObjectInfo::SHADER_STAGE_TESS_CONTROL,
+											ShaderObjectInfo::SHADER_STAGE_TESS_EVALUATION, ShaderObjectInfo::SHADER_STAGE_GEOMETRY,
+											ShaderObjectInfo::SHADER_STAGE_FRAGMENT	};
+		if(computeSupported)
+			stageList.push_back(ShaderObjectInfo::SHADER_STAGE_COMPUTE);
+		for(const auto stage : stageList) {
+			GLint numLocations = 0;
+			glGetProgramStageiv(program, stage, GL_ACTIVE_SUBROUTINE_UNIFORM_LOCATIONS, &numLocations);
+			if(numLocations <= 0)
+				continue;
+			stages.push_back({stage, static_cast<uint32_t>(numLocations)});
+
+			GLint count = 0;
+			GLint maxLength = 0;
+			glGetProgramStageiv(program, stage, GL_ACTIVE_SUBROUTINES, &count);
+			glGetProgramStageiv(program, stage, GL_ACTIVE_SUBROUTINE_MAX_LENGTH, &maxLength);
+			std::vector<GLchar> buffer(static_cast<std::size_t>(std::max(maxLength, 1)));
+			for(GLint i = 0; i < count; ++i) {
+				GLsizei length = 0;
+				glGetActiveSubroutineName(program, stage, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()), &length, buffer.data());
+				SubroutineInfo info;
+				info.stage = stage;
+				info.name.assign(buffer.data(), static_cast<std::size_t>(length));
+				info.index = static_cast<uint32_t>(i);
+				subroutines.emplace_back(std::move(info));
+			}
+		}
+	}
+#endif
+	GET_GL_ERROR();
+}
+
+int32_t ShaderReflection::getSubroutineIndex(uint32_t stage, const std::string & name) const {
+	for(const auto & info : subroutines) {
+		if(info.stage == stage && info.name == name)
+			return static_cast<int32_t>(info.index);
+	}
+	return -1;
+}
+
+uint32_t ShaderReflection::getNumSubroutineUniformLocations(uint32_t stage) const {
+	for(const auto & info : stages) {
+		if(info.stage == stage)
+			return info.numSubroutineUniformLocations;
+	}
+	return 0;
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_SHADER_SHADERREFLECTION_H
+#define RENDERING_SHADER_SHADERREFLECTION_H
+
+#include <Util/StringIdentifier.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Rendering {
+
+/**
+ * Reflection data of a linked shader program: active uniforms, uniform blocks,
+ * vertex attributes and subroutines. The data is gathered once after linking
+ * (see Shader::initLinkedProgram()) and stored in flat tables, so that later
+ * lookups do not have to query the GL.
+ */
+struct ShaderReflection {
+	struct UniformInfo {
+		std::string name;			//!< name without array index
+		uint32_t glType;
+		uint32_t arraySize;
+		int32_t blockIndex;			//!< -1 for uniforms of the default block
+		uint32_t firstLocation;		//!< index into elementLocations (default block only); the elements of an array are stored consecutively
+	};
+	struct BlockInfo {
+		std::string name;
+		uint32_t index;
+		uint32_t dataSize;
+		uint32_t numUniforms;
+	};
+	struct AttributeInfo {
+		Util::StringIdentifier name;
+		uint32_t glType;
+		uint32_t arraySize;
+		int32_t location;
+	};
+	struct SubroutineInfo {
+		uint32_t stage;
+		std::string name;
+		uint32_t index;
+	};
+	struct StageInfo {
+		uint32_t stage;
+		uint32_t numSubroutineUniformLocations;	//!< number of indices expected by glUniformSubroutinesuiv
+	};
+
+	std::vector<UniformInfo> uniforms;
+	std::vector<int32_t> elementLocations;	//!< locations of all array elements of the default block uniforms
+	std::vector<BlockInfo> blocks;
+	std::vector<AttributeInfo> attributes;	//!< without built-in attributes (gl_...)
+	std::vector<SubroutineInfo> subroutines;
+	std::vector<StageInfo> stages;			//!< only stages declaring subroutine uniforms
+	std::array<uint32_t, 3> workGroupSize;	//!< local size of a compute program; (0,0,0) for other programs
+
+	ShaderReflection() : workGroupSize({{0, 0, 0}}) {}
+
+	void clear();
+
+	//! Query all tables from the given linked program. The work group size is only queried for compute programs.
+	void gather(uint32_t program, bool computeProgram);
+
+	//! \return the subroutine index or -1 if the stage has no active subroutine with that name.
+	int32_t getSubroutineIndex(uint32_t stage, const std::string & name) const;
+
+	//! \return the number of subroutine uniform locations of the given stage (0 if the stage uses no subroutines).
+	uint32_t getNumSubroutineUniformLocations(uint32_t stage) const;
+};
+
+}
+
+#endif // RENDERING_SHADER_SHADERREFLECTION_H
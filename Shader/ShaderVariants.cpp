@@ -0,0 +1,69 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ShaderVariants.h"
+#include <stdexcept>
+
+namespace Rendering {
+
+ShaderVariants::ShaderVariants(Shader::flag_t _usage) : ReferenceCounter_t(), usage(_usage) {
+}
+
+void ShaderVariants::attachShaderObject(ShaderObjectInfo obj) {
+	shaderObjects.emplace_back(std::move(obj));
+}
+
+ShaderVariants::mask_t ShaderVariants::addFeature(const std::string & define, const std::string & value) {
+	const mask_t existing = getFeature(define);
+	if(existing != 0)
+		return existing;
+	if(features.size() >= MAX_FEATURES)
+		throw std::invalid_argument("ShaderVariants::addFeature: Too many features.");
+	features.emplace_back(define, value);
+	return static_cast<mask_t>(1) << (features.size() - 1);
+}
+
+ShaderVariants::mask_t ShaderVariants::getFeature(const std::string & define) const {
+	for(size_t i = 0; i < features.size(); ++i) {
+		if(features[i].first == define)
+			return static_cast<mask_t>(1) << i;
+	}
+	return 0;
+}
+
+Shader * ShaderVariants::getShader(mask_t featureMask) {
+	auto it = variants.find(featureMask);
+	if(it != variants.end())
+		return it->second.get();
+
+	Util::Reference<Shader> shader = Shader::createShader(usage);
+	for(const auto & baseObject : shaderObjects) {
+		ShaderObjectInfo obj(baseObject);
+		for(size_t i = 0; i < features.size(); ++i) {
+			if((featureMask & (static_cast<mask_t>(1) << i)) != 0)
+				obj.addDefine(features[i].first, features[i].second);
+		}
+		shader->attachShaderObject(std::move(obj));
+	}
+	variants.emplace(featureMask, shader);
+	return shader.get();
+}
+
+void ShaderVariants::warmUp(const std::vector<mask_t> & featureMasks, bool async) {
+	for(const auto featureMask : featureMasks) {
+		Shader * shader = getShader(featureMask);
+		if(async)
+			shader->initAsync();
+		else
+			shader->init();
+	}
+}
+
+}
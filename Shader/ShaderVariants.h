@@ -0,0 +1,84 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_SHADERVARIANTS_H_
+#define RENDERING_SHADERVARIANTS_H_
+
+#include "Shader.h"
+#include "ShaderObjectInfo.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Rendering {
+
+/*! Set of shader variants that are created from the same shader objects and differ only in their defines.
+	Each feature (e.g. skinning, fog, shadows) corresponds to a define and is identified by one bit
+	of a feature mask. The Shader of a variant is created when it is requested for the first time;
+	every define of the variant's feature mask is added to all shader objects.
+	\note If a program binary cache is set (Shader::setProgramBinaryCacheDirectory), every variant
+		is cached separately, as the defines are part of the cache key.
+	\code
+		Util::Reference<ShaderVariants> variants = new ShaderVariants;
+		variants->attachShaderObject(ShaderObjectInfo::loadVertex(vsFile));
+		variants->attachShaderObject(ShaderObjectInfo::loadFragment(fsFile));
+		const ShaderVariants::mask_t skinning = variants->addFeature("SKINNING");
+		const ShaderVariants::mask_t fog = variants->addFeature("FOG");
+		...
+		context.pushAndSetShader(variants->getShader(skinning | fog));
+	\endcode	*/
+class ShaderVariants : public Util::ReferenceCounter<ShaderVariants> {
+	public:
+		typedef uint32_t mask_t;
+		static const uint32_t MAX_FEATURES = 32;
+
+		explicit ShaderVariants(Shader::flag_t usage = Shader::USE_GL|Shader::USE_UNIFORMS);
+
+		/*! Add a shader object that is part of every variant.
+			\note Variants that have already been created are not changed; call clear() to recreate them.	*/
+		void attachShaderObject(ShaderObjectInfo obj);
+
+		/*! Register a feature that is enabled by defining @p define (with the optional @p value).
+			\return the feature's bit of the feature mask
+			\throw std::invalid_argument if MAX_FEATURES features have been registered already.	*/
+		mask_t addFeature(const std::string & define, const std::string & value = "");
+
+		//! Return the mask of the feature with the given define, or 0 if it is unknown.
+		mask_t getFeature(const std::string & define) const;
+		uint32_t getNumFeatures() const							{	return static_cast<uint32_t>(features.size());	}
+
+		/*! Return the shader of the variant with the given features. The shader is created, but not compiled, if
+			it has not been requested before; it is compiled when it is enabled for the first time.	*/
+		Shader * getShader(mask_t features);
+
+		/*! Create and compile the variants with the given feature masks in advance (e.g. while a loading screen is shown).
+			@param async If true, the shaders are compiled asynchronously (see Shader::initAsync()).	*/
+		void warmUp(const std::vector<mask_t> & featureMasks, bool async = true);
+
+		//! Number of variants that have been created.
+		size_t getNumVariants() const							{	return variants.size();	}
+
+		//! Release all created variants.
+		void clear()											{	variants.clear();	}
+
+	private:
+		Shader::flag_t usage;
+		std::vector<ShaderObjectInfo> shaderObjects;
+		std::vector<std::pair<std::string, std::string>> features; //!< define and value; the index is the feature's bit
+		std::unordered_map<mask_t, Util::Reference<Shader>> variants;
+};
+
+}
+
+#endif /* RENDERING_SHADERVARIANTS_H_ */
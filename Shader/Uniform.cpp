@@ -52,7 +52,7 @@ Uniform::Uniform(UniformName _name, dataType_t _type, size_t _numValues) :
 
 //! (ctor)
 Uniform::Uniform(UniformName _name, dataType_t _type, size_t _numValues,std::vector<uint8_t> _data) :
-		name(std::move(_name)), type(_type), numValues(_numValues), data(std::move(_data)){
+		name(std::move(_name)), type(_type), numValues(_numValues), data(_data){
 	if(data.size()!=_numValues * getValueSize(type))
 		INVALID_ARGUMENT_EXCEPTION("data is of wrong size");
 }
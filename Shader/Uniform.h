@@ -14,8 +14,10 @@
 #include <Util/StringIdentifier.h>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <deque>
 #include <string>
+#include <utility>
 #include <vector>
 
 // Forward declarations
@@ -169,10 +171,81 @@ class Uniform {
 		bool isNull()const							{	return name == Util::StringIdentifier();	}
 
 	private:
+		/*! (internal) Byte storage of the values. Up to INLINE_SIZE bytes (e.g. a single 4x4 matrix) are stored
+			inside the object itself; only larger arrays need a heap allocation.	*/
+		class ValueStorage {
+				static const size_t INLINE_SIZE = 64;
+				alignas(16) uint8_t inlineData[INLINE_SIZE];
+				uint8_t * ptr;
+				size_t count;
+
+				void allocate(size_t n) {
+					count = n;
+					ptr = n > INLINE_SIZE ? new uint8_t[n] : inlineData;
+				}
+				void release() {
+					if(ptr != inlineData)
+						delete [] ptr;
+					ptr = inlineData;
+					count = 0;
+				}
+			public:
+				ValueStorage() : ptr(inlineData), count(0) {}
+				explicit ValueStorage(size_t n) : ValueStorage() {
+					allocate(n);
+					std::memset(ptr, 0, n);
+				}
+				ValueStorage(const uint8_t * first, const uint8_t * last) : ValueStorage() {
+					allocate(static_cast<size_t>(last - first));
+					std::memcpy(ptr, first, count);
+				}
+				explicit ValueStorage(const std::vector<uint8_t> & v) : ValueStorage(v.data(), v.data() + v.size()) {}
+				ValueStorage(const ValueStorage & other) : ValueStorage(other.ptr, other.ptr + other.count) {}
+				ValueStorage(ValueStorage && other) : ValueStorage() {
+					*this = std::move(other);
+				}
+				~ValueStorage()								{	release();	}
+
+				ValueStorage & operator=(const ValueStorage & other) {
+					if(this != &other) {
+						if(count != other.count) {
+							release();
+							allocate(other.count);
+						}
+						std::memcpy(ptr, other.ptr, count);
+					}
+					return *this;
+				}
+				ValueStorage & operator=(ValueStorage && other) {
+					if(this == &other)
+						return *this;
+					release();
+					if(other.ptr != other.inlineData) { // take the heap allocation
+						ptr = other.ptr;
+						count = other.count;
+						other.ptr = other.inlineData;
+						other.count = 0;
+					} else {
+						allocate(other.count);
+						std::memcpy(ptr, other.ptr, count);
+					}
+					return *this;
+				}
+				bool operator==(const ValueStorage & other) const {
+					return count == other.count && std::memcmp(ptr, other.ptr, count) == 0;
+				}
+
+				const uint8_t * data() const				{	return ptr;	}
+				uint8_t * data()							{	return ptr;	}
+				size_t size() const							{	return count;	}
+		};
+
 		UniformName name;
 		dataType_t type;
 		size_t numValues;
-		std::vector<uint8_t> data;
+		ValueStorage data;
+
+		friend class UniformRegistry;
 };
 }
 
@@ -10,65 +10,118 @@
 */
 #include "UniformRegistry.h"
 #include <Util/Macros.h>
+#include <algorithm>
+#include <cstring>
 
 namespace Rendering {
 
 //! (static)
 UniformRegistry::step_t UniformRegistry::globalUniformUpdateCounter(1); // start with 1 to make sure 0 means 'never' (and not 'initially')
 
+const uint32_t UniformRegistry::EMPTY_SLOT;
+
 //! (ctor)
 UniformRegistry::UniformRegistry() : stepOfLastApply(0),stepOfLastGlobalSync(0){
 }
 
 //! (dtor)
-UniformRegistry::~UniformRegistry(){
-	clear();
-}
+UniformRegistry::~UniformRegistry() = default;
 
 
 void UniformRegistry::clear(){
-	for(auto & entry : uniforms) {
-		delete entry.second;
-	}
-	uniforms.clear();
-	orderedList.clear();
+	entries.clear();
+	slotTable.clear();
+	changeLog.clear();
 	resetCounters();
 }
 
-void UniformRegistry::performGlobalSync(const UniformRegistry & globalUniforms, bool forced){
-	if(forced){
-		// set all global uniforms
-		for(auto it=globalUniforms.orderedList.begin();	it!=globalUniforms.orderedList.end() && (*it)->stepOfLastSet>stepOfLastGlobalSync; ++it )
-			setUniform( (*it)->uniform,false,true);
-	}else {
-		// set all uniforms of the globalUniforms-Set that have been changed since the last call.
-		for(auto it=globalUniforms.orderedList.begin();	it!=globalUniforms.orderedList.end() && (*it)->stepOfLastSet>stepOfLastGlobalSync; ++it )
-			setUniform( (*it)->uniform,false,false);
+//! (internal)
+uint32_t UniformRegistry::createEntry(const Uniform & uniform, bool warnIfUnused, step_t step){
+	const uint32_t slot = static_cast<uint32_t>(entries.size());
+	entries.emplace_back(uniform, warnIfUnused, step);
+
+	// keep the load factor of the table below 1/2
+	if(entries.size() * 2 > slotTable.size()){
+		slotTable.assign(std::max<size_t>(16, slotTable.size() * 2), EMPTY_SLOT);
+		const size_t mask = slotTable.size() - 1;
+		for(uint32_t s = 0; s < entries.size(); ++s){
+			size_t i = std::hash<Util::StringIdentifier>()(entries[s].uniform.getNameId()) & mask;
+			while(slotTable[i] != EMPTY_SLOT)
+				i = (i + 1) & mask;
+			slotTable[i] = s;
+		}
+	} else {
+		const size_t mask = slotTable.size() - 1;
+		size_t i = std::hash<Util::StringIdentifier>()(uniform.getNameId()) & mask;
+		while(slotTable[i] != EMPTY_SLOT)
+			i = (i + 1) & mask;
+		slotTable[i] = slot;
 	}
+	return slot;
+}
+
+//! (internal)
+void UniformRegistry::logChange(uint32_t slot, step_t step){
+	changeLog.emplace_back(step, slot);
+	if(changeLog.size() > entries.size() * 2 + 64){ // remove the outdated changes
+		changeLog.clear();
+		for(uint32_t s = 0; s < entries.size(); ++s)
+			changeLog.emplace_back(entries[s].stepOfLastSet, s);
+		std::sort(changeLog.begin(), changeLog.end(), [](const change_t & a, const change_t & b) { return a.step < b.step; });
+	}
+}
+
+void UniformRegistry::performGlobalSync(const UniformRegistry & globalUniforms, bool forced){
+	// set all uniforms of the globalUniforms-Set that have been changed since the last call.
+	forEachEntrySetAfter(globalUniforms, stepOfLastGlobalSync, false, [this, forced](const entry_t & entry) {
+		setUniform(entry.uniform, false, forced);
+	});
 	stepOfLastGlobalSync = getNewGlobalStep();
 }
 
 void UniformRegistry::setUniform(const Uniform & uniform, bool warnIfUnused, bool forced){
-	entry_t * & entry = uniforms[uniform.getNameId()];
+	const uint32_t slot = findSlot(uniform.getNameId());
 
-	if(entry==nullptr){ // new entry
-		entry = new entry_t( uniform,warnIfUnused,getNewGlobalStep() );
-		orderedList.push_front(entry);
-		entry->positionInUpdateList=orderedList.begin();
-	} // if an entry exists and appliance is forced or (uniform is valid and value has changed)
-	else if( forced || (entry->valid && !(uniform==entry->uniform)) ){
+	if(slot == EMPTY_SLOT){ // new entry
+		const step_t step = getNewGlobalStep();
+		logChange(createEntry(uniform, warnIfUnused, step), step);
+		return;
+	}
+	entry_t & entry = entries[slot];
+	// if an entry exists and appliance is forced or (uniform is valid and value has changed)
+	if( forced || (entry.valid && !(uniform==entry.uniform)) ){
 
 		//! \note This warning should do no harm - otherwise remove it.
-		if(entry->uniform.getType()!=uniform.getType() ){
-			WARN("Type of Uniform changed; this may be a problem. "+entry->uniform.toString()+" -> "+uniform.toString());
+		if(entry.uniform.getType()!=uniform.getType() ){
+			WARN("Type of Uniform changed; this may be a problem. "+entry.uniform.toString()+" -> "+uniform.toString());
 		}
-		// move entry to the front of the orderedList
-		orderedList.erase(entry->positionInUpdateList);
-		orderedList.push_front(entry);
-
-		entry->reset(uniform,getNewGlobalStep(),warnIfUnused,orderedList.begin());
+		const step_t step = getNewGlobalStep();
+		entry.reset(uniform,step,warnIfUnused);
+		logChange(slot, step);
 	}
 	// else: if the value of an uniform has not changed or the uniform could not be set (= invalid), nothing needs to be done.
 }
 
+//! (internal)
+bool UniformRegistry::setUniformData(uint32_t slot, const void * data, size_t numBytes, bool forced){
+	entry_t & entry = entries[slot];
+	if(!entry.valid || entry.uniform.data.size() != numBytes)
+		return false;
+	if(!forced && std::memcmp(entry.uniform.data.data(), data, numBytes) == 0)
+		return false;
+	std::memcpy(entry.uniform.data.data(), data, numBytes);
+	const step_t step = getNewGlobalStep();
+	entry.stepOfLastSet = step;
+	logChange(slot, step);
+	return true;
+}
+
+void UniformRegistry::collectUniforms(std::vector<Uniform> & result, step_t afterStep) const {
+	for(auto it = changeLog.rbegin(); it != changeLog.rend() && it->step > afterStep; ++it) {
+		const entry_t & entry = entries[it->slot];
+		if(entry.stepOfLastSet == it->step && entry.valid)
+			result.push_back(entry.uniform);
+	}
+}
+
 }
@@ -13,33 +13,25 @@
 
 #include "Uniform.h"
 #include <Util/StringIdentifier.h>
+#include <algorithm>
 #include <cstdint>
-#include <list>
-#include <unordered_map>
+#include <functional>
+#include <vector>
 
 namespace Rendering {
 class Shader;
 
 
 /*! (internal) Collection of Uniforms. Objects of this class are internally used by Shaders to track their Uniforms and
-	by the RenderingContext, which has one instance for managing global uniforms. */
+	by the RenderingContext, which has one instance for managing global uniforms.
+	The entries are stored contiguously and are addressed by a dense slot index; names are mapped to slots by a small
+	open-addressing hash table. Changes are recorded in a log ordered by their step, so that the uniforms changed
+	since a given step can be found without traversing all entries. */
 class UniformRegistry {
-	private:
-		struct entry_t;
-
+	public:
 		typedef uint64_t step_t;
-		typedef std::list<entry_t *> orderedEntries_t;
-		typedef std::unordered_map<Util::StringIdentifier,entry_t *> uniformRegistry_t;
-
-		static step_t globalUniformUpdateCounter;
-		static step_t getNewGlobalStep(){	return ++globalUniformUpdateCounter;	}
-
-		step_t stepOfLastApply; // =0
-		step_t stepOfLastGlobalSync; // =0
-
-		uniformRegistry_t uniforms; // collection of all known uniform-entries
-		orderedEntries_t orderedList; // ordered list of all entries (when an entry is updated, it is moved to the front)
 
+	private:
 		struct entry_t{
 			Uniform uniform;
 			bool valid;
@@ -47,22 +39,73 @@ class UniformRegistry {
 			step_t stepOfLastSet;
 			int32_t location;
 
-			orderedEntries_t::iterator positionInUpdateList;
-
 			//! (ctor)
 			entry_t(Uniform u,bool _warn,step_t step) : uniform(std::move(u)),valid(true),warnIfUnused(_warn),stepOfLastSet(step),location(-1) {}
-			void reset(const Uniform & u,step_t step,bool warn,const orderedEntries_t::iterator & it) {
+			void reset(const Uniform & u,step_t step,bool warn) {
 				uniform = u;
 				valid = true;
 				warnIfUnused = warn;
 				stepOfLastSet = step;
-				positionInUpdateList = it;
 			}
 		};
+		struct change_t{
+			step_t step;
+			uint32_t slot;
+			change_t(step_t _step, uint32_t _slot) : step(_step), slot(_slot) {}
+		};
+
+		static step_t globalUniformUpdateCounter;
+		static step_t getNewGlobalStep(){	return ++globalUniformUpdateCounter;	}
+
+		static const uint32_t EMPTY_SLOT = 0xffffffff;
+
+		step_t stepOfLastApply; // =0
+		step_t stepOfLastGlobalSync; // =0
+
+		std::vector<entry_t> entries; // all known uniform-entries; the index is the entry's slot
+		std::vector<uint32_t> slotTable; // open-addressing hash table (size is a power of two): name -> slot
+		std::vector<change_t> changeLog; // (step, slot) of all changes in ascending order; outdated changes are skipped
+
+		uint32_t findSlot(const Util::StringIdentifier & nameId) const {
+			if(slotTable.empty())
+				return EMPTY_SLOT;
+			const size_t mask = slotTable.size() - 1;
+			for(size_t i = std::hash<Util::StringIdentifier>()(nameId) & mask; ; i = (i + 1) & mask) {
+				const uint32_t slot = slotTable[i];
+				if(slot == EMPTY_SLOT || entries[slot].uniform.getNameId() == nameId)
+					return slot;
+			}
+		}
+		const entry_t * getEntry(const Util::StringIdentifier & nameId) const {
+			const uint32_t slot = findSlot(nameId);
+			return slot == EMPTY_SLOT ? nullptr : &entries[slot];
+		}
 
-		entry_t * getEntry(const Util::StringIdentifier nameId){
-			const uniformRegistry_t::const_iterator it(uniforms.find(nameId));
-			return it==uniforms.end() ? nullptr : it->second;
+		//! (internal) Create a new entry and register it in the slot table.
+		uint32_t createEntry(const Uniform & uniform, bool warnIfUnused, step_t step);
+		//! (internal) Record a change of the given slot; compact the log if it contains too many outdated changes.
+		void logChange(uint32_t slot, step_t step);
+
+		/*! (internal) Overwrite the values of the (valid) uniform in the given slot in place.
+			@return false if the size does not match or the values have not changed (and @p forced is false).	*/
+		bool setUniformData(uint32_t slot, const void * data, size_t numBytes, bool forced);
+
+		/*! (internal) Call @p fun for each entry of @p registry that has been set after @p step, the oldest change first.
+			If @p all is true, all entries are visited.	*/
+		template<typename Registry_t, typename Fun_t>
+		static void forEachEntrySetAfter(Registry_t & registry, step_t step, bool all, Fun_t fun) {
+			if(all) {
+				for(auto & entry : registry.entries)
+					fun(entry);
+				return;
+			}
+			auto it = std::upper_bound(registry.changeLog.begin(), registry.changeLog.end(), step,
+										[](step_t s, const change_t & change) { return s < change.step; });
+			for(; it != registry.changeLog.end(); ++it) {
+				auto & entry = registry.entries[it->slot];
+				if(entry.stepOfLastSet == it->step) // skip outdated changes
+					fun(entry);
+			}
 		}
 
 		friend class Shader;
@@ -80,21 +123,28 @@ class UniformRegistry {
 		void resetCounters()	{	stepOfLastApply=stepOfLastGlobalSync=0;	}
 
 		const Uniform & getUniform(const Util::StringIdentifier nameId)const{
-			const uniformRegistry_t::const_iterator it(uniforms.find(nameId));
-			return (it == uniforms.end() || !it->second->valid) ? Uniform::nullUniform : // no entry or invalid entry --> return nullUniform
-				it->second->uniform;
+			const entry_t * entry = getEntry(nameId);
+			return (entry == nullptr || !entry->valid) ? Uniform::nullUniform : // no entry or invalid entry --> return nullUniform
+				entry->uniform;
 		}
 
 		//! returns true if a uniform with the given name has already been set, but the appliance failed.
 		bool isInvalid(const Util::StringIdentifier nameId)const {
-			const uniformRegistry_t::const_iterator it(uniforms.find(nameId));
-			return it == uniforms.end() ? false : !it->second->valid;
+			const entry_t * entry = getEntry(nameId);
+			return entry == nullptr ? false : !entry->valid;
 		}
 
 		//! Transfer all uniforms that have been changed in the globalUniforms since the last stepOfLastGlobalSync
 		void performGlobalSync(const UniformRegistry & globalUniforms, bool forced);
 
 		void setUniform(const Uniform & uniform, bool warnIfUnused=false, bool forced=false);
+
+		//! Return the step of the latest change of any uniform registry; all following changes have a larger step.
+		static step_t getCurrentGlobalStep()	{	return globalUniformUpdateCounter;	}
+
+		/*! Append all valid uniforms that have been set after the given step to @p result (the most recently set first).
+			\note With the default step, all valid uniforms are collected.	*/
+		void collectUniforms(std::vector<Uniform> & result, step_t afterStep = 0) const;
 };
 
 }
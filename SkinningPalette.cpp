@@ -0,0 +1,129 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "SkinningPalette.h"
+#include "RenderingContext/RenderingContext.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Geometry/Matrix4x4.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace Rendering {
+
+static const char * const shaderInterface =
+R"***(
+layout(std430, binding = 7) readonly buffer sg_SkinningPalette { mat4 sg_jointMatrices[]; };
+in uvec4 sg_Joints;
+in vec4 sg_Weights;
+
+//! Weighted sum of the joint matrices of the current vertex.
+mat4 sg_getSkinningMatrix() {
+	return sg_Weights.x * sg_jointMatrices[sg_Joints.x] + sg_Weights.y * sg_jointMatrices[sg_Joints.y] +
+			sg_Weights.z * sg_jointMatrices[sg_Joints.z] + sg_Weights.w * sg_jointMatrices[sg_Joints.w];
+}
+
+//! Transform the position and the normal of the current vertex from the bind pose into the current pose.
+void sg_skinVertex(inout vec3 position, inout vec3 normal) {
+	const mat4 skinning = sg_getSkinningMatrix();
+	position = (skinning * vec4(position, 1.0)).xyz;
+	normal = normalize(mat3(skinning) * normal);
+}
+)***";
+
+static const float identity[16] = {	1.0f, 0.0f, 0.0f, 0.0f,
+									0.0f, 1.0f, 0.0f, 0.0f,
+									0.0f, 0.0f, 1.0f, 0.0f,
+									0.0f, 0.0f, 0.0f, 1.0f	};
+
+//! (static)
+bool SkinningPalette::isSupported() {
+#if defined(LIB_GL) && defined(GL_ARB_shader_storage_buffer_object)
+	static const bool support = isExtensionSupported("GL_ARB_shader_storage_buffer_object");
+	return support;
+#else
+	return false;
+#endif
+}
+
+//! (static)
+const char * SkinningPalette::getShaderInterface() {
+	return shaderInterface;
+}
+
+SkinningPalette::SkinningPalette(uint32_t jointCount) : ReferenceCounter_t(), matricesChanged(true) {
+	setJointCount(jointCount);
+}
+
+SkinningPalette::~SkinningPalette() = default;
+
+void SkinningPalette::setJointCount(uint32_t jointCount) {
+	const uint32_t oldCount = getJointCount();
+	matrixData.resize(static_cast<std::size_t>(jointCount) * 16);
+	for(uint32_t i = oldCount; i < jointCount; ++i)
+		std::copy(identity, identity + 16, matrixData.begin() + static_cast<std::ptrdiff_t>(i) * 16);
+	matricesChanged = true;
+}
+
+Geometry::Matrix4x4 SkinningPalette::getJointMatrix(uint32_t index) const {
+	if(index >= getJointCount())
+		throw std::out_of_range("SkinningPalette::getJointMatrix: Invalid index.");
+	return Geometry::Matrix4x4(matrixData.data() + index * 16).getTransposed();
+}
+
+void SkinningPalette::setJointMatrix(uint32_t index, const Geometry::Matrix4x4 & matrix) {
+	if(index >= getJointCount())
+		throw std::out_of_range("SkinningPalette::setJointMatrix: Invalid index.");
+	const Geometry::Matrix4x4 transposed = matrix.getTransposed();
+	std::copy(transposed.getData(), transposed.getData() + 16, matrixData.begin() + static_cast<std::ptrdiff_t>(index) * 16);
+	matricesChanged = true;
+}
+
+void SkinningPalette::setJointMatrices(const std::vector<Geometry::Matrix4x4> & matrices) {
+	matrixData.resize(matrices.size() * 16);
+	for(uint32_t i = 0; i < matrices.size(); ++i)
+		setJointMatrix(i, matrices[i]);
+	matricesChanged = true;
+}
+
+void SkinningPalette::bind(RenderingContext & /*context*/) {
+#if defined(LIB_GL) && defined(GL_ARB_shader_storage_buffer_object)
+	if(!isSupported()) {
+		WARN("SkinningPalette::bind: Shader storage buffers are not supported.");
+		return;
+	}
+	if(matricesChanged || !paletteBuffer.isValid()) {
+		if(matrixData.empty())
+			paletteBuffer.uploadData(BufferObject::TARGET_SHADER_STORAGE_BUFFER, std::vector<float>(identity, identity + 16), BufferObject::USAGE_DYNAMIC_DRAW);
+		else
+			paletteBuffer.uploadData(BufferObject::TARGET_SHADER_STORAGE_BUFFER, matrixData, BufferObject::USAGE_DYNAMIC_DRAW);
+		matricesChanged = false;
+	}
+	paletteBuffer.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, PALETTE_BINDING);
+	GET_GL_ERROR();
+#else
+	WARN("SkinningPalette::bind: Shader storage buffers are not supported.");
+#endif
+}
+
+void SkinningPalette::unbind(RenderingContext & /*context*/) {
+	if(!paletteBuffer.isValid())
+		return;
+	paletteBuffer.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, PALETTE_BINDING);
+}
+
+void SkinningPalette::display(RenderingContext & context, Mesh * mesh) {
+	bind(context);
+	context.displayMesh(mesh);
+	unbind(context);
+}
+
+}
@@ -0,0 +1,92 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_SKINNINGPALETTE_H_
+#define RENDERING_SKINNINGPALETTE_H_
+
+#include "BufferObject.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <vector>
+
+namespace Geometry {
+template<typename _T> class _Matrix4x4;
+typedef _Matrix4x4<float> Matrix4x4;
+}
+
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+
+/**
+ * Joint matrix palette for skinning meshes in the vertex shader.
+ *
+ * A skinned mesh stores up to four joint indices (VertexAttributeIds::JOINTS, see
+ * VertexDescription::appendJointIndices()) and the corresponding weights (VertexAttributeIds::WEIGHTS, see
+ * VertexDescription::appendJointWeights()) per vertex. The palette contains one matrix per joint, which transforms
+ * a vertex from the bind pose into the current pose (i.e. the joint's transformation multiplied by its inverse
+ * bind matrix). The matrices are stored in a shader storage buffer (std430 array of mat4) that bind() binds to
+ * PALETTE_BINDING. A vertex shader includes the interface returned by getShaderInterface():
+ * \code
+ * // vertex shader
+ * #version 430
+ * // ... getShaderInterface() ...
+ * void main() {
+ *	vec3 position = sg_Position;
+ *	vec3 normal = sg_Normal;
+ *	sg_skinVertex(position, normal);
+ *	// ...
+ * }
+ * \endcode
+ * The changed matrices are uploaded by the next call of bind() (or display()).
+ *
+ * @note Requires OpenGL 4.3 (shader storage buffers).
+ */
+class SkinningPalette : public Util::ReferenceCounter<SkinningPalette> {
+	public:
+		static const uint32_t PALETTE_BINDING = 7;
+
+		static bool isSupported();
+
+		//! GLSL declarations (buffer, attributes and skinning functions) to be included into a vertex shader.
+		static const char * getShaderInterface();
+
+		//! Create a palette with the given number of joints; all matrices are identity matrices.
+		explicit SkinningPalette(uint32_t jointCount = 0);
+		~SkinningPalette();
+
+		uint32_t getJointCount() const						{	return static_cast<uint32_t>(matrixData.size() / 16);	}
+		//! Change the number of joints; new matrices are identity matrices.
+		void setJointCount(uint32_t jointCount);
+
+		//! @throw std::out_of_range if @p index is invalid.
+		Geometry::Matrix4x4 getJointMatrix(uint32_t index) const;
+		//! @throw std::out_of_range if @p index is invalid.
+		void setJointMatrix(uint32_t index, const Geometry::Matrix4x4 & matrix);
+		//! Replace all matrices; the number of joints is set to the number of matrices.
+		void setJointMatrices(const std::vector<Geometry::Matrix4x4> & matrices);
+
+		//! Upload the changed matrices and bind the palette for drawing skinned meshes.
+		void bind(RenderingContext & context);
+		void unbind(RenderingContext & context);
+
+		//! Draw a skinned mesh with this palette (bind(), RenderingContext::displayMesh(), unbind()).
+		void display(RenderingContext & context, Mesh * mesh);
+
+	private:
+		std::vector<float> matrixData; // column-major, as expected by std430
+		bool matricesChanged;
+		BufferObject paletteBuffer;
+};
+
+}
+
+#endif /* RENDERING_SKINNINGPALETTE_H_ */
@@ -0,0 +1,141 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "StreamingBuffer.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Util/Macros.h>
+#include <cstring>
+#include <stdexcept>
+
+namespace Rendering {
+
+#if defined(LIB_GL) && defined(GL_ARB_buffer_storage) && defined(GL_ARB_sync)
+#define STREAMING_BUFFER_AVAILABLE
+#endif
+
+//! (static)
+bool StreamingBuffer::isSupported() {
+#ifdef STREAMING_BUFFER_AVAILABLE
+	static const bool support = isExtensionSupported("GL_ARB_buffer_storage");
+	return support;
+#else
+	return false;
+#endif
+}
+
+StreamingBuffer::StreamingBuffer(size_t _regionSize, uint32_t _numRegions) :
+		bufferObject(), regionSize(_regionSize), numRegions(_numRegions), mappedData(nullptr), fences(_numRegions, nullptr),
+		currentRegion(0), regionOffset(0), frameNumber(0), stallCount(0) {
+	if(regionSize == 0 || numRegions == 0)
+		throw std::invalid_argument("StreamingBuffer: Invalid size.");
+}
+
+StreamingBuffer::~StreamingBuffer() {
+#ifdef STREAMING_BUFFER_AVAILABLE
+	for(auto & fence : fences) {
+		if(fence != nullptr)
+			glDeleteSync(reinterpret_cast<GLsync>(fence));
+	}
+	if(mappedData != nullptr) {
+		bufferObject.bind(GL_COPY_WRITE_BUFFER);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		bufferObject.unbind(GL_COPY_WRITE_BUFFER);
+	}
+#endif
+}
+
+//! (internal)
+bool StreamingBuffer::init() {
+#ifdef STREAMING_BUFFER_AVAILABLE
+	if(!isSupported())
+		return false;
+	const GLsizeiptr size = static_cast<GLsizeiptr>(regionSize * numRegions);
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	bufferObject.prepare();
+	bufferObject.bind(GL_COPY_WRITE_BUFFER);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+	bufferObject.setMemoryCategory(MemoryRegistry::STREAMING_BUFFER);
+	bufferObject._setStorageSize(static_cast<size_t>(size));
+	mappedData = reinterpret_cast<uint8_t *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+	bufferObject.unbind(GL_COPY_WRITE_BUFFER);
+	GET_GL_ERROR();
+	if(mappedData == nullptr) {
+		WARN("StreamingBuffer: Mapping the buffer failed.");
+		bufferObject.destroy();
+		return false;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+StreamingBuffer::Range StreamingBuffer::allocate(size_t numBytes, size_t alignment) {
+	Range range;
+	if(mappedData == nullptr && !init())
+		return range;
+	if(alignment > 1)
+		regionOffset = ((regionOffset + alignment - 1) / alignment) * alignment;
+	if(numBytes == 0 || regionOffset + numBytes > regionSize)
+		return range;
+	range.offset = currentRegion * regionSize + regionOffset;
+	range.data = mappedData + range.offset;
+	range.size = numBytes;
+	range.frameNumber = frameNumber;
+	regionOffset += numBytes;
+	return range;
+}
+
+StreamingBuffer::Range StreamingBuffer::upload(const uint8_t * data, size_t numBytes, size_t alignment) {
+	Range range = allocate(numBytes, alignment);
+	if(range.isValid())
+		std::memcpy(range.data, data, numBytes);
+	return range;
+}
+
+void StreamingBuffer::nextFrame() {
+	++frameNumber;
+	regionOffset = 0;
+#ifdef STREAMING_BUFFER_AVAILABLE
+	if(mappedData == nullptr) {
+		currentRegion = (currentRegion + 1) % numRegions;
+		return;
+	}
+	fences[currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	currentRegion = (currentRegion + 1) % numRegions;
+
+	GLsync fence = reinterpret_cast<GLsync>(fences[currentRegion]);
+	if(fence == nullptr)
+		return;
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if(result == GL_TIMEOUT_EXPIRED) {
+		++stallCount;
+		do {
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+		} while(result == GL_TIMEOUT_EXPIRED);
+	}
+	if(result == GL_WAIT_FAILED)
+		WARN("StreamingBuffer: Waiting for fence failed.");
+	glDeleteSync(fence);
+	fences[currentRegion] = nullptr;
+	GET_GL_ERROR();
+#else
+	currentRegion = (currentRegion + 1) % numRegions;
+#endif
+}
+
+void StreamingBuffer::bindRange(uint32_t bufferTarget, uint32_t location, const Range & range) const {
+#if defined(LIB_GL)
+	glBindBufferRange(bufferTarget, location, bufferObject.getGLId(), static_cast<GLintptr>(range.offset), static_cast<GLsizeiptr>(range.size));
+#endif
+}
+
+}
@@ -0,0 +1,101 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_STREAMINGBUFFER_H_
+#define RENDERING_STREAMINGBUFFER_H_
+
+#include "BufferObject.h"
+#include <Util/ReferenceCounter.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+
+/**
+ * Ring buffer for data that is written by the CPU once per frame (dynamic vertices, uniform blocks, ...).
+ *
+ * The storage is allocated once with @c glBufferStorage and stays persistently and coherently mapped.
+ * It is split into @a numRegions regions of equal size; all allocations of a frame are taken from one region.
+ * nextFrame() guards the region with a fence and advances to the next region, waiting only if the GPU
+ * still reads from it. Therefore, an allocation stays valid for (at least) @a numRegions - 1 following frames.
+ *
+ * @note Requires GL_ARB_buffer_storage. If it is not supported, all allocations fail and the caller
+ *	has to fall back to BufferObject::uploadData.
+ */
+class StreamingBuffer : public Util::ReferenceCounter<StreamingBuffer> {
+	public:
+		//! Part of the buffer returned by allocate(). @a data is @c nullptr if the allocation failed.
+		struct Range {
+			uint8_t * data;
+			size_t offset; //!< Offset in bytes from the beginning of the buffer object
+			size_t size;
+			uint32_t frameNumber;
+
+			Range() : data(nullptr), offset(0), size(0), frameNumber(0) {}
+			bool isValid() const	{	return data != nullptr;	}
+		};
+
+		static bool isSupported();
+
+		/*! The storage (@p regionSize * @p numRegions bytes) is created when the first allocation is requested.
+			@throw std::invalid_argument if one of the parameters is zero.	*/
+		StreamingBuffer(size_t regionSize, uint32_t numRegions = 3);
+		~StreamingBuffer();
+
+		/*! Reserve @p numBytes in the region of the current frame. The returned data pointer may be written to
+			until the region is reused.
+			@param alignment Alignment of the offset (e.g. @c GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for uniform blocks)	*/
+		Range allocate(size_t numBytes, size_t alignment = 16);
+
+		//! Allocate a range and copy the given data into it.
+		Range upload(const uint8_t * data, size_t numBytes, size_t alignment = 16);
+
+		//! @c true iff the data of the given range has not been overwritten yet.
+		bool isRangeValid(const Range & range) const {
+			return range.isValid() && range.frameNumber + numRegions > frameNumber;
+		}
+
+		/*! Finish the current frame: Insert a fence for the current region and continue with the next one.
+			If the GPU has not finished reading the next region, the call blocks.	*/
+		void nextFrame();
+
+		//! Bind the given range to an indexed target (e.g. TARGET_UNIFORM_BUFFER).
+		void bindRange(uint32_t bufferTarget, uint32_t location, const Range & range) const;
+
+		BufferObject & getBufferObject()				{	return bufferObject;	}
+		const BufferObject & getBufferObject() const	{	return bufferObject;	}
+		size_t getRegionSize() const					{	return regionSize;	}
+		uint32_t getNumRegions() const					{	return numRegions;	}
+		uint32_t getFrameNumber() const					{	return frameNumber;	}
+		//! Number of bytes allocated in the current frame.
+		size_t getUsedBytes() const						{	return regionOffset;	}
+		//! Number of calls to nextFrame() that had to wait for the GPU.
+		uint32_t getStallCount() const					{	return stallCount;	}
+
+	private:
+		BufferObject bufferObject;
+		const size_t regionSize;
+		const uint32_t numRegions;
+		uint8_t * mappedData;
+		//! GLsync objects guarding the regions.
+		std::vector<void *> fences;
+		uint32_t currentRegion;
+		size_t regionOffset;
+		uint32_t frameNumber;
+		uint32_t stallCount;
+
+		//! (internal) Create and map the storage. Returns false on failure.
+		bool init();
+};
+
+}
+
+#endif /* RENDERING_STREAMINGBUFFER_H_ */
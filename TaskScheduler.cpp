@@ -0,0 +1,279 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "TaskScheduler.h"
+#include <Util/Macros.h>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Rendering {
+
+//! The scheduler and the index of the worker running on this thread (nullptr / -1 for other threads).
+static thread_local TaskScheduler * currentScheduler = nullptr;
+static thread_local int32_t currentWorker = -1;
+
+static std::mutex globalMutex;
+static std::unique_ptr<TaskScheduler> globalScheduler;
+
+//! (internal)
+static uint32_t getDefaultNumWorkers() {
+	const uint32_t hwThreads = std::thread::hardware_concurrency();
+	return hwThreads > 1 ? hwThreads - 1 : 0;
+}
+
+//! (static)
+TaskScheduler & TaskScheduler::get() {
+	std::lock_guard<std::mutex> lock(globalMutex);
+	if(!globalScheduler)
+		globalScheduler.reset(new TaskScheduler(getDefaultNumWorkers()));
+	return *globalScheduler;
+}
+
+//! (static)
+void TaskScheduler::configure(uint32_t numThreads, std::vector<uint32_t> affinity) {
+	std::lock_guard<std::mutex> lock(globalMutex);
+	globalScheduler.reset(); // joins the old workers
+	globalScheduler.reset(new TaskScheduler(numThreads == 0 ? getDefaultNumWorkers() : numThreads - 1, std::move(affinity)));
+}
+
+TaskScheduler::TaskScheduler(uint32_t numWorkers, std::vector<uint32_t> affinity) :
+		numQueued(0), nextQueue(0), terminate(false), executedTasks(0), stolenTasks(0) {
+	for(uint32_t i = 0; i < numWorkers; ++i)
+		queues.emplace_back(new WorkerQueue);
+	for(uint32_t i = 0; i < numWorkers; ++i) {
+		workers.emplace_back(&TaskScheduler::workerLoop, this, i);
+#if defined(__linux__)
+		if(!affinity.empty()) {
+			cpu_set_t cpuSet;
+			CPU_ZERO(&cpuSet);
+			CPU_SET(affinity[i % affinity.size()], &cpuSet);
+			if(pthread_setaffinity_np(workers.back().native_handle(), sizeof(cpu_set_t), &cpuSet) != 0)
+				WARN("TaskScheduler: Setting the thread affinity failed.");
+		}
+#endif
+	}
+#if !defined(__linux__)
+	if(!affinity.empty())
+		WARN("TaskScheduler: Thread affinity is not supported on this platform.");
+#endif
+}
+
+TaskScheduler::~TaskScheduler() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		terminate = true;
+	}
+	workAvailable.notify_all();
+	for(auto & worker : workers)
+		worker.join();
+}
+
+void TaskScheduler::run(TaskGroup & group, task_t task, const char * name) {
+	++group.pending;
+	Task t{std::move(task), &group, name, -1};
+	if(workers.empty()) {
+		execute(t, -1);
+		return;
+	}
+	const uint32_t queueIndex = (currentScheduler == this) ? static_cast<uint32_t>(currentWorker) : (nextQueue++ % getNumWorkers());
+	t.queue = static_cast<int32_t>(queueIndex);
+	{
+		WorkerQueue & queue = *queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.emplace_back(std::move(t));
+	}
+	++numQueued;
+	{ // taking the lock makes sure that a worker checking numQueued before going to sleep receives the notification
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	workAvailable.notify_one();
+}
+
+void TaskScheduler::wait(TaskGroup & group) {
+	const int32_t worker = (currentScheduler == this) ? currentWorker : -1;
+	while(!group.isDone()) {
+		Task task;
+		if(findTask(worker, task)) {
+			execute(task, worker);
+		} else {
+			// the remaining tasks are running on other threads
+			std::unique_lock<std::mutex> lock(group.mutex);
+			group.finished.wait_for(lock, std::chrono::milliseconds(1), [&group]() { return group.isDone(); });
+		}
+	}
+	std::exception_ptr exception;
+	{
+		std::lock_guard<std::mutex> lock(group.mutex);
+		std::swap(exception, group.exception);
+	}
+	if(exception)
+		std::rethrow_exception(exception);
+}
+
+//! (internal)
+bool TaskScheduler::findTask(int32_t worker, Task & task) {
+	if(numQueued.load() == 0)
+		return false;
+	if(worker >= 0) {
+		WorkerQueue & queue = *queues[static_cast<size_t>(worker)];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if(!queue.tasks.empty()) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			--numQueued;
+			return true;
+		}
+	}
+	const size_t numQueues = queues.size();
+	const size_t first = worker >= 0 ? static_cast<size_t>(worker) + 1 : nextQueue.load();
+	for(size_t i = 0; i < numQueues; ++i) {
+		const size_t victim = (first + i) % numQueues;
+		if(static_cast<int32_t>(victim) == worker)
+			continue;
+		WorkerQueue & queue = *queues[victim];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if(!queue.tasks.empty()) {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			--numQueued;
+			return true;
+		}
+	}
+	return false;
+}
+
+//! (internal)
+void TaskScheduler::execute(Task & task, int32_t worker) {
+	const clock_t::time_point begin = profiler ? clock_t::now() : clock_t::time_point();
+	try {
+		task.function();
+	} catch(...) {
+		std::lock_guard<std::mutex> lock(task.group->mutex);
+		if(!task.group->exception)
+			task.group->exception = std::current_exception();
+	}
+	if(profiler)
+		profiler(TaskProfile{task.name, worker, begin, clock_t::now()});
+	++executedTasks;
+	if(task.queue >= 0 && task.queue != worker)
+		++stolenTasks;
+	task.function = nullptr; // release the captured data before the group is signaled
+
+	TaskGroup & group = *task.group;
+	std::lock_guard<std::mutex> lock(group.mutex);
+	if(--group.pending == 0)
+		group.finished.notify_all();
+}
+
+void TaskScheduler::workerLoop(uint32_t index) {
+	currentScheduler = this;
+	currentWorker = static_cast<int32_t>(index);
+	while(true) {
+		Task task;
+		if(findTask(currentWorker, task)) {
+			execute(task, currentWorker);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		workAvailable.wait(lock, [this]() { return terminate || numQueued.load() > 0; });
+		if(terminate && numQueued.load() == 0)
+			break;
+	}
+	currentScheduler = nullptr;
+	currentWorker = -1;
+}
+
+void TaskScheduler::parallelFor(uint32_t count, const std::function<void (uint32_t, uint32_t)> & fun, uint32_t minChunkSize, const char * name) {
+	if(count == 0)
+		return;
+	// a few chunks per thread allow balancing chunks of different costs
+	const uint32_t maxChunks = getConcurrency() * 4;
+	const uint32_t numChunks = std::max(1u, std::min(maxChunks, count / std::max(1u, minChunkSize)));
+	if(numChunks == 1) {
+		fun(0u, count);
+		return;
+	}
+	const uint32_t chunkSize = (count + numChunks - 1) / numChunks;
+	TaskGroup group;
+	for(uint32_t begin = chunkSize; begin < count; begin += chunkSize) {
+		const uint32_t end = std::min(count, begin + chunkSize);
+		run(group, [&fun, begin, end]() { fun(begin, end); }, name);
+	}
+	// the first chunk is processed by the calling thread
+	try {
+		fun(0u, chunkSize);
+	} catch(...) {
+		wait(group);
+		throw;
+	}
+	wait(group);
+}
+
+void TaskScheduler::run(TaskGraph & graph) {
+	const size_t numNodes = graph.nodes.size();
+	if(numNodes == 0)
+		return;
+	std::unique_ptr<std::atomic<uint32_t>[]> remaining(new std::atomic<uint32_t>[numNodes]);
+	for(size_t i = 0; i < numNodes; ++i)
+		remaining[i].store(graph.nodes[i].numDependencies);
+
+	TaskGroup group;
+	std::function<void (TaskGraph::node_t)> launch;
+	launch = [&](TaskGraph::node_t nodeId) {
+		run(group, [&, nodeId]() {
+			const TaskGraph::Node & node = graph.nodes[nodeId];
+			node.task();
+			for(const auto successor : node.successors) {
+				if(--remaining[successor] == 0)
+					launch(successor);
+			}
+		}, graph.nodes[nodeId].name);
+	};
+	bool started = false;
+	for(size_t i = 0; i < numNodes; ++i) {
+		if(graph.nodes[i].numDependencies == 0) {
+			launch(static_cast<TaskGraph::node_t>(i));
+			started = true;
+		}
+	}
+	if(!started)
+		throw std::invalid_argument("TaskScheduler::run: The task graph contains a cycle.");
+	wait(group);
+}
+
+TaskScheduler::Statistics TaskScheduler::getStatistics() const {
+	return Statistics{executedTasks.load(), stolenTasks.load()};
+}
+
+void TaskScheduler::resetStatistics() {
+	executedTasks = 0;
+	stolenTasks = 0;
+}
+
+// ---------------------------------------------------------
+
+TaskScheduler::TaskGraph::node_t TaskScheduler::TaskGraph::add(task_t task, const char * name) {
+	nodes.push_back(Node{std::move(task), name, std::vector<node_t>(), 0});
+	return static_cast<node_t>(nodes.size() - 1);
+}
+
+void TaskScheduler::TaskGraph::addDependency(node_t node, node_t dependency) {
+	if(node >= nodes.size() || dependency >= nodes.size() || node == dependency)
+		throw std::out_of_range("TaskGraph::addDependency: Invalid node.");
+	nodes[dependency].successors.push_back(node);
+	++nodes[node].numDependencies;
+}
+
+}
@@ -0,0 +1,173 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_TASKSCHEDULER_H_
+#define RENDERING_TASKSCHEDULER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Rendering {
+
+/**
+ * Work-stealing job system shared by the parallel algorithms of the library (MeshUtils, Serialization, texture tools).
+ *
+ * Every worker thread owns a task queue. Tasks submitted by a worker are pushed to its own queue and taken from its
+ * back (LIFO); idle workers steal the oldest tasks from the front of the other queues. A thread waiting for a
+ * TaskGroup executes pending tasks in the meantime, so nested parallel loops do not block workers.
+ * \code
+ *	TaskScheduler & scheduler = TaskScheduler::get();
+ *	TaskScheduler::TaskGroup group;
+ *	scheduler.run(group, [&]() { loadA(); }, "loadA");
+ *	scheduler.run(group, [&]() { loadB(); }, "loadB");
+ *	scheduler.wait(group); // rethrows the first exception of a task
+ *
+ *	scheduler.parallelFor(count, [&](uint32_t begin, uint32_t end) { ... }, 4096);
+ * \endcode
+ *
+ * The library-wide instance is created on the first call of get(); its number of threads and their affinity can be
+ * set with configure(). Thread safe.
+ */
+class TaskScheduler {
+	public:
+		typedef std::function<void ()> task_t;
+		typedef std::chrono::steady_clock clock_t;
+
+		//! A set of tasks that can be waited for.
+		class TaskGroup {
+			public:
+				TaskGroup() : pending(0) {}
+				TaskGroup(const TaskGroup &) = delete;
+				TaskGroup & operator=(const TaskGroup &) = delete;
+				bool isDone() const						{	return pending.load() == 0;	}
+			private:
+				friend class TaskScheduler;
+				std::atomic<uint32_t> pending;
+				std::mutex mutex;
+				std::condition_variable finished;
+				std::exception_ptr exception;
+		};
+
+		//! Dependency graph of tasks; a task starts after all its dependencies have finished. See run(TaskGraph &).
+		class TaskGraph {
+			public:
+				typedef uint32_t node_t;
+				//! Add a task and return its node id.
+				node_t add(task_t task, const char * name = nullptr);
+				//! @p node starts after @p dependency has finished.
+				void addDependency(node_t node, node_t dependency);
+				size_t size() const						{	return nodes.size();	}
+			private:
+				friend class TaskScheduler;
+				struct Node {
+					task_t task;
+					const char * name;
+					std::vector<node_t> successors;
+					uint32_t numDependencies;
+				};
+				std::vector<Node> nodes;
+		};
+
+		//! Passed to the profiling callback after a task has been executed.
+		struct TaskProfile {
+			const char * name;			//!< name given to run() (may be nullptr)
+			int32_t worker;				//!< index of the executing worker; -1 if a waiting non-worker thread executed the task
+			clock_t::time_point begin;
+			clock_t::time_point end;
+		};
+		typedef std::function<void (const TaskProfile &)> profiler_t;
+
+		struct Statistics {
+			uint64_t executedTasks;
+			uint64_t stolenTasks;		//!< tasks executed by another thread than the one whose queue they were pushed to
+		};
+
+		//! (static) The library-wide scheduler.
+		static TaskScheduler & get();
+
+		/*! (static) Set the number of threads executing the tasks of the library-wide scheduler, including the waiting
+			thread (i.e. @p numThreads - 1 workers are created; 0: number of hardware threads), and optionally pin worker
+			@c i to the CPU @c affinity[i % affinity.size()]. An existing scheduler is replaced; no tasks must be pending.
+			\note The affinity is only supported on Linux. */
+		static void configure(uint32_t numThreads, std::vector<uint32_t> affinity = std::vector<uint32_t>());
+
+		explicit TaskScheduler(uint32_t numWorkers, std::vector<uint32_t> affinity = std::vector<uint32_t>());
+		//! Waits for all queued tasks.
+		~TaskScheduler();
+
+		TaskScheduler(const TaskScheduler &) = delete;
+		TaskScheduler & operator=(const TaskScheduler &) = delete;
+
+		uint32_t getNumWorkers() const					{	return static_cast<uint32_t>(workers.size());	}
+		//! Number of threads that execute tasks in parallel (the workers and the waiting thread).
+		uint32_t getConcurrency() const					{	return getNumWorkers() + 1;	}
+
+		//! Queue a task of the group. Without workers, the task is executed immediately.
+		void run(TaskGroup & group, task_t task, const char * name = nullptr);
+
+		//! Wait until all tasks of the group have finished; pending tasks are executed meanwhile. Rethrows the first exception of a task.
+		void wait(TaskGroup & group);
+
+		//! Execute all tasks of the graph respecting their dependencies and wait for them. The graph must be acyclic.
+		void run(TaskGraph & graph);
+
+		/*! Split the range [0, count) into contiguous chunks of at least @p minChunkSize elements and
+			call @p fun(begin, end) for each chunk. Returns after all chunks have been processed.
+			\note @p fun must only write to data belonging to its own range. */
+		void parallelFor(uint32_t count, const std::function<void (uint32_t, uint32_t)> & fun, uint32_t minChunkSize = 1, const char * name = nullptr);
+
+		/*! Set a function that is called after every task (from the executing thread; it has to be thread safe).
+			An empty function disables profiling. \note Must not be changed while tasks are pending. */
+		void setProfilingCallback(profiler_t callback)	{	profiler = std::move(callback);	}
+
+		Statistics getStatistics() const;
+		void resetStatistics();
+
+	private:
+		struct Task {
+			task_t function;
+			TaskGroup * group;
+			const char * name;
+			int32_t queue;
+		};
+		struct WorkerQueue {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		std::vector<std::unique_ptr<WorkerQueue>> queues;
+		std::vector<std::thread> workers;
+		std::atomic<uint32_t> numQueued;
+		std::atomic<uint32_t> nextQueue; //!< round robin queue for tasks submitted by non-worker threads
+		std::mutex sleepMutex;
+		std::condition_variable workAvailable;
+		bool terminate;
+		profiler_t profiler;
+		std::atomic<uint64_t> executedTasks;
+		std::atomic<uint64_t> stolenTasks;
+
+		void workerLoop(uint32_t index);
+		//! (internal) Take a task from the own queue (if @p worker >= 0) or steal one from another queue.
+		bool findTask(int32_t worker, Task & task);
+		void execute(Task & task, int32_t worker);
+};
+
+}
+
+#endif /* RENDERING_TASKSCHEDULER_H_ */
@@ -0,0 +1,440 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "TerrainRenderer.h"
+#include "Mesh/Mesh.h"
+#include "Mesh/MeshIndexData.h"
+#include "Mesh/MeshVertexData.h"
+#include "Mesh/VertexDescription.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Shader/Uniform.h"
+#include "Texture/Texture.h"
+#include "Texture/TextureUtils.h"
+#include "TaskScheduler.h"
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Rect.h>
+#include <Geometry/Vec2.h>
+#include <Geometry/Vec4.h>
+#include <Util/Graphics/PixelAccessor.h>
+#include <Util/Macros.h>
+#include <Util/TypeConstant.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace Rendering {
+
+static const char * const vertexProgram =
+R"***(#version 130
+#define MAX_LEVELS 9
+uniform mat4 sg_matrix_modelToClipping;
+uniform sampler2D terrain_heightMap;
+uniform vec2 terrain_chunkOffset;
+uniform int terrain_chunkResolution;
+uniform int terrain_level;
+uniform vec4 terrain_neighbourLevels;
+uniform vec2 terrain_morphRanges[MAX_LEVELS];
+uniform vec3 terrain_cameraPosition;
+uniform vec3 terrain_origin;
+uniform float terrain_cellSize;
+
+in vec2 sg_Position;
+out vec3 terrainNormal;
+
+float terrainHeight(ivec2 p) {
+	return texelFetch(terrain_heightMap, clamp(p, ivec2(0), textureSize(terrain_heightMap, 0) - 1), 0).r;
+}
+
+void main() {
+	ivec2 local = ivec2(sg_Position + 0.5);
+	ivec2 p = ivec2(terrain_chunkOffset + 0.5) + local;
+
+	// vertices on the border use the level of the coarser chunk, so that both chunks morph them equally
+	ivec4 neighbourLevels = ivec4(terrain_neighbourLevels + 0.5);
+	int level = terrain_level;
+	if(local.x == 0)
+		level = max(level, neighbourLevels.x);
+	if(local.x == terrain_chunkResolution)
+		level = max(level, neighbourLevels.y);
+	if(local.y == 0)
+		level = max(level, neighbourLevels.z);
+	if(local.y == terrain_chunkResolution)
+		level = max(level, neighbourLevels.w);
+
+	float height = terrainHeight(p);
+	vec3 position = terrain_origin + vec3(float(p.x) * terrain_cellSize, height, float(p.y) * terrain_cellSize);
+
+	// vertices missing in the next level are moved onto the edge of the next level's triangle containing them
+	ivec2 odd = (p >> level) & 1;
+	if(odd != ivec2(0)) {
+		vec2 range = terrain_morphRanges[level];
+		float morph = clamp((distance(position, terrain_cameraPosition) - range.x) / max(range.y - range.x, 1.0e-6), 0.0, 1.0);
+		int step = 1 << level;
+		float coarseHeight = 0.5 * (terrainHeight(p - odd * step) + terrainHeight(p + odd * step));
+		position.y = terrain_origin.y + mix(height, coarseHeight, morph);
+	} else {
+		position.y = terrain_origin.y + height;
+	}
+	terrainNormal = normalize(vec3(terrainHeight(p - ivec2(1, 0)) - terrainHeight(p + ivec2(1, 0)), 2.0 * terrain_cellSize,
+								terrainHeight(p - ivec2(0, 1)) - terrainHeight(p + ivec2(0, 1))));
+	gl_Position = sg_matrix_modelToClipping * vec4(position, 1.0);
+}
+)***";
+
+static const char * const fragmentProgram =
+R"***(#version 130
+in vec3 terrainNormal;
+out vec4 fragColor;
+
+void main() {
+	float diffuse = max(dot(normalize(terrainNormal), normalize(vec3(0.3, 1.0, 0.2))), 0.0);
+	fragColor = vec4(vec3(0.25 + 0.75 * diffuse), 1.0);
+}
+)***";
+
+//! Number of stitching variants per level: a bit per side (-x, +x, -z, +z) whose neighbor uses the next level.
+static const uint32_t NUM_VARIANTS = 16;
+
+struct TerrainRenderer::Patch {
+	Util::Reference<Mesh> mesh;
+	uint32_t levelCount;
+	//! (first index, index count) of level * NUM_VARIANTS + variant
+	std::vector<std::pair<uint32_t, uint32_t>> ranges;
+};
+
+//! (static, internal)
+std::shared_ptr<const TerrainRenderer::Patch> TerrainRenderer::getPatch(uint32_t resolution) {
+	static std::mutex mutex;
+	static std::unordered_map<uint32_t, std::weak_ptr<const Patch>> patches;
+	std::lock_guard<std::mutex> lock(mutex);
+	std::shared_ptr<const Patch> cached = patches[resolution].lock();
+	if(cached)
+		return cached;
+
+	std::shared_ptr<Patch> patch = std::make_shared<Patch>();
+	patch->levelCount = 1;
+	while((1u << (patch->levelCount - 1)) < resolution)
+		++patch->levelCount;
+
+	const uint32_t rowLength = resolution + 1;
+	std::vector<uint32_t> indices;
+	for(uint32_t level = 0; level < patch->levelCount; ++level) {
+		const uint32_t step = 1u << level;
+		// a single quad has no vertices that could be missing in a coarser neighbor
+		const bool stitch = step < resolution;
+		for(uint32_t variant = 0; variant < NUM_VARIANTS; ++variant) {
+			if(!stitch && variant > 0) {
+				patch->ranges.push_back(patch->ranges[level * NUM_VARIANTS]);
+				continue;
+			}
+			// Edge vertices that are missing in the coarser neighbor are replaced by their predecessor on the edge;
+			// the triangles collapsing this way are skipped, the remaining ones form a fan to the coarse edge.
+			const auto vertex = [&](uint32_t x, uint32_t z) -> uint32_t {
+				if(((variant & 1) && x == 0) || ((variant & 2) && x == resolution)) {
+					if((z / step) & 1)
+						z -= step;
+				}
+				if(((variant & 4) && z == 0) || ((variant & 8) && z == resolution)) {
+					if((x / step) & 1)
+						x -= step;
+				}
+				return z * rowLength + x;
+			};
+			const auto addTriangle = [&indices](uint32_t a, uint32_t b, uint32_t c) {
+				if(a != b && b != c && a != c) {
+					indices.push_back(a);
+					indices.push_back(b);
+					indices.push_back(c);
+				}
+			};
+			const uint32_t first = static_cast<uint32_t>(indices.size());
+			for(uint32_t z = 0; z < resolution; z += step) {
+				for(uint32_t x = 0; x < resolution; x += step) {
+					// the diagonal runs from (x, z) to (x + step, z + step) on all levels (see the morphing in the vertex shader)
+					const uint32_t a = vertex(x, z);
+					const uint32_t b = vertex(x + step, z);
+					const uint32_t c = vertex(x + step, z + step);
+					const uint32_t d = vertex(x, z + step);
+					addTriangle(a, c, b);
+					addTriangle(a, d, c);
+				}
+			}
+			patch->ranges.emplace_back(first, static_cast<uint32_t>(indices.size()) - first);
+		}
+	}
+
+	VertexDescription vertexDescription;
+	vertexDescription.appendPosition2D();
+	patch->mesh = new Mesh(vertexDescription, rowLength * rowLength, static_cast<uint32_t>(indices.size()));
+	MeshVertexData & vertexData = patch->mesh->openVertexData();
+	float * position = reinterpret_cast<float *>(vertexData.data());
+	for(uint32_t z = 0; z < rowLength; ++z) {
+		for(uint32_t x = 0; x < rowLength; ++x) {
+			*position++ = static_cast<float>(x);
+			*position++ = static_cast<float>(z);
+		}
+	}
+	vertexData.markAsChanged();
+	vertexData.invalidateBoundingBox();
+	MeshIndexData & indexData = patch->mesh->openIndexData();
+	std::copy(indices.begin(), indices.end(), indexData.data());
+	indexData.updateIndexRange();
+	indexData.markAsChanged();
+
+	patches[resolution] = patch;
+	return patch;
+}
+
+TerrainRenderer::TerrainRenderer(uint32_t _chunkResolution) :
+		chunkResolution(_chunkResolution), chunksX(0), chunksZ(0), samplesX(0), cellSize(1.0f),
+		maxScreenSpaceError(2.0f), morphRegion(0.3f) {
+	if(chunkResolution < 2 || chunkResolution > (1u << (MAX_LEVELS - 1)) || (chunkResolution & (chunkResolution - 1)) != 0)
+		throw std::invalid_argument("TerrainRenderer: The chunk resolution has to be a power of two in [2, 256].");
+	patch = getPatch(chunkResolution);
+	boundingBox.invalidate();
+}
+
+TerrainRenderer::~TerrainRenderer() = default;
+
+uint32_t TerrainRenderer::getLevelCount() const {
+	return patch->levelCount;
+}
+
+Texture * TerrainRenderer::getHeightTexture() const {
+	return heightTexture.get();
+}
+
+Mesh * TerrainRenderer::getPatchMesh() const {
+	return patch->mesh.get();
+}
+
+//! (static)
+const char * TerrainRenderer::getDefaultVertexProgram() {
+	return vertexProgram;
+}
+
+void TerrainRenderer::setShader(Shader * newShader) {
+	shader = newShader;
+	if(shader.isNull())
+		initShader();
+	chunkOffsetHandle = shader->getUniformHandle("terrain_chunkOffset");
+	levelHandle = shader->getUniformHandle("terrain_level");
+	neighbourLevelsHandle = shader->getUniformHandle("terrain_neighbourLevels");
+}
+
+void TerrainRenderer::initShader() {
+	shader = Shader::createShader(vertexProgram, fragmentProgram, Shader::USE_UNIFORMS);
+}
+
+void TerrainRenderer::setHeightField(const Util::PixelAccessor & heights, float _cellSize, float heightScale, const Geometry::Vec3 & _origin) {
+	const uint32_t width = heights.getWidth();
+	const uint32_t depth = heights.getHeight();
+	std::vector<float> values(static_cast<size_t>(width) * depth);
+	for(uint32_t z = 0; z < depth; ++z) {
+		for(uint32_t x = 0; x < width; ++x)
+			values[static_cast<size_t>(z) * width + x] = heights.readSingleValueFloat(x, z) * heightScale;
+	}
+	setHeightField(values, width, depth, _cellSize, _origin);
+}
+
+void TerrainRenderer::setHeightField(const std::vector<float> & heights, uint32_t width, uint32_t depth, float _cellSize, const Geometry::Vec3 & _origin) {
+	if(width < 2 || depth < 2 || heights.size() < static_cast<size_t>(width) * depth) {
+		WARN("TerrainRenderer::setHeightField: Invalid height field.");
+		return;
+	}
+	cellSize = _cellSize;
+	origin = _origin;
+	const uint32_t n = chunkResolution;
+	chunksX = (width - 2) / n + 1;
+	chunksZ = (depth - 2) / n + 1;
+	samplesX = chunksX * n + 1;
+	const uint32_t samplesZ = chunksZ * n + 1;
+
+	// extend the border values to whole chunks
+	heightTexture = TextureUtils::createDataTexture(TextureType::TEXTURE_2D, samplesX, samplesZ, 1, Util::TypeConstant::FLOAT, 1);
+	heightTexture->allocateLocalData();
+	float * samples = reinterpret_cast<float *>(heightTexture->getLocalData());
+	for(uint32_t z = 0; z < samplesZ; ++z) {
+		const float * row = heights.data() + static_cast<size_t>(std::min(z, depth - 1)) * width;
+		for(uint32_t x = 0; x < samplesX; ++x)
+			samples[static_cast<size_t>(z) * samplesX + x] = row[std::min(x, width - 1)];
+	}
+	heightTexture->dataChanged();
+	const auto sample = [samples, this](uint32_t x, uint32_t z) {
+		return samples[static_cast<size_t>(z) * samplesX + x];
+	};
+
+	// height ranges of the chunks and the errors of their levels
+	const uint32_t levelCount = patch->levelCount;
+	const uint32_t chunkCount = chunksX * chunksZ;
+	chunkBoxes.assign(chunkCount, Geometry::Box());
+	std::vector<float> chunkErrors(static_cast<size_t>(chunkCount) * levelCount, 0.0f);
+	TaskScheduler::get().parallelFor(chunkCount, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t chunk = begin; chunk < end; ++chunk) {
+			const uint32_t x0 = (chunk % chunksX) * n;
+			const uint32_t z0 = (chunk / chunksX) * n;
+			float minHeight = std::numeric_limits<float>::max();
+			float maxHeight = std::numeric_limits<float>::lowest();
+			for(uint32_t z = z0; z <= z0 + n; ++z) {
+				for(uint32_t x = x0; x <= x0 + n; ++x) {
+					minHeight = std::min(minHeight, sample(x, z));
+					maxHeight = std::max(maxHeight, sample(x, z));
+				}
+			}
+			chunkBoxes[chunk] = Geometry::Box(origin.getX() + x0 * cellSize, origin.getX() + (x0 + n) * cellSize,
+												origin.getY() + minHeight, origin.getY() + maxHeight,
+												origin.getZ() + z0 * cellSize, origin.getZ() + (z0 + n) * cellSize);
+			// deviation of the samples from the triangles of each level (split like the patch's quads)
+			for(uint32_t level = 1; level < levelCount; ++level) {
+				const uint32_t step = 1u << level;
+				const float invStep = 1.0f / static_cast<float>(step);
+				float error = 0.0f;
+				for(uint32_t qz = z0; qz < z0 + n; qz += step) {
+					for(uint32_t qx = x0; qx < x0 + n; qx += step) {
+						const float h00 = sample(qx, qz);
+						const float h10 = sample(qx + step, qz);
+						const float h01 = sample(qx, qz + step);
+						const float h11 = sample(qx + step, qz + step);
+						for(uint32_t j = 0; j <= step; ++j) {
+							const float v = j * invStep;
+							for(uint32_t i = 0; i <= step; ++i) {
+								const float u = i * invStep;
+								const float coarse = u >= v ? h00 + u * (h10 - h00) + v * (h11 - h10)
+															: h00 + v * (h01 - h00) + u * (h11 - h01);
+								error = std::max(error, std::abs(sample(qx + i, qz + j) - coarse));
+							}
+						}
+					}
+				}
+				chunkErrors[static_cast<size_t>(chunk) * levelCount + level] = error;
+			}
+		}
+	}, 16, "TerrainRenderer::setHeightField");
+
+	// all chunks use the same errors, so that the morph ranges of neighbors agree
+	levelErrors.assign(levelCount, 0.0f);
+	for(uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+		for(uint32_t level = 1; level < levelCount; ++level)
+			levelErrors[level] = std::max(levelErrors[level], chunkErrors[static_cast<size_t>(chunk) * levelCount + level]);
+	}
+	for(uint32_t level = 1; level < levelCount; ++level)
+		levelErrors[level] = std::max(levelErrors[level], levelErrors[level - 1]);
+
+	boundingBox.invalidate();
+	culler.clear();
+	culler.reserve(chunkCount);
+	for(const auto & box : chunkBoxes) {
+		boundingBox.include(box);
+		culler.addBox(box, Geometry::Matrix4x4());
+	}
+	chunkLevels.assign(chunkCount, 0);
+}
+
+void TerrainRenderer::display(RenderingContext & context) {
+	statistics = Statistics();
+	if(chunkBoxes.empty())
+		return;
+	if(shader.isNull())
+		setShader(nullptr);
+
+	const Geometry::Matrix4x4 & modelToCamera = context.getMatrix_modelToCamera();
+	const Geometry::Matrix4x4 & cameraToClipping = context.getMatrix_cameraToClipping();
+	const Geometry::Vec3 cameraPosition = modelToCamera.inverse().transformPosition(Geometry::Vec3(0.0f, 0.0f, 0.0f));
+	// element (1,1) of a perspective projection matrix is cot(fovY / 2)
+	const float pixelsPerUnit = 0.5f * static_cast<float>(context.getViewport().getHeight()) * cameraToClipping.at(1, 1);
+
+	// a level is used beyond the distance at which its error is projected to maxScreenSpaceError pixels
+	const uint32_t levelCount = patch->levelCount;
+	std::vector<float> levelDistances(levelCount);
+	for(uint32_t level = 0; level < levelCount; ++level)
+		levelDistances[level] = levelErrors[level] * pixelsPerUnit / std::max(maxScreenSpaceError, 1.0e-3f);
+	std::vector<Geometry::Vec2> morphRanges(MAX_LEVELS, Geometry::Vec2(std::numeric_limits<float>::max(), std::numeric_limits<float>::max()));
+	for(uint32_t level = 0; level + 1 < levelCount; ++level) {
+		const float end = levelDistances[level + 1];
+		morphRanges[level] = Geometry::Vec2(end - morphRegion * (end - levelDistances[level]), end);
+	}
+
+	// levels of all chunks (including the invisible ones, as they determine the stitching of their neighbors)
+	for(uint32_t chunk = 0; chunk < chunkBoxes.size(); ++chunk) {
+		const float distance = std::sqrt(chunkBoxes[chunk].getDistanceSquared(cameraPosition));
+		uint8_t level = 0;
+		while(level + 1u < levelCount && levelDistances[level + 1] <= distance)
+			++level;
+		chunkLevels[chunk] = level;
+	}
+	// neighbors differ by at most one level
+	for(bool changed = true; changed;) {
+		changed = false;
+		for(uint32_t z = 0; z < chunksZ; ++z) {
+			for(uint32_t x = 0; x < chunksX; ++x) {
+				uint8_t & level = chunkLevels[z * chunksX + x];
+				uint8_t minNeighbour = level;
+				if(x > 0)
+					minNeighbour = std::min(minNeighbour, chunkLevels[z * chunksX + x - 1]);
+				if(x + 1 < chunksX)
+					minNeighbour = std::min(minNeighbour, chunkLevels[z * chunksX + x + 1]);
+				if(z > 0)
+					minNeighbour = std::min(minNeighbour, chunkLevels[(z - 1) * chunksX + x]);
+				if(z + 1 < chunksZ)
+					minNeighbour = std::min(minNeighbour, chunkLevels[(z + 1) * chunksX + x]);
+				if(level > minNeighbour + 1) {
+					level = minNeighbour + 1;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	culler.setFrustum(cameraToClipping * modelToCamera);
+	culler.cull(visibleChunks);
+	statistics.culledChunks = static_cast<uint32_t>(chunkBoxes.size() - visibleChunks.size());
+
+	shader->setUniform(context, Uniform("terrain_heightMap", 0), false);
+	shader->setUniform(context, Uniform("terrain_chunkResolution", static_cast<int32_t>(chunkResolution)), false);
+	shader->setUniform(context, Uniform("terrain_morphRanges", morphRanges), false);
+	shader->setUniform(context, Uniform("terrain_cameraPosition", cameraPosition), false);
+	shader->setUniform(context, Uniform("terrain_origin", origin), false);
+	shader->setUniform(context, Uniform("terrain_cellSize", cellSize), false);
+	context.pushAndSetShader(shader.get());
+	context.pushAndSetTexture(0, heightTexture.get());
+	Mesh * mesh = patch->mesh.get();
+	for(const auto chunk : visibleChunks) {
+		const uint32_t x = chunk % chunksX;
+		const uint32_t z = chunk / chunksX;
+		const uint8_t level = chunkLevels[chunk];
+		const auto neighbourLevel = [&](bool exists, uint32_t neighbour) {
+			return exists ? chunkLevels[neighbour] : level;
+		};
+		const uint8_t neighbours[4] = {
+			neighbourLevel(x > 0, chunk - 1), neighbourLevel(x + 1 < chunksX, chunk + 1),
+			neighbourLevel(z > 0, chunk - chunksX), neighbourLevel(z + 1 < chunksZ, chunk + chunksX)
+		};
+		uint32_t variant = 0;
+		for(uint32_t side = 0; side < 4; ++side) {
+			if(neighbours[side] > level)
+				variant |= 1u << side;
+		}
+		shader->setUniform(context, chunkOffsetHandle, Geometry::Vec2(static_cast<float>(x * chunkResolution), static_cast<float>(z * chunkResolution)));
+		shader->setUniform(context, levelHandle, static_cast<int32_t>(level));
+		shader->setUniform(context, neighbourLevelsHandle, Geometry::Vec4(neighbours[0], neighbours[1], neighbours[2], neighbours[3]));
+		const auto & range = patch->ranges[level * NUM_VARIANTS + variant];
+		context.displayMesh(mesh, range.first, range.second);
+		++statistics.displayedChunks;
+		statistics.displayedTriangles += range.second / 3;
+	}
+	context.popTexture(0);
+	context.popShader();
+}
+
+}
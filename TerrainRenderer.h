@@ -0,0 +1,157 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_TERRAINRENDERER_H_
+#define RENDERING_TERRAINRENDERER_H_
+
+#include "FrustumCuller.h"
+#include "Shader/Shader.h"
+#include <Geometry/Box.h>
+#include <Geometry/Vec3.h>
+#include <Util/References.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Util {
+class PixelAccessor;
+}
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+class Texture;
+
+/**
+ * Renderer for large height fields that are split into square chunks of a fixed resolution.
+ *
+ * Instead of a mesh per tile (as created by MeshUtils::createGrid() or MeshUtils::createMeshFromBitmaps()),
+ * all chunks of the same resolution share one patch mesh: a grid of (resolution+1)^2 vertices storing only
+ * their 2D grid coordinates and one index range for every level of detail and every combination of coarser
+ * neighbors (16 stitching variants per level). The patch is shared by all TerrainRenderers with the same
+ * chunk resolution. The heights are stored in a single float texture and fetched in the vertex shader,
+ * so the terrain costs four bytes per height sample in graphics memory.
+ *
+ * Level @c l of a chunk uses every (2^l)-th sample. The geometric error of a level is the maximum deviation
+ * of the coarse surface from the height samples (over all chunks, so that borders agree). A chunk uses the
+ * coarsest level whose error, projected at the distance of the chunk, stays below the maximum screen-space
+ * error; neighboring chunks differ by at most one level. Edge vertices that do not exist in the coarser
+ * neighbor are left out (stitching), and the remaining vertices are morphed to the coarser level before the
+ * chunk switches (geomorphing), so there are neither cracks nor popping.
+ * \code
+ * TerrainRenderer terrain(64);
+ * terrain.setHeightField(*Util::PixelAccessor::create(heightBitmap), 10.0f, 2000.0f);
+ * // per frame
+ * terrain.display(renderingContext);
+ * \endcode
+ * A custom shader (see setShader()) has to compute the vertex position like the default shader
+ * (getDefaultVertexProgram()) from the following attributes and uniforms:
+ * - @c sg_Position (vec2): grid coordinates of the vertex in the chunk [0, resolution]
+ * - @c terrain_heightMap (sampler2D): heights; a texel per grid coordinate (texture unit 0)
+ * - @c terrain_chunkOffset (vec2): grid coordinates of the chunk's first vertex
+ * - @c terrain_level (int), @c terrain_neighbourLevels (vec4: -x, +x, -z, +z): levels of the chunk and its neighbors
+ * - @c terrain_morphRanges (vec2[TerrainRenderer::MAX_LEVELS]): distances (start, end) of the morph to the next level
+ * - @c terrain_cameraPosition (vec3): camera position in model coordinates
+ * - @c terrain_origin (vec3), @c terrain_cellSize (float): model position of sample (0,0) and sample spacing
+ */
+class TerrainRenderer {
+	public:
+		//! Supports chunk resolutions up to 2^(MAX_LEVELS - 1).
+		static const uint32_t MAX_LEVELS = 9;
+
+		struct Statistics {
+			uint32_t displayedChunks;
+			uint32_t culledChunks;
+			uint64_t displayedTriangles;
+			Statistics() : displayedChunks(0), culledChunks(0), displayedTriangles(0) {}
+		};
+
+		/*! @param chunkResolution Number of quads along a chunk's side; a power of two in [2, 2^(MAX_LEVELS - 1)].
+			@throw std::invalid_argument if the resolution is not supported.	*/
+		explicit TerrainRenderer(uint32_t chunkResolution = 64);
+		~TerrainRenderer();
+
+		TerrainRenderer(const TerrainRenderer &) = delete;
+		TerrainRenderer & operator=(const TerrainRenderer &) = delete;
+
+		/*! Set the heights of the terrain from the single values of @p heights (e.g. a grayscale bitmap) multiplied
+			by @p heightScale. The sample (x, y) of the accessor is located at @p origin + (x * cellSize, height, y * cellSize).
+			The terrain is extended with the border values to a whole number of chunks.
+			\note The size of the height field is limited by the maximum texture size.	*/
+		void setHeightField(const Util::PixelAccessor & heights, float cellSize, float heightScale = 1.0f,
+							const Geometry::Vec3 & origin = Geometry::Vec3(0.0f, 0.0f, 0.0f));
+		//! Set the heights from @p width x @p depth values stored row by row. \see setHeightField(const Util::PixelAccessor &, ...)
+		void setHeightField(const std::vector<float> & heights, uint32_t width, uint32_t depth, float cellSize,
+							const Geometry::Vec3 & origin = Geometry::Vec3(0.0f, 0.0f, 0.0f));
+
+		/*! Draw the visible chunks with the current modelview and projection matrices. The terrain is located
+			in model coordinates.	*/
+		void display(RenderingContext & context);
+
+		//! Chunks use the coarsest level whose projected error is at most this value in pixels (default: 2).
+		void setMaxScreenSpaceError(float pixels)			{	maxScreenSpaceError = pixels;	}
+		float getMaxScreenSpaceError() const				{	return maxScreenSpaceError;	}
+
+		//! Part of the distance range of a level in which the vertices are morphed to the next level (default: 0.3).
+		void setMorphRegion(float fraction)					{	morphRegion = fraction;	}
+		float getMorphRegion() const						{	return morphRegion;	}
+
+		//! Replace the default shader; @c nullptr restores the default shader.
+		void setShader(Shader * newShader);
+		Shader * getShader() const							{	return shader.get();	}
+		static const char * getDefaultVertexProgram();
+
+		uint32_t getChunkResolution() const					{	return chunkResolution;	}
+		uint32_t getLevelCount() const;
+		uint32_t getChunkCountX() const						{	return chunksX;	}
+		uint32_t getChunkCountZ() const						{	return chunksZ;	}
+		//! Geometric error of the given level in model units.
+		float getLevelError(uint32_t level) const			{	return levelErrors.at(level);	}
+		const Geometry::Box & getBoundingBox() const		{	return boundingBox;	}
+		Texture * getHeightTexture() const;
+		//! The mesh containing the shared grid and the index ranges of all levels.
+		Mesh * getPatchMesh() const;
+		const Statistics & getStatistics() const			{	return statistics;	}
+
+	private:
+		struct Patch;
+		//! (internal) The patch of the given resolution, shared by all renderers using it.
+		static std::shared_ptr<const Patch> getPatch(uint32_t resolution);
+
+		const uint32_t chunkResolution;
+		std::shared_ptr<const Patch> patch;
+
+		uint32_t chunksX;
+		uint32_t chunksZ;
+		uint32_t samplesX; //!< chunksX * chunkResolution + 1
+		float cellSize;
+		Geometry::Vec3 origin;
+		Util::Reference<Texture> heightTexture;
+		std::vector<Geometry::Box> chunkBoxes;
+		std::vector<float> levelErrors;
+		Geometry::Box boundingBox;
+
+		float maxScreenSpaceError;
+		float morphRegion;
+		Util::Reference<Shader> shader;
+		UniformHandle chunkOffsetHandle, levelHandle, neighbourLevelsHandle;
+
+		FrustumCuller culler;
+		std::vector<uint32_t> visibleChunks;
+		std::vector<uint8_t> chunkLevels;
+		Statistics statistics;
+
+		void initShader();
+};
+
+}
+
+#endif /* RENDERING_TERRAINRENDERER_H_ */
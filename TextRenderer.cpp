@@ -8,12 +8,13 @@
 */
 #include "TextRenderer.h"
 #include "Mesh/Mesh.h"
+#include "Mesh/MeshDataStrategy.h"
+#include "Mesh/MeshIndexData.h"
+#include "Mesh/MeshVertexData.h"
 #include "Mesh/VertexDescription.h"
-#include "MeshUtils/MeshBuilder.h"
 #include "RenderingContext/RenderingParameters.h"
 #include "RenderingContext/RenderingContext.h"
 #include "Shader/Shader.h"
-#include "Shader/Uniform.h"
 #include "Texture/Texture.h"
 #include "Texture/TextureUtils.h"
 #include "Draw.h"
@@ -22,8 +23,11 @@
 #include <Util/Graphics/Color.h>
 #include <Util/Graphics/FontRenderer.h>
 #include <Util/References.h>
+#include <algorithm>
 #include <cstdint>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace Rendering {
 
@@ -33,10 +37,13 @@ uniform mat4 sg_matrix_modelToClipping;
 
 in vec2 sg_Position;
 in vec2 sg_TexCoord0;
+in vec4 sg_Color;
 out vec2 glyphPos;
+out vec4 glyphColor;
 
 void main(void) {
 	glyphPos = sg_TexCoord0;
+	glyphColor = sg_Color;
 	gl_Position = (sg_matrix_modelToClipping * vec4(sg_Position, 0.0, 1.0));
 }
 )***");
@@ -44,33 +51,183 @@ void main(void) {
 static const std::string fragmentProgram(R"***(#version 130
 
 uniform sampler2D sg_texture0;
-uniform vec4 textColor;
 
 in vec2 glyphPos;
+in vec4 glyphColor;
 out vec4 fragColor;
 
 void main(void) {
-	fragColor = vec4(1.0, 1.0, 1.0, texelFetch(sg_texture0, ivec2(glyphPos), 0).r) * textColor;
+	fragColor = vec4(1.0, 1.0, 1.0, texelFetch(sg_texture0, ivec2(glyphPos), 0).r) * glyphColor;
 }
 )***");
 
+typedef decltype(Util::FontInfo::glyphMap) GlyphMap;
+typedef GlyphMap::mapped_type GlyphInfo;
+
+//! Number of code points (ASCII and Latin-1) whose glyphs are stored in a lookup table
+static const uint32_t NUM_TABLE_GLYPHS = 256;
+
+//! Vertex layout: position (2D), texture coordinate, color (RGBA bytes)
+struct GlyphVertex {
+	float x, y;
+	float u, v;
+	uint8_t r, g, b, a;
+};
+
+/*! Collected glyph quads and the mesh used to draw them. The index data is the same for all batches
+	(four vertices per quad); it is only rebuilt if the capacity grows. */
+struct GlyphBatch {
+	std::vector<GlyphVertex> vertices;
+	Util::Reference<Mesh> mesh;
+	uint32_t capacity; //!< number of quads the mesh can hold
+
+	GlyphBatch() : capacity(0) {}
+	uint32_t getGlyphCount() const	{	return static_cast<uint32_t>(vertices.size() / 4);	}
+};
+
 struct TextRenderer::Implementation {
 	Util::Reference<Shader> shader;
 	Util::Reference<Texture> texture;
 	Util::FontInfo fontInfo;
+	std::vector<GlyphInfo> glyphTable; //!< glyphs of the first NUM_TABLE_GLYPHS code points
+	std::vector<bool> glyphTableValid;
+	GlyphBatch batch; //!< used by addToBatch() and drawBatch()
+	GlyphBatch immediateBatch; //!< used by draw()
+
+	//! Return the glyph of the given character or nullptr if it is not in the glyph map.
+	const GlyphInfo * findGlyph(char32_t character) const {
+		if(character < NUM_TABLE_GLYPHS)
+			return glyphTableValid[character] ? &glyphTable[character] : nullptr;
+		const auto it = fontInfo.glyphMap.find(character);
+		return it == fontInfo.glyphMap.cend() ? nullptr : &it->second;
+	}
+
+	void appendText(GlyphBatch & target, const std::u32string & text, const Geometry::Vec2i & textPosition, const Util::Color4f & textColor) const;
+	void drawBatch(RenderingContext & context, GlyphBatch & source);
 };
 
+//! Append a quad for each character of the text.
+void TextRenderer::Implementation::appendText(GlyphBatch & target, const std::u32string & text,
+											const Geometry::Vec2i & textPosition, const Util::Color4f & textColor) const {
+	const auto textureHeight = static_cast<int32_t>(texture->getHeight());
+	const auto toByte = [](float value) {
+		return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+	};
+	const uint8_t r = toByte(textColor.getR());
+	const uint8_t g = toByte(textColor.getG());
+	const uint8_t b = toByte(textColor.getB());
+	const uint8_t a = toByte(textColor.getA());
+
+	target.vertices.reserve(target.vertices.size() + 4 * text.size());
+	int cursorX = textPosition.getX();
+	for(const auto & character : text) {
+		const GlyphInfo * glyphInfo = findGlyph(character);
+		if(glyphInfo == nullptr) {
+			// Skip missing characters
+			continue;
+		}
+		const auto glyphWidth = glyphInfo->size.first;
+		const auto glyphHeight = glyphInfo->size.second;
+
+		const float left = static_cast<float>(cursorX + glyphInfo->offset.first);
+		const float top = static_cast<float>(textPosition.getY() + fontInfo.ascender - glyphInfo->offset.second);
+		const float texLeft = static_cast<float>(glyphInfo->position.first);
+		const float texTop = static_cast<float>(textureHeight - glyphInfo->position.second);
+
+		// Top left, bottom left, bottom right, top right
+		target.vertices.push_back({left, top, texLeft, texTop, r, g, b, a});
+		target.vertices.push_back({left, top + glyphHeight, texLeft, texTop - glyphHeight, r, g, b, a});
+		target.vertices.push_back({left + glyphWidth, top + glyphHeight, texLeft + glyphWidth, texTop - glyphHeight, r, g, b, a});
+		target.vertices.push_back({left + glyphWidth, top, texLeft + glyphWidth, texTop, r, g, b, a});
+
+		cursorX += glyphInfo->xAdvance;
+	}
+}
+
+//! Transfer the quads of the batch into its mesh, draw them and clear the batch.
+void TextRenderer::Implementation::drawBatch(RenderingContext & context, GlyphBatch & source) {
+	const uint32_t glyphCount = source.getGlyphCount();
+	if(glyphCount == 0)
+		return;
+	if(shader.isNull()) {
+		shader = Shader::createShader(vertexProgram, fragmentProgram, Shader::USE_UNIFORMS);
+	}
+	if(source.mesh.isNull() || source.capacity < glyphCount) {
+		uint32_t capacity = std::max(source.capacity, 64u);
+		while(capacity < glyphCount)
+			capacity *= 2;
+
+		VertexDescription vertexDescription;
+		vertexDescription.appendPosition2D();
+		vertexDescription.appendTexCoord();
+		vertexDescription.appendColorRGBAByte();
+		if(vertexDescription.getVertexSize() != sizeof(GlyphVertex))
+			throw std::logic_error("TextRenderer: Unexpected vertex size.");
+
+		source.mesh = new Mesh(vertexDescription, 4 * capacity, 6 * capacity);
+		source.mesh->setDataStrategy(SimpleMeshDataStrategy::getDynamicVertexStrategy());
+		MeshIndexData & indexData = source.mesh->openIndexData();
+		// 0-3
+		// |\|
+		// 1-2
+		for(uint32_t quad = 0; quad < capacity; ++quad) {
+			uint32_t * indices = indexData.data() + 6 * quad;
+			const uint32_t first = 4 * quad;
+			indices[0] = first;
+			indices[1] = first + 1;
+			indices[2] = first + 3;
+			indices[3] = first + 1;
+			indices[4] = first + 2;
+			indices[5] = first + 3;
+		}
+		indexData.updateIndexRange();
+		indexData.markAsChanged();
+		source.capacity = capacity;
+	}
+	MeshVertexData & vertexData = source.mesh->openVertexData();
+	std::copy(source.vertices.begin(), source.vertices.end(), reinterpret_cast<GlyphVertex *>(vertexData.data()));
+	vertexData.markAsChanged();
+
+	context.pushAndSetBlending(BlendingParameters(BlendingParameters::SRC_ALPHA, BlendingParameters::ONE_MINUS_SRC_ALPHA));
+	context.pushAndSetDepthBuffer(DepthBufferParameters(false, false, Comparison::LESS));
+	context.pushAndSetShader(shader.get());
+	context.pushAndSetTexture(0, texture.get());
+
+	context.displayMesh(source.mesh.get(), 0, 6 * glyphCount);
+
+	context.popTexture(0);
+	context.popShader();
+	context.popDepthBuffer();
+	context.popBlending();
+
+	source.vertices.clear();
+}
+
 TextRenderer::TextRenderer(const Util::Bitmap & glyphBitmap, 
 						   const Util::FontInfo & fontInfo) :
 		impl(new Implementation) {
 	impl->texture = TextureUtils::createTextureFromBitmap(glyphBitmap);
 	impl->fontInfo = fontInfo;
+	impl->glyphTable.resize(NUM_TABLE_GLYPHS);
+	impl->glyphTableValid.resize(NUM_TABLE_GLYPHS, false);
+	for(const auto & entry : fontInfo.glyphMap) {
+		if(entry.first < NUM_TABLE_GLYPHS) {
+			impl->glyphTable[entry.first] = entry.second;
+			impl->glyphTableValid[entry.first] = true;
+		}
+	}
 }
 
 TextRenderer::~TextRenderer() = default;
 
 TextRenderer::TextRenderer(const TextRenderer & other) :
-		impl(new Implementation(*other.impl.get())) {
+		impl(new Implementation) {
+	impl->shader = other.impl->shader;
+	impl->texture = other.impl->texture;
+	impl->fontInfo = other.impl->fontInfo;
+	impl->glyphTable = other.impl->glyphTable;
+	impl->glyphTableValid = other.impl->glyphTableValid;
+	impl->batch.vertices = other.impl->batch.vertices; // the meshes are not shared
 }
 
 TextRenderer::TextRenderer(TextRenderer &&) = default;
@@ -79,69 +236,27 @@ void TextRenderer::draw(RenderingContext & context,
 						const std::u32string & text,
 						const Geometry::Vec2i & textPosition,
 						const Util::Color4f & textColor) const {
-	if(impl->shader.isNull()) {
-		impl->shader = Shader::createShader(vertexProgram, fragmentProgram, Shader::USE_UNIFORMS);
-	}
-	context.pushAndSetBlending(BlendingParameters(BlendingParameters::SRC_ALPHA, BlendingParameters::ONE_MINUS_SRC_ALPHA));
-	context.pushAndSetDepthBuffer(DepthBufferParameters(false, false, Comparison::LESS));
-	context.pushAndSetShader(impl->shader.get());
-	context.pushAndSetTexture(0, impl->texture.get());
-
-	impl->shader->setUniform(context, Uniform("textColor", textColor));
-
-	VertexDescription vertexDescription;
-	vertexDescription.appendPosition2D();
-	vertexDescription.appendTexCoord();
-	MeshUtils::MeshBuilder builder(vertexDescription);
-
-	const auto textureHeight = static_cast<int32_t>(impl->texture->getHeight());
-
-	int cursorX = textPosition.getX();
-	for(const auto & character : text) {
-		const auto it = impl->fontInfo.glyphMap.find(character);
-		if(it == impl->fontInfo.glyphMap.cend()) {
-			// Skip missing characters
-			continue;
-		}
-		const auto & glyphInfo = it->second;
-
-		const auto glyphWidth = glyphInfo.size.first;
-		const auto glyphHeight = glyphInfo.size.second;
-
-		const Geometry::Vec2i topLeftPos(cursorX + glyphInfo.offset.first,
-										 textPosition.getY() + impl->fontInfo.ascender - glyphInfo.offset.second);
-		const Geometry::Vec2i topLeftTexCoord(glyphInfo.position.first,
-											  textureHeight - glyphInfo.position.second);
-
-		// Top left
-		builder.position(topLeftPos);
-		builder.texCoord0(topLeftTexCoord);
-		const auto indexA = builder.addVertex();
-		// Bottom left
-		builder.position(topLeftPos + Geometry::Vec2i(0, glyphHeight));
-		builder.texCoord0(topLeftTexCoord + Geometry::Vec2i(0, -glyphHeight));
-		const auto indexB = builder.addVertex();
-		// Bottom right
-		builder.position(topLeftPos + Geometry::Vec2i(glyphWidth, glyphHeight));
-		builder.texCoord0(topLeftTexCoord + Geometry::Vec2i(glyphWidth, -glyphHeight));
-		const auto indexC = builder.addVertex();
-		// Top right
-		builder.position(topLeftPos + Geometry::Vec2i(glyphWidth, 0));
-		builder.texCoord0(topLeftTexCoord + Geometry::Vec2i(glyphWidth, 0));
-		const auto indexD = builder.addVertex();
+	impl->immediateBatch.vertices.clear();
+	impl->appendText(impl->immediateBatch, text, textPosition, textColor);
+	impl->drawBatch(context, impl->immediateBatch);
+}
 
-		builder.addQuad(indexA, indexB, indexC, indexD);
+void TextRenderer::addToBatch(const std::u32string & text,
+							  const Geometry::Vec2i & textPosition,
+							  const Util::Color4f & textColor) {
+	impl->appendText(impl->batch, text, textPosition, textColor);
+}
 
-		cursorX += glyphInfo.xAdvance;
-	}
-	Util::Reference<Mesh> mesh = builder.buildMesh();
+void TextRenderer::drawBatch(RenderingContext & context) {
+	impl->drawBatch(context, impl->batch);
+}
 
-	context.displayMesh(mesh.get());
+void TextRenderer::clearBatch() {
+	impl->batch.vertices.clear();
+}
 
-	context.popTexture(0);
-	context.popShader();
-	context.popDepthBuffer();
-	context.popBlending();
+std::size_t TextRenderer::getBatchGlyphCount() const {
+	return impl->batch.getGlyphCount();
 }
 
 Geometry::Rect_i TextRenderer::getTextSize(const std::u32string & text) const {
@@ -150,46 +265,36 @@ Geometry::Rect_i TextRenderer::getTextSize(const std::u32string & text) const {
 
 	int cursorX = 0;
 	for(const auto & character : text) {
-		const auto it = impl->fontInfo.glyphMap.find(character);
-		if(it == impl->fontInfo.glyphMap.cend()) {
+		const GlyphInfo * glyphInfo = impl->findGlyph(character);
+		if(glyphInfo == nullptr) {
 			// Skip missing characters
 			continue;
 		}
-		const auto & glyphInfo = it->second;
-
-		const auto glyphWidth = glyphInfo.size.first;
-		const auto glyphHeight = glyphInfo.size.second;
+		const auto glyphWidth = glyphInfo->size.first;
+		const auto glyphHeight = glyphInfo->size.second;
 		
-		const Geometry::Vec2i topLeftPos(cursorX + glyphInfo.offset.first,
-										 impl->fontInfo.ascender - glyphInfo.offset.second);
+		const Geometry::Vec2i topLeftPos(cursorX + glyphInfo->offset.first,
+										 impl->fontInfo.ascender - glyphInfo->offset.second);
 
 		// Top left
 		textRect.include(topLeftPos);
 		// Bottom right
 		textRect.include(topLeftPos + Geometry::Vec2i(glyphWidth, glyphHeight));
 
-		cursorX += glyphInfo.xAdvance;
+		cursorX += glyphInfo->xAdvance;
 	}
 
 	return textRect;
 }
 
 int TextRenderer::getHeightOfX() const {
-	const auto it = impl->fontInfo.glyphMap.find('x');
-	if(it == impl->fontInfo.glyphMap.cend()) {
-		return 0;
-	}
-	const auto & glyphInfo = it->second;
-	return glyphInfo.size.second;
+	const GlyphInfo * glyphInfo = impl->findGlyph('x');
+	return glyphInfo == nullptr ? 0 : glyphInfo->size.second;
 }
 
 int TextRenderer::getWidthOfM() const {
-	const auto it = impl->fontInfo.glyphMap.find('M');
-	if(it == impl->fontInfo.glyphMap.cend()) {
-		return 0;
-	}
-	const auto & glyphInfo = it->second;
-	return glyphInfo.size.first;
+	const GlyphInfo * glyphInfo = impl->findGlyph('M');
+	return glyphInfo == nullptr ? 0 : glyphInfo->size.first;
 }
 
 }
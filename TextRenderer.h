@@ -9,6 +9,7 @@
 #ifndef RENDERING_TEXTRENDERER_H
 #define RENDERING_TEXTRENDERER_H
 
+#include <cstddef>
 #include <memory>
 #include <string>
 
@@ -78,6 +79,29 @@ class TextRenderer {
 				  const Geometry::Vec2i & textPosition,
 				  const Util::Color4f & textColor) const;
 
+		/**
+		 * Append the given text to the batch of this text renderer. All texts
+		 * of the batch are drawn with a single draw call by drawBatch().
+		 * The parameters are the same as for draw().
+		 */
+		void addToBatch(const std::u32string & text,
+						const Geometry::Vec2i & textPosition,
+						const Util::Color4f & textColor);
+
+		/**
+		 * Draw all texts that have been added to the batch and clear it.
+		 * The vertex buffer of the batch is kept and only grows if needed.
+		 * 
+		 * @note the 2D-rendering mode must be enabled ( @see Draw::enable2DMode(...) )
+		 */
+		void drawBatch(RenderingContext & context);
+
+		//! Remove all texts from the batch without drawing them.
+		void clearBatch();
+
+		//! Return the number of glyphs in the batch.
+		std::size_t getBatchGlyphCount() const;
+
 		/**
 		 * Calculate the size that would be needed by the text when it was
 		 * drawn.
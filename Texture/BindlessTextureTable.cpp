@@ -0,0 +1,71 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "BindlessTextureTable.h"
+#include "Texture.h"
+#include "../RenderingContext/RenderingContext.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+
+namespace Rendering {
+
+const uint32_t BindlessTextureTable::INVALID_INDEX;
+
+uint32_t BindlessTextureTable::addTexture(RenderingContext & context, Texture * texture) {
+	const uint32_t index = getIndex(texture);
+	if(index != INVALID_INDEX)
+		return index;
+	const uint64_t handle = context.makeTextureResident(texture);
+	if(handle == 0)
+		return INVALID_INDEX;
+	indices[texture] = static_cast<uint32_t>(handles.size());
+	textures.emplace_back(texture);
+	handles.push_back(handle);
+	changed = true;
+	return static_cast<uint32_t>(handles.size() - 1);
+}
+
+uint32_t BindlessTextureTable::getIndex(Texture * texture) const {
+	const auto it = indices.find(texture);
+	return it == indices.end() ? INVALID_INDEX : it->second;
+}
+
+void BindlessTextureTable::clear() {
+	textures.clear();
+	handles.clear();
+	indices.clear();
+	buffer.destroy();
+	changed = false;
+}
+
+void BindlessTextureTable::bind(RenderingContext & context, uint32_t binding) {
+	if(handles.empty())
+		return;
+	// a texture gets a new handle if its data has been uploaded again
+	for(size_t i = 0; i < textures.size(); ++i) {
+		Texture * texture = textures[i].get();
+		if(!texture->isBindlessResident() || texture->getBindlessHandle(context) != handles[i]) {
+			handles[i] = context.makeTextureResident(texture);
+			changed = true;
+		}
+	}
+	if(changed) {
+		buffer.uploadData(BufferObject::TARGET_SHADER_STORAGE_BUFFER, handles, BufferObject::USAGE_DYNAMIC_DRAW);
+		changed = false;
+	}
+	buffer.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, binding);
+	GET_GL_ERROR();
+}
+
+void BindlessTextureTable::unbind(uint32_t binding) {
+	buffer.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, binding);
+}
+
+}
@@ -0,0 +1,66 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_BINDLESSTEXTURETABLE_H_
+#define RENDERING_BINDLESSTEXTURETABLE_H_
+
+#include "../BufferObject.h"
+#include <Util/References.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Rendering {
+class RenderingContext;
+class Texture;
+
+/*! Table of bindless texture handles stored in a shader storage buffer.
+	Shaders access the textures by their index in the table instead of a texture unit, e.g.:
+	\code
+	#extension GL_ARB_bindless_texture : require
+	layout(std430, binding = 1) readonly buffer sg_TextureTable { sampler2D sg_textures[]; };
+	...
+	color = texture(sg_textures[materialTextureIndex], texCoord);
+	\endcode
+	Therefore, draws using different textures do not require any texture state changes.
+	\note Requires GL_ARB_bindless_texture and GL_ARB_shader_storage_buffer_object.	*/
+class BindlessTextureTable {
+	public:
+		//! Index returned if a texture cannot be added.
+		static const uint32_t INVALID_INDEX = 0xffffffff;
+
+		/*! Add a texture (if it is not already contained) and make it resident.
+			\return The index of the texture in the table or INVALID_INDEX.	*/
+		uint32_t addTexture(RenderingContext & context, Texture * texture);
+
+		//! Return the index of the texture or INVALID_INDEX.
+		uint32_t getIndex(Texture * texture) const;
+
+		uint32_t size() const					{	return static_cast<uint32_t>(handles.size());	}
+
+		//! Remove all textures. The textures stay resident at the context.
+		void clear();
+
+		/*! Bind the table as shader storage buffer to the given binding point.
+			Changed handles (e.g. of re-uploaded textures) are updated before. */
+		void bind(RenderingContext & context, uint32_t binding);
+		void unbind(uint32_t binding);
+
+	private:
+		std::vector<Util::Reference<Texture>> textures;
+		std::vector<uint64_t> handles;
+		std::unordered_map<Texture *, uint32_t> indices;
+		BufferObject buffer;
+		bool changed = false;
+};
+
+}
+
+#endif /* RENDERING_BINDLESSTEXTURETABLE_H_ */
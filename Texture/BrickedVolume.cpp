@@ -0,0 +1,364 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "BrickedVolume.h"
+#include "../MeshUtils/internal/ParallelFor.h"
+#include "../RenderingContext/RenderingContext.h"
+#include "../RenderingContext/RenderingParameters.h"
+#include "../Shader/Shader.h"
+#include "../Shader/Uniform.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+#include <Geometry/Vec3.h>
+#include <Util/IO/FileName.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+namespace Rendering {
+
+static const char * const shaderInterface = R"GLSL(
+uniform sampler3D sg_brickAtlas;
+uniform sampler3D sg_brickPageTable;	// rgb: slot in the atlas, a: state
+uniform vec3 sg_bvVolumeSize;			// in voxels
+uniform float sg_bvBrickSize;			// in voxels (adjacent bricks share one layer)
+uniform float sg_bvAtlasSize;			// in voxels
+
+const int SG_BRICK_MISSING = 0;
+const int SG_BRICK_EMPTY = 1;
+const int SG_BRICK_RESIDENT = 2;
+
+//! Sample the volume at the given texture coordinate; returns 0.0 if the brick is not resident.
+float sg_sampleBrickedVolume(in vec3 coord, out int state) {
+	vec3 voxel = clamp(coord, 0.0, 1.0) * (sg_bvVolumeSize - 1.0);
+	vec3 brick = min(floor(voxel / (sg_bvBrickSize - 1.0)), vec3(textureSize(sg_brickPageTable, 0) - 1));
+	vec4 entry = texelFetch(sg_brickPageTable, ivec3(brick), 0);
+	state = entry.a > 0.75 ? SG_BRICK_RESIDENT : (entry.a > 0.25 ? SG_BRICK_EMPTY : SG_BRICK_MISSING);
+	if(state != SG_BRICK_RESIDENT)
+		return 0.0;
+	vec3 atlasVoxel = floor(entry.rgb * 255.0 + 0.5) * sg_bvBrickSize + (voxel - brick * (sg_bvBrickSize - 1.0)) + 0.5;
+	return texture(sg_brickAtlas, atlasVoxel / sg_bvAtlasSize).r;
+}
+)GLSL";
+
+static const uint8_t STATE_MISSING = 0;
+static const uint8_t STATE_EMPTY = 128;
+static const uint8_t STATE_RESIDENT = 255;
+
+//! Number of bricks of @p brickSize voxels sharing one layer that cover @p size voxels.
+static uint32_t getNumBricks(uint32_t size, uint32_t brickSize) {
+	return size <= 1 ? 1 : (size - 2) / (brickSize - 1) + 1;
+}
+
+static BrickedVolume::BrickRange getRange(const float * voxels, size_t count) {
+	BrickedVolume::BrickRange range;
+	range.minValue = std::numeric_limits<float>::max();
+	range.maxValue = std::numeric_limits<float>::lowest();
+	for(size_t i = 0; i < count; ++i) {
+		range.minValue = std::min(range.minValue, voxels[i]);
+		range.maxValue = std::max(range.maxValue, voxels[i]);
+	}
+	return range;
+}
+
+//! (static)
+const char * BrickedVolume::getShaderInterface() {
+	return shaderInterface;
+}
+
+//! (static)
+BrickedVolume::BrickLoader BrickedVolume::createFileLoader(const Util::FileName & fileName, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ) {
+	auto input = std::make_shared<std::ifstream>(fileName.getPath().c_str(), std::ios_base::in | std::ios_base::binary);
+	if(!input->good())
+		WARN("BrickedVolume::createFileLoader: Could not open file '" + fileName.toString() + "'.");
+	return [input, sizeX, sizeY, sizeZ](uint32_t x, uint32_t y, uint32_t z, uint32_t size, float * data) {
+		if(x >= sizeX || y >= sizeY || z >= sizeZ)
+			return false;
+		input->clear();
+		const uint32_t rowLength = std::min(size, sizeX - x);
+		for(uint32_t k = 0; k < size; ++k) {
+			const uint64_t vz = std::min(z + k, sizeZ - 1);
+			for(uint32_t j = 0; j < size; ++j) {
+				const uint64_t vy = std::min(y + j, sizeY - 1);
+				float * row = data + (static_cast<size_t>(k) * size + j) * size;
+				input->seekg(static_cast<std::streamoff>(((vz * sizeY + vy) * sizeX + x) * sizeof(float)));
+				input->read(reinterpret_cast<char *>(row), static_cast<std::streamsize>(rowLength * sizeof(float)));
+				if(!input->good())
+					return false;
+				std::fill(row + rowLength, row + size, row[rowLength - 1]);
+			}
+		}
+		return true;
+	};
+}
+
+//! (static)
+std::vector<BrickedVolume::BrickRange> BrickedVolume::computeBrickRanges(const float * data, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ, uint32_t brickSize) {
+	brickSize = std::max(2u, brickSize);
+	const uint32_t bricksX = getNumBricks(sizeX, brickSize);
+	const uint32_t bricksY = getNumBricks(sizeY, brickSize);
+	const uint32_t bricksZ = getNumBricks(sizeZ, brickSize);
+	std::vector<BrickRange> ranges(bricksX * bricksY * bricksZ);
+	const uint32_t stride = brickSize - 1;
+	MeshUtils::parallelFor(bricksZ, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t bz = begin; bz < end; ++bz) {
+			const uint32_t z0 = bz * stride, z1 = std::min(sizeZ, z0 + brickSize);
+			for(uint32_t by = 0; by < bricksY; ++by) {
+				const uint32_t y0 = by * stride, y1 = std::min(sizeY, y0 + brickSize);
+				for(uint32_t bx = 0; bx < bricksX; ++bx) {
+					const uint32_t x0 = bx * stride, x1 = std::min(sizeX, x0 + brickSize);
+					BrickRange range = getRange(data + (static_cast<size_t>(z0) * sizeY + y0) * sizeX + x0, 0);
+					for(uint32_t z = z0; z < z1; ++z) {
+						for(uint32_t y = y0; y < y1; ++y) {
+							const BrickRange rowRange = getRange(data + (static_cast<size_t>(z) * sizeY + y) * sizeX + x0, x1 - x0);
+							range.minValue = std::min(range.minValue, rowRange.minValue);
+							range.maxValue = std::max(range.maxValue, rowRange.maxValue);
+						}
+					}
+					ranges[(bz * bricksY + by) * bricksX + bx] = range;
+				}
+			}
+		}
+	}, 1);
+	return ranges;
+}
+
+BrickedVolume::BrickedVolume(uint32_t _sizeX, uint32_t _sizeY, uint32_t _sizeZ, BrickLoader _loader, uint32_t _brickSize, uint32_t _maxResidentBricks) :
+		ReferenceCounter_t(), sizeX(_sizeX), sizeY(_sizeY), sizeZ(_sizeZ), brickSize(std::max(2u, _brickSize)),
+		bricksX(getNumBricks(_sizeX, brickSize)), bricksY(getNumBricks(_sizeY, brickSize)), bricksZ(getNumBricks(_sizeZ, brickSize)),
+		loader(std::move(_loader)), requestedResidentBricks(std::max(1u, _maxResidentBricks)), maxUploadsPerUpdate(16), emptyThreshold(0.0f),
+		initialized(false), slotsPerAxis(0), pageTableChanged(false), updateCounter(0) {
+}
+
+BrickedVolume::~BrickedVolume() = default;
+
+void BrickedVolume::setBrickRanges(std::vector<BrickRange> ranges) {
+	if(!ranges.empty() && ranges.size() != getBrickCount())
+		throw std::invalid_argument("BrickedVolume::setBrickRanges: Wrong number of ranges.");
+	brickRanges = std::move(ranges);
+	for(uint32_t brick = 0; brick < pageTableData.size() / 4; ++brick) {
+		if(residentBricks.count(brick) == 0)
+			setPageTableEntry(brick, 0, isBrickEmpty(brick) ? STATE_EMPTY : STATE_MISSING);
+	}
+}
+
+void BrickedVolume::computeBrickRanges() {
+	std::vector<BrickRange> ranges(getBrickCount());
+	std::vector<float> voxels(static_cast<size_t>(brickSize) * brickSize * brickSize);
+	const uint32_t stride = brickSize - 1;
+	for(uint32_t bz = 0; bz < bricksZ; ++bz) {
+		for(uint32_t by = 0; by < bricksY; ++by) {
+			for(uint32_t bx = 0; bx < bricksX; ++bx) {
+				BrickRange & range = ranges[getBrickIndex(bx, by, bz)];
+				if(loader && loader(bx * stride, by * stride, bz * stride, brickSize, voxels.data())) {
+					range = getRange(voxels.data(), voxels.size());
+				} else { // unknown: never empty
+					range.minValue = std::numeric_limits<float>::lowest();
+					range.maxValue = std::numeric_limits<float>::max();
+				}
+			}
+		}
+	}
+	setBrickRanges(std::move(ranges));
+}
+
+void BrickedVolume::requestBrick(uint32_t bx, uint32_t by, uint32_t bz) {
+	if(bx < bricksX && by < bricksY && bz < bricksZ)
+		requestedBricks.push_back(getBrickIndex(bx, by, bz));
+}
+
+void BrickedVolume::requestRegion(uint32_t x0, uint32_t y0, uint32_t z0, uint32_t x1, uint32_t y1, uint32_t z1) {
+	if(x1 <= x0 || y1 <= y0 || z1 <= z0)
+		return;
+	const uint32_t stride = brickSize - 1;
+	const uint32_t bx1 = std::min(bricksX - 1, (x1 - 1) / stride), by1 = std::min(bricksY - 1, (y1 - 1) / stride), bz1 = std::min(bricksZ - 1, (z1 - 1) / stride);
+	for(uint32_t bz = std::min(z0 / stride, bz1); bz <= bz1; ++bz) {
+		for(uint32_t by = std::min(y0 / stride, by1); by <= by1; ++by) {
+			for(uint32_t bx = std::min(x0 / stride, bx1); bx <= bx1; ++bx)
+				requestedBricks.push_back(getBrickIndex(bx, by, bz));
+		}
+	}
+}
+
+void BrickedVolume::bind(RenderingContext & context, Shader * shader, uint8_t textureUnit) {
+	if(atlas.isNull())
+		return;
+	context.pushAndSetTexture(textureUnit, atlas.get(), TexUnitUsageParameter::GENERAL_PURPOSE);
+	context.pushAndSetTexture(textureUnit + 1, pageTable.get(), TexUnitUsageParameter::GENERAL_PURPOSE);
+	if(shader != nullptr) {
+		shader->setUniform(context, Uniform("sg_brickAtlas", static_cast<int32_t>(textureUnit)), false);
+		shader->setUniform(context, Uniform("sg_brickPageTable", static_cast<int32_t>(textureUnit + 1)), false);
+		shader->setUniform(context, Uniform("sg_bvVolumeSize", Geometry::Vec3(sizeX, sizeY, sizeZ)), false);
+		shader->setUniform(context, Uniform("sg_bvBrickSize", static_cast<float>(brickSize)), false);
+		shader->setUniform(context, Uniform("sg_bvAtlasSize", static_cast<float>(slotsPerAxis * brickSize)), false);
+	}
+}
+
+void BrickedVolume::unbind(RenderingContext & context, uint8_t textureUnit) {
+	if(atlas.isNull())
+		return;
+	context.popTexture(textureUnit + 1);
+	context.popTexture(textureUnit);
+}
+
+void BrickedVolume::setPageTableEntry(uint32_t brickIndex, uint32_t slot, uint8_t state) {
+	uint8_t * entry = pageTableData.data() + 4 * brickIndex;
+	entry[0] = static_cast<uint8_t>(slot % slotsPerAxis);
+	entry[1] = static_cast<uint8_t>((slot / slotsPerAxis) % slotsPerAxis);
+	entry[2] = static_cast<uint8_t>(slot / (slotsPerAxis * slotsPerAxis));
+	entry[3] = state;
+	pageTableChanged = true;
+}
+
+//! (internal) Expects the atlas to be bound to GL_TEXTURE_3D.
+void BrickedVolume::loadBrick(uint32_t brickIndex, uint32_t slot) {
+	const uint32_t stride = brickSize - 1;
+	const uint32_t bx = brickIndex % bricksX, by = (brickIndex / bricksX) % bricksY, bz = brickIndex / (bricksX * bricksY);
+	std::vector<float> voxels(static_cast<size_t>(brickSize) * brickSize * brickSize);
+	if(!loader || !loader(bx * stride, by * stride, bz * stride, brickSize, voxels.data()))
+		WARN("BrickedVolume: Could not load brick data.");
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexSubImage3D(GL_TEXTURE_3D, 0, static_cast<GLint>((slot % slotsPerAxis) * brickSize),
+					static_cast<GLint>(((slot / slotsPerAxis) % slotsPerAxis) * brickSize),
+					static_cast<GLint>((slot / (slotsPerAxis * slotsPerAxis)) * brickSize),
+					static_cast<GLsizei>(brickSize), static_cast<GLsizei>(brickSize), static_cast<GLsizei>(brickSize),
+					GL_RED, GL_FLOAT, voxels.data());
+}
+
+bool BrickedVolume::init(RenderingContext & context) {
+	GLint max3dSize = 0;
+	glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &max3dSize);
+	const uint32_t maxSlots = std::min(255u, static_cast<uint32_t>(std::max(0, max3dSize)) / brickSize); // slots are stored as bytes
+	slotsPerAxis = std::min(maxSlots, static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(requestedResidentBricks)) - 1.0e-6)));
+	if(slotsPerAxis == 0) {
+		WARN("BrickedVolume: The brick size exceeds the maximal size of 3d textures.");
+		return false;
+	}
+
+	Texture::Format format;
+	format.glTextureType = GL_TEXTURE_3D;
+	format.sizeX = format.sizeY = format.numLayers = slotsPerAxis * brickSize;
+	format.pixelFormat.glLocalDataFormat = GL_RED;
+	format.pixelFormat.glLocalDataType = GL_FLOAT;
+	format.pixelFormat.glInternalFormat = GL_R32F;
+	format.glWrapS = GL_CLAMP_TO_EDGE;
+	format.glWrapT = GL_CLAMP_TO_EDGE;
+	format.glWrapR = GL_CLAMP_TO_EDGE;
+	Util::Reference<Texture> atlasTexture = new Texture(format);
+
+	format.sizeX = bricksX;
+	format.sizeY = bricksY;
+	format.numLayers = bricksZ;
+	format.pixelFormat.glLocalDataFormat = GL_RGBA;
+	format.pixelFormat.glLocalDataType = GL_UNSIGNED_BYTE;
+	format.pixelFormat.glInternalFormat = GL_RGBA8;
+	format.linearMinFilter = false;
+	format.linearMagFilter = false;
+	Util::Reference<Texture> pageTableTexture = new Texture(format);
+	try {
+		atlasTexture->_allocateGLStorage(context, 1);
+		pageTableTexture->_allocateGLStorage(context, 1);
+	} catch(const std::exception & e) {
+		WARN(std::string("BrickedVolume: ") + e.what());
+		return false;
+	}
+	glBindTexture(GL_TEXTURE_3D, atlasTexture->getGLId());
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_3D, pageTableTexture->getGLId());
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	atlas = atlasTexture;
+	pageTable = pageTableTexture;
+
+	for(uint32_t slot = getMaxResidentBricks(); slot > 0; --slot)
+		freeSlots.push_back(slot - 1);
+	pageTableData.assign(4 * static_cast<size_t>(getBrickCount()), 0);
+	for(uint32_t brick = 0; brick < getBrickCount(); ++brick)
+		setPageTableEntry(brick, 0, isBrickEmpty(brick) ? STATE_EMPTY : STATE_MISSING);
+	GET_GL_ERROR();
+	return true;
+}
+
+void BrickedVolume::update(RenderingContext & context) {
+	GLint activeTexture;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	context.pushAndSetTexture(0, nullptr); // store and disable texture unit 0, so that we can use it without side effects.
+	glActiveTexture(GL_TEXTURE0);
+
+	if(!initialized) {
+		initialized = true;
+		if(!init(context)) {
+			atlas = nullptr;
+			pageTable = nullptr;
+		}
+	}
+	if(atlas.isNotNull()) {
+		++updateCounter;
+		std::vector<uint32_t> missingBricks;
+		for(const uint32_t brick : requestedBricks) {
+			if(isBrickEmpty(brick))
+				continue;
+			auto it = residentBricks.find(brick);
+			if(it != residentBricks.end())
+				it->second.lastRequest = updateCounter;
+			else
+				missingBricks.push_back(brick);
+		}
+		requestedBricks.clear();
+		std::sort(missingBricks.begin(), missingBricks.end());
+		missingBricks.erase(std::unique(missingBricks.begin(), missingBricks.end()), missingBricks.end());
+
+		glBindTexture(GL_TEXTURE_3D, atlas->getGLId());
+		uint32_t uploads = 0;
+		for(const uint32_t brick : missingBricks) {
+			if(uploads >= maxUploadsPerUpdate)
+				break;
+			uint32_t slot;
+			if(!freeSlots.empty()) {
+				slot = freeSlots.back();
+				freeSlots.pop_back();
+			} else { // replace the least recently requested brick that has not been requested in this update
+				auto oldest = residentBricks.end();
+				for(auto it = residentBricks.begin(); it != residentBricks.end(); ++it) {
+					if(it->second.lastRequest < updateCounter && (oldest == residentBricks.end() || it->second.lastRequest < oldest->second.lastRequest))
+						oldest = it;
+				}
+				if(oldest == residentBricks.end())
+					break;
+				slot = oldest->second.slot;
+				setPageTableEntry(oldest->first, 0, STATE_MISSING);
+				residentBricks.erase(oldest);
+			}
+			loadBrick(brick, slot);
+			ResidentBrick & resident = residentBricks[brick];
+			resident.slot = slot;
+			resident.lastRequest = updateCounter;
+			setPageTableEntry(brick, slot, STATE_RESIDENT);
+			++uploads;
+		}
+		if(pageTableChanged) {
+			glBindTexture(GL_TEXTURE_3D, pageTable->getGLId());
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, static_cast<GLsizei>(bricksX), static_cast<GLsizei>(bricksY), static_cast<GLsizei>(bricksZ),
+							GL_RGBA, GL_UNSIGNED_BYTE, pageTableData.data());
+			pageTableChanged = false;
+		}
+		GET_GL_ERROR();
+	}
+	context.popTexture(0);
+	glActiveTexture(activeTexture);
+}
+
+}
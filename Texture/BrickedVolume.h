@@ -0,0 +1,169 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_BRICKEDVOLUME_H_
+#define RENDERING_BRICKEDVOLUME_H_
+
+#include "Texture.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace Util {
+class FileName;
+}
+namespace Rendering {
+class RenderingContext;
+class Shader;
+
+/**
+ * Scalar volume (e.g. a voxel dataset of several GB) that is stored in bricks of getBrickSize()^3 voxels. Adjacent
+ * bricks share one layer of voxels, so that the bricks can be filtered linearly without seams; brick (bx, by, bz)
+ * starts at the voxel (bx, by, bz) * (brickSize - 1).
+ *
+ * Only the requested bricks are loaded by the BrickLoader (e.g. from a file, see createFileLoader()) into a 3d atlas
+ * texture. A page table texture with one texel per brick stores the brick's slot in the atlas and whether it is
+ * resident, missing or empty. Empty bricks (the maximal value is not larger than getEmptyThreshold()) are never
+ * loaded; ray casters can skip them (see getShaderInterface()), and the marching cubes mesh builder can use the
+ * brick ranges to skip regions without scanning the voxels (MarchingCubesMeshBuilder::DataSet::bricks).
+ * \code
+ * // fragment shader
+ * // ... getShaderInterface() ...
+ * int state;
+ * float density = sg_sampleBrickedVolume(texCoord, state);
+ * if(state == SG_BRICK_EMPTY) { ... skip the brick ... }
+ * \endcode
+ * \code
+ * volume->requestRegion(0, 0, 0, volume->getSizeX(), volume->getSizeY(), 64);
+ * volume->update(context); // once per frame
+ * volume->bind(context, shader, 0); // uses the units 0 and 1
+ * context.displayMesh(box);
+ * volume->unbind(context, 0);
+ * \endcode
+ * @note The bricks are requested by the application (e.g. for the region inside of the view frustum); if more
+ * bricks are requested than fit into the atlas, the least recently requested ones are replaced.
+ */
+class BrickedVolume : public Util::ReferenceCounter<BrickedVolume> {
+	public:
+		//! Value range of the voxels of one brick.
+		struct BrickRange {
+			float minValue;
+			float maxValue;
+		};
+
+		/*! Function that writes the size^3 voxels starting at voxel (x, y, z) into @p data (x fastest, then y).
+			Voxels outside of the volume have to be clamped to its border. Returns false if the data could not be loaded.	*/
+		typedef std::function<bool (uint32_t x, uint32_t y, uint32_t z, uint32_t size, float * data)> BrickLoader;
+
+		//! GLSL declarations (samplers, uniforms and sampling function) to be included into a shader.
+		static const char * getShaderInterface();
+
+		//! Loader reading a dense volume of 32 bit floats (x fastest, then y, then z) from a file.
+		static BrickLoader createFileLoader(const Util::FileName & fileName, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ);
+
+		/*! (static) Compute the value ranges of the bricks of a dense volume (in parallel).
+			@return One range per brick (x fastest, then y)	*/
+		static std::vector<BrickRange> computeBrickRanges(const float * data, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ, uint32_t brickSize);
+
+		/*! @param brickSize Edge length of a brick in voxels (at least 2)
+			@param maxResidentBricks Minimal number of bricks that fit into the atlas	*/
+		BrickedVolume(uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ, BrickLoader loader, uint32_t brickSize = 32, uint32_t maxResidentBricks = 512);
+		~BrickedVolume();
+
+		uint32_t getSizeX() const							{	return sizeX;	}
+		uint32_t getSizeY() const							{	return sizeY;	}
+		uint32_t getSizeZ() const							{	return sizeZ;	}
+		uint32_t getBrickSize() const						{	return brickSize;	}
+		uint32_t getNumBricksX() const						{	return bricksX;	}
+		uint32_t getNumBricksY() const						{	return bricksY;	}
+		uint32_t getNumBricksZ() const						{	return bricksZ;	}
+		uint32_t getBrickCount() const						{	return bricksX * bricksY * bricksZ;	}
+		uint32_t getBrickIndex(uint32_t bx, uint32_t by, uint32_t bz) const	{	return (bz * bricksY + by) * bricksX + bx;	}
+
+	/*!	@name Brick ranges */
+	// @{
+		//! Values up to the threshold are empty (default: 0).
+		float getEmptyThreshold() const						{	return emptyThreshold;	}
+		void setEmptyThreshold(float value)					{	emptyThreshold = value;	}
+		//! Whether the value ranges of all bricks are known (otherwise no brick is considered empty).
+		bool hasBrickRanges() const							{	return !brickRanges.empty();	}
+		const std::vector<BrickRange> & getBrickRanges() const	{	return brickRanges;	}
+		//! Set the ranges (e.g. stored by a preprocessing step); the size must be getBrickCount().
+		void setBrickRanges(std::vector<BrickRange> ranges);
+		//! Load every brick once to compute the ranges.
+		void computeBrickRanges();
+		bool isBrickEmpty(uint32_t brickIndex) const {
+			return hasBrickRanges() && brickRanges[brickIndex].maxValue <= emptyThreshold;
+		}
+	// @}
+
+	/*!	@name Streaming */
+	// @{
+		uint32_t getResidentBrickCount() const				{	return static_cast<uint32_t>(residentBricks.size());	}
+		//! Number of bricks that fit into the atlas (known after the first update()).
+		uint32_t getMaxResidentBricks() const				{	return slotsPerAxis * slotsPerAxis * slotsPerAxis;	}
+		uint32_t getMaxUploadsPerUpdate() const				{	return maxUploadsPerUpdate;	}
+		void setMaxUploadsPerUpdate(uint32_t count)			{	maxUploadsPerUpdate = count;	}
+
+		void requestBrick(uint32_t bx, uint32_t by, uint32_t bz);
+		//! Request all bricks containing voxels in [x0, x1) x [y0, y1) x [z0, z1).
+		void requestRegion(uint32_t x0, uint32_t y0, uint32_t z0, uint32_t x1, uint32_t y1, uint32_t z1);
+
+		/*! Create the textures (at the first call), load missing requested bricks and replace the least recently
+			requested ones if the atlas is full. Has to be called outside of bind()/unbind().	*/
+		void update(RenderingContext & context);
+	// @}
+
+		//! Bind the atlas to the given unit and the page table to the following one and set the shader's uniforms.
+		void bind(RenderingContext & context, Shader * shader, uint8_t textureUnit);
+		void unbind(RenderingContext & context, uint8_t textureUnit);
+
+		//! nullptr before the first update() or if the textures could not be created.
+		Texture * getAtlasTexture() const					{	return atlas.get();	}
+		Texture * getPageTableTexture() const				{	return pageTable.get();	}
+
+	private:
+		const uint32_t sizeX, sizeY, sizeZ;
+		const uint32_t brickSize;
+		const uint32_t bricksX, bricksY, bricksZ;
+		BrickLoader loader;
+		uint32_t requestedResidentBricks;
+		uint32_t maxUploadsPerUpdate;
+		float emptyThreshold;
+		std::vector<BrickRange> brickRanges;
+
+		Util::Reference<Texture> atlas;
+		Util::Reference<Texture> pageTable;
+		bool initialized;
+		uint32_t slotsPerAxis;
+
+		struct ResidentBrick {
+			uint32_t slot;
+			uint64_t lastRequest;
+		};
+		std::unordered_map<uint32_t, ResidentBrick> residentBricks; //!< brick index -> slot and last update in which it was requested
+		std::vector<uint32_t> freeSlots;
+		std::vector<uint32_t> requestedBricks;
+		//! State and slot of each brick as stored in the page table (rgba8).
+		std::vector<uint8_t> pageTableData;
+		bool pageTableChanged;
+		uint64_t updateCounter;
+
+		bool init(RenderingContext & context);
+		void setPageTableEntry(uint32_t brickIndex, uint32_t slot, uint8_t state);
+		void loadBrick(uint32_t brickIndex, uint32_t slot);
+};
+
+}
+
+#endif /* RENDERING_BRICKEDVOLUME_H_ */
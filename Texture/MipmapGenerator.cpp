@@ -0,0 +1,323 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MipmapGenerator.h"
+#include "Texture.h"
+#include "../MeshUtils/internal/ParallelFor.h"
+#include "../RenderingContext/RenderingContext.h"
+#include "../RenderingContext/RenderingParameters.h"
+#include "../Shader/Shader.h"
+#include "../Shader/ShaderObjectInfo.h"
+#include "../Shader/Uniform.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+#include <Util/Graphics/Bitmap.h>
+#include <Util/Macros.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Rendering {
+namespace MipmapGenerator {
+
+// ----------------------------------------------------------------------------
+// cpu
+
+//! (internal) Number of rows that are filtered by one thread at least.
+static uint32_t getMinRowsPerThread(uint32_t rowLength) {
+	return std::max(1u, 65536u / std::max(1u, rowLength));
+}
+
+template<typename T> static T toTexel(float value);
+template<> uint8_t toTexel<uint8_t>(float value)	{	return static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, value + 0.5f)));	}
+template<> float toTexel<float>(float value)		{	return value;	}
+
+//! (internal) 2x2 box filter; the last row and column are repeated for odd sizes.
+template<typename T, typename sum_t>
+static void downsampleBox(const T * source, uint32_t sourceWidth, uint32_t sourceHeight, T * target, uint32_t width, uint32_t height,
+						uint32_t components, uint32_t layers) {
+	const size_t sourceRowLength = static_cast<size_t>(sourceWidth) * components;
+	MeshUtils::parallelFor(height * layers, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t row = begin; row < end; ++row) {
+			const uint32_t layer = row / height;
+			const uint32_t y = row % height;
+			const T * layerSource = source + static_cast<size_t>(layer) * sourceHeight * sourceRowLength;
+			const T * row0 = layerSource + std::min(2 * y, sourceHeight - 1) * sourceRowLength;
+			const T * row1 = layerSource + std::min(2 * y + 1, sourceHeight - 1) * sourceRowLength;
+			T * targetRow = target + static_cast<size_t>(row) * width * components;
+			for(uint32_t x = 0; x < width; ++x) {
+				const size_t x0 = std::min(2 * x, sourceWidth - 1) * components;
+				const size_t x1 = std::min(2 * x + 1, sourceWidth - 1) * components;
+				for(uint32_t c = 0; c < components; ++c) {
+					const sum_t sum = static_cast<sum_t>(row0[x0 + c]) + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+					targetRow[x * components + c] = static_cast<T>(std::is_integral<T>::value ? (sum + 2) / 4 : sum / 4);
+				}
+			}
+		}
+	}, getMinRowsPerThread(width * components));
+}
+
+//! (internal) Modified Bessel function of the first kind; used by the Kaiser window.
+static double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for(int k = 1; k < 20; ++k) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+typedef std::array<float, 6> kernel_t;
+
+/*! (internal) Weights of the source texels 2x-2 ... 2x+3 for the target texel x: a sinc filter for halving the
+	resolution, windowed with a Kaiser window (alpha = 4) of three source texels radius.	*/
+static const kernel_t & getKaiserKernel() {
+	static const kernel_t kernel = []() {
+		const double pi = 3.14159265358979323846;
+		const double alpha = 4.0, radius = 3.0;
+		kernel_t weights;
+		double sum = 0.0;
+		for(int i = 0; i < 6; ++i) {
+			const double d = std::abs(i - 2.5); // distance to the target texel's center in source texels
+			const double sinc = std::sin(pi * d / 2.0) / (pi * d / 2.0);
+			const double window = besselI0(alpha * std::sqrt(1.0 - (d / radius) * (d / radius))) / besselI0(alpha);
+			weights[i] = static_cast<float>(sinc * window);
+			sum += weights[i];
+		}
+		for(auto & w : weights)
+			w = static_cast<float>(w / sum);
+		return weights;
+	}();
+	return kernel;
+}
+
+//! (internal) Separable Kaiser filter: horizontal pass into a float buffer, then vertical pass.
+template<typename T>
+static void downsampleKaiser(const T * source, uint32_t sourceWidth, uint32_t sourceHeight, T * target, uint32_t width, uint32_t height,
+							uint32_t components, uint32_t layers) {
+	const kernel_t & kernel = getKaiserKernel();
+	const int32_t maxX = static_cast<int32_t>(sourceWidth) - 1;
+	const int32_t maxY = static_cast<int32_t>(sourceHeight) - 1;
+	const size_t rowLength = static_cast<size_t>(width) * components;
+	std::vector<float> horizontal(rowLength * sourceHeight * layers);
+
+	MeshUtils::parallelFor(sourceHeight * layers, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t row = begin; row < end; ++row) {
+			const T * sourceRow = source + static_cast<size_t>(row) * sourceWidth * components;
+			float * targetRow = horizontal.data() + row * rowLength;
+			for(uint32_t x = 0; x < width; ++x) {
+				float * texel = targetRow + x * components;
+				std::fill_n(texel, components, 0.0f);
+				for(int32_t i = 0; i < 6; ++i) {
+					const int32_t sx = std::min(std::max(static_cast<int32_t>(2 * x) - 2 + i, 0), maxX);
+					for(uint32_t c = 0; c < components; ++c)
+						texel[c] += kernel[i] * static_cast<float>(sourceRow[sx * components + c]);
+				}
+			}
+		}
+	}, getMinRowsPerThread(sourceWidth * components));
+
+	MeshUtils::parallelFor(height * layers, [&](uint32_t begin, uint32_t end) {
+		std::vector<float> sum(rowLength);
+		for(uint32_t row = begin; row < end; ++row) {
+			const uint32_t layer = row / height;
+			const uint32_t y = row % height;
+			std::fill(sum.begin(), sum.end(), 0.0f);
+			for(int32_t i = 0; i < 6; ++i) {
+				const int32_t sy = std::min(std::max(static_cast<int32_t>(2 * y) - 2 + i, 0), maxY);
+				const float * sourceRow = horizontal.data() + (static_cast<size_t>(layer) * sourceHeight + sy) * rowLength;
+				const float w = kernel[i];
+				for(size_t j = 0; j < rowLength; ++j)
+					sum[j] += w * sourceRow[j];
+			}
+			T * targetRow = target + static_cast<size_t>(row) * rowLength;
+			for(size_t j = 0; j < rowLength; ++j)
+				targetRow[j] = toTexel<T>(sum[j]);
+		}
+	}, getMinRowsPerThread(width * components));
+}
+
+template<typename T, typename sum_t>
+static void downsample(Filter filter, const uint8_t * source, uint32_t sourceWidth, uint32_t sourceHeight, uint8_t * target,
+						uint32_t width, uint32_t height, uint32_t components, uint32_t layers) {
+	if(filter == Filter::KAISER && sourceWidth > 1 && sourceHeight > 1) {
+		downsampleKaiser<T>(reinterpret_cast<const T *>(source), sourceWidth, sourceHeight, reinterpret_cast<T *>(target),
+							width, height, components, layers);
+	} else {
+		downsampleBox<T, sum_t>(reinterpret_cast<const T *>(source), sourceWidth, sourceHeight, reinterpret_cast<T *>(target),
+							width, height, components, layers);
+	}
+}
+
+bool createLocalMipmaps(Texture & texture, Filter filter) {
+	const Texture::Format & format = texture.getFormat();
+	const TextureType type = texture.getTextureType();
+	Util::Bitmap * bitmap = texture.getLocalBitmap();
+	if(bitmap == nullptr || format.pixelFormat.compressed || (type != TextureType::TEXTURE_2D && type != TextureType::TEXTURE_2D_ARRAY))
+		return false;
+	uint32_t componentSize;
+	switch(format.pixelFormat.glLocalDataType) {
+		case GL_UNSIGNED_BYTE:
+			componentSize = 1;
+			break;
+		case GL_FLOAT:
+			componentSize = 4;
+			break;
+		default:
+			return false;
+	}
+	const uint32_t components = format.getPixelSize() / componentSize;
+	const uint32_t layers = texture.getNumLayers();
+
+	std::vector<Util::Reference<Util::Bitmap>> levels;
+	const uint8_t * source = bitmap->data();
+	uint32_t sourceWidth = texture.getWidth(), sourceHeight = texture.getHeight();
+	while(sourceWidth > 1 || sourceHeight > 1) {
+		const uint32_t width = std::max(1u, sourceWidth / 2);
+		const uint32_t height = std::max(1u, sourceHeight / 2);
+		Util::Reference<Util::Bitmap> level = new Util::Bitmap(width, height * layers, bitmap->getPixelFormat());
+		if(componentSize == 1)
+			downsample<uint8_t, uint32_t>(filter, source, sourceWidth, sourceHeight, level->data(), width, height, components, layers);
+		else
+			downsample<float, float>(filter, source, sourceWidth, sourceHeight, level->data(), width, height, components, layers);
+		source = level->data();
+		sourceWidth = width;
+		sourceHeight = height;
+		levels.push_back(level);
+	}
+	texture.setLocalMipmaps(std::move(levels));
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// gpu
+
+static const char * const downsampleProgram = R"GLSL(
+layout(local_size_x = 8, local_size_y = 8) in;
+#ifdef ARRAY_TEXTURE
+layout(binding = 0) uniform sampler2DArray sourceTexture;
+layout(IMAGE_FORMAT, binding = 0) uniform writeonly image2DArray targetImage;
+#define FETCH(x, y) texelFetch(sourceTexture, ivec3(x, y, p.z), sourceLevel)
+#else
+layout(binding = 0) uniform sampler2D sourceTexture;
+layout(IMAGE_FORMAT, binding = 0) uniform writeonly image2D targetImage;
+#define FETCH(x, y) texelFetch(sourceTexture, ivec2(x, y), sourceLevel)
+#endif
+uniform int sourceLevel;
+
+void main() {
+	const ivec3 p = ivec3(gl_GlobalInvocationID);
+	const ivec2 targetSize = imageSize(targetImage).xy;
+	if(p.x >= targetSize.x || p.y >= targetSize.y)
+		return;
+	const ivec2 sourceMax = textureSize(sourceTexture, sourceLevel).xy - 1;
+	const ivec2 s0 = min(2 * p.xy, sourceMax);
+	const ivec2 s1 = min(2 * p.xy + 1, sourceMax);
+	const vec4 color = (FETCH(s0.x, s0.y) + FETCH(s1.x, s0.y) + FETCH(s0.x, s1.y) + FETCH(s1.x, s1.y)) * 0.25;
+#ifdef ARRAY_TEXTURE
+	imageStore(targetImage, p, color);
+#else
+	imageStore(targetImage, p.xy, color);
+#endif
+}
+)GLSL";
+
+//! (internal) GLSL image format of the texture as it is bound by the RenderingContext, or nullptr.
+static const char * getImageFormatQualifier(const Texture & texture) {
+	const PixelFormatGL & pixelFormat = texture.getFormat().pixelFormat;
+	if(pixelFormat.compressed)
+		return nullptr;
+	switch(pixelFormat.glInternalFormat) {
+		case GL_RGBA:
+			return pixelFormat.glLocalDataType == GL_UNSIGNED_BYTE ? "rgba8" : nullptr;
+#if defined(LIB_GL)
+		case GL_RGBA8:		return "rgba8";
+		case GL_RGBA16F:	return "rgba16f";
+		case GL_RGBA32F:	return "rgba32f";
+		case GL_RG16F:		return "rg16f";
+		case GL_RG32F:		return "rg32f";
+		case GL_R16F:		return "r16f";
+		case GL_R32F:		return "r32f";
+#endif
+		default:
+			return nullptr;
+	}
+}
+
+bool isComputeSupported() {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_image_load_store)
+	static const bool support = isExtensionSupported("GL_ARB_compute_shader") && RenderingContext::isImageBindingSupported();
+	return support;
+#else
+	return false;
+#endif
+}
+
+bool updateMipmaps(RenderingContext & context, Texture & texture, uint32_t firstLevel, uint32_t lastLevel) {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_image_load_store)
+	const TextureType type = texture.getTextureType();
+	const char * imageFormat = getImageFormatQualifier(texture);
+	if(!isComputeSupported() || imageFormat == nullptr || (type != TextureType::TEXTURE_2D && type != TextureType::TEXTURE_2D_ARRAY))
+		return false;
+	if(!texture.getHasMipmaps()) {
+		WARN("MipmapGenerator::updateMipmaps: The texture has no mipmap levels.");
+		return false;
+	}
+	const bool arrayTexture = type == TextureType::TEXTURE_2D_ARRAY;
+	const uint32_t numLevels = static_cast<uint32_t>(std::log2(std::max(texture.getWidth(), texture.getHeight()))) + 1;
+	firstLevel = std::max(1u, firstLevel);
+	lastLevel = std::min(lastLevel, numLevels - 1);
+	if(firstLevel > lastLevel)
+		return true;
+
+	static std::map<std::pair<std::string, bool>, Util::Reference<Shader>> shaders;
+	Util::Reference<Shader> & shader = shaders[std::make_pair(std::string(imageFormat), arrayTexture)];
+	if(shader.isNull()) {
+		std::string source = "#version 430\n#define IMAGE_FORMAT " + std::string(imageFormat) + "\n";
+		if(arrayTexture)
+			source += "#define ARRAY_TEXTURE\n";
+		shader = Shader::createShader(Shader::USE_UNIFORMS);
+		shader->attachShaderObject(ShaderObjectInfo::createCompute(source + downsampleProgram));
+	}
+
+	context.pushAndSetShader(shader.get());
+	context.pushAndSetTexture(0, &texture, TexUnitUsageParameter::GENERAL_PURPOSE);
+	for(uint32_t level = firstLevel; level <= lastLevel; ++level) {
+		ImageBindParameters target(&texture);
+		target.setLevel(level);
+		target.setMultiLayer(arrayTexture);
+		target.setReadOperations(false);
+		target.setWriteOperations(true);
+		context.pushAndSetBoundImage(0, target);
+		shader->setUniform(context, Uniform("sourceLevel", static_cast<int32_t>(level - 1)));
+		const uint32_t width = std::max(1u, texture.getWidth() >> level);
+		const uint32_t height = std::max(1u, texture.getHeight() >> level);
+		context.dispatchCompute((width + 7) / 8, (height + 7) / 8, arrayTexture ? texture.getNumLayers() : 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+		context.popBoundImage(0);
+	}
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+	context.popTexture(0);
+	context.popShader();
+	GET_GL_ERROR();
+	return true;
+#else
+	return false;
+#endif
+}
+
+}
+}
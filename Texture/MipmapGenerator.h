@@ -0,0 +1,50 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MIPMAPGENERATOR_H_
+#define RENDERING_MIPMAPGENERATOR_H_
+
+#include <cstdint>
+
+namespace Rendering {
+class RenderingContext;
+class Texture;
+
+/*! Mipmap generation without glGenerateMipmap.
+	- createLocalMipmaps() filters the local data on the cpu. It does not use OpenGL and can therefore be called by
+		loader threads; the levels are stored with the texture and uploaded together with its data.
+	- updateMipmaps() downsamples a range of levels of a gl texture (e.g. a render target) with a compute shader.	*/
+namespace MipmapGenerator {
+
+enum class Filter : uint8_t {
+	BOX,	//!< Average of 2x2 texels
+	KAISER	//!< Kaiser-windowed sinc (6x6 texels); sharper than the box filter
+};
+
+/*! Compute all mipmap levels of the texture's local data and store them in the texture (see Texture::setLocalMipmaps()).
+	The rows of each level are filtered in parallel.
+	@return false if the texture has no local data or its format is not supported (only uncompressed TEXTURE_2D and
+		TEXTURE_2D_ARRAY textures with unsigned byte or float components).	*/
+bool createLocalMipmaps(Texture & texture, Filter filter = Filter::BOX);
+
+//! Requires OpenGL 4.3 (compute shaders and image load/store).
+bool isComputeSupported();
+
+/*! Recompute the levels [@p firstLevel, @p lastLevel] of the gl texture using a compute shader (box filter); each level
+	is computed from the previous one. Only the changed part of a mipmap pyramid has to be updated this way, e.g. the
+	first levels of a bloom chain. The texture must already have storage for the levels (e.g. by createMipmaps()).
+	@return false if the texture's type (TEXTURE_2D, TEXTURE_2D_ARRAY) or internal format (GL_RGBA8, GL_RGBA16F,
+		GL_RGBA32F, GL_RG16F, GL_RG32F, GL_R16F, GL_R32F) is not supported; use Texture::createMipmaps() then.	*/
+bool updateMipmaps(RenderingContext & context, Texture & texture, uint32_t firstLevel = 1, uint32_t lastLevel = 1000);
+
+}
+}
+
+#endif /* RENDERING_MIPMAPGENERATOR_H_ */
@@ -0,0 +1,115 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "RawHeightFieldReader.h"
+#include "Texture.h"
+#include "../Serialization/internal/MappedFile.h"
+#include "../GLHeader.h"
+#include <Util/Macros.h>
+#include <cmath>
+#include <vector>
+
+namespace Rendering {
+
+RawHeightFieldReader::RawHeightFieldReader(const std::string & localPath, uint32_t _width) : width(0), height(0), path(localPath) {
+	uint64_t fileSize = 0;
+	if(MappedFile::isSupported()) {
+		mapping.reset(new MappedFile(localPath, false));
+		if(mapping->data != nullptr)
+			fileSize = mapping->size;
+		else
+			mapping.reset();
+	}
+	if(!mapping) {
+		stream.open(localPath.c_str(), std::ios_base::in | std::ios_base::binary);
+		if(stream.good()) {
+			stream.seekg(0, std::ios_base::end);
+			fileSize = static_cast<uint64_t>(stream.tellg());
+		}
+	}
+	if(fileSize == 0) {
+		WARN("RawHeightFieldReader: Could not open file \"" + localPath + "\".");
+		return;
+	}
+	const uint64_t numValues = fileSize / 2;
+	if(_width == 0) {
+		const uint64_t size = static_cast<uint64_t>(std::sqrt(static_cast<double>(numValues)));
+		if(size * size != numValues || fileSize % 2 != 0) {
+			WARN("RawHeightFieldReader: Height field is not quadratic for file \"" + localPath + "\".");
+			return;
+		}
+		width = height = static_cast<uint32_t>(size);
+	} else {
+		width = _width;
+		height = static_cast<uint32_t>(numValues / width);
+		if(height == 0)
+			width = 0;
+	}
+}
+
+RawHeightFieldReader::~RawHeightFieldReader() = default;
+
+bool RawHeightFieldReader::readRegion(uint32_t x, uint32_t y, uint32_t w, uint32_t h, float * target, uint8_t numComponents,
+									size_t targetRowStride, bool flip) {
+	if(!isValid() || target == nullptr || (numComponents != 1 && numComponents != 3) ||
+			static_cast<uint64_t>(x) + w > width || static_cast<uint64_t>(y) + h > height) {
+		WARN("RawHeightFieldReader::readRegion: Invalid region.");
+		return false;
+	}
+	if(targetRowStride == 0)
+		targetRowStride = static_cast<size_t>(w) * numComponents;
+
+	std::vector<uint8_t> rowBuffer;
+	if(!mapping)
+		rowBuffer.resize(static_cast<size_t>(w) * 2);
+	const float scale = 1.0f / static_cast<float>(0xFFFF);
+	for(uint32_t row = 0; row < h; ++row) {
+		const uint64_t offset = (static_cast<uint64_t>(y + row) * width + x) * 2;
+		const uint8_t * source;
+		if(mapping) {
+			source = mapping->data + offset;
+		} else {
+			stream.seekg(static_cast<std::streamoff>(offset));
+			stream.read(reinterpret_cast<char *>(rowBuffer.data()), static_cast<std::streamsize>(rowBuffer.size()));
+			if(!stream) {
+				stream.clear();
+				WARN("RawHeightFieldReader::readRegion: Error reading file \"" + path + "\".");
+				return false;
+			}
+			source = rowBuffer.data();
+		}
+		float * out = target + (flip ? h - 1 - row : row) * targetRowStride;
+		for(uint32_t i = 0; i < w; ++i) {
+			const float f = static_cast<float>(source[2 * i] | (source[2 * i + 1] << 8)) * scale;
+			for(uint8_t c = 0; c < numComponents; ++c)
+				*out++ = f;
+		}
+	}
+	return true;
+}
+
+Util::Reference<Texture> RawHeightFieldReader::createTexture(uint32_t x, uint32_t y, uint32_t w, uint32_t h, bool flip) {
+	Texture::Format format;
+	format.glTextureType = GL_TEXTURE_2D;
+	format.sizeX = w;
+	format.sizeY = h;
+	format.pixelFormat.glLocalDataType = GL_FLOAT;
+	format.pixelFormat.glInternalFormat = GL_RGB;
+	format.pixelFormat.glLocalDataFormat = GL_RGB;
+
+	Util::Reference<Texture> texture = new Texture(format);
+	texture->allocateLocalData();
+	if(!readRegion(x, y, w, h, reinterpret_cast<float *>(texture->getLocalData()), 3, 0, flip))
+		return nullptr;
+	texture->dataChanged();
+	return texture;
+}
+
+}
@@ -0,0 +1,75 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_RAWHEIGHTFIELDREADER_H_
+#define RENDERING_RAWHEIGHTFIELDREADER_H_
+
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace Rendering {
+class MappedFile;
+class Texture;
+
+/**
+ * Reader for large height fields stored as RAW files of 16 bit unsigned little-endian values (see
+ * TextureUtils::createTextureFromRAW()). The file is memory mapped (if supported, otherwise the needed rows are read
+ * from a stream), so that rectangular regions can be extracted without loading the whole file, e.g. for streaming the
+ * tiles of a terrain.
+ *
+ * The values are converted to floats in [0,1] directly into the target memory, which can be the local data of a
+ * texture or a mapped pixel unpack buffer. A vertical flip (as done by createTextureFromRAW()) is part of the copy.
+ * \code
+ * RawHeightFieldReader reader("dem.raw");
+ * Util::Reference<Texture> tile = reader.createTexture(x * 512, y * 512, 513, 513);
+ * \endcode
+ */
+class RawHeightFieldReader {
+	public:
+		/*! Open the file. If @p width is 0, the height field has to be quadratic and its size is derived from the file size;
+			otherwise the height is the number of complete rows of the given width.	*/
+		explicit RawHeightFieldReader(const std::string & localPath, uint32_t width = 0);
+		~RawHeightFieldReader();
+		RawHeightFieldReader(const RawHeightFieldReader &) = delete;
+		RawHeightFieldReader & operator=(const RawHeightFieldReader &) = delete;
+
+		bool isValid() const							{	return width > 0 && height > 0;	}
+		//! Whether the file is memory mapped (otherwise the rows are read from a stream).
+		bool isMapped() const							{	return mapping != nullptr;	}
+		uint32_t getWidth() const						{	return width;	}
+		uint32_t getHeight() const						{	return height;	}
+
+		/*! Convert the values of the region starting at column @p x and row @p y of the file into floats.
+			@param target Memory for @p h rows of @p w texels with @p numComponents (1 or 3) equal floats each
+			@param targetRowStride Distance of the target rows in floats (0: w * numComponents)
+			@param flip If @c true, the last row of the region is written first.
+			@return @c false if the region exceeds the height field or cannot be read.	*/
+		bool readRegion(uint32_t x, uint32_t y, uint32_t w, uint32_t h, float * target, uint8_t numComponents = 3,
+						size_t targetRowStride = 0, bool flip = true);
+
+		/*! Create a texture containing the given region (GL_RGB, GL_FLOAT like createTextureFromRAW()).
+			@return @c nullptr on failure.	*/
+		Util::Reference<Texture> createTexture(uint32_t x, uint32_t y, uint32_t w, uint32_t h, bool flip = true);
+
+	private:
+		std::unique_ptr<MappedFile> mapping;
+		std::ifstream stream;
+		uint32_t width;
+		uint32_t height;
+		std::string path;
+};
+
+}
+
+#endif /* RENDERING_RAWHEIGHTFIELDREADER_H_ */
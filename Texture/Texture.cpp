@@ -11,9 +11,11 @@
 #include "Texture.h"
 #include "../GLHeader.h"
 #include "../BufferObject.h"
+#include "../GLTrace.h"
 #include "../Helper.h"
 #include "../RenderingContext/RenderingContext.h"
 #include "TextureUtils.h"
+#include "TextureResidencyManager.h"
 #include <Util/Graphics/Bitmap.h>
 #include <Util/Graphics/PixelFormat.h>
 #include <Util/Macros.h>
@@ -27,7 +29,21 @@
 
 namespace Rendering {
 
+//! (internal) Record the creation of a texture with its sampling parameters.
+static void traceCreateTexture(uint32_t glId, const Texture::Format & format) {
+	GLTrace::record(GLTrace::CREATE_TEXTURE, {glId, format.glTextureType,
+			static_cast<uint32_t>(format.glWrapS), static_cast<uint32_t>(format.glWrapT), static_cast<uint32_t>(format.glWrapR),
+			static_cast<uint32_t>(format.linearMagFilter ? GL_LINEAR : GL_NEAREST), static_cast<uint32_t>(format.linearMinFilter ? GL_LINEAR : GL_NEAREST)});
+}
 
+//! (internal) Record the upload of an uncompressed image; data may be nullptr.
+static void traceTexImage(uint32_t glId, uint32_t target, int level, const Texture::Format & format,
+						  int32_t width, int32_t height, int32_t depth, const uint8_t * data) {
+	GLTrace::record(GLTrace::TEX_IMAGE, {glId, target, static_cast<uint32_t>(level), format.pixelFormat.glInternalFormat,
+			static_cast<uint32_t>(width), static_cast<uint32_t>(height), static_cast<uint32_t>(depth),
+			format.pixelFormat.glLocalDataFormat, format.pixelFormat.glLocalDataType},
+			data, static_cast<std::size_t>(format.getPixelSize()) * width * height * depth);
+}
 
 Texture::Format::Format():
 		sizeX(0), sizeY(0), numLayers(1),
@@ -77,11 +93,41 @@ uint32_t Texture::Format::getPixelSize()const{
 	}
 	return pixelSize;
 }
+
+uint32_t Texture::Format::getLevelDataSize(uint32_t level)const{
+	const uint32_t width = std::max(1u, sizeX >> level);
+	const uint32_t height = std::max(1u, sizeY >> level);
+	uint32_t layers = numLayers;
+#ifdef LIB_GL
+	if(glTextureType == GL_TEXTURE_3D)
+		layers = std::max(1u, numLayers >> level);
+#endif
+	if(!pixelFormat.compressed)
+		return getPixelSize() * width * height * layers;
+
+	uint32_t blockWidth, blockHeight, blockSize;
+	if(!TextureUtils::getCompressedBlockSize(pixelFormat.glInternalFormat, blockWidth, blockHeight, blockSize))
+		return level == 0 ? compressedImageSize : 0;
+	return ((width + blockWidth - 1) / blockWidth) * ((height + blockHeight - 1) / blockHeight) * blockSize * layers;
+}
+
+uint32_t Texture::Format::getLevelDataOffset(uint32_t level)const{
+	uint32_t offset = 0;
+	for(uint32_t l = 0; l < level; ++l)
+		offset += getLevelDataSize(l);
+	return offset;
+}
+
+uint32_t Texture::Format::getCompressedDataSize()const{
+	if(compressedImageSize != 0)
+		return compressedImageSize;
+	return getLevelDataOffset(std::max(1u, numMipLevels));
+}
 // ----------------------------------------------------
 
 //! [ctor]
 Texture::Texture(Format _format):
-		glId(0),format(std::move(_format)),dataHasChanged(true),hasMipmaps(false),mipmapCreationIsPlanned(false),
+		residentBaseLevel(0),streamedMipLevels(false),immutableStorage(false),sparseStorage(false),placeholderGLId(0),bindlessHandle(0),bindlessResident(false),memoryCategory(MemoryRegistry::TEXTURE),accountedMemory(0),residencyManager(nullptr),glId(0),format(std::move(_format)),dataHasChanged(true),hasMipmaps(false),mipmapCreationIsPlanned(false),
 		_pixelDataSize(format.getPixelSize()) {
 	switch(format.glTextureType){
 #if defined(LIB_GL)
@@ -123,6 +169,7 @@ Texture::Texture(Format _format):
 				throw std::logic_error("Texture: TEXTURE_BUFFER expects numLayers == 1 && sizeY == 1.");
 			tType = TextureType::TEXTURE_BUFFER;
 			bufferObject.reset( new BufferObject );
+			bufferObject->setMemoryCategory(MemoryRegistry::TEXTURE);
 			break;
 		case GL_TEXTURE_2D_MULTISAMPLE:
 			tType = TextureType::TEXTURE_2D_MULTISAMPLE;
@@ -152,11 +199,35 @@ void Texture::_createGLID(RenderingContext & context){
 	}
 	glPixelStorei(GL_UNPACK_ALIGNMENT,1);
 	GET_GL_ERROR();
+#if defined(LIB_GL) && defined(GL_ARB_direct_state_access)
+	if(isDirectStateAccessSupported()) {
+		glCreateTextures(format.glTextureType, 1, &glId);
+		if(!glId){
+			GET_GL_ERROR();
+			throw std::runtime_error("Texture::_createGLID: Could not create texture.");
+		}
+		++RenderingContext::_getFrameCounters().texturesCreated;
+		if(GLTrace::isRecording())
+			traceCreateTexture(glId, format);
+		if( tType!=TextureType::TEXTURE_BUFFER && tType!=TextureType::TEXTURE_2D_MULTISAMPLE ){
+			glTextureParameteri(glId,GL_TEXTURE_WRAP_S,format.glWrapS);
+			glTextureParameteri(glId,GL_TEXTURE_WRAP_T,format.glWrapT);
+			glTextureParameteri(glId,GL_TEXTURE_WRAP_R,format.glWrapR);
+			glTextureParameteri(glId,GL_TEXTURE_MAG_FILTER,format.linearMagFilter ? GL_LINEAR : GL_NEAREST);
+			glTextureParameteri(glId,GL_TEXTURE_MIN_FILTER,format.linearMinFilter ? GL_LINEAR : GL_NEAREST);
+		}
+		GET_GL_ERROR();
+		return;
+	}
+#endif
 	glGenTextures(1,&glId);
 	if(!glId){
 		GET_GL_ERROR();
 		throw std::runtime_error("Texture::_createGLID: Could not create texture.");
 	}
+	++RenderingContext::_getFrameCounters().texturesCreated;
+	if(GLTrace::isRecording())
+		traceCreateTexture(glId, format);
 
 	GLint activeTexture;
 	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
@@ -189,6 +260,18 @@ void Texture::createMipmaps(RenderingContext & context) {
 		_uploadGLTexture(context);
 
 	mipmapCreationIsPlanned = false;
+	const bool integerTexture = format.pixelFormat.glLocalDataType == GL_UNSIGNED_INT || format.pixelFormat.glLocalDataType == GL_INT;
+#if defined(LIB_GL) && defined(GL_ARB_direct_state_access)
+	if(isDirectStateAccessSupported() && !integerTexture) {
+		glGenerateTextureMipmap(glId);
+		RENDERING_GL_TRACE(GENERATE_MIPMAP, {glId, format.glTextureType});
+		hasMipmaps = true;
+		updateAccountedMemory(true);
+		glTextureParameteri(glId,GL_TEXTURE_MIN_FILTER,format.linearMinFilter ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
+		GET_GL_ERROR();
+		return;
+	}
+#endif
 	static const bool mipmapCreationSupported = isExtensionSupported("GL_EXT_framebuffer_object");
 	if(mipmapCreationSupported){
 
@@ -200,21 +283,23 @@ void Texture::createMipmaps(RenderingContext & context) {
 		glBindTexture(format.glTextureType,glId);
 		GET_GL_ERROR();
 
-		if(format.pixelFormat.glLocalDataType == GL_UNSIGNED_INT || format.pixelFormat.glLocalDataType == GL_INT) {
+		if(integerTexture) {
 			// for integer textures glGenerateMipmap is prohibited, therefore just allocate the storage
+			// (immutable storage already contains all levels)
 			int maxLevel = std::log2(std::max(getWidth(), getHeight()));
-			for(int level=1; level<=maxLevel; ++level)
+			for(int level=1; level<=maxLevel && !immutableStorage; ++level)
 				_uploadGLTexture(context, level);
 		} else {
 			#ifdef LIB_GL
 				glGenerateMipmap(format.glTextureType);
+				RENDERING_GL_TRACE(GENERATE_MIPMAP, {glId, format.glTextureType});
 			#elif defined(LIB_GLESv2)
 				glGenerateMipmap(GL_TEXTURE_2D);
 			#endif
 		}
 
 		hasMipmaps = true;
-		if(format.pixelFormat.glLocalDataType == GL_UNSIGNED_INT || format.pixelFormat.glLocalDataType == GL_INT) {
+		if(integerTexture) {
 		  glTexParameteri(format.glTextureType,GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		} else {
 		  glTexParameteri(format.glTextureType,GL_TEXTURE_MIN_FILTER,format.linearMinFilter ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
@@ -223,10 +308,196 @@ void Texture::createMipmaps(RenderingContext & context) {
 		GET_GL_ERROR();
 		context.popTexture(0);
 		glActiveTexture(activeTexture);
+		updateAccountedMemory(true);
+	}
+}
+
+void Texture::setLocalMipmaps(std::vector<Util::Reference<Util::Bitmap>> levels) {
+	localMipmaps = std::move(levels);
+	if(!localMipmaps.empty()) {
+		mipmapCreationIsPlanned = false;
+		dataHasChanged = true;
 	}
 }
 
+void Texture::_uploadLocalMipmaps(RenderingContext & context) {
+	if(!glId || localMipmaps.empty())
+		return;
+	GLint activeTexture;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	context.pushAndSetTexture(0,nullptr); // store and disable texture unit 0, so that we can use it without side effects.
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(format.glTextureType,glId);
+	uploadLocalMipmapLevels();
+	GET_GL_ERROR();
+	context.popTexture(0);
+	glActiveTexture(activeTexture);
+}
+
+//! (internal) Uploads the local mipmap levels to the bound texture.
+void Texture::uploadLocalMipmapLevels() {
+	if(localMipmaps.empty() || format.pixelFormat.compressed || (tType != TextureType::TEXTURE_2D && tType != TextureType::TEXTURE_2D_ARRAY))
+		return;
+	const GLenum target = static_cast<GLenum>(format.glTextureType);
+	const GLenum localFormat = static_cast<GLenum>(format.pixelFormat.glLocalDataFormat);
+	const GLenum localType = static_cast<GLenum>(format.pixelFormat.glLocalDataType);
+	glPixelStorei(GL_UNPACK_ALIGNMENT,1);
+	GLint level = 1;
+	for(const auto & bitmap : localMipmaps) {
+		const GLsizei width = std::max(1, static_cast<GLsizei>(getWidth()) >> level);
+		const GLsizei height = std::max(1, static_cast<GLsizei>(getHeight()) >> level);
+		if(bitmap.isNull() || bitmap->getWidth() != static_cast<uint32_t>(width) || bitmap->getHeight() != static_cast<uint32_t>(height) * getNumLayers()) {
+			WARN("Texture: Local mipmap level has an invalid size.");
+			break;
+		}
+		if(tType == TextureType::TEXTURE_2D) {
+			if(immutableStorage)
+				glTexSubImage2D(target, level, 0, 0, width, height, localFormat, localType, bitmap->data());
+			else
+				glTexImage2D(target, level, static_cast<GLint>(format.pixelFormat.glInternalFormat), width, height, 0, localFormat, localType, bitmap->data());
+		}
+#ifdef LIB_GL
+		else {
+			const GLsizei depth = static_cast<GLsizei>(getNumLayers());
+			if(immutableStorage)
+				glTexSubImage3D(target, level, 0, 0, 0, width, height, depth, localFormat, localType, bitmap->data());
+			else
+				glTexImage3D(target, level, static_cast<GLint>(format.pixelFormat.glInternalFormat), width, height, depth, 0, localFormat, localType, bitmap->data());
+		}
+#endif
+		++level;
+	}
+#ifdef LIB_GL
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, level - 1);
+#endif
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, format.linearMinFilter ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST);
+	hasMipmaps = true;
+}
+
+void Texture::_setResidentMipLevels(RenderingContext & context, uint32_t baseLevel) {
+	if(format.pixelFormat.compressed || (tType != TextureType::TEXTURE_2D && tType != TextureType::TEXTURE_2D_ARRAY) || localBitmap.isNull())
+		throw std::runtime_error("Texture::_setResidentMipLevels: Unsupported texture.");
+	const uint32_t numLevels = 1 + static_cast<uint32_t>(localMipmaps.size());
+	baseLevel = std::min(baseLevel, numLevels - 1);
+	if(glId && (bindlessHandle != 0 || immutableStorage || !streamedMipLevels || dataHasChanged))
+		removeGLData();
+	if(!glId) {
+		_createGLID(context);
+		streamedMipLevels = true;
+		residentBaseLevel = numLevels;
+	}
+	if(baseLevel == residentBaseLevel)
+		return;
+
+	GLint activeTexture;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	context.pushAndSetTexture(0,nullptr); // store and disable texture unit 0, so that we can use it without side effects.
+	glActiveTexture(GL_TEXTURE0);
+	const GLenum target = static_cast<GLenum>(format.glTextureType);
+	glBindTexture(target,glId);
+	glPixelStorei(GL_UNPACK_ALIGNMENT,1);
+
+	const GLint internalFormat = static_cast<GLint>(format.pixelFormat.glInternalFormat);
+	const GLenum localFormat = static_cast<GLenum>(format.pixelFormat.glLocalDataFormat);
+	const GLenum localType = static_cast<GLenum>(format.pixelFormat.glLocalDataType);
+	// levels >= residentBaseLevel are already uploaded; levels < baseLevel are released by specifying empty images
+	for(uint32_t level = 0; level < numLevels; ++level) {
+		const bool uploaded = level >= residentBaseLevel;
+		const bool needed = level >= baseLevel;
+		if(uploaded == needed)
+			continue;
+		const GLsizei width = needed ? std::max(1, static_cast<GLsizei>(getWidth()) >> level) : 0;
+		const GLsizei height = needed ? std::max(1, static_cast<GLsizei>(getHeight()) >> level) : 0;
+		const uint8_t * data = needed ? (level == 0 ? localBitmap->data() : localMipmaps[level - 1]->data()) : nullptr;
+		if(tType == TextureType::TEXTURE_2D) {
+			glTexImage2D(target, static_cast<GLint>(level), internalFormat, width, height, 0, localFormat, localType, data);
+		}
+#ifdef LIB_GL
+		else {
+			glTexImage3D(target, static_cast<GLint>(level), internalFormat, width, height, needed ? static_cast<GLsizei>(getNumLayers()) : 0, 0,
+							localFormat, localType, data);
+		}
+#endif
+	}
+#ifdef LIB_GL
+	glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(baseLevel));
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(numLevels - 1));
+#endif
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, format.linearMinFilter ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST);
+	GET_GL_ERROR();
+	context.popTexture(0);
+	glActiveTexture(activeTexture);
+
+	residentBaseLevel = baseLevel;
+	dataHasChanged = false;
+	mipmapCreationIsPlanned = false;
+	hasMipmaps = true;
+	size_t size = 0;
+	for(uint32_t level = baseLevel; level < numLevels; ++level)
+		size += format.getLevelDataSize(level);
+	MemoryRegistry::add(memoryCategory, static_cast<int64_t>(size) - static_cast<int64_t>(accountedMemory));
+	accountedMemory = size;
+}
+
+//! (internal) Uploads all mipmap levels stored in the local data of a compressed texture to the bound texture.
+static void uploadCompressedLevels(TextureType type, const Texture::Format & format, const uint8_t * data) {
+	const GLenum internalFormat = static_cast<GLenum>(format.pixelFormat.glInternalFormat);
+	for(uint32_t level = 0; level < std::max(1u, format.numMipLevels); ++level) {
+		const GLsizei width = std::max(1, static_cast<GLsizei>(format.sizeX) >> level);
+		const GLsizei height = std::max(1, static_cast<GLsizei>(format.sizeY) >> level);
+		const GLsizei levelSize = static_cast<GLsizei>(format.getLevelDataSize(level));
+		const uint8_t * levelData = data ? data + format.getLevelDataOffset(level) : nullptr;
+		switch(type) {
+			case TextureType::TEXTURE_2D:
+				glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), internalFormat, width, height, 0, levelSize, levelData);
+				break;
+			case TextureType::TEXTURE_CUBE_MAP: {
+				const GLsizei faceSize = levelSize / 6;
+				for(uint_fast8_t face = 0; face < 6; ++face) {
+					glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, static_cast<GLint>(level), internalFormat, width, height, 0,
+											faceSize, levelData ? levelData + face * faceSize : nullptr);
+				}
+				break;
+			}
+#ifdef LIB_GL
+			case TextureType::TEXTURE_2D_ARRAY:
+			case TextureType::TEXTURE_3D:
+			case TextureType::TEXTURE_CUBE_MAP_ARRAY: {
+				const GLsizei depth = type == TextureType::TEXTURE_3D ? std::max(1, static_cast<GLsizei>(format.numLayers) >> level) :
+																		static_cast<GLsizei>(format.numLayers);
+				glCompressedTexImage3D(static_cast<GLenum>(format.glTextureType), static_cast<GLint>(level), internalFormat,
+										width, height, depth, 0, levelSize, levelData);
+				break;
+			}
+#endif
+			default:
+				break;
+		}
+	}
+}
+
+void Texture::initStoredMipmaps() {
+	if(!format.pixelFormat.compressed || format.numMipLevels <= 1)
+		return;
+	hasMipmaps = true;
+#if defined(LIB_GL) && defined(GL_ARB_direct_state_access)
+	if(isDirectStateAccessSupported()) {
+		glTextureParameteri(glId, GL_TEXTURE_MIN_FILTER, format.linearMinFilter ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
+		glTextureParameteri(glId, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(format.numMipLevels - 1));
+		return;
+	}
+#endif
+	glTexParameteri(format.glTextureType, GL_TEXTURE_MIN_FILTER, format.linearMinFilter ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
+#ifdef LIB_GL
+	glTexParameteri(format.glTextureType, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(format.numMipLevels - 1));
+#endif
+}
+
 void Texture::_uploadGLTexture(RenderingContext & context, int level/*=0*/) {
+	// the storage of a texture with a bindless handle or allocated by glTexStorage is immutable
+	if(bindlessHandle!=0 || immutableStorage || streamedMipLevels)
+		removeGLData();
+
 	GLint activeTexture;
 	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
 
@@ -250,15 +521,14 @@ void Texture::_uploadGLTexture(RenderingContext & context, int level/*=0*/) {
 			glTexImage1D(GL_TEXTURE_1D, level, static_cast<GLint>(format.pixelFormat.glInternalFormat),
 					width, 0, static_cast<GLenum>(format.pixelFormat.glLocalDataFormat),
 					static_cast<GLenum>(format.pixelFormat.glLocalDataType), getLocalData());
+			if(GLTrace::isRecording())
+				traceTexImage(glId, GL_TEXTURE_1D, level, format, width, 1, 1, getLocalData());
 			break;
 		}
 #endif
 		case TextureType::TEXTURE_2D: {
 			if(format.pixelFormat.compressed) {
-				glCompressedTexImage2D(GL_TEXTURE_2D, level, static_cast<GLint>(format.pixelFormat.glInternalFormat),
-										width, height, 0,
-										static_cast<GLsizei>(format.compressedImageSize),
-										getLocalData());
+				uploadCompressedLevels(tType, format, getLocalData());
 			}else{
 					GET_GL_ERROR();
 				glTexImage2D(GL_TEXTURE_2D, level, static_cast<GLint>(format.pixelFormat.glInternalFormat),
@@ -266,10 +536,16 @@ void Texture::_uploadGLTexture(RenderingContext & context, int level/*=0*/) {
 										static_cast<GLenum>(format.pixelFormat.glLocalDataFormat), 
 										static_cast<GLenum>(format.pixelFormat.glLocalDataType), getLocalData());
 						GET_GL_ERROR();
+				if(GLTrace::isRecording())
+					traceTexImage(glId, GL_TEXTURE_2D, level, format, width, height, 1, getLocalData());
 			}
 			break;
 		}
 		case TextureType::TEXTURE_CUBE_MAP:{
+			if(format.pixelFormat.compressed) {
+				uploadCompressedLevels(tType, format, getLocalData());
+				break;
+			}
 			Util::Reference<Util::PixelAccessor> pa =  Util::PixelAccessor::create(getLocalBitmap());
 			if(pa){ // local data available?
 				for(uint_fast8_t layer =0; layer < 6; layer++){
@@ -277,6 +553,8 @@ void Texture::_uploadGLTexture(RenderingContext & context, int level/*=0*/) {
 								width, height, 0,
 								static_cast<GLenum>(format.pixelFormat.glLocalDataFormat), 
 								static_cast<GLenum>(format.pixelFormat.glLocalDataType), pa->_ptr<uint8_t>(0, height * layer));
+					if(GLTrace::isRecording())
+						traceTexImage(glId, GL_TEXTURE_CUBE_MAP_POSITIVE_X + layer, level, format, width, height, 1, pa->_ptr<uint8_t>(0, height * layer));
 				}
 			}
 			else{ // -> just allocate gpu data.
@@ -285,6 +563,8 @@ void Texture::_uploadGLTexture(RenderingContext & context, int level/*=0*/) {
 								width, height, 0,
 								static_cast<GLenum>(format.pixelFormat.glLocalDataFormat), 
 								static_cast<GLenum>(format.pixelFormat.glLocalDataType), nullptr);
+					if(GLTrace::isRecording())
+						traceTexImage(glId, GL_TEXTURE_CUBE_MAP_POSITIVE_X + layer, level, format, width, height, 1, nullptr);
 				}
 			}
 			break;
@@ -315,6 +595,7 @@ void Texture::_uploadGLTexture(RenderingContext & context, int level/*=0*/) {
 			}
 			// bind the buffer to the texture
 			glTexBuffer( GL_TEXTURE_BUFFER, format, bufferObject->getGLId() );
+			RENDERING_GL_TRACE(TEX_BUFFER, {format, bufferObject->getGLId()});
 			break;
 		
 		}
@@ -323,20 +604,30 @@ void Texture::_uploadGLTexture(RenderingContext & context, int level/*=0*/) {
 							width, depth, 0,
 							static_cast<GLenum>(format.pixelFormat.glLocalDataFormat), 
 							static_cast<GLenum>(format.pixelFormat.glLocalDataType), getLocalData());
+			if(GLTrace::isRecording())
+				traceTexImage(glId, GL_TEXTURE_1D_ARRAY, level, format, width, depth, 1, getLocalData());
 			break;
 		}
 		case  TextureType::TEXTURE_2D_ARRAY:
 		case  TextureType::TEXTURE_3D:
 		case  TextureType::TEXTURE_CUBE_MAP_ARRAY:{
+			if(format.pixelFormat.compressed) {
+				uploadCompressedLevels(tType, format, getLocalData());
+				break;
+			}
 			glTexImage3D(static_cast<GLenum>(format.glTextureType), level, static_cast<GLint>(format.pixelFormat.glInternalFormat),
 							width, height, depth, 0,
 							static_cast<GLenum>(format.pixelFormat.glLocalDataFormat), 
 							static_cast<GLenum>(format.pixelFormat.glLocalDataType), getLocalData());
+			if(GLTrace::isRecording())
+				traceTexImage(glId, format.glTextureType, level, format, width, height, depth, getLocalData());
 			break;
 		}
 		case TextureType::TEXTURE_2D_MULTISAMPLE: {
 			glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, format.numSamples, static_cast<GLint>(format.pixelFormat.glInternalFormat),
 									width, height, false);
+			RENDERING_GL_TRACE(TEX_IMAGE, {glId, GL_TEXTURE_2D_MULTISAMPLE, 0u, format.pixelFormat.glInternalFormat,
+										static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1u, format.numSamples, 0u});
 			GET_GL_ERROR();
 			break;
 		}
@@ -347,9 +638,13 @@ void Texture::_uploadGLTexture(RenderingContext & context, int level/*=0*/) {
 			throw std::runtime_error("Texture::_uploadGLTexture: Unsupported texture type.");
 		}
 	}
+	initStoredMipmaps();
+	if(level == 0)
+		uploadLocalMipmapLevels();
 	GET_GL_ERROR();
 	context.popTexture(0);
 	glActiveTexture(activeTexture);
+	updateAccountedMemory(hasMipmaps);
 }
 
 void Texture::allocateLocalData(){
@@ -370,6 +665,17 @@ void Texture::allocateLocalData(){
 	}
 }
 
+bool Texture::_setLocalBitmap(const Util::Reference<Util::Bitmap> & bitmap) {
+	if(bitmap.isNull() || format.pixelFormat.compressed || bitmap->getWidth() != getWidth() || bitmap->getHeight() != getHeight() * getNumLayers() ||
+			bitmap->getPixelFormat() != TextureUtils::glPixelFormatToPixelFormat(format.pixelFormat)) {
+		WARN("Texture::_setLocalBitmap: Bitmap does not match the texture's format.");
+		return false;
+	}
+	localBitmap = bitmap;
+	dataHasChanged = true;
+	return true;
+}
+
 bool Texture::isGLTextureValid()const {
 	return glId==0?false: (glIsTexture(glId)==GL_TRUE) ;
 }
@@ -386,9 +692,201 @@ bool Texture::isGLTextureResident()const {
 }
 
 void Texture::removeGLData(){
-	if(glId)
+#if defined(LIB_GL) && defined(GL_ARB_bindless_texture)
+	if(bindlessResident)
+		glMakeTextureHandleNonResidentARB(bindlessHandle);
+#endif
+	bindlessHandle = 0;
+	bindlessResident = false;
+	if(glId) {
 		glDeleteTextures(1,&glId);
+		RENDERING_GL_TRACE(DELETE_TEXTURE, {glId});
+	}
 	glId=0;
+	immutableStorage = false;
+	sparseStorage = false;
+	streamedMipLevels = false;
+	residentBaseLevel = 0;
+	placeholderGLId = 0; // cancels a pending asynchronous upload
+	updateAccountedMemory(false);
+}
+
+//! (internal) The estimate does not query the driver: the mipmap chain of an uncompressed texture adds a third.
+void Texture::updateAccountedMemory(bool withMipmaps) {
+	size_t size = 0;
+	if(glId != 0 && tType != TextureType::TEXTURE_BUFFER && !sparseStorage) { // buffer textures are accounted by their buffer object, sparse textures by their owner
+		size = getDataSize();
+		if(withMipmaps && !format.pixelFormat.compressed)
+			size += size / 3;
+		if(tType == TextureType::TEXTURE_2D_MULTISAMPLE)
+			size *= std::max(1u, format.numSamples);
+	}
+	MemoryRegistry::add(memoryCategory, static_cast<int64_t>(size) - static_cast<int64_t>(accountedMemory));
+	accountedMemory = size;
+}
+
+void Texture::_setMemoryCategory(MemoryRegistry::category_t category) {
+	if(category == memoryCategory)
+		return;
+	MemoryRegistry::move(memoryCategory, category, accountedMemory);
+	memoryCategory = category;
+}
+
+//! (internal)
+static bool isSizedInternalFormat(uint32_t internalFormat) {
+	switch(internalFormat) {
+		case GL_RGB:
+		case GL_RGBA:
+		case GL_DEPTH_COMPONENT:
+#ifdef LIB_GL
+		case GL_RED:
+		case GL_RG:
+		case GL_DEPTH_STENCIL:
+		case GL_ALPHA:
+		case GL_LUMINANCE:
+		case GL_LUMINANCE_ALPHA:
+#endif
+			return false;
+		default:
+			return true;
+	}
+}
+
+void Texture::_allocateGLStorage(RenderingContext & context, uint32_t numLevels, bool sparse) {
+	if(tType != TextureType::TEXTURE_2D && tType != TextureType::TEXTURE_2D_ARRAY && tType != TextureType::TEXTURE_3D)
+		throw std::runtime_error("Texture::_allocateGLStorage: Unsupported texture type.");
+#if defined(LIB_GL) && defined(GL_ARB_sparse_texture)
+	static const bool sparseSupported = isExtensionSupported("GL_ARB_sparse_texture");
+#else
+	const bool sparseSupported = false;
+#endif
+	if(sparse && (!sparseSupported || format.pixelFormat.compressed || !isSizedInternalFormat(format.pixelFormat.glInternalFormat)))
+		throw std::runtime_error("Texture::_allocateGLStorage: Sparse storage is not supported for this texture.");
+	if(glId)
+		removeGLData();
+	_createGLID(context);
+	sparseStorage = sparse;
+	dataHasChanged = false;
+	numLevels = std::max(1u, format.pixelFormat.compressed ? format.numMipLevels : numLevels);
+
+	const GLsizei width = static_cast<GLsizei>(getWidth());
+	const GLsizei height = static_cast<GLsizei>(getHeight());
+	const GLsizei depth = static_cast<GLsizei>(getNumLayers());
+#if defined(LIB_GL) && defined(GL_ARB_direct_state_access)
+	if(isDirectStateAccessSupported() && isSizedInternalFormat(format.pixelFormat.glInternalFormat)) {
+#if defined(GL_ARB_sparse_texture)
+		if(sparse)
+			glTextureParameteri(glId, GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+#endif
+		if(tType == TextureType::TEXTURE_2D) {
+			glTextureStorage2D(glId, static_cast<GLsizei>(numLevels), static_cast<GLenum>(format.pixelFormat.glInternalFormat), width, height);
+		} else {
+			glTextureStorage3D(glId, static_cast<GLsizei>(numLevels), static_cast<GLenum>(format.pixelFormat.glInternalFormat), width, height, depth);
+		}
+		immutableStorage = true;
+		initStoredMipmaps();
+		GET_GL_ERROR();
+		updateAccountedMemory(numLevels > 1);
+		return;
+	}
+#endif
+
+	GLint activeTexture;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	context.pushAndSetTexture(0,nullptr); // store and disable texture unit 0, so that we can use it without side effects.
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(format.glTextureType,glId);
+
+#if defined(LIB_GL) && defined(GL_ARB_texture_storage)
+	static const bool storageSupported = isExtensionSupported("GL_ARB_texture_storage");
+	if(storageSupported && isSizedInternalFormat(format.pixelFormat.glInternalFormat)) {
+#if defined(GL_ARB_sparse_texture)
+		if(sparse)
+			glTexParameteri(static_cast<GLenum>(format.glTextureType), GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+#endif
+		if(tType == TextureType::TEXTURE_2D) {
+			glTexStorage2D(GL_TEXTURE_2D, static_cast<GLsizei>(numLevels), static_cast<GLenum>(format.pixelFormat.glInternalFormat), width, height);
+		} else {
+			glTexStorage3D(static_cast<GLenum>(format.glTextureType), static_cast<GLsizei>(numLevels),
+							static_cast<GLenum>(format.pixelFormat.glInternalFormat), width, height, depth);
+		}
+		immutableStorage = true;
+	}
+#endif
+	for(uint32_t level = 0; level < numLevels && !immutableStorage; ++level) {
+		const GLsizei levelWidth = std::max(1, width >> level);
+		const GLsizei levelHeight = std::max(1, height >> level);
+		if(tType == TextureType::TEXTURE_2D) {
+			if(format.pixelFormat.compressed) {
+				glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), static_cast<GLenum>(format.pixelFormat.glInternalFormat),
+										levelWidth, levelHeight, 0, static_cast<GLsizei>(format.getLevelDataSize(level)), nullptr);
+			} else {
+				glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), static_cast<GLint>(format.pixelFormat.glInternalFormat),
+										levelWidth, levelHeight, 0,
+										static_cast<GLenum>(format.pixelFormat.glLocalDataFormat),
+										static_cast<GLenum>(format.pixelFormat.glLocalDataType), nullptr);
+			}
+		}
+#if defined(LIB_GL)
+		else {
+			const GLsizei levelDepth = tType == TextureType::TEXTURE_3D ? std::max(1, depth >> level) : depth;
+			if(format.pixelFormat.compressed) {
+				glCompressedTexImage3D(static_cast<GLenum>(format.glTextureType), static_cast<GLint>(level), static_cast<GLenum>(format.pixelFormat.glInternalFormat),
+										levelWidth, levelHeight, levelDepth, 0, static_cast<GLsizei>(format.getLevelDataSize(level)), nullptr);
+				continue;
+			}
+			glTexImage3D(static_cast<GLenum>(format.glTextureType), static_cast<GLint>(level), static_cast<GLint>(format.pixelFormat.glInternalFormat),
+							levelWidth, levelHeight, levelDepth, 0,
+							static_cast<GLenum>(format.pixelFormat.glLocalDataFormat),
+							static_cast<GLenum>(format.pixelFormat.glLocalDataType), nullptr);
+		}
+#endif
+	}
+	initStoredMipmaps();
+	GET_GL_ERROR();
+	context.popTexture(0);
+	glActiveTexture(activeTexture);
+	updateAccountedMemory(numLevels > 1);
+}
+
+//! (static)
+bool Texture::isBindlessSupported(){
+#if defined(LIB_GL) && defined(GL_ARB_bindless_texture)
+	static const bool support = isExtensionSupported("GL_ARB_bindless_texture");
+	return support;
+#else
+	return false;
+#endif
+}
+
+uint64_t Texture::getBindlessHandle(RenderingContext & context){
+#if defined(LIB_GL) && defined(GL_ARB_bindless_texture)
+	if(!isBindlessSupported() || _prepareForBinding(context)==0)
+		return 0;
+	if(bindlessHandle==0){
+		bindlessHandle = glGetTextureHandleARB(glId);
+		GET_GL_ERROR();
+	}
+	return bindlessHandle;
+#else
+	return 0;
+#endif
+}
+
+void Texture::_setBindlessResident(RenderingContext & context, bool resident){
+#if defined(LIB_GL) && defined(GL_ARB_bindless_texture)
+	if(resident == bindlessResident)
+		return;
+	if(resident){
+		if(getBindlessHandle(context)==0)
+			return;
+		glMakeTextureHandleResidentARB(bindlessHandle);
+	}else{
+		glMakeTextureHandleNonResidentARB(bindlessHandle);
+	}
+	bindlessResident = resident;
+	GET_GL_ERROR();
+#endif
 }
 
 void Texture::clearGLData(const Util::Color4f& color) {
@@ -433,7 +931,38 @@ void Texture::downloadGLTexture(RenderingContext & context) {
 	if(!localBitmap)
 		allocateLocalData();
 
+#if defined(GL_ARB_direct_state_access)
+	if(isDirectStateAccessSupported() && tType != TextureType::TEXTURE_BUFFER && tType != TextureType::TEXTURE_CUBE_MAP_ARRAY) {
+		// the faces of a cube map are returned as consecutive layers
+		if(format.pixelFormat.compressed) {
+			for(uint32_t level = 0; level < std::max(1u, format.numMipLevels); ++level) {
+				glGetCompressedTextureImage(glId, static_cast<GLint>(level), static_cast<GLsizei>(format.getLevelDataSize(level)),
+											getLocalData() + format.getLevelDataOffset(level));
+			}
+		} else {
+			glGetTextureImage(glId, 0, format.pixelFormat.glLocalDataFormat, format.pixelFormat.glLocalDataType,
+								static_cast<GLsizei>(localBitmap->getDataSize()), getLocalData());
+		}
+		GET_GL_ERROR();
+		return;
+	}
+#endif
 	context.pushAndSetTexture(0,this);
+	if(format.pixelFormat.compressed) {
+		for(uint32_t level = 0; level < std::max(1u, format.numMipLevels); ++level) {
+			uint8_t * levelData = getLocalData() + format.getLevelDataOffset(level);
+			if(tType == TextureType::TEXTURE_CUBE_MAP) {
+				const uint32_t faceSize = format.getLevelDataSize(level) / 6;
+				for(uint_fast8_t face = 0; face < 6; ++face)
+					glGetCompressedTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, static_cast<GLint>(level), levelData + face * faceSize);
+			} else {
+				glGetCompressedTexImage(format.glTextureType, static_cast<GLint>(level), levelData);
+			}
+		}
+		GET_GL_ERROR();
+		context.popTexture(0);
+		return;
+	}
 	switch( tType ){
 		case  TextureType::TEXTURE_1D:
 		case  TextureType::TEXTURE_2D:
@@ -485,6 +1014,27 @@ uint8_t * Texture::openLocalData(RenderingContext & context){
 	return getLocalData();
 }
 
+//! (internal)
+uint32_t Texture::prepareManagedForBinding(RenderingContext & context) {
+	return residencyManager->_prepareForBinding(context, *this);
+}
+
+bool Texture::_takeLocalData(Texture & other) {
+	if(other.localBitmap.isNull() || other.format != format)
+		return false;
+	localBitmap = other.localBitmap;
+	other.localBitmap = nullptr;
+	localMipmaps = std::move(other.localMipmaps);
+	other.localMipmaps.clear();
+	dataHasChanged = true;
+	return true;
+}
+
+void Texture::_releaseLocalData() {
+	localBitmap = nullptr;
+	localMipmaps.clear();
+}
+
 void Texture::_setGLId(uint32_t _glId) {
 	removeGLData();
 	glId = _glId;
@@ -492,6 +1042,7 @@ void Texture::_setGLId(uint32_t _glId) {
 		WARN("Texture::_setGLId: The given id is not a valid texture " + Util::StringUtils::toString(_glId));
 		glId = 0;
 	}	
+	updateAccountedMemory(false);
 }
 
 }
@@ -13,6 +13,7 @@
 
 #include "TextureType.h"
 #include "PixelFormatGL.h"
+#include "../MemoryRegistry.h"
 
 #include <Util/Graphics/Color.h>
 #include <Util/ReferenceCounter.h>
@@ -20,6 +21,7 @@
 #include <Util/IO/FileName.h>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace Util {
 class Bitmap;
@@ -27,6 +29,7 @@ class Bitmap;
 namespace Rendering {
 class RenderingContext;
 class BufferObject;
+class TextureResidencyManager;
 
 /***
  ** Texture
@@ -61,7 +64,8 @@ class Texture: public Util::ReferenceCounter<Texture>	{
 			uint32_t sizeX, sizeY, numLayers;		//!< width, height, depth (3d-texture)/num Layers(array texture)
 			uint32_t glTextureType;					//!< GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_
 
-			uint32_t compressedImageSize; 			//!< Size of the data in bytes. @see glCompressedTexImage2D
+			uint32_t compressedImageSize; 			//!< Size of the data in bytes (all levels); 0: computed from the block format. @see glCompressedTexImage2D
+			uint32_t numMipLevels = 1;				//!< Number of mipmap levels contained in the local data (only used for compressed formats)
 			int32_t glWrapS, glWrapT, glWrapR;		//!< e.g. GL_REPEAT
 			PixelFormatGL pixelFormat;
 		
@@ -70,13 +74,20 @@ class Texture: public Util::ReferenceCounter<Texture>	{
 			uint32_t numSamples = 4; //!< GL_TEXTURE_2D_MULTISAMPLE
 			
 			uint32_t getPixelSize() const;
-			uint32_t getDataSize() const 	{	return pixelFormat.compressed ? compressedImageSize : getPixelSize() * sizeX * sizeY * numLayers;}
+			uint32_t getDataSize() const 	{	return pixelFormat.compressed ? getCompressedDataSize() : getPixelSize() * sizeX * sizeY * numLayers;}
 			uint32_t getRowSize() const		{	return pixelFormat.compressed ? 0 : getPixelSize() * sizeX;	}
+
+			/*! Size in bytes of the given mipmap level including all layers (faces of a cube map).
+				The local data of a compressed texture stores the levels consecutively, starting with level 0.
+				\note For unknown block formats, only the size of level 0 (compressedImageSize) is available. */
+			uint32_t getLevelDataSize(uint32_t level) const;
+			//! Offset in bytes of the given mipmap level inside the local data.
+			uint32_t getLevelDataOffset(uint32_t level) const;
 			
 			bool operator==(const Format& other) const {
 				return sizeX == other.sizeX && sizeY == other.sizeY && numLayers == other.numLayers
 					  && glTextureType == other.glTextureType
-					  && compressedImageSize == other.compressedImageSize
+					  && compressedImageSize == other.compressedImageSize && numMipLevels == other.numMipLevels
 					  && glWrapS == other.glWrapS && glWrapT == other.glWrapT && glWrapR == other.glWrapR
 					  && pixelFormat.compressed == other.pixelFormat.compressed
 					  && pixelFormat.glInternalFormat == other.pixelFormat.glInternalFormat
@@ -85,6 +96,8 @@ class Texture: public Util::ReferenceCounter<Texture>	{
 					  && linearMinFilter == other.linearMinFilter && linearMagFilter == other.linearMagFilter;
 			}
 			bool operator!=(const Format& other) const { return !(*this == other); }
+		private:
+			uint32_t getCompressedDataSize() const;
 		};
 		// ---------------------------------------
 
@@ -121,6 +134,14 @@ class Texture: public Util::ReferenceCounter<Texture>	{
 
 		//! (internal) uploads the texture if necessary; returns the glId or 0 if the texture is invalid.
 		uint32_t _prepareForBinding(RenderingContext & context){
+			if(residencyManager != nullptr)
+				return prepareManagedForBinding(context);
+			return _uploadForBinding(context);
+		}
+		//! (internal) _prepareForBinding without notifying the residency manager.
+		uint32_t _uploadForBinding(RenderingContext & context){
+			if(isUploadPending())
+				return glId;
 			if(!glId || dataHasChanged)
 				_uploadGLTexture(context);
 			if(mipmapCreationIsPlanned)
@@ -132,15 +153,89 @@ class Texture: public Util::ReferenceCounter<Texture>	{
 		bool isGLTextureResident()const;
 
 		Util::Bitmap* getLocalBitmap()const					{	return localBitmap.get();	}
+		/*! (internal) Use the given bitmap as local data without copying it.
+			@return false if its size or pixel format does not match the format of the texture.	*/
+		bool _setLocalBitmap(const Util::Reference<Util::Bitmap> & bitmap);
 
 	/*!	@name Mipmaps */
 	// @{
 		void planMipmapCreation()							{	mipmapCreationIsPlanned = true;	}
+		bool isMipmapCreationPlanned() const				{	return mipmapCreationIsPlanned;	}
 		void createMipmaps(RenderingContext & context);
 		bool getHasMipmaps() const							{	return hasMipmaps;	}
+
+		/*! Store precomputed mipmap levels (starting with level 1) of an uncompressed TEXTURE_2D or TEXTURE_2D_ARRAY
+			(see MipmapGenerator::createLocalMipmaps()). They are uploaded together with the local data instead of
+			generating the mipmaps on the gpu; an empty vector removes them.
+			\note The levels are not updated automatically if the local data is changed.	*/
+		void setLocalMipmaps(std::vector<Util::Reference<Util::Bitmap>> levels);
+		const std::vector<Util::Reference<Util::Bitmap>> & getLocalMipmaps() const	{	return localMipmaps;	}
+		//! (internal) Upload the local mipmap levels into the existing gl texture.
+		void _uploadLocalMipmaps(RenderingContext & context);
+
+		/*! (internal) Keep only the mipmap levels starting with @p baseLevel in graphics memory (see TextureMipStreamer).
+			The missing levels are uploaded from the local data and the local mipmaps, the finer levels are released and
+			GL_TEXTURE_BASE_LEVEL is set accordingly. Only for uncompressed TEXTURE_2D and TEXTURE_2D_ARRAY textures with
+			local mipmaps.	*/
+		void _setResidentMipLevels(RenderingContext & context, uint32_t baseLevel);
+		//! The finest mipmap level in graphics memory (0 unless the levels are streamed).
+		uint32_t getResidentBaseLevel() const				{	return residentBaseLevel;	}
+	private:
+		std::vector<Util::Reference<Util::Bitmap>> localMipmaps;
+		uint32_t residentBaseLevel;
+		bool streamedMipLevels;
+		void uploadLocalMipmapLevels();
+	public:
+	// @}
+
+	/*!	@name Asynchronous upload (see TextureUploadQueue) */
+	// @{
+		public:
+			//! @c true while the local data is uploaded by a TextureUploadQueue. Meanwhile, a placeholder texture is bound instead.
+			bool isUploadPending() const					{	return placeholderGLId != 0;	}
+
+			//! (internal) The gl texture that is bound when the texture is used (the placeholder while an upload is pending).
+			uint32_t _getGLIdForBinding() const				{	return placeholderGLId != 0 ? placeholderGLId : glId;	}
+
+			//! (internal) Called by the TextureUploadQueue; 0 ends the pending upload.
+			void _setPlaceholderGLId(uint32_t id)			{	placeholderGLId = id;	}
+
+			/*! (internal) Create the gl texture and allocate the storage of @p numLevels mipmap levels without uploading any data.
+				If GL_ARB_texture_storage is supported and the internal format is sized, the storage is immutable
+				(glTexStorage); otherwise, glTexImage is called without data. The local data is considered as uploaded.
+				If @p sparse is true, the storage is created as sparse texture (GL_ARB_sparse_texture); its pages have to be
+				committed explicitly (see VirtualTexture) and are not accounted in the MemoryRegistry by the texture.
+				\note Only TEXTURE_2D, TEXTURE_2D_ARRAY and TEXTURE_3D are supported.	*/
+			void _allocateGLStorage(RenderingContext & context, uint32_t numLevels, bool sparse = false);
+			bool hasImmutableStorage() const				{	return immutableStorage;	}
+			bool hasSparseStorage() const					{	return sparseStorage;	}
+		private:
+			bool immutableStorage;
+			bool sparseStorage;
+			uint32_t placeholderGLId;
 	// @}
 		
 			
+	/*!	@name Bindless texture (GL_ARB_bindless_texture) */
+	// @{
+		public:
+			static bool isBindlessSupported();
+
+			/*! Return the 64-bit bindless handle of the texture (the texture is uploaded if necessary), or 0 if
+				bindless textures are not supported. The handle has to be made resident before the texture is accessed
+				by a shader (see RenderingContext::makeTextureResident).
+				\note After the handle has been created, the texture's storage cannot be changed anymore;
+					uploading changed data therefore recreates the gl texture and a new handle has to be queried. */
+			uint64_t getBindlessHandle(RenderingContext & context);
+			bool isBindlessResident() const					{	return bindlessResident;	}
+
+			//! (internal) Called by the RenderingContext.
+			void _setBindlessResident(RenderingContext & context, bool resident);
+		private:
+			uint64_t bindlessHandle;
+			bool bindlessResident;
+	// @}
+
 	/*!	@name BufferObject (tType == TEXTURE_BUFFER)  */
 	// @{
 		public:
@@ -149,6 +244,35 @@ class Texture: public Util::ReferenceCounter<Texture>	{
 			std::unique_ptr<BufferObject> bufferObject;		// if type is bufferObject
 	// @}
 
+	/*!	@name Memory accounting (see MemoryRegistry) */
+	// @{
+		public:
+			//! Graphics memory of the gl texture accounted in the MemoryRegistry (an estimate including the mipmaps).
+			size_t getAccountedGraphicsMemory() const		{	return accountedMemory;	}
+			MemoryRegistry::category_t getMemoryCategory() const	{	return memoryCategory;	}
+			//! (internal) Called by the FBO when the texture is used as render target.
+			void _setMemoryCategory(MemoryRegistry::category_t category);
+		private:
+			MemoryRegistry::category_t memoryCategory;
+			size_t accountedMemory;
+			void updateAccountedMemory(bool withMipmaps);
+	// @}
+
+	/*!	@name Residency (see TextureResidencyManager) */
+	// @{
+		public:
+			TextureResidencyManager * getResidencyManager() const	{	return residencyManager;	}
+			//! (internal) Called by the TextureResidencyManager.
+			void _setResidencyManager(TextureResidencyManager * manager)	{	residencyManager = manager;	}
+			/*! (internal) Take over the local data of @p other, which must have the same format (used for reloading
+				the data of an evicted texture). @return false if the formats differ or @p other has no local data.	*/
+			bool _takeLocalData(Texture & other);
+			//! (internal) Release the local data of a texture that can be reloaded from its file.
+			void _releaseLocalData();
+		private:
+			TextureResidencyManager * residencyManager;
+			uint32_t prepareManagedForBinding(RenderingContext & context);
+	// @}
 	/*!	@name Filename */
 	// @{
 		public:
@@ -174,6 +298,9 @@ class Texture: public Util::ReferenceCounter<Texture>	{
 		const uint32_t _pixelDataSize; // initialized automatically
 
 		Util::Reference<Util::Bitmap> localBitmap;
+
+		//! (internal) Sets the mipmap parameters of the bound texture if its compressed data contains several levels.
+		void initStoredMipmaps();
 };
 
 
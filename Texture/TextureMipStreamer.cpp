@@ -0,0 +1,167 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "TextureMipStreamer.h"
+#include "MipmapGenerator.h"
+#include "Texture.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeAccessors.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexDescription.h"
+#include "../RenderingContext/RenderingContext.h"
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Rect.h>
+#include <Geometry/Vec2.h>
+#include <Geometry/Vec3.h>
+#include <Util/Graphics/Bitmap.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace Rendering {
+
+TextureMipStreamer::TextureMipStreamer(size_t _bytesPerUpdate) :
+		bytesPerUpdate(_bytesPerUpdate), releaseDelay(60), minResidentSize(64), updateCounter(0) {
+}
+
+TextureMipStreamer::~TextureMipStreamer() = default;
+
+bool TextureMipStreamer::addTexture(RenderingContext & context, Texture * texture) {
+	if(texture == nullptr)
+		return false;
+	if(entries.count(texture) > 0)
+		return true;
+	const TextureType type = texture->getTextureType();
+	if(texture->getLocalData() == nullptr || texture->getFormat().pixelFormat.compressed || (type != TextureType::TEXTURE_2D && type != TextureType::TEXTURE_2D_ARRAY))
+		return false;
+	const uint32_t numLevels = static_cast<uint32_t>(std::log2(std::max(texture->getWidth(), texture->getHeight()))) + 1;
+	if(texture->getLocalMipmaps().size() + 1 != numLevels && !MipmapGenerator::createLocalMipmaps(*texture))
+		return false;
+
+	Entry entry;
+	entry.texture = texture;
+	entry.tailLevel = 0;
+	while(entry.tailLevel + 1 < numLevels && std::max(texture->getWidth() >> entry.tailLevel, texture->getHeight() >> entry.tailLevel) > minResidentSize)
+		++entry.tailLevel;
+	entry.requestedLevel = entry.tailLevel;
+	entry.lastRequestUpdate = updateCounter;
+	texture->_setResidentMipLevels(context, entry.tailLevel);
+	entries.emplace(texture, entry);
+	return true;
+}
+
+void TextureMipStreamer::removeTexture(Texture * texture) {
+	auto it = entries.find(texture);
+	if(it == entries.end())
+		return;
+	texture->dataChanged(); // upload all levels the next time it is bound
+	entries.erase(it);
+}
+
+void TextureMipStreamer::requestLevel(Texture * texture, float level) {
+	auto it = entries.find(texture);
+	if(it == entries.end())
+		return;
+	const uint32_t l = level <= 0.0f ? 0 : static_cast<uint32_t>(level);
+	it->second.requestedLevel = std::min(it->second.requestedLevel, l);
+}
+
+void TextureMipStreamer::requestForView(RenderingContext & context, Texture * texture, float texCoordDensity, const Geometry::Vec3 & worldPosition) {
+	if(texture != nullptr)
+		requestLevel(texture, estimateLevel(*texture, texCoordDensity, getPixelsPerWorldUnit(context, worldPosition)));
+}
+
+void TextureMipStreamer::update(RenderingContext & context) {
+	++updateCounter;
+	std::vector<std::pair<Entry *, uint32_t>> missingLevels; // entry, wanted level
+	for(auto & it : entries) {
+		Entry & entry = it.second;
+		Texture * texture = entry.texture.get();
+		if(texture->getGLId() == 0 || texture->getResidentBaseLevel() > entry.tailLevel) // e.g. evicted or changed
+			texture->_setResidentMipLevels(context, entry.tailLevel);
+		const uint32_t wanted = std::min(entry.requestedLevel, entry.tailLevel);
+		const uint32_t resident = texture->getResidentBaseLevel();
+		entry.requestedLevel = entry.tailLevel;
+		if(wanted <= resident)
+			entry.lastRequestUpdate = updateCounter;
+		if(wanted < resident)
+			missingLevels.emplace_back(&entry, wanted);
+		else if(wanted > resident && updateCounter - entry.lastRequestUpdate >= releaseDelay)
+			texture->_setResidentMipLevels(context, wanted);
+	}
+
+	// the textures missing the most levels first; the levels are added from coarse to fine
+	std::sort(missingLevels.begin(), missingLevels.end(), [](const std::pair<Entry *, uint32_t> & a, const std::pair<Entry *, uint32_t> & b) {
+		return a.first->texture->getResidentBaseLevel() - a.second > b.first->texture->getResidentBaseLevel() - b.second;
+	});
+	size_t uploadedBytes = 0;
+	for(const auto & missing : missingLevels) {
+		Texture * texture = missing.first->texture.get();
+		while(texture->getResidentBaseLevel() > missing.second && (uploadedBytes < bytesPerUpdate || uploadedBytes == 0)) {
+			const uint32_t level = texture->getResidentBaseLevel() - 1;
+			uploadedBytes += texture->getFormat().getLevelDataSize(level);
+			texture->_setResidentMipLevels(context, level);
+		}
+		if(uploadedBytes >= bytesPerUpdate)
+			break;
+	}
+}
+
+//! (static)
+float TextureMipStreamer::calculateTexCoordDensity(Mesh * mesh) {
+	if(mesh == nullptr || mesh->getDrawMode() != Mesh::DRAW_TRIANGLES)
+		return 0.0f;
+	const VertexDescription & vd = mesh->getVertexDescription();
+	if(!vd.hasAttribute(VertexAttributeIds::POSITION) || !vd.hasAttribute(VertexAttributeIds::TEXCOORD0))
+		return 0.0f;
+	MeshVertexData & vData = mesh->openVertexData();
+	Util::Reference<PositionAttributeAccessor> positions(PositionAttributeAccessor::create(vData, VertexAttributeIds::POSITION));
+	Util::Reference<TexCoordAttributeAccessor> texCoords(TexCoordAttributeAccessor::create(vData, VertexAttributeIds::TEXCOORD0));
+	const bool indexed = mesh->isUsingIndexData();
+	const MeshIndexData & iData = mesh->openIndexData();
+	const uint32_t count = indexed ? iData.getIndexCount() : vData.getVertexCount();
+
+	double worldArea = 0.0, texCoordArea = 0.0;
+	for(uint32_t i = 0; i + 2 < count; i += 3) {
+		const uint32_t a = indexed ? iData[i] : i;
+		const uint32_t b = indexed ? iData[i + 1] : i + 1;
+		const uint32_t c = indexed ? iData[i + 2] : i + 2;
+		const Geometry::Vec3 pa = positions->getPosition(a);
+		worldArea += 0.5 * (positions->getPosition(b) - pa).cross(positions->getPosition(c) - pa).length();
+		const Geometry::Vec2 ta = texCoords->getCoordinate(a);
+		const Geometry::Vec2 ab = texCoords->getCoordinate(b) - ta;
+		const Geometry::Vec2 ac = texCoords->getCoordinate(c) - ta;
+		texCoordArea += 0.5 * std::abs(ab.x() * ac.y() - ab.y() * ac.x());
+	}
+	return worldArea > 0.0 ? static_cast<float>(std::sqrt(texCoordArea / worldArea)) : 0.0f;
+}
+
+//! (static)
+float TextureMipStreamer::getPixelsPerWorldUnit(RenderingContext & context, const Geometry::Vec3 & worldPosition) {
+	const Geometry::Vec3 cameraPosition = context.getMatrix_worldToCamera().transformPosition(worldPosition);
+	const float distance = std::max(1.0e-4f, -cameraPosition.z());
+	// element (1,1) of a perspective projection matrix is cot(fovY / 2)
+	const float focal = context.getMatrix_cameraToClipping().at(1, 1);
+	return 0.5f * static_cast<float>(context.getViewport().getHeight()) * focal / distance;
+}
+
+//! (static)
+float TextureMipStreamer::estimateLevel(const Texture & texture, float texCoordDensity, float pixelsPerWorldUnit) {
+	if(texCoordDensity <= 0.0f || pixelsPerWorldUnit <= 0.0f)
+		return 0.0f;
+	const float texelsPerWorldUnit = texCoordDensity * std::sqrt(static_cast<float>(texture.getWidth()) * static_cast<float>(texture.getHeight()));
+	return std::max(0.0f, std::log2(texelsPerWorldUnit / pixelsPerWorldUnit));
+}
+
+}
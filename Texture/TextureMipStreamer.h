@@ -0,0 +1,106 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_TEXTUREMIPSTREAMER_H_
+#define RENDERING_TEXTUREMIPSTREAMER_H_
+
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace Geometry {
+template<typename _T> class _Vec3;
+typedef _Vec3<float> Vec3;
+}
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+class Texture;
+
+/**
+ * Keeps only the mipmap levels of textures in graphics memory that are needed for their current screen coverage.
+ *
+ * Each frame, the application requests the finest level that is needed for every visible texture, e.g. by
+ * requestForView() using the texture coordinate density of the mesh (see calculateTexCoordDensity()) and the
+ * projected size of a world unit at the mesh's position. update() uploads the missing finer levels (at most
+ * getBytesPerUpdate() bytes, the textures that miss the most levels first) and releases levels that have not been
+ * requested for getReleaseDelay() updates. The levels are clamped by GL_TEXTURE_BASE_LEVEL (see
+ * Texture::_setResidentMipLevels()).
+ *
+ * A managed texture keeps all levels as local data (missing local mipmaps are created by addTexture() using
+ * MipmapGenerator::createLocalMipmaps()); levels smaller than getMinResidentSize() are always in graphics memory.
+ *
+ * \code
+ * const float density = TextureMipStreamer::calculateTexCoordDensity(mesh); // once per mesh
+ * // per frame and visible mesh
+ * streamer.requestForView(context, texture, density, worldBoundingBoxCenter);
+ * // once per frame
+ * streamer.update(context);
+ * \endcode
+ * @note The manager holds a reference to every added texture. If the local data of a texture is changed, it is
+ *	uploaded completely the next time it is bound until the next update().
+ */
+class TextureMipStreamer {
+	public:
+		explicit TextureMipStreamer(size_t bytesPerUpdate = 8 * 1024 * 1024);
+		~TextureMipStreamer();
+
+		size_t getBytesPerUpdate() const				{	return bytesPerUpdate;	}
+		void setBytesPerUpdate(size_t numBytes)			{	bytesPerUpdate = numBytes;	}
+		//! Number of updates after which unrequested levels are released.
+		uint32_t getReleaseDelay() const				{	return releaseDelay;	}
+		void setReleaseDelay(uint32_t numUpdates)		{	releaseDelay = numUpdates;	}
+		//! Levels whose width and height do not exceed this size are always resident (default: 64).
+		uint32_t getMinResidentSize() const				{	return minResidentSize;	}
+		void setMinResidentSize(uint32_t size)			{	minResidentSize = size;	}
+
+		/*! Manage the mipmap levels of the texture; only the coarse levels are uploaded immediately.
+			@return false if the texture is not supported (it needs local data and has to be an uncompressed
+				TEXTURE_2D or TEXTURE_2D_ARRAY with unsigned byte or float components).	*/
+		bool addTexture(RenderingContext & context, Texture * texture);
+		//! Stop managing the texture; all its levels are uploaded the next time it is bound.
+		void removeTexture(Texture * texture);
+		uint32_t getNumTextures() const					{	return static_cast<uint32_t>(entries.size());	}
+
+		//! Request the mipmap level (fractional values are rounded down) for the next update().
+		void requestLevel(Texture * texture, float level);
+		/*! Request the level for a surface at @p worldPosition with the given texture coordinate density (texture
+			coordinate units per world unit) as seen by the current camera of the context.	*/
+		void requestForView(RenderingContext & context, Texture * texture, float texCoordDensity, const Geometry::Vec3 & worldPosition);
+
+		//! Load and release levels according to the requests since the last update.
+		void update(RenderingContext & context);
+
+		//! (static) Average texture coordinate units per world unit of the mesh's triangles (root of the ratio of the areas).
+		static float calculateTexCoordDensity(Mesh * mesh);
+		/*! (static) Screen pixels covered by a world unit at the given position (perspective projection of the current
+			camera and viewport of the context).	*/
+		static float getPixelsPerWorldUnit(RenderingContext & context, const Geometry::Vec3 & worldPosition);
+		//! (static) Mipmap level for which one texel covers about one pixel.
+		static float estimateLevel(const Texture & texture, float texCoordDensity, float pixelsPerWorldUnit);
+
+	private:
+		struct Entry {
+			Util::Reference<Texture> texture;
+			uint32_t tailLevel;			//!< finest level that is always resident
+			uint32_t requestedLevel;	//!< finest level requested since the last update
+			uint32_t lastRequestUpdate;	//!< update in which the resident levels were last needed
+		};
+		std::unordered_map<Texture *, Entry> entries;
+		size_t bytesPerUpdate;
+		uint32_t releaseDelay;
+		uint32_t minResidentSize;
+		uint32_t updateCounter;
+};
+
+}
+
+#endif /* RENDERING_TEXTUREMIPSTREAMER_H_ */
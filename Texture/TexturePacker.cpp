@@ -0,0 +1,259 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "TexturePacker.h"
+#include "TextureUtils.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttribute.h"
+#include "../Mesh/VertexAttributeAccessors.h"
+#include "../Mesh/VertexDescription.h"
+#include "../MeshUtils/MeshUtils.h"
+#include "../GLHeader.h"
+#include <Util/Macros.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+namespace Rendering {
+namespace TexturePacker {
+
+static bool isPackable(const Texture * texture) {
+	if(texture == nullptr)
+		return false;
+	const Texture::Format & format = texture->getFormat();
+	return !format.pixelFormat.compressed && format.glTextureType == GL_TEXTURE_2D && format.numLayers == 1
+			&& format.sizeX > 0 && format.sizeY > 0;
+}
+
+static bool haveSamePixelFormat(const Texture * t1, const Texture * t2) {
+	const PixelFormatGL & f1 = t1->getFormat().pixelFormat;
+	const PixelFormatGL & f2 = t2->getFormat().pixelFormat;
+	return f1.glInternalFormat == f2.glInternalFormat && f1.glLocalDataFormat == f2.glLocalDataFormat
+			&& f1.glLocalDataType == f2.glLocalDataType;
+}
+
+//! Check the textures and collect their local data; returns false (and warns) if they cannot be packed together.
+static bool collectData(RenderingContext & context, const std::vector<Texture *> & textures, std::vector<const uint8_t *> & data, const char * caller) {
+	if(textures.empty())
+		return false;
+	for(Texture * texture : textures) {
+		if(!isPackable(texture) || !haveSamePixelFormat(texture, textures.front())) {
+			WARN(std::string("TexturePacker::") + caller + ": Textures are not compatible.");
+			return false;
+		}
+		const uint8_t * localData = texture->openLocalData(context);
+		if(localData == nullptr) {
+			WARN(std::string("TexturePacker::") + caller + ": Texture has no data.");
+			return false;
+		}
+		data.push_back(localData);
+	}
+	return true;
+}
+
+//! The target texture uses the pixel format and filtering of the first texture.
+static Util::Reference<Texture> createTarget(const std::vector<Texture *> & textures, TextureType type, uint32_t width, uint32_t height, uint32_t numLayers, bool clampToEdge) {
+	Texture::Format format = textures.front()->getFormat();
+	format.glTextureType = TextureUtils::textureTypeToGLTextureType(type);
+	format.sizeX = width;
+	format.sizeY = height;
+	format.numLayers = numLayers;
+	format.numMipLevels = 1;
+	format.compressedImageSize = 0;
+	if(clampToEdge) {
+		format.glWrapS = GL_CLAMP_TO_EDGE;
+		format.glWrapT = GL_CLAMP_TO_EDGE;
+		format.glWrapR = GL_CLAMP_TO_EDGE;
+	}
+	Util::Reference<Texture> texture = new Texture(format);
+	texture->allocateLocalData();
+	if(texture->getLocalData() == nullptr)
+		return nullptr;
+	std::fill_n(texture->getLocalData(), format.getDataSize(), 0);
+	for(Texture * source : textures) {
+		if(source->getHasMipmaps() || source->isMipmapCreationPlanned()) {
+			texture->planMipmapCreation();
+			break;
+		}
+	}
+	return texture;
+}
+
+/*! Copy the pixels of a texture to (targetX, targetY) and replicate its border @p padding times.
+	@p target points to the first row of the target layer.	*/
+static void copyPixels(uint8_t * target, uint32_t targetRowSize, uint32_t targetX, uint32_t targetY,
+						const uint8_t * source, uint32_t width, uint32_t height, uint32_t pixelSize, uint32_t padding) {
+	const uint32_t rowSize = width * pixelSize;
+	const int32_t p = static_cast<int32_t>(padding);
+	for(int32_t y = -p; y < static_cast<int32_t>(height) + p; ++y) {
+		const int32_t sourceY = std::min(std::max(y, 0), static_cast<int32_t>(height) - 1);
+		const uint8_t * sourceRow = source + static_cast<size_t>(sourceY) * rowSize;
+		uint8_t * targetRow = target + static_cast<size_t>(targetY + y) * targetRowSize + static_cast<size_t>(targetX) * pixelSize;
+		std::memcpy(targetRow, sourceRow, rowSize);
+		for(uint32_t i = 1; i <= padding; ++i) {
+			std::memcpy(targetRow - i * pixelSize, sourceRow, pixelSize);
+			std::memcpy(targetRow + rowSize + (i - 1) * pixelSize, sourceRow + rowSize - pixelSize, pixelSize);
+		}
+	}
+}
+
+std::vector<std::vector<uint32_t>> groupCompatibleTextures(const std::vector<Texture *> & textures) {
+	std::vector<std::vector<uint32_t>> groups;
+	for(uint32_t i = 0; i < textures.size(); ++i) {
+		if(!isPackable(textures[i]))
+			continue;
+		auto group = std::find_if(groups.begin(), groups.end(), [&](const std::vector<uint32_t> & g) {
+			return haveSamePixelFormat(textures[g.front()], textures[i]);
+		});
+		if(group == groups.end())
+			groups.emplace_back(1, i);
+		else
+			group->push_back(i);
+	}
+	return groups;
+}
+
+PackingResult createTextureArray(RenderingContext & context, const std::vector<Texture *> & textures) {
+	PackingResult result;
+	std::vector<const uint8_t *> data;
+	if(!collectData(context, textures, data, "createTextureArray"))
+		return result;
+
+	uint32_t width = 0, height = 0;
+	for(Texture * texture : textures) {
+		width = std::max(width, texture->getWidth());
+		height = std::max(height, texture->getHeight());
+	}
+	Util::Reference<Texture> target = createTarget(textures, TextureType::TEXTURE_2D_ARRAY, width, height, static_cast<uint32_t>(textures.size()), false);
+	if(target.isNull())
+		return result;
+
+	const uint32_t pixelSize = target->getFormat().getPixelSize();
+	const uint32_t rowSize = target->getFormat().getRowSize();
+	uint8_t * targetData = target->getLocalData();
+	for(uint32_t layer = 0; layer < textures.size(); ++layer) {
+		const Texture * texture = textures[layer];
+		copyPixels(targetData + static_cast<size_t>(layer) * rowSize * height, rowSize, 0, 0, data[layer],
+				texture->getWidth(), texture->getHeight(), pixelSize, 0);
+		Placement placement;
+		placement.layer = layer;
+		placement.texCoordRect = Geometry::Rect_f(0.0f, 0.0f,
+				static_cast<float>(texture->getWidth()) / width, static_cast<float>(texture->getHeight()) / height);
+		result.placements.push_back(placement);
+	}
+	target->dataChanged();
+	result.texture = target;
+	return result;
+}
+
+PackingResult createAtlas(RenderingContext & context, const std::vector<Texture *> & textures, uint32_t maxSize, uint32_t padding) {
+	PackingResult result;
+	std::vector<const uint8_t *> data;
+	if(!collectData(context, textures, data, "createAtlas"))
+		return result;
+
+	// shelf packing: place the textures ordered by height in rows
+	std::vector<uint32_t> order(textures.size());
+	uint64_t area = 0;
+	uint32_t maxWidth = 0;
+	for(uint32_t i = 0; i < textures.size(); ++i) {
+		order[i] = i;
+		area += static_cast<uint64_t>(textures[i]->getWidth() + 2 * padding) * (textures[i]->getHeight() + 2 * padding);
+		maxWidth = std::max(maxWidth, textures[i]->getWidth() + 2 * padding);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return textures[a]->getHeight() > textures[b]->getHeight();
+	});
+
+	const uint32_t minWidth = std::max(maxWidth, static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(area)))));
+	uint32_t width = 1;
+	while(width < minWidth)
+		width *= 2;
+
+	std::vector<uint32_t> positions(2 * textures.size());
+	uint32_t height = 0;
+	for(; width <= maxSize; width *= 2) {
+		uint32_t x = 0, y = 0, shelfHeight = 0;
+		for(uint32_t i : order) {
+			const uint32_t w = textures[i]->getWidth() + 2 * padding;
+			const uint32_t h = textures[i]->getHeight() + 2 * padding;
+			if(x + w > width) {
+				y += shelfHeight;
+				x = 0;
+				shelfHeight = 0;
+			}
+			positions[2 * i] = x + padding;
+			positions[2 * i + 1] = y + padding;
+			x += w;
+			shelfHeight = std::max(shelfHeight, h);
+		}
+		height = y + shelfHeight;
+		if(height <= maxSize)
+			break;
+	}
+	if(width > maxSize) {
+		WARN("TexturePacker::createAtlas: Textures do not fit into the atlas.");
+		return result;
+	}
+
+	Util::Reference<Texture> target = createTarget(textures, TextureType::TEXTURE_2D, width, height, 1, true);
+	if(target.isNull())
+		return result;
+	const uint32_t pixelSize = target->getFormat().getPixelSize();
+	const uint32_t rowSize = target->getFormat().getRowSize();
+	for(uint32_t i = 0; i < textures.size(); ++i) {
+		const Texture * texture = textures[i];
+		copyPixels(target->getLocalData(), rowSize, positions[2 * i], positions[2 * i + 1], data[i],
+				texture->getWidth(), texture->getHeight(), pixelSize, padding);
+		Placement placement;
+		placement.texCoordRect = Geometry::Rect_f(static_cast<float>(positions[2 * i]) / width, static_cast<float>(positions[2 * i + 1]) / height,
+				static_cast<float>(texture->getWidth()) / width, static_cast<float>(texture->getHeight()) / height);
+		result.placements.push_back(placement);
+	}
+	target->dataChanged();
+	result.texture = target;
+	return result;
+}
+
+void remapTexCoords(Mesh * mesh, const Placement & placement, Util::StringIdentifier texCoordAttr) {
+	const VertexAttribute & attr = mesh->getVertexDescription().getAttribute(texCoordAttr);
+	if(attr.empty() || attr.getDataType() != GL_FLOAT || attr.getNumValues() < 2) {
+		WARN("TexturePacker::remapTexCoords: Mesh has no float texture coordinates.");
+		return;
+	}
+	const Geometry::Rect_f & rect = placement.texCoordRect;
+	MeshVertexData & vData = mesh->openVertexData();
+	Util::Reference<TexCoordAttributeAccessor> accessor(TexCoordAttributeAccessor::create(vData, texCoordAttr));
+	for(uint32_t i = 0; accessor->checkRange(i); ++i) {
+		const Geometry::Vec2 coord = accessor->getCoordinate(i);
+		accessor->setCoordinate(i, Geometry::Vec2(rect.getX() + coord.x() * rect.getWidth(), rect.getY() + coord.y() * rect.getHeight()));
+	}
+	vData.markAsChanged();
+}
+
+void addLayerAttribute(Mesh * mesh, const Placement & placement, Util::StringIdentifier attrName) {
+	VertexDescription vDesc = mesh->getVertexDescription();
+	MeshVertexData & vData = mesh->openVertexData();
+	const VertexAttribute & attr = vDesc.getAttribute(attrName);
+	if(attr.empty()) {
+		vDesc.appendFloatAttribute(attrName, 1);
+		std::unique_ptr<MeshVertexData> vDataNew(MeshUtils::convertVertices(vData, vDesc));
+		vData.swap(*vDataNew);
+	}
+	Util::Reference<FloatAttributeAccessor> accessor(FloatAttributeAccessor::create(vData, attrName));
+	for(uint32_t i = 0; accessor->checkRange(i); ++i)
+		accessor->setValue(i, static_cast<float>(placement.layer));
+	vData.markAsChanged();
+}
+
+}
+}
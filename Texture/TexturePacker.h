@@ -0,0 +1,80 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_TEXTUREPACKER_H_
+#define RENDERING_TEXTUREPACKER_H_
+
+#include "Texture.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include <Geometry/Rect.h>
+#include <Util/References.h>
+#include <Util/StringIdentifier.h>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+
+/*! Combine many small textures into one texture, so that the meshes using them can be drawn without
+	changing the bound texture (and can be batched).
+	- createTextureArray() copies each texture into a layer of a TEXTURE_2D_ARRAY.
+	- createAtlas() places the textures side by side in a TEXTURE_2D (shelf packing with replicated borders).
+	The placement of each texture is used to adapt the meshes: remapTexCoords() transforms the texture coordinates
+	into the texture's region, addLayerAttribute() adds the texture layer as vertex attribute.
+	\code
+	// meshes[i] uses textures[i]; all textures have the same pixel format
+	TexturePacker::PackingResult result = TexturePacker::createAtlas(context, textures);
+	if(result.texture.isNotNull()) {
+		for(size_t i = 0; i < meshes.size(); ++i)
+			TexturePacker::remapTexCoords(meshes[i], result.placements[i]);
+	}
+	\endcode
+	\note Only uncompressed textures of type TEXTURE_2D are supported. All textures packed together need the same pixel format.
+	\note The texture coordinates of an atlas region cannot repeat; meshes with texture coordinates outside of [0,1]
+		need the array variant (with equally sized textures) instead.	*/
+namespace TexturePacker {
+
+//! The region of a source texture inside the packed texture.
+struct Placement {
+	uint32_t layer;					//!< Layer of the texture array (0 for an atlas)
+	Geometry::Rect_f texCoordRect;	//!< Region in texture coordinates ([0,1] for a full layer)
+	Placement() : layer(0), texCoordRect(0.0f, 0.0f, 1.0f, 1.0f) {}
+};
+
+struct PackingResult {
+	Util::Reference<Texture> texture;	//!< nullptr if the textures could not be packed
+	std::vector<Placement> placements;	//!< One placement per source texture (in the same order)
+};
+
+//! Indices of the textures with equal pixel formats (that can be packed together); unsupported textures are omitted.
+std::vector<std::vector<uint32_t>> groupCompatibleTextures(const std::vector<Texture *> & textures);
+
+/*! Copy the textures into the layers of a new TEXTURE_2D_ARRAY. Its layer size is the maximal size of the textures;
+	smaller textures are placed into the lower left corner of their layer.
+	\note The textures' local data is downloaded if necessary.	*/
+PackingResult createTextureArray(RenderingContext & context, const std::vector<Texture *> & textures);
+
+/*! Pack the textures into a new TEXTURE_2D with a width (a power of two) of at most @p maxSize pixels.
+	The borders of each texture are replicated @p padding times to reduce bleeding due to filtering.
+	Returns a result without texture, if the textures do not fit into maxSize x maxSize pixels.	*/
+PackingResult createAtlas(RenderingContext & context, const std::vector<Texture *> & textures, uint32_t maxSize = 4096, uint32_t padding = 2);
+
+//! Transform the mesh's texture coordinates (stored as floats) from [0,1] into the given placement's region.
+void remapTexCoords(Mesh * mesh, const Placement & placement, Util::StringIdentifier texCoordAttr = VertexAttributeIds::TEXCOORD0);
+
+/*! Set the vertex attribute @p attrName (a single float, added if necessary) of all vertices to the placement's layer.
+	The shader can use it as third texture coordinate for sampling the texture array.	*/
+void addLayerAttribute(Mesh * mesh, const Placement & placement, Util::StringIdentifier attrName);
+
+}
+}
+
+#endif /* RENDERING_TEXTUREPACKER_H_ */
@@ -0,0 +1,162 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "TextureResidencyManager.h"
+#include "Texture.h"
+#include "TextureUploadQueue.h"
+#include "../RenderingContext/RenderingContext.h"
+#include "../RenderingContext/RenderingParameters.h"
+#include "../Serialization/Serialization.h"
+#include <Util/IO/FileName.h>
+#include <Util/IO/FileUtils.h>
+#include <Util/Macros.h>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace Rendering {
+
+//! (ctor)
+TextureResidencyManager::TextureResidencyManager(size_t budgetInBytes) : budget(budgetInBytes), usedMemory(0) {
+}
+
+//! (dtor)
+TextureResidencyManager::~TextureResidencyManager() {
+	for(auto & entry : lru)
+		entry.texture->_setResidencyManager(nullptr);
+}
+
+void TextureResidencyManager::setUploadQueue(TextureUploadQueue * queue) {
+	uploadQueue = queue;
+}
+
+bool TextureResidencyManager::addTexture(Texture * texture) {
+	if(texture == nullptr || texture->getTextureType() == TextureType::TEXTURE_BUFFER || texture->getTextureType() == TextureType::TEXTURE_2D_MULTISAMPLE)
+		return false;
+	if(texture->getResidencyManager() != nullptr)
+		return texture->getResidencyManager() == this;
+	const size_t size = texture->getAccountedGraphicsMemory();
+	lru.push_front({texture, size, false});
+	entries.emplace(texture, lru.begin());
+	usedMemory += size;
+	texture->_setResidencyManager(this);
+	return true;
+}
+
+void TextureResidencyManager::removeTexture(Texture * texture) {
+	auto it = entries.find(texture);
+	if(it == entries.end())
+		return;
+	usedMemory -= it->second->size;
+	texture->_setResidencyManager(nullptr);
+	lru.erase(it->second);
+	entries.erase(it);
+}
+
+void TextureResidencyManager::releaseUnusedTextures() {
+	for(auto it = lru.begin(); it != lru.end();) {
+		Texture * texture = (it++)->texture.get();
+		if(texture->countReferences() == 1)
+			removeTexture(texture);
+	}
+}
+
+void TextureResidencyManager::evictAll(RenderingContext & context) {
+	for(auto & entry : lru) {
+		if(entry.size > 0 && isEvictable(context, entry))
+			evict(entry);
+	}
+}
+
+//! (internal)
+bool TextureResidencyManager::isEvictable(RenderingContext & context, const Entry & entry) const {
+	const Texture * texture = entry.texture.get();
+	if(texture->getGLId() == 0 || texture->isUploadPending() || texture->isBindlessResident() || texture->hasSparseStorage()
+			|| texture->getMemoryCategory() != MemoryRegistry::TEXTURE)
+		return false;
+	if(texture->getLocalData() == nullptr && (texture->getFileName().toString().empty() || !Util::FileUtils::isFile(texture->getFileName())))
+		return false;
+	for(uint_fast8_t unit = 0; unit < MAX_TEXTURES; ++unit) {
+		if(context.getTexture(unit) == texture)
+			return false;
+	}
+	return true;
+}
+
+//! (internal)
+void TextureResidencyManager::evict(Entry & entry) {
+	Texture * texture = entry.texture.get();
+	texture->removeGLData();
+	if(entry.reloaded) {
+		texture->_releaseLocalData();
+		entry.reloaded = false;
+	}
+	++statistics.evictions;
+	statistics.evictedBytes += entry.size;
+	usedMemory -= entry.size;
+	entry.size = 0;
+}
+
+//! (internal)
+void TextureResidencyManager::enforceBudget(RenderingContext & context, const Texture * keep) {
+	for(auto it = lru.rbegin(); it != lru.rend() && usedMemory > budget; ++it) {
+		if(it->size > 0 && it->texture.get() != keep && isEvictable(context, *it))
+			evict(*it);
+	}
+}
+
+//! (internal)
+bool TextureResidencyManager::reload(Entry & entry) {
+	Texture * texture = entry.texture.get();
+	const Util::FileName & fileName = texture->getFileName();
+	if(fileName.toString().empty())
+		return false;
+	// bypass the texture cache, which would return the texture itself
+	const std::vector<uint8_t> bytes = Util::FileUtils::loadFile(fileName);
+	Util::Reference<Texture> loaded = Serialization::loadTexture(fileName.getEnding(), std::string(bytes.begin(), bytes.end()),
+																	texture->getTextureType(), texture->getNumLayers());
+	if(loaded.isNull() || !texture->_takeLocalData(*loaded.get())) {
+		WARN("TextureResidencyManager: Could not reload texture '" + fileName.toString() + "'.");
+		return false;
+	}
+	entry.reloaded = true;
+	++statistics.reloads;
+	return true;
+}
+
+uint32_t TextureResidencyManager::_prepareForBinding(RenderingContext & context, Texture & texture) {
+	auto it = entries.find(&texture);
+	if(it == entries.end())
+		return texture._uploadForBinding(context);
+	Entry & entry = *it->second;
+	lru.splice(lru.begin(), lru, it->second);
+
+	const bool wasUploaded = texture.getGLId() != 0 || texture.isUploadPending();
+	if(!wasUploaded) {
+		if(texture.getLocalData() == nullptr)
+			reload(entry);
+		if(uploadQueue.isNotNull() && texture.getLocalData() != nullptr)
+			uploadQueue->enqueue(context, &texture);
+		++statistics.misses;
+	} else {
+		++statistics.hits;
+	}
+	const uint32_t glId = texture._uploadForBinding(context);
+
+	// the size may have changed (upload, mipmaps)
+	const size_t size = texture.getAccountedGraphicsMemory();
+	usedMemory = usedMemory - entry.size + size;
+	entry.size = size;
+	if(usedMemory > budget)
+		enforceBudget(context, &texture);
+	return glId;
+}
+
+}
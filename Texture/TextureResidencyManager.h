@@ -0,0 +1,105 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_TEXTURERESIDENCYMANAGER_H_
+#define RENDERING_TEXTURERESIDENCYMANAGER_H_
+
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+namespace Rendering {
+class RenderingContext;
+class Texture;
+class TextureUploadQueue;
+
+/**
+ * Keeps the graphics memory used by the registered textures below a budget.
+ *
+ * Every time a registered texture is bound, it becomes the most recently used one. If the budget is exceeded, the gl
+ * data of the least recently used textures is removed. It is uploaded again (through the TextureUploadQueue,
+ * if one is set) the next time the texture is bound. Only textures that either have local data or can be reloaded
+ * from their file (see Texture::getFileName()) are evicted; the local data of a reloaded texture is released again
+ * when it is evicted the next time.
+ *
+ * Textures that are currently bound, used as render targets, bindless resident, sparse or uploaded asynchronously
+ * are never evicted.
+ *
+ * @note The manager holds a reference to every registered texture. Textures that are only referenced by the manager
+ *	are released by releaseUnusedTextures().
+ * @note A texture that is larger than the whole budget is still uploaded when it is bound.
+ */
+class TextureResidencyManager {
+	public:
+		struct Statistics {
+			uint64_t hits;			//!< Bound textures whose data was already uploaded.
+			uint64_t misses;		//!< Bound textures whose data had to be uploaded (again).
+			uint64_t reloads;		//!< Evicted textures whose data was reloaded from their file.
+			uint64_t evictions;		//!< Textures whose gl data was removed to meet the budget.
+			uint64_t evictedBytes;
+			Statistics() : hits(0), misses(0), reloads(0), evictions(0), evictedBytes(0) {}
+		};
+
+		explicit TextureResidencyManager(size_t budgetInBytes);
+		~TextureResidencyManager();
+
+		size_t getBudget() const						{	return budget;	}
+		//! Set the budget; it is enforced the next time a registered texture is bound.
+		void setBudget(size_t budgetInBytes)			{	budget = budgetInBytes;	}
+		//! Graphics memory currently used by the registered textures.
+		size_t getUsedMemory() const					{	return usedMemory;	}
+		uint32_t getNumTextures() const					{	return static_cast<uint32_t>(entries.size());	}
+
+		//! If set, evicted textures are uploaded again asynchronously (if supported for the texture).
+		void setUploadQueue(TextureUploadQueue * queue);
+		TextureUploadQueue * getUploadQueue() const		{	return uploadQueue.get();	}
+
+		const Statistics & getStatistics() const		{	return statistics;	}
+		void resetStatistics()							{	statistics = Statistics();	}
+
+		/*! Manage the given texture.
+			@return false if the texture is already managed by another manager or it is a buffer or multisample texture.	*/
+		bool addTexture(Texture * texture);
+		void removeTexture(Texture * texture);
+		//! Unregister the textures that are no longer referenced outside of this manager.
+		void releaseUnusedTextures();
+		//! Remove the gl data of all evictable textures that are not bound.
+		void evictAll(RenderingContext & context);
+
+		//! (internal) Called by Texture::_prepareForBinding().
+		uint32_t _prepareForBinding(RenderingContext & context, Texture & texture);
+
+	private:
+		struct Entry {
+			Util::Reference<Texture> texture;
+			size_t size;		//!< accounted graphics memory
+			bool reloaded;		//!< the local data has been reloaded from the file and can be released again
+		};
+		typedef std::list<Entry> lru_t;
+
+		size_t budget;
+		size_t usedMemory;
+		lru_t lru; //!< front = most recently bound
+		std::unordered_map<Texture *, lru_t::iterator> entries;
+		Util::Reference<TextureUploadQueue> uploadQueue;
+		Statistics statistics;
+
+		bool isEvictable(RenderingContext & context, const Entry & entry) const;
+		void evict(Entry & entry);
+		void enforceBudget(RenderingContext & context, const Texture * keep);
+		//! Reload the local data of an evicted texture from its file.
+		bool reload(Entry & entry);
+};
+
+}
+
+#endif /* RENDERING_TEXTURERESIDENCYMANAGER_H_ */
@@ -0,0 +1,266 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "TextureUploadQueue.h"
+#include "Texture.h"
+#include "TextureUtils.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+#include "../RenderingContext/RenderingContext.h"
+#include "../RenderingContext/RenderingParameters.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Rendering {
+
+//! (static)
+bool TextureUploadQueue::isSupported() {
+#if defined(LIB_GL)
+	static const bool support = isExtensionSupported("GL_ARB_pixel_buffer_object");
+	return support;
+#else
+	return false;
+#endif
+}
+
+TextureUploadQueue::TextureUploadQueue(size_t _bytesPerFrame) :
+		ReferenceCounter_t(), entries(), bytesPerFrame(_bytesPerFrame), stagingBuffer(), placeholders() {
+}
+
+TextureUploadQueue::~TextureUploadQueue() {
+	// the placeholders are released, so the remaining textures are uploaded as usual
+	for(auto & entry : entries) {
+		if(entry.texture->isUploadPending()) {
+			entry.texture->_setPlaceholderGLId(0);
+			entry.texture->dataChanged();
+		}
+	}
+}
+
+bool TextureUploadQueue::enqueue(RenderingContext & context, Texture * texture) {
+	if(texture == nullptr || texture->getLocalData() == nullptr || !isSupported())
+		return false;
+	const TextureType type = texture->getTextureType();
+	if(texture->getFormat().pixelFormat.compressed) {
+		if(type != TextureType::TEXTURE_2D && type != TextureType::TEXTURE_2D_ARRAY)
+			return false;
+	} else if(type != TextureType::TEXTURE_2D && type != TextureType::TEXTURE_2D_ARRAY && type != TextureType::TEXTURE_3D) {
+		return false;
+	}
+	if(texture->isUploadPending())
+		return true;
+
+	const uint32_t numLevels = texture->isMipmapCreationPlanned() ?
+			static_cast<uint32_t>(std::log2(std::max(texture->getWidth(), texture->getHeight()))) + 1 :
+			1 + static_cast<uint32_t>(texture->getLocalMipmaps().size());
+	texture->_allocateGLStorage(context, numLevels);
+	texture->_setPlaceholderGLId(getPlaceholderGLId(context, texture));
+
+	Entry entry;
+	entry.texture = texture;
+	entry.nextRow = 0;
+	entries.push_back(entry);
+	return true;
+}
+
+size_t TextureUploadQueue::process(RenderingContext & context) {
+	size_t uploadedBytes = 0;
+	while(!entries.empty()) {
+		Entry & entry = entries.front();
+		// the upload has been cancelled by removing or re-uploading the texture
+		if(!entry.texture->isUploadPending() || entry.texture->getLocalData() == nullptr) {
+			entries.pop_front();
+			continue;
+		}
+		if(uploadedBytes > 0 && uploadedBytes >= bytesPerFrame)
+			break;
+		if(!uploadRows(context, entry, bytesPerFrame - std::min(bytesPerFrame, uploadedBytes), uploadedBytes))
+			break;
+		Util::Reference<Texture> texture = entry.texture;
+		entries.pop_front();
+		completeUpload(context, texture.get());
+	}
+	return uploadedBytes;
+}
+
+void TextureUploadQueue::finish(RenderingContext & context) {
+	const size_t budget = bytesPerFrame;
+	bytesPerFrame = std::numeric_limits<size_t>::max();
+	process(context);
+	bytesPerFrame = budget;
+}
+
+void TextureUploadQueue::cancel(Texture * texture) {
+	for(auto it = entries.begin(); it != entries.end(); ++it) {
+		if(it->texture.get() == texture) {
+			if(texture->isUploadPending()) {
+				texture->_setPlaceholderGLId(0);
+				texture->dataChanged();
+			}
+			entries.erase(it);
+			return;
+		}
+	}
+}
+
+size_t TextureUploadQueue::getPendingBytes() const {
+	size_t numBytes = 0;
+	for(const auto & entry : entries) {
+		const Texture::Format & format = entry.texture->getFormat();
+		if(format.pixelFormat.compressed)
+			numBytes += format.getDataSize() - format.getLevelDataOffset(entry.nextRow);
+		else
+			numBytes += static_cast<size_t>(format.sizeY * format.numLayers - entry.nextRow) * format.getRowSize();
+	}
+	return numBytes;
+}
+
+//! (internal)
+uint32_t TextureUploadQueue::getPlaceholderGLId(RenderingContext & context, Texture * texture) {
+	Util::Reference<Texture> & placeholder = placeholders[texture->getGLTextureType()];
+	if(placeholder.isNull()) {
+		placeholder = TextureUtils::createColorTexture(texture->getTextureType(), 1, 1, 1, Util::TypeConstant::UINT8, 4, true);
+		placeholder->allocateLocalData();
+		uint8_t * data = placeholder->getLocalData();
+		data[0] = data[1] = data[2] = 128;
+		data[3] = 255;
+		placeholder->dataChanged();
+	}
+	return placeholder->_prepareForBinding(context);
+}
+
+//! (internal)
+bool TextureUploadQueue::uploadRows(RenderingContext & context, Entry & entry, size_t budget, size_t & uploadedBytes) {
+#if defined(LIB_GL)
+	Texture * texture = entry.texture.get();
+	const Texture::Format & format = texture->getFormat();
+	const uint8_t * localData = texture->getLocalData();
+	// a compressed texture is uploaded level by level; its "rows" are the mipmap levels
+	const uint32_t totalRows = format.pixelFormat.compressed ? std::max(1u, format.numMipLevels) : format.sizeY * format.numLayers;
+	const size_t rowSize = format.getRowSize();
+
+	const GLuint textureId = texture->getGLId();
+#if defined(GL_ARB_direct_state_access)
+	const bool directStateAccess = isDirectStateAccessSupported();
+#else
+	const bool directStateAccess = false;
+#endif
+	GLint activeTexture = GL_TEXTURE0;
+	if(!directStateAccess) {
+		glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+		context.pushAndSetTexture(0,nullptr); // store and disable texture unit 0, so that we can use it without side effects.
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(format.glTextureType, textureId);
+	}
+
+	size_t usedBytes = 0;
+	while(entry.nextRow < totalRows) {
+		if(format.pixelFormat.compressed) {
+			const uint32_t level = entry.nextRow;
+			const size_t numBytes = format.getLevelDataSize(level);
+			if(usedBytes + numBytes > budget && (usedBytes > 0 || uploadedBytes > 0))
+				break;
+			const GLsizei width = std::max(1, static_cast<GLsizei>(format.sizeX) >> level);
+			const GLsizei height = std::max(1, static_cast<GLsizei>(format.sizeY) >> level);
+
+			stagingBuffer.uploadData(GL_PIXEL_UNPACK_BUFFER, localData + format.getLevelDataOffset(level), numBytes, GL_STREAM_DRAW);
+			stagingBuffer.bind(GL_PIXEL_UNPACK_BUFFER);
+#if defined(GL_ARB_direct_state_access)
+			if(directStateAccess && texture->getTextureType() == TextureType::TEXTURE_2D) {
+				glCompressedTextureSubImage2D(textureId, static_cast<GLint>(level), 0, 0, width, height,
+											static_cast<GLenum>(format.pixelFormat.glInternalFormat), static_cast<GLsizei>(numBytes), nullptr);
+			} else if(directStateAccess) {
+				glCompressedTextureSubImage3D(textureId, static_cast<GLint>(level), 0, 0, 0, width, height, static_cast<GLsizei>(format.numLayers),
+											static_cast<GLenum>(format.pixelFormat.glInternalFormat), static_cast<GLsizei>(numBytes), nullptr);
+			} else
+#endif
+			if(texture->getTextureType() == TextureType::TEXTURE_2D) {
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), 0, 0, width, height,
+											static_cast<GLenum>(format.pixelFormat.glInternalFormat), static_cast<GLsizei>(numBytes), nullptr);
+			} else {
+				glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), 0, 0, 0, width, height, static_cast<GLsizei>(format.numLayers),
+											static_cast<GLenum>(format.pixelFormat.glInternalFormat), static_cast<GLsizei>(numBytes), nullptr);
+			}
+			stagingBuffer.unbind(GL_PIXEL_UNPACK_BUFFER);
+			++entry.nextRow;
+			usedBytes += numBytes;
+			continue;
+		}
+		uint32_t numRows = static_cast<uint32_t>((budget - usedBytes) / rowSize);
+		if(numRows == 0) {
+			if(usedBytes > 0 || uploadedBytes > 0)
+				break;
+			numRows = 1; // always make progress
+		}
+		const uint32_t layer = entry.nextRow / format.sizeY;
+		const uint32_t y = entry.nextRow % format.sizeY;
+		numRows = std::min(numRows, format.sizeY - y);
+		const size_t numBytes = numRows * rowSize;
+
+		stagingBuffer.uploadData(GL_PIXEL_UNPACK_BUFFER, localData + entry.nextRow * rowSize, numBytes, GL_STREAM_DRAW);
+		stagingBuffer.bind(GL_PIXEL_UNPACK_BUFFER);
+#if defined(GL_ARB_direct_state_access)
+		if(directStateAccess && texture->getTextureType() == TextureType::TEXTURE_2D) {
+			glTextureSubImage2D(textureId, 0, 0, static_cast<GLint>(y), static_cast<GLsizei>(format.sizeX), static_cast<GLsizei>(numRows),
+							static_cast<GLenum>(format.pixelFormat.glLocalDataFormat), static_cast<GLenum>(format.pixelFormat.glLocalDataType), nullptr);
+		} else if(directStateAccess) {
+			glTextureSubImage3D(textureId, 0, 0, static_cast<GLint>(y), static_cast<GLint>(layer),
+							static_cast<GLsizei>(format.sizeX), static_cast<GLsizei>(numRows), 1,
+							static_cast<GLenum>(format.pixelFormat.glLocalDataFormat), static_cast<GLenum>(format.pixelFormat.glLocalDataType), nullptr);
+		} else
+#endif
+		if(texture->getTextureType() == TextureType::TEXTURE_2D) {
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, static_cast<GLint>(y), static_cast<GLsizei>(format.sizeX), static_cast<GLsizei>(numRows),
+							static_cast<GLenum>(format.pixelFormat.glLocalDataFormat), static_cast<GLenum>(format.pixelFormat.glLocalDataType), nullptr);
+		} else {
+			glTexSubImage3D(static_cast<GLenum>(format.glTextureType), 0, 0, static_cast<GLint>(y), static_cast<GLint>(layer),
+							static_cast<GLsizei>(format.sizeX), static_cast<GLsizei>(numRows), 1,
+							static_cast<GLenum>(format.pixelFormat.glLocalDataFormat), static_cast<GLenum>(format.pixelFormat.glLocalDataType), nullptr);
+		}
+		stagingBuffer.unbind(GL_PIXEL_UNPACK_BUFFER);
+		entry.nextRow += numRows;
+		usedBytes += numBytes;
+	}
+	GET_GL_ERROR();
+	if(!directStateAccess) {
+		context.popTexture(0);
+		glActiveTexture(activeTexture);
+	}
+
+	uploadedBytes += usedBytes;
+	return entry.nextRow >= totalRows;
+#else
+	return true;
+#endif
+}
+
+//! (internal)
+void TextureUploadQueue::completeUpload(RenderingContext & context, Texture * texture) {
+	texture->_setPlaceholderGLId(0);
+	if(texture->isMipmapCreationPlanned())
+		texture->createMipmaps(context);
+	else
+		texture->_uploadLocalMipmaps(context);
+
+	// texture units that are already bound to the texture still use the placeholder
+	GLint activeTexture;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	for(uint_fast8_t unit = 0; unit < MAX_TEXTURES; ++unit) {
+		if(context.getTexture(unit) == texture) {
+			glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(unit));
+			glBindTexture(texture->getGLTextureType(), texture->getGLId());
+		}
+	}
+	glActiveTexture(activeTexture);
+	GET_GL_ERROR();
+}
+
+}
@@ -0,0 +1,94 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_TEXTURE_UPLOADQUEUE_H_
+#define RENDERING_TEXTURE_UPLOADQUEUE_H_
+
+#include "../BufferObject.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+
+namespace Rendering {
+class RenderingContext;
+class Texture;
+
+/**
+ * Queue for uploading the local data of textures over several frames.
+ *
+ * enqueue() allocates the texture's storage once (glTexStorage if available) and binds a small placeholder texture
+ * of the same type whenever the texture is used. process() is called once per frame and copies at most
+ * @a bytesPerFrame bytes of the queued textures' local data through a pixel unpack buffer with glTexSubImage.
+ * Large textures are split into bands of rows (compressed textures into their stored mipmap levels); when all data
+ * of a texture has been uploaded, its planned mipmaps are created and the placeholder is replaced.
+ *
+ * @note Only uncompressed TEXTURE_2D, TEXTURE_2D_ARRAY and TEXTURE_3D textures and compressed TEXTURE_2D and
+ *	TEXTURE_2D_ARRAY textures are supported.
+ */
+class TextureUploadQueue : public Util::ReferenceCounter<TextureUploadQueue> {
+	public:
+		//! Requires GL_ARB_pixel_buffer_object.
+		static bool isSupported();
+
+		explicit TextureUploadQueue(size_t bytesPerFrame = 4 * 1024 * 1024);
+		~TextureUploadQueue();
+
+		/*! Queue the upload of the texture's local data.
+			@return @c false if the texture cannot be uploaded asynchronously (no local data, unsupported type,
+				or no support for pixel buffer objects). It is then uploaded as usual when it is bound.	*/
+		bool enqueue(RenderingContext & context, Texture * texture);
+
+		/*! Upload the next part of the queued data (at least one band of rows, even if it exceeds the budget).
+			@return the number of bytes uploaded in this call.	*/
+		size_t process(RenderingContext & context);
+
+		//! Upload all pending data immediately.
+		void finish(RenderingContext & context);
+
+		//! Remove the texture from the queue; its data is uploaded as usual when it is bound the next time.
+		void cancel(Texture * texture);
+
+		bool isEmpty() const							{	return entries.empty();	}
+		size_t getPendingCount() const					{	return entries.size();	}
+		//! Number of bytes that still have to be uploaded.
+		size_t getPendingBytes() const;
+
+		size_t getBytesPerFrame() const					{	return bytesPerFrame;	}
+		void setBytesPerFrame(size_t numBytes)			{	bytesPerFrame = numBytes;	}
+
+	private:
+		struct Entry {
+			Util::Reference<Texture> texture;
+			//! Index of the next row of the local data (rows of all layers are numbered consecutively).
+			uint32_t nextRow;
+		};
+		std::deque<Entry> entries;
+		size_t bytesPerFrame;
+		BufferObject stagingBuffer;
+		//! Placeholder textures by gl texture type.
+		std::map<uint32_t, Util::Reference<Texture>> placeholders;
+
+		//! (internal) Return the gl texture that is bound instead of a texture of the given type.
+		uint32_t getPlaceholderGLId(RenderingContext & context, Texture * texture);
+
+		/*! (internal) Upload rows of the entry's texture until @p budget is used up.
+			@return @c true iff all data of the texture has been uploaded.	*/
+		bool uploadRows(RenderingContext & context, Entry & entry, size_t budget, size_t & uploadedBytes);
+
+		//! (internal) Finish the upload of a texture: create mipmaps and replace the placeholder.
+		void completeUpload(RenderingContext & context, Texture * texture);
+};
+
+}
+
+#endif /* RENDERING_TEXTURE_UPLOADQUEUE_H_ */
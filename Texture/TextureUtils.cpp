@@ -9,6 +9,8 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "TextureUtils.h"
+#include "RawHeightFieldReader.h"
+#include "../MeshUtils/internal/ParallelFor.h"
 #include "../Mesh/Mesh.h"
 #include "../Mesh/MeshDataStrategy.h"
 #include "../Mesh/MeshIndexData.h"
@@ -18,6 +20,11 @@
 #include "../Mesh/VertexDescription.h"
 #include "../RenderingContext/RenderingParameters.h"
 #include "../RenderingContext/RenderingContext.h"
+#include "../Shader/Shader.h"
+#include "../Shader/ShaderObjectInfo.h"
+#include "../Shader/Uniform.h"
+#include "../BufferObject.h"
+#include "../ComputePass.h"
 #include "../GLHeader.h"
 #include "../Helper.h"
 #include <Geometry/Definitions.h>
@@ -33,9 +40,12 @@
 #include <Util/Graphics/PixelAccessor.h>
 #include <Util/Macros.h>
 #include <Util/References.h>
+#include <Util/StringUtils.h>
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <limits>
+#include <map>
 #include <stdexcept>
 #include <string>
 
@@ -338,6 +348,105 @@ Util::Reference<Texture> createColorTexture(TextureType type,uint32_t sizeX,uint
 	return create( type, sizeX, sizeY, numLayers, glPixelFormat.glLocalDataFormat, glPixelFormat.glLocalDataType, glPixelFormat.glInternalFormat, filtering, clampToEdge, samples);
 }
 
+//! [static] Factory
+Util::Reference<Texture> createCompressedTexture(TextureType type,uint32_t sizeX,uint32_t sizeY, uint32_t numLayers, uint32_t glInternalFormat, uint32_t numMipLevels/*=1*/){
+	uint32_t blockWidth, blockHeight, blockSize;
+	if(!getCompressedBlockSize(glInternalFormat, blockWidth, blockHeight, blockSize)){
+		WARN("createCompressedTexture: Unknown compressed format " + Util::StringUtils::toString(glInternalFormat));
+		return nullptr;
+	}
+	Texture::Format format;
+	format.glTextureType = textureTypeToGLTextureType(type);
+	format.sizeX = sizeX;
+	format.sizeY = sizeY;
+	format.numLayers = numLayers;
+	format.numMipLevels = std::max(1u, numMipLevels);
+	format.pixelFormat.glInternalFormat = glInternalFormat;
+	format.pixelFormat.compressed = true;
+
+	Util::Reference<Texture> texture = new Texture(format);
+	texture->allocateLocalData();
+	return texture;
+}
+
+//! [static]
+bool getCompressedBlockSize(uint32_t glInternalFormat, uint32_t & blockWidth, uint32_t & blockHeight, uint32_t & blockSize){
+	blockWidth = 4;
+	blockHeight = 4;
+	switch(glInternalFormat){
+#if defined(GL_EXT_texture_compression_s3tc)
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+#endif
+#if defined(GL_EXT_texture_sRGB)
+		case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+#endif
+#if defined(GL_ARB_texture_compression_rgtc)
+		case GL_COMPRESSED_RED_RGTC1:
+		case GL_COMPRESSED_SIGNED_RED_RGTC1:
+#endif
+#if defined(GL_ARB_ES3_compatibility)
+		case GL_COMPRESSED_RGB8_ETC2:
+		case GL_COMPRESSED_SRGB8_ETC2:
+		case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case GL_COMPRESSED_R11_EAC:
+		case GL_COMPRESSED_SIGNED_R11_EAC:
+#endif
+#if defined(GL_OES_compressed_ETC1_RGB8_texture)
+		case GL_ETC1_RGB8_OES:
+#endif
+			blockSize = 8;
+			return true;
+#if defined(GL_EXT_texture_compression_s3tc)
+		case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+#endif
+#if defined(GL_EXT_texture_sRGB)
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+#endif
+#if defined(GL_ARB_texture_compression_rgtc)
+		case GL_COMPRESSED_RG_RGTC2:
+		case GL_COMPRESSED_SIGNED_RG_RGTC2:
+#endif
+#if defined(GL_ARB_texture_compression_bptc)
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+		case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+		case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+		case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+#endif
+#if defined(GL_ARB_ES3_compatibility)
+		case GL_COMPRESSED_RGBA8_ETC2_EAC:
+		case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+		case GL_COMPRESSED_RG11_EAC:
+		case GL_COMPRESSED_SIGNED_RG11_EAC:
+#endif
+			blockSize = 16;
+			return true;
+		default:
+			break;
+	}
+#if defined(GL_KHR_texture_compression_astc_ldr)
+	// ASTC: all blocks have 16 bytes; the formats are ordered by block size (4x4 ... 12x12) for linear and sRGB data.
+	static const uint8_t astcBlockSizes[14][2] = {	{4,4}, {5,4}, {5,5}, {6,5}, {6,6}, {8,5}, {8,6}, {8,8},
+													{10,5}, {10,6}, {10,8}, {10,10}, {12,10}, {12,12} };
+	uint32_t astcIndex = 14;
+	if(glInternalFormat >= GL_COMPRESSED_RGBA_ASTC_4x4_KHR && glInternalFormat <= GL_COMPRESSED_RGBA_ASTC_12x12_KHR)
+		astcIndex = glInternalFormat - GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
+	else if(glInternalFormat >= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR && glInternalFormat <= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12_KHR)
+		astcIndex = glInternalFormat - GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR;
+	if(astcIndex < 14){
+		blockWidth = astcBlockSizes[astcIndex][0];
+		blockHeight = astcBlockSizes[astcIndex][1];
+		blockSize = 16;
+		return true;
+	}
+#endif
+	return false;
+}
+
 //! (static)
 Util::Reference<Texture> createStdCubeTexture(uint32_t width, bool alpha) {
 	return createColorTexture(TextureType::TEXTURE_CUBE_MAP, width, width, 6, Util::TypeConstant::UINT8, alpha ? 4 : 3,  true);
@@ -422,20 +531,21 @@ Util::Reference<Texture> createNoiseTexture(uint32_t width, uint32_t height, boo
 	Util::Reference<Texture> texture = create(TextureType::TEXTURE_2D,width,height,1, alpha ? GL_RGBA : GL_RGB, GL_FLOAT,alpha ? GL_RGBA32F_ARB : GL_RGB32F_ARB,true);
 
 	texture->allocateLocalData();
-	Util::Reference<Util::PixelAccessor> pixelAccessor = Util::PixelAccessor::create(texture->getLocalBitmap());
-	Util::NoiseGenerator generator(17);
-	for(uint_fast32_t i = 0; i < static_cast<uint_fast32_t>(texture->getWidth()); ++i) {
-		for(uint_fast32_t j = 0; j < static_cast<uint_fast32_t>(texture->getHeight()); ++j) {
-			const float x = (i + 0.5f) * scaling;
+	float * data = reinterpret_cast<float *>(texture->getLocalData());
+	const uint32_t numComponents = alpha ? 4 : 3;
+	// the rows are written in parallel; every chunk uses its own (identically seeded) generator
+	MeshUtils::parallelFor(height, [&](uint32_t begin, uint32_t end) {
+		Util::NoiseGenerator generator(17);
+		for(uint_fast32_t j = begin; j < end; ++j) {
+			float * pixel = data + static_cast<size_t>(j) * width * numComponents;
 			const float y = (j + 0.5f) * scaling;
-			pixelAccessor->writeColor(i, j, Util::Color4f(
-					(generator.get(x, y, 0.5f) + 1.0f) / 2.0f,
-					(generator.get(x, y, 1.5f) + 1.0f) / 2.0f,
-					(generator.get(x, y, 2.5f) + 1.0f) / 2.0f,
-					(generator.get(x, y, 3.5f) + 1.0f) / 2.0f
-			));
+			for(uint_fast32_t i = 0; i < width; ++i) {
+				const float x = (i + 0.5f) * scaling;
+				for(uint_fast32_t c = 0; c < numComponents; ++c)
+					*pixel++ = (generator.get(x, y, c + 0.5f) + 1.0f) / 2.0f;
+			}
 		}
-	}
+	}, 16);
 	texture->dataChanged();
 
 	return texture.detachAndDecrease();
@@ -456,30 +566,134 @@ Util::Reference<Texture> createChessTexture(uint32_t width, uint32_t height, int
 	t->allocateLocalData();
 	GLubyte * tData=t->getLocalData();
 
-	GLubyte c;
-	int k=0;
-	for(uint_fast32_t i = 0; i < height; ++i) {
-		for(uint_fast32_t j = 0; j < width; ++j) {
-			c=(((i&fieldSize_powOfTwo)==0)^((j&fieldSize_powOfTwo)==0))*255;
-			tData[k++]=c;
-			tData[k++]=c;
-			tData[k++]=c;
-			tData[k++]=255;
-		}
+	// there are only two different rows; build them once and copy them in parallel
+	const size_t rowSize = static_cast<size_t>(width) * 4;
+	std::vector<GLubyte> rows(2 * rowSize);
+	for(uint_fast32_t j = 0; j < width; ++j) {
+		const GLubyte c = ((j&fieldSize_powOfTwo)==0) ? 0 : 255;
+		std::fill_n(rows.begin() + j * 4, 3, c);
+		std::fill_n(rows.begin() + rowSize + j * 4, 3, 255 - c);
+		rows[j * 4 + 3] = rows[rowSize + j * 4 + 3] = 255;
 	}
+	MeshUtils::parallelFor(height, [&](uint32_t begin, uint32_t end) {
+		for(uint_fast32_t i = begin; i < end; ++i) {
+			const auto row = rows.begin() + ((i&fieldSize_powOfTwo)==0 ? 0 : rowSize);
+			std::copy(row, row + rowSize, tData + i * rowSize);
+		}
+	}, 64);
 	t->dataChanged();
 	return t;
 }
 
-Util::Reference<Texture> createTextureFromBitmap(const Util::Bitmap & bitmap, TextureType type, uint32_t numLayers, bool clampToEdge){
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_image_load_store)
+static const char * const proceduralProgram = R"***(
+layout(local_size_x = 16, local_size_y = 16) in;
+layout(IMAGE_FORMAT, binding = 0) uniform writeonly image2D target;
+uniform int fieldSize;
+uniform float scaling;
+uniform bool alpha;
+
+uint hash(uvec3 v) {
+	v = v * 1664525u + 1013904223u;
+	v.x += v.y * v.z; v.y += v.z * v.x; v.z += v.x * v.y;
+	v ^= v >> 16u;
+	v.x += v.y * v.z; v.y += v.z * v.x; v.z += v.x * v.y;
+	return v.x ^ v.y ^ v.z;
+}
+
+// gradient of the integer lattice point; the twelve edge directions of improved Perlin noise
+float gradient(ivec3 cell, vec3 offset) {
+	const uint h = hash(uvec3(cell)) % 12u;
+	const float u = h < 8u ? offset.x : offset.y;
+	const float v = h < 4u ? offset.y : offset.z;
+	return ((h & 1u) == 0u ? u : -u) + ((h & 2u) == 0u ? v : -v);
+}
+
+float noise(vec3 p) {
+	const ivec3 i = ivec3(floor(p));
+	const vec3 f = fract(p);
+	const vec3 u = f * f * f * (f * (f * 6.0 - 15.0) + 10.0);
+	return mix(mix(mix(gradient(i, f), gradient(i + ivec3(1, 0, 0), f - vec3(1, 0, 0)), u.x),
+				   mix(gradient(i + ivec3(0, 1, 0), f - vec3(0, 1, 0)), gradient(i + ivec3(1, 1, 0), f - vec3(1, 1, 0)), u.x), u.y),
+			   mix(mix(gradient(i + ivec3(0, 0, 1), f - vec3(0, 0, 1)), gradient(i + ivec3(1, 0, 1), f - vec3(1, 0, 1)), u.x),
+				   mix(gradient(i + ivec3(0, 1, 1), f - vec3(0, 1, 1)), gradient(i + ivec3(1, 1, 1), f - vec3(1, 1, 1)), u.x), u.y), u.z);
+}
+
+void main() {
+	const ivec2 pos = ivec2(gl_GlobalInvocationID.xy);
+	if(any(greaterThanEqual(pos, imageSize(target))))
+		return;
+#ifdef NOISE
+	const vec2 p = (vec2(pos) + 0.5) * scaling;
+	const vec4 color = vec4(noise(vec3(p, 0.5)), noise(vec3(p, 1.5)), noise(vec3(p, 2.5)), noise(vec3(p, 3.5))) * 0.5 + 0.5;
+	imageStore(target, pos, alpha ? color : vec4(color.rgb, 1.0));
+#else
+	const float c = (((pos.y & fieldSize) == 0) != ((pos.x & fieldSize) == 0)) ? 1.0 : 0.0;
+	imageStore(target, pos, vec4(c, c, c, 1.0));
+#endif
+}
+)***";
+
+//! (internal) Fill the gl texture with the procedural content using a compute shader.
+static bool generateProceduralTexture(RenderingContext & context, Texture & texture, const char * imageFormat, bool noise, float scaling, bool alpha, int fieldSize) {
+	static const bool support = isExtensionSupported("GL_ARB_compute_shader") && RenderingContext::isImageBindingSupported();
+	if(!support)
+		return false;
+	static std::map<bool, Util::Reference<Shader>> shaders;
+	Util::Reference<Shader> & shader = shaders[noise];
+	if(shader.isNull()) {
+		std::string source = "#version 430\n#define IMAGE_FORMAT " + std::string(imageFormat) + "\n";
+		if(noise)
+			source += "#define NOISE\n";
+		shader = Shader::createShader(Shader::USE_UNIFORMS);
+		shader->attachShaderObject(ShaderObjectInfo::createCompute(source + proceduralProgram));
+	}
+
+	context.pushAndSetShader(shader.get());
+	ImageBindParameters target(&texture);
+	target.setReadOperations(false);
+	target.setWriteOperations(true);
+	context.pushAndSetBoundImage(0, target);
+	shader->setUniform(context, Uniform("fieldSize", fieldSize), false);
+	shader->setUniform(context, Uniform("scaling", scaling), false);
+	shader->setUniform(context, Uniform("alpha", alpha), false);
+	context.dispatchCompute((texture.getWidth() + 15) / 16, (texture.getHeight() + 15) / 16);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+	context.popBoundImage(0);
+	context.popShader();
+	GET_GL_ERROR();
+	return true;
+}
+#endif
+
+//! [static] Factory
+Util::Reference<Texture> createNoiseTexture(RenderingContext & context, uint32_t width, uint32_t height, bool alpha, float scaling) {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_image_load_store)
+	Util::Reference<Texture> texture = create(TextureType::TEXTURE_2D, width, height, 1, GL_RGBA, GL_FLOAT, GL_RGBA32F, true);
+	if(generateProceduralTexture(context, *texture.get(), "rgba32f", true, scaling, alpha, 0))
+		return texture;
+#endif
+	return createNoiseTexture(width, height, alpha, scaling);
+}
+
+//! [static] Factory
+Util::Reference<Texture> createChessTexture(RenderingContext & context, uint32_t width, uint32_t height, int fieldSize_powOfTwo) {
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_image_load_store)
+	Util::Reference<Texture> texture = create(TextureType::TEXTURE_2D, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA8, true);
+	if(generateProceduralTexture(context, *texture.get(), "rgba8", false, 1.0f, true, fieldSize_powOfTwo))
+		return texture;
+#endif
+	return createChessTexture(width, height, fieldSize_powOfTwo);
+}
+
+//! (internal) Create the texture format for the given bitmap; @return false if it is not supported.
+static bool createFormatForBitmap(const Util::Bitmap & bitmap, TextureType type, uint32_t numLayers, bool clampToEdge, Texture::Format & format){
 	const uint32_t bHeight = bitmap.getHeight();
 	const uint32_t width = bitmap.getWidth();
 
-	Texture::Format format;
-
 	if( numLayers==0 || numLayers>bHeight || (bHeight%numLayers) != 0){
 		WARN("createTextureFromBitmap: Bitmap height is not dividable into given number of layers.");
-		return nullptr;
+		return false;
 	}
 	
 	format.glTextureType = textureTypeToGLTextureType( type );
@@ -491,7 +705,7 @@ Util::Reference<Texture> createTextureFromBitmap(const Util::Bitmap & bitmap, Te
 	format.pixelFormat = pixelFormatToGLPixelFormat(bitmap.getPixelFormat());
 	if(!format.pixelFormat.isValid()){
 		WARN("createTextureFromBitmap: Bitmap has unimplemented pixel format.");
-		return nullptr;
+		return false;
 	}
 	
 	if(clampToEdge) {
@@ -499,13 +713,21 @@ Util::Reference<Texture> createTextureFromBitmap(const Util::Bitmap & bitmap, Te
 		format.glWrapT = GL_CLAMP_TO_EDGE;
 		format.glWrapR = GL_CLAMP_TO_EDGE;
 	}
+	return true;
+}
+
+Util::Reference<Texture> createTextureFromBitmap(const Util::Bitmap & bitmap, TextureType type, uint32_t numLayers, bool clampToEdge){
+	Texture::Format format;
+	if(!createFormatForBitmap(bitmap, type, numLayers, clampToEdge, format))
+		return nullptr;
 
 	Util::Reference<Texture> texture = new Texture(format);
 	texture->allocateLocalData();
 	const uint8_t * pixels = bitmap.data();
+	const uint32_t bHeight = bitmap.getHeight();
 
 	// Flip the rows.
-	const uint32_t rowSize = width * bitmap.getPixelFormat().getBytesPerPixel();
+	const uint32_t rowSize = bitmap.getWidth() * bitmap.getPixelFormat().getBytesPerPixel();
 	for (uint_fast16_t row = 0; row < bHeight; ++row) {
 		const uint32_t offset = row * rowSize;
 		const uint16_t reverseRow = bHeight - 1 - row;
@@ -517,6 +739,28 @@ Util::Reference<Texture> createTextureFromBitmap(const Util::Bitmap & bitmap, Te
 	return texture;
 }
 
+Util::Reference<Texture> createTextureFromBitmapInPlace(const Util::Reference<Util::Bitmap> & bitmap, TextureType type, uint32_t numLayers, bool clampToEdge){
+	Texture::Format format;
+	if(bitmap.isNull() || !createFormatForBitmap(*bitmap.get(), type, numLayers, clampToEdge, format))
+		return nullptr;
+	// the local data of the texture would have a different layout (e.g. a format that is converted)
+	if(glPixelFormatToPixelFormat(format.pixelFormat) != bitmap->getPixelFormat())
+		return createTextureFromBitmap(*bitmap.get(), type, numLayers, clampToEdge);
+
+	// Flip the rows.
+	uint8_t * pixels = bitmap->data();
+	const uint32_t bHeight = bitmap->getHeight();
+	const uint32_t rowSize = bitmap->getWidth() * bitmap->getPixelFormat().getBytesPerPixel();
+	for(uint32_t row = 0; row < bHeight / 2; ++row)
+		std::swap_ranges(pixels + row * rowSize, pixels + (row + 1) * rowSize, pixels + (bHeight - 1 - row) * rowSize);
+
+	Util::Reference<Texture> texture = new Texture(format);
+	if(!texture->_setLocalBitmap(bitmap))
+		return nullptr;
+	texture->dataChanged();
+	return texture;
+}
+
 /**
  * [static]  Factory: Creates a Texture from a .raw file. Returns 0 on failure.
  * @Note: Used for importing hight-maps e.g. created with terragen.
@@ -527,6 +771,10 @@ Util::Reference<Texture> createTextureFromRAW(const Util::FileName & filename, u
 		WARN(std::string("RAW-Image has unimplemented color format for file ") + filename);
 		return nullptr;
 	}
+	if(filename.getFSName() == "file") { // read directly from the mapped file
+		RawHeightFieldReader reader(filename.getPath());
+		return reader.isValid() ? reader.createTexture(0, 0, reader.getWidth(), reader.getHeight(), flip_h) : nullptr;
+	}
 	const std::vector<uint8_t> buffer = Util::FileUtils::loadFile(filename);
 	if(buffer.empty()) {
 		WARN(std::string("Could not open file ") + filename.toString());
@@ -611,13 +859,289 @@ bool compareTextures(Texture *t1, Texture *t2) {
 	const Texture::Format& f1 = t1->getFormat();
 	const Texture::Format& f2 = t2->getFormat();
 
-	if(f1.getDataSize() != f2.getDataSize()) {
+	if(f1.getDataSize() != f2.getDataSize() || f1.pixelFormat.compressed != f2.pixelFormat.compressed) {
+		return false;
+	}
+	// equal bytes of block compressed data only describe the same texture for the same block format and layout
+	if(f1.pixelFormat.compressed && (f1.pixelFormat.glInternalFormat != f2.pixelFormat.glInternalFormat
+			|| f1.sizeX != f2.sizeX || f1.sizeY != f2.sizeY || f1.numLayers != f2.numLayers || f1.numMipLevels != f2.numMipLevels)) {
 		return false;
 	}
 
 	return std::equal(t1->getLocalData(), t1->getLocalData() + f1.getDataSize(), t2->getLocalData());
 }
 
+//! (internal) Number of color components of the texture's local data.
+static uint32_t getNumComparedComponents(const Texture & texture) {
+	switch(texture.getFormat().pixelFormat.glLocalDataFormat) {
+		case GL_RED:
+#if defined(LIB_GL)
+		case GL_RED_INTEGER:
+		case GL_DEPTH_COMPONENT:
+#endif
+			return 1;
+#if defined(LIB_GL)
+		case GL_RG:
+			return 2;
+		case GL_BGR:
+#endif
+		case GL_RGB:
+			return 3;
+		default:
+			return 4;
+	}
+}
+
+//! (internal) Fill in the derived metrics from the accumulated sums.
+static void finishTextureDifference(TextureDifference & difference, double sumAbs, double sumSquared, double numValues) {
+	difference.meanDifference = static_cast<float>(sumAbs / numValues);
+	difference.meanSquaredError = static_cast<float>(sumSquared / numValues);
+	difference.psnr = difference.meanSquaredError > 0.0f ? static_cast<float>(10.0 * std::log10(1.0 / difference.meanSquaredError))
+			: std::numeric_limits<float>::infinity();
+	difference.valid = true;
+}
+
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+static const char * const differenceProgram = R"***(
+layout(local_size_x = 16, local_size_y = 16) in;
+uniform sampler2D texture1;
+uniform sampler2D texture2;
+uniform float threshold;
+uniform int numComponents;
+#ifdef DIFF_IMAGE_FORMAT
+layout(DIFF_IMAGE_FORMAT, binding = 0) uniform writeonly image2D diffImage;
+#endif
+struct Partial { float sumAbs; float sumSquared; float maxDifference; uint mismatches; };
+layout(std430, binding = 0) buffer Partials { Partial partials[]; };
+shared float sharedAbs[256];
+shared float sharedSquared[256];
+shared float sharedMax[256];
+shared uint sharedMismatches[256];
+void main() {
+	const ivec2 pos = ivec2(gl_GlobalInvocationID.xy);
+	const uint i = gl_LocalInvocationIndex;
+	float sumAbs = 0.0, sumSquared = 0.0, maxDifference = 0.0;
+	uint mismatches = 0u;
+	if(all(lessThan(pos, textureSize(texture1, 0)))) {
+		vec4 d = abs(texelFetch(texture1, pos, 0) - texelFetch(texture2, pos, 0));
+		d *= vec4(lessThan(ivec4(0, 1, 2, 3), ivec4(numComponents)));
+		sumAbs = dot(d, vec4(1.0));
+		sumSquared = dot(d, d);
+		maxDifference = max(max(d.r, d.g), max(d.b, d.a));
+		mismatches = maxDifference > threshold ? 1u : 0u;
+#ifdef DIFF_IMAGE_FORMAT
+		imageStore(diffImage, pos, vec4(d.rgb, 1.0));
+#endif
+	}
+	sharedAbs[i] = sumAbs;
+	sharedSquared[i] = sumSquared;
+	sharedMax[i] = maxDifference;
+	sharedMismatches[i] = mismatches;
+	barrier();
+	for(uint stride = 128u; stride > 0u; stride >>= 1) {
+		if(i < stride) {
+			sharedAbs[i] += sharedAbs[i + stride];
+			sharedSquared[i] += sharedSquared[i + stride];
+			sharedMax[i] = max(sharedMax[i], sharedMax[i + stride]);
+			sharedMismatches[i] += sharedMismatches[i + stride];
+		}
+		barrier();
+	}
+	if(i == 0u)
+		partials[gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x] = Partial(sharedAbs[0], sharedSquared[0], sharedMax[0], sharedMismatches[0]);
+}
+)***";
+
+static const char * const reductionProgram = R"***(#version 430
+layout(local_size_x = 256) in;
+uniform int numPartials;
+struct Partial { float sumAbs; float sumSquared; float maxDifference; uint mismatches; };
+layout(std430, binding = 0) readonly buffer Partials { Partial partials[]; };
+layout(std430, binding = 1) writeonly buffer Result { Partial result; };
+shared double sharedAbs[256];
+shared double sharedSquared[256];
+shared float sharedMax[256];
+shared uint sharedMismatches[256];
+void main() {
+	const uint i = gl_LocalInvocationIndex;
+	double sumAbs = 0.0, sumSquared = 0.0;
+	float maxDifference = 0.0;
+	uint mismatches = 0u;
+	for(uint p = i; p < uint(numPartials); p += 256u) {
+		sumAbs += double(partials[p].sumAbs);
+		sumSquared += double(partials[p].sumSquared);
+		maxDifference = max(maxDifference, partials[p].maxDifference);
+		mismatches += partials[p].mismatches;
+	}
+	sharedAbs[i] = sumAbs;
+	sharedSquared[i] = sumSquared;
+	sharedMax[i] = maxDifference;
+	sharedMismatches[i] = mismatches;
+	barrier();
+	for(uint stride = 128u; stride > 0u; stride >>= 1) {
+		if(i < stride) {
+			sharedAbs[i] += sharedAbs[i + stride];
+			sharedSquared[i] += sharedSquared[i + stride];
+			sharedMax[i] = max(sharedMax[i], sharedMax[i + stride]);
+			sharedMismatches[i] += sharedMismatches[i + stride];
+		}
+		barrier();
+	}
+	if(i == 0u)
+		result = Partial(float(sharedAbs[0]), float(sharedSquared[0]), sharedMax[0], sharedMismatches[0]);
+}
+)***";
+
+//! (internal) Image format qualifier for the diff image, or nullptr if its format cannot be written.
+static const char * getDiffImageFormatQualifier(const Texture & texture) {
+	const PixelFormatGL & pixelFormat = texture.getFormat().pixelFormat;
+	if(pixelFormat.compressed)
+		return nullptr;
+	switch(pixelFormat.glInternalFormat) {
+		case GL_RGBA:
+			return pixelFormat.glLocalDataType == GL_UNSIGNED_BYTE ? "rgba8" : nullptr;
+		case GL_RGBA8:		return "rgba8";
+		case GL_RGBA16F:	return "rgba16f";
+		case GL_RGBA32F:	return "rgba32f";
+		default:			return nullptr;
+	}
+}
+
+//! (internal)
+static bool calculateTextureDifferenceGPU(RenderingContext & context, Texture & t1, Texture & t2, float threshold, Texture * diffImage, TextureDifference & difference) {
+	const char * diffImageFormat = diffImage != nullptr ? getDiffImageFormatQualifier(*diffImage) : nullptr;
+	if(diffImage != nullptr) {
+		if(diffImageFormat == nullptr || !RenderingContext::isImageBindingSupported()) {
+			WARN("calculateTextureDifference: The diff image's format is not supported.");
+			diffImage = nullptr;
+		} else if(diffImage->getTextureType() != TextureType::TEXTURE_2D || diffImage->getWidth() != t1.getWidth() || diffImage->getHeight() != t1.getHeight()) {
+			WARN("calculateTextureDifference: The diff image's type or size does not match.");
+			diffImage = nullptr;
+		}
+	}
+
+	static std::map<std::string, Util::Reference<Shader>> differenceShaders;
+	const std::string key = diffImage != nullptr ? diffImageFormat : "";
+	Util::Reference<Shader> & differenceShader = differenceShaders[key];
+	if(differenceShader.isNull()) {
+		std::string source = "#version 430\n";
+		if(!key.empty())
+			source += "#define DIFF_IMAGE_FORMAT " + key + "\n";
+		differenceShader = Shader::createShader(Shader::USE_UNIFORMS);
+		differenceShader->attachShaderObject(ShaderObjectInfo::createCompute(source + differenceProgram));
+	}
+	static Util::Reference<Shader> reductionShader;
+	if(reductionShader.isNull()) {
+		reductionShader = Shader::createShader(Shader::USE_UNIFORMS);
+		reductionShader->attachShaderObject(ShaderObjectInfo::createCompute(reductionProgram));
+	}
+
+	const uint32_t groupsX = (t1.getWidth() + 15) / 16;
+	const uint32_t groupsY = (t1.getHeight() + 15) / 16;
+	BufferObject partialBuffer;
+	BufferObject resultBuffer;
+	partialBuffer.allocateData<uint32_t>(BufferObject::TARGET_SHADER_STORAGE_BUFFER, groupsX * groupsY * 4, BufferObject::USAGE_STREAM_COPY);
+	resultBuffer.allocateData<uint32_t>(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 4, BufferObject::USAGE_STREAM_READ);
+
+	context.pushAndSetShader(differenceShader.get());
+	context.pushAndSetTexture(0, &t1, TexUnitUsageParameter::GENERAL_PURPOSE);
+	context.pushAndSetTexture(1, &t2, TexUnitUsageParameter::GENERAL_PURPOSE);
+	if(diffImage != nullptr) {
+		ImageBindParameters target(diffImage);
+		target.setReadOperations(false);
+		target.setWriteOperations(true);
+		context.pushAndSetBoundImage(0, target);
+	}
+	differenceShader->setUniform(context, Uniform("texture1", 0), false);
+	differenceShader->setUniform(context, Uniform("texture2", 1), false);
+	differenceShader->setUniform(context, Uniform("threshold", threshold), false);
+	differenceShader->setUniform(context, Uniform("numComponents", static_cast<int32_t>(getNumComparedComponents(t1))), false);
+	partialBuffer.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 0);
+	context.dispatchCompute(groupsX, groupsY);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	if(diffImage != nullptr)
+		context.popBoundImage(0);
+	context.popTexture(1);
+	context.popTexture(0);
+	context.popShader();
+
+	context.pushAndSetShader(reductionShader.get());
+	reductionShader->setUniform(context, Uniform("numPartials", static_cast<int32_t>(groupsX * groupsY)), false);
+	resultBuffer.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 1);
+	context.dispatchCompute(1);
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT | (diffImage != nullptr ? GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT : 0));
+	resultBuffer.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 1);
+	partialBuffer.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 0);
+	context.popShader();
+	GET_GL_ERROR();
+
+	struct Partial {
+		float sumAbs;
+		float sumSquared;
+		float maxDifference;
+		uint32_t mismatches;
+	};
+	const std::vector<Partial> result = resultBuffer.downloadData<Partial>(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 1);
+	if(result.empty())
+		return false;
+	difference.maxDifference = result.front().maxDifference;
+	difference.mismatchCount = result.front().mismatches;
+	finishTextureDifference(difference, result.front().sumAbs, result.front().sumSquared,
+							static_cast<double>(t1.getWidth()) * t1.getHeight() * getNumComparedComponents(t1));
+	return true;
+}
+#endif
+
+//! (static)
+TextureDifference calculateTextureDifference(RenderingContext & context, Texture & t1, Texture & t2, float threshold, Texture * diffImage) {
+	TextureDifference difference;
+	if(t1.getTextureType() != TextureType::TEXTURE_2D || t2.getTextureType() != TextureType::TEXTURE_2D
+			|| t1.getFormat().pixelFormat.compressed || t2.getFormat().pixelFormat.compressed) {
+		WARN("calculateTextureDifference: Only uncompressed TEXTURE_2D textures are supported.");
+		return difference;
+	}
+	if(t1.getWidth() != t2.getWidth() || t1.getHeight() != t2.getHeight()) {
+		WARN("calculateTextureDifference: Texture sizes do not match.");
+		return difference;
+	}
+	if(t1.getWidth() == 0 || t1.getHeight() == 0)
+		return difference;
+
+#if defined(LIB_GL) && defined(GL_ARB_compute_shader) && defined(GL_ARB_shader_storage_buffer_object)
+	if(ComputePass::isSupported() && calculateTextureDifferenceGPU(context, t1, t2, threshold, diffImage, difference))
+		return difference;
+#endif
+
+	if(diffImage != nullptr)
+		WARN("calculateTextureDifference: The diff image is only written by the GPU implementation.");
+	const auto accessor1 = createColorPixelAccessor(context, t1);
+	const auto accessor2 = createColorPixelAccessor(context, t2);
+	if(accessor1.isNull() || accessor2.isNull())
+		return difference;
+	const uint32_t numComponents = getNumComparedComponents(t1);
+	double sumAbs = 0.0;
+	double sumSquared = 0.0;
+	for(uint32_t y = 0; y < t1.getHeight(); ++y) {
+		for(uint32_t x = 0; x < t1.getWidth(); ++x) {
+			const Util::Color4f c1 = accessor1->readColor4f(x, y);
+			const Util::Color4f c2 = accessor2->readColor4f(x, y);
+			const float d[4] = {std::abs(c1.getR() - c2.getR()), std::abs(c1.getG() - c2.getG()),
+								std::abs(c1.getB() - c2.getB()), std::abs(c1.getA() - c2.getA())};
+			float maxDifference = 0.0f;
+			for(uint32_t c = 0; c < numComponents; ++c) {
+				sumAbs += d[c];
+				sumSquared += static_cast<double>(d[c]) * d[c];
+				maxDifference = std::max(maxDifference, d[c]);
+			}
+			difference.maxDifference = std::max(difference.maxDifference, maxDifference);
+			if(maxDifference > threshold)
+				++difference.mismatchCount;
+		}
+	}
+	finishTextureDifference(difference, sumAbs, sumSquared, static_cast<double>(t1.getWidth()) * t1.getHeight() * numComponents);
+	return difference;
+}
+
 //! [static]
 void updateTextureFromScreen(RenderingContext & context,Texture & t,const Geometry::Rect_i & textureRect, int screenPosX/*=0*/, int screenPosY/*=0*/){
 	const Texture::Format & format = t.getFormat();
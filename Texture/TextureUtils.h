@@ -47,6 +47,12 @@ Util::Reference<Texture> createStdCubeTexture(uint32_t width, bool alpha);
 Util::Reference<Texture> createHDRCubeTexture(uint32_t width, bool alpha);
 Util::Reference<Texture> createStdTexture(uint32_t width, uint32_t height, bool alpha);
 Util::Reference<Texture> createNoiseTexture(uint32_t width, uint32_t height, bool alpha, float scaling = 1.0f);
+
+/*! Create a noise texture directly in GPU memory using a compute shader; no local data is allocated.
+	The texture always has four float components (GL_RGBA32F) and, if @p alpha is false, an alpha value of 1.
+	\note The GPU uses its own gradient noise, so the values differ from those of createNoiseTexture(width, height, ...).
+	If compute shaders are not supported, the texture is created on the CPU instead.	*/
+Util::Reference<Texture> createNoiseTexture(RenderingContext & context, uint32_t width, uint32_t height, bool alpha, float scaling = 1.0f);
 Util::Reference<Texture> createHDRTexture(uint32_t width, uint32_t height, bool alpha);
 Util::Reference<Texture> createRedTexture(uint32_t width, uint32_t height, bool useByte = false);
 Util::Reference<Texture> createDepthStencilTexture(uint32_t width, uint32_t height);
@@ -70,15 +76,33 @@ Util::Reference<Texture> createColorTexture(TextureType type,uint32_t sizeX,uint
 */
 Util::Reference<Texture> createDataTexture(TextureType type,uint32_t sizeX,uint32_t sizeY, uint32_t numLayers, Util::TypeConstant dataType, uint8_t numComponents);
 
+/*! Create a texture with local data for the given block compressed @p glInternalFormat (e.g. GL_COMPRESSED_RGBA_BPTC_UNORM).
+	The local data contains @p numMipLevels levels (level 0 first); each level contains all layers (faces of a cube map).
+	@see Texture::Format::getLevelDataOffset
+	@return nullptr (and a warning) if the format's block size is unknown. */
+Util::Reference<Texture> createCompressedTexture(TextureType type,uint32_t sizeX,uint32_t sizeY, uint32_t numLayers, uint32_t glInternalFormat, uint32_t numMipLevels=1);
+
+/*! Query the block dimensions and the size of a block in bytes of a compressed @p glInternalFormat (S3TC, RGTC, BPTC, ETC2/EAC, ASTC).
+	@return false if the format is unknown. */
+bool getCompressedBlockSize(uint32_t glInternalFormat, uint32_t & blockWidth, uint32_t & blockHeight, uint32_t & blockSize);
+
 // creates an vec4 data array as textures for handling big arrays inside shaders. See SkeletalAnimationUtils for generic accessor.
 Util::Reference<Texture> createTextureDataArray_Vec4(const uint32_t size);
 Util::Reference<Texture> createChessTexture(uint32_t width, uint32_t height, int fieldSize_powOfTwo=8);
 
+/*! Create a chess texture directly in GPU memory using a compute shader; no local data is allocated.
+	If compute shaders are not supported, the texture is created on the CPU instead.	*/
+Util::Reference<Texture> createChessTexture(RenderingContext & context, uint32_t width, uint32_t height, int fieldSize_powOfTwo=8);
+
 /*! Create a texture of the given @p textureType from the given @p bitmap.
 	- For textureType TEXTURE_1D and TEXTURE_2D, numLayers must be 1.
 	- For textureType TEXTURE_CUBE_MAP, numLayers must be 6.
 	- For textureType TEXTURE_CUBE_MAP_ARRAY, numLayers must be a multiple of 6.	*/
 Util::Reference<Texture> createTextureFromBitmap(const Util::Bitmap & bitmap, TextureType type = TextureType::TEXTURE_2D, uint32_t numLayers=1, bool clampToEdge = false);
+/*! Like createTextureFromBitmap(), but the rows of @p bitmap are flipped in place and the bitmap becomes the local data
+	of the texture without being copied.
+	\note The bitmap must not be used elsewhere afterwards.	*/
+Util::Reference<Texture> createTextureFromBitmapInPlace(const Util::Reference<Util::Bitmap> & bitmap, TextureType type = TextureType::TEXTURE_2D, uint32_t numLayers=1, bool clampToEdge = false);
 Util::Reference<Texture> createTextureFromRAW(const Util::FileName & filename,unsigned int type=RAW_16BIT_BW, bool flip_h = true);
 Util::Reference<Texture> createTextureFromScreen(int xpos, int ypos, const Texture::Format & format);
 Util::Reference<Texture> createTextureFromScreen(int xpos=0, int ypos=0, int width=-1, int height=-1,bool useAlpha = true);
@@ -91,8 +115,35 @@ void drawTextureToScreen(RenderingContext & rc,
 						 const std::vector<Texture *> & textures,
 						 const std::vector<Geometry::Rect_f> & textureRects);
 
+/*! Returns true iff both textures have local data of the same size and content.
+	Compressed textures additionally need the same internal format, dimensions and number of mipmap levels. */
 bool compareTextures(Texture *t1, Texture *t2);
 
+//! Difference metrics of two textures (see calculateTextureDifference()).
+struct TextureDifference {
+	float maxDifference = 0.0f;		//!< Largest absolute difference of a single component
+	float meanDifference = 0.0f;	//!< Mean absolute difference over all compared components
+	float meanSquaredError = 0.0f;
+	float psnr = 0.0f;				//!< Peak signal-to-noise ratio in dB for a peak value of 1 (infinity for identical textures)
+	uint32_t mismatchCount = 0;		//!< Number of pixels with at least one component differing by more than the threshold
+	bool valid = false;				//!< false if the textures could not be compared
+};
+
+/*! Compare two TEXTURE_2D textures of the same size and calculate the differences of their (normalized or float)
+	color components. Only the components present in the local data format of @p t1 are compared.
+	If compute shaders are supported, the comparison is done on the GPU: two compute passes reduce the per-pixel
+	differences and only the final 16 bytes are read back. Otherwise, both textures are downloaded and compared on the CPU.
+	@param threshold A pixel is counted as mismatch if one of its components differs by more than this value.
+	@param diffImage If not nullptr, the absolute per-pixel differences are written into this texture (rgb; alpha is
+		set to 1). It must have the same size and the internal format GL_RGBA8, GL_RGBA16F or GL_RGBA32F.
+		It is only written by the GPU implementation.
+	\code
+		const auto difference = TextureUtils::calculateTextureDifference(context, *reference, *screenshot, 2.0f / 255.0f);
+		if(!difference.valid || difference.mismatchCount > 0)
+			// ...
+	\endcode	*/
+TextureDifference calculateTextureDifference(RenderingContext & context, Texture & t1, Texture & t2, float threshold = 0.0f, Texture * diffImage = nullptr);
+
 //! the texture is downloaded to memory (if necessary), the proper Util-color format is chosen and the texture is flipped vertically.
 Util::Reference<Util::Bitmap> createBitmapFromTexture(RenderingContext & context,Texture & texture);
 
@@ -0,0 +1,342 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "VirtualTexture.h"
+#include "../RenderingContext/RenderingContext.h"
+#include "../RenderingContext/RenderingParameters.h"
+#include "../Shader/Shader.h"
+#include "../Shader/Uniform.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+#include "../MemoryRegistry.h"
+#include <Geometry/Vec2.h>
+#include <Util/IO/FileName.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+namespace Rendering {
+
+static const char * const shaderInterface = R"GLSL(
+#extension GL_ARB_sparse_texture2 : enable
+uniform sampler2D sg_virtualTexture;
+uniform ivec2 sg_vtPageCount;	// number of pages of level 0
+uniform int sg_vtSparseLevels;	// levels >= sg_vtSparseLevels are always resident
+uniform int sg_vtNumLevels;
+layout(std430, binding = 8) buffer sg_VirtualTextureFeedback {
+	uint sg_vtRequestedPages[];
+};
+
+void sg_requestVirtualTexturePage(in vec2 uv, in int level) {
+	int offset = 0;
+	ivec2 count = sg_vtPageCount;
+	for(int l = 0; l < level; ++l) {
+		offset += count.x * count.y;
+		count = (count + 1) / 2;
+	}
+	ivec2 page = clamp(ivec2(fract(uv) * vec2(count)), ivec2(0), count - 1);
+	sg_vtRequestedPages[offset + page.y * count.x + page.x] = 1u;
+}
+
+vec4 sg_sampleVirtualTexture(in vec2 uv) {
+	float lod = textureQueryLod(sg_virtualTexture, uv).y;
+	int level = clamp(int(lod), 0, sg_vtNumLevels - 1);
+	if(level < sg_vtSparseLevels)
+		sg_requestVirtualTexturePage(uv, level);
+#ifdef GL_ARB_sparse_texture2
+	// use the finest resident level
+	for(int l = level; l < sg_vtSparseLevels; ++l) {
+		vec4 color;
+		if(sparseTexelsResidentARB(sparseTextureLodARB(sg_virtualTexture, uv, float(l), color)))
+			return color;
+	}
+	return textureLod(sg_virtualTexture, uv, float(clamp(max(level, sg_vtSparseLevels), 0, sg_vtNumLevels - 1)));
+#else
+	return textureLod(sg_virtualTexture, uv, lod);
+#endif
+}
+)GLSL";
+
+//! (static)
+bool VirtualTexture::isSupported() {
+#if defined(LIB_GL) && defined(GL_ARB_sparse_texture) && defined(GL_ARB_shader_storage_buffer_object)
+	static const bool support = isExtensionSupported("GL_ARB_sparse_texture") && isExtensionSupported("GL_ARB_shader_storage_buffer_object");
+	return support;
+#else
+	return false;
+#endif
+}
+
+//! (static)
+const char * VirtualTexture::getShaderInterface() {
+	return shaderInterface;
+}
+
+//! (static)
+VirtualTexture::PageLoader VirtualTexture::createFileLoader(const Util::FileName & fileName, uint32_t width, uint32_t height, uint32_t pixelSize) {
+	auto input = std::make_shared<std::ifstream>(fileName.getPath().c_str(), std::ios_base::in | std::ios_base::binary);
+	if(!input->good())
+		WARN("VirtualTexture::createFileLoader: Could not open file '" + fileName.toString() + "'.");
+	std::vector<uint64_t> levelOffsets;
+	uint64_t offset = 0;
+	for(uint32_t level = 0; level < 32; ++level) {
+		levelOffsets.push_back(offset);
+		const uint32_t levelWidth = std::max(1u, width >> level);
+		const uint32_t levelHeight = std::max(1u, height >> level);
+		offset += static_cast<uint64_t>(levelWidth) * levelHeight * pixelSize;
+		if(levelWidth == 1 && levelHeight == 1)
+			break;
+	}
+	return [input, levelOffsets, width, pixelSize](uint32_t level, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t * data) {
+		if(level >= levelOffsets.size())
+			return false;
+		input->clear();
+		const uint64_t levelWidth = std::max(1u, width >> level);
+		const std::streamsize rowSize = static_cast<std::streamsize>(w) * pixelSize;
+		for(uint32_t row = 0; row < h; ++row) {
+			input->seekg(static_cast<std::streamoff>(levelOffsets[level] + ((y + row) * levelWidth + x) * pixelSize));
+			input->read(reinterpret_cast<char *>(data + row * rowSize), rowSize);
+			if(!input->good())
+				return false;
+		}
+		return true;
+	};
+}
+
+VirtualTexture::VirtualTexture(uint32_t _width, uint32_t _height, uint32_t _numLevels, const PixelFormatGL & _pixelFormat, PageLoader _loader, uint32_t _maxResidentPages) :
+		ReferenceCounter_t(), width(_width), height(_height), numLevels(std::max(1u, _numLevels)), pixelFormat(_pixelFormat),
+		loader(std::move(_loader)), maxResidentPages(_maxResidentPages), maxUploadsPerUpdate(16),
+		initialized(false), pageWidth(0), pageHeight(0), numSparseLevels(0), updateCounter(0), committedBytes(0) {
+}
+
+VirtualTexture::~VirtualTexture() {
+	MemoryRegistry::add(MemoryRegistry::TEXTURE, -committedBytes);
+}
+
+void VirtualTexture::requestTexel(uint32_t level, uint32_t x, uint32_t y) {
+	if(level >= numSparseLevels)
+		return;
+	const uint32_t px = x / pageWidth;
+	const uint32_t py = y / pageHeight;
+	const uint32_t pagesX = levelPagesX[level];
+	const uint32_t levelPages = levelPageOffsets[level + 1] - levelPageOffsets[level];
+	if(px < pagesX && py * pagesX + px < levelPages)
+		requestedPages.push_back(levelPageOffsets[level] + py * pagesX + px);
+}
+
+void VirtualTexture::bind(RenderingContext & context, Shader * shader, uint8_t textureUnit) {
+	if(texture.isNull())
+		return;
+	context.pushAndSetTexture(textureUnit, texture.get(), TexUnitUsageParameter::GENERAL_PURPOSE);
+	if(shader != nullptr) {
+		shader->setUniform(context, Uniform("sg_virtualTexture", static_cast<int32_t>(textureUnit)), false);
+		shader->setUniform(context, Uniform("sg_vtPageCount", Geometry::Vec2i(width / pageWidth, height / pageHeight)), false);
+		shader->setUniform(context, Uniform("sg_vtSparseLevels", static_cast<int32_t>(numSparseLevels)), false);
+		shader->setUniform(context, Uniform("sg_vtNumLevels", static_cast<int32_t>(numLevels)), false);
+	}
+	if(feedbackBuffer.isValid())
+		feedbackBuffer.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, FEEDBACK_BINDING);
+}
+
+void VirtualTexture::unbind(RenderingContext & context, uint8_t textureUnit) {
+	if(texture.isNull())
+		return;
+	context.popTexture(textureUnit);
+	if(feedbackBuffer.isValid())
+		feedbackBuffer.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, FEEDBACK_BINDING);
+}
+
+//! (internal) Expects the texture to be bound to GL_TEXTURE_2D.
+void VirtualTexture::loadRegion(uint32_t level, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+	std::vector<uint8_t> data(static_cast<size_t>(w) * h * texture->getFormat().getPixelSize());
+	if(!loader || !loader(level, x, y, w, h, data.data()))
+		WARN("VirtualTexture: Could not load texture data.");
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), static_cast<GLint>(x), static_cast<GLint>(y),
+					static_cast<GLsizei>(w), static_cast<GLsizei>(h),
+					static_cast<GLenum>(pixelFormat.glLocalDataFormat), static_cast<GLenum>(pixelFormat.glLocalDataType), data.data());
+}
+
+void VirtualTexture::getPageRegion(uint32_t page, uint32_t & level, uint32_t & x, uint32_t & y, uint32_t & w, uint32_t & h) const {
+	level = static_cast<uint32_t>(std::upper_bound(levelPageOffsets.begin(), levelPageOffsets.end(), page) - levelPageOffsets.begin()) - 1;
+	const uint32_t localIndex = page - levelPageOffsets[level];
+	x = (localIndex % levelPagesX[level]) * pageWidth;
+	y = (localIndex / levelPagesX[level]) * pageHeight;
+	w = std::min(pageWidth, std::max(1u, width >> level) - x);
+	h = std::min(pageHeight, std::max(1u, height >> level) - y);
+}
+
+//! (internal) Expects the texture to be bound to GL_TEXTURE_2D.
+void VirtualTexture::setPageCommitment(uint32_t page, bool commit) {
+	uint32_t level, x, y, w, h;
+	getPageRegion(page, level, x, y, w, h);
+#if defined(LIB_GL) && defined(GL_ARB_sparse_texture)
+	glTexPageCommitmentARB(GL_TEXTURE_2D, static_cast<GLint>(level), static_cast<GLint>(x), static_cast<GLint>(y), 0,
+							static_cast<GLsizei>(w), static_cast<GLsizei>(h), 1, commit ? GL_TRUE : GL_FALSE);
+#endif
+	const int64_t bytes = static_cast<int64_t>(w) * h * texture->getFormat().getPixelSize();
+	committedBytes += commit ? bytes : -bytes;
+	MemoryRegistry::add(MemoryRegistry::TEXTURE, commit ? bytes : -bytes);
+}
+
+//! (internal) Expects the texture to be bound to GL_TEXTURE_2D.
+bool VirtualTexture::init(RenderingContext & context) {
+#if defined(LIB_GL) && defined(GL_ARB_sparse_texture)
+	if(!isSupported()) {
+		WARN("VirtualTexture: Sparse textures are not supported.");
+		return false;
+	}
+	GLint pageSizeX = 0, pageSizeY = 0;
+	glGetInternalformativ(GL_TEXTURE_2D, static_cast<GLenum>(pixelFormat.glInternalFormat), GL_VIRTUAL_PAGE_SIZE_X_ARB, 1, &pageSizeX);
+	glGetInternalformativ(GL_TEXTURE_2D, static_cast<GLenum>(pixelFormat.glInternalFormat), GL_VIRTUAL_PAGE_SIZE_Y_ARB, 1, &pageSizeY);
+	if(pageSizeX <= 0 || pageSizeY <= 0) {
+		WARN("VirtualTexture: The pixel format does not support sparse textures.");
+		return false;
+	}
+	pageWidth = static_cast<uint32_t>(pageSizeX);
+	pageHeight = static_cast<uint32_t>(pageSizeY);
+	if(width == 0 || height == 0 || (width % pageWidth) != 0 || (height % pageHeight) != 0) {
+		WARN("VirtualTexture: The size is not a multiple of the page size.");
+		return false;
+	}
+
+	Texture::Format format;
+	format.glTextureType = GL_TEXTURE_2D;
+	format.sizeX = width;
+	format.sizeY = height;
+	format.numLayers = 1;
+	format.pixelFormat = pixelFormat;
+	format.glWrapS = GL_CLAMP_TO_EDGE;
+	format.glWrapT = GL_CLAMP_TO_EDGE;
+	format.glWrapR = GL_CLAMP_TO_EDGE;
+	Util::Reference<Texture> sparseTexture = new Texture(format);
+	try {
+		sparseTexture->_allocateGLStorage(context, numLevels, true);
+	} catch(const std::exception & e) {
+		WARN(std::string("VirtualTexture: ") + e.what());
+		return false;
+	}
+	glBindTexture(GL_TEXTURE_2D, sparseTexture->getGLId());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(numLevels - 1));
+	GLint sparseLevels = 0;
+	glGetTexParameteriv(GL_TEXTURE_2D, GL_NUM_SPARSE_LEVELS_ARB, &sparseLevels);
+	numSparseLevels = std::min(numLevels, static_cast<uint32_t>(std::max(0, sparseLevels)));
+	texture = sparseTexture;
+
+	// page table: the number of pages is halved (rounding up) from level to level, as in the shader
+	uint32_t pagesX = width / pageWidth, pagesY = height / pageHeight;
+	levelPageOffsets.assign(1, 0);
+	for(uint32_t level = 0; level < numSparseLevels; ++level) {
+		levelPagesX.push_back(pagesX);
+		levelPageOffsets.push_back(levelPageOffsets.back() + pagesX * pagesY);
+		pagesX = (pagesX + 1) / 2;
+		pagesY = (pagesY + 1) / 2;
+	}
+	const uint32_t pageCount = levelPageOffsets.back();
+	if(pageCount > 0) {
+		feedbackBuffer.allocateData<uint32_t>(BufferObject::TARGET_SHADER_STORAGE_BUFFER, pageCount, BufferObject::USAGE_DYNAMIC_READ);
+		feedbackBuffer.clear(BufferObject::TARGET_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT);
+	}
+
+	// the mip tail is always resident
+	for(uint32_t level = numSparseLevels; level < numLevels; ++level) {
+		const uint32_t levelWidth = std::max(1u, width >> level);
+		const uint32_t levelHeight = std::max(1u, height >> level);
+		glTexPageCommitmentARB(GL_TEXTURE_2D, static_cast<GLint>(level), 0, 0, 0,
+								static_cast<GLsizei>(levelWidth), static_cast<GLsizei>(levelHeight), 1, GL_TRUE);
+		const int64_t bytes = static_cast<int64_t>(levelWidth) * levelHeight * texture->getFormat().getPixelSize();
+		committedBytes += bytes;
+		MemoryRegistry::add(MemoryRegistry::TEXTURE, bytes);
+		loadRegion(level, 0, 0, levelWidth, levelHeight);
+	}
+	GET_GL_ERROR();
+	return true;
+#else
+	WARN("VirtualTexture: Sparse textures are not supported.");
+	return false;
+#endif
+}
+
+void VirtualTexture::update(RenderingContext & context) {
+	GLint activeTexture;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	context.pushAndSetTexture(0, nullptr); // store and disable texture unit 0, so that we can use it without side effects.
+	glActiveTexture(GL_TEXTURE0);
+
+	if(!initialized) {
+		initialized = true;
+		if(!init(context))
+			texture = nullptr;
+	} else if(texture.isNotNull()) {
+		glBindTexture(GL_TEXTURE_2D, texture->getGLId());
+	}
+	if(texture.isNotNull()) {
+		++updateCounter;
+		if(feedbackBuffer.isValid()) {
+			const auto flags = feedbackBuffer.downloadData<uint32_t>(BufferObject::TARGET_SHADER_STORAGE_BUFFER, levelPageOffsets.back());
+			for(uint32_t page = 0; page < flags.size(); ++page) {
+				if(flags[page] != 0)
+					requestedPages.push_back(page);
+			}
+			feedbackBuffer.clear(BufferObject::TARGET_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT);
+		}
+
+		std::vector<uint32_t> missingPages;
+		for(const uint32_t page : requestedPages) {
+			auto it = residentPages.find(page);
+			if(it != residentPages.end())
+				it->second = updateCounter;
+			else
+				missingPages.push_back(page);
+		}
+		requestedPages.clear();
+		// pages of coarser levels have larger indices and are loaded first
+		std::sort(missingPages.begin(), missingPages.end(), std::greater<uint32_t>());
+		missingPages.erase(std::unique(missingPages.begin(), missingPages.end()), missingPages.end());
+
+		// release the least recently used pages that have not been requested in this update
+		const auto releaseOldestPage = [&]() {
+			auto oldest = residentPages.end();
+			for(auto it = residentPages.begin(); it != residentPages.end(); ++it) {
+				if(it->second < updateCounter && (oldest == residentPages.end() || it->second < oldest->second))
+					oldest = it;
+			}
+			if(oldest == residentPages.end())
+				return false;
+			setPageCommitment(oldest->first, false);
+			residentPages.erase(oldest);
+			return true;
+		};
+		while(residentPages.size() > maxResidentPages && releaseOldestPage()) {
+		}
+
+		uint32_t uploads = 0;
+		for(const uint32_t page : missingPages) {
+			if(uploads >= maxUploadsPerUpdate)
+				break;
+			if(residentPages.size() >= maxResidentPages && !releaseOldestPage())
+				break;
+			setPageCommitment(page, true);
+			uint32_t level, x, y, w, h;
+			getPageRegion(page, level, x, y, w, h);
+			loadRegion(level, x, y, w, h);
+			residentPages[page] = updateCounter;
+			++uploads;
+		}
+		GET_GL_ERROR();
+	}
+	context.popTexture(0);
+	glActiveTexture(activeTexture);
+}
+
+}
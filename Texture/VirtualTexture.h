@@ -0,0 +1,134 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_VIRTUALTEXTURE_H_
+#define RENDERING_VIRTUALTEXTURE_H_
+
+#include "Texture.h"
+#include "PixelFormatGL.h"
+#include "../BufferObject.h"
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace Util {
+class FileName;
+}
+namespace Rendering {
+class RenderingContext;
+class Shader;
+
+/**
+ * Texture that is too large to be stored completely in graphics memory (e.g. an orthophoto mosaic of 64k x 64k
+ * texels). It is stored as sparse texture (GL_ARB_sparse_texture): only the pages that have been requested are
+ * committed to graphics memory and loaded by the PageLoader (e.g. from a file, see createFileLoader()).
+ *
+ * The pages are requested by a feedback pass: shaders sample the texture using the functions of
+ * getShaderInterface(), which mark every page they access in a shader storage buffer bound to FEEDBACK_BINDING.
+ * update() reads the marked pages, loads at most getMaxUploadsPerUpdate() missing pages (coarse levels first) and
+ * releases the least recently used pages if more than getMaxResidentPages() pages are committed.
+ * \code
+ * // fragment shader
+ * #version 430
+ * // ... getShaderInterface() ...
+ * void main() {
+ *	gl_FragColor = sg_sampleVirtualTexture(sg_TexCoord0);
+ * }
+ * \endcode
+ * \code
+ * virtualTexture->bind(context, shader, 0);
+ * context.displayMesh(terrain);
+ * virtualTexture->unbind(context, 0);
+ * virtualTexture->update(context); // once per frame
+ * \endcode
+ * The coarsest levels (the mip tail that cannot be committed page-wise) are always resident. Missing texels are
+ * replaced by the ones of a coarser resident level if GL_ARB_sparse_texture2 is supported by the shader compiler.
+ *
+ * @note The width and height must be multiples of the page size (see getPageWidth() and getPageHeight(), which
+ * depend on the pixel format and are known after the first update()); the pixel format must be sized (e.g. GL_RGBA8).
+ * @note The feedback buffer is read back synchronously in update().
+ */
+class VirtualTexture : public Util::ReferenceCounter<VirtualTexture> {
+	public:
+		static const uint32_t FEEDBACK_BINDING = 8;
+
+		/*! Function that writes the texels of the given region of a mipmap level into @p data (rows from bottom to top,
+			tightly packed). Returns false if the data could not be loaded.	*/
+		typedef std::function<bool (uint32_t level, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t * data)> PageLoader;
+
+		static bool isSupported();
+
+		//! GLSL declarations (sampler, uniforms, feedback buffer and sampling function) to be included into a shader.
+		static const char * getShaderInterface();
+
+		/*! Loader reading uncompressed texels from a file that stores all mipmap levels consecutively (starting with
+			level 0), each as rows of max(1, width >> level) pixels from bottom to top.	*/
+		static PageLoader createFileLoader(const Util::FileName & fileName, uint32_t width, uint32_t height, uint32_t pixelSize);
+
+		VirtualTexture(uint32_t width, uint32_t height, uint32_t numLevels, const PixelFormatGL & pixelFormat, PageLoader loader, uint32_t maxResidentPages = 1024);
+		~VirtualTexture();
+
+		uint32_t getWidth() const							{	return width;	}
+		uint32_t getHeight() const							{	return height;	}
+		uint32_t getNumLevels() const						{	return numLevels;	}
+		uint32_t getPageWidth() const						{	return pageWidth;	}
+		uint32_t getPageHeight() const						{	return pageHeight;	}
+		//! The sparse texture; nullptr before the first update() or if the texture could not be created.
+		Texture * getTexture() const						{	return texture.get();	}
+
+		uint32_t getResidentPageCount() const				{	return static_cast<uint32_t>(residentPages.size());	}
+		uint32_t getMaxResidentPages() const				{	return maxResidentPages;	}
+		void setMaxResidentPages(uint32_t count)			{	maxResidentPages = count;	}
+		uint32_t getMaxUploadsPerUpdate() const				{	return maxUploadsPerUpdate;	}
+		void setMaxUploadsPerUpdate(uint32_t count)			{	maxUploadsPerUpdate = count;	}
+
+		//! Request the page containing the texel (x, y) of the given level (e.g. to prefetch regions); loaded by the next update().
+		void requestTexel(uint32_t level, uint32_t x, uint32_t y);
+
+		//! Bind the texture to the given unit, set the shader's uniforms and bind the feedback buffer.
+		void bind(RenderingContext & context, Shader * shader, uint8_t textureUnit);
+		void unbind(RenderingContext & context, uint8_t textureUnit);
+
+		/*! Create the texture (at the first call), read the requested pages from the feedback buffer, load missing
+			pages and release the least recently used ones. Has to be called once per frame outside of bind()/unbind().	*/
+		void update(RenderingContext & context);
+
+	private:
+		const uint32_t width, height, numLevels;
+		const PixelFormatGL pixelFormat;
+		PageLoader loader;
+		uint32_t maxResidentPages;
+		uint32_t maxUploadsPerUpdate;
+
+		Util::Reference<Texture> texture;
+		bool initialized;
+		uint32_t pageWidth, pageHeight;
+		uint32_t numSparseLevels;				//!< Levels that are committed page-wise; the following ones are always resident
+		std::vector<uint32_t> levelPageOffsets;	//!< Index of the first page of each sparse level (and the total page count)
+		std::vector<uint32_t> levelPagesX;		//!< Number of pages in x direction per sparse level
+
+		BufferObject feedbackBuffer;
+		std::vector<uint32_t> requestedPages;
+		std::unordered_map<uint32_t, uint64_t> residentPages; //!< page index -> last update in which the page was requested
+		uint64_t updateCounter;
+		int64_t committedBytes;
+
+		bool init(RenderingContext & context);
+		void loadRegion(uint32_t level, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+		void setPageCommitment(uint32_t page, bool commit);
+		void getPageRegion(uint32_t page, uint32_t & level, uint32_t & x, uint32_t & y, uint32_t & w, uint32_t & h) const;
+};
+
+}
+
+#endif /* RENDERING_VIRTUALTEXTURE_H_ */
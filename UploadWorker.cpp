@@ -0,0 +1,186 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "UploadWorker.h"
+#include "Mesh/Mesh.h"
+#include "Mesh/MeshDataStrategy.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Texture/Texture.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Util/Macros.h>
+#include <exception>
+
+namespace Rendering {
+
+UploadWorker::UploadWorker(std::function<bool ()> _makeContextCurrent, callback_t _releaseContext) :
+		makeContextCurrent(std::move(_makeContextCurrent)), releaseContext(std::move(_releaseContext)),
+		terminate(false), contextAvailable(false), contextFailed(false) {
+	worker = std::thread(&UploadWorker::workerLoop, this);
+}
+
+UploadWorker::~UploadWorker() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		terminate = true;
+	}
+	workAvailable.notify_all();
+	worker.join();
+#if defined(LIB_GL) && defined(GL_ARB_sync)
+	for(const auto & job : finishedQueue) {
+		if(job->fence != nullptr)
+			glDeleteSync(reinterpret_cast<GLsync>(job->fence));
+	}
+#endif
+}
+
+//! (internal)
+void UploadWorker::workerLoop() {
+	const bool success = makeContextCurrent && makeContextCurrent();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		contextAvailable = success;
+		contextFailed = !success;
+	}
+	if(!success) {
+		WARN("UploadWorker: The shared context could not be made current; the jobs are executed on the render thread.");
+		return;
+	}
+	{
+		RenderingContext::initGLState(); // the profile dependent state is stored per thread
+		std::unique_ptr<RenderingContext> context(new RenderingContext);
+		while(true) {
+			std::unique_ptr<Job> job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				workAvailable.wait(lock, [this] { return terminate || !jobQueue.empty(); });
+				if(terminate)
+					break;
+				job = std::move(jobQueue.front());
+				jobQueue.pop_front();
+			}
+			try {
+				job->job(*context);
+			} catch(const std::exception & e) {
+				WARN(std::string("UploadWorker: Job failed: ") + e.what());
+			}
+#if defined(LIB_GL) && defined(GL_ARB_sync)
+			job->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			glFlush(); // the fence has to be flushed to be signaled in another context
+#else
+			RenderingContext::finish();
+#endif
+			GET_GL_ERROR();
+			std::lock_guard<std::mutex> lock(mutex);
+			finishedQueue.emplace_back(std::move(job));
+		}
+	}
+	if(releaseContext)
+		releaseContext();
+}
+
+void UploadWorker::enqueue(job_t job, callback_t onPublished) {
+	std::unique_ptr<Job> entry(new Job);
+	entry->job = std::move(job);
+	entry->onPublished = std::move(onPublished);
+	entry->fence = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobQueue.emplace_back(std::move(entry));
+	}
+	workAvailable.notify_one();
+}
+
+std::shared_future<Util::Reference<Mesh>> UploadWorker::uploadMesh(Mesh * mesh) {
+	auto promise = std::make_shared<std::promise<Util::Reference<Mesh>>>();
+	const Util::Reference<Mesh> meshRef(mesh);
+	// the job only uses the raw pointer; the reference is held (and released) by the callback on the render thread
+	enqueue([mesh](RenderingContext &) {
+				MeshDataStrategy * strategy = mesh->getDataStrategy() != nullptr ? mesh->getDataStrategy() : MeshDataStrategy::getDefaultStrategy();
+				strategy->prepare(mesh);
+			},
+			[promise, meshRef]() {	promise->set_value(meshRef);	});
+	return promise->get_future().share();
+}
+
+std::shared_future<Util::Reference<Texture>> UploadWorker::uploadTexture(Texture * texture) {
+	auto promise = std::make_shared<std::promise<Util::Reference<Texture>>>();
+	const Util::Reference<Texture> textureRef(texture);
+	enqueue([texture](RenderingContext & context) {
+				if(texture->getGLId() == 0)
+					texture->_uploadGLTexture(context);
+			},
+			[promise, textureRef]() {	promise->set_value(textureRef);	});
+	return promise->get_future().share();
+}
+
+uint32_t UploadWorker::publish(RenderingContext & context) {
+	uint32_t numPublished = 0;
+	std::deque<std::unique_ptr<Job>> localJobs;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(contextFailed)
+			localJobs.swap(jobQueue);
+	}
+	for(auto & job : localJobs) {
+		try {
+			job->job(context);
+		} catch(const std::exception & e) {
+			WARN(std::string("UploadWorker: Job failed: ") + e.what());
+		}
+		if(job->onPublished)
+			job->onPublished();
+		++numPublished;
+	}
+
+	while(true) {
+		void * fence;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if(finishedQueue.empty())
+				break;
+			fence = finishedQueue.front()->fence;
+		}
+#if defined(LIB_GL) && defined(GL_ARB_sync)
+		if(fence != nullptr) {
+			const GLenum result = glClientWaitSync(reinterpret_cast<GLsync>(fence), 0, 0);
+			if(result == GL_TIMEOUT_EXPIRED)
+				break;
+			if(result == GL_WAIT_FAILED)
+				WARN("UploadWorker: Waiting for fence failed.");
+			glDeleteSync(reinterpret_cast<GLsync>(fence));
+		}
+#else
+		(void)fence;
+#endif
+		std::unique_ptr<Job> job;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = std::move(finishedQueue.front());
+			finishedQueue.pop_front();
+		}
+		if(job->onPublished)
+			job->onPublished();
+		++numPublished;
+	}
+	return numPublished;
+}
+
+bool UploadWorker::hasContext() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return contextAvailable;
+}
+
+uint32_t UploadWorker::getPendingCount() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return static_cast<uint32_t>(jobQueue.size() + finishedQueue.size());
+}
+
+}
@@ -0,0 +1,109 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_UPLOADWORKER_H_
+#define RENDERING_UPLOADWORKER_H_
+
+#include <Util/References.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+class Texture;
+
+/**
+ * Worker thread that creates GL resources (buffers, textures, ...) in its own GL context, which shares its objects
+ * with the render thread's context.
+ *
+ * The library does not create GL contexts; the application passes a function that makes the shared context current
+ * on the calling (worker) thread (e.g. a second context created by wglCreateContextAttribs/glXCreateContextAttribs/
+ * eglCreateContext with the render context as share context) and a function that releases it again.
+ * A job is executed on the worker thread with the worker's own RenderingContext; afterwards, a fence is inserted
+ * and flushed. publish() (called once per frame on the render thread) checks the fences without waiting and calls
+ * the completion callbacks of the finished jobs; only then may the render thread use the objects.
+ * If the context cannot be made current, the jobs are executed by publish() on the render thread instead.
+ * \code
+ *	UploadWorker worker([&]{ return makeCurrent(uploadContext); }, [&]{ makeCurrent(nullptr); });
+ *	auto future = worker.uploadMesh(mesh.get());
+ *	// each frame:
+ *	worker.publish(renderingContext);
+ *	if(future.wait_for(std::chrono::seconds(0)) == std::future_status::ready) { ... }
+ * \endcode
+ * \note Objects that are not shared between contexts (vertex array objects, framebuffers, ...) must not be created
+ *	by a job. In particular, mesh data strategies that stream into per frame buffers are not suitable.
+ * \note Until they are published, the resources must not be used (or modified) by the render thread.
+ */
+class UploadWorker {
+	public:
+		typedef std::function<void (RenderingContext &)> job_t;
+		typedef std::function<void ()> callback_t;
+
+		/*! Start the worker thread.
+			@param makeContextCurrent Called on the worker thread; returns @c false if the context could not be activated.
+			@param releaseContext Called on the worker thread before it terminates.	*/
+		UploadWorker(std::function<bool ()> makeContextCurrent, callback_t releaseContext);
+		//! Waiting jobs are discarded; their callbacks are not called.
+		~UploadWorker();
+
+		UploadWorker(const UploadWorker &) = delete;
+		UploadWorker & operator=(const UploadWorker &) = delete;
+
+		/*! Queue a job (may be called from any thread). @p onPublished is called by publish() on the render thread
+			when the job's GL commands have been completed.	*/
+		void enqueue(job_t job, callback_t onPublished = callback_t());
+
+		/*! Prepare (upload) the mesh with its data strategy (or the default strategy) on the worker thread.
+			The future becomes ready in publish().	*/
+		std::shared_future<Util::Reference<Mesh>> uploadMesh(Mesh * mesh);
+		//! Upload the texture's local data on the worker thread. The future becomes ready in publish().
+		std::shared_future<Util::Reference<Texture>> uploadTexture(Texture * texture);
+
+		/*! Call the callbacks of the finished jobs whose fences are signaled. Call once per frame on the render thread.
+			@param context Used to execute the jobs if the worker thread has no context.
+			@return Number of published jobs.	*/
+		uint32_t publish(RenderingContext & context);
+
+		//! @c false if the worker's context could not be made current (the jobs are then executed by publish()).
+		bool hasContext() const;
+		//! Number of jobs that have not been published yet.
+		uint32_t getPendingCount() const;
+
+	private:
+		struct Job {
+			job_t job;
+			callback_t onPublished;
+			void * fence;
+		};
+		mutable std::mutex mutex;
+		std::condition_variable workAvailable;
+		//! The jobs are only moved by their pointers, so the captured values of the callbacks are not touched by the worker.
+		std::deque<std::unique_ptr<Job>> jobQueue;
+		std::deque<std::unique_ptr<Job>> finishedQueue;
+		std::function<bool ()> makeContextCurrent;
+		callback_t releaseContext;
+		bool terminate;
+		bool contextAvailable;
+		bool contextFailed;
+		std::thread worker;
+
+		void workerLoop();
+};
+
+}
+
+#endif /* RENDERING_UPLOADWORKER_H_ */
@@ -11,8 +11,12 @@
 #include <Geometry/Box.h>
 #include <Geometry/Vec3.h>
 #include <Rendering/RenderingContext/RenderingContext.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/VertexDescription.h>
+#include <Rendering/MeshUtils/PrimitiveShapes.h>
 #include <Rendering/Draw.h>
 #include <Rendering/Helper.h>
+#include <Util/References.h>
 #include <Util/Timer.h>
 #include <cstdint>
 #include <iostream>
@@ -52,3 +56,30 @@ void DrawTest::testBox() {
 	std::cout << "drawFastAbsBox: " << drawFastBoxTimer.getSeconds() << " s" << std::endl;
 	std::cout << "drawAbsBox: " << drawBoxTimer.getSeconds() << " s" << std::endl;
 }
+
+void DrawTest::testRedundantMeshDraw() {
+	using namespace Rendering;
+
+	RenderingContext context;
+	context.setImmediateMode(false);
+
+	VertexDescription vertexDescription;
+	vertexDescription.appendPosition3D();
+	vertexDescription.appendNormalFloat();
+	Util::Reference<Mesh> grid = MeshUtils::createGrid(vertexDescription, 10.0f, 10.0f, 512, 512);
+	context.displayMesh(grid.get()); // uploads the mesh and applies the initial state
+	RenderingContext::finish();
+
+	// drawing the same mesh again must neither touch the state nor the buffers
+	context.resetFrameCounters();
+	context.displayMesh(grid.get());
+	context.displayMesh(grid.get());
+	const RenderingContext::FrameCounters counters = context.getFrameCounters();
+	CPPUNIT_ASSERT_EQUAL(2u, counters.drawCalls);
+	CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(2 * grid->getPrimitiveCount()), counters.primitives);
+	CPPUNIT_ASSERT_EQUAL(0u, counters.appliedStateGroups);
+	CPPUNIT_ASSERT_EQUAL(0u, counters.shaderChanges);
+	CPPUNIT_ASSERT_EQUAL(0u, counters.uniformUploads);
+	CPPUNIT_ASSERT_EQUAL(0u, counters.buffersCreated);
+	CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(0), counters.bufferBytesUploaded);
+}
@@ -15,10 +15,12 @@
 class DrawTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST_SUITE(DrawTest);
 	CPPUNIT_TEST(testBox);
+	CPPUNIT_TEST(testRedundantMeshDraw);
 	CPPUNIT_TEST_SUITE_END();
 
 	public:
 		void testBox();
+		void testRedundantMeshDraw();
 };
 
 #endif /* RENDERING_DRAWTEST_H */
@@ -0,0 +1,497 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/*
+ * Micro- and macro-benchmarks of the library's hot paths. The results are written as JSON,
+ * so that they can be compared between revisions.
+ *
+ * Usage: RenderingBenchmark [--quick] [--filter <substring>] [--output <file.json>]
+ *
+ * All input data is generated deterministically; every benchmark is run a fixed number of
+ * repetitions after one warm-up repetition.
+ */
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Rect.h>
+#include <Geometry/Sphere.h>
+#include <Geometry/Vec3.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/MeshVertexData.h>
+#include <Rendering/Mesh/MeshIndexData.h>
+#include <Rendering/Mesh/VertexAttributeIds.h>
+#include <Rendering/Mesh/VertexDescription.h>
+#include <Rendering/MeshUtils/MeshUtils.h>
+#include <Rendering/MeshUtils/PrimitiveShapes.h>
+#include <Rendering/RenderingContext/RenderingContext.h>
+#include <Rendering/RenderingContext/RenderingParameters.h>
+#include <Rendering/Serialization/Serialization.h>
+#include <Rendering/Shader/Shader.h>
+#include <Rendering/Shader/Uniform.h>
+#include <Rendering/Texture/Texture.h>
+#include <Rendering/Texture/TextureUtils.h>
+#include <Rendering/FBO.h>
+#include <Rendering/Helper.h>
+#include <Util/Graphics/Color.h>
+#include <Util/References.h>
+#include <Util/UI/UI.h>
+#include <Util/UI/Window.h>
+#include <Util/Util.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Rendering;
+
+namespace {
+
+struct BenchmarkResult {
+	std::string name;
+	uint64_t iterations;
+	std::vector<double> nsPerIteration; //!< one entry per repetition
+	RenderingContext::FrameCounters counters; //!< counters of the last repetition
+	uint64_t itemsPerIteration; //!< e.g. triangles or bytes; 0 if not applicable
+	std::string itemName;
+	BenchmarkResult() : iterations(0), itemsPerIteration(0) {}
+};
+
+class BenchmarkSuite {
+	public:
+		uint32_t repetitions;
+		std::string filter;
+		std::vector<BenchmarkResult> results;
+
+		BenchmarkSuite() : repetitions(5) {}
+
+		bool isEnabled(const std::string & name) const {
+			return filter.empty() || name.find(filter) != std::string::npos;
+		}
+
+		//! Returns true if any benchmark starting with @p group may be enabled (used to skip expensive setups).
+		bool isGroupEnabled(const std::string & group) const {
+			return isEnabled(group) || filter.compare(0, group.size(), group) == 0;
+		}
+
+		/*! Measure @p body, which has to perform the given number of iterations.
+			@param itemsPerIteration Optional throughput unit (e.g. triangles per iteration). */
+		void run(const std::string & name, uint64_t iterations, const std::function<void (uint64_t)> & body,
+				uint64_t itemsPerIteration = 0, const std::string & itemName = "") {
+			if(!isEnabled(name))
+				return;
+			std::cerr << name << " ..." << std::flush;
+			BenchmarkResult result;
+			result.name = name;
+			result.iterations = iterations;
+			result.itemsPerIteration = itemsPerIteration;
+			result.itemName = itemName;
+			body(iterations); // warm up
+			for(uint32_t rep = 0; rep < repetitions; ++rep) {
+				RenderingContext::finish();
+				RenderingContext::_getFrameCounters() = RenderingContext::FrameCounters();
+				const auto start = std::chrono::high_resolution_clock::now();
+				body(iterations);
+				RenderingContext::finish();
+				const auto end = std::chrono::high_resolution_clock::now();
+				result.counters = RenderingContext::_getFrameCounters();
+				const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+				result.nsPerIteration.push_back(ns / static_cast<double>(iterations));
+			}
+			std::cerr << " " << median(result.nsPerIteration) << " ns" << std::endl;
+			results.emplace_back(std::move(result));
+		}
+
+		static double median(std::vector<double> values) {
+			if(values.empty())
+				return 0.0;
+			std::sort(values.begin(), values.end());
+			return values[values.size() / 2];
+		}
+
+		void writeJSON(std::ostream & out) const {
+			out << "{\n\t\"version\": 1,\n\t\"repetitions\": " << repetitions << ",\n";
+			out << "\t\"glVersion\": \"" << escape(getGraphicsLanguageVersion()) << "\",\n";
+			out << "\t\"benchmarks\": [";
+			for(size_t i = 0; i < results.size(); ++i) {
+				const BenchmarkResult & r = results[i];
+				double sum = 0.0;
+				for(const double v : r.nsPerIteration)
+					sum += v;
+				const double med = median(r.nsPerIteration);
+				out << (i == 0 ? "\n" : ",\n");
+				out << "\t\t{\"name\": \"" << escape(r.name) << "\", \"iterations\": " << r.iterations
+					<< ", \"nsMedian\": " << med
+					<< ", \"nsMin\": " << *std::min_element(r.nsPerIteration.begin(), r.nsPerIteration.end())
+					<< ", \"nsMean\": " << sum / static_cast<double>(r.nsPerIteration.size());
+				if(r.itemsPerIteration > 0 && med > 0.0)
+					out << ", \"" << r.itemName << "PerSecond\": " << static_cast<double>(r.itemsPerIteration) * 1.0e9 / med;
+				const RenderingContext::FrameCounters & c = r.counters;
+				out << ", \"counters\": {\"drawCalls\": " << c.drawCalls << ", \"primitives\": " << c.primitives
+					<< ", \"appliedStateGroups\": " << c.appliedStateGroups << ", \"shaderChanges\": " << c.shaderChanges
+					<< ", \"textureBinds\": " << c.textureBinds << ", \"uniformUploads\": " << c.uniformUploads
+					<< ", \"bufferBytesUploaded\": " << c.bufferBytesUploaded << ", \"buffersCreated\": " << c.buffersCreated
+					<< ", \"texturesCreated\": " << c.texturesCreated << "}}";
+			}
+			out << "\n\t]\n}\n";
+		}
+
+	private:
+		static std::string escape(const char * s) {
+			return s == nullptr ? std::string() : escape(std::string(s));
+		}
+		static std::string escape(const std::string & s) {
+			std::string out;
+			for(const char c : s) {
+				if(c == '"' || c == '\\')
+					out += '\\';
+				if(c >= 0x20)
+					out += c;
+			}
+			return out;
+		}
+};
+
+VertexDescription createVertexDescription() {
+	VertexDescription vd;
+	vd.appendPosition3D();
+	vd.appendNormalFloat();
+	vd.appendTexCoord();
+	return vd;
+}
+
+//! Create a grid with approximately the given number of triangles.
+Util::Reference<Mesh> createTriangleGrid(uint32_t numTriangles) {
+	uint32_t side = 1;
+	while(2 * side * side < numTriangles)
+		++side;
+	return MeshUtils::createGrid(createVertexDescription(), 1.0f, 1.0f, side, side);
+}
+
+// ---------------------------------------------------------------------------------------------
+// micro-benchmarks
+
+void benchmarkApplyChanges(BenchmarkSuite & suite, RenderingContext & context) {
+	const uint64_t iterations = 100000;
+	context.setImmediateMode(false);
+	// 0: no change, 1: one state group, 4: several groups, 8: most core groups are touched
+	for(const uint32_t churn : {0u, 1u, 4u, 8u}) {
+		suite.run("applyChanges/churn_" + std::to_string(churn), iterations, [&context, churn](uint64_t n) {
+			for(uint64_t i = 0; i < n; ++i) {
+				const bool odd = (i & 1) != 0;
+				if(churn >= 1)
+					context.setDepthBuffer(DepthBufferParameters(true, odd, odd ? Comparison::LEQUAL : Comparison::LESS));
+				if(churn >= 4) {
+					context.setBlending(odd ? BlendingParameters(BlendingParameters::SRC_ALPHA, BlendingParameters::ONE_MINUS_SRC_ALPHA) : BlendingParameters());
+					context.setCullFace(odd ? CullFaceParameters(CullFaceParameters::CULL_FRONT) : CullFaceParameters(CullFaceParameters::CULL_BACK));
+					context.setPolygonOffset(odd ? PolygonOffsetParameters(1.0f, 1.0f) : PolygonOffsetParameters());
+				}
+				if(churn >= 8) {
+					context.setLine(LineParameters(odd ? 2.0f : 1.0f));
+					context.setScissor(odd ? ScissorParameters(Geometry::Rect_i(0, 0, 16, 16)) : ScissorParameters());
+					context.setColorBuffer(ColorBufferParameters(true, true, true, odd));
+					context.setPointParameters(PointParameters(odd ? 2.0f : 1.0f));
+				}
+				context.applyChanges();
+			}
+		});
+	}
+	context.setImmediateMode(true);
+}
+
+void benchmarkSetUniform(BenchmarkSuite & suite, RenderingContext & context) {
+	const uint32_t numUniforms = 16;
+	std::ostringstream fs;
+	fs << "#version 120\n";
+	for(uint32_t u = 0; u < numUniforms; ++u)
+		fs << "uniform float u" << u << ";\n";
+	fs << "void main(void) {\n\tgl_FragColor = vec4(0.0";
+	for(uint32_t u = 0; u < numUniforms; ++u)
+		fs << " + u" << u;
+	fs << ");\n}\n";
+	const std::string vs = "#version 120\nvoid main(void) {\n\tgl_Position = ftransform();\n}\n";
+	Util::Reference<Shader> shader = Shader::createShader(vs, fs.str(), Shader::USE_GL | Shader::USE_UNIFORMS);
+
+	std::vector<Uniform::UniformName> names;
+	for(uint32_t u = 0; u < numUniforms; ++u)
+		names.emplace_back("u" + std::to_string(u));
+
+	context.pushAndSetShader(shader.get());
+	suite.run("UniformRegistry/setUniform", 100000, [&](uint64_t n) {
+		for(uint64_t i = 0; i < n; ++i)
+			shader->setUniform(context, Uniform(names[i % numUniforms], static_cast<float>(i)), false);
+	});
+	suite.run("UniformRegistry/setUniformAndApply", 100000, [&](uint64_t n) {
+		for(uint64_t i = 0; i < n; ++i) {
+			shader->setUniform(context, Uniform(names[i % numUniforms], static_cast<float>(i)), false);
+			context.applyChanges();
+		}
+	});
+	context.popShader();
+}
+
+void benchmarkVertexDataBind(BenchmarkSuite & suite, RenderingContext & context) {
+	Util::Reference<Mesh> mesh = createTriangleGrid(10000);
+	MeshVertexData & vd = mesh->openVertexData();
+	vd.upload();
+	suite.run("MeshVertexData/bind_vao", 100000, [&](uint64_t n) {
+		for(uint64_t i = 0; i < n; ++i) {
+			vd.bind(context, true, true);
+			vd.unbind(context, true);
+		}
+	});
+	suite.run("MeshVertexData/bind_vbo", 100000, [&](uint64_t n) {
+		for(uint64_t i = 0; i < n; ++i) {
+			vd.bind(context, true, false);
+			vd.unbind(context, true);
+		}
+	});
+}
+
+void benchmarkMeshUtils(BenchmarkSuite & suite, uint32_t numTriangles) {
+	const std::string suffix = "/" + std::to_string(numTriangles / 1000000) + "M";
+	if(!suite.isGroupEnabled("MeshUtils/"))
+		return;
+	Util::Reference<Mesh> source = createTriangleGrid(numTriangles);
+	const uint64_t triangles = source->getPrimitiveCount();
+
+	// each iteration works on a fresh copy; the copy is part of the measurement of "clone"
+	suite.run("MeshUtils/clone" + suffix, 1, [&](uint64_t n) {
+		for(uint64_t i = 0; i < n; ++i)
+			Util::Reference<Mesh> copy = source->clone();
+	}, triangles, "triangles");
+	suite.run("MeshUtils/calculateNormals" + suffix, 1, [&](uint64_t n) {
+		for(uint64_t i = 0; i < n; ++i)
+			MeshUtils::calculateNormals(source.get());
+	}, triangles, "triangles");
+	suite.run("MeshUtils/calculateHash" + suffix, 1, [&](uint64_t n) {
+		for(uint64_t i = 0; i < n; ++i)
+			MeshUtils::calculateHash(source.get());
+	}, triangles, "triangles");
+	suite.run("MeshUtils/transform" + suffix, 1, [&](uint64_t n) {
+		Geometry::Matrix4x4 matrix;
+		matrix.translate(0.5f, 0.25f, 0.0f);
+		matrix.scale(1.001f, 1.0f, 0.999f);
+		for(uint64_t i = 0; i < n; ++i)
+			MeshUtils::transform(source->openVertexData(), matrix);
+	}, triangles, "triangles");
+	suite.run("MeshUtils/eliminateDuplicateVertices" + suffix, 1, [&](uint64_t n) {
+		for(uint64_t i = 0; i < n; ++i) {
+			Util::Reference<Mesh> copy = source->clone();
+			MeshUtils::eliminateDuplicateVertices(copy.get());
+		}
+	}, triangles, "triangles");
+	suite.run("MeshUtils/optimizeIndices" + suffix, 1, [&](uint64_t n) {
+		for(uint64_t i = 0; i < n; ++i) {
+			Util::Reference<Mesh> copy = source->clone();
+			MeshUtils::optimizeIndices(copy.get());
+		}
+	}, triangles, "triangles");
+}
+
+//! Minimal DXT1 compressed DDS file without mipmaps.
+std::string createDDSData(uint32_t size) {
+	std::ostringstream out;
+	auto write32 = [&out](uint32_t v) {
+		const char bytes[4] = {static_cast<char>(v), static_cast<char>(v >> 8), static_cast<char>(v >> 16), static_cast<char>(v >> 24)};
+		out.write(bytes, 4);
+	};
+	out.write("DDS ", 4);
+	write32(124);							// size
+	write32(0x1 | 0x2 | 0x4 | 0x1000);		// DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+	write32(size);							// height
+	write32(size);							// width
+	write32((size / 4) * (size / 4) * 8);	// linear size
+	write32(0);								// depth
+	write32(1);								// mipmap count
+	for(int i = 0; i < 11; ++i)
+		write32(0);
+	write32(32);							// pixel format size
+	write32(0x4);							// DDPF_FOURCC
+	out.write("DXT1", 4);
+	for(int i = 0; i < 5; ++i)
+		write32(0);
+	write32(0x1000);						// DDSCAPS_TEXTURE
+	for(int i = 0; i < 4; ++i)
+		write32(0);
+	for(uint32_t block = 0; block < (size / 4) * (size / 4); ++block) {
+		write32(0xf800001f ^ block);
+		write32(0x55aa55aa);
+	}
+	return out.str();
+}
+
+void benchmarkStreamers(BenchmarkSuite & suite, bool quick) {
+	if(!suite.isGroupEnabled("Streamer/"))
+		return;
+	Util::Reference<Mesh> mesh = createTriangleGrid(quick ? 20000 : 200000);
+	const uint64_t triangles = mesh->getPrimitiveCount();
+
+	// formats that can be saved are benchmarked by a round trip through memory
+	for(const std::string extension : {"mmf", "ply", "qmf"}) {
+		std::ostringstream output;
+		if(!Serialization::saveMesh(mesh.get(), extension, output)) {
+			std::cerr << "Skipping Streamer/" << extension << ": saving failed." << std::endl;
+			continue;
+		}
+		const std::string data = output.str();
+		suite.run("Streamer/" + extension + "/load", 3, [&](uint64_t n) {
+			for(uint64_t i = 0; i < n; ++i)
+				Util::Reference<Mesh> loaded = Serialization::loadMesh(extension, data);
+		}, triangles, "triangles");
+		suite.run("Streamer/" + extension + "/save", 3, [&](uint64_t n) {
+			for(uint64_t i = 0; i < n; ++i) {
+				std::ostringstream out;
+				Serialization::saveMesh(mesh.get(), extension, out);
+			}
+		}, triangles, "triangles");
+	}
+
+	// load-only formats get generated input
+	{
+		const MeshVertexData & vd = mesh->openVertexData();
+		const uint32_t numVertices = static_cast<uint32_t>(vd.getVertexCount());
+		std::ostringstream obj;
+		std::ostringstream xyz;
+		const VertexAttribute & posAttr = vd.getVertexDescription().getAttribute(VertexAttributeIds::POSITION);
+		for(uint32_t v = 0; v < numVertices; ++v) {
+			const float * pos = reinterpret_cast<const float *>(vd[v] + posAttr.getOffset());
+			obj << "v " << pos[0] << ' ' << pos[1] << ' ' << pos[2] << '\n';
+			xyz << pos[0] << ' ' << pos[1] << ' ' << pos[2] << " 255 128 " << (v % 256) << '\n';
+		}
+		const MeshIndexData & id = mesh->openIndexData();
+		for(uint32_t i = 0; i + 2 < id.getIndexCount(); i += 3)
+			obj << "f " << id[i] + 1 << ' ' << id[i + 1] + 1 << ' ' << id[i + 2] + 1 << '\n';
+		const std::string objData = obj.str();
+		const std::string xyzData = xyz.str();
+		suite.run("Streamer/obj/load", 3, [&](uint64_t n) {
+			for(uint64_t i = 0; i < n; ++i)
+				Util::Reference<Mesh> loaded = Serialization::loadMesh("obj", objData);
+		}, triangles, "triangles");
+		suite.run("Streamer/xyz/load", 3, [&](uint64_t n) {
+			for(uint64_t i = 0; i < n; ++i)
+				Util::Reference<Mesh> loaded = Serialization::loadMesh("xyz", xyzData);
+		}, numVertices, "points");
+	}
+	{
+		const uint32_t size = quick ? 512 : 2048;
+		const std::string ddsData = createDDSData(size);
+		suite.run("Streamer/dds/load", 10, [&](uint64_t n) {
+			for(uint64_t i = 0; i < n; ++i)
+				Util::Reference<Texture> loaded = Serialization::loadTexture("dds", ddsData);
+		}, ddsData.size(), "bytes");
+	}
+}
+
+// ---------------------------------------------------------------------------------------------
+// macro-benchmark
+
+//! Draw a scene of many small meshes into an offscreen framebuffer.
+void benchmarkDrawScene(BenchmarkSuite & suite, RenderingContext & context, bool quick) {
+	const uint32_t resolution = 1024;
+	const uint32_t gridSize = quick ? 16 : 32; // gridSize^2 meshes
+	Util::Reference<FBO> fbo = new FBO;
+	Util::Reference<Texture> color = TextureUtils::createStdTexture(resolution, resolution, true);
+	Util::Reference<Texture> depth = TextureUtils::createDepthTexture(resolution, resolution);
+	context.pushAndSetFBO(fbo.get());
+	fbo->attachColorTexture(context, color.get());
+	fbo->attachDepthTexture(context, depth.get());
+
+	std::vector<Util::Reference<Mesh>> meshes;
+	for(uint32_t m = 0; m < 8; ++m)
+		meshes.emplace_back(MeshUtils::createSphere(createVertexDescription(), Geometry::Sphere_f(Geometry::Vec3(0.0f, 0.0f, 0.0f), 0.4f), 8 + 4 * m, 16 + 8 * m));
+
+	Geometry::Matrix4x4 projection;
+	projection.scale(1.0f / static_cast<float>(gridSize), 1.0f / static_cast<float>(gridSize), 0.5f);
+
+	context.pushViewport();
+	context.setViewport(Geometry::Rect_i(0, 0, resolution, resolution));
+	context.pushMatrix_cameraToClipping();
+	context.setMatrix_cameraToClipping(projection);
+	context.pushMatrix_modelToCamera();
+	context.pushAndSetDepthBuffer(DepthBufferParameters(true, true, Comparison::LESS));
+
+	suite.run("DrawScene/frames", 20, [&](uint64_t n) {
+		for(uint64_t frame = 0; frame < n; ++frame) {
+			context.clearScreen(Util::Color4f(0.0f, 0.0f, 0.0f, 1.0f));
+			for(uint32_t y = 0; y < gridSize; ++y) {
+				for(uint32_t x = 0; x < gridSize; ++x) {
+					Geometry::Matrix4x4 matrix;
+					matrix.translate(static_cast<float>(2 * x) - static_cast<float>(gridSize) + 1.0f,
+									static_cast<float>(2 * y) - static_cast<float>(gridSize) + 1.0f, 0.0f);
+					context.setMatrix_modelToCamera(matrix);
+					context.displayMesh(meshes[(x + y * gridSize) % meshes.size()].get());
+				}
+			}
+		}
+	}, static_cast<uint64_t>(gridSize) * gridSize, "draws");
+
+	context.popDepthBuffer();
+	context.popMatrix_modelToCamera();
+	context.popMatrix_cameraToClipping();
+	context.popViewport();
+	context.popFBO();
+}
+
+}
+
+int main(int argc, char ** argv) {
+	BenchmarkSuite suite;
+	bool quick = false;
+	std::string outputFile;
+	for(int i = 1; i < argc; ++i) {
+		const std::string arg(argv[i]);
+		if(arg == "--quick") {
+			quick = true;
+			suite.repetitions = 3;
+		} else if(arg == "--filter" && i + 1 < argc) {
+			suite.filter = argv[++i];
+		} else if(arg == "--output" && i + 1 < argc) {
+			outputFile = argv[++i];
+		} else {
+			std::cerr << "Usage: " << argv[0] << " [--quick] [--filter <substring>] [--output <file.json>]" << std::endl;
+			return 1;
+		}
+	}
+
+	Util::init();
+
+	Util::UI::Window::Properties properties;
+	properties.positioned = false;
+	properties.clientAreaWidth = 256;
+	properties.clientAreaHeight = 256;
+	properties.title = "Rendering Benchmark";
+	properties.compatibilityProfile = true;
+	std::unique_ptr<Util::UI::Window> window = Util::UI::createWindow(properties);
+	Rendering::disableGLErrorChecking();
+	Rendering::RenderingContext::initGLState();
+
+	{
+		RenderingContext context;
+		benchmarkApplyChanges(suite, context);
+		benchmarkSetUniform(suite, context);
+		benchmarkVertexDataBind(suite, context);
+		benchmarkMeshUtils(suite, 1000000);
+		if(!quick)
+			benchmarkMeshUtils(suite, 10000000);
+		benchmarkStreamers(suite, quick);
+		benchmarkDrawScene(suite, context, quick);
+	}
+
+	if(outputFile.empty()) {
+		suite.writeJSON(std::cout);
+	} else {
+		std::ofstream out(outputFile);
+		suite.writeJSON(out);
+	}
+	return 0;
+}
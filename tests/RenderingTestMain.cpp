@@ -9,6 +9,7 @@
 
 #include "TestUtils.h"
 #include <Rendering/RenderingContext/RenderingContext.h>
+#include <Rendering/HeadlessContext.h>
 #include <Rendering/Helper.h>
 #include <Util/UI/UI.h>
 #include <Util/UI/Window.h>
@@ -22,19 +23,26 @@
 #include <cppunit/extensions/TestFactoryRegistry.h>
 #include <fstream>
 #include <memory>
+#include <string>
 
 std::unique_ptr<Util::UI::Window> TestUtils::window;
 
-int main(int /*argc*/, char ** /*argv*/) {
+int main(int argc, char ** argv) {
 	Util::init();
 
-	Util::UI::Window::Properties properties;
-	properties.positioned = false;
-	properties.clientAreaWidth = 256;
-	properties.clientAreaHeight = 256;
-	properties.title = "Rendering Test";
-	properties.compatibilityProfile = true;
-	TestUtils::window = Util::UI::createWindow(properties);
+	// "--headless": use an EGL context instead of a window (e.g. on servers without window system)
+	std::unique_ptr<Rendering::HeadlessContext> headlessContext;
+	if(argc > 1 && std::string(argv[1]) == "--headless") {
+		headlessContext.reset(new Rendering::HeadlessContext(256, 256, true));
+	} else {
+		Util::UI::Window::Properties properties;
+		properties.positioned = false;
+		properties.clientAreaWidth = 256;
+		properties.clientAreaHeight = 256;
+		properties.title = "Rendering Test";
+		properties.compatibilityProfile = true;
+		TestUtils::window = Util::UI::createWindow(properties);
+	}
 	Rendering::enableGLErrorChecking();
 	Rendering::RenderingContext::initGLState();
 
@@ -0,0 +1,366 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+/**
+ * Batch conversion and cooking of meshes. Every input file is loaded with Serialization::loadMesh(),
+ * processed by a MeshUtils::MeshPipeline (and optionally turned into a level of detail chain) and saved
+ * with Serialization::saveMesh(). Directory trees are processed recursively; the files are distributed
+ * over several threads. No OpenGL context is required: all operations work on the meshes' local data.
+ *
+ * Usage: RenderingMeshTool [options] <input file or directory> <output file or directory>
+ *   --format <extension>   File format of the output files in a directory (default: mmf)
+ *   --input <extension>    Only process input files with this extension (may be given several times)
+ *   --dedupe               Eliminate duplicate, unused vertices and zero area triangles
+ *   --normals              Calculate normals
+ *   --optimize             Optimize the index order for the post-transform vertex cache
+ *   --shrink               Shrink positions, texture coordinates and normals to smaller data types
+ *   --lod <levels>         Create a level of detail chain with the given number of levels
+ *   --meshlets             Build meshlets (stored by the mmf format)
+ *   --bvh                  Build a bounding volume hierarchy (stored by the mmf format)
+ *   --threads <n>          Number of worker threads (default: number of hardware threads)
+ *   --quiet                Only print the summary
+ *
+ * For every file, the time of each stage and the main memory used by the mesh are printed.
+ */
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/MeshUtils/MeshBVH.h>
+#include <Rendering/MeshUtils/MeshLODChain.h>
+#include <Rendering/MeshUtils/MeshPipeline.h>
+#include <Rendering/MeshUtils/Meshlets.h>
+#include <Rendering/Serialization/Serialization.h>
+#include <Rendering/TaskScheduler.h>
+#include <Util/IO/FileName.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+using namespace Rendering;
+
+namespace {
+
+struct Options {
+	std::string outputFormat;
+	std::vector<std::string> inputFormats;
+	bool dedupe;
+	bool normals;
+	bool optimize;
+	bool shrink;
+	uint32_t lodLevels;
+	bool meshlets;
+	bool bvh;
+	uint32_t numThreads;
+	bool quiet;
+	Options() : outputFormat("mmf"), dedupe(false), normals(false), optimize(false), shrink(false), lodLevels(0),
+			meshlets(false), bvh(false), numThreads(0), quiet(false) {}
+};
+
+struct Job {
+	std::string input;
+	std::string output;
+};
+
+struct JobResult {
+	bool success;
+	uint32_t vertexCount;
+	uint32_t triangleCount;
+	double loadMilliseconds;
+	double processMilliseconds;
+	double saveMilliseconds;
+	std::size_t memoryLoaded;
+	std::size_t memorySaved;
+	std::size_t peakMemory;
+	std::string details;
+	JobResult() : success(false), vertexCount(0), triangleCount(0), loadMilliseconds(0.0), processMilliseconds(0.0),
+			saveMilliseconds(0.0), memoryLoaded(0), memorySaved(0), peakMemory(0) {}
+};
+
+double getMilliseconds(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string getExtension(const std::string & path) {
+	const size_t slash = path.find_last_of("/\\");
+	const size_t dot = path.find_last_of('.');
+	if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return std::string();
+	std::string extension = path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	return extension;
+}
+
+bool isDirectory(const std::string & path) {
+#if defined(_WIN32)
+	struct _stat info;
+	return _stat(path.c_str(), &info) == 0 && (info.st_mode & _S_IFDIR) != 0;
+#else
+	struct stat info;
+	return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+bool createDirectories(const std::string & path) {
+	if(path.empty() || isDirectory(path))
+		return true;
+	const size_t slash = path.find_last_of("/\\");
+	if(slash != std::string::npos && slash > 0 && !createDirectories(path.substr(0, slash)))
+		return false;
+#if defined(_WIN32)
+	return _mkdir(path.c_str()) == 0 || isDirectory(path);
+#else
+	return mkdir(path.c_str(), 0755) == 0 || isDirectory(path);
+#endif
+}
+
+//! Collect the files below @p directory (relative paths).
+void collectFiles(const std::string & directory, const std::string & relativePath, std::vector<std::string> & files) {
+#if defined(_WIN32)
+	std::cerr << "Processing directories is not supported on this platform." << std::endl;
+#else
+	DIR * dir = opendir((directory + relativePath).c_str());
+	if(dir == nullptr)
+		return;
+	std::vector<std::string> entries;
+	while(dirent * entry = readdir(dir)) {
+		const std::string name(entry->d_name);
+		if(name != "." && name != "..")
+			entries.push_back(name);
+	}
+	closedir(dir);
+	std::sort(entries.begin(), entries.end());
+	for(const auto & name : entries) {
+		const std::string path = relativePath + name;
+		if(isDirectory(directory + path))
+			collectFiles(directory, path + "/", files);
+		else
+			files.push_back(path);
+	}
+#endif
+}
+
+std::string replaceExtension(const std::string & path, const std::string & extension) {
+	const size_t slash = path.find_last_of("/\\");
+	const size_t dot = path.find_last_of('.');
+	if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return path + "." + extension;
+	return path.substr(0, dot + 1) + extension;
+}
+
+MeshUtils::MeshPipeline createPipeline(const Options & options) {
+	MeshUtils::MeshPipeline pipeline;
+	if(options.dedupe)
+		pipeline.eliminateDuplicateVertices().eliminateZeroAreaTriangles().eliminateUnusedVertices();
+	if(options.normals)
+		pipeline.calculateNormals();
+	if(options.optimize)
+		pipeline.optimizeIndices();
+	if(options.shrink)
+		pipeline.shrinkMesh(true, true, true);
+	return pipeline;
+}
+
+JobResult processFile(const Job & job, const Options & options, const MeshUtils::MeshPipeline & pipeline) {
+	JobResult result;
+	std::ostringstream details;
+
+	auto start = std::chrono::steady_clock::now();
+	Util::Reference<Mesh> mesh = Serialization::loadMesh(Util::FileName(job.input));
+	result.loadMilliseconds = getMilliseconds(start);
+	if(mesh.isNull()) {
+		result.details = "loading failed";
+		return result;
+	}
+	result.memoryLoaded = mesh->getMainMemoryUsage();
+
+	start = std::chrono::steady_clock::now();
+	if(pipeline.getStageCount() > 0) {
+		const MeshUtils::MeshPipeline::Report report = pipeline.run(mesh.get());
+		result.peakMemory = report.estimatedPeakMemory;
+		for(const auto & stage : report.stages)
+			details << " " << stage.name << ":" << std::fixed << std::setprecision(1) << stage.milliseconds << "ms";
+	}
+	std::unique_ptr<MeshUtils::MeshLODChain> lodChain;
+	if(options.lodLevels > 1 && mesh->getDrawMode() == Mesh::DRAW_TRIANGLES && mesh->isUsingIndexData()) {
+		const auto lodStart = std::chrono::steady_clock::now();
+		const MeshUtils::Simplification::weights_t weights = {{1.0f, 1.0f, 1.0f, 1.0f, 1.0f}};
+		// the files are processed in parallel, so the simplification itself uses a single thread
+		lodChain.reset(MeshUtils::MeshLODChain::create(mesh.get(), options.lodLevels, weights, 1));
+		if(lodChain)
+			mesh = lodChain->getMesh();
+		details << " lod:" << std::fixed << std::setprecision(1) << getMilliseconds(lodStart) << "ms";
+	}
+	if(options.meshlets && mesh->getDrawMode() == Mesh::DRAW_TRIANGLES && mesh->isUsingIndexData()) {
+		const auto meshletStart = std::chrono::steady_clock::now();
+		MeshUtils::getMeshlets(mesh.get());
+		details << " meshlets:" << std::fixed << std::setprecision(1) << getMilliseconds(meshletStart) << "ms";
+	}
+	if(options.bvh && mesh->getDrawMode() == Mesh::DRAW_TRIANGLES) {
+		const auto bvhStart = std::chrono::steady_clock::now();
+		MeshUtils::MeshBVH::get(mesh.get());
+		details << " bvh:" << std::fixed << std::setprecision(1) << getMilliseconds(bvhStart) << "ms";
+	}
+	result.processMilliseconds = getMilliseconds(start);
+	result.memorySaved = mesh->getMainMemoryUsage();
+	result.peakMemory = std::max(result.peakMemory, std::max(result.memoryLoaded, result.memorySaved));
+	result.vertexCount = mesh->getVertexCount();
+	result.triangleCount = mesh->getDrawMode() == Mesh::DRAW_TRIANGLES ? mesh->getPrimitiveCount() : 0;
+
+	const size_t slash = job.output.find_last_of("/\\");
+	if(slash != std::string::npos && !createDirectories(job.output.substr(0, slash))) {
+		result.details = "creating the output directory failed";
+		return result;
+	}
+	start = std::chrono::steady_clock::now();
+	result.success = Serialization::saveMesh(mesh.get(), Util::FileName(job.output));
+	result.saveMilliseconds = getMilliseconds(start);
+	result.details = result.success ? details.str() : "saving failed";
+	return result;
+}
+
+void printUsage() {
+	std::cerr << "Usage: RenderingMeshTool [--format ext] [--input ext] [--dedupe] [--normals] [--optimize] [--shrink]\n"
+				 "                         [--lod levels] [--meshlets] [--bvh] [--threads n] [--quiet] <input> <output>" << std::endl;
+}
+
+}
+
+int main(int argc, char ** argv) {
+	Options options;
+	std::vector<std::string> paths;
+	for(int i = 1; i < argc; ++i) {
+		const std::string arg(argv[i]);
+		const bool hasValue = i + 1 < argc;
+		if(arg == "--format" && hasValue) {
+			options.outputFormat = argv[++i];
+		} else if(arg == "--input" && hasValue) {
+			options.inputFormats.push_back(getExtension(std::string(".") + argv[++i]));
+		} else if(arg == "--dedupe") {
+			options.dedupe = true;
+		} else if(arg == "--normals") {
+			options.normals = true;
+		} else if(arg == "--optimize") {
+			options.optimize = true;
+		} else if(arg == "--shrink") {
+			options.shrink = true;
+		} else if(arg == "--lod" && hasValue) {
+			options.lodLevels = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		} else if(arg == "--meshlets") {
+			options.meshlets = true;
+		} else if(arg == "--bvh") {
+			options.bvh = true;
+		} else if(arg == "--threads" && hasValue) {
+			options.numThreads = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		} else if(arg == "--quiet") {
+			options.quiet = true;
+		} else if(arg.compare(0, 2, "--") == 0) {
+			printUsage();
+			return EXIT_FAILURE;
+		} else {
+			paths.push_back(arg);
+		}
+	}
+	if(paths.size() != 2) {
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	// collect the jobs
+	std::vector<Job> jobs;
+	if(isDirectory(paths[0])) {
+		std::string inputDir = paths[0];
+		std::string outputDir = paths[1];
+		if(inputDir.back() != '/')
+			inputDir += '/';
+		if(outputDir.back() != '/')
+			outputDir += '/';
+		std::vector<std::string> files;
+		collectFiles(inputDir, "", files);
+		for(const auto & file : files) {
+			const std::string extension = getExtension(file);
+			if(!options.inputFormats.empty() &&
+					std::find(options.inputFormats.begin(), options.inputFormats.end(), extension) == options.inputFormats.end())
+				continue;
+			if(options.inputFormats.empty() && extension.empty())
+				continue;
+			Job job;
+			job.input = inputDir + file;
+			job.output = outputDir + replaceExtension(file, options.outputFormat);
+			jobs.push_back(job);
+		}
+	} else {
+		Job job;
+		job.input = paths[0];
+		job.output = paths[1];
+		jobs.push_back(job);
+	}
+
+	const MeshUtils::MeshPipeline pipeline = createPipeline(options);
+	// the files and the algorithms processing them share the scheduler's threads
+	if(options.numThreads > 0)
+		TaskScheduler::configure(options.numThreads);
+	TaskScheduler & scheduler = TaskScheduler::get();
+	uint32_t numThreads = scheduler.getConcurrency();
+	numThreads = std::max<uint32_t>(1, std::min<uint32_t>(numThreads, static_cast<uint32_t>(jobs.size())));
+
+	std::vector<JobResult> results(jobs.size());
+	std::atomic<size_t> nextJob(0);
+	std::mutex outputMutex;
+	const auto start = std::chrono::steady_clock::now();
+	auto worker = [&]() {
+		for(size_t index = nextJob++; index < jobs.size(); index = nextJob++) {
+			results[index] = processFile(jobs[index], options, pipeline);
+			if(!options.quiet || !results[index].success) {
+				const JobResult & result = results[index];
+				std::lock_guard<std::mutex> lock(outputMutex);
+				std::cout << (result.success ? "" : "FAILED ") << jobs[index].input << ": " << std::fixed << std::setprecision(1)
+						<< "load " << result.loadMilliseconds << "ms, process " << result.processMilliseconds << "ms, save "
+						<< result.saveMilliseconds << "ms, " << result.vertexCount << " vertices, " << result.triangleCount << " triangles, "
+						<< "memory " << result.memoryLoaded / 1024 << "KiB -> " << result.memorySaved / 1024 << "KiB (peak "
+						<< result.peakMemory / 1024 << "KiB)" << result.details << std::endl;
+			}
+		}
+	};
+	TaskScheduler::TaskGroup group;
+	for(uint32_t t = 1; t < numThreads; ++t)
+		scheduler.run(group, worker, "processFile");
+	worker();
+	scheduler.wait(group);
+
+	size_t numFailed = 0;
+	std::size_t memoryLoaded = 0;
+	std::size_t memorySaved = 0;
+	for(const auto & result : results) {
+		if(!result.success)
+			++numFailed;
+		memoryLoaded += result.memoryLoaded;
+		memorySaved += result.memorySaved;
+	}
+	std::cout << jobs.size() << " files (" << numFailed << " failed) on " << numThreads << " threads in " << std::fixed
+			<< std::setprecision(1) << getMilliseconds(start) / 1000.0 << "s, memory " << memoryLoaded / 1024 << "KiB -> "
+			<< memorySaved / 1024 << "KiB" << std::endl;
+	return numFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,123 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+/**
+ * Replay of GL traces recorded with Rendering::GLTrace, e.g. for performance regression tests on a GPU server.
+ * The trace is replayed in a HeadlessContext; the time of every frame (including glFinish) is measured.
+ *
+ * Usage: RenderingTraceReplay [options] <trace file>
+ *   --repeat <n>           Replay the trace n times (default: 1)
+ *   --warmup <n>           Number of additional repetitions before the measurement (default: 1)
+ *   --size <w> <h>         Size of the framebuffer (default: 1024 768)
+ *   --core                 Use an OpenGL core profile context
+ *   --frames               Print the time of every frame
+ *
+ * The summary contains the number of frames and commands, the uploaded data, and the minimum, median,
+ * 95th percentile and maximum frame time.
+ */
+#include <Rendering/GLTrace.h>
+#include <Rendering/HeadlessContext.h>
+#include <Rendering/RenderingContext/RenderingContext.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using namespace Rendering;
+
+namespace {
+
+void printUsage() {
+	std::cerr << "Usage: RenderingTraceReplay [--repeat <n>] [--warmup <n>] [--size <w> <h>] [--core] [--frames] <trace file>" << std::endl;
+}
+
+double getPercentile(const std::vector<double> & sortedValues, double percentile) {
+	if(sortedValues.empty())
+		return 0.0;
+	const std::size_t index = static_cast<std::size_t>(percentile * (sortedValues.size() - 1) + 0.5);
+	return sortedValues[std::min(index, sortedValues.size() - 1)];
+}
+
+}
+
+int main(int argc, char ** argv) {
+	uint32_t repetitions = 1;
+	uint32_t warmup = 1;
+	uint32_t width = 1024;
+	uint32_t height = 768;
+	bool coreProfile = false;
+	bool printFrames = false;
+	std::string filename;
+	for(int i = 1; i < argc; ++i) {
+		const std::string arg(argv[i]);
+		if(arg == "--repeat" && i + 1 < argc) {
+			repetitions = std::max(1u, static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)));
+		} else if(arg == "--warmup" && i + 1 < argc) {
+			warmup = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		} else if(arg == "--size" && i + 2 < argc) {
+			width = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			height = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		} else if(arg == "--core") {
+			coreProfile = true;
+		} else if(arg == "--frames") {
+			printFrames = true;
+		} else if(arg.compare(0, 2, "--") == 0 || !filename.empty()) {
+			printUsage();
+			return EXIT_FAILURE;
+		} else {
+			filename = arg;
+		}
+	}
+	if(filename.empty() || width == 0 || height == 0) {
+		printUsage();
+		return EXIT_FAILURE;
+	}
+	if(!HeadlessContext::isSupported()) {
+		std::cerr << "The Rendering library was built without headless context support (RENDERING_HEADLESS_EGL)." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	try {
+		HeadlessContext headless(width, height, !coreProfile);
+		RenderingContext context;
+		headless.bindFramebuffer(context);
+		if(warmup > 0)
+			GLTrace::replay(filename, warmup);
+		const GLTrace::ReplayResult result = GLTrace::replay(filename, repetitions);
+		headless.unbindFramebuffer(context);
+
+		if(printFrames) {
+			for(std::size_t frame = 0; frame < result.frameTimes.size(); ++frame)
+				std::cout << frame << '\t' << std::fixed << std::setprecision(3) << result.frameTimes[frame] << " ms\n";
+		}
+		std::vector<double> sortedTimes(result.frameTimes);
+		std::sort(sortedTimes.begin(), sortedTimes.end());
+		const double sum = std::accumulate(sortedTimes.begin(), sortedTimes.end(), 0.0);
+		std::cout << std::fixed << std::setprecision(3)
+				<< "Frames:    " << sortedTimes.size() << " (" << repetitions << " repetitions)\n"
+				<< "Commands:  " << result.numCommands << '\n'
+				<< "Uploaded:  " << (static_cast<double>(result.numBytesUploaded) / (1024.0 * 1024.0)) << " MiB\n"
+				<< "Total:     " << result.totalTime << " ms\n"
+				<< "Mean:      " << (sortedTimes.empty() ? 0.0 : sum / sortedTimes.size()) << " ms\n"
+				<< "Min:       " << (sortedTimes.empty() ? 0.0 : sortedTimes.front()) << " ms\n"
+				<< "Median:    " << getPercentile(sortedTimes, 0.5) << " ms\n"
+				<< "95%:       " << getPercentile(sortedTimes, 0.95) << " ms\n"
+				<< "Max:       " << (sortedTimes.empty() ? 0.0 : sortedTimes.back()) << " ms" << std::endl;
+	} catch(const std::exception & e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}